@@ -23,6 +23,7 @@
 
 #include <gz/utils/SuppressWarning.hh>
 
+#include <gz/sensors/AtmosphereTable.hh>
 #include <gz/sensors/config.hh>
 #include <gz/sensors/air_speed/Export.hh>
 
@@ -83,6 +84,20 @@ namespace gz
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasConnections() const override;
 
+      /// \brief Set a table to look up the air density and temperature at
+      /// the sensor's altitude in, instead of evaluating the atmosphere
+      /// model. A single table can be shared by many sensors.
+      /// \param[in] _table Atmosphere table, null to evaluate the model on
+      /// every update, which is the default.
+      public: void SetAtmosphere(
+                  std::shared_ptr<const AtmosphereTable> _table);
+
+      /// \brief Get the table the air density and temperature are looked
+      /// up in.
+      /// \return Atmosphere table, null if the model is evaluated.
+      /// \sa SetAtmosphere
+      public: std::shared_ptr<const AtmosphereTable> Atmosphere() const;
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief Data pointer for private data
       /// \internal
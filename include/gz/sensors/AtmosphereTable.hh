@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_ATMOSPHERETABLE_HH_
+#define GZ_SENSORS_ATMOSPHERETABLE_HH_
+
+#include <memory>
+
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class AtmosphereTablePrivate;
+
+    /// \brief State of the atmosphere at an altitude.
+    struct AtmosphereSample
+    {
+      /// \brief Pressure in pascals.
+      double pressure = 0.0;
+
+      /// \brief Density in kilograms per cubic meter.
+      double density = 0.0;
+
+      /// \brief Temperature in kelvin.
+      double temperature = 0.0;
+    };
+
+    /// \brief Troposphere of the international standard atmosphere,
+    /// evaluated once at regularly spaced altitudes and linearly
+    /// interpolated in between.
+    ///
+    /// The model is the same as AirPressureSensor's, with the temperature
+    /// decreasing linearly with the geopotential height. A table is
+    /// immutable, so a single one can be shared by the air pressure and air
+    /// speed sensors of all vehicles, see AirPressureSensor::SetAtmosphere
+    /// and AirSpeedSensor::SetAtmosphere.
+    class GZ_SENSORS_VISIBLE AtmosphereTable
+    {
+      /// \brief Constructor
+      /// \param[in] _resolution Spacing of the tabulated altitudes, in
+      /// meters. The interpolated pressure is within a millipascal of the
+      /// model at a resolution of 1 meter, the error grows with the square
+      /// of the resolution. Non positive resolutions become 1 meter.
+      /// \param[in] _minAltitude Lowest tabulated altitude, in meters.
+      /// \param[in] _maxAltitude Highest tabulated altitude, in meters.
+      public: explicit AtmosphereTable(double _resolution = 1.0,
+                  double _minAltitude = -500.0,
+                  double _maxAltitude = 11000.0);
+
+      /// \brief Destructor
+      public: ~AtmosphereTable();
+
+      /// \brief Get the spacing of the tabulated altitudes.
+      /// \return Resolution in meters.
+      public: double Resolution() const;
+
+      /// \brief Get the lowest tabulated altitude.
+      /// \return Altitude in meters.
+      public: double MinAltitude() const;
+
+      /// \brief Get the highest tabulated altitude.
+      /// \return Altitude in meters.
+      public: double MaxAltitude() const;
+
+      /// \brief Get the state of the atmosphere at an altitude, interpolated
+      /// from the table. Altitudes outside of the table are evaluated with
+      /// Evaluate().
+      /// \param[in] _altitude Altitude above mean sea level, in meters.
+      /// \return State of the atmosphere.
+      public: AtmosphereSample Lookup(double _altitude) const;
+
+      /// \brief Evaluate the model at an altitude.
+      /// \param[in] _altitude Altitude above mean sea level, in meters.
+      /// \return State of the atmosphere.
+      public: static AtmosphereSample Evaluate(double _altitude);
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<AtmosphereTablePrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
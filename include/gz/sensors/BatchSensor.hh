@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_BATCHSENSOR_HH_
+#define GZ_SENSORS_BATCHSENSOR_HH_
+
+#include <chrono>
+#include <vector>
+
+#include <gz/sensors/config.hh>
+
+#include "gz/sensors/Sensor.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Base class of sensor types that generate the data of all
+    /// their due instances in a single call, such as custom sensors with
+    /// many instances whose state is best kept in contiguous arrays.
+    ///
+    /// The Manager groups the sensors of such types and calls UpdateSensors()
+    /// once per step on one of them, with all the instances that are due,
+    /// even when grouped updates are disabled. Forced updates, replayed
+    /// sensors and sensors that interpolate their inputs are updated one by
+    /// one, through a call with a single sensor. A batch is updated on one
+    /// thread, which the sensor type may split its work from.
+    ///
+    /// \code
+    /// class Odometer : public gz::sensors::BatchSensor<Odometer>
+    /// {
+    ///   protected: void UpdateSensors(const std::vector<Odometer *> &_all,
+    ///       const std::chrono::steady_clock::duration &_now) override;
+    /// };
+    /// \endcode
+    /// \tparam SensorType The sensor type deriving from this class.
+    /// \tparam BaseType Sensor class to derive from.
+    template <typename SensorType, typename BaseType = Sensor>
+    class BatchSensor : public BaseType
+    {
+      // Documentation inherited.
+      public: bool HasBatchUpdate() const override
+      {
+        return true;
+      }
+
+      using BaseType::Update;
+
+      /// \brief Update this sensor alone.
+      /// \param[in] _now The current time
+      /// \return True.
+      public: bool Update(
+        const std::chrono::steady_clock::duration &_now) override
+      {
+        const std::vector<SensorType *> sensors{
+            static_cast<SensorType *>(this)};
+        this->UpdateSensors(sensors, _now);
+        return true;
+      }
+
+      /// \brief Generate data for sensors of this type that are due.
+      /// \param[in] _sensors Sensors to update, including this one, in the
+      /// order the Manager would update them one by one.
+      /// \param[in] _now The current time
+      protected: virtual void UpdateSensors(
+        const std::vector<SensorType *> &_sensors,
+        const std::chrono::steady_clock::duration &_now) = 0;
+
+      // Documentation inherited.
+      protected: void UpdateBatch(const std::vector<Sensor *> &_sensors,
+        const std::chrono::steady_clock::duration &_now) override
+      {
+        thread_local std::vector<SensorType *> sensors;
+        sensors.clear();
+        for (auto *s : _sensors)
+          sensors.push_back(static_cast<SensorType *>(s));
+        this->UpdateSensors(sensors, _now);
+      }
+    };
+    }
+  }
+}
+
+#endif
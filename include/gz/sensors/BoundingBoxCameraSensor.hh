@@ -36,6 +36,28 @@ namespace gz
     // forward declarations
     class BoundingBoxCameraSensorPrivate;
 
+    /// \brief How BoundingBoxCameraSensor saves the boxes of its samples,
+    /// in the boxes folder of the save path.
+    enum class BoundingBoxExportFormat
+    {
+      /// \brief One CSV file per sample, boxes_<sample>.csv.
+      CSV = 0,
+
+      /// \brief One JSON object per sample and line, appended to
+      /// boxes.jsonl. The object has the sample number and an array of
+      /// boxes with the fields of the CSV columns.
+      JSON_LINES = 1,
+
+      /// \brief Fixed size records appended to boxes.bin, in host byte
+      /// order with no padding. A 2D box is a uint32 label followed by
+      /// x_center, y_center, width and height as doubles, 36 bytes. A 3D
+      /// box is a uint32 label followed by x, y, z, w, h, l, roll, pitch
+      /// and yaw as doubles, 76 bytes. Each sample appends to boxes.idx
+      /// its number as a uint64, the offset of its first box in boxes.bin
+      /// as a uint64 and its number of boxes as a uint32, 20 bytes.
+      BINARY = 2
+    };
+
     /// \brief BoundingBox camera sensor class.
     ///
     /// This class creates a BoundingBox image from an gz rendering scene.
@@ -99,10 +121,72 @@ namespace gz
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited.
+      public: SensorMemoryUsage MemoryUsage() const override;
+
+      /// \brief Set whether the boxes are drawn, converted to messages,
+      /// saved and published on a worker thread. Update() then returns once
+      /// a frame is handed over, so the next frame renders while the
+      /// previous one is processed. A frame waits for the worker to take
+      /// the previous one, so no frame is dropped. Disabling it waits for
+      /// the frames being processed. Disabled by default.
+      /// \param[in] _pipelined True to process frames on a worker thread.
+      public: void SetPipelined(bool _pipelined);
+
+      /// \brief Get whether frames are processed on a worker thread.
+      /// \return True if pipelined.
+      /// \sa SetPipelined
+      public: bool Pipelined() const;
+
+      /// \brief Set how the boxes of saved samples are written. The JSON
+      /// lines and binary formats append every sample to the same files,
+      /// written from a background thread. They're flushed when the sensor
+      /// is destroyed.
+      /// \param[in] _format Export format.
+      public: void SetBoxesExportFormat(BoundingBoxExportFormat _format);
+
+      /// \brief Get how the boxes of saved samples are written.
+      /// \return Export format, BoundingBoxExportFormat::CSV by default.
+      /// \sa SetBoxesExportFormat
+      public: BoundingBoxExportFormat BoxesExportFormat() const;
+
+      /// \brief Set whether the number of visible pixels of each 2D box is
+      /// published with the boxes. A segmentation camera with the same view
+      /// renders the label of the closest surface at each pixel, and the
+      /// pixels within a box that hold its label are counted. The counts
+      /// are in the `visible_pixels` entry of the boxes message header, one
+      /// value per box in the order of the boxes, so dividing by a box area
+      /// gives its visible ratio. Labels must be below 256, and overlapping
+      /// boxes with the same label count each other's pixels. Ignored for
+      /// 3D boxes. Disabled by default.
+      /// \param[in] _count True to count visible pixels.
+      public: void SetVisiblePixelCounting(bool _count);
+
+      /// \brief Get whether the visible pixels of boxes are counted.
+      /// \return True if counted.
+      /// \sa SetVisiblePixelCounting
+      public: bool VisiblePixelCounting() const;
+
+      // Documentation inherited.
+      protected: bool HasRegionOfInterestSupport() const override;
+
       /// \brief Create a camera in a scene
       /// \return True on success.
       private: bool CreateCamera();
 
+      /// \brief Create the rgb camera of the annotated image if it's needed,
+      /// destroy it otherwise, so it's only rendered when the image is
+      /// published or saved.
+      /// \param[in] _needed True if the image is published or saved.
+      /// \return True if the rgb camera exists.
+      private: bool UpdateRgbCamera(bool _needed);
+
+      /// \brief Create the segmentation camera that counts visible pixels
+      /// if it's needed, destroy it otherwise.
+      /// \param[in] _needed True if visible pixels are counted.
+      /// \return True if the segmentation camera exists.
+      private: bool UpdateVisibilityCamera(bool _needed);
+
       /// \brief Callback for triggered subscription
       /// \param[in] _msg Boolean message
       private: void OnTrigger(const gz::msgs::Boolean &/*_msg*/);
@@ -18,6 +18,8 @@
 #ifndef GZ_SENSORS_BROWNDISTORTIONMODEL_HH_
 #define GZ_SENSORS_BROWNDISTORTIONMODEL_HH_
 
+#include <cstddef>
+
 #include <sdf/sdf.hh>
 
 #include "gz/sensors/Distortion.hh"
@@ -74,6 +76,29 @@ namespace gz
       /// \return Distortion center.
       public: math::Vector2d Center() const;
 
+      /// \brief Distort positions in normalized image coordinates, where
+      /// the image spans [0, 1] in both directions, as the camera
+      /// distortion does.
+      /// \param[in] _x Horizontal undistorted positions.
+      /// \param[in] _y Vertical undistorted positions.
+      /// \param[out] _outX Horizontal distorted positions. May be _x.
+      /// \param[out] _outY Vertical distorted positions. May be _y.
+      /// \param[in] _count Number of positions.
+      public: void Distort(const double *_x, const double *_y,
+                  double *_outX, double *_outY, std::size_t _count) const;
+
+      /// \brief Undistort positions in normalized image coordinates, the
+      /// inverse of Distort. Each position starts from an estimate
+      /// interpolated in a grid of the inverse over [-0.5, 1.5], computed
+      /// by Load, refined by a few Newton steps.
+      /// \param[in] _x Horizontal distorted positions.
+      /// \param[in] _y Vertical distorted positions.
+      /// \param[out] _outX Horizontal undistorted positions. May be _x.
+      /// \param[out] _outY Vertical undistorted positions. May be _y.
+      /// \param[in] _count Number of positions.
+      public: void Undistort(const double *_x, const double *_y,
+                  double *_outX, double *_outY, std::size_t _count) const;
+
       /// Documentation inherited
       public: virtual void Print(std::ostream &_out) const override;
 
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_CAMERAGROUP_HH_
+#define GZ_SENSORS_CAMERAGROUP_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <gz/common/Event.hh>
+#include <gz/common/Image.hh>
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/camera/Export.hh"
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // forward declarations
+    class CameraGroupPrivate;
+    class CameraSensor;
+
+    /// \brief Images of all the cameras of a group for one update, stored
+    /// contiguously, camera after camera, as a count x height x width x
+    /// channels array. The pixels are only valid during the callback it's
+    /// given to.
+    /// \sa CameraGroup::ConnectBatchCallback
+    struct CameraBatch
+    {
+      /// \brief Time of the frames.
+      std::chrono::steady_clock::duration time{0};
+
+      /// \brief Pixels of the images, in the order the cameras were added.
+      const unsigned char *data = nullptr;
+
+      /// \brief Size of the pixels in bytes.
+      std::size_t size = 0;
+
+      /// \brief Number of images.
+      std::size_t count = 0;
+
+      /// \brief Width of each image in pixels.
+      unsigned int width = 0;
+
+      /// \brief Height of each image in pixels.
+      unsigned int height = 0;
+
+      /// \brief Pixel format of the images.
+      common::Image::PixelFormatType format =
+          common::Image::UNKNOWN_PIXEL_FORMAT;
+    };
+
+    /// \brief Gathers the images of several cameras of identical size and
+    /// format, for example one per environment of a vectorized simulation,
+    /// into a single batch per update. The images are taken from the image
+    /// views of the cameras, so while the group is their only consumer
+    /// they don't build nor publish messages of their own. A batch is
+    /// complete once every camera produced its image for the same time.
+    /// Combined with Manager::SetRenderBatchCallback, all the cameras are
+    /// rendered in one pass before any of them is read back.
+    class GZ_SENSORS_CAMERA_VISIBLE CameraGroup
+    {
+      /// \brief Constructor
+      public: CameraGroup();
+
+      /// \brief Destructor
+      public: ~CameraGroup();
+
+      /// \brief Add a camera to the group. Cameras must outlive the group.
+      /// \param[in] _camera Camera to add.
+      /// \return False if the camera is null, already in the group, or
+      /// its image size or format differ from the first camera's.
+      public: bool AddCamera(CameraSensor *_camera);
+
+      /// \brief Get the number of cameras of the group.
+      /// \return Number of cameras.
+      public: std::size_t CameraCount() const;
+
+      /// \brief Publish each batch as a gz::msgs::Image whose height is the
+      /// number of cameras times their image height, with a "batch_size"
+      /// header entry holding the number of cameras. Batches are only
+      /// published while the topic has subscribers.
+      /// \param[in] _topic Topic of the batches.
+      /// \return True if the topic could be advertised.
+      public: bool SetTopic(const std::string &_topic);
+
+      /// \brief Get the topic of the batches.
+      /// \return Topic, empty if batches aren't published.
+      /// \sa SetTopic
+      public: std::string Topic() const;
+
+      /// \brief Set a callback to be called with each batch.
+      /// \param[in] _callback This callback will be called every time all
+      /// the cameras produced an image for the same time, from the update
+      /// of the last of them.
+      /// \remark Do not block inside of the callback, and don't keep the
+      /// pixel pointer after it returns.
+      /// \return A connection pointer that must remain in scope. When the
+      /// connection pointer falls out of scope, the connection is broken.
+      public: common::ConnectionPtr ConnectBatchCallback(
+                  std::function<void(const CameraBatch &)> _callback);
+
+      /// \brief Get the number of complete batches.
+      /// \return Number of batches.
+      public: uint64_t BatchCount() const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<CameraGroupPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
@@ -17,13 +17,17 @@
 #ifndef GZ_SENSORS_CAMERASENSOR_HH_
 #define GZ_SENSORS_CAMERASENSOR_HH_
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <gz/msgs/boolean.pb.h>
 #include <gz/msgs/image.pb.h>
 
+#include <gz/common/Image.hh>
 #include <sdf/sdf.hh>
 
 #include <gz/utils/SuppressWarning.hh>
@@ -51,6 +55,79 @@ namespace gz
     // Inline bracket to help doxygen filtering.
     inline namespace GZ_SENSORS_VERSION_NAMESPACE {
     //
+    /// \brief View of an image produced by a camera, without copying it.
+    /// The pixels are only valid during the callback it's given to.
+    /// \sa CameraSensor::ConnectImageViewCallback
+    struct ImageView
+    {
+      /// \brief Time of the frame.
+      std::chrono::steady_clock::duration time{0};
+
+      /// \brief Pixels, row by row with no padding.
+      const unsigned char *data = nullptr;
+
+      /// \brief Size of the pixels in bytes.
+      std::size_t size = 0;
+
+      /// \brief Width in pixels.
+      unsigned int width = 0;
+
+      /// \brief Height in pixels.
+      unsigned int height = 0;
+
+      /// \brief Pixel format.
+      common::Image::PixelFormatType format =
+          common::Image::UNKNOWN_PIXEL_FORMAT;
+    };
+
+    /// \brief Render target of a camera frame, left on the GPU. The
+    /// texture can be registered with CUDA or Vulkan through their OpenGL
+    /// interop, for example with cudaGraphicsGLRegisterImage, and mapped
+    /// for each frame. Mapping orders the consumer after the OpenGL
+    /// commands of the frame. Consumers that read the texture on their own
+    /// queue can insert a fence with glFenceSync from the callback, which
+    /// runs on the rendering thread with the engine's context current.
+    /// \sa CameraSensor::ConnectGpuFrameCallback
+    struct GpuFrame
+    {
+      /// \brief Time of the frame.
+      std::chrono::steady_clock::duration time{0};
+
+      /// \brief OpenGL name of the render texture, 0 if the render engine
+      /// doesn't render with OpenGL.
+      unsigned int textureId = 0;
+
+      /// \brief Width of the texture in pixels.
+      unsigned int width = 0;
+
+      /// \brief Height of the texture in pixels.
+      unsigned int height = 0;
+
+      /// \brief Pixel format of the camera. The texture may have more
+      /// channels, as chosen by the render engine.
+      rendering::PixelFormat format = rendering::PF_UNKNOWN;
+
+      /// \brief Number of GPU frames produced before this one.
+      uint64_t sequence = 0;
+    };
+
+    /// \brief Pixel format a camera can also publish its RGB images in.
+    /// \sa CameraSensor::AddConvertedOutput
+    enum class ConvertedPixelFormat
+    {
+      /// \brief Full range 8 bit grey, published as L_INT8.
+      MONO8 = 0,
+
+      /// \brief Packed YUV 4:2:2, Y0 U Y1 V for each pair of pixels, with
+      /// BT.601 limited range values. The step is twice the width.
+      YUYV = 1,
+
+      /// \brief Planar YUV 4:2:0, a luma plane followed by a plane of
+      /// interleaved U and V at half resolution, with BT.601 limited range
+      /// values. The step is the width.
+      NV12 = 2
+    };
+
     /// \brief forward declarations
     class CameraSensorPrivate;
 
@@ -79,6 +156,18 @@ namespace gz
       /// \return true if loading was successful
       public: virtual bool Load(sdf::ElementPtr _sdf) override;
 
+      /// \brief Reconfigure the camera in place. The image width and
+      /// height, clip planes, horizontal field of view, lens intrinsics and
+      /// projection and the noise parameters can be changed. A new
+      /// resolution resizes the render target and image buffer, and
+      /// updates the camera info. Changing the pixel format, trigger,
+      /// camera info topic or noise type fails. Cameras derived from this
+      /// class only apply the settings of Sensor::Reconfigure().
+      /// \param[in] _sdf Sensor settings.
+      /// \return True if the settings were applied.
+      /// \sa Sensor::Reconfigure
+      public: bool Reconfigure(const sdf::Sensor &_sdf) override;
+
       /// \brief Initialize values in the sensor
       /// \return True on success
       public: virtual bool Init() override;
@@ -103,6 +192,36 @@ namespace gz
                   std::function<
                   void(const gz::msgs::Image &)> _callback);
 
+      /// \brief Set a callback to be called with a view of each image,
+      /// without building a message. The pixels aren't copied into a
+      /// gz::msgs::Image unless the image is also published or given to
+      /// the callbacks of ConnectImageCallback.
+      /// \param[in] _callback This callback will be called every time the
+      /// camera produces image data. The Update function will be blocked
+      /// while the callbacks are executed.
+      /// \remark Do not block inside of the callback, and don't keep the
+      /// pixel pointer after it returns.
+      /// \return A connection pointer that must remain in scope. When the
+      /// connection pointer falls out of scope, the connection is broken.
+      public: gz::common::ConnectionPtr ConnectImageViewCallback(
+                  std::function<void(const ImageView &)> _callback);
+
+      /// \brief Set a callback to be called with the render target of each
+      /// frame. While it's the only consumer, frames are rendered without
+      /// being read back or published, so pixels never leave the GPU. The
+      /// texture has the render resolution and none of the processing done
+      /// on the CPU, like distortion on the CPU, motion blur or the region
+      /// of interest.
+      /// \param[in] _callback This callback will be called every time the
+      /// camera renders a frame, on the rendering thread.
+      /// \remark Do not block inside of the callback. The texture is only
+      /// valid until the next update of the sensor.
+      /// \return A connection pointer that must remain in scope. When the
+      /// connection pointer falls out of scope, the connection is broken.
+      /// \sa GpuFrame
+      public: gz::common::ConnectionPtr ConnectGpuFrameCallback(
+                  std::function<void(const GpuFrame &)> _callback);
+
       /// \brief Set the rendering scene.
       /// \param[in] _scene Pointer to the scene
       public: virtual void SetScene(
@@ -136,6 +255,9 @@ namespace gz
       // Documentation inherited.
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited.
+      public: SensorMemoryUsage MemoryUsage() const override;
+
       /// \brief Check if there are any image subscribers
       /// \return True if there are image subscribers, false otherwise
       public: virtual bool HasImageConnections() const;
@@ -148,6 +270,239 @@ namespace gz
       /// \return The camera optical frame
       public: const std::string& OpticalFrameId() const;
 
+      /// \brief Set whether frames are also published PNG compressed on
+      /// the image topic followed by "/compressed". Compressed images are
+      /// msgs::Image messages whose data is the PNG file and whose header
+      /// has a "format" entry set to "png". Frames are encoded on a worker
+      /// thread and only while the compressed topic has subscribers. If the
+      /// worker is still busy when a frame is ready, the frame replaces the
+      /// one waiting to be encoded, if any. Must be called after Load().
+      /// Disabled by default.
+      /// \param[in] _enabled True to enable compressed output.
+      /// \return True if the compressed topic could be advertised.
+      public: bool SetCompressedOutput(bool _enabled);
+
+      /// \brief Get whether compressed output is enabled.
+      /// \return True if compressed output is enabled.
+      /// \sa SetCompressedOutput
+      public: bool CompressedOutput() const;
+
+      /// \brief Check if there are any compressed image subscribers
+      /// \return True if compressed output is enabled and has subscribers.
+      public: bool HasCompressedConnections() const;
+
+      /// \brief Also publish the images at a lower resolution on the image
+      /// topic followed by "/downsampled_<_factor>". Each output pixel is
+      /// the average of a block of _factor by _factor pixels, and columns
+      /// or rows that don't fill a whole block are dropped. All outputs
+      /// come from the same render: each one is computed from the finest
+      /// output of the frame whose factor divides _factor, or from the full
+      /// image. An output is only computed while its topic has subscribers.
+      /// Outputs apply to the region of interest. The RGB_INT8, L_INT8 and
+      /// L_INT16 pixel formats are supported. Must be called after Load().
+      /// \param[in] _factor Downsampling factor, at least 2.
+      /// \return True if the output was added or already existed.
+      public: bool AddDownsampledOutput(unsigned int _factor);
+
+      /// \brief Get the topic of a downsampled output.
+      /// \param[in] _factor Downsampling factor.
+      /// \return Topic, empty if there is no output for _factor.
+      /// \sa AddDownsampledOutput
+      public: std::string DownsampledTopic(unsigned int _factor) const;
+
+      /// \brief Check if any downsampled output has subscribers.
+      /// \return True if a downsampled topic has subscribers.
+      public: bool HasDownsampledConnections() const;
+
+      /// \brief Also publish the images in another pixel format, on the
+      /// image topic followed by "/mono8", "/yuyv" or "/nv12", so that
+      /// consumers such as hardware video encoders don't have to convert
+      /// them. YUV images have an unknown pixel format type and a "format"
+      /// header entry set to "yuyv" or "nv12"; a last odd column, and for
+      /// NV12 a last odd row, is dropped. An output is only converted while
+      /// its topic has subscribers and applies to the region of interest.
+      /// Only the RGB_INT8 pixel format can be converted. Must be called
+      /// after Load().
+      /// \param[in] _format Output pixel format.
+      /// \return True if the output was added or already existed.
+      public: bool AddConvertedOutput(ConvertedPixelFormat _format);
+
+      /// \brief Get the topic of a converted output.
+      /// \param[in] _format Output pixel format.
+      /// \return Topic, empty if there is no output for _format.
+      /// \sa AddConvertedOutput
+      public: std::string ConvertedTopic(ConvertedPixelFormat _format) const;
+
+      /// \brief Check if any converted output has subscribers.
+      /// \return True if a converted topic has subscribers.
+      public: bool HasConvertedConnections() const;
+
+      /// \brief Also publish each image as horizontal tiles of _rows rows,
+      /// on the image topic followed by "/tiles", so that consumers of very
+      /// large images can start processing before a whole frame is
+      /// serialized, and so that no message holds a full frame. Tiles are
+      /// msgs::Image messages with the width, step and pixel format of the
+      /// image and the height of the tile; the last tile of a frame may be
+      /// shorter. Their header has "frame", "tile", "tile_count" and "row"
+      /// entries: the sequence number of the frame, the index of the tile
+      /// in the frame, the number of tiles of the frame and the first row
+      /// of the tile. Tiles are only published while the topic has
+      /// subscribers and apply to the region of interest. Must be called
+      /// after Load().
+      /// \param[in] _rows Rows per tile, 0 to disable tiled output.
+      /// \return True if the tiles topic could be advertised.
+      public: bool SetTiledOutput(unsigned int _rows);
+
+      /// \brief Get the number of rows per tile.
+      /// \return Rows per tile, 0 if tiled output is disabled.
+      /// \sa SetTiledOutput
+      public: unsigned int TiledOutputRows() const;
+
+      /// \brief Get the topic of the tiles.
+      /// \return Topic, empty if tiled output is disabled.
+      /// \sa SetTiledOutput
+      public: std::string TiledTopic() const;
+
+      /// \brief Check if there are any tile subscribers
+      /// \return True if tiled output is enabled and has subscribers.
+      public: bool HasTiledConnections() const;
+
+      /// \brief Simulate the motion blur of the exposure. When the camera
+      /// moved since the previous image, extra sub-frames are rendered at
+      /// poses interpolated over the exposure and averaged with the image.
+      /// The number of sub-frames follows the motion, about one per pixel
+      /// of blur, so a static camera renders a single frame. The blur is
+      /// estimated from the rotation and from the translation as seen on
+      /// content one metre away. Not applied in asynchronous readback mode.
+      /// \param[in] _exposure Fraction of the time between two images the
+      /// shutter is open, in [0, 1]. 0 disables motion blur.
+      /// \param[in] _maxSubFrames Largest number of frames rendered per
+      /// image, including the image itself.
+      public: void SetMotionBlur(double _exposure,
+                  unsigned int _maxSubFrames);
+
+      /// \brief Get the fraction of the time between images the shutter is
+      /// open.
+      /// \return Exposure, 0 if motion blur is disabled.
+      /// \sa SetMotionBlur
+      public: double MotionBlurExposure() const;
+
+      /// \brief Get the largest number of frames rendered per image.
+      /// \return Number of frames.
+      /// \sa SetMotionBlur
+      public: unsigned int MotionBlurMaxSubFrames() const;
+
+      /// \brief Get the number of frames rendered for the last image.
+      /// \return Number of frames, 1 without motion blur.
+      /// \sa SetMotionBlur
+      public: unsigned int LastSubFrameCount() const;
+
+      /// \brief Render at a fraction of the published resolution. Images
+      /// are upsampled with bilinear filtering to the resolution of the
+      /// SDF, so messages, camera info and callbacks keep their size. Can
+      /// be changed at any time after Load(). Not supported by Bayer pixel
+      /// formats.
+      /// \param[in] _scale Fraction of the resolution rendered, in (0, 1].
+      /// \return False if the scale is out of range, the camera doesn't
+      /// exist or its pixel format isn't supported.
+      public: bool SetRenderScale(double _scale);
+
+      /// \brief Get the fraction of the published resolution rendered.
+      /// \return Render scale, 1 by default.
+      /// \sa SetRenderScale
+      public: double RenderScale() const;
+
+      /// \brief Publish only a region of the rendered images. The region
+      /// is clamped to the image and applies to the image topics, shared
+      /// memory output, compressed output, recording and image callbacks.
+      /// The camera_info intrinsics and projection are adjusted to match.
+      /// Point clouds and saved frames keep the full image. Not supported
+      /// by bounding box and wide angle cameras, nor by Bayer pixel
+      /// formats.
+      /// \param[in] _x First column of the region.
+      /// \param[in] _y First row of the region.
+      /// \param[in] _width Width of the region, zero for the rest of the
+      /// row.
+      /// \param[in] _height Height of the region, zero for the rest of the
+      /// column. Set all four values to zero to publish full images.
+      /// \return False if the sensor doesn't support a region of interest.
+      /// \sa SetDecimation
+      public: bool SetRegionOfInterest(unsigned int _x, unsigned int _y,
+                  unsigned int _width, unsigned int _height);
+
+      /// \brief Get the region of interest, as requested.
+      /// \param[out] _x First column of the region.
+      /// \param[out] _y First row of the region.
+      /// \param[out] _width Width of the region, zero for the rest of the
+      /// row.
+      /// \param[out] _height Height of the region, zero for the rest of the
+      /// column.
+      /// \sa SetRegionOfInterest
+      public: void RegionOfInterest(unsigned int &_x, unsigned int &_y,
+                  unsigned int &_width, unsigned int &_height) const;
+
+      /// \brief Publish one pixel out of _decimation in each direction of
+      /// the region of interest, dividing the bandwidth by the square of
+      /// _decimation. Applies to the same outputs as SetRegionOfInterest.
+      /// \param[in] _decimation Decimation factor, one to publish every
+      /// pixel.
+      /// \return False if _decimation is zero or the sensor doesn't support
+      /// decimation.
+      public: bool SetDecimation(unsigned int _decimation);
+
+      /// \brief Get the decimation factor.
+      /// \return Decimation factor, one by default.
+      /// \sa SetDecimation
+      public: unsigned int Decimation() const;
+
+      /// \brief Set whether the camera info message is only published when
+      /// it changes, such as when the resolution, the intrinsics, the
+      /// baseline or the region of interest change. It's also published as
+      /// soon as the topic gets subscribers after having none, and then on
+      /// a heartbeat, so subscribers that join while others are connected
+      /// get it within one heartbeat period. Disabled by default, which
+      /// publishes it with every frame.
+      /// \param[in] _onChange True to publish the camera info on change.
+      /// \sa SetInfoHeartbeat
+      public: void SetInfoOnChange(bool _onChange);
+
+      /// \brief Get whether the camera info message is only published when
+      /// it changes.
+      /// \return True if published on change.
+      /// \sa SetInfoOnChange
+      public: bool InfoOnChange() const;
+
+      /// \brief Set the period at which the camera info message is
+      /// republished when it's published on change. Defaults to one
+      /// second.
+      /// \param[in] _period Heartbeat period, zero to only publish on
+      /// change.
+      /// \sa SetInfoOnChange
+      public: void SetInfoHeartbeat(
+                  const std::chrono::steady_clock::duration &_period);
+
+      /// \brief Get the period at which the camera info message is
+      /// republished when it's published on change.
+      /// \return Heartbeat period.
+      /// \sa SetInfoOnChange
+      public: std::chrono::steady_clock::duration InfoHeartbeat() const;
+
+      /// \brief Check if there are subscribers to the optical flow,
+      /// published on the topic of the sensor followed by "/optical_flow".
+      /// The flow is an RGB_FLOAT32 image the size of the full image, with
+      /// the rightward and downward motion in pixels of each pixel since the
+      /// previous flow image, followed by its depth along the camera axis.
+      /// The motion is NaN where there's no surface. A depth camera with the
+      /// same pose and field of view renders with the images while the
+      /// topic has subscribers, and the flow comes from reprojecting its
+      /// depths from the previous camera pose, so it's the flow of a static
+      /// scene: moving objects get the flow of static ones at their place.
+      /// Lens distortion and custom projections aren't modeled. The first
+      /// frame after the topic gets subscribers isn't published, as it has
+      /// no previous pose.
+      /// \return True if there are subscribers, false otherwise
+      public: bool HasOpticalFlowConnections() const;
+
       /// \brief Advertise camera info topic.
       /// \return True if successful.
       protected: bool AdvertiseInfo();
@@ -164,11 +519,46 @@ namespace gz
       /// information.
       protected: void PopulateInfo(const sdf::Camera *_cameraSdf);
 
-      /// \brief Publish camera info message.
+      /// \brief Publish camera info message if the camera info topic has
+      /// subscribers. When InfoOnChange() is true, it's only published if
+      /// the information changed, if the topic just got its first
+      /// subscriber or on the heartbeat.
       /// \param[in] _now The current time
       protected: void PublishInfo(
         const std::chrono::steady_clock::duration &_now);
 
+      /// \brief Queue a frame for compression if the compressed topic has
+      /// subscribers.
+      /// \param[in] _image Width, height, step, pixel format and header of
+      /// the frame. Its data field is ignored.
+      /// \param[in] _data Pixels of the frame.
+      /// \param[in] _size Number of bytes in _data.
+      /// \param[in] _format Pixel format of _data.
+      /// \sa SetCompressedOutput
+      protected: void PublishCompressedImage(const msgs::Image &_image,
+                     const unsigned char *_data, std::size_t _size,
+                     common::Image::PixelFormatType _format);
+
+      /// \brief Get whether the sensor applies the region of interest and
+      /// decimation to its images.
+      /// \return True unless the pixel format is a Bayer pattern.
+      protected: virtual bool HasRegionOfInterestSupport() const;
+
+      /// \brief Apply the region of interest and decimation to an image.
+      /// \param[in] _data Full image, rows stored contiguously.
+      /// \param[in,out] _width Width of the full image, set to the output
+      /// width.
+      /// \param[in,out] _height Height of the full image, set to the output
+      /// height.
+      /// \param[in] _bytesPerPixel Number of bytes of a pixel.
+      /// \param[in,out] _buffer Storage for the output, kept by the caller
+      /// across frames. Unused if the output is the full image.
+      /// \return _data for full images, otherwise the data of _buffer.
+      protected: const unsigned char *ApplyRegionOfInterest(
+                     const unsigned char *_data, unsigned int &_width,
+                     unsigned int &_height, std::size_t _bytesPerPixel,
+                     std::vector<unsigned char> &_buffer) const;
+
       /// \brief Create a camera in a scene
       /// \return True on success.
       private: bool CreateCamera();
@@ -178,6 +568,63 @@ namespace gz
       /// \param[in] _scene Pointer to the new scene.
       private: void OnSceneChange(gz::rendering::ScenePtr /*_scene*/);
 
+      /// \brief Compute and publish the downsampled outputs that have
+      /// subscribers.
+      /// \param[in] _image Published image, without data.
+      /// \param[in] _data Pixels of the published image.
+      /// \param[in] _width Width of the published image.
+      /// \param[in] _height Height of the published image.
+      /// \param[in] _frameTime Time of the frame.
+      private: void PublishDownsampledImages(const msgs::Image &_image,
+                   const unsigned char *_data, unsigned int _width,
+                   unsigned int _height,
+                   const std::chrono::steady_clock::duration &_frameTime);
+
+      /// \brief Convert and publish the converted outputs that have
+      /// subscribers.
+      /// \param[in] _data Pixels of the published image.
+      /// \param[in] _width Width of the published image.
+      /// \param[in] _height Height of the published image.
+      /// \param[in] _frameTime Time of the frame.
+      private: void PublishConvertedImages(const unsigned char *_data,
+                   unsigned int _width, unsigned int _height,
+                   const std::chrono::steady_clock::duration &_frameTime);
+
+      /// \brief Publish an image as tiles if the tiles topic has
+      /// subscribers.
+      /// \param[in] _image Published image, without data.
+      /// \param[in] _data Pixels of the published image.
+      /// \param[in] _height Height of the published image.
+      /// \param[in] _frameTime Time of the frame.
+      private: void PublishTiles(const msgs::Image &_image,
+                   const unsigned char *_data, unsigned int _height,
+                   const std::chrono::steady_clock::duration &_frameTime);
+
+      /// \brief Copy the rendered image into the image buffer, upsampled
+      /// to the published resolution if the render scale is below 1.
+      private: void ReadImage();
+
+      /// \brief Render the extra sub-frames of the motion blur and average
+      /// them with the image that was just read back. Restores the camera
+      /// pose.
+      private: void RenderMotionBlur();
+
+      /// \brief Apply the image noise to the image buffer, when the render
+      /// engine has no noise pass.
+      private: void ApplyCpuNoise();
+
+      /// \brief Create the depth camera of the optical flow if it's needed,
+      /// destroy it otherwise.
+      /// \param[in] _needed True if the optical flow is published.
+      /// \return True if the depth camera exists.
+      private: bool UpdateFlowCamera(bool _needed);
+
+      /// \brief Compute and publish the optical flow from the last depths
+      /// of the flow camera.
+      /// \param[in] _now Time of the update.
+      private: void PublishOpticalFlow(
+                   const std::chrono::steady_clock::duration &_now);
+
       /// \brief Callback for triggered subscription
       /// \param[in] _msg Boolean message
       private: void OnTrigger(const gz::msgs::Boolean &/*_msg*/);
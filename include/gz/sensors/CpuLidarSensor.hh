@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_CPULIDARSENSOR_HH_
+#define GZ_SENSORS_CPULIDARSENSOR_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sdf/sdf.hh>
+
+#include <gz/math/Pose3.hh>
+#include <gz/math/Vector3.hh>
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/cpu_lidar/Export.hh"
+#include "gz/sensors/Lidar.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class CpuLidarSensorPrivate;
+    class CpuRayScenePrivate;
+
+    /// \brief Triangle geometry that CpuLidarSensor casts rays against,
+    /// usually shared by all the lidars of a world. Meshes are registered
+    /// once by name and placed in the world by objects, so that moving an
+    /// object only moves its box in the hierarchy over the objects, which is
+    /// rebuilt before the next scan. Every mesh has its own bounding volume
+    /// hierarchy over its triangles. All functions are thread safe, scans
+    /// run concurrently and wait for edits.
+    class GZ_SENSORS_CPU_LIDAR_VISIBLE CpuRayScene
+    {
+      /// \brief Constructor
+      public: CpuRayScene();
+
+      /// \brief Destructor
+      public: ~CpuRayScene();
+
+      /// \brief Add a mesh, or replace the mesh with the same name. Objects
+      /// that use it are moved to the new mesh.
+      /// \param[in] _name Name of the mesh.
+      /// \param[in] _vertices Vertices, in meters.
+      /// \param[in] _indices Three vertex indices per triangle.
+      /// \return False if an index is out of range or the number of indices
+      /// isn't a multiple of 3.
+      public: bool SetMesh(const std::string &_name,
+                  const std::vector<math::Vector3d> &_vertices,
+                  const std::vector<unsigned int> &_indices);
+
+      /// \brief Add an object, or replace the object with the same id.
+      /// \param[in] _id Id of the object, e.g. its entity.
+      /// \param[in] _mesh Name of a mesh added with SetMesh.
+      /// \param[in] _pose World pose of the object.
+      /// \param[in] _retro Retro reflectance, reported as the intensity of
+      /// the rays that hit the object.
+      /// \return False if there's no such mesh.
+      public: bool SetObject(uint64_t _id, const std::string &_mesh,
+                  const math::Pose3d &_pose, double _retro = 0.0);
+
+      /// \brief Move an object.
+      /// \param[in] _id Id of the object.
+      /// \param[in] _pose World pose of the object.
+      /// \return False if there's no such object.
+      public: bool SetObjectPose(uint64_t _id, const math::Pose3d &_pose);
+
+      /// \brief Remove an object.
+      /// \param[in] _id Id of the object.
+      /// \return False if there's no such object.
+      public: bool RemoveObject(uint64_t _id);
+
+      /// \brief Get the number of objects.
+      /// \return Number of objects.
+      public: std::size_t ObjectCount() const;
+
+      /// \brief Cast rays from a common origin and find their closest hit.
+      /// \param[in] _pose World pose the rays are cast from.
+      /// \param[in] _directions x, y and z of the unit direction of each
+      /// ray, in the frame of _pose.
+      /// \param[in] _count Number of rays.
+      /// \param[in] _rangeMax Farthest distance of a hit.
+      /// \param[out] _hits For each ray, the distance of its hit followed by
+      /// the retro reflectance of the object. Rays that don't hit anything
+      /// closer than _rangeMax get an infinite distance and zero retro.
+      /// \param[in] _stride Distance between the values of consecutive rays
+      /// in _hits, in floats, at least 2.
+      public: void CastRays(const math::Pose3d &_pose,
+                  const float *_directions, std::size_t _count,
+                  double _rangeMax, float *_hits, std::size_t _stride) const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<CpuRayScenePrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+
+    /// \brief Lidar that casts its rays on the CPU against a CpuRayScene,
+    /// so it runs on hosts without a GPU. It's loaded from the same SDF as
+    /// GpuLidarSensor and produces the same outputs: laser scans on its
+    /// topic, point clouds on its topic followed by "/points", with x, y, z,
+    /// intensity and ring fields, and frames with the range, intensity and
+    /// a zero third channel of each ray through ConnectNewLidarFrame.
+    /// Ranges beyond the maximum range are +inf and ranges below the
+    /// minimum range are -inf. Every range sample gets its own ray, so the
+    /// scan has RangeCount() by VerticalRangeCount() rays.
+    ///
+    /// It isn't a rendering sensor, so the Manager updates it from its
+    /// worker threads. The rays of a scan are cast by SetThreadCount()
+    /// threads.
+    class GZ_SENSORS_CPU_LIDAR_VISIBLE CpuLidarSensor : public Lidar
+    {
+      /// \brief constructor
+      public: CpuLidarSensor();
+
+      /// \brief destructor
+      public: virtual ~CpuLidarSensor();
+
+      /// \brief Load the sensor based on data from an sdf::Sensor object.
+      /// \param[in] _sdf SDF Sensor parameters.
+      /// \return true if loading was successful
+      public: virtual bool Load(const sdf::Sensor &_sdf) override;
+
+      /// \brief Load the sensor with SDF parameters.
+      /// \param[in] _sdf SDF Sensor parameters.
+      /// \return true if loading was successful
+      public: virtual bool Load(sdf::ElementPtr _sdf) override;
+
+      /// \brief Initialize values in the sensor
+      /// \return True on success
+      public: virtual bool Init() override;
+
+      /// \brief Force the sensor to generate data
+      /// \param[in] _now The current time
+      /// \return true if the update was successfull
+      public: virtual bool Update(
+        const std::chrono::steady_clock::duration &_now) override;
+
+      /// \brief Set the geometry the rays are cast against.
+      /// \param[in] _scene The geometry, may be shared with other sensors.
+      public: void SetRayScene(std::shared_ptr<CpuRayScene> _scene);
+
+      /// \brief Get the geometry the rays are cast against.
+      /// \return The geometry, null if none was set.
+      public: std::shared_ptr<CpuRayScene> RayScene() const;
+
+      /// \brief Set the number of threads that cast the rays of a scan. The
+      /// rays of the scan are split between the updating thread and
+      /// _count - 1 workers owned by the sensor.
+      /// \param[in] _count Number of threads, zero and one cast on the
+      /// updating thread, which is the default.
+      public: void SetThreadCount(unsigned int _count);
+
+      /// \brief Get the number of threads that cast the rays of a scan.
+      /// \return Number of threads, at least one.
+      public: unsigned int ThreadCount() const;
+
+      /// \brief Set a callback to be called when data is generated.
+      /// \param[in] _subscriber This callback will be called every time the
+      /// sensor generates data. The Update function will be blocked while the
+      /// callbacks are executed.
+      /// \remark Do not block inside of the callback.
+      /// \return A connection pointer that must remain in scope. When the
+      /// connection pointer falls out of scope, the connection is broken.
+      public: gz::common::ConnectionPtr ConnectNewLidarFrame(
+          std::function<void(const float *_scan, unsigned int _width,
+                  unsigned int _height, unsigned int _channels,
+                  const std::string &_format)> _subscriber) override;
+
+      /// \brief Check if there are any subscribers
+      /// \return True if there are subscribers, false otherwise
+      public: bool HasConnections() const override;
+
+      // Documentation inherited
+      public: SensorMemoryUsage MemoryUsage() const override;
+
+      /// \brief The rays are cast on the CPU, so the Manager may update this
+      /// sensor from its worker threads.
+      /// \return False
+      public: bool IsRenderingSensor() const override;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<CpuLidarSensorPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
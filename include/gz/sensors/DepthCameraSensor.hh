@@ -60,6 +60,16 @@ namespace gz
     /// It offers both a gz-transport interface and a direct C++ API
     /// to access the image data. The API works by setting a callback to be
     /// called with image data.
+    ///
+    /// Depths are published as R_FLOAT32 meters. With an L16 image format
+    /// in the SDF, they are published as L_INT16 millimeters instead, with
+    /// 0 for missing or out of range depths, and saved frames hold these
+    /// millimeters in a 16 bit PNG. The point cloud is unaffected.
+    ///
+    /// Gaussian image noise is added to the depths by a render pass on the
+    /// depth camera, so it is applied before the frames are read back. If
+    /// the render engine has no noise pass, the noise is applied to the
+    /// read-back depths on the CPU instead.
     class GZ_SENSORS_DEPTH_CAMERA_VISIBLE DepthCameraSensor
       : public CameraSensor
     {
@@ -148,9 +158,103 @@ namespace gz
       /// \return height of the image
       public: virtual double NearClip() const;
 
+      /// \brief Scale the grayscale images of the depths, which color the
+      /// point cloud and are saved to disk, from white at the near clip
+      /// distance to black at the far one. By default, each image is scaled
+      /// from white at zero to black at its largest finite depth, which
+      /// takes an extra pass over the depths and changes the shades from one
+      /// frame to the next.
+      /// \param[in] _fixed True to scale between the clip distances.
+      public: void SetFixedImageRange(bool _fixed);
+
+      /// \brief Get whether the depth images are scaled between the clip
+      /// distances.
+      /// \return True if the range is fixed.
+      /// \sa SetFixedImageRange
+      public: bool FixedImageRange() const;
+
+      /// \brief Set whether point clouds are published in the layout the
+      /// depth camera computes them in on the GPU: x, y and z as FLOAT32
+      /// followed by an rgba UINT32 field holding red in its most
+      /// significant byte and alpha in its least significant one, 16 bytes
+      /// per point. The message data is then a copy of the read back buffer,
+      /// with no conversion on the CPU, so there's no per point work and the
+      /// read back size is the message size. The colors are the rendered
+      /// colors rather than the depth shades of the default layout, and
+      /// PointCloudResolution() is ignored. Disabled by default.
+      /// \param[in] _gpuLayout True to publish the GPU layout.
+      public: void SetPointCloudGpuLayout(bool _gpuLayout);
+
+      /// \brief Get whether point clouds are published in the GPU layout.
+      /// \return True if the GPU layout is published.
+      /// \sa SetPointCloudGpuLayout
+      public: bool PointCloudGpuLayout() const;
+
+      /// \brief Set whether point clouds are also published compressed on
+      /// the point cloud topic followed by "/compressed", in the format
+      /// described by GpuLidarSensor::SetCompressedPointsOutput. Clouds are
+      /// encoded on a worker thread and only while the compressed topic has
+      /// subscribers. If the worker is still busy when a cloud is ready,
+      /// the cloud replaces the one waiting to be encoded, if any. Must be
+      /// called after Load(). Disabled by default.
+      /// \param[in] _enabled True to enable compressed output.
+      /// \param[in] _resolution Quantization step in meters, positive.
+      /// \return True if the compressed topic could be advertised.
+      public: bool SetCompressedPointsOutput(bool _enabled,
+                  double _resolution = 0.001);
+
+      /// \brief Get whether compressed point cloud output is enabled.
+      /// \return True if compressed output is enabled.
+      /// \sa SetCompressedPointsOutput
+      public: bool CompressedPointsOutput() const;
+
+      /// \brief Check if there are any compressed point cloud subscribers
+      /// \return True if compressed output is enabled and has subscribers.
+      public: bool HasCompressedPointConnections() const;
+
+      /// \brief Set whether an elevation map around the sensor is published
+      /// on the topic of the sensor followed by "/elevation_map", in the
+      /// format described by GpuLidarSensor::SetElevationMapOutput. The
+      /// points rendered by the depth camera are binned into the grid of
+      /// the map, only while the topic has subscribers. Must be called
+      /// after Load(). Disabled by default.
+      /// \param[in] _enabled True to enable the elevation map.
+      /// \param[in] _resolution Size of a cell in meters, positive.
+      /// \param[in] _size Number of cells along each side, positive.
+      /// \param[in] _rate Maximum number of maps published per second, zero
+      /// to publish one after every frame.
+      /// \return True if the map topic could be advertised.
+      public: bool SetElevationMapOutput(bool _enabled,
+                  double _resolution = 0.1, unsigned int _size = 200u,
+                  double _rate = 1.0);
+
+      /// \brief Get whether elevation map output is enabled.
+      /// \return True if elevation map output is enabled.
+      /// \sa SetElevationMapOutput
+      public: bool ElevationMapOutput() const;
+
+      /// \brief Check if there are any elevation map subscribers
+      /// \return True if elevation map output is enabled and has
+      /// subscribers.
+      public: bool HasElevationMapConnections() const;
+
+      /// \brief Check if there are any subscribers to the surface normals,
+      /// published on the topic of the sensor followed by "/normals". The
+      /// normals are an RGB_FLOAT32 image the size of the point cloud with
+      /// the x, y and z of the unit normal at each point, in the frame of
+      /// the points and facing the camera, or NaN where there's no surface.
+      /// They're estimated from the differences between neighbouring points
+      /// of the point cloud rendered by the depth camera, on the point
+      /// cloud threads, and only while the topic has subscribers.
+      /// \return True if there are subscribers, false otherwise
+      public: bool HasNormalConnections() const;
+
       // Documentation inherited.
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited.
+      public: SensorMemoryUsage MemoryUsage() const override;
+
       /// \brief Check if there are any depth subscribers
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasDepthConnections() const;
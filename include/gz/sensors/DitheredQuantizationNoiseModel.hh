@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_DITHEREDQUANTIZATIONNOISEMODEL_HH_
+#define GZ_SENSORS_DITHEREDQUANTIZATIONNOISEMODEL_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <sdf/sdf.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+#include "gz/sensors/Noise.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // Forward declarations
+    class DitheredQuantizationNoiseModelPrivate;
+
+    /** \class DitheredQuantizationNoiseModel \
+    DitheredQuantizationNoiseModel.hh \
+    gz/sensors/DitheredQuantizationNoiseModel.hh
+    **/
+    /// \brief Dithered quantization noise class. Gaussian noise with `mean` and
+    /// `stddev` is added to the input, followed by triangular dither one
+    /// quantization bin wide, and the result is rounded to `precision`. The
+    /// dither makes the quantization error independent of the signal.
+    /// Select it with `<noise type="gaussian"
+    /// gz:type="dithered_quantization">`.
+    class GZ_SENSORS_VISIBLE DitheredQuantizationNoiseModel : public Noise
+    {
+      /// \brief Constructor.
+      public: DitheredQuantizationNoiseModel();
+
+      /// \brief Destructor.
+      public: ~DitheredQuantizationNoiseModel() override;
+
+      // Documentation inherited.
+      public: void Load(const sdf::Noise &_sdf) override;
+
+      // Documentation inherited.
+      public: double ApplyImpl(double _in, double _dt) override;
+
+      // Documentation inherited.
+      public: void ApplyBatchImpl(double *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min,
+                  double _max) override;
+
+      // Documentation inherited.
+      public: void ApplyBatchImpl(float *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min,
+                  double _max) override;
+
+      // Documentation inherited.
+      public: void SetSeed(uint64_t _seed) override;
+
+      // Documentation inherited.
+      public: void SaveState(SensorState &_state) const override;
+
+      // Documentation inherited.
+      public: bool RestoreState(SensorState &_state) override;
+
+      // Documentation inherited.
+      public: void Print(std::ostream &_out) const override;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<DitheredQuantizationNoiseModelPrivate> dataPtr;
+    };
+    }
+  }
+}
+
+#endif
@@ -100,6 +100,7 @@ namespace gz
     ///     <minimum_range></minimum_range>
     ///     <maximum_range></maximum_range>
     ///     <resolution></resolution>
+    ///     <per_beam_rendering></per_beam_rendering>
     ///     <reference_frame></reference_frame>
     ///   </gz:dvl>
     /// </sensor>
@@ -189,6 +190,10 @@ namespace gz
     /// Defaults to 1 cm if left unspecified.
     /// - `<maximum_range>` sets an upper bound for range measurements.
     /// Defaults to 100 m if left unspecified.
+    /// - `<per_beam_rendering>` renders each beam with its own depth sensor,
+    /// only as wide as the beam aperture, instead of a single depth sensor
+    /// that spans all beams. Fewer rays are traced when beams are narrow
+    /// and far apart. Defaults to false if left unspecified.
     /// - `<reference_frame>` sets a transform from the sensor frame to the
     /// reference frame in which all measurements are reported. Defaults to
     /// the identity transform.
@@ -231,6 +236,25 @@ namespace gz
       /// \brief Inherits documentation from parent class
       public: virtual bool HasConnections() const override;
 
+      /// \brief Set the number of threads that process beams. Depth scans
+      /// are searched for beam targets and beams are tracked and sampled by
+      /// the updating thread and _count - 1 workers owned by the sensor.
+      /// Noise is applied and estimates are solved in beam order on the
+      /// updating thread, so results don't depend on the thread count.
+      /// \param[in] _count Number of threads, zero and one process beams on
+      /// the updating thread, which is the default.
+      public: void SetThreadCount(unsigned int _count);
+
+      /// \brief Get the number of threads that process beams.
+      /// \return Number of threads, at least one.
+      public: unsigned int ThreadCount() const;
+
+      /// \brief Inherits documentation from parent class
+      public: void SaveState(SensorState &_state) const override;
+
+      /// \brief Inherits documentation from parent class
+      public: bool RestoreState(SensorState &_state) override;
+
       /// \brief Yield rendering sensors that underpin the implementation.
       ///
       /// \internal
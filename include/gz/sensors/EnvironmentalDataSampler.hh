@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_ENVIRONMENTALDATASAMPLER_HH_
+#define GZ_SENSORS_ENVIRONMENTALDATASAMPLER_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <gz/math/Vector3.hh>
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/EnvironmentalData.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class EnvironmentalDataSamplerPrivate;
+
+    /// \brief Prepared handle to sample columns of environmental data.
+    ///
+    /// The columns are looked up by name once, when the sampler is
+    /// created, and each one keeps its own session on the time varying
+    /// grid. Grids are only stepped when the time changes, and the last
+    /// sample of each column is kept, so querying the same position again,
+    /// or one within the position tolerance, doesn't search the grid.
+    ///
+    /// The sampler refers to the grids of the environmental data, which
+    /// must outlive it.
+    class GZ_SENSORS_VISIBLE EnvironmentalDataSampler
+    {
+      /// \brief Constructor of a sampler without columns.
+      public: EnvironmentalDataSampler();
+
+      /// \brief Constructor
+      /// \param[in] _data Environmental data to sample.
+      /// \param[in] _columns Names of the columns to sample. Empty names
+      /// are columns without data, which are never sampled.
+      public: EnvironmentalDataSampler(const EnvironmentalData &_data,
+                  const std::vector<std::string> &_columns);
+
+      /// \brief Move constructor
+      /// \param[in] _other Sampler to move.
+      public: EnvironmentalDataSampler(
+                  EnvironmentalDataSampler &&_other) noexcept;
+
+      /// \brief Move assignment
+      /// \param[in] _other Sampler to move.
+      /// \return This sampler.
+      public: EnvironmentalDataSampler &operator=(
+                  EnvironmentalDataSampler &&_other) noexcept;
+
+      /// \brief Destructor
+      public: ~EnvironmentalDataSampler();
+
+      /// \brief Check that every named column was found in the data.
+      /// \return True if all the named columns were found.
+      public: bool Valid() const;
+
+      /// \brief Get the number of columns, including those without data.
+      /// \return Number of columns.
+      public: std::size_t ColumnCount() const;
+
+      /// \brief Check if a column has data to sample.
+      /// \param[in] _column Index of the column.
+      /// \return True if the column has data.
+      public: bool HasData(std::size_t _column) const;
+
+      /// \brief Set the distance a position can move before a column is
+      /// sampled again. Queries closer than this to the last sampled
+      /// position of a column return its last sample.
+      /// \param[in] _tolerance Distance in the units of the data, 0 by
+      /// default, so only the same position reuses the last sample.
+      public: void SetPositionTolerance(double _tolerance);
+
+      /// \brief Get the distance a position can move before a column is
+      /// sampled again.
+      /// \return Distance in the units of the data.
+      /// \sa SetPositionTolerance
+      public: double PositionTolerance() const;
+
+      /// \brief Advance all the columns in time. Stepping to the current
+      /// time does nothing.
+      /// \param[in] _now Time to step the grids to.
+      public: void StepTo(const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Sample a column, interpolating its grid.
+      /// \param[in] _column Index of the column.
+      /// \param[in] _pos Position in the data frame.
+      /// \return Sampled value, nullopt if the column has no data or the
+      /// position is out of the grid.
+      public: std::optional<double> LookUp(std::size_t _column,
+                  const math::Vector3d &_pos);
+
+      /// \brief Sample a column at many positions. Consecutive positions
+      /// within the position tolerance of each other share a sample.
+      /// \param[in] _column Index of the column.
+      /// \param[in] _positions Positions in the data frame.
+      /// \param[out] _values Sampled values, one per position, nullopt where
+      /// there's no data. Resized to the number of positions.
+      public: void LookUp(std::size_t _column,
+                  const std::vector<math::Vector3d> &_positions,
+                  std::vector<std::optional<double>> &_values);
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<EnvironmentalDataSamplerPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_FLICKERNOISEMODEL_HH_
+#define GZ_SENSORS_FLICKERNOISEMODEL_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <sdf/sdf.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+#include "gz/sensors/Noise.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // Forward declarations
+    class FlickerNoiseModelPrivate;
+
+    /** \class FlickerNoiseModel FlickerNoiseModel.hh \
+    gz/sensors/FlickerNoiseModel.hh
+    **/
+    /// \brief Flicker noise class. The noise approximates a 1/f power
+    /// spectrum with a fixed bank of first-order Gauss-Markov processes
+    /// whose correlation times are spaced by a factor of four, starting at
+    /// `dynamic_bias_correlation_time`. The total standard deviation is
+    /// `stddev` and the noise is offset by `mean`. Select it with
+    /// `<noise type="gaussian" gz:type="flicker">`.
+    ///
+    /// Each value of a buffer passed to ApplyBatch has its own filter bank,
+    /// advanced by the time step. A time step that isn't positive produces
+    /// uncorrelated samples.
+    class GZ_SENSORS_VISIBLE FlickerNoiseModel : public Noise
+    {
+      /// \brief Constructor.
+      public: FlickerNoiseModel();
+
+      /// \brief Destructor.
+      public: ~FlickerNoiseModel() override;
+
+      // Documentation inherited.
+      public: void Load(const sdf::Noise &_sdf) override;
+
+      // Documentation inherited.
+      public: double ApplyImpl(double _in, double _dt) override;
+
+      // Documentation inherited.
+      public: void ApplyBatchImpl(double *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min,
+                  double _max) override;
+
+      // Documentation inherited.
+      public: void ApplyBatchImpl(float *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min,
+                  double _max) override;
+
+      // Documentation inherited.
+      public: void SetSeed(uint64_t _seed) override;
+
+      // Documentation inherited.
+      public: void SaveState(SensorState &_state) const override;
+
+      // Documentation inherited.
+      public: bool RestoreState(SensorState &_state) override;
+
+      // Documentation inherited.
+      public: void Print(std::ostream &_out) const override;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<FlickerNoiseModelPrivate> dataPtr;
+    };
+    }
+  }
+}
+
+#endif
@@ -18,10 +18,14 @@
 #ifndef GZ_SENSORS_FORCETORQUESENSOR_HH_
 #define GZ_SENSORS_FORCETORQUESENSOR_HH_
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include <sdf/sdf.hh>
 
+#include <gz/common/Event.hh>
 #include <gz/utils/SuppressWarning.hh>
 
 #include <gz/math/Pose3.hh>
@@ -38,6 +42,20 @@ namespace gz
     // Inline bracket to help doxygen filtering.
     inline namespace GZ_SENSORS_VERSION_NAMESPACE {
     //
+    /// \brief Output of a force torque update, with noise applied.
+    /// \sa ForceTorqueSensor::LatestSample
+    struct ForceTorqueSample
+    {
+      /// \brief Time of the update.
+      std::chrono::steady_clock::duration time{0};
+
+      /// \brief Measured force in Newtons.
+      math::Vector3d force;
+
+      /// \brief Measured torque in Newton meters.
+      math::Vector3d torque;
+    };
+
     /// \brief forward declarations
     class ForceTorqueSensorPrivate;
 
@@ -88,6 +106,21 @@ namespace gz
       /// \return The latest measured torque.
       public: math::Vector3d Torque() const;
 
+      /// \brief Get the output of the last update. This can be called from
+      /// any thread, often, without blocking or being blocked by Update.
+      /// \return Latest sample, with a zero time before the first update.
+      public: ForceTorqueSample LatestSample() const;
+
+      /// \brief Set a callback to be called with the output of each
+      /// update. Unlike subscribing to the topic, no message is built for
+      /// the callback.
+      /// \param[in] _callback Callback, called on the thread that updates
+      /// the sensor. Update is blocked while it runs.
+      /// \return A connection pointer that must remain in scope. When the
+      /// connection pointer falls out of scope, the connection is broken.
+      public: gz::common::ConnectionPtr ConnectSampleCallback(
+                  std::function<void(const ForceTorqueSample &)> _callback);
+
       /// \brief Set the torque vector in sensor frame and where the torque is
       /// applied on the child (parent-to-child)
       /// \param[in] _torque torque vector in newton.
@@ -115,10 +148,37 @@ namespace gz
       public: void SetRotationChildInSensor(
                   const math::Quaterniond &_rotChildInSensor);
 
+      /// \brief Set a filter applied to the force and torque after noise,
+      /// on every update, so the sensor can update at the physics rate
+      /// while publishing filtered readings at a lower rate. Samples
+      /// dropped by decimation aren't stored, published or passed to sample
+      /// callbacks. The filter state is reset. No filter by default.
+      /// \param[in] _options Filter options. A sample rate of zero uses
+      /// the update rate of the sensor.
+      /// \return False if the options are invalid, in which case the
+      /// filter is unchanged.
+      public: bool SetOutputFilter(const SignalFilterOptions &_options);
+
+      /// \brief Get the filter applied to the readings.
+      /// \return Filter options.
+      /// \sa SetOutputFilter
+      public: SignalFilterOptions OutputFilter() const;
+
       /// \brief Check if there are any subscribers
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited
+      protected: void SaveInputs(SensorState &_state) const override;
+
+      // Documentation inherited
+      protected: bool InterpolateInputs(SensorState &_from,
+        SensorState &_to, double _alpha) override;
+
+      // Documentation inherited
+      protected: void UpdateBatch(const std::vector<Sensor *> &_sensors,
+        const std::chrono::steady_clock::duration &_now) override;
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief Data pointer for private data
       /// \internal
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_FRAMERECORDER_HH_
+#define GZ_SENSORS_FRAMERECORDER_HH_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4005)
+#pragma warning(disable: 4251)
+#endif
+#include <gz/msgs/image.pb.h>
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/rendering/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class FrameRecorderPrivate;
+    class FrameRecordReaderPrivate;
+
+    /// \brief Header at the start of a frame recording file.
+    ///
+    /// The header is followed by an index of FrameRecordHeader::indexCapacity
+    /// FrameRecordIndexEntry, one per recorded frame, and by the frame data
+    /// starting at FrameRecordHeader::dataOffset. Frames are stored raw, as
+    /// published by the sensor, each one starting on a 64 byte boundary.
+    struct alignas(64) FrameRecordHeader
+    {
+      /// \brief Value of magic for a valid recording, "GZSREC01".
+      static constexpr uint64_t kMagic = 0x31304345525a5347u;
+
+      /// \brief Version of the layout.
+      static constexpr uint32_t kVersion = 1u;
+
+      /// \brief kMagic.
+      uint64_t magic;
+
+      /// \brief kVersion.
+      uint32_t version;
+
+      /// \brief Unused, zero.
+      uint32_t reserved;
+
+      /// \brief Offset of the index from the start of the file.
+      uint64_t indexOffset;
+
+      /// \brief Maximum number of frames.
+      uint64_t indexCapacity;
+
+      /// \brief Offset of the frame data from the start of the file.
+      uint64_t dataOffset;
+
+      /// \brief Number of bytes of frame data, including padding.
+      uint64_t dataSize;
+
+      /// \brief Number of recorded frames. Updated after the frame data and
+      /// its index entry are written.
+      std::atomic<uint64_t> frameCount;
+    };
+
+    /// \brief Index entry of a recorded frame.
+    /// \sa FrameRecordHeader
+    struct FrameRecordIndexEntry
+    {
+      /// \brief Offset of the frame data from the start of the file.
+      uint64_t offset;
+
+      /// \brief Number of bytes of frame data.
+      uint64_t size;
+
+      /// \brief Seconds of the frame stamp.
+      int64_t sec;
+
+      /// \brief Nanoseconds of the frame stamp.
+      int32_t nsec;
+
+      /// \brief Stream of the sensor the frame belongs to, for sensors
+      /// producing several images per update.
+      uint32_t stream;
+
+      /// \brief Frame width.
+      uint32_t width;
+
+      /// \brief Frame height.
+      uint32_t height;
+
+      /// \brief Size of a row in bytes.
+      uint32_t step;
+
+      /// \brief Pixel format, a msgs::PixelFormatType value.
+      uint32_t pixelFormat;
+    };
+
+    /// \brief Appends raw sensor frames to a single memory mapped file laid
+    /// out as described by FrameRecordHeader. Frames are copied as is, so
+    /// recording costs one memory copy per frame and no encoding. The file
+    /// is preallocated and grown geometrically as frames are appended. Only
+    /// available on POSIX platforms.
+    /// \sa FrameRecordReader
+    class GZ_SENSORS_RENDERING_VISIBLE FrameRecorder
+    {
+      /// \brief Constructor
+      public: FrameRecorder();
+
+      /// \brief Destructor. Closes the file.
+      public: ~FrameRecorder();
+
+      /// \brief Create a recording, replacing any existing file.
+      /// \param[in] _path Path of the file.
+      /// \param[in] _maxFrames Maximum number of frames.
+      /// \param[in] _dataSize Number of bytes of frame data to preallocate.
+      /// \return True on success.
+      public: bool Open(const std::string &_path, uint64_t _maxFrames,
+                  uint64_t _dataSize = 0u);
+
+      /// \brief Close the recording, trimming the unused preallocated space.
+      public: void Close();
+
+      /// \brief Get whether a recording is open.
+      /// \return True if a recording is open.
+      public: bool IsOpen() const;
+
+      /// \brief Get the path of the recording.
+      /// \return Path of the file, empty if no recording is open.
+      public: std::string Path() const;
+
+      /// \brief Append a frame.
+      /// \param[in] _stream Stream the frame belongs to.
+      /// \param[in] _image Width, height, step, pixel format and stamp of
+      /// the frame. Its data field is ignored.
+      /// \param[in] _data Frame data.
+      /// \param[in] _size Number of bytes in _data.
+      /// \return False if no recording is open, the maximum number of frames
+      /// has been reached or the file couldn't be grown.
+      public: bool Append(uint32_t _stream, const msgs::Image &_image,
+                  const void *_data, std::size_t _size);
+
+      /// \brief Get the number of recorded frames.
+      /// \return Number of frames.
+      public: uint64_t FrameCount() const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \internal
+      /// \brief Data pointer for private data
+      private: std::unique_ptr<FrameRecorderPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+
+    /// \brief Reads a recording made by FrameRecorder through a read-only
+    /// memory mapping, so frames can be replayed without decoding or
+    /// copying. Only available on POSIX platforms.
+    class GZ_SENSORS_RENDERING_VISIBLE FrameRecordReader
+    {
+      /// \brief Constructor
+      public: FrameRecordReader();
+
+      /// \brief Destructor. Closes the file.
+      public: ~FrameRecordReader();
+
+      /// \brief Open a recording.
+      /// \param[in] _path Path of the file.
+      /// \return True if the file is a valid recording.
+      public: bool Open(const std::string &_path);
+
+      /// \brief Close the recording.
+      public: void Close();
+
+      /// \brief Get the number of frames.
+      /// \return Number of frames, zero if no recording is open.
+      public: uint64_t FrameCount() const;
+
+      /// \brief Get the index entry of a frame.
+      /// \param[in] _index Index of the frame.
+      /// \return The entry, null if _index is out of range.
+      public: const FrameRecordIndexEntry *Entry(uint64_t _index) const;
+
+      /// \brief Get the data of a frame.
+      /// \param[in] _index Index of the frame.
+      /// \return Pointer to FrameRecordIndexEntry::size bytes, valid until
+      /// the recording is closed. Null if _index is out of range.
+      public: const void *Data(uint64_t _index) const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \internal
+      /// \brief Data pointer for private data
+      private: std::unique_ptr<FrameRecordReaderPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_GAUSSMARKOVNOISEMODEL_HH_
+#define GZ_SENSORS_GAUSSMARKOVNOISEMODEL_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <sdf/sdf.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+#include "gz/sensors/Noise.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // Forward declarations
+    class GaussMarkovNoiseModelPrivate;
+
+    /** \class GaussMarkovNoiseModel GaussMarkovNoiseModel.hh \
+    gz/sensors/GaussMarkovNoiseModel.hh
+    **/
+    /// \brief Gauss-Markov noise class. The noise added to each value is a
+    /// stationary first-order Gauss-Markov process with standard deviation
+    /// `stddev` and correlation time `dynamic_bias_correlation_time`, offset
+    /// by `mean`. Select it with `<noise type="gaussian"
+    /// gz:type="gauss_markov">`.
+    ///
+    /// Each value of a buffer passed to ApplyBatch is an independent
+    /// process advanced by the time step, so the noise of e.g. a lidar ray
+    /// is correlated in time but not with the neighboring rays. A time step
+    /// that isn't positive produces uncorrelated samples.
+    class GZ_SENSORS_VISIBLE GaussMarkovNoiseModel : public Noise
+    {
+      /// \brief Constructor.
+      public: GaussMarkovNoiseModel();
+
+      /// \brief Destructor.
+      public: ~GaussMarkovNoiseModel() override;
+
+      // Documentation inherited.
+      public: void Load(const sdf::Noise &_sdf) override;
+
+      // Documentation inherited.
+      public: double ApplyImpl(double _in, double _dt) override;
+
+      // Documentation inherited.
+      public: void ApplyBatchImpl(double *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min,
+                  double _max) override;
+
+      // Documentation inherited.
+      public: void ApplyBatchImpl(float *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min,
+                  double _max) override;
+
+      // Documentation inherited.
+      public: void SetSeed(uint64_t _seed) override;
+
+      // Documentation inherited.
+      public: void SaveState(SensorState &_state) const override;
+
+      // Documentation inherited.
+      public: bool RestoreState(SensorState &_state) override;
+
+      // Documentation inherited.
+      public: void Print(std::ostream &_out) const override;
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<GaussMarkovNoiseModelPrivate> dataPtr;
+    };
+    }
+  }
+}
+
+#endif
@@ -52,6 +52,30 @@ namespace gz
       // Documentation inherited.
       public: double ApplyImpl(double _in, double _dt) override;
 
+      // Documentation inherited.
+      public: void ApplyBatchImpl(double *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min,
+                  double _max) override;
+
+      // Documentation inherited.
+      public: void ApplyBatchImpl(float *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min,
+                  double _max) override;
+
+      /// \brief Give this model its own random stream, seeded with _seed,
+      /// instead of the global math::Rand generator. The constant bias is
+      /// sampled again from the new stream, so a model produces the same
+      /// sequence for the same seed regardless of what other models draw or
+      /// which thread it runs on.
+      /// \param[in] _seed Seed of the stream.
+      public: void SetSeed(uint64_t _seed) override;
+
+      // Documentation inherited.
+      public: void SaveState(SensorState &_state) const override;
+
+      // Documentation inherited.
+      public: bool RestoreState(SensorState &_state) override;
+
       /// \brief Accessor for mean.
       /// \return Mean of Gaussian noise.
       public: double Mean() const;
@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <sdf/sdf.hh>
 
@@ -86,6 +87,15 @@ namespace gz
       /// \return True on success
       public: virtual bool Load(sdf::ElementPtr _sdf) override;
 
+      /// \brief Reconfigure the lidar in place. The gpu rays are created
+      /// again if the ray counts, angles, range or visibility mask changed,
+      /// publishers are kept. Changing the vertical samples fails while
+      /// beam angles are set.
+      /// \param[in] _sdf Sensor settings.
+      /// \return True if the settings were applied.
+      /// \sa Lidar::Reconfigure
+      public: bool Reconfigure(const sdf::Sensor &_sdf) override;
+
       /// \brief Create Lidar sensor
       public: virtual bool CreateLidar() override;
 
@@ -125,6 +135,182 @@ namespace gz
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited
+      public: SensorMemoryUsage MemoryUsage() const override;
+
+      /// \brief Get the topic of the range images. Each image is a
+      /// R_FLOAT32 msgs::Image holding the range of every ray, RangeCount()
+      /// wide and VerticalRangeCount() high, with the noise of the scan
+      /// applied and rays without a hit at +/-infinity. Images are only
+      /// generated while the topic has subscribers, independently of the
+      /// scan and point cloud topics.
+      /// \return Topic of the range images.
+      public: std::string RangeImageTopic() const;
+
+      /// \brief Get the topic of the intensity images, laid out like the
+      /// range images.
+      /// \return Topic of the intensity images.
+      /// \sa RangeImageTopic
+      public: std::string IntensityImageTopic() const;
+
+      /// \brief Set explicit beam angles for sensors with non-uniformly
+      /// spaced beams. The scan is rendered over the span of the
+      /// elevations at half the smallest gap between two beams, and each
+      /// beam samples its nearest rendered row. Row k of the laser scan,
+      /// range images and point cloud then holds beam k. The vertical
+      /// angles of the laser scan message keep their uniform SDF values.
+      /// Setting the angles after the scene recreates the rendering sensor.
+      /// \param[in] _elevations Elevation of each beam in radians, one per
+      /// vertical sample. Empty restores uniformly spaced beams.
+      /// \param[in] _azimuthOffsets Horizontal offset of each beam in
+      /// radians, rounded to the nearest ray. Empty for no offsets.
+      /// \return True if the angles are valid and were applied.
+      public: bool SetBeamAngles(const std::vector<double> &_elevations,
+                  const std::vector<double> &_azimuthOffsets = {});
+
+      /// \brief Get the beam elevations.
+      /// \return Elevation of each beam, empty for uniformly spaced beams.
+      /// \sa SetBeamAngles
+      public: std::vector<double> BeamElevations() const;
+
+      /// \brief Get the beam azimuth offsets.
+      /// \return Horizontal offset of each beam, empty for no offsets.
+      /// \sa SetBeamAngles
+      public: std::vector<double> BeamAzimuthOffsets() const;
+
+      /// \brief Accumulate consecutive scans into each point cloud message,
+      /// to pay the publishing overhead once per batch. The rows of the
+      /// scans are stacked, so a message is _size times as high as a single
+      /// scan, and the "scan_stamps" key of its header holds the stamp of
+      /// each scan in nanoseconds. The message stamp is the one of the last
+      /// scan. The laser scan is still published for every scan.
+      /// \param[in] _size Number of scans per message, zero is treated as
+      /// one, which is the default.
+      public: void SetScanBatchSize(unsigned int _size);
+
+      /// \brief Get the number of scans in each point cloud message.
+      /// \return Number of scans per message.
+      /// \sa SetScanBatchSize
+      public: unsigned int ScanBatchSize() const;
+
+      /// \brief Simulate the motion distortion of a spinning lidar. The
+      /// columns of the scan are split into _slices groups, which are
+      /// captured one after the other across the update period while the
+      /// sensor moves from its previous pose to its current one. Each
+      /// point of the point cloud is expressed in the sensor frame at the
+      /// time of its slice, and a FLOAT32 "t" field holds that time in
+      /// seconds relative to the stamp of the message, from minus the
+      /// period for the first column to zero for the last one. The laser
+      /// scan isn't affected.
+      /// \param[in] _slices Number of slices, clamped to the horizontal ray
+      /// count. Zero disables the rolling scan, which is the default.
+      public: void SetRollingScanSlices(unsigned int _slices);
+
+      /// \brief Get the number of slices of the rolling scan.
+      /// \return Number of slices, zero when the rolling scan is disabled.
+      /// \sa SetRollingScanSlices
+      public: unsigned int RollingScanSlices() const;
+
+      /// \brief Simulate a lidar that reports the strongest and the last
+      /// return of each ray. Each ray is rendered as _samples sub-rays
+      /// spread across its horizontal step, in the same render pass. The
+      /// laser scan, range images and point cloud hold the strongest
+      /// return, the sub-ray with the highest intensity and the nearest
+      /// one on ties. The point cloud gets a FLOAT32 "range2" field and an
+      /// "intensity2" field of the intensity type, holding the farthest
+      /// sub-ray if it's at least _separation beyond the strongest return.
+      /// Otherwise range2 is +inf and intensity2 zero. Noise isn't applied
+      /// to the last return. Setting it after the scene recreates the
+      /// rendering sensor.
+      /// \param[in] _samples Sub-rays per ray, zero or one disables the
+      /// dual return, which is the default.
+      /// \param[in] _separation Minimum distance between the two returns
+      /// in meters, positive.
+      /// \return True if the parameters are valid and were applied.
+      public: bool SetDualReturn(unsigned int _samples,
+                  double _separation = 0.5);
+
+      /// \brief Get the number of sub-rays rendered per ray.
+      /// \return Sub-rays per ray, one when the dual return is disabled.
+      /// \sa SetDualReturn
+      public: unsigned int DualReturnSamples() const;
+
+      /// \brief Get the minimum distance between the two returns.
+      /// \return Minimum separation in meters.
+      /// \sa SetDualReturn
+      public: double DualReturnSeparation() const;
+
+      /// \brief Set whether point clouds are also published compressed on
+      /// the point cloud topic followed by "/compressed". Clouds are
+      /// encoded on a worker thread and only while the compressed topic has
+      /// subscribers. If the worker is still busy when a cloud is ready,
+      /// the cloud replaces the one waiting to be encoded, if any. Must be
+      /// called after Load(). Disabled by default.
+      ///
+      /// Compressed clouds are msgs::PointCloudPacked messages with the
+      /// width, height, steps, fields and header of the cloud, plus a
+      /// "format" header entry set to "delta_xyz" and a
+      /// "compressed_resolution" entry holding the quantization step in
+      /// meters. Their data is, in order:
+      /// - a validity mask of (width * height + 7) / 8 bytes, bit i % 8 of
+      ///   byte i / 8 set if point i, in row major order, has finite
+      ///   coordinates;
+      /// - for each valid point, the zig-zag LEB128 varints of the
+      ///   differences of its x, y and z, rounded to multiples of the
+      ///   step, with the previous valid point of its row, or with zero for
+      ///   the first valid point of a row;
+      /// - for each field after z, its bytes for each valid point.
+      /// \param[in] _enabled True to enable compressed output.
+      /// \param[in] _resolution Quantization step in meters, positive.
+      /// \return True if the compressed topic could be advertised.
+      public: bool SetCompressedPointsOutput(bool _enabled,
+                  double _resolution = 0.001);
+
+      /// \brief Get whether compressed point cloud output is enabled.
+      /// \return True if compressed output is enabled.
+      /// \sa SetCompressedPointsOutput
+      public: bool CompressedPointsOutput() const;
+
+      /// \brief Check if there are any compressed point cloud subscribers
+      /// \return True if compressed output is enabled and has subscribers.
+      public: bool HasCompressedPointConnections() const;
+
+      /// \brief Set whether an elevation map around the sensor is published
+      /// on the lidar topic followed by "/elevation_map". The points of
+      /// each scan are binned into a square grid in the world frame,
+      /// aligned with the world axes and centered on the sensor, while they
+      /// are generated. The grid scrolls by whole cells as the sensor
+      /// moves, keeping the cells that stay in it. Each cell holds the
+      /// height of its highest point, NaN until a point falls in it, so a
+      /// cell is occupied if its height is finite. The grid is only updated
+      /// while the topic has subscribers. Must be called after Load().
+      /// Disabled by default.
+      ///
+      /// Maps are R_FLOAT32 msgs::Image messages with one pixel per cell,
+      /// x increasing along rows and y from one row to the next. Their
+      /// header has a "world" frame_id and "resolution", "origin_x" and
+      /// "origin_y" entries: the lower corner of the first pixel is at
+      /// (origin_x, origin_y), in meters.
+      /// \param[in] _enabled True to enable the elevation map.
+      /// \param[in] _resolution Size of a cell in meters, positive.
+      /// \param[in] _size Number of cells along each side, positive.
+      /// \param[in] _rate Maximum number of maps published per second, zero
+      /// to publish one after every scan.
+      /// \return True if the map topic could be advertised.
+      public: bool SetElevationMapOutput(bool _enabled,
+                  double _resolution = 0.1, unsigned int _size = 200u,
+                  double _rate = 1.0);
+
+      /// \brief Get whether elevation map output is enabled.
+      /// \return True if elevation map output is enabled.
+      /// \sa SetElevationMapOutput
+      public: bool ElevationMapOutput() const;
+
+      /// \brief Check if there are any elevation map subscribers
+      /// \return True if elevation map output is enabled and has
+      /// subscribers.
+      public: bool HasElevationMapConnections() const;
+
       /// \brief Connect function pointer to internal GpuRays callback
       /// \return gz::common::Connection pointer
       public: virtual gz::common::ConnectionPtr ConnectNewLidarFrame(
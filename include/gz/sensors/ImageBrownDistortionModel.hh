@@ -18,6 +18,8 @@
 #ifndef GZ_SENSORS_IMAGEBROWNDISTORTIONMODEL_HH_
 #define GZ_SENSORS_IMAGEBROWNDISTORTIONMODEL_HH_
 
+#include <cstddef>
+
 #include <sdf/sdf.hh>
 
 // TODO(WilliamLewww): Remove these pragmas once gz-rendering is disabling the
@@ -63,6 +65,25 @@ namespace gz
       // Documentation inherited.
       public: virtual void SetCamera(rendering::CameraPtr _camera);
 
+      /// \brief Get whether the distortion is applied to the frames on the
+      /// CPU, because the render engine of the camera has no distortion
+      /// pass. The sensor then calls Distort on each frame.
+      /// \return True if the distortion is applied on the CPU.
+      public: bool DistortsOnCpu() const;
+
+      /// \brief Distort an image on the CPU. The source pixel of each
+      /// output pixel is computed once per image size and cached, so a
+      /// frame is a single gather pass.
+      /// \param[in] _src Undistorted image, rows stored contiguously.
+      /// \param[out] _dst Distorted image, same size as _src. Must not
+      /// overlap _src.
+      /// \param[in] _width Image width.
+      /// \param[in] _height Image height.
+      /// \param[in] _bytesPerPixel Number of bytes of a pixel.
+      public: void Distort(const unsigned char *_src, unsigned char *_dst,
+                  unsigned int _width, unsigned int _height,
+                  std::size_t _bytesPerPixel);
+
       /// Documentation inherited
       public: virtual void Print(std::ostream &_out) const override;
 
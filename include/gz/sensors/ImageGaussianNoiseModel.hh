@@ -18,6 +18,9 @@
 #ifndef GZ_SENSORS_IMAGEGAUSSIANNOISEMODEL_HH_
 #define GZ_SENSORS_IMAGEGAUSSIANNOISEMODEL_HH_
 
+#include <cstddef>
+#include <cstdint>
+
 #include <sdf/sdf.hh>
 
 // TODO(louise) Remove these pragmas once gz-rendering is disabling the
@@ -63,6 +66,56 @@ namespace gz
       // Documentation inherited.
       public: virtual void SetCamera(rendering::CameraPtr _camera);
 
+      /// \brief Get whether the noise is applied to the frames on the CPU,
+      /// because the render engine of the camera has no gaussian noise
+      /// pass. The sensor then calls ApplyToImage on each frame.
+      /// \return True if the noise is applied on the CPU.
+      public: bool AppliesOnCpu() const;
+
+      /// \brief Set the number of threads ApplyToImage splits a frame
+      /// between, the calling thread and worker threads owned by the model.
+      /// The noise doesn't depend on the number of threads.
+      /// \param[in] _count Number of threads. Zero and one apply the noise
+      /// on the calling thread, which is the default.
+      public: void SetThreadCount(unsigned int _count);
+
+      /// \brief Get the number of threads ApplyToImage splits a frame
+      /// between.
+      /// \return Number of threads, at least one.
+      public: unsigned int ThreadCount() const;
+
+      /// \brief Apply the noise to the values of an 8 bit frame on the
+      /// CPU, such as R8G8B8 or L8 pixels. Like the render pass, the mean
+      /// and standard deviation are fractions of the full range, and the
+      /// results are rounded and clamped to it.
+      /// \param[in,out] _data First value.
+      /// \param[in] _count Number of values, i.e. pixels times channels.
+      public: void ApplyToImage(unsigned char *_data, std::size_t _count);
+
+      /// \brief Apply the noise to the values of a 16 bit frame on the
+      /// CPU, such as L16 pixels.
+      /// \param[in,out] _data First value.
+      /// \param[in] _count Number of values, i.e. pixels times channels.
+      /// \sa ApplyToImage(unsigned char *, std::size_t)
+      public: void ApplyToImage(uint16_t *_data, std::size_t _count);
+
+      /// \brief Apply the noise to the values of a floating point frame on
+      /// the CPU, such as depths. The mean and standard deviation are in the
+      /// units of the values. Values that aren't finite, such as depths out
+      /// of range, are left as they are.
+      /// \param[in,out] _data First value.
+      /// \param[in] _count Number of values.
+      public: void ApplyToImage(float *_data, std::size_t _count);
+
+      // Documentation inherited.
+      public: void SetSeed(uint64_t _seed) override;
+
+      // Documentation inherited.
+      public: void SaveState(SensorState &_state) const override;
+
+      // Documentation inherited.
+      public: bool RestoreState(SensorState &_state) override;
+
       /// Documentation inherited
       public: virtual void Print(std::ostream &_out) const override;
 
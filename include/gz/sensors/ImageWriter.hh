@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_IMAGEWRITER_HH_
+#define GZ_SENSORS_IMAGEWRITER_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/common/Image.hh>
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/rendering/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class ImageWriterPrivate;
+
+    /// \brief What ImageWriter does with an image when its queue is full.
+    enum class ImageDropPolicy
+    {
+      /// \brief Wait until there's room in the queue.
+      BLOCK,
+
+      /// \brief Discard the new image.
+      DROP_NEWEST,
+
+      /// \brief Discard the oldest queued image to make room for the new
+      /// one.
+      DROP_OLDEST
+    };
+
+    /// \brief Encodes images to PNG and writes them to disk on a pool of
+    /// background threads, so that sensors saving their frames don't wait
+    /// for the encoder. Images are queued in a bounded queue shared by all
+    /// sensors. The threads are started by the first write. Images still
+    /// queued when the process exits are written before it does.
+    class GZ_SENSORS_RENDERING_VISIBLE ImageWriter
+    {
+      /// \brief Get the image writer shared by all sensors.
+      /// \return The image writer.
+      public: static ImageWriter &Instance();
+
+      /// \brief Destructor. Writes the queued images and stops the threads.
+      public: ~ImageWriter();
+
+      /// \brief Set the number of threads encoding and writing images.
+      /// Queued images are kept.
+      /// \param[in] _count Number of threads. Zero is treated as one.
+      public: void SetWorkerCount(unsigned int _count);
+
+      /// \brief Get the number of threads encoding and writing images.
+      /// Defaults to one.
+      /// \return Number of threads.
+      public: unsigned int WorkerCount() const;
+
+      /// \brief Set the maximum number of images waiting to be written.
+      /// \param[in] _depth Queue depth. Zero is treated as one.
+      public: void SetQueueDepth(std::size_t _depth);
+
+      /// \brief Get the maximum number of images waiting to be written.
+      /// Defaults to 64.
+      /// \return Queue depth.
+      public: std::size_t QueueDepth() const;
+
+      /// \brief Set what happens to an image written while the queue is
+      /// full.
+      /// \param[in] _policy The drop policy.
+      public: void SetDropPolicy(ImageDropPolicy _policy);
+
+      /// \brief Get what happens to an image written while the queue is
+      /// full. Defaults to ImageDropPolicy::BLOCK, so that no image is lost.
+      /// \return The drop policy.
+      public: ImageDropPolicy DropPolicy() const;
+
+      /// \brief Queue an image to be saved as a PNG file.
+      /// \param[in] _filename Path of the file. Its directory must exist.
+      /// \param[in] _data Pixels of the image, moved to the queue.
+      /// \param[in] _width Image width.
+      /// \param[in] _height Image height.
+      /// \param[in] _format Pixel format of _data.
+      /// \return False if the image was dropped.
+      public: bool Write(const std::string &_filename,
+                  std::vector<unsigned char> &&_data, unsigned int _width,
+                  unsigned int _height,
+                  common::Image::PixelFormatType _format);
+
+      /// \brief Queue an image to be saved as a PNG file.
+      /// \param[in] _filename Path of the file. Its directory must exist.
+      /// \param[in] _data Pixels of the image, copied before returning.
+      /// \param[in] _size Number of bytes in _data.
+      /// \param[in] _width Image width.
+      /// \param[in] _height Image height.
+      /// \param[in] _format Pixel format of _data.
+      /// \return False if the image was dropped.
+      public: bool Write(const std::string &_filename,
+                  const unsigned char *_data, std::size_t _size,
+                  unsigned int _width, unsigned int _height,
+                  common::Image::PixelFormatType _format);
+
+      /// \brief Block until all the images queued so far are written.
+      public: void Flush();
+
+      /// \brief Get the number of images dropped because the queue was
+      /// full.
+      /// \return Number of dropped images.
+      public: uint64_t DroppedCount() const;
+
+      /// \brief Constructor, use Instance().
+      private: ImageWriter();
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \internal
+      /// \brief Data pointer for private data
+      private: std::unique_ptr<ImageWriterPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
@@ -17,10 +17,14 @@
 #ifndef GZ_SENSORS_IMUSENSOR_HH_
 #define GZ_SENSORS_IMUSENSOR_HH_
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include <sdf/sdf.hh>
 
+#include <gz/common/Event.hh>
 #include <gz/utils/SuppressWarning.hh>
 #include <gz/math/Pose3.hh>
 
@@ -56,6 +60,28 @@ namespace gz
       CUSTOM = 4
     };
 
+    /// \brief Output of an IMU update, with noise applied.
+    /// \sa ImuSensor::LatestSample
+    struct ImuSample
+    {
+      /// \brief Time of the update.
+      std::chrono::steady_clock::duration time{0};
+
+      /// \brief Orientation in the reference frame, identity when
+      /// hasOrientation is false.
+      math::Quaterniond orientation;
+
+      /// \brief True if orientation is enabled.
+      bool hasOrientation = false;
+
+      /// \brief Angular velocity in body frame, in radians per second.
+      math::Vector3d angularVelocity;
+
+      /// \brief Linear acceleration in local frame, in meters per second
+      /// squared.
+      math::Vector3d linearAcceleration;
+    };
+
     ///
     /// \brief forward declarations
     class ImuSensorPrivate;
@@ -140,6 +166,21 @@ namespace gz
       /// never been enabled.
       public: math::Quaterniond Orientation() const;
 
+      /// \brief Get the output of the last update. This can be called from
+      /// any thread, often, without blocking or being blocked by Update.
+      /// \return Latest sample, with a zero time before the first update.
+      public: ImuSample LatestSample() const;
+
+      /// \brief Set a callback to be called with the output of each
+      /// update. Unlike subscribing to the topic, no message is built for
+      /// the callback.
+      /// \param[in] _callback Callback, called on the thread that updates
+      /// the sensor. Update is blocked while it runs.
+      /// \return A connection pointer that must remain in scope. When the
+      /// connection pointer falls out of scope, the connection is broken.
+      public: gz::common::ConnectionPtr ConnectSampleCallback(
+                  std::function<void(const ImuSample &)> _callback);
+
       /// \brief Set the gravity vector
       /// \param[in] _gravity gravity vector in meters per second squared.
       public: void SetGravity(const math::Vector3d &_gravity);
@@ -166,10 +207,84 @@ namespace gz
       public: void SetWorldFrameOrientation(
         const math::Quaterniond &_rot, WorldFrameEnumType _relativeTo);
 
+      /// \brief Set whether the imu integrates its readings between
+      /// updates. When enabled, Integrate() should be called on every
+      /// physics step after the angular velocity, linear acceleration and
+      /// world pose are set. It accumulates the delta angle and delta
+      /// velocity with coning and sculling corrections, without building a
+      /// message. Update() then publishes the average angular velocity and
+      /// linear acceleration over the interval since the previous update,
+      /// instead of the last instantaneous values. Disabled by default.
+      /// \param[in] _enabled True to integrate readings between updates.
+      public: void SetIntegrationEnabled(bool _enabled);
+
+      /// \brief Get whether the imu integrates its readings between updates.
+      /// \return True if integration is enabled.
+      /// \sa SetIntegrationEnabled
+      public: bool IntegrationEnabled() const;
+
+      /// \brief Accumulate the current angular velocity and linear
+      /// acceleration over the time since the previous call. Does nothing
+      /// if integration is disabled. The first call, and any call after
+      /// time goes backwards, only records the time.
+      /// \param[in] _now The current time.
+      /// \sa SetIntegrationEnabled
+      public: void Integrate(const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Get the delta angle published by the last integrated
+      /// update, i.e. the rotation vector of the imu over the interval, with
+      /// noise applied.
+      /// \return Delta angle in radians, in the imu frame.
+      public: math::Vector3d DeltaAngle() const;
+
+      /// \brief Get the delta velocity published by the last integrated
+      /// update, i.e. the change of velocity due to specific force over the
+      /// interval, with noise applied.
+      /// \return Delta velocity in meters per second, in the imu frame.
+      public: math::Vector3d DeltaVelocity() const;
+
+      /// \brief Set a filter applied to the angular velocity and linear
+      /// acceleration after noise, on every update, so the sensor can
+      /// update at the physics rate while publishing filtered readings at a
+      /// lower rate. Samples dropped by decimation aren't stored, published
+      /// or passed to sample callbacks. The orientation isn't filtered. The
+      /// filter state is reset. No filter by default.
+      /// \param[in] _options Filter options. A sample rate of zero uses
+      /// the update rate of the sensor.
+      /// \return False if the options are invalid, in which case the
+      /// filter is unchanged.
+      public: bool SetOutputFilter(const SignalFilterOptions &_options);
+
+      /// \brief Get the filter applied to the readings.
+      /// \return Filter options.
+      /// \sa SetOutputFilter
+      public: SignalFilterOptions OutputFilter() const;
+
       /// \brief Check if there are any subscribers
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited
+      public: void SaveState(SensorState &_state) const override;
+
+      // Documentation inherited
+      public: bool RestoreState(SensorState &_state) override;
+
+      // Documentation inherited
+      protected: void SaveInputs(SensorState &_state) const override;
+
+      // Documentation inherited
+      protected: bool InterpolateInputs(SensorState &_from,
+        SensorState &_to, double _alpha) override;
+
+      // Documentation inherited
+      protected: void UpdateNoiseState(
+        const std::chrono::steady_clock::duration &_now) override;
+
+      // Documentation inherited
+      protected: void UpdateBatch(const std::vector<Sensor *> &_sensors,
+        const std::chrono::steady_clock::duration &_now) override;
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief Data pointer for private data
       /// \internal
@@ -17,6 +17,8 @@
 #ifndef GZ_SENSORS_LIDAR_HH_
 #define GZ_SENSORS_LIDAR_HH_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -37,6 +39,24 @@ namespace gz
     /// \brief forward declarations
     class LidarPrivate;
 
+    /// \brief Angular zone of a lidar whose rays are blanked, such as the
+    /// part of the field of view occluded by the vehicle carrying it.
+    /// Angles are in radians, in the frame of the sensor.
+    struct LidarBlankingZone
+    {
+      /// \brief Minimum horizontal angle.
+      double angleMin{0.0};
+
+      /// \brief Maximum horizontal angle.
+      double angleMax{0.0};
+
+      /// \brief Minimum vertical angle.
+      double verticalAngleMin{0.0};
+
+      /// \brief Maximum vertical angle.
+      double verticalAngleMax{0.0};
+    };
+
     /// \brief Lidar Sensor Class
     ///
     ///   This class creates laser scans using. It's measures the range
@@ -63,8 +83,42 @@ namespace gz
       /// \brief Apply noise to the laser buffer, if noise has been
       /// configured. This should be called before PublishLidarScan if you
       /// want the scan data to contain noise.
+      ///
+      /// The noise is applied to the ranges on the CPU. Unlike depth
+      /// cameras, GPU lidars can't add it with a render pass, because their
+      /// frames interleave the ranges with other channels and the gaussian
+      /// noise pass would perturb all of them.
       public: void ApplyNoise();
 
+      /// \brief Get whether noise is applied to the ranges.
+      /// \return True if a noise model is configured.
+      /// \sa ApplyNoise
+      public: bool HasNoise() const;
+
+      /// \brief Set the zones of the field of view whose rays are blanked.
+      /// Blanked rays have a +inf range and a zero intensity in the scan,
+      /// and NaN coordinates in point clouds. They're skipped when the scan
+      /// is copied, when noise is applied and when point clouds are filled.
+      /// A horizontal angle is in a zone if it, or the same angle one
+      /// revolution before or after, is within the zone.
+      /// \param[in] _zones Blanking zones, empty to blank no ray, which is
+      /// the default.
+      /// \return True if the zones are valid and were applied.
+      public: bool SetBlankingZones(
+                  const std::vector<LidarBlankingZone> &_zones);
+
+      /// \brief Get the blanking zones.
+      /// \return Blanking zones.
+      /// \sa SetBlankingZones
+      public: std::vector<LidarBlankingZone> BlankingZones() const;
+
+      /// \brief Get the mask of the blanked rays, row major in the layout
+      /// of the scan, non-zero for blanked rays.
+      /// \return Mask of the blanked rays, null when no ray is blanked.
+      /// \sa SetBlankingZones
+      public: std::shared_ptr<const std::vector<uint8_t>> BlankingMask()
+                  const;
+
       /// \brief Publish LaserScan message
       /// \param[in] _now The current time
       /// \return true if the update was successfull
@@ -81,6 +135,16 @@ namespace gz
       /// \return true if loading was successful
       public: virtual bool Load(sdf::ElementPtr _sdf) override;
 
+      /// \brief Reconfigure the lidar in place. All the ray settings can
+      /// be changed: the number of samples, resolution and angles of the
+      /// scan, the range and the noise. The scans, message and blanking mask
+      /// follow the new ray counts; noise models are only replaced if their
+      /// settings changed.
+      /// \param[in] _sdf Sensor settings.
+      /// \return True if the settings were applied.
+      /// \sa Sensor::Reconfigure
+      public: bool Reconfigure(const sdf::Sensor &_sdf) override;
+
       /// \brief Initialize values in the sensor
       /// \return True on success
       public: virtual bool Init() override;
@@ -95,6 +159,15 @@ namespace gz
       /// \brief Finalize the ray
       protected: virtual void Fini();
 
+      /// \brief Set the angles of the rows of the scan for sensors with
+      /// non-uniformly spaced beams, so that the blanking mask follows them.
+      /// \param[in] _elevations Elevation of each row in radians, empty for
+      /// the uniform vertical angles.
+      /// \param[in] _azimuthOffsets Horizontal offset of each row in
+      /// radians, empty for no offsets.
+      protected: void SetBlankingBeams(const std::vector<double> &_elevations,
+                     const std::vector<double> &_azimuthOffsets);
+
       /// \brief Get the minimum angle
       /// \return The minimum angle
       public: gz::math::Angle AngleMin() const;
@@ -240,6 +313,9 @@ namespace gz
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited
+      public: SensorMemoryUsage MemoryUsage() const override;
+
       /// \brief Get the visibility mask
       /// \return Visibility mask
       public: uint32_t VisibilityMask() const;
@@ -249,9 +325,32 @@ namespace gz
       public: mutable std::mutex lidarMutex;
       GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
 
-      /// \brief Raw buffer of laser data.
+      /// \brief Raw buffer of laser data. Points to the latest scan
+      /// committed with CommitScanBuffer, which is owned by the sensor.
+      /// Readers that may run while a new scan is written should use
+      /// AcquireScanBuffer instead.
       public: float *laserBuffer = nullptr;
 
+      /// \brief Get a buffer to write the next scan into. It's neither the
+      /// latest scan nor the one being read, so it can be filled without
+      /// holding lidarMutex.
+      /// \param[in] _samples Number of floats of the scan.
+      /// \return Buffer of _samples floats, owned by the sensor.
+      public: float *ScanWriteBuffer(std::size_t _samples);
+
+      /// \brief Make the buffer of the last ScanWriteBuffer call the latest
+      /// scan, and point laserBuffer to it.
+      public: void CommitScanBuffer();
+
+      /// \brief Get the latest scan and keep it from being overwritten by
+      /// the writer until ReleaseScanBuffer is called. Calls can't be
+      /// nested.
+      /// \return The latest scan, null if there's none.
+      public: float *AcquireScanBuffer();
+
+      /// \brief Release the scan returned by AcquireScanBuffer.
+      public: void ReleaseScanBuffer();
+
       /// \brief true if Load() has been called and was successful
       public: bool initialized = false;
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_SENSORS_LOGICALCAMERAMODELINDEX_HH_
+#define GZ_SENSORS_LOGICALCAMERAMODELINDEX_HH_
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gz/utils/SuppressWarning.hh>
+
+#include <gz/math/AxisAlignedBox.hh>
+#include <gz/math/Frustum.hh>
+#include <gz/math/Pose3.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/logical_camera/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class LogicalCameraModelIndexPrivate;
+
+    /// \brief Poses of the models in the world, kept in a uniform grid so
+    /// that a logical camera only visits the models in the cells its
+    /// frustum overlaps.
+    ///
+    /// A single index can be shared by all logical cameras, see
+    /// LogicalCameraSensor::SetModelIndex, so model poses are set once per
+    /// step for all of them. Models can be registered once with AddModel,
+    /// and then only the poses that changed pushed by id. The index is
+    /// safe to use from several threads.
+    class GZ_SENSORS_LOGICAL_CAMERA_VISIBLE LogicalCameraModelIndex
+    {
+      /// \brief Constructor
+      /// \param[in] _cellSize Length of the side of a grid cell, in meters.
+      /// Cells a few times smaller than the far distance of the cameras
+      /// work well.
+      public: explicit LogicalCameraModelIndex(double _cellSize = 10.0);
+
+      /// \brief Destructor
+      public: ~LogicalCameraModelIndex();
+
+      /// \brief Get the length of the side of a grid cell.
+      /// \return Cell size, in meters.
+      public: double CellSize() const;
+
+      /// \brief Set the models currently in the world. Models that moved
+      /// are updated in the grid, models that are missing are removed.
+      /// \param[in] _models A map of model names to their world pose.
+      public: void SetModelPoses(
+                  const std::map<std::string, math::Pose3d> &_models);
+
+      /// \brief Add a model, or set its pose if it's in the index.
+      /// \param[in] _name Model name.
+      /// \param[in] _pose Model world pose.
+      /// \return Id of the model, valid until the model is removed. Ids of
+      /// removed models are reused.
+      public: std::size_t AddModel(const std::string &_name,
+                                   const math::Pose3d &_pose);
+
+      /// \brief Remove a model.
+      /// \param[in] _id Id of the model.
+      /// \return False if there's no model with that id.
+      public: bool RemoveModel(std::size_t _id);
+
+      /// \brief Set the pose of a model.
+      /// \param[in] _id Id of the model.
+      /// \param[in] _pose Model world pose.
+      /// \return False if there's no model with that id.
+      public: bool SetModelPose(std::size_t _id, const math::Pose3d &_pose);
+
+      /// \brief Set the poses of the models that changed, e.g. since the
+      /// last step. Models that are not listed keep their pose. Unknown
+      /// ids are ignored.
+      /// \param[in] _poses Model ids and their world pose.
+      public: void SetModelPoses(
+                  const std::vector<std::pair<std::size_t, math::Pose3d>>
+                  &_poses);
+
+      /// \brief Set the bounding box of a model, used to detect models
+      /// that intersect a frustum. The model is bounded by the sphere
+      /// around the box.
+      /// \param[in] _id Id of the model.
+      /// \param[in] _box Bounding box in the model frame. An empty box
+      /// bounds the model by its origin.
+      /// \return False if there's no model with that id.
+      /// \sa ForEachModelIntersectingFrustum
+      public: bool SetModelBounds(std::size_t _id,
+                                  const math::AxisAlignedBox &_box);
+
+      /// \brief Get the id of a model.
+      /// \param[in] _name Model name.
+      /// \return Id of the model, nullopt if it's not in the index.
+      public: std::optional<std::size_t> ModelId(
+                  const std::string &_name) const;
+
+      /// \brief Get the number of models in the index.
+      /// \return Number of models.
+      public: std::size_t ModelCount() const;
+
+      /// \brief Call a function for each model whose origin is within a
+      /// frustum. The index must not be modified from the function.
+      /// \param[in] _frustum Frustum, with its pose in the world frame.
+      /// \param[in] _f Function taking the name and world pose of a model.
+      public: void ForEachModelInFrustum(const math::Frustum &_frustum,
+                  const std::function<void(const std::string &,
+                                           const math::Pose3d &)> &_f)
+                  const;
+
+      /// \brief Call a function for each model whose bounding sphere
+      /// intersects a frustum. Models without bounds are tested by their
+      /// origin. Spheres are tested against the frustum planes in batches.
+      /// The index must not be modified from the function.
+      /// \param[in] _frustum Frustum, with its pose in the world frame.
+      /// \param[in] _f Function taking the name and world pose of a model.
+      /// \sa SetModelBounds
+      public: void ForEachModelIntersectingFrustum(
+                  const math::Frustum &_frustum,
+                  const std::function<void(const std::string &,
+                                           const math::Pose3d &)> &_f)
+                  const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<LogicalCameraModelIndexPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
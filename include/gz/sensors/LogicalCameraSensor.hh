@@ -31,6 +31,7 @@
 
 #include "gz/sensors/config.hh"
 #include "gz/sensors/Export.hh"
+#include "gz/sensors/LogicalCameraModelIndex.hh"
 #include "gz/sensors/logical_camera/Export.hh"
 #include "gz/sensors/Sensor.hh"
 
@@ -85,10 +86,77 @@ namespace gz
       /// \return Far distance.
       public: double Far() const;
 
-      /// \brief Set the models currently in the world
+      /// \brief Set the models currently in the world. They're indexed by
+      /// the sensor on its next update. Ignored while the sensor uses a
+      /// model index set with SetModelIndex.
       /// \param[in] _models A map of model names to their world pose.
       public: void SetModelPoses(std::map<std::string, math::Pose3d> &&_models);
 
+      /// \brief Set an index of the models in the world to detect models
+      /// from, instead of the poses given to SetModelPoses. The index can
+      /// be shared with other logical cameras, and its poses are set once
+      /// for all of them.
+      /// \param[in] _index Model index, null to go back to the poses given
+      /// to SetModelPoses.
+      public: void SetModelIndex(
+                  std::shared_ptr<const LogicalCameraModelIndex> _index);
+
+      /// \brief Get the model index set with SetModelIndex.
+      /// \return Model index, null if the sensor uses its own poses.
+      public: std::shared_ptr<const LogicalCameraModelIndex>
+                  ModelIndex() const;
+
+      /// \brief Set whether models are detected when their bounding
+      /// volume intersects the frustum, instead of when their origin is
+      /// within it. Bounds are set on the index given to SetModelIndex,
+      /// with LogicalCameraModelIndex::SetModelBounds. Disabled by default.
+      /// \param[in] _enabled True to detect models by their bounds.
+      public: void SetBoundingVolumeDetection(bool _enabled);
+
+      /// \brief Get whether models are detected by their bounding volume.
+      /// \return True if models are detected by their bounds.
+      /// \sa SetBoundingVolumeDetection
+      public: bool BoundingVolumeDetection() const;
+
+      /// \brief Set what the delta images published on the topic of the
+      /// sensor followed by "/delta" include. A delta image lists the
+      /// models that entered the frustum and the visible models whose pose
+      /// relative to the camera changed by more than the tolerances since
+      /// it was last published. The `left` entry of its header has the
+      /// names of the models that left the frustum. Keyframes list all the
+      /// visible models and have a `keyframe` header entry of 1, instead of
+      /// 0, so consumers can reset their models. A keyframe is published
+      /// for the first delta image a subscriber gets and then every
+      /// _keyframePeriod images. Defaults to zero tolerances and a
+      /// keyframe every 100 images.
+      /// \param[in] _positionTolerance Position change, in meters, from
+      /// which a pose is published again.
+      /// \param[in] _rotationTolerance Rotation change from which a pose is
+      /// published again.
+      /// \param[in] _keyframePeriod Number of delta images between
+      /// keyframes, zero for keyframes only when subscribers appear.
+      public: void SetDeltaPublishing(double _positionTolerance,
+                  const math::Angle &_rotationTolerance,
+                  unsigned int _keyframePeriod);
+
+      /// \brief Get the position change from which a pose is published
+      /// again in delta images.
+      /// \return Position tolerance, in meters.
+      /// \sa SetDeltaPublishing
+      public: double DeltaPositionTolerance() const;
+
+      /// \brief Get the rotation change from which a pose is published
+      /// again in delta images.
+      /// \return Rotation tolerance.
+      /// \sa SetDeltaPublishing
+      public: math::Angle DeltaRotationTolerance() const;
+
+      /// \brief Get the number of delta images between keyframes.
+      /// \return Keyframe period, zero if keyframes are only published
+      /// when subscribers appear.
+      /// \sa SetDeltaPublishing
+      public: unsigned int DeltaKeyframePeriod() const;
+
       /// \brief Get the horizontal field of view. The field of view is the
       /// angle between the frustum's vertex and the edges of the near or far
       /// plane. This value represents the horizontal angle.
@@ -109,6 +177,14 @@ namespace gz
       /// \return List of detected models.
       public: msgs::LogicalCameraImage Image() const;
 
+      /// \brief Get the latest image without copying it or waiting for
+      /// Update. The image is immutable and can be kept while newer images
+      /// are produced. Images are only snapshotted once this has been called,
+      /// the first call copies the latest image under the sensor lock.
+      /// \return Latest image.
+      public: std::shared_ptr<const msgs::LogicalCameraImage>
+                  LatestImage() const;
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief Data pointer for private data
       /// \internal
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_MAGNETICDIPOLEMODEL_HH_
+#define GZ_SENSORS_MAGNETICDIPOLEMODEL_HH_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include <gz/math/Angle.hh>
+#include <gz/math/SphericalCoordinates.hh>
+#include <gz/math/Vector3.hh>
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class MagneticDipoleModelPrivate;
+
+    /// \brief Dipole approximation of the Earth magnetic field in a world,
+    /// shared by its magnetometers.
+    ///
+    /// The field is only the degree 1 (dipole) part of the IGRF-13 main
+    /// field model, with its secular variation, at a fixed date. It isn't
+    /// the full IGRF-13 model: its intensity is typically within about 10%
+    /// of the full model, with larger errors in places such as the South
+    /// Atlantic Anomaly, and its declination can be off by more than 10
+    /// degrees. Where heading accuracy matters, set a field computed with
+    /// a full model, e.g. IGRF or WMM, with
+    /// MagnetometerSensor::SetWorldMagneticField instead.
+    ///
+    /// The world is split into cubic regions, and the field is evaluated
+    /// once at the center of each region the first time it's needed and
+    /// cached, so a fleet of magnetometers, see
+    /// MagnetometerSensor::SetFieldModel, only evaluates the model when
+    /// entering a new region. Looking up the field is thread safe.
+    class GZ_SENSORS_VISIBLE MagneticDipoleModel
+    {
+      /// \brief Index of a region along the world x, y and z axes.
+      public: using Cell = std::array<int64_t, 3>;
+
+      /// \brief Constructor
+      /// \param[in] _origin Spherical coordinates of the world.
+      /// \param[in] _decimalYear Date of the field, e.g. 2024.5.
+      /// \param[in] _resolution Size of the regions, in meters. The dipole
+      /// field changes by less than 0.05% per kilometer near the surface.
+      /// Non positive resolutions become 1000 meters.
+      public: explicit MagneticDipoleModel(
+                  const math::SphericalCoordinates &_origin,
+                  double _decimalYear = 2020.0,
+                  double _resolution = 1000.0);
+
+      /// \brief Destructor
+      public: ~MagneticDipoleModel();
+
+      /// \brief Get the spherical coordinates of the world.
+      /// \return Spherical coordinates.
+      public: const math::SphericalCoordinates &Origin() const;
+
+      /// \brief Get the date of the field.
+      /// \return Decimal year.
+      public: double DecimalYear() const;
+
+      /// \brief Get the size of the regions.
+      /// \return Resolution in meters.
+      public: double Resolution() const;
+
+      /// \brief Get the region a position is in.
+      /// \param[in] _pos Position in the world frame.
+      /// \return Region.
+      public: Cell CellOf(const math::Vector3d &_pos) const;
+
+      /// \brief Get the field of a region, evaluating it the first time.
+      /// \param[in] _cell Region.
+      /// \return Magnetic field in the world frame, in teslas.
+      public: math::Vector3d Field(const Cell &_cell) const;
+
+      /// \brief Get the field of the region a position is in.
+      /// \param[in] _pos Position in the world frame.
+      /// \return Magnetic field in the world frame, in teslas.
+      public: math::Vector3d Field(const math::Vector3d &_pos) const;
+
+      /// \brief Evaluate the dipole field.
+      /// \param[in] _latitude Latitude.
+      /// \param[in] _longitude Longitude.
+      /// \param[in] _altitude Altitude in meters, above the 6371.2 km
+      /// reference sphere of the model.
+      /// \param[in] _decimalYear Date of the field.
+      /// \return East, north and up components of the field, in teslas.
+      public: static math::Vector3d Evaluate(const math::Angle &_latitude,
+                  const math::Angle &_longitude, double _altitude,
+                  double _decimalYear);
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<MagneticDipoleModelPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
@@ -18,6 +18,7 @@
 #define GZ_SENSORS_MAGNETOMETERSENSOR_HH_
 
 #include <memory>
+#include <vector>
 
 #include <sdf/sdf.hh>
 
@@ -25,6 +26,7 @@
 #include <gz/math/Pose3.hh>
 
 #include <gz/sensors/config.hh>
+#include <gz/sensors/MagneticDipoleModel.hh>
 #include <gz/sensors/magnetometer/Export.hh>
 
 #include "gz/sensors/Sensor.hh"
@@ -81,7 +83,8 @@ namespace gz
       /// \return Pose in world frame.
       public: math::Pose3d WorldPose() const;
 
-      /// \brief Set the magnetic field vector in world frame
+      /// \brief Set the magnetic field vector in world frame. Not used
+      /// while a field model is set.
       /// \param[in] _field Magnetic field vector in world frame.
       public: void SetWorldMagneticField(const math::Vector3d &_field);
 
@@ -89,6 +92,21 @@ namespace gz
       /// \return Magnetic field vector in world frame
       public: math::Vector3d WorldMagneticField() const;
 
+      /// \brief Set a model to get the world magnetic field at the sensor's
+      /// position from, instead of the field set with
+      /// SetWorldMagneticField(). The field is only looked up in the model
+      /// when the sensor moves to another region of it. A single model can
+      /// be shared by many sensors.
+      /// \param[in] _model Field model, null to use the world field set with
+      /// SetWorldMagneticField(), which is the default.
+      public: void SetFieldModel(
+                  std::shared_ptr<const MagneticDipoleModel> _model);
+
+      /// \brief Get the model the world magnetic field is looked up in.
+      /// \return Field model, null if the world field is set directly.
+      /// \sa SetFieldModel
+      public: std::shared_ptr<const MagneticDipoleModel> FieldModel() const;
+
       /// \brief Get the magnetic field vector in body frame
       /// \return Magnetic field vector in body frame
       public: math::Vector3d MagneticField() const;
@@ -97,6 +115,10 @@ namespace gz
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited
+      protected: void UpdateBatch(const std::vector<Sensor *> &_sensors,
+        const std::chrono::steady_clock::duration &_now) override;
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief Data pointer for private data
       /// \internal
@@ -17,8 +17,14 @@
 #ifndef GZ_SENSORS_MANAGER_HH_
 #define GZ_SENSORS_MANAGER_HH_
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <type_traits>
 #include <vector>
@@ -27,8 +33,13 @@
 #include <gz/common/Console.hh>
 #include <gz/sensors/config.hh>
 #include <gz/sensors/Export.hh>
+#include <gz/sensors/RenderTaskQueue.hh>
 #include <gz/sensors/Sensor.hh>
+#include <gz/sensors/SensorBundle.hh>
 #include <gz/sensors/SensorFactory.hh>
+#include <gz/sensors/SensorPrototype.hh>
+#include <gz/sensors/SensorRecorder.hh>
+#include <gz/sensors/SensorReplay.hh>
 
 namespace gz
 {
@@ -39,6 +50,45 @@ namespace gz
     // Forward declarations
     class ManagerPrivate;
 
+    /// \brief Diagnostics of a Manager::RunOnce call that took longer than
+    /// the step budget.
+    /// \sa Manager::SetStepBudget
+    struct ManagerStepOverrun
+    {
+      /// \brief Wall-clock cost of an update of the step.
+      struct SensorCost
+      {
+        /// \brief ID of the sensor, NO_SENSOR for the render batch
+        /// callback.
+        SensorId id{NO_SENSOR};
+
+        /// \brief Name of the sensor.
+        std::string name;
+
+        /// \brief Wall-clock duration of the update. Sensors updated as a
+        /// group share the duration of the group equally.
+        std::chrono::steady_clock::duration cost{0};
+      };
+
+      /// \brief Time the step updated the sensors for.
+      std::chrono::steady_clock::duration time{0};
+
+      /// \brief Wall-clock duration of the step.
+      std::chrono::steady_clock::duration duration{0};
+
+      /// \brief Budget of the step.
+      std::chrono::steady_clock::duration budget{0};
+
+      /// \brief Number of overruns since the previous report, including
+      /// this one.
+      uint64_t overruns{0u};
+
+      /// \brief Updates run in the step, most expensive first. Sensors
+      /// updated by the render queue run outside of the steps and aren't
+      /// included.
+      std::vector<SensorCost> sensors;
+    };
+
     /// \brief Loads and runs sensors
     ///
     ///   This class is responsible for loading and running sensors, and
@@ -74,6 +124,7 @@ namespace gz
               SensorType *CreateSensor(SdfType _sdf)
               {
                 SensorFactory sensorFactory;
+                sensorFactory.SetAdvertiseDeferred(this->AdvertiseDeferred());
                 auto sensor = sensorFactory.CreateSensor<SensorType>(_sdf);
                 if (nullptr == sensor)
                 {
@@ -89,8 +140,118 @@ namespace gz
                 return result;
               }
 
+      /// \brief Create a sensor of a custom type registered with
+      /// SensorFactory::RegisterCustomType.
+      /// \param[in] _sdf An SDF element or DOM object of a custom sensor.
+      /// \tparam SdfType It may be an `sdf::ElementPtr` containing a sensor or
+      /// an `sdf::Sensor`.
+      /// \return A pointer to the created sensor. Null returned on
+      /// error. The Manager keeps ownership of the pointer's lifetime.
+      public: template<typename SdfType>
+              gz::sensors::Sensor *CreateCustomSensor(SdfType _sdf)
+              {
+                SensorFactory sensorFactory;
+                sensorFactory.SetAdvertiseDeferred(this->AdvertiseDeferred());
+                auto sensor = sensorFactory.CreateCustomSensor(_sdf);
+                if (nullptr == sensor)
+                {
+                  gzerr << "Failed to create sensor." << std::endl;
+                  return nullptr;
+                }
+                auto result = sensor.get();
+                if (NO_SENSOR == this->AddSensor(std::move(sensor)))
+                {
+                  gzerr << "Failed to add sensor." << std::endl;
+                  return nullptr;
+                }
+                return result;
+              }
+
+      /// \brief Create sensors of the same type, loading them in parallel.
+      /// \sa SensorFactory::CreateSensors for the sensors that may be
+      /// created this way.
+      /// \param[in] _sdfs SDF elements or DOM objects.
+      /// \param[in] _threadCount Number of threads loading the sensors,
+      /// including the calling one. Zero uses one thread per hardware
+      /// thread.
+      /// \tparam SensorType Sensor type
+      /// \tparam SdfType It may be an `sdf::ElementPtr` containing a sensor or
+      /// an `sdf::Sensor`.
+      /// \return Pointers to the created sensors, in the order of _sdfs.
+      /// Sensors that failed to be created are null. The Manager keeps
+      /// ownership of the pointers' lifetime.
+      public: template<typename SensorType, typename SdfType>
+              std::vector<SensorType *> CreateSensors(
+                  const std::vector<SdfType> &_sdfs,
+                  unsigned int _threadCount = 0u)
+              {
+                SensorFactory sensorFactory;
+                sensorFactory.SetAdvertiseDeferred(this->AdvertiseDeferred());
+                auto sensors = sensorFactory.CreateSensors<SensorType>(
+                    _sdfs, _threadCount);
+                std::vector<SensorType *> result(sensors.size(), nullptr);
+                for (std::size_t i = 0; i < sensors.size(); ++i)
+                {
+                  if (nullptr == sensors[i])
+                  {
+                    gzerr << "Failed to create sensor." << std::endl;
+                    continue;
+                  }
+                  SensorType *sensor = sensors[i].get();
+                  if (NO_SENSOR == this->AddSensor(std::move(sensors[i])))
+                  {
+                    gzerr << "Failed to add sensor." << std::endl;
+                    continue;
+                  }
+                  result[i] = sensor;
+                }
+                return result;
+              }
+
+      /// \brief Create identical sensors from a prototype, loading them in
+      /// parallel.
+      /// \sa CreateSensors(const std::vector<SdfType> &, unsigned int)
+      /// \param[in] _prototype Description shared by the sensors.
+      /// \param[in] _instances Name, topic and parent of each sensor.
+      /// \param[in] _threadCount Number of threads loading the sensors,
+      /// including the calling one. Zero uses one thread per hardware
+      /// thread.
+      /// \tparam SensorType Sensor type
+      /// \return Pointers to the created sensors, in the order of
+      /// _instances. Sensors that failed to be created are null. The
+      /// Manager keeps ownership of the pointers' lifetime.
+      public: template<typename SensorType>
+              std::vector<SensorType *> CreateSensors(
+                  const SensorPrototype &_prototype,
+                  const std::vector<SensorInstance> &_instances,
+                  unsigned int _threadCount = 0u)
+              {
+                if (!_prototype.Valid())
+                {
+                  gzerr << "Failed to create sensors, invalid prototype."
+                        << std::endl;
+                  return std::vector<SensorType *>(
+                      _instances.size(), nullptr);
+                }
+
+                auto result = this->CreateSensors<SensorType>(
+                    _prototype.Instances(_instances), _threadCount);
+                for (std::size_t i = 0; i < result.size(); ++i)
+                {
+                  if (nullptr != result[i] && !_instances[i].parent.empty())
+                    result[i]->SetParent(_instances[i].parent);
+                }
+                return result;
+              }
 
       /// \brief Add a sensor for this manager to manage.
+      ///
+      /// It may be called while RunOnce runs on another thread, or from
+      /// the step itself, such as from a sensor callback. The sensor is
+      /// then staged and added at the start of the next RunOnce, so the
+      /// step is never blocked. Staged sensors can already be looked up
+      /// with Sensor() and SensorIds(). The other functions of the manager
+      /// must not be called concurrently with RunOnce.
       /// \sa Sensor()
       /// \param[in] _sensor Pointer to the sensor
       /// \return A sensor id that refers to the created sensor. NO_SENSOR
@@ -103,18 +264,441 @@ namespace gz
       public: gz::sensors::Sensor *Sensor(
                   gz::sensors::SensorId _id);
 
-      /// \brief Remove a sensor by ID
+      /// \brief Remove a sensor by ID. Like AddSensor, it may be called
+      /// while RunOnce runs, in which case the sensor keeps being updated
+      /// until the step ends and is destroyed at the start of the next
+      /// RunOnce.
       /// \param[in] _id ID of the sensor to remove
       /// \return True if the sensor exists and removed.
       public: bool Remove(const gz::sensors::SensorId _id);
 
+      /// \brief Get the ids of the loaded sensors.
+      /// \return Ids in increasing order.
+      public: std::vector<SensorId> SensorIds() const;
+
       /// \brief Run the sensor generation one step.
+      ///
+      /// Sensors are kept in a schedule ordered by their next data update
+      /// time, so only sensors that are due are visited. Changes made
+      /// through Sensor::SetUpdateRate, Sensor::SetNextDataUpdateTime or
+      /// Sensor::Init are picked up on the next call.
+      ///
+      /// Due sensors are updated by Sensor::Priority and then by id. Control
+      /// sensors are updated first on the calling thread, before the others
+      /// are handed to the workers or the render batch.
       /// \param _time: The current simulated time
       /// \param _force: If true, all sensors are forced to update. Otherwise
       ///        a sensor will update based on it's Hz rate.
       public: void RunOnce(const std::chrono::steady_clock::duration &_time,
                   bool _force = false);
 
+      /// \brief Get the earliest time at which any active sensor is due to
+      /// generate data. This can be used to skip calls to RunOnce, or to
+      /// batch several simulation steps, while no sensor needs updating.
+      /// \return The earliest Sensor::NextDataUpdateTime() among the active
+      /// sensors. Sensors with a zero update rate are due every cycle, in
+      /// which case std::chrono::steady_clock::duration::min() is returned.
+      /// If there are no active sensors
+      /// std::chrono::steady_clock::duration::max() is returned.
+      public: std::chrono::steady_clock::duration NextUpdateTime();
+
+      /// \brief Set whether RunOnce updates due sensors of the same type
+      /// together through Sensor::UpdateGroup, so that sensor types which
+      /// override Sensor::UpdateBatch can process them over contiguous state.
+      /// The data produced by each sensor is the same, but sensors are
+      /// updated group by group instead of in id order. Rendering sensors are
+      /// never grouped. Defaults to false. When disabled, the sensors whose
+      /// Sensor::HasBatchUpdate() is true, such as BatchSensor types, are
+      /// still grouped, and updated before the other sensors of their
+      /// priority class, on the thread calling RunOnce.
+      /// \param[in] _grouped True to enable grouped updates.
+      public: void SetGroupedUpdate(bool _grouped);
+
+      /// \brief Get whether due sensors of the same type are updated
+      /// together.
+      /// \return True if grouped updates are enabled.
+      /// \sa SetGroupedUpdate
+      public: bool GroupedUpdate() const;
+
+      /// \brief Set the number of worker threads used by RunOnce to update
+      /// sensors in parallel. Only sensors that don't require rendering are
+      /// dispatched to the workers, rendering sensors are always updated on
+      /// the thread that calls RunOnce. RunOnce returns once every sensor has
+      /// been updated. The default is zero, which updates all sensors
+      /// sequentially on the calling thread.
+      /// \param[in] _count Number of worker threads.
+      /// \sa Sensor::IsRenderingSensor
+      public: void SetWorkerThreadCount(unsigned int _count);
+
+      /// \brief Get the number of worker threads used by RunOnce.
+      /// \return Number of worker threads, zero if sensors are updated
+      /// sequentially.
+      /// \sa SetWorkerThreadCount
+      public: unsigned int WorkerThreadCount() const;
+
+      /// \brief Pin the worker threads to sets of CPUs, such as the CPUs of
+      /// the NUMA nodes of the machine. Worker i runs on the set
+      /// i % _cpuSets.size(). Each sensor handed to the workers is placed on
+      /// the set with the fewest sensors the first time it's updated, and is
+      /// then only updated by the workers of that set, so the buffers it
+      /// allocates are first touched, and with the default Linux policy
+      /// allocated, on the memory node of that set. The thread calling
+      /// RunOnce doesn't help the pinned workers. Sets without a worker
+      /// aren't used. Grouped updates are handed out regardless of the
+      /// placement. Pinning is only supported on Linux. Running workers
+      /// are restarted.
+      /// \param[in] _cpuSets CPU indices of each set, empty to not pin the
+      /// workers. Empty sets are ignored.
+      /// \sa SetWorkerThreadCount
+      /// \sa SetGroupedUpdate
+      public: void SetWorkerAffinity(
+                  const std::vector<std::vector<unsigned int>> &_cpuSets);
+
+      /// \brief Get the CPU sets the worker threads are pinned to.
+      /// \return CPU indices of each set, empty if the workers aren't
+      /// pinned.
+      /// \sa SetWorkerAffinity
+      public: std::vector<std::vector<unsigned int>> WorkerAffinity() const;
+
+      /// \brief Pin the worker threads to NUMA nodes, using the CPUs of each
+      /// node as a set of SetWorkerAffinity. Only supported on Linux.
+      /// \param[in] _nodes Indices of the NUMA nodes.
+      /// \return False if a node has no CPUs, in which case the affinity
+      /// isn't changed.
+      /// \sa SetWorkerAffinity
+      public: bool SetWorkerNumaNodes(const std::vector<unsigned int> &_nodes);
+
+      /// \brief Record the messages published by every sensor, including
+      /// the ones added later, straight from Sensor::Publish to an MCAP
+      /// file. It must not be called concurrently with RunOnce.
+      /// \param[in] _recorder Recorder with an open file, null to stop
+      /// recording.
+      /// \sa Sensor::SetRecorder
+      public: void SetRecorder(std::shared_ptr<SensorRecorder> _recorder);
+
+      /// \brief Get the recorder the sensors are recorded to.
+      /// \return The recorder, null if not recording.
+      /// \sa SetRecorder
+      public: std::shared_ptr<SensorRecorder> Recorder() const;
+
+      /// \brief Have sensors publish the messages of a recording instead
+      /// of computing them, including the ones added later. They're still
+      /// scheduled and publish on the same topics, but replayed rendering
+      /// sensors don't render, so a run needs no GPU. It must not be
+      /// called concurrently with RunOnce.
+      /// \param[in] _replay Replay with an open file, null to compute data
+      /// again.
+      /// \param[in] _sensors Names or SDF types, such as "camera", of the
+      /// sensors to replay. All sensors are replayed if empty.
+      /// \sa Sensor::SetReplay
+      public: void SetReplay(std::shared_ptr<SensorReplay> _replay,
+                  const std::vector<std::string> &_sensors = {});
+
+      /// \brief Get the replay the selected sensors publish from.
+      /// \return The replay, null if not replaying.
+      /// \sa SetReplay
+      public: std::shared_ptr<SensorReplay> Replay() const;
+
+      /// \brief Publish the messages of a group of sensors together, one
+      /// frame per update of the first sensor of the group holding its
+      /// messages and the ones the other sensors published since the
+      /// previous frame, e.g. a camera followed by an imu to get each image
+      /// with the imu samples leading to it. Give the sensors a common rate
+      /// or trigger for their data to be time aligned. The sensors are
+      /// pinned with SetPhaseAligned so staggering doesn't split them, and
+      /// keep publishing on their own topics. It must not be called
+      /// concurrently with RunOnce.
+      /// \param[in] _topic Topic of the frames, see SensorBundleHeader.
+      /// \param[in] _sensors Ids of the sensors, the first one closes the
+      /// frames. A sensor can only be in one bundle.
+      /// \return False if a sensor doesn't exist or is already bundled, or
+      /// if the topic is already used by a bundle or can't be advertised.
+      /// \sa Sensor::SetBundle
+      public: bool AddBundle(const std::string &_topic,
+                  const std::vector<SensorId> &_sensors);
+
+      /// \brief Stop publishing the frames of a bundle. Its sensors are
+      /// unpinned unless they were pinned before AddBundle.
+      /// \param[in] _topic Topic of the frames.
+      /// \return False if there's no bundle on the topic.
+      public: bool RemoveBundle(const std::string &_topic);
+
+      /// \brief Get a bundle, e.g. to set a frame callback.
+      /// \param[in] _topic Topic of the frames.
+      /// \return The bundle, null if there's none on the topic.
+      public: std::shared_ptr<SensorBundle> Bundle(
+                  const std::string &_topic) const;
+
+      /// \brief Function that renders the due rendering sensors of a
+      /// RunOnce together. It receives the sensors and the time they are
+      /// updated for.
+      /// \sa SetRenderBatchCallback
+      public: using RenderBatchCallback = std::function<void(
+                  const std::vector<gz::sensors::Sensor *> &,
+                  const std::chrono::steady_clock::duration &)>;
+
+      /// \brief Set a function called by RunOnce with all the due rendering
+      /// sensors, right before they are updated, so that they can be
+      /// rendered in a single pass. RenderingSensor::RenderBatch is such a
+      /// function:
+      /// `mgr.SetRenderBatchCallback(&RenderingSensor::RenderBatch);`
+      /// Pass an empty function to render each sensor on its own, which is
+      /// the default.
+      /// \param[in] _callback Function rendering the sensors.
+      /// \sa Sensor::IsRenderingSensor
+      public: void SetRenderBatchCallback(RenderBatchCallback _callback);
+
+      /// \brief Set a queue to hand the due rendering sensors to, instead of
+      /// updating them in RunOnce. RunOnce then queues one task with the
+      /// due rendering sensors and returns without waiting for it. The
+      /// task calls the render batch callback, if any, and updates the
+      /// sensors once the render thread runs it. A sensor waiting for the
+      /// render thread is skipped until its task has run, so rendering
+      /// sensors fall behind their update rate, instead of delaying the
+      /// simulation, when the render thread can't keep up. Removing a
+      /// sensor that is being rendered waits for its task to finish.
+      /// Pass null to update rendering sensors in RunOnce again, which is
+      /// the default.
+      /// \param[in] _queue Queue drained by the render thread.
+      /// \sa SetRenderBatchCallback
+      public: void SetRenderQueue(std::shared_ptr<RenderTaskQueue> _queue);
+
+      /// \brief Get the queue the due rendering sensors are handed to.
+      /// \return The queue, null if rendering sensors are updated by
+      /// RunOnce.
+      /// \sa SetRenderQueue
+      public: std::shared_ptr<RenderTaskQueue> RenderQueue() const;
+
+      /// \brief Set whether triggered sensors, such as triggered cameras,
+      /// are rendered as soon as their trigger is received instead of on
+      /// the next RunOnce that finds them due. A triggered sensor is queued
+      /// on the render queue right away and updated for the time of the
+      /// last RunOnce. Sensors triggered before the render thread gets to
+      /// the queued task are rendered together, through the render batch
+      /// callback if there's one. Has no effect without a render queue.
+      /// Disabled by default.
+      /// \param[in] _immediate True to render triggered sensors right away.
+      /// \sa SetRenderQueue
+      public: void SetImmediateTrigger(bool _immediate);
+
+      /// \brief Get whether triggered sensors are rendered right away.
+      /// \return True if immediate triggers are enabled.
+      /// \sa SetImmediateTrigger
+      public: bool ImmediateTrigger() const;
+
+      /// \brief Seed the noise models of all sensors, including sensors
+      /// added later. Each sensor derives its own seeds from _seed and its
+      /// name, so a world seeded with the same value produces the same noise
+      /// on every run.
+      /// \param[in] _seed World seed.
+      /// \sa Sensor::SetNoiseSeed
+      public: void SetNoiseSeed(uint64_t _seed);
+
+      /// \brief Save the state of every sensor with Sensor::SaveState(),
+      /// e.g. at the start of an episode. The state of a sensor is cleared
+      /// first, so passing the same map again reuses its memory. Must not be
+      /// called during RunOnce() nor while rendering sensors are queued on a
+      /// render queue.
+      /// \param[in,out] _states State of each sensor, by id.
+      public: void SaveState(
+                  std::unordered_map<SensorId, SensorState> &_states) const;
+
+      /// \brief Restore the states saved by SaveState(), e.g. to reset an
+      /// episode. Sensors without a state are left alone. Must not be called
+      /// during RunOnce() nor while rendering sensors are queued on a render
+      /// queue.
+      /// \param[in,out] _states State of each sensor, by id. Read from the
+      /// start, whatever their read position.
+      /// \return False if a sensor was removed or failed to restore its
+      /// state.
+      public: bool RestoreState(
+                  std::unordered_map<SensorId, SensorState> &_states);
+
+      /// \brief Set whether sensors created by this manager hold back their
+      /// topic and service advertisements until AdvertisePending() is
+      /// called, so that a large world can load all of its sensors before
+      /// announcing their topics. Defaults to false.
+      /// \param[in] _deferred True to defer advertisements.
+      /// \sa Sensor::SetAdvertiseDeferred
+      public: void SetAdvertiseDeferred(bool _deferred);
+
+      /// \brief Get whether sensors created by this manager defer their
+      /// advertisements.
+      /// \return True if advertisements are deferred.
+      /// \sa SetAdvertiseDeferred
+      public: bool AdvertiseDeferred() const;
+
+      /// \brief Make the deferred advertisements of all sensors. Sensors
+      /// stop deferring advertisements afterwards, sensors created later
+      /// still defer them as long as AdvertiseDeferred() is true.
+      /// \return True if all topics and services were advertised.
+      /// \sa Sensor::AdvertisePending
+      public: bool AdvertisePending();
+
+      /// \brief Only run one shard of the sensors, so that the sensors of
+      /// a world are split between processes or hosts that load the same
+      /// world. A sensor belongs to the shard given by ShardOf for its
+      /// name. RunOnce leaves the sensors of other shards alone, they're
+      /// still loaded so their poses can be sent to the process running
+      /// them. Defaults to a single shard, which runs every sensor.
+      /// \param[in] _index Shard run by this manager.
+      /// \param[in] _count Number of shards.
+      /// \sa RemoteSensorCoordinator
+      public: void SetShard(unsigned int _index, unsigned int _count);
+
+      /// \brief Spread the sensors that have the same update rate over the
+      /// period of that rate, so they don't all update on the same step.
+      /// The first RunOnce after a sensor is added, or after this is
+      /// enabled, moves the next update of each sensor that hasn't been
+      /// staggered yet with Sensor::SetNextDataUpdateTime. Sensors added
+      /// together are evenly spaced, in id order, and later ones are put
+      /// in the middle of the largest gap of their rate. The first update
+      /// of a sensor may therefore be delayed by up to one period. Sensors
+      /// still stamp their data with the time of the step they update on.
+      /// Sensors with a zero rate, and those pinned with SetPhaseAligned,
+      /// keep their schedule. Disabled by default.
+      /// \param[in] _stagger True to stagger the sensors.
+      public: void SetPhaseStagger(bool _stagger);
+
+      /// \brief Get whether sensors of the same rate are spread over their
+      /// period.
+      /// \return True if phases are staggered.
+      /// \sa SetPhaseStagger
+      public: bool PhaseStagger() const;
+
+      /// \brief Pin a sensor to its own schedule when phases are staggered,
+      /// such as sensors that must update on the same step as others. A
+      /// sensor that is unpinned is staggered by the next RunOnce.
+      /// \param[in] _id Id of the sensor, which doesn't need to be added yet.
+      /// \param[in] _aligned True to keep the schedule of the sensor.
+      /// \sa SetPhaseStagger
+      public: void SetPhaseAligned(SensorId _id, bool _aligned);
+
+      /// \brief Get whether a sensor keeps its schedule when phases are
+      /// staggered.
+      /// \param[in] _id Id of the sensor.
+      /// \return True if the sensor is pinned.
+      /// \sa SetPhaseAligned
+      public: bool PhaseAligned(SensorId _id) const;
+
+      /// \brief Keep the sensors within a wall-clock budget by lowering
+      /// the rate of the sensors that have a minimum update rate. Once per
+      /// simulated second, RunOnce adds up the measured cost of each
+      /// sensor times its rate. Over budget, the sensors with the highest
+      /// load are lowered towards their minimum rate. Under 90% of the
+      /// budget, lowered sensors are raised back towards UpdateRate(),
+      /// cheapest first. Critical sensors, with no minimum rate, keep
+      /// their rate but count towards the budget. The rates reached are
+      /// reported by Sensor::EffectiveUpdateRate and the sim_update_rate
+      /// of the performance metrics.
+      /// \param[in] _budget Wall-clock seconds the sensor updates may take
+      /// per simulated second, e.g. 0.5 to leave half of real time to the
+      /// simulation. Zero, the default, disables the budget and restores
+      /// the rates of all sensors.
+      /// \sa Sensor::SetMinUpdateRate
+      public: void SetUpdateBudget(double _budget);
+
+      /// \brief Get the wall-clock budget of the sensor updates.
+      /// \return Seconds of updates per simulated second, 0 if disabled.
+      /// \sa SetUpdateBudget
+      public: double UpdateBudget() const;
+
+      /// \brief Record the phases of the sensor updates into a ring buffer
+      /// that can be written as Chrome trace JSON, for chrome://tracing or
+      /// Perfetto. Each sensor gets a track with its update, render,
+      /// readback, fill, noise and publish phases, and the manager one with
+      /// its steps and the scheduling of each step. The buffer is shared
+      /// by all the managers of the process. Disabled by default.
+      /// \param[in] _events Number of events kept, the oldest ones being
+      /// overwritten. Zero disables recording.
+      public: void SetTraceCapacity(std::size_t _events);
+
+      /// \brief Get the number of trace events kept.
+      /// \return Number of events, zero when tracing is disabled.
+      /// \sa SetTraceCapacity
+      public: std::size_t TraceCapacity() const;
+
+      /// \brief Write the recorded trace events as Chrome trace JSON.
+      /// \param[in] _path Path of the file, overwritten.
+      /// \return True if the file was written.
+      /// \sa SetTraceCapacity
+      public: bool DumpTrace(const std::string &_path) const;
+
+      /// \brief Write the trace to a file when a RunOnce call takes longer
+      /// than a wall-clock budget, to catch latency spikes when they
+      /// happen. The file is overwritten by each overrun, at most once per
+      /// second. Tracing must be enabled with SetTraceCapacity.
+      /// \param[in] _budget Wall-clock seconds a step may take, zero
+      /// disables the dump, which is the default.
+      /// \param[in] _path Path of the trace file.
+      public: void SetTraceOverrunDump(double _budget,
+                  const std::string &_path);
+
+      /// \brief Get the memory held by the buffers of the sensors of the
+      /// manager, to see which sensors hold what and plan capacity. Don't
+      /// call it while RunOnce is running.
+      /// \return Bytes held by each sensor, the sum of the entries of its
+      /// Sensor::MemoryUsage report, keyed by sensor ID.
+      public: std::map<SensorId, std::size_t> MemoryUsage() const;
+
+      /// \brief Get the total memory held by the buffers of the sensors of
+      /// the manager.
+      /// \return Bytes held by all the sensors.
+      /// \sa MemoryUsage
+      public: std::size_t TotalMemoryUsage() const;
+
+      /// \brief Function called with the diagnostics of a step that overran
+      /// its budget.
+      /// \sa SetStepOverrunCallback
+      public: using StepOverrunCallback =
+                  std::function<void(const ManagerStepOverrun &)>;
+
+      /// \brief Set a wall-clock budget for each RunOnce call. While it's
+      /// set, the manager measures every update of a step. When a step
+      /// takes longer, the slowest sensors are logged as a warning and
+      /// passed to the step overrun callback, at most once per second so
+      /// long runs aren't flooded. SetTraceOverrunDump captures a trace of
+      /// the same spikes.
+      /// \param[in] _budget Wall-clock seconds a step may take. Zero, the
+      /// default, disables the watchdog.
+      public: void SetStepBudget(double _budget);
+
+      /// \brief Get the wall-clock budget of a RunOnce call.
+      /// \return Seconds, 0 if the watchdog is disabled.
+      /// \sa SetStepBudget
+      public: double StepBudget() const;
+
+      /// \brief Set the function called with the diagnostics of the steps
+      /// that overran the step budget. It's called on the thread calling
+      /// RunOnce, at most once per second.
+      /// \param[in] _callback Function to call, empty to only log.
+      /// \sa SetStepBudget
+      public: void SetStepOverrunCallback(StepOverrunCallback _callback);
+
+      /// \brief Get the number of steps that overran the step budget,
+      /// including those that weren't reported.
+      /// \return Number of overruns since the budget was set.
+      /// \sa SetStepBudget
+      public: uint64_t StepOverrunCount() const;
+
+      /// \brief Get the shard run by this manager.
+      /// \return Shard index.
+      /// \sa SetShard
+      public: unsigned int ShardIndex() const;
+
+      /// \brief Get the number of shards the sensors are split into.
+      /// \return Number of shards, 1 if the sensors aren't split.
+      /// \sa SetShard
+      public: unsigned int ShardCount() const;
+
+      /// \brief Get the shard a sensor belongs to. It only depends on the
+      /// name of the sensor, so every process agrees on it.
+      /// \param[in] _sensorName Name of the sensor.
+      /// \param[in] _count Number of shards.
+      /// \return Shard index, 0 if _count is 0.
+      public: static unsigned int ShardOf(const std::string &_sensorName,
+                  unsigned int _count);
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief private data pointer
       private: std::unique_ptr<ManagerPrivate> dataPtr;
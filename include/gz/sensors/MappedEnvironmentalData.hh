@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_MAPPEDENVIRONMENTALDATA_HH_
+#define GZ_SENSORS_MAPPEDENVIRONMENTALDATA_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/EnvironmentalData.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class MappedEnvironmentalDataPrivate;
+
+    /// \brief How the values of an environmental grid file are stored.
+    enum class EnvironmentalGridValueType : uint32_t
+    {
+      /// \brief 64 bit floating point values.
+      FLOAT64 = 0,
+
+      /// \brief 32 bit floating point values, half the size of FLOAT64
+      /// with about 7 significant digits.
+      FLOAT32 = 1,
+
+      /// \brief 16 bit integers q, a quarter of the size of FLOAT64,
+      /// standing for offset + scale * q with the scale and offset of the
+      /// column. -32768 stands for NaN.
+      INT16 = 2
+    };
+
+    /// \brief Header at the start of an environmental grid file.
+    ///
+    /// The header is followed by the column names, each one terminated by
+    /// a null character, starting at namesOffset. The grid axes follow at
+    /// axesOffset, as doubles: xCount x coordinates, yCount y coordinates,
+    /// zCount z coordinates and timeCount times in seconds, all increasing.
+    /// The scale and offset of each column follow at scalesOffset, as
+    /// pairs of doubles. The values start at dataOffset, stored as
+    /// valueType, one time slice after the other. A time slice holds the
+    /// columns in order, and a column its values with x varying fastest,
+    /// then y, then z. All offsets are from the start of the file and
+    /// multiples of 8, values are in host byte order.
+    struct EnvironmentalGridHeader
+    {
+      /// \brief Value of magic for a valid file, "GZENVG01".
+      static constexpr uint64_t kMagic = 0x313047564e455a47u;
+
+      /// \brief Version of the layout.
+      static constexpr uint32_t kVersion = 2u;
+
+      /// \brief kMagic.
+      uint64_t magic;
+
+      /// \brief kVersion.
+      uint32_t version;
+
+      /// \brief Number of columns.
+      uint32_t columnCount;
+
+      /// \brief Number of x coordinates.
+      uint32_t xCount;
+
+      /// \brief Number of y coordinates.
+      uint32_t yCount;
+
+      /// \brief Number of z coordinates.
+      uint32_t zCount;
+
+      /// \brief Number of time slices.
+      uint32_t timeCount;
+
+      /// \brief Offset of the column names.
+      uint64_t namesOffset;
+
+      /// \brief Number of bytes of column names, including terminators.
+      uint64_t namesSize;
+
+      /// \brief Offset of the axes.
+      uint64_t axesOffset;
+
+      /// \brief Offset of the values.
+      uint64_t dataOffset;
+
+      /// \brief Offset of the column scales and offsets.
+      uint64_t scalesOffset;
+
+      /// \brief How the values are stored, an EnvironmentalGridValueType.
+      uint32_t valueType;
+
+      /// \brief Unused, zero.
+      uint32_t reserved;
+    };
+
+    /// \brief Environmental data backed by a memory mapped grid file laid
+    /// out as described by EnvironmentalGridHeader.
+    ///
+    /// Only the two time slices around the current time are loaded into
+    /// an in memory EnvironmentalData, and the pages of the slices left
+    /// behind are released, so opening a file and its resident memory
+    /// don't depend on the duration of the dataset. Every time StepTo()
+    /// moves to other slices, Data() is replaced, and it has to be given
+    /// to the sensors again, e.g. with
+    /// DopplerVelocityLog::SetEnvironmentalData. Sensors refer to the data
+    /// they were given, so it must be kept alive until then. Only
+    /// available on POSIX platforms.
+    class GZ_SENSORS_VISIBLE MappedEnvironmentalData
+    {
+      /// \brief Constructor
+      public: MappedEnvironmentalData();
+
+      /// \brief Destructor. Closes the file.
+      public: ~MappedEnvironmentalData();
+
+      /// \brief Open a grid file and load its first time slices.
+      /// \param[in] _path Path of the file.
+      /// \param[in] _reference Spatial reference of the grid coordinates.
+      /// \param[in] _units Units, only for spherical coordinates.
+      /// \return True if the file was opened.
+      public: bool Open(const std::string &_path,
+                  EnvironmentalData::ReferenceT _reference,
+                  EnvironmentalData::ReferenceUnits _units =
+                      EnvironmentalData::ReferenceUnits::RADIANS);
+
+      /// \brief Close the file and release the loaded data.
+      public: void Close();
+
+      /// \brief Check if a file is open.
+      /// \return True if a file is open.
+      public: bool IsOpen() const;
+
+      /// \brief Get the names of the columns.
+      /// \return Column names, empty if no file is open.
+      public: const std::vector<std::string> &Columns() const;
+
+      /// \brief Get the number of time slices in the file.
+      /// \return Number of time slices.
+      public: std::size_t TimeCount() const;
+
+      /// \brief Get how the values of the file are stored.
+      /// \return Value type, FLOAT64 if no file is open.
+      public: EnvironmentalGridValueType ValueType() const;
+
+      /// \brief Get the index of the first loaded time slice.
+      /// \return Index of the first of, at most, two loaded slices.
+      public: std::size_t FirstLoadedSlice() const;
+
+      /// \brief Load the time slices around a time, if they're not loaded
+      /// yet. Times before the first slice or after the last one load the
+      /// first or last two slices.
+      /// \param[in] _now Current time.
+      /// \return True if other slices were loaded and Data() changed.
+      public: bool StepTo(const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Get the loaded data.
+      /// \return Data of the loaded time slices, null if no file is open.
+      public: std::shared_ptr<EnvironmentalData> Data() const;
+
+      /// \brief Write a grid file.
+      /// \param[in] _path Path of the file, replaced if it exists.
+      /// \param[in] _columns Names of the columns.
+      /// \param[in] _x X coordinates, increasing.
+      /// \param[in] _y Y coordinates, increasing.
+      /// \param[in] _z Z coordinates, increasing.
+      /// \param[in] _times Times of the slices in seconds, increasing.
+      /// \param[in] _values Values in the order of the file, see
+      /// EnvironmentalGridHeader.
+      /// \param[in] _type How to store the values. INT16 spreads the
+      /// range of each column over the integers, so the error is at most
+      /// half the range divided by 65534.
+      /// \return True if the file was written.
+      public: static bool Write(const std::string &_path,
+                  const std::vector<std::string> &_columns,
+                  const std::vector<double> &_x,
+                  const std::vector<double> &_y,
+                  const std::vector<double> &_z,
+                  const std::vector<double> &_times,
+                  const std::vector<double> &_values,
+                  EnvironmentalGridValueType _type =
+                      EnvironmentalGridValueType::FLOAT64);
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<MappedEnvironmentalDataPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
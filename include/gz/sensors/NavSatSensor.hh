@@ -19,6 +19,7 @@
 
 #include <memory>
 
+#include <gz/math/SphericalCoordinates.hh>
 #include <gz/utils/SuppressWarning.hh>
 #include <sdf/Sensor.hh>
 
@@ -119,6 +120,46 @@ namespace gz
       public: void SetPosition(const math::Angle &_latitude,
           const math::Angle &_longitude, double _altitude = 0.0);
 
+      /// \brief Set the spherical coordinates of the world origin, used to
+      /// convert positions and velocities set with SetWorldPosition() and
+      /// SetWorldVelocity().
+      /// \param[in] _origin Spherical coordinates of the world.
+      public: void SetSphericalCoordinates(
+          const math::SphericalCoordinates &_origin);
+
+      /// \brief Get the spherical coordinates of the world origin.
+      /// \return Spherical coordinates of the world.
+      public: const math::SphericalCoordinates &SphericalCoordinates() const;
+
+      /// \brief Set the position of the sensor from its position in the
+      /// world frame. The latitude, longitude and altitude are computed with
+      /// the spherical coordinates of the world. See
+      /// SetLinearizationDistance() to make this cheaper.
+      /// \param[in] _pos Position in the world frame, in meters.
+      public: void SetWorldPosition(const math::Vector3d &_pos);
+
+      /// \brief Set the velocity of the sensor from its velocity in the
+      /// world frame, rotated to ENU with the heading of the spherical
+      /// coordinates of the world.
+      /// \param[in] _vel Velocity in the world frame, in meters per second.
+      public: void SetWorldVelocity(const math::Vector3d &_vel);
+
+      /// \brief Set how far from the last exactly converted position
+      /// SetWorldPosition() may use a linearization of the earth model.
+      /// Within this distance, a position is converted with a few multiply
+      /// adds, otherwise it's converted exactly and becomes the new
+      /// linearization point. The error grows with the square of the
+      /// distance, it's a few millimeters at 100 meters away from the
+      /// poles. Zero, the default, converts every position exactly.
+      /// \param[in] _distance Distance in meters.
+      public: void SetLinearizationDistance(double _distance);
+
+      /// \brief Get how far from the linearization point positions are
+      /// linearized.
+      /// \return Distance in meters.
+      /// \sa SetLinearizationDistance
+      public: double LinearizationDistance() const;
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief Data pointer for private data
       /// \internal
@@ -18,7 +18,10 @@
 #ifndef GZ_SENSORS_NOISE_HH_
 #define GZ_SENSORS_NOISE_HH_
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -36,6 +39,7 @@ namespace gz
     inline namespace GZ_SENSORS_VERSION_NAMESPACE {
     // Forward declarations
     class NoisePrivate;
+    class SensorState;
 
     /// \class NoiseFactory Noise.hh gz/sensors/Noise.hh
     /// \brief Use this noise manager for creating and loading noise models.
@@ -52,7 +56,9 @@ namespace gz
           const std::string &_sensorType = "");
 
       /// \brief Load a noise model based on the input sdf parameters and
-      /// sensor type.
+      /// sensor type. Noise models that SDFormat doesn't describe are
+      /// selected with a `gz:type` attribute on a `gaussian` noise element,
+      /// one of `gauss_markov`, `flicker` or `dithered_quantization`.
       /// \param[in] _sdf Noise sdf parameters.
       /// \param[in] _sensorType Type of sensor. This is currently used to
       /// distinguish between image and non image sensors in order to create
@@ -67,7 +73,10 @@ namespace gz
     {
       NONE = 0,
       CUSTOM = 1,
-      GAUSSIAN = 2
+      GAUSSIAN = 2,
+      GAUSS_MARKOV = 3,
+      FLICKER = 4,
+      DITHERED_QUANTIZATION = 5
     };
 
     /// \class Noise Noise.hh gz/sensors/Noise.hh
@@ -101,6 +110,66 @@ namespace gz
       /// \return Data with noise applied.
       public: virtual double ApplyImpl(double _in, double _dt);
 
+      /// \brief Apply noise to a buffer of values in place. Values that are
+      /// finite after noise is applied are then clamped to [_min, _max].
+      /// Time dependent noise state, such as a dynamic bias, is advanced once
+      /// by _dt for the whole buffer.
+      /// \param[in,out] _data First value.
+      /// \param[in] _count Number of values.
+      /// \param[in] _stride Distance between consecutive values, in
+      /// elements.
+      /// \param[in] _dt Input data time step.
+      /// \param[in] _min Lower clamping bound.
+      /// \param[in] _max Upper clamping bound.
+      public: void ApplyBatch(double *_data, std::size_t _count,
+                  std::size_t _stride = 1u, double _dt = 0.0,
+                  double _min = -std::numeric_limits<double>::infinity(),
+                  double _max = std::numeric_limits<double>::infinity());
+
+      /// \copydoc ApplyBatch(double *, std::size_t, std::size_t, double,
+      /// double, double)
+      public: void ApplyBatch(float *_data, std::size_t _count,
+                  std::size_t _stride = 1u, double _dt = 0.0,
+                  double _min = -std::numeric_limits<double>::infinity(),
+                  double _max = std::numeric_limits<double>::infinity());
+
+      /// \brief Apply noise to a buffer of values in place. This gets
+      /// overriden by derived classes, and called by ApplyBatch. The default
+      /// implementation calls ApplyImpl for each value.
+      /// \param[in,out] _data First value.
+      /// \param[in] _count Number of values.
+      /// \param[in] _stride Distance between consecutive values, in
+      /// elements.
+      /// \param[in] _dt Input data time step.
+      /// \param[in] _min Lower clamping bound.
+      /// \param[in] _max Upper clamping bound.
+      public: virtual void ApplyBatchImpl(double *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min, double _max);
+
+      /// \copydoc ApplyBatchImpl(double *, std::size_t, std::size_t, double,
+      /// double, double)
+      public: virtual void ApplyBatchImpl(float *_data, std::size_t _count,
+                  std::size_t _stride, double _dt, double _min, double _max);
+
+      /// \brief Seed the random numbers of this noise model. Noise models
+      /// that don't draw random numbers ignore it.
+      /// \param[in] _seed Seed.
+      public: virtual void SetSeed(uint64_t _seed);
+
+      /// \brief Append the state that evolves as noise is applied, such as
+      /// the random stream and the bias, to _state. Parameters loaded from
+      /// SDF aren't saved. Models that draw from the global math::Rand
+      /// generator, because they weren't seeded, can't save its state. The
+      /// default implementation saves nothing.
+      /// \param[in,out] _state State to append to.
+      public: virtual void SaveState(SensorState &_state) const;
+
+      /// \brief Restore the state saved by SaveState(), read from the read
+      /// position of _state.
+      /// \param[in,out] _state State to read from.
+      /// \return False if _state is too short.
+      public: virtual bool RestoreState(SensorState &_state);
+
       /// \brief Accessor for NoiseType.
       /// \return Type of noise currently in use.
       public: NoiseType Type() const;
@@ -116,6 +185,13 @@ namespace gz
       /// \param[in] _out Output stream
       public: virtual void Print(std::ostream &_out) const;
 
+      /// \brief Shared implementation of the ApplyBatch overloads.
+      /// \tparam T Value type.
+      private: template <typename T>
+               void ApplyBatchTemplate(T *_data, std::size_t _count,
+                   std::size_t _stride, double _dt, double _min,
+                   double _max);
+
       /// \brief Private data pointer
       private: NoisePrivate *dataPtr = nullptr;
     };
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_RAWPAYLOAD_HH_
+#define GZ_SENSORS_RAWPAYLOAD_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <gz/sensors/config.hh>
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Layout of the raw payload messages published by sensors with
+    /// raw payload output enabled, on the topic of a publisher followed by
+    /// "/raw".
+    /// \sa Sensor::SetRawPayloadOutput
+    ///
+    /// A raw payload message is published with gz-transport's raw API, as
+    /// the message type RawPayloadType() of the protobuf type. It starts
+    /// with a RawPayloadHeader, followed by the protobuf message without
+    /// its payload, such as a msgs::Image without its data, and ends with
+    /// the payload at RawPayloadHeader::payloadOffset. Offsets are relative
+    /// to the start of the message and the payload offset is a multiple of
+    /// RawPayloadHeader::kAlignment, so a subscriber of the raw topic can
+    /// read the pixels or points in place instead of parsing them out of
+    /// the protobuf message. Integers are in host byte order.
+    struct alignas(64) RawPayloadHeader
+    {
+      /// \brief Value of magic for a valid message.
+      static constexpr uint32_t kMagic = 0x475a5250u;
+
+      /// \brief Version of the layout.
+      static constexpr uint32_t kVersion = 1u;
+
+      /// \brief Alignment of the payload offset.
+      static constexpr std::size_t kAlignment = 64u;
+
+      /// \brief kMagic.
+      uint32_t magic;
+
+      /// \brief Layout version, kVersion.
+      uint32_t version;
+
+      /// \brief Size of the protobuf message following this header.
+      uint32_t messageSize;
+
+      /// \brief Unused, zero.
+      uint32_t reserved;
+
+      /// \brief Offset of the payload.
+      uint64_t payloadOffset;
+
+      /// \brief Number of payload bytes.
+      uint64_t payloadSize;
+    };
+
+    /// \brief Parts of a raw payload message, pointing into its bytes.
+    struct RawPayloadView
+    {
+      /// \brief Serialized protobuf message without its payload.
+      const char *message{nullptr};
+
+      /// \brief Size of the protobuf message.
+      std::size_t messageSize{0u};
+
+      /// \brief Payload.
+      const char *payload{nullptr};
+
+      /// \brief Size of the payload.
+      std::size_t payloadSize{0u};
+    };
+
+    /// \brief Get the gz-transport message type of the raw payload
+    /// messages of a protobuf type.
+    /// \param[in] _type Full name of the protobuf type, such as
+    /// "gz.msgs.Image".
+    /// \return The raw message type.
+    inline std::string RawPayloadType(const std::string &_type)
+    {
+      return "gz.sensors.raw." + _type;
+    }
+
+    /// \brief Find the parts of a raw payload message, without copying.
+    /// \param[in] _data Bytes of the message, such as the data given to a
+    /// raw gz-transport subscriber.
+    /// \param[in] _size Number of bytes.
+    /// \param[out] _view Parts of the message.
+    /// \return False if the bytes aren't a raw payload message.
+    inline bool ParseRawPayload(const char *_data, std::size_t _size,
+        RawPayloadView &_view)
+    {
+      RawPayloadHeader header;
+      if (!_data || _size < sizeof(header))
+        return false;
+      std::memcpy(&header, _data, sizeof(header));
+      if (header.magic != RawPayloadHeader::kMagic ||
+          header.version != RawPayloadHeader::kVersion ||
+          header.messageSize > _size - sizeof(header) ||
+          header.payloadOffset < sizeof(header) + header.messageSize ||
+          header.payloadOffset > _size ||
+          header.payloadSize > _size - header.payloadOffset)
+      {
+        return false;
+      }
+      _view.message = _data + sizeof(header);
+      _view.messageSize = header.messageSize;
+      _view.payload = _data + header.payloadOffset;
+      _view.payloadSize = static_cast<std::size_t>(header.payloadSize);
+      return true;
+    }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_REMOTESENSORS_HH_
+#define GZ_SENSORS_REMOTESENSORS_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // forward declarations
+    class Manager;
+    class RemoteSensorCoordinatorPrivate;
+    class RemoteSensorWorkerPrivate;
+
+    /// \brief Runs the sensors of a world in several processes, possibly
+    /// on other hosts. Every process loads the same sensors into a Manager
+    /// and runs one shard of them, see Manager::SetShard. The coordinator,
+    /// in the simulation process, runs shard 0. Each step it sends the
+    /// time and the poses of the other shards' sensors on <_topic>/step,
+    /// runs its own shard, and waits until every worker reports the step
+    /// done on <_topic>/done. The workers publish their sensors' data on
+    /// the usual topics, so subscribers don't need to know where a sensor
+    /// runs.
+    class GZ_SENSORS_VISIBLE RemoteSensorCoordinator
+    {
+      /// \brief Constructor. Sets the shard of the manager.
+      /// \param[in] _manager Manager with the sensors of the world. It must
+      /// outlive the coordinator.
+      /// \param[in] _topic Prefix of the step topics.
+      /// \param[in] _shardCount Number of shards, including the one run by
+      /// the coordinator.
+      public: RemoteSensorCoordinator(Manager &_manager,
+                  const std::string &_topic, unsigned int _shardCount);
+
+      /// \brief Destructor
+      public: ~RemoteSensorCoordinator();
+
+      /// \brief Run a step on every shard. Remote sensors get the poses
+      /// their sensors have in the manager, so set the poses first. The
+      /// step is done once every worker updated its sensors for _time.
+      /// A step that times out can be sent again with the same time.
+      /// \param[in] _time The current simulated time
+      /// \param[in] _timeout Maximum time to wait for the workers.
+      /// \return True if every shard finished the step in time.
+      public: bool Step(const std::chrono::steady_clock::duration &_time,
+                  const std::chrono::steady_clock::duration &_timeout);
+
+      /// \brief Get the number of shards.
+      /// \return Number of shards, including the coordinator's.
+      public: unsigned int ShardCount() const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<RemoteSensorCoordinatorPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+
+    /// \brief Runs one shard of the sensors of a world for a
+    /// RemoteSensorCoordinator. For every step it receives, the worker
+    /// sets the poses of its sensors, calls Manager::RunOnce and reports
+    /// the step done. The steps run on a transport thread.
+    class GZ_SENSORS_VISIBLE RemoteSensorWorker
+    {
+      /// \brief Constructor. Sets the shard of the manager.
+      /// \param[in] _manager Manager with the sensors of the world. It must
+      /// outlive the worker and may not be used while the worker exists.
+      /// \param[in] _topic Prefix of the step topics of the coordinator.
+      /// \param[in] _shard Shard run by this worker, from 1.
+      /// \param[in] _shardCount Number of shards.
+      public: RemoteSensorWorker(Manager &_manager,
+                  const std::string &_topic, unsigned int _shard,
+                  unsigned int _shardCount);
+
+      /// \brief Destructor
+      public: ~RemoteSensorWorker();
+
+      /// \brief Get the number of steps run.
+      /// \return Number of steps.
+      public: uint64_t StepCount() const;
+
+      /// \brief Get the time of the last step run.
+      /// \return Time of the last step, 0 if none ran.
+      public: std::chrono::steady_clock::duration LastStepTime() const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<RemoteSensorWorkerPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
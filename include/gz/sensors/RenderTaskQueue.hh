@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_RENDERTASKQUEUE_HH_
+#define GZ_SENSORS_RENDERTASKQUEUE_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class RenderTaskQueuePrivate;
+
+    /// \brief Queue of work that must run on the thread owning the render
+    /// engine. Any thread can push tasks, and the render thread runs them
+    /// in order, either from its own loop with RunNext() or once per
+    /// frame with RunPending(). Given to Manager::SetRenderQueue, it
+    /// lets the simulation thread carry on while rendering sensors render,
+    /// read back and publish their frames on the render thread.
+    class GZ_SENSORS_VISIBLE RenderTaskQueue
+    {
+      /// \brief A unit of render thread work.
+      public: using Task = std::function<void()>;
+
+      /// \brief Constructor
+      public: RenderTaskQueue();
+
+      /// \brief Destructor. Tasks still queued are discarded.
+      public: ~RenderTaskQueue();
+
+      /// \brief Queue a task. Thread safe.
+      /// \param[in] _task Task to run on the render thread.
+      public: void Push(Task _task);
+
+      /// \brief Run the tasks queued so far, in order. Tasks they queue
+      /// run on the next call.
+      /// \return Number of tasks run.
+      public: std::size_t RunPending();
+
+      /// \brief Run the next task, waiting for one to be queued.
+      /// \param[in] _timeout Maximum time to wait for a task.
+      /// \return True if a task was run, false if the wait timed out.
+      public: bool RunNext(const std::chrono::steady_clock::duration &_timeout);
+
+      /// \brief Get the number of queued tasks.
+      /// \return Number of tasks waiting to run.
+      public: std::size_t Size() const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<RenderTaskQueuePrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
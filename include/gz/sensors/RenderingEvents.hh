@@ -18,6 +18,9 @@
 #ifndef GZ_SENSORS_RENDERINGEVENTS_HH_
 #define GZ_SENSORS_RENDERINGEVENTS_HH_
 
+#include <cstdint>
+#include <functional>
+
 #include <gz/common/Event.hh>
 #include <gz/utils/SuppressWarning.hh>
 
@@ -55,6 +58,56 @@ namespace gz
                   std::function<void(const gz::rendering::ScenePtr &)>
                   _callback);
 
+      /// \brief Set a callback to be called once per FlushSceneChanges()
+      /// if the scene changed since the previous flush. However many times
+      /// the scene changed in between, for example while a world reloads,
+      /// the callback is only called with the latest scene.
+      ///
+      /// \param[in] _callback  This callback will be called with the latest
+      /// scene, null if it was destroyed since.
+      /// \remark Do not block inside of the callback.
+      /// \return A connection pointer that must remain in scope. When the
+      /// connection pointer falls out of scope, the connection is broken.
+      /// \sa FlushSceneChanges
+      public: static gz::common::ConnectionPtr
+                  ConnectCoalescedSceneChangeCallback(
+                  std::function<void(const gz::rendering::ScenePtr &)>
+                  _callback);
+
+      /// \brief Call the coalesced scene change callbacks if the scene
+      /// changed since the previous call. Meant to be called once per
+      /// simulation step, from the thread that renders.
+      /// \return True if the scene changed and the callbacks were called.
+      /// \sa ConnectCoalescedSceneChangeCallback
+      public: static bool FlushSceneChanges();
+
+      /// \brief Get the number of times sceneEvent was signaled. It's cheap
+      /// to read, so sensors can compare it with the value they last saw
+      /// to find out whether the scene changed. Thread safe.
+      /// \return Scene generation, 0 before the first scene change.
+      public: static uint64_t SceneGeneration();
+
+      /// \brief Signal that the content of the scene changed, for example
+      /// that a visual moved or a material changed. Meant to be called by
+      /// the application updating the scene, once per step in which
+      /// something changed. Thread safe.
+      /// \sa SceneContentGeneration
+      public: static void NotifySceneContentChanged();
+
+      /// \brief Get the number of content changes, counting the calls to
+      /// NotifySceneContentChanged() and the scene changes. Sensors that
+      /// reuse frames compare it with the value of their last render.
+      /// Thread safe.
+      /// \return Content generation, 0 before the first change.
+      /// \sa RenderingSensor::SetFrameReuse
+      public: static uint64_t SceneContentGeneration();
+
+      /// \brief Get the scene passed to the latest scene change. Thread
+      /// safe.
+      /// \return The latest scene, null if there was no scene change or
+      /// the scene was destroyed since.
+      public: static gz::rendering::ScenePtr LatestScene();
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief Event that is used to trigger callbacks when the scene
       /// is changed
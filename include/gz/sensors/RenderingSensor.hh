@@ -17,7 +17,23 @@
 #ifndef GZ_SENSORS_RENDERINGSENSOR_HH_
 #define GZ_SENSORS_RENDERINGSENSOR_HH_
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4005)
+#pragma warning(disable: 4251)
+#endif
+#include <gz/msgs/image.pb.h>
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
 
 #include <gz/utils/SuppressWarning.hh>
 
@@ -81,11 +97,265 @@ namespace gz
       /// \sa SetManualSceneUpdate
       public: bool ManualSceneUpdate() const;
 
+      /// \brief Set whether frames are read back one update late. When
+      /// enabled, an update first reads back the frame rendered by the
+      /// previous update, which the GPU has had a whole update period to
+      /// finish, and then issues the rendering of the new frame without
+      /// waiting for it. This trades one update of latency for not stalling
+      /// the CPU on the GPU. Published data is stamped with the time of the
+      /// frame it was rendered for. Disabled by default.
+      /// \param[in] _async True to enable asynchronous readback.
+      public: void SetAsyncReadback(bool _async);
+
+      /// \brief Get whether frames are read back one update late.
+      /// \return True if asynchronous readback is enabled.
+      /// \sa SetAsyncReadback
+      public: bool AsyncReadback() const;
+
+      /// \brief Set whether frames are used in place. When enabled, the
+      /// frame callbacks of the depth, thermal, segmentation and wide angle
+      /// camera sensors keep a pointer to the frame buffer of the rendering
+      /// camera instead of copying it, and the messages are filled straight
+      /// from that buffer. This requires the rendering engine to keep the
+      /// buffer unchanged until the camera reads the next frame back, which
+      /// gz-rendering's ogre2 cameras do. Disabled by default.
+      /// \param[in] _enabled True to use frames in place.
+      public: void SetZeroCopyFrames(bool _enabled);
+
+      /// \brief Get whether frames are used in place.
+      /// \return True if frames aren't copied out of the rendering cameras.
+      /// \sa SetZeroCopyFrames
+      public: bool ZeroCopyFrames() const;
+
+      /// \brief Set whether the last frame is republished instead of
+      /// rendered when nothing changed. A frame is reused while the pose
+      /// of the sensor and RenderingEvents::SceneContentGeneration() stay
+      /// the same, so the application must call
+      /// RenderingEvents::NotifySceneContentChanged() whenever it changes
+      /// the scene. Reused frames get the stamp of the update. Sensors with
+      /// noise rendered on the GPU keep rendering every frame, and frames
+      /// aren't reused in asynchronous readback mode. Supported by the
+      /// camera, depth camera, thermal camera and GPU lidar sensors.
+      /// Disabled by default.
+      /// \param[in] _enabled True to reuse unchanged frames.
+      public: void SetFrameReuse(bool _enabled);
+
+      /// \brief Get whether unchanged frames are reused.
+      /// \return True if frame reuse is enabled.
+      /// \sa SetFrameReuse
+      public: bool FrameReuse() const;
+
+      /// \brief Get the number of updates that reused the last frame.
+      /// \return Number of reused frames.
+      /// \sa SetFrameReuse
+      public: uint64_t ReusedFrameCount() const;
+
+      /// \brief Set whether image frames are written into shared memory for
+      /// consumers running on the same host. Each image stream of the
+      /// sensor gets a segment named after its topic, laid out as described
+      /// by SharedMemoryImageHeader, and a descriptor topic, the image
+      /// topic followed by "/shm". For each frame, a msgs::Image without
+      /// pixels is published on the descriptor topic. Its header carries
+      /// the "shm_name", "shm_slot" and "shm_sequence" of the frame.
+      /// Frames are still published on the image topics while they have
+      /// subscribers. Only available on POSIX platforms. Disabled by
+      /// default.
+      /// \param[in] _enabled True to enable shared memory output.
+      /// \param[in] _slotCount Number of frames kept in each segment.
+      public: void SetSharedMemoryOutput(bool _enabled,
+                  unsigned int _slotCount = 4u);
+
+      /// \brief Get whether image frames are written into shared memory.
+      /// \return True if shared memory output is enabled.
+      /// \sa SetSharedMemoryOutput
+      public: bool SharedMemoryOutput() const;
+
+      /// \brief Record the raw frames of the sensor into a single file
+      /// laid out as described by FrameRecordHeader, which can be replayed
+      /// with FrameRecordReader without decoding. Frames are recorded on
+      /// every update, whether or not the sensor has subscribers. Only
+      /// available on POSIX platforms.
+      /// \param[in] _path Path of the recording, replaced if it exists.
+      /// An empty path stops recording and closes the file.
+      /// \param[in] _maxFrames Maximum number of frames recorded.
+      /// \return True if recording started, or stopped for an empty path.
+      public: bool SetRecording(const std::string &_path,
+                  uint64_t _maxFrames = 100000u);
+
+      /// \brief Get whether frames are being recorded.
+      /// \return True if a recording is open.
+      /// \sa SetRecording
+      public: bool Recording() const;
+
+      /// \brief Set the number of threads used to generate point clouds,
+      /// for sensors which publish them. The rows of a cloud are split
+      /// between the thread updating the sensor and worker threads owned by
+      /// the sensor. The clouds are identical to the ones generated on a
+      /// single thread.
+      /// \param[in] _count Number of threads. Zero and one generate clouds
+      /// on the updating thread, which is the default.
+      public: void SetPointCloudThreadCount(unsigned int _count);
+
+      /// \brief Get the number of threads used to generate point clouds.
+      /// \return Number of threads, at least one.
+      /// \sa SetPointCloudThreadCount
+      public: unsigned int PointCloudThreadCount() const;
+
+      /// \brief Set the number of threads used to apply image noise on the
+      /// CPU, for sensors whose render engine has no noise pass. The values
+      /// of a frame are split between the thread updating the sensor and
+      /// worker threads owned by the noise model. The noise is identical to
+      /// the one applied on a single thread.
+      /// \param[in] _count Number of threads. Zero and one apply the noise
+      /// on the updating thread, which is the default.
+      /// \sa ImageGaussianNoiseModel::AppliesOnCpu
+      public: void SetImageNoiseThreadCount(unsigned int _count);
+
+      /// \brief Get the number of threads used to apply image noise on the
+      /// CPU.
+      /// \return Number of threads, at least one.
+      /// \sa SetImageNoiseThreadCount
+      public: unsigned int ImageNoiseThreadCount() const;
+
+      /// \brief Set the resolution of point cloud coordinates, for sensors
+      /// which publish point clouds. With a positive resolution, the x, y
+      /// and z fields are declared as INT16 and hold the coordinate divided
+      /// by the resolution, clamped to +/-32767, or -32768 for points
+      /// without a finite coordinate. The resolution is published under the
+      /// "xyz_resolution" key of the cloud header, the fields are tightly
+      /// packed and lidar intensities are published as UINT8, rounded and
+      /// clamped to [0, 255]. This shrinks a lidar point from 32 to 9 bytes
+      /// and a camera point from 16 to 10 bytes. Zero, the default,
+      /// publishes FLOAT32 fields.
+      /// \param[in] _resolution Resolution in meters, for example 0.005
+      /// for +/-163 m in steps of 5 mm.
+      public: void SetPointCloudResolution(double _resolution);
+
+      /// \brief Get the resolution of point cloud coordinates.
+      /// \return Resolution in meters, zero for FLOAT32 coordinates.
+      /// \sa SetPointCloudResolution
+      public: double PointCloudResolution() const;
+
+      /// \brief Set the side of the voxel grid applied to point clouds, for
+      /// sensors which publish them. With a positive size, the organized
+      /// cloud is replaced by an unorganized one, a single row holding the
+      /// first point of each occupied voxel with all its fields. Points
+      /// without finite coordinates are dropped and the cloud is marked
+      /// dense. Zero, the default, publishes the organized clouds.
+      /// \param[in] _size Side of the voxels in meters.
+      public: void SetPointCloudVoxelSize(double _size);
+
+      /// \brief Get the side of the voxel grid applied to point clouds.
+      /// \return Side in meters, zero if clouds aren't filtered.
+      /// \sa SetPointCloudVoxelSize
+      public: double PointCloudVoxelSize() const;
+
+      /// \brief Render several rendering sensors in a single pass. Each
+      /// scene is updated once, the cameras of all the sensors are rendered
+      /// and the GPU is flushed once. The frames are read back by the next
+      /// update of each sensor, which must be made for _now, so that the
+      /// readbacks of all the sensors happen after all the cameras have been
+      /// submitted. The scene update is skipped if every sensor of the scene
+      /// has a manual scene update. Sensors that aren't rendering sensors,
+      /// have no connections, have no scene or read back asynchronously are
+      /// left out and render on their own during their update. So are
+      /// sensors that reuse their last frame, see SetFrameReuse.
+      /// \param[in] _sensors Sensors about to be updated.
+      /// \param[in] _now Time of the update.
+      /// \sa Manager::SetRenderBatchCallback
+      public: static void RenderBatch(const std::vector<Sensor *> &_sensors,
+                  const std::chrono::steady_clock::duration &_now);
+
+      // Documentation inherited
+      public: bool IsRenderingSensor() const override;
+
+      /// \brief Get the number of pixels rendered by an update, summed
+      /// over the sensor's rendering cameras.
+      /// \return Number of pixels, 0 if the cameras aren't created yet.
+      /// \sa ScenePlacement::DefaultCost
+      public: uint64_t PixelCount() const;
+
+      /// \brief Render a frame and read back the data of a frame, taking
+      /// AsyncReadback() into account. Data delivered through the rendering
+      /// sensors' frame callbacks, and data copied by _readback, belong to
+      /// the frame stamped _frameTime.
+      /// \param[in] _now Time of the frame to render.
+      /// \param[out] _frameTime Time of the frame that was read back. This is
+      /// _now unless asynchronous readback is enabled, in which case it is
+      /// the time of the previous frame.
+      /// \param[in] _readback Function that copies data out of the rendering
+      /// sensors. It is called once the frame stamped _frameTime is complete
+      /// and before a new frame is rendered.
+      /// \return True if a frame was read back, false for the first update
+      /// in asynchronous mode.
+      protected: bool Render(const std::chrono::steady_clock::duration &_now,
+                     std::chrono::steady_clock::duration &_frameTime,
+                     const std::function<void()> &_readback = {});
+
+      /// \brief Get whether shared memory frames may have consumers. This is
+      /// true if shared memory output is enabled and a descriptor topic has
+      /// subscribers, or no frame was written yet.
+      /// \return True if frames should be written to shared memory.
+      protected: bool HasSharedMemoryConnections() const;
+
+      /// \brief Check whether the last rendered frame can be published
+      /// again, see SetFrameReuse. If it can't, the caller is expected to
+      /// render: the current pose and content generation are recorded as
+      /// those of the next frame.
+      /// \return True if the frame is reused and rendering can be skipped.
+      protected: bool ReuseFrame();
+
+      /// \brief Forget the last rendered frame, so that the next update
+      /// renders. To be called when something that isn't tracked by
+      /// ReuseFrame() changed, like the resolution or the camera
+      /// parameters.
+      protected: void InvalidateFrame();
+
+      /// \brief Write a frame of an image stream to shared memory and
+      /// publish its descriptor. Does nothing unless shared memory output
+      /// is enabled.
+      /// \param[in] _topic Image topic of the stream.
+      /// \param[in] _image Width, height, step, pixel format and header of
+      /// the frame. Its data field is ignored.
+      /// \param[in] _data Pixels of the frame.
+      /// \param[in] _size Number of bytes in _data.
+      /// \return True if the frame was written.
+      protected: bool WriteSharedMemoryImage(const std::string &_topic,
+                     const msgs::Image &_image, const void *_data,
+                     std::size_t _size);
+
+      /// \brief Append a frame to the recording. Does nothing unless
+      /// recording.
+      /// \param[in] _stream Stream of the sensor the frame belongs to.
+      /// \param[in] _image Width, height, step, pixel format and header of
+      /// the frame. Its data field is ignored.
+      /// \param[in] _data Frame data.
+      /// \param[in] _size Number of bytes in _data.
+      /// \return True if the frame was recorded.
+      /// \sa SetRecording
+      protected: bool RecordFrame(uint32_t _stream, const msgs::Image &_image,
+                     const void *_data, std::size_t _size);
+
       /// \brief Add a rendering::Sensor. Its render updates will be handled
       /// by this base class.
       /// \param[in] _sensor Sensor to add.
       protected: void AddSensor(rendering::SensorPtr _sensor);
 
+      /// \brief Remove a rendering::Sensor added with AddSensor, so this
+      /// base class no longer renders it. The sensor isn't destroyed.
+      /// \param[in] _sensor Sensor to remove.
+      protected: void RemoveSensor(rendering::SensorPtr _sensor);
+
+      /// \brief Follow the scene changes signaled by RenderingEvents since
+      /// the sensor was created or this was last called. The latest scene
+      /// is set once, however many times it changed, so sensors calling
+      /// this at the start of their Update don't set up their cameras
+      /// again for every change while a world reloads. It's cheap when the
+      /// scene didn't change.
+      /// \return True if SetScene was called.
+      /// \sa RenderingEvents::SceneGeneration
+      protected: bool ApplySceneChanges();
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \internal
       /// \brief Data pointer for private data
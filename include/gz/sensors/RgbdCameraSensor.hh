@@ -48,6 +48,11 @@ namespace gz
     /// It offers both a gz-transport interface and a direct C++ API
     /// to access the image data. The API works by setting a callback to be
     /// called with image data.
+    ///
+    /// Gaussian image noise is added by a render pass on the depth camera,
+    /// so it is applied before the frames are read back. If the render
+    /// engine has no noise pass, the noise is applied to the read-back depths
+    /// on the CPU instead.
     class GZ_SENSORS_RGBD_CAMERA_VISIBLE RgbdCameraSensor
       : public CameraSensor
     {
@@ -93,6 +98,9 @@ namespace gz
       // Documentation inherited.
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited.
+      public: SensorMemoryUsage MemoryUsage() const override;
+
       /// \brief Check if there are color subscribers
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasColorConnections() const;
@@ -105,6 +113,13 @@ namespace gz
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasPointConnections() const;
 
+      /// \brief Check if there are surface normal subscribers. The normals
+      /// are published on the topic of the sensor followed by "/normals",
+      /// as described by DepthCameraSensor::HasNormalConnections, in the
+      /// frame of the point cloud.
+      /// \return True if there are subscribers, false otherwise
+      public: bool HasNormalConnections() const;
+
       /// \brief Create an RGB camera and a depth camera.
       /// \return True on success.
       private: bool CreateCameras();
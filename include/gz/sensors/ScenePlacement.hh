@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SCENEPLACEMENT_HH_
+#define GZ_SENSORS_SCENEPLACEMENT_HH_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/utils/SuppressWarning.hh>
+
+// TODO(louise) Remove these pragmas once gz-rendering is disabling the
+// warnings
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+#include <gz/rendering/RenderTypes.hh>
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/rendering/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // forward declarations
+    class RenderingSensor;
+    class ScenePlacementPrivate;
+
+    /// \brief Spreads rendering sensors over several scenes, for example
+    /// one per GPU, each created by a render engine on its own device.
+    /// The scenes are replicas of the same world, the application applies
+    /// the same scene updates to all of them. Sensors can be pinned to a
+    /// scene, the others go to the least loaded scene, where the load of
+    /// a sensor is the number of pixels it renders times its update rate.
+    /// RenderingSensor::RenderBatch renders each scene in its own pass.
+    class GZ_SENSORS_RENDERING_VISIBLE ScenePlacement
+    {
+      /// \brief Function giving the rendering load of a sensor.
+      public: using CostFunction =
+                  std::function<double(const RenderingSensor &)>;
+
+      /// \brief Constructor
+      public: ScenePlacement();
+
+      /// \brief Destructor
+      public: ~ScenePlacement();
+
+      /// \brief Add a scene sensors can be assigned to.
+      /// \param[in] _scene Scene to add.
+      /// \return Index of the scene, used to pin sensors to it.
+      public: std::size_t AddScene(rendering::ScenePtr _scene);
+
+      /// \brief Get the number of scenes.
+      /// \return Number of scenes added.
+      public: std::size_t SceneCount() const;
+
+      /// \brief Get a scene.
+      /// \param[in] _index Index of the scene.
+      /// \return The scene, null if the index is out of range.
+      public: rendering::ScenePtr SceneByIndex(std::size_t _index) const;
+
+      /// \brief Always assign a sensor to the same scene.
+      /// \param[in] _sensorName Name of the sensor.
+      /// \param[in] _index Index of the scene.
+      public: void Pin(const std::string &_sensorName, std::size_t _index);
+
+      /// \brief Let a pinned sensor be assigned automatically again.
+      /// \param[in] _sensorName Name of the sensor.
+      public: void Unpin(const std::string &_sensorName);
+
+      /// \brief Set the function giving the rendering load of a sensor.
+      /// \param[in] _cost Cost function, DefaultCost if empty.
+      public: void SetCostFunction(CostFunction _cost);
+
+      /// \brief Load of a sensor used unless a cost function is set: the
+      /// number of pixels rendered by its cameras times its update rate.
+      /// Sensors without a camera yet count as one pixel, and sensors
+      /// without an update rate as updating at 1 Hz.
+      /// \param[in] _sensor Sensor to weigh.
+      /// \return Load of the sensor.
+      public: static double DefaultCost(const RenderingSensor &_sensor);
+
+      /// \brief Assign sensors to the scenes and set their scene. Pinned
+      /// sensors are assigned first. The others are assigned from the most
+      /// to the least costly, each to the scene with the lowest load so far.
+      /// Sensors already in their assigned scene are left untouched.
+      /// \param[in] _sensors Sensors to assign.
+      /// \return Index of the scene assigned to each sensor, empty if there
+      /// are no scenes.
+      public: std::vector<std::size_t> Assign(
+                  const std::vector<RenderingSensor *> &_sensors);
+
+      /// \brief Get the load assigned to a scene by the last Assign call.
+      /// \param[in] _index Index of the scene.
+      /// \return Sum of the loads of its sensors, 0 if the index is out of
+      /// range.
+      public: double SceneLoad(std::size_t _index) const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<ScenePlacementPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
@@ -118,9 +118,37 @@ namespace gz
       /// \return height of the image
       public: virtual unsigned int ImageHeight() const override;
 
+      /// \brief Set whether the labels maps are published with one 16 bit
+      /// value per pixel, as L_INT16 images, instead of 3 channels. This
+      /// also applies to their shared memory and recorded frames. Semantic
+      /// maps hold the label. Panoptic maps hold the label in the high byte
+      /// and the low byte of the instance count in the low byte. Disabled
+      /// by default.
+      /// \param[in] _enabled True to publish 16 bit labels maps.
+      public: void SetLabelsMap16Bit(bool _enabled);
+
+      /// \brief Get whether the labels maps are published as 16 bit images.
+      /// \return True for 16 bit labels maps.
+      /// \sa SetLabelsMap16Bit
+      public: bool LabelsMap16Bit() const;
+
+      /// \brief Get the topic of the run-length encoded labels maps, the
+      /// sensor topic followed by "/labels_map_rle". Each message is a
+      /// msgs::Image laid out like a 16 bit labels map, see
+      /// SetLabelsMap16Bit, whose header has a "format" entry set to "rle".
+      /// Its data is a sequence of runs in row major order. Each run takes
+      /// 4 bytes: the label, then the number of consecutive pixels holding
+      /// it, both little endian 16 bit integers. Maps are only encoded
+      /// while the topic has subscribers.
+      /// \return Topic of the run-length encoded labels maps.
+      public: std::string LabelsMapRleTopic() const;
+
       // Documentation inherited.
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited.
+      public: SensorMemoryUsage MemoryUsage() const override;
+
       /// \brief Create a camera in a scene
       /// \return True on success.
       private: bool CreateCamera();
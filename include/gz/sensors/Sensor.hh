@@ -27,16 +27,32 @@
 #pragma warning(pop)
 #endif
 
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <gz/utils/SuppressWarning.hh>
 #include <gz/math/Pose3.hh>
+#include <gz/transport/Node.hh>
 #include <gz/sensors/config.hh>
 #include <gz/sensors/Export.hh>
+#include <gz/sensors/SensorState.hh>
+#include <gz/sensors/SensorTypes.hh>
 #include <sdf/sdf.hh>
 
+namespace google
+{
+  namespace protobuf
+  {
+    class Arena;
+  }
+}
+
 namespace gz
 {
   namespace sensors
@@ -49,7 +65,104 @@ namespace gz
     const SensorId NO_SENSOR = 0;
 
     /// \brief forward declarations
+    class SensorBundle;
     class SensorPrivate;
+    class SensorRecorder;
+    class SensorReplay;
+
+    /// \brief Wall-clock time spent by a sensor generating data.
+    /// \sa Sensor::ExecutionTime
+    struct SensorExecutionTime
+    {
+      /// \brief Number of buckets in the histogram.
+      static constexpr std::size_t kHistogramSize = 24u;
+
+      /// \brief Number of measured updates.
+      uint64_t count{0u};
+
+      /// \brief Duration of the last update.
+      std::chrono::steady_clock::duration last{0};
+
+      /// \brief Exponentially weighted moving average of the update
+      /// duration, with a smoothing factor of 0.1.
+      std::chrono::steady_clock::duration average{0};
+
+      /// \brief Longest update duration.
+      std::chrono::steady_clock::duration max{0};
+
+      /// \brief Histogram of update durations. Bucket 0 counts updates
+      /// that took less than 1 microsecond, and bucket i counts updates that
+      /// took [2^(i-1), 2^i) microseconds. The last bucket also counts all
+      /// longer updates.
+      std::array<uint64_t, kHistogramSize> histogram{};
+    };
+
+    /// \brief Bytes of memory held by the buffers of a sensor, keyed by
+    /// buffer name.
+    /// \sa Sensor::MemoryUsage
+    using SensorMemoryUsage = std::map<std::string, std::size_t>;
+
+    /// \brief Stage of the pipeline that turns an update of a sensor into
+    /// a published message.
+    /// \sa Sensor::StampLatency
+    enum class SensorLatencyStage
+    {
+      /// \brief The update of the sensor started.
+      UPDATE = 0,
+
+      /// \brief The scene was rendered.
+      RENDER = 1,
+
+      /// \brief The rendered data was read back from the GPU.
+      READBACK = 2,
+
+      /// \brief A message was filled and handed to Sensor::Publish.
+      FILL = 3,
+
+      /// \brief A message was published, or queued when asynchronous
+      /// publishing is enabled.
+      PUBLISH = 4
+    };
+
+    /// \brief Priority class of a sensor. The manager updates higher
+    /// classes first, and lowers the rates of lower classes first when it
+    /// has an update budget.
+    /// \sa Sensor::SetPriority
+    enum class SensorPriority
+    {
+      /// \brief Sensors feeding control loops, the default of IMU and
+      /// force-torque sensors. They're updated before any other sensor,
+      /// on the thread calling Manager::RunOnce. Rendering sensors of this
+      /// class are only updated first, they still go through the render
+      /// batch and queue of the manager.
+      CONTROL = 0,
+
+      /// \brief Default class.
+      NORMAL = 1,
+
+      /// \brief Perception sensors, the default of rendering sensors such
+      /// as cameras and lidars. They're updated after the other sensors.
+      PERCEPTION = 2
+    };
+
+    /// \brief Kind of memory used by the large buffers of a sensor, such as
+    /// frames read back from the GPU and point clouds.
+    /// \sa Sensor::SetBufferMemory
+    enum class SensorBufferMemory
+    {
+      /// \brief Regular heap memory aligned to a cache line.
+      DEFAULT = 0,
+
+      /// \brief Memory aligned to transparent huge pages, which lowers the
+      /// TLB misses of full frame passes. Buffers smaller than a huge page
+      /// use regular memory.
+      HUGE_PAGES = 1,
+
+      /// \brief Page-locked memory that is never swapped out, so writing a
+      /// readback into it never faults on a page. Locked memory is limited
+      /// per process by ulimit -l.
+      PINNED = 2
+    };
 
     /// \brief a base sensor class
     ///
@@ -106,6 +219,77 @@ namespace gz
       public: void SetNextDataUpdateTime(
                   const std::chrono::steady_clock::duration &_time);
 
+      /// \brief Append the mutable state of the sensor to _state: its
+      /// schedule, the sequence numbers of its messages, the state of its
+      /// noise models and whatever subclasses accumulate between updates,
+      /// such as integrated readings. Restoring it with RestoreState() on the
+      /// same sensor, or one loaded from the same SDF, makes the following
+      /// updates behave as they did after the save, e.g. to reset an episode
+      /// without loading the sensor again. Configuration set through the API
+      /// isn't saved, nor is the state of the rendering engine. Noise models
+      /// that weren't seeded with SetNoiseSeed() draw from the global
+      /// math::Rand generator, which isn't saved. Must not be called while
+      /// the sensor is being updated.
+      /// \param[in,out] _state State to append to. Clear it first to reuse
+      /// its memory.
+      public: virtual void SaveState(SensorState &_state) const;
+
+      /// \brief Restore the state saved by SaveState(), read from the read
+      /// position of _state. Rewind _state first to read it from the start.
+      /// Must not be called while the sensor is being updated.
+      /// \param[in,out] _state State to read from.
+      /// \return False if _state is too short or was saved by a sensor with
+      /// other noise models, in which case the state may be partially
+      /// restored.
+      public: virtual bool RestoreState(SensorState &_state);
+
+      /// \brief Apply new settings in place, without destroying and loading
+      /// the sensor again. Settings of _sdf equal to the loaded ones are
+      /// left as they are, so _sdf is typically the loaded SDF with a few
+      /// changes. Only the buffers and render targets affected by the
+      /// changes are resized; publishers, subscriptions and caches are kept.
+      /// The base class applies the update rate, pose and metrics setting.
+      /// Sensor types that don't override it keep their other settings as
+      /// loaded. Must not be called while the sensor is being updated.
+      /// \param[in] _sdf Sensor settings, of the type of the sensor.
+      /// \return False, with nothing changed, if _sdf is of another type or
+      /// changes a setting that requires recreating the sensor, such as
+      /// its topic.
+      public: virtual bool Reconfigure(const sdf::Sensor &_sdf);
+
+      /// \brief Set a callback that is called whenever the schedule of the
+      /// sensor is changed from outside of Update(), i.e. when the next data
+      /// update time or the update rate are set, when the sensor is
+      /// activated or deactivated, or when the sensor is initialized.
+      /// The Manager uses this to keep its update schedule in
+      /// sync with the sensor.
+      /// \param[in] _callback Function called with the id of this sensor. It
+      /// may be called from a transport thread when the rate is changed
+      /// through the `set_rate` service, so it must not block.
+      public: void SetScheduleChangedCallback(
+                  std::function<void(SensorId)> _callback);
+
+      /// \brief Set a callback that is called when a triggered sensor
+      /// receives a trigger. The Manager uses this to render triggered
+      /// sensors as soon as they're triggered.
+      /// \param[in] _callback Function called with the id of this sensor,
+      /// from the transport thread that received the trigger, so it must
+      /// not block.
+      /// \sa Manager::SetImmediateTrigger
+      public: void SetTriggerCallback(
+                  std::function<void(SensorId)> _callback);
+
+      /// \brief Get whether the sensor only generates data once triggered.
+      /// \return True if the sensor waits for triggers.
+      /// \sa TriggerPending
+      public: bool WaitsForTrigger() const;
+
+      /// \brief Get whether a trigger was received since the sensor was
+      /// last updated.
+      /// \return True if a trigger is pending.
+      /// \sa WaitsForTrigger
+      public: bool TriggerPending() const;
+
       /// \brief Update the sensor.
       ///
       ///   This is called by the manager, and is responsible for determining
@@ -119,9 +303,23 @@ namespace gz
       /// function returned true.
       /// False otherwise.
       /// \remarks If forced the NextUpdateTime() will be unchanged.
+      /// \remarks With SetInputInterpolation(), it generates every sample
+      /// due since the previous call, and returns true if one of them
+      /// did.
       public: bool Update(
         const std::chrono::steady_clock::duration &_now, const bool _force);
 
+      /// \brief Update a group of sensors that share the same type.
+      ///
+      ///   This is equivalent to calling Update(_now, false) on each sensor,
+      ///   but the sensors that are due are handed together to UpdateBatch(),
+      ///   so sensor types that override it can share work across the group.
+      /// \param[in] _sensors Sensors to update. All of them must have the
+      /// same dynamic type.
+      /// \param[in] _now The current time
+      public: static void UpdateGroup(const std::vector<Sensor *> &_sensors,
+        const std::chrono::steady_clock::duration &_now);
+
       /// \brief Get the update rate of the sensor.
       ///
       ///   The update rate is the number of times per second a sensor should
@@ -135,6 +333,65 @@ namespace gz
       /// \param[in] _hz Update rate of sensor in Hertz.
       public: void SetUpdateRate(const double _hz);
 
+      /// \brief Set whether update times are computed without drift.
+      /// \details By default the update period is truncated to whole
+      /// milliseconds and added to the previous update time, so e.g. a
+      /// 333 Hz sensor updates every 3 ms. With a drift-free schedule, the
+      /// n-th update after the schedule starts happens at n / rate seconds
+      /// with nanosecond resolution. The schedule restarts whenever the
+      /// rate or the next update time is set. Disabled by default.
+      /// \param[in] _driftFree True to enable the drift-free schedule.
+      public: void SetDriftFreeSchedule(bool _driftFree);
+
+      /// \brief Get whether update times are computed without drift.
+      /// \return True if the drift-free schedule is enabled.
+      /// \sa SetDriftFreeSchedule
+      public: bool DriftFreeSchedule() const;
+
+      /// \brief Set the lowest rate the sensor may be lowered to when the
+      /// sensors exceed the budget of Manager::SetUpdateBudget. Sensors
+      /// with a zero minimum rate, the default, are critical and always run
+      /// at UpdateRate(). Sensors updated every cycle are never lowered.
+      /// \param[in] _hz Minimum update rate in Hertz.
+      public: void SetMinUpdateRate(double _hz);
+
+      /// \brief Get the lowest rate the sensor may be lowered to.
+      /// \return Minimum update rate in Hertz, 0 for critical sensors.
+      /// \sa SetMinUpdateRate
+      public: double MinUpdateRate() const;
+
+      /// \brief Set the priority class of the sensor.
+      /// \param[in] _priority Priority class.
+      public: void SetPriority(SensorPriority _priority);
+
+      /// \brief Get the priority class of the sensor.
+      /// \return Priority class, SensorPriority::NORMAL unless the sensor
+      /// type or SetPriority chose another one.
+      public: SensorPriority Priority() const;
+
+      /// \brief Lower the rate the sensor is updated at, without changing
+      /// UpdateRate(). The rate is kept between MinUpdateRate() and
+      /// UpdateRate(), and setting UpdateRate() or more restores it.
+      /// \param[in] _hz Effective update rate in Hertz.
+      public: void SetEffectiveUpdateRate(double _hz);
+
+      /// \brief Get the rate the sensor is updated at.
+      /// \return UpdateRate(), unless it was lowered by
+      /// SetEffectiveUpdateRate.
+      public: double EffectiveUpdateRate() const;
+
+      /// \brief Set whether the wall-clock duration of the updates is
+      /// measured, which the manager does to respect its update budget.
+      /// \param[in] _measure True to measure update durations.
+      /// \sa UpdateCost
+      public: void SetMeasureUpdateCost(bool _measure);
+
+      /// \brief Get the average wall-clock duration of the last updates,
+      /// an exponential moving average measured while
+      /// SetMeasureUpdateCost() is enabled or metrics are enabled.
+      /// \return Average update duration, 0 if none was measured.
+      public: std::chrono::steady_clock::duration UpdateCost() const;
+
       /// \brief Get the current pose.
       /// \return Current pose of the sensor.
       public: gz::math::Pose3d Pose() const;
@@ -174,6 +431,61 @@ namespace gz
       /// \param[in] _enableMetrics True to enable.
       public: void SetEnableMetrics(bool _enableMetrics);
 
+      /// \brief Get the wall-clock time spent generating data. Durations
+      /// are only measured while metrics are enabled. When the sensor is
+      /// updated as part of a batch, each sensor of the batch is accounted
+      /// an equal share of the batch duration.
+      /// \return Execution time statistics.
+      /// \sa SetEnableMetrics
+      public: SensorExecutionTime ExecutionTime() const;
+
+      /// \brief Clear the execution time and latency statistics.
+      public: void ResetExecutionTime();
+
+      /// \brief Set whether FillHeader() adds the wall-clock stamps of the
+      /// stages the current update went through before the message was
+      /// filled. They're `stamp_update`, `stamp_render` and
+      /// `stamp_readback` key-value pairs, in nanoseconds since the epoch of
+      /// the system clock, following the `frame_id` and `seq` pairs.
+      /// Disabled by default.
+      /// \param[in] _enable True to add the stamps to the headers.
+      /// \sa StampLatency
+      public: void SetLatencyStamps(bool _enable);
+
+      /// \brief Get whether FillHeader() adds latency stamps.
+      /// \return True if latency stamps are added.
+      /// \sa SetLatencyStamps
+      public: bool LatencyStamps() const;
+
+      /// \brief Get the latency of a stage, the wall-clock time from the
+      /// start of the update to the stage. Latencies are measured while
+      /// metrics or latency stamps are enabled, and published with the
+      /// metrics on the `<topic>/performance_metrics/latency` topic. The
+      /// UPDATE stage has no statistics.
+      /// \param[in] _stage Stage of the pipeline.
+      /// \return Latency statistics of the stage.
+      /// \sa SetEnableMetrics
+      public: SensorExecutionTime Latency(SensorLatencyStage _stage) const;
+
+      /// \brief Get the memory held by the buffers of the sensor, such as
+      /// rendered images, scans, point clouds, messages kept across updates
+      /// and the message arena. Derived sensors add their buffers to the
+      /// report of their base class. Memory held by the rendering engine
+      /// and tables shared between sensors aren't included. The report is
+      /// published with the metrics on the
+      /// `<topic>/performance_metrics/memory` topic. Don't call it while
+      /// the sensor is being updated.
+      /// \return Bytes held by each buffer.
+      /// \sa Manager::MemoryUsage
+      public: virtual SensorMemoryUsage MemoryUsage() const;
+
+      /// \brief Record that the current update reached a stage. It's
+      /// called by Update(), by RenderingSensor and by Publish(), and does
+      /// nothing while metrics and latency stamps are disabled. Stamping
+      /// the UPDATE stage starts a new update and forgets the other stamps.
+      /// \param[in] _stage Stage the update reached.
+      public: void StampLatency(SensorLatencyStage _stage);
+
       /// \brief Get parent link of the sensor.
       /// \return Parent link of sensor.
       public: std::string Parent() const;
@@ -208,8 +520,36 @@ namespace gz
       public: void AddSequence(gz::msgs::Header *_msg,
                   const std::string &_seqKey = "default");
 
+      /// \brief Fill a gz::msgs::Header with the time stamp, a `frame_id`
+      /// key-value pair with FrameId() and a `seq` key-value pair with the
+      /// next number of the default sequence, as AddSequence() would.
+      ///
+      /// When latency stamps are enabled, the stamps of the stages the
+      /// current update went through follow, see SetLatencyStamps().
+      /// Any other key-value pair is removed. If the header was filled by
+      /// this function before, its entries are updated in place, so
+      /// refilling a message that is kept across updates doesn't allocate.
+      /// \param[in,out] _msg The header to fill.
+      /// \param[in] _now Time stamp.
+      public: void FillHeader(gz::msgs::Header *_msg,
+                  const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Fill a gz::msgs::Header with the time stamp, a `frame_id`
+      /// key-value pair and a `seq` key-value pair.
+      /// \param[in,out] _msg The header to fill.
+      /// \param[in] _now Time stamp.
+      /// \param[in] _frameId Value of the `frame_id` key.
+      /// \param[in] _seqKey Name of the sequence to use.
+      /// \sa FillHeader(gz::msgs::Header *,
+      /// const std::chrono::steady_clock::duration &)
+      public: void FillHeader(gz::msgs::Header *_msg,
+                  const std::chrono::steady_clock::duration &_now,
+                  const std::string &_frameId, const std::string &_seqKey);
+
       /// \brief Publishes information about the performance of the sensor.
-      ///        This method is called by Update().
+      ///        This method is called by Update(). Execution time
+      ///        statistics are published on the
+      ///        `<topic>/performance_metrics/execution_time` topic.
       /// \param[in] _now Current time.
       public: void PublishMetrics(
         const std::chrono::duration<double> &_now);
@@ -231,6 +571,494 @@ namespace gz
       /// \return True if there are subscribers, false otherwise
       public: virtual bool HasConnections() const;
 
+      /// \brief Set whether the sensor skips generating data while nobody
+      /// is subscribed to it. When enabled, updates that are due while
+      /// HasConnections() returns false only advance the update schedule,
+      /// unless they are forced. Disabled by default.
+      /// \param[in] _lazy True to skip updates without subscribers.
+      /// \sa SetLazyNoiseUpdate
+      public: void SetLazyUpdate(bool _lazy);
+
+      /// \brief Get whether the sensor skips generating data while nobody
+      /// is subscribed to it.
+      /// \return True if lazy updates are enabled.
+      /// \sa SetLazyUpdate
+      public: bool LazyUpdate() const;
+
+      /// \brief Set whether skipped lazy updates still advance the state of
+      /// the sensor's noise models, such as the bias random walk of a
+      /// Gaussian noise model, by calling UpdateNoiseState(). Disabled by
+      /// default.
+      /// \param[in] _keepNoise True to update the noise state on skipped
+      /// updates.
+      /// \sa SetLazyUpdate
+      public: void SetLazyNoiseUpdate(bool _keepNoise);
+
+      /// \brief Get whether skipped lazy updates still advance the state of
+      /// the sensor's noise models.
+      /// \return True if the noise state is updated on skipped updates.
+      /// \sa SetLazyNoiseUpdate
+      public: bool LazyNoiseUpdate() const;
+
+      /// \brief Set whether sensor data is published from a background
+      /// thread. When enabled, Update only fills the messages and hands them
+      /// over to a queue, and serialization and transport happen on a
+      /// publishing thread shared by all sensors. Each publisher of the
+      /// sensor gets its own queue, bounded by AsyncPublishDepth(). When a
+      /// queue is full the oldest message is dropped. Disabling discards
+      /// messages that are still queued. Defaults to false.
+      /// \param[in] _async True to publish from the background thread.
+      public: void SetAsyncPublish(bool _async);
+
+      /// \brief Get whether sensor data is published from a background
+      /// thread.
+      /// \return True if asynchronous publishing is enabled.
+      /// \sa SetAsyncPublish
+      public: bool AsyncPublish() const;
+
+      /// \brief Set the maximum number of messages per publisher that can
+      /// wait to be published when asynchronous publishing is enabled.
+      /// Defaults to 1, so subscribers always get the latest data.
+      /// \param[in] _depth Queue depth. Zero is treated as one.
+      /// \sa SetAsyncPublish
+      public: void SetAsyncPublishDepth(std::size_t _depth);
+
+      /// \brief Get the maximum number of messages per publisher that can
+      /// wait to be published when asynchronous publishing is enabled.
+      /// \return Queue depth.
+      public: std::size_t AsyncPublishDepth() const;
+
+      /// \brief Set the limits of backpressure handling, for subscribers
+      /// that can't keep up when asynchronous publishing is enabled. Once
+      /// the messages of a publisher waiting to be published, including
+      /// the one being published, reach _depth messages or _bytes
+      /// serialized bytes, new messages of that publisher are dropped
+      /// without being copied. While every publisher with subscribers is
+      /// over a limit, updates are skipped, so rendering sensors don't
+      /// render or read back frames nobody can take. Drops and skips are
+      /// published with the performance metrics, on the
+      /// performance_metrics/backpressure topic. Zero disables a limit;
+      /// both are disabled by default.
+      /// \param[in] _depth Limit on pending messages per publisher.
+      /// \param[in] _bytes Limit on pending bytes per publisher.
+      /// \sa SetAsyncPublish
+      /// \sa SetEnableMetrics
+      public: void SetBackpressureLimits(std::size_t _depth,
+                  std::size_t _bytes);
+
+      /// \brief Get the limit on pending messages per publisher.
+      /// \return Number of messages, 0 if disabled.
+      /// \sa SetBackpressureLimits
+      public: std::size_t BackpressureDepth() const;
+
+      /// \brief Get the limit on pending bytes per publisher.
+      /// \return Number of bytes, 0 if disabled.
+      /// \sa SetBackpressureLimits
+      public: std::size_t BackpressureBytes() const;
+
+      /// \brief Get the number of messages of the asynchronous publish
+      /// queues that were dropped, because a queue was full or over the
+      /// backpressure limits.
+      /// \return Number of dropped messages.
+      public: uint64_t DroppedMessageCount() const;
+
+      /// \brief Get the number of updates skipped because of backpressure.
+      /// \return Number of skipped updates.
+      /// \sa SetBackpressureLimits
+      public: uint64_t BackpressureSkippedCount() const;
+
+      /// \brief Set a delay between an update and the publication of its
+      /// messages, to emulate the latency of a real sensor. Messages given
+      /// to Publish() are held in a ring buffer per publisher, moved or
+      /// copied into messages that are reused once the ring has been
+      /// filled, and published by the first Update() call at or after the
+      /// update time plus the delay. The release is therefore aligned to
+      /// the steps of the caller. Messages still held when the delay is
+      /// changed keep their release time. Held messages are dropped if time
+      /// goes backwards. The latency stages don't include the delay. It can
+      /// also be set in seconds with the `<gz_output_delay>` element of the
+      /// sensor. Defaults to zero, which publishes right away.
+      /// \param[in] _delay Output delay. Negative values are treated as
+      /// zero.
+      /// \sa SetOutputDelayDepth
+      public: void SetOutputDelay(
+                  const std::chrono::steady_clock::duration &_delay);
+
+      /// \brief Get the delay between an update and the publication of its
+      /// messages.
+      /// \return Output delay.
+      /// \sa SetOutputDelay
+      public: std::chrono::steady_clock::duration OutputDelay() const;
+
+      /// \brief Set the number of messages each publisher can hold while
+      /// they are delayed. When a buffer is full, its oldest message is
+      /// published early to make room for the new one. Setting it drops the
+      /// messages being held. Defaults to zero, which holds one message per
+      /// update made during the delay, plus one, or 32 messages when the
+      /// sensor updates on every step.
+      /// \param[in] _depth Buffer depth, zero to size it automatically.
+      /// \sa SetOutputDelay
+      public: void SetOutputDelayDepth(std::size_t _depth);
+
+      /// \brief Get the number of messages each publisher can hold while
+      /// they are delayed.
+      /// \return Buffer depth, zero if it's sized automatically.
+      public: std::size_t OutputDelayDepth() const;
+
+      /// \brief Get the number of messages waiting for their output delay
+      /// to elapse.
+      /// \return Number of held messages.
+      public: std::size_t DelayedMessageCount() const;
+
+      /// \brief Set the kind of memory used by the large buffers of the
+      /// sensor: the images of cameras, the depth, thermal and label frames
+      /// read back from the GPU, point clouds and lidar scans. It applies
+      /// to the buffers allocated afterwards, so it's best set before the
+      /// sensor is loaded, or with the `<gz_buffer_memory>` element of the
+      /// sensor, one of `default`, `huge_pages` or `pinned`. Buffers fall
+      /// back to regular memory when the kind isn't available, which is the
+      /// case on other platforms than Linux. Sensors without large buffers
+      /// ignore it. Defaults to SensorBufferMemory::DEFAULT.
+      /// \param[in] _memory Kind of memory.
+      public: void SetBufferMemory(SensorBufferMemory _memory);
+
+      /// \brief Get the kind of memory used by the large buffers of the
+      /// sensor.
+      /// \return Kind of memory.
+      /// \sa SetBufferMemory
+      public: SensorBufferMemory BufferMemory() const;
+
+      /// \brief Set the recorder every message handed to Publish() is
+      /// recorded to, before any output delay or publish queue. Messages are
+      /// recorded under the topic of their publisher when it was advertised
+      /// with Advertise(), under Topic() otherwise, with the time of the
+      /// update that produced them. Lazy sensors keep updating without
+      /// subscribers while recording. It must not be set during an update.
+      /// \param[in] _recorder Recorder, null to stop recording.
+      /// \sa Manager::SetRecorder
+      public: void SetRecorder(std::shared_ptr<SensorRecorder> _recorder);
+
+      /// \brief Get the recorder the messages of the sensor are recorded to.
+      /// \return The recorder, null if the sensor isn't recorded.
+      public: std::shared_ptr<SensorRecorder> Recorder() const;
+
+      /// \brief Set the bundle every message handed to Publish() is added
+      /// to, under the same topic as for SetRecorder(), with the time of the
+      /// update that produced it. The end of each update is notified to the
+      /// bundle. Lazy sensors keep updating without subscribers while the
+      /// bundle has consumers. It must not be set during an update.
+      /// \param[in] _bundle Bundle, null to leave the bundle.
+      /// \sa Manager::AddBundle
+      public: void SetBundle(std::shared_ptr<SensorBundle> _bundle);
+
+      /// \brief Get the bundle the messages of the sensor are added to.
+      /// \return The bundle, null if the sensor isn't bundled.
+      public: std::shared_ptr<SensorBundle> Bundle() const;
+
+      /// \brief Set a replay whose recorded messages the sensor publishes
+      /// in place of computing new data. Each update publishes the
+      /// messages of the sensor's topics recorded since the previous one,
+      /// up to the update time, so the schedule and the topics don't
+      /// change. Rendering sensors being replayed don't render and are
+      /// updated like other sensors. It must not be set during an update.
+      /// \param[in] _replay Replay, null to compute data again.
+      /// \sa Manager::SetReplay
+      public: void SetReplay(std::shared_ptr<SensorReplay> _replay);
+
+      /// \brief Get the replay the sensor publishes messages from.
+      /// \return The replay, null if the sensor isn't replayed.
+      public: std::shared_ptr<SensorReplay> Replay() const;
+
+      /// \brief Get the type of the sensor, as named in SDF, such as
+      /// "camera" or "gpu_lidar".
+      /// \return Type of the SDF the sensor was loaded with, "none" if
+      /// it wasn't loaded.
+      public: std::string TypeStr() const;
+
+      /// \brief Set whether messages with a large payload, such as images
+      /// and point clouds, are also published in the raw payload layout on
+      /// the topic of their publisher followed by "/raw". Subscribers of
+      /// that topic read the payload in place, at an aligned offset, instead
+      /// of parsing it out of a protobuf message. Messages are only encoded
+      /// while the raw topic has subscribers, and the protobuf topic is
+      /// skipped while it has none. Raw messages aren't delayed by
+      /// SetOutputDelay(). Disabled by default, or set with
+      /// <gz_raw_payload> in SDF.
+      /// \param[in] _enabled True to publish raw payloads.
+      /// \sa RawPayloadHeader
+      public: void SetRawPayloadOutput(bool _enabled);
+
+      /// \brief Get whether messages with a large payload are also published
+      /// in the raw payload layout.
+      /// \return True if raw payloads are published.
+      /// \sa SetRawPayloadOutput
+      public: bool RawPayloadOutput() const;
+
+      /// \brief Set whether a sensor whose update rate is higher than the
+      /// rate its inputs are set at, e.g. an imu at 1 kHz in a world stepped
+      /// at 250 Hz, generates the samples that are due between two calls to
+      /// Update() from inputs interpolated between the ones set for each
+      /// call, instead of one sample per call. Positions and vectors are
+      /// interpolated linearly and rotations along the shortest arc. The
+      /// first update after it's enabled generates a single sample. Forced
+      /// and replayed updates aren't interpolated. Disabled by default, or
+      /// set with <gz_interpolate_inputs> in SDF.
+      /// \param[in] _enabled True to interpolate inputs.
+      /// \sa SaveInputs
+      public: void SetInputInterpolation(bool _enabled);
+
+      /// \brief Get whether samples due between updates are generated from
+      /// interpolated inputs.
+      /// \return True if inputs are interpolated.
+      /// \sa SetInputInterpolation
+      public: bool InputInterpolation() const;
+
+      /// \brief Publish a message using one of the sensor's publishers. If
+      /// an output delay is set, the message is copied to the delay buffer.
+      /// Else if asynchronous publishing is enabled, the message is copied
+      /// to the publish queue, otherwise it's published right away.
+      /// \param[in] _pub Publisher owned by the sensor.
+      /// \param[in] _msg Message to publish.
+      /// \return True if the message was published or queued.
+      /// \sa SetAsyncPublish
+      public: bool Publish(transport::Node::Publisher &_pub,
+        const google::protobuf::Message &_msg);
+
+      /// \brief Publish a message using one of the sensor's publishers. If
+      /// an output delay is set, the contents of the message are moved to
+      /// the delay buffer, leaving _msg empty. Else if asynchronous
+      /// publishing is enabled, they're moved to the publish queue.
+      /// Otherwise it's published right away.
+      /// \param[in] _pub Publisher owned by the sensor.
+      /// \param[in] _msg Message to publish.
+      /// \return True if the message was published or queued.
+      /// \sa SetAsyncPublish
+      public: bool Publish(transport::Node::Publisher &_pub,
+        google::protobuf::Message &&_msg);
+
+      /// \brief Set whether the sensor holds back its topic and service
+      /// advertisements until AdvertisePending() is called. Each
+      /// advertisement is announced to the whole network, so deferring them
+      /// lets a world load all of its sensors before the discovery traffic
+      /// starts. Set it before Load(). Disabled by default.
+      /// \param[in] _deferred True to defer advertisements.
+      /// \sa Manager::SetAdvertiseDeferred
+      public: void SetAdvertiseDeferred(bool _deferred);
+
+      /// \brief Get whether advertisements are held back until
+      /// AdvertisePending() is called.
+      /// \return True if advertisements are deferred.
+      public: bool AdvertiseDeferred() const;
+
+      /// \brief Make the advertisements that were deferred, in the order
+      /// they were requested, and stop deferring new ones.
+      /// \return True if all topics and services were advertised.
+      /// \sa SetAdvertiseDeferred
+      public: bool AdvertisePending();
+
+      /// \brief Get the number of advertisements waiting for
+      /// AdvertisePending().
+      /// \return Number of deferred advertisements.
+      public: std::size_t PendingAdvertisementCount() const;
+
+      /// \brief Advertise a topic, or defer the advertisement if
+      /// AdvertiseDeferred() is true, in which case _pub is only valid
+      /// once AdvertisePending() is called. Both _node and _pub must live as
+      /// long as the sensor.
+      /// \param[in] _node Node to advertise the topic on.
+      /// \param[out] _pub Publisher to assign.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _options Advertisement options.
+      /// \tparam MsgT Message type.
+      /// \return False if the topic couldn't be advertised right away, true
+      /// otherwise.
+      protected: template<typename MsgT>
+        bool Advertise(transport::Node &_node,
+          transport::Node::Publisher &_pub, const std::string &_topic,
+          const transport::AdvertiseMessageOptions &_options =
+              transport::AdvertiseMessageOptions())
+      {
+        auto advertise = [&_node, &_pub, _topic, _options]()
+        {
+          _pub = _node.Advertise<MsgT>(_topic, _options);
+          return static_cast<bool>(_pub);
+        };
+        this->SetPublisherTopic(_pub, _topic);
+        if (this->AdvertiseDeferred())
+        {
+          this->DeferAdvertisement(_topic, std::move(advertise));
+          return true;
+        }
+        return advertise();
+      }
+
+      /// \brief Queue an advertisement until AdvertisePending() is called.
+      /// \param[in] _topic Topic or service name, for error messages.
+      /// \param[in] _advertise Makes the advertisement, returns true on
+      /// success.
+      private: void DeferAdvertisement(const std::string &_topic,
+        std::function<bool()> _advertise);
+
+      /// \brief Remember the topic of a publisher, under which its messages
+      /// are recorded.
+      /// \param[in] _pub Publisher owned by the sensor.
+      /// \param[in] _topic Topic name.
+      private: void SetPublisherTopic(transport::Node::Publisher &_pub,
+        const std::string &_topic);
+
+      /// \brief Set whether the sensor builds temporary outgoing messages
+      /// on a per-sensor protobuf arena. The arena keeps its first memory
+      /// block across resets, so nested submessages built in steady state
+      /// don't cost individual allocations. Disabled by default.
+      /// \param[in] _enabled True to enable the message arena.
+      /// \sa MessageArena
+      public: void SetMessageArenaEnabled(bool _enabled);
+
+      /// \brief Get whether the sensor builds temporary outgoing messages on
+      /// a per-sensor protobuf arena.
+      /// \return True if the message arena is enabled.
+      public: bool MessageArenaEnabled() const;
+
+      /// \brief Get the arena to create temporary outgoing messages on.
+      /// Messages created on it remain valid until ResetMessageArena() is
+      /// called, which Update() does after every update.
+      /// \return The arena, or nullptr if the message arena is disabled, in
+      /// which case messages should be allocated on the heap.
+      /// \sa SetMessageArenaEnabled
+      protected: google::protobuf::Arena *MessageArena();
+
+      /// \brief Release all messages created on the message arena. Sensors
+      /// that publish outside of Update() should call this once they are
+      /// done with their messages.
+      protected: void ResetMessageArena();
+
+      /// \brief Seed the random streams of the sensor's noise models. Each
+      /// noise model gets its own seed, derived from _seed, the sensor's name
+      /// and the noise type, so that runs with the same seed are
+      /// reproducible regardless of the order sensors are updated in. Noise
+      /// models loaded later are seeded as well.
+      /// \param[in] _seed Seed, typically shared by all sensors of a world.
+      /// \sa DeriveNoiseSeed
+      public: void SetNoiseSeed(uint64_t _seed);
+
+      /// \brief Get whether SetNoiseSeed() has been called.
+      /// \return True if the sensor's noise models are seeded.
+      public: bool HasNoiseSeed() const;
+
+      /// \brief Get the seed set with SetNoiseSeed().
+      /// \return The seed, or 0 if none was set.
+      public: uint64_t NoiseSeed() const;
+
+      /// \brief Derive the seed of one noise model of a sensor.
+      /// \param[in] _seed Seed passed to SetNoiseSeed().
+      /// \param[in] _sensorName Name of the sensor.
+      /// \param[in] _type Type of the noise model.
+      /// \return The seed of the noise model.
+      public: static uint64_t DeriveNoiseSeed(uint64_t _seed,
+                  const std::string &_sensorName, SensorNoiseType _type);
+
+      /// \brief Register a noise model of the sensor so that it is seeded
+      /// by SetNoiseSeed(). Registering a type again replaces the previous
+      /// model. Sensors should call this for every noise model they load.
+      /// \param[in] _type Type of the noise model.
+      /// \param[in] _noise The noise model.
+      protected: void RegisterNoise(SensorNoiseType _type,
+                     const NoisePtr &_noise);
+
+      /// \brief Register every noise model of a table with
+      /// RegisterNoise(). Types without a model are skipped.
+      /// \param[in] _noises The noise models.
+      protected: void RegisterNoise(const NoiseTable &_noises);
+
+      /// \brief Call the trigger callback, if any. Triggered sensors call
+      /// this once they have received a trigger and are ready to be
+      /// updated, without holding locks that Update takes. It also marks
+      /// the trigger as pending, which puts a sensor that waits for
+      /// triggers back on the schedule of the Manager.
+      /// \sa SetTriggerCallback
+      /// \sa SetWaitForTrigger
+      protected: void NotifyTriggered();
+
+      /// \brief Set whether the sensor only generates data once triggered.
+      /// The Manager then leaves the sensor out of its schedule until
+      /// NotifyTriggered() is called, and puts it back out once it's
+      /// updated, so idle triggered sensors cost nothing per step.
+      /// Updates forced through RunOnce still reach the sensor.
+      /// \param[in] _wait True if the sensor waits for triggers.
+      protected: void SetWaitForTrigger(bool _wait);
+
+      /// \brief Advance the state of the sensor's noise models without
+      /// generating data. Called instead of Update() for updates skipped
+      /// because of SetLazyUpdate(), if SetLazyNoiseUpdate() is enabled.
+      /// The default implementation calls Update(), so sensors with
+      /// stateful noise should override it with a cheaper version.
+      /// \param[in] _now The current time
+      protected: virtual void UpdateNoiseState(
+        const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Append the inputs of the sensor, set from outside before
+      /// each update, to _state for SetInputInterpolation(). The default
+      /// implementation writes Pose(). Sensors with other inputs should
+      /// override it and InterpolateInputs() together.
+      /// \param[in,out] _state State to append to.
+      protected: virtual void SaveInputs(SensorState &_state) const;
+
+      /// \brief Set the inputs of the sensor to the ones saved by
+      /// SaveInputs() in _from and _to, interpolated at _alpha.
+      /// \param[in,out] _from Inputs of the previous update, read from its
+      /// read position.
+      /// \param[in,out] _to Inputs of the current update, read from its read
+      /// position.
+      /// \param[in] _alpha 0 for the inputs of _from, 1 for the ones of _to,
+      /// which must be set exactly.
+      /// \return False if the states are too short.
+      protected: virtual bool InterpolateInputs(SensorState &_from,
+        SensorState &_to, double _alpha);
+
+      /// \brief Generate data for a batch of sensors that are due.
+      ///
+      ///   Called by UpdateGroup() on the first sensor of the batch. All
+      ///   sensors in the batch have the same dynamic type as this one. The
+      ///   default implementation calls Update(_now) on each sensor.
+      ///   Overrides must produce the same output as individual updates.
+      /// \param[in] _sensors Sensors that need to generate data.
+      /// \param[in] _now The current time
+      protected: virtual void UpdateBatch(
+        const std::vector<Sensor *> &_sensors,
+        const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Get whether this sensor generates data using the rendering
+      /// engine. Rendering sensors must be updated from the thread that owns
+      /// the rendering context, so the Manager never updates them from its
+      /// worker threads.
+      /// \return True if this is a rendering sensor, false otherwise.
+      /// \sa Manager::SetWorkerThreadCount
+      public: virtual bool IsRenderingSensor() const;
+
+      /// \brief Get whether the sensors of this type are updated together
+      /// through UpdateBatch() even when the Manager's grouped updates are
+      /// disabled. Rendering sensors are never batched this way.
+      /// \return False by default, true for BatchSensor types.
+      /// \sa BatchSensor
+      /// \sa Manager::SetGroupedUpdate
+      public: virtual bool HasBatchUpdate() const;
+
+      /// \brief Check whether a due update should be skipped because of
+      /// backpressure or SetLazyUpdate(), updating the noise state if
+      /// needed.
+      /// \param[in] _now The current time
+      /// \return True if the update should be skipped.
+      private: bool SkipLazyUpdate(
+        const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Generate a single sample if the sensor is due, the body of
+      /// Update(const std::chrono::steady_clock::duration &, const bool).
+      /// \param[in] _now Time of the sample.
+      /// \param[in] _force Force the update to happen even if it's not time
+      /// \return True if the update was triggered and generated data.
+      private: bool UpdateSample(
+        const std::chrono::steady_clock::duration &_now, const bool _force);
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \internal
       /// \brief Data pointer for private data
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SENSORBUNDLE_HH_
+#define GZ_SENSORS_SENSORBUNDLE_HH_
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <google/protobuf/message.h>
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class SensorBundlePrivate;
+
+    /// \brief Header of a bundle frame, published by a SensorBundle with
+    /// gz-transport's raw API as the message type SensorBundleType().
+    ///
+    /// The header is followed by SensorBundleHeader::count entries, each
+    /// made of a SensorBundleEntryHeader, the topic, the message type and
+    /// the serialized protobuf message, padded to a multiple of 8 bytes.
+    /// Integers are in host byte order.
+    struct SensorBundleHeader
+    {
+      /// \brief Value of magic for a valid frame.
+      static constexpr uint32_t kMagic = 0x475a5342u;
+
+      /// \brief Version of the layout.
+      static constexpr uint32_t kVersion = 1u;
+
+      /// \brief kMagic.
+      uint32_t magic;
+
+      /// \brief Layout version, kVersion.
+      uint32_t version;
+
+      /// \brief Number of entries.
+      uint32_t count;
+
+      /// \brief Unused, zero.
+      uint32_t reserved;
+
+      /// \brief Time of the update of the first sensor of the bundle that
+      /// closed the frame, in nanoseconds.
+      int64_t time;
+    };
+
+    /// \brief Header of an entry of a bundle frame.
+    struct SensorBundleEntryHeader
+    {
+      /// \brief Time of the update that produced the message, in
+      /// nanoseconds.
+      int64_t time;
+
+      /// \brief Size of the topic.
+      uint32_t topicSize;
+
+      /// \brief Size of the message type.
+      uint32_t typeSize;
+
+      /// \brief Size of the serialized message.
+      uint64_t messageSize;
+    };
+
+    /// \brief An entry of a bundle frame, pointing into its bytes.
+    struct SensorBundleEntry
+    {
+      /// \brief Time of the update that produced the message.
+      std::chrono::steady_clock::duration time{0};
+
+      /// \brief Topic the message was published on.
+      std::string topic;
+
+      /// \brief Full name of the protobuf type of the message.
+      std::string type;
+
+      /// \brief Serialized message.
+      const char *message{nullptr};
+
+      /// \brief Size of the serialized message.
+      std::size_t messageSize{0u};
+    };
+
+    /// \brief Get the gz-transport message type of bundle frames.
+    /// \return The message type.
+    inline std::string SensorBundleType()
+    {
+      return "gz.sensors.bundle";
+    }
+
+    /// \brief Find the entries of a bundle frame. Messages aren't copied.
+    /// \param[in] _data Bytes of the frame, such as the data given to a
+    /// raw gz-transport subscriber.
+    /// \param[in] _size Number of bytes.
+    /// \param[out] _time Time of the frame.
+    /// \param[out] _entries Entries of the frame, oldest first.
+    /// \return False if the bytes aren't a bundle frame.
+    inline bool ParseSensorBundle(const char *_data, std::size_t _size,
+        std::chrono::steady_clock::duration &_time,
+        std::vector<SensorBundleEntry> &_entries)
+    {
+      _entries.clear();
+      SensorBundleHeader header;
+      if (!_data || _size < sizeof(header))
+        return false;
+      std::memcpy(&header, _data, sizeof(header));
+      if (header.magic != SensorBundleHeader::kMagic ||
+          header.version != SensorBundleHeader::kVersion)
+      {
+        return false;
+      }
+      _time = std::chrono::nanoseconds(header.time);
+
+      std::size_t pos = sizeof(header);
+      for (uint32_t i = 0u; i < header.count; ++i)
+      {
+        SensorBundleEntryHeader entry;
+        if (_size - pos < sizeof(entry))
+          return false;
+        std::memcpy(&entry, _data + pos, sizeof(entry));
+        pos += sizeof(entry);
+        const uint64_t size = static_cast<uint64_t>(entry.topicSize) +
+            entry.typeSize + entry.messageSize;
+        if (size > _size - pos)
+          return false;
+
+        SensorBundleEntry view;
+        view.time = std::chrono::nanoseconds(entry.time);
+        view.topic.assign(_data + pos, entry.topicSize);
+        pos += entry.topicSize;
+        view.type.assign(_data + pos, entry.typeSize);
+        pos += entry.typeSize;
+        view.message = _data + pos;
+        view.messageSize = static_cast<std::size_t>(entry.messageSize);
+        pos += view.messageSize;
+        _entries.push_back(std::move(view));
+
+        // Entries are padded to 8 bytes
+        pos = std::min(_size, (pos + 7u) & ~static_cast<std::size_t>(7u));
+      }
+      return true;
+    }
+
+    /// \brief Gathers the messages of a group of sensors into one frame per
+    /// update of the first sensor of the group, e.g. a camera image with
+    /// the imu samples published since the previous image, so subscribers
+    /// get time aligned data in a single message instead of synchronizing
+    /// several topics. Sensors hand the messages they publish to the bundle
+    /// with the time of their update, and the bundle publishes the frame at
+    /// the end of each update of the first sensor that produced a message.
+    /// Messages are only gathered while the frame topic has subscribers or
+    /// a frame callback is set. Add and EndUpdate can be called from
+    /// several threads.
+    /// \sa Manager::AddBundle
+    /// \sa Sensor::SetBundle
+    class GZ_SENSORS_VISIBLE SensorBundle
+    {
+      /// \brief Callback with the bytes of a frame.
+      public: using FrameCallback =
+          std::function<void(const char *_data, std::size_t _size)>;
+
+      /// \brief Constructor
+      public: SensorBundle();
+
+      /// \brief Destructor
+      public: ~SensorBundle();
+
+      /// \brief Advertise the topic frames are published on.
+      /// \param[in] _topic Topic name.
+      /// \return False if the topic couldn't be advertised.
+      public: bool Advertise(const std::string &_topic);
+
+      /// \brief Get the topic frames are published on.
+      /// \return Topic name, empty if not advertised.
+      public: std::string Topic() const;
+
+      /// \brief Set the sensor whose updates close the frames.
+      /// \param[in] _sensor Name of the sensor.
+      public: void SetPrimary(const std::string &_sensor);
+
+      /// \brief Get the sensor whose updates close the frames.
+      /// \return Name of the sensor.
+      public: std::string Primary() const;
+
+      /// \brief Set a callback that gets every frame, in addition to the
+      /// subscribers of the topic, e.g. to copy it to shared memory. It's
+      /// called from the thread that updates the first sensor, and must not
+      /// call the bundle.
+      /// \param[in] _callback Callback, null to remove it.
+      public: void SetFrameCallback(FrameCallback _callback);
+
+      /// \brief Set the number of messages kept for the next frame. The
+      /// oldest ones are dropped once it's reached, in case the first
+      /// sensor stops producing data. Defaults to 1024.
+      /// \param[in] _count Number of messages.
+      public: void SetMaxPending(std::size_t _count);
+
+      /// \brief Get the number of messages kept for the next frame.
+      /// \return Number of messages.
+      public: std::size_t MaxPending() const;
+
+      /// \brief Get whether frames have a consumer, a subscriber of the
+      /// topic or a frame callback.
+      /// \return True if frames are consumed.
+      public: bool HasConnections() const;
+
+      /// \brief Add a message to the next frame.
+      /// \param[in] _sensor Name of the sensor that published it.
+      /// \param[in] _topic Topic the message is published on.
+      /// \param[in] _msg Message.
+      /// \param[in] _time Time of the update that produced the message.
+      public: void Add(const std::string &_sensor, const std::string &_topic,
+                  const google::protobuf::Message &_msg,
+                  const std::chrono::steady_clock::duration &_time);
+
+      /// \brief Notify that a sensor finished an update. If it's the first
+      /// sensor and it added messages since the previous frame, the frame is
+      /// published.
+      /// \param[in] _sensor Name of the sensor.
+      /// \param[in] _time Time of the update.
+      /// \return True if a frame was published.
+      public: bool EndUpdate(const std::string &_sensor,
+                  const std::chrono::steady_clock::duration &_time);
+
+      /// \brief Get the number of frames published.
+      /// \return Number of frames.
+      public: uint64_t FrameCount() const;
+
+      /// \brief Get the number of messages dropped because MaxPending()
+      /// was reached.
+      /// \return Number of dropped messages.
+      public: uint64_t DroppedCount() const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \internal
+      /// \brief Data pointer for private data
+      private: std::unique_ptr<SensorBundlePrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
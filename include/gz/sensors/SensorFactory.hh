@@ -17,9 +17,17 @@
 #ifndef GZ_SENSORS_SENSORFACTORY_HH_
 #define GZ_SENSORS_SENSORFACTORY_HH_
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 #include <sdf/sdf.hh>
 
 #include <gz/common/Console.hh>
@@ -27,6 +35,7 @@
 
 #include <gz/sensors/config.hh>
 #include <gz/sensors/Export.hh>
+#include <gz/sensors/SensorPrototype.hh>
 
 #include "gz/sensors/Sensor.hh"
 
@@ -42,9 +51,9 @@ namespace gz
     /// \brief A factory class for creating sensors
     /// This class instantiates sensor objects based on the sensor type and
     /// makes sure they're initialized correctly.
-    // After removing plugin functionality, the sensor factory class doesn't
-    // hold any internal state. Consider converting the functionality in this
-    // class to helper functions.
+    // After removing plugin functionality, the sensor factory class only
+    // holds options applied to the sensors it creates. Consider converting
+    // the functionality in this class to helper functions.
     class GZ_SENSORS_VISIBLE SensorFactory
     {
       /// \brief Constructor
@@ -53,6 +62,77 @@ namespace gz
       /// \brief Destructor
       public: ~SensorFactory();
 
+      /// \brief Set whether sensors created by this factory hold back their
+      /// advertisements until Sensor::AdvertisePending() is called.
+      /// Disabled by default.
+      /// \param[in] _deferred True to defer advertisements.
+      /// \sa Sensor::SetAdvertiseDeferred
+      public: void SetAdvertiseDeferred(bool _deferred);
+
+      /// \brief Get whether sensors created by this factory defer their
+      /// advertisements.
+      /// \return True if advertisements are deferred.
+      public: bool AdvertiseDeferred() const;
+
+      /// \brief Function creating an unloaded sensor of a custom type.
+      public: using CustomSensorConstructor =
+                  std::function<std::unique_ptr<Sensor>()>;
+
+      /// \brief Register a custom sensor type, the value of the
+      /// `gz:type` attribute of `custom` sensors, so CreateCustomSensor()
+      /// creates its sensors. Registrations are shared by all factories and
+      /// managers.
+      /// \param[in] _type Custom sensor type.
+      /// \param[in] _constructor Creates a sensor of the type.
+      /// \return False if the type is empty, already registered or the
+      /// constructor is empty.
+      public: static bool RegisterCustomType(const std::string &_type,
+                  CustomSensorConstructor _constructor);
+
+      /// \brief Register a custom sensor type implemented by a class.
+      /// Types deriving from BatchSensor are updated in batches.
+      /// \sa RegisterCustomType(const std::string &, CustomSensorConstructor)
+      /// \param[in] _type Custom sensor type.
+      /// \tparam SensorType Sensor class, default constructible.
+      /// \return False if the type is empty or already registered.
+      public: template<typename SensorType>
+              static bool RegisterCustomType(const std::string &_type)
+              {
+                return RegisterCustomType(_type,
+                    []() -> std::unique_ptr<Sensor>
+                    {
+                      return std::make_unique<SensorType>();
+                    });
+              }
+
+      /// \brief Remove a custom sensor type. Sensors of the type that were
+      /// created are kept.
+      /// \param[in] _type Custom sensor type.
+      /// \return False if the type isn't registered.
+      public: static bool UnregisterCustomType(const std::string &_type);
+
+      /// \brief Get whether a custom sensor type is registered.
+      /// \param[in] _type Custom sensor type.
+      /// \return True if the type is registered.
+      public: static bool HasCustomType(const std::string &_type);
+
+      /// \brief Create a sensor of a registered custom type, loaded and
+      /// initialized as CreateSensor() does.
+      /// \param[in] _sdf SDF Sensor DOM object of a `custom` sensor.
+      /// \return A pointer to the created sensor. Null returned on error,
+      /// or if the custom type of the sensor isn't registered.
+      /// \sa customType
+      public: std::unique_ptr<Sensor> CreateCustomSensor(
+                  const sdf::Sensor &_sdf);
+
+      /// \brief Create a sensor of a registered custom type from an SDF
+      /// element.
+      /// \sa CreateCustomSensor(const sdf::Sensor &)
+      /// \param[in] _sdf pointer to the sdf element
+      /// \return A pointer to the created sensor. Null returned on error.
+      public: std::unique_ptr<Sensor> CreateCustomSensor(
+                  sdf::ElementPtr _sdf);
+
       /// \brief Create a sensor from a SDF DOM object with a known sensor type.
       ///
       ///   This creates sensors by looking at the given SDF DOM object.
@@ -76,6 +156,8 @@ namespace gz
                   return nullptr;
                 }
 
+                sensor->SetAdvertiseDeferred(this->AdvertiseDeferred());
+
                 if (!sensor->Load(_sdf))
                 {
                   gzerr << "Failed to load sensor [" << _sdf.Name()
@@ -121,6 +203,8 @@ namespace gz
                   return nullptr;
                 }
 
+                sensor->SetAdvertiseDeferred(this->AdvertiseDeferred());
+
                 if (!sensor->Load(_sdf))
                 {
                   gzerr << "Failed to load sensor [" << name
@@ -138,6 +222,97 @@ namespace gz
                 return sensor;
               }
 
+      /// \brief Create a sensor from a prototype.
+      /// \param[in] _prototype Description shared by identical sensors.
+      /// \param[in] _instance Name, topic and parent of the sensor.
+      /// \tparam SensorType Sensor type
+      /// \return A pointer to the created sensor. Null returned on error.
+      public: template<typename SensorType>
+              std::unique_ptr<SensorType> CreateSensor(
+                  const SensorPrototype &_prototype,
+                  const SensorInstance &_instance)
+              {
+                if (!_prototype.Valid())
+                {
+                  gzerr << "Failed to create sensor [" << _instance.name
+                         << "], invalid prototype." << std::endl;
+                  return nullptr;
+                }
+
+                auto sensor = this->CreateSensor<SensorType>(
+                    _prototype.Instance(_instance));
+                if (nullptr != sensor && !_instance.parent.empty())
+                  sensor->SetParent(_instance.parent);
+                return sensor;
+              }
+
+      /// \brief Create sensors of the same type in parallel.
+      ///
+      ///   Each sensor is loaded and initialized on one of the threads, as
+      ///   CreateSensor() would. Only sensor types whose Load() and Init()
+      ///   don't share state with other sensors may be created this way,
+      ///   which includes all the sensors of this library. Rendering sensors
+      ///   must not have a scene yet: their rendering objects are created
+      ///   later, when RenderingSensor::SetScene is called from the
+      ///   rendering thread.
+      /// \param[in] _sdfs SDF Sensor DOM objects or elements.
+      /// \param[in] _threadCount Number of threads, including the calling
+      /// one. Zero uses one thread per hardware thread.
+      /// \tparam SensorType Sensor type
+      /// \tparam SdfType `sdf::Sensor` or `sdf::ElementPtr`.
+      /// \return The created sensors, in the order of _sdfs. Sensors that
+      /// failed to be created are null.
+      public: template<typename SensorType, typename SdfType>
+              std::vector<std::unique_ptr<SensorType>> CreateSensors(
+                  const std::vector<SdfType> &_sdfs,
+                  unsigned int _threadCount = 0u)
+              {
+                std::vector<std::unique_ptr<SensorType>> sensors(
+                    _sdfs.size());
+                if (_threadCount == 0u)
+                {
+                  _threadCount =
+                      std::max(1u, std::thread::hardware_concurrency());
+                }
+                const std::size_t threadCount =
+                    std::min<std::size_t>(_threadCount, _sdfs.size());
+
+                std::atomic<std::size_t> next{0u};
+                auto work = [&]()
+                {
+                  for (std::size_t i = next++; i < _sdfs.size(); i = next++)
+                    sensors[i] = this->CreateSensor<SensorType>(_sdfs[i]);
+                };
+
+                std::vector<std::thread> threads;
+                for (std::size_t i = 1u; i < threadCount; ++i)
+                  threads.emplace_back(work);
+                work();
+                for (auto &thread : threads)
+                  thread.join();
+                return sensors;
+              }
+
+      /// \brief Create a sensor on a new thread.
+      /// \sa CreateSensors for the sensors that may be created this way.
+      /// \param[in] _sdf SDF Sensor DOM object or element, copied.
+      /// \tparam SensorType Sensor type
+      /// \tparam SdfType `sdf::Sensor` or `sdf::ElementPtr`.
+      /// \return Future of the created sensor, null on error.
+      public: template<typename SensorType, typename SdfType>
+              std::future<std::unique_ptr<SensorType>> CreateSensorAsync(
+                  SdfType _sdf)
+              {
+                return std::async(std::launch::async,
+                    [_sdf = std::move(_sdf),
+                     deferred = this->AdvertiseDeferred()]()
+                    {
+                      SensorFactory factory;
+                      factory.SetAdvertiseDeferred(deferred);
+                      return factory.CreateSensor<SensorType>(_sdf);
+                    });
+              }
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief private data pointer
       private: std::unique_ptr<SensorFactoryPrivate> dataPtr;
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SENSORPROTOTYPE_HH_
+#define GZ_SENSORS_SENSORPROTOTYPE_HH_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sdf/Element.hh>
+#include <sdf/Sensor.hh>
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class SensorPrototypePrivate;
+
+    /// \brief What differs between sensors created from the same
+    /// prototype.
+    struct SensorInstance
+    {
+      /// \brief Name of the sensor.
+      std::string name;
+
+      /// \brief Topic of the sensor. Empty keeps the prototype's topic.
+      std::string topic;
+
+      /// \brief Parent link of the sensor. Empty keeps no parent.
+      std::string parent;
+    };
+
+    /// \brief Description of a sensor that is parsed once and used to
+    /// create many identical sensors, such as the same sensor on every
+    /// robot of a fleet.
+    ///
+    /// Creating a sensor from an SDF element parses and validates the
+    /// element every time. A prototype parses it once, and each sensor is
+    /// loaded from a copy of the parsed description with its own name and
+    /// topic, see SensorFactory::CreateSensor and Manager::CreateSensors.
+    class GZ_SENSORS_VISIBLE SensorPrototype
+    {
+      /// \brief Constructor of an invalid prototype.
+      public: SensorPrototype();
+
+      /// \brief Constructor
+      /// \param[in] _sdf Parsed sensor description.
+      public: explicit SensorPrototype(const sdf::Sensor &_sdf);
+
+      /// \brief Constructor that parses an SDF element.
+      /// \param[in] _sdf Sensor element. The prototype is invalid if it's
+      /// null or has errors.
+      public: explicit SensorPrototype(sdf::ElementPtr _sdf);
+
+      /// \brief Destructor
+      public: ~SensorPrototype();
+
+      /// \brief Get whether the prototype has a valid description.
+      /// \return True if sensors can be created from it.
+      public: bool Valid() const;
+
+      /// \brief Get the parsed sensor description.
+      /// \return Sensor description.
+      public: const sdf::Sensor &Sdf() const;
+
+      /// \brief Get the description of one sensor.
+      /// \param[in] _instance Name and topic of the sensor.
+      /// \return Copy of the prototype's description with the name and
+      /// topic of _instance.
+      public: sdf::Sensor Instance(const SensorInstance &_instance) const;
+
+      /// \brief Get the descriptions of several sensors.
+      /// \param[in] _instances Names and topics of the sensors.
+      /// \return One description per instance, in the same order.
+      public: std::vector<sdf::Sensor> Instances(
+                  const std::vector<SensorInstance> &_instances) const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Data pointer for private data
+      /// \internal
+      private: std::unique_ptr<SensorPrototypePrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
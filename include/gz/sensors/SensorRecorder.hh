@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SENSORRECORDER_HH_
+#define GZ_SENSORS_SENSORRECORDER_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <google/protobuf/message.h>
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class SensorRecorderPrivate;
+
+    /// \brief Compression of the chunks of a SensorRecorder file.
+    enum class SensorRecorderCompression
+    {
+      /// \brief Chunks are stored uncompressed.
+      NONE = 0,
+
+      /// \brief Chunks are compressed to LZ4 frames.
+      LZ4 = 1
+    };
+
+    /// \brief Records the messages published by sensors to an MCAP file,
+    /// without going through gz-transport. Sensors hand every message they
+    /// publish to the recorder, which serializes it on the calling thread
+    /// and queues it for a background thread. That thread gathers the
+    /// messages in chunks, compresses them and writes them to the file.
+    /// Each topic and message type gets an MCAP channel with a protobuf
+    /// schema, so the file can be read by MCAP tools. Message times are the
+    /// simulation times of the sensor updates that produced them, in
+    /// nanoseconds. Record can be called from several threads.
+    /// \sa Manager::SetRecorder
+    /// \sa Sensor::SetRecorder
+    class GZ_SENSORS_VISIBLE SensorRecorder
+    {
+      /// \brief Constructor
+      public: SensorRecorder();
+
+      /// \brief Destructor. Closes the file.
+      public: ~SensorRecorder();
+
+      /// \brief Create a recording, replacing any existing file. A file
+      /// that is already open is closed first.
+      /// \param[in] _path Path of the file.
+      /// \return True on success.
+      public: bool Open(const std::string &_path);
+
+      /// \brief Write the queued messages, the summary of the recording and
+      /// close the file. Blocks until everything is written.
+      public: void Close();
+
+      /// \brief Get whether a recording is open.
+      /// \return True if a recording is open.
+      public: bool IsOpen() const;
+
+      /// \brief Set the compression of the chunks. It applies to the files
+      /// opened afterwards. Defaults to SensorRecorderCompression::LZ4.
+      /// \param[in] _compression Chunk compression.
+      public: void SetCompression(SensorRecorderCompression _compression);
+
+      /// \brief Get the compression of the chunks.
+      /// \return Chunk compression.
+      public: SensorRecorderCompression Compression() const;
+
+      /// \brief Set the number of uncompressed bytes after which a chunk is
+      /// written. Larger chunks compress better and smaller chunks bound how
+      /// much is lost on a crash. It applies to the files opened
+      /// afterwards. Defaults to 4 MiB.
+      /// \param[in] _size Chunk size in bytes.
+      public: void SetChunkSize(std::size_t _size);
+
+      /// \brief Get the number of uncompressed bytes after which a chunk is
+      /// written.
+      /// \return Chunk size in bytes.
+      public: std::size_t ChunkSize() const;
+
+      /// \brief Set the number of serialized bytes that can wait for the
+      /// background thread. Messages that don't fit are dropped, so a slow
+      /// disk never blocks the sensors. Defaults to 256 MiB.
+      /// \param[in] _size Queue size in bytes.
+      public: void SetQueueSize(std::size_t _size);
+
+      /// \brief Get the number of serialized bytes that can wait for the
+      /// background thread.
+      /// \return Queue size in bytes.
+      public: std::size_t QueueSize() const;
+
+      /// \brief Record a message.
+      /// \param[in] _topic Topic the message is published on.
+      /// \param[in] _msg Message to record.
+      /// \param[in] _time Simulation time of the message.
+      /// \return False if no recording is open or the queue is full.
+      public: bool Record(const std::string &_topic,
+                  const google::protobuf::Message &_msg,
+                  const std::chrono::steady_clock::duration &_time);
+
+      /// \brief Get the number of messages queued for the current file,
+      /// including the ones already written.
+      /// \return Number of recorded messages.
+      public: uint64_t RecordedCount() const;
+
+      /// \brief Get the number of messages dropped for the current file
+      /// because the queue was full.
+      /// \return Number of dropped messages.
+      public: uint64_t DroppedCount() const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \internal
+      /// \brief Data pointer for private data
+      private: std::unique_ptr<SensorRecorderPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SENSORREPLAY_HH_
+#define GZ_SENSORS_SENSORREPLAY_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gz/utils/SuppressWarning.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief forward declarations
+    class SensorReplayPrivate;
+
+    /// \brief Serves the messages of an MCAP file, such as one written by
+    /// SensorRecorder, keyed on their simulation time. Sensors given a
+    /// replay publish the recorded messages of their topics instead of
+    /// computing new ones, so rendering sensors don't render. Only
+    /// messages with a protobuf schema are served, unchanged and in time
+    /// order. Open indexes the file; messages are read back from it when
+    /// they're requested, a few decompressed chunks being kept in memory.
+    /// Messages can be requested from several threads.
+    /// \sa Manager::SetReplay
+    /// \sa Sensor::SetReplay
+    class GZ_SENSORS_VISIBLE SensorReplay
+    {
+      /// \brief Callback called with a recorded message.
+      /// \param[in] _type Full name of the protobuf message type.
+      /// \param[in] _data Serialized message.
+      public: using MessageCallback = std::function<void(
+                  const std::string &_type, const std::string &_data)>;
+
+      /// \brief Constructor
+      public: SensorReplay();
+
+      /// \brief Destructor
+      public: ~SensorReplay();
+
+      /// \brief Open a recording and index its messages. A file that is
+      /// already open is closed first.
+      /// \param[in] _path Path of the file.
+      /// \return False if the file can't be read or isn't an MCAP file.
+      public: bool Open(const std::string &_path);
+
+      /// \brief Close the recording.
+      public: void Close();
+
+      /// \brief Get whether a recording is open.
+      /// \return True if a recording is open.
+      public: bool IsOpen() const;
+
+      /// \brief Get the topics of the recording that have messages.
+      /// \return Topic names, sorted.
+      public: std::vector<std::string> Topics() const;
+
+      /// \brief Get the number of messages of a topic.
+      /// \param[in] _topic Topic name.
+      /// \return Number of messages, 0 for unknown topics.
+      public: std::size_t MessageCount(const std::string &_topic) const;
+
+      /// \brief Call a callback with the messages of a topic whose time is
+      /// after _after and not after _until, in time order.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _after Messages at this time or earlier are skipped.
+      /// \param[in] _until Messages after this time are skipped.
+      /// \param[in] _callback Called with each message.
+      /// \return Number of messages the callback was called with.
+      public: std::size_t Messages(const std::string &_topic,
+                  const std::chrono::steady_clock::duration &_after,
+                  const std::chrono::steady_clock::duration &_until,
+                  const MessageCallback &_callback) const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \internal
+      /// \brief Data pointer for private data
+      private: std::unique_ptr<SensorReplayPrivate> dataPtr;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+    };
+    }
+  }
+}
+
+#endif
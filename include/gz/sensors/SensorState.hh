@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SENSORSTATE_HH_
+#define GZ_SENSORS_SENSORSTATE_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <gz/math/Pose3.hh>
+#include <gz/math/Quaternion.hh>
+#include <gz/math/Vector3.hh>
+
+#include <gz/sensors/config.hh>
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Snapshot of the mutable state of a sensor, see
+    /// Sensor::SaveState. Values are stored back to back in host byte
+    /// order, and read back in the order they were written. Clear() keeps
+    /// the memory, so saving the same sensor again doesn't allocate.
+    class SensorState
+    {
+      /// \brief Forget the stored values, keeping the memory.
+      public: void Clear()
+      {
+        this->data.clear();
+        this->offset = 0u;
+      }
+
+      /// \brief Move the read position back to the first value.
+      public: void Rewind()
+      {
+        this->offset = 0u;
+      }
+
+      /// \brief Get the number of stored bytes.
+      /// \return Size of the state in bytes.
+      public: std::size_t Size() const
+      {
+        return this->data.size();
+      }
+
+      /// \brief Check whether every value was read.
+      /// \return True if the read position is at the end.
+      public: bool AtEnd() const
+      {
+        return this->offset == this->data.size();
+      }
+
+      /// \brief Append bytes.
+      /// \param[in] _data Bytes to append.
+      /// \param[in] _size Number of bytes.
+      public: void WriteBytes(const void *_data, std::size_t _size)
+      {
+        const std::size_t start = this->data.size();
+        this->data.resize(start + _size);
+        if (_size > 0u)
+          std::memcpy(this->data.data() + start, _data, _size);
+      }
+
+      /// \brief Read bytes at the read position.
+      /// \param[out] _data Buffer of _size bytes.
+      /// \param[in] _size Number of bytes.
+      /// \return False if fewer than _size bytes are left.
+      public: bool ReadBytes(void *_data, std::size_t _size)
+      {
+        const unsigned char *bytes = this->ReadView(_size);
+        if (!bytes)
+          return false;
+        if (_size > 0u)
+          std::memcpy(_data, bytes, _size);
+        return true;
+      }
+
+      /// \brief Get the bytes at the read position without copying them,
+      /// and move past them.
+      /// \param[in] _size Number of bytes.
+      /// \return Pointer to the bytes, null if fewer than _size are left.
+      public: const unsigned char *ReadView(std::size_t _size)
+      {
+        if (_size > this->data.size() - this->offset)
+          return nullptr;
+        const unsigned char *bytes = this->data.data() + this->offset;
+        this->offset += _size;
+        return bytes;
+      }
+
+      /// \brief Append a value.
+      /// \param[in] _value Value, of a trivially copyable type.
+      public: template <typename T>
+              void Write(const T &_value)
+      {
+        static_assert(std::is_trivially_copyable_v<T>,
+            "Only trivially copyable values can be written");
+        this->WriteBytes(&_value, sizeof(T));
+      }
+
+      /// \brief Read a value.
+      /// \param[out] _value Value, of a trivially copyable type.
+      /// \return False if the state is too short.
+      public: template <typename T>
+              bool Read(T &_value)
+      {
+        static_assert(std::is_trivially_copyable_v<T>,
+            "Only trivially copyable values can be read");
+        return this->ReadBytes(&_value, sizeof(T));
+      }
+
+      /// \brief Append a vector.
+      /// \param[in] _value Vector.
+      public: void Write(const math::Vector3d &_value)
+      {
+        this->Write(_value.X());
+        this->Write(_value.Y());
+        this->Write(_value.Z());
+      }
+
+      /// \brief Read a vector.
+      /// \param[out] _value Vector.
+      /// \return False if the state is too short.
+      public: bool Read(math::Vector3d &_value)
+      {
+        double v[3];
+        if (!this->ReadBytes(v, sizeof(v)))
+          return false;
+        _value.Set(v[0], v[1], v[2]);
+        return true;
+      }
+
+      /// \brief Append a quaternion.
+      /// \param[in] _value Quaternion.
+      public: void Write(const math::Quaterniond &_value)
+      {
+        this->Write(_value.W());
+        this->Write(_value.X());
+        this->Write(_value.Y());
+        this->Write(_value.Z());
+      }
+
+      /// \brief Read a quaternion.
+      /// \param[out] _value Quaternion.
+      /// \return False if the state is too short.
+      public: bool Read(math::Quaterniond &_value)
+      {
+        double v[4];
+        if (!this->ReadBytes(v, sizeof(v)))
+          return false;
+        _value.Set(v[0], v[1], v[2], v[3]);
+        return true;
+      }
+
+      /// \brief Append a pose.
+      /// \param[in] _value Pose.
+      public: void Write(const math::Pose3d &_value)
+      {
+        this->Write(_value.Pos());
+        this->Write(_value.Rot());
+      }
+
+      /// \brief Read a pose.
+      /// \param[out] _value Pose.
+      /// \return False if the state is too short.
+      public: bool Read(math::Pose3d &_value)
+      {
+        math::Vector3d pos;
+        math::Quaterniond rot;
+        if (!this->Read(pos) || !this->Read(rot))
+          return false;
+        _value.Set(pos, rot);
+        return true;
+      }
+
+      /// \brief Append a vector of trivially copyable values, preceded by
+      /// its size.
+      /// \param[in] _values Values.
+      public: template <typename T>
+              void WriteVector(const std::vector<T> &_values)
+      {
+        this->Write(static_cast<uint64_t>(_values.size()));
+        this->WriteBytes(_values.data(), _values.size() * sizeof(T));
+      }
+
+      /// \brief Read a vector written by WriteVector. It's only
+      /// reallocated if its capacity is too small.
+      /// \param[out] _values Values.
+      /// \return False if the state is too short.
+      public: template <typename T>
+              bool ReadVector(std::vector<T> &_values)
+      {
+        uint64_t size{0u};
+        if (!this->Read(size) ||
+            size > (this->data.size() - this->offset) / sizeof(T))
+        {
+          return false;
+        }
+        _values.resize(static_cast<std::size_t>(size));
+        return this->ReadBytes(_values.data(), _values.size() * sizeof(T));
+      }
+
+      /// \brief Stored bytes.
+      private: std::vector<unsigned char> data;
+
+      /// \brief Read position.
+      private: std::size_t offset{0u};
+    };
+    }
+  }
+}
+
+#endif
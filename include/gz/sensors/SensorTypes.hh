@@ -17,6 +17,7 @@
 #ifndef GZ_SENSORS_SENSORTYPES_HH_
 #define GZ_SENSORS_SENSORTYPES_HH_
 
+#include <array>
 #include <vector>
 #include <memory>
 
@@ -215,6 +216,11 @@ namespace gz
       SENSOR_NOISE_TYPE_END
     };
 
+    /// \def NoiseTable
+    /// \brief Noise models of a sensor, indexed by SensorNoiseType, with
+    /// SENSOR_NOISE_TYPE_END entries. Types without a model hold null.
+    typedef std::array<NoisePtr, SENSOR_NOISE_TYPE_END> NoiseTable;
+
 
     /// \def SensorDistortionType
     /// \brief Eumeration of all sensor noise types
@@ -258,6 +264,45 @@ namespace gz
       /// \brief Number of Sensor Categories
       CATEGORY_COUNT = 3
     };
+
+    /// \brief Filters of the output stage of a sensor, applied to each
+    /// output after noise.
+    enum class SignalFilterType
+    {
+      /// \brief Outputs aren't filtered.
+      NONE = 0,
+
+      /// \brief Mean of the last window samples.
+      MOVING_AVERAGE = 1,
+
+      /// \brief Second order Butterworth low-pass filter, a biquad.
+      BUTTERWORTH = 2
+    };
+
+    /// \brief Options of the output filter stage of a sensor. The stage
+    /// runs at the rate the sensor is updated, so sensors updated at the
+    /// physics rate filter every step, and only outputs one filtered sample
+    /// out of decimation.
+    struct SignalFilterOptions
+    {
+      /// \brief Filter.
+      SignalFilterType type{SignalFilterType::NONE};
+
+      /// \brief Number of samples averaged by MOVING_AVERAGE, at least 1.
+      unsigned int window{4u};
+
+      /// \brief Cutoff frequency of BUTTERWORTH in Hz, below half the
+      /// sample rate.
+      double cutoffFrequency{0.0};
+
+      /// \brief Rate samples are filtered at in Hz. 0 uses the update
+      /// rate of the sensor, which must then be set for BUTTERWORTH.
+      double sampleRate{0.0};
+
+      /// \brief Output every decimation-th filtered sample, at least 1.
+      /// The other samples update the filter without being published.
+      unsigned int decimation{1u};
+    };
     }
   }
 }
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SHAREDMEMORYIMAGE_HH_
+#define GZ_SENSORS_SHAREDMEMORYIMAGE_HH_
+
+#include <atomic>
+#include <cstdint>
+
+#include <gz/sensors/config.hh>
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Layout of the shared memory segments written by rendering
+    /// sensors with shared memory output enabled.
+    /// \sa RenderingSensor::SetSharedMemoryOutput
+    ///
+    /// A segment starts with a SharedMemoryImageHeader, followed by
+    /// SharedMemoryImageHeader::slotCount slots of
+    /// SharedMemoryImageHeader::slotSize bytes each. Every slot starts
+    /// with a SharedMemoryImageSlot, directly followed by the pixels.
+    ///
+    /// Frames are written to the slots in turn. Each slot is guarded by a
+    /// sequence counter which is odd while the slot is being written. A
+    /// reader copies the pixels out of a slot, then checks that the
+    /// sequence is still the one announced by the descriptor message, and
+    /// discards the copy otherwise.
+    ///
+    /// The segment is recreated with a larger slot size if a frame doesn't
+    /// fit, in which case magic is cleared in the old segment. Readers
+    /// should reopen the segment when magic no longer matches.
+    struct alignas(64) SharedMemoryImageHeader
+    {
+      /// \brief Value of magic for a valid segment.
+      static constexpr uint32_t kMagic = 0x475a5349u;
+
+      /// \brief Version of the layout.
+      static constexpr uint32_t kVersion = 1u;
+
+      /// \brief Set to kMagic once the segment has been initialized.
+      uint32_t magic;
+
+      /// \brief Layout version, kVersion.
+      uint32_t version;
+
+      /// \brief Number of slots in the segment.
+      uint32_t slotCount;
+
+      /// \brief Unused, zero.
+      uint32_t reserved;
+
+      /// \brief Size of a slot in bytes, including its
+      /// SharedMemoryImageSlot.
+      uint64_t slotSize;
+
+      /// \brief Number of frames written so far. The latest frame is in
+      /// slot (frameCount - 1) % slotCount.
+      std::atomic<uint64_t> frameCount;
+    };
+
+    /// \brief Header of a slot in a shared memory image segment.
+    /// \sa SharedMemoryImageHeader
+    struct alignas(64) SharedMemoryImageSlot
+    {
+      /// \brief Sequence counter, odd while the slot is being written.
+      std::atomic<uint64_t> sequence;
+
+      /// \brief Image width in pixels.
+      uint32_t width;
+
+      /// \brief Image height in pixels.
+      uint32_t height;
+
+      /// \brief Size of a row in bytes.
+      uint32_t step;
+
+      /// \brief Pixel format, a msgs::PixelFormatType value.
+      uint32_t pixelFormat;
+
+      /// \brief Seconds of the frame stamp.
+      int64_t sec;
+
+      /// \brief Nanoseconds of the frame stamp.
+      int32_t nsec;
+
+      /// \brief Unused, zero.
+      uint32_t reserved;
+
+      /// \brief Number of pixel bytes following this header.
+      uint64_t size;
+    };
+    }
+  }
+}
+
+#endif
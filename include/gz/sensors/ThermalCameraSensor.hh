@@ -53,6 +53,19 @@ namespace gz
     // forward declarations
     class ThermalCameraSensorPrivate;
 
+    /// \brief Colormaps of the false color thermal images.
+    enum class ThermalColormap
+    {
+      /// \brief Black to white.
+      GRAYSCALE = 0,
+
+      /// \brief Black through purple, red, orange and yellow to white.
+      IRONBOW = 1,
+
+      /// \brief Blue through cyan, green and yellow to red.
+      RAINBOW = 2
+    };
+
     /// \brief Thermal camera sensor class.
     ///
     /// This class creates thermal image from a Gazebo Rendering scene.
@@ -152,9 +165,62 @@ namespace gz
       /// \param[in] _resolution Temperature linear resolution
       public: virtual void SetLinearResolution(float _resolution);
 
+      /// \brief Set the temperature of a visual, through its "temperature"
+      /// user data read by the thermal camera. Temperatures are kept by the
+      /// sensor and only the ones that changed are written to their visuals
+      /// at the start of the next update. Setting the same temperature
+      /// again costs nothing. A visual that isn't in the scene yet gets its
+      /// temperature once it's added, and every temperature is written
+      /// again when the scene changes.
+      /// \param[in] _visual Name of the visual.
+      /// \param[in] _temperature Temperature in kelvin.
+      public: void SetEntityTemperature(const std::string &_visual,
+                  float _temperature);
+
+      /// \brief Set the heat signature of a visual, a texture whose
+      /// pixel intensities map to temperatures between a min and a max.
+      /// It's written to the "temperature", "minTemp" and "maxTemp" user
+      /// data of the visual like SetEntityTemperature. The texture path is
+      /// resolved once per texture, so the visuals sharing a heat signature
+      /// share its texture.
+      /// \param[in] _visual Name of the visual.
+      /// \param[in] _texture Heat signature texture, a path or a file name
+      /// found in the resource paths.
+      /// \param[in] _min Temperature of the black pixels in kelvin.
+      /// \param[in] _max Temperature of the white pixels in kelvin.
+      public: void SetEntityHeatSignature(const std::string &_visual,
+                  const std::string &_texture, float _min, float _max);
+
+      /// \brief Get the number of entity temperatures not written to their
+      /// visuals yet, because they changed since the last update or their
+      /// visual isn't in the scene.
+      /// \return Number of pending entity temperatures.
+      /// \sa SetEntityTemperature
+      public: std::size_t PendingEntityTemperatureCount() const;
+
+      /// \brief Set the colormap of the false color images.
+      /// \param[in] _colormap Colormap. Defaults to IRONBOW.
+      /// \sa ColormapTopic
+      public: void SetColormap(ThermalColormap _colormap);
+
+      /// \brief Get the colormap of the false color images.
+      /// \return Colormap.
+      public: ThermalColormap Colormap() const;
+
+      /// \brief Get the topic of the false color images, the sensor topic
+      /// followed by "/colormap". Each image is a RGB_INT8 msgs::Image laid
+      /// out like the thermal images, with every frame scaled between its
+      /// coldest and hottest pixels. Images are only generated while the
+      /// topic has subscribers.
+      /// \return Topic of the false color images.
+      public: std::string ColormapTopic() const;
+
       // Documentation inherited.
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited.
+      public: SensorMemoryUsage MemoryUsage() const override;
+
       /// \brief Create a camera in a scene
       /// \return True on success.
       private: bool CreateCamera();
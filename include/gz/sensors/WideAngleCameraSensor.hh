@@ -17,6 +17,7 @@
 #ifndef GZ_SENSORS_WIDEANGLECAMERASENSOR_HH_
 #define GZ_SENSORS_WIDEANGLECAMERASENSOR_HH_
 
+#include <chrono>
 #include <memory>
 #include <cstdint>
 #include <string>
@@ -134,10 +135,72 @@ namespace gz
       // Documentation inherited.
       public: virtual bool HasConnections() const override;
 
+      // Documentation inherited.
+      public: SensorMemoryUsage MemoryUsage() const override;
+
+      /// \brief Set whether the cubemap faces are updated progressively
+      /// across frames, for scenes that change slowly. Six cameras render
+      /// the faces, a few of them per frame in turn, and the image is
+      /// stitched on the CPU from the latest render of each face, through
+      /// a lookup table built from the lens. A face older than the
+      /// staleness limit on the next frame is rendered on top of the
+      /// faces in turn, so a zero limit renders every face every frame.
+      /// The time each face was rendered is in the `face_stamps` entry of
+      /// the image header, in nanoseconds, for the faces facing +X, -X,
+      /// +Y, -Y, +Z and -Z of the sensor frame. Images are only published
+      /// once every face was rendered. Image noise only applies if it's
+      /// applied on the CPU. Disabled by default.
+      /// \param[in] _enabled True to update the faces progressively.
+      /// \param[in] _facesPerFrame Number of faces rendered in turn per
+      /// frame, between 1 and 6.
+      /// \param[in] _staleness Longest time a face goes without being
+      /// rendered.
+      /// \return False if the sensor isn't loaded or the number of faces
+      /// is out of range.
+      public: bool SetProgressiveUpdate(bool _enabled,
+                  unsigned int _facesPerFrame = 1u,
+                  const std::chrono::steady_clock::duration &_staleness =
+                  std::chrono::seconds(1));
+
+      /// \brief Get whether the cubemap faces are updated progressively.
+      /// \return True if enabled.
+      /// \sa SetProgressiveUpdate
+      public: bool ProgressiveUpdate() const;
+
+      /// \brief Get the number of faces rendered in turn per frame when
+      /// they're updated progressively.
+      /// \return Number of faces.
+      /// \sa SetProgressiveUpdate
+      public: unsigned int ProgressiveFacesPerFrame() const;
+
+      /// \brief Get the longest time a face goes without being rendered
+      /// when they're updated progressively.
+      /// \return Staleness limit.
+      /// \sa SetProgressiveUpdate
+      public: std::chrono::steady_clock::duration ProgressiveStaleness()
+                  const;
+
+      // Documentation inherited.
+      protected: bool HasRegionOfInterestSupport() const override;
+
       /// \brief Create a camera in a scene
       /// \return True on success.
       private: bool CreateCamera();
 
+      /// \brief Create the cameras of the cubemap faces if they're needed,
+      /// destroy them otherwise. The wide angle camera is only rendered
+      /// when they don't exist.
+      /// \param[in] _needed True if the faces are updated progressively.
+      /// \return True if the face cameras exist.
+      private: bool UpdateFaceCameras(bool _needed);
+
+      /// \brief Render the faces scheduled for this frame, schedule the
+      /// faces of the next one and stitch the image.
+      /// \param[in] _now The current time
+      /// \return True if the image was stitched.
+      private: bool RenderFaces(
+                  const std::chrono::steady_clock::duration &_now);
+
       GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
       /// \brief Data pointer for private data
       /// \internal
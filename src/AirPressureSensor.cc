@@ -14,6 +14,8 @@
  * limitations under the License.
  *
 */
+#include <memory>
+#include <utility>
 
 #if defined(_MSC_VER)
   #pragma warning(push)
@@ -38,19 +40,6 @@
 using namespace gz;
 using namespace sensors;
 
-// Constants. These constants from from RotorS:
-// https://github.com/ethz-asl/rotors_simulator/blob/master/rotors_gazebo_plugins/include/rotors_gazebo_plugins/gazebo_pressure_plugin.h
-static constexpr double kGasConstantNmPerKmolKelvin = 8314.32;
-static constexpr double kMeanMolecularAirWeightKgPerKmol = 28.9644;
-static constexpr double kGravityMagnitude = 9.80665;
-static constexpr double kEarthRadiusMeters = 6356766.0;
-static constexpr double kPressureOneAtmospherePascals = 101325.0;
-static constexpr double kSeaLevelTempKelvin = 288.15;
-static constexpr double kTempLapseKelvinPerMeter = 0.0065;
-static constexpr double kAirConstantDimensionless = kGravityMagnitude *
-    kMeanMolecularAirWeightKgPerKmol /
-        (kGasConstantNmPerKmolKelvin * -kTempLapseKelvinPerMeter);
-
 /// \brief Private data for AirPressureSensor
 class gz::sensors::AirPressureSensorPrivate
 {
@@ -60,6 +49,9 @@ class gz::sensors::AirPressureSensorPrivate
   /// \brief publisher to publish air pressure messages.
   public: transport::Node::Publisher pub;
 
+  /// \brief Message reused by every update.
+  public: msgs::FluidPressure msg;
+
   /// \brief true if Load() has been called and was successful
   public: bool initialized = false;
 
@@ -70,7 +62,10 @@ class gz::sensors::AirPressureSensorPrivate
   public: double referenceAltitude = 0.0;
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief Table to look up the pressure in, null to evaluate the model.
+  public: std::shared_ptr<const AtmosphereTable> atmosphere;
 };
 
 //////////////////////////////////////////////////
@@ -113,11 +108,8 @@ bool AirPressureSensor::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/air_pressure");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<msgs::FluidPressure>(
-      this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<msgs::FluidPressure>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic[" << this->Topic() << "].\n";
     return false;
@@ -131,8 +123,20 @@ bool AirPressureSensor::Load(const sdf::Sensor &_sdf)
   {
     this->dataPtr->noises[AIR_PRESSURE_NOISE_PASCALS] =
       NoiseFactory::NewNoiseModel(_sdf.AirPressureSensor()->PressureNoise());
+
+    // The variance doesn't change between updates
+    if (this->dataPtr->noises[AIR_PRESSURE_NOISE_PASCALS]->Type() ==
+        NoiseType::GAUSSIAN)
+    {
+      GaussianNoiseModelPtr gaussian =
+        std::dynamic_pointer_cast<GaussianNoiseModel>(
+            this->dataPtr->noises[AIR_PRESSURE_NOISE_PASCALS]);
+      this->dataPtr->msg.set_variance(sqrt(gaussian->StdDev()));
+    }
   }
 
+  this->RegisterNoise(this->dataPtr->noises);
+
   this->dataPtr->initialized = true;
   return true;
 }
@@ -156,59 +160,45 @@ bool AirPressureSensor::Update(
     return false;
   }
 
-  msgs::FluidPressure msg;
-  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-  auto frame = msg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->FrameId());
-
-  // This block of code comes from RotorS:
-  // https://github.com/ethz-asl/rotors_simulator/blob/master/rotors_gazebo_plugins/src/gazebo_pressure_plugin.cpp
-  {
-    // Get the current height.
-    double height = this->dataPtr->referenceAltitude + this->Pose().Pos().Z();
+  auto &msg = this->dataPtr->msg;
+  this->FillHeader(msg.mutable_header(), _now);
 
-    // Compute the geopotential height.
-    double geoHeight = kEarthRadiusMeters * height /
-      (kEarthRadiusMeters + height);
-
-    // Compute the temperature at the current altitude in Kelvin.
-    double tempAtHeight =
-      kSeaLevelTempKelvin - kTempLapseKelvinPerMeter * geoHeight;
-
-    // Compute the current air pressure.
-    this->dataPtr->pressure =
-      kPressureOneAtmospherePascals * exp(kAirConstantDimensionless *
-          log(kSeaLevelTempKelvin / tempAtHeight));
-  }
+  // Get the current height.
+  const double height =
+    this->dataPtr->referenceAltitude + this->Pose().Pos().Z();
+  this->dataPtr->pressure = this->dataPtr->atmosphere ?
+    this->dataPtr->atmosphere->Lookup(height).pressure :
+    AtmosphereTable::Evaluate(height).pressure;
 
   // Apply pressure noise
-  if (this->dataPtr->noises.find(AIR_PRESSURE_NOISE_PASCALS) !=
-      this->dataPtr->noises.end())
+  if (this->dataPtr->noises[AIR_PRESSURE_NOISE_PASCALS])
   {
     this->dataPtr->pressure =
       this->dataPtr->noises[AIR_PRESSURE_NOISE_PASCALS]->Apply(
           this->dataPtr->pressure);
-
-    if (this->dataPtr->noises[AIR_PRESSURE_NOISE_PASCALS]->Type() ==
-        NoiseType::GAUSSIAN)
-    {
-     GaussianNoiseModelPtr gaussian =
-       std::dynamic_pointer_cast<GaussianNoiseModel>(
-           this->dataPtr->noises[AIR_PRESSURE_NOISE_PASCALS]);
-      msg.set_variance(sqrt(gaussian->StdDev()));
-    }
   }
 
   msg.set_pressure(this->dataPtr->pressure);
 
   // publish
-  this->AddSequence(msg.mutable_header());
-  this->dataPtr->pub.Publish(msg);
+  this->Publish(this->dataPtr->pub, msg);
 
   return true;
 }
 
+//////////////////////////////////////////////////
+void AirPressureSensor::SetAtmosphere(
+    std::shared_ptr<const AtmosphereTable> _table)
+{
+  this->dataPtr->atmosphere = std::move(_table);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const AtmosphereTable> AirPressureSensor::Atmosphere() const
+{
+  return this->dataPtr->atmosphere;
+}
+
 //////////////////////////////////////////////////
 void AirPressureSensor::SetReferenceAltitude(double _reference)
 {
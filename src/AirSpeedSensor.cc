@@ -15,6 +15,8 @@
  *
 */
 
+#include <utility>
+
 #if defined(_MSC_VER)
   #pragma warning(push)
   #pragma warning(disable: 4005)
@@ -59,6 +61,9 @@ class gz::sensors::AirSpeedSensorPrivate
   /// \brief publisher to publish air speed messages.
   public: transport::Node::Publisher pub;
 
+  /// \brief Air speed message, reused by every update.
+  public: msgs::AirSpeed msg;
+
   /// \brief true if Load() has been called and was successful
   public: bool initialized = false;
 
@@ -69,7 +74,11 @@ class gz::sensors::AirSpeedSensorPrivate
   public: gz::math::Vector3d vel;
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief Table to look up the air density and
+  /// temperature in, null to evaluate the model.
+  public: std::shared_ptr<const AtmosphereTable> atmosphere;
 };
 
 //////////////////////////////////////////////////
@@ -112,11 +121,8 @@ bool AirSpeedSensor::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/air_speed");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<msgs::AirSpeed>(
-      this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<msgs::AirSpeed>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic[" << this->Topic() << "].\n";
     return false;
@@ -132,6 +138,8 @@ bool AirSpeedSensor::Load(const sdf::Sensor &_sdf)
       NoiseFactory::NewNoiseModel(_sdf.AirSpeedSensor()->PressureNoise());
   }
 
+  this->RegisterNoise(this->dataPtr->noises);
+
   this->dataPtr->initialized = true;
   return true;
 }
@@ -155,19 +163,29 @@ bool AirSpeedSensor::Update(
     return false;
   }
 
-  msgs::AirSpeed msg;
-  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-  auto frame = msg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->FrameId());
+  auto &msg = this->dataPtr->msg;
+  this->FillHeader(msg.mutable_header(), _now);
 
   // compute the air density at the local altitude / temperature
   // Z-component from ENU
   const float alt_rel = static_cast<float>(this->Pose().Pos().Z());
   const float alt_amsl = kDefaultHomeAltAmsl + alt_rel;
-  const float temperature_local = kTemperaturMsl - kLapseRate * alt_amsl;
-  const float density_ratio = powf(kTemperaturMsl / temperature_local , 4.256f);
-  const float air_density = kAirDensityMsl / density_ratio;
+  float temperature_local;
+  float air_density;
+  if (this->dataPtr->atmosphere)
+  {
+    const AtmosphereSample sample =
+      this->dataPtr->atmosphere->Lookup(alt_amsl);
+    temperature_local = static_cast<float>(sample.temperature);
+    air_density = static_cast<float>(sample.density);
+  }
+  else
+  {
+    temperature_local = kTemperaturMsl - kLapseRate * alt_amsl;
+    const float density_ratio =
+      powf(kTemperaturMsl / temperature_local , 4.256f);
+    air_density = kAirDensityMsl / density_ratio;
+  }
 
   math::Vector3d wind_vel_{0, 0, 0};
   math::Quaterniond veh_q_world_to_body = this->Pose().Rot();
@@ -179,8 +197,7 @@ bool AirSpeedSensor::Update(
     * air_vel_in_body_.X() * air_vel_in_body_.X();
 
   // Apply pressure noise
-  if (this->dataPtr->noises.find(AIR_SPEED_NOISE_PASCALS) !=
-      this->dataPtr->noises.end())
+  if (this->dataPtr->noises[AIR_SPEED_NOISE_PASCALS])
   {
     diff_pressure =
       this->dataPtr->noises[AIR_SPEED_NOISE_PASCALS]->Apply(
@@ -191,8 +208,7 @@ bool AirSpeedSensor::Update(
   msg.set_temperature(temperature_local);
 
   // publish
-  this->AddSequence(msg.mutable_header());
-  this->dataPtr->pub.Publish(msg);
+  this->Publish(this->dataPtr->pub, msg);
 
   return true;
 }
@@ -209,6 +225,19 @@ void AirSpeedSensor::SetVelocity(const gz::math::Vector3d &_vel)
   this->dataPtr->vel = _vel;
 }
 
+//////////////////////////////////////////////////
+void AirSpeedSensor::SetAtmosphere(
+    std::shared_ptr<const AtmosphereTable> _table)
+{
+  this->dataPtr->atmosphere = std::move(_table);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const AtmosphereTable> AirSpeedSensor::Atmosphere() const
+{
+  return this->dataPtr->atmosphere;
+}
+
 //////////////////////////////////////////////////
 bool AirSpeedSensor::HasConnections() const
 {
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_ALIGNEDBUFFER_HH_
+#define GZ_SENSORS_ALIGNEDBUFFER_HH_
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+#include "gz/sensors/config.hh"
+#include "BufferMemory.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Frame buffer of trivially copyable values aligned for SIMD
+    /// loads. Storage is only reallocated when the buffer grows beyond its
+    /// capacity. Sensors reserve the capacity of a frame when the camera is
+    /// created or an output is connected, so that resizing the buffer in a
+    /// frame callback doesn't allocate. A resolution change reallocates it.
+    /// The storage can be made of huge pages or pinned memory, see
+    /// AllocateBufferMemory.
+    template <typename T>
+    class AlignedBuffer
+    {
+      static_assert(std::is_trivially_copyable<T>::value,
+          "AlignedBuffer only holds trivially copyable values");
+
+      /// \brief Alignment of the storage in bytes, a cache line.
+      public: static constexpr std::size_t kAlignment = kBufferAlignment;
+
+      /// \brief Set the kind of memory of the next allocations. The current
+      /// storage is kept until the buffer grows beyond its capacity.
+      /// \param[in] _memory Kind of memory.
+      public: void SetMemory(SensorBufferMemory _memory)
+      {
+        this->memory = _memory;
+      }
+
+      /// \brief Get the kind of memory of the next allocations.
+      /// \return Requested kind of memory.
+      public: SensorBufferMemory Memory() const
+      {
+        return this->memory;
+      }
+
+      /// \brief Get the kind of memory of the current storage, which falls
+      /// back to DEFAULT when the requested kind isn't available.
+      /// \return Kind of memory allocated, DEFAULT if nothing was reserved.
+      public: SensorBufferMemory AllocatedMemory() const
+      {
+        return this->storage.get_deleter().memory;
+      }
+
+      /// \brief Make sure _count values fit without reallocating. The size
+      /// is unchanged, and so are the values if no allocation is needed.
+      /// \param[in] _count Number of values.
+      public: void Reserve(std::size_t _count)
+      {
+        if (_count <= this->capacity)
+          return;
+        this->storage.reset();
+        SensorBufferMemory allocated = this->memory;
+        T *data = static_cast<T *>(
+            AllocateBufferMemory(_count * sizeof(T), allocated));
+        this->storage = Storage(data, Deleter{_count * sizeof(T), allocated});
+        this->capacity = _count;
+      }
+
+      /// \brief Set the number of values. Growing beyond the capacity
+      /// reallocates, which discards the previous values.
+      /// \param[in] _count Number of values.
+      public: void Resize(std::size_t _count)
+      {
+        this->Reserve(_count);
+        this->size = _count;
+      }
+
+      /// \brief Get the values.
+      /// \return Pointer to the values, null if nothing was reserved.
+      public: T *Data()
+      {
+        return this->storage.get();
+      }
+
+      /// \brief Get the values.
+      /// \return Pointer to the values, null if nothing was reserved.
+      public: const T *Data() const
+      {
+        return this->storage.get();
+      }
+
+      /// \brief Get the number of values.
+      /// \return Number of values.
+      public: std::size_t Size() const
+      {
+        return this->size;
+      }
+
+      /// \brief Get whether the buffer holds no value. A reserved buffer is
+      /// empty until it's resized.
+      /// \return True if the size is zero.
+      public: bool Empty() const
+      {
+        return this->size == 0u;
+      }
+
+      /// \brief Get the number of values that fit without reallocating.
+      /// \return Capacity of the buffer.
+      public: std::size_t Capacity() const
+      {
+        return this->capacity;
+      }
+
+      /// \brief Frees storage returned by AllocateBufferMemory.
+      private: struct Deleter
+      {
+        void operator()(T *_data) const
+        {
+          FreeBufferMemory(_data, this->bytes, this->memory);
+        }
+
+        /// \brief Size of the storage in bytes.
+        std::size_t bytes{0u};
+
+        /// \brief Kind of memory of the storage.
+        SensorBufferMemory memory{SensorBufferMemory::DEFAULT};
+      };
+
+      /// \brief Owner of the storage.
+      private: using Storage = std::unique_ptr<T[], Deleter>;
+
+      /// \brief Storage of the values.
+      private: Storage storage;
+
+      /// \brief Kind of memory of the next allocations.
+      private: SensorBufferMemory memory{SensorBufferMemory::DEFAULT};
+
+      /// \brief Number of values.
+      private: std::size_t size{0u};
+
+      /// \brief Number of values that fit in the storage.
+      private: std::size_t capacity{0u};
+    };
+    }
+  }
+}
+
+#endif
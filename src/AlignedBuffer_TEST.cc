@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "AlignedBuffer.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(AlignedBuffer, Empty)
+{
+  AlignedBuffer<float> buffer;
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_EQ(0u, buffer.Size());
+  EXPECT_EQ(0u, buffer.Capacity());
+  EXPECT_EQ(nullptr, buffer.Data());
+}
+
+//////////////////////////////////////////////////
+TEST(AlignedBuffer, Reserve)
+{
+  AlignedBuffer<uint16_t> buffer;
+  buffer.Reserve(100u);
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_EQ(100u, buffer.Capacity());
+  uint16_t *data = buffer.Data();
+  ASSERT_NE(nullptr, data);
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(data) %
+      AlignedBuffer<uint16_t>::kAlignment);
+
+  // Resizing within the capacity keeps the storage and the values
+  data[0] = 7u;
+  buffer.Resize(100u);
+  EXPECT_FALSE(buffer.Empty());
+  EXPECT_EQ(100u, buffer.Size());
+  EXPECT_EQ(data, buffer.Data());
+  buffer.Resize(10u);
+  EXPECT_EQ(10u, buffer.Size());
+  EXPECT_EQ(data, buffer.Data());
+  EXPECT_EQ(7u, buffer.Data()[0]);
+  buffer.Reserve(50u);
+  EXPECT_EQ(data, buffer.Data());
+  EXPECT_EQ(100u, buffer.Capacity());
+}
+
+//////////////////////////////////////////////////
+TEST(AlignedBuffer, Grow)
+{
+  AlignedBuffer<float> buffer;
+  buffer.Resize(16u);
+  EXPECT_EQ(16u, buffer.Capacity());
+
+  // A larger frame reallocates aligned storage
+  buffer.Resize(1000u);
+  EXPECT_EQ(1000u, buffer.Size());
+  EXPECT_EQ(1000u, buffer.Capacity());
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(buffer.Data()) %
+      AlignedBuffer<float>::kAlignment);
+  buffer.Data()[999] = 1.0f;
+  EXPECT_FLOAT_EQ(1.0f, buffer.Data()[999]);
+}
+
+//////////////////////////////////////////////////
+TEST(AlignedBuffer, Memory)
+{
+  AlignedBuffer<float> buffer;
+  EXPECT_EQ(SensorBufferMemory::DEFAULT, buffer.Memory());
+  EXPECT_EQ(SensorBufferMemory::DEFAULT, buffer.AllocatedMemory());
+
+  // Buffers smaller than a huge page use regular memory
+  buffer.SetMemory(SensorBufferMemory::HUGE_PAGES);
+  EXPECT_EQ(SensorBufferMemory::HUGE_PAGES, buffer.Memory());
+  buffer.Reserve(16u);
+  EXPECT_EQ(SensorBufferMemory::DEFAULT, buffer.AllocatedMemory());
+
+  const std::size_t large = kHugePageSize / sizeof(float) + 1u;
+  buffer.Resize(large);
+  ASSERT_NE(nullptr, buffer.Data());
+  buffer.Data()[large - 1u] = 2.0f;
+  EXPECT_FLOAT_EQ(2.0f, buffer.Data()[large - 1u]);
+#ifdef __linux__
+  EXPECT_EQ(SensorBufferMemory::HUGE_PAGES, buffer.AllocatedMemory());
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(buffer.Data()) %
+      kHugePageSize);
+#endif
+
+  // Changing the kind keeps the storage until it grows. Pinning falls back
+  // to regular memory past the lock limit of the process.
+  float *data = buffer.Data();
+  buffer.SetMemory(SensorBufferMemory::PINNED);
+  buffer.Resize(16u);
+  EXPECT_EQ(data, buffer.Data());
+  buffer.Resize(large * 2u);
+  EXPECT_NE(SensorBufferMemory::HUGE_PAGES, buffer.AllocatedMemory());
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(buffer.Data()) %
+      AlignedBuffer<float>::kAlignment);
+  buffer.Data()[large * 2u - 1u] = 3.0f;
+  EXPECT_FLOAT_EQ(3.0f, buffer.Data()[large * 2u - 1u]);
+}
+
+//////////////////////////////////////////////////
+TEST(AlignedBuffer, Advice)
+{
+  std::vector<unsigned char> image(kHugePageSize * 3u);
+  BufferMemoryAdvice advice;
+  EXPECT_EQ(SensorBufferMemory::DEFAULT,
+      advice.Apply(nullptr, 0u, SensorBufferMemory::PINNED));
+  EXPECT_EQ(SensorBufferMemory::DEFAULT,
+      advice.Apply(image.data(), image.size(), SensorBufferMemory::DEFAULT));
+#ifdef __linux__
+  EXPECT_EQ(SensorBufferMemory::HUGE_PAGES, advice.Apply(image.data(),
+      image.size(), SensorBufferMemory::HUGE_PAGES));
+#endif
+
+  // Pinning may be refused by the lock limit, the buffer is usable anyway
+  advice.Apply(image.data(), 4096u, SensorBufferMemory::PINNED);
+  image[0] = 1u;
+  advice.Reset();
+  EXPECT_EQ(1u, image[0]);
+}
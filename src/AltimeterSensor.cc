@@ -46,6 +46,9 @@ class gz::sensors::AltimeterSensorPrivate
   /// \brief publisher to publish altimeter messages.
   public: transport::Node::Publisher pub;
 
+  /// \brief Message reused by every update.
+  public: msgs::Altimeter msg;
+
   /// \brief true if Load() has been called and was successful
   public: bool initialized = false;
 
@@ -59,7 +62,7 @@ class gz::sensors::AltimeterSensorPrivate
   public: double verticalReference = 0.0;
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
 };
 
 //////////////////////////////////////////////////
@@ -102,10 +105,8 @@ bool AltimeterSensor::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/altimeter");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<msgs::Altimeter>(this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<msgs::Altimeter>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic[" << this->Topic() << "].\n";
     return false;
@@ -131,6 +132,8 @@ bool AltimeterSensor::Load(const sdf::Sensor &_sdf)
           _sdf.AltimeterSensor()->VerticalVelocityNoise());
   }
 
+  this->RegisterNoise(this->dataPtr->noises);
+
   this->dataPtr->initialized = true;
   return true;
 }
@@ -153,15 +156,11 @@ bool AltimeterSensor::Update(const std::chrono::steady_clock::duration &_now)
     return false;
   }
 
-  msgs::Altimeter msg;
-  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-  auto frame = msg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->FrameId());
+  auto &msg = this->dataPtr->msg;
+  this->FillHeader(msg.mutable_header(), _now);
 
   // Apply altimeter vertical position noise
-  if (this->dataPtr->noises.find(ALTIMETER_VERTICAL_POSITION_NOISE_METERS) !=
-      this->dataPtr->noises.end())
+  if (this->dataPtr->noises[ALTIMETER_VERTICAL_POSITION_NOISE_METERS])
   {
     this->dataPtr->verticalPosition =
       this->dataPtr->noises[ALTIMETER_VERTICAL_POSITION_NOISE_METERS]->Apply(
@@ -169,9 +168,7 @@ bool AltimeterSensor::Update(const std::chrono::steady_clock::duration &_now)
   }
 
   // Apply altimeter vertical velocity noise
-  if (this->dataPtr->noises.find(
-        ALTIMETER_VERTICAL_VELOCITY_NOISE_METERS_PER_S) !=
-      this->dataPtr->noises.end())
+  if (this->dataPtr->noises[ALTIMETER_VERTICAL_VELOCITY_NOISE_METERS_PER_S])
   {
     this->dataPtr->verticalVelocity =
       this->dataPtr->noises[
@@ -184,8 +181,7 @@ bool AltimeterSensor::Update(const std::chrono::steady_clock::duration &_now)
   msg.set_vertical_reference(this->dataPtr->verticalReference);
 
   // publish
-  this->AddSequence(msg.mutable_header());
-  this->dataPtr->pub.Publish(msg);
+  this->Publish(this->dataPtr->pub, msg);
 
   return true;
 }
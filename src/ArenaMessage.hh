@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_ARENAMESSAGE_HH_
+#define GZ_SENSORS_ARENAMESSAGE_HH_
+
+#include <google/protobuf/arena.h>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Temporary message created on an arena, or on the heap when
+    /// there is no arena. Messages on an arena are released when the arena
+    /// is reset, heap messages when this object is destroyed.
+    /// \tparam T Protobuf message type.
+    template <typename T>
+    class ArenaMessage
+    {
+      /// \brief Constructor
+      /// \param[in] _arena Arena to create the message on, may be null.
+      public: explicit ArenaMessage(google::protobuf::Arena *_arena)
+        : msg(google::protobuf::Arena::CreateMessage<T>(_arena)),
+          owned(_arena == nullptr)
+      {
+      }
+
+      /// \brief Constructor that falls back to a reusable message, cleared
+      /// first, when there is no arena. The fallback keeps the memory of
+      /// its fields between uses.
+      /// \param[in] _arena Arena to create the message on, may be null.
+      /// \param[in] _fallback Message to use when there is no arena. It
+      /// must outlive this object.
+      public: ArenaMessage(google::protobuf::Arena *_arena, T *_fallback)
+        : msg(_arena ? google::protobuf::Arena::CreateMessage<T>(_arena)
+                     : _fallback),
+          owned(false)
+      {
+        if (!_arena)
+          this->msg->Clear();
+      }
+
+      /// \brief Destructor
+      public: ~ArenaMessage()
+      {
+        if (this->owned)
+          delete this->msg;
+      }
+
+      /// \brief No copy constructor
+      public: ArenaMessage(const ArenaMessage &) = delete;
+
+      /// \brief No copy assignment
+      public: ArenaMessage &operator=(const ArenaMessage &) = delete;
+
+      /// \brief Get the message.
+      /// \return Pointer to the message.
+      public: T *Get() const
+      {
+        return this->msg;
+      }
+
+      /// \brief Access the message.
+      /// \return Pointer to the message.
+      public: T *operator->() const
+      {
+        return this->msg;
+      }
+
+      /// \brief Access the message.
+      /// \return Reference to the message.
+      public: T &operator*() const
+      {
+        return *this->msg;
+      }
+
+      /// \brief The message.
+      private: T *msg;
+
+      /// \brief True if the message is on the heap.
+      private: bool owned;
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <gz/common/Console.hh>
+
+#include "gz/sensors/AtmosphereTable.hh"
+
+using namespace gz;
+using namespace sensors;
+
+// Constants. These constants from from RotorS:
+// https://github.com/ethz-asl/rotors_simulator/blob/master/rotors_gazebo_plugins/include/rotors_gazebo_plugins/gazebo_pressure_plugin.h
+static constexpr double kGasConstantNmPerKmolKelvin = 8314.32;
+static constexpr double kMeanMolecularAirWeightKgPerKmol = 28.9644;
+static constexpr double kGravityMagnitude = 9.80665;
+static constexpr double kEarthRadiusMeters = 6356766.0;
+static constexpr double kPressureOneAtmospherePascals = 101325.0;
+static constexpr double kSeaLevelTempKelvin = 288.15;
+static constexpr double kTempLapseKelvinPerMeter = 0.0065;
+static constexpr double kAirConstantDimensionless = kGravityMagnitude *
+    kMeanMolecularAirWeightKgPerKmol /
+        (kGasConstantNmPerKmolKelvin * -kTempLapseKelvinPerMeter);
+
+/// \brief Private data for AtmosphereTable
+class gz::sensors::AtmosphereTablePrivate
+{
+  /// \brief Spacing of the tabulated altitudes, in meters.
+  public: double resolution = 1.0;
+
+  /// \brief Lowest tabulated altitude, in meters.
+  public: double minAltitude = 0.0;
+
+  /// \brief Highest tabulated altitude, in meters.
+  public: double maxAltitude = 0.0;
+
+  /// \brief Pressure at each tabulated altitude.
+  public: std::vector<double> pressure;
+
+  /// \brief Density at each tabulated altitude.
+  public: std::vector<double> density;
+
+  /// \brief Temperature at each tabulated altitude.
+  public: std::vector<double> temperature;
+};
+
+//////////////////////////////////////////////////
+AtmosphereTable::AtmosphereTable(double _resolution, double _minAltitude,
+    double _maxAltitude)
+  : dataPtr(new AtmosphereTablePrivate())
+{
+  if (!(_resolution > 0.0))
+  {
+    gzwarn << "Atmosphere table resolution must be positive, using 1 meter "
+           << "instead of [" << _resolution << "]." << std::endl;
+    _resolution = 1.0;
+  }
+  if (_maxAltitude < _minAltitude)
+    std::swap(_minAltitude, _maxAltitude);
+
+  const std::size_t count = static_cast<std::size_t>(
+      std::ceil((_maxAltitude - _minAltitude) / _resolution)) + 1;
+  this->dataPtr->resolution = _resolution;
+  this->dataPtr->minAltitude = _minAltitude;
+  this->dataPtr->maxAltitude =
+      _minAltitude + static_cast<double>(count - 1) * _resolution;
+  this->dataPtr->pressure.resize(count);
+  this->dataPtr->density.resize(count);
+  this->dataPtr->temperature.resize(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const AtmosphereSample sample = Evaluate(
+        _minAltitude + static_cast<double>(i) * _resolution);
+    this->dataPtr->pressure[i] = sample.pressure;
+    this->dataPtr->density[i] = sample.density;
+    this->dataPtr->temperature[i] = sample.temperature;
+  }
+}
+
+//////////////////////////////////////////////////
+AtmosphereTable::~AtmosphereTable() = default;
+
+//////////////////////////////////////////////////
+double AtmosphereTable::Resolution() const
+{
+  return this->dataPtr->resolution;
+}
+
+//////////////////////////////////////////////////
+double AtmosphereTable::MinAltitude() const
+{
+  return this->dataPtr->minAltitude;
+}
+
+//////////////////////////////////////////////////
+double AtmosphereTable::MaxAltitude() const
+{
+  return this->dataPtr->maxAltitude;
+}
+
+//////////////////////////////////////////////////
+AtmosphereSample AtmosphereTable::Lookup(double _altitude) const
+{
+  const auto &d = *this->dataPtr;
+  if (!(_altitude >= d.minAltitude && _altitude <= d.maxAltitude))
+    return Evaluate(_altitude);
+
+  const std::size_t last = d.pressure.size() - 1;
+  if (last == 0)
+    return {d.pressure[0], d.density[0], d.temperature[0]};
+
+  const double position = (_altitude - d.minAltitude) / d.resolution;
+  const std::size_t i =
+      std::min(static_cast<std::size_t>(position), last - 1);
+  const double t = position - static_cast<double>(i);
+  AtmosphereSample sample;
+  sample.pressure = d.pressure[i] + t * (d.pressure[i + 1] - d.pressure[i]);
+  sample.density = d.density[i] + t * (d.density[i + 1] - d.density[i]);
+  sample.temperature =
+      d.temperature[i] + t * (d.temperature[i + 1] - d.temperature[i]);
+  return sample;
+}
+
+//////////////////////////////////////////////////
+AtmosphereSample AtmosphereTable::Evaluate(double _altitude)
+{
+  // This block of code comes from RotorS:
+  // https://github.com/ethz-asl/rotors_simulator/blob/master/rotors_gazebo_plugins/src/gazebo_pressure_plugin.cpp
+
+  // Compute the geopotential height.
+  double geoHeight = kEarthRadiusMeters * _altitude /
+    (kEarthRadiusMeters + _altitude);
+
+  // Compute the temperature at the current altitude in Kelvin.
+  double tempAtHeight =
+    kSeaLevelTempKelvin - kTempLapseKelvinPerMeter * geoHeight;
+
+  AtmosphereSample sample;
+  sample.temperature = tempAtHeight;
+
+  // Compute the current air pressure.
+  sample.pressure =
+    kPressureOneAtmospherePascals * exp(kAirConstantDimensionless *
+        log(kSeaLevelTempKelvin / tempAtHeight));
+
+  // Ideal gas law
+  sample.density = sample.pressure * kMeanMolecularAirWeightKgPerKmol /
+      (kGasConstantNmPerKmolKelvin * tempAtHeight);
+  return sample;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "gz/sensors/AtmosphereTable.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(AtmosphereTable_TEST, Evaluate)
+{
+  // Sea level of the standard atmosphere
+  const AtmosphereSample seaLevel = AtmosphereTable::Evaluate(0.0);
+  EXPECT_DOUBLE_EQ(101325.0, seaLevel.pressure);
+  EXPECT_DOUBLE_EQ(288.15, seaLevel.temperature);
+  EXPECT_NEAR(1.225, seaLevel.density, 1e-4);
+
+  // Everything decreases with altitude in the troposphere
+  const AtmosphereSample high = AtmosphereTable::Evaluate(5000.0);
+  EXPECT_LT(high.pressure, seaLevel.pressure);
+  EXPECT_LT(high.density, seaLevel.density);
+  EXPECT_LT(high.temperature, seaLevel.temperature);
+  EXPECT_NEAR(54020.0, high.pressure, 50.0);
+}
+
+/////////////////////////////////////////////////
+TEST(AtmosphereTable_TEST, Lookup)
+{
+  AtmosphereTable table(1.0);
+  EXPECT_DOUBLE_EQ(1.0, table.Resolution());
+  EXPECT_DOUBLE_EQ(-500.0, table.MinAltitude());
+  EXPECT_DOUBLE_EQ(11000.0, table.MaxAltitude());
+
+  for (double altitude = -400.0; altitude < 10000.0; altitude += 37.3)
+  {
+    const AtmosphereSample expected = AtmosphereTable::Evaluate(altitude);
+    const AtmosphereSample sample = table.Lookup(altitude);
+    EXPECT_NEAR(expected.pressure, sample.pressure, 1e-3) << altitude;
+    EXPECT_NEAR(expected.density, sample.density, 1e-7) << altitude;
+    EXPECT_NEAR(expected.temperature, sample.temperature, 1e-6) << altitude;
+  }
+
+  // Tabulated altitudes and the bounds are exact
+  EXPECT_DOUBLE_EQ(AtmosphereTable::Evaluate(100.0).pressure,
+      table.Lookup(100.0).pressure);
+  EXPECT_DOUBLE_EQ(AtmosphereTable::Evaluate(11000.0).pressure,
+      table.Lookup(11000.0).pressure);
+
+  // Altitudes out of the table are evaluated
+  EXPECT_DOUBLE_EQ(AtmosphereTable::Evaluate(-1000.0).pressure,
+      table.Lookup(-1000.0).pressure);
+  EXPECT_DOUBLE_EQ(AtmosphereTable::Evaluate(12000.0).pressure,
+      table.Lookup(12000.0).pressure);
+  EXPECT_TRUE(std::isnan(table.Lookup(std::nan("")).pressure));
+}
+
+/////////////////////////////////////////////////
+TEST(AtmosphereTable_TEST, Resolution)
+{
+  // A coarse table is less accurate
+  AtmosphereTable coarse(100.0, 0.0, 1050.0);
+  EXPECT_DOUBLE_EQ(100.0, coarse.Resolution());
+  EXPECT_DOUBLE_EQ(1100.0, coarse.MaxAltitude());
+  EXPECT_NEAR(AtmosphereTable::Evaluate(550.0).pressure,
+      coarse.Lookup(550.0).pressure, 10.0);
+
+  // Invalid resolutions are replaced
+  AtmosphereTable invalid(0.0, 0.0, 10.0);
+  EXPECT_DOUBLE_EQ(1.0, invalid.Resolution());
+
+  // Single entry table
+  AtmosphereTable single(1.0, 5.0, 5.0);
+  EXPECT_DOUBLE_EQ(AtmosphereTable::Evaluate(5.0).pressure,
+      single.Lookup(5.0).pressure);
+}
@@ -15,7 +15,18 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <gz/msgs/boolean.pb.h>
 #include <gz/msgs/image.pb.h>
@@ -30,23 +41,115 @@
 #include <gz/common/Util.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/rendering/BoundingBoxCamera.hh>
+#include <gz/rendering/SegmentationCamera.hh>
 #include <gz/transport/Node.hh>
 #include <gz/transport/Publisher.hh>
 
 #include "gz/sensors/BoundingBoxCameraSensor.hh"
-#include "gz/sensors/RenderingEvents.hh"
+#include "gz/sensors/ImageWriter.hh"
 #include "gz/sensors/SensorFactory.hh"
 
+#include "AlignedBuffer.hh"
+#include "MemorySize.hh"
+#include "BoxStreamWriter.hh"
+
 using namespace gz;
 using namespace sensors;
 
 class gz::sensors::BoundingBoxCameraSensorPrivate
 {
+  /// \brief A rendered frame and what its outputs need
+  public: struct Frame
+  {
+    /// \brief Boxes of the frame
+    std::vector<rendering::BoundingBox> boxes;
+
+    /// \brief Rgb image, null if it's neither published nor saved
+    unsigned char *image{nullptr};
+
+    /// \brief Storage of the image of a pipelined frame
+    AlignedBuffer<unsigned char> imageBuffer;
+
+    /// \brief Image width
+    unsigned int width{0u};
+
+    /// \brief Image height
+    unsigned int height{0u};
+
+    /// \brief Camera that draws the boxes on the image
+    rendering::BoundingBoxCameraPtr camera{nullptr};
+
+    /// \brief Visible pixels of each box, if counted
+    std::vector<uint32_t> visiblePixels;
+
+    /// \brief True to publish the visible pixels of the boxes
+    bool countVisiblePixels{false};
+
+    /// \brief Image message, its header filled when rendered
+    msgs::Image imageMsg;
+
+    /// \brief 2D boxes message, its header filled when rendered
+    msgs::AnnotatedAxisAligned2DBox_V boxes2DMsg;
+
+    /// \brief 3D boxes message, its header filled when rendered
+    msgs::AnnotatedOriented3DBox_V boxes3DMsg;
+
+    /// \brief True to publish the image with the boxes drawn on it
+    bool publishImage{false};
+
+    /// \brief True to save the image and the boxes
+    bool save{false};
+
+    /// \brief Number of the saved sample
+    std::uint64_t saveCounter{0u};
+
+    /// \brief How the boxes are saved
+    BoundingBoxExportFormat exportFormat{BoundingBoxExportFormat::CSV};
+  };
+
+  /// \brief Destructor, stops the worker thread
+  public: ~BoundingBoxCameraSensorPrivate();
+
+  /// \brief Save the image and the boxes of a frame, draw the boxes on
+  /// its image and fill its messages.
+  /// \param[in,out] _frame The frame.
+  public: void ProcessFrame(Frame &_frame);
+
+  /// \brief Count the visible pixels of the boxes of a frame in the
+  /// last labels map.
+  /// \param[in,out] _frame The frame.
+  public: void CountVisiblePixels(Frame &_frame) const;
+
+  /// \brief Callback on new labels maps from the visibility camera
+  /// \param[in] _data Labels map, a label repeated in each channel.
+  /// \param[in] _width Map width.
+  /// \param[in] _height Map height.
+  /// \param[in] _channels Number of channels.
+  public: void OnNewVisibilityFrame(const uint8_t *_data,
+      unsigned int _width, unsigned int _height, unsigned int _channels,
+      const std::string &/*_format*/);
+
   /// \brief Save an image of rgb camera
-  public: void SaveImage();
+  /// \param[in] _frame Frame of the image.
+  public: void SaveImage(const Frame &_frame);
 
   /// \brief Save the bounding boxes
-  public: void SaveBoxes();
+  /// \param[in] _frame Frame of the boxes.
+  public: void SaveBoxes(const Frame &_frame);
+
+  /// \brief Append the bounding boxes to the JSON lines file
+  /// \param[in] _frame Frame of the boxes.
+  public: void AppendBoxesJson(const Frame &_frame);
+
+  /// \brief Append the bounding boxes to the binary file and its index
+  /// \param[in] _frame Frame of the boxes.
+  public: void AppendBoxesBinary(const Frame &_frame);
+
+  /// \brief Worker thread loop of the pipelined mode.
+  public: void Run();
+
+  /// \brief Wait for the pipelined frames and stop the worker thread.
+  public: void StopWorker();
 
   /// \brief SDF Sensor DOM Object
   public: sdf::Sensor sdfSensor;
@@ -61,6 +164,25 @@ class gz::sensors::BoundingBoxCameraSensorPrivate
   /// its image (just for visualization)
   public: rendering::CameraPtr rgbCamera{nullptr};
 
+  /// \brief Segmentation camera rendering the labels map that visible
+  /// pixels are counted in
+  public: rendering::SegmentationCameraPtr visibilityCamera{nullptr};
+
+  /// \brief Connection to the labels maps of the visibility camera
+  public: common::ConnectionPtr newVisibilityConnection;
+
+  /// \brief Label of each pixel of the last labels map
+  public: AlignedBuffer<unsigned char> visibilityLabels;
+
+  /// \brief Width of the last labels map
+  public: unsigned int visibilityWidth{0u};
+
+  /// \brief Height of the last labels map
+  public: unsigned int visibilityHeight{0u};
+
+  /// \brief True to count the visible pixels of boxes
+  public: std::atomic<bool> countVisiblePixels{false};
+
   /// \brief Node to create publisher
   public: transport::Node node;
 
@@ -76,15 +198,42 @@ class gz::sensors::BoundingBoxCameraSensorPrivate
   /// \brief RGB Image to draw boxes on it
   public: rendering::Image image;
 
-  /// \brief Buffer contains the image data to be saved
-  public: unsigned char *saveImageBuffer{nullptr};
+  /// \brief Frame being filled by Update
+  public: Frame frame;
+
+  /// \brief Frame waiting for the worker thread
+  public: Frame pendingFrame;
+
+  /// \brief Frame processed by the worker thread
+  public: Frame workerFrame;
+
+  /// \brief True to process frames on the worker thread
+  public: bool pipelined{false};
+
+  /// \brief Worker thread of the pipelined mode
+  public: std::thread worker;
+
+  /// \brief Protects the pending frame and the worker state
+  public: std::mutex workerMutex;
+
+  /// \brief Signals a pending frame or that the worker must stop
+  public: std::condition_variable workCv;
+
+  /// \brief Signals that the worker took the pending frame or is idle
+  public: std::condition_variable idleCv;
+
+  /// \brief True if pendingFrame waits for the worker
+  public: bool framePending{false};
+
+  /// \brief True while the worker processes workerFrame
+  public: bool workerBusy{false};
+
+  /// \brief True to stop the worker thread
+  public: bool stopWorker{false};
 
   /// \brief Connection to the new BoundingBox frames data
   public: common::ConnectionPtr newBoundingBoxConnection;
 
-  /// \brief Connection to the Manager's scene change event.
-  public: common::ConnectionPtr sceneChangeConnection;
-
   /// \brief Just a mutex for thread safety
   public: std::mutex mutex;
 
@@ -115,6 +264,25 @@ class gz::sensors::BoundingBoxCameraSensorPrivate
 
   /// \brief counter used to set the sample filename
   public: std::uint64_t saveCounter{0};
+
+  /// \brief How the boxes of the next samples are saved
+  public: std::atomic<BoundingBoxExportFormat> exportFormat{
+    BoundingBoxExportFormat::CSV};
+
+  /// \brief Writer of the JSON lines file, opened by the first sample
+  public: std::unique_ptr<BoxStreamWriter> jsonWriter;
+
+  /// \brief Writer of the binary boxes file, opened by the first sample
+  public: std::unique_ptr<BoxStreamWriter> binaryWriter;
+
+  /// \brief Writer of the binary index file, opened by the first sample
+  public: std::unique_ptr<BoxStreamWriter> indexWriter;
+
+  /// \brief Line of the JSON lines file being built
+  public: std::string jsonLine;
+
+  /// \brief Records of the binary file being built
+  public: std::string binaryRecords;
 };
 
 //////////////////////////////////////////////////
@@ -195,10 +363,8 @@ bool BoundingBoxCameraSensor::Load(const sdf::Sensor &_sdf)
   auto topicBoundingBoxes = this->Topic();
   auto topicImage = this->Topic() + "_image";
 
-  this->dataPtr->imagePublisher =
-    this->dataPtr->node.Advertise<msgs::Image>(topicImage);
-
-  if (!this->dataPtr->imagePublisher)
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+      this->dataPtr->imagePublisher, topicImage))
   {
     gzerr << "Unable to create publisher on topic ["
       << topicImage << "].\n";
@@ -208,18 +374,21 @@ bool BoundingBoxCameraSensor::Load(const sdf::Sensor &_sdf)
   gzdbg << "Camera images for [" << this->Name() << "] advertised on ["
     << topicImage << "]" << std::endl;
 
+  bool boxesAdvertised = false;
   if (this->dataPtr->type == rendering::BoundingBoxType::BBT_BOX3D)
   {
-    this->dataPtr->boxesPublisher = this->dataPtr->node.Advertise<
-      msgs::AnnotatedOriented3DBox_V>(topicBoundingBoxes);
+    boxesAdvertised = this->Advertise<msgs::AnnotatedOriented3DBox_V>(
+        this->dataPtr->node, this->dataPtr->boxesPublisher,
+        topicBoundingBoxes);
   }
   else
   {
-    this->dataPtr->boxesPublisher = this->dataPtr->node.Advertise<
-      msgs::AnnotatedAxisAligned2DBox_V>(topicBoundingBoxes);
+    boxesAdvertised = this->Advertise<msgs::AnnotatedAxisAligned2DBox_V>(
+        this->dataPtr->node, this->dataPtr->boxesPublisher,
+        topicBoundingBoxes);
   }
 
-  if (!this->dataPtr->boxesPublisher)
+  if (!boxesAdvertised)
   {
     gzerr << "Unable to create publisher on topic ["
       << topicBoundingBoxes << "].\n";
@@ -255,6 +424,7 @@ bool BoundingBoxCameraSensor::Load(const sdf::Sensor &_sdf)
     gzdbg << "Camera trigger messages for [" << this->Name() << "] subscribed"
           << " on [" << this->dataPtr->triggerTopic << "]" << std::endl;
     this->dataPtr->isTriggeredCamera = true;
+    this->SetWaitForTrigger(true);
   }
 
   if (!this->AdvertiseInfo())
@@ -265,11 +435,6 @@ bool BoundingBoxCameraSensor::Load(const sdf::Sensor &_sdf)
     this->CreateCamera();
   }
 
-  this->dataPtr->sceneChangeConnection =
-    RenderingEvents::ConnectSceneChangeCallback(
-    std::bind(&BoundingBoxCameraSensor::SetScene, this,
-    std::placeholders::_1));
-
   this->dataPtr->initialized = true;
 
   return true;
@@ -286,6 +451,8 @@ void BoundingBoxCameraSensor::SetScene(
   {
     this->dataPtr->boundingboxCamera = nullptr;
     this->dataPtr->rgbCamera = nullptr;
+    this->dataPtr->newVisibilityConnection.reset();
+    this->dataPtr->visibilityCamera = nullptr;
     RenderingSensor::SetScene(_scene);
 
     if (this->dataPtr->initialized)
@@ -306,26 +473,18 @@ bool BoundingBoxCameraSensor::CreateCamera()
   // Camera Info Msg
   this->PopulateInfo(sdfCamera);
 
-  if (!this->dataPtr->rgbCamera)
+  if (!this->dataPtr->boundingboxCamera)
   {
-    // Create rendering camera
+    // Create rendering camera. The rgb camera of the annotated image is
+    // only created once the image is published or saved.
     this->dataPtr->boundingboxCamera =
       this->Scene()->CreateBoundingBoxCamera(this->Name());
-
-    this->dataPtr->rgbCamera = this->Scene()->CreateCamera(
-      this->Name() + "_rgbCamera");
   }
 
   auto width = sdfCamera->ImageWidth();
   auto height = sdfCamera->ImageHeight();
 
   // Set Camera Properties
-  this->dataPtr->rgbCamera->SetImageFormat(rendering::PF_R8G8B8);
-  this->dataPtr->rgbCamera->SetImageWidth(width);
-  this->dataPtr->rgbCamera->SetImageHeight(height);
-  this->dataPtr->rgbCamera->SetVisibilityMask(sdfCamera->VisibilityMask());
-  this->dataPtr->rgbCamera->SetNearClipPlane(sdfCamera->NearClip());
-  this->dataPtr->rgbCamera->SetFarClipPlane(sdfCamera->FarClip());
   math::Angle angle = sdfCamera->HorizontalFov();
   if (angle < 0.01 || angle > GZ_PI*2)
   {
@@ -333,8 +492,6 @@ bool BoundingBoxCameraSensor::CreateCamera()
     return false;
   }
   double aspectRatio = static_cast<double>(width)/height;
-  this->dataPtr->rgbCamera->SetAspectRatio(aspectRatio);
-  this->dataPtr->rgbCamera->SetHFOV(angle);
 
   this->dataPtr->boundingboxCamera->SetImageWidth(width);
   this->dataPtr->boundingboxCamera->SetImageHeight(height);
@@ -349,12 +506,10 @@ bool BoundingBoxCameraSensor::CreateCamera()
   this->dataPtr->boundingboxCamera->SetBoundingBoxType(this->dataPtr->type);
 
   // Add the camera to the scene
-  this->Scene()->RootVisual()->AddChild(this->dataPtr->rgbCamera);
   this->Scene()->RootVisual()->AddChild(this->dataPtr->boundingboxCamera);
 
-  // Add the rendering sensors to handle its render
+  // Add the rendering sensor to handle its render
   this->AddSensor(this->dataPtr->boundingboxCamera);
-  this->AddSensor(this->dataPtr->rgbCamera);
 
   // Create the directory to store frames
   if (sdfCamera->SaveFrames())
@@ -385,8 +540,128 @@ bool BoundingBoxCameraSensor::CreateCamera()
       std::bind(&BoundingBoxCameraSensor::OnNewBoundingBoxes, this,
         std::placeholders::_1));
 
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool BoundingBoxCameraSensor::UpdateRgbCamera(bool _needed)
+{
+  if (!_needed)
+  {
+    if (this->dataPtr->rgbCamera)
+    {
+      // Destroying it removes it from the rendered sensors
+      this->Scene()->DestroySensor(this->dataPtr->rgbCamera);
+      this->dataPtr->rgbCamera = nullptr;
+    }
+    return false;
+  }
+
+  if (this->dataPtr->rgbCamera)
+    return true;
+
+  auto sdfCamera = this->dataPtr->sdfSensor.CameraSensor();
+  if (!sdfCamera)
+    return false;
+
+  auto width = sdfCamera->ImageWidth();
+  auto height = sdfCamera->ImageHeight();
+
+  this->dataPtr->rgbCamera = this->Scene()->CreateCamera(
+    this->Name() + "_rgbCamera");
+  if (!this->dataPtr->rgbCamera)
+  {
+    gzerr << "Unable to create the rgb camera of [" << this->Name()
+          << "]\n";
+    return false;
+  }
+
+  // Set Camera Properties
+  this->dataPtr->rgbCamera->SetImageFormat(rendering::PF_R8G8B8);
+  this->dataPtr->rgbCamera->SetImageWidth(width);
+  this->dataPtr->rgbCamera->SetImageHeight(height);
+  this->dataPtr->rgbCamera->SetVisibilityMask(sdfCamera->VisibilityMask());
+  this->dataPtr->rgbCamera->SetNearClipPlane(sdfCamera->NearClip());
+  this->dataPtr->rgbCamera->SetFarClipPlane(sdfCamera->FarClip());
+  this->dataPtr->rgbCamera->SetAspectRatio(
+    static_cast<double>(width)/height);
+  this->dataPtr->rgbCamera->SetHFOV(sdfCamera->HorizontalFov());
+
+  // Add the camera to the scene and to the rendered sensors
+  this->Scene()->RootVisual()->AddChild(this->dataPtr->rgbCamera);
+  this->AddSensor(this->dataPtr->rgbCamera);
+
   this->dataPtr->image = this->dataPtr->rgbCamera->CreateImage();
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool BoundingBoxCameraSensor::UpdateVisibilityCamera(bool _needed)
+{
+  if (!_needed)
+  {
+    if (this->dataPtr->visibilityCamera)
+    {
+      // Destroying it removes it from the rendered sensors
+      this->dataPtr->newVisibilityConnection.reset();
+      this->Scene()->DestroySensor(this->dataPtr->visibilityCamera);
+      this->dataPtr->visibilityCamera = nullptr;
+    }
+    return false;
+  }
+
+  if (this->dataPtr->visibilityCamera)
+    return true;
+
+  auto sdfCamera = this->dataPtr->sdfSensor.CameraSensor();
+  if (!sdfCamera)
+    return false;
+
+  auto width = sdfCamera->ImageWidth();
+  auto height = sdfCamera->ImageHeight();
+
+  this->dataPtr->visibilityCamera = this->Scene()->CreateSegmentationCamera(
+    this->Name() + "_visibilityCamera");
+  if (!this->dataPtr->visibilityCamera)
+  {
+    gzerr << "Unable to create the visibility camera of [" << this->Name()
+          << "]\n";
+    return false;
+  }
+
+  // Render the labels map directly, the depth test keeps the label of the
+  // closest surface at each pixel
+  this->dataPtr->visibilityCamera->SetSegmentationType(
+    rendering::SegmentationType::ST_SEMANTIC);
+  this->dataPtr->visibilityCamera->EnableColoredMap(false);
 
+  // Set Camera Properties
+  this->dataPtr->visibilityCamera->SetImageWidth(width);
+  this->dataPtr->visibilityCamera->SetImageHeight(height);
+  this->dataPtr->visibilityCamera->SetVisibilityMask(
+    sdfCamera->VisibilityMask());
+  this->dataPtr->visibilityCamera->SetNearClipPlane(sdfCamera->NearClip());
+  this->dataPtr->visibilityCamera->SetFarClipPlane(sdfCamera->FarClip());
+  this->dataPtr->visibilityCamera->SetAspectRatio(
+    static_cast<double>(width)/height);
+  this->dataPtr->visibilityCamera->SetHFOV(sdfCamera->HorizontalFov());
+
+  // Add the camera to the scene and to the rendered sensors
+  this->Scene()->RootVisual()->AddChild(this->dataPtr->visibilityCamera);
+  this->AddSensor(this->dataPtr->visibilityCamera);
+
+  this->dataPtr->visibilityLabels.SetMemory(this->BufferMemory());
+  this->dataPtr->visibilityLabels.Reserve(
+    static_cast<std::size_t>(width) * height);
+  this->dataPtr->visibilityWidth = 0u;
+  this->dataPtr->visibilityHeight = 0u;
+
+  this->dataPtr->newVisibilityConnection =
+    this->dataPtr->visibilityCamera->ConnectNewSegmentationFrame(
+      std::bind(&BoundingBoxCameraSensorPrivate::OnNewVisibilityFrame,
+        this->dataPtr.get(),
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
+        std::placeholders::_4, std::placeholders::_5));
   return true;
 }
 
@@ -412,23 +687,21 @@ bool BoundingBoxCameraSensor::Update(
   const std::chrono::steady_clock::duration &_now)
 {
   GZ_PROFILE("BoundingBoxCameraSensor::Update");
+  this->ApplySceneChanges();
   if (!this->dataPtr->initialized)
   {
     gzerr << "Not initialized, update ignored.\n";
     return false;
   }
 
-  if (!this->dataPtr->boundingboxCamera || !this->dataPtr->rgbCamera)
+  if (!this->dataPtr->boundingboxCamera)
   {
     gzerr << "Camera doesn't exist.\n";
     return false;
   }
 
-  if (this->HasInfoConnections())
-  {
-    // publish the camera info message
-    this->PublishInfo(_now);
-  }
+  // publish the camera info message, if it has subscribers
+  this->PublishInfo(_now);
 
   // render only if necessary
   {
@@ -448,73 +721,253 @@ bool BoundingBoxCameraSensor::Update(
     return false;
   }
 
+  // The rgb camera only renders if its image is published or saved
+  auto &frame = this->dataPtr->frame;
+  const bool needImage = this->UpdateRgbCamera(
+      this->dataPtr->imagePublisher.HasConnections() ||
+      this->dataPtr->saveSample);
+  frame.publishImage =
+      needImage && this->dataPtr->imagePublisher.HasConnections();
+  frame.countVisiblePixels = this->UpdateVisibilityCamera(
+      this->dataPtr->countVisiblePixels &&
+      this->dataPtr->type != rendering::BoundingBoxType::BBT_BOX3D &&
+      this->dataPtr->boxesPublisher.HasConnections());
+  frame.save = this->dataPtr->saveSample;
+  frame.exportFormat = this->dataPtr->exportFormat;
+  frame.width = this->dataPtr->boundingboxCamera->ImageWidth();
+  frame.height = this->dataPtr->boundingboxCamera->ImageHeight();
+  frame.camera = this->dataPtr->boundingboxCamera;
+
   // The sensor updates only the bounding box camera with its pose
   // as it has the same name, so make rgb camera with the same pose
-  this->dataPtr->rgbCamera->SetWorldPose(
-    this->dataPtr->boundingboxCamera->WorldPose());
+  if (needImage)
+  {
+    this->dataPtr->rgbCamera->SetWorldPose(
+      this->dataPtr->boundingboxCamera->WorldPose());
+  }
+  if (frame.countVisiblePixels)
+  {
+    this->dataPtr->visibilityCamera->SetWorldPose(
+      this->dataPtr->boundingboxCamera->WorldPose());
+  }
 
   // Render the bounding box camera
   this->Render();
 
-  // Render the rgb camera
-  this->dataPtr->rgbCamera->Copy(this->dataPtr->image);
+  frame.image = nullptr;
+  if (needImage)
+  {
+    this->dataPtr->rgbCamera->Copy(this->dataPtr->image);
+    frame.image = this->dataPtr->image.Data<unsigned char>();
+    this->FillHeader(frame.imageMsg.mutable_header(), _now, this->Name(),
+        "rgbImage");
+  }
 
-  auto imageBuffer = this->dataPtr->image.Data<unsigned char>();
+  auto *boxesHeader =
+      this->dataPtr->type == rendering::BoundingBoxType::BBT_BOX3D ?
+      frame.boxes3DMsg.mutable_header() : frame.boxes2DMsg.mutable_header();
+  this->FillHeader(boxesHeader, _now, this->Name(), "boundingboxes");
 
-  if (this->dataPtr->saveSample)
   {
-    auto bufferSize = this->dataPtr->image.MemorySize();
-    if (!this->dataPtr->saveImageBuffer)
-      this->dataPtr->saveImageBuffer = new uint8_t[bufferSize];
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    frame.boxes = this->dataPtr->boundingBoxes;
+    if (frame.save)
+      frame.saveCounter = this->dataPtr->saveCounter++;
+  }
+
+  // The labels map is overwritten by the next frame, so count now
+  frame.visiblePixels.clear();
+  if (frame.countVisiblePixels)
+    this->dataPtr->CountVisiblePixels(frame);
+
+  if (this->dataPtr->pipelined)
+  {
+    // The rendered image is overwritten by the next frame
+    if (frame.image)
+    {
+      const std::size_t size = this->dataPtr->image.MemorySize();
+      frame.imageBuffer.SetMemory(this->BufferMemory());
+      frame.imageBuffer.Resize(size);
+      memcpy(frame.imageBuffer.Data(), frame.image, size);
+      frame.image = frame.imageBuffer.Data();
+    }
+
+    {
+      GZ_PROFILE("BoundingBoxCameraSensor::WaitForWorker");
+      std::unique_lock<std::mutex> lock(this->dataPtr->workerMutex);
+      this->dataPtr->idleCv.wait(lock, [this]
+      {
+        return !this->dataPtr->framePending;
+      });
 
-    memcpy(this->dataPtr->saveImageBuffer, imageBuffer,
-      bufferSize);
+      // Swapping keeps the buffers of both frames allocated
+      std::swap(frame, this->dataPtr->pendingFrame);
+      this->dataPtr->framePending = true;
+      if (!this->dataPtr->worker.joinable())
+      {
+        this->dataPtr->stopWorker = false;
+        this->dataPtr->worker = std::thread(
+            &BoundingBoxCameraSensorPrivate::Run, this->dataPtr.get());
+      }
+    }
+    this->dataPtr->workCv.notify_one();
   }
+  else
+  {
+    this->dataPtr->ProcessFrame(frame);
 
-  // Draw bounding boxes
-  for (const auto &box : this->dataPtr->boundingBoxes)
+    if (frame.publishImage)
+      this->Publish(this->dataPtr->imagePublisher, frame.imageMsg);
+    if (this->dataPtr->type == rendering::BoundingBoxType::BBT_BOX3D)
+      this->Publish(this->dataPtr->boxesPublisher, frame.boxes3DMsg);
+    else
+      this->Publish(this->dataPtr->boxesPublisher, frame.boxes2DMsg);
+  }
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (this->dataPtr->isTriggeredCamera)
   {
-    this->dataPtr->boundingboxCamera->DrawBoundingBox(
-      imageBuffer, math::Color::Green, box);
+    return this->dataPtr->isTriggered = false;
   }
 
-  auto width = this->dataPtr->rgbCamera->ImageWidth();
-  auto height = this->dataPtr->rgbCamera->ImageHeight();
+  return true;
+}
 
-  // Create Image message
-  msgs::Image imageMsg;
-  imageMsg.set_width(width);
-  imageMsg.set_height(height);
-  // Format
-  imageMsg.set_step(
-    width * rendering::PixelUtil::BytesPerPixel(rendering::PF_R8G8B8));
-  imageMsg.set_pixel_format_type(
-    msgs::PixelFormatType::RGB_INT8);
-  // Time stamp
-  auto stamp = imageMsg.mutable_header()->mutable_stamp();
-  *stamp = msgs::Convert(_now);
-  auto frame = imageMsg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->Name());
-  // Image data
-  imageMsg.set_data(imageBuffer,
-      rendering::PixelUtil::MemorySize(rendering::PF_R8G8B8,
-      width, height));
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensor::SetPipelined(bool _pipelined)
+{
+  if (!_pipelined)
+    this->dataPtr->StopWorker();
+  this->dataPtr->pipelined = _pipelined;
+}
 
-  // Publish
-  this->AddSequence(imageMsg.mutable_header(), "rgbImage");
-  this->dataPtr->imagePublisher.Publish(imageMsg);
+//////////////////////////////////////////////////
+bool BoundingBoxCameraSensor::Pipelined() const
+{
+  return this->dataPtr->pipelined;
+}
 
-  msgs::AnnotatedAxisAligned2DBox_V boxes2DMsg;
-  msgs::AnnotatedOriented3DBox_V boxes3DMsg;
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensor::SetBoxesExportFormat(
+    BoundingBoxExportFormat _format)
+{
+  this->dataPtr->exportFormat = _format;
+}
 
-  if (this->dataPtr->type == rendering::BoundingBoxType::BBT_BOX3D)
+//////////////////////////////////////////////////
+BoundingBoxExportFormat BoundingBoxCameraSensor::BoxesExportFormat() const
+{
+  return this->dataPtr->exportFormat;
+}
+
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensor::SetVisiblePixelCounting(bool _count)
+{
+  this->dataPtr->countVisiblePixels = _count;
+}
+
+//////////////////////////////////////////////////
+bool BoundingBoxCameraSensor::VisiblePixelCounting() const
+{
+  return this->dataPtr->countVisiblePixels;
+}
+
+//////////////////////////////////////////////////
+BoundingBoxCameraSensorPrivate::~BoundingBoxCameraSensorPrivate()
+{
+  this->StopWorker();
+}
+
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensorPrivate::StopWorker()
+{
+  {
+    std::unique_lock<std::mutex> lock(this->workerMutex);
+    this->idleCv.wait(lock, [this]
+    {
+      return !this->framePending && !this->workerBusy;
+    });
+    this->stopWorker = true;
+  }
+  this->workCv.notify_one();
+  if (this->worker.joinable())
+    this->worker.join();
+}
+
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensorPrivate::Run()
+{
+  GZ_PROFILE_THREAD_NAME("BoundingBoxCameraSensor");
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->workerMutex);
+      this->workerBusy = false;
+      this->idleCv.notify_all();
+      this->workCv.wait(lock, [this]
+      {
+        return this->stopWorker || this->framePending;
+      });
+      if (!this->framePending)
+        return;
+
+      std::swap(this->workerFrame, this->pendingFrame);
+      this->framePending = false;
+      this->workerBusy = true;
+    }
+    this->idleCv.notify_all();
+
+    this->ProcessFrame(this->workerFrame);
+
+    // Already off the update thread, so publish directly
+    GZ_PROFILE("BoundingBoxCameraSensor::Publish");
+    if (this->workerFrame.publishImage)
+      this->imagePublisher.Publish(this->workerFrame.imageMsg);
+    if (this->type == rendering::BoundingBoxType::BBT_BOX3D)
+      this->boxesPublisher.Publish(this->workerFrame.boxes3DMsg);
+    else
+      this->boxesPublisher.Publish(this->workerFrame.boxes2DMsg);
+  }
+}
+
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensorPrivate::ProcessFrame(Frame &_frame)
+{
+  GZ_PROFILE("BoundingBoxCameraSensor::ProcessFrame");
+
+  // Save a sample (image & its bounding boxes) before drawing the boxes
+  if (_frame.save)
+  {
+    this->SaveImage(_frame);
+    this->SaveBoxes(_frame);
+  }
+
+  if (_frame.publishImage)
+  {
+    // Draw bounding boxes
+    for (const auto &box : _frame.boxes)
+    {
+      _frame.camera->DrawBoundingBox(_frame.image, math::Color::Green, box);
+    }
+
+    _frame.imageMsg.set_width(_frame.width);
+    _frame.imageMsg.set_height(_frame.height);
+    _frame.imageMsg.set_step(_frame.width *
+        rendering::PixelUtil::BytesPerPixel(rendering::PF_R8G8B8));
+    _frame.imageMsg.set_pixel_format_type(msgs::PixelFormatType::RGB_INT8);
+    _frame.imageMsg.set_data(_frame.image,
+        rendering::PixelUtil::MemorySize(rendering::PF_R8G8B8,
+        _frame.width, _frame.height));
+  }
+
+  if (this->type == rendering::BoundingBoxType::BBT_BOX3D)
   {
     // Create 3D boxes message
-    for (const auto &box : this->dataPtr->boundingBoxes)
+    _frame.boxes3DMsg.clear_annotated_box();
+    for (const auto &box : _frame.boxes)
     {
       // box data
-      auto annotatedBox = boxes3DMsg.add_annotated_box();
+      auto annotatedBox = _frame.boxes3DMsg.add_annotated_box();
       annotatedBox->set_label(box.Label());
 
       auto oriented3DBox = annotatedBox->mutable_box();
@@ -522,21 +975,15 @@ bool BoundingBoxCameraSensor::Update(
       msgs::Set(oriented3DBox->mutable_boxsize(), box.Size());
       msgs::Set(oriented3DBox->mutable_orientation(), box.Orientation());
     }
-    // time stamp
-    auto stampBoxes =
-      boxes3DMsg.mutable_header()->mutable_stamp();
-    *stampBoxes = msgs::Convert(_now);
-    auto frameBoxes = boxes3DMsg.mutable_header()->add_data();
-    frameBoxes->set_key("frame_id");
-    frameBoxes->add_value(this->Name());
   }
   else
   {
     // Create 2D boxes message
-    for (const auto &box : this->dataPtr->boundingBoxes)
+    _frame.boxes2DMsg.clear_annotated_box();
+    for (const auto &box : _frame.boxes)
     {
       // box data
-      auto annotatedBox = boxes2DMsg.add_annotated_box();
+      auto annotatedBox = _frame.boxes2DMsg.add_annotated_box();
       annotatedBox->set_label(box.Label());
 
       auto minCorner = box.Center() - box.Size() * 0.5;
@@ -548,65 +995,98 @@ bool BoundingBoxCameraSensor::Update(
       msgs::Set(axisAlignedBox->mutable_max_corner(),
           {maxCorner.X(), maxCorner.Y()});
     }
-    // time stamp
-    auto stampBoxes = boxes2DMsg.mutable_header()->mutable_stamp();
-    *stampBoxes = msgs::Convert(_now);
-    auto frameBoxes = boxes2DMsg.mutable_header()->add_data();
-    frameBoxes->set_key("frame_id");
-    frameBoxes->add_value(this->Name());
-  }
-
-  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
-  // Publish
-  if (this->dataPtr->type == rendering::BoundingBoxType::BBT_BOX3D)
-  {
-    this->AddSequence(boxes3DMsg.mutable_header(), "boundingboxes");
-    this->dataPtr->boxesPublisher.Publish(boxes3DMsg);
-  }
-  else
-  {
-    this->AddSequence(boxes2DMsg.mutable_header(), "boundingboxes");
-    this->dataPtr->boxesPublisher.Publish(boxes2DMsg);
+    // The header is refilled every frame, which drops this entry
+    if (_frame.countVisiblePixels)
+    {
+      auto entry = _frame.boxes2DMsg.mutable_header()->add_data();
+      entry->set_key("visible_pixels");
+      for (const auto count : _frame.visiblePixels)
+        entry->add_value(std::to_string(count));
+    }
   }
+}
 
-  // Save a sample (image & its bounding boxes)
-  if (this->dataPtr->saveSample)
-  {
-    this->dataPtr->SaveImage();
-    this->dataPtr->SaveBoxes();
-    ++this->dataPtr->saveCounter;
-  }
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensorPrivate::OnNewVisibilityFrame(
+  const uint8_t *_data, unsigned int _width, unsigned int _height,
+  unsigned int _channels, const std::string &/*_format*/)
+{
+  // Semantic labels are repeated in each channel, keep the first one
+  const std::size_t count = static_cast<std::size_t>(_width) * _height;
+  this->visibilityLabels.Resize(count);
+  unsigned char *labels = this->visibilityLabels.Data();
+  for (std::size_t i = 0u; i < count; ++i)
+    labels[i] = _data[i * _channels];
+  this->visibilityWidth = _width;
+  this->visibilityHeight = _height;
+}
 
-  if (this->dataPtr->isTriggeredCamera)
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensorPrivate::CountVisiblePixels(Frame &_frame) const
+{
+  _frame.visiblePixels.assign(_frame.boxes.size(), 0u);
+  const unsigned char *labels = this->visibilityLabels.Data();
+  const int width = static_cast<int>(this->visibilityWidth);
+  const int height = static_cast<int>(this->visibilityHeight);
+  for (std::size_t i = 0u; i < _frame.boxes.size(); ++i)
   {
-    return this->dataPtr->isTriggered = false;
+    const auto &box = _frame.boxes[i];
+    if (box.Label() > 255u)
+      continue;
+
+    // Pixels whose center lies within the box
+    const auto minCorner = box.Center() - box.Size() * 0.5;
+    const auto maxCorner = box.Center() + box.Size() * 0.5;
+    const int xMin = std::max(
+        static_cast<int>(std::ceil(minCorner.X() - 0.5)), 0);
+    const int xMax = std::min(
+        static_cast<int>(std::floor(maxCorner.X() - 0.5)), width - 1);
+    const int yMin = std::max(
+        static_cast<int>(std::ceil(minCorner.Y() - 0.5)), 0);
+    const int yMax = std::min(
+        static_cast<int>(std::floor(maxCorner.Y() - 0.5)), height - 1);
+
+    const auto label = static_cast<unsigned char>(box.Label());
+    uint32_t visible = 0u;
+    for (int y = yMin; y <= yMax; ++y)
+    {
+      const unsigned char *row = labels + static_cast<std::size_t>(y) * width;
+      for (int x = xMin; x <= xMax; ++x)
+        visible += row[x] == label;
+    }
+    _frame.visiblePixels[i] = visible;
   }
-
-  return true;
 }
 
 /////////////////////////////////////////////////
 unsigned int BoundingBoxCameraSensor::ImageHeight() const
 {
-  return this->dataPtr->rgbCamera->ImageHeight();
+  if (!this->dataPtr->boundingboxCamera)
+    return 0u;
+  return this->dataPtr->boundingboxCamera->ImageHeight();
 }
 
 /////////////////////////////////////////////////
 unsigned int BoundingBoxCameraSensor::ImageWidth() const
 {
-  return this->dataPtr->rgbCamera->ImageWidth();
+  if (!this->dataPtr->boundingboxCamera)
+    return 0u;
+  return this->dataPtr->boundingboxCamera->ImageWidth();
 }
 
 //////////////////////////////////////////////////
 void BoundingBoxCameraSensor::OnTrigger(const gz::msgs::Boolean &/*_msg*/)
 {
-  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
-  this->dataPtr->isTriggered = true;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->isTriggered = true;
+  }
+  this->NotifyTriggered();
 }
 
 //////////////////////////////////////////////////
-void BoundingBoxCameraSensorPrivate::SaveImage()
+void BoundingBoxCameraSensorPrivate::SaveImage(const Frame &_frame)
 {
   // Attempt to create the save directory if it doesn't exist
   if (!common::isDirectory(this->savePath))
@@ -629,29 +1109,29 @@ void BoundingBoxCameraSensorPrivate::SaveImage()
     }
   }
 
-  auto width = this->rgbCamera->ImageWidth();
-  auto height = this->rgbCamera->ImageHeight();
-  if (width == 0 || height == 0)
+  auto width = _frame.width;
+  auto height = _frame.height;
+  if (width == 0 || height == 0 || !_frame.image)
     return;
 
-  common::Image localImage;
-
   // Save the images in format of 0000001, 0000002 .. etc
   // Useful in sorting them in python
   std::stringstream ss;
-  ss << std::setw(7) << std::setfill('0') << this->saveCounter;
+  ss << std::setw(7) << std::setfill('0') << _frame.saveCounter;
   std::string saveCounterString = ss.str();
 
   std::string filename = "image_" + saveCounterString + ".png";
 
-  localImage.SetFromData(this->saveImageBuffer, width, height,
-      common::Image::RGB_INT8);
-  localImage.SavePNG(
-      common::joinPaths(this->saveImageFolder, filename));
+  // Encoding and writing the file happen on the image writer's threads
+  ImageWriter::Instance().Write(
+      common::joinPaths(this->saveImageFolder, filename),
+      _frame.image,
+      static_cast<std::size_t>(width) * height * 3u,
+      width, height, common::Image::RGB_INT8);
 }
 
 //////////////////////////////////////////////////
-void BoundingBoxCameraSensorPrivate::SaveBoxes()
+void BoundingBoxCameraSensorPrivate::SaveBoxes(const Frame &_frame)
 {
   // Attempt to create the save directory if it doesn't exist
   if (!common::isDirectory(this->savePath))
@@ -674,10 +1154,21 @@ void BoundingBoxCameraSensorPrivate::SaveBoxes()
     }
   }
 
+  if (_frame.exportFormat == BoundingBoxExportFormat::JSON_LINES)
+  {
+    this->AppendBoxesJson(_frame);
+    return;
+  }
+  if (_frame.exportFormat == BoundingBoxExportFormat::BINARY)
+  {
+    this->AppendBoxesBinary(_frame);
+    return;
+  }
+
   // Save the images in format of 0000001, 0000002 .. etc
   // Useful in sorting them in python
   std::stringstream ss;
-  ss << std::setw(7) << std::setfill('0') << this->saveCounter;
+  ss << std::setw(7) << std::setfill('0') << _frame.saveCounter;
   std::string saveCounterString = ss.str();
 
   std::string filename = this->saveBoxesFolder + "/boxes_" +
@@ -687,7 +1178,7 @@ void BoundingBoxCameraSensorPrivate::SaveBoxes()
   if (this->type == rendering::BoundingBoxType::BBT_BOX3D)
   {
     file << "label,x,y,z,w,h,l,roll,pitch,yaw\n";
-    for (const auto &box : this->boundingBoxes)
+    for (const auto &box : _frame.boxes)
     {
       auto label = std::to_string(box.Label());
 
@@ -714,7 +1205,7 @@ void BoundingBoxCameraSensorPrivate::SaveBoxes()
   else
   {
     file << "label,x_center,y_center,width,height\n";
-    for (const auto &box : this->boundingBoxes)
+    for (const auto &box : _frame.boxes)
     {
       auto label = std::to_string(box.Label());
 
@@ -734,6 +1225,143 @@ void BoundingBoxCameraSensorPrivate::SaveBoxes()
   file.close();
 }
 
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensorPrivate::AppendBoxesJson(const Frame &_frame)
+{
+  if (!this->jsonWriter)
+  {
+    const std::string filename = this->saveBoxesFolder + "/boxes.jsonl";
+    this->jsonWriter = std::make_unique<BoxStreamWriter>(filename);
+    if (!this->jsonWriter->IsOpen())
+    {
+      gzerr << "Failed to open [" << filename << "]" << std::endl;
+    }
+  }
+
+  // Same fields as the CSV columns
+  auto &line = this->jsonLine;
+  line = "{\"sample\":" + std::to_string(_frame.saveCounter) + ",\"boxes\":[";
+  for (std::size_t i = 0u; i < _frame.boxes.size(); ++i)
+  {
+    const auto &box = _frame.boxes[i];
+    if (i > 0u)
+      line += ',';
+    line += "{\"label\":" + std::to_string(box.Label());
+    if (this->type == rendering::BoundingBoxType::BBT_BOX3D)
+    {
+      line += ",\"x\":" + std::to_string(box.Center().X());
+      line += ",\"y\":" + std::to_string(box.Center().Y());
+      line += ",\"z\":" + std::to_string(box.Center().Z());
+      line += ",\"w\":" + std::to_string(box.Size().X());
+      line += ",\"h\":" + std::to_string(box.Size().Y());
+      line += ",\"l\":" + std::to_string(box.Size().Z());
+      line += ",\"roll\":" + std::to_string(box.Orientation().Roll());
+      line += ",\"pitch\":" + std::to_string(box.Orientation().Pitch());
+      line += ",\"yaw\":" + std::to_string(box.Orientation().Yaw());
+    }
+    else
+    {
+      line += ",\"x_center\":" + std::to_string(box.Center().X());
+      line += ",\"y_center\":" + std::to_string(box.Center().Y());
+      line += ",\"width\":" + std::to_string(box.Size().X());
+      line += ",\"height\":" + std::to_string(box.Size().Y());
+    }
+    line += '}';
+  }
+  line += "]}\n";
+  this->jsonWriter->Append(line.data(), line.size());
+}
+
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensorPrivate::AppendBoxesBinary(const Frame &_frame)
+{
+  if (!this->binaryWriter)
+  {
+    for (auto *writer : {&this->binaryWriter, &this->indexWriter})
+    {
+      const std::string filename = this->saveBoxesFolder +
+          (writer == &this->binaryWriter ? "/boxes.bin" : "/boxes.idx");
+      *writer = std::make_unique<BoxStreamWriter>(filename);
+      if (!(*writer)->IsOpen())
+      {
+        gzerr << "Failed to open [" << filename << "]" << std::endl;
+      }
+    }
+  }
+
+  // Packed records, see BoundingBoxExportFormat::BINARY
+  const bool box3D = this->type == rendering::BoundingBoxType::BBT_BOX3D;
+  const std::size_t valueCount = box3D ? 9u : 4u;
+  const std::size_t recordSize =
+      sizeof(uint32_t) + valueCount * sizeof(double);
+  auto &records = this->binaryRecords;
+  records.resize(_frame.boxes.size() * recordSize);
+  char *record = &records[0];
+  for (const auto &box : _frame.boxes)
+  {
+    const uint32_t label = box.Label();
+    double values[9];
+    values[0] = box.Center().X();
+    values[1] = box.Center().Y();
+    if (box3D)
+    {
+      values[2] = box.Center().Z();
+      values[3] = box.Size().X();
+      values[4] = box.Size().Y();
+      values[5] = box.Size().Z();
+      values[6] = box.Orientation().Roll();
+      values[7] = box.Orientation().Pitch();
+      values[8] = box.Orientation().Yaw();
+    }
+    else
+    {
+      values[2] = box.Size().X();
+      values[3] = box.Size().Y();
+    }
+    memcpy(record, &label, sizeof(label));
+    memcpy(record + sizeof(label), values, valueCount * sizeof(double));
+    record += recordSize;
+  }
+
+  char entry[20];
+  const uint64_t sample = _frame.saveCounter;
+  const uint64_t offset = this->binaryWriter->Size();
+  const uint32_t count = static_cast<uint32_t>(_frame.boxes.size());
+  memcpy(entry, &sample, sizeof(sample));
+  memcpy(entry + 8, &offset, sizeof(offset));
+  memcpy(entry + 16, &count, sizeof(count));
+
+  this->binaryWriter->Append(records.data(), records.size());
+  this->indexWriter->Append(entry, sizeof(entry));
+}
+
+//////////////////////////////////////////////////
+SensorMemoryUsage BoundingBoxCameraSensor::MemoryUsage() const
+{
+  auto frameSize =
+      [](const BoundingBoxCameraSensorPrivate::Frame &_frame)
+  {
+    return MemorySize(_frame.boxes) + MemorySize(_frame.imageBuffer) +
+        MemorySize(_frame.imageMsg) + MemorySize(_frame.boxes2DMsg) +
+        MemorySize(_frame.boxes3DMsg);
+  };
+
+  SensorMemoryUsage usage = CameraSensor::MemoryUsage();
+  usage["image"] += this->dataPtr->image.MemorySize();
+  usage["boxes"] = MemorySize(this->dataPtr->boundingBoxes);
+
+  std::size_t frames = frameSize(this->dataPtr->frame);
+  {
+    // The frame being processed by the worker isn't measured
+    std::lock_guard<std::mutex> lock(this->dataPtr->workerMutex);
+    frames += frameSize(this->dataPtr->pendingFrame);
+    if (!this->dataPtr->workerBusy)
+      frames += frameSize(this->dataPtr->workerFrame);
+  }
+  usage["frames"] = frames;
+  return usage;
+}
+
 //////////////////////////////////////////////////
 bool BoundingBoxCameraSensor::HasConnections() const
 {
@@ -743,3 +1371,10 @@ bool BoundingBoxCameraSensor::HasConnections() const
       this->dataPtr->boxesPublisher.HasConnections()) ||
       this->HasInfoConnections();
 }
+
+//////////////////////////////////////////////////
+bool BoundingBoxCameraSensor::HasRegionOfInterestSupport() const
+{
+  // Box coordinates are given in full image pixels
+  return false;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_BOXSTREAMWRITER_HH_
+#define GZ_SENSORS_BOXSTREAMWRITER_HH_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Appends records to a single file, writing them from a
+    /// background thread. Appended bytes are gathered in a buffer handed to
+    /// the thread once it holds kFlushSize bytes, so the caller never waits
+    /// for the disk and the file sees a few large writes instead of many
+    /// small ones. The thread is started by the first flush.
+    class BoxStreamWriter
+    {
+      /// \brief Number of buffered bytes that triggers a write.
+      public: static constexpr std::size_t kFlushSize = 1u << 16;
+
+      /// \brief Constructor, opens the file for appending.
+      /// \param[in] _path Path of the file, created if it doesn't exist.
+      /// Its directory must exist.
+      public: explicit BoxStreamWriter(const std::string &_path)
+      {
+        this->file = std::fopen(_path.c_str(), "ab");
+        if (this->file && std::fseek(this->file, 0, SEEK_END) == 0)
+        {
+          const long size = std::ftell(this->file);
+          this->size = size > 0 ? static_cast<uint64_t>(size) : 0u;
+        }
+      }
+
+      /// \brief Destructor. Writes the buffered bytes and closes the file.
+      public: ~BoxStreamWriter()
+      {
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->stop = true;
+        }
+        this->cv.notify_one();
+        if (this->thread.joinable())
+          this->thread.join();
+        if (this->file)
+        {
+          std::fwrite(this->buffer.data(), 1u, this->buffer.size(),
+              this->file);
+          std::fclose(this->file);
+        }
+      }
+
+      /// \brief No copy.
+      public: BoxStreamWriter(const BoxStreamWriter &) = delete;
+
+      /// \brief No copy.
+      public: BoxStreamWriter &operator=(const BoxStreamWriter &) = delete;
+
+      /// \brief Get whether the file could be opened.
+      /// \return True if the file is open.
+      public: bool IsOpen() const
+      {
+        return this->file != nullptr;
+      }
+
+      /// \brief Get the size the file will have once the appended bytes are
+      /// written, which is the offset of the next appended byte.
+      /// \return Size of the file in bytes.
+      public: uint64_t Size() const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->size;
+      }
+
+      /// \brief Append bytes to the file.
+      /// \param[in] _data Bytes to append, copied before returning.
+      /// \param[in] _count Number of bytes.
+      public: void Append(const void *_data, std::size_t _count)
+      {
+        if (!this->file)
+          return;
+
+        bool full;
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->buffer.append(static_cast<const char *>(_data), _count);
+          this->size += _count;
+          full = this->buffer.size() >= kFlushSize;
+          if (full && !this->thread.joinable())
+            this->thread = std::thread(&BoxStreamWriter::Run, this);
+        }
+        if (full)
+          this->cv.notify_one();
+      }
+
+      /// \brief Wait until every appended byte is written to the file.
+      public: void Flush()
+      {
+        if (!this->file)
+          return;
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if (!this->thread.joinable())
+          this->thread = std::thread(&BoxStreamWriter::Run, this);
+        this->flushRequested = true;
+        this->cv.notify_one();
+        this->idleCv.wait(lock, [this]
+        {
+          return !this->flushRequested && !this->writing;
+        });
+      }
+
+      /// \brief Worker thread loop.
+      private: void Run()
+      {
+        std::string data;
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true)
+        {
+          this->cv.wait(lock, [this]
+          {
+            return this->stop || this->flushRequested ||
+                this->buffer.size() >= kFlushSize;
+          });
+          if (this->stop)
+            return;
+
+          // Swapping keeps both buffers allocated across writes
+          data.clear();
+          std::swap(data, this->buffer);
+          const bool flush = this->flushRequested;
+          this->flushRequested = false;
+          this->writing = true;
+
+          lock.unlock();
+          std::fwrite(data.data(), 1u, data.size(), this->file);
+          if (flush)
+            std::fflush(this->file);
+          lock.lock();
+
+          this->writing = false;
+          this->idleCv.notify_all();
+        }
+      }
+
+      /// \brief The file.
+      private: std::FILE *file{nullptr};
+
+      /// \brief Protects the members below.
+      private: mutable std::mutex mutex;
+
+      /// \brief Signals a full buffer, a flush or that the thread must stop.
+      private: std::condition_variable cv;
+
+      /// \brief Signals that a flush is done.
+      private: std::condition_variable idleCv;
+
+      /// \brief Bytes appended since the last write.
+      private: std::string buffer;
+
+      /// \brief Size of the file once the buffer is written.
+      private: uint64_t size{0u};
+
+      /// \brief True if Flush waits for the thread.
+      private: bool flushRequested{false};
+
+      /// \brief True while the thread writes to the file.
+      private: bool writing{false};
+
+      /// \brief True to stop the thread.
+      private: bool stop{false};
+
+      /// \brief The worker thread.
+      private: std::thread thread;
+    };
+    }
+  }
+}
+
+#endif
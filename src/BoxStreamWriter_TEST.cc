@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "BoxStreamWriter.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Read a whole file.
+/// \param[in] _path Path of the file.
+/// \return Content of the file.
+std::string ReadFile(const std::string &_path)
+{
+  std::ifstream file(_path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+      std::istreambuf_iterator<char>());
+}
+
+//////////////////////////////////////////////////
+TEST(BoxStreamWriter, AppendAndFlush)
+{
+  const std::string path = ::testing::TempDir() + "/gz_box_stream_append";
+  std::remove(path.c_str());
+
+  BoxStreamWriter writer(path);
+  ASSERT_TRUE(writer.IsOpen());
+  EXPECT_EQ(0u, writer.Size());
+
+  writer.Append("abc", 3u);
+  writer.Append("de", 2u);
+  EXPECT_EQ(5u, writer.Size());
+
+  // Small records stay buffered until flushed
+  writer.Flush();
+  EXPECT_EQ("abcde", ReadFile(path));
+
+  // Large appends are written without a flush
+  const std::string large(BoxStreamWriter::kFlushSize * 3u, 'x');
+  writer.Append(large.data(), large.size());
+  writer.Append("end", 3u);
+  EXPECT_EQ(5u + large.size() + 3u, writer.Size());
+  writer.Flush();
+  EXPECT_EQ("abcde" + large + "end", ReadFile(path));
+
+  std::remove(path.c_str());
+}
+
+//////////////////////////////////////////////////
+TEST(BoxStreamWriter, AppendsToExistingFile)
+{
+  const std::string path = ::testing::TempDir() + "/gz_box_stream_existing";
+  std::remove(path.c_str());
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "head";
+  }
+
+  {
+    BoxStreamWriter writer(path);
+    ASSERT_TRUE(writer.IsOpen());
+    EXPECT_EQ(4u, writer.Size());
+    writer.Append("tail", 4u);
+    EXPECT_EQ(8u, writer.Size());
+  }
+
+  // The destructor writes the buffered bytes
+  EXPECT_EQ("headtail", ReadFile(path));
+  std::remove(path.c_str());
+}
+
+//////////////////////////////////////////////////
+TEST(BoxStreamWriter, InvalidPath)
+{
+  BoxStreamWriter writer(::testing::TempDir() + "/missing_dir/boxes");
+  EXPECT_FALSE(writer.IsOpen());
+  writer.Append("abc", 3u);
+  writer.Flush();
+  EXPECT_EQ(0u, writer.Size());
+}
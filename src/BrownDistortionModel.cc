@@ -22,6 +22,14 @@
 
 #include "gz/sensors/BrownDistortionModel.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <gz/common/Console.hh>
 #include <gz/math/Helpers.hh>
 #include <gz/math/Rand.hh>
@@ -29,8 +37,137 @@
 using namespace gz;
 using namespace sensors;
 
+namespace
+{
+#if defined(__SSE2__)
+/// \brief Two doubles processed together.
+struct Double2
+{
+  __m128d v;
+
+  Double2(__m128d _v) : v(_v) {}  // NOLINT(runtime/explicit)
+  Double2(double _s) : v(_mm_set1_pd(_s)) {}  // NOLINT(runtime/explicit)
+  static Double2 Load(const double *_p) { return _mm_loadu_pd(_p); }
+  void Store(double *_p) const { _mm_storeu_pd(_p, this->v); }
+};
+inline Double2 operator+(Double2 _a, Double2 _b)
+{ return _mm_add_pd(_a.v, _b.v); }
+inline Double2 operator-(Double2 _a, Double2 _b)
+{ return _mm_sub_pd(_a.v, _b.v); }
+inline Double2 operator*(Double2 _a, Double2 _b)
+{ return _mm_mul_pd(_a.v, _b.v); }
+inline Double2 operator/(Double2 _a, Double2 _b)
+{ return _mm_div_pd(_a.v, _b.v); }
+#define GZ_SENSORS_DOUBLE2 1
+#endif
+
+/// \brief Coefficients of the Brown model.
+struct BrownCoefficients
+{
+  double k1, k2, k3, p1, p2, cx, cy;
+};
+
+/// \brief Apply the Brown model to a normalized image position, the same
+/// way the distortion render pass does. Written once for doubles and pairs
+/// of doubles.
+/// \param[in] _c Coefficients.
+/// \param[in] _x Undistorted horizontal position.
+/// \param[in] _y Undistorted vertical position.
+/// \param[out] _dx Distorted horizontal position.
+/// \param[out] _dy Distorted vertical position.
+template <typename V>
+inline void DistortPoint(const BrownCoefficients &_c, V _x, V _y, V &_dx,
+    V &_dy)
+{
+  const V nx = _x - V(_c.cx);
+  const V ny = _y - V(_c.cy);
+  const V r2 = nx * nx + ny * ny;
+  const V radial =
+      V(1.0) + r2 * (V(_c.k1) + r2 * (V(_c.k2) + r2 * V(_c.k3)));
+  const V nxy = V(2.0) * nx * ny;
+  _dx = V(_c.cx) + nx * radial + V(_c.p2) * (r2 + V(2.0) * nx * nx) +
+      V(_c.p1) * nxy;
+  _dy = V(_c.cy) + ny * radial + V(_c.p1) * (r2 + V(2.0) * ny * ny) +
+      V(_c.p2) * nxy;
+}
+
+/// \brief Refine the undistorted position of a distorted position with a
+/// Newton step on the Brown model.
+/// \param[in] _c Coefficients.
+/// \param[in] _tx Distorted horizontal position.
+/// \param[in] _ty Distorted vertical position.
+/// \param[in,out] _x Undistorted horizontal position estimate.
+/// \param[in,out] _y Undistorted vertical position estimate.
+template <typename V>
+inline void NewtonStep(const BrownCoefficients &_c, V _tx, V _ty, V &_x,
+    V &_y)
+{
+  const V nx = _x - V(_c.cx);
+  const V ny = _y - V(_c.cy);
+  const V r2 = nx * nx + ny * ny;
+  const V radial =
+      V(1.0) + r2 * (V(_c.k1) + r2 * (V(_c.k2) + r2 * V(_c.k3)));
+  const V nxy = V(2.0) * nx * ny;
+  const V ex = V(_c.cx) + nx * radial +
+      V(_c.p2) * (r2 + V(2.0) * nx * nx) + V(_c.p1) * nxy - _tx;
+  const V ey = V(_c.cy) + ny * radial +
+      V(_c.p1) * (r2 + V(2.0) * ny * ny) + V(_c.p2) * nxy - _ty;
+
+  // Jacobian of the model
+  const V radialSlope =
+      V(2.0) * (V(_c.k1) + r2 * (V(2.0 * _c.k2) + r2 * V(3.0 * _c.k3)));
+  const V a = radial + nx * nx * radialSlope + V(6.0 * _c.p2) * nx +
+      V(2.0 * _c.p1) * ny;
+  const V b = nx * ny * radialSlope + V(2.0 * _c.p1) * nx +
+      V(2.0 * _c.p2) * ny;
+  const V d = radial + ny * ny * radialSlope + V(6.0 * _c.p1) * ny +
+      V(2.0 * _c.p2) * nx;
+  const V det = a * d - b * b;
+  _x = _x - (d * ex - b * ey) / det;
+  _y = _y - (a * ey - b * ex) / det;
+}
+
+/// \brief Number of nodes of the undistortion grid in each direction.
+constexpr int kGridSize = 33;
+
+/// \brief Lowest normalized position covered by the undistortion grid.
+constexpr double kGridMin = -0.5;
+
+/// \brief Highest normalized position covered by the undistortion grid.
+constexpr double kGridMax = 1.5;
+
+/// \brief Newton steps from the grid estimate.
+constexpr int kRefineSteps = 3;
+}
+
 class gz::sensors::BrownDistortionModel::Implementation
 {
+  /// \brief Get the coefficients.
+  /// \return The coefficients of the model.
+  public: BrownCoefficients Coefficients() const
+  {
+    return {this->k1, this->k2, this->k3, this->p1, this->p2,
+        this->lensCenter.X(), this->lensCenter.Y()};
+  }
+
+  /// \brief Compute the undistorted position of the grid nodes.
+  public: void BuildGrid();
+
+  /// \brief Estimate the undistorted position of a distorted position,
+  /// interpolating the grid.
+  /// \param[in] _x Distorted horizontal position.
+  /// \param[in] _y Distorted vertical position.
+  /// \param[out] _ux Estimated undistorted horizontal position.
+  /// \param[out] _uy Estimated undistorted vertical position.
+  public: void Estimate(double _x, double _y, double &_ux,
+              double &_uy) const;
+
+  /// \brief Undistorted horizontal position of the grid nodes, row-major.
+  public: std::vector<double> gridX;
+
+  /// \brief Undistorted vertical position of the grid nodes, row-major.
+  public: std::vector<double> gridY;
+
   /// \brief The radial distortion coefficient k1.
   public: double k1 = 0.0;
 
@@ -50,6 +187,66 @@ class gz::sensors::BrownDistortionModel::Implementation
   public: math::Vector2d lensCenter = {0.5, 0.5};
 };
 
+//////////////////////////////////////////////////
+void BrownDistortionModel::Implementation::BuildGrid()
+{
+  const BrownCoefficients c = this->Coefficients();
+  const double step = (kGridMax - kGridMin) / (kGridSize - 1);
+  this->gridX.resize(kGridSize * kGridSize);
+  this->gridY.resize(kGridSize * kGridSize);
+  for (int row = 0; row < kGridSize; ++row)
+  {
+    for (int col = 0; col < kGridSize; ++col)
+    {
+      // Neighbouring nodes are close, so start from the previous one
+      const double tx = kGridMin + col * step;
+      const double ty = kGridMin + row * step;
+      double x = col > 0 ? this->gridX[row * kGridSize + col - 1] : tx;
+      double y = col > 0 ? this->gridY[row * kGridSize + col - 1] : ty;
+      for (int i = 0; i < 20; ++i)
+        NewtonStep(c, tx, ty, x, y);
+      if (!std::isfinite(x) || !std::isfinite(y))
+      {
+        x = tx;
+        y = ty;
+      }
+      this->gridX[row * kGridSize + col] = x;
+      this->gridY[row * kGridSize + col] = y;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void BrownDistortionModel::Implementation::Estimate(double _x, double _y,
+    double &_ux, double &_uy) const
+{
+  const double scale = (kGridSize - 1) / (kGridMax - kGridMin);
+  const double gx = (_x - kGridMin) * scale;
+  const double gy = (_y - kGridMin) * scale;
+  if (this->gridX.empty() || !(gx >= 0.0 && gx <= kGridSize - 1) ||
+      !(gy >= 0.0 && gy <= kGridSize - 1))
+  {
+    _ux = _x;
+    _uy = _y;
+    return;
+  }
+
+  const int col = std::min(static_cast<int>(gx), kGridSize - 2);
+  const int row = std::min(static_cast<int>(gy), kGridSize - 2);
+  const double fx = gx - col;
+  const double fy = gy - row;
+  const int i = row * kGridSize + col;
+  auto bilinear = [&](const std::vector<double> &_grid)
+  {
+    const double top = _grid[i] + fx * (_grid[i + 1] - _grid[i]);
+    const double bottom = _grid[i + kGridSize] +
+        fx * (_grid[i + kGridSize + 1] - _grid[i + kGridSize]);
+    return top + fy * (bottom - top);
+  };
+  _ux = bilinear(this->gridX);
+  _uy = bilinear(this->gridY);
+}
+
 //////////////////////////////////////////////////
 BrownDistortionModel::BrownDistortionModel()
   : Distortion(DistortionType::BROWN),
@@ -73,6 +270,69 @@ void BrownDistortionModel::Load(const sdf::Camera &_sdf)
   this->dataPtr->p1 = _sdf.DistortionP1();
   this->dataPtr->p2 = _sdf.DistortionP2();
   this->dataPtr->lensCenter = _sdf.DistortionCenter();
+  this->dataPtr->BuildGrid();
+}
+
+//////////////////////////////////////////////////
+void BrownDistortionModel::Distort(const double *_x, const double *_y,
+    double *_outX, double *_outY, std::size_t _count) const
+{
+  const BrownCoefficients c = this->dataPtr->Coefficients();
+  std::size_t i = 0u;
+#ifdef GZ_SENSORS_DOUBLE2
+  for (; i + 2u <= _count; i += 2u)
+  {
+    Double2 dx(0.0), dy(0.0);
+    DistortPoint(c, Double2::Load(_x + i), Double2::Load(_y + i), dx, dy);
+    dx.Store(_outX + i);
+    dy.Store(_outY + i);
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    double dx, dy;
+    DistortPoint(c, _x[i], _y[i], dx, dy);
+    _outX[i] = dx;
+    _outY[i] = dy;
+  }
+}
+
+//////////////////////////////////////////////////
+void BrownDistortionModel::Undistort(const double *_x, const double *_y,
+    double *_outX, double *_outY, std::size_t _count) const
+{
+  const BrownCoefficients c = this->dataPtr->Coefficients();
+
+  // Grid estimates are written to the output first, so the outputs may
+  // alias the inputs as long as each point is read before it's written
+  std::size_t i = 0u;
+#ifdef GZ_SENSORS_DOUBLE2
+  for (; i + 2u <= _count; i += 2u)
+  {
+    const Double2 tx = Double2::Load(_x + i);
+    const Double2 ty = Double2::Load(_y + i);
+    double ux[2], uy[2];
+    this->dataPtr->Estimate(_x[i], _y[i], ux[0], uy[0]);
+    this->dataPtr->Estimate(_x[i + 1u], _y[i + 1u], ux[1], uy[1]);
+    Double2 x = Double2::Load(ux);
+    Double2 y = Double2::Load(uy);
+    for (int step = 0; step < kRefineSteps; ++step)
+      NewtonStep(c, tx, ty, x, y);
+    x.Store(_outX + i);
+    y.Store(_outY + i);
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    const double tx = _x[i];
+    const double ty = _y[i];
+    double x, y;
+    this->dataPtr->Estimate(tx, ty, x, y);
+    for (int step = 0; step < kRefineSteps; ++step)
+      NewtonStep(c, tx, ty, x, y);
+    _outX[i] = x;
+    _outY[i] = y;
+  }
 }
 
 //////////////////////////////////////////////////
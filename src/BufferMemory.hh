@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_BUFFERMEMORY_HH_
+#define GZ_SENSORS_BUFFERMEMORY_HH_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <gz/common/Console.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Sensor.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Size of a transparent huge page on x86-64 and most aarch64
+    /// kernels.
+    constexpr std::size_t kHugePageSize = 2u * 1024u * 1024u;
+
+    /// \brief Alignment of default buffer memory, a cache line.
+    constexpr std::size_t kBufferAlignment = 64u;
+
+    /// \brief Warn once per process that a kind of memory isn't available.
+    /// \param[in] _flag Flag of the kind of memory.
+    /// \param[in] _what Description of the failure.
+    inline void WarnBufferMemoryOnce(std::atomic<bool> &_flag,
+        const char *_what)
+    {
+      if (!_flag.exchange(true))
+      {
+        gzwarn << _what << ", sensor buffers use regular memory instead."
+               << std::endl;
+      }
+    }
+
+    /// \brief Allocate memory for a sensor buffer. Huge page buffers are
+    /// aligned and rounded up to kHugePageSize and advised to the kernel as
+    /// transparent huge pages. Pinned buffers are page aligned and locked
+    /// in RAM, so a readback never faults on a page that was swapped out.
+    /// When the requested kind isn't available, such as on other platforms
+    /// than Linux, past the memory lock limit or for buffers smaller than a
+    /// huge page, regular memory is used.
+    /// \param[in] _bytes Number of bytes, not zero.
+    /// \param[in,out] _memory Requested kind of memory, set to the kind
+    /// that was allocated.
+    /// \return The memory, to be given to FreeBufferMemory.
+    inline void *AllocateBufferMemory(std::size_t _bytes,
+        SensorBufferMemory &_memory)
+    {
+#ifdef __linux__
+      if (_memory == SensorBufferMemory::HUGE_PAGES &&
+          _bytes >= kHugePageSize)
+      {
+        const std::size_t size =
+            (_bytes + kHugePageSize - 1u) / kHugePageSize * kHugePageSize;
+        void *data = nullptr;
+        if (posix_memalign(&data, kHugePageSize, size) == 0)
+        {
+          static std::atomic<bool> warned{false};
+          if (madvise(data, size, MADV_HUGEPAGE) != 0)
+          {
+            WarnBufferMemoryOnce(warned,
+                "Transparent huge pages aren't supported by the kernel");
+          }
+          return data;
+        }
+      }
+      else if (_memory == SensorBufferMemory::PINNED)
+      {
+        const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const std::size_t size = (_bytes + page - 1u) / page * page;
+        void *data = nullptr;
+        if (posix_memalign(&data, page, size) == 0)
+        {
+          if (mlock(data, size) == 0)
+            return data;
+          static std::atomic<bool> warned{false};
+          WarnBufferMemoryOnce(warned,
+              "The memory lock limit (ulimit -l) was reached");
+          std::free(data);
+        }
+      }
+#endif
+      _memory = SensorBufferMemory::DEFAULT;
+      return ::operator new[](_bytes, std::align_val_t(kBufferAlignment));
+    }
+
+    /// \brief Free memory returned by AllocateBufferMemory.
+    /// \param[in] _data The memory, may be null.
+    /// \param[in] _bytes Number of bytes it was allocated with.
+    /// \param[in] _memory Kind of memory AllocateBufferMemory allocated.
+    inline void FreeBufferMemory(void *_data, std::size_t _bytes,
+        SensorBufferMemory _memory)
+    {
+      if (!_data)
+        return;
+      if (_memory == SensorBufferMemory::DEFAULT)
+      {
+        ::operator delete[](_data, std::align_val_t(kBufferAlignment));
+        return;
+      }
+#ifdef __linux__
+      if (_memory == SensorBufferMemory::PINNED)
+      {
+        const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        munlock(_data, (_bytes + page - 1u) / page * page);
+      }
+#endif
+      (void)_bytes;
+      std::free(_data);
+    }
+
+    /// \brief Applies a kind of memory to a buffer allocated by a library,
+    /// such as the image of a rendering camera, for as long as this object
+    /// lives. Huge pages are advised for the huge pages that fit inside the
+    /// buffer. Pinned buffers are locked in RAM and unlocked on Reset.
+    /// The buffer must outlive this object or its next Reset.
+    class BufferMemoryAdvice
+    {
+      /// \brief Default constructor
+      public: BufferMemoryAdvice() = default;
+
+      /// \brief Destructor, unlocks a pinned buffer.
+      public: ~BufferMemoryAdvice()
+      {
+        this->Reset();
+      }
+
+      /// \brief No copy constructor
+      public: BufferMemoryAdvice(const BufferMemoryAdvice &) = delete;
+
+      /// \brief No copy assignment
+      public: BufferMemoryAdvice &operator=(
+                  const BufferMemoryAdvice &) = delete;
+
+      /// \brief Apply a kind of memory to a buffer, after resetting the
+      /// previous one.
+      /// \param[in] _data Start of the buffer.
+      /// \param[in] _bytes Size of the buffer in bytes.
+      /// \param[in] _memory Requested kind of memory.
+      /// \return The kind of memory applied, DEFAULT if none could be.
+      public: SensorBufferMemory Apply(void *_data, std::size_t _bytes,
+                  SensorBufferMemory _memory)
+      {
+        this->Reset();
+        if (!_data || _bytes == 0u)
+          return SensorBufferMemory::DEFAULT;
+#ifdef __linux__
+        const auto start = reinterpret_cast<std::uintptr_t>(_data);
+        if (_memory == SensorBufferMemory::HUGE_PAGES)
+        {
+          const std::uintptr_t first = (start + kHugePageSize - 1u) /
+              kHugePageSize * kHugePageSize;
+          const std::uintptr_t last =
+              (start + _bytes) / kHugePageSize * kHugePageSize;
+          if (last > first &&
+              madvise(reinterpret_cast<void *>(first), last - first,
+                  MADV_HUGEPAGE) == 0)
+          {
+            return SensorBufferMemory::HUGE_PAGES;
+          }
+        }
+        else if (_memory == SensorBufferMemory::PINNED)
+        {
+          if (mlock(_data, _bytes) == 0)
+          {
+            this->locked = _data;
+            this->lockedBytes = _bytes;
+            return SensorBufferMemory::PINNED;
+          }
+          static std::atomic<bool> warned{false};
+          WarnBufferMemoryOnce(warned,
+              "The memory lock limit (ulimit -l) was reached");
+        }
+#endif
+        return SensorBufferMemory::DEFAULT;
+      }
+
+      /// \brief Unlock the buffer if it's pinned. Huge page advice can't be
+      /// undone and stays with the memory.
+      public: void Reset()
+      {
+#ifdef __linux__
+        if (this->locked)
+          munlock(this->locked, this->lockedBytes);
+#endif
+        this->locked = nullptr;
+        this->lockedBytes = 0u;
+      }
+
+      /// \brief Locked buffer, null if none.
+      private: void *locked{nullptr};
+
+      /// \brief Size of the locked buffer in bytes.
+      private: std::size_t lockedBytes{0u};
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/image.pb.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+#include <gz/msgs/Utility.hh>
+#include <gz/transport/Node.hh>
+
+#include "gz/sensors/CameraGroup.hh"
+#include "gz/sensors/CameraSensor.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Private data for CameraGroup
+class gz::sensors::CameraGroupPrivate
+{
+  /// \brief Store the image view of a camera in the batch, and emit the
+  /// batch once it's complete.
+  /// \param[in] _index Index of the camera.
+  /// \param[in] _view Image of the camera.
+  public: void OnImage(std::size_t _index, const ImageView &_view);
+
+  /// \brief Give a complete batch to the callbacks and the topic.
+  public: void EmitBatch();
+
+  /// \brief Forget the images of the current batch.
+  public: void ResetBatch();
+
+  /// \brief Protects all the members below. Recursive so that batch
+  /// callbacks can query the group.
+  public: mutable std::recursive_mutex mutex;
+
+  /// \brief Cameras of the group.
+  public: std::vector<CameraSensor *> cameras;
+
+  /// \brief Connections to the image views of the cameras.
+  public: std::vector<common::ConnectionPtr> connections;
+
+  /// \brief Images of the current batch, camera after camera.
+  public: std::vector<unsigned char> buffer;
+
+  /// \brief Whether each camera's image of the current batch arrived.
+  public: std::vector<bool> received;
+
+  /// \brief Number of images of the current batch that arrived.
+  public: std::size_t receivedCount{0u};
+
+  /// \brief Time of the current batch.
+  public: std::chrono::steady_clock::duration time{0};
+
+  /// \brief Size of an image in bytes, 0 until the first image.
+  public: std::size_t imageSize{0u};
+
+  /// \brief Width of the images.
+  public: unsigned int width{0u};
+
+  /// \brief Height of the images.
+  public: unsigned int height{0u};
+
+  /// \brief Pixel format of the images.
+  public: common::Image::PixelFormatType format{
+      common::Image::UNKNOWN_PIXEL_FORMAT};
+
+  /// \brief Number of complete batches.
+  public: uint64_t batches{0u};
+
+  /// \brief Event that is used to trigger callbacks with a batch
+  public: common::EventT<void(const CameraBatch &)> batchEvent;
+
+  /// \brief Node to publish the batches.
+  public: transport::Node node;
+
+  /// \brief Topic of the batches.
+  public: std::string topic;
+
+  /// \brief Publisher of the batches.
+  public: transport::Node::Publisher pub;
+
+  /// \brief Batch message, reused across batches.
+  public: msgs::Image msg;
+};
+
+namespace
+{
+/// \brief Get the message pixel format of an image pixel format.
+/// \param[in] _format Image pixel format.
+/// \return Message pixel format, UNKNOWN_PIXEL_FORMAT if it isn't one of
+/// the camera formats.
+msgs::PixelFormatType MsgsFormat(common::Image::PixelFormatType _format)
+{
+  switch (_format)
+  {
+    case common::Image::RGB_INT8:
+      return msgs::PixelFormatType::RGB_INT8;
+    case common::Image::L_INT8:
+      return msgs::PixelFormatType::L_INT8;
+    case common::Image::L_INT16:
+      return msgs::PixelFormatType::L_INT16;
+    case common::Image::BAYER_RGGB8:
+      return msgs::PixelFormatType::BAYER_RGGB8;
+    case common::Image::BAYER_BGGR8:
+      return msgs::PixelFormatType::BAYER_BGGR8;
+    case common::Image::BAYER_GBRG8:
+      return msgs::PixelFormatType::BAYER_GBRG8;
+    case common::Image::BAYER_GRBG8:
+      return msgs::PixelFormatType::BAYER_GRBG8;
+    default:
+      return msgs::PixelFormatType::UNKNOWN_PIXEL_FORMAT;
+  }
+}
+}
+
+//////////////////////////////////////////////////
+CameraGroup::CameraGroup()
+  : dataPtr(new CameraGroupPrivate())
+{
+}
+
+//////////////////////////////////////////////////
+CameraGroup::~CameraGroup()
+{
+  // Stop receiving images before the data is destroyed
+  this->dataPtr->connections.clear();
+}
+
+//////////////////////////////////////////////////
+bool CameraGroup::AddCamera(CameraSensor *_camera)
+{
+  if (!_camera)
+  {
+    gzerr << "Can't add a null camera to a camera group." << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(this->dataPtr->mutex);
+  auto &cameras = this->dataPtr->cameras;
+  if (std::find(cameras.begin(), cameras.end(), _camera) != cameras.end())
+  {
+    gzerr << "Camera [" << _camera->Name() << "] is already in the group."
+          << std::endl;
+    return false;
+  }
+
+  if (!cameras.empty())
+  {
+    const CameraSensor *first = cameras.front();
+    const auto firstCamera = first->RenderingCamera();
+    const auto camera = _camera->RenderingCamera();
+    if (_camera->ImageWidth() != first->ImageWidth() ||
+        _camera->ImageHeight() != first->ImageHeight() ||
+        (camera && firstCamera &&
+         camera->ImageFormat() != firstCamera->ImageFormat()))
+    {
+      gzerr << "Camera [" << _camera->Name() << "] doesn't have the image "
+            << "size and format of camera [" << first->Name()
+            << "], it can't be added to the group." << std::endl;
+      return false;
+    }
+  }
+
+  const std::size_t index = cameras.size();
+  cameras.push_back(_camera);
+  CameraGroupPrivate *data = this->dataPtr.get();
+  this->dataPtr->connections.push_back(_camera->ConnectImageViewCallback(
+      [data, index](const ImageView &_view)
+      {
+        data->OnImage(index, _view);
+      }));
+  this->dataPtr->received.assign(cameras.size(), false);
+  this->dataPtr->buffer.resize(this->dataPtr->imageSize * cameras.size());
+  this->dataPtr->ResetBatch();
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t CameraGroup::CameraCount() const
+{
+  std::lock_guard<std::recursive_mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->cameras.size();
+}
+
+//////////////////////////////////////////////////
+bool CameraGroup::SetTopic(const std::string &_topic)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->dataPtr->mutex);
+  auto pub = this->dataPtr->node.Advertise<msgs::Image>(_topic);
+  if (!pub)
+  {
+    gzerr << "Unable to create publisher on topic [" << _topic << "]."
+          << std::endl;
+    return false;
+  }
+  this->dataPtr->pub = pub;
+  this->dataPtr->topic = _topic;
+  gzdbg << "Camera group batches advertised on [" << _topic << "]"
+        << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string CameraGroup::Topic() const
+{
+  std::lock_guard<std::recursive_mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->topic;
+}
+
+//////////////////////////////////////////////////
+common::ConnectionPtr CameraGroup::ConnectBatchCallback(
+    std::function<void(const CameraBatch &)> _callback)
+{
+  return this->dataPtr->batchEvent.Connect(_callback);
+}
+
+//////////////////////////////////////////////////
+uint64_t CameraGroup::BatchCount() const
+{
+  std::lock_guard<std::recursive_mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->batches;
+}
+
+//////////////////////////////////////////////////
+void CameraGroupPrivate::ResetBatch()
+{
+  std::fill(this->received.begin(), this->received.end(), false);
+  this->receivedCount = 0u;
+}
+
+//////////////////////////////////////////////////
+void CameraGroupPrivate::OnImage(std::size_t _index, const ImageView &_view)
+{
+  GZ_PROFILE("CameraGroup::OnImage");
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  if (this->imageSize == 0u)
+  {
+    // The first image sets the layout of the batch
+    this->imageSize = _view.size;
+    this->width = _view.width;
+    this->height = _view.height;
+    this->format = _view.format;
+    this->buffer.resize(this->imageSize * this->cameras.size());
+  }
+  else if (_view.size != this->imageSize || _view.width != this->width ||
+      _view.height != this->height || _view.format != this->format)
+  {
+    gzerr << "Image of camera [" << this->cameras[_index]->Name()
+          << "] doesn't match the layout of the camera group, skipped."
+          << std::endl;
+    return;
+  }
+
+  // An image of a new time starts a new batch, incomplete ones are dropped
+  if (this->receivedCount > 0u && _view.time != this->time)
+    this->ResetBatch();
+  this->time = _view.time;
+
+  if (!this->received[_index])
+  {
+    std::memcpy(this->buffer.data() + _index * this->imageSize, _view.data,
+        this->imageSize);
+    this->received[_index] = true;
+    ++this->receivedCount;
+  }
+
+  if (this->receivedCount == this->cameras.size())
+  {
+    this->EmitBatch();
+    this->ResetBatch();
+  }
+}
+
+//////////////////////////////////////////////////
+void CameraGroupPrivate::EmitBatch()
+{
+  ++this->batches;
+  if (this->batchEvent.ConnectionCount() > 0u)
+  {
+    CameraBatch batch;
+    batch.time = this->time;
+    batch.data = this->buffer.data();
+    batch.size = this->buffer.size();
+    batch.count = this->cameras.size();
+    batch.width = this->width;
+    batch.height = this->height;
+    batch.format = this->format;
+    try
+    {
+      this->batchEvent(batch);
+    }
+    catch(...)
+    {
+      gzerr << "Exception thrown in a camera batch callback.\n";
+    }
+  }
+
+  if (!this->pub || !this->pub.HasConnections())
+    return;
+
+  GZ_PROFILE("CameraGroup::EmitBatch Publish");
+  const unsigned int count = static_cast<unsigned int>(this->cameras.size());
+  this->msg.set_width(this->width);
+  this->msg.set_height(this->height * count);
+  this->msg.set_step(this->height > 0u ?
+      static_cast<unsigned int>(this->imageSize / this->height) : 0u);
+  this->msg.set_pixel_format_type(MsgsFormat(this->format));
+  auto *header = this->msg.mutable_header();
+  header->Clear();
+  *header->mutable_stamp() = msgs::Convert(this->time);
+  auto *entry = header->add_data();
+  entry->set_key("batch_size");
+  entry->add_value(std::to_string(count));
+  this->msg.set_data(this->buffer.data(), this->buffer.size());
+  this->pub.Publish(this->msg);
+}
@@ -19,7 +19,13 @@
 #include <gz/msgs/camera_info.pb.h>
 #include <gz/msgs/image.pb.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <gz/common/Console.hh>
 #include <gz/common/Event.hh>
@@ -28,6 +34,7 @@
 #include <gz/common/StringUtils.hh>
 #include <gz/math/Angle.hh>
 #include <gz/math/Helpers.hh>
+#include <gz/math/Pose3.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
 
@@ -36,16 +43,66 @@
 #include "gz/sensors/ImageDistortion.hh"
 #include "gz/sensors/ImageGaussianNoiseModel.hh"
 #include "gz/sensors/ImageNoise.hh"
+#include "gz/sensors/ImageWriter.hh"
 #include "gz/sensors/Manager.hh"
 #include "gz/sensors/RenderingEvents.hh"
 #include "gz/sensors/SensorFactory.hh"
 #include "gz/sensors/SensorTypes.hh"
 
+#include "AlignedBuffer.hh"
+#include "BufferMemory.hh"
+#include "FrameAccumulator.hh"
+#include "ImageCompressor.hh"
+#include "ImageRegion.hh"
+#include "ImageUpsampler.hh"
+#include "MemorySize.hh"
+#include "OpticalFlow.hh"
+#include "PixelConversion.hh"
+#include "TraceRecorder.hh"
+
+#include <gz/rendering/DepthCamera.hh>
 #include <gz/rendering/Utils.hh>
 
 using namespace gz;
 using namespace sensors;
 
+/// \brief Image published at a fraction of the camera resolution.
+struct DownsampledOutput
+{
+  /// \brief Size of the pixel blocks averaged into one pixel.
+  unsigned int factor{1u};
+
+  /// \brief Topic of the output.
+  std::string topic;
+
+  /// \brief Publisher of the output.
+  transport::Node::Publisher pub;
+
+  /// \brief Image message, kept across updates so that its pixel buffer
+  /// is reused.
+  msgs::Image msg;
+
+  /// \brief True if msg holds the current frame.
+  bool generated{false};
+};
+
+/// \brief Image published in another pixel format.
+struct ConvertedOutput
+{
+  /// \brief Pixel format of the output.
+  ConvertedPixelFormat format{ConvertedPixelFormat::MONO8};
+
+  /// \brief Topic of the output.
+  std::string topic;
+
+  /// \brief Publisher of the output.
+  transport::Node::Publisher pub;
+
+  /// \brief Image message, kept across updates so that its pixel buffer
+  /// is reused.
+  msgs::Image msg;
+};
+
 /// \brief Private data for CameraSensor
 class gz::sensors::CameraSensorPrivate
 {
@@ -61,6 +118,42 @@ class gz::sensors::CameraSensorPrivate
   public: bool SaveImage(const unsigned char *_data, unsigned int _width,
     unsigned int _height, gz::common::Image::PixelFormatType _format);
 
+  /// \brief Set the projection matrix of the camera from the lens
+  /// intrinsics and projection of the SDF, or fill them in from the
+  /// camera's projection if the SDF doesn't have them.
+  /// \param[in,out] _cameraSdf Camera SDF.
+  public: void UpdateProjection(sdf::Camera &_cameraSdf);
+
+  /// \brief Refresh the width, height, step and pixel format of imageMsg,
+  /// imageFormat and imageSize if the camera was resized, its pixel
+  /// format changed or the region of interest changed since the last call.
+  public: void UpdateImageTemplate();
+
+  /// \brief Get the region of interest and decimation inside an image.
+  /// \param[in] _width Width of the full image.
+  /// \param[in] _height Height of the full image.
+  /// \return The region, clamped to the image.
+  public: ImageRegion Region(unsigned int _width, unsigned int _height) const;
+
+  /// \brief Update regionInfoMsg from infoMsg and the region of interest.
+  public: void UpdateRegionInfo();
+
+  /// \brief Apply a change of the region of interest or decimation.
+  public: void OnRegionChanged();
+
+  /// \brief Compute the number of sub-frames of the next image and
+  /// where the exposure starts, from the motion of the camera since the
+  /// previous image.
+  /// \param[in] _pose Pose of the camera for the next image.
+  /// \param[in] _enabled False if sub-frames can't be rendered, the
+  /// image then has a single frame.
+  public: void UpdateMotionBlur(const math::Pose3d &_pose, bool _enabled);
+
+  /// \brief Give the render target of the last frame to the GPU frame
+  /// callbacks.
+  /// \param[in] _time Time the frame was rendered for.
+  public: void EmitGpuFrame(const std::chrono::steady_clock::duration &_time);
+
   /// \brief Computes the OpenGL NDC matrix
   /// \param[in] _left Left vertical clipping plane
   /// \param[in] _right Right vertical clipping plane
@@ -133,6 +226,76 @@ class gz::sensors::CameraSensorPrivate
   /// \brief Camera info publisher to publish images
   public: transport::Node::Publisher infoPub;
 
+  /// \brief Publisher of compressed images
+  public: transport::Node::Publisher compressedPub;
+
+  /// \brief Encodes and publishes compressed images, null unless
+  /// compressed output is enabled.
+  public: std::unique_ptr<ImageCompressor> compressor;
+
+  /// \brief Downsampled outputs, sorted by increasing factor.
+  public: std::vector<DownsampledOutput> downsampledOutputs;
+
+  /// \brief Block sums of a row, reused by the downsampling kernel.
+  public: std::vector<uint32_t> binSums;
+
+  /// \brief Outputs in other pixel formats.
+  public: std::vector<ConvertedOutput> convertedOutputs;
+
+  /// \brief Rows per tile, 0 if tiled output is disabled.
+  public: unsigned int tileRows{0u};
+
+  /// \brief Topic of the tiles.
+  public: std::string tilesTopic;
+
+  /// \brief Publisher of the tiles.
+  public: transport::Node::Publisher tilesPub;
+
+  /// \brief Tile message, reused for all tiles.
+  public: msgs::Image tileMsg;
+
+  /// \brief Number of frames published as tiles.
+  public: uint64_t tiledFrames{0u};
+
+  /// \brief Fraction of the time between images the shutter is open, 0
+  /// if motion blur is disabled.
+  public: double blurExposure{0.0};
+
+  /// \brief Largest number of frames rendered per image.
+  public: unsigned int blurMaxSubFrames{1u};
+
+  /// \brief Number of frames rendered for the current image.
+  public: unsigned int subFrames{1u};
+
+  /// \brief Pose of the camera at the previous image.
+  public: math::Pose3d blurPrevPose;
+
+  /// \brief Pose of the camera at the current image.
+  public: math::Pose3d blurPose;
+
+  /// \brief True if blurPrevPose is the pose of the previous image.
+  public: bool blurHasPrevPose{false};
+
+  /// \brief Position between blurPrevPose and blurPose where the exposure
+  /// starts, in [0, 1].
+  public: double blurStart{1.0};
+
+  /// \brief Sums the sub-frames of the motion blur.
+  public: FrameAccumulator blurAccumulator;
+
+  /// \brief Fraction of the published resolution rendered.
+  public: double renderScale{1.0};
+
+  /// \brief Image rendered at the render scale, empty if the scale is 1.
+  public: gz::rendering::Image renderImage;
+
+  /// \brief Kind of memory applied to renderImage, declared after it so
+  /// it's reset before the image is freed.
+  public: BufferMemoryAdvice renderImageMemory;
+
+  /// \brief Upsamples renderImage to image.
+  public: ImageUpsampler upsampler;
+
   /// \brief true if Load() has been called and was successful
   public: bool initialized = false;
 
@@ -142,17 +305,85 @@ class gz::sensors::CameraSensorPrivate
   /// \brief Pointer to an image to be published
   public: gz::rendering::Image image;
 
+  /// \brief Kind of memory applied to image, declared after it so it's
+  /// reset before the image is freed.
+  public: BufferMemoryAdvice imageMemory;
+
+  /// \brief Image message, kept across updates so that its pixel buffer
+  /// is reused instead of allocated for every frame.
+  public: msgs::Image imageMsg;
+
+  /// \brief Camera pixel format imageMsg was last set up for.
+  public: rendering::PixelFormat templateFormat{rendering::PF_UNKNOWN};
+
+  /// \brief Pixel format of the images, matching templateFormat.
+  public: common::Image::PixelFormatType imageFormat{
+      common::Image::UNKNOWN_PIXEL_FORMAT};
+
+  /// \brief Camera image width imageMsg was last set up for.
+  public: unsigned int templateWidth{0u};
+
+  /// \brief Camera image height imageMsg was last set up for.
+  public: unsigned int templateHeight{0u};
+
+  /// \brief Number of bytes of a pixel, matching templateFormat.
+  public: unsigned int bytesPerPixel{0u};
+
+  /// \brief Number of bytes of a published image, matching templateFormat.
+  public: std::size_t imageSize{0u};
+
+  /// \brief First column of the region of interest.
+  public: unsigned int regionX{0u};
+
+  /// \brief First row of the region of interest.
+  public: unsigned int regionY{0u};
+
+  /// \brief Width of the region of interest, zero for the full width.
+  public: unsigned int regionWidth{0u};
+
+  /// \brief Height of the region of interest, zero for the full height.
+  public: unsigned int regionHeight{0u};
+
+  /// \brief One pixel out of decimation is published in each direction.
+  public: unsigned int decimation{1u};
+
+  /// \brief True if a region of interest or a decimation is set.
+  public: bool regionEnabled{false};
+
+  /// \brief Cropped and decimated image, unused for full frames.
+  public: std::vector<unsigned char> regionBuffer;
+
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
 
   /// \brief Distortion added to sensor data
   public: DistortionPtr distortion;
 
+  /// \brief The distortion if it's applied to the frames on the CPU
+  public: std::shared_ptr<ImageBrownDistortionModel> cpuDistortion;
+
+  /// \brief Distorted frame, for the CPU distortion
+  public: std::vector<unsigned char> distortedBuffer;
+
+  /// \brief The image noise if it's applied to the frames on the CPU
+  public: std::shared_ptr<ImageGaussianNoiseModel> cpuNoise;
+
   /// \brief Event that is used to trigger callbacks when a new image
   /// is generated
   public: gz::common::EventT<
           void(const gz::msgs::Image &)> imageEvent;
 
+  /// \brief Event that is used to trigger callbacks with a view of a new
+  /// image
+  public: gz::common::EventT<void(const ImageView &)> imageViewEvent;
+
+  /// \brief Event that is used to trigger callbacks with the render target
+  /// of a new frame
+  public: gz::common::EventT<void(const GpuFrame &)> gpuFrameEvent;
+
+  /// \brief Number of GPU frames produced.
+  public: uint64_t gpuFrames{0u};
+
   /// \brief Connection to the Manager's scene change event.
   public: gz::common::ConnectionPtr sceneChangeConnection;
 
@@ -186,6 +417,31 @@ class gz::sensors::CameraSensorPrivate
   /// \brief Camera information message.
   public: msgs::CameraInfo infoMsg;
 
+  /// \brief Camera information of the region of interest, published
+  /// instead of infoMsg when regionEnabled is true.
+  public: msgs::CameraInfo regionInfoMsg;
+
+  /// \brief Incremented whenever the camera information changes.
+  public: uint64_t infoVersion{0u};
+
+  /// \brief Version of the camera information last published.
+  public: uint64_t publishedInfoVersion{0u};
+
+  /// \brief Time at which the camera information was last published.
+  public: std::chrono::steady_clock::duration infoTime{0};
+
+  /// \brief True if the camera info topic had subscribers the last time
+  /// it was checked.
+  public: bool infoConnected{false};
+
+  /// \brief True to only publish the camera information when it changes,
+  /// when it gets subscribers, and on heartbeats.
+  public: bool infoOnChange{false};
+
+  /// \brief Period of the camera information heartbeat, zero to disable.
+  public: std::chrono::steady_clock::duration infoHeartbeat{
+      std::chrono::seconds(1)};
+
   /// \brief The frame this camera uses in its camera_info topic.
   public: std::string opticalFrameId{""};
 
@@ -197,8 +453,121 @@ class gz::sensors::CameraSensorPrivate
 
   /// \brief Flag to indicate if sensor is generating data
   public: bool generatingData = false;
+
+  /// \brief Publisher of the optical flow.
+  public: transport::Node::Publisher flowPub;
+
+  /// \brief Depth camera of the optical flow, null while the flow has no
+  /// subscribers.
+  public: rendering::DepthCameraPtr flowCamera;
+
+  /// \brief Connection to the depth frames of the flow camera.
+  public: common::ConnectionPtr flowDepthConnection;
+
+  /// \brief Last depths of the flow camera.
+  public: AlignedBuffer<float> flowDepth;
+
+  /// \brief Width of the depths in flowDepth.
+  public: unsigned int flowWidth{0u};
+
+  /// \brief Height of the depths in flowDepth.
+  public: unsigned int flowHeight{0u};
+
+  /// \brief Pose of the flow camera when flowDepth was rendered.
+  public: math::Pose3d flowDepthPose;
+
+  /// \brief Pose of the flow camera at the last published flow image.
+  public: math::Pose3d flowPrevPose;
+
+  /// \brief True once flowPrevPose is set.
+  public: bool flowHasPrevPose{false};
+
+  /// \brief Optical flow, 3 floats per pixel.
+  public: std::vector<float> flowBuffer;
+
+  /// \brief Optical flow message, reused across updates.
+  public: msgs::Image flowMsg;
 };
 
+//////////////////////////////////////////////////
+void CameraSensorPrivate::UpdateProjection(sdf::Camera &_cameraSdf)
+{
+  // Update the DOM object intrinsics to have consistent
+  // intrinsics between ogre camera and camera_info msg
+  if(!_cameraSdf.HasLensIntrinsics())
+  {
+    auto intrinsicMatrix =
+      gz::rendering::projectionToCameraIntrinsic(
+        this->camera->ProjectionMatrix(),
+        this->camera->ImageWidth(),
+        this->camera->ImageHeight()
+      );
+
+    _cameraSdf.SetLensIntrinsicsFx(intrinsicMatrix(0, 0));
+    _cameraSdf.SetLensIntrinsicsFy(intrinsicMatrix(1, 1));
+    _cameraSdf.SetLensIntrinsicsCx(intrinsicMatrix(0, 2));
+    _cameraSdf.SetLensIntrinsicsCy(intrinsicMatrix(1, 2));
+  }
+  // set custom projection matrix based on intrinsics param specified in sdf
+  else
+  {
+    double fx = _cameraSdf.LensIntrinsicsFx();
+    double fy = _cameraSdf.LensIntrinsicsFy();
+    double cx = _cameraSdf.LensIntrinsicsCx();
+    double cy = _cameraSdf.LensIntrinsicsCy();
+    double s = _cameraSdf.LensIntrinsicsSkew();
+    auto projectionMatrix = BuildProjectionMatrix(
+        this->camera->ImageWidth(),
+        this->camera->ImageHeight(),
+        fx, fy, cx, cy, s,
+        this->camera->NearClipPlane(),
+        this->camera->FarClipPlane());
+    this->camera->SetProjectionMatrix(projectionMatrix);
+  }
+
+  // Update the DOM object intrinsics to have consistent
+  // projection matrix values between ogre camera and camera_info msg
+  // If these values are not defined in the SDF then we need to update
+  // these values to something reasonable. The projection matrix is
+  // the cumulative effect of intrinsic and extrinsic parameters
+  if(!_cameraSdf.HasLensProjection())
+  {
+    // Note that the matrix from Ogre via camera->ProjectionMatrix() has a
+    // different format than the projection matrix used in SDFormat.
+    // This is why they are converted using projectionToCameraIntrinsic.
+    // The resulting matrix is the intrinsic matrix, but since the user has
+    // not overridden the values, this is also equal to the projection matrix.
+    auto intrinsicMatrix =
+      gz::rendering::projectionToCameraIntrinsic(
+        this->camera->ProjectionMatrix(),
+        this->camera->ImageWidth(),
+        this->camera->ImageHeight()
+      );
+    _cameraSdf.SetLensProjectionFx(intrinsicMatrix(0, 0));
+    _cameraSdf.SetLensProjectionFy(intrinsicMatrix(1, 1));
+    _cameraSdf.SetLensProjectionCx(intrinsicMatrix(0, 2));
+    _cameraSdf.SetLensProjectionCy(intrinsicMatrix(1, 2));
+  }
+  // set custom projection matrix based on projection param specified in sdf
+  else
+  {
+    // tx and ty are not used
+    double fx = _cameraSdf.LensProjectionFx();
+    double fy = _cameraSdf.LensProjectionFy();
+    double cx = _cameraSdf.LensProjectionCx();
+    double cy = _cameraSdf.LensProjectionCy();
+    double s = 0;
+
+    auto projectionMatrix = BuildProjectionMatrix(
+        this->camera->ImageWidth(),
+        this->camera->ImageHeight(),
+        fx, fy, cx, cy, s,
+        this->camera->NearClipPlane(),
+        this->camera->FarClipPlane());
+    this->camera->SetProjectionMatrix(projectionMatrix);
+  }
+}
+
 //////////////////////////////////////////////////
 bool CameraSensor::CreateCamera()
 {
@@ -232,9 +601,11 @@ bool CameraSensor::CreateCamera()
       this->dataPtr->noises[noiseType] =
         ImageNoiseFactory::NewNoiseModel(noiseSdf, "camera");
 
-      std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
-           this->dataPtr->noises[noiseType])->SetCamera(
-             this->dataPtr->camera);
+      auto imageNoise = std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
+          this->dataPtr->noises[noiseType]);
+      imageNoise->SetCamera(this->dataPtr->camera);
+      this->dataPtr->cpuNoise =
+          imageNoise->AppliesOnCpu() ? imageNoise : nullptr;
     }
     else if (noiseSdf.Type() != sdf::NoiseType::NONE)
     {
@@ -263,8 +634,10 @@ bool CameraSensor::CreateCamera()
         ImageDistortionFactory::NewDistortionModel(*cameraSdf, "camera");
     this->dataPtr->distortion->Load(*cameraSdf);
 
-    std::dynamic_pointer_cast<ImageBrownDistortionModel>(
-        this->dataPtr->distortion)->SetCamera(this->dataPtr->camera);
+    auto brown = std::dynamic_pointer_cast<ImageBrownDistortionModel>(
+        this->dataPtr->distortion);
+    brown->SetCamera(this->dataPtr->camera);
+    this->dataPtr->cpuDistortion = brown->DistortsOnCpu() ? brown : nullptr;
   }
 
   sdf::PixelFormatType pixelFormat = cameraSdf->PixelFormat();
@@ -297,40 +670,16 @@ bool CameraSensor::CreateCamera()
       break;
   }
 
-  // Update the DOM object intrinsics to have consistent
-  // intrinsics between ogre camera and camera_info msg
-  if(!cameraSdf->HasLensIntrinsics())
-  {
-    auto intrinsicMatrix =
-      gz::rendering::projectionToCameraIntrinsic(
-        this->dataPtr->camera->ProjectionMatrix(),
-        this->dataPtr->camera->ImageWidth(),
-        this->dataPtr->camera->ImageHeight()
-      );
-
-    cameraSdf->SetLensIntrinsicsFx(intrinsicMatrix(0, 0));
-    cameraSdf->SetLensIntrinsicsFy(intrinsicMatrix(1, 1));
-    cameraSdf->SetLensIntrinsicsCx(intrinsicMatrix(0, 2));
-    cameraSdf->SetLensIntrinsicsCy(intrinsicMatrix(1, 2));
-  }
-  // set custom projection matrix based on intrinsics param specified in sdf
-  else
-  {
-    double fx = cameraSdf->LensIntrinsicsFx();
-    double fy = cameraSdf->LensIntrinsicsFy();
-    double cx = cameraSdf->LensIntrinsicsCx();
-    double cy = cameraSdf->LensIntrinsicsCy();
-    double s = cameraSdf->LensIntrinsicsSkew();
-    auto projectionMatrix = CameraSensorPrivate::BuildProjectionMatrix(
-        this->dataPtr->camera->ImageWidth(),
-        this->dataPtr->camera->ImageHeight(),
-        fx, fy, cx, cy, s,
-        this->dataPtr->camera->NearClipPlane(),
-        this->dataPtr->camera->FarClipPlane());
-    this->dataPtr->camera->SetProjectionMatrix(projectionMatrix);
-  }
+  this->dataPtr->UpdateProjection(*cameraSdf);
 
+  // The image is allocated by the rendering library, apply the buffer
+  // memory to it afterwards
+  this->dataPtr->imageMemory.Reset();
   this->dataPtr->image = this->dataPtr->camera->CreateImage();
+  this->dataPtr->imageMemory.Apply(
+      this->dataPtr->image.Data<unsigned char>(),
+      this->dataPtr->image.MemorySize(), this->BufferMemory());
+  this->dataPtr->UpdateImageTemplate();
 
   this->Scene()->RootVisual()->AddChild(this->dataPtr->camera);
 
@@ -342,48 +691,6 @@ bool CameraSensor::CreateCamera()
     this->dataPtr->saveImage = true;
   }
 
-  // Update the DOM object intrinsics to have consistent
-  // projection matrix values between ogre camera and camera_info msg
-  // If these values are not defined in the SDF then we need to update
-  // these values to something reasonable. The projection matrix is
-  // the cumulative effect of intrinsic and extrinsic parameters
-  if(!cameraSdf->HasLensProjection())
-  {
-    // Note that the matrix from Ogre via camera->ProjectionMatrix() has a
-    // different format than the projection matrix used in SDFormat.
-    // This is why they are converted using projectionToCameraIntrinsic.
-    // The resulting matrix is the intrinsic matrix, but since the user has
-    // not overridden the values, this is also equal to the projection matrix.
-    auto intrinsicMatrix =
-      gz::rendering::projectionToCameraIntrinsic(
-        this->dataPtr->camera->ProjectionMatrix(),
-        this->dataPtr->camera->ImageWidth(),
-        this->dataPtr->camera->ImageHeight()
-      );
-    cameraSdf->SetLensProjectionFx(intrinsicMatrix(0, 0));
-    cameraSdf->SetLensProjectionFy(intrinsicMatrix(1, 1));
-    cameraSdf->SetLensProjectionCx(intrinsicMatrix(0, 2));
-    cameraSdf->SetLensProjectionCy(intrinsicMatrix(1, 2));
-  }
-  // set custom projection matrix based on projection param specified in sdf
-  else
-  {
-    // tx and ty are not used
-    double fx = cameraSdf->LensProjectionFx();
-    double fy = cameraSdf->LensProjectionFy();
-    double cx = cameraSdf->LensProjectionCx();
-    double cy = cameraSdf->LensProjectionCy();
-    double s = 0;
-
-    auto projectionMatrix = CameraSensorPrivate::BuildProjectionMatrix(
-        this->dataPtr->camera->ImageWidth(),
-        this->dataPtr->camera->ImageHeight(),
-        fx, fy, cx, cy, s,
-        this->dataPtr->camera->NearClipPlane(),
-        this->dataPtr->camera->FarClipPlane());
-    this->dataPtr->camera->SetProjectionMatrix(projectionMatrix);
-  }
-
   // Populate camera info topic
   this->PopulateInfo(cameraSdf);
 
@@ -403,6 +710,7 @@ CameraSensor::~CameraSensor()
   {
     this->Scene()->DestroySensor(this->dataPtr->camera);
   }
+  this->UpdateFlowCamera(false);
 }
 
 //////////////////////////////////////////////////
@@ -445,10 +753,8 @@ bool CameraSensor::Load(const sdf::Sensor &_sdf)
     this->dataPtr->infoTopic = _sdf.CameraSensor()->CameraInfoTopic();
   }
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<gz::msgs::Image>(
-          this->Topic());
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<gz::msgs::Image>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() << "].\n";
@@ -458,6 +764,14 @@ bool CameraSensor::Load(const sdf::Sensor &_sdf)
   gzdbg << "Camera images for [" << this->Name() << "] advertised on ["
          << this->Topic() << "]" << std::endl;
 
+  if (!this->Advertise<gz::msgs::Image>(this->dataPtr->node,
+      this->dataPtr->flowPub, this->Topic() + "/optical_flow"))
+  {
+    gzerr << "Unable to create publisher on topic["
+      << this->Topic() << "/optical_flow].\n";
+    return false;
+  }
+
   if (_sdf.CameraSensor()->Triggered())
   {
     if (!_sdf.CameraSensor()->TriggerTopic().empty())
@@ -483,6 +797,7 @@ bool CameraSensor::Load(const sdf::Sensor &_sdf)
     gzdbg << "Camera trigger messages for [" << this->Name() << "] subscribed"
            << " on [" << this->dataPtr->triggerTopic << "]" << std::endl;
     this->dataPtr->isTriggeredCamera = true;
+    this->SetWaitForTrigger(true);
   }
 
   if (!this->AdvertiseInfo())
@@ -507,6 +822,108 @@ bool CameraSensor::Load(sdf::ElementPtr _sdf)
   return this->Load(sdfSensor);
 }
 
+//////////////////////////////////////////////////
+bool CameraSensor::Reconfigure(const sdf::Sensor &_sdf)
+{
+  // Derived cameras render with cameras of their own
+  if (_sdf.Type() != sdf::SensorType::CAMERA)
+    return this->Sensor::Reconfigure(_sdf);
+
+  const sdf::Camera *cameraSdf = _sdf.CameraSensor();
+  if (!cameraSdf)
+  {
+    gzerr << "Unable to reconfigure camera [" << this->Name()
+          << "] without camera settings.\n";
+    return false;
+  }
+
+  double renderScale = 1.0;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    const sdf::Camera *loaded = this->dataPtr->sdfSensor.CameraSensor();
+    if (cameraSdf->PixelFormat() != loaded->PixelFormat() ||
+        cameraSdf->Triggered() != loaded->Triggered() ||
+        cameraSdf->TriggerTopic() != loaded->TriggerTopic() ||
+        cameraSdf->CameraInfoTopic() != loaded->CameraInfoTopic() ||
+        cameraSdf->ImageNoise().Type() != loaded->ImageNoise().Type())
+    {
+      gzerr << "The pixel format, trigger, camera info topic and noise type "
+            << "of camera [" << this->Name() << "] can't be reconfigured, "
+            << "the sensor must be created again.\n";
+      return false;
+    }
+
+    if (cameraSdf->ImageWidth() == 0u || cameraSdf->ImageHeight() == 0u)
+    {
+      gzerr << "Invalid image size [" << cameraSdf->ImageWidth() << "x"
+            << cameraSdf->ImageHeight() << "]\n";
+      return false;
+    }
+
+    const math::Angle angle = cameraSdf->HorizontalFov();
+    if (angle < 0.01 || angle > GZ_PI*2)
+    {
+      gzerr << "Invalid horizontal field of view [" << angle << "]\n";
+      return false;
+    }
+
+    if (!this->Sensor::Reconfigure(_sdf))
+      return false;
+
+    const bool noiseChanged = cameraSdf->ImageNoise() != loaded->ImageNoise();
+    this->dataPtr->sdfSensor = _sdf;
+    sdf::Camera *newSdf = this->dataPtr->sdfSensor.CameraSensor();
+
+    // The camera is created from the new settings once there's a scene
+    if (!this->dataPtr->camera)
+      return true;
+
+    const NoisePtr &noise = this->dataPtr->noises[CAMERA_NOISE];
+    if (noiseChanged && noise)
+      noise->Load(newSdf->ImageNoise());
+
+    const unsigned int width = newSdf->ImageWidth();
+    const unsigned int height = newSdf->ImageHeight();
+    rendering::CameraPtr &camera = this->dataPtr->camera;
+    camera->SetNearClipPlane(newSdf->NearClip());
+    camera->SetFarClipPlane(newSdf->FarClip());
+    camera->SetAspectRatio(static_cast<double>(width) / height);
+    camera->SetHFOV(angle);
+
+    // The projection is computed at the published resolution, a render
+    // scale is applied again afterwards. Only a new resolution reallocates
+    // the image.
+    renderScale = this->dataPtr->renderScale;
+    if (camera->ImageWidth() != width || camera->ImageHeight() != height)
+    {
+      camera->SetImageWidth(width);
+      camera->SetImageHeight(height);
+    }
+    if (width != this->dataPtr->image.Width() ||
+        height != this->dataPtr->image.Height())
+    {
+      this->dataPtr->imageMemory.Reset();
+      this->dataPtr->image = camera->CreateImage();
+      this->dataPtr->imageMemory.Apply(
+          this->dataPtr->image.Data<unsigned char>(),
+          this->dataPtr->image.MemorySize(), this->BufferMemory());
+      this->dataPtr->UpdateImageTemplate();
+    }
+
+    this->dataPtr->UpdateProjection(*newSdf);
+    this->dataPtr->infoMsg.Clear();
+    this->PopulateInfo(newSdf);
+    this->InvalidateFrame();
+
+    // The optical flow camera is created again with the new settings
+    this->UpdateFlowCamera(false);
+  }
+
+  if (renderScale < 1.0)
+    return this->SetRenderScale(renderScale);
+  return true;
+}
+
 /////////////////////////////////////////////////
 gz::common::ConnectionPtr CameraSensor::ConnectImageCallback(
     std::function<void(const gz::msgs::Image &)> _callback)
@@ -514,6 +931,20 @@ gz::common::ConnectionPtr CameraSensor::ConnectImageCallback(
   return this->dataPtr->imageEvent.Connect(_callback);
 }
 
+/////////////////////////////////////////////////
+gz::common::ConnectionPtr CameraSensor::ConnectImageViewCallback(
+    std::function<void(const ImageView &)> _callback)
+{
+  return this->dataPtr->imageViewEvent.Connect(_callback);
+}
+
+/////////////////////////////////////////////////
+gz::common::ConnectionPtr CameraSensor::ConnectGpuFrameCallback(
+    std::function<void(const GpuFrame &)> _callback)
+{
+  return this->dataPtr->gpuFrameEvent.Connect(_callback);
+}
+
 /////////////////////////////////////////////////
 void CameraSensor::SetScene(gz::rendering::ScenePtr _scene)
 {
@@ -523,6 +954,7 @@ void CameraSensor::SetScene(gz::rendering::ScenePtr _scene)
   {
     // TODO(anyone) Remove camera from scene
     this->dataPtr->camera = nullptr;
+    this->UpdateFlowCamera(false);
     RenderingSensor::SetScene(_scene);
     if (this->dataPtr->initialized)
       this->CreateCamera();
@@ -550,11 +982,8 @@ bool CameraSensor::Update(const std::chrono::steady_clock::duration &_now)
   // move the camera to the current pose
   this->dataPtr->camera->SetLocalPose(this->Pose());
 
-  if (this->HasInfoConnections())
-  {
-    // publish the camera info message
-    this->PublishInfo(_now);
-  }
+  // publish the camera info message, if it has subscribers
+  this->PublishInfo(_now);
 
   // render only if necessary
   if (this->dataPtr->isTriggeredCamera &&
@@ -565,7 +994,16 @@ bool CameraSensor::Update(const std::chrono::steady_clock::duration &_now)
 
   if (!this->dataPtr->pub.HasConnections() &&
       this->dataPtr->imageEvent.ConnectionCount() <= 0 &&
-      !this->dataPtr->saveImage)
+      this->dataPtr->imageViewEvent.ConnectionCount() <= 0 &&
+      this->dataPtr->gpuFrameEvent.ConnectionCount() <= 0 &&
+      !this->dataPtr->saveImage &&
+      !this->HasSharedMemoryConnections() &&
+      !this->HasCompressedConnections() &&
+      !this->HasDownsampledConnections() &&
+      !this->HasConvertedConnections() &&
+      !this->HasTiledConnections() &&
+      !this->HasOpticalFlowConnections() &&
+      !this->Recording())
   {
     if (this->dataPtr->generatingData)
     {
@@ -573,6 +1011,8 @@ bool CameraSensor::Update(const std::chrono::steady_clock::duration &_now)
              << "generation. " << std::endl;;
       this->dataPtr->generatingData = false;
     }
+    this->dataPtr->blurHasPrevPose = false;
+    this->UpdateFlowCamera(false);
 
     return true;
   }
@@ -586,81 +1026,104 @@ bool CameraSensor::Update(const std::chrono::steady_clock::duration &_now)
     }
   }
 
+  // The depths of the optical flow are rendered with the image
+  const bool flow = this->UpdateFlowCamera(this->HasOpticalFlowConnections());
+  if (flow)
+    this->dataPtr->flowCamera->SetLocalPose(this->Pose());
+
+  const bool gpuFrames = this->dataPtr->gpuFrameEvent.ConnectionCount() > 0;
   if (this->HasImageConnections() || this->dataPtr->saveImage)
   {
-    // generate sensor data
-    this->Render();
+    // generate sensor data, unless the last frame is still valid. Noise
+    // is rendered and a blurred frame shows motion, so they're not reused.
+    std::chrono::steady_clock::duration frameTime{_now};
+    if (this->dataPtr->noises[CAMERA_NOISE] ||
+        this->dataPtr->subFrames > 1u || !this->ReuseFrame())
     {
-      GZ_PROFILE("CameraSensor::Update Copy image");
-      this->dataPtr->camera->Copy(this->dataPtr->image);
+      this->dataPtr->UpdateMotionBlur(this->Pose(), !this->AsyncReadback());
+      const bool ready = this->Render(_now, frameTime, [this]()
+          {
+            GZ_PROFILE("CameraSensor::Update Copy image");
+            TraceScope trace("fill", *this);
+            this->ReadImage();
+            if (this->dataPtr->subFrames > 1u)
+              this->RenderMotionBlur();
+            if (this->dataPtr->cpuNoise)
+              this->ApplyCpuNoise();
+          });
+      if (gpuFrames)
+        this->dataPtr->EmitGpuFrame(_now);
+      if (!ready)
+      {
+        // The first frame in async readback mode isn't complete yet
+        return true;
+      }
     }
-
-    unsigned int width = this->dataPtr->camera->ImageWidth();
-    unsigned int height = this->dataPtr->camera->ImageHeight();
-    unsigned char *data = this->dataPtr->image.Data<unsigned char>();
-
-    gz::common::Image::PixelFormatType
-        format{common::Image::UNKNOWN_PIXEL_FORMAT};
-    msgs::PixelFormatType msgsPixelFormat =
-      msgs::PixelFormatType::UNKNOWN_PIXEL_FORMAT;
-
-    switch (this->dataPtr->camera->ImageFormat())
+    else if (gpuFrames)
     {
-      case rendering::PF_R8G8B8:
-        format = common::Image::RGB_INT8;
-        msgsPixelFormat = msgs::PixelFormatType::RGB_INT8;
-        break;
-      case rendering::PF_L8:
-        format = common::Image::L_INT8;
-        msgsPixelFormat = msgs::PixelFormatType::L_INT8;
-        break;
-      case rendering::PF_L16:
-        format = common::Image::L_INT16;
-        msgsPixelFormat = msgs::PixelFormatType::L_INT16;
-        break;
-      case rendering::PF_BAYER_RGGB8:
-        format = common::Image::BAYER_RGGB8;
-        msgsPixelFormat = msgs::PixelFormatType::BAYER_RGGB8;
-        break;
-      case rendering::PF_BAYER_BGGR8:
-        format = common::Image::BAYER_BGGR8;
-        msgsPixelFormat = msgs::PixelFormatType::BAYER_BGGR8;
-        break;
-      case rendering::PF_BAYER_GBRG8:
-        format = common::Image::BAYER_GBRG8;
-        msgsPixelFormat = msgs::PixelFormatType::BAYER_GBRG8;
-        break;
-      case rendering::PF_BAYER_GRBG8:
-        format = common::Image::BAYER_GRBG8;
-        msgsPixelFormat = msgs::PixelFormatType::BAYER_GRBG8;
-        break;
-      default:
-        gzerr << "Unsupported pixel format ["
-          << this->dataPtr->camera->ImageFormat() << "]\n";
-        break;
+      this->dataPtr->EmitGpuFrame(_now);
     }
 
-    // create message
-    msgs::Image msg;
+    // Only the stamp, sequence and pixels change between frames
+    this->dataPtr->UpdateImageTemplate();
+    unsigned int width = this->dataPtr->templateWidth;
+    unsigned int height = this->dataPtr->templateHeight;
+    const std::size_t size = this->dataPtr->imageSize;
+    const common::Image::PixelFormatType format = this->dataPtr->imageFormat;
+    const unsigned char *fullData =
+        this->dataPtr->image.Data<unsigned char>();
+    if (this->dataPtr->cpuDistortion)
+    {
+      GZ_PROFILE("CameraSensor::Update Distort");
+      this->dataPtr->distortedBuffer.resize(
+          this->dataPtr->image.MemorySize());
+      this->dataPtr->cpuDistortion->Distort(fullData,
+          this->dataPtr->distortedBuffer.data(), width, height,
+          this->dataPtr->bytesPerPixel);
+      fullData = this->dataPtr->distortedBuffer.data();
+    }
+    const unsigned char *data = this->ApplyRegionOfInterest(fullData,
+        width, height, this->dataPtr->bytesPerPixel,
+        this->dataPtr->regionBuffer);
+
+    // Pixels only go through protobuf if someone receives the message
+    const bool publishImage =
+        (this->dataPtr->pub && this->dataPtr->pub.HasConnections()) ||
+        this->dataPtr->imageEvent.ConnectionCount() > 0u ||
+        (!this->SharedMemoryOutput() && !this->CompressedOutput() &&
+         this->dataPtr->downsampledOutputs.empty() &&
+         this->dataPtr->convertedOutputs.empty() &&
+         this->dataPtr->tileRows == 0u &&
+         this->dataPtr->imageViewEvent.ConnectionCount() == 0u);
+
+    // fill message
+    msgs::Image &msg = this->dataPtr->imageMsg;
     {
       GZ_PROFILE("CameraSensor::Update Message");
-      msg.set_width(width);
-      msg.set_height(height);
-      msg.set_step(width * rendering::PixelUtil::BytesPerPixel(
-                   this->dataPtr->camera->ImageFormat()));
-      msg.set_pixel_format_type(msgsPixelFormat);
-      *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-      auto frame = msg.mutable_header()->add_data();
-      frame->set_key("frame_id");
-      frame->add_value(this->dataPtr->opticalFrameId);
-      msg.set_data(data, this->dataPtr->camera->ImageMemorySize());
+      this->FillHeader(msg.mutable_header(), frameTime,
+          this->dataPtr->opticalFrameId, "default");
+
+      // Assigning keeps the capacity of the buffer, so steady state frames
+      // are copied once from the readback image without reallocating.
+      if (publishImage)
+      {
+        msg.mutable_data()->assign(reinterpret_cast<const char *>(data),
+            size);
+      }
     }
 
+    this->WriteSharedMemoryImage(this->Topic(), msg, data, size);
+    this->RecordFrame(0u, msg, data, size);
+    this->PublishCompressedImage(msg, data, size, format);
+    this->PublishDownsampledImages(msg, data, width, height, frameTime);
+    this->PublishConvertedImages(data, width, height, frameTime);
+    this->PublishTiles(msg, data, height, frameTime);
+
     // publish the image message
+    if (publishImage)
     {
-      this->AddSequence(msg.mutable_header());
       GZ_PROFILE("CameraSensor::Update Publish");
-      this->dataPtr->pub.Publish(msg);
+      this->Publish(this->dataPtr->pub, msg);
     }
 
     // Trigger callbacks.
@@ -675,13 +1138,52 @@ bool CameraSensor::Update(const std::chrono::steady_clock::duration &_now)
         gzerr << "Exception thrown in an image callback.\n";
       }
     }
+    if (this->dataPtr->imageViewEvent.ConnectionCount() > 0)
+    {
+      ImageView view;
+      view.time = frameTime;
+      view.data = data;
+      view.size = size;
+      view.width = width;
+      view.height = height;
+      view.format = format;
+      try
+      {
+        this->dataPtr->imageViewEvent(view);
+      }
+      catch(...)
+      {
+        gzerr << "Exception thrown in an image view callback.\n";
+      }
+    }
 
     // Save image
     if (this->dataPtr->saveImage)
     {
-      this->dataPtr->SaveImage(data, width, height, format);
+      this->dataPtr->SaveImage(fullData, this->dataPtr->templateWidth,
+          this->dataPtr->templateHeight, format);
+    }
+  }
+  else if (gpuFrames)
+  {
+    // The frame stays on the GPU, nothing is read back
+    std::chrono::steady_clock::duration frameTime;
+    if (this->dataPtr->noises[CAMERA_NOISE] ||
+        this->dataPtr->subFrames > 1u || !this->ReuseFrame())
+    {
+      this->dataPtr->subFrames = 1u;
+      this->Render(_now, frameTime);
     }
+    this->dataPtr->EmitGpuFrame(_now);
   }
+  else if (flow)
+  {
+    // Only the depths of the optical flow are needed
+    this->Render();
+  }
+
+  if (flow)
+    this->PublishOpticalFlow(_now);
 
   if (this->dataPtr->isTriggeredCamera)
   {
@@ -694,39 +1196,223 @@ bool CameraSensor::Update(const std::chrono::steady_clock::duration &_now)
 //////////////////////////////////////////////////
 void CameraSensor::OnTrigger(const gz::msgs::Boolean &/*_msg*/)
 {
-  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
-  this->dataPtr->isTriggered = true;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->isTriggered = true;
+  }
+  this->NotifyTriggered();
 }
 
 //////////////////////////////////////////////////
-bool CameraSensorPrivate::SaveImage(const unsigned char *_data,
-    unsigned int _width, unsigned int _height,
-    gz::common::Image::PixelFormatType _format)
+void CameraSensorPrivate::UpdateImageTemplate()
 {
-  // Attempt to create the directory if it doesn't exist
-  if (!gz::common::isDirectory(this->saveImagePath))
+  // The image buffer has the published size, the camera may render less
+  const rendering::PixelFormat pixelFormat = this->camera->ImageFormat();
+  const unsigned int width = this->image.Width();
+  const unsigned int height = this->image.Height();
+  if (pixelFormat == this->templateFormat &&
+      width == this->templateWidth && height == this->templateHeight)
   {
-    if (!gz::common::createDirectories(this->saveImagePath))
-      return false;
+    return;
   }
-
-  std::string filename = this->saveImagePrefix +
+  this->templateFormat = pixelFormat;
+  this->templateWidth = width;
+  this->templateHeight = height;
+  this->bytesPerPixel = rendering::PixelUtil::BytesPerPixel(pixelFormat);
+
+  this->imageFormat = common::Image::UNKNOWN_PIXEL_FORMAT;
+  msgs::PixelFormatType msgsFormat =
+    msgs::PixelFormatType::UNKNOWN_PIXEL_FORMAT;
+  switch (pixelFormat)
+  {
+    case rendering::PF_R8G8B8:
+      this->imageFormat = common::Image::RGB_INT8;
+      msgsFormat = msgs::PixelFormatType::RGB_INT8;
+      break;
+    case rendering::PF_L8:
+      this->imageFormat = common::Image::L_INT8;
+      msgsFormat = msgs::PixelFormatType::L_INT8;
+      break;
+    case rendering::PF_L16:
+      this->imageFormat = common::Image::L_INT16;
+      msgsFormat = msgs::PixelFormatType::L_INT16;
+      break;
+    case rendering::PF_BAYER_RGGB8:
+      this->imageFormat = common::Image::BAYER_RGGB8;
+      msgsFormat = msgs::PixelFormatType::BAYER_RGGB8;
+      break;
+    case rendering::PF_BAYER_BGGR8:
+      this->imageFormat = common::Image::BAYER_BGGR8;
+      msgsFormat = msgs::PixelFormatType::BAYER_BGGR8;
+      break;
+    case rendering::PF_BAYER_GBRG8:
+      this->imageFormat = common::Image::BAYER_GBRG8;
+      msgsFormat = msgs::PixelFormatType::BAYER_GBRG8;
+      break;
+    case rendering::PF_BAYER_GRBG8:
+      this->imageFormat = common::Image::BAYER_GRBG8;
+      msgsFormat = msgs::PixelFormatType::BAYER_GRBG8;
+      break;
+    default:
+      gzerr << "Unsupported pixel format [" << pixelFormat << "]\n";
+      break;
+  }
+
+  // Published images only hold the region of interest
+  const ImageRegion region = this->Region(width, height);
+  this->imageMsg.set_width(region.OutputWidth());
+  this->imageMsg.set_height(region.OutputHeight());
+  this->imageMsg.set_step(region.OutputWidth() * this->bytesPerPixel);
+  this->imageMsg.set_pixel_format_type(msgsFormat);
+  this->imageSize = region.IsFull(width, height) ?
+      this->image.MemorySize() :
+      static_cast<std::size_t>(this->imageMsg.step()) *
+      region.OutputHeight();
+}
+
+//////////////////////////////////////////////////
+ImageRegion CameraSensorPrivate::Region(unsigned int _width,
+    unsigned int _height) const
+{
+  return ClampImageRegion(this->regionX, this->regionY, this->regionWidth,
+      this->regionHeight, this->decimation, _width, _height);
+}
+
+//////////////////////////////////////////////////
+void CameraSensorPrivate::UpdateRegionInfo()
+{
+  ++this->infoVersion;
+  this->regionInfoMsg.CopyFrom(this->infoMsg);
+  const ImageRegion region =
+      this->Region(this->infoMsg.width(), this->infoMsg.height());
+  this->regionInfoMsg.set_width(region.OutputWidth());
+  this->regionInfoMsg.set_height(region.OutputHeight());
+
+  // Output pixel (u, v) is full image pixel (x + d * u, y + d * v)
+  const double d = region.decimation;
+  const double x = region.x;
+  const double y = region.y;
+  if (this->regionInfoMsg.intrinsics().k_size() == 9)
+  {
+    auto *k = this->regionInfoMsg.mutable_intrinsics()->mutable_k();
+    k->Set(0, k->Get(0) / d);
+    k->Set(1, k->Get(1) / d);
+    k->Set(2, (k->Get(2) - x) / d);
+    k->Set(4, k->Get(4) / d);
+    k->Set(5, (k->Get(5) - y) / d);
+  }
+  if (this->regionInfoMsg.projection().p_size() == 12)
+  {
+    auto *p = this->regionInfoMsg.mutable_projection()->mutable_p();
+    p->Set(0, p->Get(0) / d);
+    p->Set(1, p->Get(1) / d);
+    p->Set(2, (p->Get(2) - x) / d);
+    p->Set(3, p->Get(3) / d);
+    p->Set(5, p->Get(5) / d);
+    p->Set(6, (p->Get(6) - y) / d);
+    p->Set(7, p->Get(7) / d);
+  }
+}
+
+//////////////////////////////////////////////////
+void CameraSensorPrivate::OnRegionChanged()
+{
+  this->regionEnabled = this->regionX > 0u || this->regionY > 0u ||
+      this->regionWidth > 0u || this->regionHeight > 0u ||
+      this->decimation > 1u;
+
+  // Rebuild the image message layout on the next frame
+  this->templateFormat = rendering::PF_UNKNOWN;
+  this->UpdateRegionInfo();
+}
+
+//////////////////////////////////////////////////
+void CameraSensorPrivate::EmitGpuFrame(
+    const std::chrono::steady_clock::duration &_time)
+{
+  GpuFrame frame;
+  frame.time = _time;
+  frame.textureId = this->camera->RenderTextureGLId();
+  frame.width = this->camera->ImageWidth();
+  frame.height = this->camera->ImageHeight();
+  frame.format = this->camera->ImageFormat();
+  frame.sequence = this->gpuFrames++;
+  try
+  {
+    this->gpuFrameEvent(frame);
+  }
+  catch(...)
+  {
+    gzerr << "Exception thrown in a GPU frame callback.\n";
+  }
+}
+
+//////////////////////////////////////////////////
+void CameraSensorPrivate::UpdateMotionBlur(const math::Pose3d &_pose,
+    bool _enabled)
+{
+  this->subFrames = 1u;
+  this->blurPrevPose = this->blurPose;
+  this->blurPose = _pose;
+  const bool hasPrevPose = this->blurHasPrevPose;
+  this->blurHasPrevPose = true;
+  if (!_enabled || !hasPrevPose || this->blurExposure <= 0.0 ||
+      this->blurMaxSubFrames <= 1u ||
+      this->imageFormat == common::Image::UNKNOWN_PIXEL_FORMAT)
+  {
+    return;
+  }
+
+  // Focal length in pixels
+  const double hfov = this->camera->HFOV().Radian();
+  if (hfov <= 0.0)
+    return;
+  const double focal = this->image.Width() / (2.0 * std::tan(
+      hfov * 0.5));
+
+  math::Vector3d axis;
+  double angle{0.0};
+  (this->blurPrevPose.Rot().Inverse() * _pose.Rot()).AxisAngle(axis, angle);
+  if (angle > GZ_PI)
+    angle = 2.0 * GZ_PI - angle;
+  const double distance =
+      (_pose.Pos() - this->blurPrevPose.Pos()).Length();
+
+  // Translation is seen on content one metre away, as an angle of about
+  // distance radians
+  const double blurPixels =
+      this->blurExposure * (std::abs(angle) + distance) * focal;
+  this->subFrames = MotionBlurSubFrames(blurPixels, this->blurMaxSubFrames);
+  this->blurStart = 1.0 - this->blurExposure;
+}
+
+//////////////////////////////////////////////////
+bool CameraSensorPrivate::SaveImage(const unsigned char *_data,
+    unsigned int _width, unsigned int _height,
+    gz::common::Image::PixelFormatType _format)
+{
+  // Attempt to create the directory if it doesn't exist
+  if (!gz::common::isDirectory(this->saveImagePath))
+  {
+    if (!gz::common::createDirectories(this->saveImagePath))
+      return false;
+  }
+
+  std::string filename = this->saveImagePrefix +
                          std::to_string(this->saveImageCounter) + ".png";
   ++this->saveImageCounter;
 
-  gz::common::Image localImage;
-  localImage.SetFromData(_data, _width, _height, _format);
-
-  localImage.SavePNG(
-      gz::common::joinPaths(this->saveImagePath, filename));
-  return true;
+  // Encoding and writing the file happen on the image writer's threads
+  return ImageWriter::Instance().Write(
+      gz::common::joinPaths(this->saveImagePath, filename), _data,
+      this->image.MemorySize(), _width, _height, _format);
 }
 
 //////////////////////////////////////////////////
 unsigned int CameraSensor::ImageWidth() const
 {
   if (this->dataPtr->camera)
-    return this->dataPtr->camera->ImageWidth();
+    return this->dataPtr->image.Width();
   return 0;
 }
 
@@ -734,7 +1420,7 @@ unsigned int CameraSensor::ImageWidth() const
 unsigned int CameraSensor::ImageHeight() const
 {
   if (this->dataPtr->camera)
-    return this->dataPtr->camera->ImageHeight();
+    return this->dataPtr->image.Height();
   return 0;
 }
 
@@ -773,10 +1459,8 @@ bool CameraSensor::AdvertiseInfo(const std::string &_topic)
 {
   this->dataPtr->infoTopic = _topic;
 
-  this->dataPtr->infoPub =
-      this->dataPtr->node.Advertise<gz::msgs::CameraInfo>(
-      this->dataPtr->infoTopic);
-  if (!this->dataPtr->infoPub)
+  if (!this->Advertise<gz::msgs::CameraInfo>(this->dataPtr->node,
+      this->dataPtr->infoPub, this->dataPtr->infoTopic))
   {
     gzerr << "Unable to create publisher on topic ["
       << this->dataPtr->infoTopic << "].\n";
@@ -794,9 +1478,56 @@ bool CameraSensor::AdvertiseInfo(const std::string &_topic)
 void CameraSensor::PublishInfo(
   const std::chrono::steady_clock::duration &_now)
 {
-  *this->dataPtr->infoMsg.mutable_header()->mutable_stamp() =
-    msgs::Convert(_now);
-  this->dataPtr->infoPub.Publish(this->dataPtr->infoMsg);
+  const bool connected = this->HasInfoConnections();
+  const bool subscribed = connected && !this->dataPtr->infoConnected;
+  this->dataPtr->infoConnected = connected;
+  if (!connected)
+    return;
+
+  if (this->dataPtr->infoOnChange && !subscribed &&
+      this->dataPtr->infoVersion == this->dataPtr->publishedInfoVersion)
+  {
+    const auto &period = this->dataPtr->infoHeartbeat;
+    const auto &last = this->dataPtr->infoTime;
+    // Time going backwards, such as after a reset, restarts the heartbeat
+    if (period <= std::chrono::steady_clock::duration::zero() ||
+        (_now >= last && _now - last < period))
+    {
+      return;
+    }
+  }
+
+  msgs::CameraInfo &msg = this->dataPtr->regionEnabled ?
+      this->dataPtr->regionInfoMsg : this->dataPtr->infoMsg;
+  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
+  this->Publish(this->dataPtr->infoPub, msg);
+  this->dataPtr->publishedInfoVersion = this->dataPtr->infoVersion;
+  this->dataPtr->infoTime = _now;
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::SetInfoOnChange(bool _onChange)
+{
+  this->dataPtr->infoOnChange = _onChange;
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::InfoOnChange() const
+{
+  return this->dataPtr->infoOnChange;
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::SetInfoHeartbeat(
+    const std::chrono::steady_clock::duration &_period)
+{
+  this->dataPtr->infoHeartbeat = _period;
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration CameraSensor::InfoHeartbeat() const
+{
+  return this->dataPtr->infoHeartbeat;
 }
 
 //////////////////////////////////////////////////
@@ -880,6 +1611,7 @@ void CameraSensor::PopulateInfo(const sdf::Camera *_cameraSdf)
 
   this->dataPtr->infoMsg.set_width(width);
   this->dataPtr->infoMsg.set_height(height);
+  this->dataPtr->UpdateRegionInfo();
 }
 
 //////////////////////////////////////////////////
@@ -893,6 +1625,7 @@ void CameraSensor::SetBaseline(double _baseline)
   {
     auto fx = this->dataPtr->infoMsg.projection().p(0);
     this->dataPtr->infoMsg.mutable_projection()->set_p(3, -fx * _baseline);
+    this->dataPtr->UpdateRegionInfo();
   }
 }
 
@@ -905,14 +1638,47 @@ double CameraSensor::Baseline() const
 //////////////////////////////////////////////////
 bool CameraSensor::HasConnections() const
 {
-  return this->HasImageConnections() || this->HasInfoConnections();
+  return this->HasImageConnections() || this->HasInfoConnections() ||
+      this->HasOpticalFlowConnections() ||
+      this->dataPtr->gpuFrameEvent.ConnectionCount() > 0u;
+}
+
+//////////////////////////////////////////////////
+SensorMemoryUsage CameraSensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage = RenderingSensor::MemoryUsage();
+  usage["image"] = this->dataPtr->image.MemorySize() +
+      this->dataPtr->renderImage.MemorySize();
+  usage["image_msg"] = MemorySize(this->dataPtr->imageMsg);
+  usage["region_buffer"] = MemorySize(this->dataPtr->regionBuffer) +
+      MemorySize(this->dataPtr->distortedBuffer);
+  usage["motion_blur"] = this->dataPtr->blurAccumulator.MemorySize();
+  usage["optical_flow"] = MemorySize(this->dataPtr->flowDepth) +
+      MemorySize(this->dataPtr->flowBuffer) +
+      MemorySize(this->dataPtr->flowMsg);
+
+  std::size_t outputs = MemorySize(this->dataPtr->tileMsg) +
+      MemorySize(this->dataPtr->binSums);
+  for (const auto &output : this->dataPtr->downsampledOutputs)
+    outputs += MemorySize(output.msg);
+  for (const auto &output : this->dataPtr->convertedOutputs)
+    outputs += MemorySize(output.msg);
+  usage["outputs"] = outputs;
+  return usage;
 }
 
 //////////////////////////////////////////////////
 bool CameraSensor::HasImageConnections() const
 {
   return (this->dataPtr->pub && this->dataPtr->pub.HasConnections()) ||
-         this->dataPtr->imageEvent.ConnectionCount() > 0u;
+         this->dataPtr->imageEvent.ConnectionCount() > 0u ||
+         this->dataPtr->imageViewEvent.ConnectionCount() > 0u ||
+         this->HasSharedMemoryConnections() ||
+         this->HasCompressedConnections() ||
+         this->HasDownsampledConnections() ||
+         this->HasConvertedConnections() ||
+         this->HasTiledConnections() ||
+         this->Recording();
 }
 
 //////////////////////////////////////////////////
@@ -921,6 +1687,858 @@ bool CameraSensor::HasInfoConnections() const
   return this->dataPtr->infoPub && this->dataPtr->infoPub.HasConnections();
 }
 
+//////////////////////////////////////////////////
+bool CameraSensor::HasOpticalFlowConnections() const
+{
+  return this->dataPtr->flowPub && this->dataPtr->flowPub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::UpdateFlowCamera(bool _needed)
+{
+  if (!_needed)
+  {
+    if (this->dataPtr->flowCamera)
+    {
+      // Destroying it removes it from the rendered sensors
+      this->dataPtr->flowDepthConnection.reset();
+      if (this->Scene())
+        this->Scene()->DestroySensor(this->dataPtr->flowCamera);
+      this->dataPtr->flowCamera = nullptr;
+    }
+    this->dataPtr->flowHasPrevPose = false;
+    return false;
+  }
+
+  if (this->dataPtr->flowCamera)
+    return true;
+
+  const sdf::Camera *cameraSdf = this->dataPtr->sdfSensor.CameraSensor();
+  if (!cameraSdf || !this->Scene())
+    return false;
+
+  const unsigned int width = cameraSdf->ImageWidth();
+  const unsigned int height = cameraSdf->ImageHeight();
+  this->dataPtr->flowCamera = this->Scene()->CreateDepthCamera(
+      this->Name() + "_flowCamera");
+  if (!this->dataPtr->flowCamera)
+  {
+    gzerr << "Unable to create the optical flow camera of [" << this->Name()
+          << "]\n";
+    return false;
+  }
+  this->dataPtr->flowCamera->SetImageWidth(width);
+  this->dataPtr->flowCamera->SetImageHeight(height);
+  this->dataPtr->flowCamera->SetNearClipPlane(cameraSdf->NearClip());
+  this->dataPtr->flowCamera->SetFarClipPlane(cameraSdf->FarClip());
+  this->dataPtr->flowCamera->SetVisibilityMask(cameraSdf->VisibilityMask());
+  this->dataPtr->flowCamera->SetAspectRatio(
+      static_cast<double>(width) / height);
+  this->dataPtr->flowCamera->SetHFOV(cameraSdf->HorizontalFov());
+  this->dataPtr->flowCamera->CreateDepthTexture();
+
+  // Add the camera to the scene and to the rendered sensors
+  this->Scene()->RootVisual()->AddChild(this->dataPtr->flowCamera);
+  this->AddSensor(this->dataPtr->flowCamera);
+
+  this->dataPtr->flowDepth.SetMemory(this->BufferMemory());
+  this->dataPtr->flowDepth.Reserve(static_cast<std::size_t>(width) * height);
+  this->dataPtr->flowDepth.Resize(0u);
+  this->dataPtr->flowHasPrevPose = false;
+
+  // Frames are delivered while the sensor renders, with its mutex held
+  this->dataPtr->flowDepthConnection =
+      this->dataPtr->flowCamera->ConnectNewDepthFrame(
+      [this](const float *_scan, unsigned int _width, unsigned int _height,
+          unsigned int /*_channels*/, const std::string &/*_format*/)
+      {
+        const std::size_t samples = static_cast<std::size_t>(_width) *
+            _height;
+        this->dataPtr->flowDepth.Resize(samples);
+        std::copy(_scan, _scan + samples, this->dataPtr->flowDepth.Data());
+        this->dataPtr->flowWidth = _width;
+        this->dataPtr->flowHeight = _height;
+        this->dataPtr->flowDepthPose =
+            this->dataPtr->flowCamera->WorldPose();
+      });
+  return true;
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::PublishOpticalFlow(
+    const std::chrono::steady_clock::duration &_now)
+{
+  if (this->dataPtr->flowDepth.Empty())
+    return;
+
+  // The first frame only sets the previous pose
+  const math::Pose3d pose = this->dataPtr->flowDepthPose;
+  if (!this->dataPtr->flowHasPrevPose)
+  {
+    this->dataPtr->flowPrevPose = pose;
+    this->dataPtr->flowHasPrevPose = true;
+    return;
+  }
+
+  GZ_PROFILE("CameraSensor::PublishOpticalFlow");
+  const unsigned int width = this->dataPtr->flowWidth;
+  const unsigned int height = this->dataPtr->flowHeight;
+  this->dataPtr->flowBuffer.resize(
+      static_cast<std::size_t>(width) * height * 3u);
+  StaticSceneFlow(this->dataPtr->flowDepth.Data(), width, height,
+      this->dataPtr->flowCamera->HFOV().Radian(), this->dataPtr->flowPrevPose,
+      pose, this->dataPtr->flowBuffer.data());
+  this->dataPtr->flowPrevPose = pose;
+
+  msgs::Image &msg = this->dataPtr->flowMsg;
+  msg.set_width(width);
+  msg.set_height(height);
+  msg.set_step(width * 3u * sizeof(float));
+  msg.set_pixel_format_type(msgs::PixelFormatType::RGB_FLOAT32);
+  this->FillHeader(msg.mutable_header(), _now,
+      this->dataPtr->opticalFrameId, "opticalFlow");
+  msg.mutable_data()->assign(
+      reinterpret_cast<const char *>(this->dataPtr->flowBuffer.data()),
+      this->dataPtr->flowBuffer.size() * sizeof(float));
+  this->Publish(this->dataPtr->flowPub, msg);
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::SetCompressedOutput(bool _enabled)
+{
+  if (!_enabled)
+  {
+    this->dataPtr->compressor.reset();
+    this->dataPtr->compressedPub = transport::Node::Publisher();
+    return true;
+  }
+
+  if (this->dataPtr->compressor)
+    return true;
+
+  if (this->Topic().empty())
+  {
+    gzerr << "Compressed output requires the sensor to be loaded.\n";
+    return false;
+  }
+
+  const std::string topic = this->Topic() + "/compressed";
+  this->dataPtr->compressedPub =
+      this->dataPtr->node.Advertise<msgs::Image>(topic);
+  if (!this->dataPtr->compressedPub)
+  {
+    gzerr << "Unable to create publisher on topic [" << topic << "].\n";
+    return false;
+  }
+  this->dataPtr->compressor =
+      std::make_unique<ImageCompressor>(this->dataPtr->compressedPub);
+
+  gzdbg << "Compressed images for [" << this->Name() << "] advertised on ["
+        << topic << "]" << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::CompressedOutput() const
+{
+  return this->dataPtr->compressor != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::HasCompressedConnections() const
+{
+  return this->dataPtr->compressor &&
+         this->dataPtr->compressedPub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::SetRegionOfInterest(unsigned int _x, unsigned int _y,
+    unsigned int _width, unsigned int _height)
+{
+  if (!this->HasRegionOfInterestSupport())
+  {
+    gzerr << "Sensor [" << this->Name() << "] doesn't support a region of "
+          << "interest.\n";
+    return false;
+  }
+
+  this->dataPtr->regionX = _x;
+  this->dataPtr->regionY = _y;
+  this->dataPtr->regionWidth = _width;
+  this->dataPtr->regionHeight = _height;
+  this->dataPtr->OnRegionChanged();
+  return true;
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::RegionOfInterest(unsigned int &_x, unsigned int &_y,
+    unsigned int &_width, unsigned int &_height) const
+{
+  _x = this->dataPtr->regionX;
+  _y = this->dataPtr->regionY;
+  _width = this->dataPtr->regionWidth;
+  _height = this->dataPtr->regionHeight;
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::SetDecimation(unsigned int _decimation)
+{
+  if (_decimation == 0u)
+  {
+    gzerr << "Decimation of sensor [" << this->Name()
+          << "] must be positive.\n";
+    return false;
+  }
+  if (_decimation > 1u && !this->HasRegionOfInterestSupport())
+  {
+    gzerr << "Sensor [" << this->Name() << "] doesn't support "
+          << "decimation.\n";
+    return false;
+  }
+
+  this->dataPtr->decimation = _decimation;
+  this->dataPtr->OnRegionChanged();
+  return true;
+}
+
+//////////////////////////////////////////////////
+unsigned int CameraSensor::Decimation() const
+{
+  return this->dataPtr->decimation;
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::HasRegionOfInterestSupport() const
+{
+  // Cropping or decimating would break the color filter pattern
+  const sdf::Camera *cameraSdf = this->dataPtr->sdfSensor.CameraSensor();
+  if (!cameraSdf)
+    return true;
+  switch (cameraSdf->PixelFormat())
+  {
+    case sdf::PixelFormatType::BAYER_RGGB8:
+    case sdf::PixelFormatType::BAYER_BGGR8:
+    case sdf::PixelFormatType::BAYER_GBRG8:
+    case sdf::PixelFormatType::BAYER_GRBG8:
+      return false;
+    default:
+      return true;
+  }
+}
+
+//////////////////////////////////////////////////
+const unsigned char *CameraSensor::ApplyRegionOfInterest(
+    const unsigned char *_data, unsigned int &_width, unsigned int &_height,
+    std::size_t _bytesPerPixel, std::vector<unsigned char> &_buffer) const
+{
+  if (!this->dataPtr->regionEnabled || !_data)
+    return _data;
+
+  const ImageRegion region = this->dataPtr->Region(_width, _height);
+  if (region.IsFull(_width, _height))
+    return _data;
+
+  GZ_PROFILE("CameraSensor::ApplyRegionOfInterest");
+  const unsigned int width = region.OutputWidth();
+  const unsigned int height = region.OutputHeight();
+  // Resizing keeps the capacity, so steady state frames don't allocate
+  _buffer.resize(static_cast<std::size_t>(width) * height * _bytesPerPixel);
+  CopyImageRegion(_data, _width, _bytesPerPixel, region, _buffer.data());
+  _width = width;
+  _height = height;
+  return _buffer.data();
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::AddDownsampledOutput(unsigned int _factor)
+{
+  if (_factor < 2u)
+  {
+    gzerr << "Downsampling factor of sensor [" << this->Name()
+          << "] must be at least 2.\n";
+    return false;
+  }
+  if (!this->DownsampledTopic(_factor).empty())
+    return true;
+  if (!this->HasRegionOfInterestSupport())
+  {
+    gzerr << "Sensor [" << this->Name() << "] doesn't support downsampled "
+          << "outputs.\n";
+    return false;
+  }
+  if (this->Topic().empty())
+  {
+    gzerr << "Downsampled outputs require the sensor to be loaded.\n";
+    return false;
+  }
+
+  DownsampledOutput output;
+  output.factor = _factor;
+  output.topic = this->Topic() + "/downsampled_" + std::to_string(_factor);
+  output.pub = this->dataPtr->node.Advertise<msgs::Image>(output.topic);
+  if (!output.pub)
+  {
+    gzerr << "Unable to create publisher on topic [" << output.topic
+          << "].\n";
+    return false;
+  }
+  gzdbg << "Downsampled images for [" << this->Name() << "] advertised on ["
+        << output.topic << "]" << std::endl;
+
+  auto &outputs = this->dataPtr->downsampledOutputs;
+  auto it = std::find_if(outputs.begin(), outputs.end(),
+      [_factor](const DownsampledOutput &_output)
+      {
+        return _output.factor > _factor;
+      });
+  outputs.insert(it, std::move(output));
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string CameraSensor::DownsampledTopic(unsigned int _factor) const
+{
+  for (const auto &output : this->dataPtr->downsampledOutputs)
+  {
+    if (output.factor == _factor)
+      return output.topic;
+  }
+  return std::string();
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::HasDownsampledConnections() const
+{
+  for (const auto &output : this->dataPtr->downsampledOutputs)
+  {
+    if (output.pub.HasConnections())
+      return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::PublishDownsampledImages(const msgs::Image &_image,
+    const unsigned char *_data, unsigned int _width, unsigned int _height,
+    const std::chrono::steady_clock::duration &_frameTime)
+{
+  auto &outputs = this->dataPtr->downsampledOutputs;
+  if (outputs.empty())
+    return;
+
+  unsigned int channels = 0u;
+  bool wide = false;
+  switch (this->dataPtr->imageFormat)
+  {
+    case common::Image::RGB_INT8:
+      channels = 3u;
+      break;
+    case common::Image::L_INT8:
+      channels = 1u;
+      break;
+    case common::Image::L_INT16:
+      channels = 1u;
+      wide = true;
+      break;
+    default:
+      return;
+  }
+
+  GZ_PROFILE("CameraSensor::PublishDownsampledImages");
+  for (auto &output : outputs)
+    output.generated = false;
+
+  for (std::size_t i = 0u; i < outputs.size(); ++i)
+  {
+    DownsampledOutput &output = outputs[i];
+    if (!output.pub.HasConnections())
+      continue;
+
+    // Start from the smallest image already generated for this frame that
+    // divides evenly into the output, so each level is computed once.
+    const unsigned char *src = _data;
+    unsigned int srcWidth = _width;
+    unsigned int srcHeight = _height;
+    unsigned int factor = output.factor;
+    for (std::size_t j = i; j-- > 0u;)
+    {
+      const DownsampledOutput &finer = outputs[j];
+      if (finer.generated && output.factor % finer.factor == 0u)
+      {
+        src = reinterpret_cast<const unsigned char *>(finer.msg.data().data());
+        srcWidth = finer.msg.width();
+        srcHeight = finer.msg.height();
+        factor = output.factor / finer.factor;
+        break;
+      }
+    }
+
+    const unsigned int width = srcWidth / factor;
+    const unsigned int height = srcHeight / factor;
+    if (width == 0u || height == 0u)
+      continue;
+
+    msgs::Image &msg = output.msg;
+    const std::size_t bytesPerPixel = channels * (wide ? 2u : 1u);
+    msg.set_width(width);
+    msg.set_height(height);
+    msg.set_step(width * bytesPerPixel);
+    msg.set_pixel_format_type(_image.pixel_format_type());
+    this->FillHeader(msg.mutable_header(), _frameTime,
+        this->dataPtr->opticalFrameId, output.topic);
+
+    // Resizing keeps the capacity, so steady state frames don't allocate
+    std::string *pixels = msg.mutable_data();
+    pixels->resize(static_cast<std::size_t>(msg.step()) * height);
+    if (wide)
+    {
+      BinImage(reinterpret_cast<const uint16_t *>(src), srcWidth,
+          srcHeight, channels, factor, this->dataPtr->binSums,
+          reinterpret_cast<uint16_t *>(&(*pixels)[0]));
+    }
+    else
+    {
+      BinImage(src, srcWidth, srcHeight, channels, factor,
+          this->dataPtr->binSums,
+          reinterpret_cast<unsigned char *>(&(*pixels)[0]));
+    }
+    output.generated = true;
+
+    this->Publish(output.pub, msg);
+  }
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::AddConvertedOutput(ConvertedPixelFormat _format)
+{
+  if (!this->ConvertedTopic(_format).empty())
+    return true;
+  if (!this->HasRegionOfInterestSupport())
+  {
+    gzerr << "Sensor [" << this->Name() << "] doesn't support converted "
+          << "outputs.\n";
+    return false;
+  }
+  if (this->Topic().empty())
+  {
+    gzerr << "Converted outputs require the sensor to be loaded.\n";
+    return false;
+  }
+
+  ConvertedOutput output;
+  output.format = _format;
+  std::string suffix;
+  switch (_format)
+  {
+    case ConvertedPixelFormat::MONO8:
+      suffix = "mono8";
+      output.msg.set_pixel_format_type(msgs::PixelFormatType::L_INT8);
+      break;
+    case ConvertedPixelFormat::YUYV:
+      suffix = "yuyv";
+      break;
+    case ConvertedPixelFormat::NV12:
+      suffix = "nv12";
+      break;
+    default:
+      gzerr << "Unknown converted pixel format ["
+            << static_cast<int>(_format) << "].\n";
+      return false;
+  }
+  output.topic = this->Topic() + "/" + suffix;
+  output.pub = this->dataPtr->node.Advertise<msgs::Image>(output.topic);
+  if (!output.pub)
+  {
+    gzerr << "Unable to create publisher on topic [" << output.topic
+          << "].\n";
+    return false;
+  }
+  gzdbg << "Converted images for [" << this->Name() << "] advertised on ["
+        << output.topic << "]" << std::endl;
+
+  this->dataPtr->convertedOutputs.push_back(std::move(output));
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string CameraSensor::ConvertedTopic(ConvertedPixelFormat _format) const
+{
+  for (const auto &output : this->dataPtr->convertedOutputs)
+  {
+    if (output.format == _format)
+      return output.topic;
+  }
+  return std::string();
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::HasConvertedConnections() const
+{
+  for (const auto &output : this->dataPtr->convertedOutputs)
+  {
+    if (output.pub.HasConnections())
+      return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::PublishConvertedImages(const unsigned char *_data,
+    unsigned int _width, unsigned int _height,
+    const std::chrono::steady_clock::duration &_frameTime)
+{
+  if (this->dataPtr->convertedOutputs.empty() ||
+      this->dataPtr->imageFormat != common::Image::RGB_INT8)
+  {
+    return;
+  }
+
+  GZ_PROFILE("CameraSensor::PublishConvertedImages");
+  for (auto &output : this->dataPtr->convertedOutputs)
+  {
+    if (!output.pub.HasConnections())
+      continue;
+
+    msgs::Image &msg = output.msg;
+    unsigned int width = _width;
+    unsigned int height = _height;
+    std::size_t size = 0u;
+    const char *formatName = nullptr;
+    switch (output.format)
+    {
+      case ConvertedPixelFormat::MONO8:
+        msg.set_step(width);
+        size = static_cast<std::size_t>(width) * height;
+        break;
+      case ConvertedPixelFormat::YUYV:
+        width &= ~1u;
+        msg.set_step(width * 2u);
+        size = static_cast<std::size_t>(width) * 2u * height;
+        formatName = "yuyv";
+        break;
+      case ConvertedPixelFormat::NV12:
+        width &= ~1u;
+        height &= ~1u;
+        msg.set_step(width);
+        size = static_cast<std::size_t>(width) * height * 3u / 2u;
+        formatName = "nv12";
+        break;
+    }
+    if (size == 0u)
+      continue;
+
+    msg.set_width(width);
+    msg.set_height(height);
+    this->FillHeader(msg.mutable_header(), _frameTime,
+        this->dataPtr->opticalFrameId, output.topic);
+    if (formatName)
+    {
+      auto *entry = msg.mutable_header()->add_data();
+      entry->set_key("format");
+      entry->add_value(formatName);
+    }
+
+    // Resizing keeps the capacity, so steady state frames don't allocate
+    std::string *pixels = msg.mutable_data();
+    pixels->resize(size);
+    auto *dst = reinterpret_cast<unsigned char *>(&(*pixels)[0]);
+    switch (output.format)
+    {
+      case ConvertedPixelFormat::MONO8:
+        RgbToMono(_data, _width, _height, dst);
+        break;
+      case ConvertedPixelFormat::YUYV:
+        RgbToYuyv(_data, _width, _height, dst);
+        break;
+      case ConvertedPixelFormat::NV12:
+        RgbToNv12(_data, _width, _height, dst);
+        break;
+    }
+
+    this->Publish(output.pub, msg);
+  }
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::SetTiledOutput(unsigned int _rows)
+{
+  if (_rows == 0u)
+  {
+    this->dataPtr->tileRows = 0u;
+    return true;
+  }
+  if (this->Topic().empty())
+  {
+    gzerr << "Tiled output requires the sensor to be loaded.\n";
+    return false;
+  }
+
+  if (!this->dataPtr->tilesPub)
+  {
+    this->dataPtr->tilesTopic = this->Topic() + "/tiles";
+    this->dataPtr->tilesPub =
+        this->dataPtr->node.Advertise<msgs::Image>(this->dataPtr->tilesTopic);
+    if (!this->dataPtr->tilesPub)
+    {
+      gzerr << "Unable to create publisher on topic ["
+            << this->dataPtr->tilesTopic << "].\n";
+      return false;
+    }
+    gzdbg << "Image tiles for [" << this->Name() << "] advertised on ["
+          << this->dataPtr->tilesTopic << "]" << std::endl;
+  }
+  this->dataPtr->tileRows = _rows;
+  return true;
+}
+
+//////////////////////////////////////////////////
+unsigned int CameraSensor::TiledOutputRows() const
+{
+  return this->dataPtr->tileRows;
+}
+
+//////////////////////////////////////////////////
+std::string CameraSensor::TiledTopic() const
+{
+  return this->dataPtr->tileRows > 0u ? this->dataPtr->tilesTopic :
+      std::string();
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::HasTiledConnections() const
+{
+  return this->dataPtr->tileRows > 0u && this->dataPtr->tilesPub &&
+      this->dataPtr->tilesPub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::PublishTiles(const msgs::Image &_image,
+    const unsigned char *_data, unsigned int _height,
+    const std::chrono::steady_clock::duration &_frameTime)
+{
+  if (!this->HasTiledConnections() || _height == 0u)
+    return;
+
+  GZ_PROFILE("CameraSensor::PublishTiles");
+  const unsigned int rows = this->dataPtr->tileRows;
+  const unsigned int count = (_height + rows - 1u) / rows;
+  const std::size_t step = _image.step();
+  const uint64_t frame = this->dataPtr->tiledFrames++;
+
+  msgs::Image &msg = this->dataPtr->tileMsg;
+  msg.set_width(_image.width());
+  msg.set_step(_image.step());
+  msg.set_pixel_format_type(_image.pixel_format_type());
+  for (unsigned int i = 0u; i < count; ++i)
+  {
+    const unsigned int row = i * rows;
+    const unsigned int height = std::min(rows, _height - row);
+    msg.set_height(height);
+    this->FillHeader(msg.mutable_header(), _frameTime,
+        this->dataPtr->opticalFrameId, this->dataPtr->tilesTopic);
+    auto *header = msg.mutable_header();
+    const std::pair<const char *, uint64_t> entries[] = {
+      {"frame", frame}, {"tile", i}, {"tile_count", count}, {"row", row}};
+    for (const auto &[key, value] : entries)
+    {
+      auto *entry = header->add_data();
+      entry->set_key(key);
+      entry->add_value(std::to_string(value));
+    }
+
+    // Each tile is serialized by Publish, so the buffer is reused
+    msg.set_data(_data + row * step, height * step);
+    this->Publish(this->dataPtr->tilesPub, msg);
+  }
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::SetMotionBlur(double _exposure,
+    unsigned int _maxSubFrames)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->blurExposure = std::clamp(_exposure, 0.0, 1.0);
+  this->dataPtr->blurMaxSubFrames = std::max(_maxSubFrames, 1u);
+}
+
+//////////////////////////////////////////////////
+double CameraSensor::MotionBlurExposure() const
+{
+  return this->dataPtr->blurExposure;
+}
+
+//////////////////////////////////////////////////
+unsigned int CameraSensor::MotionBlurMaxSubFrames() const
+{
+  return this->dataPtr->blurMaxSubFrames;
+}
+
+//////////////////////////////////////////////////
+unsigned int CameraSensor::LastSubFrameCount() const
+{
+  return this->dataPtr->subFrames;
+}
+
+//////////////////////////////////////////////////
+bool CameraSensor::SetRenderScale(double _scale)
+{
+  if (!(_scale > 0.0) || _scale > 1.0)
+  {
+    gzerr << "Render scale must be in (0, 1], got [" << _scale << "]"
+          << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (!this->dataPtr->camera)
+  {
+    gzerr << "Camera doesn't exist.\n";
+    return false;
+  }
+
+  const rendering::PixelFormat format =
+      this->dataPtr->camera->ImageFormat();
+  if (_scale < 1.0 && format != rendering::PF_R8G8B8 &&
+      format != rendering::PF_L8 && format != rendering::PF_L16)
+  {
+    gzerr << "Render scale isn't supported for pixel format [" << format
+          << "] of camera [" << this->Name() << "]" << std::endl;
+    return false;
+  }
+
+  const unsigned int width = this->dataPtr->image.Width();
+  const unsigned int height = this->dataPtr->image.Height();
+  this->dataPtr->renderScale = _scale;
+  this->InvalidateFrame();
+  if (_scale < 1.0)
+  {
+    this->dataPtr->camera->SetImageWidth(std::max(1u,
+        static_cast<unsigned int>(std::lround(width * _scale))));
+    this->dataPtr->camera->SetImageHeight(std::max(1u,
+        static_cast<unsigned int>(std::lround(height * _scale))));
+    this->dataPtr->renderImageMemory.Reset();
+    this->dataPtr->renderImage = this->dataPtr->camera->CreateImage();
+    this->dataPtr->renderImageMemory.Apply(
+        this->dataPtr->renderImage.Data<unsigned char>(),
+        this->dataPtr->renderImage.MemorySize(), this->BufferMemory());
+    this->dataPtr->upsampler.Configure(
+        this->dataPtr->camera->ImageWidth(),
+        this->dataPtr->camera->ImageHeight(), width, height);
+  }
+  else
+  {
+    this->dataPtr->camera->SetImageWidth(width);
+    this->dataPtr->camera->SetImageHeight(height);
+    this->dataPtr->renderImageMemory.Reset();
+    this->dataPtr->renderImage = rendering::Image();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+double CameraSensor::RenderScale() const
+{
+  return this->dataPtr->renderScale;
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::ReadImage()
+{
+  if (this->dataPtr->renderScale >= 1.0)
+  {
+    this->dataPtr->camera->Copy(this->dataPtr->image);
+    return;
+  }
+
+  this->dataPtr->camera->Copy(this->dataPtr->renderImage);
+  GZ_PROFILE("CameraSensor::ReadImage Upsample");
+  const unsigned int channels = rendering::PixelUtil::ChannelCount(
+      this->dataPtr->camera->ImageFormat());
+  if (this->dataPtr->camera->ImageFormat() == rendering::PF_L16)
+  {
+    this->dataPtr->upsampler.Apply(
+        this->dataPtr->renderImage.Data<uint16_t>(),
+        this->dataPtr->image.Data<uint16_t>(), channels);
+  }
+  else
+  {
+    this->dataPtr->upsampler.Apply(
+        this->dataPtr->renderImage.Data<unsigned char>(),
+        this->dataPtr->image.Data<unsigned char>(), channels);
+  }
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::ApplyCpuNoise()
+{
+  rendering::Image &image = this->dataPtr->image;
+  auto &noise = *this->dataPtr->cpuNoise;
+  noise.SetThreadCount(this->ImageNoiseThreadCount());
+  if (this->dataPtr->imageFormat == common::Image::L_INT16)
+  {
+    noise.ApplyToImage(image.Data<uint16_t>(),
+        image.MemorySize() / sizeof(uint16_t));
+  }
+  else
+  {
+    noise.ApplyToImage(image.Data<unsigned char>(), image.MemorySize());
+  }
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::RenderMotionBlur()
+{
+  GZ_PROFILE("CameraSensor::RenderMotionBlur");
+  rendering::Image &image = this->dataPtr->image;
+  FrameAccumulator &accumulator = this->dataPtr->blurAccumulator;
+  const bool wide = this->dataPtr->imageFormat == common::Image::L_INT16;
+  const std::size_t count = wide ?
+      image.MemorySize() / sizeof(uint16_t) : image.MemorySize();
+
+  auto add = [&]()
+  {
+    if (wide)
+      accumulator.Add(image.Data<uint16_t>());
+    else
+      accumulator.Add(image.Data<unsigned char>());
+  };
+
+  // The image rendered at the current pose closes the exposure
+  accumulator.Reset(count);
+  add();
+
+  const math::Pose3d &from = this->dataPtr->blurPrevPose;
+  const math::Pose3d &to = this->dataPtr->blurPose;
+  const double start = this->dataPtr->blurStart;
+  const unsigned int frames = this->dataPtr->subFrames;
+  for (unsigned int i = 0u; i + 1u < frames; ++i)
+  {
+    const double t = start + (1.0 - start) * i / (frames - 1u);
+    math::Pose3d pose(from.Pos() + (to.Pos() - from.Pos()) * t,
+        math::Quaterniond::Slerp(t, from.Rot(), to.Rot(), true));
+    this->dataPtr->camera->SetLocalPose(pose);
+    this->Render();
+    this->ReadImage();
+    add();
+  }
+  this->dataPtr->camera->SetLocalPose(to);
+
+  if (wide)
+    accumulator.Average(image.Data<uint16_t>());
+  else
+    accumulator.Average(image.Data<unsigned char>());
+}
+
+//////////////////////////////////////////////////
+void CameraSensor::PublishCompressedImage(const msgs::Image &_image,
+    const unsigned char *_data, std::size_t _size,
+    common::Image::PixelFormatType _format)
+{
+  if (!this->HasCompressedConnections())
+    return;
+  this->dataPtr->compressor->Push(_image, _data, _size, _format);
+}
+
 //////////////////////////////////////////////////
 const std::string& CameraSensor::OpticalFrameId() const
 {
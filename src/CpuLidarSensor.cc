@@ -0,0 +1,656 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#if defined(_MSC_VER)
+  #pragma warning(push)
+  #pragma warning(disable: 4005)
+  #pragma warning(disable: 4251)
+#endif
+#include <gz/msgs/pointcloud_packed.pb.h>
+#if defined(_MSC_VER)
+  #pragma warning(pop)
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Event.hh>
+#include <gz/common/Profiler.hh>
+#include <gz/math/Helpers.hh>
+#include <gz/math/Matrix3.hh>
+#include <gz/msgs/Utility.hh>
+#include <gz/transport/Node.hh>
+
+#include "gz/sensors/CpuLidarSensor.hh"
+#include "MemorySize.hh"
+#include "PointCloudUtil.hh"
+#include "RayBvh.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Number of rays cast by a thread at a time.
+constexpr std::size_t kRayChunk = 256u;
+
+/// \brief Object of a CpuRayScene.
+struct RayObject
+{
+  /// \brief Mesh of the object.
+  std::shared_ptr<const TriangleBvh> mesh;
+
+  /// \brief Name of the mesh.
+  std::string meshName;
+
+  /// \brief Retro reflectance.
+  float retro{0.0f};
+
+  /// \brief Rotation from the world to the object frame, row major.
+  std::array<float, 9> rot{};
+
+  /// \brief Position of the object in the world.
+  std::array<float, 3> pos{};
+
+  /// \brief Set the pose of the object.
+  /// \param[in] _pose World pose.
+  void SetPose(const math::Pose3d &_pose)
+  {
+    const math::Matrix3d m(_pose.Rot().Inverse());
+    for (int r = 0; r < 3; ++r)
+    {
+      for (int c = 0; c < 3; ++c)
+        this->rot[r * 3 + c] = static_cast<float>(m(r, c));
+    }
+    this->pos = {static_cast<float>(_pose.Pos().X()),
+        static_cast<float>(_pose.Pos().Y()),
+        static_cast<float>(_pose.Pos().Z())};
+  }
+
+  /// \brief Rotate a vector from the world to the object frame.
+  /// \param[in] _v Vector in the world frame.
+  /// \return Vector in the object frame.
+  std::array<float, 3> ToLocal(const std::array<float, 3> &_v) const
+  {
+    return {
+        this->rot[0] * _v[0] + this->rot[1] * _v[1] + this->rot[2] * _v[2],
+        this->rot[3] * _v[0] + this->rot[4] * _v[1] + this->rot[5] * _v[2],
+        this->rot[6] * _v[0] + this->rot[7] * _v[1] + this->rot[8] * _v[2]};
+  }
+};
+}
+
+/// \brief Private data for CpuRayScene
+class gz::sensors::CpuRayScenePrivate
+{
+  /// \brief Rebuild the hierarchy over the objects. mutex must be locked
+  /// exclusively.
+  public: void Rebuild() const;
+
+  /// \brief Meshes by name.
+  public: std::unordered_map<std::string,
+      std::shared_ptr<const TriangleBvh>> meshes;
+
+  /// \brief Objects by id.
+  public: std::unordered_map<uint64_t, RayObject> objects;
+
+  /// \brief Objects with a mesh, in the build order of topLevel.
+  public: mutable std::vector<RayObject> castObjects;
+
+  /// \brief Hierarchy over the world boxes of castObjects.
+  public: mutable RayBvh topLevel;
+
+  /// \brief True if the objects changed since the last rebuild.
+  public: mutable bool dirty{false};
+
+  /// \brief Protects the members above. Scans lock it shared.
+  public: mutable std::shared_mutex mutex;
+};
+
+/// \brief Private data for CpuLidarSensor
+class gz::sensors::CpuLidarSensorPrivate
+{
+  /// \brief Compute the ray directions of a scan, if its size or angles
+  /// changed.
+  /// \param[in] _sensor The sensor.
+  /// \param[in] _width Number of rays per row.
+  /// \param[in] _height Number of rows.
+  public: void UpdateDirections(const CpuLidarSensor &_sensor,
+              unsigned int _width, unsigned int _height);
+
+  /// \brief Fill and publish the point cloud of a scan.
+  /// \param[in] _sensor The sensor.
+  /// \param[in] _scan The scan, 3 floats per ray.
+  /// \param[in] _width Number of rays per row.
+  /// \param[in] _height Number of rows.
+  /// \param[in] _now Time of the scan.
+  public: void PublishPoints(CpuLidarSensor &_sensor, const float *_scan,
+              unsigned int _width, unsigned int _height,
+              const std::chrono::steady_clock::duration &_now);
+
+  /// \brief The geometry.
+  public: std::shared_ptr<CpuRayScene> scene;
+
+  /// \brief Splits the rays between threads.
+  public: PointCloudUtil workers;
+
+  /// \brief Direction of each ray in the sensor frame, 3 floats per ray.
+  public: std::vector<float> directions;
+
+  /// \brief Angles and counts the directions were computed for.
+  public: std::array<double, 6> directionsKey{};
+
+  /// \brief Node to create the point cloud publisher.
+  public: transport::Node node;
+
+  /// \brief Point cloud publisher.
+  public: transport::Node::Publisher pointPub;
+
+  /// \brief Point cloud message, reused between scans.
+  public: msgs::PointCloudPacked pointMsg;
+
+  /// \brief Event triggered with each scan.
+  public: gz::common::EventT<void(const float *_scan, unsigned int _width,
+              unsigned int _height, unsigned int _channels,
+              const std::string &_format)> lidarEvent;
+};
+
+//////////////////////////////////////////////////
+CpuRayScene::CpuRayScene()
+  : dataPtr(new CpuRayScenePrivate())
+{
+}
+
+//////////////////////////////////////////////////
+CpuRayScene::~CpuRayScene() = default;
+
+//////////////////////////////////////////////////
+bool CpuRayScene::SetMesh(const std::string &_name,
+    const std::vector<math::Vector3d> &_vertices,
+    const std::vector<unsigned int> &_indices)
+{
+  std::vector<float> vertices;
+  vertices.reserve(_vertices.size() * 3u);
+  for (const auto &v : _vertices)
+  {
+    vertices.push_back(static_cast<float>(v.X()));
+    vertices.push_back(static_cast<float>(v.Y()));
+    vertices.push_back(static_cast<float>(v.Z()));
+  }
+  const std::vector<uint32_t> indices(_indices.begin(), _indices.end());
+
+  // Build outside of the lock, scans go on meanwhile
+  auto mesh = std::make_shared<TriangleBvh>();
+  if (!mesh->Build(vertices.data(), _vertices.size(), indices.data(),
+        indices.size()))
+  {
+    gzerr << "Invalid triangles for mesh [" << _name << "]." << std::endl;
+    return false;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->meshes[_name] = mesh;
+  for (auto &[id, object] : this->dataPtr->objects)
+  {
+    if (object.meshName == _name)
+      object.mesh = mesh;
+  }
+  this->dataPtr->dirty = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool CpuRayScene::SetObject(uint64_t _id, const std::string &_mesh,
+    const math::Pose3d &_pose, double _retro)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  auto it = this->dataPtr->meshes.find(_mesh);
+  if (it == this->dataPtr->meshes.end())
+  {
+    gzerr << "Unable to add object [" << _id << "], there's no mesh ["
+          << _mesh << "]." << std::endl;
+    return false;
+  }
+
+  RayObject &object = this->dataPtr->objects[_id];
+  object.mesh = it->second;
+  object.meshName = _mesh;
+  object.retro = static_cast<float>(_retro);
+  object.SetPose(_pose);
+  this->dataPtr->dirty = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool CpuRayScene::SetObjectPose(uint64_t _id, const math::Pose3d &_pose)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  auto it = this->dataPtr->objects.find(_id);
+  if (it == this->dataPtr->objects.end())
+    return false;
+  it->second.SetPose(_pose);
+  this->dataPtr->dirty = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool CpuRayScene::RemoveObject(uint64_t _id)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  if (this->dataPtr->objects.erase(_id) == 0u)
+    return false;
+  this->dataPtr->dirty = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t CpuRayScene::ObjectCount() const
+{
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->objects.size();
+}
+
+//////////////////////////////////////////////////
+void CpuRayScenePrivate::Rebuild() const
+{
+  GZ_PROFILE("CpuRayScene::Rebuild");
+  std::vector<const RayObject *> source;
+  std::vector<float> boxes;
+  source.reserve(this->objects.size());
+  boxes.reserve(this->objects.size() * 6u);
+  for (const auto &[id, object] : this->objects)
+  {
+    std::array<float, 3> lo, hi;
+    if (!object.mesh || !object.mesh->Bounds(lo, hi))
+      continue;
+
+    // World box of the corners of the mesh box. The rotation maps world
+    // to object, so its transpose maps object to world.
+    std::array<float, 3> worldMin, worldMax;
+    worldMin.fill(std::numeric_limits<float>::infinity());
+    worldMax.fill(-std::numeric_limits<float>::infinity());
+    for (int corner = 0; corner < 8; ++corner)
+    {
+      const std::array<float, 3> p = {
+          (corner & 1) ? hi[0] : lo[0],
+          (corner & 2) ? hi[1] : lo[1],
+          (corner & 4) ? hi[2] : lo[2]};
+      for (int k = 0; k < 3; ++k)
+      {
+        const float w = object.rot[k] * p[0] + object.rot[3 + k] * p[1] +
+            object.rot[6 + k] * p[2] + object.pos[k];
+        worldMin[k] = std::min(worldMin[k], w);
+        worldMax[k] = std::max(worldMax[k], w);
+      }
+    }
+    boxes.insert(boxes.end(), worldMin.begin(), worldMin.end());
+    boxes.insert(boxes.end(), worldMax.begin(), worldMax.end());
+    source.push_back(&object);
+  }
+
+  this->topLevel.Build(boxes.data(), source.size());
+  this->castObjects.clear();
+  this->castObjects.reserve(source.size());
+  for (uint32_t index : this->topLevel.Order())
+    this->castObjects.push_back(*source[index]);
+  this->dirty = false;
+}
+
+//////////////////////////////////////////////////
+void CpuRayScene::CastRays(const math::Pose3d &_pose,
+    const float *_directions, std::size_t _count, double _rangeMax,
+    float *_hits, std::size_t _stride) const
+{
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  if (this->dataPtr->dirty)
+  {
+    lock.unlock();
+    {
+      std::unique_lock<std::shared_mutex> rebuildLock(this->dataPtr->mutex);
+      if (this->dataPtr->dirty)
+        this->dataPtr->Rebuild();
+    }
+    lock.lock();
+  }
+
+  const math::Matrix3d m(_pose.Rot());
+  std::array<float, 9> rot;
+  for (int r = 0; r < 3; ++r)
+  {
+    for (int c = 0; c < 3; ++c)
+      rot[r * 3 + c] = static_cast<float>(m(r, c));
+  }
+  const std::array<float, 3> origin = {
+      static_cast<float>(_pose.Pos().X()),
+      static_cast<float>(_pose.Pos().Y()),
+      static_cast<float>(_pose.Pos().Z())};
+  const float rangeMax = static_cast<float>(_rangeMax);
+
+  const std::vector<RayObject> &objects = this->dataPtr->castObjects;
+  for (std::size_t i = 0u; i < _count; ++i)
+  {
+    const float *d = _directions + i * 3u;
+    const BvhRay ray(origin, {
+        rot[0] * d[0] + rot[1] * d[1] + rot[2] * d[2],
+        rot[3] * d[0] + rot[4] * d[1] + rot[5] * d[2],
+        rot[6] * d[0] + rot[7] * d[1] + rot[8] * d[2]});
+
+    float range = rangeMax;
+    float retro = 0.0f;
+    bool hit = false;
+    this->dataPtr->topLevel.Traverse(ray, range,
+        [&](uint32_t _index, float &_t)
+        {
+          const RayObject &object = objects[_index];
+          const std::array<float, 3> offset = {
+              ray.origin[0] - object.pos[0],
+              ray.origin[1] - object.pos[1],
+              ray.origin[2] - object.pos[2]};
+          // Rigid transforms keep distances, so _t carries over
+          const BvhRay local(object.ToLocal(offset), object.ToLocal(ray.dir));
+          if (object.mesh->Intersect(local, _t))
+          {
+            retro = object.retro;
+            hit = true;
+          }
+        });
+
+    _hits[i * _stride] = hit ? range : std::numeric_limits<float>::infinity();
+    _hits[i * _stride + 1u] = retro;
+  }
+}
+
+//////////////////////////////////////////////////
+CpuLidarSensor::CpuLidarSensor()
+  : dataPtr(new CpuLidarSensorPrivate())
+{
+}
+
+//////////////////////////////////////////////////
+CpuLidarSensor::~CpuLidarSensor() = default;
+
+//////////////////////////////////////////////////
+bool CpuLidarSensor::Load(const sdf::Sensor &_sdf)
+{
+  if (!Lidar::Load(_sdf))
+    return false;
+
+  const std::string pointTopic = this->Topic() + "/points";
+  if (!this->Advertise<msgs::PointCloudPacked>(this->dataPtr->node,
+      this->dataPtr->pointPub, pointTopic))
+  {
+    gzerr << "Unable to create publisher on topic[" << pointTopic
+          << "].\n";
+    return false;
+  }
+
+  gzdbg << "Lidar points for [" << this->Name() << "] advertised on ["
+        << pointTopic << "]" << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool CpuLidarSensor::Load(sdf::ElementPtr _sdf)
+{
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(_sdf);
+  return this->Load(sdfSensor);
+}
+
+//////////////////////////////////////////////////
+bool CpuLidarSensor::Init()
+{
+  return this->Sensor::Init();
+}
+
+//////////////////////////////////////////////////
+void CpuLidarSensorPrivate::UpdateDirections(const CpuLidarSensor &_sensor,
+    unsigned int _width, unsigned int _height)
+{
+  const std::array<double, 6> key{{
+      _sensor.AngleMin().Radian(), _sensor.AngleMax().Radian(),
+      _sensor.VerticalAngleMin().Radian(),
+      _sensor.VerticalAngleMax().Radian(),
+      static_cast<double>(_width), static_cast<double>(_height)}};
+  const std::size_t size = static_cast<std::size_t>(_width) * _height;
+  if (key == this->directionsKey && this->directions.size() == size * 3u)
+    return;
+  this->directionsKey = key;
+
+  // Same spherical convention as the point clouds of GpuLidarSensor,
+  // angles computed from their index so they don't drift along a row
+  const double angleStep =
+      _width > 1u ? (key[1] - key[0]) / (_width - 1u) : 0.0;
+  const double verticalAngleStep =
+      _height > 1u ? (key[3] - key[2]) / (_height - 1u) : 0.0;
+  this->directions.resize(size * 3u);
+  for (unsigned int j = 0; j < _height; ++j)
+  {
+    const double inclination = key[2] + j * verticalAngleStep;
+    for (unsigned int i = 0; i < _width; ++i)
+    {
+      const double azimuth = key[0] + i * angleStep;
+      float *d = this->directions.data() +
+          (static_cast<std::size_t>(j) * _width + i) * 3u;
+      d[0] = static_cast<float>(std::cos(inclination) * std::cos(azimuth));
+      d[1] = static_cast<float>(std::cos(inclination) * std::sin(azimuth));
+      d[2] = static_cast<float>(std::sin(inclination));
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+bool CpuLidarSensor::Update(const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("CpuLidarSensor::Update");
+  if (!this->initialized)
+  {
+    gzerr << "Not initialized, update ignored.\n";
+    return false;
+  }
+
+  const unsigned int width = this->RangeCount();
+  const unsigned int height = this->VerticalRangeCount();
+  const std::size_t rays = static_cast<std::size_t>(width) * height;
+  this->dataPtr->UpdateDirections(*this, width, height);
+
+  // Chunks of rays rather than rows are split between threads, so that a
+  // planar lidar is cast in parallel too
+  float *buffer = this->ScanWriteBuffer(rays * 3u);
+  const math::Pose3d pose = this->Pose();
+  const double rangeMin = this->RangeMin();
+  const double rangeMax = this->RangeMax();
+  const std::shared_ptr<CpuRayScene> scene = this->dataPtr->scene;
+  const float *directions = this->dataPtr->directions.data();
+  const auto blankingMask = this->BlankingMask();
+  const uint8_t *blanked = blankingMask && blankingMask->size() == rays ?
+      blankingMask->data() : nullptr;
+  const uint32_t chunks =
+      static_cast<uint32_t>((rays + kRayChunk - 1u) / kRayChunk);
+  {
+    GZ_PROFILE("CpuLidarSensor::Update Cast");
+    this->dataPtr->workers.ForEachRowRange(chunks,
+        [&](uint32_t _begin, uint32_t _end)
+        {
+          const std::size_t first = _begin * kRayChunk;
+          const std::size_t last = std::min(rays, _end * kRayChunk);
+          float *hits = buffer + first * 3u;
+
+          // Blanked rays aren't cast, runs of the others are
+          for (std::size_t begin = first; scene && begin < last;)
+          {
+            while (begin < last && blanked && blanked[begin])
+              ++begin;
+            std::size_t end = begin;
+            while (end < last && !(blanked && blanked[end]))
+              ++end;
+            if (end > begin)
+            {
+              scene->CastRays(pose, directions + begin * 3u, end - begin,
+                  rangeMax, buffer + begin * 3u, 3u);
+            }
+            begin = end;
+          }
+          for (std::size_t i = 0u; i < last - first; ++i)
+          {
+            float *hit = hits + i * 3u;
+            if (!scene || (blanked && blanked[first + i]))
+            {
+              hit[0] = std::numeric_limits<float>::infinity();
+              hit[1] = 0.0f;
+            }
+            else if (hit[0] < rangeMin)
+            {
+              hit[0] = -std::numeric_limits<float>::infinity();
+            }
+            hit[2] = 0.0f;
+          }
+        });
+  }
+  this->CommitScanBuffer();
+
+  if (this->dataPtr->lidarEvent.ConnectionCount() > 0u)
+    this->dataPtr->lidarEvent(buffer, width, height, 3u, "PF_FLOAT32_RGB");
+
+  this->ApplyNoise();
+  this->PublishLidarScan(_now);
+
+  if (this->dataPtr->pointPub.HasConnections())
+  {
+    const float *scan = this->AcquireScanBuffer();
+    if (scan)
+      this->dataPtr->PublishPoints(*this, scan, width, height, _now);
+    this->ReleaseScanBuffer();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void CpuLidarSensorPrivate::PublishPoints(CpuLidarSensor &_sensor,
+    const float *_scan, unsigned int _width, unsigned int _height,
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("CpuLidarSensor::Update Publish point cloud");
+  if (this->pointMsg.field_size() != 5 ||
+      this->pointMsg.width() != _width || this->pointMsg.height() != _height)
+  {
+    this->workers.InitMsg(this->pointMsg, _sensor.FrameId(), {
+        {"intensity", msgs::PointCloudPacked::Field::FLOAT32},
+        {"ring", msgs::PointCloudPacked::Field::UINT16}});
+    this->pointMsg.set_width(_width);
+    this->pointMsg.set_height(_height);
+    this->pointMsg.set_row_step(this->pointMsg.point_step() * _width);
+  }
+  _sensor.FillHeader(this->pointMsg.mutable_header(), _now);
+
+  const uint32_t pointStep = this->pointMsg.point_step();
+  const uint32_t offsets[5] = {
+      this->pointMsg.field(0).offset(), this->pointMsg.field(1).offset(),
+      this->pointMsg.field(2).offset(), this->pointMsg.field(3).offset(),
+      this->pointMsg.field(4).offset()};
+  std::string *data = this->pointMsg.mutable_data();
+  data->resize(static_cast<std::size_t>(pointStep) * _width * _height);
+
+  bool dense = true;
+  char *point = data->data();
+  for (unsigned int j = 0; j < _height; ++j)
+  {
+    const uint16_t ring = static_cast<uint16_t>(j);
+    for (unsigned int i = 0; i < _width; ++i)
+    {
+      const std::size_t index = static_cast<std::size_t>(j) * _width + i;
+      const float range = _scan[index * 3u];
+      dense = dense && std::isfinite(range);
+      const float *d = this->directions.data() + index * 3u;
+      const float values[4] = {
+          range * d[0], range * d[1], range * d[2], _scan[index * 3u + 1u]};
+      for (int k = 0; k < 4; ++k)
+        std::memcpy(point + offsets[k], &values[k], sizeof(float));
+      std::memcpy(point + offsets[4], &ring, sizeof(ring));
+      point += pointStep;
+    }
+  }
+  this->pointMsg.set_is_dense(dense);
+  _sensor.Publish(this->pointPub, this->pointMsg);
+}
+
+//////////////////////////////////////////////////
+void CpuLidarSensor::SetRayScene(std::shared_ptr<CpuRayScene> _scene)
+{
+  this->dataPtr->scene = std::move(_scene);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<CpuRayScene> CpuLidarSensor::RayScene() const
+{
+  return this->dataPtr->scene;
+}
+
+//////////////////////////////////////////////////
+void CpuLidarSensor::SetThreadCount(unsigned int _count)
+{
+  this->dataPtr->workers.SetThreadCount(_count);
+}
+
+//////////////////////////////////////////////////
+unsigned int CpuLidarSensor::ThreadCount() const
+{
+  return this->dataPtr->workers.ThreadCount();
+}
+
+//////////////////////////////////////////////////
+gz::common::ConnectionPtr CpuLidarSensor::ConnectNewLidarFrame(
+    std::function<void(const float *_scan, unsigned int _width,
+      unsigned int _height, unsigned int _channels,
+      const std::string &_format)> _subscriber)
+{
+  return this->dataPtr->lidarEvent.Connect(_subscriber);
+}
+
+//////////////////////////////////////////////////
+bool CpuLidarSensor::HasConnections() const
+{
+  return Lidar::HasConnections() ||
+      (this->dataPtr->pointPub && this->dataPtr->pointPub.HasConnections()) ||
+      this->dataPtr->lidarEvent.ConnectionCount() > 0u;
+}
+
+//////////////////////////////////////////////////
+SensorMemoryUsage CpuLidarSensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage = Lidar::MemoryUsage();
+  usage["directions"] = MemorySize(this->dataPtr->directions);
+  usage["point_msg"] = MemorySize(this->dataPtr->pointMsg);
+  return usage;
+}
+
+//////////////////////////////////////////////////
+bool CpuLidarSensor::IsRenderingSensor() const
+{
+  return false;
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+#include <sdf/sdf.hh>
+
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/math/Pose3.hh>
+#include <gz/math/Vector3.hh>
+
+#include <gz/sensors/CpuLidarSensor.hh>
+#include <gz/sensors/Manager.hh>
+
+using namespace gz;
+
+/// \brief Create the SDF of a lidar.
+/// \param[in] _horizontalSamples Number of rays per row.
+/// \param[in] _verticalSamples Number of rows.
+/// \return Sensor element.
+static sdf::ElementPtr CpuLidarToSDF(unsigned int _horizontalSamples,
+    unsigned int _verticalSamples)
+{
+  std::ostringstream stream;
+  stream
+    << "<?xml version='1.0'?>"
+    << "<sdf version='1.6'>"
+    << " <model name='m1'>"
+    << "  <link name='link1'>"
+    << "    <sensor name='cpu_lidar' type='lidar'>"
+    << "      <topic>/gz/sensors/test/cpu_lidar</topic>"
+    << "      <update_rate>10</update_rate>"
+    << "      <ray>"
+    << "        <scan>"
+    << "          <horizontal>"
+    << "            <samples>" << _horizontalSamples << "</samples>"
+    << "            <resolution>1</resolution>"
+    << "            <min_angle>-1.5</min_angle>"
+    << "            <max_angle>1.5</max_angle>"
+    << "          </horizontal>"
+    << "          <vertical>"
+    << "            <samples>" << _verticalSamples << "</samples>"
+    << "            <resolution>1</resolution>"
+    << "            <min_angle>-0.2</min_angle>"
+    << "            <max_angle>0.2</max_angle>"
+    << "          </vertical>"
+    << "        </scan>"
+    << "        <range>"
+    << "          <min>0.1</min>"
+    << "          <max>10</max>"
+    << "          <resolution>0.01</resolution>"
+    << "        </range>"
+    << "      </ray>"
+    << "      <always_on>1</always_on>"
+    << "    </sensor>"
+    << "  </link>"
+    << " </model>"
+    << "</sdf>";
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readString(stream.str(), sdfParsed))
+    return sdf::ElementPtr();
+
+  return sdfParsed->Root()->GetElement("model")->GetElement("link")
+    ->GetElement("sensor");
+}
+
+/// \brief Add a square of side 2 facing the x axis to a scene.
+/// \param[in] _scene Scene to add the mesh to.
+/// \return True on success.
+static bool AddQuadMesh(sensors::CpuRayScene &_scene)
+{
+  return _scene.SetMesh("quad",
+      {{0, -1, -1}, {0, 1, -1}, {0, 1, 1}, {0, -1, 1}},
+      {0, 1, 2, 0, 2, 3});
+}
+
+/////////////////////////////////////////////////
+TEST(CpuLidarSensor_TEST, Scene)
+{
+  sensors::CpuRayScene scene;
+  EXPECT_FALSE(scene.SetObject(1u, "quad", math::Pose3d::Zero));
+  EXPECT_FALSE(scene.SetMesh("bad", {{0, 0, 0}}, {0, 0, 1}));
+  ASSERT_TRUE(AddQuadMesh(scene));
+  EXPECT_TRUE(scene.SetObject(1u, "quad", math::Pose3d(5, 0, 0, 0, 0, 0),
+      0.5));
+  EXPECT_EQ(1u, scene.ObjectCount());
+
+  const std::vector<float> directions = {1, 0, 0, 0, 1, 0, -1, 0, 0};
+  std::vector<float> hits(6u);
+  scene.CastRays(math::Pose3d::Zero, directions.data(), 3u, 10.0,
+      hits.data(), 2u);
+  EXPECT_NEAR(5.0f, hits[0], 1e-4);
+  EXPECT_FLOAT_EQ(0.5f, hits[1]);
+  EXPECT_TRUE(std::isinf(hits[2]));
+  EXPECT_FLOAT_EQ(0.0f, hits[3]);
+  EXPECT_TRUE(std::isinf(hits[4]));
+
+  // Hits beyond the maximum range are ignored
+  scene.CastRays(math::Pose3d::Zero, directions.data(), 1u, 4.0,
+      hits.data(), 2u);
+  EXPECT_TRUE(std::isinf(hits[0]));
+
+  // Moving the object, or the rays, moves the hits
+  EXPECT_TRUE(scene.SetObjectPose(1u, math::Pose3d(0, 3, 0, 0, 0, 1.5708)));
+  EXPECT_FALSE(scene.SetObjectPose(2u, math::Pose3d::Zero));
+  scene.CastRays(math::Pose3d(0, 1, 0, 0, 0, 1.5708), directions.data(),
+      1u, 10.0, hits.data(), 2u);
+  EXPECT_NEAR(2.0f, hits[0], 1e-4);
+
+  EXPECT_TRUE(scene.RemoveObject(1u));
+  EXPECT_FALSE(scene.RemoveObject(1u));
+  EXPECT_EQ(0u, scene.ObjectCount());
+  scene.CastRays(math::Pose3d(0, 1, 0, 0, 0, 1.5708), directions.data(),
+      1u, 10.0, hits.data(), 2u);
+  EXPECT_TRUE(std::isinf(hits[0]));
+}
+
+/////////////////////////////////////////////////
+TEST(CpuLidarSensor_TEST, Scan)
+{
+  sensors::Manager mgr;
+  sdf::ElementPtr lidarSdf = CpuLidarToSDF(31u, 5u);
+  ASSERT_NE(nullptr, lidarSdf);
+  auto *sensor = mgr.CreateSensor<sensors::CpuLidarSensor>(lidarSdf);
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_FALSE(sensor->IsRenderingSensor());
+  EXPECT_EQ(1u, sensor->ThreadCount());
+  sensor->SetThreadCount(3u);
+  EXPECT_EQ(3u, sensor->ThreadCount());
+
+  // No scene, nothing is hit
+  EXPECT_TRUE(sensor->Update(std::chrono::steady_clock::duration::zero()));
+  EXPECT_TRUE(std::isinf(sensor->Range(15)));
+
+  auto scene = std::make_shared<sensors::CpuRayScene>();
+  ASSERT_TRUE(AddQuadMesh(*scene));
+  ASSERT_TRUE(scene->SetObject(7u, "quad", math::Pose3d(5, 0, 0, 0, 0, 0)));
+  sensor->SetRayScene(scene);
+  EXPECT_EQ(scene, sensor->RayScene());
+
+  unsigned int frames = 0u;
+  unsigned int frameWidth = 0u;
+  unsigned int frameHeight = 0u;
+  auto connection = sensor->ConnectNewLidarFrame(
+      [&](const float *, unsigned int _width, unsigned int _height,
+          unsigned int _channels, const std::string &_format)
+      {
+        ++frames;
+        frameWidth = _width;
+        frameHeight = _height;
+        EXPECT_EQ(3u, _channels);
+        EXPECT_EQ("PF_FLOAT32_RGB", _format);
+      });
+  EXPECT_TRUE(sensor->HasConnections());
+
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(100)));
+  EXPECT_EQ(1u, frames);
+  EXPECT_EQ(31u, frameWidth);
+  EXPECT_EQ(5u, frameHeight);
+
+  // The middle ray of the middle row points at the quad, the first and
+  // last rays of a row point sideways, past it
+  const int middle = 2 * 31 + 15;
+  EXPECT_NEAR(5.0, sensor->Range(middle), 1e-3);
+  EXPECT_TRUE(std::isinf(sensor->Range(2 * 31)));
+  EXPECT_TRUE(std::isinf(sensor->Range(2 * 31 + 30)));
+
+  // A ray at azimuth a and inclination b hits the plane x = 5 at
+  // 5 / (cos(a) cos(b))
+  const double azimuth = -1.5 + 16 * (3.0 / 30);
+  const double inclination = -0.2 + 3 * (0.4 / 4);
+  EXPECT_NEAR(5.0 / (std::cos(azimuth) * std::cos(inclination)),
+      sensor->Range(3 * 31 + 16), 1e-3);
+}
+
+/////////////////////////////////////////////////
+TEST(CpuLidarSensor_TEST, BlankingZones)
+{
+  sensors::Manager mgr;
+  sdf::ElementPtr lidarSdf = CpuLidarToSDF(31u, 5u);
+  ASSERT_NE(nullptr, lidarSdf);
+  auto *sensor = mgr.CreateSensor<sensors::CpuLidarSensor>(lidarSdf);
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_TRUE(sensor->BlankingZones().empty());
+  EXPECT_EQ(nullptr, sensor->BlankingMask());
+
+  auto scene = std::make_shared<sensors::CpuRayScene>();
+  ASSERT_TRUE(AddQuadMesh(*scene));
+  ASSERT_TRUE(scene->SetObject(7u, "quad", math::Pose3d(5, 0, 0, 0, 0, 0)));
+  sensor->SetRayScene(scene);
+
+  // Zones with inverted angles are rejected
+  sensors::LidarBlankingZone zone;
+  zone.angleMin = 0.05;
+  zone.angleMax = -0.05;
+  EXPECT_FALSE(sensor->SetBlankingZones({zone}));
+  EXPECT_TRUE(sensor->BlankingZones().empty());
+
+  // Blank the middle column, at azimuth zero
+  zone.angleMin = -0.05;
+  zone.angleMax = 0.05;
+  zone.verticalAngleMin = -1.0;
+  zone.verticalAngleMax = 1.0;
+  ASSERT_TRUE(sensor->SetBlankingZones({zone}));
+  ASSERT_EQ(1u, sensor->BlankingZones().size());
+  const auto mask = sensor->BlankingMask();
+  ASSERT_NE(nullptr, mask);
+  ASSERT_EQ(31u * 5u, mask->size());
+  EXPECT_NE(0u, (*mask)[2 * 31 + 15]);
+  EXPECT_EQ(0u, (*mask)[2 * 31 + 16]);
+
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(100)));
+  for (int row = 0; row < 5; ++row)
+    EXPECT_TRUE(std::isinf(sensor->Range(row * 31 + 15))) << row;
+  const double azimuth = -1.5 + 16 * (3.0 / 30);
+  EXPECT_NEAR(5.0 / std::cos(azimuth), sensor->Range(2 * 31 + 16), 1e-3);
+
+  // No zone, the middle ray hits the quad again
+  ASSERT_TRUE(sensor->SetBlankingZones({}));
+  EXPECT_EQ(nullptr, sensor->BlankingMask());
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(200)));
+  EXPECT_NEAR(5.0, sensor->Range(2 * 31 + 15), 1e-3);
+}
+
+/////////////////////////////////////////////////
+TEST(CpuLidarSensor_TEST, Reconfigure)
+{
+  sensors::Manager mgr;
+  sdf::ElementPtr lidarSdf = CpuLidarToSDF(31u, 5u);
+  ASSERT_NE(nullptr, lidarSdf);
+  auto *sensor = mgr.CreateSensor<sensors::CpuLidarSensor>(lidarSdf);
+  ASSERT_NE(nullptr, sensor);
+
+  auto scene = std::make_shared<sensors::CpuRayScene>();
+  ASSERT_TRUE(AddQuadMesh(*scene));
+  ASSERT_TRUE(scene->SetObject(7u, "quad", math::Pose3d(5, 0, 0, 0, 0, 0)));
+  sensor->SetRayScene(scene);
+
+  unsigned int frameWidth = 0u;
+  unsigned int frameHeight = 0u;
+  auto connection = sensor->ConnectNewLidarFrame(
+      [&](const float *, unsigned int _width, unsigned int _height,
+          unsigned int, const std::string &)
+      {
+        frameWidth = _width;
+        frameHeight = _height;
+      });
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(100)));
+  EXPECT_EQ(31u, frameWidth);
+  EXPECT_EQ(5u, frameHeight);
+
+  // More horizontal and fewer vertical samples at another rate
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(CpuLidarToSDF(61u, 3u));
+  sdfSensor.SetUpdateRate(20.0);
+  ASSERT_TRUE(sensor->Reconfigure(sdfSensor));
+  EXPECT_EQ(61u, sensor->RayCount());
+  EXPECT_EQ(3u, sensor->VerticalRayCount());
+  EXPECT_DOUBLE_EQ(20.0, sensor->UpdateRate());
+
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(200)));
+  EXPECT_EQ(61u, frameWidth);
+  EXPECT_EQ(3u, frameHeight);
+  EXPECT_NEAR(5.0, sensor->Range(61 + 30), 1e-3);
+  const double azimuth = -1.5 + 31 * (3.0 / 60);
+  EXPECT_NEAR(5.0 / std::cos(azimuth), sensor->Range(61 + 31), 1e-3);
+
+  // Changes that require recreating the sensor are rejected as a whole
+  sdf::Sensor other = sdfSensor;
+  sdf::Lidar lidar = *sdfSensor.LidarSensor();
+  lidar.SetHorizontalScanSamples(11u);
+  other.SetLidarSensor(lidar);
+  other.SetTopic("/gz/sensors/test/other_lidar");
+  EXPECT_FALSE(sensor->Reconfigure(other));
+  EXPECT_EQ(61u, sensor->RayCount());
+
+  other = sdfSensor;
+  lidar.SetHorizontalScanSamples(0u);
+  other.SetLidarSensor(lidar);
+  EXPECT_FALSE(sensor->Reconfigure(other));
+  EXPECT_EQ(61u, sensor->RayCount());
+
+  sdf::Sensor camera;
+  camera.SetType(sdf::SensorType::CAMERA);
+  EXPECT_FALSE(sensor->Reconfigure(camera));
+}
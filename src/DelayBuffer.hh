@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_DELAYBUFFER_HH_
+#define GZ_SENSORS_DELAYBUFFER_HH_
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <google/protobuf/message.h>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Fixed size ring of messages that are held until a release
+    /// time. The slots keep their messages once they have been released,
+    /// so after the ring has been filled once, messages are moved or copied
+    /// into memory that's already allocated. Release times are expected to
+    /// be pushed in increasing order.
+    class DelayBuffer
+    {
+      /// \brief Constructor
+      /// \param[in] _capacity Number of slots. Zero is treated as one.
+      public: explicit DelayBuffer(std::size_t _capacity)
+        : slots(_capacity > 0u ? _capacity : 1u)
+      {
+      }
+
+      /// \brief Get the number of slots.
+      /// \return Number of slots.
+      public: std::size_t Capacity() const
+      {
+        return this->slots.size();
+      }
+
+      /// \brief Get the number of messages being held.
+      /// \return Number of messages.
+      public: std::size_t Size() const
+      {
+        return this->size;
+      }
+
+      /// \brief Check whether all slots are holding a message.
+      /// \return True if no message can be pushed.
+      public: bool Full() const
+      {
+        return this->size == this->slots.size();
+      }
+
+      /// \brief Hold a copy of a message. The buffer must not be full.
+      /// \param[in] _release Time at which the message is released.
+      /// \param[in] _msg Message to hold.
+      public: void Push(const std::chrono::steady_clock::duration &_release,
+                  const google::protobuf::Message &_msg)
+      {
+        this->Next(_release, _msg).CopyFrom(_msg);
+      }
+
+      /// \brief Hold the contents of a message, which are swapped with the
+      /// slot, leaving _msg empty. The buffer must not be full.
+      /// \param[in] _release Time at which the message is released.
+      /// \param[in] _msg Message to hold.
+      public: void Push(const std::chrono::steady_clock::duration &_release,
+                  google::protobuf::Message &&_msg)
+      {
+        auto &slot = this->Next(_release, _msg);
+        slot.GetReflection()->Swap(&slot, &_msg);
+        _msg.Clear();
+      }
+
+      /// \brief Release the messages whose release time has been reached,
+      /// oldest first.
+      /// \param[in] _now Current time.
+      /// \param[in] _release Called with each released message, which may
+      /// be modified or swapped out.
+      /// \tparam F Callable taking a google::protobuf::Message reference.
+      /// \return Number of released messages.
+      public: template <typename F>
+              std::size_t Release(
+                  const std::chrono::steady_clock::duration &_now,
+                  F &&_release)
+      {
+        std::size_t released = 0u;
+        while (this->size > 0u && this->slots[this->head].release <= _now)
+        {
+          this->ReleaseOldest(_release);
+          ++released;
+        }
+        return released;
+      }
+
+      /// \brief Release the oldest message, whatever its release time.
+      /// \param[in] _release Called with the message if there's one.
+      /// \tparam F Callable taking a google::protobuf::Message reference.
+      public: template <typename F>
+              void ReleaseOldest(F &&_release)
+      {
+        if (this->size == 0u)
+          return;
+        auto &slot = this->slots[this->head];
+        _release(*slot.msg);
+        slot.msg->Clear();
+        this->head = (this->head + 1u) % this->slots.size();
+        --this->size;
+      }
+
+      /// \brief Drop all the messages being held. The slots keep their
+      /// memory.
+      public: void Clear()
+      {
+        for (; this->size > 0u; --this->size)
+        {
+          this->slots[this->head].msg->Clear();
+          this->head = (this->head + 1u) % this->slots.size();
+        }
+      }
+
+      /// \brief Get the memory held by the slots.
+      /// \return Bytes used by the messages of the slots.
+      public: std::size_t SpaceUsed() const
+      {
+        std::size_t bytes = this->slots.capacity() * sizeof(Slot);
+        for (const auto &slot : this->slots)
+        {
+          if (slot.msg)
+            bytes += slot.msg->SpaceUsedLong();
+        }
+        return bytes;
+      }
+
+      /// \brief Take the next free slot, creating its message if it has
+      /// none or one of another type.
+      /// \param[in] _release Time at which the message is released.
+      /// \param[in] _prototype Message of the type to hold.
+      /// \return Empty message of the slot.
+      private: google::protobuf::Message &Next(
+                   const std::chrono::steady_clock::duration &_release,
+                   const google::protobuf::Message &_prototype)
+      {
+        auto &slot =
+            this->slots[(this->head + this->size) % this->slots.size()];
+        if (!slot.msg ||
+            slot.msg->GetDescriptor() != _prototype.GetDescriptor())
+        {
+          slot.msg.reset(_prototype.New());
+        }
+        slot.release = _release;
+        ++this->size;
+        return *slot.msg;
+      }
+
+      /// \brief A held message.
+      private: struct Slot
+      {
+        /// \brief Time at which the message is released.
+        std::chrono::steady_clock::duration release{0};
+
+        /// \brief The message, kept once released.
+        std::unique_ptr<google::protobuf::Message> msg;
+      };
+
+      /// \brief Slots of the ring.
+      private: std::vector<Slot> slots;
+
+      /// \brief Index of the oldest message.
+      private: std::size_t head{0u};
+
+      /// \brief Number of messages being held.
+      private: std::size_t size{0u};
+    };
+    }
+  }
+}
+
+#endif
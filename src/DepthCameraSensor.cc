@@ -18,7 +18,14 @@
 #include <gz/msgs/image.pb.h>
 #include <gz/msgs/pointcloud_packed.pb.h>
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <gz/common/Console.hh>
 #include <gz/common/Image.hh>
@@ -36,9 +43,15 @@
 #include "gz/sensors/SensorFactory.hh"
 #include "gz/sensors/ImageGaussianNoiseModel.hh"
 #include "gz/sensors/ImageNoise.hh"
+#include "gz/sensors/ImageWriter.hh"
 #include "gz/sensors/RenderingEvents.hh"
 
+#include "AlignedBuffer.hh"
+#include "ElevationMap.hh"
+#include "MemorySize.hh"
+#include "PointCloudCompressor.hh"
 #include "PointCloudUtil.hh"
+#include "TraceRecorder.hh"
 
 // undefine near and far macros from windows.h
 #ifdef _WIN32
@@ -82,22 +95,55 @@ class gz::sensors::DepthCameraSensorPrivate
   public: gz::rendering::DepthCameraPtr depthCamera;
 
   /// \brief Depth data buffer.
-  public: float *depthBuffer = nullptr;
+  public: AlignedBuffer<float> depthBuffer;
+
+  /// \brief Latest depth frame, either depthBuffer or, when frames are
+  /// used in place, the depth camera's buffer.
+  public: const float *depthFrame{nullptr};
+
+  /// \brief The image noise if it's applied to the frames on the CPU, in
+  /// which case frames are always copied to depthBuffer.
+  public: std::shared_ptr<ImageGaussianNoiseModel> cpuNoise;
+
+  /// \brief Cropped and decimated depth image, unused for full frames.
+  public: std::vector<unsigned char> regionBuffer;
 
   /// \brief point cloud data buffer.
-  public: float *pointCloudBuffer = nullptr;
+  public: AlignedBuffer<float> pointCloudBuffer;
+
+  /// \brief Latest point cloud, either pointCloudBuffer or, when frames
+  /// are used in place, the depth camera's buffer.
+  public: const float *pointCloudFrame{nullptr};
 
   /// \brief xyz data buffer.
-  public: float *xyzBuffer = nullptr;
+  public: AlignedBuffer<float> xyzBuffer;
 
   /// \brief Near clip distance.
   public: float near = 0.0;
 
+  /// \brief True to scale the depth images between the clip distances
+  /// instead of between zero and the largest depth.
+  public: bool fixedImageRange = false;
+
+  /// \brief True to output uint16 millimeters instead of float meters.
+  public: bool millimeters = false;
+
+  /// \brief True to publish point clouds in the layout of the depth
+  /// camera's point cloud buffer.
+  public: bool gpuPointLayout = false;
+
+  /// \brief Whether pointMsg was last initialized with the layout of the
+  /// depth camera's point cloud buffer.
+  public: bool pointMsgGpuLayout = false;
+
+  /// \brief Depth image converted to millimeters.
+  public: std::vector<uint16_t> millimeterBuffer;
+
   /// \brief Pointer to an image to be published
   public: gz::rendering::Image image;
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
 
   /// \brief Event that is used to trigger callbacks when a new image
   /// is generated
@@ -134,39 +180,135 @@ class gz::sensors::DepthCameraSensorPrivate
   /// \brief The point cloud message.
   public: msgs::PointCloudPacked pointMsg;
 
+  /// \brief Voxel filtered point cloud, when a voxel size is set.
+  public: msgs::PointCloudPacked voxelMsg;
+
   /// \brief Helper class that can fill a msgs::PointCloudPacked
   /// image and depth data.
   public: PointCloudUtil pointsUtil;
 
+  /// \brief Initialize the point message with the coordinate type of a
+  /// resolution, keeping its width and height.
+  /// \param[in] _frameId Frame of the point cloud.
+  /// \param[in] _resolution Resolution of the coordinates, zero for floats.
+  public: void InitPointMsg(const std::string &_frameId, double _resolution);
+
+  /// \brief Publish pointMsg, or its voxel filtered copy when the sensor
+  /// has a voxel size.
+  /// \param[in] _sensor The sensor.
+  public: void PublishPointMsg(DepthCameraSensor &_sensor);
+
   /// \brief publisher to publish point cloud
   public: transport::Node::Publisher pointPub;
+
+  /// \brief Publisher of the compressed point clouds.
+  public: transport::Node::Publisher compressedPointPub;
+
+  /// \brief Encodes and publishes compressed point clouds, null unless
+  /// compressed output is enabled.
+  public: std::unique_ptr<PointCloudCompressor> pointCompressor;
+
+  /// \brief Publisher of the surface normals.
+  public: transport::Node::Publisher normalPub;
+
+  /// \brief Surface normals, 3 floats per point.
+  public: AlignedBuffer<float> normalBuffer;
+
+  /// \brief Publisher of the elevation maps.
+  public: transport::Node::Publisher elevationMapPub;
+
+  /// \brief Elevation map around the sensor, null unless elevation map
+  /// output is enabled.
+  public: std::unique_ptr<ElevationMap> elevationMap;
+
+  /// \brief Minimum time between two elevation maps.
+  public: std::chrono::steady_clock::duration elevationMapPeriod{0};
+
+  /// \brief Time of the last published elevation map.
+  public: std::chrono::steady_clock::duration elevationMapTime{0};
+
+  /// \brief True once an elevation map was published.
+  public: bool elevationMapPublished{false};
+
+  /// \brief Publish the elevation map, unless the last one was published
+  /// less than elevationMapPeriod ago.
+  /// \param[in] _sensor The sensor.
+  /// \param[in] _now Time of the frame.
+  public: void PublishElevationMap(DepthCameraSensor &_sensor,
+              const std::chrono::steady_clock::duration &_now);
 };
 
 using namespace gz;
 using namespace sensors;
 
+//////////////////////////////////////////////////
+void DepthCameraSensorPrivate::InitPointMsg(const std::string &_frameId,
+    double _resolution)
+{
+  // \todo(anyone) Float coordinates force the xyz and rgb fields to be
+  // aligned to memory boundaries. This is need by ROS1:
+  // https://github.com/ros/common_msgs/pull/77. Ideally, memory alignment
+  // should be configured.
+  const uint32_t width = this->pointMsg.width();
+  const uint32_t height = this->pointMsg.height();
+  this->pointsUtil.SetResolution(_resolution);
+  this->pointMsgGpuLayout = this->gpuPointLayout;
+  if (this->pointMsgGpuLayout)
+  {
+    // x, y, z and rgba of the depth camera buffer, tightly packed
+    this->pointMsg.Clear();
+    msgs::InitPointCloudPacked(this->pointMsg, _frameId, false,
+        {{"xyz", msgs::PointCloudPacked::Field::FLOAT32},
+         {"rgba", msgs::PointCloudPacked::Field::UINT32}});
+  }
+  else
+  {
+    this->pointsUtil.InitMsg(this->pointMsg, _frameId,
+        {{"rgb", msgs::PointCloudPacked::Field::FLOAT32}});
+  }
+  this->pointMsg.set_width(width);
+  this->pointMsg.set_height(height);
+  this->pointMsg.set_row_step(this->pointMsg.point_step() * width);
+}
+
+//////////////////////////////////////////////////
+void DepthCameraSensorPrivate::PublishPointMsg(DepthCameraSensor &_sensor)
+{
+  _sensor.AddSequence(this->pointMsg.mutable_header(), "pointMsg");
+  const double voxelSize = _sensor.PointCloudVoxelSize();
+  const msgs::PointCloudPacked *msg = &this->pointMsg;
+  if (voxelSize > 0.0)
+  {
+    this->pointsUtil.VoxelFilter(this->pointMsg, voxelSize, this->voxelMsg);
+    msg = &this->voxelMsg;
+  }
+  if (this->pointPub.HasConnections())
+    _sensor.Publish(this->pointPub, *msg);
+  if (_sensor.HasCompressedPointConnections())
+    this->pointCompressor->Push(*msg);
+}
+
 //////////////////////////////////////////////////
 bool DepthCameraSensorPrivate::ConvertDepthToImage(
     const float *_data,
     unsigned char *_imageBuffer,
     unsigned int _width, unsigned int _height)
 {
-  float maxDepth = 0;
-  for (unsigned int i = 0; i < _height * _width; ++i)
+  // A fixed range skips the pass that finds the largest depth
+  float nearDepth = 0.0f;
+  float farDepth = 0.0f;
+  if (this->fixedImageRange)
   {
-    if (_data[i] > maxDepth && !std::isinf(_data[i]))
-    {
-      maxDepth = _data[i];
-    }
+    nearDepth = this->near;
+    farDepth = static_cast<float>(this->depthCamera->FarClipPlane());
   }
-  double factor = 255 / maxDepth;
-  for (unsigned int j = 0; j < _height * _width; ++j)
+  else
   {
-    unsigned char d = static_cast<unsigned char>(255 - (_data[j] * factor));
-    _imageBuffer[j * 3] = d;
-    _imageBuffer[j * 3 + 1] = d;
-    _imageBuffer[j * 3 + 2] = d;
+    farDepth = this->pointsUtil.MaxFiniteDepth(_data,
+        static_cast<std::size_t>(_width) * _height);
   }
+  this->pointsUtil.DepthToImage(_imageBuffer, _data, _width, _height,
+      nearDepth, farDepth);
   return true;
 }
 
@@ -185,26 +327,33 @@ bool DepthCameraSensorPrivate::SaveImage(const float *_data,
   if (_width == 0 || _height == 0)
     return false;
 
-  common::Image localImage;
+  std::string filename = this->saveImagePrefix +
+                         std::to_string(this->saveImageCounter) + ".png";
+  ++this->saveImageCounter;
 
   unsigned int depthSamples = _width * _height;
-  unsigned int depthBufferSize = depthSamples * 3;
 
-  unsigned char * imgDepthBuffer = new unsigned char[depthBufferSize];
+  // Millimeter depths are saved as they are published, in a 16 bit PNG
+  if (this->millimeters)
+  {
+    std::vector<unsigned char> mmBuffer(depthSamples * sizeof(uint16_t));
+    this->pointsUtil.DepthToMillimeters(
+        reinterpret_cast<uint16_t *>(mmBuffer.data()), _data, depthSamples);
+    return ImageWriter::Instance().Write(
+        common::joinPaths(this->saveImagePath, filename),
+        std::move(mmBuffer), _width, _height, common::Image::L_INT16);
+  }
 
-  this->ConvertDepthToImage(_data, imgDepthBuffer, _width, _height);
+  unsigned int depthBufferSize = depthSamples * 3;
 
-  std::string filename = this->saveImagePrefix +
-                         std::to_string(this->saveImageCounter) + ".png";
-  ++this->saveImageCounter;
+  std::vector<unsigned char> imgDepthBuffer(depthBufferSize);
 
-  localImage.SetFromData(imgDepthBuffer, _width, _height,
-      common::Image::RGB_INT8);
-  localImage.SavePNG(
-      common::joinPaths(this->saveImagePath, filename));
+  this->ConvertDepthToImage(_data, imgDepthBuffer.data(), _width, _height);
 
-  delete[] imgDepthBuffer;
-  return true;
+  // Encoding and writing the file happen on the image writer's threads
+  return ImageWriter::Instance().Write(
+      common::joinPaths(this->saveImagePath, filename),
+      std::move(imgDepthBuffer), _width, _height, common::Image::RGB_INT8);
 }
 
 //////////////////////////////////////////////////
@@ -218,12 +367,6 @@ DepthCameraSensor::~DepthCameraSensor()
 {
   this->dataPtr->depthConnection.reset();
   this->dataPtr->pointCloudConnection.reset();
-  if (this->dataPtr->depthBuffer)
-    delete [] this->dataPtr->depthBuffer;
-  if (this->dataPtr->pointCloudBuffer)
-    delete [] this->dataPtr->pointCloudBuffer;
-  if (this->dataPtr->xyzBuffer)
-    delete [] this->dataPtr->xyzBuffer;
 }
 
 //////////////////////////////////////////////////
@@ -269,10 +412,8 @@ bool DepthCameraSensor::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/camera/depth");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<msgs::Image>(
-          this->Topic());
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() << "].\n";
@@ -286,10 +427,8 @@ bool DepthCameraSensor::Load(const sdf::Sensor &_sdf)
     return false;
 
   // Create the point cloud publisher
-  this->dataPtr->pointPub =
-      this->dataPtr->node.Advertise<msgs::PointCloudPacked>(
-          this->Topic() + "/points");
-  if (!this->dataPtr->pointPub)
+  if (!this->Advertise<msgs::PointCloudPacked>(this->dataPtr->node,
+      this->dataPtr->pointPub, this->Topic() + "/points"))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() + "/points" << "].\n";
@@ -299,6 +438,15 @@ bool DepthCameraSensor::Load(const sdf::Sensor &_sdf)
   gzdbg << "Points for [" << this->Name() << "] advertised on ["
          << this->Topic() << "/points]" << std::endl;
 
+  // Create the surface normals publisher
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+      this->dataPtr->normalPub, this->Topic() + "/normals"))
+  {
+    gzerr << "Unable to create publisher on topic["
+      << this->Topic() + "/normals" << "].\n";
+    return false;
+  }
+
   if (this->Scene())
   {
     this->CreateCamera();
@@ -355,9 +503,11 @@ bool DepthCameraSensor::CreateCamera()
       this->dataPtr->noises[noiseType] =
         ImageNoiseFactory::NewNoiseModel(noiseSdf, "depth");
 
-      std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
-           this->dataPtr->noises[noiseType])->SetCamera(
-             this->dataPtr->depthCamera);
+      auto imageNoise = std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
+          this->dataPtr->noises[noiseType]);
+      imageNoise->SetCamera(this->dataPtr->depthCamera);
+      this->dataPtr->cpuNoise =
+          imageNoise->AppliesOnCpu() ? imageNoise : nullptr;
     }
     else if (noiseSdf.Type() != sdf::NoiseType::NONE)
     {
@@ -371,6 +521,10 @@ bool DepthCameraSensor::CreateCamera()
   // from objects before near clip plane
   this->dataPtr->near = near;
 
+  // Depths are float meters unless 16 bit millimeters are requested
+  this->dataPtr->millimeters =
+      cameraSdf->PixelFormat() == sdf::PixelFormatType::L_INT16;
+
   // \todo(nkoeng) these parameters via sdf
   this->dataPtr->depthCamera->SetAntiAliasing(2);
 
@@ -401,29 +555,26 @@ bool DepthCameraSensor::CreateCamera()
     this->dataPtr->saveImage = true;
   }
 
+  // Allocate the depth buffers before the first frame arrives
+  const std::size_t depthSamples = static_cast<std::size_t>(width) * height;
+  this->dataPtr->depthBuffer.SetMemory(this->BufferMemory());
+  this->dataPtr->depthBuffer.Reserve(depthSamples);
+  this->dataPtr->depthFrame = nullptr;
+  this->dataPtr->pointCloudFrame = nullptr;
+  if (this->dataPtr->millimeters)
+    this->dataPtr->millimeterBuffer.reserve(depthSamples);
+
   this->dataPtr->depthConnection =
       this->dataPtr->depthCamera->ConnectNewDepthFrame(
       std::bind(&DepthCameraSensor::OnNewDepthFrame, this,
         std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
         std::placeholders::_4, std::placeholders::_5));
 
-  // Initialize the point message.
-  // \todo(anyone) The true value in the following function call forces
-  // the xyz and rgb fields to be aligned to memory boundaries. This is need
-  // by ROS1: https://github.com/ros/common_msgs/pull/77. Ideally, memory
-  // alignment should be configured.
-  msgs::InitPointCloudPacked(
-        this->dataPtr->pointMsg,
-        this->OpticalFrameId(),
-        true,
-        {{"xyz", msgs::PointCloudPacked::Field::FLOAT32},
-         {"rgb", msgs::PointCloudPacked::Field::FLOAT32}});
-
-  // Set the values of the point message based on the camera information.
+  // Initialize the point message based on the camera information.
   this->dataPtr->pointMsg.set_width(this->ImageWidth());
   this->dataPtr->pointMsg.set_height(this->ImageHeight());
-  this->dataPtr->pointMsg.set_row_step(
-      this->dataPtr->pointMsg.point_step() * this->ImageWidth());
+  this->dataPtr->InitPointMsg(this->OpticalFrameId(),
+      this->PointCloudResolution());
 
   return true;
 }
@@ -442,15 +593,27 @@ void DepthCameraSensor::OnNewDepthFrame(const float *_scan,
   common::Image::PixelFormatType format =
     common::Image::ConvertPixelFormat(_format);
 
-  if (!this->dataPtr->depthBuffer)
-    this->dataPtr->depthBuffer = new float[depthSamples];
-
-  memcpy(this->dataPtr->depthBuffer, _scan, depthBufferSize);
+  if (this->ZeroCopyFrames() && !this->dataPtr->cpuNoise)
+  {
+    this->dataPtr->depthFrame = _scan;
+  }
+  else
+  {
+    this->dataPtr->depthBuffer.Resize(depthSamples);
+    memcpy(this->dataPtr->depthBuffer.Data(), _scan, depthBufferSize);
+    if (this->dataPtr->cpuNoise)
+    {
+      this->dataPtr->cpuNoise->SetThreadCount(this->ImageNoiseThreadCount());
+      this->dataPtr->cpuNoise->ApplyToImage(this->dataPtr->depthBuffer.Data(),
+          depthSamples);
+    }
+    this->dataPtr->depthFrame = this->dataPtr->depthBuffer.Data();
+  }
 
   // Save image
   if (this->dataPtr->saveImage)
   {
-    this->dataPtr->SaveImage(_scan, _width, _height,
+    this->dataPtr->SaveImage(this->dataPtr->depthFrame, _width, _height,
         format);
   }
 }
@@ -467,10 +630,17 @@ void DepthCameraSensor::OnNewRgbPointCloud(const float *_scan,
   unsigned int pointCloudBufferSize = pointCloudSamples * _channels *
       sizeof(float);
 
-  if (!this->dataPtr->pointCloudBuffer)
-    this->dataPtr->pointCloudBuffer = new float[pointCloudSamples * _channels];
-
-  memcpy(this->dataPtr->pointCloudBuffer, _scan, pointCloudBufferSize);
+  if (this->ZeroCopyFrames())
+  {
+    this->dataPtr->pointCloudFrame = _scan;
+  }
+  else
+  {
+    this->dataPtr->pointCloudBuffer.Resize(pointCloudSamples * _channels);
+    memcpy(this->dataPtr->pointCloudBuffer.Data(), _scan,
+        pointCloudBufferSize);
+    this->dataPtr->pointCloudFrame = this->dataPtr->pointCloudBuffer.Data();
+  }
 }
 
 /////////////////////////////////////////////////
@@ -519,58 +689,114 @@ bool DepthCameraSensor::Update(
     return false;
   }
 
-  if (this->HasInfoConnections())
-  {
-    // publish the camera info message
-    this->PublishInfo(_now);
-  }
+  // publish the camera info message, if it has subscribers
+  this->PublishInfo(_now);
 
-  if (!this->HasDepthConnections() && !this->HasPointConnections())
+  if (!this->HasDepthConnections() && !this->HasPointConnections() &&
+      !this->HasNormalConnections() && !this->HasElevationMapConnections())
   {
     return false;
   }
 
-  if (this->HasPointConnections() && !this->dataPtr->pointCloudConnection)
+  // Normals and elevation maps are computed from the point cloud
+  const bool needPoints = this->HasPointConnections() ||
+      this->HasNormalConnections() || this->HasElevationMapConnections();
+  if (needPoints && !this->dataPtr->pointCloudConnection)
   {
+    // Allocate the point cloud buffers before the first cloud arrives
+    const std::size_t samples =
+        static_cast<std::size_t>(this->ImageWidth()) * this->ImageHeight();
+    this->dataPtr->pointCloudBuffer.SetMemory(this->BufferMemory());
+    this->dataPtr->xyzBuffer.SetMemory(this->BufferMemory());
+    this->dataPtr->pointCloudBuffer.Reserve(samples * 4u);
+    this->dataPtr->xyzBuffer.Reserve(samples * 3u);
     this->dataPtr->pointCloudConnection =
         this->dataPtr->depthCamera->ConnectNewRgbPointCloud(
         std::bind(&DepthCameraSensor::OnNewRgbPointCloud, this,
           std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
           std::placeholders::_4, std::placeholders::_5));
+
+    // The last frame has no point cloud
+    this->InvalidateFrame();
   }
-  else if (!this->HasPointConnections() && this->dataPtr->pointCloudConnection)
+  else if (!needPoints && this->dataPtr->pointCloudConnection)
   {
     this->dataPtr->pointCloudConnection.reset();
+    this->dataPtr->pointCloudFrame = nullptr;
   }
 
-  // generate sensor data
-  this->Render();
+  // generate sensor data, unless the last frame is still valid. The noise
+  // is rendered, so noisy frames aren't reused.
+  std::chrono::steady_clock::duration frameTime{_now};
+  if ((this->dataPtr->noises[CAMERA_NOISE] || !this->ReuseFrame()) &&
+      !this->Render(_now, frameTime))
+  {
+    // The first frame in async readback mode isn't complete yet
+    return true;
+  }
 
   unsigned int width = this->dataPtr->depthCamera->ImageWidth();
   unsigned int height = this->dataPtr->depthCamera->ImageHeight();
 
   auto msgsFormat = msgs::PixelFormatType::R_FLOAT32;
+  auto renderingFormat = rendering::PF_FLOAT32_R;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+
+  if (!this->dataPtr->depthFrame)
+    return false;
+
+  // Only the depth image is cropped, the point cloud is full size
+  unsigned int depthWidth = width;
+  unsigned int depthHeight = height;
+  const unsigned char *depthData = this->ApplyRegionOfInterest(
+      reinterpret_cast<const unsigned char *>(this->dataPtr->depthFrame),
+      depthWidth, depthHeight, sizeof(float), this->dataPtr->regionBuffer);
+
+  // Convert the cropped depths, which halves the size of the image
+  if (this->dataPtr->millimeters)
+  {
+    msgsFormat = msgs::PixelFormatType::L_INT16;
+    renderingFormat = rendering::PF_L16;
+    const std::size_t depthSamples =
+        static_cast<std::size_t>(depthWidth) * depthHeight;
+    this->dataPtr->millimeterBuffer.resize(depthSamples);
+    this->dataPtr->pointsUtil.DepthToMillimeters(
+        this->dataPtr->millimeterBuffer.data(),
+        reinterpret_cast<const float *>(depthData), depthSamples);
+    depthData = reinterpret_cast<const unsigned char *>(
+        this->dataPtr->millimeterBuffer.data());
+  }
 
   // create message
   msgs::Image msg;
-  msg.set_width(width);
-  msg.set_height(height);
-  msg.set_step(width * rendering::PixelUtil::BytesPerPixel(
-               rendering::PF_FLOAT32_R));
+  msg.set_width(depthWidth);
+  msg.set_height(depthHeight);
+  msg.set_step(depthWidth * rendering::PixelUtil::BytesPerPixel(
+               renderingFormat));
   msg.set_pixel_format_type(msgsFormat);
-  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
+  *msg.mutable_header()->mutable_stamp() = msgs::Convert(frameTime);
 
   auto* frame = msg.mutable_header()->add_data();
   frame->set_key("frame_id");
   frame->add_value(this->OpticalFrameId());
 
-  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
-  msg.set_data(this->dataPtr->depthBuffer,
-      rendering::PixelUtil::MemorySize(rendering::PF_FLOAT32_R,
-      width, height));
+  // Pixels only go through protobuf if someone receives the message
+  const bool publishDepth =
+      (this->dataPtr->pub && this->dataPtr->pub.HasConnections()) ||
+      this->dataPtr->imageEvent.ConnectionCount() > 0u ||
+      !this->SharedMemoryOutput();
+
+  const std::size_t depthSize = rendering::PixelUtil::MemorySize(
+      renderingFormat, depthWidth, depthHeight);
+  if (publishDepth)
+    msg.set_data(depthData, depthSize);
 
   this->AddSequence(msg.mutable_header(), "default");
-  this->dataPtr->pub.Publish(msg);
+  this->WriteSharedMemoryImage(this->Topic(), msg, depthData, depthSize);
+  this->RecordFrame(0u, msg, depthData, depthSize);
+  if (publishDepth)
+    this->Publish(this->dataPtr->pub, msg);
 
 
   if (this->dataPtr->imageEvent.ConnectionCount() > 0u)
@@ -586,41 +812,99 @@ bool DepthCameraSensor::Update(
     }
   }
 
-  if (this->HasPointConnections() &&
-      this->dataPtr->pointCloudBuffer)
+  if (this->HasNormalConnections() && this->dataPtr->pointCloudFrame)
   {
-    // Set the time stamp
-    *this->dataPtr->pointMsg.mutable_header()->mutable_stamp() =
-      msgs::Convert(_now);
-    this->dataPtr->pointMsg.set_is_dense(true);
+    GZ_PROFILE("DepthCameraSensor::Update Normals");
+    const std::size_t samples = static_cast<std::size_t>(width) * height;
+    this->dataPtr->normalBuffer.SetMemory(this->BufferMemory());
+    this->dataPtr->normalBuffer.Resize(samples * 3u);
+    this->dataPtr->pointsUtil.SetThreadCount(this->PointCloudThreadCount());
+    this->dataPtr->pointsUtil.NormalsFromPointCloud(
+        this->dataPtr->normalBuffer.Data(), this->dataPtr->pointCloudFrame,
+        width, height);
 
-    if (!this->dataPtr->xyzBuffer)
-      this->dataPtr->xyzBuffer = new float[width*height*3];
+    msgs::Image normalMsg;
+    normalMsg.set_width(width);
+    normalMsg.set_height(height);
+    normalMsg.set_step(width * 3u * sizeof(float));
+    normalMsg.set_pixel_format_type(msgs::PixelFormatType::RGB_FLOAT32);
+    *normalMsg.mutable_header()->mutable_stamp() = msgs::Convert(frameTime);
+    auto *normalFrame = normalMsg.mutable_header()->add_data();
+    normalFrame->set_key("frame_id");
+    normalFrame->add_value(this->OpticalFrameId());
+    normalMsg.set_data(this->dataPtr->normalBuffer.Data(),
+        samples * 3u * sizeof(float));
+    this->AddSequence(normalMsg.mutable_header(), "normals");
+    this->Publish(this->dataPtr->normalPub, normalMsg);
+  }
+
+  if (this->HasElevationMapConnections() && this->dataPtr->pointCloudFrame)
+  {
+    this->dataPtr->elevationMap->AddPoints(this->dataPtr->pointCloudFrame,
+        static_cast<std::size_t>(width) * height, 4u, this->Pose());
+    this->dataPtr->PublishElevationMap(*this, frameTime);
+  }
 
-    if (this->dataPtr->image.Width() != width
-        || this->dataPtr->image.Height() != height)
+  if (this->HasPointConnections() && this->dataPtr->pointCloudFrame)
+  {
+    if (this->dataPtr->pointsUtil.Resolution() !=
+        this->PointCloudResolution() ||
+        this->dataPtr->pointMsgGpuLayout != this->dataPtr->gpuPointLayout)
     {
-      this->dataPtr->image =
-          rendering::Image(width, height, rendering::PF_R8G8B8);
+      this->dataPtr->InitPointMsg(this->OpticalFrameId(),
+          this->PointCloudResolution());
     }
 
-    // extract image data from point cloud data
-    this->dataPtr->pointsUtil.XYZFromPointCloud(
-        this->dataPtr->xyzBuffer,
-        this->dataPtr->pointCloudBuffer,
-        width, height);
+    // Set the time stamp
+    *this->dataPtr->pointMsg.mutable_header()->mutable_stamp() =
+      msgs::Convert(frameTime);
+    this->dataPtr->pointMsg.set_is_dense(true);
 
-    // convert depth to grayscale rgb image
-    this->dataPtr->ConvertDepthToImage(this->dataPtr->depthBuffer,
-        this->dataPtr->image.Data<unsigned char>(), width, height);
+    if (this->dataPtr->pointMsgGpuLayout)
+    {
+      // The buffer is the message data, no conversion
+      GZ_PROFILE("DepthCameraSensor::Update Copy point cloud");
+      {
+        TraceScope trace("fill", *this);
+        std::string *data = this->dataPtr->pointMsg.mutable_data();
+        data->resize(static_cast<std::size_t>(width) * height * 16u);
+        std::memcpy(data->data(), this->dataPtr->pointCloudFrame,
+            data->size());
+      }
+      this->dataPtr->PublishPointMsg(*this);
+      return true;
+    }
 
-    // fill the point cloud msg with data from xyz and rgb buffer
-    this->dataPtr->pointsUtil.FillMsg(this->dataPtr->pointMsg,
-        this->dataPtr->xyzBuffer,
-        this->dataPtr->image.Data<unsigned char>());
+    {
+      TraceScope trace("fill", *this);
+      this->dataPtr->xyzBuffer.Resize(
+          static_cast<std::size_t>(width) * height * 3u);
+
+      if (this->dataPtr->image.Width() != width
+          || this->dataPtr->image.Height() != height)
+      {
+        this->dataPtr->image =
+            rendering::Image(width, height, rendering::PF_R8G8B8);
+      }
+
+      // extract image data from point cloud data
+      this->dataPtr->pointsUtil.XYZFromPointCloud(
+          this->dataPtr->xyzBuffer.Data(),
+          this->dataPtr->pointCloudFrame, width, height);
+
+      // convert depth to grayscale rgb image
+      this->dataPtr->pointsUtil.SetThreadCount(
+          this->PointCloudThreadCount());
+      this->dataPtr->ConvertDepthToImage(this->dataPtr->depthFrame,
+          this->dataPtr->image.Data<unsigned char>(), width, height);
+
+      // fill the point cloud msg with data from xyz and rgb buffer
+      this->dataPtr->pointsUtil.FillMsg(this->dataPtr->pointMsg,
+          this->dataPtr->xyzBuffer.Data(),
+          this->dataPtr->image.Data<unsigned char>());
+    }
 
-    this->AddSequence(this->dataPtr->pointMsg.mutable_header(), "pointMsg");
-    this->dataPtr->pointPub.Publish(this->dataPtr->pointMsg);
+    this->dataPtr->PublishPointMsg(*this);
   }
   return true;
 }
@@ -649,10 +933,55 @@ double DepthCameraSensor::NearClip() const
   return this->dataPtr->near;
 }
 
+//////////////////////////////////////////////////
+void DepthCameraSensor::SetFixedImageRange(bool _fixed)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->fixedImageRange = _fixed;
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::FixedImageRange() const
+{
+  return this->dataPtr->fixedImageRange;
+}
+
+//////////////////////////////////////////////////
+void DepthCameraSensor::SetPointCloudGpuLayout(bool _gpuLayout)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->gpuPointLayout = _gpuLayout;
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::PointCloudGpuLayout() const
+{
+  return this->dataPtr->gpuPointLayout;
+}
+
+//////////////////////////////////////////////////
+SensorMemoryUsage DepthCameraSensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage = CameraSensor::MemoryUsage();
+  usage["depth_buffer"] = MemorySize(this->dataPtr->depthBuffer) +
+      MemorySize(this->dataPtr->millimeterBuffer);
+  usage["point_cloud_buffer"] = MemorySize(this->dataPtr->pointCloudBuffer);
+  usage["xyz_buffer"] = MemorySize(this->dataPtr->xyzBuffer);
+  usage["normal_buffer"] = MemorySize(this->dataPtr->normalBuffer);
+  usage["region_buffer"] += MemorySize(this->dataPtr->regionBuffer);
+  usage["image"] += this->dataPtr->image.MemorySize();
+  usage["point_msg"] = MemorySize(this->dataPtr->pointMsg) +
+      MemorySize(this->dataPtr->voxelMsg);
+  usage["elevation_map"] = this->dataPtr->elevationMap ?
+      this->dataPtr->elevationMap->MemorySize() : 0u;
+  return usage;
+}
+
 //////////////////////////////////////////////////
 bool DepthCameraSensor::HasConnections() const
 {
   return this->HasDepthConnections() || this->HasPointConnections() ||
+      this->HasNormalConnections() || this->HasElevationMapConnections() ||
       this->HasInfoConnections();
 }
 
@@ -660,11 +989,175 @@ bool DepthCameraSensor::HasConnections() const
 bool DepthCameraSensor::HasDepthConnections() const
 {
   return (this->dataPtr->pub && this->dataPtr->pub.HasConnections())
-         || this->dataPtr->imageEvent.ConnectionCount() > 0u;
+         || this->dataPtr->imageEvent.ConnectionCount() > 0u
+         || this->HasSharedMemoryConnections()
+         || this->Recording();
 }
 
 //////////////////////////////////////////////////
 bool DepthCameraSensor::HasPointConnections() const
 {
-  return this->dataPtr->pointPub && this->dataPtr->pointPub.HasConnections();
+  return (this->dataPtr->pointPub && this->dataPtr->pointPub.HasConnections())
+      || this->HasCompressedPointConnections();
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::HasNormalConnections() const
+{
+  return this->dataPtr->normalPub && this->dataPtr->normalPub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::SetCompressedPointsOutput(bool _enabled,
+    double _resolution)
+{
+  if (!_enabled)
+  {
+    this->dataPtr->pointCompressor.reset();
+    this->dataPtr->compressedPointPub = transport::Node::Publisher();
+    return true;
+  }
+
+  if (this->Topic().empty())
+  {
+    gzerr << "Compressed point clouds require the sensor to be loaded.\n";
+    return false;
+  }
+
+  if (!(_resolution > 0.0))
+  {
+    gzerr << "Invalid point cloud compression resolution [" << _resolution
+          << "], it must be positive.\n";
+    return false;
+  }
+
+  // A new resolution replaces the compressor
+  if (this->dataPtr->pointCompressor &&
+      this->dataPtr->pointCompressor->Resolution() == _resolution)
+  {
+    return true;
+  }
+  this->dataPtr->pointCompressor.reset();
+
+  const std::string topic = this->Topic() + "/points/compressed";
+  if (!this->dataPtr->compressedPointPub)
+  {
+    this->dataPtr->compressedPointPub =
+        this->dataPtr->node.Advertise<msgs::PointCloudPacked>(topic);
+  }
+  if (!this->dataPtr->compressedPointPub)
+  {
+    gzerr << "Unable to create publisher on topic [" << topic << "].\n";
+    return false;
+  }
+  this->dataPtr->pointCompressor = std::make_unique<PointCloudCompressor>(
+      this->dataPtr->compressedPointPub, _resolution);
+
+  gzdbg << "Compressed points for [" << this->Name() << "] advertised on ["
+        << topic << "]" << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::CompressedPointsOutput() const
+{
+  return this->dataPtr->pointCompressor != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::HasCompressedPointConnections() const
+{
+  return this->dataPtr->pointCompressor &&
+         this->dataPtr->compressedPointPub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::SetElevationMapOutput(bool _enabled,
+    double _resolution, unsigned int _size, double _rate)
+{
+  if (!_enabled)
+  {
+    this->dataPtr->elevationMap.reset();
+    this->dataPtr->elevationMapPub = transport::Node::Publisher();
+    return true;
+  }
+
+  if (this->Topic().empty())
+  {
+    gzerr << "Elevation maps require the sensor to be loaded.\n";
+    return false;
+  }
+
+  if (!(_resolution > 0.0) || _size == 0u || !(_rate >= 0.0))
+  {
+    gzerr << "Invalid elevation map resolution [" << _resolution
+          << "], size [" << _size << "] or rate [" << _rate
+          << "]. The resolution and size must be positive, the rate can't "
+          << "be negative.\n";
+    return false;
+  }
+
+  const std::string topic = this->Topic() + "/elevation_map";
+  if (!this->dataPtr->elevationMapPub)
+  {
+    this->dataPtr->elevationMapPub =
+        this->dataPtr->node.Advertise<msgs::Image>(topic);
+  }
+  if (!this->dataPtr->elevationMapPub)
+  {
+    gzerr << "Unable to create publisher on topic [" << topic << "].\n";
+    return false;
+  }
+
+  // A new grid starts empty, the same one keeps its cells
+  if (!this->dataPtr->elevationMap ||
+      this->dataPtr->elevationMap->Resolution() != _resolution ||
+      this->dataPtr->elevationMap->Size() != _size)
+  {
+    this->dataPtr->elevationMap =
+        std::make_unique<ElevationMap>(_resolution, _size);
+  }
+  this->dataPtr->elevationMapPeriod = _rate > 0.0 ?
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / _rate)) :
+      std::chrono::steady_clock::duration::zero();
+  this->dataPtr->elevationMapPublished = false;
+
+  gzdbg << "Elevation map for [" << this->Name() << "] advertised on ["
+        << topic << "]" << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::ElevationMapOutput() const
+{
+  return this->dataPtr->elevationMap != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool DepthCameraSensor::HasElevationMapConnections() const
+{
+  return this->dataPtr->elevationMap &&
+         this->dataPtr->elevationMapPub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+void DepthCameraSensorPrivate::PublishElevationMap(
+    DepthCameraSensor &_sensor,
+    const std::chrono::steady_clock::duration &_now)
+{
+  // Time going back, after a reset, publishes right away
+  if (this->elevationMapPublished && _now >= this->elevationMapTime &&
+      _now - this->elevationMapTime < this->elevationMapPeriod)
+  {
+    return;
+  }
+
+  GZ_PROFILE("DepthCameraSensor::Update Publish elevation map");
+  msgs::Image msg;
+  _sensor.FillHeader(msg.mutable_header(), _now, "world", "elevation_map");
+  this->elevationMap->FillMsg(msg);
+  _sensor.Publish(this->elevationMapPub, std::move(msg));
+  this->elevationMapTime = _now;
+  this->elevationMapPublished = true;
 }
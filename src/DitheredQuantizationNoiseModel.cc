@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include <gz/common/Console.hh>
+
+#include "gz/sensors/DitheredQuantizationNoiseModel.hh"
+#include "gz/sensors/SensorState.hh"
+
+#include "PhiloxRandom.hh"
+
+using namespace gz;
+using namespace sensors;
+
+class gz::sensors::DitheredQuantizationNoiseModelPrivate
+{
+  /// \brief Mean of the Gaussian noise.
+  public: double mean = 0.0;
+
+  /// \brief Standard deviation of the Gaussian noise.
+  public: double stdDev = 0.0;
+
+  /// \brief Width of a quantization bin. The output isn't quantized if
+  /// this isn't positive.
+  public: double precision = 0.0;
+
+  /// \brief Random stream of this model.
+  public: PhiloxRandom rng{PhiloxRandom::DefaultSeed()};
+
+  /// \brief Apply noise to a single value.
+  /// \param[in] _in Input value.
+  /// \return Noisy value.
+  public: double Apply(double _in)
+  {
+    double out = _in + (this->stdDev > 0.0 ?
+        this->rng.Normal(this->mean, this->stdDev) : this->mean);
+    if (this->precision > 0.0)
+    {
+      // Triangular dither spanning one bin on each side
+      const double dither = this->rng.Uniform() - this->rng.Uniform();
+      out = std::round(out / this->precision + dither) * this->precision;
+    }
+    return out;
+  }
+
+  /// \brief Apply noise to a strided buffer and clamp the finite results.
+  /// \param[in,out] _data First value.
+  /// \param[in] _count Number of values.
+  /// \param[in] _stride Distance between consecutive values.
+  /// \param[in] _min Lower clamping bound.
+  /// \param[in] _max Upper clamping bound.
+  public: template <typename T>
+          void ApplyBatch(T *_data, std::size_t _count, std::size_t _stride,
+              double _min, double _max)
+  {
+    for (std::size_t i = 0u; i < _count; ++i)
+    {
+      double out = this->Apply(static_cast<double>(_data[i * _stride]));
+      if (std::isfinite(out))
+        out = std::min(std::max(out, _min), _max);
+      _data[i * _stride] = static_cast<T>(out);
+    }
+  }
+};
+
+//////////////////////////////////////////////////
+DitheredQuantizationNoiseModel::DitheredQuantizationNoiseModel()
+  : Noise(NoiseType::DITHERED_QUANTIZATION),
+    dataPtr(std::make_unique<DitheredQuantizationNoiseModelPrivate>())
+{
+}
+
+//////////////////////////////////////////////////
+DitheredQuantizationNoiseModel::~DitheredQuantizationNoiseModel() = default;
+
+//////////////////////////////////////////////////
+void DitheredQuantizationNoiseModel::Load(const sdf::Noise &_sdf)
+{
+  Noise::Load(_sdf);
+  this->dataPtr->mean = _sdf.Mean();
+  this->dataPtr->stdDev = _sdf.StdDev();
+  this->dataPtr->precision = _sdf.Precision();
+  if (this->dataPtr->precision <= 0.0)
+  {
+    gzerr << "Dithered quantization noise requires a positive precision, "
+          << "the output won't be quantized." << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+double DitheredQuantizationNoiseModel::ApplyImpl(double _in,
+    double /*_dt*/)
+{
+  return this->dataPtr->Apply(_in);
+}
+
+//////////////////////////////////////////////////
+void DitheredQuantizationNoiseModel::ApplyBatchImpl(double *_data,
+    std::size_t _count, std::size_t _stride, double /*_dt*/, double _min,
+    double _max)
+{
+  this->dataPtr->ApplyBatch(_data, _count, _stride, _min, _max);
+}
+
+//////////////////////////////////////////////////
+void DitheredQuantizationNoiseModel::ApplyBatchImpl(float *_data,
+    std::size_t _count, std::size_t _stride, double /*_dt*/, double _min,
+    double _max)
+{
+  this->dataPtr->ApplyBatch(_data, _count, _stride, _min, _max);
+}
+
+//////////////////////////////////////////////////
+void DitheredQuantizationNoiseModel::SetSeed(uint64_t _seed)
+{
+  this->dataPtr->rng = PhiloxRandom(_seed);
+}
+
+//////////////////////////////////////////////////
+void DitheredQuantizationNoiseModel::SaveState(SensorState &_state) const
+{
+  _state.Write(this->dataPtr->rng);
+}
+
+//////////////////////////////////////////////////
+bool DitheredQuantizationNoiseModel::RestoreState(SensorState &_state)
+{
+  return _state.Read(this->dataPtr->rng);
+}
+
+//////////////////////////////////////////////////
+void DitheredQuantizationNoiseModel::Print(std::ostream &_out) const
+{
+  _out << "Dithered quantization noise, mean[" << this->dataPtr->mean
+    << "], stdDev[" << this->dataPtr->stdDev << "] "
+    << "precision[" << this->dataPtr->precision << "]";
+}
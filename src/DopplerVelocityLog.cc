@@ -15,8 +15,16 @@
  *
 */
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 // TODO(hidmic): implement SVD in gazebo?
@@ -31,8 +39,7 @@
 #include <gz/math/Vector2.hh>
 #include <gz/math/Vector3.hh>
 
-#include <gz/math/TimeVaryingVolumetricGrid.hh>
-
+#include <gz/msgs/boolean.pb.h>
 #include <gz/msgs/dvl_beam_state.pb.h>
 #include <gz/msgs/dvl_kinematic_estimate.pb.h>
 #include <gz/msgs/dvl_range_estimate.pb.h>
@@ -47,15 +54,19 @@
 #include <gz/rendering/RayQuery.hh>
 
 #include <gz/sensors/DopplerVelocityLog.hh>
+#include <gz/sensors/EnvironmentalDataSampler.hh>
 #include <gz/sensors/GaussianNoiseModel.hh>
 #include <gz/sensors/Manager.hh>
 #include <gz/sensors/Noise.hh>
-#include <gz/sensors/RenderingEvents.hh>
 #include <gz/sensors/RenderingSensor.hh>
 #include <gz/sensors/SensorTypes.hh>
 
 #include <gz/transport/Node.hh>
 
+#include "ArenaMessage.hh"
+#include "RowWorkers.hh"
+#include "SharedTableCache.hh"
+
 namespace gz
 {
   namespace sensors
@@ -312,109 +323,6 @@ namespace gz
 
         private: Value value;
       };
-
-      /// \brief A time-varying vector field built on
-      /// per-axis time-varying volumetric data grids
-      ///
-      /// \see gz::math::InMemoryTimeVaryingVolumetricGrid
-      template <typename T, typename V = T, typename P = T>
-      class InMemoryTimeVaryingVectorField
-      {
-        public: using SessionT = gz::math::InMemorySession<T, P>;
-
-        public: using GridT =
-          gz::math::InMemoryTimeVaryingVolumetricGrid<T, V, P>;
-
-        /// \brief Default constructor.
-        public: InMemoryTimeVaryingVectorField() = default;
-
-        /// \brief Constructor
-        /// \param[in] _xData X-axis volumetric data grid.
-        /// \param[in] _yData Y-axis volumetric data grid.
-        /// \param[in] _zData Z-axis volumetric data grid.
-        public: explicit InMemoryTimeVaryingVectorField(
-            const GridT *_xData, const GridT *_yData, const GridT *_zData)
-          : xData(_xData), yData(_yData), zData(_zData)
-        {
-          if (this->xData)
-          {
-            this->xSession = this->xData->CreateSession();
-          }
-          if (this->yData)
-          {
-            this->ySession = this->yData->CreateSession();
-          }
-          if (this->zData)
-          {
-            this->zSession = this->zData->CreateSession();
-          }
-        }
-
-        /// \brief Advance vector field in time.
-        /// \param[in] _now Time to step data grids to.
-        public: void StepTo(const std::chrono::steady_clock::duration &_now)
-        {
-          const T now = std::chrono::duration<T>(_now).count();
-          if (this->xData && this->xSession)
-          {
-            this->xSession = this->xData->StepTo(this->xSession.value(), now);
-          }
-          if (this->yData && this->ySession)
-          {
-            this->ySession = this->yData->StepTo(this->ySession.value(), now);
-          }
-          if (this->zData && this->zSession)
-          {
-            this->zSession = this->zData->StepTo(this->zSession.value(), now);
-          }
-        }
-
-        /// \brief Look up vector field value, interpolating data grids.
-        /// \param[in] _pos Vector field argument.
-        /// \return vector field value at `_pos`
-        public: gz::math::Vector3<V> LookUp(const gz::math::Vector3<P> &_pos)
-        {
-          auto outcome = gz::math::Vector3<V>::Zero;
-          if (this->xData && this->xSession)
-          {
-            const auto interpolation =
-                this->xData->LookUp(this->xSession.value(), _pos);
-            outcome.X(interpolation.value_or(0.));
-          }
-          if (this->yData && this->ySession)
-          {
-            const auto interpolation =
-                this->yData->LookUp(this->ySession.value(), _pos);
-            outcome.Y(interpolation.value_or(0.));
-          }
-          if (this->zData && this->zSession)
-          {
-            const auto interpolation =
-                this->zData->LookUp(this->ySession.value(), _pos);
-            outcome.Z(interpolation.value_or(0.));
-          }
-          return outcome;
-        }
-
-        /// \brief Session for x-axis volumetric data grid, if any.
-        private: std::optional<SessionT> xSession{std::nullopt};
-
-        /// \brief Session for y-axis volumetric data grid, if any.
-        private: std::optional<SessionT> ySession{std::nullopt};
-
-        /// \brief Session for z-axis volumetric data grid, if any.
-        private: std::optional<SessionT> zSession{std::nullopt};
-
-        /// \brief X-axis volumetric data grid, if any.
-        private: const GridT * xData{nullptr};
-
-        /// \brief Y-axis volumetric data grid, if any.
-        private: const GridT * yData{nullptr};
-
-        /// \brief Z-axis volumetric data grid, if any.
-        private: const GridT * zData{nullptr};
-      };
-
     }
 
     using namespace gz::msgs;
@@ -468,10 +376,14 @@ namespace gz
       /// \param[in] _now Current simulation time.
       /// \param[out] _info Optional tracking mode info,
       /// useful for performance comparison.
-      /// \return velocity tracking result.
-      public: DVLVelocityTracking TrackBottom(
+      /// \param[out] _message Velocity tracking result. It must be empty.
+      public: void TrackBottom(
           const std::chrono::steady_clock::duration &_now,
-          TrackingModeInfo *_info);
+          TrackingModeInfo *_info, DVLVelocityTracking *_message);
+
+      /// \brief Bottom tracking message, reused across updates
+      /// when there is no message arena.
+      public: DVLVelocityTracking bottomModeMessage;
 
       /// \brief Whether water-mass tracking mode is enabled
       /// and which variant if it is.
@@ -481,10 +393,10 @@ namespace gz
       /// \param[in] _now Current simulation time.
       /// \param[out] _info Optional tracking mode info,
       /// useful for performance comparison.
-      /// \return velocity tracking result.
-      public: DVLVelocityTracking TrackWaterMass(
+      /// \param[out] _message Velocity tracking result. It must be empty.
+      public: void TrackWaterMass(
           const std::chrono::steady_clock::duration &_now,
-          TrackingModeInfo *_info);
+          TrackingModeInfo *_info, DVLVelocityTracking *_message);
 
       /// \brief Number of bins for water-mass sampling.
       public: int waterMassModeNumBins;
@@ -506,12 +418,68 @@ namespace gz
       public:
       std::shared_ptr<gz::sensors::GaussianNoiseModel> waterMassModeNoise;
 
+      /// \brief Water-mass tracking message, reused across updates
+      /// when there is no message arena.
+      public: DVLVelocityTracking waterMassModeMessage;
+
       /// \brief State of the world.
       public: const WorldState *worldState;
 
-      /// \brief Water velocity vector field for water-mass sampling.
-      public:
-      std::optional<InMemoryTimeVaryingVectorField<double>> waterVelocity;
+      /// \brief Environmental data to sample water velocity from, if any.
+      /// It must outlive the sensor, as samplers refer to its grids.
+      public: const EnvironmentalData *waterVelocityData{nullptr};
+
+      /// \brief Water-mass sampling state of a beam, so beams can be
+      /// sampled concurrently.
+      public: struct WaterMassBeamSample
+      {
+        /// \brief Water velocity sampler, with a column per velocity
+        /// component. Null until first used.
+        std::optional<EnvironmentalDataSampler> sampler;
+
+        /// \brief Sample points, in the environmental data frame.
+        std::vector<gz::math::Vector3d> points;
+
+        /// \brief Water velocity components sampled at each point.
+        std::array<std::vector<std::optional<double>>, 3> velocity;
+
+        /// \brief Beam axis in the world frame.
+        gz::math::Vector3d axisInWorldFrame;
+
+        /// \brief Sensor velocity projected onto the beam axis.
+        double sensorBeamSpeed{0.};
+
+        /// \brief Whether the bottom is too close to sample the beam.
+        bool discarded{false};
+      };
+
+      /// \brief Water-mass sampling state of each beam, reused across
+      /// updates.
+      public: std::vector<WaterMassBeamSample> waterMassBeamSamples;
+
+      /// \brief Noiseless bottom-tracking measurement of a beam.
+      public: struct BottomBeamSample
+      {
+        /// \brief Beam axis in the sensor frame.
+        gz::math::Vector3d axisInSensorFrame;
+
+        /// \brief DVL speed w.r.t. the target along the beam axis.
+        double speed{0.};
+      };
+
+      /// \brief Bottom-tracking measurement of each beam, reused across
+      /// updates.
+      public: std::vector<BottomBeamSample> bottomBeamSamples;
+
+      /// \brief Run a function on every beam, split between the worker
+      /// threads, if any, and the calling thread. Beams must be processed
+      /// independently of each other.
+      /// \param[in] _fn Function to run on a beam index.
+      public: void ForEachBeam(const std::function<void(size_t)> &_fn);
+
+      /// \brief Threads that process beams along with the updating thread,
+      /// null to process them on the updating thread only.
+      public: std::unique_ptr<RowWorkers> workers;
 
       /// \brief Water velocity data shape, as dimension names,
       /// for environmental data indexing.
@@ -524,29 +492,59 @@ namespace gz
       /// \brief Whether water velocity was updated since last use.
       public: bool waterVelocityUpdated{true};
 
-      /// \brief Depth sensor (i.e. a GPU raytracing sensor).
-      public: gz::rendering::GpuRaysPtr depthSensor;
+      /// \brief Depth sensors (i.e. GPU raytracing sensors), either one
+      /// spanning all beams or one per beam.
+      public: std::vector<gz::rendering::GpuRaysPtr> depthSensors;
 
       /// \brief Image sensor (i.e. a camera sensor) to aid ray querys.
       public: gz::rendering::CameraPtr imageSensor;
 
-      /// \brief Depth sensor intrinsic constants
-      public: struct {
-        gz::math::Vector2d offset;  ///<! Azimuth and elevation offsets
-        gz::math::Vector2d step;  ///<! Azimuth and elevation steps
-      } depthSensorIntrinsics;
+      /// \brief Field of view and intrinsic constants of a depth sensor.
+      public: struct BeamView
+      {
+        /// \brief Spherical footprint in the view frame.
+        AxisAlignedPatch2d footprint;
+
+        /// \brief Azimuth and elevation offsets.
+        gz::math::Vector2d offset;
+
+        /// \brief Azimuth and elevation steps.
+        gz::math::Vector2d step;
+
+        /// \brief Scan width, i.e. horizontal ray count.
+        unsigned int width{0u};
+
+        /// \brief Scan height, i.e. vertical ray count.
+        unsigned int height{0u};
+
+        /// \brief Rotation from the view frame to the acoustic beams'
+        /// frame.
+        gz::math::Quaterniond rotation{gz::math::Quaterniond::Identity};
+      };
+
+      /// \brief Views of the depth sensors, in the same order.
+      public: std::vector<BeamView> beamViews;
+
+      /// \brief Whether each beam is rendered by its own depth sensor,
+      /// only as wide as its aperture.
+      public: bool perBeamRendering{false};
 
       /// \brief Callback for rendering sensor frames
+      /// \param[in] _view Index of the depth sensor the scan comes from.
       public: void OnNewFrame(
-          const float *_scan, unsigned int _width,
+          size_t _view, const float *_scan, unsigned int _width,
           unsigned int _height, unsigned int _channels,
           const std::string & /*_format*/);
 
-      /// \brief Connection from depth camera with new depth data.
-      public: gz::common::ConnectionPtr depthConnection;
+      /// \brief Update a beam's target from a depth scan
+      /// \param[in] _beam Index of the beam.
+      /// \param[in] _scan Depth scan of the beam's view.
+      /// \param[in] _channels Channels per scan pixel.
+      public: void UpdateBeamTarget(
+          size_t _beam, const float *_scan, unsigned int _channels);
 
-      /// \brief Connection to the Manager's scene change event.
-      public: gz::common::ConnectionPtr sceneChangeConnection;
+      /// \brief Connections from depth sensors with new depth data.
+      public: std::vector<gz::common::ConnectionPtr> depthConnections;
 
       /// \brief DVL acoustic beams' description
       public: std::vector<AcousticBeam> beams;
@@ -567,8 +565,26 @@ namespace gz
       /// \brief DVL acoustic beams' targets
       public: std::vector<std::optional<TrackingTarget>> beamTargets;
 
-      /// \brief DVL acoustic beams' patches in depth scan frame.
-      public: std::vector<AxisAlignedPatch2i> beamScanPatches;
+      /// \brief Depth scan pixels that lie within an acoustic beam's
+      /// aperture, computed once from the depth sensor intrinsics.
+      public: struct BeamScanMask
+      {
+        /// \brief Pixel indices in the depth scan, row major.
+        std::vector<unsigned int> indices;
+
+        /// \brief Unit direction of each pixel in the acoustic beams'
+        /// frame, in the same order as indices.
+        std::vector<gz::math::Vector3d> directions;
+      };
+
+      /// \brief DVL acoustic beams' masks in depth scan frame. Shared by
+      /// the DVLs with the same beams and depth sensor intrinsics.
+      public: std::shared_ptr<const std::vector<BeamScanMask>>
+                  beamScanMasks;
+
+      /// \brief Beam masks shared by all DVLs.
+      public: static SharedTableCache<std::vector<BeamScanMask>>
+                  beamScanMaskCache;
 
       /// \brief Node to create a topic publisher with.
       public: gz::transport::Node node;
@@ -579,11 +595,29 @@ namespace gz
       /// \brief Flag to indicate if sensor should be publishing estimates.
       public: bool publishingEstimates = false;
 
+      /// \brief Beam markers of a tracking mode, with their geometry
+      /// built once.
+      public: struct BeamMarkers
+      {
+        /// \brief Beam lobe markers, with their geometry.
+        gz::msgs::Marker_V markers;
+
+        /// \brief Marker updates to send, reused across updates.
+        gz::msgs::Marker_V updates;
+
+        /// \brief Time until which each marker is known to be shown
+        /// remotely, so that its updates can leave its geometry out.
+        std::vector<std::chrono::steady_clock::duration> shownUntil;
+
+        /// \brief Time an update keeps a marker known to be shown.
+        std::chrono::steady_clock::duration holdTime;
+      };
+
       /// \brief Setup beam markers for a generic tracking mode.
       /// \param[in] _sensor (Outer) DVL sensor holding beam arrangement.
       /// \param[in] _namespace Namespace to tell markers apart.
       /// \return tracking mode beam markers
-      public: gz::msgs::Marker_V SetupBeamMarkers(
+      public: BeamMarkers SetupBeamMarkers(
           DopplerVelocityLog *_sensor,
           const std::string &_namespace);
 
@@ -591,29 +625,35 @@ namespace gz
       /// both locally and remotely (by publishing).
       ///
       /// Beam markers are assumed to have been setup
-      /// by calling `SetupBeamMarkers()`.
+      /// by calling `SetupBeamMarkers()`. Markers known to be shown
+      /// remotely are sent without their geometry.
       ///
       /// \param[in] _sensor (Outer) DVL sensor performing the tracking.
+      /// \param[in] _now Current simulation time.
       /// \param[in] _trackingMessage Velocity estimate message.
       /// \param[inout] _beamMarkers Beam markers to update.
       public: void UpdateBeamMarkers(
           DopplerVelocityLog *_sensor,
+          const std::chrono::steady_clock::duration &_now,
           const DVLVelocityTracking &_trackingMessage,
-          gz::msgs::Marker_V *_beamMarkers);
+          BeamMarkers *_beamMarkers);
 
       /// \brief Bottom tracking mode beam lobe markers.
-      public: gz::msgs::Marker_V bottomModeBeamMarkers;
+      public: BeamMarkers bottomModeBeamMarkers;
 
       /// \brief Whether to display bottom tracking mode beams.
       public: bool visualizeBottomModeBeams = false;
 
       /// \brief Water-mass tracking mode beam lobe markers.
-      public: gz::msgs::Marker_V waterMassModeBeamMarkers;
+      public: BeamMarkers waterMassModeBeamMarkers;
 
       /// \brief Whether to display water-mass tracking mode beams.
       public: bool visualizeWaterMassModeBeams = false;
     };
 
+    SharedTableCache<std::vector<DopplerVelocityLog::Implementation::
+        BeamScanMask>> DopplerVelocityLog::Implementation::beamScanMaskCache;
+
     //////////////////////////////////////////////////
     DopplerVelocityLog::DopplerVelocityLog()
       : dataPtr(new Implementation())
@@ -623,8 +663,7 @@ namespace gz
     //////////////////////////////////////////////////
     DopplerVelocityLog::~DopplerVelocityLog()
     {
-      this->dataPtr->depthConnection.reset();
-      this->dataPtr->sceneChangeConnection.reset();
+      this->dataPtr->depthConnections.clear();
     }
 
     //////////////////////////////////////////////////
@@ -670,9 +709,8 @@ namespace gz
       this->dataPtr->sensorSdf = elem->GetElement("gz:dvl");
 
       // Instantiate interfaces
-      this->dataPtr->pub =
-          this->dataPtr->node.Advertise<DVLVelocityTracking>(this->Topic());
-      if (!this->dataPtr->pub)
+      if (!this->Advertise<DVLVelocityTracking>(this->dataPtr->node,
+          this->dataPtr->pub, this->Topic()))
       {
         gzerr << "Unable to create publisher on topic "
                << "[" << this->Topic() << "] for sensor "
@@ -692,10 +730,6 @@ namespace gz
       }
 
       gzmsg << "Loaded [" << this->Name() << "] DVL sensor." << std::endl;
-      this->dataPtr->sceneChangeConnection =
-          gz::sensors::RenderingEvents::ConnectSceneChangeCallback(
-          std::bind(&DopplerVelocityLog::SetScene,
-                    this, std::placeholders::_1));
 
       return true;
     }
@@ -961,7 +995,7 @@ namespace gz
     }
 
     //////////////////////////////////////////////////
-    gz::msgs::Marker_V
+    DopplerVelocityLog::Implementation::BeamMarkers
     DopplerVelocityLog::Implementation::SetupBeamMarkers(
         DopplerVelocityLog *_sensor, const std::string &_namespace)
     {
@@ -972,7 +1006,17 @@ namespace gz
                   _sensor->UpdateRate() > epsilon ?
                   1. / _sensor->UpdateRate() : 0.001));
 
-      gz::msgs::Marker_V beamMarkers;
+      BeamMarkers result;
+      // A marker is known to be shown for half its lifetime after an
+      // update, to leave time for the update to be processed. Markers
+      // without a lifetime are shown until deleted.
+      result.holdTime =
+          lifetime == std::chrono::steady_clock::duration::zero() ?
+          std::chrono::steady_clock::duration::max() : lifetime / 2;
+      result.shownUntil.assign(
+          3 * this->beams.size(), std::chrono::steady_clock::duration::min());
+
+      gz::msgs::Marker_V &beamMarkers = result.markers;
       for (const AcousticBeam & beam : this->beams)
       {
         const double angularResolution =
@@ -1033,7 +1077,7 @@ namespace gz
             beamCapMarker->add_point(),
             gz::math::Vector3d{1., beam.NormalizedRadius(), 0.});
       }
-      return beamMarkers;
+      return result;
     }
 
     //////////////////////////////////////////////////
@@ -1116,17 +1160,6 @@ namespace gz
       // Add as many (still null) targets as beams
       this->beamTargets.resize(this->beams.size());
 
-      this->depthSensor =
-          _sensor->Scene()->CreateGpuRays(
-              _sensor->Name() + "_depth_sensor");
-      if (!this->depthSensor)
-      {
-        gzerr << "Failed to create depth sensor for "
-               << "for [" << _sensor->Name() << "] sensor."
-               << std::endl;
-        return false;
-      }
-
       // Aggregate all beams' footprint in spherical coordinates into one
       AxisAlignedPatch2d beamsSphericalFootprint;
       for (const auto & beam : this->beams)
@@ -1142,58 +1175,153 @@ namespace gz
             << " m at a 1 m distance for [" << _sensor->Name() << "] sensor."
             << std::endl;
 
-      this->depthSensor->SetAngleMin(beamsSphericalFootprint.XMin());
-      this->depthSensor->SetAngleMax(beamsSphericalFootprint.XMax());
-      auto horizontalRayCount = static_cast<unsigned int>(
-          std::ceil(beamsSphericalFootprint.XSize() /
-                    this->resolution));
-      if (horizontalRayCount % 2 == 0) ++horizontalRayCount;  // ensure odd
-      this->depthSensor->SetRayCount(horizontalRayCount);
-
-      this->depthSensor->SetVerticalAngleMin(
-          beamsSphericalFootprint.YMin());
-      this->depthSensor->SetVerticalAngleMax(
-          beamsSphericalFootprint.YMax());
-      auto verticalRayCount = static_cast<unsigned int>(
-          std::ceil(beamsSphericalFootprint.YSize() /
-                    this->resolution));
-      if (verticalRayCount % 2 == 0) ++verticalRayCount;  // ensure odd
-      this->depthSensor->SetVerticalRayCount(verticalRayCount);
-
-      auto & intrinsics = this->depthSensorIntrinsics;
-      intrinsics.offset.X(beamsSphericalFootprint.XMin());
-      intrinsics.offset.Y(beamsSphericalFootprint.YMin());
-      intrinsics.step.X(
-        beamsSphericalFootprint.XSize() / (horizontalRayCount - 1));
-      intrinsics.step.Y(
-        beamsSphericalFootprint.YSize() / (verticalRayCount - 1));
-
-      // Pre-compute scan indices covered by beam spherical
-      // footprints for speed during scan iteration
-      this->beamScanPatches.clear();
-      for (const auto & beam : this->beams)
-      {
-        this->beamScanPatches.push_back(AxisAlignedPatch2i{
-            (beam.SphericalFootprint() - intrinsics.offset) /
-            intrinsics.step});
-      }
-
       const double minimumRange =
           this->sensorSdf->Get<double>("minimum_range", 0.1).first;
       gzmsg << "Setting minimum range to " << minimumRange
             << " m for [" << _sensor->Name() << "] sensor." << std::endl;
-      this->depthSensor->SetNearClipPlane(minimumRange);
 
       this->maximumRange =
           this->sensorSdf->Get<double>("maximum_range", 100.).first;
       gzmsg << "Setting maximum range to " << this->maximumRange
             << " m for [" << _sensor->Name() << "] sensor." << std::endl;
-      this->depthSensor->SetFarClipPlane(this->maximumRange);
 
-      this->depthSensor->SetVisibilityMask(GZ_VISIBILITY_ALL);
-      this->depthSensor->SetClamp(false);
+      // Either one depth sensor spans all beams, or each beam has a depth
+      // sensor along its axis that only spans its aperture
+      this->beamViews.clear();
+      this->depthSensors.clear();
+      this->perBeamRendering =
+          this->sensorSdf->Get<bool>("per_beam_rendering", false).first;
+      const bool perBeam = this->perBeamRendering;
+      if (perBeam)
+      {
+        for (const auto & beam : this->beams)
+        {
+          const double halfAperture = beam.ApertureAngle().Radian() / 2.;
+          BeamView view;
+          view.footprint = AxisAlignedPatch2d{
+            gz::math::Vector2d{halfAperture, halfAperture},
+            gz::math::Vector2d{-halfAperture, -halfAperture}};
+          view.rotation = beam.Transform().Rot();
+          this->beamViews.push_back(view);
+        }
+      }
+      else
+      {
+        BeamView view;
+        view.footprint = beamsSphericalFootprint;
+        this->beamViews.push_back(view);
+      }
+
+      for (size_t i = 0; i < this->beamViews.size(); ++i)
+      {
+        BeamView & view = this->beamViews[i];
+        const std::string name = perBeam ?
+            _sensor->Name() + "_depth_sensor_" + std::to_string(i) :
+            _sensor->Name() + "_depth_sensor";
+        gz::rendering::GpuRaysPtr depthSensor =
+            _sensor->Scene()->CreateGpuRays(name);
+        if (!depthSensor)
+        {
+          gzerr << "Failed to create depth sensor for "
+                 << "for [" << _sensor->Name() << "] sensor."
+                 << std::endl;
+          return false;
+        }
 
-      _sensor->AddSensor(this->depthSensor);
+        depthSensor->SetAngleMin(view.footprint.XMin());
+        depthSensor->SetAngleMax(view.footprint.XMax());
+        view.width = static_cast<unsigned int>(
+            std::ceil(view.footprint.XSize() / this->resolution));
+        if (view.width % 2 == 0) ++view.width;  // ensure odd
+        depthSensor->SetRayCount(view.width);
+
+        depthSensor->SetVerticalAngleMin(view.footprint.YMin());
+        depthSensor->SetVerticalAngleMax(view.footprint.YMax());
+        view.height = static_cast<unsigned int>(
+            std::ceil(view.footprint.YSize() / this->resolution));
+        if (view.height % 2 == 0) ++view.height;  // ensure odd
+        depthSensor->SetVerticalRayCount(view.height);
+
+        view.offset.X(view.footprint.XMin());
+        view.offset.Y(view.footprint.YMin());
+        view.step.X(view.footprint.XSize() / (view.width - 1));
+        view.step.Y(view.footprint.YSize() / (view.height - 1));
+
+        depthSensor->SetNearClipPlane(minimumRange);
+        depthSensor->SetFarClipPlane(this->maximumRange);
+        depthSensor->SetVisibilityMask(GZ_VISIBILITY_ALL);
+        depthSensor->SetClamp(false);
+
+        _sensor->AddSensor(depthSensor);
+        this->depthSensors.push_back(depthSensor);
+      }
+
+      // Pre-compute scan pixels within each beam's aperture and their
+      // directions, so frames only have to look for the closest one
+      SharedTableKey key;
+      key.Add(perBeam);
+      for (const auto & view : this->beamViews)
+      {
+        key.Add(view.width).Add(view.height)
+            .Add(view.offset.X()).Add(view.offset.Y())
+            .Add(view.step.X()).Add(view.step.Y());
+      }
+      for (const auto & beam : this->beams)
+      {
+        key.Add(beam.Axis().X()).Add(beam.Axis().Y()).Add(beam.Axis().Z())
+            .Add(beam.ApertureAngle().Radian())
+            .Add(beam.SphericalFootprint().XMin())
+            .Add(beam.SphericalFootprint().XMax())
+            .Add(beam.SphericalFootprint().YMin())
+            .Add(beam.SphericalFootprint().YMax());
+      }
+      this->beamScanMasks = beamScanMaskCache.Get(key, [&]()
+      {
+        std::vector<BeamScanMask> masks;
+        for (size_t i = 0; i < this->beams.size(); ++i)
+        {
+          const AcousticBeam & beam = this->beams[i];
+          const BeamView & view = this->beamViews[perBeam ? i : 0u];
+
+          // The beam axis and footprint in the frame of the view
+          const gz::math::Vector3d axis =
+              view.rotation.Inverse() * beam.Axis();
+          const AxisAlignedPatch2d footprint =
+              perBeam ? view.footprint : beam.SphericalFootprint();
+          const AxisAlignedPatch2i beamScanPatch{
+              (footprint - view.offset) / view.step};
+          const int uMin = std::max(beamScanPatch.XMin(), 0);
+          const int uMax = std::min(beamScanPatch.XMax(),
+                                    static_cast<int>(view.width));
+          const int vMin = std::max(beamScanPatch.YMin(), 0);
+          const int vMax = std::min(beamScanPatch.YMax(),
+                                    static_cast<int>(view.height));
+
+          BeamScanMask mask;
+          for (int v = vMin; v < vMax; ++v)
+          {
+            const double inclination = v * view.step.Y() + view.offset.Y();
+            for (int u = uMin; u < uMax; ++u)
+            {
+              const double azimuth = u * view.step.X() + view.offset.X();
+              const gz::math::Vector3d direction{
+                std::cos(inclination) * std::cos(azimuth),
+                std::cos(inclination) * std::sin(azimuth),
+                std::sin(inclination)
+              };
+              const gz::math::Angle angle = std::acos(
+                  direction.Normalized().Dot(axis));
+              if (angle < beam.ApertureAngle() / 2.)
+              {
+                mask.indices.push_back(u + v * view.width);
+                mask.directions.push_back(view.rotation * direction);
+              }
+            }
+          }
+          masks.push_back(std::move(mask));
+        }
+        return masks;
+      });
 
       this->imageSensor =
           _sensor->Scene()->CreateCamera(
@@ -1220,12 +1348,16 @@ namespace gz
 
       _sensor->AddSensor(this->imageSensor);
 
-      this->depthConnection =
-          this->depthSensor->ConnectNewGpuRaysFrame(
-              std::bind(&DopplerVelocityLog::Implementation::OnNewFrame, this,
-                        std::placeholders::_1, std::placeholders::_2,
-                        std::placeholders::_3, std::placeholders::_4,
-                        std::placeholders::_5));
+      this->depthConnections.clear();
+      for (size_t i = 0; i < this->depthSensors.size(); ++i)
+      {
+        this->depthConnections.push_back(
+            this->depthSensors[i]->ConnectNewGpuRaysFrame(
+                std::bind(&DopplerVelocityLog::Implementation::OnNewFrame,
+                          this, i, std::placeholders::_1,
+                          std::placeholders::_2, std::placeholders::_3,
+                          std::placeholders::_4, std::placeholders::_5)));
+      }
 
       return true;
     }
@@ -1234,77 +1366,93 @@ namespace gz
     std::vector<gz::rendering::SensorPtr>
     DopplerVelocityLog::RenderingSensors() const
     {
-      return {this->dataPtr->depthSensor, this->dataPtr->imageSensor};
+      std::vector<gz::rendering::SensorPtr> sensors(
+          this->dataPtr->depthSensors.begin(),
+          this->dataPtr->depthSensors.end());
+      sensors.push_back(this->dataPtr->imageSensor);
+      return sensors;
     }
 
     //////////////////////////////////////////////////
     void DopplerVelocityLog::Implementation::OnNewFrame(
-        const float *_scan, unsigned int _width,
-        unsigned int _height, unsigned int _channels,
+        size_t _view, const float *_scan,
+        [[maybe_unused]] unsigned int _width,
+        [[maybe_unused]] unsigned int _height, unsigned int _channels,
         const std::string & /*_format*/)
     {
-      const auto & intrinsics = this->depthSensorIntrinsics;
+      assert(_view < this->beamViews.size());
+      assert(_width == this->beamViews[_view].width);
+      assert(_height == this->beamViews[_view].height);
 
-      for (size_t i = 0; i < this->beams.size(); ++i)
+      if (this->perBeamRendering)
       {
-        const AxisAlignedPatch2i & beamScanPatch =
-            this->beamScanPatches[i];
-        const AcousticBeam & beam = this->beams[i];
+        this->UpdateBeamTarget(_view, _scan, _channels);
+        return;
+      }
 
-        // Clear existing target, if any
-        std::optional<TrackingTarget> & beamTarget = this->beamTargets[i];
-        beamTarget.reset();
+      this->ForEachBeam([&](size_t _beam)
+      {
+        this->UpdateBeamTarget(_beam, _scan, _channels);
+      });
+    }
 
-        // Iterate over the beam solid angle in camera coordinates
-        for (auto v = beamScanPatch.YMin(); v < beamScanPatch.YMax(); ++v)
+    //////////////////////////////////////////////////
+    void DopplerVelocityLog::Implementation::ForEachBeam(
+        const std::function<void(size_t)> &_fn)
+    {
+      if (!this->workers || this->beams.size() < 2u)
+      {
+        for (size_t i = 0; i < this->beams.size(); ++i)
         {
-          assert(v >= 0 && v < static_cast<int>(_height));
-          const gz::math::Angle inclination =
-              v * intrinsics.step.Y() + intrinsics.offset.Y();
+          _fn(i);
+        }
+        return;
+      }
 
-          for (auto u = beamScanPatch.XMin(); u < beamScanPatch.XMax(); ++u)
+      this->workers->Run(static_cast<uint32_t>(this->beams.size()),
+          [&](uint32_t _begin, uint32_t _end)
           {
-            assert(u >= 0 && u < static_cast<int>(_width));
-
-            const float range = _scan[(u + v * _width) * _channels];
-            if (!std::isfinite(range)) continue;
-
-            const gz::math::Angle azimuth =
-                u * intrinsics.step.X() + intrinsics.offset.X();
-
-            // Convert to cartesian coordinates in the acoustic beams' frame
-            const auto point = range * gz::math::Vector3d{
-              std::cos(inclination.Radian()) * std::cos(azimuth.Radian()),
-              std::cos(inclination.Radian()) * std::sin(azimuth.Radian()),
-              std::sin(inclination.Radian())
-            };
-
-            // Track point if (a) it effectively lies within the
-            // beam's aperture and (b) it is the closest seen so far
-            const gz::math::Angle angle = std::acos(
-                point.Normalized().Dot(beam.Axis()));
-            if (angle < beam.ApertureAngle() / 2.)
+            for (uint32_t i = _begin; i < _end; ++i)
             {
-              if (beamTarget)
-              {
-                if (beamTarget->pose.Pos().Length() > point.Length())
-                {
-                  beamTarget->pose.Pos() = point;
-                }
-              }
-              else
-              {
-                beamTarget = {
-                  gz::math::Pose3d{
-                    point,
-                    gz::math::Quaterniond::Identity},
-                  0
-                };
-              }
+              _fn(i);
             }
-          }
+          });
+    }
+
+    //////////////////////////////////////////////////
+    void DopplerVelocityLog::Implementation::UpdateBeamTarget(
+        size_t _beam, const float *_scan, unsigned int _channels)
+    {
+      const BeamScanMask & mask = (*this->beamScanMasks)[_beam];
+
+      // Clear existing target, if any
+      std::optional<TrackingTarget> & beamTarget = this->beamTargets[_beam];
+      beamTarget.reset();
+
+      // Look for the closest point within the beam's aperture,
+      // non-finite ranges never compare less
+      float closestRange = std::numeric_limits<float>::infinity();
+      size_t closest = mask.indices.size();
+      for (size_t k = 0; k < mask.indices.size(); ++k)
+      {
+        const float range = _scan[mask.indices[k] * _channels];
+        if (range < closestRange)
+        {
+          closestRange = range;
+          closest = k;
         }
       }
+
+      if (closest < mask.indices.size())
+      {
+        // Convert to cartesian coordinates in the acoustic beams' frame
+        beamTarget = {
+          gz::math::Pose3d{
+            closestRange * mask.directions[closest],
+            gz::math::Quaterniond::Identity},
+          0
+        };
+      }
     }
 
     /////////////////////////////////////////////////
@@ -1314,7 +1462,8 @@ namespace gz
       if (this->Scene() != _scene)
       {
         // TODO(anyone) Remove camera from scene
-        this->dataPtr->depthSensor = nullptr;
+        this->dataPtr->depthConnections.clear();
+        this->dataPtr->depthSensors.clear();
         this->dataPtr->imageSensor = nullptr;
         RenderingSensor::SetScene(_scene);
         if (!this->dataPtr->initialized)
@@ -1345,44 +1494,18 @@ namespace gz
               << "[" << this->Name() << "] sensor."
               << std::endl;
 
-        using VectorFieldT = InMemoryTimeVaryingVectorField<double>;
-        const auto & [xDim, yDim, zDim] = this->dataPtr->waterVelocityShape;
-
-        const VectorFieldT::GridT *xData = nullptr;
-        if (!xDim.empty())
-        {
-          if (!_data.frame.Has(xDim))
-          {
-            gzerr << "No '" << xDim << "' data found "
-                  << "in the environment" << std::endl;
-            return;
-          }
-          xData = &_data.frame[xDim];
-        }
-        const VectorFieldT::GridT *yData = nullptr;
-        if (!yDim.empty())
+        EnvironmentalDataSampler sampler(_data, {
+            this->dataPtr->waterVelocityShape[0],
+            this->dataPtr->waterVelocityShape[1],
+            this->dataPtr->waterVelocityShape[2]});
+        if (!sampler.Valid())
         {
-          if (!_data.frame.Has(yDim))
-          {
-            gzerr << "No '" << yDim << "' data found "
-                  << "in the environment" << std::endl;
-            return;
-          }
-          yData = &_data.frame[yDim];
-        }
-        const VectorFieldT::GridT *zData = nullptr;
-        if (!zDim.empty())
-        {
-          if (!_data.frame.Has(zDim))
-          {
-            gzerr << "No '" << zDim << "' data found "
-                  << "in the environment" << std::endl;
-            return;
-          }
-          zData = &_data.frame[zDim];
+          return;
         }
 
-        this->dataPtr->waterVelocity = VectorFieldT(xData, yData, zData);
+        // Each beam samples with its own sampler, created when first used
+        this->dataPtr->waterVelocityData = &_data;
+        this->dataPtr->waterMassBeamSamples.clear();
         this->dataPtr->waterVelocityReference = _data.reference;
         this->dataPtr->waterVelocityUpdated = true;
 
@@ -1403,6 +1526,7 @@ namespace gz
     DopplerVelocityLog::Update(const std::chrono::steady_clock::duration &)
     {
       GZ_PROFILE("DopplerVelocityLog::Update");
+      this->ApplySceneChanges();
       if (!this->dataPtr->initialized || this->dataPtr->entityId == 0)
       {
         gzerr << "Not initialized, update ignored." << std::endl;
@@ -1440,7 +1564,18 @@ namespace gz
 
       const gz::math::Pose3d beamsFramePose =
           this->Pose() * this->dataPtr->beamsFrameTransform;
-      this->dataPtr->depthSensor->SetLocalPose(beamsFramePose);
+      if (this->dataPtr->perBeamRendering)
+      {
+        for (size_t i = 0; i < this->dataPtr->depthSensors.size(); ++i)
+        {
+          this->dataPtr->depthSensors[i]->SetLocalPose(
+              beamsFramePose * this->dataPtr->beams[i].Transform());
+        }
+      }
+      else
+      {
+        this->dataPtr->depthSensors.front()->SetLocalPose(beamsFramePose);
+      }
       this->dataPtr->imageSensor->SetLocalPose(beamsFramePose);
 
       // Generate sensor data
@@ -1450,13 +1585,12 @@ namespace gz
     }
 
     //////////////////////////////////////////////////
-    DVLVelocityTracking
-    DopplerVelocityLog::Implementation::TrackBottom(
+    void DopplerVelocityLog::Implementation::TrackBottom(
         const std::chrono::steady_clock::duration &_now,
-        TrackingModeInfo *_info)
+        TrackingModeInfo *_info, DVLVelocityTracking *_message)
     {
       // Boostrap velocity tracking message
-      DVLVelocityTracking message;
+      DVLVelocityTracking &message = *_message;
       auto * headerMessage = message.mutable_header();
       *headerMessage->mutable_stamp() = gz::msgs::Convert(_now);
       message.set_type(this->dvlType);
@@ -1471,11 +1605,12 @@ namespace gz
       //  | Bnx Bny Bnz |           | sn |
       //
       // where Bk is the k-th beam axis, v is the velocity to estimate
-      // and sk is the k-th beam measured speed.
+      // and sk is the k-th beam measured speed. The problem is solved
+      // through its 3x3 normal equations, accumulated beam by beam.
       size_t numBeamsLocked = 0;
       double targetRange = std::numeric_limits<double>::infinity();
-      Eigen::MatrixXd beamBasis(this->beams.size(), 3);
-      Eigen::VectorXd beamSpeeds(this->beams.size());
+      Eigen::Matrix3d beamBasisGramian = Eigen::Matrix3d::Zero();
+      Eigen::Vector3d beamBasisSpeeds = Eigen::Vector3d::Zero();
       const EntityKinematicState & sensorStateInWorldFrame =
           this->worldState->kinematics.at(this->entityId);
 
@@ -1483,6 +1618,54 @@ namespace gz
           this->bottomModeNoise ?
           std::pow(this->bottomModeNoise->StdDev(), 2.) : 0.0;
 
+      // Measure beam speeds concurrently. Noise is applied and the least
+      // squares problem is built in beam order afterwards, so estimates
+      // do not depend on the number of threads.
+      this->bottomBeamSamples.resize(this->beams.size());
+      this->ForEachBeam([&](size_t _beam)
+      {
+        const auto & beamTarget = this->beamTargets[_beam];
+        if (!beamTarget)
+        {
+          return;
+        }
+
+        EntityKinematicState targetEntityStateInWorldFrame;
+        if (this->worldState->kinematics.count(beamTarget->entity) > 0)
+        {
+          targetEntityStateInWorldFrame =
+              this->worldState->kinematics.at(beamTarget->entity);
+        }
+
+        // Transform beam reflecting target pose
+        // in the (global) world frame
+        const gz::math::Pose3d targetPoseInWorldFrame =
+            sensorStateInWorldFrame.pose *
+            this->beamsFrameTransform *
+            beamTarget->pose;
+
+        // Compute beam reflecting target velocity
+        // in the (global) world frame
+        const gz::math::Vector3d targetVelocityInWorldFrame =
+            targetEntityStateInWorldFrame.linearVelocity +
+            targetEntityStateInWorldFrame.angularVelocity.Cross(
+                targetPoseInWorldFrame.Pos() -
+                targetEntityStateInWorldFrame.pose.Pos());
+
+        // Compute DVL velocity w.r.t. target velocity in the sensor frame
+        const gz::math::Vector3d relativeSensorVelocityInSensorFrame =
+            sensorStateInWorldFrame.pose.Rot().RotateVectorReverse(
+                sensorStateInWorldFrame.linearVelocity -
+                targetVelocityInWorldFrame);
+
+        // Estimate speed as measured by beam (excl. measurement noise)
+        BottomBeamSample & sample = this->bottomBeamSamples[_beam];
+        sample.axisInSensorFrame =
+            this->beamsFrameTransform.Rot() * this->beams[_beam].Axis();
+        sample.speed =
+            relativeSensorVelocityInSensorFrame.Dot(sample.axisInSensorFrame);
+      });
+
       for (size_t i = 0; i < this->beams.size(); ++i)
       {
         const AcousticBeam & beam = this->beams[i];
@@ -1499,39 +1682,11 @@ namespace gz
           // Use shortest beam range as target range
           targetRange = std::min(targetRange, beamRange);
 
-          EntityKinematicState targetEntityStateInWorldFrame;
-          if (this->worldState->kinematics.count(beamTarget->entity) > 0)
-          {
-            targetEntityStateInWorldFrame =
-                this->worldState->kinematics.at(beamTarget->entity);
-          }
-
-          // Transform beam reflecting target pose
-          // in the (global) world frame
-          const gz::math::Pose3d targetPoseInWorldFrame =
-              sensorStateInWorldFrame.pose *
-              this->beamsFrameTransform *
-              beamTarget->pose;
-
-          // Compute beam reflecting target velocity
-          // in the (global) world frame
-          const gz::math::Vector3d targetVelocityInWorldFrame =
-              targetEntityStateInWorldFrame.linearVelocity +
-              targetEntityStateInWorldFrame.angularVelocity.Cross(
-                  targetPoseInWorldFrame.Pos() -
-                  targetEntityStateInWorldFrame.pose.Pos());
-
-          // Compute DVL velocity w.r.t. target velocity in the sensor frame
-          const gz::math::Vector3d relativeSensorVelocityInSensorFrame =
-              sensorStateInWorldFrame.pose.Rot().RotateVectorReverse(
-                  sensorStateInWorldFrame.linearVelocity -
-                  targetVelocityInWorldFrame);
-
-          // Estimate speed as measured by beam (incl. measurement noise)
-          const gz::math::Vector3d beamAxisInSensorFrame =
-              this->beamsFrameTransform.Rot() * beam.Axis();
-          double beamSpeed =
-              relativeSensorVelocityInSensorFrame.Dot(beamAxisInSensorFrame);
+          // Add measurement noise to the speed measured by the beam
+          const BottomBeamSample & sample = this->bottomBeamSamples[i];
+          const gz::math::Vector3d & beamAxisInSensorFrame =
+              sample.axisInSensorFrame;
+          double beamSpeed = sample.speed;
           if (this->bottomModeNoise)
           {
             beamSpeed = this->bottomModeNoise->Apply(beamSpeed);
@@ -1560,8 +1715,9 @@ namespace gz
                     beamVelocityMessage->mutable_covariance()->begin());
 
           // Build least squares problem in the reference frame
-          beamBasis.row(numBeamsLocked) = beamBasisElement.transpose();
-          beamSpeeds(numBeamsLocked) = beamSpeed;
+          beamBasisGramian.noalias() +=
+              beamBasisElement * beamBasisElement.transpose();
+          beamBasisSpeeds += beamSpeed * beamBasisElement;
           ++numBeamsLocked;
         }
         beamMessage->set_locked(beamTarget.has_value());
@@ -1569,19 +1725,19 @@ namespace gz
 
       if (numBeamsLocked >= 3)
       {
-        // Enough rows for a unique least squares solution
-        const auto svdDecomposition =
-            beamBasis.topRows(numBeamsLocked).jacobiSvd(
-                Eigen::ComputeThinU | Eigen::ComputeThinV);
+        // Enough rows for a unique least squares solution. As B+ = (B^T B)+ B^T
+        // and B+ B+^T = (B^T B)+, the normal equations give the same solution
+        // and covariance as B+ does.
+        const Eigen::JacobiSVD<Eigen::Matrix3d> svdDecomposition(
+            beamBasisGramian, Eigen::ComputeFullU | Eigen::ComputeFullV);
 
         // Estimate DVL velocity mean and covariance in the reference frame
         const Eigen::Vector3d velocityMeanInReferenceFrame =
-            svdDecomposition.solve(beamSpeeds.head(numBeamsLocked));
-        const Eigen::MatrixXd pseudoInverse = svdDecomposition.solve(
-            Eigen::MatrixXd::Identity(numBeamsLocked, numBeamsLocked));
+            svdDecomposition.solve(beamBasisSpeeds);
         // Use row-major 1D layout for covariance
         const RowMajorMatrix3d velocityCovarianceInReferenceFrame =
-            pseudoInverse * bottomModeNoiseVariance * pseudoInverse.transpose();
+            bottomModeNoiseVariance *
+            svdDecomposition.solve(Eigen::Matrix3d::Identity());
 
         auto * velocityMessage = message.mutable_velocity();
         velocityMessage->set_reference(
@@ -1618,18 +1774,15 @@ namespace gz
       {
         _info->numBeamsLocked = numBeamsLocked;
       }
-
-      return message;
     }
 
     //////////////////////////////////////////////////
-    DVLVelocityTracking
-    DopplerVelocityLog::Implementation::TrackWaterMass(
+    void DopplerVelocityLog::Implementation::TrackWaterMass(
         const std::chrono::steady_clock::duration &_now,
-        TrackingModeInfo *_info)
+        TrackingModeInfo *_info, DVLVelocityTracking *_message)
     {
       // Boostrap velocity tracking message
-      DVLVelocityTracking message;
+      DVLVelocityTracking &message = *_message;
       auto * headerMessage = message.mutable_header();
       *headerMessage->mutable_stamp() = gz::msgs::Convert(_now);
       message.set_type(this->dvlType);
@@ -1648,28 +1801,46 @@ namespace gz
       //  | Bnx Bny Bnz |               | sn |
       //
       // where Bk is the k-th beam axis, v is the velocity to estimate
-      // and E[sk] is the expected k-th beam measured speed.
+      // and E[sk] is the expected k-th beam measured speed. The problem is
+      // solved through its 3x3 normal equations, accumulated beam by beam.
       size_t numBeamsLocked = 0;
       double meanTargetRange = std::numeric_limits<double>::infinity();
       double targetRangeVariance = std::numeric_limits<double>::infinity();
 
-      Eigen::MatrixXd beamBasis(this->beams.size(), 3);
-      Eigen::VectorXd averageBeamSpeeds(this->beams.size());
+      Eigen::Matrix3d beamBasisGramian = Eigen::Matrix3d::Zero();
+      Eigen::Vector3d beamBasisSpeeds = Eigen::Vector3d::Zero();
 
       const EntityKinematicState & sensorStateInWorldFrame =
           this->worldState->kinematics.at(this->entityId);
 
-      for (size_t i = 0; i < this->beams.size(); ++i)
+      // Each beam samples water velocity with its own sampler
+      this->waterMassBeamSamples.resize(this->beams.size());
+      for (auto & beamSample : this->waterMassBeamSamples)
       {
-        const AcousticBeam & beam = this->beams[i];
-        auto * beamMessage = message.add_beams();
-        beamMessage->set_id(beam.Id());
+        if (!beamSample.sampler)
+        {
+          beamSample.sampler.emplace(
+              *this->waterVelocityData, std::vector<std::string>{
+                this->waterVelocityShape[0],
+                this->waterVelocityShape[1],
+                this->waterVelocityShape[2]});
+        }
+      }
+
+      // Sample water velocity along beams concurrently. Noise is applied
+      // and the least squares problem is built in beam order afterwards,
+      // so estimates do not depend on the number of threads.
+      this->ForEachBeam([&](size_t _beam)
+      {
+        WaterMassBeamSample & beamSample = this->waterMassBeamSamples[_beam];
+        beamSample.sampler->StepTo(_now);
 
         const gz::math::Vector3d beamAxisInSensorFrame =
-            this->beamsFrameTransform.Rot() * beam.Axis();
+            this->beamsFrameTransform.Rot() * this->beams[_beam].Axis();
 
         // Discard beams that do not span both water mass boundaries
-        const auto & beamTarget = this->beamTargets[i];
+        beamSample.discarded = false;
+        const auto & beamTarget = this->beamTargets[_beam];
         if (beamTarget)
         {
           const double beamTargetBoundary = std::abs(
@@ -1677,13 +1848,93 @@ namespace gz
           if (beamTargetBoundary < this->waterMassModeFarBoundary)
           {
             // Bottom is too close for water mass tracking
-            beamMessage->set_locked(false);
-            continue;
+            beamSample.discarded = true;
+            return;
           }
         }
 
         const gz::math::Vector3d beamAxisInWorldFrame =
             sensorStateInWorldFrame.pose.Rot() * beamAxisInSensorFrame;
+        beamSample.axisInWorldFrame = beamAxisInWorldFrame;
+
+        // Sample points are the intersections between the beam axis and
+        // the mid-bin planes (along the -z-axis of the sensor frame), so
+        // they are evenly spaced along the beam axis in the world frame
+        const double projectionScale =
+            1. / -gz::math::Vector3d::UnitZ.Dot(beamAxisInSensorFrame);
+        const gz::math::Vector3d firstSamplePointInWorldFrame =
+            sensorStateInWorldFrame.pose.Pos() + projectionScale * (
+                this->waterMassModeBinHeight / 2 +
+                this->waterMassModeNearBoundary) * beamAxisInWorldFrame;
+        const gz::math::Vector3d sampleStepInWorldFrame =
+            projectionScale * this->waterMassModeBinHeight *
+            beamAxisInWorldFrame;
+
+        // Transforms to data frames other than spherical coordinates are
+        // affine, so sample points can be transformed just once too
+        const bool affineDataFrame = this->waterVelocityReference !=
+            gz::math::SphericalCoordinates::SPHERICAL;
+        gz::math::Vector3d firstSamplePointInDataFrame;
+        gz::math::Vector3d sampleStepInDataFrame;
+        if (affineDataFrame)
+        {
+          firstSamplePointInDataFrame =
+              this->worldState->origin.PositionTransform(
+                  firstSamplePointInWorldFrame,
+                  gz::math::SphericalCoordinates::GLOBAL,
+                  this->waterVelocityReference);
+          sampleStepInDataFrame =
+              this->worldState->origin.VelocityTransform(
+                  sampleStepInWorldFrame,
+                  gz::math::SphericalCoordinates::GLOBAL,
+                  this->waterVelocityReference);
+        }
+
+        // Project sensor velocity onto the beam axis once, bin samples
+        // only have to project the sampled water velocity
+        beamSample.sensorBeamSpeed =
+            sensorStateInWorldFrame.linearVelocity.Dot(beamAxisInWorldFrame);
+
+        // Transform sample points to the environmental data frame
+        std::vector<gz::math::Vector3d> &samplePointsInDataFrame =
+            beamSample.points;
+        samplePointsInDataFrame.resize(this->waterMassModeNumBins);
+        for (int j = 0; j < this->waterMassModeNumBins; ++j)
+        {
+          samplePointsInDataFrame[j] =
+              affineDataFrame ?
+              firstSamplePointInDataFrame + j * sampleStepInDataFrame :
+              this->worldState->origin.PositionTransform(
+                  firstSamplePointInWorldFrame + j * sampleStepInWorldFrame,
+                  gz::math::SphericalCoordinates::GLOBAL,
+                  this->waterVelocityReference);
+        }
+
+        // Sample water velocity in the world frame at all sample points,
+        // one velocity component at a time
+        for (std::size_t k = 0; k < beamSample.velocity.size(); ++k)
+        {
+          beamSample.sampler->LookUp(
+              k, samplePointsInDataFrame, beamSample.velocity[k]);
+        }
+      });
+
+      for (size_t i = 0; i < this->beams.size(); ++i)
+      {
+        const AcousticBeam & beam = this->beams[i];
+        auto * beamMessage = message.add_beams();
+        beamMessage->set_id(beam.Id());
+
+        const WaterMassBeamSample & beamSample =
+            this->waterMassBeamSamples[i];
+        if (beamSample.discarded)
+        {
+          beamMessage->set_locked(false);
+          continue;
+        }
+
+        const gz::math::Vector3d beamAxisInSensorFrame =
+            this->beamsFrameTransform.Rot() * beam.Axis();
 
         const gz::math::Vector3d beamAxisInReferenceFrame =
             this->referenceFrameRotation * beamAxisInSensorFrame;
@@ -1708,51 +1959,21 @@ namespace gz
           meanTargetRange = meanBeamRange;
           targetRangeVariance = beamRangeVariance;
         }
+
         // Compute beam speed mean and variance using water mass bin samples
         double averageBeamSpeed = 0.;
         double beamSpeedRSS = 0.;
         for (int j = 0; j < this->waterMassModeNumBins; ++j)
         {
-          // Compute offset to mid-bin plane in the sensor frame
-          // (along the -z-axis)
-          const double offsetToBinPlane = (
-              this->waterMassModeBinHeight * j +
-              this->waterMassModeBinHeight / 2 +
-              this->waterMassModeNearBoundary);
-
-          // Compute sample point as the intersection between
-          // beam axis and mid-bin plane in the sensor frame
-          const gz::math::Vector3d samplePointInSensorFrame =
-              (offsetToBinPlane * beamAxisInSensorFrame) /
-              -gz::math::Vector3d::UnitZ.Dot(beamAxisInSensorFrame);
-
-          // Transform sample point to the (global) world frame
-          const gz::math::Vector3d samplePointInWorldFrame =
-              sensorStateInWorldFrame.pose.Pos() +
-              sensorStateInWorldFrame.pose.Rot() *
-              samplePointInSensorFrame;
-
-          // Transform sample point to the environmental data frame
-          const gz::math::Vector3d samplePointInDataFrame =
-              this->worldState->origin.PositionTransform(
-                  samplePointInWorldFrame,
-                  gz::math::SphericalCoordinates::GLOBAL,
-                  this->waterVelocityReference);
-
-          // Sample water velocity in the world frame at sample point
-          const gz::math::Vector3d sampledVelocityInWorldFrame =
-              this->waterVelocity->LookUp(samplePointInDataFrame);
-
-          // Compute DVL velocity w.r.t. sampled water velocity
-          // in the sensor frame
-          const gz::math::Vector3d relativeSensorVelocityInSensorFrame =
-              sensorStateInWorldFrame.pose.Rot().RotateVectorReverse(
-                  sensorStateInWorldFrame.linearVelocity -
-                  sampledVelocityInWorldFrame);
-
-          // Estimate speed as measured by beam (incl. measurement noise)
-          double beamSpeed =
-              relativeSensorVelocityInSensorFrame.Dot(beamAxisInSensorFrame);
+          const gz::math::Vector3d sampledVelocityInWorldFrame(
+              beamSample.velocity[0][j].value_or(0.),
+              beamSample.velocity[1][j].value_or(0.),
+              beamSample.velocity[2][j].value_or(0.));
+
+          // Estimate speed as measured by beam (incl. measurement noise),
+          // i.e. DVL velocity w.r.t. sampled water velocity along the beam
+          double beamSpeed = beamSample.sensorBeamSpeed -
+              sampledVelocityInWorldFrame.Dot(beamSample.axisInWorldFrame);
           if (this->waterMassModeNoise)
           {
             this->waterMassModeNoise->Apply(beamSpeed);
@@ -1790,8 +2011,9 @@ namespace gz
                   beamVelocityMessage->mutable_covariance()->begin());
 
         // Build least squares problem in the reference frame
-        beamBasis.row(numBeamsLocked) = beamBasisElement;
-        averageBeamSpeeds(numBeamsLocked) = averageBeamSpeed;
+        beamBasisGramian.noalias() +=
+            beamBasisElement * beamBasisElement.transpose();
+        beamBasisSpeeds += averageBeamSpeed * beamBasisElement;
 
         ++numBeamsLocked;
 
@@ -1800,20 +2022,18 @@ namespace gz
 
       if (numBeamsLocked >= 3)
       {
-        // Enough rows for a unique least squares solution
-        const auto svdDecomposition =
-            beamBasis.topRows(numBeamsLocked).jacobiSvd(
-                Eigen::ComputeThinU | Eigen::ComputeThinV);
+        // Enough rows for a unique least squares solution,
+        // see TrackBottom() for the normal equations
+        const Eigen::JacobiSVD<Eigen::Matrix3d> svdDecomposition(
+            beamBasisGramian, Eigen::ComputeFullU | Eigen::ComputeFullV);
 
         // Estimate DVL velocity mean and covariance in the reference frame
         const Eigen::Vector3d velocityMeanInReferenceFrame =
-            svdDecomposition.solve(averageBeamSpeeds.head(numBeamsLocked));
-        const Eigen::MatrixXd pseudoInverse = svdDecomposition.solve(
-            Eigen::MatrixXd::Identity(numBeamsLocked, numBeamsLocked));
+            svdDecomposition.solve(beamBasisSpeeds);
         // Use row-major 1D layout for covariance
         const RowMajorMatrix3d velocityCovarianceInReferenceFrame =
-            pseudoInverse * waterMassModeNoiseVariance *
-            pseudoInverse.transpose();
+            waterMassModeNoiseVariance *
+            svdDecomposition.solve(Eigen::Matrix3d::Identity());
 
         auto * velocityMessage = message.mutable_velocity();
         velocityMessage->set_reference(
@@ -1852,7 +2072,6 @@ namespace gz
         // Track number of beams locked for scoring
         _info->numBeamsLocked = numBeamsLocked;
       }
-      return message;
     }
 
     //////////////////////////////////////////////////
@@ -1895,24 +2114,26 @@ namespace gz
         }
       }
 
+      // Tracking messages are released with the message arena, if enabled,
+      // or cleared and reused across updates otherwise
       TrackingModeInfo bottomModeInfo;
-      DVLVelocityTracking bottomModeMessage;
+      ArenaMessage<DVLVelocityTracking> bottomModeMessage(
+          this->MessageArena(), &this->dataPtr->bottomModeMessage);
       if (this->dataPtr->bottomModeSwitch)
       {
-        bottomModeMessage =
-            this->dataPtr->TrackBottom(_now, &bottomModeInfo);
+        this->dataPtr->TrackBottom(
+            _now, &bottomModeInfo, bottomModeMessage.Get());
       }
 
       TrackingModeInfo waterMassModeInfo;
-      DVLVelocityTracking waterMassModeMessage;
+      ArenaMessage<DVLVelocityTracking> waterMassModeMessage(
+          this->MessageArena(), &this->dataPtr->waterMassModeMessage);
       if (this->dataPtr->waterMassModeSwitch)
       {
-        if (this->dataPtr->waterVelocity)
+        if (this->dataPtr->waterVelocityData)
         {
-          this->dataPtr->waterVelocity->StepTo(_now);
-
-          waterMassModeMessage =
-              this->dataPtr->TrackWaterMass(_now, &waterMassModeInfo);
+          this->dataPtr->TrackWaterMass(
+              _now, &waterMassModeInfo, waterMassModeMessage.Get());
         }
         else if (this->dataPtr->waterVelocityUpdated)
         {
@@ -1944,15 +2165,15 @@ namespace gz
       {
         if (this->dataPtr->publishingEstimates)
         {
-          auto * headerMessage = bottomModeMessage.mutable_header();
+          auto * headerMessage = bottomModeMessage->mutable_header();
           this->AddSequence(headerMessage, "doppler_velocity_log");
-          this->dataPtr->pub.Publish(bottomModeMessage);
+          this->Publish(this->dataPtr->pub, *bottomModeMessage);
         }
 
         if (this->dataPtr->visualizeBottomModeBeams)
         {
           this->dataPtr->UpdateBeamMarkers(
-              this, bottomModeMessage,
+              this, _now, *bottomModeMessage,
               &this->dataPtr->bottomModeBeamMarkers);
         }
       }
@@ -1963,28 +2184,32 @@ namespace gz
       {
         if (this->dataPtr->publishingEstimates)
         {
-          auto * headerMessage = waterMassModeMessage.mutable_header();
+          auto * headerMessage = waterMassModeMessage->mutable_header();
           this->AddSequence(headerMessage, "doppler_velocity_log");
-          this->dataPtr->pub.Publish(waterMassModeMessage);
+          this->Publish(this->dataPtr->pub, *waterMassModeMessage);
         }
 
         if (this->dataPtr->visualizeWaterMassModeBeams)
         {
           this->dataPtr->UpdateBeamMarkers(
-              this, waterMassModeMessage,
+              this, _now, *waterMassModeMessage,
               &this->dataPtr->waterMassModeBeamMarkers);
         }
       }
+
+      // PostUpdate runs outside of Update, so release the tracking messages
+      // here. They are not used past this point.
+      this->ResetMessageArena();
     }
 
     //////////////////////////////////////////////////
     void DopplerVelocityLog::Implementation::UpdateBeamMarkers(
         DopplerVelocityLog *_sensor,
+        const std::chrono::steady_clock::duration &_now,
         const DVLVelocityTracking &_trackingMessage,
-        gz::msgs::Marker_V *_beamMarkersMessage)
+        BeamMarkers *_beamMarkers)
     {
-      auto * headerMessage = _beamMarkersMessage->mutable_header();
-      _sensor->AddSequence(headerMessage, "doppler_velocity_log_viz");
+      gz::msgs::Marker_V *_beamMarkersMessage = &_beamMarkers->markers;
 
       for (int i = 0; i < _trackingMessage.beams_size(); ++i)
       {
@@ -1996,14 +2221,14 @@ namespace gz
             _beamMarkersMessage->mutable_marker(3 * i + 2);
 
         beamLowerQuantileConeMarker->set_parent(
-            this->depthSensor->Parent()->Name());
+            this->imageSensor->Parent()->Name());
         beamUpperQuantileConeMarker->set_parent(
-            this->depthSensor->Parent()->Name());
+            this->imageSensor->Parent()->Name());
         beamCapMarker->set_parent(
-            this->depthSensor->Parent()->Name());
+            this->imageSensor->Parent()->Name());
 
         const gz::math::Pose3d beamLocalTransform =
-            this->depthSensor->LocalPose() * this->beams[i].Transform();
+            this->imageSensor->LocalPose() * this->beams[i].Transform();
         gz::msgs::Set(
             beamLowerQuantileConeMarker->mutable_pose(), beamLocalTransform);
         gz::msgs::Set(
@@ -2074,13 +2299,72 @@ namespace gz
         }
       }
 
-      bool result;
-      gz::msgs::Boolean reply;
-      constexpr unsigned int timeout_ms = 1000u;
-      bool outcome = this->node.Request(
-          "/marker_array", *_beamMarkersMessage,
-          timeout_ms, reply, result);
-      if (!outcome || !result || !reply.data())
+      // Send geometry only for markers that are not known to be shown,
+      // and deletions only for markers that are
+      gz::msgs::Marker_V &updatesMessage = _beamMarkers->updates;
+      updatesMessage.clear_marker();
+      auto * headerMessage = updatesMessage.mutable_header();
+      _sensor->AddSequence(headerMessage, "doppler_velocity_log_viz");
+      for (int k = 0; k < _beamMarkersMessage->marker_size(); ++k)
+      {
+        const auto & marker = _beamMarkersMessage->marker(k);
+        auto & shownUntil = _beamMarkers->shownUntil[k];
+        const bool shown = _now <= shownUntil;
+        if (marker.action() == gz::msgs::Marker::DELETE_MARKER)
+        {
+          if (shown)
+          {
+            auto * updateMarker = updatesMessage.add_marker();
+            updateMarker->set_ns(marker.ns());
+            updateMarker->set_id(marker.id());
+            updateMarker->set_action(gz::msgs::Marker::DELETE_MARKER);
+          }
+          shownUntil = std::chrono::steady_clock::duration::min();
+          continue;
+        }
+
+        auto * updateMarker = updatesMessage.add_marker();
+        if (shown)
+        {
+          updateMarker->set_ns(marker.ns());
+          updateMarker->set_id(marker.id());
+          updateMarker->set_action(marker.action());
+          updateMarker->set_type(marker.type());
+          updateMarker->set_visibility(marker.visibility());
+          *updateMarker->mutable_lifetime() = marker.lifetime();
+          updateMarker->set_parent(marker.parent());
+          *updateMarker->mutable_pose() = marker.pose();
+          *updateMarker->mutable_scale() = marker.scale();
+          *updateMarker->mutable_material() = marker.material();
+        }
+        else
+        {
+          *updateMarker = marker;
+        }
+        shownUntil =
+            _beamMarkers->holdTime == std::chrono::steady_clock::duration::max()
+            ? _beamMarkers->holdTime : _now + _beamMarkers->holdTime;
+      }
+
+      if (updatesMessage.marker_size() == 0)
+      {
+        return;
+      }
+
+      // Do not block on the reply, so that slow clients do not stall
+      // the sensor
+      const std::string sensorName = _sensor->Name();
+      std::function<void(const gz::msgs::Boolean &, const bool)> onReply =
+          [sensorName](const gz::msgs::Boolean &_reply, const bool _result)
+          {
+            if (!_result || !_reply.data())
+            {
+              gzwarn << "Failed to render beam markers for ["
+                     << sensorName << "] sensor."
+                     << std::endl;
+            }
+          };
+      if (!this->node.Request("/marker_array", updatesMessage, onReply))
       {
         gzwarn << "Failed to render beam markers for ["
                << _sensor->Name() << "] sensor."
@@ -2093,5 +2377,88 @@ namespace gz
     {
       return this->dataPtr->pub && this->dataPtr->pub.HasConnections();
     }
+
+    //////////////////////////////////////////////////
+    void DopplerVelocityLog::SetThreadCount(unsigned int _count)
+    {
+      if (_count == 0u)
+        _count = 1u;
+      if (_count == this->ThreadCount())
+        return;
+
+      this->dataPtr->workers.reset();
+      if (_count > 1u)
+        this->dataPtr->workers = std::make_unique<RowWorkers>(_count);
+    }
+
+    //////////////////////////////////////////////////
+    unsigned int DopplerVelocityLog::ThreadCount() const
+    {
+      return this->dataPtr->workers ? this->dataPtr->workers->Count() : 1u;
+    }
+
+    //////////////////////////////////////////////////
+    void DopplerVelocityLog::SaveState(SensorState &_state) const
+    {
+      RenderingSensor::SaveState(_state);
+
+      // The tracking mode noise models aren't registered with the sensor
+      for (const auto &noise :
+           {this->dataPtr->bottomModeNoise, this->dataPtr->waterMassModeNoise})
+      {
+        _state.Write(noise != nullptr);
+        if (noise)
+          noise->SaveState(_state);
+      }
+
+      const auto &targets = this->dataPtr->beamTargets;
+      _state.Write(static_cast<uint64_t>(targets.size()));
+      for (const auto &target : targets)
+      {
+        _state.Write(target.has_value());
+        if (target)
+        {
+          _state.Write(target->pose);
+          _state.Write(target->entity);
+        }
+      }
+    }
+
+    //////////////////////////////////////////////////
+    bool DopplerVelocityLog::RestoreState(SensorState &_state)
+    {
+      if (!RenderingSensor::RestoreState(_state))
+        return false;
+
+      for (const auto &noise :
+           {this->dataPtr->bottomModeNoise, this->dataPtr->waterMassModeNoise})
+      {
+        bool hasNoise{false};
+        if (!_state.Read(hasNoise) || hasNoise != (noise != nullptr))
+          return false;
+        if (noise && !noise->RestoreState(_state))
+          return false;
+      }
+
+      uint64_t count{0u};
+      if (!_state.Read(count) || count != this->dataPtr->beamTargets.size())
+        return false;
+      for (auto &target : this->dataPtr->beamTargets)
+      {
+        bool hasTarget{false};
+        if (!_state.Read(hasTarget))
+          return false;
+        if (!hasTarget)
+        {
+          target.reset();
+          continue;
+        }
+        TrackingTarget restored;
+        if (!_state.Read(restored.pose) || !_state.Read(restored.entity))
+          return false;
+        target = restored;
+      }
+      return true;
+    }
   }  // namespace sensors
 }  // namespace gz
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ElevationMap.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <gz/common/Profiler.hh>
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+//////////////////////////////////////////////////
+/// \brief Get a numeric header entry.
+/// \param[in] _msg Cloud.
+/// \param[in] _key Key of the entry.
+/// \param[out] _value Value of the entry.
+/// \return True if the entry exists and is a number.
+bool HeaderValue(const msgs::PointCloudPacked &_msg, const std::string &_key,
+    double &_value)
+{
+  for (int i = 0; i < _msg.header().data_size(); ++i)
+  {
+    const auto &data = _msg.header().data(i);
+    if (data.key() == _key && data.value_size() > 0)
+    {
+      std::istringstream stream(data.value(0));
+      return static_cast<bool>(stream >> _value);
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+/// \brief Add a header entry holding a number.
+/// \param[in,out] _msg Image.
+/// \param[in] _key Key of the entry.
+/// \param[in] _value Value of the entry.
+void AddHeaderValue(msgs::Image &_msg, const std::string &_key,
+    double _value)
+{
+  std::ostringstream value;
+  value.precision(std::numeric_limits<double>::max_digits10);
+  value << _value;
+  auto *entry = _msg.mutable_header()->add_data();
+  entry->set_key(_key);
+  entry->add_value(value.str());
+}
+}
+
+//////////////////////////////////////////////////
+ElevationMap::ElevationMap(double _resolution, unsigned int _size)
+  : resolution(_resolution), size(std::max(_size, 1u)),
+    heights(static_cast<std::size_t>(this->size) * this->size,
+        std::numeric_limits<float>::quiet_NaN())
+{
+}
+
+//////////////////////////////////////////////////
+double ElevationMap::Resolution() const
+{
+  return this->resolution;
+}
+
+//////////////////////////////////////////////////
+unsigned int ElevationMap::Size() const
+{
+  return this->size;
+}
+
+//////////////////////////////////////////////////
+int64_t ElevationMap::CellIndex(double _value) const
+{
+  return static_cast<int64_t>(std::floor(_value / this->resolution));
+}
+
+//////////////////////////////////////////////////
+std::size_t ElevationMap::RingIndex(int64_t _index) const
+{
+  const int64_t size = this->size;
+  return static_cast<std::size_t>(((_index % size) + size) % size);
+}
+
+//////////////////////////////////////////////////
+void ElevationMap::Recenter(const math::Vector3d &_position)
+{
+  if (!std::isfinite(_position.X()) || !std::isfinite(_position.Y()))
+    return;
+
+  const int64_t half = this->size / 2u;
+  const int64_t originX = this->CellIndex(_position.X()) - half;
+  const int64_t originY = this->CellIndex(_position.Y()) - half;
+  if (!this->hasOrigin)
+  {
+    this->originX = originX;
+    this->originY = originY;
+    this->hasOrigin = true;
+    return;
+  }
+
+  const int64_t size = this->size;
+  const int64_t dx = originX - this->originX;
+  const int64_t dy = originY - this->originY;
+  if (dx >= size || dx <= -size || dy >= size || dy <= -size)
+  {
+    this->Clear();
+  }
+  else
+  {
+    // Clear the columns, then the rows, that leave the grid. Moving up
+    // drops the lowest ones, moving down the highest ones.
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const int64_t firstColumn = dx > 0 ? this->originX : originX + size;
+    for (int64_t c = firstColumn; c < firstColumn + std::abs(dx); ++c)
+    {
+      const std::size_t column = this->RingIndex(c);
+      for (std::size_t row = 0u; row < this->size; ++row)
+        this->heights[row * this->size + column] = nan;
+    }
+    const int64_t firstRow = dy > 0 ? this->originY : originY + size;
+    for (int64_t r = firstRow; r < firstRow + std::abs(dy); ++r)
+    {
+      float *row = this->heights.data() + this->RingIndex(r) * this->size;
+      std::fill(row, row + this->size, nan);
+    }
+  }
+  this->originX = originX;
+  this->originY = originY;
+}
+
+//////////////////////////////////////////////////
+void ElevationMap::AddPoint(double _x, double _y, double _z)
+{
+  if (!std::isfinite(_x) || !std::isfinite(_y) || !std::isfinite(_z))
+    return;
+
+  const int64_t x = this->CellIndex(_x);
+  const int64_t y = this->CellIndex(_y);
+  const int64_t size = this->size;
+  if (x < this->originX || x >= this->originX + size ||
+      y < this->originY || y >= this->originY + size)
+  {
+    return;
+  }
+
+  // Also replaces the NaN of empty cells
+  float &height = this->heights[this->RingIndex(y) * this->size +
+      this->RingIndex(x)];
+  const float z = static_cast<float>(_z);
+  if (!(height >= z))
+    height = z;
+}
+
+//////////////////////////////////////////////////
+void ElevationMap::AddPoints(const float *_points, std::size_t _count,
+    std::size_t _stride, const math::Pose3d &_pose)
+{
+  GZ_PROFILE("ElevationMap::AddPoints");
+  this->Recenter(_pose.Pos());
+  if (!_points || _stride < 3u)
+    return;
+
+  // Columns of the rotation matrix
+  const math::Vector3d ex = _pose.Rot().RotateVector(math::Vector3d::UnitX);
+  const math::Vector3d ey = _pose.Rot().RotateVector(math::Vector3d::UnitY);
+  const math::Vector3d ez = _pose.Rot().RotateVector(math::Vector3d::UnitZ);
+  const math::Vector3d &t = _pose.Pos();
+  for (std::size_t i = 0u; i < _count; ++i)
+  {
+    const float *p = _points + i * _stride;
+    const double x = p[0];
+    const double y = p[1];
+    const double z = p[2];
+    this->AddPoint(ex.X() * x + ey.X() * y + ez.X() * z + t.X(),
+                   ex.Y() * x + ey.Y() * y + ez.Y() * z + t.Y(),
+                   ex.Z() * x + ey.Z() * y + ez.Z() * z + t.Z());
+  }
+}
+
+//////////////////////////////////////////////////
+bool ElevationMap::AddPoints(const msgs::PointCloudPacked &_cloud,
+    const math::Pose3d &_pose, std::size_t _first, std::size_t _count)
+{
+  GZ_PROFILE("ElevationMap::AddPoints");
+  if (_cloud.field_size() < 3 || _cloud.width() == 0u)
+    return false;
+
+  const auto type = _cloud.field(0).datatype();
+  const bool quantized = type == msgs::PointCloudPacked::Field::INT16;
+  if (!quantized && type != msgs::PointCloudPacked::Field::FLOAT32)
+    return false;
+  const std::size_t fieldSize = quantized ? sizeof(int16_t) : sizeof(float);
+  for (int k = 0; k < 3; ++k)
+  {
+    if (_cloud.field(k).datatype() != type ||
+        _cloud.field(k).offset() + fieldSize > _cloud.point_step())
+    {
+      return false;
+    }
+  }
+  double scale = 1.0;
+  if (quantized && !HeaderValue(_cloud, "xyz_resolution", scale))
+    return false;
+
+  // Rows may be padded
+  const std::size_t width = _cloud.width();
+  const std::size_t end = _first + _count;
+  if (_count > 0u && _cloud.data().size() <
+      ((end - 1u) / width) * _cloud.row_step() +
+      ((end - 1u) % width + 1u) * _cloud.point_step())
+  {
+    return false;
+  }
+
+  this->Recenter(_pose.Pos());
+  const math::Vector3d ex = _pose.Rot().RotateVector(math::Vector3d::UnitX);
+  const math::Vector3d ey = _pose.Rot().RotateVector(math::Vector3d::UnitY);
+  const math::Vector3d ez = _pose.Rot().RotateVector(math::Vector3d::UnitZ);
+  const math::Vector3d &t = _pose.Pos();
+  const char *data = _cloud.data().data();
+  for (std::size_t i = _first; i < end; ++i)
+  {
+    const char *point = data + (i / width) * _cloud.row_step() +
+        (i % width) * _cloud.point_step();
+    double xyz[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      if (quantized)
+      {
+        int16_t value;
+        std::memcpy(&value, point + _cloud.field(k).offset(), sizeof(value));
+        // The lowest value marks invalid points
+        xyz[k] = value == std::numeric_limits<int16_t>::min() ?
+            std::numeric_limits<double>::quiet_NaN() : value * scale;
+      }
+      else
+      {
+        float value;
+        std::memcpy(&value, point + _cloud.field(k).offset(), sizeof(value));
+        xyz[k] = value;
+      }
+    }
+    this->AddPoint(
+        ex.X() * xyz[0] + ey.X() * xyz[1] + ez.X() * xyz[2] + t.X(),
+        ex.Y() * xyz[0] + ey.Y() * xyz[1] + ez.Y() * xyz[2] + t.Y(),
+        ex.Z() * xyz[0] + ey.Z() * xyz[1] + ez.Z() * xyz[2] + t.Z());
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+float ElevationMap::Height(double _x, double _y) const
+{
+  const int64_t x = this->CellIndex(_x);
+  const int64_t y = this->CellIndex(_y);
+  const int64_t size = this->size;
+  if (!this->hasOrigin || x < this->originX || x >= this->originX + size ||
+      y < this->originY || y >= this->originY + size)
+  {
+    return std::numeric_limits<float>::quiet_NaN();
+  }
+  return this->heights[this->RingIndex(y) * this->size + this->RingIndex(x)];
+}
+
+//////////////////////////////////////////////////
+void ElevationMap::Clear()
+{
+  std::fill(this->heights.begin(), this->heights.end(),
+      std::numeric_limits<float>::quiet_NaN());
+}
+
+//////////////////////////////////////////////////
+void ElevationMap::FillMsg(msgs::Image &_msg) const
+{
+  GZ_PROFILE("ElevationMap::FillMsg");
+  const std::size_t size = this->size;
+  _msg.set_width(this->size);
+  _msg.set_height(this->size);
+  _msg.set_step(this->size * sizeof(float));
+  _msg.set_pixel_format_type(msgs::PixelFormatType::R_FLOAT32);
+
+  // Each row of the ring buffer is in two parts, from the lowest column to
+  // the end of the buffer and from its start
+  std::string *data = _msg.mutable_data();
+  data->resize(size * size * sizeof(float));
+  char *out = data->data();
+  const std::size_t split = this->RingIndex(this->originX);
+  for (std::size_t j = 0u; j < size; ++j)
+  {
+    const float *row = this->heights.data() +
+        this->RingIndex(this->originY + static_cast<int64_t>(j)) * size;
+    std::memcpy(out, row + split, (size - split) * sizeof(float));
+    std::memcpy(out + (size - split) * sizeof(float), row,
+        split * sizeof(float));
+    out += size * sizeof(float);
+  }
+
+  AddHeaderValue(_msg, "resolution", this->resolution);
+  AddHeaderValue(_msg, "origin_x", this->originX * this->resolution);
+  AddHeaderValue(_msg, "origin_y", this->originY * this->resolution);
+}
+
+//////////////////////////////////////////////////
+std::size_t ElevationMap::MemorySize() const
+{
+  return this->heights.capacity() * sizeof(float);
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_ELEVATIONMAP_HH_
+#define GZ_SENSORS_ELEVATIONMAP_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <gz/math/Pose3.hh>
+#include <gz/msgs/image.pb.h>
+#include <gz/msgs/pointcloud_packed.pb.h>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Square 2.5D elevation grid in the world frame, centered on
+    /// the sensor and aligned with the world axes. Each cell holds the
+    /// highest point that fell in it, NaN until a point does, so a cell is
+    /// occupied if its height is finite.
+    ///
+    /// The cells are a ring buffer indexed by their world coordinates
+    /// modulo the size of the grid. When the sensor moves, the grid
+    /// scrolls by whole cells: only the cells that leave it are cleared,
+    /// the others stay in place and keep their heights.
+    class GZ_SENSORS_VISIBLE ElevationMap
+    {
+      /// \brief Constructor
+      /// \param[in] _resolution Size of a cell in meters, positive.
+      /// \param[in] _size Number of cells along each side, at least 1.
+      public: ElevationMap(double _resolution, unsigned int _size);
+
+      /// \brief Get the size of a cell.
+      /// \return Size in meters.
+      public: double Resolution() const;
+
+      /// \brief Get the number of cells along each side.
+      /// \return Number of cells.
+      public: unsigned int Size() const;
+
+      /// \brief Move the grid so a position is in its center cell, clearing
+      /// the cells that leave it.
+      /// \param[in] _position Position in the world frame.
+      public: void Recenter(const math::Vector3d &_position);
+
+      /// \brief Add points, after moving the grid to the sensor. Points
+      /// with a non-finite coordinate and points outside of the grid are
+      /// ignored.
+      /// \param[in] _points x, y and z of each point, in the sensor frame.
+      /// \param[in] _count Number of points.
+      /// \param[in] _stride Number of floats from a point to the next one,
+      /// at least 3.
+      /// \param[in] _pose Pose of the sensor in the world frame.
+      public: void AddPoints(const float *_points, std::size_t _count,
+                  std::size_t _stride, const math::Pose3d &_pose);
+
+      /// \brief Add points of a cloud, after moving the grid to the sensor.
+      /// \param[in] _cloud Cloud in the sensor frame. Its x, y and z must
+      /// be its first three fields, as FLOAT32 or as INT16 with an
+      /// "xyz_resolution" header entry.
+      /// \param[in] _pose Pose of the sensor in the world frame.
+      /// \param[in] _first Index of the first point to add, in row major
+      /// order.
+      /// \param[in] _count Number of points to add.
+      /// \return False if the cloud doesn't have these points.
+      public: bool AddPoints(const msgs::PointCloudPacked &_cloud,
+                  const math::Pose3d &_pose, std::size_t _first,
+                  std::size_t _count);
+
+      /// \brief Get the height of the cell that holds a position.
+      /// \param[in] _x X coordinate in the world frame.
+      /// \param[in] _y Y coordinate in the world frame.
+      /// \return Height in meters, NaN if the cell is empty or outside of
+      /// the grid.
+      public: float Height(double _x, double _y) const;
+
+      /// \brief Clear all the cells.
+      public: void Clear();
+
+      /// \brief Fill an image with the grid. The image is R_FLOAT32, Size()
+      /// pixels wide and high. Column i and row j are the cell whose lower
+      /// corner is at x = origin_x + i * resolution and y = origin_y + j *
+      /// resolution. The "resolution", "origin_x" and "origin_y" header
+      /// entries are added, in meters. The other header entries and the
+      /// stamp are kept.
+      /// \param[out] _msg Image to fill.
+      public: void FillMsg(msgs::Image &_msg) const;
+
+      /// \brief Get the memory held by the cells.
+      /// \return Size in bytes.
+      public: std::size_t MemorySize() const;
+
+      /// \brief Get the world index of the cell that holds a coordinate.
+      /// \param[in] _value Coordinate in meters.
+      /// \return Cell index.
+      private: int64_t CellIndex(double _value) const;
+
+      /// \brief Get the ring buffer index of a world cell index.
+      /// \param[in] _index World cell index.
+      /// \return Index between 0 and Size() - 1.
+      private: std::size_t RingIndex(int64_t _index) const;
+
+      /// \brief Add a point in the world frame.
+      /// \param[in] _x X coordinate.
+      /// \param[in] _y Y coordinate.
+      /// \param[in] _z Z coordinate.
+      private: void AddPoint(double _x, double _y, double _z);
+
+      /// \brief Size of a cell.
+      private: double resolution;
+
+      /// \brief Number of cells along each side.
+      private: unsigned int size;
+
+      /// \brief World index of the lowest column of the grid.
+      private: int64_t originX{0};
+
+      /// \brief World index of the lowest row of the grid.
+      private: int64_t originY{0};
+
+      /// \brief True once the grid was moved to a position.
+      private: bool hasOrigin{false};
+
+      /// \brief Height of each cell, indexed by the ring buffer indices of
+      /// its row and column.
+      private: std::vector<float> heights;
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gz/math/Pose3.hh>
+
+#include "ElevationMap.hh"
+#include "PointCloudUtil.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+//////////////////////////////////////////////////
+/// \brief Get the value of a header entry.
+/// \param[in] _msg Image.
+/// \param[in] _key Key of the entry.
+/// \return Value, empty if there is no entry.
+std::string HeaderValue(const msgs::Image &_msg, const std::string &_key)
+{
+  for (int i = 0; i < _msg.header().data_size(); ++i)
+  {
+    const auto &data = _msg.header().data(i);
+    if (data.key() == _key && data.value_size() > 0)
+      return data.value(0);
+  }
+  return std::string();
+}
+}
+
+//////////////////////////////////////////////////
+TEST(ElevationMap, HighestPoint)
+{
+  ElevationMap map(0.5, 10u);
+  EXPECT_DOUBLE_EQ(0.5, map.Resolution());
+  EXPECT_EQ(10u, map.Size());
+
+  // The grid spans [-2.5, 2.5) around the sensor
+  const float nan = std::nanf("");
+  const std::vector<float> points = {
+      1.1f, 1.2f, 0.3f, 0.0f,
+      1.4f, 1.0f, 0.7f, 0.0f,
+      1.2f, 1.3f, 0.5f, 0.0f,
+      -2.6f, 0.0f, 1.0f, 0.0f,
+      -2.4f, 0.0f, -1.0f, 0.0f,
+      0.0f, 2.6f, 1.0f, 0.0f,
+      0.0f, 0.0f, nan, 0.0f};
+  map.AddPoints(points.data(), points.size() / 4u, 4u, math::Pose3d::Zero);
+
+  EXPECT_FLOAT_EQ(0.7f, map.Height(1.25, 1.25));
+  EXPECT_FLOAT_EQ(-1.0f, map.Height(-2.25, 0.25));
+  EXPECT_TRUE(std::isnan(map.Height(0.25, 0.25)));
+  EXPECT_TRUE(std::isnan(map.Height(-2.75, 0.25)));
+  EXPECT_TRUE(std::isnan(map.Height(0.25, 2.75)));
+
+  map.Clear();
+  EXPECT_TRUE(std::isnan(map.Height(1.25, 1.25)));
+}
+
+//////////////////////////////////////////////////
+TEST(ElevationMap, SensorPose)
+{
+  ElevationMap map(1.0, 8u);
+
+  // 90 degrees of yaw: x forward is y in the world
+  const math::Pose3d pose(10.0, 20.0, 1.5, 0.0, 0.0, GZ_PI * 0.5);
+  const std::vector<float> points = {2.0f, 0.0f, -1.0f};
+  map.AddPoints(points.data(), 1u, 3u, pose);
+  EXPECT_FLOAT_EQ(0.5f, map.Height(10.5, 22.5));
+  EXPECT_TRUE(std::isnan(map.Height(12.5, 20.5)));
+}
+
+//////////////////////////////////////////////////
+TEST(ElevationMap, Scrolling)
+{
+  ElevationMap map(1.0, 4u);
+
+  // The grid spans [-2, 2) on x and y
+  std::vector<float> points;
+  for (int y = -2; y < 2; ++y)
+  {
+    for (int x = -2; x < 2; ++x)
+    {
+      points.push_back(x + 0.5f);
+      points.push_back(y + 0.5f);
+      points.push_back(static_cast<float>(10 * x + y));
+    }
+  }
+  map.AddPoints(points.data(), points.size() / 3u, 3u, math::Pose3d::Zero);
+
+  // Moving by one cell on x and two on y keeps the overlap
+  map.Recenter(math::Vector3d(1.2, 2.7, 0.0));
+  for (int y = -2; y < 2; ++y)
+  {
+    for (int x = -2; x < 2; ++x)
+    {
+      const float height = map.Height(x + 0.5, y + 0.5);
+      if (x >= -1 && y >= 0)
+        EXPECT_FLOAT_EQ(static_cast<float>(10 * x + y), height);
+      else
+        EXPECT_TRUE(std::isnan(height));
+    }
+  }
+
+  // The cells that entered the grid are empty, not the ones that left it
+  EXPECT_TRUE(std::isnan(map.Height(2.5, 0.5)));
+  EXPECT_TRUE(std::isnan(map.Height(0.5, 3.5)));
+
+  // Coming back doesn't restore the cleared cells
+  map.Recenter(math::Vector3d::Zero);
+  EXPECT_TRUE(std::isnan(map.Height(-1.5, -1.5)));
+  EXPECT_FLOAT_EQ(1.0f, map.Height(0.5, 1.5));
+
+  // Moving by more than the grid clears it
+  map.Recenter(math::Vector3d(100.0, 0.0, 0.0));
+  map.Recenter(math::Vector3d::Zero);
+  EXPECT_TRUE(std::isnan(map.Height(0.5, 1.5)));
+}
+
+//////////////////////////////////////////////////
+TEST(ElevationMap, FillMsg)
+{
+  ElevationMap map(0.5, 4u);
+
+  // Around (10.2, -2.9), the grid starts at (9, -4) and its first column
+  // isn't the first one of the ring buffer
+  const math::Pose3d pose(10.2, -2.9, 0.0, 0.0, 0.0, 0.0);
+  const std::vector<float> points = {
+      -1.0f, -0.7f, 1.0f,
+      0.6f, 0.8f, 2.0f};
+  map.AddPoints(points.data(), 2u, 3u, pose);
+
+  msgs::Image msg;
+  map.FillMsg(msg);
+  ASSERT_EQ(4u, msg.width());
+  ASSERT_EQ(4u, msg.height());
+  EXPECT_EQ(16u, msg.step());
+  EXPECT_EQ(msgs::PixelFormatType::R_FLOAT32, msg.pixel_format_type());
+  ASSERT_EQ(64u, msg.data().size());
+  EXPECT_EQ("0.5", HeaderValue(msg, "resolution"));
+  EXPECT_EQ("9", HeaderValue(msg, "origin_x"));
+  EXPECT_EQ("-4", HeaderValue(msg, "origin_y"));
+
+  std::vector<float> pixels(16u);
+  std::memcpy(pixels.data(), msg.data().data(), msg.data().size());
+  for (unsigned int j = 0u; j < 4u; ++j)
+  {
+    for (unsigned int i = 0u; i < 4u; ++i)
+    {
+      const float height = map.Height(9.25 + 0.5 * i, -3.75 + 0.5 * j);
+      if (std::isnan(height))
+        EXPECT_TRUE(std::isnan(pixels[j * 4u + i]));
+      else
+        EXPECT_FLOAT_EQ(height, pixels[j * 4u + i]);
+    }
+  }
+  EXPECT_FLOAT_EQ(1.0f, pixels[0u * 4u + 0u]);
+  EXPECT_FLOAT_EQ(2.0f, pixels[3u * 4u + 3u]);
+}
+
+//////////////////////////////////////////////////
+TEST(ElevationMap, Cloud)
+{
+  for (double resolution : {0.0, 0.01})
+  {
+    PointCloudUtil util;
+    util.SetResolution(resolution);
+    msgs::PointCloudPacked msg;
+    util.InitMsg(msg, "frame", {});
+    const float xyz[3][3] = {
+        {0.25f, 0.25f, 0.5f},
+        {-0.75f, 0.25f, 1.5f},
+        {0.25f, -0.75f, std::nanf("")}};
+    msg.set_width(3u);
+    msg.set_height(1u);
+    msg.set_row_step(msg.point_step() * 3u);
+    msg.mutable_data()->resize(msg.row_step());
+    for (uint32_t i = 0u; i < 3u; ++i)
+    {
+      char *point = msg.mutable_data()->data() + i * msg.point_step();
+      for (int k = 0; k < 3; ++k)
+      {
+        if (resolution > 0.0)
+        {
+          const int16_t q = PointCloudUtil::QuantizeCoordinate(xyz[i][k],
+              static_cast<float>(1.0 / resolution));
+          std::memcpy(point + msg.field(k).offset(), &q, sizeof(q));
+        }
+        else
+        {
+          std::memcpy(point + msg.field(k).offset(), &xyz[i][k],
+              sizeof(float));
+        }
+      }
+    }
+
+    // Only the points from the first one are added
+    ElevationMap map(1.0, 4u);
+    EXPECT_TRUE(map.AddPoints(msg, math::Pose3d::Zero, 1u, 2u));
+    EXPECT_TRUE(std::isnan(map.Height(0.5, 0.5)));
+    EXPECT_NEAR(1.5f, map.Height(-0.5, 0.5), 1e-5);
+    EXPECT_TRUE(std::isnan(map.Height(0.5, -0.5)));
+
+    EXPECT_TRUE(map.AddPoints(msg, math::Pose3d::Zero, 0u, 1u));
+    EXPECT_NEAR(0.5f, map.Height(0.5, 0.5), 1e-5);
+
+    // Past the end of the cloud
+    EXPECT_FALSE(map.AddPoints(msg, math::Pose3d::Zero, 2u, 2u));
+  }
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/math/TimeVaryingVolumetricGrid.hh>
+
+#include "gz/sensors/EnvironmentalDataSampler.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief A column of environmental data and its sampling state.
+struct SamplerColumn
+{
+  /// \brief Grid of the column, null if the column has no data.
+  const EnvironmentalData::T *grid{nullptr};
+
+  /// \brief Session on the grid, null once the grid can't be stepped.
+  std::optional<math::InMemorySession<double, double>> session;
+
+  /// \brief True if lastPosition and lastValue hold a sample.
+  bool cached{false};
+
+  /// \brief Position of the last sample.
+  math::Vector3d lastPosition;
+
+  /// \brief Value of the last sample.
+  std::optional<double> lastValue;
+};
+
+/// \brief Private data for EnvironmentalDataSampler
+class gz::sensors::EnvironmentalDataSamplerPrivate
+{
+  /// \brief Sample a column, reusing its last sample if the position is
+  /// close enough.
+  /// \param[in] _column Column to sample.
+  /// \param[in] _pos Position in the data frame.
+  /// \return Sampled value.
+  public: std::optional<double> Sample(SamplerColumn &_column,
+              const math::Vector3d &_pos) const;
+
+  /// \brief Columns, in the order they were given.
+  public: std::vector<SamplerColumn> columns;
+
+  /// \brief True if all the named columns were found.
+  public: bool valid{true};
+
+  /// \brief Distance a position can move before a column is sampled again.
+  public: double tolerance{0.0};
+
+  /// \brief Time the grids were last stepped to, if any.
+  public: std::optional<double> time;
+};
+
+//////////////////////////////////////////////////
+std::optional<double> EnvironmentalDataSamplerPrivate::Sample(
+    SamplerColumn &_column, const math::Vector3d &_pos) const
+{
+  if (!_column.grid || !_column.session)
+    return std::nullopt;
+
+  if (_column.cached &&
+      _pos.Distance(_column.lastPosition) <= this->tolerance)
+  {
+    return _column.lastValue;
+  }
+
+  _column.lastValue = _column.grid->LookUp(_column.session.value(), _pos);
+  _column.lastPosition = _pos;
+  _column.cached = true;
+  return _column.lastValue;
+}
+
+//////////////////////////////////////////////////
+EnvironmentalDataSampler::EnvironmentalDataSampler()
+  : dataPtr(new EnvironmentalDataSamplerPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+EnvironmentalDataSampler::EnvironmentalDataSampler(
+    const EnvironmentalData &_data, const std::vector<std::string> &_columns)
+  : dataPtr(new EnvironmentalDataSamplerPrivate)
+{
+  this->dataPtr->columns.resize(_columns.size());
+  for (std::size_t i = 0; i < _columns.size(); ++i)
+  {
+    if (_columns[i].empty())
+      continue;
+
+    if (!_data.frame.Has(_columns[i]))
+    {
+      gzerr << "No '" << _columns[i] << "' data found "
+            << "in the environment" << std::endl;
+      this->dataPtr->valid = false;
+      continue;
+    }
+
+    SamplerColumn &column = this->dataPtr->columns[i];
+    column.grid = &_data.frame[_columns[i]];
+    column.session = column.grid->CreateSession();
+  }
+}
+
+//////////////////////////////////////////////////
+EnvironmentalDataSampler::EnvironmentalDataSampler(
+    EnvironmentalDataSampler &&_other) noexcept = default;
+
+//////////////////////////////////////////////////
+EnvironmentalDataSampler &EnvironmentalDataSampler::operator=(
+    EnvironmentalDataSampler &&_other) noexcept = default;
+
+//////////////////////////////////////////////////
+EnvironmentalDataSampler::~EnvironmentalDataSampler() = default;
+
+//////////////////////////////////////////////////
+bool EnvironmentalDataSampler::Valid() const
+{
+  return this->dataPtr->valid;
+}
+
+//////////////////////////////////////////////////
+std::size_t EnvironmentalDataSampler::ColumnCount() const
+{
+  return this->dataPtr->columns.size();
+}
+
+//////////////////////////////////////////////////
+bool EnvironmentalDataSampler::HasData(std::size_t _column) const
+{
+  return _column < this->dataPtr->columns.size() &&
+         this->dataPtr->columns[_column].grid != nullptr;
+}
+
+//////////////////////////////////////////////////
+void EnvironmentalDataSampler::SetPositionTolerance(double _tolerance)
+{
+  this->dataPtr->tolerance = _tolerance > 0.0 ? _tolerance : 0.0;
+  for (SamplerColumn &column : this->dataPtr->columns)
+    column.cached = false;
+}
+
+//////////////////////////////////////////////////
+double EnvironmentalDataSampler::PositionTolerance() const
+{
+  return this->dataPtr->tolerance;
+}
+
+//////////////////////////////////////////////////
+void EnvironmentalDataSampler::StepTo(
+    const std::chrono::steady_clock::duration &_now)
+{
+  const double now = std::chrono::duration<double>(_now).count();
+  if (this->dataPtr->time && *this->dataPtr->time == now)
+    return;
+  this->dataPtr->time = now;
+
+  for (SamplerColumn &column : this->dataPtr->columns)
+  {
+    if (!column.grid || !column.session)
+      continue;
+    column.session = column.grid->StepTo(column.session.value(), now);
+    column.cached = false;
+  }
+}
+
+//////////////////////////////////////////////////
+std::optional<double> EnvironmentalDataSampler::LookUp(
+    std::size_t _column, const math::Vector3d &_pos)
+{
+  if (_column >= this->dataPtr->columns.size())
+    return std::nullopt;
+  return this->dataPtr->Sample(this->dataPtr->columns[_column], _pos);
+}
+
+//////////////////////////////////////////////////
+void EnvironmentalDataSampler::LookUp(std::size_t _column,
+    const std::vector<math::Vector3d> &_positions,
+    std::vector<std::optional<double>> &_values)
+{
+  _values.assign(_positions.size(), std::nullopt);
+  if (_column >= this->dataPtr->columns.size())
+    return;
+
+  SamplerColumn &column = this->dataPtr->columns[_column];
+  for (std::size_t i = 0; i < _positions.size(); ++i)
+    _values[i] = this->dataPtr->Sample(column, _positions[i]);
+}
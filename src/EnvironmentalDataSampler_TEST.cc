@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <gz/math/TimeVaryingVolumetricGrid.hh>
+
+#include "gz/sensors/EnvironmentalDataSampler.hh"
+
+using namespace gz;
+using namespace sensors;
+using namespace std::chrono_literals;
+
+/// \brief Environmental data with a "x" column equal to the x coordinate
+/// and a "t" column equal to the time, over a unit cube and 10 seconds.
+std::shared_ptr<EnvironmentalData> MakeData()
+{
+  math::InMemoryTimeVaryingVolumetricGridFactory<double, double> xFactory;
+  math::InMemoryTimeVaryingVolumetricGridFactory<double, double> tFactory;
+  for (double t : {0.0, 10.0})
+  {
+    for (double x : {0.0, 1.0})
+    {
+      for (double y : {0.0, 1.0})
+      {
+        for (double z : {0.0, 1.0})
+        {
+          xFactory.AddPoint(t, math::Vector3d(x, y, z), x);
+          tFactory.AddPoint(t, math::Vector3d(x, y, z), t);
+        }
+      }
+    }
+  }
+  EnvironmentalData::FrameT frame;
+  frame["x"] = xFactory.Build();
+  frame["t"] = tFactory.Build();
+  return EnvironmentalData::MakeShared(
+      std::move(frame), math::SphericalCoordinates::GLOBAL);
+}
+
+/////////////////////////////////////////////////
+TEST(EnvironmentalDataSampler_TEST, Columns)
+{
+  EnvironmentalDataSampler empty;
+  EXPECT_TRUE(empty.Valid());
+  EXPECT_EQ(0u, empty.ColumnCount());
+  EXPECT_FALSE(empty.LookUp(0, math::Vector3d::Zero).has_value());
+
+  auto data = MakeData();
+  EnvironmentalDataSampler sampler(*data, {"t", "", "x"});
+  EXPECT_TRUE(sampler.Valid());
+  EXPECT_EQ(3u, sampler.ColumnCount());
+  EXPECT_TRUE(sampler.HasData(0));
+  EXPECT_FALSE(sampler.HasData(1));
+  EXPECT_TRUE(sampler.HasData(2));
+  EXPECT_FALSE(sampler.HasData(3));
+
+  const math::Vector3d pos(0.25, 0.5, 0.5);
+  auto x = sampler.LookUp(2, pos);
+  ASSERT_TRUE(x.has_value());
+  EXPECT_NEAR(0.25, *x, 1e-9);
+  EXPECT_FALSE(sampler.LookUp(1, pos).has_value());
+  EXPECT_FALSE(sampler.LookUp(3, pos).has_value());
+
+  // Out of the grid
+  EXPECT_FALSE(sampler.LookUp(2, math::Vector3d(5, 5, 5)).has_value());
+
+  EnvironmentalDataSampler missing(*data, {"x", "y"});
+  EXPECT_FALSE(missing.Valid());
+  EXPECT_TRUE(missing.HasData(0));
+  EXPECT_FALSE(missing.HasData(1));
+}
+
+/////////////////////////////////////////////////
+TEST(EnvironmentalDataSampler_TEST, StepTo)
+{
+  auto data = MakeData();
+  EnvironmentalDataSampler sampler(*data, {"t"});
+  const math::Vector3d pos(0.5, 0.5, 0.5);
+
+  sampler.StepTo(0s);
+  auto t = sampler.LookUp(0, pos);
+  ASSERT_TRUE(t.has_value());
+  EXPECT_NEAR(0.0, *t, 1e-9);
+
+  // The same position is sampled again once the time changes
+  sampler.StepTo(5s);
+  t = sampler.LookUp(0, pos);
+  ASSERT_TRUE(t.has_value());
+  EXPECT_NEAR(5.0, *t, 1e-9);
+
+  sampler.StepTo(5s);
+  t = sampler.LookUp(0, pos);
+  ASSERT_TRUE(t.has_value());
+  EXPECT_NEAR(5.0, *t, 1e-9);
+}
+
+/////////////////////////////////////////////////
+TEST(EnvironmentalDataSampler_TEST, PositionTolerance)
+{
+  auto data = MakeData();
+  EnvironmentalDataSampler sampler(*data, {"x"});
+  EXPECT_DOUBLE_EQ(0.0, sampler.PositionTolerance());
+
+  auto x = sampler.LookUp(0, math::Vector3d(0.5, 0.5, 0.5));
+  ASSERT_TRUE(x.has_value());
+  EXPECT_NEAR(0.5, *x, 1e-9);
+
+  // Without tolerance, any other position is sampled
+  x = sampler.LookUp(0, math::Vector3d(0.51, 0.5, 0.5));
+  ASSERT_TRUE(x.has_value());
+  EXPECT_NEAR(0.51, *x, 1e-9);
+
+  // Positions within the tolerance reuse the last sample
+  sampler.SetPositionTolerance(0.1);
+  EXPECT_DOUBLE_EQ(0.1, sampler.PositionTolerance());
+  x = sampler.LookUp(0, math::Vector3d(0.5, 0.5, 0.5));
+  ASSERT_TRUE(x.has_value());
+  EXPECT_NEAR(0.5, *x, 1e-9);
+  x = sampler.LookUp(0, math::Vector3d(0.55, 0.5, 0.5));
+  ASSERT_TRUE(x.has_value());
+  EXPECT_NEAR(0.5, *x, 1e-9);
+  x = sampler.LookUp(0, math::Vector3d(0.75, 0.5, 0.5));
+  ASSERT_TRUE(x.has_value());
+  EXPECT_NEAR(0.75, *x, 1e-9);
+
+  sampler.SetPositionTolerance(-1.0);
+  EXPECT_DOUBLE_EQ(0.0, sampler.PositionTolerance());
+}
+
+/////////////////////////////////////////////////
+TEST(EnvironmentalDataSampler_TEST, Batch)
+{
+  auto data = MakeData();
+  EnvironmentalDataSampler sampler(*data, {"x", ""});
+
+  const std::vector<math::Vector3d> positions{
+      {0.1, 0.5, 0.5}, {0.1, 0.5, 0.5}, {0.9, 0.2, 0.7}, {2.0, 0.5, 0.5}};
+  std::vector<std::optional<double>> values{1.0};
+  sampler.LookUp(0, positions, values);
+  ASSERT_EQ(positions.size(), values.size());
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    ASSERT_TRUE(values[i].has_value());
+    EXPECT_NEAR(positions[i].X(), *values[i], 1e-9);
+  }
+  EXPECT_FALSE(values[3].has_value());
+
+  sampler.LookUp(1, positions, values);
+  ASSERT_EQ(positions.size(), values.size());
+  for (const auto &value : values)
+    EXPECT_FALSE(value.has_value());
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "gz/sensors/FlickerNoiseModel.hh"
+#include "gz/sensors/SensorState.hh"
+
+#include "GaussMarkovProcess.hh"
+#include "PhiloxRandom.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+  /// \brief Number of processes in the filter bank.
+  constexpr std::size_t kPoleCount = 8u;
+
+  /// \brief Ratio between the correlation times of consecutive processes.
+  /// Processes with log-spaced correlation times and equal variance sum to
+  /// a 1/f spectrum over the range they cover.
+  constexpr double kPoleRatio = 4.0;
+}
+
+class gz::sensors::FlickerNoiseModelPrivate
+{
+  /// \brief Offset added to the noise.
+  public: double mean = 0.0;
+
+  /// \brief Total standard deviation of the noise.
+  public: double stdDev = 0.0;
+
+  /// \brief Longest correlation time of the filter bank.
+  public: double correlationTime = 0.0;
+
+  /// \brief The filter bank.
+  public: std::array<GaussMarkovProcess, kPoleCount> poles;
+
+  /// \brief Random stream of this model.
+  public: PhiloxRandom rng{PhiloxRandom::DefaultSeed()};
+
+  /// \brief State of the filter bank used by ApplyImpl.
+  public: std::array<double, kPoleCount> state{};
+
+  /// \brief True once state has been sampled.
+  public: bool hasState = false;
+
+  /// \brief State of the filter bank of each value passed to ApplyBatch,
+  /// kPoleCount consecutive entries per value.
+  public: std::vector<double> states;
+
+  /// \brief Forget the state of all filter banks.
+  public: void Reset()
+  {
+    this->hasState = false;
+    this->states.clear();
+  }
+
+  /// \brief Set the time step of all processes.
+  /// \param[in] _dt Time step.
+  public: void SetTimeStep(double _dt)
+  {
+    for (auto &pole : this->poles)
+      pole.SetTimeStep(_dt);
+  }
+
+  /// \brief Advance a filter bank, or sample its initial state.
+  /// \param[in,out] _state First of kPoleCount states.
+  /// \param[in] _initial True to sample the initial state.
+  /// \return Sum of the states.
+  public: double Step(double *_state, bool _initial)
+  {
+    double sum = 0.0;
+    for (std::size_t k = 0u; k < kPoleCount; ++k)
+    {
+      _state[k] = _initial ? this->poles[k].Initial(this->rng) :
+          this->poles[k].Step(_state[k], this->rng);
+      sum += _state[k];
+    }
+    return sum;
+  }
+
+  /// \brief Apply noise to a strided buffer and clamp the finite results.
+  /// \param[in,out] _data First value.
+  /// \param[in] _count Number of values.
+  /// \param[in] _stride Distance between consecutive values.
+  /// \param[in] _dt Time step.
+  /// \param[in] _min Lower clamping bound.
+  /// \param[in] _max Upper clamping bound.
+  public: template <typename T>
+          void ApplyBatch(T *_data, std::size_t _count, std::size_t _stride,
+              double _dt, double _min, double _max);
+};
+
+//////////////////////////////////////////////////
+template <typename T>
+void FlickerNoiseModelPrivate::ApplyBatch(T *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  this->SetTimeStep(_dt);
+  const bool initial = this->states.size() != _count * kPoleCount;
+  if (initial)
+    this->states.resize(_count * kPoleCount);
+
+  for (std::size_t i = 0u; i < _count; ++i)
+  {
+    const double noise = this->Step(&this->states[i * kPoleCount], initial);
+    double out = static_cast<double>(_data[i * _stride]) + this->mean +
+        noise;
+    if (std::isfinite(out))
+      out = std::min(std::max(out, _min), _max);
+    _data[i * _stride] = static_cast<T>(out);
+  }
+}
+
+//////////////////////////////////////////////////
+FlickerNoiseModel::FlickerNoiseModel()
+  : Noise(NoiseType::FLICKER),
+    dataPtr(std::make_unique<FlickerNoiseModelPrivate>())
+{
+}
+
+//////////////////////////////////////////////////
+FlickerNoiseModel::~FlickerNoiseModel() = default;
+
+//////////////////////////////////////////////////
+void FlickerNoiseModel::Load(const sdf::Noise &_sdf)
+{
+  Noise::Load(_sdf);
+  this->dataPtr->mean = _sdf.Mean();
+  this->dataPtr->stdDev = _sdf.StdDev();
+  this->dataPtr->correlationTime = _sdf.DynamicBiasCorrelationTime();
+
+  const double poleStdDev =
+      this->dataPtr->stdDev / std::sqrt(static_cast<double>(kPoleCount));
+  double tau = this->dataPtr->correlationTime;
+  for (auto &pole : this->dataPtr->poles)
+  {
+    pole.Set(poleStdDev, tau);
+    tau /= kPoleRatio;
+  }
+  this->dataPtr->Reset();
+}
+
+//////////////////////////////////////////////////
+double FlickerNoiseModel::ApplyImpl(double _in, double _dt)
+{
+  this->dataPtr->SetTimeStep(_dt);
+  const double noise = this->dataPtr->Step(this->dataPtr->state.data(),
+      !this->dataPtr->hasState);
+  this->dataPtr->hasState = true;
+  return _in + this->dataPtr->mean + noise;
+}
+
+//////////////////////////////////////////////////
+void FlickerNoiseModel::ApplyBatchImpl(double *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  this->dataPtr->ApplyBatch(_data, _count, _stride, _dt, _min, _max);
+}
+
+//////////////////////////////////////////////////
+void FlickerNoiseModel::ApplyBatchImpl(float *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  this->dataPtr->ApplyBatch(_data, _count, _stride, _dt, _min, _max);
+}
+
+//////////////////////////////////////////////////
+void FlickerNoiseModel::SetSeed(uint64_t _seed)
+{
+  this->dataPtr->rng = PhiloxRandom(_seed);
+  this->dataPtr->Reset();
+}
+
+//////////////////////////////////////////////////
+void FlickerNoiseModel::SaveState(SensorState &_state) const
+{
+  _state.Write(this->dataPtr->rng);
+  _state.Write(this->dataPtr->state);
+  _state.Write(this->dataPtr->hasState);
+  _state.WriteVector(this->dataPtr->states);
+}
+
+//////////////////////////////////////////////////
+bool FlickerNoiseModel::RestoreState(SensorState &_state)
+{
+  return _state.Read(this->dataPtr->rng) &&
+      _state.Read(this->dataPtr->state) &&
+      _state.Read(this->dataPtr->hasState) &&
+      _state.ReadVector(this->dataPtr->states);
+}
+
+//////////////////////////////////////////////////
+void FlickerNoiseModel::Print(std::ostream &_out) const
+{
+  _out << "Flicker noise, mean[" << this->dataPtr->mean << "], "
+    << "stdDev[" << this->dataPtr->stdDev << "] "
+    << "correlationTime[" << this->dataPtr->correlationTime << "] "
+    << "poles[" << kPoleCount << "]";
+}
@@ -26,6 +26,11 @@
 #endif
 #include <gz/msgs/Utility.hh>
 
+#include <cstdint>
+#include <typeinfo>
+#include <vector>
+
+#include <gz/common/Event.hh>
 #include <gz/common/Profiler.hh>
 #include <gz/transport/Node.hh>
 
@@ -33,22 +38,63 @@
 #include "gz/sensors/Noise.hh"
 #include "gz/sensors/SensorFactory.hh"
 #include "gz/sensors/SensorTypes.hh"
+#include "InputInterpolation.hh"
+#include "NoisePipeline.hh"
+#include "SeqLock.hh"
+#include "SignalFilter.hh"
 
 using namespace gz;
 using namespace sensors;
 
+/// \brief Trivially copyable copy of a ForceTorqueSample.
+struct ForceTorqueSampleData
+{
+  /// \brief Time of the update in nanoseconds.
+  int64_t time;
+
+  /// \brief Force as x, y, z.
+  double force[3];
+
+  /// \brief Torque as x, y, z.
+  double torque[3];
+};
+
 /// \brief Private data for ForceTorqueSensor
 class gz::sensors::ForceTorqueSensorPrivate
 {
+  /// \brief Compute measurementTransform from the measure frame, the
+  /// measure direction and the rotations of the parent and child.
+  public: void UpdateMeasurementTransform();
+
+  /// \brief Apply noise to a measured wrench, then fill and publish a
+  /// message.
+  /// \param[in] _sensor The sensor that owns this data.
+  /// \param[in] _now The current time.
+  /// \param[in] _force Measured force.
+  /// \param[in] _torque Measured torque.
+  public: void GenerateData(ForceTorqueSensor &_sensor,
+              const std::chrono::steady_clock::duration &_now,
+              math::Vector3d _force, math::Vector3d _torque);
+
   /// \brief node to create publisher
   public: transport::Node node;
 
   /// \brief publisher to publish Wrench messages.
   public: transport::Node::Publisher pub;
 
+  /// \brief Message reused by every update.
+  public: msgs::Wrench msg;
+
   /// \brief true if Load() has been called and was successful
   public: bool initialized = false;
 
+  /// \brief Event triggered with the output of each update.
+  public: gz::common::EventT<void(const ForceTorqueSample &)> sampleEvent;
+
+  /// \brief Output of the last update, read by LatestSample.
+  public: SeqLock<ForceTorqueSampleData> latest{
+      ForceTorqueSampleData{0, {0, 0, 0}, {0, 0, 0}}};
+
   /// \brief Noise free force as set by SetForce
   public: gz::math::Vector3d force{0, 0, 0};
 
@@ -77,6 +123,18 @@ class gz::sensors::ForceTorqueSensorPrivate
   public: gz::math::Matrix3d rotationChildInSensor{
               gz::math::Matrix3d::Identity};
 
+  /// \brief Matrix that transforms the force and torque set on the sensor
+  /// to the measured ones, including the sign of the measure direction.
+  /// Zero if the measure frame isn't valid.
+  public: gz::math::Matrix3d measurementTransform{
+              gz::math::Matrix3d::Identity};
+
+  /// \brief True if the measure frame is one of the supported frames.
+  public: bool validMeasureFrame = true;
+
+  /// \brief True if any channel has a noise model.
+  public: bool hasNoise = false;
+
   /// \brief Flag for if time has been initialized
   public: bool timeInitialized = false;
 
@@ -85,13 +143,122 @@ class gz::sensors::ForceTorqueSensorPrivate
     {std::chrono::steady_clock::duration::zero()};
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief Noise of the force and torque axes, resolved when the sensor
+  /// loads.
+  public: NoisePipeline<6> noisePipeline;
+
+  /// \brief Filter of the force and torque axes, after noise.
+  public: SignalFilter<6> filter;
 };
 
+//////////////////////////////////////////////////
+void ForceTorqueSensorPrivate::UpdateMeasurementTransform()
+{
+  this->validMeasureFrame = true;
+  if (this->measureFrame == sdf::ForceTorqueFrame::PARENT)
+  {
+    this->measurementTransform = this->rotationParentInSensor.Inverse();
+  }
+  else if (this->measureFrame == sdf::ForceTorqueFrame::CHILD)
+  {
+    this->measurementTransform = this->rotationChildInSensor.Inverse();
+  }
+  else if (this->measureFrame == sdf::ForceTorqueFrame::SENSOR)
+  {
+    this->measurementTransform = math::Matrix3d::Identity;
+  }
+  else
+  {
+    this->validMeasureFrame = false;
+    this->measurementTransform = math::Matrix3d::Zero;
+  }
+
+  if (this->measureDirection ==
+      sdf::ForceTorqueMeasureDirection::CHILD_TO_PARENT)
+  {
+    this->measurementTransform = this->measurementTransform * -1.0;
+  }
+}
+
+//////////////////////////////////////////////////
+void ForceTorqueSensorPrivate::GenerateData(ForceTorqueSensor &_sensor,
+    const std::chrono::steady_clock::duration &_now,
+    math::Vector3d _force, math::Vector3d _torque)
+{
+  if (!this->validMeasureFrame)
+    gzerr << "measureFrame must be PARENT_LINK, CHILD_LINK or SENSOR\n";
+
+  if (this->hasNoise)
+  {
+    // If time has gone backwards, reinitialize.
+    if (_now < this->prevStep)
+    {
+      this->timeInitialized = false;
+    }
+
+    // Only compute dt if time is initialized and increasing.
+    double dt;
+    if (this->timeInitialized)
+    {
+      auto delay = std::chrono::duration_cast<std::chrono::duration<float>>(
+          _now - this->prevStep);
+      dt = delay.count();
+    }
+    else
+    {
+      dt = 0.0;
+    }
+
+    this->noisePipeline.Apply({&_force.X(), &_force.Y(), &_force.Z(),
+        &_torque.X(), &_torque.Y(), &_torque.Z()}, dt);
+  }
+
+  if (!this->filter.Apply({&_force.X(), &_force.Y(), &_force.Z(),
+      &_torque.X(), &_torque.Y(), &_torque.Z()}))
+  {
+    // Dropped by decimation
+    this->prevStep = _now;
+    this->timeInitialized = true;
+    return;
+  }
+
+  this->latest.Store({
+      std::chrono::duration_cast<std::chrono::nanoseconds>(_now).count(),
+      {_force.X(), _force.Y(), _force.Z()},
+      {_torque.X(), _torque.Y(), _torque.Z()}});
+
+  if (this->sampleEvent.ConnectionCount() > 0)
+  {
+    ForceTorqueSample sample;
+    sample.time = _now;
+    sample.force = _force;
+    sample.torque = _torque;
+    this->sampleEvent(sample);
+  }
+
+  // The message is only built if someone receives it
+  if (this->pub.HasConnections())
+  {
+    auto &msg = this->msg;
+    _sensor.FillHeader(msg.mutable_header(), _now);
+
+    msgs::Set(msg.mutable_force(), _force);
+    msgs::Set(msg.mutable_torque(), _torque);
+
+    // publish
+    _sensor.Publish(this->pub, msg);
+  }
+  this->prevStep = _now;
+  this->timeInitialized = true;
+}
+
 //////////////////////////////////////////////////
 ForceTorqueSensor::ForceTorqueSensor()
   : dataPtr(std::make_unique<ForceTorqueSensorPrivate>())
 {
+  this->SetPriority(SensorPriority::CONTROL);
 }
 
 //////////////////////////////////////////////////
@@ -130,10 +297,8 @@ bool ForceTorqueSensor::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/forcetorque");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<gz::msgs::Wrench>(this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<gz::msgs::Wrench>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic[" << this->Topic() << "].\n";
     return false;
@@ -156,6 +321,17 @@ bool ForceTorqueSensor::Load(const sdf::Sensor &_sdf)
     }
   }
 
+  this->dataPtr->hasNoise = false;
+  for (const auto &noise : this->dataPtr->noises)
+    this->dataPtr->hasNoise = this->dataPtr->hasNoise || noise != nullptr;
+  this->RegisterNoise(this->dataPtr->noises);
+  const NoiseTable &table = this->dataPtr->noises;
+  this->dataPtr->noisePipeline.Load({table[FORCE_X_NOISE_N],
+      table[FORCE_Y_NOISE_N], table[FORCE_Z_NOISE_N],
+      table[TORQUE_X_NOISE_N_M], table[TORQUE_Y_NOISE_N_M],
+      table[TORQUE_Z_NOISE_N_M]});
+  this->dataPtr->UpdateMeasurementTransform();
+
   this->dataPtr->initialized = true;
   return true;
 }
@@ -178,90 +354,49 @@ bool ForceTorqueSensor::Update(const std::chrono::steady_clock::duration &_now)
     return false;
   }
 
-  // If time has gone backwards, reinitialize.
-  if (_now < this->dataPtr->prevStep)
-  {
-    this->dataPtr->timeInitialized = false;
-  }
-
-  // Only compute dt if time is initialized and increasing.
-  double dt;
-  if (this->dataPtr->timeInitialized)
-  {
-    auto delay = std::chrono::duration_cast<std::chrono::duration<float>>(
-        _now - this->dataPtr->prevStep);
-    dt = delay.count();
-  }
-  else
-  {
-    dt = 0.0;
-  }
   // Get the force and torque in the appropriate frame.
-  gz::math::Vector3d measuredForce;
-  gz::math::Vector3d measuredTorque;
+  this->dataPtr->GenerateData(*this, _now,
+      this->dataPtr->measurementTransform * this->dataPtr->force,
+      this->dataPtr->measurementTransform * this->dataPtr->torque);
+  return true;
+}
 
-  if (this->dataPtr->measureFrame == sdf::ForceTorqueFrame::PARENT)
-  {
-    measuredForce =
-        this->dataPtr->rotationParentInSensor.Inverse() * this->dataPtr->force;
-    measuredTorque =
-        this->dataPtr->rotationParentInSensor.Inverse() * this->dataPtr->torque;
-  }
-  else if (this->dataPtr->measureFrame == sdf::ForceTorqueFrame::CHILD)
-  {
-    measuredForce =
-        this->dataPtr->rotationChildInSensor.Inverse() * this->dataPtr->force;
-    measuredTorque =
-        this->dataPtr->rotationChildInSensor.Inverse() * this->dataPtr->torque;
-  }
-  else if (this->dataPtr->measureFrame == sdf::ForceTorqueFrame::SENSOR)
+//////////////////////////////////////////////////
+void ForceTorqueSensor::UpdateBatch(const std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("ForceTorqueSensor::UpdateBatch");
+  // Subclasses may override Update, in which case they must be updated one
+  // by one.
+  if (typeid(*this) != typeid(ForceTorqueSensor))
   {
-    measuredForce = this->dataPtr->force;
-    measuredTorque = this->dataPtr->torque;
-  }
-  else
-  {
-    gzerr << "measureFrame must be PARENT_LINK, CHILD_LINK or SENSOR\n";
+    Sensor::UpdateBatch(_sensors, _now);
+    return;
   }
 
-  if (this->dataPtr->measureDirection ==
-      sdf::ForceTorqueMeasureDirection::CHILD_TO_PARENT)
+  // Transform the wrenches of all sensors in one pass, then apply noise
+  // and publish.
+  thread_local std::vector<math::Vector3d> forces;
+  thread_local std::vector<math::Vector3d> torques;
+  forces.resize(_sensors.size());
+  torques.resize(_sensors.size());
+  for (std::size_t i = 0; i < _sensors.size(); ++i)
   {
-    measuredForce *= -1;
-    measuredTorque *= -1;
+    const auto &d = *static_cast<ForceTorqueSensor *>(_sensors[i])->dataPtr;
+    forces[i] = d.measurementTransform * d.force;
+    torques[i] = d.measurementTransform * d.torque;
   }
 
-  // Convenience method to apply noise to a channel, if present.
-  auto applyNoise = [&](SensorNoiseType noiseType, double &value)
+  for (std::size_t i = 0; i < _sensors.size(); ++i)
   {
-    if (this->dataPtr->noises.find(noiseType) != this->dataPtr->noises.end())
+    auto ft = static_cast<ForceTorqueSensor *>(_sensors[i]);
+    if (!ft->dataPtr->initialized)
     {
-      value = this->dataPtr->noises[noiseType]->Apply(value, dt);
+      gzerr << "Not initialized, update ignored.\n";
+      continue;
     }
-  };
-
-  applyNoise(FORCE_X_NOISE_N, measuredForce.X());
-  applyNoise(FORCE_Y_NOISE_N, measuredForce.Y());
-  applyNoise(FORCE_Z_NOISE_N, measuredForce.Z());
-  applyNoise(TORQUE_X_NOISE_N_M, measuredTorque.X());
-  applyNoise(TORQUE_Y_NOISE_N_M, measuredTorque.Y());
-  applyNoise(TORQUE_Z_NOISE_N_M, measuredTorque.Z());
-
-  msgs::Wrench msg;
-  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-  auto frame = msg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->FrameId());
-
-  msgs::Set(msg.mutable_force(), measuredForce);
-  msgs::Set(msg.mutable_torque(), measuredTorque);
-
-  // publish
-  this->AddSequence(msg.mutable_header());
-  this->dataPtr->pub.Publish(msg);
-  this->dataPtr->prevStep = _now;
-  this->dataPtr->timeInitialized = true;
-  return true;
+    ft->dataPtr->GenerateData(*ft, _now, forces[i], torques[i]);
+  }
 }
 
 //////////////////////////////////////////////////
@@ -288,6 +423,65 @@ void ForceTorqueSensor::SetTorque(const math::Vector3d &_torque)
   this->dataPtr->torque = _torque;
 }
 
+//////////////////////////////////////////////////
+bool ForceTorqueSensor::SetOutputFilter(const SignalFilterOptions &_options)
+{
+  return this->dataPtr->filter.Configure(_options, this->UpdateRate(),
+      this->Name());
+}
+
+//////////////////////////////////////////////////
+SignalFilterOptions ForceTorqueSensor::OutputFilter() const
+{
+  return this->dataPtr->filter.Options();
+}
+
+//////////////////////////////////////////////////
+void ForceTorqueSensor::SaveInputs(SensorState &_state) const
+{
+  Sensor::SaveInputs(_state);
+  _state.Write(this->dataPtr->force);
+  _state.Write(this->dataPtr->torque);
+}
+
+//////////////////////////////////////////////////
+bool ForceTorqueSensor::InterpolateInputs(SensorState &_from,
+    SensorState &_to, double _alpha)
+{
+  if (!Sensor::InterpolateInputs(_from, _to, _alpha))
+    return false;
+
+  math::Vector3d fromForce, toForce, fromTorque, toTorque;
+  if (!_from.Read(fromForce) || !_from.Read(fromTorque) ||
+      !_to.Read(toForce) || !_to.Read(toTorque))
+  {
+    return false;
+  }
+  this->dataPtr->force = InterpolateInput(fromForce, toForce, _alpha);
+  this->dataPtr->torque = InterpolateInput(fromTorque, toTorque, _alpha);
+  return true;
+}
+
+//////////////////////////////////////////////////
+gz::common::ConnectionPtr ForceTorqueSensor::ConnectSampleCallback(
+    std::function<void(const ForceTorqueSample &)> _callback)
+{
+  return this->dataPtr->sampleEvent.Connect(_callback);
+}
+
+//////////////////////////////////////////////////
+ForceTorqueSample ForceTorqueSensor::LatestSample() const
+{
+  const ForceTorqueSampleData data = this->dataPtr->latest.Load();
+  ForceTorqueSample sample;
+  sample.time = std::chrono::duration_cast<
+      std::chrono::steady_clock::duration>(
+      std::chrono::nanoseconds(data.time));
+  sample.force.Set(data.force[0], data.force[1], data.force[2]);
+  sample.torque.Set(data.torque[0], data.torque[1], data.torque[2]);
+  return sample;
+}
+
 //////////////////////////////////////////////////
 math::Quaterniond ForceTorqueSensor::RotationParentInSensor() const
 {
@@ -299,6 +493,7 @@ void ForceTorqueSensor::SetRotationParentInSensor(
     const math::Quaterniond &_rotParentInSensor)
 {
   this->dataPtr->rotationParentInSensor = _rotParentInSensor;
+  this->dataPtr->UpdateMeasurementTransform();
 }
 
 //////////////////////////////////////////////////
@@ -306,6 +501,7 @@ void ForceTorqueSensor::SetRotationChildInSensor(
     const math::Quaterniond &_rotChildInSensor)
 {
   this->dataPtr->rotationChildInSensor = _rotChildInSensor;
+  this->dataPtr->UpdateMeasurementTransform();
 }
 
 //////////////////////////////////////////////////
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_FRAMEACCUMULATOR_HH_
+#define GZ_SENSORS_FRAMEACCUMULATOR_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Get the number of sub-frames needed to render the motion
+    /// blur of a frame, so that consecutive sub-frames are about one pixel
+    /// apart.
+    /// \param[in] _blurPixels Distance the image moves during the
+    /// exposure, in pixels.
+    /// \param[in] _maxSubFrames Largest number of sub-frames.
+    /// \return Number of sub-frames, at least 1.
+    inline unsigned int MotionBlurSubFrames(double _blurPixels,
+        unsigned int _maxSubFrames)
+    {
+      if (!(_blurPixels > 1.0) || _maxSubFrames <= 1u)
+        return 1u;
+      const double frames = std::ceil(_blurPixels);
+      if (frames >= static_cast<double>(_maxSubFrames))
+        return _maxSubFrames;
+      return static_cast<unsigned int>(frames);
+    }
+
+    /// \brief Sums the channels of several frames to average them.
+    class FrameAccumulator
+    {
+      /// \brief Start a new accumulation.
+      /// \param[in] _count Number of channels of a frame.
+      public: void Reset(std::size_t _count)
+      {
+        this->sums.assign(_count, 0u);
+        this->frames = 0u;
+      }
+
+      /// \brief Add a frame.
+      /// \param[in] _data Channels of the frame, as many as given to
+      /// Reset().
+      /// \tparam T Channel type, 8 or 16 bit unsigned integer.
+      public: template <typename T>
+              void Add(const T *_data)
+      {
+        for (std::size_t i = 0u; i < this->sums.size(); ++i)
+          this->sums[i] += _data[i];
+        ++this->frames;
+      }
+
+      /// \brief Write the rounded average of the frames added since the
+      /// last Reset().
+      /// \param[out] _data Channels of the average. Untouched if no frame
+      /// was added.
+      /// \tparam T Channel type, 8 or 16 bit unsigned integer.
+      public: template <typename T>
+              void Average(T *_data) const
+      {
+        if (this->frames == 0u)
+          return;
+        const uint32_t half = this->frames / 2u;
+        for (std::size_t i = 0u; i < this->sums.size(); ++i)
+          _data[i] = static_cast<T>((this->sums[i] + half) / this->frames);
+      }
+
+      /// \brief Get the number of frames added since the last Reset().
+      /// \return Number of frames.
+      public: unsigned int Frames() const
+      {
+        return this->frames;
+      }
+
+      /// \brief Get the memory allocated for the sums.
+      /// \return Bytes allocated.
+      public: std::size_t MemorySize() const
+      {
+        return this->sums.capacity() * sizeof(uint32_t);
+      }
+
+      /// \brief Sum of each channel.
+      private: std::vector<uint32_t> sums;
+
+      /// \brief Number of frames added.
+      private: unsigned int frames{0u};
+    };
+    }
+  }
+}
+
+#endif
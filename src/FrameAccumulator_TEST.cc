@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "FrameAccumulator.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(FrameAccumulator, SubFrames)
+{
+  EXPECT_EQ(1u, MotionBlurSubFrames(0.0, 8u));
+  EXPECT_EQ(1u, MotionBlurSubFrames(0.9, 8u));
+  EXPECT_EQ(1u, MotionBlurSubFrames(-3.0, 8u));
+  EXPECT_EQ(2u, MotionBlurSubFrames(1.5, 8u));
+  EXPECT_EQ(5u, MotionBlurSubFrames(5.0, 8u));
+  EXPECT_EQ(8u, MotionBlurSubFrames(100.0, 8u));
+  EXPECT_EQ(1u, MotionBlurSubFrames(100.0, 1u));
+  EXPECT_EQ(1u, MotionBlurSubFrames(100.0, 0u));
+}
+
+/////////////////////////////////////////////////
+TEST(FrameAccumulator, Average)
+{
+  FrameAccumulator accumulator;
+  accumulator.Reset(3u);
+  EXPECT_EQ(0u, accumulator.Frames());
+
+  std::vector<uint8_t> out{7u, 7u, 7u};
+  accumulator.Average(out.data());
+  EXPECT_EQ((std::vector<uint8_t>{7u, 7u, 7u}), out);
+
+  const std::vector<uint8_t> a{0u, 255u, 10u};
+  const std::vector<uint8_t> b{255u, 255u, 11u};
+  accumulator.Add(a.data());
+  accumulator.Add(b.data());
+  EXPECT_EQ(2u, accumulator.Frames());
+  accumulator.Average(out.data());
+  EXPECT_EQ((std::vector<uint8_t>{128u, 255u, 11u}), out);
+
+  // 16 bit channels
+  accumulator.Reset(2u);
+  const std::vector<uint16_t> c{65535u, 1000u};
+  const std::vector<uint16_t> d{65535u, 2000u};
+  const std::vector<uint16_t> e{65535u, 3001u};
+  accumulator.Add(c.data());
+  accumulator.Add(d.data());
+  accumulator.Add(e.data());
+  std::vector<uint16_t> out16(2u);
+  accumulator.Average(out16.data());
+  EXPECT_EQ((std::vector<uint16_t>{65535u, 2000u}), out16);
+}
@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "gz/sensors/FrameRecorder.hh"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Alignment of the index and of the frames.
+constexpr uint64_t kAlignment = 64u;
+
+/// \brief Default number of bytes of frame data preallocated.
+constexpr uint64_t kDefaultDataSize = 64u * 1024u * 1024u;
+
+/// \brief Round a size up to kAlignment.
+/// \param[in] _size Size in bytes.
+/// \return Aligned size.
+uint64_t AlignSize(uint64_t _size)
+{
+  return (_size + kAlignment - 1u) / kAlignment * kAlignment;
+}
+}
+
+/// \brief Private data for FrameRecorder
+class gz::sensors::FrameRecorderPrivate
+{
+  /// \brief Map the first _size bytes of the file, unmapping any previous
+  /// mapping.
+  /// \param[in] _size Size of the file.
+  /// \return True on success.
+  public: bool Map(uint64_t _size);
+
+  /// \brief Get the header of the mapped file.
+  /// \return The header.
+  public: FrameRecordHeader *Header() const
+  {
+    return static_cast<FrameRecordHeader *>(this->address);
+  }
+
+  /// \brief Path of the file.
+  public: std::string path;
+
+  /// \brief File descriptor, -1 when closed.
+  public: int fd{-1};
+
+  /// \brief Start of the mapping.
+  public: void *address{nullptr};
+
+  /// \brief Size of the mapping and of the file.
+  public: uint64_t mapSize{0u};
+};
+
+/// \brief Private data for FrameRecordReader
+class gz::sensors::FrameRecordReaderPrivate
+{
+  /// \brief Get the header of the mapped file.
+  /// \return The header.
+  public: const FrameRecordHeader *Header() const
+  {
+    return static_cast<const FrameRecordHeader *>(this->address);
+  }
+
+  /// \brief Start of the mapping.
+  public: void *address{nullptr};
+
+  /// \brief Size of the mapping.
+  public: uint64_t mapSize{0u};
+
+  /// \brief Number of frames, read when the file was opened.
+  public: uint64_t frameCount{0u};
+};
+
+//////////////////////////////////////////////////
+bool FrameRecorderPrivate::Map(uint64_t _size)
+{
+#ifdef _WIN32
+  (void)_size;
+  return false;
+#else
+  if (this->address)
+    munmap(this->address, this->mapSize);
+  this->address = nullptr;
+  this->mapSize = 0u;
+
+  if (ftruncate(this->fd, static_cast<off_t>(_size)) != 0)
+  {
+    gzerr << "Unable to resize recording [" << this->path << "] to "
+          << _size << " bytes: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  void *addr = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED,
+      this->fd, 0);
+  if (addr == MAP_FAILED)
+  {
+    gzerr << "Unable to map recording [" << this->path << "] of "
+          << _size << " bytes: " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  this->address = addr;
+  this->mapSize = _size;
+  return true;
+#endif
+}
+
+//////////////////////////////////////////////////
+FrameRecorder::FrameRecorder()
+  : dataPtr(new FrameRecorderPrivate())
+{
+}
+
+//////////////////////////////////////////////////
+FrameRecorder::~FrameRecorder()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool FrameRecorder::Open(const std::string &_path, uint64_t _maxFrames,
+    uint64_t _dataSize)
+{
+  this->Close();
+#ifdef _WIN32
+  (void)_path;
+  (void)_maxFrames;
+  (void)_dataSize;
+  gzerr << "Frame recording is not supported on Windows.\n";
+  return false;
+#else
+  if (_maxFrames == 0u)
+  {
+    gzerr << "Unable to create recording [" << _path
+          << "]: the maximum number of frames must be positive.\n";
+    return false;
+  }
+
+  this->dataPtr->fd = open(_path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (this->dataPtr->fd < 0)
+  {
+    gzerr << "Unable to create recording [" << _path << "]: "
+          << std::strerror(errno) << std::endl;
+    return false;
+  }
+  this->dataPtr->path = _path;
+
+  const uint64_t indexOffset = AlignSize(sizeof(FrameRecordHeader));
+  const uint64_t dataOffset = AlignSize(
+      indexOffset + _maxFrames * sizeof(FrameRecordIndexEntry));
+  const uint64_t dataSize = _dataSize > 0u ? _dataSize : kDefaultDataSize;
+  if (!this->dataPtr->Map(dataOffset + AlignSize(dataSize)))
+  {
+    this->Close();
+    return false;
+  }
+
+  // The file is zero filled by ftruncate
+  auto *header = new (this->dataPtr->address) FrameRecordHeader{};
+  header->version = FrameRecordHeader::kVersion;
+  header->indexOffset = indexOffset;
+  header->indexCapacity = _maxFrames;
+  header->dataOffset = dataOffset;
+  header->dataSize = 0u;
+  header->frameCount.store(0u, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = FrameRecordHeader::kMagic;
+  return true;
+#endif
+}
+
+//////////////////////////////////////////////////
+void FrameRecorder::Close()
+{
+#ifndef _WIN32
+  if (this->dataPtr->fd < 0)
+    return;
+
+  uint64_t usedSize = 0u;
+  if (this->dataPtr->address)
+  {
+    const FrameRecordHeader *header = this->dataPtr->Header();
+    usedSize = header->dataOffset + header->dataSize;
+    msync(this->dataPtr->address, this->dataPtr->mapSize, MS_ASYNC);
+    munmap(this->dataPtr->address, this->dataPtr->mapSize);
+  }
+  // Trim the preallocated space that wasn't used
+  if (usedSize > 0u && ftruncate(this->dataPtr->fd,
+        static_cast<off_t>(usedSize)) != 0)
+  {
+    gzerr << "Unable to trim recording [" << this->dataPtr->path << "]: "
+          << std::strerror(errno) << std::endl;
+  }
+  close(this->dataPtr->fd);
+
+  this->dataPtr->fd = -1;
+  this->dataPtr->address = nullptr;
+  this->dataPtr->mapSize = 0u;
+  this->dataPtr->path.clear();
+#endif
+}
+
+//////////////////////////////////////////////////
+bool FrameRecorder::IsOpen() const
+{
+  return this->dataPtr->address != nullptr;
+}
+
+//////////////////////////////////////////////////
+std::string FrameRecorder::Path() const
+{
+  return this->dataPtr->path;
+}
+
+//////////////////////////////////////////////////
+bool FrameRecorder::Append(uint32_t _stream, const msgs::Image &_image,
+    const void *_data, std::size_t _size)
+{
+  GZ_PROFILE("FrameRecorder::Append");
+  if (!this->dataPtr->address)
+    return false;
+
+  FrameRecordHeader *header = this->dataPtr->Header();
+  const uint64_t count = header->frameCount.load(std::memory_order_relaxed);
+  if (count >= header->indexCapacity)
+    return false;
+
+  const uint64_t offset = header->dataOffset + header->dataSize;
+  const uint64_t end = offset + AlignSize(_size);
+  if (end > this->dataPtr->mapSize)
+  {
+    // Grow geometrically so appending stays amortized constant time
+    const uint64_t newSize = std::max(end, this->dataPtr->mapSize * 2u);
+    if (!this->dataPtr->Map(newSize))
+    {
+      // Keep what has been recorded so far
+      this->Close();
+      return false;
+    }
+    header = this->dataPtr->Header();
+  }
+
+  auto *bytes = static_cast<unsigned char *>(this->dataPtr->address);
+  std::memcpy(bytes + offset, _data, _size);
+
+  auto *entry = reinterpret_cast<FrameRecordIndexEntry *>(
+      bytes + header->indexOffset) + count;
+  entry->offset = offset;
+  entry->size = _size;
+  entry->sec = _image.header().stamp().sec();
+  entry->nsec = _image.header().stamp().nsec();
+  entry->stream = _stream;
+  entry->width = _image.width();
+  entry->height = _image.height();
+  entry->step = _image.step();
+  entry->pixelFormat = static_cast<uint32_t>(_image.pixel_format_type());
+
+  header->dataSize = end - header->dataOffset;
+  header->frameCount.store(count + 1u, std::memory_order_release);
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint64_t FrameRecorder::FrameCount() const
+{
+  if (!this->dataPtr->address)
+    return 0u;
+  return this->dataPtr->Header()->frameCount.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+FrameRecordReader::FrameRecordReader()
+  : dataPtr(new FrameRecordReaderPrivate())
+{
+}
+
+//////////////////////////////////////////////////
+FrameRecordReader::~FrameRecordReader()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool FrameRecordReader::Open(const std::string &_path)
+{
+  this->Close();
+#ifdef _WIN32
+  (void)_path;
+  gzerr << "Frame recording is not supported on Windows.\n";
+  return false;
+#else
+  int fd = open(_path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    gzerr << "Unable to open recording [" << _path << "]: "
+          << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  struct stat st;
+  void *addr = MAP_FAILED;
+  if (fstat(fd, &st) == 0 &&
+      static_cast<uint64_t>(st.st_size) >= sizeof(FrameRecordHeader))
+  {
+    addr = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ,
+        MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (addr == MAP_FAILED)
+  {
+    gzerr << "Unable to map recording [" << _path << "]\n";
+    return false;
+  }
+  this->dataPtr->address = addr;
+  this->dataPtr->mapSize = static_cast<uint64_t>(st.st_size);
+
+  const FrameRecordHeader *header = this->dataPtr->Header();
+  const uint64_t count = header->frameCount.load(std::memory_order_acquire);
+  if (header->magic != FrameRecordHeader::kMagic ||
+      header->version != FrameRecordHeader::kVersion ||
+      count > header->indexCapacity ||
+      header->indexOffset + header->indexCapacity *
+        sizeof(FrameRecordIndexEntry) > header->dataOffset ||
+      header->dataOffset + header->dataSize > this->dataPtr->mapSize)
+  {
+    gzerr << "File [" << _path << "] is not a valid recording.\n";
+    this->Close();
+    return false;
+  }
+  this->dataPtr->frameCount = count;
+  return true;
+#endif
+}
+
+//////////////////////////////////////////////////
+void FrameRecordReader::Close()
+{
+#ifndef _WIN32
+  if (this->dataPtr->address)
+    munmap(this->dataPtr->address, this->dataPtr->mapSize);
+#endif
+  this->dataPtr->address = nullptr;
+  this->dataPtr->mapSize = 0u;
+  this->dataPtr->frameCount = 0u;
+}
+
+//////////////////////////////////////////////////
+uint64_t FrameRecordReader::FrameCount() const
+{
+  return this->dataPtr->frameCount;
+}
+
+//////////////////////////////////////////////////
+const FrameRecordIndexEntry *FrameRecordReader::Entry(uint64_t _index) const
+{
+  if (_index >= this->dataPtr->frameCount)
+    return nullptr;
+  const auto *bytes = static_cast<const unsigned char *>(
+      this->dataPtr->address);
+  return reinterpret_cast<const FrameRecordIndexEntry *>(
+      bytes + this->dataPtr->Header()->indexOffset) + _index;
+}
+
+//////////////////////////////////////////////////
+const void *FrameRecordReader::Data(uint64_t _index) const
+{
+  const FrameRecordIndexEntry *entry = this->Entry(_index);
+  if (!entry || entry->offset + entry->size > this->dataPtr->mapSize)
+    return nullptr;
+  return static_cast<const unsigned char *>(this->dataPtr->address) +
+      entry->offset;
+}
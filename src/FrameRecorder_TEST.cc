@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Filesystem.hh>
+
+#include "gz/sensors/FrameRecorder.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Test FrameRecorder and FrameRecordReader
+class FrameRecorder_TEST : public ::testing::Test
+{
+  // Documentation inherited
+  protected: void SetUp() override
+  {
+    common::Console::SetVerbosity(4);
+    this->path = common::joinPaths(::testing::TempDir(),
+        "gz_sensors_frame_recorder.bin");
+    common::removeFile(this->path);
+  }
+
+  // Documentation inherited
+  protected: void TearDown() override
+  {
+    common::removeFile(this->path);
+  }
+
+  /// \brief Path of the recording.
+  protected: std::string path;
+};
+
+/// \brief Make the metadata of a frame.
+/// \param[in] _width Frame width.
+/// \param[in] _height Frame height.
+/// \param[in] _sec Stamp seconds.
+/// \return Image message without data.
+static msgs::Image MakeMeta(uint32_t _width, uint32_t _height, int64_t _sec)
+{
+  msgs::Image msg;
+  msg.set_width(_width);
+  msg.set_height(_height);
+  msg.set_step(_width * 3u);
+  msg.set_pixel_format_type(msgs::PixelFormatType::RGB_INT8);
+  msg.mutable_header()->mutable_stamp()->set_sec(_sec);
+  msg.mutable_header()->mutable_stamp()->set_nsec(500);
+  return msg;
+}
+
+//////////////////////////////////////////////////
+TEST_F(FrameRecorder_TEST, RecordAndReplay)
+{
+  std::vector<std::vector<unsigned char>> frames;
+  {
+    FrameRecorder recorder;
+    EXPECT_FALSE(recorder.IsOpen());
+    EXPECT_FALSE(recorder.Append(0u, MakeMeta(1u, 1u, 0), "abc", 3u));
+
+    // Small preallocation so the file has to grow
+    ASSERT_TRUE(recorder.Open(this->path, 8u, 100u));
+    EXPECT_TRUE(recorder.IsOpen());
+    EXPECT_EQ(this->path, recorder.Path());
+
+    for (uint32_t i = 0; i < 8u; ++i)
+    {
+      const uint32_t width = 4u + i;
+      frames.emplace_back(width * 2u * 3u,
+          static_cast<unsigned char>(i + 1u));
+      EXPECT_TRUE(recorder.Append(i % 2u, MakeMeta(width, 2u, i),
+            frames.back().data(), frames.back().size()));
+    }
+    EXPECT_EQ(8u, recorder.FrameCount());
+
+    // Index is full
+    EXPECT_FALSE(recorder.Append(0u, MakeMeta(4u, 2u, 9),
+          frames[0].data(), frames[0].size()));
+    EXPECT_EQ(8u, recorder.FrameCount());
+  }
+
+  FrameRecordReader reader;
+  ASSERT_TRUE(reader.Open(this->path));
+  ASSERT_EQ(8u, reader.FrameCount());
+  for (uint32_t i = 0; i < 8u; ++i)
+  {
+    const FrameRecordIndexEntry *entry = reader.Entry(i);
+    ASSERT_NE(nullptr, entry);
+    EXPECT_EQ(i % 2u, entry->stream);
+    EXPECT_EQ(4u + i, entry->width);
+    EXPECT_EQ(2u, entry->height);
+    EXPECT_EQ((4u + i) * 3u, entry->step);
+    EXPECT_EQ(static_cast<uint32_t>(msgs::PixelFormatType::RGB_INT8),
+        entry->pixelFormat);
+    EXPECT_EQ(static_cast<int64_t>(i), entry->sec);
+    EXPECT_EQ(500, entry->nsec);
+    EXPECT_EQ(0u, entry->offset % 64u);
+    ASSERT_EQ(frames[i].size(), entry->size);
+
+    const auto *data = static_cast<const unsigned char *>(reader.Data(i));
+    ASSERT_NE(nullptr, data);
+    EXPECT_EQ(frames[i],
+        std::vector<unsigned char>(data, data + entry->size));
+  }
+  EXPECT_EQ(nullptr, reader.Entry(8u));
+  EXPECT_EQ(nullptr, reader.Data(8u));
+
+  reader.Close();
+  EXPECT_EQ(0u, reader.FrameCount());
+}
+
+//////////////////////////////////////////////////
+TEST_F(FrameRecorder_TEST, InvalidFile)
+{
+  FrameRecordReader reader;
+  EXPECT_FALSE(reader.Open(this->path));
+
+  FrameRecorder recorder;
+  EXPECT_FALSE(recorder.Open(this->path, 0u));
+  EXPECT_FALSE(recorder.IsOpen());
+
+  {
+    std::ofstream file(this->path, std::ios::binary);
+    file << std::string(256u, 'x');
+  }
+  EXPECT_FALSE(reader.Open(this->path));
+  EXPECT_EQ(0u, reader.FrameCount());
+}
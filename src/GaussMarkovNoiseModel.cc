@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "gz/sensors/GaussMarkovNoiseModel.hh"
+#include "gz/sensors/SensorState.hh"
+
+#include "GaussMarkovProcess.hh"
+#include "PhiloxRandom.hh"
+
+using namespace gz;
+using namespace sensors;
+
+class gz::sensors::GaussMarkovNoiseModelPrivate
+{
+  /// \brief Offset added to the noise.
+  public: double mean = 0.0;
+
+  /// \brief The noise process.
+  public: GaussMarkovProcess process;
+
+  /// \brief Random stream of this model.
+  public: PhiloxRandom rng{PhiloxRandom::DefaultSeed()};
+
+  /// \brief State of the process used by ApplyImpl.
+  public: double state = 0.0;
+
+  /// \brief True once state has been sampled.
+  public: bool hasState = false;
+
+  /// \brief State of the process of each value passed to ApplyBatch.
+  public: std::vector<double> states;
+
+  /// \brief Forget the state of all processes.
+  public: void Reset()
+  {
+    this->hasState = false;
+    this->states.clear();
+  }
+
+  /// \brief Apply noise to a strided buffer and clamp the finite results.
+  /// \param[in,out] _data First value.
+  /// \param[in] _count Number of values.
+  /// \param[in] _stride Distance between consecutive values.
+  /// \param[in] _dt Time step.
+  /// \param[in] _min Lower clamping bound.
+  /// \param[in] _max Upper clamping bound.
+  public: template <typename T>
+          void ApplyBatch(T *_data, std::size_t _count, std::size_t _stride,
+              double _dt, double _min, double _max);
+};
+
+//////////////////////////////////////////////////
+template <typename T>
+void GaussMarkovNoiseModelPrivate::ApplyBatch(T *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  this->process.SetTimeStep(_dt);
+  if (this->states.size() != _count)
+  {
+    this->states.resize(_count);
+    for (auto &x : this->states)
+      x = this->process.Initial(this->rng);
+  }
+  else
+  {
+    for (auto &x : this->states)
+      x = this->process.Step(x, this->rng);
+  }
+
+  for (std::size_t i = 0u; i < _count; ++i)
+  {
+    double out = static_cast<double>(_data[i * _stride]) + this->mean +
+        this->states[i];
+    if (std::isfinite(out))
+      out = std::min(std::max(out, _min), _max);
+    _data[i * _stride] = static_cast<T>(out);
+  }
+}
+
+//////////////////////////////////////////////////
+GaussMarkovNoiseModel::GaussMarkovNoiseModel()
+  : Noise(NoiseType::GAUSS_MARKOV),
+    dataPtr(std::make_unique<GaussMarkovNoiseModelPrivate>())
+{
+}
+
+//////////////////////////////////////////////////
+GaussMarkovNoiseModel::~GaussMarkovNoiseModel() = default;
+
+//////////////////////////////////////////////////
+void GaussMarkovNoiseModel::Load(const sdf::Noise &_sdf)
+{
+  Noise::Load(_sdf);
+  this->dataPtr->mean = _sdf.Mean();
+  this->dataPtr->process.Set(_sdf.StdDev(),
+      _sdf.DynamicBiasCorrelationTime());
+  this->dataPtr->Reset();
+}
+
+//////////////////////////////////////////////////
+double GaussMarkovNoiseModel::ApplyImpl(double _in, double _dt)
+{
+  auto &process = this->dataPtr->process;
+  process.SetTimeStep(_dt);
+  this->dataPtr->state = this->dataPtr->hasState ?
+      process.Step(this->dataPtr->state, this->dataPtr->rng) :
+      process.Initial(this->dataPtr->rng);
+  this->dataPtr->hasState = true;
+  return _in + this->dataPtr->mean + this->dataPtr->state;
+}
+
+//////////////////////////////////////////////////
+void GaussMarkovNoiseModel::ApplyBatchImpl(double *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  this->dataPtr->ApplyBatch(_data, _count, _stride, _dt, _min, _max);
+}
+
+//////////////////////////////////////////////////
+void GaussMarkovNoiseModel::ApplyBatchImpl(float *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  this->dataPtr->ApplyBatch(_data, _count, _stride, _dt, _min, _max);
+}
+
+//////////////////////////////////////////////////
+void GaussMarkovNoiseModel::SetSeed(uint64_t _seed)
+{
+  this->dataPtr->rng = PhiloxRandom(_seed);
+  this->dataPtr->Reset();
+}
+
+//////////////////////////////////////////////////
+void GaussMarkovNoiseModel::SaveState(SensorState &_state) const
+{
+  _state.Write(this->dataPtr->rng);
+  _state.Write(this->dataPtr->state);
+  _state.Write(this->dataPtr->hasState);
+  _state.WriteVector(this->dataPtr->states);
+}
+
+//////////////////////////////////////////////////
+bool GaussMarkovNoiseModel::RestoreState(SensorState &_state)
+{
+  return _state.Read(this->dataPtr->rng) &&
+      _state.Read(this->dataPtr->state) &&
+      _state.Read(this->dataPtr->hasState) &&
+      _state.ReadVector(this->dataPtr->states);
+}
+
+//////////////////////////////////////////////////
+void GaussMarkovNoiseModel::Print(std::ostream &_out) const
+{
+  _out << "Gauss-Markov noise, mean[" << this->dataPtr->mean << "], "
+    << "stdDev[" << this->dataPtr->process.stdDev << "] "
+    << "correlationTime[" << this->dataPtr->process.tau << "]";
+}
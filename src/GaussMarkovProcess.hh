@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_GAUSSMARKOVPROCESS_HH_
+#define GZ_SENSORS_GAUSSMARKOVPROCESS_HH_
+
+#include <cmath>
+
+#include "gz/sensors/config.hh"
+
+#include "PhiloxRandom.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Exact discretization of a stationary first-order Gauss-Markov
+    /// process, x[k+1] = phi * x[k] + sigma * w[k]. The coefficients only
+    /// depend on the time step, so they are cached for the last one.
+    class GaussMarkovProcess
+    {
+      /// \brief Set the parameters of the process.
+      /// \param[in] _stdDev Steady state standard deviation.
+      /// \param[in] _tau Correlation time, in seconds.
+      public: void Set(double _stdDev, double _tau)
+      {
+        this->stdDev = _stdDev;
+        this->tau = _tau;
+        this->dt = -1.0;
+        this->phi = 0.0;
+        this->sigma = _stdDev;
+      }
+
+      /// \brief Update the cached coefficients for a time step. A time step
+      /// that isn't positive, or a correlation time that isn't, makes
+      /// consecutive samples uncorrelated.
+      /// \param[in] _dt Time step, in seconds.
+      public: void SetTimeStep(double _dt)
+      {
+        if (_dt == this->dt)
+          return;
+        this->dt = _dt;
+        if (_dt > 0.0 && this->tau > 0.0)
+        {
+          this->phi = std::exp(-_dt / this->tau);
+          this->sigma = this->stdDev * std::sqrt(-std::expm1(-2.0 * _dt /
+              this->tau));
+        }
+        else
+        {
+          this->phi = 0.0;
+          this->sigma = this->stdDev;
+        }
+      }
+
+      /// \brief Draw a sample of the steady state distribution.
+      /// \param[in] _rng Random stream.
+      /// \return Sample.
+      public: double Initial(PhiloxRandom &_rng) const
+      {
+        return _rng.Normal(0.0, this->stdDev);
+      }
+
+      /// \brief Advance a state by the cached time step.
+      /// \param[in] _x Current state.
+      /// \param[in] _rng Random stream.
+      /// \return Next state.
+      public: double Step(double _x, PhiloxRandom &_rng) const
+      {
+        return this->phi * _x + _rng.Normal(0.0, this->sigma);
+      }
+
+      /// \brief Steady state standard deviation.
+      public: double stdDev{0.0};
+
+      /// \brief Correlation time.
+      public: double tau{0.0};
+
+      /// \brief Time step of the cached coefficients, negative if none.
+      public: double dt{-1.0};
+
+      /// \brief Decay factor over dt.
+      public: double phi{0.0};
+
+      /// \brief Standard deviation of the increment over dt.
+      public: double sigma{0.0};
+    };
+    }
+  }
+}
+
+#endif
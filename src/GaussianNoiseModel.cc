@@ -20,15 +20,32 @@
   #include <Winsock2.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "gz/sensors/GaussianNoiseModel.hh"
+#include "gz/sensors/SensorState.hh"
 #include <gz/math/Helpers.hh>
 #include <gz/math/Rand.hh>
 
 #include "gz/common/Console.hh"
 
+#include "PhiloxRandom.hh"
+
 using namespace gz;
 using namespace sensors;
 
+namespace
+{
+  /// \brief math::Rand draws from a single process-wide generator. Sensors
+  /// may be updated from several Manager worker threads at once, so access
+  /// to it has to be serialized. Models with their own stream don't use it.
+  std::mutex randMutex;
+}
+
 class gz::sensors::GaussianNoiseModelPrivate
 {
   /// \brief If type starts with GAUSSIAN, the mean of the distribution
@@ -56,8 +73,202 @@ class gz::sensors::GaussianNoiseModelPrivate
 
   /// \brief True if the type is GAUSSIAN_QUANTIZED
   public: bool quantized = false;
+
+  /// \brief True if the dynamic bias parameters are both positive.
+  public: bool dynamicBias = false;
+
+  /// \brief Time step phiD and sigmaBD were computed for, negative if
+  /// they haven't been computed yet.
+  public: double cachedDt = -1.0;
+
+  /// \brief Decay factor of the dynamic bias over cachedDt.
+  public: double phiD = 0.0;
+
+  /// \brief Standard deviation of the dynamic bias increment over cachedDt.
+  public: double sigmaBD = 0.0;
+
+  /// \brief Mean of the distribution the constant bias is sampled from.
+  public: double biasMean = 0.0;
+
+  /// \brief Standard deviation of the distribution the constant bias is
+  /// sampled from.
+  public: double biasStdDev = 0.0;
+
+  /// \brief Random stream of this model, set by SetSeed. If null, the
+  /// global math::Rand generator is used.
+  public: std::unique_ptr<PhiloxRandom> rng;
+
+  /// \brief Lock randMutex if this model uses the global generator.
+  /// \return The lock, which doesn't own the mutex if the model has its
+  /// own stream.
+  public: std::unique_lock<std::mutex> LockRand() const;
+
+  /// \brief Draw a normally distributed number. randMutex must be locked
+  /// if rng is null.
+  /// \param[in] _mean Mean of the distribution.
+  /// \param[in] _stdDev Standard deviation of the distribution.
+  /// \return Random number.
+  public: double Normal(double _mean, double _stdDev);
+
+  /// \brief Sample the constant bias. randMutex must be locked if rng is
+  /// null.
+  public: void SampleBias();
+
+  /// \brief Advance the dynamic bias by a time step. randMutex must be
+  /// locked if rng is null.
+  /// \param[in] _dt Time step.
+  public: void UpdateBias(double _dt);
+
+  /// \brief Apply noise to a single value.
+  /// \tparam Quantized True if the output is rounded to precision.
+  /// \param[in] _in Input value.
+  /// \param[in] _dt Time step.
+  /// \return Noisy value.
+  public: template <bool Quantized>
+          double Apply(double _in, double _dt);
+
+  /// \brief Apply noise to a strided buffer and clamp the finite results.
+  /// \tparam T Value type of the buffer.
+  /// \tparam Quantized True if the output is rounded to precision.
+  /// \param[in,out] _data First value.
+  /// \param[in] _count Number of values.
+  /// \param[in] _stride Distance between consecutive values.
+  /// \param[in] _dt Time step.
+  /// \param[in] _min Lower clamping bound.
+  /// \param[in] _max Upper clamping bound.
+  public: template <typename T, bool Quantized>
+          void ApplyBatch(T *_data, std::size_t _count, std::size_t _stride,
+              double _dt, double _min, double _max);
 };
 
+//////////////////////////////////////////////////
+std::unique_lock<std::mutex> GaussianNoiseModelPrivate::LockRand() const
+{
+  if (this->rng)
+    return std::unique_lock<std::mutex>();
+  return std::unique_lock<std::mutex>(randMutex);
+}
+
+//////////////////////////////////////////////////
+double GaussianNoiseModelPrivate::Normal(double _mean, double _stdDev)
+{
+  if (this->rng)
+    return this->rng->Normal(_mean, _stdDev);
+  return math::Rand::DblNormal(_mean, _stdDev);
+}
+
+//////////////////////////////////////////////////
+void GaussianNoiseModelPrivate::SampleBias()
+{
+  if (this->biasStdDev > 0.0)
+    this->bias = this->Normal(this->biasMean, this->biasStdDev);
+  else
+    this->bias = this->biasMean;
+
+  // With equal probability, we pick a negative bias (by convention,
+  // rateBiasMean should be positive, though it would work fine if
+  // negative).
+  const double u = this->rng ? this->rng->Uniform() : math::Rand::DblUniform();
+  if (u < 0.5)
+    this->bias = -this->bias;
+}
+
+//////////////////////////////////////////////////
+void GaussianNoiseModelPrivate::UpdateBias(double _dt)
+{
+  // Generate varying (correlated) bias to each input value.
+  // This implementation is based on the one available in Rotors:
+  // https://github.com/ethz-asl/rotors_simulator/blob/master/rotors_gazebo_plugins/src/gazebo_imu_plugin.cpp
+  //
+  // More information about the parameters and their derivation:
+  //
+  // https://github.com/ethz-asl/kalibr/wiki/IMU-Noise-Model
+  //
+  // This can only be generated in the case that _dt > 0.0
+
+  if (!this->dynamicBias || _dt <= 0)
+    return;
+
+  // Sensors update at a fixed rate, so the discretization only needs to be
+  // recomputed when the time step changes.
+  if (_dt != this->cachedDt)
+  {
+    double sigma_b = this->dynamicBiasStdDev;
+    double tau = this->dynamicBiasCorrTime;
+
+    this->sigmaBD = sqrt(-sigma_b * sigma_b *
+        tau / 2 * expm1(-2 * _dt / tau));
+    this->phiD = exp(-_dt / tau);
+    this->cachedDt = _dt;
+  }
+  this->bias = this->phiD * this->bias + this->Normal(0, this->sigmaBD);
+}
+
+//////////////////////////////////////////////////
+template <bool Quantized>
+double GaussianNoiseModelPrivate::Apply(double _in, double _dt)
+{
+  auto randLock = this->LockRand();
+
+  // Generate independent (uncorrelated) Gaussian noise to each input value.
+  double whiteNoise = this->stdDev > 0.0 ?
+      this->Normal(this->mean, this->stdDev) : this->mean;
+
+  this->UpdateBias(_dt);
+
+  double output = _in + this->bias + whiteNoise;
+  if constexpr (Quantized)
+    output = std::round(output / this->precision) * this->precision;
+  return output;
+}
+
+//////////////////////////////////////////////////
+template <typename T, bool Quantized>
+void GaussianNoiseModelPrivate::ApplyBatch(T *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  // Draw all white noise samples first, so the arithmetic below is a
+  // plain loop the compiler can vectorize.
+  thread_local std::vector<double> noise;
+  noise.resize(_count);
+  {
+    auto randLock = this->LockRand();
+    if (this->stdDev > 0.0 && this->rng)
+    {
+      this->rng->Normal(noise.data(), noise.size(), this->mean, this->stdDev);
+    }
+    else if (this->stdDev > 0.0)
+    {
+      for (auto &n : noise)
+        n = math::Rand::DblNormal(this->mean, this->stdDev);
+    }
+    else
+    {
+      std::fill(noise.begin(), noise.end(), this->mean);
+    }
+    this->UpdateBias(_dt);
+  }
+
+  const double offset = this->bias;
+  for (std::size_t i = 0u; i < _count; ++i)
+    noise[i] += static_cast<double>(_data[i * _stride]) + offset;
+
+  if constexpr (Quantized)
+  {
+    const double precision = this->precision;
+    for (auto &n : noise)
+      n = std::round(n / precision) * precision;
+  }
+
+  for (std::size_t i = 0u; i < _count; ++i)
+  {
+    double out = noise[i];
+    if (std::isfinite(out))
+      out = std::min(std::max(out, _min), _max);
+    _data[i * _stride] = static_cast<T>(out);
+  }
+}
+
 //////////////////////////////////////////////////
 GaussianNoiseModel::GaussianNoiseModel()
   : Noise(NoiseType::GAUSSIAN), dataPtr(new GaussianNoiseModelPrivate())
@@ -81,26 +292,22 @@ void GaussianNoiseModel::Load(const sdf::Noise &_sdf)
   this->dataPtr->stdDev = _sdf.StdDev();
   this->dataPtr->dynamicBiasStdDev = _sdf.DynamicBiasStdDev();
   this->dataPtr->dynamicBiasCorrTime = _sdf.DynamicBiasCorrelationTime();
+  this->dataPtr->dynamicBias = this->dataPtr->dynamicBiasStdDev > 0 &&
+      this->dataPtr->dynamicBiasCorrTime > 0;
+  this->dataPtr->cachedDt = -1.0;
 
   // Sample the bias
-  double biasMean = 0;
-  double biasStdDev = 0;
-  biasMean = _sdf.BiasMean();
-  biasStdDev = _sdf.BiasStdDev();
-  if (biasStdDev > 0.0)
-    this->dataPtr->bias = math::Rand::DblNormal(biasMean, biasStdDev);
-  else
-    this->dataPtr->bias = biasMean;
-
-  // With equal probability, we pick a negative bias (by convention,
-  // rateBiasMean should be positive, though it would work fine if
-  // negative).
-  if (math::Rand::DblUniform() < 0.5)
-    this->dataPtr->bias = -this->dataPtr->bias;
+  this->dataPtr->biasMean = _sdf.BiasMean();
+  this->dataPtr->biasStdDev = _sdf.BiasStdDev();
+  {
+    auto randLock = this->dataPtr->LockRand();
+    this->dataPtr->SampleBias();
+  }
 
   this->Print(out);
 
   this->dataPtr->precision = _sdf.Precision();
+  this->dataPtr->quantized = false;
   if (this->dataPtr->precision < 0)
     gzerr << "Noise precision cannot be less than 0" << std::endl;
   else if (!math::equal(this->dataPtr->precision, 0.0, 1e-6))
@@ -110,47 +317,83 @@ void GaussianNoiseModel::Load(const sdf::Noise &_sdf)
 //////////////////////////////////////////////////
 double GaussianNoiseModel::ApplyImpl(double _in, double _dt)
 {
-  // Generate independent (uncorrelated) Gaussian noise to each input value.
-  double whiteNoise = this->dataPtr->stdDev > 0.0 ?
-      math::Rand::DblNormal(this->dataPtr->mean, this->dataPtr->stdDev) :
-      this->dataPtr->mean;
-
-  // Generate varying (correlated) bias to each input value.
-  // This implementation is based on the one available in Rotors:
-  // https://github.com/ethz-asl/rotors_simulator/blob/master/rotors_gazebo_plugins/src/gazebo_imu_plugin.cpp
-  //
-  // More information about the parameters and their derivation:
-  //
-  // https://github.com/ethz-asl/kalibr/wiki/IMU-Noise-Model
-  //
-  // This can only be generated in the case that _dt > 0.0
+  if (this->dataPtr->quantized)
+    return this->dataPtr->Apply<true>(_in, _dt);
+  return this->dataPtr->Apply<false>(_in, _dt);
+}
 
-  if (this->dataPtr->dynamicBiasStdDev > 0 &&
-     this->dataPtr->dynamicBiasCorrTime > 0 &&
-     _dt > 0)
+//////////////////////////////////////////////////
+void GaussianNoiseModel::ApplyBatchImpl(double *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  if (this->dataPtr->quantized)
   {
-    double sigma_b = this->dataPtr->dynamicBiasStdDev;
-    double tau = this->dataPtr->dynamicBiasCorrTime;
+    this->dataPtr->ApplyBatch<double, true>(
+        _data, _count, _stride, _dt, _min, _max);
+  }
+  else
+  {
+    this->dataPtr->ApplyBatch<double, false>(
+        _data, _count, _stride, _dt, _min, _max);
+  }
+}
 
-    double sigma_b_d = sqrt(-sigma_b * sigma_b *
-        tau / 2 * expm1(-2 * _dt / tau));
-    double phi_d = exp(-_dt / tau);
-    this->dataPtr->bias = phi_d * this->dataPtr->bias +
-      math::Rand::DblNormal(0, sigma_b_d);
+//////////////////////////////////////////////////
+void GaussianNoiseModel::ApplyBatchImpl(float *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  if (this->dataPtr->quantized)
+  {
+    this->dataPtr->ApplyBatch<float, true>(
+        _data, _count, _stride, _dt, _min, _max);
   }
+  else
+  {
+    this->dataPtr->ApplyBatch<float, false>(
+        _data, _count, _stride, _dt, _min, _max);
+  }
+}
 
-  double output = _in + this->dataPtr->bias + whiteNoise;
+//////////////////////////////////////////////////
+void GaussianNoiseModel::SetSeed(uint64_t _seed)
+{
+  this->dataPtr->rng = std::make_unique<PhiloxRandom>(_seed);
+  this->dataPtr->SampleBias();
+}
 
-  if (this->dataPtr->quantized)
+//////////////////////////////////////////////////
+void GaussianNoiseModel::SaveState(SensorState &_state) const
+{
+  _state.Write(this->dataPtr->bias);
+  _state.Write(this->dataPtr->rng != nullptr);
+  if (this->dataPtr->rng)
+    _state.Write(*this->dataPtr->rng);
+}
+
+//////////////////////////////////////////////////
+bool GaussianNoiseModel::RestoreState(SensorState &_state)
+{
+  double bias{0.0};
+  bool hasRng{false};
+  if (!_state.Read(bias) || !_state.Read(hasRng))
+    return false;
+
+  if (hasRng)
   {
-    // Apply this->dataPtr->precision
-    if (!math::equal(this->dataPtr->precision, 0.0, 1e-6))
-    {
-      output = std::round(output / this->dataPtr->precision) *
-        this->dataPtr->precision;
-    }
+    PhiloxRandom rng{0u};
+    if (!_state.Read(rng))
+      return false;
+    if (this->dataPtr->rng)
+      *this->dataPtr->rng = rng;
+    else
+      this->dataPtr->rng = std::make_unique<PhiloxRandom>(rng);
   }
-  return output;
+  else
+  {
+    this->dataPtr->rng.reset();
+  }
+  this->dataPtr->bias = bias;
+  return true;
 }
 
 //////////////////////////////////////////////////
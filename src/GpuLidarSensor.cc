@@ -14,11 +14,26 @@
  * limitations under the License.
  *
 */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
 #if defined(_MSC_VER)
   #pragma warning(push)
   #pragma warning(disable: 4005)
   #pragma warning(disable: 4251)
 #endif
+#include <gz/msgs/image.pb.h>
 #include <gz/msgs/pointcloud_packed.pb.h>
 #if defined(_MSC_VER)
   #pragma warning(pop)
@@ -26,20 +41,66 @@
 
 #include <gz/common/Console.hh>
 #include <gz/common/Profiler.hh>
+#include <gz/math/Helpers.hh>
+#include <gz/math/Matrix3.hh>
+#include <gz/math/Pose3.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
 
 #include "gz/sensors/GpuLidarSensor.hh"
 #include "gz/sensors/SensorFactory.hh"
+#include "ElevationMap.hh"
+#include "MemorySize.hh"
+#include "PointCloudCompressor.hh"
+#include "PointCloudUtil.hh"
+#include "SharedTableCache.hh"
+#include "TraceRecorder.hh"
 
 using namespace gz::sensors;
 
+/// \brief Maximum number of rows rendered for a beam table.
+static constexpr unsigned int kMaxBeamRenderRows = 2048u;
+
+/// \brief Unit direction of each ray of a lidar, row major.
+struct RayDirections
+{
+  /// \brief X components.
+  std::vector<float> x;
+
+  /// \brief Y components.
+  std::vector<float> y;
+
+  /// \brief Z components.
+  std::vector<float> z;
+};
+
 /// \brief Private data for the GpuLidar class
 class gz::sensors::GpuLidarSensorPrivate
 {
   /// \brief Fill the point cloud packed message
   /// \param[in] _laserBuffer Lidar data buffer.
-  public: void FillPointCloudMsg(const float *_laserBuffer);
+  /// \param[in] _offset Byte offset of the scan in the message data, to
+  /// append it to a batch.
+  /// \param[in] _blanked Non-zero for each blanked point, null when no
+  /// point is blanked.
+  public: void FillPointCloudMsg(const float *_laserBuffer,
+      std::size_t _offset = 0u, const uint8_t *_blanked = nullptr);
+
+  /// \brief Remove the stamps of the previous batch from the point cloud
+  /// header.
+  /// \param[in] _batched True to add an empty list of stamps for the
+  /// next batch.
+  public: void ResetScanStamps(bool _batched);
+
+  /// \brief Number of scans in each point cloud message.
+  public: unsigned int scanBatchSize{1u};
+
+  /// \brief Number of scans in the point cloud message being batched.
+  public: unsigned int batchedScans{0u};
+
+  /// \brief Stamps of the scans of the batch, in the point cloud header.
+  /// Null when scans aren't batched.
+  public: msgs::Header_Map *scanStamps{nullptr};
 
   /// \brief Rendering camera
   public: gz::rendering::GpuRaysPtr gpuRays;
@@ -65,13 +126,227 @@ class gz::sensors::GpuLidarSensorPrivate
   /// \brief The point cloud message.
   public: msgs::PointCloudPacked pointMsg;
 
+  /// \brief Voxel filtered point cloud, when a voxel size is set.
+  public: msgs::PointCloudPacked voxelMsg;
+
+  /// \brief Splits the point cloud rows across threads.
+  public: PointCloudUtil pointsUtil;
+
+  /// \brief Initialize the point message with the coordinate and intensity
+  /// types of a resolution, keeping its width and height.
+  /// \param[in] _frameId Frame of the point cloud.
+  /// \param[in] _resolution Resolution of the coordinates, zero for floats.
+  public: void InitPointMsg(const std::string &_frameId, double _resolution);
+
+  /// \brief Get the ray direction tables, from the lidars with the same
+  /// rays if they changed since they were last updated.
+  /// \param[in] _width Number of rays per row.
+  /// \param[in] _height Number of rows.
+  public: void UpdateRayDirections(uint32_t _width, uint32_t _height);
+
+  /// \brief Compute the ray direction tables.
+  /// \param[in] _angles Minimum, maximum, vertical minimum and vertical
+  /// maximum ray angles.
+  /// \param[in] _counts Number of horizontal and vertical rays.
+  /// \param[in] _width Number of rays per row.
+  /// \param[in] _height Number of rows.
+  /// \return Direction of each ray.
+  public: RayDirections BuildRayDirections(
+              const std::array<double, 4> &_angles,
+              const std::array<unsigned int, 2> &_counts,
+              uint32_t _width, uint32_t _height) const;
+
+  /// \brief Unit direction of each ray. Shared by the lidars with the same
+  /// rays.
+  public: std::shared_ptr<const RayDirections> rayDirections;
+
+  /// \brief Ray direction tables shared by all lidars.
+  public: static SharedTableCache<RayDirections> rayDirectionsCache;
+
+  /// \brief Parameters the ray direction tables were built for.
+  public: SharedTableKey rayKey;
+
+  /// \brief Rebuild the beam index map from the beam tables and the
+  /// current ray angles and counts.
+  public: void UpdateBeamIndex();
+
+  /// \brief Get the number of rows of the lidar buffer.
+  /// \return Number of beams, or of rendered rows without a beam table.
+  public: unsigned int ScanHeight() const;
+
+  /// \brief Get the number of rays per row of the lidar buffer.
+  /// \return Number of rendered rays per row, over the dual return
+  /// sub-rays.
+  public: unsigned int ScanWidth() const;
+
+  /// \brief Get the horizontal angles of the first and last rays of the
+  /// lidar buffer, without the margin of the dual return sub-rays.
+  /// \return Minimum and maximum angles in radians.
+  public: std::array<double, 2> ScanAngles() const;
+
+  /// \brief Keep the strongest return of the sub-rays of each ray of a
+  /// dual return frame, and store the last returns in secondFrame.
+  /// \param[in] _scan Rendered frame.
+  /// \param[in] _width Number of rendered rays per row.
+  /// \param[in] _height Number of rendered rows.
+  /// \param[in] _channels Number of channels of the frame.
+  /// \return Frame of the strongest returns, _width / returnSamples rays
+  /// wide.
+  public: const float *ReduceReturns(const float *_scan, unsigned int _width,
+      unsigned int _height, unsigned int _channels);
+
+  /// \brief Number of sub-rays rendered per ray, one without dual return.
+  public: unsigned int returnSamples{1u};
+
+  /// \brief Minimum distance between the strongest and last returns.
+  public: double returnSeparation{0.5};
+
+  /// \brief Horizontal margin rendered on each side of the scan so that
+  /// the sub-rays are centered on their ray, in radians.
+  public: double returnMargin{0.0};
+
+  /// \brief Strongest returns of the last dual return frame.
+  public: std::vector<float> reducedFrame;
+
+  /// \brief Range and intensity of the last returns of the last dual
+  /// return frame, one pair per rendered ray.
+  public: std::vector<float> secondFrame;
+
+  /// \brief Range and intensity of the last return of each point of the
+  /// point cloud, row major. Empty without dual return.
+  public: std::vector<float> secondReturn;
+
+  /// \brief Protects secondReturn.
+  public: std::mutex secondReturnMutex;
+
+  /// \brief Index of the "t" field of the point cloud, -1 if there's none.
+  public: int timeField{-1};
+
+  /// \brief Index of the "range2" field of the point cloud, followed by
+  /// "intensity2", -1 if there's none.
+  public: int secondReturnField{-1};
+
+  /// \brief Elevation of each beam, empty for uniformly spaced beams.
+  public: std::vector<double> beamElevations;
+
+  /// \brief Azimuth offset of each beam, empty for no offsets.
+  public: std::vector<double> beamAzimuthOffsets;
+
+  /// \brief Ray sampled by each point of the point cloud, row major with
+  /// one row per beam. Null when there's no beam table. Shared by the
+  /// lidars with the same beams and rays.
+  public: std::shared_ptr<const std::vector<uint32_t>> beamIndex;
+
+  /// \brief Beam index maps shared by all lidars.
+  public: static SharedTableCache<std::vector<uint32_t>> beamIndexCache;
+
+  /// \brief Get the beam index map.
+  /// \return Ray sampled by each point, empty without a beam table.
+  public: const std::vector<uint32_t> &BeamIndex() const;
+
+  /// \brief Compute the transform and time of each slice of a rolling
+  /// scan ending at the current pose.
+  /// \param[in] _pose Current pose of the sensor.
+  /// \param[in] _now Current time.
+  /// \param[in] _updateRate Update rate of the sensor.
+  public: void UpdateSlices(const math::Pose3d &_pose,
+      const std::chrono::steady_clock::duration &_now, double _updateRate);
+
+  /// \brief Number of slices of a rolling scan, zero when the whole scan
+  /// is captured at once.
+  public: unsigned int rollingSlices{0u};
+
+  /// \brief Transform of each slice of a rolling scan, from the sensor
+  /// frame at the end of the scan to the frame at the time of the slice.
+  /// The rotation is stored row major, followed by the translation.
+  public: std::vector<std::array<float, 12>> sliceTransforms;
+
+  /// \brief Time of each slice of a rolling scan relative to the end of
+  /// the scan, in seconds.
+  public: std::vector<float> sliceTimes;
+
+  /// \brief Pose of the sensor at the previous update.
+  public: math::Pose3d previousPose;
+
+  /// \brief Time of the previous update.
+  public: std::chrono::steady_clock::duration previousTime{0};
+
+  /// \brief True once previousPose and previousTime are set.
+  public: bool hasPreviousPose{false};
+
+  /// \brief Layout and stamp of the recorded scans.
+  public: msgs::Image recordMsg;
+
+  /// \brief Last rendered scan before noise, kept while frames may be
+  /// reused so that they get new noise.
+  public: std::vector<float> cleanScan;
+
   /// \brief Transport node.
   public: transport::Node node;
 
   /// \brief Publisher for the publish point cloud message.
   public: transport::Node::Publisher pointPub;
+
+  /// \brief Publisher of the compressed point clouds.
+  public: transport::Node::Publisher compressedPointPub;
+
+  /// \brief Encodes and publishes compressed point clouds, null unless
+  /// compressed output is enabled.
+  public: std::unique_ptr<PointCloudCompressor> pointCompressor;
+
+  /// \brief Publisher of the elevation maps.
+  public: transport::Node::Publisher elevationMapPub;
+
+  /// \brief Elevation map around the sensor, null unless elevation map
+  /// output is enabled.
+  public: std::unique_ptr<ElevationMap> elevationMap;
+
+  /// \brief Minimum time between two elevation maps.
+  public: std::chrono::steady_clock::duration elevationMapPeriod{0};
+
+  /// \brief Time of the last published elevation map.
+  public: std::chrono::steady_clock::duration elevationMapTime{0};
+
+  /// \brief True once an elevation map was published.
+  public: bool elevationMapPublished{false};
+
+  /// \brief Publish the elevation map, unless the last one was published
+  /// less than elevationMapPeriod ago.
+  /// \param[in] _sensor The sensor.
+  /// \param[in] _now Current time.
+  public: void PublishElevationMap(GpuLidarSensor &_sensor,
+              const std::chrono::steady_clock::duration &_now);
+
+  /// \brief Copy one channel of the lidar buffer into a float image.
+  /// \param[in,out] _msg Image message.
+  /// \param[in] _laserBuffer Lidar data buffer.
+  /// \param[in] _channel Channel to copy, 0 for ranges and 1 for
+  /// intensities.
+  public: void FillChannelImage(msgs::Image &_msg, const float *_laserBuffer,
+      unsigned int _channel);
+
+  /// \brief Range image topic.
+  public: std::string rangeImageTopic;
+
+  /// \brief Intensity image topic.
+  public: std::string intensityImageTopic;
+
+  /// \brief Publisher of the range images.
+  public: transport::Node::Publisher rangeImagePub;
+
+  /// \brief Publisher of the intensity images.
+  public: transport::Node::Publisher intensityImagePub;
+
+  /// \brief Range image message.
+  public: msgs::Image rangeImageMsg;
+
+  /// \brief Intensity image message.
+  public: msgs::Image intensityImageMsg;
 };
 
+SharedTableCache<RayDirections> GpuLidarSensorPrivate::rayDirectionsCache;
+SharedTableCache<std::vector<uint32_t>> GpuLidarSensorPrivate::beamIndexCache;
+
 //////////////////////////////////////////////////
 GpuLidarSensor::GpuLidarSensor()
   : dataPtr(new GpuLidarSensorPrivate())
@@ -84,12 +359,6 @@ GpuLidarSensor::~GpuLidarSensor()
   this->RemoveGpuRays(this->Scene());
 
   this->dataPtr->sceneChangeConnection.reset();
-
-  if (this->laserBuffer)
-  {
-    delete [] this->laserBuffer;
-    this->laserBuffer = nullptr;
-  }
 }
 
 /////////////////////////////////////////////////
@@ -129,15 +398,7 @@ bool GpuLidarSensor::Load(const sdf::Sensor &_sdf)
   }
 
   // Initialize the point message.
-  // \todo(anyone) The true value in the following function call forces
-  // the xyz and rgb fields to be aligned to memory boundaries. This is need
-  // by ROS1: https://github.com/ros/common_msgs/pull/77. Ideally, memory
-  // alignment should be configured. This same problem is in the
-  // RgbdCameraSensor.
-  msgs::InitPointCloudPacked(this->dataPtr->pointMsg, this->Name(), true,
-      {{"xyz", msgs::PointCloudPacked::Field::FLOAT32},
-      {"intensity", msgs::PointCloudPacked::Field::FLOAT32},
-      {"ring", msgs::PointCloudPacked::Field::UINT16}});
+  this->dataPtr->InitPointMsg(this->Name(), this->PointCloudResolution());
 
   if (this->Scene())
     this->CreateLidar();
@@ -146,14 +407,26 @@ bool GpuLidarSensor::Load(const sdf::Sensor &_sdf)
     RenderingEvents::ConnectSceneChangeCallback(
         std::bind(&GpuLidarSensor::SetScene, this, std::placeholders::_1));
 
+  // Create the range and intensity image publishers
+  this->dataPtr->rangeImageTopic = this->Topic() + "/range_image";
+  this->dataPtr->intensityImageTopic = this->Topic() + "/intensity_image";
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+          this->dataPtr->rangeImagePub, this->dataPtr->rangeImageTopic) ||
+      !this->Advertise<msgs::Image>(this->dataPtr->node,
+          this->dataPtr->intensityImagePub,
+          this->dataPtr->intensityImageTopic))
+  {
+    gzerr << "Unable to create publishers on topics["
+      << this->dataPtr->rangeImageTopic << "] and ["
+      << this->dataPtr->intensityImageTopic << "].\n";
+    return false;
+  }
+
   // Create the point cloud publisher
   this->SetTopic(this->Topic() + "/points");
 
-  this->dataPtr->pointPub =
-      this->dataPtr->node.Advertise<gz::msgs::PointCloudPacked>(
-          this->Topic());
-
-  if (!this->dataPtr->pointPub)
+  if (!this->Advertise<gz::msgs::PointCloudPacked>(this->dataPtr->node,
+      this->dataPtr->pointPub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() << "].\n";
@@ -176,6 +449,48 @@ bool GpuLidarSensor::Load(sdf::ElementPtr _sdf)
   return this->Load(sdfSensor);
 }
 
+//////////////////////////////////////////////////
+bool GpuLidarSensor::Reconfigure(const sdf::Sensor &_sdf)
+{
+  // There's a beam angle per vertical range
+  const sdf::Lidar *lidarSdf = _sdf.LidarSensor();
+  if (lidarSdf && !this->dataPtr->beamElevations.empty() &&
+      std::max(1u, static_cast<unsigned int>(
+          lidarSdf->VerticalScanSamples() *
+          lidarSdf->VerticalScanResolution())) != this->VerticalRangeCount())
+  {
+    gzerr << "The vertical samples of lidar [" << this->Name() << "] can't "
+          << "be reconfigured while beam angles are set.\n";
+    return false;
+  }
+
+  // Settings the gpu rays are created from
+  const auto raysKey = [this]()
+  {
+    return std::array<double, 9>{{
+        static_cast<double>(this->RayCount()),
+        static_cast<double>(this->VerticalRayCount()),
+        this->AngleMin().Radian(), this->AngleMax().Radian(),
+        this->VerticalAngleMin().Radian(),
+        this->VerticalAngleMax().Radian(),
+        this->RangeMin(), this->RangeMax(),
+        static_cast<double>(this->VisibilityMask())}};
+  };
+  const auto key = raysKey();
+
+  if (!Lidar::Reconfigure(_sdf))
+    return false;
+
+  std::lock_guard<std::mutex> lock(this->lidarMutex);
+  if (this->dataPtr->gpuRays && raysKey() != key)
+  {
+    gz::rendering::ScenePtr scene = this->Scene();
+    this->RemoveGpuRays(scene);
+    return this->CreateLidar();
+  }
+  return true;
+}
+
 //////////////////////////////////////////////////
 bool GpuLidarSensor::Init()
 {
@@ -203,25 +518,71 @@ bool GpuLidarSensor::CreateLidar()
   // Mask ranges outside of min/max to +/- inf, as per REP 117
   this->dataPtr->gpuRays->SetClamp(false);
 
-  this->dataPtr->gpuRays->SetAngleMin(this->AngleMin().Radian());
-  this->dataPtr->gpuRays->SetAngleMax(this->AngleMax().Radian());
+  // The sub-rays of a dual return lidar are rendered in the same pass,
+  // centered on their ray as long as the scan stays within a revolution
+  const unsigned int samples = this->dataPtr->returnSamples;
+  const double angleMin = this->AngleMin().Radian();
+  const double angleMax = this->AngleMax().Radian();
+  double margin = 0.0;
+  if (samples > 1u && this->RayCount() > 1u)
+  {
+    const double step = (angleMax - angleMin) / (this->RayCount() - 1u);
+    margin = std::clamp(step * (samples - 1u) / (2.0 * samples), 0.0,
+        std::max(0.0, GZ_PI - (angleMax - angleMin) / 2.0));
+  }
+  this->dataPtr->returnMargin = margin;
+  this->dataPtr->gpuRays->SetAngleMin(angleMin - margin);
+  this->dataPtr->gpuRays->SetAngleMax(angleMax + margin);
 
-  this->dataPtr->gpuRays->SetVerticalAngleMin(
-      this->VerticalAngleMin().Radian());
-  this->dataPtr->gpuRays->SetVerticalAngleMax(
-      this->VerticalAngleMax().Radian());
+  this->dataPtr->gpuRays->SetRayCount(this->RayCount() * samples);
 
-  this->dataPtr->gpuRays->SetRayCount(this->RayCount());
-  this->dataPtr->gpuRays->SetVerticalRayCount(
-      this->VerticalRayCount());
+  const std::vector<double> &elevations = this->dataPtr->beamElevations;
+  if (elevations.empty())
+  {
+    this->dataPtr->gpuRays->SetVerticalAngleMin(
+        this->VerticalAngleMin().Radian());
+    this->dataPtr->gpuRays->SetVerticalAngleMax(
+        this->VerticalAngleMax().Radian());
+    this->dataPtr->gpuRays->SetVerticalRayCount(
+        this->VerticalRayCount());
+  }
+  else
+  {
+    // Render the span of the beams at half the smallest gap between two
+    // beams, so that each beam is within a quarter of that gap of a ray
+    std::vector<double> sorted = elevations;
+    std::sort(sorted.begin(), sorted.end());
+    double minGap = 0.0;
+    for (std::size_t i = 1u; i < sorted.size(); ++i)
+    {
+      const double gap = sorted[i] - sorted[i - 1u];
+      if (gap > 1e-9 && (minGap <= 0.0 || gap < minGap))
+        minGap = gap;
+    }
+    const double span = sorted.back() - sorted.front();
+    unsigned int rows = 1u;
+    if (minGap > 0.0)
+    {
+      rows = static_cast<unsigned int>(std::min(std::ceil(2.0 * span / minGap),
+          static_cast<double>(kMaxBeamRenderRows - 1u))) + 1u;
+      if (rows == kMaxBeamRenderRows)
+      {
+        gzwarn << "Beams of [" << this->Name() << "] are too close to each "
+               << "other, rendering " << rows << " rows.\n";
+      }
+    }
+    this->dataPtr->gpuRays->SetVerticalAngleMin(sorted.front());
+    this->dataPtr->gpuRays->SetVerticalAngleMax(sorted.back());
+    this->dataPtr->gpuRays->SetVerticalRayCount(rows);
+  }
 
   this->Scene()->RootVisual()->AddChild(
       this->dataPtr->gpuRays);
 
   // Set the values on the point message.
-  this->dataPtr->pointMsg.set_width(this->dataPtr->gpuRays->RangeCount());
-  this->dataPtr->pointMsg.set_height(
-      this->dataPtr->gpuRays->VerticalRangeCount());
+  this->dataPtr->pointMsg.set_width(this->dataPtr->ScanWidth());
+  this->dataPtr->pointMsg.set_height(this->dataPtr->ScanHeight());
+  this->dataPtr->UpdateBeamIndex();
   this->dataPtr->pointMsg.set_row_step(
       this->dataPtr->pointMsg.point_step() *
       this->dataPtr->pointMsg.width());
@@ -243,19 +604,117 @@ void GpuLidarSensor::OnNewLidarFrame(const float *_scan,
     unsigned int _width, unsigned int _height, unsigned int _channels,
     const std::string &_format)
 {
-  std::lock_guard<std::mutex> lock(this->lidarMutex);
+  // Dual return frames are reduced to one ray per sub-ray group first
+  const bool dualReturn = this->dataPtr->returnSamples > 1u &&
+      _width % this->dataPtr->returnSamples == 0u;
+  if (dualReturn)
+  {
+    _scan = this->dataPtr->ReduceReturns(_scan, _width, _height, _channels);
+    _width /= this->dataPtr->returnSamples;
+  }
 
-  unsigned int samples = _width * _height * _channels;
+  // The scan is written to a buffer that isn't being read, without
+  // lidarMutex. With a beam table, each row holds the rays of a beam.
+  // Hold the beam index map while copying, CreateLidar may replace it
+  const auto beamTable = this->dataPtr->beamIndex;
+  const std::vector<uint32_t> &beamIndex =
+      beamTable ? *beamTable : this->dataPtr->BeamIndex();
+  const bool mapped = !beamIndex.empty() &&
+      beamIndex.size() % _width == 0u &&
+      *std::max_element(beamIndex.begin(), beamIndex.end()) <
+      _width * _height;
+  const unsigned int height = mapped ?
+      static_cast<unsigned int>(beamIndex.size() / _width) : _height;
+
+  unsigned int samples = _width * height * _channels;
   unsigned int lidarBufferSize = samples * sizeof(float);
 
-  if (!this->laserBuffer)
-    this->laserBuffer = new float[samples];
+  // Blanked rays aren't copied, they get no return
+  const auto blankingMask = this->BlankingMask();
+  const std::size_t rays = static_cast<std::size_t>(_width) * height;
+  const uint8_t *blanked = blankingMask && blankingMask->size() == rays ?
+      blankingMask->data() : nullptr;
+  const auto blank = [&](float *_ray)
+  {
+    _ray[0] = std::numeric_limits<float>::infinity();
+    std::fill(_ray + 1, _ray + _channels, 0.0f);
+  };
 
-  memcpy(this->laserBuffer, _scan, lidarBufferSize);
+  float *buffer = this->ScanWriteBuffer(samples);
+  if (mapped)
+  {
+    for (std::size_t i = 0u; i < beamIndex.size(); ++i)
+    {
+      if (blanked && blanked[i])
+      {
+        blank(buffer + i * _channels);
+        continue;
+      }
+      std::memcpy(buffer + i * _channels,
+          _scan + static_cast<std::size_t>(beamIndex[i]) * _channels,
+          _channels * sizeof(float));
+    }
+  }
+  else if (blanked)
+  {
+    for (std::size_t i = 0u; i < rays; ++i)
+    {
+      if (blanked[i])
+      {
+        blank(buffer + i * _channels);
+        continue;
+      }
+      // Copy the whole run of rays that aren't blanked
+      std::size_t end = i + 1u;
+      while (end < rays && !blanked[end])
+        ++end;
+      std::memcpy(buffer + i * _channels, _scan + i * _channels,
+          (end - i) * _channels * sizeof(float));
+      i = end - 1u;
+    }
+  }
+  else
+  {
+    memcpy(buffer, _scan, lidarBufferSize);
+  }
+  this->CommitScanBuffer();
+
+  // The last returns follow the same beam mapping
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->secondReturnMutex);
+    std::vector<float> &second = this->dataPtr->secondReturn;
+    if (!dualReturn)
+    {
+      second.clear();
+    }
+    else if (mapped)
+    {
+      const float *frame = this->dataPtr->secondFrame.data();
+      second.resize(beamIndex.size() * 2u);
+      for (std::size_t i = 0u; i < beamIndex.size(); ++i)
+      {
+        second[i * 2u] = frame[static_cast<std::size_t>(beamIndex[i]) * 2u];
+        second[i * 2u + 1u] =
+            frame[static_cast<std::size_t>(beamIndex[i]) * 2u + 1u];
+      }
+    }
+    else
+    {
+      second = this->dataPtr->secondFrame;
+    }
+    for (std::size_t i = 0u; blanked && i < second.size() / 2u; ++i)
+    {
+      if (blanked[i])
+      {
+        second[i * 2u] = std::numeric_limits<float>::infinity();
+        second[i * 2u + 1u] = 0.0f;
+      }
+    }
+  }
 
   if (this->dataPtr->lidarEvent.ConnectionCount() > 0)
   {
-    this->dataPtr->lidarEvent(_scan, _width, _height, _channels, _format);
+    this->dataPtr->lidarEvent(buffer, _width, height, _channels, _format);
   }
 }
 
@@ -275,15 +734,118 @@ bool GpuLidarSensor::Update(const std::chrono::steady_clock::duration &_now)
     return false;
   }
 
-  this->Render();
+  // The last scan is published again if nothing changed, with new noise.
+  // Rolling scans are stamped per slice, so they're always rendered.
+  const bool noise = this->HasNoise();
+  if (this->dataPtr->rollingSlices > 0u || !this->ReuseFrame())
+  {
+    this->Render();
+    if (noise && this->FrameReuse())
+    {
+      const float *scan = this->AcquireScanBuffer();
+      if (scan)
+      {
+        this->dataPtr->cleanScan.assign(scan, scan +
+            static_cast<std::size_t>(this->dataPtr->ScanWidth()) *
+            this->dataPtr->ScanHeight() * this->dataPtr->gpuRays->Channels());
+      }
+      this->ReleaseScanBuffer();
+    }
+  }
+  else if (noise)
+  {
+    float *scan = this->AcquireScanBuffer();
+    if (scan)
+    {
+      std::copy(this->dataPtr->cleanScan.begin(),
+          this->dataPtr->cleanScan.end(), scan);
+    }
+    this->ReleaseScanBuffer();
+  }
 
   // Apply noise before publishing the data.
   this->ApplyNoise();
 
   this->PublishLidarScan(_now);
 
-  if (this->dataPtr->pointPub.HasConnections())
+  // The latest scan is kept from being overwritten while it's read below
+  const float *scan = this->AcquireScanBuffer();
+
+  // Range and intensity images are copied straight from the lidar buffer
+  const bool rangeImage = this->dataPtr->rangeImagePub.HasConnections();
+  const bool intensityImage =
+      this->dataPtr->intensityImagePub.HasConnections();
+  if (rangeImage || intensityImage)
+  {
+    GZ_PROFILE("GpuLidarSensor::Update Publish images");
+    if (scan && rangeImage)
+    {
+      this->FillHeader(this->dataPtr->rangeImageMsg.mutable_header(), _now,
+          this->FrameId(), "range_image");
+      this->dataPtr->FillChannelImage(this->dataPtr->rangeImageMsg,
+          scan, 0u);
+      this->Publish(this->dataPtr->rangeImagePub,
+          this->dataPtr->rangeImageMsg);
+    }
+    if (scan && intensityImage)
+    {
+      this->FillHeader(this->dataPtr->intensityImageMsg.mutable_header(),
+          _now, this->FrameId(), "intensity_image");
+      this->dataPtr->FillChannelImage(this->dataPtr->intensityImageMsg,
+          scan, 1u);
+      this->Publish(this->dataPtr->intensityImagePub,
+          this->dataPtr->intensityImageMsg);
+    }
+  }
+
+  if (this->Recording())
   {
+    // Each sample holds the range, intensity and retro values
+    const unsigned int width = this->dataPtr->ScanWidth();
+    const unsigned int height = this->dataPtr->ScanHeight();
+    const unsigned int channels = this->dataPtr->gpuRays->Channels();
+    msgs::Image &msg = this->dataPtr->recordMsg;
+    msg.set_width(width);
+    msg.set_height(height);
+    msg.set_step(width * channels * sizeof(float));
+    msg.set_pixel_format_type(channels == 3u ?
+        msgs::PixelFormatType::RGB_FLOAT32 :
+        msgs::PixelFormatType::UNKNOWN_PIXEL_FORMAT);
+    *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
+
+    if (scan)
+    {
+      this->RecordFrame(0u, msg, scan,
+          static_cast<std::size_t>(width) * height * channels *
+          sizeof(float));
+    }
+  }
+
+  const bool publishPoints = this->dataPtr->pointPub.HasConnections();
+  const bool compressPoints = this->HasCompressedPointConnections();
+  const bool mapPoints = this->HasElevationMapConnections();
+  if (scan && (publishPoints || compressPoints || mapPoints))
+  {
+    // The time field is only there for rolling scans, the last return
+    // fields for dual returns
+    const int fieldCount = 5 + (this->dataPtr->rollingSlices > 0u ? 1 : 0) +
+        (this->dataPtr->returnSamples > 1u ? 2 : 0);
+    if (this->dataPtr->pointsUtil.Resolution() !=
+        this->PointCloudResolution() ||
+        this->dataPtr->pointMsg.field_size() != fieldCount)
+    {
+      this->dataPtr->InitPointMsg(this->FrameId(),
+          this->PointCloudResolution());
+      this->dataPtr->batchedScans = 0u;
+    }
+
+    // Start a new batch, also after the batch size was reduced
+    const unsigned int batchSize = std::max(this->dataPtr->scanBatchSize, 1u);
+    if (this->dataPtr->batchedScans >= batchSize)
+      this->dataPtr->batchedScans = 0u;
+    if (this->dataPtr->batchedScans == 0u)
+      this->dataPtr->ResetScanStamps(batchSize > 1u);
+
     // Set the time stamp
     *this->dataPtr->pointMsg.mutable_header()->mutable_stamp() =
       msgs::Convert(_now);
@@ -301,14 +863,71 @@ bool GpuLidarSensor::Update(const std::chrono::steady_clock::duration &_now)
       }
     }
 
-    this->dataPtr->FillPointCloudMsg(this->laserBuffer);
+    if (this->dataPtr->rollingSlices > 0u)
+      this->dataPtr->UpdateSlices(this->Pose(), _now, this->UpdateRate());
+
+    // Batched scans are appended after the previous ones
+    const uint32_t height = this->dataPtr->pointMsg.height();
+    const std::size_t scanSize =
+        static_cast<std::size_t>(this->dataPtr->pointMsg.row_step()) * height;
+    this->dataPtr->pointsUtil.SetThreadCount(this->PointCloudThreadCount());
+    {
+      TraceScope trace("fill", *this);
+      const auto blankingMask = this->BlankingMask();
+      const bool blanked = blankingMask && blankingMask->size() ==
+          static_cast<std::size_t>(this->dataPtr->pointMsg.width()) * height;
+      std::lock_guard<std::mutex> lock(this->dataPtr->secondReturnMutex);
+      this->dataPtr->FillPointCloudMsg(scan,
+          this->dataPtr->batchedScans * scanSize,
+          blanked ? blankingMask->data() : nullptr);
+    }
+
+    // Bin the points of the scan while they're in the cache
+    if (mapPoints)
+    {
+      const std::size_t scanPoints =
+          static_cast<std::size_t>(this->dataPtr->pointMsg.width()) * height;
+      this->dataPtr->elevationMap->AddPoints(this->dataPtr->pointMsg,
+          this->Pose(), this->dataPtr->batchedScans * scanPoints,
+          scanPoints);
+      this->dataPtr->PublishElevationMap(*this, _now);
+    }
+
+    if (this->dataPtr->scanStamps)
+    {
+      this->dataPtr->scanStamps->add_value(std::to_string(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(_now).count()));
+    }
 
+    if (++this->dataPtr->batchedScans == batchSize &&
+        (publishPoints || compressPoints))
     {
+      this->dataPtr->batchedScans = 0u;
+      this->dataPtr->pointMsg.set_height(height * batchSize);
       this->AddSequence(this->dataPtr->pointMsg.mutable_header());
       GZ_PROFILE("GpuLidarSensor::Update Publish point cloud");
-      this->dataPtr->pointPub.Publish(this->dataPtr->pointMsg);
+      const double voxelSize = this->PointCloudVoxelSize();
+      const msgs::PointCloudPacked *msg = &this->dataPtr->pointMsg;
+      if (voxelSize > 0.0)
+      {
+        this->dataPtr->pointsUtil.VoxelFilter(this->dataPtr->pointMsg,
+            voxelSize, this->dataPtr->voxelMsg);
+        msg = &this->dataPtr->voxelMsg;
+      }
+      if (publishPoints)
+        this->Publish(this->dataPtr->pointPub, *msg);
+      if (compressPoints)
+        this->dataPtr->pointCompressor->Push(*msg);
+      this->dataPtr->pointMsg.set_height(height);
     }
   }
+
+  this->ReleaseScanBuffer();
+
+  // Keep track of the motion of the sensor for rolling scans
+  this->dataPtr->previousPose = this->Pose();
+  this->dataPtr->previousTime = _now;
+  this->dataPtr->hasPreviousPose = true;
   return true;
 }
 
@@ -336,7 +955,8 @@ bool GpuLidarSensor::IsHorizontal() const
 //////////////////////////////////////////////////
 gz::math::Angle GpuLidarSensor::HFOV() const
 {
-  return this->dataPtr->gpuRays->HFOV();
+  return this->dataPtr->gpuRays->HFOV() -
+      gz::math::Angle(2.0 * this->dataPtr->returnMargin);
 }
 
 //////////////////////////////////////////////////
@@ -345,87 +965,833 @@ gz::math::Angle GpuLidarSensor::VFOV() const
   return this->dataPtr->gpuRays->VFOV();
 }
 
+//////////////////////////////////////////////////
+SensorMemoryUsage GpuLidarSensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage = Lidar::MemoryUsage();
+  usage["point_msg"] = MemorySize(this->dataPtr->pointMsg) +
+      MemorySize(this->dataPtr->voxelMsg);
+  usage["range_images"] = MemorySize(this->dataPtr->rangeImageMsg) +
+      MemorySize(this->dataPtr->intensityImageMsg);
+  usage["record_msg"] = MemorySize(this->dataPtr->recordMsg);
+  usage["clean_scan"] = MemorySize(this->dataPtr->cleanScan);
+  usage["elevation_map"] = this->dataPtr->elevationMap ?
+      this->dataPtr->elevationMap->MemorySize() : 0u;
+  usage["rolling_shutter"] = MemorySize(this->dataPtr->sliceTransforms) +
+      MemorySize(this->dataPtr->sliceTimes);
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->secondReturnMutex);
+  usage["returns"] = MemorySize(this->dataPtr->reducedFrame) +
+      MemorySize(this->dataPtr->secondFrame) +
+      MemorySize(this->dataPtr->secondReturn);
+  return usage;
+}
+
 //////////////////////////////////////////////////
 bool GpuLidarSensor::HasConnections() const
 {
   return Lidar::HasConnections() ||
      (this->dataPtr->pointPub && this->dataPtr->pointPub.HasConnections()) ||
+     this->HasCompressedPointConnections() ||
+     this->HasElevationMapConnections() ||
+     (this->dataPtr->rangeImagePub &&
+      this->dataPtr->rangeImagePub.HasConnections()) ||
+     (this->dataPtr->intensityImagePub &&
+      this->dataPtr->intensityImagePub.HasConnections()) ||
      this->dataPtr->lidarEvent.ConnectionCount() > 0u;
 }
 
 //////////////////////////////////////////////////
-void GpuLidarSensorPrivate::FillPointCloudMsg(const float *_laserBuffer)
+std::string GpuLidarSensor::RangeImageTopic() const
 {
-  GZ_PROFILE("GpuLidarSensorPrivate::FillPointCloudMsg");
-  uint32_t width = this->pointMsg.width();
-  uint32_t height = this->pointMsg.height();
-  unsigned int channels = 3;
+  return this->dataPtr->rangeImageTopic;
+}
 
-  float angleStep =
-    (this->gpuRays->AngleMax() - this->gpuRays->AngleMin()).Radian() /
-    (this->gpuRays->RangeCount()-1);
+//////////////////////////////////////////////////
+std::string GpuLidarSensor::IntensityImageTopic() const
+{
+  return this->dataPtr->intensityImageTopic;
+}
 
-  float verticleAngleStep = (this->gpuRays->VerticalAngleMax() -
-      this->gpuRays->VerticalAngleMin()).Radian() /
-    (this->gpuRays->VerticalRangeCount()-1);
+//////////////////////////////////////////////////
+bool GpuLidarSensor::SetBeamAngles(const std::vector<double> &_elevations,
+    const std::vector<double> &_azimuthOffsets)
+{
+  if (!_elevations.empty() && _elevations.size() != this->VerticalRangeCount())
+  {
+    gzerr << "Got " << _elevations.size() << " beam elevations for "
+          << this->VerticalRangeCount() << " vertical samples, beam angles "
+          << "ignored.\n";
+    return false;
+  }
+  if (!_azimuthOffsets.empty() &&
+      _azimuthOffsets.size() != _elevations.size())
+  {
+    gzerr << "Got " << _azimuthOffsets.size() << " azimuth offsets for "
+          << _elevations.size() << " beams, beam angles ignored.\n";
+    return false;
+  }
+  for (const double angle : _elevations)
+  {
+    if (!std::isfinite(angle) || std::abs(angle) >= GZ_PI / 2.0)
+    {
+      gzerr << "Invalid beam elevation [" << angle
+            << "], beam angles ignored.\n";
+      return false;
+    }
+  }
 
-  // Angles of ray currently processing, azimuth is horizontal, inclination
-  // is vertical
-  float inclination = this->gpuRays->VerticalAngleMin().Radian();
+  std::lock_guard<std::mutex> lock(this->lidarMutex);
+  this->dataPtr->beamElevations = _elevations;
+  this->dataPtr->beamAzimuthOffsets = _azimuthOffsets;
+  this->SetBlankingBeams(_elevations, _azimuthOffsets);
 
-  std::string *msgBuffer = this->pointMsg.mutable_data();
-  msgBuffer->resize(this->pointMsg.row_step() *
-      this->pointMsg.height());
-  char *msgBufferIndex = msgBuffer->data();
-  // Set Pointcloud as dense. Change if invalid points are found.
-  bool isDense { true };
-  // Iterate over scan and populate point cloud
-  for (uint32_t j = 0; j < height; ++j)
+  // The render resolution depends on the beams
+  if (this->dataPtr->gpuRays)
   {
-    float azimuth = this->gpuRays->AngleMin().Radian();
+    gz::rendering::ScenePtr scene = this->Scene();
+    this->RemoveGpuRays(scene);
+    return this->CreateLidar();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::vector<double> GpuLidarSensor::BeamElevations() const
+{
+  return this->dataPtr->beamElevations;
+}
+
+//////////////////////////////////////////////////
+std::vector<double> GpuLidarSensor::BeamAzimuthOffsets() const
+{
+  return this->dataPtr->beamAzimuthOffsets;
+}
+
+//////////////////////////////////////////////////
+void GpuLidarSensor::SetScanBatchSize(unsigned int _size)
+{
+  this->dataPtr->scanBatchSize = std::max(_size, 1u);
+}
+
+//////////////////////////////////////////////////
+unsigned int GpuLidarSensor::ScanBatchSize() const
+{
+  return this->dataPtr->scanBatchSize;
+}
 
-    for (uint32_t i = 0; i < width; ++i)
+//////////////////////////////////////////////////
+void GpuLidarSensor::SetRollingScanSlices(unsigned int _slices)
+{
+  this->dataPtr->rollingSlices = _slices;
+}
+
+//////////////////////////////////////////////////
+unsigned int GpuLidarSensor::RollingScanSlices() const
+{
+  return this->dataPtr->rollingSlices;
+}
+
+//////////////////////////////////////////////////
+bool GpuLidarSensor::SetDualReturn(unsigned int _samples, double _separation)
+{
+  if (!(_separation > 0.0) || !std::isfinite(_separation))
+  {
+    gzerr << "Invalid dual return separation [" << _separation
+          << "], it must be positive.\n";
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(this->lidarMutex);
+  const unsigned int samples = std::max(_samples, 1u);
+  this->dataPtr->returnSeparation = _separation;
+  if (samples == this->dataPtr->returnSamples)
+    return true;
+  this->dataPtr->returnSamples = samples;
+
+  // The render resolution depends on the sub-rays
+  if (this->dataPtr->gpuRays)
+  {
+    gz::rendering::ScenePtr scene = this->Scene();
+    this->RemoveGpuRays(scene);
+    return this->CreateLidar();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+unsigned int GpuLidarSensor::DualReturnSamples() const
+{
+  return this->dataPtr->returnSamples;
+}
+
+//////////////////////////////////////////////////
+double GpuLidarSensor::DualReturnSeparation() const
+{
+  return this->dataPtr->returnSeparation;
+}
+
+//////////////////////////////////////////////////
+bool GpuLidarSensor::SetCompressedPointsOutput(bool _enabled,
+    double _resolution)
+{
+  if (!_enabled)
+  {
+    this->dataPtr->pointCompressor.reset();
+    this->dataPtr->compressedPointPub = transport::Node::Publisher();
+    return true;
+  }
+
+  if (!this->initialized)
+  {
+    gzerr << "Compressed point clouds require the sensor to be loaded.\n";
+    return false;
+  }
+
+  if (!(_resolution > 0.0))
+  {
+    gzerr << "Invalid point cloud compression resolution [" << _resolution
+          << "], it must be positive.\n";
+    return false;
+  }
+
+  // A new resolution replaces the compressor
+  if (this->dataPtr->pointCompressor &&
+      this->dataPtr->pointCompressor->Resolution() == _resolution)
+  {
+    return true;
+  }
+  this->dataPtr->pointCompressor.reset();
+
+  const std::string topic = this->Topic() + "/compressed";
+  if (!this->dataPtr->compressedPointPub)
+  {
+    this->dataPtr->compressedPointPub =
+        this->dataPtr->node.Advertise<msgs::PointCloudPacked>(topic);
+  }
+  if (!this->dataPtr->compressedPointPub)
+  {
+    gzerr << "Unable to create publisher on topic [" << topic << "].\n";
+    return false;
+  }
+  this->dataPtr->pointCompressor = std::make_unique<PointCloudCompressor>(
+      this->dataPtr->compressedPointPub, _resolution);
+
+  gzdbg << "Compressed points for [" << this->Name() << "] advertised on ["
+        << topic << "]" << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool GpuLidarSensor::CompressedPointsOutput() const
+{
+  return this->dataPtr->pointCompressor != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool GpuLidarSensor::HasCompressedPointConnections() const
+{
+  return this->dataPtr->pointCompressor &&
+         this->dataPtr->compressedPointPub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+bool GpuLidarSensor::SetElevationMapOutput(bool _enabled,
+    double _resolution, unsigned int _size, double _rate)
+{
+  if (!_enabled)
+  {
+    this->dataPtr->elevationMap.reset();
+    this->dataPtr->elevationMapPub = transport::Node::Publisher();
+    return true;
+  }
+
+  if (!this->initialized)
+  {
+    gzerr << "Elevation maps require the sensor to be loaded.\n";
+    return false;
+  }
+
+  if (!(_resolution > 0.0) || _size == 0u || !(_rate >= 0.0))
+  {
+    gzerr << "Invalid elevation map resolution [" << _resolution
+          << "], size [" << _size << "] or rate [" << _rate
+          << "]. The resolution and size must be positive, the rate can't "
+          << "be negative.\n";
+    return false;
+  }
+
+  const std::string topic = this->Topic() + "/elevation_map";
+  if (!this->dataPtr->elevationMapPub)
+  {
+    this->dataPtr->elevationMapPub =
+        this->dataPtr->node.Advertise<msgs::Image>(topic);
+  }
+  if (!this->dataPtr->elevationMapPub)
+  {
+    gzerr << "Unable to create publisher on topic [" << topic << "].\n";
+    return false;
+  }
+
+  // A new grid starts empty, the same one keeps its cells
+  if (!this->dataPtr->elevationMap ||
+      this->dataPtr->elevationMap->Resolution() != _resolution ||
+      this->dataPtr->elevationMap->Size() != _size)
+  {
+    this->dataPtr->elevationMap =
+        std::make_unique<ElevationMap>(_resolution, _size);
+  }
+  this->dataPtr->elevationMapPeriod = _rate > 0.0 ?
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / _rate)) :
+      std::chrono::steady_clock::duration::zero();
+  this->dataPtr->elevationMapPublished = false;
+
+  gzdbg << "Elevation map for [" << this->Name() << "] advertised on ["
+        << topic << "]" << std::endl;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool GpuLidarSensor::ElevationMapOutput() const
+{
+  return this->dataPtr->elevationMap != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool GpuLidarSensor::HasElevationMapConnections() const
+{
+  return this->dataPtr->elevationMap &&
+         this->dataPtr->elevationMapPub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+void GpuLidarSensorPrivate::PublishElevationMap(GpuLidarSensor &_sensor,
+    const std::chrono::steady_clock::duration &_now)
+{
+  // Time going back, after a reset, publishes right away
+  if (this->elevationMapPublished && _now >= this->elevationMapTime &&
+      _now - this->elevationMapTime < this->elevationMapPeriod)
+  {
+    return;
+  }
+
+  GZ_PROFILE("GpuLidarSensor::Update Publish elevation map");
+  msgs::Image msg;
+  _sensor.FillHeader(msg.mutable_header(), _now, "world", "elevation_map");
+  this->elevationMap->FillMsg(msg);
+  _sensor.Publish(this->elevationMapPub, std::move(msg));
+  this->elevationMapTime = _now;
+  this->elevationMapPublished = true;
+}
+
+//////////////////////////////////////////////////
+void GpuLidarSensorPrivate::FillChannelImage(msgs::Image &_msg,
+    const float *_laserBuffer, unsigned int _channel)
+{
+  const unsigned int width = this->ScanWidth();
+  const unsigned int height = this->ScanHeight();
+  const unsigned int channels = this->gpuRays->Channels();
+  const std::size_t count = static_cast<std::size_t>(width) * height;
+
+  if (_msg.width() != width || _msg.height() != height)
+  {
+    _msg.set_width(width);
+    _msg.set_height(height);
+    _msg.set_step(width * sizeof(float));
+    _msg.set_pixel_format_type(msgs::PixelFormatType::R_FLOAT32);
+  }
+
+  std::string *data = _msg.mutable_data();
+  data->resize(count * sizeof(float));
+  char *dst = data->data();
+  const float *src = _laserBuffer + _channel;
+  for (std::size_t i = 0u; i < count; ++i)
+    std::memcpy(dst + i * sizeof(float), src + i * channels, sizeof(float));
+}
+
+//////////////////////////////////////////////////
+void GpuLidarSensorPrivate::InitPointMsg(const std::string &_frameId,
+    double _resolution)
+{
+  // \todo(anyone) Float coordinates force the xyz and intensity fields to be
+  // aligned to memory boundaries. This is need by ROS1:
+  // https://github.com/ros/common_msgs/pull/77. Ideally, memory alignment
+  // should be configured. This same problem is in the RgbdCameraSensor.
+  const uint32_t width = this->pointMsg.width();
+  const uint32_t height = this->pointMsg.height();
+  std::vector<std::pair<std::string,
+      msgs::PointCloudPacked::Field::DataType>> fields{
+      {"intensity", _resolution > 0.0 ?
+          msgs::PointCloudPacked::Field::UINT8 :
+          msgs::PointCloudPacked::Field::FLOAT32},
+      {"ring", msgs::PointCloudPacked::Field::UINT16}};
+  this->timeField = -1;
+  if (this->rollingSlices > 0u)
+  {
+    this->timeField = 3 + static_cast<int>(fields.size());
+    fields.push_back({"t", msgs::PointCloudPacked::Field::FLOAT32});
+  }
+  this->secondReturnField = -1;
+  if (this->returnSamples > 1u)
+  {
+    this->secondReturnField = 3 + static_cast<int>(fields.size());
+    fields.push_back({"range2", msgs::PointCloudPacked::Field::FLOAT32});
+    fields.push_back({"intensity2", fields[0].second});
+  }
+  this->pointsUtil.SetResolution(_resolution);
+  this->pointsUtil.InitMsg(this->pointMsg, _frameId, fields);
+  this->pointMsg.set_width(width);
+  this->pointMsg.set_height(height);
+  this->pointMsg.set_row_step(this->pointMsg.point_step() * width);
+}
+
+//////////////////////////////////////////////////
+void GpuLidarSensorPrivate::UpdateRayDirections(uint32_t _width,
+    uint32_t _height)
+{
+  const std::array<double, 2> scanAngles = this->ScanAngles();
+  const std::array<double, 4> angles{{
+      scanAngles[0], scanAngles[1],
+      this->gpuRays->VerticalAngleMin().Radian(),
+      this->gpuRays->VerticalAngleMax().Radian()}};
+  const std::array<unsigned int, 2> counts{{
+      this->ScanWidth(), this->gpuRays->VerticalRangeCount()}};
+
+  // The beams decide which rendered ray each point samples
+  SharedTableKey key;
+  key.Add(angles).Add(counts).Add(_width).Add(_height)
+      .Add(this->beamElevations).Add(this->beamAzimuthOffsets);
+  if (this->rayDirections && key == this->rayKey)
+    return;
+
+  this->rayKey = key;
+  this->rayDirections = rayDirectionsCache.Get(key, [&]()
+      {
+        return this->BuildRayDirections(angles, counts, _width, _height);
+      });
+}
+
+//////////////////////////////////////////////////
+RayDirections GpuLidarSensorPrivate::BuildRayDirections(
+    const std::array<double, 4> &_angles,
+    const std::array<unsigned int, 2> &_counts,
+    uint32_t _width, uint32_t _height) const
+{
+  const std::size_t size = static_cast<std::size_t>(_width) * _height;
+  RayDirections directions;
+  directions.x.resize(size);
+  directions.y.resize(size);
+  directions.z.resize(size);
+
+  // Angles are computed from their index, so they don't drift along a row
+  const double angleStep = _counts[0] > 1u ?
+      (_angles[1] - _angles[0]) / (_counts[0] - 1u) : 0.0;
+  const double verticalAngleStep = _counts[1] > 1u ?
+      (_angles[3] - _angles[2]) / (_counts[1] - 1u) : 0.0;
+
+  // Rays sampled by a beam table point along the rendered ray they map to
+  const std::vector<uint32_t> &beamIndex = this->BeamIndex();
+  const bool mapped = beamIndex.size() == size && _counts[0] > 0u;
+
+  // Convert spherical coordinates to Cartesian for pointcloud
+  // See https://en.wikipedia.org/wiki/Spherical_coordinate_system
+  for (uint32_t j = 0; j < _height; ++j)
+  {
+    double inclination = _angles[2] + j * verticalAngleStep;
+    if (mapped)
     {
-      // Index of current point, and the depth value at that point
-      auto index = j * width * channels + i * channels;
-      float depth = _laserBuffer[index];
-      // Validate Depth/Radius and update pointcloud density flag
-      if (isDense)
-        isDense = !(gz::math::isnan(depth) || std::isinf(depth));
-
-      float intensity = _laserBuffer[index + 1];
-      uint16_t ring = j;
+      const std::size_t source = beamIndex[
+          static_cast<std::size_t>(j) * _width];
+      inclination = _angles[2] + (source / _counts[0]) * verticalAngleStep;
+    }
+    const double cosInclination = std::cos(inclination);
+    const double sinInclination = std::sin(inclination);
+    for (uint32_t i = 0; i < _width; ++i)
+    {
+      const std::size_t index = static_cast<std::size_t>(j) * _width + i;
+      const double azimuth = _angles[0] + (mapped ?
+          beamIndex[index] % _counts[0] : i) * angleStep;
+      directions.x[index] =
+          static_cast<float>(cosInclination * std::cos(azimuth));
+      directions.y[index] =
+          static_cast<float>(cosInclination * std::sin(azimuth));
+      directions.z[index] = static_cast<float>(sinInclination);
+    }
+  }
+  return directions;
+}
+
+//////////////////////////////////////////////////
+void GpuLidarSensorPrivate::ResetScanStamps(bool _batched)
+{
+  auto *data = this->pointMsg.mutable_header()->mutable_data();
+  for (int i = data->size() - 1; i >= 0; --i)
+  {
+    if (data->Get(i).key() == "scan_stamps")
+      data->DeleteSubrange(i, 1);
+  }
+
+  this->scanStamps = nullptr;
+  if (_batched)
+  {
+    this->scanStamps = data->Add();
+    this->scanStamps->set_key("scan_stamps");
+  }
+}
+
+//////////////////////////////////////////////////
+unsigned int GpuLidarSensorPrivate::ScanHeight() const
+{
+  return this->beamElevations.empty() ?
+      this->gpuRays->VerticalRangeCount() :
+      static_cast<unsigned int>(this->beamElevations.size());
+}
+
+//////////////////////////////////////////////////
+unsigned int GpuLidarSensorPrivate::ScanWidth() const
+{
+  return this->gpuRays->RangeCount() / std::max(this->returnSamples, 1u);
+}
+
+//////////////////////////////////////////////////
+std::array<double, 2> GpuLidarSensorPrivate::ScanAngles() const
+{
+  return {{this->gpuRays->AngleMin().Radian() + this->returnMargin,
+      this->gpuRays->AngleMax().Radian() - this->returnMargin}};
+}
 
-      int fieldIndex = 0;
+//////////////////////////////////////////////////
+const float *GpuLidarSensorPrivate::ReduceReturns(const float *_scan,
+    unsigned int _width, unsigned int _height, unsigned int _channels)
+{
+  GZ_PROFILE("GpuLidarSensorPrivate::ReduceReturns");
+  const unsigned int samples = this->returnSamples;
+  const std::size_t rays =
+      static_cast<std::size_t>(_width / samples) * _height;
+  this->reducedFrame.resize(rays * _channels);
+  this->secondFrame.resize(rays * 2u);
+
+  const float separation = static_cast<float>(this->returnSeparation);
+  for (std::size_t r = 0u; r < rays; ++r)
+  {
+    const float *group = _scan + r * samples * _channels;
+
+    // Strongest return, nearest on ties, and farthest one. Without any
+    // hit the middle sub-ray keeps its out of range value
+    unsigned int strongest = samples / 2u;
+    bool hit = false;
+    float last = 0.0f;
+    float lastIntensity = 0.0f;
+    for (unsigned int s = 0u; s < samples; ++s)
+    {
+      const float range = group[s * _channels];
+      if (!std::isfinite(range))
+        continue;
+      const float intensity = group[s * _channels + 1u];
+      const float bestRange = group[strongest * _channels];
+      const float bestIntensity = group[strongest * _channels + 1u];
+      if (!hit || intensity > bestIntensity ||
+          (intensity == bestIntensity && range < bestRange))
+      {
+        strongest = s;
+      }
+      if (!hit || range > last)
+      {
+        last = range;
+        lastIntensity = intensity;
+      }
+      hit = true;
+    }
 
-      // Convert spherical coordinates to Cartesian for pointcloud
-      // See https://en.wikipedia.org/wiki/Spherical_coordinate_system
-      *reinterpret_cast<float *>(msgBufferIndex +
-          this->pointMsg.field(fieldIndex++).offset()) =
-        depth * std::cos(inclination) * std::cos(azimuth);
+    std::memcpy(this->reducedFrame.data() + r * _channels,
+        group + strongest * _channels, _channels * sizeof(float));
+    const bool second = hit && last - group[strongest * _channels] >=
+        separation;
+    this->secondFrame[r * 2u] =
+        second ? last : std::numeric_limits<float>::infinity();
+    this->secondFrame[r * 2u + 1u] = second ? lastIntensity : 0.0f;
+  }
+  return this->reducedFrame.data();
+}
 
-      *reinterpret_cast<float *>(msgBufferIndex +
-          this->pointMsg.field(fieldIndex++).offset()) =
-        depth * std::cos(inclination) * std::sin(azimuth);
+//////////////////////////////////////////////////
+void GpuLidarSensorPrivate::UpdateBeamIndex()
+{
+  // Ray directions follow the beams
+  this->beamIndex.reset();
+  this->rayDirections.reset();
+  if (this->beamElevations.empty())
+    return;
+
+  const unsigned int width = this->ScanWidth();
+  const unsigned int height = this->gpuRays->VerticalRangeCount();
+  const std::array<double, 2> scanAngles = this->ScanAngles();
+  const double angleMin = scanAngles[0];
+  const double angleMax = scanAngles[1];
+  const double verticalAngleMin = this->gpuRays->VerticalAngleMin().Radian();
+  const double verticalAngleMax = this->gpuRays->VerticalAngleMax().Radian();
+
+  SharedTableKey key;
+  key.Add(width).Add(height).Add(angleMin).Add(angleMax)
+      .Add(verticalAngleMin).Add(verticalAngleMax)
+      .Add(this->beamElevations).Add(this->beamAzimuthOffsets);
+  this->beamIndex = beamIndexCache.Get(key, [&]()
+  {
+    const double angleStep = width > 1u ?
+        (angleMax - angleMin) / (width - 1u) : 0.0;
+    const double verticalAngleStep = height > 1u ?
+        (verticalAngleMax - verticalAngleMin) / (height - 1u) : 0.0;
 
-      *reinterpret_cast<float *>(msgBufferIndex +
-          this->pointMsg.field(fieldIndex++).offset()) =
-        depth * std::sin(inclination);
+    // Offsets wrap around full revolutions and are clamped otherwise
+    const bool fullRevolution =
+        angleMax - angleMin + angleStep >= 2.0 * GZ_PI;
 
-      // Intensity
-      *reinterpret_cast<float *>(msgBufferIndex +
-          this->pointMsg.field(fieldIndex++).offset()) = intensity;
+    std::vector<uint32_t> index(this->beamElevations.size() * width);
+    for (std::size_t b = 0u; b < this->beamElevations.size(); ++b)
+    {
+      // Nearest rendered row of the beam
+      const long row = verticalAngleStep > 0.0 ? std::lround(
+          (this->beamElevations[b] - verticalAngleMin) / verticalAngleStep) :
+          0;
+      const std::size_t rowIndex = static_cast<std::size_t>(
+          std::clamp(row, 0l, static_cast<long>(height) - 1l)) * width;
+
+      const long shift =
+          angleStep > 0.0 && !this->beamAzimuthOffsets.empty() ?
+          std::lround(this->beamAzimuthOffsets[b] / angleStep) : 0;
+      const long columns = static_cast<long>(width);
+      for (unsigned int i = 0u; i < width; ++i)
+      {
+        long column = static_cast<long>(i) + shift;
+        if (fullRevolution)
+          column = ((column % columns) + columns) % columns;
+        else
+          column = std::clamp(column, 0l, columns - 1l);
+        index[b * width + i] = static_cast<uint32_t>(rowIndex + column);
+      }
+    }
+    return index;
+  });
+}
 
-      // Ring
-      *reinterpret_cast<uint16_t *>(msgBufferIndex +
-          this->pointMsg.field(fieldIndex++).offset()) = ring;
+//////////////////////////////////////////////////
+const std::vector<uint32_t> &GpuLidarSensorPrivate::BeamIndex() const
+{
+  static const std::vector<uint32_t> noBeamIndex;
+  return this->beamIndex ? *this->beamIndex : noBeamIndex;
+}
 
-      // Move the index to the next point.
-      msgBufferIndex += this->pointMsg.point_step();
+//////////////////////////////////////////////////
+void GpuLidarSensorPrivate::UpdateSlices(const math::Pose3d &_pose,
+    const std::chrono::steady_clock::duration &_now, double _updateRate)
+{
+  const unsigned int slices = std::min(this->rollingSlices,
+      std::max(this->pointMsg.width(), 1u));
+  this->sliceTransforms.resize(slices);
+  this->sliceTimes.resize(slices);
+
+  // The scan lasts one update period, or the time since the previous
+  // update if there's no rate
+  const double elapsed = this->hasPreviousPose && _now > this->previousTime ?
+      std::chrono::duration<double>(_now - this->previousTime).count() : 0.0;
+  const double period = _updateRate > 0.0 ? 1.0 / _updateRate : elapsed;
+
+  // Pose at the start of the scan, interpolated between the previous and
+  // current poses
+  math::Pose3d start = _pose;
+  if (elapsed > 0.0)
+  {
+    const double f = std::max(0.0, 1.0 - period / elapsed);
+    start.Set(this->previousPose.Pos() +
+        (_pose.Pos() - this->previousPose.Pos()) * f,
+        math::Quaterniond::Slerp(f, this->previousPose.Rot(), _pose.Rot(),
+        true));
+  }
 
-      azimuth += angleStep;
+  for (unsigned int k = 0u; k < slices; ++k)
+  {
+    // Each slice is captured at its end, so the last one has no distortion
+    const double f = static_cast<double>(k + 1u) / slices;
+    const math::Vector3d pos = start.Pos() + (_pose.Pos() - start.Pos()) * f;
+    const math::Quaterniond inverseRot = math::Quaterniond::Slerp(f,
+        start.Rot(), _pose.Rot(), true).Inverse();
+
+    // Transform from the current frame to the frame of the slice
+    const math::Matrix3d rot(inverseRot * _pose.Rot());
+    const math::Vector3d trans = inverseRot.RotateVector(_pose.Pos() - pos);
+    std::array<float, 12> &transform = this->sliceTransforms[k];
+    for (unsigned int r = 0u; r < 3u; ++r)
+    {
+      for (unsigned int c = 0u; c < 3u; ++c)
+        transform[r * 3u + c] = static_cast<float>(rot(r, c));
+      transform[9u + r] = static_cast<float>(trans[r]);
     }
-    inclination += verticleAngleStep;
+    this->sliceTimes[k] = static_cast<float>(-(1.0 - f) * period);
   }
-  this->pointMsg.set_is_dense(isDense);
+}
+
+//////////////////////////////////////////////////
+void GpuLidarSensorPrivate::FillPointCloudMsg(const float *_laserBuffer,
+    std::size_t _offset, const uint8_t *_blanked)
+{
+  GZ_PROFILE("GpuLidarSensorPrivate::FillPointCloudMsg");
+  uint32_t width = this->pointMsg.width();
+  uint32_t height = this->pointMsg.height();
+  unsigned int channels = 3;
+
+  this->UpdateRayDirections(width, height);
+
+  std::string *msgBuffer = this->pointMsg.mutable_data();
+  msgBuffer->resize(_offset + static_cast<std::size_t>(
+      this->pointMsg.row_step()) * this->pointMsg.height());
+  char *msgData = msgBuffer->data() + _offset;
+
+  const uint32_t pointStep = this->pointMsg.point_step();
+  const uint32_t xOffset = this->pointMsg.field(0).offset();
+  const uint32_t yOffset = this->pointMsg.field(1).offset();
+  const uint32_t zOffset = this->pointMsg.field(2).offset();
+  const uint32_t intensityOffset = this->pointMsg.field(3).offset();
+  const uint32_t ringOffset = this->pointMsg.field(4).offset();
+  const bool rolling = this->timeField >= 0 &&
+      this->timeField < this->pointMsg.field_size() &&
+      !this->sliceTransforms.empty();
+  const uint32_t timeOffset =
+      rolling ? this->pointMsg.field(this->timeField).offset() : 0u;
+  const bool dualReturn = this->secondReturnField >= 0 &&
+      this->secondReturnField + 1 < this->pointMsg.field_size() &&
+      this->secondReturn.size() ==
+      static_cast<std::size_t>(width) * height * 2u;
+  const uint32_t range2Offset = dualReturn ?
+      this->pointMsg.field(this->secondReturnField).offset() : 0u;
+  const uint32_t intensity2Offset = dualReturn ?
+      this->pointMsg.field(this->secondReturnField + 1).offset() : 0u;
+  const float *secondReturnData = this->secondReturn.data();
+  const uint64_t slices = this->sliceTransforms.size();
+  const bool quantized = this->pointsUtil.Resolution() > 0.0;
+  const float inverseResolution = quantized ?
+      static_cast<float>(1.0 / this->pointsUtil.Resolution()) : 1.0f;
+  const float *dirX = this->rayDirections->x.data();
+  const float *dirY = this->rayDirections->y.data();
+  const float *dirZ = this->rayDirections->z.data();
+
+  // Set Pointcloud as dense. Change if invalid points are found in any
+  // range of rows.
+  std::atomic<bool> isCloudDense { true };
+
+  // Iterate over scan and populate point cloud
+  this->pointsUtil.ForEachRowRange(height, [&](uint32_t _begin,
+      uint32_t _end)
+  {
+    bool isDense { true };
+    char *msgBufferIndex = msgData +
+        static_cast<std::size_t>(_begin) * width * pointStep;
+    for (uint32_t j = _begin; j < _end; ++j)
+    {
+      const std::size_t rowIndex = static_cast<std::size_t>(j) * width;
+      const float *rowBuffer = _laserBuffer + rowIndex * channels;
+      uint16_t ring = j;
+
+      for (uint32_t i = 0; i < width; ++i)
+      {
+        // Depth value of the current point
+        float depth = rowBuffer[i * channels];
+        // Validate Depth/Radius and update pointcloud density flag
+        if (isDense)
+          isDense = !(gz::math::isnan(depth) || std::isinf(depth));
+
+        float intensity = rowBuffer[i * channels + 1];
+        const float intensity2 = dualReturn ?
+            secondReturnData[(rowIndex + i) * 2u + 1u] : 0.0f;
+
+        // Blanked points are invalid, they aren't projected
+        const bool blank = _blanked && _blanked[rowIndex + i];
+        float x = gz::math::NAN_F;
+        float y = gz::math::NAN_F;
+        float z = gz::math::NAN_F;
+        if (!blank)
+        {
+          x = depth * dirX[rowIndex + i];
+          y = depth * dirY[rowIndex + i];
+          z = depth * dirZ[rowIndex + i];
+        }
+
+        // Move the point to the frame of its slice
+        if (rolling)
+        {
+          const std::size_t slice = i * slices / width;
+          if (!blank)
+          {
+            const std::array<float, 12> &m = this->sliceTransforms[slice];
+            const float px = x;
+            const float py = y;
+            const float pz = z;
+            x = m[0] * px + m[1] * py + m[2] * pz + m[9];
+            y = m[3] * px + m[4] * py + m[5] * pz + m[10];
+            z = m[6] * px + m[7] * py + m[8] * pz + m[11];
+          }
+          std::memcpy(msgBufferIndex + timeOffset, &this->sliceTimes[slice],
+              sizeof(float));
+        }
+
+        if (quantized)
+        {
+          const int16_t xyz[3] = {
+              PointCloudUtil::QuantizeCoordinate(x, inverseResolution),
+              PointCloudUtil::QuantizeCoordinate(y, inverseResolution),
+              PointCloudUtil::QuantizeCoordinate(z, inverseResolution)};
+          std::memcpy(msgBufferIndex + xOffset, &xyz[0], sizeof(int16_t));
+          std::memcpy(msgBufferIndex + yOffset, &xyz[1], sizeof(int16_t));
+          std::memcpy(msgBufferIndex + zOffset, &xyz[2], sizeof(int16_t));
+
+          // Intensity, NaN stored as zero
+          *reinterpret_cast<uint8_t *>(msgBufferIndex + intensityOffset) =
+            intensity > 0.0f ?
+            static_cast<uint8_t>(std::fmin(255.0f, std::round(intensity))) :
+            0u;
+          if (dualReturn)
+          {
+            *reinterpret_cast<uint8_t *>(msgBufferIndex + intensity2Offset) =
+              intensity2 > 0.0f ?
+              static_cast<uint8_t>(std::fmin(255.0f, std::round(intensity2))) :
+              0u;
+          }
+        }
+        else
+        {
+          *reinterpret_cast<float *>(msgBufferIndex + xOffset) = x;
+          *reinterpret_cast<float *>(msgBufferIndex + yOffset) = y;
+          *reinterpret_cast<float *>(msgBufferIndex + zOffset) = z;
+
+          // Intensity
+          *reinterpret_cast<float *>(msgBufferIndex + intensityOffset) =
+            intensity;
+          if (dualReturn)
+          {
+            std::memcpy(msgBufferIndex + intensity2Offset, &intensity2,
+                sizeof(float));
+          }
+        }
+
+        // Last return
+        if (dualReturn)
+        {
+          std::memcpy(msgBufferIndex + range2Offset,
+              &secondReturnData[(rowIndex + i) * 2u], sizeof(float));
+        }
+
+        // Ring
+        std::memcpy(msgBufferIndex + ringOffset, &ring, sizeof(ring));
+
+        // Move the index to the next point.
+        msgBufferIndex += pointStep;
+      }
+    }
+
+    if (!isDense)
+      isCloudDense = false;
+  });
+  // A batch is dense if all its scans are
+  this->pointMsg.set_is_dense(isCloudDense &&
+      (_offset == 0u || this->pointMsg.is_dense()));
 }
@@ -20,6 +20,8 @@
   #include <Winsock2.h>
 #endif
 
+#include <memory>
+
 #include <gz/common/Console.hh>
 
 // TODO(WilliamLewww): Remove these pragmas once gz-rendering is disabling the
@@ -38,6 +40,9 @@
 
 #include "gz/sensors/ImageBrownDistortionModel.hh"
 
+#include "ImageRemap.hh"
+#include "SharedTableCache.hh"
+
 using namespace gz;
 using namespace sensors;
 
@@ -61,10 +66,84 @@ class gz::sensors::ImageBrownDistortionModelPrivate
   /// \brief The distortion center.
   public: math::Vector2d lensCenter = {0.5, 0.5};
 
+  /// \brief Apply the Brown model to a normalized image position, as the
+  /// distortion pass does.
+  /// \param[in] _in Undistorted position.
+  /// \return Distorted position.
+  public: math::Vector2d Apply(const math::Vector2d &_in) const;
+
+  /// \brief Build the remap table of the CPU path.
+  /// \param[in] _width Image width.
+  /// \param[in] _height Image height.
+  /// \return Source pixel of each distorted pixel.
+  public: ImageRemap BuildRemap(unsigned int _width,
+              unsigned int _height) const;
+
   /// \brief The distortion pass.
   public: rendering::DistortionPassPtr distortionPass;
+
+  /// \brief True if the render engine has no distortion pass
+  public: bool distortsOnCpu{false};
+
+  /// \brief Source pixel of each distorted pixel, for the CPU path.
+  /// Shared by the cameras with the same distortion and image size.
+  public: std::shared_ptr<const ImageRemap> remap;
+
+  /// \brief Remap tables shared by all cameras.
+  public: static SharedTableCache<ImageRemap> remapCache;
 };
 
+SharedTableCache<ImageRemap> ImageBrownDistortionModelPrivate::remapCache;
+
+//////////////////////////////////////////////////
+math::Vector2d ImageBrownDistortionModelPrivate::Apply(
+    const math::Vector2d &_in) const
+{
+  const math::Vector2d n = _in - this->lensCenter;
+  const double rSq = n.X() * n.X() + n.Y() * n.Y();
+
+  // radial
+  const double radial = 1.0 + this->k1 * rSq + this->k2 * rSq * rSq +
+      this->k3 * rSq * rSq * rSq;
+  math::Vector2d dist = n * radial;
+
+  // tangential
+  dist.X() += this->p2 * (rSq + 2 * n.X() * n.X()) +
+      2 * this->p1 * n.X() * n.Y();
+  dist.Y() += this->p1 * (rSq + 2 * n.Y() * n.Y()) +
+      2 * this->p2 * n.X() * n.Y();
+  return this->lensCenter + dist;
+}
+
+//////////////////////////////////////////////////
+ImageRemap ImageBrownDistortionModelPrivate::BuildRemap(unsigned int _width,
+    unsigned int _height) const
+{
+  // The model maps undistorted to distorted positions. The source of a
+  // distorted pixel is found by fixed point iteration, which converges
+  // for the distortion magnitudes of real lenses.
+  ImageRemap remap;
+  remap.Build(_width, _height,
+      [this](double &_x, double &_y)
+      {
+        const math::Vector2d target(_x, _y);
+        math::Vector2d source = target;
+        for (int i = 0; i < 20; ++i)
+        {
+          const math::Vector2d error = this->Apply(source) - target;
+          source -= error;
+          if (error.SquaredLength() < 1e-14)
+            break;
+        }
+        if ((this->Apply(source) - target).SquaredLength() > 1e-8)
+          return false;
+        _x = source.X();
+        _y = source.Y();
+        return true;
+      });
+  return remap;
+}
+
 //////////////////////////////////////////////////
 ImageBrownDistortionModel::ImageBrownDistortionModel()
   : BrownDistortionModel(), dataPtr(new ImageBrownDistortionModelPrivate())
@@ -102,28 +181,56 @@ void ImageBrownDistortionModel::SetCamera(rendering::CameraPtr _camera)
 
   rendering::RenderEngine *engine = _camera->Scene()->Engine();
   rendering::RenderPassSystemPtr rpSystem = engine->RenderPassSystem();
-  if (rpSystem)
+  rendering::RenderPassPtr distortionPass = rpSystem ?
+      rpSystem->Create<rendering::DistortionPass>() : nullptr;
+  this->dataPtr->distortsOnCpu = !distortionPass;
+  if (this->dataPtr->distortsOnCpu)
+  {
+    gzwarn << "ImageBrownDistortionModel has no render pass in "
+           << engine->Name() << ", distorting the frames on the CPU"
+           << std::endl;
+    return;
+  }
+
+  // add distortion pass
+  this->dataPtr->distortionPass =
+      std::dynamic_pointer_cast<rendering::DistortionPass>(distortionPass);
+  this->dataPtr->distortionPass->SetK1(this->dataPtr->k1);
+  this->dataPtr->distortionPass->SetK2(this->dataPtr->k2);
+  this->dataPtr->distortionPass->SetK3(this->dataPtr->k3);
+  this->dataPtr->distortionPass->SetP1(this->dataPtr->p1);
+  this->dataPtr->distortionPass->SetP2(this->dataPtr->p2);
+  this->dataPtr->distortionPass->SetCenter(this->dataPtr->lensCenter);
+  this->dataPtr->distortionPass->SetEnabled(true);
+  _camera->AddRenderPass(this->dataPtr->distortionPass);
+}
+
+//////////////////////////////////////////////////
+bool ImageBrownDistortionModel::DistortsOnCpu() const
+{
+  return this->dataPtr->distortsOnCpu;
+}
+
+//////////////////////////////////////////////////
+void ImageBrownDistortionModel::Distort(const unsigned char *_src,
+    unsigned char *_dst, unsigned int _width, unsigned int _height,
+    std::size_t _bytesPerPixel)
+{
+  if (!this->dataPtr->remap ||
+      !this->dataPtr->remap->Matches(_width, _height))
   {
-    // add distortion pass
-    rendering::RenderPassPtr distortionPass =
-      rpSystem->Create<rendering::DistortionPass>();
-    if (!distortionPass)
-    {
-      gzwarn << "ImageBrownDistortionModel is not supported in "
-              << engine->Name() << std::endl;
-      return;
-    }
-    this->dataPtr->distortionPass =
-        std::dynamic_pointer_cast<rendering::DistortionPass>(distortionPass);
-    this->dataPtr->distortionPass->SetK1(this->dataPtr->k1);
-    this->dataPtr->distortionPass->SetK2(this->dataPtr->k2);
-    this->dataPtr->distortionPass->SetK3(this->dataPtr->k3);
-    this->dataPtr->distortionPass->SetP1(this->dataPtr->p1);
-    this->dataPtr->distortionPass->SetP2(this->dataPtr->p2);
-    this->dataPtr->distortionPass->SetCenter(this->dataPtr->lensCenter);
-    this->dataPtr->distortionPass->SetEnabled(true);
-    _camera->AddRenderPass(this->dataPtr->distortionPass);
+    SharedTableKey key;
+    key.Add(this->dataPtr->k1).Add(this->dataPtr->k2)
+        .Add(this->dataPtr->k3).Add(this->dataPtr->p1)
+        .Add(this->dataPtr->p2).Add(this->dataPtr->lensCenter.X())
+        .Add(this->dataPtr->lensCenter.Y()).Add(_width).Add(_height);
+    this->dataPtr->remap = ImageBrownDistortionModelPrivate::remapCache.Get(
+        key, [&]()
+        {
+          return this->dataPtr->BuildRemap(_width, _height);
+        });
   }
+  this->dataPtr->remap->Apply(_src, _dst, _bytesPerPixel);
 }
 
 //////////////////////////////////////////////////
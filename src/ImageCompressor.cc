@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ImageCompressor.hh"
+
+#include <utility>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+ImageCompressor::ImageCompressor(const transport::Node::Publisher &_pub)
+  : pub(_pub)
+{
+}
+
+//////////////////////////////////////////////////
+ImageCompressor::~ImageCompressor()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->cv.notify_one();
+  if (this->thread.joinable())
+    this->thread.join();
+}
+
+//////////////////////////////////////////////////
+void ImageCompressor::Push(const msgs::Image &_image,
+    const unsigned char *_data, std::size_t _size,
+    common::Image::PixelFormatType _format)
+{
+  GZ_PROFILE("ImageCompressor::Push");
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->pending)
+      ++this->dropped;
+
+    this->pendingMsg.set_width(_image.width());
+    this->pendingMsg.set_height(_image.height());
+    this->pendingMsg.set_step(_image.step());
+    this->pendingMsg.set_pixel_format_type(_image.pixel_format_type());
+    this->pendingMsg.mutable_header()->CopyFrom(_image.header());
+    this->pendingData.assign(_data, _data + _size);
+    this->pendingFormat = _format;
+    this->pending = true;
+
+    if (!this->thread.joinable())
+      this->thread = std::thread(&ImageCompressor::Run, this);
+  }
+  this->cv.notify_one();
+}
+
+//////////////////////////////////////////////////
+uint64_t ImageCompressor::DroppedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->dropped;
+}
+
+//////////////////////////////////////////////////
+void ImageCompressor::Run()
+{
+  GZ_PROFILE_THREAD_NAME("ImageCompressor");
+  msgs::Image msg;
+  std::vector<unsigned char> data;
+  std::vector<unsigned char> png;
+  bool reported = false;
+  while (true)
+  {
+    common::Image::PixelFormatType format;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cv.wait(lock, [this]
+      {
+        return this->stop || this->pending;
+      });
+      if (this->stop)
+        return;
+
+      // Swapping keeps both pixel buffers allocated across frames
+      std::swap(data, this->pendingData);
+      msg.Swap(&this->pendingMsg);
+      format = this->pendingFormat;
+      this->pending = false;
+    }
+
+    {
+      GZ_PROFILE("ImageCompressor::Encode");
+      common::Image image;
+      image.SetFromData(data.data(), msg.width(), msg.height(), format);
+      if (!image.Valid())
+      {
+        if (!reported)
+        {
+          gzerr << "Unable to compress image with pixel format ["
+                << format << "].\n";
+          reported = true;
+        }
+        continue;
+      }
+      png.clear();
+      image.SavePNGToBuffer(png);
+    }
+
+    msg.set_data(png.data(), png.size());
+    auto *entry = msg.mutable_header()->add_data();
+    entry->set_key("format");
+    entry->add_value("png");
+
+    GZ_PROFILE("ImageCompressor::Publish");
+    this->pub.Publish(msg);
+  }
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_IMAGECOMPRESSOR_HH_
+#define GZ_SENSORS_IMAGECOMPRESSOR_HH_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gz/common/Image.hh>
+#include <gz/msgs/image.pb.h>
+#include <gz/transport/Node.hh>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Encodes image frames to PNG on a worker thread and publishes
+    /// them. Only the latest frame waits for the worker: a frame pushed
+    /// while another one is waiting replaces it. The worker thread is
+    /// started by the first push.
+    class ImageCompressor
+    {
+      /// \brief Constructor
+      /// \param[in] _pub Publisher of the compressed images.
+      public: explicit ImageCompressor(
+                  const transport::Node::Publisher &_pub);
+
+      /// \brief Destructor. Discards the waiting frame and stops the worker
+      /// thread once the frame being encoded, if any, is published.
+      public: ~ImageCompressor();
+
+      /// \brief Queue a frame for compression.
+      /// \param[in] _image Width, height, step, pixel format and header of
+      /// the frame. Its data field is ignored.
+      /// \param[in] _data Pixels of the frame, copied before returning.
+      /// \param[in] _size Number of bytes in _data.
+      /// \param[in] _format Pixel format of _data.
+      public: void Push(const msgs::Image &_image, const unsigned char *_data,
+                  std::size_t _size, common::Image::PixelFormatType _format);
+
+      /// \brief Get the number of frames replaced before being encoded.
+      /// \return Number of dropped frames.
+      public: uint64_t DroppedCount() const;
+
+      /// \brief Worker thread loop.
+      private: void Run();
+
+      /// \brief Publisher of the compressed images.
+      private: transport::Node::Publisher pub;
+
+      /// \brief Protects the members below.
+      private: mutable std::mutex mutex;
+
+      /// \brief Signals a waiting frame or that the worker must stop.
+      private: std::condition_variable cv;
+
+      /// \brief Metadata of the waiting frame.
+      private: msgs::Image pendingMsg;
+
+      /// \brief Pixels of the waiting frame.
+      private: std::vector<unsigned char> pendingData;
+
+      /// \brief Pixel format of the waiting frame.
+      private: common::Image::PixelFormatType pendingFormat{
+                   common::Image::UNKNOWN_PIXEL_FORMAT};
+
+      /// \brief True if a frame is waiting.
+      private: bool pending{false};
+
+      /// \brief True to stop the worker thread.
+      private: bool stop{false};
+
+      /// \brief Number of frames replaced before being encoded.
+      private: uint64_t dropped{0u};
+
+      /// \brief The worker thread.
+      private: std::thread thread;
+    };
+    }
+  }
+}
+
+#endif
@@ -20,7 +20,16 @@
   #include <Winsock2.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
 #include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
 
 #include <gz/rendering/GaussianNoisePass.hh>
 #include <gz/rendering/RenderPass.hh>
@@ -28,10 +37,29 @@
 #include <gz/rendering/RenderPassSystem.hh>
 
 #include "gz/sensors/ImageGaussianNoiseModel.hh"
+#include "gz/sensors/SensorState.hh"
+
+#include "PhiloxRandom.hh"
+#include "RowWorkers.hh"
 
 using namespace gz;
 using namespace sensors;
 
+namespace
+{
+/// \brief Number of values drawn from the same random stream. Frames are
+/// split in blocks of this size, so the noise doesn't depend on how the
+/// blocks are spread between threads.
+constexpr std::size_t kBlockSize = 16384u;
+
+/// \brief Difference between the seeds of consecutive blocks of a frame.
+constexpr uint64_t kBlockSeedStep = 0x9E3779B97F4A7C15ull;
+
+/// \brief Difference between the seed of the frame stream and the seed
+/// given to SetSeed, so it doesn't repeat the stream of the base class.
+constexpr uint64_t kFrameSeedOffset = 0xD1B54A32D192ED03ull;
+}
+
 class gz::sensors::ImageGaussianNoiseModelPrivate
 {
   /// \brief If type starts with GAUSSIAN, the mean of the distribution
@@ -44,8 +72,91 @@ class gz::sensors::ImageGaussianNoiseModelPrivate
 
   /// \brief Gaussian noise pass.
   public: rendering::GaussianNoisePassPtr gaussianNoisePass;
+
+  /// \brief True if the render engine has no gaussian noise pass.
+  public: bool appliesOnCpu = false;
+
+  /// \brief Stream the seed of each frame applied on the CPU is drawn from.
+  public: PhiloxRandom rng{PhiloxRandom::DefaultSeed()};
+
+  /// \brief Worker threads, null when frames are processed on the calling
+  /// thread.
+  public: std::unique_ptr<RowWorkers> workers;
+
+  /// \brief Apply the noise to a frame on the CPU.
+  /// \tparam T Value type of the frame.
+  /// \param[in,out] _data First value.
+  /// \param[in] _count Number of values.
+  /// \param[in] _scale Value of a full range for integer types, 1 for
+  /// floating point types.
+  public: template <typename T>
+          void Apply(T *_data, std::size_t _count, double _scale);
 };
 
+//////////////////////////////////////////////////
+template <typename T>
+void ImageGaussianNoiseModelPrivate::Apply(T *_data, std::size_t _count,
+    double _scale)
+{
+  if (_count == 0u || (this->stdDev <= 0.0 && this->mean == 0.0))
+    return;
+
+  GZ_PROFILE("ImageGaussianNoiseModel::ApplyToImage");
+  const auto bits = this->rng.Next();
+  const uint64_t frameSeed = (static_cast<uint64_t>(bits[0]) << 32) | bits[1];
+  const double mean = this->mean * _scale;
+  const double stdDev = this->stdDev * _scale;
+  const auto blocks =
+      static_cast<uint32_t>((_count + kBlockSize - 1u) / kBlockSize);
+
+  const std::function<void(uint32_t, uint32_t)> applyBlocks =
+      [&](uint32_t _begin, uint32_t _end)
+  {
+    // Draw the samples of a block first, so the arithmetic below is a
+    // plain loop the compiler can vectorize.
+    thread_local std::vector<double> noise;
+    noise.resize(kBlockSize);
+    for (uint32_t block = _begin; block < _end; ++block)
+    {
+      const std::size_t first = block * kBlockSize;
+      const std::size_t n = std::min(kBlockSize, _count - first);
+      if (stdDev > 0.0)
+      {
+        PhiloxRandom blockRng(frameSeed + block * kBlockSeedStep);
+        blockRng.Normal(noise.data(), n, mean, stdDev);
+      }
+      else
+      {
+        std::fill_n(noise.begin(), n, mean);
+      }
+
+      T *values = _data + first;
+      if constexpr (std::is_floating_point_v<T>)
+      {
+        for (std::size_t i = 0u; i < n; ++i)
+        {
+          values[i] = std::isfinite(values[i]) ?
+              static_cast<T>(values[i] + noise[i]) : values[i];
+        }
+      }
+      else
+      {
+        const double max = std::numeric_limits<T>::max();
+        for (std::size_t i = 0u; i < n; ++i)
+        {
+          const double out = std::round(values[i] + noise[i]);
+          values[i] = static_cast<T>(std::min(std::max(out, 0.0), max));
+        }
+      }
+    }
+  };
+
+  if (this->workers && blocks > 1u)
+    this->workers->Run(blocks, applyBlocks);
+  else
+    applyBlocks(0u, blocks);
+}
+
 //////////////////////////////////////////////////
 ImageGaussianNoiseModel::ImageGaussianNoiseModel()
   : GaussianNoiseModel(), dataPtr(new ImageGaussianNoiseModelPrivate())
@@ -66,6 +177,13 @@ void ImageGaussianNoiseModel::Load(const sdf::Noise &_sdf)
 
   this->dataPtr->mean = _sdf.Mean();
   this->dataPtr->stdDev = _sdf.StdDev();
+
+  // Loading again, e.g. to reconfigure the sensor, updates the render pass
+  if (this->dataPtr->gaussianNoisePass)
+  {
+    this->dataPtr->gaussianNoisePass->SetMean(this->dataPtr->mean);
+    this->dataPtr->gaussianNoisePass->SetStdDev(this->dataPtr->stdDev);
+  }
 }
 
 //////////////////////////////////////////////////
@@ -79,24 +197,91 @@ void ImageGaussianNoiseModel::SetCamera(rendering::CameraPtr _camera)
 
   rendering::RenderEngine *engine = _camera->Scene()->Engine();
   rendering::RenderPassSystemPtr rpSystem = engine->RenderPassSystem();
-  if (rpSystem)
+  rendering::RenderPassPtr noisePass = rpSystem ?
+      rpSystem->Create<rendering::GaussianNoisePass>() : nullptr;
+  this->dataPtr->appliesOnCpu = !noisePass;
+  if (this->dataPtr->appliesOnCpu)
   {
-    // add gaussian noise pass
-    rendering::RenderPassPtr noisePass =
-      rpSystem->Create<rendering::GaussianNoisePass>();
-    if (!noisePass)
-    {
-      gzwarn << "ImageGaussianNoiseModel is not supported in "
-             << engine->Name() << std::endl;
-      return;
-    }
-    this->dataPtr->gaussianNoisePass =
-        std::dynamic_pointer_cast<rendering::GaussianNoisePass>(noisePass);
-    this->dataPtr->gaussianNoisePass->SetMean(this->dataPtr->mean);
-    this->dataPtr->gaussianNoisePass->SetStdDev(this->dataPtr->stdDev);
-    this->dataPtr->gaussianNoisePass->SetEnabled(true);
-    _camera->AddRenderPass(this->dataPtr->gaussianNoisePass);
+    gzwarn << "ImageGaussianNoiseModel has no render pass in "
+           << engine->Name() << ", applying the noise to the frames on the "
+           << "CPU" << std::endl;
+    return;
   }
+
+  // add gaussian noise pass
+  this->dataPtr->gaussianNoisePass =
+      std::dynamic_pointer_cast<rendering::GaussianNoisePass>(noisePass);
+  this->dataPtr->gaussianNoisePass->SetMean(this->dataPtr->mean);
+  this->dataPtr->gaussianNoisePass->SetStdDev(this->dataPtr->stdDev);
+  this->dataPtr->gaussianNoisePass->SetEnabled(true);
+  _camera->AddRenderPass(this->dataPtr->gaussianNoisePass);
+}
+
+//////////////////////////////////////////////////
+bool ImageGaussianNoiseModel::AppliesOnCpu() const
+{
+  return this->dataPtr->appliesOnCpu;
+}
+
+//////////////////////////////////////////////////
+void ImageGaussianNoiseModel::SetThreadCount(unsigned int _count)
+{
+  if (_count == 0u)
+    _count = 1u;
+  if (_count == this->ThreadCount())
+    return;
+
+  this->dataPtr->workers.reset();
+  if (_count > 1u)
+    this->dataPtr->workers = std::make_unique<RowWorkers>(_count);
+}
+
+//////////////////////////////////////////////////
+unsigned int ImageGaussianNoiseModel::ThreadCount() const
+{
+  return this->dataPtr->workers ? this->dataPtr->workers->Count() : 1u;
+}
+
+//////////////////////////////////////////////////
+void ImageGaussianNoiseModel::ApplyToImage(unsigned char *_data,
+    std::size_t _count)
+{
+  this->dataPtr->Apply(_data, _count,
+      std::numeric_limits<unsigned char>::max());
+}
+
+//////////////////////////////////////////////////
+void ImageGaussianNoiseModel::ApplyToImage(uint16_t *_data,
+    std::size_t _count)
+{
+  this->dataPtr->Apply(_data, _count, std::numeric_limits<uint16_t>::max());
+}
+
+//////////////////////////////////////////////////
+void ImageGaussianNoiseModel::ApplyToImage(float *_data, std::size_t _count)
+{
+  this->dataPtr->Apply(_data, _count, 1.0);
+}
+
+//////////////////////////////////////////////////
+void ImageGaussianNoiseModel::SetSeed(uint64_t _seed)
+{
+  GaussianNoiseModel::SetSeed(_seed);
+  this->dataPtr->rng = PhiloxRandom(_seed + kFrameSeedOffset);
+}
+
+//////////////////////////////////////////////////
+void ImageGaussianNoiseModel::SaveState(SensorState &_state) const
+{
+  GaussianNoiseModel::SaveState(_state);
+  _state.Write(this->dataPtr->rng);
+}
+
+//////////////////////////////////////////////////
+bool ImageGaussianNoiseModel::RestoreState(SensorState &_state)
+{
+  return GaussianNoiseModel::RestoreState(_state) &&
+      _state.Read(this->dataPtr->rng);
 }
 
 //////////////////////////////////////////////////
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <sdf/Noise.hh>
+
+#include "gz/sensors/ImageGaussianNoiseModel.hh"
+#include "gz/sensors/SensorState.hh"
+
+using namespace gz;
+
+/////////////////////////////////////////////////
+/// \brief Create a noise model applied on the CPU.
+/// \param[in] _mean Mean.
+/// \param[in] _stdDev Standard deviation.
+/// \return The noise model.
+std::shared_ptr<sensors::ImageGaussianNoiseModel> CpuNoise(double _mean,
+    double _stdDev)
+{
+  sdf::Noise noiseSdf;
+  noiseSdf.SetType(sdf::NoiseType::GAUSSIAN);
+  noiseSdf.SetMean(_mean);
+  noiseSdf.SetStdDev(_stdDev);
+
+  auto noise = std::make_shared<sensors::ImageGaussianNoiseModel>();
+  noise->Load(noiseSdf);
+  noise->SetSeed(7u);
+  return noise;
+}
+
+/////////////////////////////////////////////////
+TEST(ImageGaussianNoiseModelTest, Statistics)
+{
+  auto noise = CpuNoise(0.5, 0.2);
+  EXPECT_FALSE(noise->AppliesOnCpu());
+
+  std::vector<float> values(100000u, 2.0f);
+  noise->ApplyToImage(values.data(), values.size());
+
+  double sum = 0.0;
+  double sumSq = 0.0;
+  for (float value : values)
+  {
+    sum += value;
+    sumSq += value * value;
+  }
+  const double mean = sum / values.size();
+  const double variance = sumSq / values.size() - mean * mean;
+  EXPECT_NEAR(2.5, mean, 0.01);
+  EXPECT_NEAR(0.2, std::sqrt(variance), 0.01);
+
+  // The integer formats scale the noise by their full range
+  std::vector<uint16_t> depths(100000u, 30000u);
+  noise = CpuNoise(0.25, 0.0);
+  noise->ApplyToImage(depths.data(), depths.size());
+  for (uint16_t depth : depths)
+    EXPECT_EQ(46384u, depth);
+}
+
+/////////////////////////////////////////////////
+TEST(ImageGaussianNoiseModelTest, Clamp)
+{
+  auto noise = CpuNoise(0.0, 1.0);
+  std::vector<unsigned char> pixels(3000u, 128u);
+  noise->ApplyToImage(pixels.data(), pixels.size());
+
+  unsigned int low = 0u;
+  unsigned int high = 0u;
+  for (unsigned char pixel : pixels)
+  {
+    low += pixel == 0u;
+    high += pixel == 255u;
+  }
+  // With a standard deviation of the full range most values saturate
+  EXPECT_GT(low, 500u);
+  EXPECT_GT(high, 500u);
+}
+
+/////////////////////////////////////////////////
+TEST(ImageGaussianNoiseModelTest, NonFinite)
+{
+  auto noise = CpuNoise(0.0, 0.1);
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> values = {1.0f, inf, -inf,
+      std::numeric_limits<float>::quiet_NaN(), 1.0f};
+  noise->ApplyToImage(values.data(), values.size());
+
+  EXPECT_NE(1.0f, values[0]);
+  EXPECT_EQ(inf, values[1]);
+  EXPECT_EQ(-inf, values[2]);
+  EXPECT_TRUE(std::isnan(values[3]));
+  EXPECT_NE(1.0f, values[4]);
+}
+
+/////////////////////////////////////////////////
+TEST(ImageGaussianNoiseModelTest, Threads)
+{
+  // Large enough for several blocks per thread
+  std::vector<float> expected(200000u, 1.0f);
+  auto noise = CpuNoise(0.0, 0.1);
+  EXPECT_EQ(1u, noise->ThreadCount());
+  noise->ApplyToImage(expected.data(), expected.size());
+
+  std::vector<float> values(expected.size(), 1.0f);
+  noise = CpuNoise(0.0, 0.1);
+  noise->SetThreadCount(4u);
+  EXPECT_EQ(4u, noise->ThreadCount());
+  noise->ApplyToImage(values.data(), values.size());
+  EXPECT_EQ(expected, values);
+
+  // Frames get different noise
+  std::vector<float> next(expected.size(), 1.0f);
+  noise->ApplyToImage(next.data(), next.size());
+  EXPECT_NE(values, next);
+
+  noise->SetThreadCount(0u);
+  EXPECT_EQ(1u, noise->ThreadCount());
+}
+
+/////////////////////////////////////////////////
+TEST(ImageGaussianNoiseModelTest, SaveState)
+{
+  auto noise = CpuNoise(0.0, 0.1);
+  std::vector<unsigned char> pixels(1000u, 100u);
+  noise->ApplyToImage(pixels.data(), pixels.size());
+
+  sensors::SensorState state;
+  noise->SaveState(state);
+  std::vector<unsigned char> expected(1000u, 100u);
+  noise->ApplyToImage(expected.data(), expected.size());
+
+  // The restored model applies the same noise to the next frame
+  EXPECT_TRUE(noise->RestoreState(state));
+  EXPECT_TRUE(state.AtEnd());
+  std::vector<unsigned char> values(1000u, 100u);
+  noise->ApplyToImage(values.data(), values.size());
+  EXPECT_EQ(expected, values);
+
+  sensors::SensorState empty;
+  EXPECT_FALSE(noise->RestoreState(empty));
+}
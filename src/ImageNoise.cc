@@ -26,6 +26,8 @@
 #include "gz/sensors/ImageNoise.hh"
 #include "gz/sensors/ImageGaussianNoiseModel.hh"
 
+#include "TraceRecorder.hh"
+
 using namespace gz;
 using namespace sensors;
 
@@ -33,6 +35,7 @@ using namespace sensors;
 NoisePtr ImageNoiseFactory::NewNoiseModel(const sdf::Noise &_sdf,
     const std::string &_sensorType)
 {
+  TraceScope trace("create_noise", kFactoryTraceTrack);
   sdf::NoiseType noiseType = _sdf.Type();
 
   NoisePtr noise;
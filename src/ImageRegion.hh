@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_IMAGEREGION_HH_
+#define GZ_SENSORS_IMAGEREGION_HH_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Region of an image that is published, and the decimation
+    /// applied to it.
+    struct ImageRegion
+    {
+      /// \brief Column of the first pixel.
+      unsigned int x{0u};
+
+      /// \brief Row of the first pixel.
+      unsigned int y{0u};
+
+      /// \brief Number of columns of the region in the full image.
+      unsigned int width{0u};
+
+      /// \brief Number of rows of the region in the full image.
+      unsigned int height{0u};
+
+      /// \brief One pixel out of decimation is kept in each direction.
+      unsigned int decimation{1u};
+
+      /// \brief Get the width of the output image.
+      /// \return Number of columns kept.
+      unsigned int OutputWidth() const
+      {
+        return (this->width + this->decimation - 1u) / this->decimation;
+      }
+
+      /// \brief Get the height of the output image.
+      /// \return Number of rows kept.
+      unsigned int OutputHeight() const
+      {
+        return (this->height + this->decimation - 1u) / this->decimation;
+      }
+
+      /// \brief Get whether the region is the full image.
+      /// \param[in] _width Width of the full image.
+      /// \param[in] _height Height of the full image.
+      /// \return True if the output is the full image.
+      bool IsFull(unsigned int _width, unsigned int _height) const
+      {
+        return this->decimation <= 1u && this->x == 0u && this->y == 0u &&
+            this->width == _width && this->height == _height;
+      }
+    };
+
+    /// \brief Clamp a requested region of interest to an image.
+    /// \param[in] _x Requested first column.
+    /// \param[in] _y Requested first row.
+    /// \param[in] _width Requested width, zero for the full width.
+    /// \param[in] _height Requested height, zero for the full height.
+    /// \param[in] _decimation Requested decimation, zero is treated as one.
+    /// \param[in] _imageWidth Width of the image.
+    /// \param[in] _imageHeight Height of the image.
+    /// \return Region inside the image, empty if the image is.
+    inline ImageRegion ClampImageRegion(unsigned int _x, unsigned int _y,
+        unsigned int _width, unsigned int _height, unsigned int _decimation,
+        unsigned int _imageWidth, unsigned int _imageHeight)
+    {
+      ImageRegion region;
+      region.decimation = std::max(_decimation, 1u);
+      if (_imageWidth == 0u || _imageHeight == 0u)
+        return region;
+      region.x = std::min(_x, _imageWidth - 1u);
+      region.y = std::min(_y, _imageHeight - 1u);
+      region.width = _imageWidth - region.x;
+      region.height = _imageHeight - region.y;
+      if (_width > 0u)
+        region.width = std::min(region.width, _width);
+      if (_height > 0u)
+        region.height = std::min(region.height, _height);
+      return region;
+    }
+
+    /// \brief Average blocks of _factor by _factor pixels of an image.
+    /// Columns and rows that don't fill a whole block are dropped.
+    /// \param[in] _src Source image, rows stored contiguously.
+    /// \param[in] _srcWidth Width of the source image.
+    /// \param[in] _srcHeight Height of the source image.
+    /// \param[in] _channels Number of channels of a pixel.
+    /// \param[in] _factor Size of the blocks.
+    /// \param[in,out] _sums Storage for the block sums of a row, kept by the
+    /// caller across frames.
+    /// \param[out] _dst Output image of _srcWidth / _factor by
+    /// _srcHeight / _factor pixels.
+    template <typename T>
+    void BinImage(const T *_src, unsigned int _srcWidth,
+        unsigned int _srcHeight, unsigned int _channels, unsigned int _factor,
+        std::vector<uint32_t> &_sums, T *_dst)
+    {
+      const unsigned int width = _srcWidth / _factor;
+      const unsigned int height = _srcHeight / _factor;
+      const std::size_t rowValues = static_cast<std::size_t>(width) *
+          _channels;
+      const uint32_t count = _factor * _factor;
+      _sums.resize(rowValues);
+
+      for (unsigned int row = 0u; row < height; ++row)
+      {
+        std::fill(_sums.begin(), _sums.end(), 0u);
+        for (unsigned int i = 0u; i < _factor; ++i)
+        {
+          const T *in = _src + (static_cast<std::size_t>(row) * _factor + i) *
+              _srcWidth * _channels;
+          for (unsigned int col = 0u; col < width; ++col)
+          {
+            uint32_t *sum = _sums.data() + col * _channels;
+            for (unsigned int j = 0u; j < _factor; ++j)
+            {
+              for (unsigned int c = 0u; c < _channels; ++c)
+                sum[c] += in[c];
+              in += _channels;
+            }
+          }
+        }
+
+        T *out = _dst + row * rowValues;
+        for (std::size_t k = 0u; k < rowValues; ++k)
+          out[k] = static_cast<T>((_sums[k] + count / 2u) / count);
+      }
+    }
+
+    /// \brief Copy the decimated rows of a region, with a pixel size known
+    /// at compile time so that the copy of each pixel is a single load and
+    /// store the compiler can unroll.
+    /// \param[in] _src First pixel of the region.
+    /// \param[in] _srcStep Number of bytes of a row of the source image.
+    /// \param[in] _width Output width.
+    /// \param[in] _height Output height.
+    /// \param[in] _decimation Decimation factor.
+    /// \param[out] _dst Output pixels.
+    template <std::size_t BytesPerPixel>
+    void DecimateImageRegion(const unsigned char *_src, std::size_t _srcStep,
+        unsigned int _width, unsigned int _height, unsigned int _decimation,
+        unsigned char *_dst)
+    {
+      const std::size_t pixelStride = BytesPerPixel * _decimation;
+      const std::size_t rowStride = _srcStep * _decimation;
+      for (unsigned int row = 0u; row < _height; ++row)
+      {
+        const unsigned char *in = _src + row * rowStride;
+        for (unsigned int col = 0u; col < _width; ++col)
+        {
+          std::memcpy(_dst, in, BytesPerPixel);
+          _dst += BytesPerPixel;
+          in += pixelStride;
+        }
+      }
+    }
+
+    /// \brief Copy a region of an image, keeping one pixel out of
+    /// ImageRegion::decimation in each direction.
+    /// \param[in] _src Source image, rows stored contiguously.
+    /// \param[in] _srcWidth Width of the source image.
+    /// \param[in] _bytesPerPixel Number of bytes of a pixel.
+    /// \param[in] _region Region to copy, inside the source image.
+    /// \param[out] _dst Output image of _region.OutputWidth() by
+    /// _region.OutputHeight() pixels.
+    inline void CopyImageRegion(const unsigned char *_src,
+        unsigned int _srcWidth, std::size_t _bytesPerPixel,
+        const ImageRegion &_region, unsigned char *_dst)
+    {
+      const std::size_t srcStep = _srcWidth * _bytesPerPixel;
+      const unsigned char *start =
+          _src + _region.y * srcStep + _region.x * _bytesPerPixel;
+      const unsigned int width = _region.OutputWidth();
+      const unsigned int height = _region.OutputHeight();
+
+      if (_region.decimation <= 1u)
+      {
+        const std::size_t rowSize = width * _bytesPerPixel;
+        for (unsigned int row = 0u; row < height; ++row)
+          std::memcpy(_dst + row * rowSize, start + row * srcStep, rowSize);
+        return;
+      }
+
+      switch (_bytesPerPixel)
+      {
+        case 1u:
+          DecimateImageRegion<1u>(start, srcStep, width, height,
+              _region.decimation, _dst);
+          break;
+        case 2u:
+          DecimateImageRegion<2u>(start, srcStep, width, height,
+              _region.decimation, _dst);
+          break;
+        case 3u:
+          DecimateImageRegion<3u>(start, srcStep, width, height,
+              _region.decimation, _dst);
+          break;
+        case 4u:
+          DecimateImageRegion<4u>(start, srcStep, width, height,
+              _region.decimation, _dst);
+          break;
+        default:
+          for (unsigned int row = 0u; row < height; ++row)
+          {
+            const unsigned char *in = start + row * _region.decimation *
+                srcStep;
+            for (unsigned int col = 0u; col < width; ++col)
+            {
+              std::memcpy(_dst, in, _bytesPerPixel);
+              _dst += _bytesPerPixel;
+              in += _bytesPerPixel * _region.decimation;
+            }
+          }
+          break;
+      }
+    }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_IMAGEREMAP_HH_
+#define GZ_SENSORS_IMAGEREMAP_HH_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Remap table of an image: the source pixel of each output
+    /// pixel. The table is built once from a mapping function, so applying
+    /// it is a single gather pass whose cost doesn't depend on the
+    /// mapping. Sources are the nearest pixel.
+    class ImageRemap
+    {
+      /// \brief Mapping from an output position to its source position.
+      /// Positions are normalized to [0, 1] across the image, with pixel
+      /// centers at (i + 0.5) / size.
+      /// \param[in,out] _x Horizontal output position, set to the source.
+      /// \param[in,out] _y Vertical output position, set to the source.
+      /// \return False if the output pixel has no source and stays black.
+      public: using Mapping = std::function<bool(double &_x, double &_y)>;
+
+      /// \brief Source index of the output pixels without a source.
+      public: static constexpr uint32_t kNoSource = UINT32_MAX;
+
+      /// \brief Build the table.
+      /// \param[in] _width Image width.
+      /// \param[in] _height Image height.
+      /// \param[in] _mapping Mapping from output to source positions.
+      public: void Build(unsigned int _width, unsigned int _height,
+                  const Mapping &_mapping)
+      {
+        this->Build(_width, _height, _width, _height, _mapping);
+      }
+
+      /// \brief Build the table for a source of another size. Source
+      /// positions are normalized across the source image.
+      /// \param[in] _width Output image width.
+      /// \param[in] _height Output image height.
+      /// \param[in] _srcWidth Source image width.
+      /// \param[in] _srcHeight Source image height.
+      /// \param[in] _mapping Mapping from output to source positions.
+      public: void Build(unsigned int _width, unsigned int _height,
+                  unsigned int _srcWidth, unsigned int _srcHeight,
+                  const Mapping &_mapping)
+      {
+        this->width = _width;
+        this->height = _height;
+        this->sources.resize(static_cast<std::size_t>(_width) * _height);
+        std::size_t index = 0u;
+        for (unsigned int v = 0u; v < _height; ++v)
+        {
+          for (unsigned int u = 0u; u < _width; ++u, ++index)
+          {
+            double x = (u + 0.5) / _width;
+            double y = (v + 0.5) / _height;
+            this->sources[index] = kNoSource;
+            if (!_mapping(x, y))
+              continue;
+            const double col = std::floor(x * _srcWidth);
+            const double row = std::floor(y * _srcHeight);
+            if (col >= 0.0 && col < _srcWidth && row >= 0.0 &&
+                row < _srcHeight)
+            {
+              this->sources[index] = static_cast<uint32_t>(
+                  static_cast<std::size_t>(row) * _srcWidth +
+                  static_cast<std::size_t>(col));
+            }
+          }
+        }
+      }
+
+      /// \brief Get whether the table was built for an image size.
+      /// \param[in] _width Image width.
+      /// \param[in] _height Image height.
+      /// \return True if Build was called with this size.
+      public: bool Matches(unsigned int _width, unsigned int _height) const
+      {
+        return !this->sources.empty() && this->width == _width &&
+            this->height == _height;
+      }
+
+      /// \brief Get the source index of each output pixel.
+      /// \return Row-major source indices, kNoSource for black pixels.
+      public: const std::vector<uint32_t> &Sources() const
+      {
+        return this->sources;
+      }
+
+      /// \brief Remap an image.
+      /// \param[in] _src Source image, rows stored contiguously, of the
+      /// source size given to Build.
+      /// \param[out] _dst Output image, of the output size given to Build.
+      /// Must not overlap _src.
+      /// \param[in] _bytesPerPixel Number of bytes of a pixel.
+      public: void Apply(const unsigned char *_src, unsigned char *_dst,
+                  std::size_t _bytesPerPixel) const
+      {
+        // Fixed pixel sizes turn the copies into plain loads and stores
+        switch (_bytesPerPixel)
+        {
+          case 1u:
+            this->Gather<1u>(_src, _dst);
+            break;
+          case 2u:
+            this->Gather<2u>(_src, _dst);
+            break;
+          case 3u:
+            this->Gather<3u>(_src, _dst);
+            break;
+          case 4u:
+            this->Gather<4u>(_src, _dst);
+            break;
+          default:
+            for (std::size_t i = 0u; i < this->sources.size(); ++i)
+            {
+              unsigned char *out = _dst + i * _bytesPerPixel;
+              if (this->sources[i] == kNoSource)
+                std::memset(out, 0, _bytesPerPixel);
+              else
+                std::memcpy(out, _src + this->sources[i] * _bytesPerPixel,
+                    _bytesPerPixel);
+            }
+            break;
+        }
+      }
+
+      /// \brief Gather pass for a pixel size.
+      /// \param[in] _src Source image.
+      /// \param[out] _dst Output image.
+      private: template <std::size_t N>
+      void Gather(const unsigned char *_src, unsigned char *_dst) const
+      {
+        const unsigned char black[N] = {};
+        const std::size_t count = this->sources.size();
+        const uint32_t *sourceIndex = this->sources.data();
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+          const uint32_t s = sourceIndex[i];
+          std::memcpy(_dst + i * N,
+              s == kNoSource ? black : _src + static_cast<std::size_t>(s) * N,
+              N);
+        }
+      }
+
+      /// \brief Image width.
+      private: unsigned int width{0u};
+
+      /// \brief Image height.
+      private: unsigned int height{0u};
+
+      /// \brief Source index of each output pixel.
+      private: std::vector<uint32_t> sources;
+    };
+    }
+  }
+}
+
+#endif
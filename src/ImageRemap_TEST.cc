@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "ImageRemap.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(ImageRemap, Identity)
+{
+  ImageRemap remap;
+  EXPECT_FALSE(remap.Matches(4u, 3u));
+  remap.Build(4u, 3u, [](double &, double &) { return true; });
+  EXPECT_TRUE(remap.Matches(4u, 3u));
+  EXPECT_FALSE(remap.Matches(3u, 4u));
+
+  std::vector<unsigned char> src(4u * 3u * 3u);
+  for (std::size_t i = 0u; i < src.size(); ++i)
+    src[i] = static_cast<unsigned char>(i);
+  std::vector<unsigned char> dst(src.size(), 0xff);
+  remap.Apply(src.data(), dst.data(), 3u);
+  EXPECT_EQ(src, dst);
+}
+
+//////////////////////////////////////////////////
+TEST(ImageRemap, MirrorAndBlack)
+{
+  // Mirror the columns, pixels of the bottom row have no source
+  ImageRemap remap;
+  remap.Build(4u, 2u, [](double &_x, double &_y)
+  {
+    _x = 1.0 - _x;
+    return _y < 0.5;
+  });
+
+  const std::vector<uint32_t> expected = {3u, 2u, 1u, 0u,
+      ImageRemap::kNoSource, ImageRemap::kNoSource, ImageRemap::kNoSource,
+      ImageRemap::kNoSource};
+  EXPECT_EQ(expected, remap.Sources());
+
+  for (std::size_t bytesPerPixel : {1u, 2u, 3u, 4u, 6u})
+  {
+    std::vector<unsigned char> src(8u * bytesPerPixel);
+    for (std::size_t i = 0u; i < src.size(); ++i)
+      src[i] = static_cast<unsigned char>(i + 1u);
+    std::vector<unsigned char> dst(src.size(), 0xff);
+    remap.Apply(src.data(), dst.data(), bytesPerPixel);
+    for (std::size_t p = 0u; p < 8u; ++p)
+    {
+      for (std::size_t c = 0u; c < bytesPerPixel; ++c)
+      {
+        const unsigned char value = p < 4u ?
+            src[(3u - p) * bytesPerPixel + c] : 0u;
+        EXPECT_EQ(value, dst[p * bytesPerPixel + c])
+            << "pixel " << p << " bytes " << bytesPerPixel;
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ImageRemap, OutsideSource)
+{
+  // Sources outside of the image are black
+  ImageRemap remap;
+  remap.Build(2u, 2u, [](double &_x, double &)
+  {
+    _x += 0.5;
+    return true;
+  });
+  const std::vector<uint32_t> expected = {1u, ImageRemap::kNoSource,
+      3u, ImageRemap::kNoSource};
+  EXPECT_EQ(expected, remap.Sources());
+}
+
+//////////////////////////////////////////////////
+TEST(ImageRemap, SourceSize)
+{
+  // Sample the two halves of a 2x4 source side by side into a 4x2 image
+  ImageRemap remap;
+  remap.Build(4u, 2u, 2u, 4u, [](double &_x, double &_y)
+  {
+    const bool right = _x >= 0.5;
+    _x = right ? (_x - 0.5) * 2.0 : _x * 2.0;
+    _y = right ? (_y * 0.5 + 0.5) : (_y * 0.5);
+    return true;
+  });
+  EXPECT_TRUE(remap.Matches(4u, 2u));
+  EXPECT_FALSE(remap.Matches(2u, 4u));
+  const std::vector<uint32_t> expected = {0u, 1u, 4u, 5u, 2u, 3u, 6u, 7u};
+  EXPECT_EQ(expected, remap.Sources());
+
+  std::vector<unsigned char> src(8u);
+  for (std::size_t i = 0u; i < src.size(); ++i)
+    src[i] = static_cast<unsigned char>(i);
+  std::vector<unsigned char> dst(src.size(), 0xff);
+  remap.Apply(src.data(), dst.data(), 1u);
+  EXPECT_EQ(std::vector<unsigned char>(expected.begin(), expected.end()),
+      dst);
+}
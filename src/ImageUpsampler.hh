@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_IMAGEUPSAMPLER_HH_
+#define GZ_SENSORS_IMAGEUPSAMPLER_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Bilinear resize of images rendered at a lower resolution to
+    /// the published resolution. The source pixels and weights of each row
+    /// and column are computed once per pair of sizes, pixel centers are
+    /// aligned and weights have 8 fractional bits.
+    class ImageUpsampler
+    {
+      /// \brief Set the source and destination sizes. Nothing is done if
+      /// they didn't change.
+      /// \param[in] _srcWidth Width of the source image.
+      /// \param[in] _srcHeight Height of the source image.
+      /// \param[in] _dstWidth Width of the destination image.
+      /// \param[in] _dstHeight Height of the destination image.
+      public: void Configure(unsigned int _srcWidth, unsigned int _srcHeight,
+                  unsigned int _dstWidth, unsigned int _dstHeight)
+      {
+        if (_srcWidth == this->srcWidth && _srcHeight == this->srcHeight &&
+            _dstWidth == this->dstWidth && _dstHeight == this->dstHeight)
+        {
+          return;
+        }
+        this->srcWidth = _srcWidth;
+        this->srcHeight = _srcHeight;
+        this->dstWidth = _dstWidth;
+        this->dstHeight = _dstHeight;
+        Taps(_srcWidth, _dstWidth, this->columns);
+        Taps(_srcHeight, _dstHeight, this->rows);
+      }
+
+      /// \brief Resize an image.
+      /// \param[in] _src Source pixels, rows of srcWidth pixels.
+      /// \param[out] _dst Destination pixels, rows of dstWidth pixels.
+      /// \param[in] _channels Channels per pixel.
+      /// \tparam T Channel type, 8 or 16 bit unsigned integer.
+      public: template <typename T>
+              void Apply(const T *_src, T *_dst, unsigned int _channels) const
+      {
+        const std::size_t srcStep =
+            static_cast<std::size_t>(this->srcWidth) * _channels;
+        for (const Tap &row : this->rows)
+        {
+          const T *top = _src + row.first * srcStep;
+          const T *bottom = _src + row.second * srcStep;
+          const uint64_t wy = row.weight;
+          for (const Tap &col : this->columns)
+          {
+            const std::size_t a = col.first * _channels;
+            const std::size_t b = col.second * _channels;
+            const uint64_t wx = col.weight;
+            for (unsigned int c = 0u; c < _channels; ++c)
+            {
+              const uint64_t upper =
+                  top[a + c] * (256u - wx) + top[b + c] * wx;
+              const uint64_t lower =
+                  bottom[a + c] * (256u - wx) + bottom[b + c] * wx;
+              *_dst++ = static_cast<T>(
+                  (upper * (256u - wy) + lower * wy + 32768u) >> 16);
+            }
+          }
+        }
+      }
+
+      /// \brief Source pixels of a destination row or column and the weight
+      /// of the second one.
+      private: struct Tap
+      {
+        /// \brief First source pixel.
+        std::size_t first;
+
+        /// \brief Second source pixel.
+        std::size_t second;
+
+        /// \brief Weight of the second source pixel, out of 256.
+        uint32_t weight;
+      };
+
+      /// \brief Compute the taps of one dimension.
+      /// \param[in] _src Source size.
+      /// \param[in] _dst Destination size.
+      /// \param[out] _taps One tap per destination pixel.
+      private: static void Taps(unsigned int _src, unsigned int _dst,
+                   std::vector<Tap> &_taps)
+      {
+        _taps.resize(_dst);
+        if (_src == 0u)
+          return;
+        const double ratio = static_cast<double>(_src) / _dst;
+        for (unsigned int i = 0u; i < _dst; ++i)
+        {
+          const double pos = std::clamp((i + 0.5) * ratio - 0.5, 0.0,
+              static_cast<double>(_src - 1u));
+          const std::size_t first = static_cast<std::size_t>(pos);
+          _taps[i].first = first;
+          _taps[i].second = std::min<std::size_t>(first + 1u, _src - 1u);
+          _taps[i].weight = static_cast<uint32_t>(
+              std::lround((pos - first) * 256.0));
+        }
+      }
+
+      /// \brief Width of the source image.
+      private: unsigned int srcWidth{0u};
+
+      /// \brief Height of the source image.
+      private: unsigned int srcHeight{0u};
+
+      /// \brief Width of the destination image.
+      private: unsigned int dstWidth{0u};
+
+      /// \brief Height of the destination image.
+      private: unsigned int dstHeight{0u};
+
+      /// \brief Taps of the destination columns.
+      private: std::vector<Tap> columns;
+
+      /// \brief Taps of the destination rows.
+      private: std::vector<Tap> rows;
+    };
+    }
+  }
+}
+
+#endif
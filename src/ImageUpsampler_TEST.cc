@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "ImageUpsampler.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(ImageUpsampler, SameSize)
+{
+  const std::vector<uint8_t> src{1u, 2u, 3u, 4u, 5u, 6u};
+  ImageUpsampler upsampler;
+  upsampler.Configure(3u, 2u, 3u, 2u);
+  std::vector<uint8_t> dst(6u);
+  upsampler.Apply(src.data(), dst.data(), 1u);
+  EXPECT_EQ(src, dst);
+}
+
+/////////////////////////////////////////////////
+TEST(ImageUpsampler, Double)
+{
+  // Two pixels, 0 and 200, interpolated with aligned centers
+  const std::vector<uint8_t> src{0u, 200u};
+  ImageUpsampler upsampler;
+  upsampler.Configure(2u, 1u, 4u, 2u);
+  std::vector<uint8_t> dst(8u);
+  upsampler.Apply(src.data(), dst.data(), 1u);
+  EXPECT_EQ((std::vector<uint8_t>{0u, 50u, 150u, 200u,
+                                  0u, 50u, 150u, 200u}), dst);
+}
+
+/////////////////////////////////////////////////
+TEST(ImageUpsampler, Channels)
+{
+  // 1x1 RGB image to 2x2
+  const std::vector<uint8_t> src{10u, 20u, 30u};
+  ImageUpsampler upsampler;
+  upsampler.Configure(1u, 1u, 2u, 2u);
+  std::vector<uint8_t> dst(12u);
+  upsampler.Apply(src.data(), dst.data(), 3u);
+  for (unsigned int i = 0u; i < 4u; ++i)
+  {
+    EXPECT_EQ(10u, dst[i * 3u]);
+    EXPECT_EQ(20u, dst[i * 3u + 1u]);
+    EXPECT_EQ(30u, dst[i * 3u + 2u]);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(ImageUpsampler, Wide)
+{
+  const std::vector<uint16_t> src{65535u, 65535u, 0u, 65535u};
+  ImageUpsampler upsampler;
+  upsampler.Configure(2u, 2u, 4u, 4u);
+  std::vector<uint16_t> dst(16u);
+  upsampler.Apply(src.data(), dst.data(), 1u);
+  EXPECT_EQ(65535u, dst[0]);
+  EXPECT_EQ(0u, dst[12]);
+  EXPECT_EQ(65535u, dst[15]);
+  // Between the four pixels
+  EXPECT_EQ(53247u, dst[5]);
+  EXPECT_EQ(28672u, dst[9]);
+}
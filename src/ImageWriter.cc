@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "gz/sensors/ImageWriter.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief An image waiting to be written.
+struct ImageJob
+{
+  /// \brief Path of the file.
+  std::string filename;
+
+  /// \brief Pixels of the image.
+  std::vector<unsigned char> data;
+
+  /// \brief Image width.
+  unsigned int width{0u};
+
+  /// \brief Image height.
+  unsigned int height{0u};
+
+  /// \brief Pixel format of data.
+  common::Image::PixelFormatType format{common::Image::UNKNOWN_PIXEL_FORMAT};
+};
+}
+
+/// \brief Private data class for ImageWriter
+class gz::sensors::ImageWriterPrivate
+{
+  /// \brief Queue an image, applying the drop policy.
+  /// \param[in] _job The image.
+  /// \return False if the image was dropped.
+  public: bool Push(ImageJob &&_job);
+
+  /// \brief Start workerCount threads. Must be called with mutex locked.
+  public: void StartWorkers();
+
+  /// \brief Write the queued images and join the threads.
+  public: void StopWorkers();
+
+  /// \brief Thread loop.
+  public: void Run();
+
+  /// \brief Protects the members below.
+  public: mutable std::mutex mutex;
+
+  /// \brief Signals queued images or that the threads must stop.
+  public: std::condition_variable workCv;
+
+  /// \brief Signals room in the queue.
+  public: std::condition_variable spaceCv;
+
+  /// \brief Signals that the queue is empty and no image is being written.
+  public: std::condition_variable idleCv;
+
+  /// \brief Images waiting to be written.
+  public: std::deque<ImageJob> jobs;
+
+  /// \brief Maximum size of jobs.
+  public: std::size_t depth{64u};
+
+  /// \brief What to do when jobs is full.
+  public: ImageDropPolicy policy{ImageDropPolicy::BLOCK};
+
+  /// \brief Number of threads to run.
+  public: unsigned int workerCount{1u};
+
+  /// \brief Running threads.
+  public: std::vector<std::thread> workers;
+
+  /// \brief Number of images being written.
+  public: unsigned int busy{0u};
+
+  /// \brief True to make the threads exit once jobs is empty.
+  public: bool stop{false};
+
+  /// \brief Number of dropped images.
+  public: uint64_t dropped{0u};
+};
+
+//////////////////////////////////////////////////
+void ImageWriterPrivate::StartWorkers()
+{
+  for (unsigned int i = 0; i < this->workerCount; ++i)
+    this->workers.emplace_back(&ImageWriterPrivate::Run, this);
+}
+
+//////////////////////////////////////////////////
+void ImageWriterPrivate::StopWorkers()
+{
+  std::vector<std::thread> threads;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+    std::swap(threads, this->workers);
+  }
+  this->workCv.notify_all();
+  for (auto &thread : threads)
+    thread.join();
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->stop = false;
+}
+
+//////////////////////////////////////////////////
+bool ImageWriterPrivate::Push(ImageJob &&_job)
+{
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (this->workers.empty())
+      this->StartWorkers();
+
+    if (this->jobs.size() >= this->depth)
+    {
+      switch (this->policy)
+      {
+        case ImageDropPolicy::DROP_NEWEST:
+          ++this->dropped;
+          return false;
+        case ImageDropPolicy::DROP_OLDEST:
+          while (this->jobs.size() >= this->depth)
+          {
+            this->jobs.pop_front();
+            ++this->dropped;
+          }
+          break;
+        case ImageDropPolicy::BLOCK:
+        default:
+        {
+          GZ_PROFILE("ImageWriter::Wait");
+          this->spaceCv.wait(lock, [this]
+          {
+            return this->jobs.size() < this->depth;
+          });
+          break;
+        }
+      }
+    }
+    this->jobs.push_back(std::move(_job));
+  }
+  this->workCv.notify_one();
+  return true;
+}
+
+//////////////////////////////////////////////////
+void ImageWriterPrivate::Run()
+{
+  GZ_PROFILE_THREAD_NAME("ImageWriter");
+  while (true)
+  {
+    ImageJob job;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->workCv.wait(lock, [this]
+      {
+        return this->stop || !this->jobs.empty();
+      });
+      // Queued images are written before stopping
+      if (this->jobs.empty())
+        return;
+      job = std::move(this->jobs.front());
+      this->jobs.pop_front();
+      ++this->busy;
+    }
+    this->spaceCv.notify_one();
+
+    {
+      GZ_PROFILE("ImageWriter::Write");
+      common::Image image;
+      image.SetFromData(job.data.data(), job.width, job.height, job.format);
+      if (image.Valid())
+        image.SavePNG(job.filename);
+      else
+        gzerr << "Unable to save image [" << job.filename << "].\n";
+    }
+
+    bool idle = false;
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      --this->busy;
+      idle = this->jobs.empty() && this->busy == 0u;
+    }
+    if (idle)
+      this->idleCv.notify_all();
+  }
+}
+
+//////////////////////////////////////////////////
+ImageWriter::ImageWriter()
+  : dataPtr(new ImageWriterPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+ImageWriter::~ImageWriter()
+{
+  this->dataPtr->StopWorkers();
+}
+
+//////////////////////////////////////////////////
+ImageWriter &ImageWriter::Instance()
+{
+  static ImageWriter writer;
+  return writer;
+}
+
+//////////////////////////////////////////////////
+void ImageWriter::SetWorkerCount(unsigned int _count)
+{
+  _count = std::max(_count, 1u);
+  bool restart = false;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    if (_count == this->dataPtr->workerCount)
+      return;
+    this->dataPtr->workerCount = _count;
+    restart = !this->dataPtr->workers.empty();
+  }
+
+  if (restart)
+  {
+    this->dataPtr->StopWorkers();
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    if (this->dataPtr->workers.empty())
+      this->dataPtr->StartWorkers();
+  }
+}
+
+//////////////////////////////////////////////////
+unsigned int ImageWriter::WorkerCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->workerCount;
+}
+
+//////////////////////////////////////////////////
+void ImageWriter::SetQueueDepth(std::size_t _depth)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->depth = std::max<std::size_t>(_depth, 1u);
+  }
+  this->dataPtr->spaceCv.notify_all();
+}
+
+//////////////////////////////////////////////////
+std::size_t ImageWriter::QueueDepth() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->depth;
+}
+
+//////////////////////////////////////////////////
+void ImageWriter::SetDropPolicy(ImageDropPolicy _policy)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->policy = _policy;
+}
+
+//////////////////////////////////////////////////
+ImageDropPolicy ImageWriter::DropPolicy() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->policy;
+}
+
+//////////////////////////////////////////////////
+bool ImageWriter::Write(const std::string &_filename,
+    std::vector<unsigned char> &&_data, unsigned int _width,
+    unsigned int _height, common::Image::PixelFormatType _format)
+{
+  ImageJob job;
+  job.filename = _filename;
+  job.data = std::move(_data);
+  job.width = _width;
+  job.height = _height;
+  job.format = _format;
+  return this->dataPtr->Push(std::move(job));
+}
+
+//////////////////////////////////////////////////
+bool ImageWriter::Write(const std::string &_filename,
+    const unsigned char *_data, std::size_t _size, unsigned int _width,
+    unsigned int _height, common::Image::PixelFormatType _format)
+{
+  return this->Write(_filename,
+      std::vector<unsigned char>(_data, _data + _size), _width, _height,
+      _format);
+}
+
+//////////////////////////////////////////////////
+void ImageWriter::Flush()
+{
+  std::unique_lock<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->idleCv.wait(lock, [this]
+  {
+    return this->dataPtr->jobs.empty() && this->dataPtr->busy == 0u;
+  });
+}
+
+//////////////////////////////////////////////////
+uint64_t ImageWriter::DroppedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->dropped;
+}
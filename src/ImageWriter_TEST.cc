@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Filesystem.hh>
+
+#include "gz/sensors/ImageWriter.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Test ImageWriter
+class ImageWriter_TEST : public ::testing::Test
+{
+  // Documentation inherited
+  protected: void SetUp() override
+  {
+    common::Console::SetVerbosity(4);
+    this->path = common::joinPaths(::testing::TempDir(),
+        "gz_sensors_image_writer");
+    common::removeAll(this->path);
+    ASSERT_TRUE(common::createDirectories(this->path));
+  }
+
+  // Documentation inherited
+  protected: void TearDown() override
+  {
+    auto &writer = ImageWriter::Instance();
+    writer.Flush();
+    writer.SetWorkerCount(1u);
+    writer.SetQueueDepth(64u);
+    writer.SetDropPolicy(ImageDropPolicy::BLOCK);
+    common::removeAll(this->path);
+  }
+
+  /// \brief Get the path of an image file.
+  /// \param[in] _index Image index.
+  /// \return Path of the file.
+  protected: std::string File(int _index) const
+  {
+    return common::joinPaths(this->path,
+        "image_" + std::to_string(_index) + ".png");
+  }
+
+  /// \brief Directory the images are written to.
+  protected: std::string path;
+};
+
+//////////////////////////////////////////////////
+TEST_F(ImageWriter_TEST, Defaults)
+{
+  auto &writer = ImageWriter::Instance();
+  EXPECT_EQ(&writer, &ImageWriter::Instance());
+  EXPECT_EQ(1u, writer.WorkerCount());
+  EXPECT_EQ(64u, writer.QueueDepth());
+  EXPECT_EQ(ImageDropPolicy::BLOCK, writer.DropPolicy());
+
+  writer.SetWorkerCount(0u);
+  EXPECT_EQ(1u, writer.WorkerCount());
+  writer.SetQueueDepth(0u);
+  EXPECT_EQ(1u, writer.QueueDepth());
+}
+
+//////////////////////////////////////////////////
+TEST_F(ImageWriter_TEST, WriteBlocking)
+{
+  auto &writer = ImageWriter::Instance();
+  writer.SetWorkerCount(3u);
+  writer.SetQueueDepth(2u);
+  const uint64_t dropped = writer.DroppedCount();
+
+  // Blocking keeps every image even with a short queue
+  std::vector<unsigned char> pixels(16u * 8u * 3u, 128u);
+  for (int i = 0; i < 20; ++i)
+  {
+    EXPECT_TRUE(writer.Write(this->File(i), pixels.data(), pixels.size(),
+        16u, 8u, common::Image::RGB_INT8));
+  }
+  writer.Flush();
+  EXPECT_EQ(dropped, writer.DroppedCount());
+
+  for (int i = 0; i < 20; ++i)
+  {
+    ASSERT_TRUE(common::isFile(this->File(i))) << this->File(i);
+    common::Image image(this->File(i));
+    EXPECT_EQ(16u, image.Width());
+    EXPECT_EQ(8u, image.Height());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST_F(ImageWriter_TEST, DropNewest)
+{
+  auto &writer = ImageWriter::Instance();
+  writer.SetQueueDepth(1u);
+  writer.SetDropPolicy(ImageDropPolicy::DROP_NEWEST);
+  const uint64_t dropped = writer.DroppedCount();
+
+  std::vector<unsigned char> pixels(512u * 512u * 3u, 64u);
+  unsigned int queued = 0u;
+  for (int i = 0; i < 20; ++i)
+  {
+    if (writer.Write(this->File(i), std::vector<unsigned char>(pixels),
+        512u, 512u, common::Image::RGB_INT8))
+    {
+      ++queued;
+    }
+  }
+  writer.Flush();
+
+  // Every image is either written or counted as dropped
+  EXPECT_EQ(20u, queued + writer.DroppedCount() - dropped);
+  unsigned int written = 0u;
+  for (int i = 0; i < 20; ++i)
+    written += common::isFile(this->File(i)) ? 1u : 0u;
+  EXPECT_EQ(queued, written);
+  EXPECT_TRUE(common::isFile(this->File(0)));
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_IMUBATCHSTATE_HH_
+#define GZ_SENSORS_IMUBATCHSTATE_HH_
+
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <gz/math/Quaternion.hh>
+#include <gz/math/Vector3.hh>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Orientation, gravity and linear acceleration of a group of
+    /// imus, stored as one contiguous array per component so the gravity
+    /// compensation of the whole group runs two imus at a time.
+    class ImuBatchState
+    {
+      /// \brief Set the number of imus. The state of the imus kept is
+      /// unchanged.
+      /// \param[in] _size Number of imus.
+      public: void Resize(std::size_t _size)
+      {
+        for (auto *component : {&this->qw, &this->qx, &this->qy, &this->qz,
+            &this->gx, &this->gy, &this->gz, &this->ax, &this->ay, &this->az})
+        {
+          component->resize(_size);
+        }
+      }
+
+      /// \brief Get the number of imus.
+      /// \return Number of imus.
+      public: std::size_t Size() const
+      {
+        return this->qw.size();
+      }
+
+      /// \brief Set the state of an imu.
+      /// \param[in] _index Index of the imu, less than Size().
+      /// \param[in] _rot World orientation of the imu.
+      /// \param[in] _gravity Gravity in the world frame.
+      /// \param[in] _linearAcc Linear acceleration in the imu frame.
+      public: void Set(std::size_t _index, const math::Quaterniond &_rot,
+          const math::Vector3d &_gravity, const math::Vector3d &_linearAcc)
+      {
+        // The inverse of a zero orientation, within its tolerance, is the
+        // identity
+        const double norm = _rot.W() * _rot.W() + _rot.X() * _rot.X() +
+            _rot.Y() * _rot.Y() + _rot.Z() * _rot.Z();
+        const bool valid = norm > 1e-6;
+        this->qw[_index] = valid ? _rot.W() : 1.0;
+        this->qx[_index] = valid ? _rot.X() : 0.0;
+        this->qy[_index] = valid ? _rot.Y() : 0.0;
+        this->qz[_index] = valid ? _rot.Z() : 0.0;
+        this->gx[_index] = _gravity.X();
+        this->gy[_index] = _gravity.Y();
+        this->gz[_index] = _gravity.Z();
+        this->ax[_index] = _linearAcc.X();
+        this->ay[_index] = _linearAcc.Y();
+        this->az[_index] = _linearAcc.Z();
+      }
+
+      /// \brief Subtract gravity, rotated into the frame of each imu, from
+      /// its linear acceleration. The rotated gravity is the same as
+      /// _rot.Inverse().RotateVector(_gravity), including for orientations
+      /// that aren't normalized.
+      public: void RemoveGravity()
+      {
+        // Rotate by the conjugate q* v q, then divide by the squared norm
+        // as the inverse does:
+        // v' = ((w^2 - u.u) v + 2 (u.v) u - 2 w (u x v)) / |q|^2
+        const std::size_t count = this->Size();
+        const double *w = this->qw.data();
+        const double *x = this->qx.data();
+        const double *y = this->qy.data();
+        const double *z = this->qz.data();
+        const double *vx = this->gx.data();
+        const double *vy = this->gy.data();
+        const double *vz = this->gz.data();
+        double *rx = this->ax.data();
+        double *ry = this->ay.data();
+        double *rz = this->az.data();
+        std::size_t i = 0;
+#if defined(__SSE2__)
+        const __m128d two = _mm_set1_pd(2.0);
+        for (; i + 2 <= count; i += 2)
+        {
+          const __m128d qw = _mm_loadu_pd(w + i);
+          const __m128d qx = _mm_loadu_pd(x + i);
+          const __m128d qy = _mm_loadu_pd(y + i);
+          const __m128d qz = _mm_loadu_pd(z + i);
+          const __m128d gx = _mm_loadu_pd(vx + i);
+          const __m128d gy = _mm_loadu_pd(vy + i);
+          const __m128d gz = _mm_loadu_pd(vz + i);
+          const __m128d ww = _mm_mul_pd(qw, qw);
+          const __m128d uu = _mm_add_pd(_mm_add_pd(_mm_mul_pd(qx, qx),
+              _mm_mul_pd(qy, qy)), _mm_mul_pd(qz, qz));
+          const __m128d scale =
+              _mm_div_pd(_mm_set1_pd(1.0), _mm_add_pd(ww, uu));
+          const __m128d s = _mm_sub_pd(ww, uu);
+          const __m128d uv = _mm_mul_pd(two, _mm_add_pd(_mm_add_pd(
+              _mm_mul_pd(qx, gx), _mm_mul_pd(qy, gy)), _mm_mul_pd(qz, gz)));
+          const __m128d w2 = _mm_mul_pd(two, qw);
+          const __m128d cx =
+              _mm_sub_pd(_mm_mul_pd(qy, gz), _mm_mul_pd(qz, gy));
+          const __m128d cy =
+              _mm_sub_pd(_mm_mul_pd(qz, gx), _mm_mul_pd(qx, gz));
+          const __m128d cz =
+              _mm_sub_pd(_mm_mul_pd(qx, gy), _mm_mul_pd(qy, gx));
+          const __m128d lx = _mm_mul_pd(_mm_sub_pd(_mm_add_pd(
+              _mm_mul_pd(s, gx), _mm_mul_pd(uv, qx)), _mm_mul_pd(w2, cx)),
+              scale);
+          const __m128d ly = _mm_mul_pd(_mm_sub_pd(_mm_add_pd(
+              _mm_mul_pd(s, gy), _mm_mul_pd(uv, qy)), _mm_mul_pd(w2, cy)),
+              scale);
+          const __m128d lz = _mm_mul_pd(_mm_sub_pd(_mm_add_pd(
+              _mm_mul_pd(s, gz), _mm_mul_pd(uv, qz)), _mm_mul_pd(w2, cz)),
+              scale);
+          _mm_storeu_pd(rx + i, _mm_sub_pd(_mm_loadu_pd(rx + i), lx));
+          _mm_storeu_pd(ry + i, _mm_sub_pd(_mm_loadu_pd(ry + i), ly));
+          _mm_storeu_pd(rz + i, _mm_sub_pd(_mm_loadu_pd(rz + i), lz));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+          const double ww = w[i] * w[i];
+          const double uu = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+          const double scale = 1.0 / (ww + uu);
+          const double s = ww - uu;
+          const double uv =
+              2.0 * (x[i] * vx[i] + y[i] * vy[i] + z[i] * vz[i]);
+          const double w2 = 2.0 * w[i];
+          const double cx = y[i] * vz[i] - z[i] * vy[i];
+          const double cy = z[i] * vx[i] - x[i] * vz[i];
+          const double cz = x[i] * vy[i] - y[i] * vx[i];
+          rx[i] -= (s * vx[i] + uv * x[i] - w2 * cx) * scale;
+          ry[i] -= (s * vy[i] + uv * y[i] - w2 * cy) * scale;
+          rz[i] -= (s * vz[i] + uv * z[i] - w2 * cz) * scale;
+        }
+      }
+
+      /// \brief Get the linear acceleration of an imu.
+      /// \param[in] _index Index of the imu, less than Size().
+      /// \return Linear acceleration in the imu frame.
+      public: math::Vector3d LinearAcceleration(std::size_t _index) const
+      {
+        return math::Vector3d(
+            this->ax[_index], this->ay[_index], this->az[_index]);
+      }
+
+      /// \brief Orientation components.
+      private: std::vector<double> qw, qx, qy, qz;
+
+      /// \brief Gravity components, in the world frame.
+      private: std::vector<double> gx, gy, gz;
+
+      /// \brief Linear acceleration components, in the imu frame.
+      private: std::vector<double> ax, ay, az;
+    };
+    }
+  }
+}
+
+#endif
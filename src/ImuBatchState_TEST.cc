@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <gz/math/Quaternion.hh>
+#include <gz/math/Vector3.hh>
+
+#include "ImuBatchState.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(ImuBatchState_TEST, RemoveGravity)
+{
+  const math::Vector3d gravity(0.1, -0.2, -9.8);
+  const std::vector<math::Quaterniond> rotations = {
+    math::Quaterniond(1, 0, 0, 0),
+    math::Quaterniond(0.3, -1.2, 0.7),
+    math::Quaterniond(-2.5, 0.4, 3.0),
+    // Not normalized
+    math::Quaterniond(2.0, 0.5, -1.0, 0.25),
+    // Zero, treated as the identity
+    math::Quaterniond(0, 0, 0, 0),
+  };
+
+  ImuBatchState state;
+  state.Resize(rotations.size());
+  EXPECT_EQ(rotations.size(), state.Size());
+  for (std::size_t i = 0; i < rotations.size(); ++i)
+  {
+    state.Set(i, rotations[i], gravity,
+        math::Vector3d(1.0 * i, 2.0, -3.0 * i));
+  }
+  state.RemoveGravity();
+
+  for (std::size_t i = 0; i < rotations.size(); ++i)
+  {
+    const math::Vector3d expected = math::Vector3d(1.0 * i, 2.0, -3.0 * i) -
+        rotations[i].Inverse().RotateVector(gravity);
+    EXPECT_EQ(expected, state.LinearAcceleration(i)) << i;
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(ImuBatchState_TEST, Resize)
+{
+  ImuBatchState state;
+  EXPECT_EQ(0u, state.Size());
+
+  state.Resize(2);
+  state.Set(0, math::Quaterniond(1, 0, 0, 0), math::Vector3d(0, 0, -9.8),
+      math::Vector3d(1, 2, 3));
+  state.Resize(3);
+  EXPECT_EQ(3u, state.Size());
+  EXPECT_EQ(math::Vector3d(1, 2, 3), state.LinearAcceleration(0));
+
+  // Removing no gravity leaves the accelerations unchanged
+  state.Set(1, math::Quaterniond(0.5, 0.5, 0.5, 0.5), math::Vector3d(),
+      math::Vector3d(4, 5, 6));
+  state.Resize(2);
+  state.RemoveGravity();
+  EXPECT_EQ(math::Vector3d(1, 2, 3 + 9.8), state.LinearAcceleration(0));
+  EXPECT_EQ(math::Vector3d(4, 5, 6), state.LinearAcceleration(1));
+}
@@ -24,6 +24,12 @@
   #pragma warning(pop)
 #endif
 
+#include <chrono>
+#include <cstdint>
+#include <typeinfo>
+#include <vector>
+
+#include <gz/common/Event.hh>
 #include <gz/common/Profiler.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
@@ -33,13 +39,53 @@
 #include "gz/sensors/Noise.hh"
 #include "gz/sensors/SensorFactory.hh"
 #include "gz/sensors/SensorTypes.hh"
+#include "ImuBatchState.hh"
+#include "InputInterpolation.hh"
+#include "NoisePipeline.hh"
+#include "SeqLock.hh"
+#include "SignalFilter.hh"
 
 using namespace gz;
 using namespace sensors;
 
+/// \brief Trivially copyable copy of an ImuSample.
+struct ImuSampleData
+{
+  /// \brief Time of the update in nanoseconds.
+  int64_t time;
+
+  /// \brief Orientation as w, x, y, z.
+  double orientation[4];
+
+  /// \brief Angular velocity as x, y, z.
+  double angularVelocity[3];
+
+  /// \brief Linear acceleration as x, y, z.
+  double linearAcceleration[3];
+
+  /// \brief True if orientation is enabled.
+  bool hasOrientation;
+};
+
 /// \brief Private data for ImuSensor
 class gz::sensors::ImuSensorPrivate
 {
+  /// \brief Apply noise to the current readings, then fill and publish a
+  /// message.
+  /// \param[in] _sensor The sensor that owns this data.
+  /// \param[in] _now The current time.
+  /// \param[in] _localGravity Gravity rotated into the sensor frame.
+  public: void GenerateData(ImuSensor &_sensor,
+              const std::chrono::steady_clock::duration &_now,
+              const math::Vector3d &_localGravity);
+
+  /// \brief Event triggered with the output of each update.
+  public: gz::common::EventT<void(const ImuSample &)> sampleEvent;
+
+  /// \brief Output of the last update, read by LatestSample.
+  public: SeqLock<ImuSampleData> latest{
+      ImuSampleData{0, {1, 0, 0, 0}, {0, 0, 0}, {0, 0, 0}, false}};
+
   /// \brief node to create publisher
   public: transport::Node node;
 
@@ -95,13 +141,231 @@ class gz::sensors::ImuSensorPrivate
     {std::chrono::steady_clock::duration::zero()};
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief Noise of the accelerometer and gyroscope axes, resolved when
+  /// the sensor loads.
+  public: NoisePipeline<6> noisePipeline;
+
+  /// \brief Filter of the accelerometer and gyroscope axes, after noise.
+  public: SignalFilter<6> filter;
+
+  /// \brief Fill the fields of msg that don't change between updates.
+  /// \param[in] _sensor The sensor.
+  public: void InitMessage(const ImuSensor &_sensor);
+
+  /// \brief Message reused by every update. Only the header, orientation,
+  /// angular velocity and linear acceleration change between updates.
+  public: msgs::IMU msg;
+
+  /// \brief Get the time elapsed since the previous step.
+  /// \param[in] _now Current time.
+  /// \return Elapsed time in seconds, or zero if time is not initialized
+  /// or went backwards.
+  public: double StepDt(const std::chrono::steady_clock::duration &_now);
+
+  /// \brief Replace the readings with their averages over the integrated
+  /// interval and reset the accumulators.
+  /// \return Length of the interval in seconds, zero if nothing was
+  /// integrated.
+  public: double TakeIntegrated();
+
+  /// \brief True to integrate readings between updates.
+  public: bool integrationEnabled = false;
+
+  /// \brief True once Integrate() has recorded a time.
+  public: bool integrationTimeInitialized = false;
+
+  /// \brief Time of the previous call to Integrate().
+  public: std::chrono::steady_clock::duration prevIntegrationStep
+    {std::chrono::steady_clock::duration::zero()};
+
+  /// \brief Time integrated since the previous update, in seconds.
+  public: double integratedTime = 0.0;
+
+  /// \brief Sum of the delta angles since the previous update.
+  public: math::Vector3d integratedAngle;
+
+  /// \brief Sum of the delta velocities since the previous update.
+  public: math::Vector3d integratedVelocity;
+
+  /// \brief Coning correction accumulated since the previous update.
+  public: math::Vector3d coning;
+
+  /// \brief Sculling correction accumulated since the previous update.
+  public: math::Vector3d sculling;
+
+  /// \brief Delta angle of the last integrated update.
+  public: math::Vector3d deltaAngle;
+
+  /// \brief Delta velocity of the last integrated update.
+  public: math::Vector3d deltaVelocity;
 };
 
+//////////////////////////////////////////////////
+double ImuSensorPrivate::TakeIntegrated()
+{
+  const double interval = this->integratedTime;
+  if (interval <= 0.0)
+    return 0.0;
+
+  const math::Vector3d &alpha = this->integratedAngle;
+  const math::Vector3d &nu = this->integratedVelocity;
+
+  // The velocity increments are summed in the frame at the start of the
+  // interval, add the rotation compensation to first order.
+  this->angularVel = (alpha + this->coning) / interval;
+  this->linearAcc = (nu + 0.5 * alpha.Cross(nu) + this->sculling) / interval;
+
+  this->integratedTime = 0.0;
+  this->integratedAngle = math::Vector3d::Zero;
+  this->integratedVelocity = math::Vector3d::Zero;
+  this->coning = math::Vector3d::Zero;
+  this->sculling = math::Vector3d::Zero;
+  return interval;
+}
+
+//////////////////////////////////////////////////
+double ImuSensorPrivate::StepDt(
+    const std::chrono::steady_clock::duration &_now)
+{
+  // If time has gone backwards, reinitialize.
+  if (_now < this->prevStep)
+  {
+    this->timeInitialized = false;
+  }
+
+  // Only compute dt if time is initialized and increasing.
+  double dt;
+  if (this->timeInitialized)
+  {
+    auto delay = std::chrono::duration_cast<std::chrono::duration<float>>(
+        _now - this->prevStep);
+    dt = delay.count();
+  }
+  else
+  {
+    dt = 0.0;
+  }
+  return dt;
+}
+
+//////////////////////////////////////////////////
+void ImuSensorPrivate::InitMessage(const ImuSensor &_sensor)
+{
+  this->msg.Clear();
+  this->msg.set_entity_name(_sensor.Name());
+
+  // Populate covariance
+  for (int i = 0; i < 9; ++i) {
+    this->msg.mutable_linear_acceleration_covariance()->add_data(0);
+    this->msg.mutable_angular_velocity_covariance()->add_data(0);
+    this->msg.mutable_orientation_covariance()->add_data(0);
+  }
+
+  auto getCov = [&](SensorNoiseType noiseType) -> float{
+    if (this->noises[noiseType]) {
+      GaussianNoiseModelPtr gaussian =
+        std::dynamic_pointer_cast<GaussianNoiseModel>(
+            this->noises[noiseType]);
+      if (gaussian) {
+        return static_cast<float>(gaussian->StdDev() * gaussian->StdDev());
+      }
+    }
+    return 0.0f;
+  };
+
+  this->msg.mutable_linear_acceleration_covariance()->set_data(
+      0, getCov(ACCELEROMETER_X_NOISE_M_S_S));
+  this->msg.mutable_linear_acceleration_covariance()->set_data(
+      4, getCov(ACCELEROMETER_Y_NOISE_M_S_S));
+  this->msg.mutable_linear_acceleration_covariance()->set_data(
+      8, getCov(ACCELEROMETER_Z_NOISE_M_S_S));
+  this->msg.mutable_angular_velocity_covariance()->set_data(
+      0, getCov(GYROSCOPE_X_NOISE_RAD_S));
+  this->msg.mutable_angular_velocity_covariance()->set_data(
+      4, getCov(GYROSCOPE_Y_NOISE_RAD_S));
+  this->msg.mutable_angular_velocity_covariance()->set_data(
+      8, getCov(GYROSCOPE_Z_NOISE_RAD_S));
+}
+
+//////////////////////////////////////////////////
+void ImuSensorPrivate::GenerateData(ImuSensor &_sensor,
+    const std::chrono::steady_clock::duration &_now,
+    const math::Vector3d &_localGravity)
+{
+  const double dt = this->StepDt(_now);
+
+  this->linearAcc -= _localGravity;
+
+  this->noisePipeline.Apply({
+      &this->linearAcc.X(), &this->linearAcc.Y(), &this->linearAcc.Z(),
+      &this->angularVel.X(), &this->angularVel.Y(), &this->angularVel.Z()},
+      dt);
+
+  if (!this->filter.Apply({
+      &this->linearAcc.X(), &this->linearAcc.Y(), &this->linearAcc.Z(),
+      &this->angularVel.X(), &this->angularVel.Y(), &this->angularVel.Z()}))
+  {
+    // Dropped by decimation
+    this->prevStep = _now;
+    this->timeInitialized = true;
+    return;
+  }
+
+  if (this->orientationEnabled)
+  {
+    // Set the IMU orientation
+    // imu orientation with respect to reference frame
+    this->orientation =
+        this->orientationReference.Inverse() *
+        this->worldPose.Rot();
+  }
+
+  const math::Quaterniond &rot = this->orientationEnabled ?
+      this->orientation : math::Quaterniond::Identity;
+  this->latest.Store({
+      std::chrono::duration_cast<std::chrono::nanoseconds>(_now).count(),
+      {rot.W(), rot.X(), rot.Y(), rot.Z()},
+      {this->angularVel.X(), this->angularVel.Y(), this->angularVel.Z()},
+      {this->linearAcc.X(), this->linearAcc.Y(), this->linearAcc.Z()},
+      this->orientationEnabled});
+
+  if (this->sampleEvent.ConnectionCount() > 0)
+  {
+    ImuSample sample;
+    sample.time = _now;
+    sample.orientation = rot;
+    sample.hasOrientation = this->orientationEnabled;
+    sample.angularVelocity = this->angularVel;
+    sample.linearAcceleration = this->linearAcc;
+    this->sampleEvent(sample);
+  }
+
+  // The message is only built if someone receives it
+  if (this->pub.HasConnections())
+  {
+    auto &msg = this->msg;
+    _sensor.FillHeader(msg.mutable_header(), _now);
+    if (this->orientationEnabled)
+      msgs::Set(msg.mutable_orientation(), this->orientation);
+    else
+      msg.clear_orientation();
+    msgs::Set(msg.mutable_angular_velocity(), this->angularVel);
+    msgs::Set(msg.mutable_linear_acceleration(), this->linearAcc);
+
+    // publish
+    _sensor.Publish(this->pub, msg);
+  }
+  this->prevStep = _now;
+  this->timeInitialized = true;
+}
+
 //////////////////////////////////////////////////
 ImuSensor::ImuSensor()
   : dataPtr(new ImuSensorPrivate())
 {
+  this->SetPriority(SensorPriority::CONTROL);
 }
 
 //////////////////////////////////////////////////
@@ -138,10 +402,8 @@ bool ImuSensor::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/imu");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<msgs::IMU>(this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<msgs::IMU>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic[" << this->Topic() << "].\n";
     return false;
@@ -187,6 +449,15 @@ bool ImuSensor::Load(const sdf::Sensor &_sdf)
   this->dataPtr->customRpyQuaternion = math::Quaterniond(
       _sdf.ImuSensor()->CustomRpy());
 
+  this->dataPtr->InitMessage(*this);
+
+  this->RegisterNoise(this->dataPtr->noises);
+  const NoiseTable &table = this->dataPtr->noises;
+  this->dataPtr->noisePipeline.Load({table[ACCELEROMETER_X_NOISE_M_S_S],
+      table[ACCELEROMETER_Y_NOISE_M_S_S], table[ACCELEROMETER_Z_NOISE_M_S_S],
+      table[GYROSCOPE_X_NOISE_RAD_S], table[GYROSCOPE_Y_NOISE_RAD_S],
+      table[GYROSCOPE_Z_NOISE_RAD_S]});
+
   this->dataPtr->initialized = true;
   return true;
 }
@@ -209,109 +480,71 @@ bool ImuSensor::Update(const std::chrono::steady_clock::duration &_now)
     return false;
   }
 
-  // If time has gone backwards, reinitialize.
-  if (_now < this->dataPtr->prevStep)
+  if (this->dataPtr->integrationEnabled)
   {
-    this->dataPtr->timeInitialized = false;
-  }
-
-  // Only compute dt if time is initialized and increasing.
-  double dt;
-  if (this->dataPtr->timeInitialized)
-  {
-    auto delay = std::chrono::duration_cast<std::chrono::duration<float>>(
-        _now - this->dataPtr->prevStep);
-    dt = delay.count();
-  }
-  else
-  {
-    dt = 0.0;
+    const double interval = this->dataPtr->TakeIntegrated();
+    if (interval > 0.0)
+    {
+      // Gravity was removed while integrating
+      this->dataPtr->GenerateData(*this, _now, math::Vector3d::Zero);
+      this->dataPtr->deltaAngle = this->dataPtr->angularVel * interval;
+      this->dataPtr->deltaVelocity = this->dataPtr->linearAcc * interval;
+      return true;
+    }
   }
 
   // Add contribution from gravity
   // Skip if gravity is not enabled?
-  this->dataPtr->linearAcc -=
+  this->dataPtr->GenerateData(*this, _now,
       this->dataPtr->worldPose.Rot().Inverse().RotateVector(
-      this->dataPtr->gravity);
+      this->dataPtr->gravity));
+  return true;
+}
 
-  // Convenience method to apply noise to a channel, if present.
-  auto applyNoise = [&](SensorNoiseType noiseType, double & value)
+//////////////////////////////////////////////////
+void ImuSensor::UpdateBatch(const std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("ImuSensor::UpdateBatch");
+  // Subclasses may override Update, in which case they must be updated one
+  // by one.
+  if (typeid(*this) != typeid(ImuSensor))
   {
-    if (this->dataPtr->noises.find(noiseType) != this->dataPtr->noises.end()) {
-      value = this->dataPtr->noises[noiseType]->Apply(value, dt);
-    }
-  };
-
-  applyNoise(ACCELEROMETER_X_NOISE_M_S_S, this->dataPtr->linearAcc.X());
-  applyNoise(ACCELEROMETER_Y_NOISE_M_S_S, this->dataPtr->linearAcc.Y());
-  applyNoise(ACCELEROMETER_Z_NOISE_M_S_S, this->dataPtr->linearAcc.Z());
-  applyNoise(GYROSCOPE_X_NOISE_RAD_S, this->dataPtr->angularVel.X());
-  applyNoise(GYROSCOPE_Y_NOISE_RAD_S, this->dataPtr->angularVel.Y());
-  applyNoise(GYROSCOPE_Z_NOISE_RAD_S, this->dataPtr->angularVel.Z());
-
-  msgs::IMU msg;
-  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-  msg.set_entity_name(this->Name());
-  auto frame = msg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->FrameId());
-
-  // Populate covariance
-  for (int i = 0; i < 9; ++i) {
-    msg.mutable_linear_acceleration_covariance()->add_data(0);
-    msg.mutable_angular_velocity_covariance()->add_data(0);
-    msg.mutable_orientation_covariance()->add_data(0);
+    Sensor::UpdateBatch(_sensors, _now);
+    return;
   }
 
-  auto getCov = [&](SensorNoiseType noiseType) -> float{
-    if (this->dataPtr->noises.find(noiseType) != this->dataPtr->noises.end()) {
-      GaussianNoiseModelPtr gaussian =
-        std::dynamic_pointer_cast<GaussianNoiseModel>(
-            this->dataPtr->noises[noiseType]);
-      if (gaussian) {
-        return static_cast<float>(gaussian->StdDev() * gaussian->StdDev());
-      }
-    }
-    return 0.0f;
-  };
-
+  // Gather the orientation, gravity and acceleration of all sensors into
+  // contiguous arrays, and remove gravity rotated into each sensor frame in
+  // one pass.
+  thread_local ImuBatchState state;
+  state.Resize(_sensors.size());
+  for (std::size_t i = 0; i < _sensors.size(); ++i)
   {
-    msg.mutable_linear_acceleration_covariance()->set_data(
-        0, getCov(ACCELEROMETER_X_NOISE_M_S_S));
-    msg.mutable_linear_acceleration_covariance()->set_data(
-        4, getCov(ACCELEROMETER_Y_NOISE_M_S_S));
-    msg.mutable_linear_acceleration_covariance()->set_data(
-        8, getCov(ACCELEROMETER_Z_NOISE_M_S_S));
-    msg.mutable_angular_velocity_covariance()->set_data(
-        0, getCov(GYROSCOPE_X_NOISE_RAD_S));
-    msg.mutable_angular_velocity_covariance()->set_data(
-        4, getCov(GYROSCOPE_Y_NOISE_RAD_S));
-    msg.mutable_angular_velocity_covariance()->set_data(
-        8, getCov(GYROSCOPE_Z_NOISE_RAD_S));
-    msg.mutable_orientation_covariance()->set_data(0, 0.0);
-    msg.mutable_orientation_covariance()->set_data(4, 0.0);
-    msg.mutable_orientation_covariance()->set_data(8, 0.0);
+    auto imu = static_cast<ImuSensor *>(_sensors[i]);
+    state.Set(i, imu->dataPtr->worldPose.Rot(), imu->dataPtr->gravity,
+        imu->dataPtr->linearAcc);
   }
+  state.RemoveGravity();
 
-  if (this->dataPtr->orientationEnabled)
+  for (std::size_t i = 0; i < _sensors.size(); ++i)
   {
-    // Set the IMU orientation
-    // imu orientation with respect to reference frame
-    this->dataPtr->orientation =
-        this->dataPtr->orientationReference.Inverse() *
-        this->dataPtr->worldPose.Rot();
-
-    msgs::Set(msg.mutable_orientation(), this->dataPtr->orientation);
+    auto imu = static_cast<ImuSensor *>(_sensors[i]);
+    if (!imu->dataPtr->initialized)
+    {
+      gzerr << "Not initialized, update ignored.\n";
+      continue;
+    }
+    // Integrating sensors removed gravity already
+    if (imu->dataPtr->integrationEnabled &&
+        imu->dataPtr->integratedTime > 0.0)
+    {
+      imu->Update(_now);
+      continue;
+    }
+    imu->dataPtr->linearAcc = state.LinearAcceleration(i);
+    imu->dataPtr->GenerateData(*imu, _now, math::Vector3d::Zero);
   }
-  msgs::Set(msg.mutable_angular_velocity(), this->dataPtr->angularVel);
-  msgs::Set(msg.mutable_linear_acceleration(), this->dataPtr->linearAcc);
-
-  // publish
-  this->AddSequence(msg.mutable_header());
-  this->dataPtr->pub.Publish(msg);
-  this->dataPtr->prevStep = _now;
-  this->dataPtr->timeInitialized = true;
-  return true;
 }
 
 //////////////////////////////////////////////////
@@ -338,6 +571,89 @@ math::Vector3d ImuSensor::LinearAcceleration() const
   return this->dataPtr->linearAcc;
 }
 
+//////////////////////////////////////////////////
+void ImuSensor::SetIntegrationEnabled(bool _enabled)
+{
+  if (_enabled == this->dataPtr->integrationEnabled)
+    return;
+
+  this->dataPtr->integrationEnabled = _enabled;
+  this->dataPtr->integrationTimeInitialized = false;
+  this->dataPtr->integratedTime = 0.0;
+  this->dataPtr->integratedAngle = math::Vector3d::Zero;
+  this->dataPtr->integratedVelocity = math::Vector3d::Zero;
+  this->dataPtr->coning = math::Vector3d::Zero;
+  this->dataPtr->sculling = math::Vector3d::Zero;
+}
+
+//////////////////////////////////////////////////
+bool ImuSensor::IntegrationEnabled() const
+{
+  return this->dataPtr->integrationEnabled;
+}
+
+//////////////////////////////////////////////////
+void ImuSensor::Integrate(const std::chrono::steady_clock::duration &_now)
+{
+  auto &d = *this->dataPtr;
+  if (!d.integrationEnabled)
+    return;
+
+  if (!d.integrationTimeInitialized || _now < d.prevIntegrationStep)
+  {
+    d.integrationTimeInitialized = true;
+    d.prevIntegrationStep = _now;
+    return;
+  }
+
+  const double dt =
+      std::chrono::duration<double>(_now - d.prevIntegrationStep).count();
+  d.prevIntegrationStep = _now;
+  if (dt <= 0.0)
+    return;
+
+  // Increments over this step, with gravity removed from the acceleration
+  // to get the specific force
+  const math::Vector3d dTheta = d.angularVel * dt;
+  const math::Vector3d dV = (d.linearAcc -
+      d.worldPose.Rot().Inverse().RotateVector(d.gravity)) * dt;
+
+  // Coning and sculling corrections, from the increments accumulated so
+  // far and those of this step
+  d.coning += 0.5 * d.integratedAngle.Cross(dTheta);
+  d.sculling += 0.5 * (d.integratedAngle.Cross(dV) +
+      d.integratedVelocity.Cross(dTheta));
+
+  d.integratedAngle += dTheta;
+  d.integratedVelocity += dV;
+  d.integratedTime += dt;
+}
+
+//////////////////////////////////////////////////
+math::Vector3d ImuSensor::DeltaAngle() const
+{
+  return this->dataPtr->deltaAngle;
+}
+
+//////////////////////////////////////////////////
+math::Vector3d ImuSensor::DeltaVelocity() const
+{
+  return this->dataPtr->deltaVelocity;
+}
+
+//////////////////////////////////////////////////
+bool ImuSensor::SetOutputFilter(const SignalFilterOptions &_options)
+{
+  return this->dataPtr->filter.Configure(_options, this->UpdateRate(),
+      this->Name());
+}
+
+//////////////////////////////////////////////////
+SignalFilterOptions ImuSensor::OutputFilter() const
+{
+  return this->dataPtr->filter.Options();
+}
+
 //////////////////////////////////////////////////
 void ImuSensor::SetWorldPose(const math::Pose3d _pose)
 {
@@ -443,6 +759,31 @@ bool ImuSensor::OrientationEnabled() const
   return this->dataPtr->orientationEnabled;
 }
 
+//////////////////////////////////////////////////
+ImuSample ImuSensor::LatestSample() const
+{
+  const ImuSampleData data = this->dataPtr->latest.Load();
+  ImuSample sample;
+  sample.time = std::chrono::duration_cast<
+      std::chrono::steady_clock::duration>(
+      std::chrono::nanoseconds(data.time));
+  sample.orientation.Set(data.orientation[0], data.orientation[1],
+      data.orientation[2], data.orientation[3]);
+  sample.hasOrientation = data.hasOrientation;
+  sample.angularVelocity.Set(data.angularVelocity[0],
+      data.angularVelocity[1], data.angularVelocity[2]);
+  sample.linearAcceleration.Set(data.linearAcceleration[0],
+      data.linearAcceleration[1], data.linearAcceleration[2]);
+  return sample;
+}
+
+//////////////////////////////////////////////////
+gz::common::ConnectionPtr ImuSensor::ConnectSampleCallback(
+    std::function<void(const ImuSample &)> _callback)
+{
+  return this->dataPtr->sampleEvent.Connect(_callback);
+}
+
 //////////////////////////////////////////////////
 void ImuSensor::SetGravity(const math::Vector3d &_gravity)
 {
@@ -461,6 +802,105 @@ math::Quaterniond ImuSensor::Orientation() const
   return this->dataPtr->orientation;
 }
 
+//////////////////////////////////////////////////
+void ImuSensor::SaveState(SensorState &_state) const
+{
+  Sensor::SaveState(_state);
+
+  _state.Write(this->dataPtr->latest.Load());
+  _state.Write(this->dataPtr->linearAcc);
+  _state.Write(this->dataPtr->angularVel);
+  _state.Write(this->dataPtr->orientationReference);
+  _state.Write(this->dataPtr->orientation);
+  _state.Write(this->dataPtr->worldPose);
+  _state.Write(this->dataPtr->timeInitialized);
+  _state.Write(this->dataPtr->prevStep);
+
+  _state.Write(this->dataPtr->integrationTimeInitialized);
+  _state.Write(this->dataPtr->prevIntegrationStep);
+  _state.Write(this->dataPtr->integratedTime);
+  _state.Write(this->dataPtr->integratedAngle);
+  _state.Write(this->dataPtr->integratedVelocity);
+  _state.Write(this->dataPtr->coning);
+  _state.Write(this->dataPtr->sculling);
+  _state.Write(this->dataPtr->deltaAngle);
+  _state.Write(this->dataPtr->deltaVelocity);
+  this->dataPtr->filter.SaveState(_state);
+}
+
+//////////////////////////////////////////////////
+void ImuSensor::SaveInputs(SensorState &_state) const
+{
+  Sensor::SaveInputs(_state);
+  _state.Write(this->dataPtr->worldPose);
+  _state.Write(this->dataPtr->angularVel);
+  _state.Write(this->dataPtr->linearAcc);
+}
+
+//////////////////////////////////////////////////
+bool ImuSensor::InterpolateInputs(SensorState &_from, SensorState &_to,
+    double _alpha)
+{
+  if (!Sensor::InterpolateInputs(_from, _to, _alpha))
+    return false;
+
+  math::Pose3d fromPose, toPose;
+  math::Vector3d fromVel, toVel, fromAcc, toAcc;
+  if (!_from.Read(fromPose) || !_from.Read(fromVel) ||
+      !_from.Read(fromAcc) || !_to.Read(toPose) || !_to.Read(toVel) ||
+      !_to.Read(toAcc))
+  {
+    return false;
+  }
+  this->dataPtr->worldPose = InterpolateInput(fromPose, toPose, _alpha);
+  this->dataPtr->angularVel = InterpolateInput(fromVel, toVel, _alpha);
+  this->dataPtr->linearAcc = InterpolateInput(fromAcc, toAcc, _alpha);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ImuSensor::RestoreState(SensorState &_state)
+{
+  if (!Sensor::RestoreState(_state))
+    return false;
+
+  ImuSampleData latest;
+  if (!_state.Read(latest))
+    return false;
+  this->dataPtr->latest.Store(latest);
+
+  return _state.Read(this->dataPtr->linearAcc) &&
+      _state.Read(this->dataPtr->angularVel) &&
+      _state.Read(this->dataPtr->orientationReference) &&
+      _state.Read(this->dataPtr->orientation) &&
+      _state.Read(this->dataPtr->worldPose) &&
+      _state.Read(this->dataPtr->timeInitialized) &&
+      _state.Read(this->dataPtr->prevStep) &&
+      _state.Read(this->dataPtr->integrationTimeInitialized) &&
+      _state.Read(this->dataPtr->prevIntegrationStep) &&
+      _state.Read(this->dataPtr->integratedTime) &&
+      _state.Read(this->dataPtr->integratedAngle) &&
+      _state.Read(this->dataPtr->integratedVelocity) &&
+      _state.Read(this->dataPtr->coning) &&
+      _state.Read(this->dataPtr->sculling) &&
+      _state.Read(this->dataPtr->deltaAngle) &&
+      _state.Read(this->dataPtr->deltaVelocity) &&
+      this->dataPtr->filter.RestoreState(_state);
+}
+
+//////////////////////////////////////////////////
+void ImuSensor::UpdateNoiseState(
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("ImuSensor::UpdateNoiseState");
+  // Draw the same noise samples as a full update, so the noise sequence
+  // doesn't depend on whether anyone is subscribed
+  const double dt = this->dataPtr->StepDt(_now);
+  this->dataPtr->noisePipeline.Advance(dt);
+  this->dataPtr->prevStep = _now;
+  this->dataPtr->timeInitialized = true;
+}
+
 //////////////////////////////////////////////////
 bool ImuSensor::HasConnections() const
 {
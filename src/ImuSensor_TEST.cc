@@ -14,6 +14,9 @@
  * limitations under the License.
  *
  */
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <sdf/sdf.hh>
 
@@ -382,6 +385,128 @@ TEST(ImuSensor_TEST, Orientation)
 
 }
 
+//////////////////////////////////////////////////
+TEST(ImuSensor_TEST, LatestSample)
+{
+  sensors::Manager mgr;
+
+  const auto noise = noNoiseParameters(100, 0.0);
+  sdf::ElementPtr imuSDF = ImuSensorToSDF("TestImu_Latest", 100,
+      "/gz/sensors/test/imu_latest", noise, noise, true, true);
+  auto sensor = mgr.CreateSensor<sensors::ImuSensor>(imuSDF);
+  ASSERT_NE(nullptr, sensor);
+
+  sensors::ImuSample sample = sensor->LatestSample();
+  EXPECT_EQ(std::chrono::steady_clock::duration::zero(), sample.time);
+  EXPECT_FALSE(sample.hasOrientation);
+
+  math::Quaterniond orientValue(math::Vector3d(GZ_PI/2.0, 0, GZ_PI));
+  sensor->SetWorldPose(math::Pose3d(math::Vector3d(0, 1, 2), orientValue));
+  sensor->SetAngularVelocity(math::Vector3d(1, 2, 3));
+  sensor->SetLinearAcceleration(math::Vector3d(4, 5, 6));
+  sensor->SetGravity(math::Vector3d::Zero);
+  const std::chrono::steady_clock::duration now = std::chrono::milliseconds(10);
+  sensor->Update(now);
+
+  sample = sensor->LatestSample();
+  EXPECT_EQ(now, sample.time);
+  EXPECT_TRUE(sample.hasOrientation);
+  EXPECT_EQ(sensor->Orientation(), sample.orientation);
+  EXPECT_EQ(sensor->AngularVelocity(), sample.angularVelocity);
+  EXPECT_EQ(sensor->LinearAcceleration(), sample.linearAcceleration);
+
+  sensor->SetOrientationEnabled(false);
+  sensor->Update(now * 2);
+  sample = sensor->LatestSample();
+  EXPECT_EQ(now * 2, sample.time);
+  EXPECT_FALSE(sample.hasOrientation);
+  EXPECT_EQ(math::Quaterniond::Identity, sample.orientation);
+}
+
+//////////////////////////////////////////////////
+TEST(ImuSensor_TEST, SampleCallback)
+{
+  sensors::Manager mgr;
+
+  const auto noise = noNoiseParameters(100, 0.0);
+  sdf::ElementPtr imuSDF = ImuSensorToSDF("TestImu_Callback", 100,
+      "/gz/sensors/test/imu_callback", noise, noise, true, true);
+  auto sensor = mgr.CreateSensor<sensors::ImuSensor>(imuSDF);
+  ASSERT_NE(nullptr, sensor);
+
+  int count = 0;
+  sensors::ImuSample received;
+  auto connection = sensor->ConnectSampleCallback(
+      [&](const sensors::ImuSample &_sample)
+      {
+        received = _sample;
+        ++count;
+      });
+  ASSERT_NE(nullptr, connection);
+
+  sensor->SetAngularVelocity(math::Vector3d(1, 2, 3));
+  sensor->SetLinearAcceleration(math::Vector3d(4, 5, 6));
+  sensor->SetGravity(math::Vector3d::Zero);
+  const std::chrono::steady_clock::duration now = std::chrono::milliseconds(10);
+  sensor->Update(now);
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(now, received.time);
+  EXPECT_EQ(math::Vector3d(1, 2, 3), received.angularVelocity);
+  EXPECT_EQ(math::Vector3d(4, 5, 6), received.linearAcceleration);
+
+  connection.reset();
+  sensor->Update(now * 2);
+  EXPECT_EQ(1, count);
+}
+
+//////////////////////////////////////////////////
+TEST(ImuSensor_TEST, OutputFilter)
+{
+  sensors::Manager mgr;
+
+  const auto noise = noNoiseParameters(1000, 0.0);
+  sdf::ElementPtr imuSDF = ImuSensorToSDF("TestImu_Filter", 1000,
+      "/gz/sensors/test/imu_filter", noise, noise, true, false);
+  auto sensor = mgr.CreateSensor<sensors::ImuSensor>(imuSDF);
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_EQ(sensors::SignalFilterType::NONE, sensor->OutputFilter().type);
+
+  sensors::SignalFilterOptions options;
+  options.type = sensors::SignalFilterType::BUTTERWORTH;
+  options.cutoffFrequency = 600.0;
+  EXPECT_FALSE(sensor->SetOutputFilter(options));
+
+  options.type = sensors::SignalFilterType::MOVING_AVERAGE;
+  options.window = 2u;
+  options.decimation = 2u;
+  ASSERT_TRUE(sensor->SetOutputFilter(options));
+  EXPECT_EQ(2u, sensor->OutputFilter().decimation);
+
+  int count = 0;
+  sensors::ImuSample received;
+  auto connection = sensor->ConnectSampleCallback(
+      [&](const sensors::ImuSample &_sample)
+      {
+        received = _sample;
+        ++count;
+      });
+
+  sensor->SetGravity(math::Vector3d::Zero);
+  for (int i = 0; i < 4; ++i)
+  {
+    sensor->SetAngularVelocity(math::Vector3d(i, 0, 0));
+    sensor->SetLinearAcceleration(math::Vector3d(0, 0, 2 * i));
+    sensor->Update(std::chrono::milliseconds(i + 1));
+  }
+
+  // Every other sample is published, averaged with the dropped one
+  EXPECT_EQ(2, count);
+  EXPECT_EQ(std::chrono::milliseconds(3), received.time);
+  EXPECT_EQ(math::Vector3d(1.5, 0, 0), received.angularVelocity);
+  EXPECT_EQ(math::Vector3d(0, 0, 3), received.linearAcceleration);
+  EXPECT_EQ(std::chrono::milliseconds(3), sensor->LatestSample().time);
+}
+
 //////////////////////////////////////////////////
 TEST(ImuSensor_TEST, OrientationReference)
 {
@@ -802,3 +927,156 @@ TEST(ImuSensor_TEST, LocalizationTagInvalid)
   math::Quaterniond orientValue(math::Vector3d(0, 0, 0));
   EXPECT_EQ(orientValue, sensor->Orientation());
 }
+
+//////////////////////////////////////////////////
+TEST(ImuSensor_TEST, GroupedUpdate)
+{
+  // Create a sensor manager that updates IMUs as a group
+  sensors::Manager mgr;
+  mgr.SetGroupedUpdate(true);
+  EXPECT_TRUE(mgr.GroupedUpdate());
+
+  const double updateRate = 100;
+  const auto accelNoise = noNoiseParameters(updateRate, 0.0);
+  const auto gyroNoise = noNoiseParameters(updateRate, 0.0);
+  const math::Vector3d gravity(0, 0, -9.8);
+
+  std::vector<sensors::ImuSensor *> imus;
+  std::vector<math::Pose3d> poses;
+  for (int i = 0; i < 4; ++i)
+  {
+    const std::string name = "TestImu_Group" + std::to_string(i);
+    sdf::ElementPtr imuSDF = ImuSensorToSDF(name, updateRate,
+        "/gz/sensors/test/imu_group" + std::to_string(i),
+        accelNoise, gyroNoise, true, false);
+
+    auto sensor = mgr.CreateSensor<sensors::ImuSensor>(imuSDF);
+    ASSERT_NE(nullptr, sensor);
+
+    math::Pose3d pose(i, 0, 0, 0.1 * i, -0.2 * i, 0.3 * i);
+    sensor->SetWorldPose(pose);
+    sensor->SetGravity(gravity);
+    sensor->SetLinearAcceleration(math::Vector3d::Zero);
+    imus.push_back(sensor);
+    poses.push_back(pose);
+  }
+
+  mgr.RunOnce(std::chrono::milliseconds(10));
+
+  // Each IMU reports gravity in its own frame, as it would if updated alone
+  for (std::size_t i = 0; i < imus.size(); ++i)
+  {
+    const math::Vector3d expected =
+        -poses[i].Rot().Inverse().RotateVector(gravity);
+    EXPECT_EQ(expected, imus[i]->LinearAcceleration());
+    EXPECT_EQ(std::chrono::milliseconds(20), imus[i]->NextDataUpdateTime());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ImuSensor_TEST, Integration)
+{
+  sensors::Manager mgr;
+
+  const double updateRate = 100;
+  const auto accelNoise = noNoiseParameters(updateRate, 0.0);
+  const auto gyroNoise = noNoiseParameters(updateRate, 0.0);
+  sdf::ElementPtr imuSDF = ImuSensorToSDF("TestImu_Integration", updateRate,
+      "/gz/sensors/test/imu_integration", accelNoise, gyroNoise, true, false);
+
+  auto sensor = mgr.CreateSensor<sensors::ImuSensor>(imuSDF);
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_FALSE(sensor->IntegrationEnabled());
+
+  sensor->SetIntegrationEnabled(true);
+  EXPECT_TRUE(sensor->IntegrationEnabled());
+
+  const math::Vector3d gravity(0, 0, -9.8);
+  const math::Vector3d angularVel(0, 0, 0.5);
+  const math::Vector3d linearAcc(1, 2, 0);
+  sensor->SetGravity(gravity);
+  sensor->SetWorldPose(math::Pose3d::Zero);
+
+  // Integrate at 1 kHz, the first step only records the time
+  for (int i = 0; i <= 10; ++i)
+  {
+    sensor->SetAngularVelocity(angularVel);
+    sensor->SetLinearAcceleration(linearAcc);
+    sensor->Integrate(std::chrono::milliseconds(i));
+  }
+
+  // The last readings set are replaced by the averages over the interval
+  sensor->SetAngularVelocity(math::Vector3d::Zero);
+  sensor->SetLinearAcceleration(math::Vector3d::Zero);
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(10)));
+
+  // Rotation about a fixed axis has no coning, and a constant specific
+  // force has no sculling, which leaves the rotation compensation
+  const double interval = 0.01;
+  EXPECT_EQ(angularVel, sensor->AngularVelocity());
+  EXPECT_EQ(angularVel * interval, sensor->DeltaAngle());
+
+  const math::Vector3d specificForce = linearAcc - gravity;
+  const math::Vector3d deltaAngle = angularVel * interval;
+  const math::Vector3d deltaVelocity = specificForce * interval;
+  const math::Vector3d expected =
+      deltaVelocity + 0.5 * deltaAngle.Cross(deltaVelocity);
+  EXPECT_EQ(expected, sensor->DeltaVelocity());
+  EXPECT_EQ(expected / interval, sensor->LinearAcceleration());
+  EXPECT_NE(specificForce, sensor->LinearAcceleration());
+
+  // Without integrated time, the instantaneous readings are used
+  sensor->SetAngularVelocity(angularVel);
+  sensor->SetLinearAcceleration(linearAcc);
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(20)));
+  EXPECT_EQ(angularVel, sensor->AngularVelocity());
+  EXPECT_EQ(specificForce, sensor->LinearAcceleration());
+}
+
+//////////////////////////////////////////////////
+TEST(ImuSensor_TEST, SaveState)
+{
+  sensors::Manager mgr;
+
+  const double updateRate = 100;
+  const auto accelNoise = noNoiseParameters(updateRate, 0.0);
+  const auto gyroNoise = noNoiseParameters(updateRate, 0.0);
+  sdf::ElementPtr imuSDF = ImuSensorToSDF("TestImu_SaveState", updateRate,
+      "/gz/sensors/test/imu_save_state", accelNoise, gyroNoise, true, false);
+
+  auto sensor = mgr.CreateSensor<sensors::ImuSensor>(imuSDF);
+  ASSERT_NE(nullptr, sensor);
+  sensor->SetIntegrationEnabled(true);
+  sensor->SetGravity(math::Vector3d(0, 0, -9.8));
+  sensor->SetWorldPose(math::Pose3d::Zero);
+
+  auto integrate = [&](int _start, int _end)
+  {
+    for (int i = _start; i <= _end; ++i)
+    {
+      sensor->SetAngularVelocity(math::Vector3d(0, 0, 0.1 * i));
+      sensor->SetLinearAcceleration(math::Vector3d(i, 0, 0));
+      sensor->Integrate(std::chrono::milliseconds(i));
+    }
+  };
+
+  // Save halfway through the interval
+  integrate(0, 5);
+  sensors::SensorState state;
+  sensor->SaveState(state);
+
+  integrate(6, 10);
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(10)));
+  const math::Vector3d deltaAngle = sensor->DeltaAngle();
+  const math::Vector3d deltaVelocity = sensor->DeltaVelocity();
+  const auto next = sensor->NextDataUpdateTime();
+
+  // The restored sensor integrates the rest of the interval the same way
+  EXPECT_TRUE(sensor->RestoreState(state));
+  EXPECT_TRUE(state.AtEnd());
+  integrate(6, 10);
+  EXPECT_TRUE(sensor->Update(std::chrono::milliseconds(10)));
+  EXPECT_EQ(deltaAngle, sensor->DeltaAngle());
+  EXPECT_EQ(deltaVelocity, sensor->DeltaVelocity());
+  EXPECT_EQ(next, sensor->NextDataUpdateTime());
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_INPUTINTERPOLATION_HH_
+#define GZ_SENSORS_INPUTINTERPOLATION_HH_
+
+#include <gz/math/Pose3.hh>
+#include <gz/math/Quaternion.hh>
+#include <gz/math/Vector3.hh>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Interpolate a sensor input linearly between two snapshots.
+    /// The ends are returned exactly.
+    /// \param[in] _from Value of the previous snapshot.
+    /// \param[in] _to Value of the current snapshot.
+    /// \param[in] _alpha 0 for _from, 1 for _to.
+    /// \return Interpolated value.
+    inline math::Vector3d InterpolateInput(const math::Vector3d &_from,
+        const math::Vector3d &_to, double _alpha)
+    {
+      if (_alpha <= 0.0)
+        return _from;
+      if (_alpha >= 1.0)
+        return _to;
+      return _from + (_to - _from) * _alpha;
+    }
+
+    /// \brief Interpolate a pose between two snapshots, the position
+    /// linearly and the rotation along the shortest arc. The ends are
+    /// returned exactly.
+    /// \param[in] _from Pose of the previous snapshot.
+    /// \param[in] _to Pose of the current snapshot.
+    /// \param[in] _alpha 0 for _from, 1 for _to.
+    /// \return Interpolated pose.
+    inline math::Pose3d InterpolateInput(const math::Pose3d &_from,
+        const math::Pose3d &_to, double _alpha)
+    {
+      if (_alpha <= 0.0)
+        return _from;
+      if (_alpha >= 1.0)
+        return _to;
+      return math::Pose3d(
+          InterpolateInput(_from.Pos(), _to.Pos(), _alpha),
+          math::Quaterniond::Slerp(_alpha, _from.Rot(), _to.Rot(), true));
+    }
+    }
+  }
+}
+
+#endif
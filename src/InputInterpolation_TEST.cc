@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include <gz/math/Pose3.hh>
+#include <gz/math/Vector3.hh>
+
+#include "InputInterpolation.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(InputInterpolation, Vector)
+{
+  const math::Vector3d from(0.1, 2.0, -4.0);
+  const math::Vector3d to(1.1, -2.0, 4.0);
+  EXPECT_EQ(from, InterpolateInput(from, to, 0.0));
+  EXPECT_EQ(to, InterpolateInput(from, to, 1.0));
+  EXPECT_EQ(math::Vector3d(0.6, 0.0, 0.0), InterpolateInput(from, to, 0.5));
+
+  // Outside of the snapshots the ends are held
+  EXPECT_EQ(from, InterpolateInput(from, to, -1.0));
+  EXPECT_EQ(to, InterpolateInput(from, to, 2.0));
+}
+
+//////////////////////////////////////////////////
+TEST(InputInterpolation, Pose)
+{
+  const math::Pose3d from(0, 0, 0, 0, 0, 0);
+  const math::Pose3d to(2, 4, 6, 0, 0, GZ_PI / 2.0);
+  EXPECT_EQ(from, InterpolateInput(from, to, 0.0));
+  EXPECT_EQ(to, InterpolateInput(from, to, 1.0));
+
+  const math::Pose3d half = InterpolateInput(from, to, 0.5);
+  EXPECT_EQ(math::Vector3d(1, 2, 3), half.Pos());
+  EXPECT_NEAR(GZ_PI / 4.0, half.Rot().Yaw(), 1e-9);
+  EXPECT_NEAR(0.0, half.Rot().Roll(), 1e-9);
+
+  // Rotations take the shortest arc
+  const math::Pose3d near(0, 0, 0, 0, 0, GZ_PI - 0.1);
+  const math::Pose3d across(0, 0, 0, 0, 0, -GZ_PI + 0.1);
+  EXPECT_NEAR(GZ_PI, std::abs(InterpolateInput(near, across, 0.5)
+      .Rot().Yaw()), 1e-9);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_LABELMAPENCODING_HH_
+#define GZ_SENSORS_LABELMAPENCODING_HH_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Convert a labels map of 3 channel pixels, as filled by
+    /// rendering::SegmentationCamera::LabelMapFromColoredBuffer, to one 16
+    /// bit value per pixel. Semantic maps repeat the label in each channel
+    /// and give the label. Panoptic maps hold the instance count in the
+    /// first two channels, low byte first, and the label in the third. They
+    /// give the label in the high byte and the low byte of the instance
+    /// count in the low byte.
+    /// \param[in] _labels Labels map, 3 bytes per pixel.
+    /// \param[in] _count Number of pixels.
+    /// \param[in] _panoptic True for a panoptic map.
+    /// \param[out] _dst 16 bit labels, _count values.
+    inline void LabelsMapTo16Bit(const unsigned char *_labels,
+        std::size_t _count, bool _panoptic, uint16_t *_dst)
+    {
+      if (_panoptic)
+      {
+        for (std::size_t i = 0u; i < _count; ++i)
+        {
+          _dst[i] = static_cast<uint16_t>(
+              (_labels[i * 3u + 2u] << 8u) | _labels[i * 3u]);
+        }
+      }
+      else
+      {
+        for (std::size_t i = 0u; i < _count; ++i)
+          _dst[i] = _labels[i * 3u];
+      }
+    }
+
+    /// \brief Run-length encode 16 bit labels in row major order. Each run
+    /// takes 4 bytes: the label, then the number of consecutive pixels
+    /// holding it, both little endian. Runs longer than 65535 pixels are
+    /// split.
+    /// \param[in] _labels 16 bit labels.
+    /// \param[in] _count Number of pixels.
+    /// \param[out] _dst Encoded runs, replacing its content. Its capacity
+    /// is kept, so encoding into the same string every frame doesn't
+    /// allocate once it is large enough.
+    inline void EncodeLabelRuns(const uint16_t *_labels, std::size_t _count,
+        std::string &_dst)
+    {
+      _dst.clear();
+      std::size_t i = 0u;
+      while (i < _count)
+      {
+        const uint16_t label = _labels[i];
+        std::size_t run = 1u;
+        while (i + run < _count && run < 0xFFFFu && _labels[i + run] == label)
+          ++run;
+        const char bytes[4] = {
+            static_cast<char>(label & 0xFFu),
+            static_cast<char>(label >> 8u),
+            static_cast<char>(run & 0xFFu),
+            static_cast<char>(run >> 8u)};
+        _dst.append(bytes, sizeof(bytes));
+        i += run;
+      }
+    }
+
+    /// \brief Colors of semantic labels, learned from frames which have
+    /// both the colored map and the labels map, to color later labels maps
+    /// with a lookup per pixel.
+    class LabelColorTable
+    {
+      /// \brief Learn the colors of the labels of a frame.
+      /// \param[in] _labels Semantic labels map, 3 bytes per pixel.
+      /// \param[in] _colors Colored map of the same frame, 3 bytes per
+      /// pixel.
+      /// \param[in] _count Number of pixels.
+      public: void Learn(const unsigned char *_labels,
+          const unsigned char *_colors, std::size_t _count)
+      {
+        for (std::size_t i = 0u; i < _count; ++i)
+        {
+          const unsigned char *color = _colors + i * 3u;
+          this->colors[_labels[i * 3u]] = kKnown | color[0] |
+              (color[1] << 8u) | (static_cast<uint32_t>(color[2]) << 16u);
+        }
+      }
+
+      /// \brief Color a semantic labels map.
+      /// \param[in] _labels Semantic labels map, 3 bytes per pixel.
+      /// \param[in] _count Number of pixels.
+      /// \param[out] _dst Colored map, 3 bytes per pixel. Pixels of labels
+      /// without a color are black.
+      /// \return False if a label has no color.
+      public: bool Color(const unsigned char *_labels, std::size_t _count,
+          unsigned char *_dst) const
+      {
+        uint32_t known = kKnown;
+        for (std::size_t i = 0u; i < _count; ++i)
+        {
+          const uint32_t color = this->colors[_labels[i * 3u]];
+          known &= color;
+          _dst[i * 3u] = static_cast<unsigned char>(color);
+          _dst[i * 3u + 1u] = static_cast<unsigned char>(color >> 8u);
+          _dst[i * 3u + 2u] = static_cast<unsigned char>(color >> 16u);
+        }
+        return known != 0u;
+      }
+
+      /// \brief Check whether a label has a color.
+      /// \param[in] _label Label.
+      /// \return True if the color of the label was learned.
+      public: bool Has(uint8_t _label) const
+      {
+        return (this->colors[_label] & kKnown) != 0u;
+      }
+
+      /// \brief Check whether no color was learned.
+      /// \return True if no label has a color.
+      public: bool Empty() const
+      {
+        for (const auto color : this->colors)
+        {
+          if (color & kKnown)
+            return false;
+        }
+        return true;
+      }
+
+      /// \brief Forget all colors.
+      public: void Clear()
+      {
+        this->colors.fill(0u);
+      }
+
+      /// \brief Flag of the entries with a color.
+      private: static constexpr uint32_t kKnown = 0x01000000u;
+
+      /// \brief Color of each label, red in the low byte, zero if unknown.
+      private: std::array<uint32_t, 256> colors{};
+    };
+    }
+  }
+}
+
+#endif
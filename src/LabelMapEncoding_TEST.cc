@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "LabelMapEncoding.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Decode runs written by EncodeLabelRuns.
+/// \param[in] _runs Encoded runs.
+/// \return Labels of the pixels.
+static std::vector<uint16_t> DecodeLabelRuns(const std::string &_runs)
+{
+  std::vector<uint16_t> labels;
+  const auto *bytes = reinterpret_cast<const unsigned char *>(_runs.data());
+  for (std::size_t i = 0u; i + 4u <= _runs.size(); i += 4u)
+  {
+    const uint16_t label = static_cast<uint16_t>(bytes[i] | bytes[i + 1] << 8);
+    const std::size_t run = bytes[i + 2] | bytes[i + 3] << 8;
+    labels.insert(labels.end(), run, label);
+  }
+  return labels;
+}
+
+//////////////////////////////////////////////////
+TEST(LabelMapEncoding, Semantic16Bit)
+{
+  const std::vector<unsigned char> labels = {3, 3, 3, 0, 0, 0, 255, 255, 255};
+  std::vector<uint16_t> dst(3u);
+  LabelsMapTo16Bit(labels.data(), 3u, false, dst.data());
+  EXPECT_EQ(std::vector<uint16_t>({3u, 0u, 255u}), dst);
+}
+
+//////////////////////////////////////////////////
+TEST(LabelMapEncoding, Panoptic16Bit)
+{
+  // Instance count low byte, high byte, then the label
+  const std::vector<unsigned char> labels = {1, 0, 2, 7, 1, 5};
+  std::vector<uint16_t> dst(2u);
+  LabelsMapTo16Bit(labels.data(), 2u, true, dst.data());
+  EXPECT_EQ(0x0201u, dst[0]);
+  EXPECT_EQ(0x0507u, dst[1]);
+}
+
+//////////////////////////////////////////////////
+TEST(LabelMapEncoding, Runs)
+{
+  std::string runs = "stale";
+  EncodeLabelRuns(nullptr, 0u, runs);
+  EXPECT_TRUE(runs.empty());
+
+  const std::vector<uint16_t> labels = {4u, 4u, 4u, 0x1234u, 4u};
+  EncodeLabelRuns(labels.data(), labels.size(), runs);
+  ASSERT_EQ(12u, runs.size());
+  const auto *bytes = reinterpret_cast<const unsigned char *>(runs.data());
+  EXPECT_EQ(4u, bytes[0]);
+  EXPECT_EQ(0u, bytes[1]);
+  EXPECT_EQ(3u, bytes[2]);
+  EXPECT_EQ(0u, bytes[3]);
+  EXPECT_EQ(0x34u, bytes[4]);
+  EXPECT_EQ(0x12u, bytes[5]);
+  EXPECT_EQ(labels, DecodeLabelRuns(runs));
+}
+
+//////////////////////////////////////////////////
+TEST(LabelMapEncoding, LongRuns)
+{
+  // A uniform 640x480 map doesn't fit in a single run
+  const std::vector<uint16_t> labels(640u * 480u, 9u);
+  std::string runs;
+  EncodeLabelRuns(labels.data(), labels.size(), runs);
+  EXPECT_EQ(5u * 4u, runs.size());
+  EXPECT_EQ(labels, DecodeLabelRuns(runs));
+}
+
+//////////////////////////////////////////////////
+TEST(LabelMapEncoding, LabelColors)
+{
+  LabelColorTable table;
+  EXPECT_TRUE(table.Empty());
+
+  // Semantic labels repeat the label in each channel
+  const std::vector<unsigned char> labels = {
+      0, 0, 0, 4, 4, 4, 4, 4, 4, 200, 200, 200};
+  const std::vector<unsigned char> colors = {
+      0, 0, 0, 10, 20, 30, 10, 20, 30, 255, 1, 2};
+  table.Learn(labels.data(), colors.data(), 4u);
+  EXPECT_FALSE(table.Empty());
+  EXPECT_TRUE(table.Has(0u));
+  EXPECT_TRUE(table.Has(4u));
+  EXPECT_TRUE(table.Has(200u));
+  EXPECT_FALSE(table.Has(5u));
+
+  const std::vector<unsigned char> frame = {
+      200, 200, 200, 4, 4, 4, 0, 0, 0};
+  std::vector<unsigned char> dst(9u);
+  EXPECT_TRUE(table.Color(frame.data(), 3u, dst.data()));
+  EXPECT_EQ(std::vector<unsigned char>(
+      {255, 1, 2, 10, 20, 30, 0, 0, 0}), dst);
+
+  // Unknown labels are black and reported
+  const std::vector<unsigned char> unknown = {4, 4, 4, 5, 5, 5};
+  dst.assign(6u, 99u);
+  EXPECT_FALSE(table.Color(unknown.data(), 2u, dst.data()));
+  EXPECT_EQ(std::vector<unsigned char>({10, 20, 30, 0, 0, 0}), dst);
+
+  table.Clear();
+  EXPECT_TRUE(table.Empty());
+  EXPECT_FALSE(table.Has(4u));
+}
@@ -14,6 +14,18 @@
  * limitations under the License.
  *
 */
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #if defined(_MSC_VER)
   #pragma warning(push)
   #pragma warning(disable: 4005)
@@ -27,18 +39,71 @@
 #include <gz/common/Console.hh>
 #include <gz/common/Event.hh>
 #include <gz/common/Profiler.hh>
+#include <gz/math/Helpers.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
 #include <sdf/Lidar.hh>
 
 #include "gz/sensors/GaussianNoiseModel.hh"
 #include "gz/sensors/Lidar.hh"
+#include "LidarScanPool.hh"
+#include "MemorySize.hh"
+#include "TraceRecorder.hh"
 #include "gz/sensors/Noise.hh"
 #include "gz/sensors/SensorFactory.hh"
 #include "gz/sensors/SensorTypes.hh"
 
 using namespace gz::sensors;
 
+namespace
+{
+/// \brief Split lidar samples of 3 channels into ranges and intensities,
+/// replacing NaN ranges with the maximum range. SSE2 handles four rays per
+/// iteration.
+/// \param[in] _samples Range, intensity and retro of each ray.
+/// \param[in] _count Number of rays.
+/// \param[in] _rangeMax Range stored for NaN ranges.
+/// \param[out] _ranges Ranges, _count values.
+/// \param[out] _intensities Intensities, _count values.
+void DeinterleaveScan(const float *_samples, std::size_t _count,
+    double _rangeMax, double *_ranges, double *_intensities)
+{
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  const __m128d maxRange = _mm_set1_pd(_rangeMax);
+  for (; i + 4 <= _count; i += 4)
+  {
+    // a = r0 i0 x0 r1, b = i1 x1 r2 i2, c = x2 r3 i3 x3
+    const __m128 a = _mm_loadu_ps(_samples + i * 3);
+    const __m128 b = _mm_loadu_ps(_samples + i * 3 + 4);
+    const __m128 c = _mm_loadu_ps(_samples + i * 3 + 8);
+    const __m128 r23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+    const __m128 i01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+    const __m128 i23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+    const __m128d ranges[2] = {
+        _mm_cvtps_pd(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 0))),
+        _mm_cvtps_pd(_mm_shuffle_ps(r23, r23, _MM_SHUFFLE(0, 0, 2, 0)))};
+    for (int k = 0; k < 2; ++k)
+    {
+      const __m128d nan = _mm_cmpunord_pd(ranges[k], ranges[k]);
+      _mm_storeu_pd(_ranges + i + k * 2, _mm_or_pd(
+          _mm_and_pd(nan, maxRange), _mm_andnot_pd(nan, ranges[k])));
+    }
+    _mm_storeu_pd(_intensities + i,
+        _mm_cvtps_pd(_mm_shuffle_ps(i01, i01, _MM_SHUFFLE(0, 0, 2, 0))));
+    _mm_storeu_pd(_intensities + i + 2,
+        _mm_cvtps_pd(_mm_shuffle_ps(i23, i23, _MM_SHUFFLE(0, 0, 2, 0))));
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    const double range = _samples[i * 3];
+    _ranges[i] = std::isnan(range) ? _rangeMax : range;
+    _intensities[i] = _samples[i * 3 + 1];
+  }
+}
+}
+
 /// \brief Private data for Lidar class
 class gz::sensors::LidarPrivate
 {
@@ -51,11 +116,49 @@ class gz::sensors::LidarPrivate
   /// \brief Laser message to publish data.
   public: gz::msgs::LaserScan laserMsg;
 
+  /// \brief Ranges of the next laser message, filled without holding
+  /// lidarMutex and swapped into laserMsg.
+  public: google::protobuf::RepeatedField<double> nextRanges;
+
+  /// \brief Intensities of the next laser message.
+  public: google::protobuf::RepeatedField<double> nextIntensities;
+
+  /// \brief Scans shared by the render callback, the noise and the
+  /// publisher.
+  public: LidarScanPool scanPool;
+
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
 
   /// \brief Sdf sensor.
   public: sdf::Lidar sdfLidar;
+
+  /// \brief Rebuild the blanking mask from the zones and the ray angles.
+  /// \param[in] _lidar The sensor.
+  public: void UpdateBlankingMask(const Lidar &_lidar);
+
+  /// \brief Set the counts, ranges and angles of laserMsg from sdfLidar.
+  /// \param[in] _lidar The sensor.
+  public: void UpdateMsg(const Lidar &_lidar);
+
+  /// \brief Create the noise models of sdfLidar, replacing the current
+  /// ones.
+  public: void CreateNoise();
+
+  /// \brief Zones of the field of view whose rays are blanked.
+  public: std::vector<LidarBlankingZone> blankingZones;
+
+  /// \brief Elevation of each row of the scan, empty for uniform rows.
+  public: std::vector<double> blankingElevations;
+
+  /// \brief Horizontal offset of each row of the scan, empty for none.
+  public: std::vector<double> blankingAzimuthOffsets;
+
+  /// \brief Mask of the blanked rays, null when no ray is blanked.
+  public: std::shared_ptr<const std::vector<uint8_t>> blankingMask;
+
+  /// \brief Protects the blanking zones, beams and mask.
+  public: mutable std::mutex blankingMutex;
 };
 
 //////////////////////////////////////////////////
@@ -70,6 +173,50 @@ Lidar::~Lidar()
   this->Fini();
 }
 
+//////////////////////////////////////////////////
+void LidarPrivate::UpdateMsg(const Lidar &_lidar)
+{
+  this->laserMsg.set_count(_lidar.RangeCount());
+  this->laserMsg.set_range_min(_lidar.RangeMin());
+  this->laserMsg.set_range_max(_lidar.RangeMax());
+  this->laserMsg.set_angle_min(_lidar.AngleMin().Radian());
+  this->laserMsg.set_angle_max(_lidar.AngleMax().Radian());
+  this->laserMsg.set_angle_step(_lidar.AngleResolution());
+  this->laserMsg.set_vertical_angle_min(
+      _lidar.VerticalAngleMin().Radian());
+  this->laserMsg.set_vertical_angle_max(
+      _lidar.VerticalAngleMax().Radian());
+  this->laserMsg.set_vertical_angle_step(
+      _lidar.VerticalAngleResolution());
+  this->laserMsg.set_vertical_count(
+      _lidar.VerticalRangeCount());
+}
+
+//////////////////////////////////////////////////
+void LidarPrivate::CreateNoise()
+{
+  this->noises[LIDAR_NOISE] = nullptr;
+
+  const std::map<SensorNoiseType, sdf::Noise> noises = {
+    {LIDAR_NOISE, this->sdfLidar.LidarNoise()},
+  };
+
+  for (const auto & [noiseType, noiseSdf] : noises)
+  {
+    if (noiseSdf.Type() == sdf::NoiseType::GAUSSIAN)
+    {
+      this->noises[noiseType] =
+        NoiseFactory::NewNoiseModel(noiseSdf);
+    }
+    else if (noiseSdf.Type() != sdf::NoiseType::NONE)
+    {
+      gzwarn << "The lidar sensor only supports Gaussian noise. "
+       << "The supplied noise type[" << static_cast<int>(noiseSdf.Type())
+       << "] is not supported." << std::endl;
+    }
+  }
+}
+
 //////////////////////////////////////////////////
 bool Lidar::Init()
 {
@@ -79,11 +226,38 @@ bool Lidar::Init()
 //////////////////////////////////////////////////
 void Lidar::Fini()
 {
-  if (this->laserBuffer)
-  {
+  // Buffers that weren't allocated by the pool belong to the sensor
+  if (this->laserBuffer && !this->dataPtr->scanPool.Owns(this->laserBuffer))
     delete [] this->laserBuffer;
-    this->laserBuffer = nullptr;
-  }
+  this->laserBuffer = nullptr;
+}
+
+//////////////////////////////////////////////////
+float *Lidar::ScanWriteBuffer(std::size_t _samples)
+{
+  this->dataPtr->scanPool.SetMemory(this->BufferMemory());
+  return this->dataPtr->scanPool.WriteBuffer(_samples);
+}
+
+//////////////////////////////////////////////////
+void Lidar::CommitScanBuffer()
+{
+  this->laserBuffer = this->dataPtr->scanPool.Commit();
+}
+
+//////////////////////////////////////////////////
+float *Lidar::AcquireScanBuffer()
+{
+  // Fall back to buffers set by sensors that don't use the pool
+  if (!this->dataPtr->scanPool.HasScan())
+    return this->laserBuffer;
+  return this->dataPtr->scanPool.Acquire();
+}
+
+//////////////////////////////////////////////////
+void Lidar::ReleaseScanBuffer()
+{
+  this->dataPtr->scanPool.Release();
 }
 
 //////////////////////////////////////////////////
@@ -120,10 +294,8 @@ bool Lidar::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/lidar");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<gz::msgs::LaserScan>(
-        this->Topic());
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<gz::msgs::LaserScan>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() << "].\n";
@@ -141,40 +313,14 @@ bool Lidar::Load(const sdf::Sensor &_sdf)
     gzerr << "Lidar: Image has 0 size!\n";
   }
 
-  // create message
-  this->dataPtr->laserMsg.set_count(this->RangeCount());
-  this->dataPtr->laserMsg.set_range_min(this->RangeMin());
-  this->dataPtr->laserMsg.set_range_max(this->RangeMax());
-  this->dataPtr->laserMsg.set_angle_min(this->AngleMin().Radian());
-  this->dataPtr->laserMsg.set_angle_max(this->AngleMax().Radian());
-  this->dataPtr->laserMsg.set_angle_step(this->AngleResolution());
-  this->dataPtr->laserMsg.set_vertical_angle_min(
-      this->VerticalAngleMin().Radian());
-  this->dataPtr->laserMsg.set_vertical_angle_max(
-      this->VerticalAngleMax().Radian());
-  this->dataPtr->laserMsg.set_vertical_angle_step(
-      this->VerticalAngleResolution());
-  this->dataPtr->laserMsg.set_vertical_count(
-      this->VerticalRangeCount());
-
-  // Handle noise model settings.
-  const std::map<SensorNoiseType, sdf::Noise> noises = {
-    {LIDAR_NOISE, this->dataPtr->sdfLidar.LidarNoise()},
-  };
+  this->dataPtr->UpdateMsg(*this);
+  this->dataPtr->CreateNoise();
+  this->RegisterNoise(this->dataPtr->noises);
 
-  for (const auto & [noiseType, noiseSdf] : noises)
+  // Zones may be set before the ray counts are known
   {
-    if (noiseSdf.Type() == sdf::NoiseType::GAUSSIAN)
-    {
-      this->dataPtr->noises[noiseType] =
-        NoiseFactory::NewNoiseModel(noiseSdf);
-    }
-    else if (noiseSdf.Type() != sdf::NoiseType::NONE)
-    {
-      gzwarn << "The lidar sensor only supports Gaussian noise. "
-       << "The supplied noise type[" << static_cast<int>(noiseSdf.Type())
-       << "] is not supported." << std::endl;
-    }
+    std::lock_guard<std::mutex> lock(this->dataPtr->blankingMutex);
+    this->dataPtr->UpdateBlankingMask(*this);
   }
 
   this->initialized = true;
@@ -189,6 +335,49 @@ bool Lidar::Load(sdf::ElementPtr _sdf)
   return this->Load(sdfSensor);
 }
 
+//////////////////////////////////////////////////
+bool Lidar::Reconfigure(const sdf::Sensor &_sdf)
+{
+  const sdf::Lidar *lidarSdf = _sdf.LidarSensor();
+  if (!lidarSdf)
+  {
+    gzerr << "Unable to reconfigure lidar [" << this->Name()
+          << "] without lidar settings.\n";
+    return false;
+  }
+
+  if (lidarSdf->HorizontalScanSamples() == 0u ||
+      lidarSdf->VerticalScanSamples() == 0u)
+  {
+    gzerr << "Unable to reconfigure lidar [" << this->Name()
+          << "] with 0 samples.\n";
+    return false;
+  }
+
+  if (!this->Sensor::Reconfigure(_sdf))
+    return false;
+
+  {
+    std::lock_guard<std::mutex> lock(this->lidarMutex);
+    const bool noiseChanged =
+        lidarSdf->LidarNoise() != this->dataPtr->sdfLidar.LidarNoise();
+    this->dataPtr->sdfLidar = *lidarSdf;
+    this->dataPtr->UpdateMsg(*this);
+
+    // Noise models are only replaced if their settings changed, so they
+    // keep their state otherwise
+    if (noiseChanged)
+    {
+      this->dataPtr->CreateNoise();
+      this->RegisterNoise(LIDAR_NOISE, this->dataPtr->noises[LIDAR_NOISE]);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->blankingMutex);
+  this->dataPtr->UpdateBlankingMask(*this);
+  return true;
+}
+
 /////////////////////////////////////////////////
 gz::common::ConnectionPtr Lidar::ConnectNewLidarFrame(
           std::function<void(const float *_scan, unsigned int _width,
@@ -205,84 +394,210 @@ bool Lidar::Update(const std::chrono::steady_clock::duration &/*_now*/)
   return false;
 }
 
+//////////////////////////////////////////////////
+bool Lidar::HasNoise() const
+{
+  return this->dataPtr->noises[LIDAR_NOISE] != nullptr;
+}
+
 //////////////////////////////////////////////////
 void Lidar::ApplyNoise()
 {
-  if (this->dataPtr->noises.find(LIDAR_NOISE) != this->dataPtr->noises.end())
+  const NoisePtr &noise = this->dataPtr->noises[LIDAR_NOISE];
+  if (!noise)
+    return;
+
+  TraceScope trace("noise", *this);
+  const auto mask = this->BlankingMask();
+  float *scan = this->AcquireScanBuffer();
+  if (scan)
   {
-    for (unsigned int j = 0; j < this->VerticalRayCount(); ++j)
+    // Ranges are the first of the 3 channels of each ray
+    const std::size_t count =
+      static_cast<std::size_t>(this->VerticalRayCount()) * this->RayCount();
+    if (!mask || mask->size() != count)
+    {
+      noise->ApplyBatch(scan, count, 3u, 0.0,
+          this->RangeMin(), this->RangeMax());
+    }
+    else
     {
-      for (unsigned int i = 0; i < this->RayCount(); ++i)
+      // Noise is applied to each run of rays that aren't blanked
+      const uint8_t *blanked = mask->data();
+      std::size_t begin = 0u;
+      while (begin < count)
       {
-        int index = j * this->RayCount() + i;
-        double range = this->laserBuffer[index*3];
-        range = this->dataPtr->noises[LIDAR_NOISE]->Apply(range);
-        if (std::isfinite(range))
+        while (begin < count && blanked[begin])
+          ++begin;
+        std::size_t end = begin;
+        while (end < count && !blanked[end])
+          ++end;
+        if (end > begin)
         {
-          range = gz::math::clamp(range,
-            this->RangeMin(), this->RangeMax());
+          noise->ApplyBatch(scan + begin * 3u, end - begin, 3u, 0.0,
+              this->RangeMin(), this->RangeMax());
         }
-        this->laserBuffer[index*3] = range;
+        begin = end;
       }
     }
   }
+  this->ReleaseScanBuffer();
 }
 
 //////////////////////////////////////////////////
-bool Lidar::PublishLidarScan(const std::chrono::steady_clock::duration &_now)
+bool Lidar::SetBlankingZones(const std::vector<LidarBlankingZone> &_zones)
 {
-  GZ_PROFILE("Lidar::PublishLidarScan");
-  if (!this->laserBuffer)
-    return false;
+  for (const LidarBlankingZone &zone : _zones)
+  {
+    if (!std::isfinite(zone.angleMin) || !std::isfinite(zone.angleMax) ||
+        !std::isfinite(zone.verticalAngleMin) ||
+        !std::isfinite(zone.verticalAngleMax) ||
+        zone.angleMin > zone.angleMax ||
+        zone.verticalAngleMin > zone.verticalAngleMax)
+    {
+      gzerr << "Invalid blanking zone [" << zone.angleMin << ", "
+            << zone.angleMax << "] x [" << zone.verticalAngleMin << ", "
+            << zone.verticalAngleMax << "], blanking zones ignored.\n";
+      return false;
+    }
+  }
 
-  std::lock_guard<std::mutex> lock(this->lidarMutex);
+  std::lock_guard<std::mutex> lock(this->dataPtr->blankingMutex);
+  this->dataPtr->blankingZones = _zones;
+  this->dataPtr->UpdateBlankingMask(*this);
+  return true;
+}
 
-  *this->dataPtr->laserMsg.mutable_header()->mutable_stamp() =
-    msgs::Convert(_now);
-  // Remove 'data' entries before adding new ones
-  this->dataPtr->laserMsg.mutable_header()->clear_data();
-  auto frame = this->dataPtr->laserMsg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  // keeping here the sensor name instead of frame_id because the visualizeLidar
-  // plugin relies on this value to get the position of the lidar.
-  // the ros_gz plugin is using the laserscan.proto 'frame' field
-  frame->add_value(this->Name());
-  this->dataPtr->laserMsg.set_frame(this->FrameId());
-
-  // Store the latest laser scans into laserMsg
-  msgs::Set(this->dataPtr->laserMsg.mutable_world_pose(),
-      this->Pose());
+//////////////////////////////////////////////////
+std::vector<LidarBlankingZone> Lidar::BlankingZones() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->blankingMutex);
+  return this->dataPtr->blankingZones;
+}
 
-  const int numRays = this->RayCount() * this->VerticalRayCount();
-  if (this->dataPtr->laserMsg.ranges_size() != numRays)
+//////////////////////////////////////////////////
+std::shared_ptr<const std::vector<uint8_t>> Lidar::BlankingMask() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->blankingMutex);
+  return this->dataPtr->blankingMask;
+}
+
+//////////////////////////////////////////////////
+void Lidar::SetBlankingBeams(const std::vector<double> &_elevations,
+    const std::vector<double> &_azimuthOffsets)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->blankingMutex);
+  this->dataPtr->blankingElevations = _elevations;
+  this->dataPtr->blankingAzimuthOffsets = _azimuthOffsets;
+  this->dataPtr->UpdateBlankingMask(*this);
+}
+
+//////////////////////////////////////////////////
+void LidarPrivate::UpdateBlankingMask(const Lidar &_lidar)
+{
+  this->blankingMask.reset();
+  const unsigned int width = _lidar.RangeCount();
+  const unsigned int height = this->blankingElevations.empty() ?
+      _lidar.VerticalRangeCount() :
+      static_cast<unsigned int>(this->blankingElevations.size());
+  if (this->blankingZones.empty() || width == 0u || height == 0u)
+    return;
+
+  const double angleMin = _lidar.AngleMin().Radian();
+  const double angleStep = width > 1u ?
+      (_lidar.AngleMax().Radian() - angleMin) / (width - 1u) : 0.0;
+  const double verticalAngleMin = _lidar.VerticalAngleMin().Radian();
+  const double verticalAngleStep = height > 1u ?
+      (_lidar.VerticalAngleMax().Radian() - verticalAngleMin) /
+      (height - 1u) : 0.0;
+
+  auto mask = std::make_shared<std::vector<uint8_t>>(
+      static_cast<std::size_t>(width) * height, 0u);
+  bool blanked = false;
+  for (unsigned int j = 0u; j < height; ++j)
   {
-    // gzdbg << "Size mismatch; allocating memory\n";
-    this->dataPtr->laserMsg.clear_ranges();
-    this->dataPtr->laserMsg.clear_intensities();
-    for (int i = 0; i < numRays; ++i)
+    const double elevation = this->blankingElevations.empty() ?
+        verticalAngleMin + j * verticalAngleStep :
+        this->blankingElevations[j];
+    const double offset = j < this->blankingAzimuthOffsets.size() ?
+        this->blankingAzimuthOffsets[j] : 0.0;
+    for (const LidarBlankingZone &zone : this->blankingZones)
     {
-      this->dataPtr->laserMsg.add_ranges(gz::math::NAN_F);
-      this->dataPtr->laserMsg.add_intensities(gz::math::NAN_F);
+      if (elevation < zone.verticalAngleMin ||
+          elevation > zone.verticalAngleMax)
+      {
+        continue;
+      }
+      for (unsigned int i = 0u; i < width; ++i)
+      {
+        const double azimuth = angleMin + i * angleStep + offset;
+        for (const double turn : {0.0, -2.0 * GZ_PI, 2.0 * GZ_PI})
+        {
+          if (azimuth + turn >= zone.angleMin &&
+              azimuth + turn <= zone.angleMax)
+          {
+            (*mask)[static_cast<std::size_t>(j) * width + i] = 1u;
+            blanked = true;
+            break;
+          }
+        }
+      }
     }
   }
+  if (blanked)
+    this->blankingMask = std::move(mask);
+}
+
+//////////////////////////////////////////////////
+bool Lidar::PublishLidarScan(const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("Lidar::PublishLidarScan");
+  const float *scan = this->AcquireScanBuffer();
+  if (!scan)
+  {
+    this->ReleaseScanBuffer();
+    return false;
+  }
 
-  for (unsigned int j = 0; j < this->VerticalRangeCount(); ++j)
+  const int numRays = this->RayCount() * this->VerticalRayCount();
+  if (this->dataPtr->nextRanges.size() != numRays)
   {
-    for (unsigned int i = 0; i < this->RangeCount(); ++i)
-    {
-      int index = j * this->RangeCount() + i;
-      double range = this->laserBuffer[index*3];
+    // gzdbg << "Size mismatch; allocating memory\n";
+    this->dataPtr->nextRanges.Resize(numRays, gz::math::NAN_F);
+    this->dataPtr->nextIntensities.Resize(numRays, gz::math::NAN_F);
+  }
 
-      range = gz::math::isnan(range) ? this->RangeMax() : range;
-      this->dataPtr->laserMsg.set_ranges(index, range);
-      this->dataPtr->laserMsg.set_intensities(index,
-          this->laserBuffer[index * 3 + 1]);
-    }
+  // Deinterleave the range and intensity channels into the next message
+  // buffers, without blocking the readers of the current ones
+  const std::size_t count = std::min<std::size_t>(numRays,
+      static_cast<std::size_t>(this->RangeCount()) *
+      this->VerticalRangeCount());
+  DeinterleaveScan(scan, count, this->RangeMax(),
+      this->dataPtr->nextRanges.mutable_data(),
+      this->dataPtr->nextIntensities.mutable_data());
+  this->ReleaseScanBuffer();
+
+  {
+    std::lock_guard<std::mutex> lock(this->lidarMutex);
+
+    // keeping here the sensor name instead of frame_id because the
+    // visualizeLidar plugin relies on this value to get the position of the
+    // lidar. the ros_gz plugin is using the laserscan.proto 'frame' field
+    this->FillHeader(this->dataPtr->laserMsg.mutable_header(), _now,
+        this->Name(), "default");
+    this->dataPtr->laserMsg.set_frame(this->FrameId());
+
+    // Store the latest laser scans into laserMsg
+    msgs::Set(this->dataPtr->laserMsg.mutable_world_pose(),
+        this->Pose());
+    this->dataPtr->laserMsg.mutable_ranges()->Swap(
+        &this->dataPtr->nextRanges);
+    this->dataPtr->laserMsg.mutable_intensities()->Swap(
+        &this->dataPtr->nextIntensities);
   }
 
-  // publish
-  this->AddSequence(this->dataPtr->laserMsg.mutable_header());
-  this->dataPtr->pub.Publish(this->dataPtr->laserMsg);
+  // publish, the message is only modified by this thread
+  this->Publish(this->dataPtr->pub, this->dataPtr->laserMsg);
 
   return true;
 }
@@ -476,3 +791,18 @@ bool Lidar::HasConnections() const
 {
   return this->dataPtr->pub && this->dataPtr->pub.HasConnections();
 }
+
+//////////////////////////////////////////////////
+SensorMemoryUsage Lidar::MemoryUsage() const
+{
+  SensorMemoryUsage usage = RenderingSensor::MemoryUsage();
+  usage["scans"] = this->dataPtr->scanPool.MemorySize();
+  usage["laser_msg"] = MemorySize(this->dataPtr->laserMsg) +
+      this->dataPtr->nextRanges.SpaceUsedExcludingSelfLong() +
+      this->dataPtr->nextIntensities.SpaceUsedExcludingSelfLong();
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->blankingMutex);
+  if (this->dataPtr->blankingMask)
+    usage["blanking_mask"] = MemorySize(*this->dataPtr->blankingMask);
+  return usage;
+}
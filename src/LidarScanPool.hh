@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_LIDARSCANPOOL_HH_
+#define GZ_SENSORS_LIDARSCANPOOL_HH_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include "gz/sensors/config.hh"
+#include "AlignedBuffer.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Triple buffer of lidar scans. A writer fills the next scan
+    /// while a reader works on the latest one, without either of them
+    /// holding a lock during the copy. Only the choice of buffers is
+    /// serialized, by a mutex held for a few instructions.
+    class LidarScanPool
+    {
+      /// \brief Get the buffer for the next scan. It's never the latest
+      /// scan nor the scan being read.
+      /// \param[in] _samples Number of floats of the scan.
+      /// \return Buffer of _samples floats.
+      public: float *WriteBuffer(std::size_t _samples)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        const int latestIndex = this->latest.load();
+        for (int i = 0; i < kBufferCount; ++i)
+        {
+          if (i != latestIndex && i != this->reading)
+          {
+            this->writing = i;
+            break;
+          }
+        }
+        AlignedBuffer<float> &buffer = this->buffers[this->writing];
+        buffer.Resize(_samples);
+        return buffer.Data();
+      }
+
+      /// \brief Make the buffer of the last WriteBuffer call the latest
+      /// scan.
+      /// \return The latest scan, null if nothing was written.
+      public: float *Commit()
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->writing >= 0)
+        {
+          this->latest.store(this->writing);
+          this->writing = -1;
+        }
+        const int latestIndex = this->latest.load();
+        return latestIndex < 0 ? nullptr : this->buffers[latestIndex].Data();
+      }
+
+      /// \brief Get the latest scan and keep it from being overwritten
+      /// until Release is called. Calls can't be nested.
+      /// \return The latest scan, null if none was committed.
+      public: float *Acquire()
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->reading = this->latest.load();
+        return this->reading < 0 ?
+            nullptr : this->buffers[this->reading].Data();
+      }
+
+      /// \brief Let the writer reuse the scan returned by Acquire.
+      public: void Release()
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->reading = -1;
+      }
+
+      /// \brief Check if a scan was committed, without locking.
+      /// \return True if there's a latest scan.
+      public: bool HasScan() const
+      {
+        return this->latest.load() >= 0;
+      }
+
+      /// \brief Check if a pointer is one of the buffers of the pool.
+      /// \param[in] _buffer Pointer to check.
+      /// \return True if the pool owns the buffer.
+      public: bool Owns(const float *_buffer) const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (const AlignedBuffer<float> &buffer : this->buffers)
+        {
+          if (!buffer.Empty() && buffer.Data() == _buffer)
+            return true;
+        }
+        return false;
+      }
+
+      /// \brief Get the memory allocated for the scans.
+      /// \return Bytes allocated by the buffers.
+      public: std::size_t MemorySize() const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::size_t bytes = 0u;
+        for (const AlignedBuffer<float> &buffer : this->buffers)
+          bytes += buffer.Capacity() * sizeof(float);
+        return bytes;
+      }
+
+      /// \brief Set the kind of memory of the scans allocated afterwards.
+      /// \param[in] _memory Kind of memory.
+      public: void SetMemory(SensorBufferMemory _memory)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (AlignedBuffer<float> &buffer : this->buffers)
+          buffer.SetMemory(_memory);
+      }
+
+      /// \brief Number of buffers, one per role.
+      private: static constexpr int kBufferCount = 3;
+
+      /// \brief The scans.
+      private: std::array<AlignedBuffer<float>, kBufferCount> buffers;
+
+      /// \brief Index of the latest scan, -1 if there's none.
+      private: std::atomic<int> latest{-1};
+
+      /// \brief Index of the scan being written, -1 if there's none.
+      private: int writing{-1};
+
+      /// \brief Index of the scan being read, -1 if there's none.
+      private: int reading{-1};
+
+      /// \brief Protects the choice of buffers.
+      private: mutable std::mutex mutex;
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "LidarScanPool.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(LidarScanPool, Empty)
+{
+  LidarScanPool pool;
+  EXPECT_FALSE(pool.HasScan());
+  EXPECT_EQ(nullptr, pool.Commit());
+  EXPECT_EQ(nullptr, pool.Acquire());
+  pool.Release();
+  EXPECT_FALSE(pool.Owns(nullptr));
+}
+
+//////////////////////////////////////////////////
+TEST(LidarScanPool, Buffers)
+{
+  LidarScanPool pool;
+  float *first = pool.WriteBuffer(4u);
+  ASSERT_NE(nullptr, first);
+  first[0] = 1.0f;
+  EXPECT_EQ(first, pool.Commit());
+  EXPECT_TRUE(pool.HasScan());
+  EXPECT_TRUE(pool.Owns(first));
+
+  // The next scan never overwrites the latest one
+  float *second = pool.WriteBuffer(4u);
+  EXPECT_NE(first, second);
+
+  // Nor the one being read, after it was replaced
+  float *reading = pool.Acquire();
+  EXPECT_EQ(first, reading);
+  second[0] = 2.0f;
+  EXPECT_EQ(second, pool.Commit());
+  float *third = pool.WriteBuffer(4u);
+  EXPECT_NE(first, third);
+  EXPECT_NE(second, third);
+  EXPECT_FLOAT_EQ(1.0f, reading[0]);
+  pool.Release();
+
+  // The latest scan is read next
+  EXPECT_EQ(second, pool.Acquire());
+  pool.Release();
+
+  float value = 0.0f;
+  EXPECT_FALSE(pool.Owns(&value));
+}
+
+//////////////////////////////////////////////////
+TEST(LidarScanPool, Threads)
+{
+  // Each scan is filled with its number, so a reader sees a torn scan if
+  // the writer overwrites it
+  constexpr std::size_t kSamples = 1024u;
+  constexpr int kScans = 2000;
+  LidarScanPool pool;
+  std::atomic<bool> done{false};
+  std::thread writer([&]
+  {
+    for (int n = 1; n <= kScans; ++n)
+    {
+      float *buffer = pool.WriteBuffer(kSamples);
+      for (std::size_t i = 0u; i < kSamples; ++i)
+        buffer[i] = static_cast<float>(n);
+      pool.Commit();
+    }
+    done = true;
+  });
+
+  int torn = 0;
+  while (!done)
+  {
+    const float *scan = pool.Acquire();
+    if (scan)
+    {
+      for (std::size_t i = 1u; i < kSamples; ++i)
+      {
+        if (scan[i] != scan[0])
+        {
+          ++torn;
+          break;
+        }
+      }
+    }
+    pool.Release();
+  }
+  writer.join();
+  EXPECT_EQ(0, torn);
+}
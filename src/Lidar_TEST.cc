@@ -17,8 +17,20 @@
 #include <gtest/gtest.h>
 #include <sdf/sdf.hh>
 
+#include <gz/msgs/laserscan.pb.h>
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <gz/math/Angle.hh>
 #include <gz/math/Helpers.hh>
+#include <gz/transport/Node.hh>
 
 #include <gz/sensors/Export.hh>
 #include <gz/sensors/Manager.hh>
@@ -224,3 +236,94 @@ TEST(Lidar_TEST, CreateLaserFailures)
   sensor.Update(std::chrono::steady_clock::duration(
     std::chrono::milliseconds(100)));
 }
+
+/////////////////////////////////////////////////
+/// \brief Test splitting a scan into the ranges and intensities of the
+/// published message
+TEST(Lidar_TEST, PublishScan)
+{
+  gz::sensors::Manager mgr;
+
+  // 14 rays, so the last two don't fill a group of four
+  const std::string topic = "/gz/sensors/test/lidar_publish_scan";
+  const double rangeMax = 10.0;
+  sdf::ElementPtr lidarSDF = LidarToSDF("TestLidar", 30, topic,
+      7, 1, -0.5, 0.5, 2, 1, -0.1, 0.1, 0.01, 0.08, rangeMax, 1u, true,
+      false);
+  gz::sensors::Lidar *sensor = mgr.CreateSensor<gz::sensors::Lidar>(
+      lidarSDF);
+  ASSERT_NE(nullptr, sensor);
+  const std::size_t count = 14u;
+  ASSERT_EQ(count, static_cast<std::size_t>(sensor->RangeCount()) *
+      sensor->VerticalRangeCount());
+
+  std::mutex mutex;
+  gz::msgs::LaserScan scanMsg;
+  int received = 0;
+  std::function<void(const gz::msgs::LaserScan &)> cb =
+      [&](const gz::msgs::LaserScan &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        scanMsg = _msg;
+        ++received;
+      };
+  gz::transport::Node node;
+  EXPECT_TRUE(node.Subscribe(topic, cb));
+  for (int sleep = 0; sleep < 30 && !sensor->HasConnections(); ++sleep)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_TRUE(sensor->HasConnections());
+
+  // Range, intensity and retro of each ray, with NaN and inf ranges in both
+  // the groups of four and the tail
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> expectedRanges(count);
+  std::vector<float> expectedIntensities(count);
+  float *scan = sensor->ScanWriteBuffer(count * 3u);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    float range = 0.5f + 0.25f * i;
+    if (i == 1u || i == 6u || i == 13u)
+      range = nan;
+    else if (i == 4u || i == 12u)
+      range = inf;
+    scan[i * 3] = range;
+    scan[i * 3 + 1] = 100.0f + i;
+    scan[i * 3 + 2] = -1.0f;
+    expectedRanges[i] = std::isnan(range) ?
+        static_cast<float>(rangeMax) : range;
+    expectedIntensities[i] = 100.0f + i;
+  }
+  sensor->CommitScanBuffer();
+
+  EXPECT_TRUE(sensor->PublishLidarScan(std::chrono::seconds(1)));
+
+  std::vector<double> ranges;
+  sensor->Ranges(ranges);
+  ASSERT_EQ(count, ranges.size());
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    EXPECT_DOUBLE_EQ(expectedRanges[i], ranges[i]) << i;
+    EXPECT_DOUBLE_EQ(expectedRanges[i], sensor->Range(static_cast<int>(i)))
+        << i;
+  }
+
+  for (int sleep = 0; sleep < 30; ++sleep)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (received > 0)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(1, received);
+  ASSERT_EQ(static_cast<int>(count), scanMsg.ranges_size());
+  ASSERT_EQ(static_cast<int>(count), scanMsg.intensities_size());
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    EXPECT_DOUBLE_EQ(expectedRanges[i], scanMsg.ranges(i)) << i;
+    EXPECT_DOUBLE_EQ(expectedIntensities[i], scanMsg.intensities(i)) << i;
+  }
+}
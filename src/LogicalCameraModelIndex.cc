@@ -0,0 +1,490 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "gz/sensors/LogicalCameraModelIndex.hh"
+#include "ModelPoseGrid.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Number of spheres tested against the frustum planes at once.
+constexpr std::size_t kSphereBatchSize = 64u;
+
+/// \brief Spheres to test against the frustum planes, as arrays of
+/// each coordinate.
+struct SphereBatch
+{
+  /// \brief Model ids of the spheres.
+  std::array<std::size_t, kSphereBatchSize> ids;
+
+  /// \brief Sphere center x coordinates.
+  std::array<double, kSphereBatchSize> x;
+
+  /// \brief Sphere center y coordinates.
+  std::array<double, kSphereBatchSize> y;
+
+  /// \brief Sphere center z coordinates.
+  std::array<double, kSphereBatchSize> z;
+
+  /// \brief Sphere radii.
+  std::array<double, kSphereBatchSize> r;
+
+  /// \brief Set to 1 for spheres that intersect all planes' positive
+  /// side, 0 otherwise.
+  std::array<uint8_t, kSphereBatchSize> inside;
+
+  /// \brief Number of spheres in the batch.
+  std::size_t size{0};
+};
+
+/// \brief Planes of a frustum, as in math::Planed, with their normal
+/// pointing inside the frustum.
+struct FrustumPlanes
+{
+  /// \brief Normal x coordinates.
+  std::array<double, 6> nx;
+
+  /// \brief Normal y coordinates.
+  std::array<double, 6> ny;
+
+  /// \brief Normal z coordinates.
+  std::array<double, 6> nz;
+
+  /// \brief Offsets along the normals.
+  std::array<double, 6> d;
+};
+
+//////////////////////////////////////////////////
+/// \brief Test a batch of spheres against the planes of a frustum. A
+/// sphere is inside if its signed distance to every plane is at least
+/// minus its radius.
+/// \param[in] _planes Frustum planes.
+/// \param[in,out] _batch Spheres, their inside flags are set.
+void TestSpheres(const FrustumPlanes &_planes, SphereBatch &_batch)
+{
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 2 <= _batch.size; i += 2)
+  {
+    const __m128d x = _mm_loadu_pd(&_batch.x[i]);
+    const __m128d y = _mm_loadu_pd(&_batch.y[i]);
+    const __m128d z = _mm_loadu_pd(&_batch.z[i]);
+    const __m128d r = _mm_loadu_pd(&_batch.r[i]);
+    __m128d inside = _mm_cmpeq_pd(r, r);
+    for (std::size_t p = 0; p < 6; ++p)
+    {
+      const __m128d dist = _mm_add_pd(_mm_add_pd(_mm_add_pd(
+          _mm_mul_pd(_mm_set1_pd(_planes.nx[p]), x),
+          _mm_mul_pd(_mm_set1_pd(_planes.ny[p]), y)),
+          _mm_mul_pd(_mm_set1_pd(_planes.nz[p]), z)),
+          _mm_sub_pd(r, _mm_set1_pd(_planes.d[p])));
+      inside = _mm_and_pd(inside, _mm_cmpge_pd(dist, _mm_setzero_pd()));
+    }
+    const int mask = _mm_movemask_pd(inside);
+    _batch.inside[i] = static_cast<uint8_t>(mask & 1);
+    _batch.inside[i + 1] = static_cast<uint8_t>((mask >> 1) & 1);
+  }
+#endif
+  for (; i < _batch.size; ++i)
+  {
+    bool inside = true;
+    for (std::size_t p = 0; p < 6; ++p)
+    {
+      const double dist = _planes.nx[p] * _batch.x[i] +
+          _planes.ny[p] * _batch.y[i] + _planes.nz[p] * _batch.z[i] +
+          (_batch.r[i] - _planes.d[p]);
+      inside = inside && dist >= 0.0;
+    }
+    _batch.inside[i] = inside ? 1u : 0u;
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the bounding box of the corners of a frustum.
+/// \param[in] _frustum Frustum.
+/// \param[out] _min Minimum corner of the box.
+/// \param[out] _max Maximum corner of the box.
+void FrustumBox(const math::Frustum &_frustum, math::Vector3d &_min,
+                math::Vector3d &_max)
+{
+  // The frustum looks along its +x axis, with the near and far planes
+  // normal to it.
+  const double tanHalfFov = std::tan(_frustum.FOV().Radian() * 0.5);
+  const double aspectRatio =
+      _frustum.AspectRatio() > 0.0 ? _frustum.AspectRatio() : 1.0;
+  _min.Set(std::numeric_limits<double>::infinity(),
+           std::numeric_limits<double>::infinity(),
+           std::numeric_limits<double>::infinity());
+  _max = -_min;
+  for (double distance : {_frustum.Near(), _frustum.Far()})
+  {
+    const double halfWidth = distance * tanHalfFov;
+    const double halfHeight = halfWidth / aspectRatio;
+    for (double y : {-halfWidth, halfWidth})
+    {
+      for (double z : {-halfHeight, halfHeight})
+      {
+        const math::Vector3d corner =
+            _frustum.Pose().CoordPositionAdd(
+                math::Vector3d(distance, y, z));
+        _min.Min(corner);
+        _max.Max(corner);
+      }
+    }
+  }
+}
+}
+
+/// \brief Private data for LogicalCameraModelIndex
+class gz::sensors::LogicalCameraModelIndexPrivate
+{
+  /// \brief Constructor
+  /// \param[in] _cellSize Length of the side of a grid cell.
+  public: explicit LogicalCameraModelIndexPrivate(double _cellSize)
+    : grid(_cellSize)
+  {
+  }
+
+  /// \brief Add a model.
+  /// \param[in] _name Model name.
+  /// \param[in] _pose Model world pose.
+  /// \return Id of the model.
+  public: std::size_t Add(const std::string &_name,
+                          const math::Pose3d &_pose)
+  {
+    std::size_t id;
+    if (!this->freeIds.empty())
+    {
+      id = this->freeIds.back();
+      this->freeIds.pop_back();
+      this->names[id] = _name;
+      this->poses[id] = _pose;
+      this->used[id] = true;
+      this->bounds[id] = Sphere();
+    }
+    else
+    {
+      id = this->names.size();
+      this->names.push_back(_name);
+      this->poses.push_back(_pose);
+      this->used.push_back(true);
+      this->bounds.emplace_back();
+    }
+    this->bounds[id].worldCenter = _pose.Pos();
+    this->grid.Set(id, _pose.Pos());
+    return id;
+  }
+
+  /// \brief Remove a model.
+  /// \param[in] _id Id of the model.
+  public: void Remove(std::size_t _id)
+  {
+    this->grid.Remove(_id);
+    this->names[_id].clear();
+    this->used[_id] = false;
+    this->freeIds.push_back(_id);
+  }
+
+  /// \brief Set the pose of a model.
+  /// \param[in] _id Id of the model.
+  /// \param[in] _pose Model world pose.
+  /// \return False if there's no model with that id.
+  public: bool SetPose(std::size_t _id, const math::Pose3d &_pose)
+  {
+    if (_id >= this->used.size() || !this->used[_id])
+      return false;
+    this->poses[_id] = _pose;
+    Sphere &sphere = this->bounds[_id];
+    sphere.worldCenter = _pose.CoordPositionAdd(sphere.center);
+    this->grid.Set(_id, _pose.Pos());
+    return true;
+  }
+
+  /// \brief Bounding sphere of a model.
+  public: struct Sphere
+  {
+    /// \brief Center in the model frame.
+    math::Vector3d center;
+
+    /// \brief Center in the world frame.
+    math::Vector3d worldCenter;
+
+    /// \brief Radius, zero if the model has no bounds.
+    double radius{0.0};
+  };
+
+  /// \brief Guards all members, queries share it.
+  public: mutable std::shared_mutex mutex;
+
+  /// \brief Grid of model positions, by model id.
+  public: ModelPoseGrid grid;
+
+  /// \brief Ids of the models, by name.
+  public: std::map<std::string, std::size_t> ids;
+
+  /// \brief Model names, by id. Empty for free ids.
+  public: std::vector<std::string> names;
+
+  /// \brief Whether each id is used by a model.
+  public: std::vector<bool> used;
+
+  /// \brief Model bounding spheres, by id.
+  public: std::vector<Sphere> bounds;
+
+  /// \brief Largest distance from a model origin to the farthest point
+  /// of its bounding sphere, over all models ever given bounds.
+  public: double maxReach{0.0};
+
+  /// \brief Model world poses, by id.
+  public: std::vector<math::Pose3d> poses;
+
+  /// \brief Ids of removed models, to be reused.
+  public: std::vector<std::size_t> freeIds;
+};
+
+//////////////////////////////////////////////////
+LogicalCameraModelIndex::LogicalCameraModelIndex(double _cellSize)
+  : dataPtr(new LogicalCameraModelIndexPrivate(_cellSize))
+{
+}
+
+//////////////////////////////////////////////////
+LogicalCameraModelIndex::~LogicalCameraModelIndex() = default;
+
+//////////////////////////////////////////////////
+double LogicalCameraModelIndex::CellSize() const
+{
+  return this->dataPtr->grid.CellSize();
+}
+
+//////////////////////////////////////////////////
+void LogicalCameraModelIndex::SetModelPoses(
+    const std::map<std::string, math::Pose3d> &_models)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  auto &ids = this->dataPtr->ids;
+
+  // Both maps are sorted by name, walk them together
+  auto id = ids.begin();
+  auto model = _models.begin();
+  while (id != ids.end() || model != _models.end())
+  {
+    if (model == _models.end() ||
+        (id != ids.end() && id->first < model->first))
+    {
+      // The model is gone
+      this->dataPtr->Remove(id->second);
+      id = ids.erase(id);
+    }
+    else if (id == ids.end() || model->first < id->first)
+    {
+      // The model is new
+      ids.emplace_hint(id, model->first,
+                       this->dataPtr->Add(model->first, model->second));
+      ++model;
+    }
+    else
+    {
+      this->dataPtr->SetPose(id->second, model->second);
+      ++id;
+      ++model;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+std::size_t LogicalCameraModelIndex::AddModel(const std::string &_name,
+    const math::Pose3d &_pose)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  auto id = this->dataPtr->ids.lower_bound(_name);
+  if (id != this->dataPtr->ids.end() && id->first == _name)
+  {
+    this->dataPtr->SetPose(id->second, _pose);
+    return id->second;
+  }
+  const std::size_t newId = this->dataPtr->Add(_name, _pose);
+  this->dataPtr->ids.emplace_hint(id, _name, newId);
+  return newId;
+}
+
+//////////////////////////////////////////////////
+bool LogicalCameraModelIndex::RemoveModel(std::size_t _id)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  if (_id >= this->dataPtr->used.size() || !this->dataPtr->used[_id])
+    return false;
+  this->dataPtr->ids.erase(this->dataPtr->names[_id]);
+  this->dataPtr->Remove(_id);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool LogicalCameraModelIndex::SetModelPose(std::size_t _id,
+    const math::Pose3d &_pose)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->SetPose(_id, _pose);
+}
+
+//////////////////////////////////////////////////
+void LogicalCameraModelIndex::SetModelPoses(
+    const std::vector<std::pair<std::size_t, math::Pose3d>> &_poses)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  for (const auto &[id, pose] : _poses)
+    this->dataPtr->SetPose(id, pose);
+}
+
+//////////////////////////////////////////////////
+std::optional<std::size_t> LogicalCameraModelIndex::ModelId(
+    const std::string &_name) const
+{
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  auto id = this->dataPtr->ids.find(_name);
+  if (id == this->dataPtr->ids.end())
+    return std::nullopt;
+  return id->second;
+}
+
+//////////////////////////////////////////////////
+std::size_t LogicalCameraModelIndex::ModelCount() const
+{
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->ids.size();
+}
+
+//////////////////////////////////////////////////
+bool LogicalCameraModelIndex::SetModelBounds(std::size_t _id,
+    const math::AxisAlignedBox &_box)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  if (_id >= this->dataPtr->used.size() || !this->dataPtr->used[_id])
+    return false;
+
+  LogicalCameraModelIndexPrivate::Sphere &sphere =
+      this->dataPtr->bounds[_id];
+  if (_box.Min().X() > _box.Max().X() || _box.Min().Y() > _box.Max().Y() ||
+      _box.Min().Z() > _box.Max().Z())
+  {
+    // Empty box, test the model origin
+    sphere.center = math::Vector3d::Zero;
+    sphere.radius = 0.0;
+  }
+  else
+  {
+    sphere.center = _box.Center();
+    sphere.radius = _box.Size().Length() * 0.5;
+  }
+  sphere.worldCenter =
+      this->dataPtr->poses[_id].CoordPositionAdd(sphere.center);
+  this->dataPtr->maxReach = std::max(this->dataPtr->maxReach,
+      sphere.center.Length() + sphere.radius);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void LogicalCameraModelIndex::ForEachModelInFrustum(
+    const math::Frustum &_frustum,
+    const std::function<void(const std::string &,
+                             const math::Pose3d &)> &_f) const
+{
+  math::Vector3d boxMin, boxMax;
+  FrustumBox(_frustum, boxMin, boxMax);
+
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->grid.ForEachInBox(boxMin, boxMax,
+      [&](std::size_t _id)
+      {
+        const math::Pose3d &pose = this->dataPtr->poses[_id];
+        if (_frustum.Contains(pose.Pos()))
+          _f(this->dataPtr->names[_id], pose);
+      });
+}
+
+//////////////////////////////////////////////////
+void LogicalCameraModelIndex::ForEachModelIntersectingFrustum(
+    const math::Frustum &_frustum,
+    const std::function<void(const std::string &,
+                             const math::Pose3d &)> &_f) const
+{
+  FrustumPlanes planes;
+  for (int p = 0; p < 6; ++p)
+  {
+    const math::Planed plane =
+        _frustum.Plane(static_cast<math::Frustum::FrustumPlane>(p));
+    planes.nx[p] = plane.Normal().X();
+    planes.ny[p] = plane.Normal().Y();
+    planes.nz[p] = plane.Normal().Z();
+    planes.d[p] = plane.Offset();
+  }
+
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->mutex);
+
+  // Models whose origin is out of the frustum box may still reach into it
+  math::Vector3d boxMin, boxMax;
+  FrustumBox(_frustum, boxMin, boxMax);
+  const math::Vector3d reach(this->dataPtr->maxReach,
+      this->dataPtr->maxReach, this->dataPtr->maxReach);
+  boxMin -= reach;
+  boxMax += reach;
+
+  SphereBatch batch;
+  auto flush = [&]()
+  {
+    TestSpheres(planes, batch);
+    for (std::size_t i = 0; i < batch.size; ++i)
+    {
+      if (batch.inside[i])
+      {
+        const std::size_t id = batch.ids[i];
+        _f(this->dataPtr->names[id], this->dataPtr->poses[id]);
+      }
+    }
+    batch.size = 0;
+  };
+
+  const auto &bounds = this->dataPtr->bounds;
+  this->dataPtr->grid.ForEachInBox(boxMin, boxMax,
+      [&](std::size_t _id)
+      {
+        const LogicalCameraModelIndexPrivate::Sphere &sphere = bounds[_id];
+        batch.ids[batch.size] = _id;
+        batch.x[batch.size] = sphere.worldCenter.X();
+        batch.y[batch.size] = sphere.worldCenter.Y();
+        batch.z[batch.size] = sphere.worldCenter.Z();
+        batch.r[batch.size] = sphere.radius;
+        if (++batch.size == kSphereBatchSize)
+          flush();
+      });
+  flush();
+}
@@ -15,7 +15,15 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <gz/common/Console.hh>
 #include <gz/common/Profiler.hh>
@@ -33,6 +41,10 @@ using namespace sensors;
 /// \brief Private data for LogicalCameraSensor
 class gz::sensors::LogicalCameraSensorPrivate
 {
+  /// \brief Fill the delta image from the last image.
+  /// \param[in] _keyframe True to list all the visible models.
+  public: void FillDelta(bool _keyframe);
+
   /// \brief node to create publisher
   public: transport::Node node;
 
@@ -51,13 +63,124 @@ class gz::sensors::LogicalCameraSensorPrivate
   /// \brief Set world pose.
   public: math::Pose3d worldPose;
 
-  /// \brief List of models in the world
+  /// \brief List of models in the world, given to SetModelPoses
   public: std::map<std::string, math::Pose3d> models;
 
+  /// \brief True if models changed since they were last indexed.
+  public: bool modelsChanged = false;
+
+  /// \brief Index of the models given to SetModelPoses.
+  public: LogicalCameraModelIndex ownIndex;
+
+  /// \brief Index set with SetModelIndex, if any.
+  public: std::shared_ptr<const LogicalCameraModelIndex> sharedIndex;
+
+  /// \brief True to detect models by their bounding volume.
+  public: bool boundingVolumeDetection = false;
+
   /// \brief Msg containg info on models detected by logical camera
   msgs::LogicalCameraImage msg;
+
+  /// \brief Copy of the last image, replaced atomically on each update
+  /// once LatestImage has been called.
+  public: std::shared_ptr<const msgs::LogicalCameraImage> latestImage;
+
+  /// \brief True once LatestImage has been called.
+  public: std::atomic<bool> latestRequested{false};
+
+  /// \brief Publisher of the delta images.
+  public: transport::Node::Publisher deltaPub;
+
+  /// \brief Delta image, reused across updates.
+  public: msgs::LogicalCameraImage deltaMsg;
+
+  /// \brief A model known to the subscribers of the delta images.
+  public: struct DeltaModel
+  {
+    /// \brief Pose in the camera frame, when last published.
+    math::Pose3d pose;
+
+    /// \brief Delta image the model was last visible in.
+    uint64_t seen{0u};
+  };
+
+  /// \brief Models known to the subscribers of the delta images.
+  public: std::unordered_map<std::string, DeltaModel> deltaModels;
+
+  /// \brief Names of the models that left the frustum in the last delta
+  /// image.
+  public: std::vector<std::string> deltaLeft;
+
+  /// \brief Number of delta images since subscribers appeared.
+  public: uint64_t deltaCount{0u};
+
+  /// \brief True if the last update published a delta image.
+  public: bool deltaSubscribed{false};
+
+  /// \brief Position change from which a pose is published again.
+  public: double deltaPositionTolerance{0.0};
+
+  /// \brief Rotation change from which a pose is published again.
+  public: math::Angle deltaRotationTolerance{0.0};
+
+  /// \brief Number of delta images between keyframes.
+  public: unsigned int deltaKeyframePeriod{100u};
 };
 
+//////////////////////////////////////////////////
+void LogicalCameraSensorPrivate::FillDelta(bool _keyframe)
+{
+  const uint64_t stamp = ++this->deltaCount;
+  *this->deltaMsg.mutable_pose() = this->msg.pose();
+
+  auto *models = this->deltaMsg.mutable_model();
+  int count = 0;
+  for (const auto &modelMsg : this->msg.model())
+  {
+    const math::Pose3d pose = msgs::Convert(modelMsg.pose());
+    auto [it, entered] = this->deltaModels.try_emplace(modelMsg.name());
+    DeltaModel &model = it->second;
+    model.seen = stamp;
+    if (!_keyframe && !entered)
+    {
+      const math::Quaterniond rotation =
+          model.pose.Rot().Inverse() * pose.Rot();
+      const double angle =
+          2.0 * std::acos(std::min(1.0, std::abs(rotation.W())));
+      if (model.pose.Pos().Distance(pose.Pos()) <=
+              this->deltaPositionTolerance &&
+          angle <= this->deltaRotationTolerance.Radian())
+      {
+        continue;
+      }
+    }
+    model.pose = pose;
+
+    msgs::LogicalCameraImage::Model *deltaModelMsg =
+        count < models->size() ? models->Mutable(count) : models->Add();
+    ++count;
+    if (deltaModelMsg->name() != modelMsg.name())
+      deltaModelMsg->set_name(modelMsg.name());
+    *deltaModelMsg->mutable_pose() = modelMsg.pose();
+  }
+  while (models->size() > count)
+    models->RemoveLast();
+
+  // Models that aren't visible anymore left the frustum
+  this->deltaLeft.clear();
+  for (auto it = this->deltaModels.begin(); it != this->deltaModels.end();)
+  {
+    if (it->second.seen == stamp)
+    {
+      ++it;
+      continue;
+    }
+    if (!_keyframe)
+      this->deltaLeft.push_back(it->first);
+    it = this->deltaModels.erase(it);
+  }
+}
+
 //////////////////////////////////////////////////
 LogicalCameraSensor::LogicalCameraSensor()
   : dataPtr(new LogicalCameraSensorPrivate())
@@ -106,11 +229,8 @@ bool LogicalCameraSensor::Load(sdf::ElementPtr _sdf)
   if (this->Topic().empty())
     this->SetTopic("/logical_camera");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<msgs::LogicalCameraImage>(
-      this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<msgs::LogicalCameraImage>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic[" << this->Topic() << "].\n";
     return false;
@@ -119,6 +239,14 @@ bool LogicalCameraSensor::Load(sdf::ElementPtr _sdf)
   gzdbg << "Logical images for [" << this->Name() << "] advertised on ["
          << this->Topic() << "]" << std::endl;
 
+  const std::string deltaTopic = this->Topic() + "/delta";
+  if (!this->Advertise<msgs::LogicalCameraImage>(this->dataPtr->node,
+      this->dataPtr->deltaPub, deltaTopic))
+  {
+    gzerr << "Unable to create publisher on topic[" << deltaTopic << "].\n";
+    return false;
+  }
+
   this->dataPtr->initialized = true;
   return true;
 }
@@ -127,7 +255,71 @@ bool LogicalCameraSensor::Load(sdf::ElementPtr _sdf)
 void LogicalCameraSensor::SetModelPoses(
     std::map<std::string, math::Pose3d> &&_models)
 {
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
   this->dataPtr->models = std::move(_models);
+  this->dataPtr->modelsChanged = true;
+}
+
+//////////////////////////////////////////////////
+void LogicalCameraSensor::SetModelIndex(
+    std::shared_ptr<const LogicalCameraModelIndex> _index)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->sharedIndex = std::move(_index);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const LogicalCameraModelIndex>
+LogicalCameraSensor::ModelIndex() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->sharedIndex;
+}
+
+//////////////////////////////////////////////////
+void LogicalCameraSensor::SetDeltaPublishing(double _positionTolerance,
+    const math::Angle &_rotationTolerance, unsigned int _keyframePeriod)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->deltaPositionTolerance = std::max(0.0, _positionTolerance);
+  this->dataPtr->deltaRotationTolerance =
+      std::max(0.0, _rotationTolerance.Radian());
+  this->dataPtr->deltaKeyframePeriod = _keyframePeriod;
+}
+
+//////////////////////////////////////////////////
+double LogicalCameraSensor::DeltaPositionTolerance() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->deltaPositionTolerance;
+}
+
+//////////////////////////////////////////////////
+math::Angle LogicalCameraSensor::DeltaRotationTolerance() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->deltaRotationTolerance;
+}
+
+//////////////////////////////////////////////////
+unsigned int LogicalCameraSensor::DeltaKeyframePeriod() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->deltaKeyframePeriod;
+}
+
+//////////////////////////////////////////////////
+void LogicalCameraSensor::SetBoundingVolumeDetection(bool _enabled)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->boundingVolumeDetection = _enabled;
+}
+
+//////////////////////////////////////////////////
+bool LogicalCameraSensor::BoundingVolumeDetection() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->boundingVolumeDetection;
 }
 
 //////////////////////////////////////////////////
@@ -148,27 +340,85 @@ bool LogicalCameraSensor::Update(
   // set frustum pose
   this->dataPtr->frustum.SetPose(this->Pose());
 
-  this->dataPtr->msg.clear_model();
-  for (const auto &it : this->dataPtr->models)
+  // Index the poses given to SetModelPoses once per update, however many
+  // times they were set
+  const LogicalCameraModelIndex *index = this->dataPtr->sharedIndex.get();
+  if (!index)
   {
-    if (this->dataPtr->frustum.Contains(it.second.Pos()))
+    if (this->dataPtr->modelsChanged)
     {
-      msgs::LogicalCameraImage::Model *modelMsg =
-          this->dataPtr->msg.add_model();
-      modelMsg->set_name(it.first);
-      msgs::Set(modelMsg->mutable_pose(), this->Pose().Inverse() * it.second);
+      this->dataPtr->ownIndex.SetModelPoses(this->dataPtr->models);
+      this->dataPtr->modelsChanged = false;
     }
+    index = &this->dataPtr->ownIndex;
+  }
+
+  // Overwrite the models of the last image in place. Models are visited
+  // in the same order while they stay in their cells, so names are
+  // mostly already set.
+  auto *models = this->dataPtr->msg.mutable_model();
+  int count = 0;
+  const math::Pose3d inversePose = this->Pose().Inverse();
+  auto addModel = [&](const std::string &_name, const math::Pose3d &_pose)
+  {
+    msgs::LogicalCameraImage::Model *modelMsg =
+        count < models->size() ? models->Mutable(count) : models->Add();
+    ++count;
+    if (modelMsg->name() != _name)
+      modelMsg->set_name(_name);
+    msgs::Set(modelMsg->mutable_pose(), inversePose * _pose);
+  };
+  if (this->dataPtr->boundingVolumeDetection)
+    index->ForEachModelIntersectingFrustum(this->dataPtr->frustum, addModel);
+  else
+    index->ForEachModelInFrustum(this->dataPtr->frustum, addModel);
+  while (models->size() > count)
+    models->RemoveLast();
+  this->FillHeader(this->dataPtr->msg.mutable_header(), _now);
+
+  if (this->dataPtr->latestRequested.load(std::memory_order_relaxed))
+  {
+    std::atomic_store(&this->dataPtr->latestImage,
+        std::shared_ptr<const msgs::LogicalCameraImage>(
+        std::make_shared<msgs::LogicalCameraImage>(this->dataPtr->msg)));
   }
-  *this->dataPtr->msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-  // Remove 'data' entries before adding new ones
-  this->dataPtr->msg.mutable_header()->clear_data();
-  auto frame = this->dataPtr->msg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->FrameId());
 
   // publish
-  this->AddSequence(this->dataPtr->msg.mutable_header());
-  this->dataPtr->pub.Publish(this->dataPtr->msg);
+  this->Publish(this->dataPtr->pub, this->dataPtr->msg);
+
+  // Deltas are only tracked while they have subscribers, new ones start
+  // with a keyframe
+  auto &d = *this->dataPtr;
+  if (d.deltaPub.HasConnections())
+  {
+    if (!d.deltaSubscribed)
+    {
+      d.deltaModels.clear();
+      d.deltaCount = 0u;
+      d.deltaSubscribed = true;
+    }
+    const bool keyframe = d.deltaCount == 0u ||
+        (d.deltaKeyframePeriod > 0u &&
+         d.deltaCount % d.deltaKeyframePeriod == 0u);
+    d.FillDelta(keyframe);
+
+    auto *header = d.deltaMsg.mutable_header();
+    this->FillHeader(header, _now, this->FrameId(), "delta");
+    auto *keyframeEntry = header->add_data();
+    keyframeEntry->set_key("keyframe");
+    keyframeEntry->add_value(keyframe ? "1" : "0");
+    auto *leftEntry = header->add_data();
+    leftEntry->set_key("left");
+    for (const auto &name : d.deltaLeft)
+      leftEntry->add_value(name);
+
+    this->Publish(d.deltaPub, d.deltaMsg);
+  }
+  else if (d.deltaSubscribed)
+  {
+    d.deltaModels.clear();
+    d.deltaSubscribed = false;
+  }
 
   return true;
 }
@@ -204,9 +454,29 @@ msgs::LogicalCameraImage LogicalCameraSensor::Image() const
   return this->dataPtr->msg;
 }
 
+//////////////////////////////////////////////////
+std::shared_ptr<const msgs::LogicalCameraImage>
+LogicalCameraSensor::LatestImage() const
+{
+  auto image = std::atomic_load(&this->dataPtr->latestImage);
+  if (image)
+    return image;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  image = std::atomic_load(&this->dataPtr->latestImage);
+  if (!image)
+  {
+    image = std::make_shared<msgs::LogicalCameraImage>(this->dataPtr->msg);
+    std::atomic_store(&this->dataPtr->latestImage, image);
+    this->dataPtr->latestRequested = true;
+  }
+  return image;
+}
+
 //////////////////////////////////////////////////
 bool LogicalCameraSensor::HasConnections() const
 {
-  return this->dataPtr->pub && this->dataPtr->pub.HasConnections();
+  return (this->dataPtr->pub && this->dataPtr->pub.HasConnections()) ||
+      (this->dataPtr->deltaPub && this->dataPtr->deltaPub.HasConnections());
 }
 
@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "Lz4Frame.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Magic number of an LZ4 frame.
+constexpr uint32_t kFrameMagic = 0x184D2204u;
+
+/// \brief Largest block, the 4 MiB maximum of the frame format.
+constexpr std::size_t kBlockSize = 4u * 1024u * 1024u;
+
+/// \brief Shortest match of the block format.
+constexpr std::size_t kMinMatch = 4u;
+
+/// \brief The last match must start this many bytes before the end.
+constexpr std::size_t kMatchLimit = 12u;
+
+/// \brief The last bytes of a block are always literals.
+constexpr std::size_t kLastLiterals = 5u;
+
+/// \brief Largest match offset.
+constexpr std::size_t kMaxOffset = 65535u;
+
+/// \brief Number of bits of the hash table index.
+constexpr int kHashBits = 14;
+
+/// \brief Read 4 bytes in host order.
+/// \param[in] _p Bytes to read.
+/// \return The bytes.
+uint32_t Read32(const uint8_t *_p)
+{
+  uint32_t value;
+  std::memcpy(&value, _p, sizeof(value));
+  return value;
+}
+
+/// \brief Read a little endian 32 bit value.
+/// \param[in] _p Bytes to read.
+/// \return The value.
+uint32_t ReadLe32(const uint8_t *_p)
+{
+  return static_cast<uint32_t>(_p[0]) |
+      static_cast<uint32_t>(_p[1]) << 8 |
+      static_cast<uint32_t>(_p[2]) << 16 |
+      static_cast<uint32_t>(_p[3]) << 24;
+}
+
+/// \brief Append a little endian 32 bit value.
+/// \param[in] _value The value.
+/// \param[out] _out String to append to.
+void AppendLe32(uint32_t _value, std::string &_out)
+{
+  for (int i = 0; i < 4; ++i)
+    _out.push_back(static_cast<char>((_value >> (8 * i)) & 0xFFu));
+}
+
+/// \brief Append the extra bytes of a literal or match length.
+/// \param[in] _length Length minus the 15 stored in the token.
+/// \param[out] _out Buffer to append to.
+void AppendLength(std::size_t _length, std::vector<uint8_t> &_out)
+{
+  while (_length >= 255u)
+  {
+    _out.push_back(255u);
+    _length -= 255u;
+  }
+  _out.push_back(static_cast<uint8_t>(_length));
+}
+
+/// \brief Append a sequence of literals followed by an optional match.
+/// \param[in] _literals First literal.
+/// \param[in] _literalCount Number of literals.
+/// \param[in] _offset Match offset, unused if _matchLength is zero.
+/// \param[in] _matchLength Match length, zero for the last sequence.
+/// \param[out] _out Buffer to append to.
+void AppendSequence(const uint8_t *_literals, std::size_t _literalCount,
+    std::size_t _offset, std::size_t _matchLength, std::vector<uint8_t> &_out)
+{
+  const std::size_t matchCode =
+      _matchLength == 0u ? 0u : _matchLength - kMinMatch;
+  uint8_t token =
+      static_cast<uint8_t>((_literalCount < 15u ? _literalCount : 15u) << 4);
+  token |= static_cast<uint8_t>(matchCode < 15u ? matchCode : 15u);
+  _out.push_back(token);
+  if (_literalCount >= 15u)
+    AppendLength(_literalCount - 15u, _out);
+  _out.insert(_out.end(), _literals, _literals + _literalCount);
+  if (_matchLength == 0u)
+    return;
+
+  _out.push_back(static_cast<uint8_t>(_offset & 0xFFu));
+  _out.push_back(static_cast<uint8_t>(_offset >> 8));
+  if (matchCode >= 15u)
+    AppendLength(matchCode - 15u, _out);
+}
+
+/// \brief Compress a block.
+/// \param[in] _in Bytes to compress.
+/// \param[in] _size Number of bytes, at most kBlockSize.
+/// \param[in,out] _table Hash table, reset by this function.
+/// \param[out] _out Compressed block, replaced.
+void CompressBlock(const uint8_t *_in, std::size_t _size,
+    std::vector<uint32_t> &_table, std::vector<uint8_t> &_out)
+{
+  _out.clear();
+  std::size_t anchor = 0u;
+  if (_size > kMatchLimit)
+  {
+    // Positions are stored plus one, zero means empty
+    std::fill(_table.begin(), _table.end(), 0u);
+    const std::size_t matchStartLimit = _size - kMatchLimit;
+    const std::size_t matchEndLimit = _size - kLastLiterals;
+    std::size_t pos = 0u;
+    while (pos < matchStartLimit)
+    {
+      const uint32_t sequence = Read32(_in + pos);
+      const uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+      const std::size_t candidate = _table[hash];
+      _table[hash] = static_cast<uint32_t>(pos + 1u);
+      if (candidate == 0u || pos - (candidate - 1u) > kMaxOffset ||
+          Read32(_in + candidate - 1u) != sequence)
+      {
+        ++pos;
+        continue;
+      }
+
+      const std::size_t match = candidate - 1u;
+      std::size_t length = kMinMatch;
+      while (pos + length < matchEndLimit &&
+             _in[match + length] == _in[pos + length])
+      {
+        ++length;
+      }
+      AppendSequence(_in + anchor, pos - anchor, pos - match, length, _out);
+      pos += length;
+      anchor = pos;
+    }
+  }
+  AppendSequence(_in + anchor, _size - anchor, 0u, 0u, _out);
+}
+
+/// \brief Hash of the frame descriptor, the second byte of the 32 bit
+/// xxHash of its bytes with a zero seed.
+/// \param[in] _data Descriptor bytes.
+/// \param[in] _size Number of bytes, less than 16.
+/// \return Header checksum.
+uint8_t DescriptorChecksum(const uint8_t *_data, std::size_t _size)
+{
+  constexpr uint32_t kPrime1 = 2654435761u;
+  constexpr uint32_t kPrime2 = 2246822519u;
+  constexpr uint32_t kPrime3 = 3266489917u;
+  constexpr uint32_t kPrime4 = 668265263u;
+  constexpr uint32_t kPrime5 = 374761393u;
+  auto rotl = [](uint32_t _x, int _r)
+  {
+    return (_x << _r) | (_x >> (32 - _r));
+  };
+
+  uint32_t hash = kPrime5 + static_cast<uint32_t>(_size);
+  std::size_t i = 0u;
+  for (; i + 4u <= _size; i += 4u)
+  {
+    hash += ReadLe32(_data + i) * kPrime3;
+    hash = rotl(hash, 17) * kPrime4;
+  }
+  for (; i < _size; ++i)
+  {
+    hash += _data[i] * kPrime5;
+    hash = rotl(hash, 11) * kPrime1;
+  }
+  hash ^= hash >> 15;
+  hash *= kPrime2;
+  hash ^= hash >> 13;
+  hash *= kPrime3;
+  hash ^= hash >> 16;
+  return static_cast<uint8_t>((hash >> 8) & 0xFFu);
+}
+
+/// \brief Read the extra bytes of a literal or match length.
+/// \param[in] _in Block.
+/// \param[in] _size Size of the block.
+/// \param[in,out] _pos Position of the first extra byte.
+/// \param[in,out] _length Length to add to.
+/// \return False if the block ends early.
+bool ReadLength(const uint8_t *_in, std::size_t _size, std::size_t &_pos,
+    std::size_t &_length)
+{
+  while (true)
+  {
+    if (_pos >= _size)
+      return false;
+    const uint8_t byte = _in[_pos++];
+    _length += byte;
+    if (byte != 255u)
+      return true;
+  }
+}
+
+/// \brief Decompress a block.
+/// \param[in] _in Block.
+/// \param[in] _size Size of the block.
+/// \param[out] _out String the bytes are appended to.
+/// \param[in] _start Size of _out before the block, matches don't reach
+/// before it.
+/// \return False if the block is malformed.
+bool DecompressBlock(const uint8_t *_in, std::size_t _size, std::string &_out,
+    std::size_t _start)
+{
+  std::size_t pos = 0u;
+  while (pos < _size)
+  {
+    const uint8_t token = _in[pos++];
+    std::size_t literals = token >> 4;
+    if (literals == 15u && !ReadLength(_in, _size, pos, literals))
+      return false;
+    if (literals > _size - pos)
+      return false;
+    _out.append(reinterpret_cast<const char *>(_in + pos), literals);
+    pos += literals;
+    if (pos == _size)
+      return true;
+
+    if (_size - pos < 2u)
+      return false;
+    const std::size_t offset = _in[pos] | (_in[pos + 1] << 8);
+    pos += 2u;
+    std::size_t length = token & 0x0Fu;
+    if (length == 15u && !ReadLength(_in, _size, pos, length))
+      return false;
+    length += kMinMatch;
+    if (offset == 0u || offset > _out.size() - _start)
+      return false;
+
+    // Matches may overlap their own output
+    std::size_t from = _out.size() - offset;
+    for (std::size_t i = 0u; i < length; ++i)
+      _out.push_back(_out[from + i]);
+  }
+  return true;
+}
+}
+
+//////////////////////////////////////////////////
+void sensors::Lz4CompressFrame(const void *_data, std::size_t _size,
+    std::string &_out)
+{
+  AppendLe32(kFrameMagic, _out);
+
+  // Version 1, independent blocks, no checksums, 4 MiB blocks
+  const uint8_t descriptor[2] = {0x60u, 0x70u};
+  _out.push_back(static_cast<char>(descriptor[0]));
+  _out.push_back(static_cast<char>(descriptor[1]));
+  _out.push_back(static_cast<char>(DescriptorChecksum(descriptor, 2u)));
+
+  const auto *in = static_cast<const uint8_t *>(_data);
+  std::vector<uint32_t> table(std::size_t{1} << kHashBits);
+  std::vector<uint8_t> block;
+  for (std::size_t offset = 0u; offset < _size; offset += kBlockSize)
+  {
+    const std::size_t size =
+        _size - offset < kBlockSize ? _size - offset : kBlockSize;
+    CompressBlock(in + offset, size, table, block);
+    if (block.size() < size)
+    {
+      AppendLe32(static_cast<uint32_t>(block.size()), _out);
+      _out.append(reinterpret_cast<const char *>(block.data()),
+          block.size());
+    }
+    else
+    {
+      AppendLe32(static_cast<uint32_t>(size) | 0x80000000u, _out);
+      _out.append(reinterpret_cast<const char *>(in + offset), size);
+    }
+  }
+  AppendLe32(0u, _out);
+}
+
+//////////////////////////////////////////////////
+bool sensors::Lz4DecompressFrame(const void *_data, std::size_t _size,
+    std::string &_out)
+{
+  const auto *in = static_cast<const uint8_t *>(_data);
+  if (_size < 7u || ReadLe32(in) != kFrameMagic)
+    return false;
+
+  const uint8_t flags = in[4];
+  if ((flags >> 6) != 1u || !(flags & 0x20u))
+    return false;
+  const bool blockChecksum = flags & 0x10u;
+  const bool contentSize = flags & 0x08u;
+  const bool contentChecksum = flags & 0x04u;
+  const bool dictionary = flags & 0x01u;
+  std::size_t pos = 6u + (contentSize ? 8u : 0u) + (dictionary ? 4u : 0u);
+  if (pos >= _size)
+    return false;
+  ++pos;
+
+  while (true)
+  {
+    if (_size - pos < 4u)
+      return false;
+    const uint32_t header = ReadLe32(in + pos);
+    pos += 4u;
+    if (header == 0u)
+      break;
+
+    const std::size_t size = header & 0x7FFFFFFFu;
+    if (size > _size - pos)
+      return false;
+    if (header & 0x80000000u)
+      _out.append(reinterpret_cast<const char *>(in + pos), size);
+    else if (!DecompressBlock(in + pos, size, _out, _out.size()))
+      return false;
+    pos += size + (blockChecksum ? 4u : 0u);
+  }
+  return !contentChecksum || _size - pos >= 4u;
+}
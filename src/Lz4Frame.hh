@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_LZ4FRAME_HH_
+#define GZ_SENSORS_LZ4FRAME_HH_
+
+#include <cstddef>
+#include <string>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Compress bytes to an LZ4 frame, readable by the lz4 tool and
+    /// library. The compressor is a greedy single pass over a hash table of
+    /// the last positions of 4 byte sequences, which favors speed over
+    /// ratio. Blocks that don't shrink are stored uncompressed.
+    /// \param[in] _data Bytes to compress.
+    /// \param[in] _size Number of bytes.
+    /// \param[out] _out String the frame is appended to.
+    GZ_SENSORS_VISIBLE void Lz4CompressFrame(const void *_data,
+        std::size_t _size, std::string &_out);
+
+    /// \brief Decompress an LZ4 frame made of independent blocks, such as
+    /// the frames of Lz4CompressFrame. Checksums aren't verified.
+    /// \param[in] _data The frame.
+    /// \param[in] _size Number of bytes of the frame.
+    /// \param[out] _out String the bytes are appended to.
+    /// \return False if the frame is malformed or uses linked blocks.
+    GZ_SENSORS_VISIBLE bool Lz4DecompressFrame(const void *_data,
+        std::size_t _size, std::string &_out);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "Lz4Frame.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Compress and decompress bytes.
+/// \param[in] _data Bytes to compress.
+/// \param[out] _frame Compressed frame.
+/// \return Decompressed bytes.
+static std::string RoundTrip(const std::string &_data, std::string &_frame)
+{
+  _frame.clear();
+  Lz4CompressFrame(_data.data(), _data.size(), _frame);
+  std::string out;
+  EXPECT_TRUE(Lz4DecompressFrame(_frame.data(), _frame.size(), out));
+  return out;
+}
+
+//////////////////////////////////////////////////
+TEST(Lz4Frame, Header)
+{
+  std::string frame;
+  EXPECT_EQ("", RoundTrip("", frame));
+
+  // Magic, descriptor, its checksum and the end mark
+  const std::string expected("\x04\x22\x4D\x18\x60\x70\x73\0\0\0\0", 11u);
+  EXPECT_EQ(expected, frame);
+}
+
+//////////////////////////////////////////////////
+TEST(Lz4Frame, RoundTrip)
+{
+  std::string frame;
+  for (const std::size_t size : {1u, 5u, 12u, 13u, 100u, 70000u})
+  {
+    std::string data;
+    for (std::size_t i = 0u; i < size; ++i)
+      data.push_back(static_cast<char>((i / 7u) % 13u));
+    EXPECT_EQ(data, RoundTrip(data, frame)) << size;
+  }
+
+  // Repeated data compresses, including matches longer than 15 bytes and
+  // matches overlapping their output
+  std::string zeros(100000u, '\0');
+  EXPECT_EQ(zeros, RoundTrip(zeros, frame));
+  EXPECT_LT(frame.size(), 1000u);
+
+  // Blocks larger than 4 MiB are split
+  std::string large;
+  std::mt19937 rng(3);
+  for (std::size_t i = 0u; i < 5u * 1024u * 1024u; ++i)
+    large.push_back("sensor data "[rng() % 12u]);
+  EXPECT_EQ(large, RoundTrip(large, frame));
+  EXPECT_LT(frame.size(), large.size());
+}
+
+//////////////////////////////////////////////////
+TEST(Lz4Frame, Incompressible)
+{
+  std::string data;
+  std::mt19937 rng(7);
+  for (int i = 0; i < 1000; ++i)
+    data.push_back(static_cast<char>(rng()));
+
+  // The block is stored as is
+  std::string frame;
+  EXPECT_EQ(data, RoundTrip(data, frame));
+  EXPECT_EQ(data.size() + 15u, frame.size());
+}
+
+//////////////////////////////////////////////////
+TEST(Lz4Frame, Malformed)
+{
+  std::string frame;
+  Lz4CompressFrame("abcdabcdabcdabcdabcd", 20u, frame);
+
+  std::string out;
+  EXPECT_FALSE(Lz4DecompressFrame(frame.data(), 4u, out));
+  EXPECT_FALSE(Lz4DecompressFrame(frame.data(), frame.size() - 4u, out));
+
+  std::string badMagic = frame;
+  badMagic[0] = 0;
+  EXPECT_FALSE(Lz4DecompressFrame(badMagic.data(), badMagic.size(), out));
+
+  // Linked blocks aren't supported
+  std::string linked = frame;
+  linked[4] = 0x40;
+  EXPECT_FALSE(Lz4DecompressFrame(linked.data(), linked.size(), out));
+}
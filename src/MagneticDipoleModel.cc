@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+#include <gz/common/Console.hh>
+
+#include "gz/sensors/MagneticDipoleModel.hh"
+
+using namespace gz;
+using namespace sensors;
+
+// Dipole coefficients of the IGRF-13 main field at its 2020 epoch and
+// their secular variation, in nanoteslas and nanoteslas per year:
+// https://www.ngdc.noaa.gov/IAGA/vmod/igrf.html
+static constexpr double kEpoch = 2020.0;
+static constexpr double kG10 = -29404.8;
+static constexpr double kG11 = -1450.9;
+static constexpr double kH11 = 4652.5;
+static constexpr double kG10PerYear = 5.7;
+static constexpr double kG11PerYear = 7.4;
+static constexpr double kH11PerYear = -25.9;
+static constexpr double kReferenceRadiusMeters = 6371200.0;
+static constexpr double kTeslasPerNanotesla = 1e-9;
+
+/// \brief Hash of a region index.
+struct CellHash
+{
+  /// \brief Hash a region index.
+  /// \param[in] _cell Region index.
+  /// \return Hash.
+  std::size_t operator()(const MagneticDipoleModel::Cell &_cell) const
+  {
+    std::size_t hash = std::hash<int64_t>()(_cell[0]);
+    hash = hash * 31u + std::hash<int64_t>()(_cell[1]);
+    return hash * 31u + std::hash<int64_t>()(_cell[2]);
+  }
+};
+
+/// \brief Private data for MagneticDipoleModel
+class gz::sensors::MagneticDipoleModelPrivate
+{
+  /// \brief Spherical coordinates of the world.
+  public: math::SphericalCoordinates origin;
+
+  /// \brief Date of the field.
+  public: double decimalYear = kEpoch;
+
+  /// \brief Size of the regions, in meters.
+  public: double resolution = 1000.0;
+
+  /// \brief Protects fields.
+  public: mutable std::mutex mutex;
+
+  /// \brief Field of the regions evaluated so far, in the world frame.
+  public: mutable std::unordered_map<MagneticDipoleModel::Cell,
+      math::Vector3d, CellHash> fields;
+};
+
+//////////////////////////////////////////////////
+MagneticDipoleModel::MagneticDipoleModel(
+    const math::SphericalCoordinates &_origin, double _decimalYear,
+    double _resolution)
+  : dataPtr(new MagneticDipoleModelPrivate())
+{
+  if (!(_resolution > 0.0))
+  {
+    gzwarn << "Magnetic field model resolution must be positive, using "
+           << "1000 meters instead of [" << _resolution << "]."
+           << std::endl;
+    _resolution = 1000.0;
+  }
+  this->dataPtr->origin = _origin;
+  this->dataPtr->decimalYear = _decimalYear;
+  this->dataPtr->resolution = _resolution;
+}
+
+//////////////////////////////////////////////////
+MagneticDipoleModel::~MagneticDipoleModel() = default;
+
+//////////////////////////////////////////////////
+const math::SphericalCoordinates &MagneticDipoleModel::Origin() const
+{
+  return this->dataPtr->origin;
+}
+
+//////////////////////////////////////////////////
+double MagneticDipoleModel::DecimalYear() const
+{
+  return this->dataPtr->decimalYear;
+}
+
+//////////////////////////////////////////////////
+double MagneticDipoleModel::Resolution() const
+{
+  return this->dataPtr->resolution;
+}
+
+//////////////////////////////////////////////////
+MagneticDipoleModel::Cell MagneticDipoleModel::CellOf(
+    const math::Vector3d &_pos) const
+{
+  const double resolution = this->dataPtr->resolution;
+  return {static_cast<int64_t>(std::floor(_pos.X() / resolution)),
+          static_cast<int64_t>(std::floor(_pos.Y() / resolution)),
+          static_cast<int64_t>(std::floor(_pos.Z() / resolution))};
+}
+
+//////////////////////////////////////////////////
+math::Vector3d MagneticDipoleModel::Field(const Cell &_cell) const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto it = this->dataPtr->fields.find(_cell);
+  if (it != this->dataPtr->fields.end())
+    return it->second;
+
+  const double resolution = this->dataPtr->resolution;
+  const math::Vector3d center(
+      (static_cast<double>(_cell[0]) + 0.5) * resolution,
+      (static_cast<double>(_cell[1]) + 0.5) * resolution,
+      (static_cast<double>(_cell[2]) + 0.5) * resolution);
+  const math::Vector3d spherical =
+      this->dataPtr->origin.SphericalFromLocalPosition(center);
+  const math::Vector3d global = Evaluate(
+      math::Angle(GZ_DTOR(spherical.X())),
+      math::Angle(GZ_DTOR(spherical.Y())), spherical.Z(),
+      this->dataPtr->decimalYear);
+  const math::Vector3d field =
+      this->dataPtr->origin.LocalFromGlobalVelocity(global);
+  this->dataPtr->fields.emplace(_cell, field);
+  return field;
+}
+
+//////////////////////////////////////////////////
+math::Vector3d MagneticDipoleModel::Field(const math::Vector3d &_pos) const
+{
+  return this->Field(this->CellOf(_pos));
+}
+
+//////////////////////////////////////////////////
+math::Vector3d MagneticDipoleModel::Evaluate(const math::Angle &_latitude,
+    const math::Angle &_longitude, double _altitude, double _decimalYear)
+{
+  const double years = _decimalYear - kEpoch;
+  const double g10 = kG10 + kG10PerYear * years;
+  const double g11 = kG11 + kG11PerYear * years;
+  const double h11 = kH11 + kH11PerYear * years;
+
+  // Field of the degree 1 potential, with the colatitude theta and the
+  // longitude phi, in the north, east and down directions
+  const double sinTheta = std::cos(_latitude.Radian());
+  const double cosTheta = std::sin(_latitude.Radian());
+  const double sinPhi = std::sin(_longitude.Radian());
+  const double cosPhi = std::cos(_longitude.Radian());
+  const double ratio =
+      kReferenceRadiusMeters / (kReferenceRadiusMeters + _altitude);
+  const double k = ratio * ratio * ratio * kTeslasPerNanotesla;
+  const double equatorial = g11 * cosPhi + h11 * sinPhi;
+
+  const double north = k * (-g10 * sinTheta + equatorial * cosTheta);
+  const double east = k * (g11 * sinPhi - h11 * cosPhi);
+  const double down = -2.0 * k * (g10 * cosTheta + equatorial * sinTheta);
+  return {east, north, -down};
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <gz/math/Angle.hh>
+
+#include "gz/sensors/MagneticDipoleModel.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(MagneticDipoleModel_TEST, Evaluate)
+{
+  // On the equator at the prime meridian, the dipole points north with a
+  // westward declination and a small upward inclination
+  math::Vector3d field = MagneticDipoleModel::Evaluate(
+      math::Angle(0.0), math::Angle(0.0), 0.0, 2020.0);
+  EXPECT_NEAR(-4652.5e-9, field.X(), 1e-12);
+  EXPECT_NEAR(29404.8e-9, field.Y(), 1e-12);
+  EXPECT_NEAR(-2901.8e-9, field.Z(), 1e-12);
+
+  // Near the north pole it points down, twice as strong
+  field = MagneticDipoleModel::Evaluate(
+      math::Angle(GZ_DTOR(90.0)), math::Angle(0.0), 0.0, 2020.0);
+  EXPECT_NEAR(-58809.6e-9, field.Z(), 1e-12);
+
+  // It decreases with the cube of the distance to the center
+  const math::Vector3d high = MagneticDipoleModel::Evaluate(
+      math::Angle(GZ_DTOR(45.0)), math::Angle(GZ_DTOR(10.0)), 6371200.0,
+      2020.0);
+  const math::Vector3d low = MagneticDipoleModel::Evaluate(
+      math::Angle(GZ_DTOR(45.0)), math::Angle(GZ_DTOR(10.0)), 0.0,
+      2020.0);
+  EXPECT_NEAR(low.Length() / 8.0, high.Length(), 1e-15);
+
+  // Secular variation
+  field = MagneticDipoleModel::Evaluate(
+      math::Angle(0.0), math::Angle(0.0), 0.0, 2025.0);
+  EXPECT_NEAR((29404.8 - 5 * 5.7) * 1e-9, field.Y(), 1e-12);
+}
+
+/////////////////////////////////////////////////
+TEST(MagneticDipoleModel_TEST, Regions)
+{
+  const math::SphericalCoordinates origin(
+      math::SphericalCoordinates::EARTH_WGS84, GZ_DTOR(-33.9),
+      GZ_DTOR(18.4), 0.0, 0.0);
+  MagneticDipoleModel model(origin, 2024.0, 100.0);
+  EXPECT_DOUBLE_EQ(2024.0, model.DecimalYear());
+  EXPECT_DOUBLE_EQ(100.0, model.Resolution());
+  EXPECT_NEAR(GZ_DTOR(-33.9), model.Origin().LatitudeReference().Radian(),
+      1e-12);
+
+  const MagneticDipoleModel::Cell cell =
+      model.CellOf(math::Vector3d(150.0, -50.0, 0.0));
+  EXPECT_EQ(1, cell[0]);
+  EXPECT_EQ(-1, cell[1]);
+  EXPECT_EQ(0, cell[2]);
+
+  // Positions in the same region share its field, evaluated at its
+  // center. Fields are compared in microteslas, as vectors are equal
+  // within 1e-6.
+  const math::Vector3d field = model.Field(math::Vector3d(101, -1, 1));
+  EXPECT_EQ(field * 1e6, model.Field(math::Vector3d(199, -99, 99)) * 1e6);
+  EXPECT_EQ(field * 1e6, model.Field(cell) * 1e6);
+  const math::Vector3d spherical =
+      origin.SphericalFromLocalPosition(math::Vector3d(150, -50, 50));
+  const math::Vector3d expected = origin.LocalFromGlobalVelocity(
+      MagneticDipoleModel::Evaluate(math::Angle(GZ_DTOR(spherical.X())),
+          math::Angle(GZ_DTOR(spherical.Y())), spherical.Z(), 2024.0));
+  EXPECT_EQ(expected * 1e6, field * 1e6);
+
+  // Other regions are evaluated separately
+  EXPECT_NE(field * 1e6, model.Field(math::Vector3d(5e4, 0, 0)) * 1e6);
+
+  // Non positive resolutions are replaced
+  MagneticDipoleModel invalid(origin, 2024.0, -1.0);
+  EXPECT_DOUBLE_EQ(1000.0, invalid.Resolution());
+}
@@ -24,6 +24,11 @@
   #pragma warning(pop)
 #endif
 
+#include <memory>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
 #include <gz/common/Profiler.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
@@ -33,6 +38,7 @@
 #include "gz/sensors/Noise.hh"
 #include "gz/sensors/SensorFactory.hh"
 #include "gz/sensors/SensorTypes.hh"
+#include "NoisePipeline.hh"
 
 using namespace gz;
 using namespace sensors;
@@ -40,12 +46,25 @@ using namespace sensors;
 /// \brief Private data for MagnetometerSensor
 class gz::sensors::MagnetometerSensorPrivate
 {
+  /// \brief Look up the world field in the field model, if any, when the
+  /// sensor moved to another region of it.
+  public: void UpdateWorldField();
+
+  /// \brief Apply noise to the local field and publish it.
+  /// \param[in] _sensor Sensor that owns this data.
+  /// \param[in] _now The current time
+  public: void GenerateData(MagnetometerSensor &_sensor,
+              const std::chrono::steady_clock::duration &_now);
+
   /// \brief node to create publisher
   public: transport::Node node;
 
   /// \brief publisher to publish magnetometer messages.
   public: transport::Node::Publisher pub;
 
+  /// \brief Message reused by every update.
+  public: msgs::Magnetometer msg;
+
   /// \brief true if Load() has been called and was successful
   public: bool initialized = false;
 
@@ -53,17 +72,62 @@ class gz::sensors::MagnetometerSensorPrivate
   /// field and the sensor's current pose.
   public: math::Vector3d localField;
 
-  /// \brief Store world magnetic field vector. We assume it is uniform
-  /// everywhere in the world, and that it doesn't change during the simulation.
+  /// \brief Store world magnetic field vector. Without a field model, we
+  /// assume it is uniform everywhere in the world, and that it doesn't
+  /// change during the simulation.
   public: math::Vector3d worldField;
 
+  /// \brief Model the world field is looked up in, if any.
+  public: std::shared_ptr<const MagneticDipoleModel> fieldModel;
+
+  /// \brief Region of the field model the world field was looked up for.
+  public: MagneticDipoleModel::Cell fieldCell{};
+
+  /// \brief True if worldField holds the field of fieldCell.
+  public: bool fieldCellValid = false;
+
   /// \brief World pose of the magnetometer
   public: math::Pose3d worldPose;
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief Noise of the axes, resolved when the sensor loads.
+  public: NoisePipeline<3> noisePipeline;
 };
 
+//////////////////////////////////////////////////
+void MagnetometerSensorPrivate::UpdateWorldField()
+{
+  if (!this->fieldModel)
+    return;
+
+  const MagneticDipoleModel::Cell cell =
+      this->fieldModel->CellOf(this->worldPose.Pos());
+  if (this->fieldCellValid && cell == this->fieldCell)
+    return;
+
+  this->worldField = this->fieldModel->Field(cell);
+  this->fieldCell = cell;
+  this->fieldCellValid = true;
+}
+
+//////////////////////////////////////////////////
+void MagnetometerSensorPrivate::GenerateData(MagnetometerSensor &_sensor,
+    const std::chrono::steady_clock::duration &_now)
+{
+  _sensor.FillHeader(this->msg.mutable_header(), _now);
+
+  // Apply magnetometer noise after converting to body frame
+  this->noisePipeline.Apply({&this->localField.X(), &this->localField.Y(),
+      &this->localField.Z()});
+
+  msgs::Set(this->msg.mutable_field_tesla(), this->localField);
+
+  // publish
+  _sensor.Publish(this->pub, this->msg);
+}
+
 //////////////////////////////////////////////////
 MagnetometerSensor::MagnetometerSensor()
   : dataPtr(new MagnetometerSensorPrivate())
@@ -104,11 +168,8 @@ bool MagnetometerSensor::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/magnetometer");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<msgs::Magnetometer>(
-      this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<msgs::Magnetometer>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic[" << this->Topic() << "].\n";
     return false;
@@ -136,6 +197,12 @@ bool MagnetometerSensor::Load(const sdf::Sensor &_sdf)
       NoiseFactory::NewNoiseModel(_sdf.MagnetometerSensor()->ZNoise());
   }
 
+  this->RegisterNoise(this->dataPtr->noises);
+  this->dataPtr->noisePipeline.Load({
+      this->dataPtr->noises[MAGNETOMETER_X_NOISE_TESLA],
+      this->dataPtr->noises[MAGNETOMETER_Y_NOISE_TESLA],
+      this->dataPtr->noises[MAGNETOMETER_Z_NOISE_TESLA]});
+
   this->dataPtr->initialized = true;
   return true;
 }
@@ -160,48 +227,47 @@ bool MagnetometerSensor::Update(
   }
 
   // compute magnetic field in body frame
+  this->dataPtr->UpdateWorldField();
   this->dataPtr->localField =
       this->dataPtr->worldPose.Rot().Inverse().RotateVector(
       this->dataPtr->worldField);
 
-  msgs::Magnetometer msg;
-  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-  auto frame = msg.mutable_header()->add_data();
-  frame->set_key("frame_id");
-  frame->add_value(this->FrameId());
+  this->dataPtr->GenerateData(*this, _now);
+  return true;
+}
 
-  // Apply magnetometer noise after converting to body frame
-  if (this->dataPtr->noises.find(MAGNETOMETER_X_NOISE_TESLA) !=
-      this->dataPtr->noises.end())
+//////////////////////////////////////////////////
+void MagnetometerSensor::UpdateBatch(const std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("MagnetometerSensor::UpdateBatch");
+  // Subclasses may override Update, in which case they must be updated one
+  // by one.
+  if (typeid(*this) != typeid(MagnetometerSensor))
   {
-    this->dataPtr->localField.X(
-        this->dataPtr->noises[MAGNETOMETER_X_NOISE_TESLA]->Apply(
-          this->dataPtr->localField.X()));
+    Sensor::UpdateBatch(_sensors, _now);
+    return;
   }
 
-  if (this->dataPtr->noises.find(MAGNETOMETER_Y_NOISE_TESLA) !=
-      this->dataPtr->noises.end())
+  // Rotate the fields of all sensors in one pass, then apply noise and
+  // publish.
+  for (Sensor *sensor : _sensors)
   {
-    this->dataPtr->localField.Y(
-        this->dataPtr->noises[MAGNETOMETER_Y_NOISE_TESLA]->Apply(
-          this->dataPtr->localField.Y()));
+    auto &d = *static_cast<MagnetometerSensor *>(sensor)->dataPtr;
+    d.UpdateWorldField();
+    d.localField = d.worldPose.Rot().Inverse().RotateVector(d.worldField);
   }
 
-  if (this->dataPtr->noises.find(MAGNETOMETER_Z_NOISE_TESLA) !=
-      this->dataPtr->noises.end())
+  for (Sensor *sensor : _sensors)
   {
-    this->dataPtr->localField.Z(
-        this->dataPtr->noises[MAGNETOMETER_Z_NOISE_TESLA]->Apply(
-          this->dataPtr->localField.Z()));
+    auto magnetometer = static_cast<MagnetometerSensor *>(sensor);
+    if (!magnetometer->dataPtr->initialized)
+    {
+      gzerr << "Not initialized, update ignored.\n";
+      continue;
+    }
+    magnetometer->dataPtr->GenerateData(*magnetometer, _now);
   }
-
-  msgs::Set(msg.mutable_field_tesla(), this->dataPtr->localField);
-
-  // publish
-  this->AddSequence(msg.mutable_header());
-  this->dataPtr->pub.Publish(msg);
-
-  return true;
 }
 
 //////////////////////////////////////////////////
@@ -228,6 +294,21 @@ math::Vector3d MagnetometerSensor::WorldMagneticField() const
   return this->dataPtr->worldField;
 }
 
+//////////////////////////////////////////////////
+void MagnetometerSensor::SetFieldModel(
+    std::shared_ptr<const MagneticDipoleModel> _model)
+{
+  this->dataPtr->fieldModel = std::move(_model);
+  this->dataPtr->fieldCellValid = false;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const MagneticDipoleModel>
+MagnetometerSensor::FieldModel() const
+{
+  return this->dataPtr->fieldModel;
+}
+
 //////////////////////////////////////////////////
 math::Vector3d MagnetometerSensor::MagneticField() const
 {
@@ -16,73 +16,2306 @@
 */
 
 #include "gz/sensors/Manager.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <typeinfo>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <gz/common/Profiler.hh>
 #include <gz/common/SystemPaths.hh>
 #include <gz/common/Console.hh>
 
 #include "gz/sensors/config.hh"
+#include "gz/sensors/SensorBundle.hh"
 #include "gz/sensors/SensorFactory.hh"
+#include "gz/sensors/SensorRecorder.hh"
+#include "gz/sensors/SensorReplay.hh"
+#include "ThreadAffinity.hh"
+#include "TraceRecorder.hh"
 
 using namespace gz::sensors;
 
+namespace
+{
+/// \brief An entry in the update schedule of the manager.
+struct ScheduleEntry
+{
+  /// \brief Time at which the sensor is due.
+  std::chrono::steady_clock::duration time;
+
+  /// \brief Id of the sensor.
+  SensorId id;
+
+  /// \brief Version of the sensor schedule when the entry was added. Entries
+  /// with an outdated version are discarded when they reach the top.
+  uint64_t version;
+
+  /// \brief Order entries by time, so that std::priority_queue becomes a
+  /// min-heap.
+  bool operator>(const ScheduleEntry &_other) const
+  {
+    return this->time > _other.time;
+  }
+};
+
+/// \brief Storage slot of a sensor owned by the manager.
+struct SensorSlot
+{
+  /// \brief The sensor.
+  std::unique_ptr<gz::sensors::Sensor> sensor;
+
+  /// \brief Current version of the sensor's schedule entry.
+  uint64_t scheduleVersion{0};
+
+  /// \brief False if the sensor belongs to another shard.
+  bool local{true};
+};
+
+/// \brief Rendering sensors handed to a render queue. Shared with the
+/// queued tasks, which may outlive the manager.
+struct RenderHandoff
+{
+  /// \brief Protects the members below.
+  std::mutex mutex;
+
+  /// \brief Notifies that a task finished updating its sensors.
+  std::condition_variable idleCv;
+
+  /// \brief The manager, null once it's destroyed.
+  gz::sensors::ManagerPrivate *manager{nullptr};
+
+  /// \brief Sensors queued and not updated yet. Removed sensors are
+  /// erased, so their tasks skip them.
+  std::unordered_set<SensorId> inFlight;
+
+  /// \brief True while a task updates its sensors.
+  bool running{false};
+
+  /// \brief Thread that ran the last task.
+  std::thread::id renderThread;
+
+  /// \brief Queue triggered sensors are handed to, null unless immediate
+  /// triggers are enabled.
+  std::shared_ptr<gz::sensors::RenderTaskQueue> triggerQueue;
+
+  /// \brief Render batch callback of the triggered sensors.
+  gz::sensors::Manager::RenderBatchCallback triggerBatchCallback;
+
+  /// \brief Time of the last RunOnce, triggered sensors are updated for it.
+  std::chrono::steady_clock::duration time{0};
+
+  /// \brief Triggered sensors waiting for the queued trigger task.
+  std::vector<std::pair<SensorId, gz::sensors::Sensor *>> triggered;
+};
+}
+
 class gz::sensors::ManagerPrivate
 {
-  /// \brief Loaded sensors.
-  public: std::map<SensorId, std::unique_ptr<Sensor>> sensors;
+  /// \brief Time at which a sensor should be scheduled. Sensors with a zero
+  /// update rate are updated every cycle, so they are always due. Inactive
+  /// sensors, and sensors waiting for a trigger, are only updated when
+  /// forced, so they are never due.
+  /// \param[in] _sensor Sensor to schedule.
+  /// \return Schedule time.
+  public: static std::chrono::steady_clock::duration ScheduleTime(
+              const Sensor &_sensor);
+
+  /// \brief Check whether a sensor belongs to the shard of the manager.
+  /// \param[in] _sensor Sensor to check.
+  /// \return True if the sensor is run by this manager.
+  public: bool IsLocal(const Sensor &_sensor) const;
+
+  /// \brief Add or re-key a sensor in the schedule.
+  /// \param[in] _slot Slot of the sensor to schedule.
+  public: void Schedule(SensorSlot &_slot);
+
+  /// \brief Re-key all sensors whose schedule was changed outside of
+  /// RunOnce.
+  public: void ApplyScheduleChanges();
+
+  /// \brief Rebuild the schedule from scratch, dropping stale entries.
+  public: void RebuildSchedule();
+
+  /// \brief Check whether a schedule entry is up to date.
+  /// \param[in] _entry Entry to check.
+  /// \return True if the entry is the current one for its sensor.
+  public: bool IsCurrent(const ScheduleEntry &_entry) const;
+
+  /// \brief Pop stale entries until the top of the schedule is current.
+  public: void PruneSchedule();
+
+  /// \brief Update a list of sensors, in parallel if there are workers.
+  /// \param[in] _sensors Sensors to update.
+  /// \param[in] _time Current time.
+  /// \param[in] _force Force flag passed to Sensor::Update.
+  public: void UpdateSensors(const std::vector<Sensor *> &_sensors,
+              const std::chrono::steady_clock::duration &_time, bool _force);
+
+  /// \brief Remove the rendering sensors from a list of due sensors and
+  /// queue them on the render queue. Sensors still waiting for the render
+  /// thread are only removed.
+  /// \param[in,out] _sensors Due sensors.
+  /// \param[in] _time Current time.
+  /// \param[in] _force Force flag passed to Sensor::Update.
+  public: void QueueRenderingSensors(std::vector<Sensor *> &_sensors,
+              const std::chrono::steady_clock::duration &_time, bool _force);
+
+  /// \brief Queue a triggered sensor on the render queue, together with
+  /// the other sensors triggered until the render thread gets to it.
+  /// \param[in] _handoff State shared with the manager.
+  /// \param[in] _id Id of the triggered sensor.
+  /// \param[in] _sensor The triggered sensor.
+  public: static void QueueTriggered(
+              const std::shared_ptr<RenderHandoff> &_handoff, SensorId _id,
+              Sensor *_sensor);
+
+  /// \brief Share the render queue and batch callback with the trigger
+  /// callbacks, if immediate triggers are enabled.
+  public: void UpdateTriggerQueue();
+
+  /// \brief Update queued rendering sensors, run on the render thread.
+  /// \param[in] _handoff State shared with the manager.
+  /// \param[in] _sensors Ids and pointers of the queued sensors.
+  /// \param[in] _time Time passed to RunOnce.
+  /// \param[in] _force Force flag passed to Sensor::Update.
+  /// \param[in] _callback Render batch callback, may be empty.
+  public: static void RenderQueued(RenderHandoff &_handoff,
+              const std::vector<std::pair<SensorId, Sensor *>> &_sensors,
+              const std::chrono::steady_clock::duration &_time, bool _force,
+              const Manager::RenderBatchCallback &_callback);
+
+  /// \brief Try to lock stepMutex, which fails while a step is running on
+  /// another thread, or on the calling thread.
+  /// \return The lock, which doesn't own stepMutex if changes to the
+  /// sensors must be staged.
+  public: std::unique_lock<std::mutex> TryLockStep();
+
+  /// \brief Add and remove the staged sensors. stepMutex must be locked.
+  public: void ApplyStaged();
+
+  /// \brief Add a sensor to the slots and the schedule. stepMutex must be
+  /// locked.
+  /// \param[in] _sensor Sensor to add.
+  public: void AddNow(std::unique_ptr<Sensor> _sensor);
+
+  /// \brief Remove a sensor and destroy it. stepMutex must be locked.
+  /// \param[in] _id Id of the sensor.
+  /// \return True if the sensor was found.
+  public: bool RemoveNow(SensorId _id);
+
+  /// \brief Lower or raise the effective rates of the sensors to fit
+  /// updateBudget, once per simulated second.
+  /// \param[in] _time Current time.
+  public: void AdaptRates(const std::chrono::steady_clock::duration &_time);
+
+  /// \brief Give the sensors that haven't been staggered yet a phase
+  /// offset within the period of their update rate, away from the other
+  /// sensors of the same rate.
+  /// \param[in] _time Current time.
+  public: void StaggerPhases(const std::chrono::steady_clock::duration &_time);
+
+  /// \brief Split sensors into groups of sensors of the same type.
+  /// \param[in] _sensors Sensors to split.
+  public: void BuildGroups(const std::vector<Sensor *> &_sensors);
+
+  /// \brief Order sensors by priority class, then by id. Rendering sensors
+  /// of the control class come after the other control sensors.
+  /// \param[in,out] _sensors Sensors to sort.
+  public: static void SortByPriority(std::vector<Sensor *> &_sensors);
+
+  /// \brief Start the worker threads.
+  /// \param[in] _count Number of threads to start.
+  public: void StartWorkers(unsigned int _count);
+
+  /// \brief Stop and join all worker threads.
+  public: void StopWorkers();
+
+  /// \brief Main loop of a worker thread.
+  /// \param[in] _generation Batch generation at the time the worker was
+  /// started.
+  /// \param[in] _index Index of the worker.
+  public: void WorkerLoop(uint64_t _generation, unsigned int _index);
+
+  /// \brief Update the sensors in parallelSensors, or the groups in groups,
+  /// until none is left. Called by the workers and by the thread that runs
+  /// RunOnce.
+  public: void UpdateParallelSensors();
+
+  /// \brief Number of CPU sets sensors are placed on, zero if the workers
+  /// aren't pinned.
+  /// \return Number of CPU sets that have at least one worker.
+  public: std::size_t PlacementCount() const;
+
+  /// \brief Split parallelSensors into placedSensors, placing sensors that
+  /// weren't placed yet on the CPU set with the fewest sensors.
+  public: void PlaceSensors();
+
+  /// \brief Update the sensors placed on a CPU set until none is left.
+  /// Called by the workers pinned to that set.
+  /// \param[in] _set Index of the CPU set.
+  public: void UpdatePlacedSensors(std::size_t _set);
+
+  /// \brief Find the slot of a sensor.
+  /// \param[in] _id Id of the sensor.
+  /// \return Pointer to the slot, nullptr if the sensor isn't loaded.
+  public: SensorSlot *Slot(SensorId _id);
+
+  /// \brief Find the slot of a sensor.
+  /// \param[in] _id Id of the sensor.
+  /// \return Pointer to the slot, nullptr if the sensor isn't loaded.
+  public: const SensorSlot *Slot(SensorId _id) const;
+
+  /// \brief Loaded sensors, stored contiguously so that they can be
+  /// iterated without chasing tree nodes. The order of the slots is not
+  /// stable, since removing a sensor moves the last slot into its place.
+  public: std::vector<SensorSlot> sensors;
+
+  /// \brief Index into sensors of each loaded sensor.
+  public: std::unordered_map<SensorId, std::size_t> sensorIndices;
+
+  /// \brief Held by RunOnce for the whole step, and by AddSensor and
+  /// Remove while they change the sensors outside of a step.
+  public: std::mutex stepMutex;
+
+  /// \brief Thread running RunOnce, so that changes made from the step,
+  /// such as from sensor callbacks, are staged.
+  public: std::atomic<std::thread::id> stepThread;
+
+  /// \brief Sets stepThread for the lifetime of a step.
+  public: class StepThread
+  {
+    /// \brief Constructor
+    /// \param[in] _manager The manager running the step.
+    public: explicit StepThread(ManagerPrivate &_manager)
+      : manager(_manager)
+    {
+      this->manager.stepThread = std::this_thread::get_id();
+    }
+
+    /// \brief Destructor
+    public: ~StepThread()
+    {
+      this->manager.stepThread = std::thread::id();
+    }
+
+    /// \brief The manager running the step.
+    public: ManagerPrivate &manager;
+  };
+
+  /// \brief Held while sensors and sensorIndices change, and by lookups
+  /// that may run concurrently with RunOnce. RunOnce reads them without
+  /// it, as they only change between steps.
+  public: mutable std::shared_mutex sensorsMutex;
+
+  /// \brief Protects the staged changes.
+  public: mutable std::mutex stagingMutex;
+
+  /// \brief Sensors added during a step, added by the next one.
+  public: std::vector<std::unique_ptr<Sensor>> stagedAdds;
+
+  /// \brief Sensors removed during a step, removed by the next one.
+  public: std::vector<SensorId> stagedRemoves;
+
+  /// \brief True if there are staged changes.
+  public: std::atomic<bool> hasStaged{false};
+
+  /// \brief Sensors ordered by the time they are due.
+  public: std::priority_queue<ScheduleEntry, std::vector<ScheduleEntry>,
+              std::greater<ScheduleEntry>> schedule;
+
+  /// \brief Sensors whose schedule changed outside of RunOnce.
+  public: std::vector<SensorId> changedSchedules;
+
+  /// \brief Protects changedSchedules, which may be written from transport
+  /// or worker threads.
+  public: std::mutex changedSchedulesMutex;
+
+  /// \brief Sensors that are due in the current RunOnce.
+  public: std::vector<Sensor *> dueSensors;
+
+  /// \brief Due sensors, other than control sensors, when some control
+  /// sensors are due.
+  public: std::vector<Sensor *> otherSensors;
+
+  /// \brief Sensors that are due in the current RunOnce and must be updated
+  /// on the calling thread.
+  public: std::vector<Sensor *> renderingSensors;
+
+  /// \brief Due sensors whose type has a batch update, used by
+  /// UpdateBatchSensors.
+  public: std::vector<Sensor *> batchSensors;
+
+  /// \brief Due sensors left by UpdateBatchSensors.
+  public: std::vector<Sensor *> unbatchedSensors;
+
+  /// \brief True to update sensors of the same type together.
+  public: bool groupedUpdate{false};
+
+  /// \brief Renders the due rendering sensors together, may be empty.
+  public: Manager::RenderBatchCallback renderBatchCallback;
+
+  /// \brief Queue the due rendering sensors are handed to, may be null.
+  public: std::shared_ptr<RenderTaskQueue> renderQueue;
+
+  /// \brief State shared with the tasks on renderQueue.
+  public: std::shared_ptr<RenderHandoff> renderHandoff{
+              std::make_shared<RenderHandoff>()};
+
+  /// \brief True to render triggered sensors as soon as they're triggered.
+  public: bool immediateTrigger{false};
+
+  /// \brief Seed of the noise models, valid if hasNoiseSeed is true.
+  public: uint64_t noiseSeed{0u};
+
+  /// \brief True if SetNoiseSeed() has been called.
+  public: bool hasNoiseSeed{false};
+
+  /// \brief True if created sensors defer their advertisements.
+  public: bool advertiseDeferred{false};
+
+  /// \brief Shard run by the manager.
+  public: unsigned int shardIndex{0u};
+
+  /// \brief Number of shards.
+  public: unsigned int shardCount{1u};
+
+  /// \brief True to spread sensors of the same rate over their period.
+  public: bool phaseStagger{false};
+
+  /// \brief True if sensors were added or unpinned since they were last
+  /// staggered.
+  public: bool staggerPending{false};
+
+  /// \brief Sensors that were given a phase offset.
+  public: std::unordered_set<SensorId> staggered;
+
+  /// \brief Sensors that keep their schedule when staggering.
+  public: std::unordered_set<SensorId> phaseAligned;
+
+  /// \brief Wall-clock seconds of updates per simulated second, 0 if
+  /// rates aren't adapted.
+  public: double updateBudget{0.0};
+
+  /// \brief Wall-clock seconds a step may take before the trace is
+  /// dumped, 0 if it isn't.
+  public: double traceOverrunBudget{0.0};
+
+  /// \brief File the trace is dumped to on overruns.
+  public: std::string traceOverrunPath;
+
+  /// \brief Wall-clock time of the last overrun dump.
+  public: std::chrono::steady_clock::time_point lastTraceDump;
+
+  /// \brief Update a sensor, measuring its cost if the step budget is set.
+  /// \param[in] _sensor Sensor to update.
+  /// \param[in] _time Time to update the sensor for.
+  /// \param[in] _force True to force the update.
+  public: void UpdateSensor(Sensor &_sensor,
+              const std::chrono::steady_clock::duration &_time, bool _force);
+
+  /// \brief Update a group of sensors, measuring its cost if the step
+  /// budget is set.
+  /// \param[in] _group Sensors of the group.
+  /// \param[in] _time Time to update the sensors for.
+  public: void UpdateGroup(const std::vector<Sensor *> &_group,
+              const std::chrono::steady_clock::duration &_time);
+
+  /// \brief Update the sensors whose type has a batch update together,
+  /// one group per type, on this thread.
+  /// \param[in] _sensors Due sensors.
+  /// \param[in] _time Time to update the sensors for.
+  /// \return The other sensors, _sensors itself if none has a batch
+  /// update.
+  /// \sa Sensor::HasBatchUpdate
+  public: const std::vector<Sensor *> &UpdateBatchSensors(
+              const std::vector<Sensor *> &_sensors,
+              const std::chrono::steady_clock::duration &_time);
+
+  /// \brief Count a step that overran the step budget, and report it if
+  /// the last report is a second old.
+  /// \param[in] _time Time the step updated the sensors for.
+  /// \param[in] _duration Wall-clock duration of the step.
+  public: void StepOverrun(const std::chrono::steady_clock::duration &_time,
+              const std::chrono::steady_clock::duration &_duration);
+
+  /// \brief Wall-clock seconds a step may take, 0 if it isn't watched.
+  public: double stepBudget{0.0};
+
+  /// \brief Called with the reports of the step overruns.
+  public: Manager::StepOverrunCallback stepOverrunCallback;
+
+  /// \brief Cost of each update of the current step, null for the render
+  /// batch callback. Only filled while the step budget is set.
+  public: std::vector<std::pair<const Sensor *,
+              std::chrono::steady_clock::duration>> stepCosts;
+
+  /// \brief Protects stepCosts, which the workers add to.
+  public: std::mutex stepCostsMutex;
+
+  /// \brief Number of step overruns.
+  public: uint64_t stepOverruns{0u};
+
+  /// \brief Number of step overruns when the last one was reported.
+  public: uint64_t reportedStepOverruns{0u};
+
+  /// \brief Wall-clock time of the last step overrun report.
+  public: std::chrono::steady_clock::time_point lastStepOverrunReport;
+
+  /// \brief Identify the manager on its trace track.
+  public: struct TraceTrack
+  {
+    /// \brief Get the track of the manager.
+    /// \return Track id, which no sensor has.
+    public: SensorId Id() const { return NO_SENSOR; }
+
+    /// \brief Get the name of the track.
+    /// \return Track name.
+    public: std::string Name() const { return "Manager"; }
+  };
+
+  /// \brief Traces a step. Once it's done, reports it if it overran the
+  /// step budget and dumps the trace if it overran the trace budget.
+  public: class TraceStep
+  {
+    /// \brief Constructor
+    /// \param[in] _manager Manager running the step.
+    /// \param[in] _time Time the step updates the sensors for.
+    public: TraceStep(ManagerPrivate &_manager,
+                const std::chrono::steady_clock::duration &_time)
+      : manager(_manager), time(_time),
+        start(std::chrono::steady_clock::now())
+    {
+      if (this->manager.stepBudget > 0.0)
+        this->manager.stepCosts.clear();
+    }
+
+    /// \brief Destructor
+    public: ~TraceStep()
+    {
+      const auto now = std::chrono::steady_clock::now();
+      if (this->manager.stepBudget > 0.0 &&
+          std::chrono::duration<double>(now - this->start).count() >
+          this->manager.stepBudget)
+      {
+        this->manager.StepOverrun(this->time, now - this->start);
+      }
+
+      if (this->manager.traceOverrunBudget <= 0.0)
+        return;
+      if (std::chrono::duration<double>(now - this->start).count() <=
+          this->manager.traceOverrunBudget ||
+          now - this->manager.lastTraceDump < std::chrono::seconds(1))
+      {
+        return;
+      }
+      // Let the step end in the trace before it's written
+      this->scope.reset();
+      this->manager.lastTraceDump = now;
+      TraceRecorder::Instance().Dump(this->manager.traceOverrunPath);
+    }
+
+    /// \brief Manager running the step.
+    public: ManagerPrivate &manager;
+
+    /// \brief Time the step updates the sensors for.
+    public: std::chrono::steady_clock::duration time;
+
+    /// \brief Start of the step.
+    public: std::chrono::steady_clock::time_point start;
+
+    /// \brief Track of the step.
+    public: TraceTrack track;
+
+    /// \brief Trace of the step, reset before the trace is dumped.
+    public: std::optional<TraceScope> scope{std::in_place, "step", track};
+  };
+
+  /// \brief Time rates were last adapted at, valid if adaptStarted.
+  public: std::chrono::steady_clock::duration adaptTime{0};
+
+  /// \brief False until AdaptRates is first called after the budget is
+  /// set.
+  public: bool adaptStarted{false};
+
+  /// \brief Number of RunOnce calls since adaptTime.
+  public: uint64_t adaptSteps{0u};
+
+  /// \brief Groups of due sensors that share the same type. Only the first
+  /// groupCount entries are in use, the rest are kept to reuse their memory.
+  public: std::vector<std::vector<Sensor *>> groups;
+
+  /// \brief Number of groups in use.
+  public: std::size_t groupCount{0};
+
+  /// \brief Index into groups of each sensor type, used by BuildGroups.
+  public: std::unordered_map<std::type_index, std::size_t> groupIndices;
+
+  /// \brief Worker threads used to update non-rendering sensors.
+  public: std::vector<std::thread> workers;
+
+  /// \brief Protects the worker synchronization data below.
+  public: std::mutex workMutex;
+
+  /// \brief Notifies the workers that a new batch of sensors is ready.
+  public: std::condition_variable workCv;
+
+  /// \brief Notifies RunOnce that all the workers are done.
+  public: std::condition_variable doneCv;
+
+  /// \brief Incremented every time a new batch is handed to the workers.
+  public: uint64_t workGeneration{0};
+
+  /// \brief Number of workers still processing the current batch.
+  public: unsigned int busyWorkers{0};
+
+  /// \brief True to make the workers exit.
+  public: bool stopWorkers{false};
+
+  /// \brief Sensors updated by the workers during the current RunOnce.
+  public: std::vector<Sensor *> parallelSensors;
+
+  /// \brief Index of the next sensor in parallelSensors to be updated.
+  public: std::atomic<std::size_t> nextParallelSensor{0};
+
+  /// \brief Time passed to RunOnce for the current batch.
+  public: std::chrono::steady_clock::duration batchTime{0};
+
+  /// \brief Force flag passed to RunOnce for the current batch.
+  public: bool batchForce{false};
+
+  /// \brief True if the current batch is made of groups.
+  public: bool batchGrouped{false};
+
+  /// \brief Recorder given to every sensor, null if not recording.
+  public: std::shared_ptr<SensorRecorder> recorder;
+
+  /// \brief Check whether a sensor is selected for the replay.
+  /// \param[in] _sensor The sensor.
+  /// \return True if replaySensors is empty or has its name or type.
+  public: bool IsReplayed(const Sensor &_sensor) const;
+
+  /// \brief Replay given to the selected sensors, null if not replaying.
+  public: std::shared_ptr<SensorReplay> replay;
+
+  /// \brief Names and types of the replayed sensors, empty for all.
+  public: std::vector<std::string> replaySensors;
+
+  /// \brief A bundle added with Manager::AddBundle.
+  public: struct BundleSlot
+  {
+    /// \brief The bundle.
+    std::shared_ptr<SensorBundle> bundle;
+
+    /// \brief Ids of the bundled sensors.
+    std::vector<SensorId> sensors;
+
+    /// \brief Ids of the sensors pinned by AddBundle.
+    std::vector<SensorId> pinned;
+  };
+
+  /// \brief Bundles by topic.
+  public: std::map<std::string, BundleSlot> bundles;
+
+  /// \brief CPUs the workers are pinned to, worker i runs on set
+  /// i % size. Empty if the workers aren't pinned.
+  public: std::vector<std::vector<unsigned int>> workerCpuSets;
+
+  /// \brief True if the current batch is split into placedSensors.
+  public: bool batchPlaced{false};
+
+  /// \brief Sensors of the current batch placed on each CPU set.
+  public: std::vector<std::vector<Sensor *>> placedSensors;
+
+  /// \brief Index of the next sensor to be updated in each list of
+  /// placedSensors.
+  public: std::unique_ptr<std::atomic<std::size_t>[]> nextPlacedSensor;
+
+  /// \brief CPU set each sensor is placed on. Sensors keep their set, so
+  /// the memory they allocate on their first update stays local.
+  public: std::unordered_map<SensorId, std::size_t> sensorPlacement;
+
+  /// \brief Number of sensors placed on each CPU set.
+  public: std::vector<std::size_t> placementLoad;
 };
 
 //////////////////////////////////////////////////
-Manager::Manager() :
-  dataPtr(new ManagerPrivate)
+std::chrono::steady_clock::duration ManagerPrivate::ScheduleTime(
+    const Sensor &_sensor)
 {
+  if (!_sensor.IsActive())
+    return std::chrono::steady_clock::duration::max();
+  if (_sensor.WaitsForTrigger() && !_sensor.TriggerPending())
+    return std::chrono::steady_clock::duration::max();
+  if (_sensor.UpdateRate() > 0.0)
+    return _sensor.NextDataUpdateTime();
+  return std::chrono::steady_clock::duration::min();
 }
 
 //////////////////////////////////////////////////
-Manager::~Manager()
+SensorSlot *ManagerPrivate::Slot(SensorId _id)
 {
-  this->dataPtr->sensors.clear();
+  auto it = this->sensorIndices.find(_id);
+  return it != this->sensorIndices.end() ? &this->sensors[it->second] :
+      nullptr;
 }
 
 //////////////////////////////////////////////////
-bool Manager::Init()
+const SensorSlot *ManagerPrivate::Slot(SensorId _id) const
 {
-  return true;
+  auto it = this->sensorIndices.find(_id);
+  return it != this->sensorIndices.end() ? &this->sensors[it->second] :
+      nullptr;
 }
 
 //////////////////////////////////////////////////
-gz::sensors::Sensor *Manager::Sensor(
-    gz::sensors::SensorId _id)
+bool ManagerPrivate::IsLocal(const Sensor &_sensor) const
 {
-  auto iter = this->dataPtr->sensors.find(_id);
-  return iter != this->dataPtr->sensors.end() ? iter->second.get() : nullptr;
+  return this->shardCount <= 1u ||
+      Manager::ShardOf(_sensor.Name(), this->shardCount) == this->shardIndex;
 }
 
 //////////////////////////////////////////////////
-bool Manager::Remove(const gz::sensors::SensorId _id)
+void ManagerPrivate::Schedule(SensorSlot &_slot)
 {
-  return this->dataPtr->sensors.erase(_id) > 0;
+  // Sensors of other shards are never due
+  const auto time = _slot.local ? ScheduleTime(*_slot.sensor) :
+      std::chrono::steady_clock::duration::max();
+  this->schedule.push({time, _slot.sensor->Id(), ++_slot.scheduleVersion});
 }
 
-/////////////////////////////////////////////////
-SensorId Manager::AddSensor(
-  std::unique_ptr<sensors::Sensor> _sensor)
+//////////////////////////////////////////////////
+void ManagerPrivate::ApplyScheduleChanges()
 {
-  if (!_sensor)
-    return NO_SENSOR;
-  SensorId id = _sensor->Id();
-  this->dataPtr->sensors[id] = std::move(_sensor);
-  return id;
+  std::vector<SensorId> changed;
+  {
+    std::lock_guard<std::mutex> lock(this->changedSchedulesMutex);
+    std::swap(changed, this->changedSchedules);
+  }
+
+  for (const auto id : changed)
+  {
+    auto slot = this->Slot(id);
+    if (slot)
+      this->Schedule(*slot);
+  }
+
+  // Stale entries are only dropped when they reach the top, so rebuild the
+  // heap if too many of them have accumulated.
+  if (this->schedule.size() > 2 * this->sensors.size() + 64)
+    this->RebuildSchedule();
 }
 
 //////////////////////////////////////////////////
-void Manager::RunOnce(
-  const std::chrono::steady_clock::duration &_time, bool _force)
+void ManagerPrivate::RebuildSchedule()
 {
-  GZ_PROFILE("SensorManager::RunOnce");
-  for (auto &s : this->dataPtr->sensors)
+  std::vector<ScheduleEntry> entries;
+  entries.reserve(this->sensors.size());
+  for (auto &slot : this->sensors)
+  {
+    const auto time = slot.local ? ScheduleTime(*slot.sensor) :
+        std::chrono::steady_clock::duration::max();
+    entries.push_back({time, slot.sensor->Id(), ++slot.scheduleVersion});
+  }
+  this->schedule = decltype(this->schedule)(
+      std::greater<ScheduleEntry>(), std::move(entries));
+}
+
+//////////////////////////////////////////////////
+bool ManagerPrivate::IsCurrent(const ScheduleEntry &_entry) const
+{
+  auto slot = this->Slot(_entry.id);
+  return slot && slot->scheduleVersion == _entry.version;
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::PruneSchedule()
+{
+  while (!this->schedule.empty() && !this->IsCurrent(this->schedule.top()))
+    this->schedule.pop();
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::UpdateSensors(const std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_time, bool _force)
+{
+  // Forced updates ignore the schedule of the sensors, which grouped updates
+  // rely on. Without grouped updates, only batch sensors are grouped.
+  const bool grouped = this->groupedUpdate && !_force;
+  const bool batched = !this->groupedUpdate && !_force;
+
+  // Control sensors come first and are updated right away on this thread,
+  // so they don't wait for the others. Rendering sensors are sorted after
+  // the other control sensors and stay with the others, so they still go
+  // through the render batch and aren't grouped.
+  auto firstOther = std::find_if(_sensors.begin(), _sensors.end(),
+      [](const Sensor *_sensor)
+      {
+        return _sensor->Priority() != SensorPriority::CONTROL ||
+            _sensor->IsRenderingSensor();
+      });
+  if (firstOther != _sensors.begin())
+  {
+    GZ_PROFILE("SensorManager::ControlSensors");
+    this->otherSensors.assign(_sensors.begin(), firstOther);
+    if (grouped)
+    {
+      this->BuildGroups(this->otherSensors);
+      for (std::size_t i = 0; i < this->groupCount; ++i)
+        this->UpdateGroup(this->groups[i], _time);
+    }
+    else
+    {
+      const auto &control = batched ?
+          this->UpdateBatchSensors(this->otherSensors, _time) :
+          this->otherSensors;
+      for (auto &s : control)
+        this->UpdateSensor(*s, _time, _force);
+    }
+    if (firstOther == _sensors.end())
+      return;
+    this->otherSensors.assign(firstOther, _sensors.end());
+  }
+  const auto &remaining =
+      firstOther == _sensors.begin() ? _sensors : this->otherSensors;
+  const auto &sensors = batched ?
+      this->UpdateBatchSensors(remaining, _time) : remaining;
+
+  if (this->renderBatchCallback)
+  {
+    this->renderingSensors.clear();
+    for (auto &s : sensors)
+    {
+      if (s->IsRenderingSensor())
+        this->renderingSensors.push_back(s);
+    }
+    if (!this->renderingSensors.empty())
+    {
+      GZ_PROFILE("SensorManager::RenderBatch");
+      const auto start = std::chrono::steady_clock::now();
+      this->renderBatchCallback(this->renderingSensors, _time);
+      if (this->stepBudget > 0.0)
+      {
+        this->stepCosts.emplace_back(nullptr,
+            std::chrono::steady_clock::now() - start);
+      }
+    }
+  }
+
+  if (this->workers.empty() && !grouped)
+  {
+    for (auto &s : sensors)
+      this->UpdateSensor(*s, _time, _force);
+    return;
+  }
+
+  // Rendering sensors are neither grouped nor handed to the workers
+  this->parallelSensors.clear();
+  this->renderingSensors.clear();
+  for (auto &s : sensors)
+  {
+    if (s->IsRenderingSensor())
+      this->renderingSensors.push_back(s);
+    else
+      this->parallelSensors.push_back(s);
+  }
+
+  if (grouped)
+    this->BuildGroups(this->parallelSensors);
+
+  if (this->workers.empty())
+  {
+    for (auto &s : this->renderingSensors)
+      this->UpdateSensor(*s, _time, _force);
+    for (std::size_t i = 0; i < this->groupCount; ++i)
+      this->UpdateGroup(this->groups[i], _time);
+    return;
+  }
+
+  // Hand the non-rendering sensors to the workers
+  const bool placed = !grouped && this->PlacementCount() > 0;
+  if (placed)
+    this->PlaceSensors();
+  {
+    std::lock_guard<std::mutex> lock(this->workMutex);
+    this->batchTime = _time;
+    this->batchForce = _force;
+    this->batchGrouped = grouped;
+    this->batchPlaced = placed;
+    this->nextParallelSensor = 0;
+    this->busyWorkers = static_cast<unsigned int>(this->workers.size());
+    ++this->workGeneration;
+  }
+  this->workCv.notify_all();
+
+  // Rendering sensors stay on this thread. Once they are done, help the
+  // workers with whatever is left, unless the sensors are placed on the
+  // CPU sets of the workers.
+  for (auto &s : this->renderingSensors)
+    this->UpdateSensor(*s, _time, _force);
+  if (!placed)
+    this->UpdateParallelSensors();
+
+  // Wait for all workers to reach the end of the batch
+  std::unique_lock<std::mutex> lock(this->workMutex);
+  this->doneCv.wait(lock, [this]
+  {
+    return this->busyWorkers == 0;
+  });
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::QueueRenderingSensors(std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_time, bool _force)
+{
+  std::vector<std::pair<SensorId, Sensor *>> queued;
+  {
+    std::lock_guard<std::mutex> lock(this->renderHandoff->mutex);
+    auto &inFlight = this->renderHandoff->inFlight;
+    auto it = std::remove_if(_sensors.begin(), _sensors.end(),
+        [&](Sensor *_sensor)
+        {
+          if (!_sensor->IsRenderingSensor())
+            return false;
+          if (inFlight.insert(_sensor->Id()).second)
+            queued.emplace_back(_sensor->Id(), _sensor);
+          return true;
+        });
+    _sensors.erase(it, _sensors.end());
+  }
+
+  if (queued.empty())
+    return;
+
+  this->renderQueue->Push(
+      [handoff = this->renderHandoff, queued = std::move(queued), _time,
+       _force, callback = this->renderBatchCallback]()
+      {
+        RenderQueued(*handoff, queued, _time, _force, callback);
+      });
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::QueueTriggered(
+    const std::shared_ptr<RenderHandoff> &_handoff, SensorId _id,
+    Sensor *_sensor)
+{
+  std::shared_ptr<RenderTaskQueue> queue;
+  {
+    std::lock_guard<std::mutex> lock(_handoff->mutex);
+    if (!_handoff->manager || !_handoff->triggerQueue)
+      return;
+
+    // A sensor already waiting for the render thread renders its trigger
+    // when it's updated
+    if (!_handoff->inFlight.insert(_id).second)
+      return;
+
+    // The first sensor triggered queues the task, the next ones join it
+    _handoff->triggered.emplace_back(_id, _sensor);
+    if (_handoff->triggered.size() > 1u)
+      return;
+    queue = _handoff->triggerQueue;
+  }
+
+  queue->Push([handoff = _handoff]()
+      {
+        std::vector<std::pair<SensorId, Sensor *>> sensors;
+        std::chrono::steady_clock::duration time;
+        Manager::RenderBatchCallback callback;
+        {
+          std::lock_guard<std::mutex> lock(handoff->mutex);
+          sensors.swap(handoff->triggered);
+          time = handoff->time;
+          callback = handoff->triggerBatchCallback;
+        }
+        RenderQueued(*handoff, sensors, time, true, callback);
+      });
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::UpdateTriggerQueue()
+{
+  std::lock_guard<std::mutex> lock(this->renderHandoff->mutex);
+  this->renderHandoff->triggerQueue =
+      this->immediateTrigger ? this->renderQueue : nullptr;
+  this->renderHandoff->triggerBatchCallback = this->renderBatchCallback;
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::RenderQueued(RenderHandoff &_handoff,
+    const std::vector<std::pair<SensorId, Sensor *>> &_sensors,
+    const std::chrono::steady_clock::duration &_time, bool _force,
+    const Manager::RenderBatchCallback &_callback)
+{
+  // Skip the sensors removed since they were queued
+  std::vector<SensorId> ids;
+  std::vector<Sensor *> sensors;
+  {
+    std::lock_guard<std::mutex> lock(_handoff.mutex);
+    if (!_handoff.manager)
+      return;
+    for (const auto &[id, sensor] : _sensors)
+    {
+      if (_handoff.inFlight.count(id) > 0)
+      {
+        ids.push_back(id);
+        sensors.push_back(sensor);
+      }
+    }
+    _handoff.running = true;
+    _handoff.renderThread = std::this_thread::get_id();
+  }
+
+  if (_callback && !sensors.empty())
+  {
+    GZ_PROFILE("SensorManager::RenderBatch");
+    _callback(sensors, _time);
+  }
+  for (auto &s : sensors)
+    s->Update(_time, _force);
+
+  // Have RunOnce re-key the sensors with their new update times
+  {
+    std::lock_guard<std::mutex> lock(_handoff.mutex);
+    _handoff.running = false;
+    for (const auto id : ids)
+      _handoff.inFlight.erase(id);
+    if (_handoff.manager)
+    {
+      std::lock_guard<std::mutex> scheduleLock(
+          _handoff.manager->changedSchedulesMutex);
+      auto &changed = _handoff.manager->changedSchedules;
+      changed.insert(changed.end(), ids.begin(), ids.end());
+    }
+  }
+  _handoff.idleCv.notify_all();
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::AdaptRates(
+    const std::chrono::steady_clock::duration &_time)
+{
+  ++this->adaptSteps;
+  const double elapsed =
+      std::chrono::duration<double>(_time - this->adaptTime).count();
+
+  // Also restart after the time went backwards
+  if (!this->adaptStarted || elapsed < 0.0)
+  {
+    this->adaptStarted = true;
+    this->adaptTime = _time;
+    this->adaptSteps = 0u;
+    return;
+  }
+  if (elapsed < 1.0)
+    return;
+  const double stepRate = static_cast<double>(this->adaptSteps) / elapsed;
+  this->adaptTime = _time;
+  this->adaptSteps = 0u;
+
+  // Load of each sensor, in wall-clock seconds per simulated second
+  struct SensorLoad
+  {
+    Sensor *sensor;
+    double cost;
+    double rate;
+  };
+  std::vector<SensorLoad> adjustable;
+  double total = 0.0;
+  for (auto &slot : this->sensors)
+  {
+    auto *sensor = slot.sensor.get();
+    if (!slot.local || !sensor->IsActive())
+      continue;
+    const double cost =
+        std::chrono::duration<double>(sensor->UpdateCost()).count();
+    const bool everyCycle = sensor->UpdateRate() <= 0.0;
+    const double rate =
+        everyCycle ? stepRate : sensor->EffectiveUpdateRate();
+    total += cost * rate;
+    if (!everyCycle && sensor->MinUpdateRate() > 0.0 && cost > 0.0)
+      adjustable.push_back({sensor, cost, rate});
+  }
+
+  if (total > this->updateBudget)
   {
-    s.second->Update(_time, _force);
+    // Take the excess from the lowest priority class first, and from the
+    // heaviest sensors within a class
+    std::sort(adjustable.begin(), adjustable.end(),
+        [](const SensorLoad &_a, const SensorLoad &_b)
+        {
+          if (_a.sensor->Priority() != _b.sensor->Priority())
+            return _a.sensor->Priority() > _b.sensor->Priority();
+          return _a.cost * _a.rate > _b.cost * _b.rate;
+        });
+    double excess = total - this->updateBudget;
+    for (auto &load : adjustable)
+    {
+      const double minRate =
+          std::min(load.sensor->MinUpdateRate(), load.sensor->UpdateRate());
+      const double saving =
+          std::min(excess, load.cost * (load.rate - minRate));
+      if (saving <= 0.0)
+        continue;
+      load.sensor->SetEffectiveUpdateRate(load.rate - saving / load.cost);
+      excess -= saving;
+      if (excess <= 0.0)
+        break;
+    }
+    return;
   }
+
+  // Give the headroom back, leaving a margin so rates don't oscillate
+  double headroom = 0.9 * this->updateBudget - total;
+  if (headroom <= 0.0)
+    return;
+  std::sort(adjustable.begin(), adjustable.end(),
+      [](const SensorLoad &_a, const SensorLoad &_b)
+      {
+        if (_a.sensor->Priority() != _b.sensor->Priority())
+          return _a.sensor->Priority() < _b.sensor->Priority();
+        return _a.cost < _b.cost;
+      });
+  for (auto &load : adjustable)
+  {
+    const double extra = std::min(headroom,
+        load.cost * (load.sensor->UpdateRate() - load.rate));
+    if (extra <= 0.0)
+      continue;
+    load.sensor->SetEffectiveUpdateRate(load.rate + extra / load.cost);
+    headroom -= extra;
+    if (headroom <= 0.0)
+      break;
+  }
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::StaggerPhases(
+    const std::chrono::steady_clock::duration &_time)
+{
+  // Sensors are grouped by rate, in id order so offsets are reproducible
+  std::map<double, std::vector<Sensor *>> fresh;
+  std::map<double, std::vector<Sensor *>> placed;
+  for (auto &slot : this->sensors)
+  {
+    Sensor *sensor = slot.sensor.get();
+    const double rate = sensor->UpdateRate();
+    if (!slot.local || rate <= 0.0 || this->phaseAligned.count(sensor->Id()))
+      continue;
+    if (this->staggered.count(sensor->Id()))
+      placed[rate].push_back(sensor);
+    else
+      fresh[rate].push_back(sensor);
+  }
+
+  for (auto &[rate, group] : fresh)
+  {
+    std::sort(group.begin(), group.end(), [](Sensor *_a, Sensor *_b)
+    {
+      return _a->Id() < _b->Id();
+    });
+    const auto period =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / rate));
+    if (period <= std::chrono::steady_clock::duration::zero())
+      continue;
+
+    // Phases of the sensors already spread, relative to now
+    std::vector<std::chrono::steady_clock::duration> phases;
+    for (const Sensor *sensor : placed[rate])
+    {
+      auto phase = (sensor->NextDataUpdateTime() - _time) % period;
+      if (phase < std::chrono::steady_clock::duration::zero())
+        phase += period;
+      phases.push_back(phase);
+    }
+    std::sort(phases.begin(), phases.end());
+
+    for (std::size_t i = 0u; i < group.size(); ++i)
+    {
+      std::chrono::steady_clock::duration offset;
+      if (placed[rate].empty())
+      {
+        // Evenly spaced when the whole group is new
+        offset = period * static_cast<int64_t>(i) /
+            static_cast<int64_t>(group.size());
+      }
+      else
+      {
+        // Otherwise in the middle of the largest gap
+        std::size_t gapIndex = 0u;
+        auto gap = std::chrono::steady_clock::duration::zero();
+        for (std::size_t j = 0u; j < phases.size(); ++j)
+        {
+          const auto next = j + 1u < phases.size() ? phases[j + 1u] :
+              phases.front() + period;
+          if (next - phases[j] > gap)
+          {
+            gap = next - phases[j];
+            gapIndex = j;
+          }
+        }
+        offset = (phases[gapIndex] + gap / 2) % period;
+        phases.insert(std::upper_bound(phases.begin(), phases.end(), offset),
+            offset);
+      }
+      group[i]->SetNextDataUpdateTime(_time + offset);
+      this->staggered.insert(group[i]->Id());
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::BuildGroups(const std::vector<Sensor *> &_sensors)
+{
+  this->groupCount = 0;
+  this->groupIndices.clear();
+  for (auto &s : _sensors)
+  {
+    auto [it, inserted] = this->groupIndices.try_emplace(
+        std::type_index(typeid(*s)), this->groupCount);
+    if (inserted)
+    {
+      if (this->groups.size() <= this->groupCount)
+        this->groups.emplace_back();
+      this->groups[this->groupCount].clear();
+      ++this->groupCount;
+    }
+    this->groups[it->second].push_back(s);
+  }
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::SortByPriority(std::vector<Sensor *> &_sensors)
+{
+  std::sort(_sensors.begin(), _sensors.end(),
+      [](const Sensor *_a, const Sensor *_b)
+      {
+        if (_a->Priority() != _b->Priority())
+          return _a->Priority() < _b->Priority();
+        // Rendering sensors can't take the control fast path
+        if (_a->Priority() == SensorPriority::CONTROL &&
+            _a->IsRenderingSensor() != _b->IsRenderingSensor())
+        {
+          return _b->IsRenderingSensor();
+        }
+        return _a->Id() < _b->Id();
+      });
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::StartWorkers(unsigned int _count)
+{
+  this->stopWorkers = false;
+  this->workers.reserve(_count);
+
+  // The number of CPU sets in use may change, place the sensors again
+  this->sensorPlacement.clear();
+  this->placementLoad.clear();
+  for (unsigned int i = 0; i < _count; ++i)
+  {
+    this->workers.emplace_back(&ManagerPrivate::WorkerLoop, this,
+        this->workGeneration, i);
+  }
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::StopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->workMutex);
+    this->stopWorkers = true;
+  }
+  this->workCv.notify_all();
+  for (auto &worker : this->workers)
+  {
+    if (worker.joinable())
+      worker.join();
+  }
+  this->workers.clear();
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::WorkerLoop(uint64_t _generation, unsigned int _index)
+{
+  // The CPU sets only change while the workers are stopped
+  const std::size_t set = this->workerCpuSets.empty() ? 0u :
+      _index % this->workerCpuSets.size();
+  if (!this->workerCpuSets.empty() &&
+      !PinCurrentThread(this->workerCpuSets[set]))
+  {
+    gzwarn << "Failed to set the CPU affinity of sensor worker [" << _index
+           << "]." << std::endl;
+  }
+
+  uint64_t generation = _generation;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->workMutex);
+      this->workCv.wait(lock, [&]
+      {
+        return this->stopWorkers || this->workGeneration != generation;
+      });
+      if (this->stopWorkers)
+        return;
+      generation = this->workGeneration;
+    }
+
+    if (this->batchPlaced)
+      this->UpdatePlacedSensors(set);
+    else
+      this->UpdateParallelSensors();
+
+    {
+      std::lock_guard<std::mutex> lock(this->workMutex);
+      if (--this->busyWorkers == 0)
+        this->doneCv.notify_one();
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::UpdateParallelSensors()
+{
+  GZ_PROFILE("SensorManager::UpdateParallelSensors");
+  if (this->batchGrouped)
+  {
+    const std::size_t count = this->groupCount;
+    for (std::size_t i = this->nextParallelSensor++; i < count;
+         i = this->nextParallelSensor++)
+    {
+      this->UpdateGroup(this->groups[i], this->batchTime);
+    }
+    return;
+  }
+
+  const std::size_t count = this->parallelSensors.size();
+  for (std::size_t i = this->nextParallelSensor++; i < count;
+       i = this->nextParallelSensor++)
+  {
+    this->UpdateSensor(*this->parallelSensors[i], this->batchTime,
+        this->batchForce);
+  }
+}
+
+//////////////////////////////////////////////////
+std::size_t ManagerPrivate::PlacementCount() const
+{
+  return std::min(this->workerCpuSets.size(), this->workers.size());
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::PlaceSensors()
+{
+  const std::size_t count = this->PlacementCount();
+  if (this->placedSensors.size() != count)
+  {
+    this->placedSensors.assign(count, {});
+    this->nextPlacedSensor.reset(new std::atomic<std::size_t>[count]);
+  }
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    this->placedSensors[i].clear();
+    this->nextPlacedSensor[i] = 0;
+  }
+  this->placementLoad.resize(count, 0);
+
+  for (auto &s : this->parallelSensors)
+  {
+    auto it = this->sensorPlacement.find(s->Id());
+    if (it == this->sensorPlacement.end())
+    {
+      const std::size_t set = static_cast<std::size_t>(std::distance(
+          this->placementLoad.begin(), std::min_element(
+          this->placementLoad.begin(), this->placementLoad.end())));
+      ++this->placementLoad[set];
+      it = this->sensorPlacement.emplace(s->Id(), set).first;
+    }
+    this->placedSensors[it->second].push_back(s);
+  }
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::UpdatePlacedSensors(std::size_t _set)
+{
+  GZ_PROFILE("SensorManager::UpdatePlacedSensors");
+  const auto &sensors = this->placedSensors[_set];
+  auto &next = this->nextPlacedSensor[_set];
+  for (std::size_t i = next++; i < sensors.size(); i = next++)
+    this->UpdateSensor(*sensors[i], this->batchTime, this->batchForce);
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::UpdateSensor(Sensor &_sensor,
+    const std::chrono::steady_clock::duration &_time, bool _force)
+{
+  if (this->stepBudget <= 0.0)
+  {
+    _sensor.Update(_time, _force);
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  _sensor.Update(_time, _force);
+  const auto cost = std::chrono::steady_clock::now() - start;
+  std::lock_guard<std::mutex> lock(this->stepCostsMutex);
+  this->stepCosts.emplace_back(&_sensor, cost);
+}
+
+//////////////////////////////////////////////////
+const std::vector<Sensor *> &ManagerPrivate::UpdateBatchSensors(
+    const std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_time)
+{
+  auto isBatch = [](const Sensor *_sensor)
+  {
+    return _sensor->HasBatchUpdate() && !_sensor->IsRenderingSensor();
+  };
+  if (std::none_of(_sensors.begin(), _sensors.end(), isBatch))
+    return _sensors;
+
+  GZ_PROFILE("SensorManager::BatchSensors");
+  this->batchSensors.clear();
+  this->unbatchedSensors.clear();
+  for (auto &s : _sensors)
+  {
+    if (isBatch(s))
+      this->batchSensors.push_back(s);
+    else
+      this->unbatchedSensors.push_back(s);
+  }
+  this->BuildGroups(this->batchSensors);
+  for (std::size_t i = 0; i < this->groupCount; ++i)
+    this->UpdateGroup(this->groups[i], _time);
+  return this->unbatchedSensors;
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::UpdateGroup(const std::vector<Sensor *> &_group,
+    const std::chrono::steady_clock::duration &_time)
+{
+  if (this->stepBudget <= 0.0 || _group.empty())
+  {
+    Sensor::UpdateGroup(_group, _time);
+    return;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  Sensor::UpdateGroup(_group, _time);
+  const auto share = (std::chrono::steady_clock::now() - start) /
+      static_cast<int>(_group.size());
+  std::lock_guard<std::mutex> lock(this->stepCostsMutex);
+  for (const auto *s : _group)
+    this->stepCosts.emplace_back(s, share);
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::StepOverrun(
+    const std::chrono::steady_clock::duration &_time,
+    const std::chrono::steady_clock::duration &_duration)
+{
+  ++this->stepOverruns;
+  const auto now = std::chrono::steady_clock::now();
+  if (this->reportedStepOverruns > 0u &&
+      now - this->lastStepOverrunReport < std::chrono::seconds(1))
+  {
+    return;
+  }
+
+  ManagerStepOverrun report;
+  report.time = _time;
+  report.duration = _duration;
+  report.budget = std::chrono::duration_cast<
+      std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(this->stepBudget));
+  report.overruns = this->stepOverruns - this->reportedStepOverruns;
+  report.sensors.reserve(this->stepCosts.size());
+  for (const auto &[sensor, cost] : this->stepCosts)
+  {
+    ManagerStepOverrun::SensorCost entry;
+    if (sensor)
+    {
+      entry.id = sensor->Id();
+      entry.name = sensor->Name();
+    }
+    else
+    {
+      entry.name = "render batch";
+    }
+    entry.cost = cost;
+    report.sensors.push_back(std::move(entry));
+  }
+  std::stable_sort(report.sensors.begin(), report.sensors.end(),
+      [](const ManagerStepOverrun::SensorCost &_a,
+         const ManagerStepOverrun::SensorCost &_b)
+      {
+        return _a.cost > _b.cost;
+      });
+
+  auto millis = [](const std::chrono::steady_clock::duration &_d)
+  {
+    return std::chrono::duration<double, std::milli>(_d).count();
+  };
+  std::ostringstream slowest;
+  const std::size_t listed = std::min<std::size_t>(report.sensors.size(), 3u);
+  for (std::size_t i = 0u; i < listed; ++i)
+  {
+    slowest << (i > 0u ? ", " : "") << report.sensors[i].name << " ("
+            << millis(report.sensors[i].cost) << " ms)";
+  }
+  gzwarn << "Sensor update step took " << millis(report.duration)
+         << " ms, over its budget of " << millis(report.budget) << " ms ("
+         << report.overruns << " overruns since the last report). Slowest: "
+         << (listed > 0u ? slowest.str() : "none") << std::endl;
+
+  this->reportedStepOverruns = this->stepOverruns;
+  this->lastStepOverrunReport = now;
+  if (this->stepOverrunCallback)
+    this->stepOverrunCallback(report);
+}
+
+//////////////////////////////////////////////////
+Manager::Manager() :
+  dataPtr(new ManagerPrivate)
+{
+  this->dataPtr->renderHandoff->manager = this->dataPtr.get();
+}
+
+//////////////////////////////////////////////////
+Manager::~Manager()
+{
+  // Tasks still queued find no manager and return. Wait for the one
+  // running, unless it's the one destroying the manager.
+  {
+    auto &handoff = *this->dataPtr->renderHandoff;
+    std::unique_lock<std::mutex> lock(handoff.mutex);
+    handoff.manager = nullptr;
+    handoff.inFlight.clear();
+    if (handoff.renderThread != std::this_thread::get_id())
+      handoff.idleCv.wait(lock, [&handoff] { return !handoff.running; });
+  }
+  this->dataPtr->StopWorkers();
+  this->dataPtr->sensorIndices.clear();
+  this->dataPtr->sensors.clear();
+}
+
+//////////////////////////////////////////////////
+bool Manager::Init()
+{
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::unique_lock<std::mutex> ManagerPrivate::TryLockStep()
+{
+  if (this->stepThread == std::this_thread::get_id())
+    return std::unique_lock<std::mutex>();
+  return std::unique_lock<std::mutex>(this->stepMutex, std::try_to_lock);
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::ApplyStaged()
+{
+  if (!this->hasStaged)
+    return;
+
+  std::vector<SensorId> removes;
+  {
+    std::lock_guard<std::mutex> lock(this->stagingMutex);
+    std::swap(removes, this->stagedRemoves);
+  }
+  for (const auto id : removes)
+    this->RemoveNow(id);
+
+  // Added while holding stagingMutex, so lookups find the sensors either
+  // staged or in their slot
+  std::lock_guard<std::mutex> lock(this->stagingMutex);
+  for (auto &sensor : this->stagedAdds)
+    this->AddNow(std::move(sensor));
+  this->stagedAdds.clear();
+  this->hasStaged = !this->stagedRemoves.empty();
+}
+
+//////////////////////////////////////////////////
+void ManagerPrivate::AddNow(std::unique_ptr<Sensor> _sensor)
+{
+  const SensorId id = _sensor->Id();
+  const bool local = this->IsLocal(*_sensor);
+  SensorSlot *slot;
+  {
+    std::unique_lock<std::shared_mutex> lock(this->sensorsMutex);
+    slot = this->Slot(id);
+    if (slot)
+    {
+      slot->sensor = std::move(_sensor);
+    }
+    else
+    {
+      this->sensorIndices[id] = this->sensors.size();
+      this->sensors.push_back({std::move(_sensor), 0});
+      slot = &this->sensors.back();
+    }
+  }
+  slot->local = local;
+  if (this->updateBudget > 0.0)
+    slot->sensor->SetMeasureUpdateCost(true);
+  this->staggered.erase(id);
+  this->staggerPending = this->phaseStagger;
+  this->Schedule(*slot);
+}
+
+//////////////////////////////////////////////////
+bool ManagerPrivate::RemoveNow(SensorId _id)
+{
+  if (this->sensorIndices.find(_id) == this->sensorIndices.end())
+    return false;
+
+  // A queued sensor is skipped by its task, wait in case it's being
+  // updated on the render thread.
+  {
+    auto &handoff = *this->renderHandoff;
+    std::unique_lock<std::mutex> lock(handoff.mutex);
+    if (handoff.inFlight.erase(_id) > 0 &&
+        handoff.renderThread != std::this_thread::get_id())
+    {
+      handoff.idleCv.wait(lock, [&handoff] { return !handoff.running; });
+    }
+  }
+
+  // Move the last slot into the freed one. Entries left in the schedule
+  // are discarded once they reach the top. The sensor is destroyed once
+  // lookups can't reach it anymore.
+  std::unique_ptr<Sensor> removed;
+  {
+    std::unique_lock<std::shared_mutex> lock(this->sensorsMutex);
+    auto it = this->sensorIndices.find(_id);
+    const std::size_t index = it->second;
+    this->sensorIndices.erase(it);
+    removed = std::move(this->sensors[index].sensor);
+    if (index != this->sensors.size() - 1)
+    {
+      this->sensors[index] = std::move(this->sensors.back());
+      this->sensorIndices[this->sensors[index].sensor->Id()] = index;
+    }
+    this->sensors.pop_back();
+  }
+  this->staggered.erase(_id);
+  this->phaseAligned.erase(_id);
+  auto placement = this->sensorPlacement.find(_id);
+  if (placement != this->sensorPlacement.end())
+  {
+    --this->placementLoad[placement->second];
+    this->sensorPlacement.erase(placement);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+gz::sensors::Sensor *Manager::Sensor(
+    gz::sensors::SensorId _id)
+{
+  auto lookup = [this, _id]() -> gz::sensors::Sensor *
+  {
+    std::shared_lock<std::shared_mutex> lock(this->dataPtr->sensorsMutex);
+    auto slot = this->dataPtr->Slot(_id);
+    return slot ? slot->sensor.get() : nullptr;
+  };
+
+  auto sensor = lookup();
+  if (sensor)
+    return sensor;
+
+  // Staged sensors are moved to their slot while holding stagingMutex
+  std::lock_guard<std::mutex> lock(this->dataPtr->stagingMutex);
+  for (const auto &staged : this->dataPtr->stagedAdds)
+  {
+    if (staged->Id() == _id)
+      return staged.get();
+  }
+  return lookup();
+}
+
+//////////////////////////////////////////////////
+bool Manager::Remove(const gz::sensors::SensorId _id)
+{
+  auto stepLock = this->dataPtr->TryLockStep();
+  std::unique_lock<std::mutex> lock(this->dataPtr->stagingMutex);
+
+  // Sensors that are still staged are dropped right away
+  auto &adds = this->dataPtr->stagedAdds;
+  auto it = std::find_if(adds.begin(), adds.end(),
+      [_id](const std::unique_ptr<gz::sensors::Sensor> &_sensor)
+      {
+        return _sensor->Id() == _id;
+      });
+  if (it != adds.end())
+  {
+    adds.erase(it);
+    return true;
+  }
+
+  if (stepLock.owns_lock())
+  {
+    lock.unlock();
+    return this->dataPtr->RemoveNow(_id);
+  }
+
+  // A step is running, the sensor is removed at the start of the next one
+  {
+    std::shared_lock<std::shared_mutex> sensorsLock(
+        this->dataPtr->sensorsMutex);
+    if (!this->dataPtr->Slot(_id))
+      return false;
+  }
+  this->dataPtr->stagedRemoves.push_back(_id);
+  this->dataPtr->hasStaged = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::vector<SensorId> Manager::SensorIds() const
+{
+  std::vector<SensorId> ids;
+  std::lock_guard<std::mutex> lock(this->dataPtr->stagingMutex);
+  {
+    std::shared_lock<std::shared_mutex> sensorsLock(
+        this->dataPtr->sensorsMutex);
+    ids.reserve(this->dataPtr->sensors.size());
+    for (const auto &slot : this->dataPtr->sensors)
+      ids.push_back(slot.sensor->Id());
+  }
+  for (const auto &sensor : this->dataPtr->stagedAdds)
+    ids.push_back(sensor->Id());
+  for (const auto id : this->dataPtr->stagedRemoves)
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+//////////////////////////////////////////////////
+SensorId Manager::AddSensor(
+  std::unique_ptr<sensors::Sensor> _sensor)
+{
+  if (!_sensor)
+    return NO_SENSOR;
+  SensorId id = _sensor->Id();
+  _sensor->SetScheduleChangedCallback([this](SensorId _changedId)
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->changedSchedulesMutex);
+    this->dataPtr->changedSchedules.push_back(_changedId);
+  });
+  if (this->dataPtr->hasNoiseSeed)
+    _sensor->SetNoiseSeed(this->dataPtr->noiseSeed);
+  if (this->dataPtr->recorder)
+    _sensor->SetRecorder(this->dataPtr->recorder);
+  if (this->dataPtr->replay && this->dataPtr->IsReplayed(*_sensor))
+    _sensor->SetReplay(this->dataPtr->replay);
+  _sensor->SetTriggerCallback(
+      [handoff = this->dataPtr->renderHandoff, sensor = _sensor.get()](
+      SensorId _triggeredId)
+      {
+        ManagerPrivate::QueueTriggered(handoff, _triggeredId, sensor);
+      });
+
+  auto stepLock = this->dataPtr->TryLockStep();
+  if (stepLock.owns_lock())
+  {
+    this->dataPtr->AddNow(std::move(_sensor));
+    return id;
+  }
+
+  // A step is running, the sensor is added at the start of the next one
+  std::lock_guard<std::mutex> lock(this->dataPtr->stagingMutex);
+  this->dataPtr->stagedAdds.push_back(std::move(_sensor));
+  this->dataPtr->hasStaged = true;
+  return id;
+}
+
+//////////////////////////////////////////////////
+void Manager::RunOnce(
+  const std::chrono::steady_clock::duration &_time, bool _force)
+{
+  GZ_PROFILE("SensorManager::RunOnce");
+  std::lock_guard<std::mutex> stepLock(this->dataPtr->stepMutex);
+  ManagerPrivate::StepThread stepThread(*this->dataPtr);
+  ManagerPrivate::TraceStep step(*this->dataPtr, _time);
+  auto &dueSensors = this->dataPtr->dueSensors;
+  dueSensors.clear();
+
+  // Sensors added or removed while the previous step ran
+  this->dataPtr->ApplyStaged();
+
+  if (this->dataPtr->immediateTrigger)
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->renderHandoff->mutex);
+    this->dataPtr->renderHandoff->time = _time;
+  }
+
+  // Forced updates don't change the schedule of any sensor
+  if (_force)
+  {
+    for (auto &slot : this->dataPtr->sensors)
+    {
+      if (slot.local)
+        dueSensors.push_back(slot.sensor.get());
+    }
+    ManagerPrivate::SortByPriority(dueSensors);
+    if (this->dataPtr->renderQueue)
+      this->dataPtr->QueueRenderingSensors(dueSensors, _time, _force);
+    this->dataPtr->UpdateSensors(dueSensors, _time, _force);
+    return;
+  }
+
+  {
+    TraceScope trace("schedule", step.track);
+    if (this->dataPtr->staggerPending)
+    {
+      this->dataPtr->StaggerPhases(_time);
+      this->dataPtr->staggerPending = false;
+    }
+    this->dataPtr->ApplyScheduleChanges();
+
+    // Pop all sensors that are due
+    auto &schedule = this->dataPtr->schedule;
+    while (!schedule.empty() && schedule.top().time <= _time)
+    {
+      const ScheduleEntry entry = schedule.top();
+      schedule.pop();
+      auto slot = this->dataPtr->Slot(entry.id);
+      if (!slot || slot->scheduleVersion != entry.version)
+        continue;
+      dueSensors.push_back(slot->sensor.get());
+    }
+
+    // Update in a stable order, by priority class and then by id
+    ManagerPrivate::SortByPriority(dueSensors);
+  }
+
+  // Queued sensors are re-keyed once the render thread updated them
+  if (this->dataPtr->renderQueue)
+    this->dataPtr->QueueRenderingSensors(dueSensors, _time, _force);
+  this->dataPtr->UpdateSensors(dueSensors, _time, _force);
+
+  // Re-key with the new update times
+  for (auto &s : dueSensors)
+    this->dataPtr->Schedule(*this->dataPtr->Slot(s->Id()));
+
+  // Rates changed here are re-keyed by the next call
+  if (this->dataPtr->updateBudget > 0.0)
+    this->dataPtr->AdaptRates(_time);
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration Manager::NextUpdateTime()
+{
+  this->dataPtr->ApplyScheduleChanges();
+  this->dataPtr->PruneSchedule();
+  if (this->dataPtr->schedule.empty())
+    return std::chrono::steady_clock::duration::max();
+  return this->dataPtr->schedule.top().time;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetGroupedUpdate(bool _grouped)
+{
+  this->dataPtr->groupedUpdate = _grouped;
+}
+
+//////////////////////////////////////////////////
+bool Manager::GroupedUpdate() const
+{
+  return this->dataPtr->groupedUpdate;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetWorkerThreadCount(unsigned int _count)
+{
+  if (_count == this->dataPtr->workers.size())
+    return;
+
+  this->dataPtr->StopWorkers();
+  this->dataPtr->StartWorkers(_count);
+}
+
+//////////////////////////////////////////////////
+unsigned int Manager::WorkerThreadCount() const
+{
+  return static_cast<unsigned int>(this->dataPtr->workers.size());
+}
+
+//////////////////////////////////////////////////
+void Manager::SetWorkerAffinity(
+    const std::vector<std::vector<unsigned int>> &_cpuSets)
+{
+  const auto count = static_cast<unsigned int>(this->dataPtr->workers.size());
+  this->dataPtr->StopWorkers();
+  this->dataPtr->workerCpuSets = _cpuSets;
+  this->dataPtr->workerCpuSets.erase(std::remove_if(
+      this->dataPtr->workerCpuSets.begin(),
+      this->dataPtr->workerCpuSets.end(),
+      [](const std::vector<unsigned int> &_set) { return _set.empty(); }),
+      this->dataPtr->workerCpuSets.end());
+  this->dataPtr->StartWorkers(count);
+}
+
+//////////////////////////////////////////////////
+void Manager::SetRecorder(std::shared_ptr<SensorRecorder> _recorder)
+{
+  this->dataPtr->recorder = _recorder;
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->sensorsMutex);
+  for (auto &slot : this->dataPtr->sensors)
+    slot.sensor->SetRecorder(_recorder);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorRecorder> Manager::Recorder() const
+{
+  return this->dataPtr->recorder;
+}
+
+//////////////////////////////////////////////////
+bool ManagerPrivate::IsReplayed(const Sensor &_sensor) const
+{
+  if (this->replaySensors.empty())
+    return true;
+  const std::string name = _sensor.Name();
+  const std::string type = _sensor.TypeStr();
+  return std::any_of(this->replaySensors.begin(), this->replaySensors.end(),
+      [&name, &type](const std::string &_selected)
+      {
+        return _selected == name || _selected == type;
+      });
+}
+
+//////////////////////////////////////////////////
+void Manager::SetReplay(std::shared_ptr<SensorReplay> _replay,
+    const std::vector<std::string> &_sensors)
+{
+  this->dataPtr->replay = _replay;
+  this->dataPtr->replaySensors = _sensors;
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->sensorsMutex);
+  for (auto &slot : this->dataPtr->sensors)
+  {
+    slot.sensor->SetReplay(_replay && this->dataPtr->IsReplayed(
+        *slot.sensor) ? _replay : nullptr);
+  }
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorReplay> Manager::Replay() const
+{
+  return this->dataPtr->replay;
+}
+
+//////////////////////////////////////////////////
+bool Manager::AddBundle(const std::string &_topic,
+    const std::vector<SensorId> &_sensors)
+{
+  if (_sensors.empty())
+  {
+    gzerr << "Unable to add sensor bundle [" << _topic
+          << "] without sensors." << std::endl;
+    return false;
+  }
+  if (this->dataPtr->bundles.count(_topic) > 0)
+  {
+    gzerr << "A sensor bundle already publishes on [" << _topic << "]."
+          << std::endl;
+    return false;
+  }
+
+  std::vector<gz::sensors::Sensor *> sensors;
+  for (const auto id : _sensors)
+  {
+    auto sensor = this->Sensor(id);
+    if (!sensor)
+    {
+      gzerr << "Unable to add sensor bundle [" << _topic
+            << "], there's no sensor with id [" << id << "]." << std::endl;
+      return false;
+    }
+    if (sensor->Bundle() ||
+        std::find(sensors.begin(), sensors.end(), sensor) != sensors.end())
+    {
+      gzerr << "Unable to add sensor bundle [" << _topic << "], sensor ["
+            << sensor->Name() << "] is already bundled." << std::endl;
+      return false;
+    }
+    sensors.push_back(sensor);
+  }
+
+  auto bundle = std::make_shared<SensorBundle>();
+  if (!bundle->Advertise(_topic))
+    return false;
+  bundle->SetPrimary(sensors.front()->Name());
+
+  auto &slot = this->dataPtr->bundles[_topic];
+  slot.bundle = bundle;
+  slot.sensors = _sensors;
+  for (auto sensor : sensors)
+  {
+    sensor->SetBundle(bundle);
+    if (!this->PhaseAligned(sensor->Id()))
+    {
+      this->SetPhaseAligned(sensor->Id(), true);
+      slot.pinned.push_back(sensor->Id());
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool Manager::RemoveBundle(const std::string &_topic)
+{
+  auto it = this->dataPtr->bundles.find(_topic);
+  if (it == this->dataPtr->bundles.end())
+    return false;
+
+  for (const auto id : it->second.sensors)
+  {
+    auto sensor = this->Sensor(id);
+    if (sensor && sensor->Bundle() == it->second.bundle)
+      sensor->SetBundle(nullptr);
+  }
+  for (const auto id : it->second.pinned)
+    this->SetPhaseAligned(id, false);
+  this->dataPtr->bundles.erase(it);
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorBundle> Manager::Bundle(
+    const std::string &_topic) const
+{
+  auto it = this->dataPtr->bundles.find(_topic);
+  return it == this->dataPtr->bundles.end() ? nullptr : it->second.bundle;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::vector<unsigned int>> Manager::WorkerAffinity() const
+{
+  return this->dataPtr->workerCpuSets;
+}
+
+//////////////////////////////////////////////////
+bool Manager::SetWorkerNumaNodes(const std::vector<unsigned int> &_nodes)
+{
+  std::vector<std::vector<unsigned int>> cpuSets;
+  for (const auto node : _nodes)
+  {
+    cpuSets.push_back(NumaNodeCpus(node));
+    if (cpuSets.back().empty())
+    {
+      gzerr << "No CPUs found for NUMA node [" << node << "]." << std::endl;
+      return false;
+    }
+  }
+  this->SetWorkerAffinity(cpuSets);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetRenderBatchCallback(RenderBatchCallback _callback)
+{
+  this->dataPtr->renderBatchCallback = std::move(_callback);
+  this->dataPtr->UpdateTriggerQueue();
+}
+
+//////////////////////////////////////////////////
+void Manager::SetRenderQueue(std::shared_ptr<RenderTaskQueue> _queue)
+{
+  this->dataPtr->renderQueue = std::move(_queue);
+  this->dataPtr->UpdateTriggerQueue();
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<RenderTaskQueue> Manager::RenderQueue() const
+{
+  return this->dataPtr->renderQueue;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetImmediateTrigger(bool _immediate)
+{
+  this->dataPtr->immediateTrigger = _immediate;
+  this->dataPtr->UpdateTriggerQueue();
+}
+
+//////////////////////////////////////////////////
+bool Manager::ImmediateTrigger() const
+{
+  return this->dataPtr->immediateTrigger;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetNoiseSeed(uint64_t _seed)
+{
+  this->dataPtr->noiseSeed = _seed;
+  this->dataPtr->hasNoiseSeed = true;
+  for (auto &slot : this->dataPtr->sensors)
+  {
+    if (slot.sensor)
+      slot.sensor->SetNoiseSeed(_seed);
+  }
+}
+
+//////////////////////////////////////////////////
+void Manager::SaveState(
+    std::unordered_map<SensorId, SensorState> &_states) const
+{
+  for (const auto &slot : this->dataPtr->sensors)
+  {
+    if (!slot.sensor)
+      continue;
+    SensorState &state = _states[slot.sensor->Id()];
+    state.Clear();
+    slot.sensor->SaveState(state);
+  }
+}
+
+//////////////////////////////////////////////////
+bool Manager::RestoreState(
+    std::unordered_map<SensorId, SensorState> &_states)
+{
+  bool result = true;
+  for (auto &[id, state] : _states)
+  {
+    gz::sensors::Sensor *sensor = this->Sensor(id);
+    if (!sensor)
+    {
+      gzerr << "Unable to restore the state of sensor [" << id
+            << "], it was removed." << std::endl;
+      result = false;
+      continue;
+    }
+    state.Rewind();
+    if (!sensor->RestoreState(state))
+    {
+      gzerr << "Unable to restore the state of sensor ["
+            << sensor->Name() << "]." << std::endl;
+      result = false;
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetAdvertiseDeferred(bool _deferred)
+{
+  this->dataPtr->advertiseDeferred = _deferred;
+}
+
+//////////////////////////////////////////////////
+bool Manager::AdvertiseDeferred() const
+{
+  return this->dataPtr->advertiseDeferred;
+}
+
+//////////////////////////////////////////////////
+bool Manager::AdvertisePending()
+{
+  bool result = true;
+  for (auto &slot : this->dataPtr->sensors)
+  {
+    if (slot.sensor && !slot.sensor->AdvertisePending())
+      result = false;
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetShard(unsigned int _index, unsigned int _count)
+{
+  if (_count == 0u || _index >= _count)
+  {
+    gzerr << "Invalid shard [" << _index << "] of [" << _count
+          << "] shards." << std::endl;
+    return;
+  }
+
+  this->dataPtr->shardIndex = _index;
+  this->dataPtr->shardCount = _count;
+  for (auto &slot : this->dataPtr->sensors)
+    slot.local = this->dataPtr->IsLocal(*slot.sensor);
+  this->dataPtr->RebuildSchedule();
+}
+
+//////////////////////////////////////////////////
+unsigned int Manager::ShardIndex() const
+{
+  return this->dataPtr->shardIndex;
+}
+
+//////////////////////////////////////////////////
+unsigned int Manager::ShardCount() const
+{
+  return this->dataPtr->shardCount;
+}
+
+//////////////////////////////////////////////////
+unsigned int Manager::ShardOf(const std::string &_sensorName,
+    unsigned int _count)
+{
+  if (_count == 0u)
+    return 0u;
+
+  // FNV-1a, which doesn't depend on the standard library implementation
+  uint64_t hash = 14695981039346656037ull;
+  for (const unsigned char c : _sensorName)
+  {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return static_cast<unsigned int>(hash % _count);
+}
+
+//////////////////////////////////////////////////
+void Manager::SetPhaseStagger(bool _stagger)
+{
+  this->dataPtr->phaseStagger = _stagger;
+  this->dataPtr->staggerPending = _stagger;
+  if (!_stagger)
+    this->dataPtr->staggered.clear();
+}
+
+//////////////////////////////////////////////////
+bool Manager::PhaseStagger() const
+{
+  return this->dataPtr->phaseStagger;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetPhaseAligned(SensorId _id, bool _aligned)
+{
+  if (_aligned)
+  {
+    this->dataPtr->phaseAligned.insert(_id);
+    return;
+  }
+  if (this->dataPtr->phaseAligned.erase(_id) > 0)
+  {
+    this->dataPtr->staggered.erase(_id);
+    this->dataPtr->staggerPending = this->dataPtr->phaseStagger;
+  }
+}
+
+//////////////////////////////////////////////////
+bool Manager::PhaseAligned(SensorId _id) const
+{
+  return this->dataPtr->phaseAligned.count(_id) > 0;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetUpdateBudget(double _budget)
+{
+  this->dataPtr->updateBudget = std::max(_budget, 0.0);
+  this->dataPtr->adaptStarted = false;
+  const bool enabled = this->dataPtr->updateBudget > 0.0;
+  for (auto &slot : this->dataPtr->sensors)
+  {
+    slot.sensor->SetMeasureUpdateCost(enabled);
+    if (!enabled)
+      slot.sensor->SetEffectiveUpdateRate(slot.sensor->UpdateRate());
+  }
+}
+
+//////////////////////////////////////////////////
+double Manager::UpdateBudget() const
+{
+  return this->dataPtr->updateBudget;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetTraceCapacity(std::size_t _events)
+{
+  TraceRecorder::Instance().SetCapacity(_events);
+}
+
+//////////////////////////////////////////////////
+std::size_t Manager::TraceCapacity() const
+{
+  return TraceRecorder::Instance().Capacity();
+}
+
+//////////////////////////////////////////////////
+bool Manager::DumpTrace(const std::string &_path) const
+{
+  return TraceRecorder::Instance().Dump(_path);
+}
+
+//////////////////////////////////////////////////
+void Manager::SetTraceOverrunDump(double _budget, const std::string &_path)
+{
+  this->dataPtr->traceOverrunBudget =
+      std::isfinite(_budget) ? std::max(_budget, 0.0) : 0.0;
+  this->dataPtr->traceOverrunPath = _path;
+  this->dataPtr->lastTraceDump = std::chrono::steady_clock::time_point();
+}
+
+//////////////////////////////////////////////////
+void Manager::SetStepBudget(double _budget)
+{
+  this->dataPtr->stepBudget =
+      std::isfinite(_budget) ? std::max(_budget, 0.0) : 0.0;
+  this->dataPtr->stepCosts.clear();
+  this->dataPtr->stepOverruns = 0u;
+  this->dataPtr->reportedStepOverruns = 0u;
+}
+
+//////////////////////////////////////////////////
+double Manager::StepBudget() const
+{
+  return this->dataPtr->stepBudget;
+}
+
+//////////////////////////////////////////////////
+void Manager::SetStepOverrunCallback(StepOverrunCallback _callback)
+{
+  this->dataPtr->stepOverrunCallback = std::move(_callback);
+}
+
+//////////////////////////////////////////////////
+uint64_t Manager::StepOverrunCount() const
+{
+  return this->dataPtr->stepOverruns;
+}
+
+//////////////////////////////////////////////////
+std::map<SensorId, std::size_t> Manager::MemoryUsage() const
+{
+  std::map<SensorId, std::size_t> usage;
+  for (const auto &slot : this->dataPtr->sensors)
+  {
+    std::size_t bytes = 0u;
+    for (const auto &entry : slot.sensor->MemoryUsage())
+      bytes += entry.second;
+    usage[slot.sensor->Id()] = bytes;
+  }
+  return usage;
+}
+
+//////////////////////////////////////////////////
+std::size_t Manager::TotalMemoryUsage() const
+{
+  std::size_t bytes = 0u;
+  for (const auto &entry : this->MemoryUsage())
+    bytes += entry.second;
+  return bytes;
 }
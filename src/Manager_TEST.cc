@@ -15,9 +15,25 @@
  *
 */
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include <gtest/gtest.h>
+#include <gz/common/Filesystem.hh>
+#include <gz/sensors/BatchSensor.hh>
 #include <gz/sensors/Manager.hh>
 
+#include "test_config.hh"  // NOLINT(build/include)
+
 /// \brief Test sensor manager
 class Manager_TEST : public ::testing::Test
 {
@@ -94,3 +110,1456 @@ TEST_F(Manager_TEST, RemoveSensor)
 
   EXPECT_TRUE(mgr.Remove(createdSensor->Id()));
 }
+
+//////////////////////////////////////////////////
+class CountingSensor : public gz::sensors::Sensor
+{
+  public: virtual bool Update(
+    const std::chrono::steady_clock::duration &) override
+  {
+    this->updateCount++;
+    return true;
+  }
+
+  public: std::atomic<unsigned int> updateCount{0};
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, WorkerThreads)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_TRUE(mgr.Init());
+  EXPECT_EQ(0u, mgr.WorkerThreadCount());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+
+  std::vector<CountingSensor *> sensors;
+  for (int i = 0; i < 50; ++i)
+  {
+    sdfSensor.SetTopic("/parallel/sensor" + std::to_string(i));
+    auto sensor = mgr.CreateSensor<CountingSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    sensors.push_back(sensor);
+  }
+
+  mgr.SetWorkerThreadCount(4u);
+  EXPECT_EQ(4u, mgr.WorkerThreadCount());
+
+  // Every sensor is updated exactly once per RunOnce
+  for (int i = 0; i < 10; ++i)
+    mgr.RunOnce(std::chrono::seconds(i));
+  for (auto sensor : sensors)
+    EXPECT_EQ(10u, sensor->updateCount);
+
+  // Back to sequential updates
+  mgr.SetWorkerThreadCount(0u);
+  EXPECT_EQ(0u, mgr.WorkerThreadCount());
+  mgr.RunOnce(std::chrono::seconds(10));
+  for (auto sensor : sensors)
+    EXPECT_EQ(11u, sensor->updateCount);
+}
+
+//////////////////////////////////////////////////
+class ThreadRecordingSensor : public CountingSensor
+{
+  public: virtual bool Update(
+    const std::chrono::steady_clock::duration &_now) override
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->threads.insert(std::this_thread::get_id());
+    return CountingSensor::Update(_now);
+  }
+
+  public: std::mutex mutex;
+
+  public: std::set<std::thread::id> threads;
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, WorkerAffinity)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_TRUE(mgr.Init());
+  EXPECT_TRUE(mgr.WorkerAffinity().empty());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+
+  std::vector<ThreadRecordingSensor *> sensors;
+  for (int i = 0; i < 20; ++i)
+  {
+    sdfSensor.SetTopic("/pinned/sensor" + std::to_string(i));
+    auto sensor = mgr.CreateSensor<ThreadRecordingSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    sensors.push_back(sensor);
+  }
+
+  // Two sets of two workers each, empty sets are dropped. Pinning may be
+  // refused by the system, which only warns.
+  mgr.SetWorkerThreadCount(4u);
+  mgr.SetWorkerAffinity({{0u}, {}, {0u}});
+  EXPECT_EQ(4u, mgr.WorkerThreadCount());
+  ASSERT_EQ(2u, mgr.WorkerAffinity().size());
+  EXPECT_EQ(std::vector<unsigned int>({0u}), mgr.WorkerAffinity()[1]);
+
+  for (int i = 0; i < 10; ++i)
+    mgr.RunOnce(std::chrono::seconds(i));
+
+  // Placed sensors are only updated by the workers
+  std::set<std::thread::id> workers;
+  for (auto sensor : sensors)
+  {
+    EXPECT_EQ(10u, sensor->updateCount);
+    EXPECT_EQ(0u, sensor->threads.count(std::this_thread::get_id()));
+    workers.insert(sensor->threads.begin(), sensor->threads.end());
+  }
+  EXPECT_LE(workers.size(), 4u);
+
+  // Removing sensors and changing the worker count places sensors again
+  EXPECT_TRUE(mgr.Remove(sensors.back()->Id()));
+  sensors.pop_back();
+  mgr.SetWorkerThreadCount(1u);
+  mgr.RunOnce(std::chrono::seconds(10));
+  for (auto sensor : sensors)
+    EXPECT_EQ(11u, sensor->updateCount);
+
+  // Unpinned workers are helped by the calling thread again
+  mgr.SetWorkerAffinity({});
+  EXPECT_TRUE(mgr.WorkerAffinity().empty());
+  EXPECT_EQ(1u, mgr.WorkerThreadCount());
+  mgr.RunOnce(std::chrono::seconds(11));
+  for (auto sensor : sensors)
+    EXPECT_EQ(12u, sensor->updateCount);
+
+  EXPECT_FALSE(mgr.SetWorkerNumaNodes({100000u}));
+  EXPECT_TRUE(mgr.WorkerAffinity().empty());
+}
+
+//////////////////////////////////////////////////
+class FakeRenderingSensor : public CountingSensor
+{
+  public: bool IsRenderingSensor() const override
+  {
+    return true;
+  }
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, RenderBatchCallback)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_TRUE(mgr.Init());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetTopic("/batch/plain");
+  auto plain = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, plain);
+  sdfSensor.SetTopic("/batch/rendering0");
+  auto rendering0 = mgr.CreateSensor<FakeRenderingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, rendering0);
+  sdfSensor.SetTopic("/batch/rendering1");
+  auto rendering1 = mgr.CreateSensor<FakeRenderingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, rendering1);
+
+  std::vector<gz::sensors::Sensor *> batch;
+  std::chrono::steady_clock::duration batchTime{0};
+  unsigned int updatesBefore = 0u;
+  mgr.SetRenderBatchCallback(
+      [&](const std::vector<gz::sensors::Sensor *> &_sensors,
+          const std::chrono::steady_clock::duration &_time)
+      {
+        batch = _sensors;
+        batchTime = _time;
+        updatesBefore = rendering0->updateCount + rendering1->updateCount;
+      });
+
+  // Only rendering sensors are passed, before any of them is updated
+  mgr.RunOnce(std::chrono::seconds(1));
+  ASSERT_EQ(2u, batch.size());
+  EXPECT_NE(batch.end(), std::find(batch.begin(), batch.end(), rendering0));
+  EXPECT_NE(batch.end(), std::find(batch.begin(), batch.end(), rendering1));
+  EXPECT_EQ(std::chrono::seconds(1), batchTime);
+  EXPECT_EQ(0u, updatesBefore);
+  EXPECT_EQ(1u, rendering0->updateCount);
+  EXPECT_EQ(1u, rendering1->updateCount);
+  EXPECT_EQ(1u, plain->updateCount);
+
+  // Disabled with an empty function
+  batch.clear();
+  mgr.SetRenderBatchCallback({});
+  mgr.RunOnce(std::chrono::seconds(2));
+  EXPECT_TRUE(batch.empty());
+  EXPECT_EQ(2u, rendering0->updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, RenderQueue)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_TRUE(mgr.Init());
+  EXPECT_EQ(nullptr, mgr.RenderQueue());
+
+  auto queue = std::make_shared<gz::sensors::RenderTaskQueue>();
+  mgr.SetRenderQueue(queue);
+  EXPECT_EQ(queue, mgr.RenderQueue());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetTopic("/queue/plain");
+  auto plain = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, plain);
+  sdfSensor.SetTopic("/queue/rendering0");
+  auto rendering0 = mgr.CreateSensor<FakeRenderingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, rendering0);
+  sdfSensor.SetTopic("/queue/rendering1");
+  auto rendering1 = mgr.CreateSensor<FakeRenderingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, rendering1);
+
+  std::vector<gz::sensors::Sensor *> batch;
+  mgr.SetRenderBatchCallback(
+      [&](const std::vector<gz::sensors::Sensor *> &_sensors,
+          const std::chrono::steady_clock::duration &)
+      {
+        batch = _sensors;
+      });
+
+  // Rendering sensors are updated by the render thread
+  mgr.RunOnce(std::chrono::seconds(1));
+  EXPECT_EQ(1u, plain->updateCount);
+  EXPECT_EQ(0u, rendering0->updateCount);
+  EXPECT_EQ(1u, queue->Size());
+  EXPECT_TRUE(batch.empty());
+
+  // Not queued again while they wait for the render thread
+  mgr.RunOnce(std::chrono::seconds(2));
+  EXPECT_EQ(2u, plain->updateCount);
+  EXPECT_EQ(1u, queue->Size());
+
+  EXPECT_EQ(1u, queue->RunPending());
+  EXPECT_EQ(2u, batch.size());
+  EXPECT_EQ(1u, rendering0->updateCount);
+  EXPECT_EQ(1u, rendering1->updateCount);
+
+  // Queued again once they're done
+  mgr.RunOnce(std::chrono::seconds(3));
+  EXPECT_EQ(1u, queue->Size());
+
+  // Removed sensors are skipped
+  EXPECT_TRUE(mgr.Remove(rendering1->Id()));
+  EXPECT_EQ(1u, queue->RunPending());
+  ASSERT_EQ(1u, batch.size());
+  EXPECT_EQ(rendering0, batch[0]);
+  EXPECT_EQ(2u, rendering0->updateCount);
+
+  // Render thread
+  std::atomic<bool> done{false};
+  std::thread renderThread([&]
+  {
+    while (!done)
+      queue->RunNext(std::chrono::milliseconds(10));
+  });
+  for (int i = 4; i < 100; ++i)
+    mgr.RunOnce(std::chrono::seconds(i));
+  EXPECT_TRUE(mgr.Remove(rendering0->Id()));
+  done = true;
+  renderThread.join();
+  EXPECT_EQ(99u, plain->updateCount);
+
+  // Updated by RunOnce again
+  mgr.SetRenderQueue(nullptr);
+  sdfSensor.SetTopic("/queue/rendering2");
+  auto rendering2 = mgr.CreateSensor<FakeRenderingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, rendering2);
+  mgr.RunOnce(std::chrono::seconds(100));
+  EXPECT_EQ(1u, rendering2->updateCount);
+}
+
+//////////////////////////////////////////////////
+/// \brief Sensor that adds another sensor from its first update.
+class SpawningSensor : public CountingSensor
+{
+  public: virtual bool Update(
+    const std::chrono::steady_clock::duration &_now) override
+  {
+    if (this->updateCount == 0u)
+    {
+      auto sensor = std::make_unique<CountingSensor>();
+      this->spawned = sensor.get();
+      this->spawnedId = this->manager->AddSensor(std::move(sensor));
+    }
+    return CountingSensor::Update(_now);
+  }
+
+  public: gz::sensors::Manager *manager{nullptr};
+
+  public: CountingSensor *spawned{nullptr};
+
+  public: gz::sensors::SensorId spawnedId{gz::sensors::NO_SENSOR};
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, AddSensorDuringStep)
+{
+  gz::sensors::Manager mgr;
+  auto spawner = std::make_unique<SpawningSensor>();
+  spawner->manager = &mgr;
+  auto spawning = spawner.get();
+  mgr.AddSensor(std::move(spawner));
+
+  // Staged until the next step, but already visible
+  mgr.RunOnce(std::chrono::seconds(1));
+  ASSERT_NE(nullptr, spawning->spawned);
+  EXPECT_EQ(spawning->spawned, mgr.Sensor(spawning->spawnedId));
+  EXPECT_EQ(2u, mgr.SensorIds().size());
+  EXPECT_EQ(0u, spawning->spawned->updateCount);
+
+  mgr.RunOnce(std::chrono::seconds(2));
+  EXPECT_EQ(1u, spawning->spawned->updateCount);
+  EXPECT_EQ(2u, spawning->updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, ConcurrentChurn)
+{
+  gz::sensors::Manager mgr;
+  mgr.SetWorkerThreadCount(2u);
+  std::vector<CountingSensor *> permanent;
+  for (int i = 0; i < 8; ++i)
+  {
+    auto sensor = std::make_unique<CountingSensor>();
+    permanent.push_back(sensor.get());
+    mgr.AddSensor(std::move(sensor));
+  }
+
+  // Sensors come and go while the steps run
+  std::atomic<bool> done{false};
+  std::vector<gz::sensors::SensorId> kept;
+  std::thread churn([&]()
+  {
+    for (int i = 0; i < 500; ++i)
+    {
+      const auto id = mgr.AddSensor(std::make_unique<CountingSensor>());
+      EXPECT_NE(nullptr, mgr.Sensor(id));
+      if (i % 5 == 0)
+        kept.push_back(id);
+      else
+        EXPECT_TRUE(mgr.Remove(id));
+    }
+    done = true;
+  });
+
+  int steps = 0;
+  while (!done)
+    mgr.RunOnce(std::chrono::milliseconds(++steps));
+  churn.join();
+  mgr.RunOnce(std::chrono::milliseconds(++steps));
+
+  for (auto sensor : permanent)
+    EXPECT_EQ(static_cast<unsigned int>(steps), sensor->updateCount);
+  auto ids = mgr.SensorIds();
+  EXPECT_EQ(permanent.size() + kept.size(), ids.size());
+  for (const auto id : kept)
+  {
+    EXPECT_NE(nullptr, mgr.Sensor(id));
+    EXPECT_TRUE(std::binary_search(ids.begin(), ids.end(), id));
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Rendering sensor that can be triggered.
+class FakeTriggeredSensor : public FakeRenderingSensor
+{
+  public: virtual bool Update(
+    const std::chrono::steady_clock::duration &_now) override
+  {
+    this->updateTime = _now;
+    return FakeRenderingSensor::Update(_now);
+  }
+
+  public: void Trigger()
+  {
+    this->NotifyTriggered();
+  }
+
+  public: std::chrono::steady_clock::duration updateTime{0};
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, ImmediateTrigger)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_FALSE(mgr.ImmediateTrigger());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetTopic("/trigger/camera0");
+  auto camera0 = mgr.CreateSensor<FakeTriggeredSensor>(sdfSensor);
+  ASSERT_NE(nullptr, camera0);
+  camera0->SetUpdateRate(1.0);
+  sdfSensor.SetTopic("/trigger/camera1");
+  auto camera1 = mgr.CreateSensor<FakeTriggeredSensor>(sdfSensor);
+  ASSERT_NE(nullptr, camera1);
+  camera1->SetUpdateRate(1.0);
+
+  // Nothing happens without a render queue, or until enabled
+  mgr.SetImmediateTrigger(true);
+  EXPECT_TRUE(mgr.ImmediateTrigger());
+  camera0->Trigger();
+  mgr.SetImmediateTrigger(false);
+  auto queue = std::make_shared<gz::sensors::RenderTaskQueue>();
+  mgr.SetRenderQueue(queue);
+  camera0->Trigger();
+  EXPECT_EQ(0u, queue->Size());
+
+  std::vector<gz::sensors::Sensor *> batch;
+  mgr.SetRenderBatchCallback(
+      [&](const std::vector<gz::sensors::Sensor *> &_sensors,
+          const std::chrono::steady_clock::duration &)
+      {
+        batch = _sensors;
+      });
+  mgr.SetImmediateTrigger(true);
+  mgr.RunOnce(std::chrono::seconds(1));
+  EXPECT_EQ(1u, queue->RunPending());
+  EXPECT_EQ(1u, camera0->updateCount);
+
+  // Triggers received before the render thread runs share one task, and
+  // render for the time of the last RunOnce, before the sensors are due
+  mgr.RunOnce(std::chrono::milliseconds(1500));
+  EXPECT_EQ(0u, queue->Size());
+  camera0->Trigger();
+  camera1->Trigger();
+  camera0->Trigger();
+  EXPECT_EQ(1u, queue->Size());
+  EXPECT_EQ(1u, queue->RunPending());
+  EXPECT_EQ(2u, batch.size());
+  EXPECT_EQ(2u, camera0->updateCount);
+  EXPECT_EQ(2u, camera1->updateCount);
+  EXPECT_EQ(std::chrono::milliseconds(1500), camera0->updateTime);
+
+  // Removed sensors are skipped
+  camera1->Trigger();
+  EXPECT_TRUE(mgr.Remove(camera1->Id()));
+  batch.clear();
+  EXPECT_EQ(1u, queue->RunPending());
+  EXPECT_TRUE(batch.empty());
+
+  // Disabled again
+  mgr.SetImmediateTrigger(false);
+  camera0->Trigger();
+  EXPECT_EQ(0u, queue->Size());
+}
+
+//////////////////////////////////////////////////
+/// \brief Sensor that only updates once triggered.
+class WaitingSensor : public CountingSensor
+{
+  public: WaitingSensor()
+  {
+    this->SetWaitForTrigger(true);
+  }
+
+  public: void Trigger()
+  {
+    this->NotifyTriggered();
+  }
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, WaitForTrigger)
+{
+  gz::sensors::Manager mgr;
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetTopic("/wait/camera");
+  auto camera = mgr.CreateSensor<WaitingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, camera);
+  EXPECT_TRUE(camera->WaitsForTrigger());
+  EXPECT_FALSE(camera->TriggerPending());
+  camera->SetUpdateRate(10.0);
+
+  // Never due until triggered
+  for (int i = 0; i < 10; ++i)
+    mgr.RunOnce(std::chrono::milliseconds(i * 100));
+  EXPECT_EQ(0u, camera->updateCount);
+  EXPECT_EQ(std::chrono::steady_clock::duration::max(), mgr.NextUpdateTime());
+
+  // A trigger makes it due once, within its rate
+  camera->Trigger();
+  EXPECT_TRUE(camera->TriggerPending());
+  mgr.RunOnce(std::chrono::milliseconds(1000));
+  EXPECT_EQ(1u, camera->updateCount);
+  EXPECT_FALSE(camera->TriggerPending());
+  mgr.RunOnce(std::chrono::milliseconds(1100));
+  EXPECT_EQ(1u, camera->updateCount);
+
+  camera->Trigger();
+  mgr.RunOnce(std::chrono::milliseconds(1150));
+  EXPECT_EQ(2u, camera->updateCount);
+
+  // Triggers faster than the rate wait for the next update time
+  camera->Trigger();
+  mgr.RunOnce(std::chrono::milliseconds(1175));
+  EXPECT_EQ(2u, camera->updateCount);
+  mgr.RunOnce(std::chrono::milliseconds(1200));
+  EXPECT_EQ(3u, camera->updateCount);
+
+  // Forced updates still reach it
+  mgr.RunOnce(std::chrono::milliseconds(1300), true);
+  EXPECT_EQ(4u, camera->updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, Shards)
+{
+  EXPECT_EQ(0u, gz::sensors::Manager::ShardOf("sensor", 0u));
+  EXPECT_EQ(0u, gz::sensors::Manager::ShardOf("sensor", 1u));
+  EXPECT_EQ(gz::sensors::Manager::ShardOf("sensor", 3u),
+      gz::sensors::Manager::ShardOf("sensor", 3u));
+
+  gz::sensors::Manager mgr;
+  EXPECT_EQ(0u, mgr.ShardIndex());
+  EXPECT_EQ(1u, mgr.ShardCount());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  std::vector<CountingSensor *> sensors;
+  for (int i = 0; i < 20; ++i)
+  {
+    sdfSensor.SetName("sensor" + std::to_string(i));
+    sdfSensor.SetTopic("/shards/sensor" + std::to_string(i));
+    auto sensor = mgr.CreateSensor<CountingSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    sensors.push_back(sensor);
+  }
+  EXPECT_EQ(20u, mgr.SensorIds().size());
+  EXPECT_TRUE(std::is_sorted(mgr.SensorIds().begin(),
+      mgr.SensorIds().end()));
+
+  // Invalid shards are ignored
+  mgr.SetShard(2u, 2u);
+  EXPECT_EQ(1u, mgr.ShardCount());
+
+  // Only the sensors of the shard are updated, forced or not
+  mgr.SetShard(1u, 2u);
+  EXPECT_EQ(1u, mgr.ShardIndex());
+  EXPECT_EQ(2u, mgr.ShardCount());
+  mgr.RunOnce(std::chrono::seconds(1));
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  unsigned int local = 0u;
+  for (auto *sensor : sensors)
+  {
+    const bool inShard =
+        gz::sensors::Manager::ShardOf(sensor->Name(), 2u) == 1u;
+    EXPECT_EQ(inShard ? 2u : 0u, sensor->updateCount) << sensor->Name();
+    local += inShard ? 1u : 0u;
+  }
+  EXPECT_GT(local, 0u);
+  EXPECT_LT(local, 20u);
+
+  // Back to a single shard
+  mgr.SetShard(0u, 1u);
+  mgr.RunOnce(std::chrono::seconds(3));
+  for (auto *sensor : sensors)
+    EXPECT_GE(sensor->updateCount, 1u);
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, Schedule)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_TRUE(mgr.Init());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+
+  sdfSensor.SetTopic("/schedule/fast");
+  auto fast = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, fast);
+  fast->SetUpdateRate(10.0);
+
+  sdfSensor.SetTopic("/schedule/slow");
+  auto slow = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, slow);
+  slow->SetUpdateRate(1.0);
+
+  sdfSensor.SetTopic("/schedule/always");
+  auto always = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, always);
+
+  // Step for 2 seconds at 100 Hz
+  for (int i = 0; i < 200; ++i)
+    mgr.RunOnce(std::chrono::milliseconds(i * 10));
+
+  EXPECT_EQ(20u, fast->updateCount);
+  EXPECT_EQ(2u, slow->updateCount);
+  EXPECT_EQ(200u, always->updateCount);
+
+  // Pulling the next update time in re-keys the sensor
+  slow->SetNextDataUpdateTime(std::chrono::milliseconds(2000));
+  mgr.RunOnce(std::chrono::milliseconds(2000));
+  EXPECT_EQ(3u, slow->updateCount);
+
+  // Removed sensors are not updated anymore
+  EXPECT_TRUE(mgr.Remove(fast->Id()));
+  mgr.RunOnce(std::chrono::milliseconds(5000));
+  EXPECT_EQ(4u, slow->updateCount);
+  EXPECT_EQ(202u, always->updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, PhaseStagger)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_FALSE(mgr.PhaseStagger());
+  mgr.SetPhaseStagger(true);
+  EXPECT_TRUE(mgr.PhaseStagger());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+
+  std::vector<CountingSensor *> spread;
+  for (int i = 0; i < 4; ++i)
+  {
+    sdfSensor.SetTopic("/stagger/camera" + std::to_string(i));
+    auto sensor = mgr.CreateSensor<CountingSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    sensor->SetUpdateRate(10.0);
+    spread.push_back(sensor);
+  }
+
+  sdfSensor.SetTopic("/stagger/pinned");
+  auto pinned = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, pinned);
+  pinned->SetUpdateRate(10.0);
+  mgr.SetPhaseAligned(pinned->Id(), true);
+  EXPECT_TRUE(mgr.PhaseAligned(pinned->Id()));
+  EXPECT_FALSE(mgr.PhaseAligned(spread[0]->Id()));
+
+  auto total = [&]()
+  {
+    unsigned int count = 0u;
+    for (auto sensor : spread)
+      count += sensor->updateCount;
+    return count;
+  };
+
+  // Step for 1 second at 40 Hz, one staggered sensor updates per step and
+  // the pinned one on every 100 ms
+  unsigned int previous = 0u;
+  for (int i = 0; i < 40; ++i)
+  {
+    mgr.RunOnce(std::chrono::milliseconds(i * 25));
+    EXPECT_EQ(previous + 1u, total()) << i;
+    previous = total();
+    EXPECT_EQ(static_cast<unsigned int>(i / 4 + 1), pinned->updateCount);
+  }
+  for (auto sensor : spread)
+    EXPECT_EQ(10u, sensor->updateCount);
+  EXPECT_EQ(std::chrono::milliseconds(1000), pinned->NextDataUpdateTime());
+  EXPECT_EQ(std::chrono::milliseconds(1075), spread[3]->NextDataUpdateTime());
+
+  // A sensor added later goes in the middle of a gap
+  sdfSensor.SetTopic("/stagger/late");
+  auto late = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, late);
+  late->SetUpdateRate(10.0);
+  mgr.RunOnce(std::chrono::milliseconds(1000));
+  EXPECT_EQ(0u, late->updateCount);
+  auto phase = (late->NextDataUpdateTime() - std::chrono::milliseconds(1000))
+      % std::chrono::milliseconds(25);
+  EXPECT_EQ(std::chrono::milliseconds(12) + std::chrono::microseconds(500),
+      phase);
+}
+
+//////////////////////////////////////////////////
+/// \brief Sensor that takes a fixed wall-clock time to update.
+class SlowSensor : public CountingSensor
+{
+  public: virtual bool Update(
+    const std::chrono::steady_clock::duration &_now) override
+  {
+    std::this_thread::sleep_for(this->cost);
+    return CountingSensor::Update(_now);
+  }
+
+  public: std::chrono::milliseconds cost{1};
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, UpdateBudget)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_DOUBLE_EQ(0.0, mgr.UpdateBudget());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetTopic("/budget/critical");
+  auto critical = mgr.CreateSensor<SlowSensor>(sdfSensor);
+  ASSERT_NE(nullptr, critical);
+  critical->SetUpdateRate(100.0);
+  sdfSensor.SetTopic("/budget/heavy");
+  auto heavy = mgr.CreateSensor<SlowSensor>(sdfSensor);
+  ASSERT_NE(nullptr, heavy);
+  heavy->SetUpdateRate(100.0);
+  heavy->SetMinUpdateRate(10.0);
+  heavy->cost = std::chrono::milliseconds(2);
+
+  // The sensors take at least 0.3 s per simulated second
+  mgr.SetUpdateBudget(0.15);
+  EXPECT_DOUBLE_EQ(0.15, mgr.UpdateBudget());
+  int step = 0;
+  for (; step < 300; ++step)
+    mgr.RunOnce(std::chrono::milliseconds(step * 10));
+  EXPECT_LT(0, heavy->UpdateCost().count());
+  EXPECT_DOUBLE_EQ(100.0, critical->EffectiveUpdateRate());
+  EXPECT_GT(100.0, heavy->EffectiveUpdateRate());
+  EXPECT_LE(10.0, heavy->EffectiveUpdateRate());
+  EXPECT_DOUBLE_EQ(100.0, heavy->UpdateRate());
+
+  // Raised back once there's room
+  mgr.SetUpdateBudget(10.0);
+  for (const int end = step + 300; step < end; ++step)
+    mgr.RunOnce(std::chrono::milliseconds(step * 10));
+  EXPECT_DOUBLE_EQ(100.0, heavy->EffectiveUpdateRate());
+
+  // Disabling the budget restores the rates
+  mgr.SetUpdateBudget(0.15);
+  for (const int end = step + 300; step < end; ++step)
+    mgr.RunOnce(std::chrono::milliseconds(step * 10));
+  EXPECT_GT(100.0, heavy->EffectiveUpdateRate());
+  mgr.SetUpdateBudget(0.0);
+  EXPECT_DOUBLE_EQ(100.0, heavy->EffectiveUpdateRate());
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, Trace)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_EQ(0u, mgr.TraceCapacity());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetName("traced");
+  sdfSensor.SetTopic("/trace/slow");
+  auto slow = mgr.CreateSensor<SlowSensor>(sdfSensor);
+  ASSERT_NE(nullptr, slow);
+  slow->SetUpdateRate(100.0);
+  slow->cost = std::chrono::milliseconds(5);
+
+  mgr.SetTraceCapacity(64u);
+  EXPECT_EQ(64u, mgr.TraceCapacity());
+
+  // A step over the budget writes the trace
+  const std::string path = gz::common::joinPaths(::testing::TempDir(),
+      "manager_trace_test.json");
+  gz::common::removeFile(path);
+  mgr.SetTraceOverrunDump(0.001, path);
+  mgr.RunOnce(std::chrono::milliseconds(10));
+  ASSERT_TRUE(gz::common::exists(path));
+
+  std::ifstream file(path);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  const std::string json = contents.str();
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"traced\""));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"Manager\""));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"update\""));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"schedule\""));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"step\""));
+  gz::common::removeFile(path);
+
+  EXPECT_TRUE(mgr.DumpTrace(path));
+  EXPECT_TRUE(gz::common::exists(path));
+  gz::common::removeFile(path);
+
+  mgr.SetTraceOverrunDump(0.0, path);
+  mgr.SetTraceCapacity(0u);
+  EXPECT_EQ(0u, mgr.TraceCapacity());
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, StepBudget)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_DOUBLE_EQ(0.0, mgr.StepBudget());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetName("slow");
+  auto slow = mgr.CreateSensor<SlowSensor>(sdfSensor);
+  ASSERT_NE(nullptr, slow);
+  slow->cost = std::chrono::milliseconds(5);
+  sdfSensor.SetName("fast");
+  auto fast = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, fast);
+
+  std::vector<gz::sensors::ManagerStepOverrun> reports;
+  mgr.SetStepOverrunCallback(
+      [&reports](const gz::sensors::ManagerStepOverrun &_report)
+      {
+        reports.push_back(_report);
+      });
+
+  // Nothing is watched without a budget
+  mgr.RunOnce(std::chrono::milliseconds(10), true);
+  EXPECT_EQ(0u, mgr.StepOverrunCount());
+  EXPECT_TRUE(reports.empty());
+
+  mgr.SetStepBudget(0.001);
+  EXPECT_DOUBLE_EQ(0.001, mgr.StepBudget());
+  mgr.RunOnce(std::chrono::milliseconds(20), true);
+  EXPECT_EQ(1u, mgr.StepOverrunCount());
+  ASSERT_EQ(1u, reports.size());
+  EXPECT_EQ(std::chrono::milliseconds(20), reports[0].time);
+  EXPECT_EQ(std::chrono::milliseconds(1), reports[0].budget);
+  EXPECT_LE(std::chrono::milliseconds(5), reports[0].duration);
+  EXPECT_EQ(1u, reports[0].overruns);
+  ASSERT_EQ(2u, reports[0].sensors.size());
+  EXPECT_EQ(slow->Id(), reports[0].sensors[0].id);
+  EXPECT_EQ("slow", reports[0].sensors[0].name);
+  EXPECT_LE(std::chrono::milliseconds(5), reports[0].sensors[0].cost);
+  EXPECT_EQ(fast->Id(), reports[0].sensors[1].id);
+
+  // Overruns within a second are counted, not reported
+  mgr.RunOnce(std::chrono::milliseconds(30), true);
+  EXPECT_EQ(2u, mgr.StepOverrunCount());
+  EXPECT_EQ(1u, reports.size());
+
+  // A step within the budget isn't an overrun
+  mgr.SetStepBudget(10.0);
+  mgr.RunOnce(std::chrono::milliseconds(40), true);
+  EXPECT_EQ(0u, mgr.StepOverrunCount());
+  EXPECT_EQ(1u, reports.size());
+
+  mgr.SetStepBudget(-1.0);
+  EXPECT_DOUBLE_EQ(0.0, mgr.StepBudget());
+}
+
+//////////////////////////////////////////////////
+/// \brief Sensor that reports fixed buffer sizes.
+class MemorySensor : public CountingSensor
+{
+  public: gz::sensors::SensorMemoryUsage MemoryUsage() const override
+  {
+    return {{"image", 1000u}, {"point_msg", 24u}};
+  }
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, MemoryUsage)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_TRUE(mgr.MemoryUsage().empty());
+  EXPECT_EQ(0u, mgr.TotalMemoryUsage());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetName("memory");
+  auto memory = mgr.CreateSensor<MemorySensor>(sdfSensor);
+  ASSERT_NE(nullptr, memory);
+  sdfSensor.SetName("counting");
+  auto counting = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, counting);
+
+  auto usage = mgr.MemoryUsage();
+  ASSERT_EQ(2u, usage.size());
+  EXPECT_EQ(1024u, usage[memory->Id()]);
+  EXPECT_EQ(0u, usage[counting->Id()]);
+  EXPECT_EQ(1024u, mgr.TotalMemoryUsage());
+}
+
+//////////////////////////////////////////////////
+/// \brief Sensor that records the order in which sensors are updated.
+class OrderSensor : public gz::sensors::Sensor
+{
+  public: virtual bool Update(
+    const std::chrono::steady_clock::duration &) override
+  {
+    this->order->push_back(this->Id());
+    return true;
+  }
+
+  public: std::vector<gz::sensors::SensorId> *order{nullptr};
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, Priority)
+{
+  gz::sensors::Manager mgr;
+  std::vector<gz::sensors::SensorId> order;
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  std::vector<OrderSensor *> sensors;
+  const gz::sensors::SensorPriority priorities[] = {
+    gz::sensors::SensorPriority::PERCEPTION,
+    gz::sensors::SensorPriority::NORMAL,
+    gz::sensors::SensorPriority::CONTROL,
+    gz::sensors::SensorPriority::NORMAL};
+  for (auto priority : priorities)
+  {
+    sdfSensor.SetTopic("/priority/" + std::to_string(sensors.size()));
+    auto sensor = mgr.CreateSensor<OrderSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    EXPECT_EQ(gz::sensors::SensorPriority::NORMAL, sensor->Priority());
+    sensor->SetPriority(priority);
+    EXPECT_EQ(priority, sensor->Priority());
+    sensor->order = &order;
+    sensors.push_back(sensor);
+  }
+
+  // Control sensors first, then by id within a class
+  const std::vector<gz::sensors::SensorId> expected = {
+    sensors[2]->Id(), sensors[1]->Id(), sensors[3]->Id(), sensors[0]->Id()};
+  mgr.RunOnce(std::chrono::seconds(1));
+  EXPECT_EQ(expected, order);
+
+  order.clear();
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  EXPECT_EQ(expected, order);
+
+  // Same order when grouped
+  order.clear();
+  mgr.SetGroupedUpdate(true);
+  mgr.RunOnce(std::chrono::seconds(3));
+  ASSERT_EQ(expected.size(), order.size());
+  EXPECT_EQ(sensors[2]->Id(), order.front());
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, RenderingControlSensor)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_TRUE(mgr.Init());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetTopic("/control/rendering");
+  auto rendering = mgr.CreateSensor<FakeRenderingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, rendering);
+  rendering->SetPriority(gz::sensors::SensorPriority::CONTROL);
+  sdfSensor.SetTopic("/control/plain");
+  auto plain = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, plain);
+  plain->SetPriority(gz::sensors::SensorPriority::CONTROL);
+
+  std::vector<gz::sensors::Sensor *> batch;
+  unsigned int plainBefore = 0u;
+  mgr.SetRenderBatchCallback(
+      [&](const std::vector<gz::sensors::Sensor *> &_sensors,
+          const std::chrono::steady_clock::duration &)
+      {
+        batch = _sensors;
+        plainBefore = plain->updateCount;
+      });
+
+  // The rendering sensor doesn't take the control fast path, the other
+  // control sensor is updated before the render batch
+  mgr.RunOnce(std::chrono::seconds(1));
+  ASSERT_EQ(1u, batch.size());
+  EXPECT_EQ(rendering, batch[0]);
+  EXPECT_EQ(1u, plainBefore);
+  EXPECT_EQ(1u, rendering->updateCount);
+  EXPECT_EQ(1u, plain->updateCount);
+
+  // Same when grouped
+  batch.clear();
+  mgr.SetGroupedUpdate(true);
+  mgr.RunOnce(std::chrono::seconds(2));
+  ASSERT_EQ(1u, batch.size());
+  EXPECT_EQ(rendering, batch[0]);
+  EXPECT_EQ(2u, rendering->updateCount);
+  EXPECT_EQ(2u, plain->updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, NextUpdateTime)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_EQ(std::chrono::steady_clock::duration::max(), mgr.NextUpdateTime());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+
+  sdfSensor.SetTopic("/next_update/a");
+  auto a = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, a);
+  a->SetUpdateRate(2.0);
+
+  sdfSensor.SetTopic("/next_update/b");
+  auto b = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, b);
+  b->SetUpdateRate(4.0);
+
+  // Both are due right away
+  EXPECT_EQ(std::chrono::steady_clock::duration::zero(), mgr.NextUpdateTime());
+
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero());
+  EXPECT_EQ(std::chrono::milliseconds(250), mgr.NextUpdateTime());
+
+  // Inactive sensors are never due
+  b->SetActive(false);
+  EXPECT_EQ(std::chrono::milliseconds(500), mgr.NextUpdateTime());
+
+  a->SetActive(false);
+  EXPECT_EQ(std::chrono::steady_clock::duration::max(), mgr.NextUpdateTime());
+
+  // Sensors with zero rate are always due
+  a->SetActive(true);
+  a->SetUpdateRate(0.0);
+  EXPECT_EQ(std::chrono::steady_clock::duration::min(), mgr.NextUpdateTime());
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, RemoveKeepsLookup)
+{
+  gz::sensors::Manager mgr;
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+
+  std::vector<gz::sensors::SensorId> ids;
+  for (int i = 0; i < 5; ++i)
+  {
+    sdfSensor.SetTopic("/remove_lookup/sensor" + std::to_string(i));
+    auto sensor = mgr.CreateSensor<CountingSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    ids.push_back(sensor->Id());
+  }
+
+  // Remove from the middle and from the front
+  EXPECT_TRUE(mgr.Remove(ids[2]));
+  EXPECT_FALSE(mgr.Remove(ids[2]));
+  EXPECT_TRUE(mgr.Remove(ids[0]));
+
+  for (std::size_t i = 0; i < ids.size(); ++i)
+  {
+    auto sensor = mgr.Sensor(ids[i]);
+    if (i == 0 || i == 2)
+    {
+      EXPECT_EQ(nullptr, sensor);
+    }
+    else
+    {
+      ASSERT_NE(nullptr, sensor);
+      EXPECT_EQ(ids[i], sensor->Id());
+    }
+  }
+
+  // Remaining sensors keep updating
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero());
+  for (auto i : {1u, 3u, 4u})
+  {
+    auto sensor = dynamic_cast<CountingSensor *>(mgr.Sensor(ids[i]));
+    ASSERT_NE(nullptr, sensor);
+    EXPECT_EQ(1u, sensor->updateCount);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Sensor that records the size of the batches it's updated in.
+class BatchCountingSensor
+  : public gz::sensors::BatchSensor<BatchCountingSensor>
+{
+  protected: void UpdateSensors(
+    const std::vector<BatchCountingSensor *> &_sensors,
+    const std::chrono::steady_clock::duration &) override
+  {
+    if (this->batchSizes)
+      this->batchSizes->push_back(_sensors.size());
+    for (auto *s : _sensors)
+      ++s->updateCount;
+  }
+
+  public: unsigned int updateCount{0u};
+
+  public: std::vector<std::size_t> *batchSizes{nullptr};
+};
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, BatchSensors)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_FALSE(mgr.GroupedUpdate());
+  std::vector<std::size_t> batchSizes;
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  std::vector<BatchCountingSensor *> batchSensors;
+  std::vector<CountingSensor *> sensors;
+  for (int i = 0; i < 20; ++i)
+  {
+    sdfSensor.SetTopic("/batch/sensor" + std::to_string(i));
+    auto sensor = mgr.CreateSensor<BatchCountingSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    EXPECT_TRUE(sensor->HasBatchUpdate());
+    sensor->batchSizes = &batchSizes;
+    batchSensors.push_back(sensor);
+
+    if (i % 5 == 0)
+    {
+      sdfSensor.SetTopic("/batch/other" + std::to_string(i));
+      auto other = mgr.CreateSensor<CountingSensor>(sdfSensor);
+      ASSERT_NE(nullptr, other);
+      EXPECT_FALSE(other->HasBatchUpdate());
+      sensors.push_back(other);
+    }
+  }
+
+  // One call updates all the batch sensors, with or without workers
+  mgr.RunOnce(std::chrono::seconds(1));
+  EXPECT_EQ(std::vector<std::size_t>{20u}, batchSizes);
+  mgr.SetWorkerThreadCount(2u);
+  mgr.RunOnce(std::chrono::seconds(2));
+  EXPECT_EQ(std::vector<std::size_t>({20u, 20u}), batchSizes);
+  mgr.SetWorkerThreadCount(0u);
+
+  // Forced updates are individual
+  batchSizes.clear();
+  mgr.RunOnce(std::chrono::seconds(3), true);
+  EXPECT_EQ(std::vector<std::size_t>(20u, 1u), batchSizes);
+
+  // Control sensors are batched apart
+  batchSizes.clear();
+  batchSensors[7]->SetPriority(gz::sensors::SensorPriority::CONTROL);
+  mgr.RunOnce(std::chrono::seconds(4));
+  EXPECT_EQ(std::vector<std::size_t>({1u, 19u}), batchSizes);
+
+  for (auto sensor : batchSensors)
+    EXPECT_EQ(4u, sensor->updateCount);
+  for (auto sensor : sensors)
+    EXPECT_EQ(4u, sensor->updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, CustomTypes)
+{
+  auto sdfFile = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "custom_sensors.sdf");
+  sdf::Root root;
+  ASSERT_TRUE(root.Load(sdfFile).empty());
+  auto link = root.WorldByIndex(0)->ModelByIndex(0)->LinkByIndex(0);
+  ASSERT_NE(nullptr, link);
+  const sdf::Sensor *complete = link->SensorByName("complete");
+  const sdf::Sensor *missing = link->SensorByName("missing_gz_type");
+  ASSERT_NE(nullptr, complete);
+  ASSERT_NE(nullptr, missing);
+
+  using gz::sensors::SensorFactory;
+  EXPECT_FALSE(SensorFactory::HasCustomType("sensor_type"));
+  gz::sensors::Manager mgr;
+  EXPECT_EQ(nullptr, mgr.CreateCustomSensor(*complete));
+
+  EXPECT_TRUE(
+      SensorFactory::RegisterCustomType<BatchCountingSensor>("sensor_type"));
+  EXPECT_TRUE(SensorFactory::HasCustomType("sensor_type"));
+  EXPECT_FALSE(
+      SensorFactory::RegisterCustomType<CountingSensor>("sensor_type"));
+  EXPECT_FALSE(SensorFactory::RegisterCustomType<CountingSensor>(""));
+
+  // Sensors are created from DOM objects and elements
+  auto sensor = mgr.CreateCustomSensor(*complete);
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_EQ("complete", sensor->Name());
+  EXPECT_NE(nullptr, dynamic_cast<BatchCountingSensor *>(sensor));
+  EXPECT_TRUE(sensor->HasBatchUpdate());
+  SensorFactory factory;
+  auto fromElement = factory.CreateCustomSensor(complete->Element());
+  ASSERT_NE(nullptr, fromElement);
+  EXPECT_EQ("complete", fromElement->Name());
+  EXPECT_EQ(nullptr, factory.CreateCustomSensor(*missing));
+  EXPECT_EQ(nullptr, factory.CreateCustomSensor(sdf::ElementPtr()));
+
+  mgr.RunOnce(std::chrono::seconds(1));
+  EXPECT_EQ(1u, static_cast<BatchCountingSensor *>(sensor)->updateCount);
+
+  EXPECT_TRUE(SensorFactory::UnregisterCustomType("sensor_type"));
+  EXPECT_FALSE(SensorFactory::UnregisterCustomType("sensor_type"));
+  EXPECT_FALSE(SensorFactory::HasCustomType("sensor_type"));
+  EXPECT_EQ(nullptr, factory.CreateCustomSensor(*complete));
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, CreateSensorsInParallel)
+{
+  gz::sensors::Manager mgr;
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+
+  std::vector<sdf::Sensor> sdfSensors;
+  for (int i = 0; i < 50; ++i)
+  {
+    sdfSensor.SetTopic("/create_parallel/sensor" + std::to_string(i));
+    sdfSensors.push_back(sdfSensor);
+  }
+
+  auto sensors = mgr.CreateSensors<CountingSensor>(sdfSensors, 4u);
+  ASSERT_EQ(sdfSensors.size(), sensors.size());
+
+  // Sensors are returned in order, with unique ids
+  std::vector<gz::sensors::SensorId> ids;
+  for (std::size_t i = 0; i < sensors.size(); ++i)
+  {
+    ASSERT_NE(nullptr, sensors[i]);
+    EXPECT_EQ(sdfSensors[i].Topic(), sensors[i]->Topic());
+    EXPECT_EQ(sensors[i], mgr.Sensor(sensors[i]->Id()));
+    ids.push_back(sensors[i]->Id());
+  }
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(ids.end(), std::adjacent_find(ids.begin(), ids.end()));
+
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero());
+  for (auto sensor : sensors)
+    EXPECT_EQ(1u, sensor->updateCount);
+
+  // Failures are null
+  std::vector<sdf::ElementPtr> invalid{nullptr, nullptr};
+  auto failed = mgr.CreateSensors<CountingSensor>(invalid);
+  ASSERT_EQ(2u, failed.size());
+  EXPECT_EQ(nullptr, failed[0]);
+  EXPECT_EQ(nullptr, failed[1]);
+
+  // A single sensor on its own thread
+  gz::sensors::SensorFactory factory;
+  auto future = factory.CreateSensorAsync<CountingSensor>(sdfSensor);
+  auto sensor = future.get();
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_EQ(sdfSensor.Topic(), sensor->Topic());
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, AdvertiseDeferred)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_FALSE(mgr.AdvertiseDeferred());
+  mgr.SetAdvertiseDeferred(true);
+  EXPECT_TRUE(mgr.AdvertiseDeferred());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+
+  std::vector<CountingSensor *> sensors;
+  for (int i = 0; i < 3; ++i)
+  {
+    sdfSensor.SetTopic("/advertise_deferred/sensor" + std::to_string(i));
+    auto sensor = mgr.CreateSensor<CountingSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    EXPECT_TRUE(sensor->AdvertiseDeferred());
+    EXPECT_EQ(1u, sensor->PendingAdvertisementCount());
+    sensors.push_back(sensor);
+  }
+
+  EXPECT_TRUE(mgr.AdvertisePending());
+  for (auto sensor : sensors)
+  {
+    EXPECT_FALSE(sensor->AdvertiseDeferred());
+    EXPECT_EQ(0u, sensor->PendingAdvertisementCount());
+  }
+
+  mgr.SetAdvertiseDeferred(false);
+  sdfSensor.SetTopic("/advertise_deferred/sensor3");
+  auto sensor = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_EQ(0u, sensor->PendingAdvertisementCount());
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, CreateSensorsFromPrototype)
+{
+  gz::sensors::Manager mgr;
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetUpdateRate(10.0);
+  gz::sensors::SensorPrototype prototype(sdfSensor);
+
+  std::vector<gz::sensors::SensorInstance> instances;
+  for (int i = 0; i < 20; ++i)
+  {
+    const std::string robot = "robot_" + std::to_string(i);
+    instances.push_back({"counter", "/" + robot + "/counter",
+        robot + "::link"});
+  }
+
+  auto sensors = mgr.CreateSensors<CountingSensor>(prototype, instances);
+  ASSERT_EQ(instances.size(), sensors.size());
+  for (std::size_t i = 0; i < sensors.size(); ++i)
+  {
+    ASSERT_NE(nullptr, sensors[i]);
+    EXPECT_EQ("counter", sensors[i]->Name());
+    EXPECT_EQ(instances[i].topic, sensors[i]->Topic());
+    EXPECT_EQ(instances[i].parent, sensors[i]->Parent());
+    EXPECT_DOUBLE_EQ(10.0, sensors[i]->UpdateRate());
+  }
+
+  // Invalid prototypes create no sensor
+  gz::sensors::SensorPrototype invalid;
+  auto failed = mgr.CreateSensors<CountingSensor>(invalid, instances);
+  ASSERT_EQ(instances.size(), failed.size());
+  EXPECT_EQ(nullptr, failed[0]);
+
+  gz::sensors::SensorFactory factory;
+  auto single = factory.CreateSensor<CountingSensor>(prototype,
+      {"single", "/single/counter", "single::link"});
+  ASSERT_NE(nullptr, single);
+  EXPECT_EQ("single", single->Name());
+  EXPECT_EQ("single::link", single->Parent());
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, SaveState)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_TRUE(mgr.Init());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetTopic("/state/fast");
+  auto fast = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, fast);
+  fast->SetUpdateRate(10.0);
+
+  for (int i = 0; i < 100; ++i)
+    mgr.RunOnce(std::chrono::milliseconds(i * 10));
+  EXPECT_EQ(10u, fast->updateCount);
+
+  std::unordered_map<gz::sensors::SensorId, gz::sensors::SensorState> states;
+  mgr.SaveState(states);
+  ASSERT_EQ(1u, states.count(fast->Id()));
+
+  for (int i = 100; i < 200; ++i)
+    mgr.RunOnce(std::chrono::milliseconds(i * 10));
+  EXPECT_EQ(20u, fast->updateCount);
+
+  // After a restore, the same steps give the same updates
+  EXPECT_TRUE(mgr.RestoreState(states));
+  for (int i = 100; i < 200; ++i)
+    mgr.RunOnce(std::chrono::milliseconds(i * 10));
+  EXPECT_EQ(30u, fast->updateCount);
+
+  // States can be restored again, and saved into the same map
+  EXPECT_TRUE(mgr.RestoreState(states));
+  mgr.SaveState(states);
+  EXPECT_EQ(1u, states.size());
+
+  // Removed sensors can't be restored
+  EXPECT_TRUE(mgr.Remove(fast->Id()));
+  EXPECT_FALSE(mgr.RestoreState(states));
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, Recorder)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_EQ(nullptr, mgr.Recorder());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  auto before = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, before);
+  EXPECT_EQ(nullptr, before->Recorder());
+
+  // Given to the existing sensors and the ones added later
+  auto recorder = std::make_shared<gz::sensors::SensorRecorder>();
+  mgr.SetRecorder(recorder);
+  EXPECT_EQ(recorder, mgr.Recorder());
+  EXPECT_EQ(recorder, before->Recorder());
+  auto after = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, after);
+  EXPECT_EQ(recorder, after->Recorder());
+
+  mgr.SetRecorder(nullptr);
+  EXPECT_EQ(nullptr, before->Recorder());
+  EXPECT_EQ(nullptr, after->Recorder());
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, Replay)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_EQ(nullptr, mgr.Replay());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetName("replayed");
+  auto byName = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  sdfSensor.SetName("computed");
+  auto other = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, byName);
+  ASSERT_NE(nullptr, other);
+
+  // Selected by name, then by type for the ones added later
+  auto replay = std::make_shared<gz::sensors::SensorReplay>();
+  mgr.SetReplay(replay, {"replayed"});
+  EXPECT_EQ(replay, mgr.Replay());
+  EXPECT_EQ(replay, byName->Replay());
+  EXPECT_EQ(nullptr, other->Replay());
+
+  mgr.SetReplay(replay, {"custom"});
+  sdfSensor.SetName("later");
+  auto later = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, later);
+  EXPECT_EQ(replay, other->Replay());
+  EXPECT_EQ(replay, later->Replay());
+
+  // Replayed sensors are scheduled but not computed
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_EQ(0u, byName->updateCount);
+  EXPECT_EQ(0u, later->updateCount);
+
+  mgr.SetReplay(nullptr);
+  EXPECT_EQ(nullptr, byName->Replay());
+  EXPECT_EQ(nullptr, later->Replay());
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  EXPECT_EQ(1u, later->updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST_F(Manager_TEST, Bundle)
+{
+  gz::sensors::Manager mgr;
+  EXPECT_EQ(nullptr, mgr.Bundle("/test_bundle"));
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetName("camera");
+  auto camera = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  sdfSensor.SetName("imu");
+  auto imu = mgr.CreateSensor<CountingSensor>(sdfSensor);
+  ASSERT_NE(nullptr, camera);
+  ASSERT_NE(nullptr, imu);
+  mgr.SetPhaseAligned(imu->Id(), true);
+
+  EXPECT_FALSE(mgr.AddBundle("/test_bundle", {}));
+  EXPECT_FALSE(mgr.AddBundle("/test_bundle", {camera->Id(), 12345u}));
+  EXPECT_FALSE(mgr.AddBundle("/test_bundle", {camera->Id(), camera->Id()}));
+  EXPECT_EQ(nullptr, camera->Bundle());
+
+  // The first sensor closes the frames
+  ASSERT_TRUE(mgr.AddBundle("/test_bundle", {camera->Id(), imu->Id()}));
+  auto bundle = mgr.Bundle("/test_bundle");
+  ASSERT_NE(nullptr, bundle);
+  EXPECT_EQ("/test_bundle", bundle->Topic());
+  EXPECT_EQ("camera", bundle->Primary());
+  EXPECT_EQ(bundle, camera->Bundle());
+  EXPECT_EQ(bundle, imu->Bundle());
+  EXPECT_TRUE(mgr.PhaseAligned(camera->Id()));
+
+  // A sensor is in one bundle, and a topic has one bundle
+  EXPECT_FALSE(mgr.AddBundle("/test_bundle_other", {imu->Id()}));
+  EXPECT_FALSE(mgr.AddBundle("/test_bundle", {}));
+
+  // Only the sensors pinned by the bundle are unpinned
+  EXPECT_TRUE(mgr.RemoveBundle("/test_bundle"));
+  EXPECT_FALSE(mgr.RemoveBundle("/test_bundle"));
+  EXPECT_EQ(nullptr, mgr.Bundle("/test_bundle"));
+  EXPECT_EQ(nullptr, camera->Bundle());
+  EXPECT_EQ(nullptr, imu->Bundle());
+  EXPECT_FALSE(mgr.PhaseAligned(camera->Id()));
+  EXPECT_TRUE(mgr.PhaseAligned(imu->Id()));
+}
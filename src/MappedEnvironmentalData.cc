@@ -0,0 +1,653 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include "gz/sensors/MappedEnvironmentalData.hh"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+#include <gz/math/TimeVaryingVolumetricGrid.hh>
+#include <gz/math/Vector3.hh>
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Round a size up to a multiple of 8 bytes.
+/// \param[in] _size Size in bytes.
+/// \return Rounded size.
+static uint64_t AlignSize(uint64_t _size)
+{
+  return (_size + 7u) & ~uint64_t{7u};
+}
+
+/// \brief Multiply sizes, checking for overflow.
+/// \param[in] _a First factor.
+/// \param[in] _b Second factor.
+/// \param[out] _product Product, if it didn't overflow.
+/// \return True if the product didn't overflow.
+static bool Multiply(uint64_t _a, uint64_t _b, uint64_t &_product)
+{
+  if (_a != 0u && _b > std::numeric_limits<uint64_t>::max() / _a)
+    return false;
+  _product = _a * _b;
+  return true;
+}
+
+/// \brief Get the size of a stored value.
+/// \param[in] _type How values are stored.
+/// \return Size in bytes, 0 for unknown types.
+static uint64_t ValueSize(EnvironmentalGridValueType _type)
+{
+  switch (_type)
+  {
+    case EnvironmentalGridValueType::FLOAT64:
+      return sizeof(double);
+    case EnvironmentalGridValueType::FLOAT32:
+      return sizeof(float);
+    case EnvironmentalGridValueType::INT16:
+      return sizeof(int16_t);
+  }
+  return 0u;
+}
+
+/// \brief Integer standing for NaN in INT16 grids.
+static constexpr int16_t kInt16NaN = std::numeric_limits<int16_t>::min();
+
+/// \brief Private data for MappedEnvironmentalData
+class gz::sensors::MappedEnvironmentalDataPrivate
+{
+  /// \brief Load two time slices into new data.
+  /// \param[in] _first Index of the first slice.
+  public: void Load(std::size_t _first);
+
+  /// \brief Release the pages of a range of time slices.
+  /// \param[in] _first Index of the first slice.
+  /// \param[in] _last Index past the last slice.
+  public: void Release(std::size_t _first, std::size_t _last) const;
+
+  /// \brief Decode the values of a column in a time slice.
+  /// \param[in] _slice Index of the slice.
+  /// \param[in] _column Index of the column.
+  /// \param[out] _values Values of the column.
+  public: void Decode(std::size_t _slice, std::size_t _column,
+              std::vector<double> &_values) const;
+
+  /// \brief Mapped file.
+  public: void *address{nullptr};
+
+  /// \brief Size of the mapped file.
+  public: uint64_t mapSize{0u};
+
+  /// \brief Offset of the values.
+  public: uint64_t dataOffset{0u};
+
+  /// \brief Number of values of a column in a time slice.
+  public: uint64_t gridSize{0u};
+
+  /// \brief How values are stored.
+  public: EnvironmentalGridValueType valueType{
+      EnvironmentalGridValueType::FLOAT64};
+
+  /// \brief Size of a stored value, in bytes.
+  public: uint64_t valueSize{sizeof(double)};
+
+  /// \brief Scale of each column.
+  public: std::vector<double> scales;
+
+  /// \brief Offset of each column.
+  public: std::vector<double> offsets;
+
+  /// \brief Decoded values of a column, reused across columns.
+  public: std::vector<double> values;
+
+  /// \brief Column names.
+  public: std::vector<std::string> columns;
+
+  /// \brief X coordinates.
+  public: std::vector<double> x;
+
+  /// \brief Y coordinates.
+  public: std::vector<double> y;
+
+  /// \brief Z coordinates.
+  public: std::vector<double> z;
+
+  /// \brief Times of the slices, in seconds.
+  public: std::vector<double> times;
+
+  /// \brief Spatial reference of the grid coordinates.
+  public: EnvironmentalData::ReferenceT reference{};
+
+  /// \brief Units of the grid coordinates.
+  public: EnvironmentalData::ReferenceUnits units{};
+
+  /// \brief Index of the first loaded slice, if any.
+  public: std::optional<std::size_t> first;
+
+  /// \brief Loaded data.
+  public: std::shared_ptr<EnvironmentalData> data;
+};
+
+//////////////////////////////////////////////////
+void MappedEnvironmentalDataPrivate::Decode(std::size_t _slice,
+    std::size_t _column, std::vector<double> &_values) const
+{
+  const uint64_t index =
+      (_slice * this->columns.size() + _column) * this->gridSize;
+  const unsigned char *bytes = static_cast<const unsigned char *>(
+      this->address) + this->dataOffset + index * this->valueSize;
+  const std::size_t count = static_cast<std::size_t>(this->gridSize);
+  _values.resize(count);
+
+  switch (this->valueType)
+  {
+    case EnvironmentalGridValueType::FLOAT64:
+    {
+      const double *stored = reinterpret_cast<const double *>(bytes);
+      std::copy(stored, stored + count, _values.begin());
+      break;
+    }
+    case EnvironmentalGridValueType::FLOAT32:
+    {
+      const float *stored = reinterpret_cast<const float *>(bytes);
+      std::copy(stored, stored + count, _values.begin());
+      break;
+    }
+    case EnvironmentalGridValueType::INT16:
+    {
+      const int16_t *stored = reinterpret_cast<const int16_t *>(bytes);
+      const double scale = this->scales[_column];
+      const double offset = this->offsets[_column];
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        _values[i] = stored[i] == kInt16NaN ?
+            std::numeric_limits<double>::quiet_NaN() :
+            offset + scale * stored[i];
+      }
+      break;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void MappedEnvironmentalDataPrivate::Load(std::size_t _first)
+{
+  GZ_PROFILE("MappedEnvironmentalData::Load");
+  const std::size_t last = std::min(_first + 2u, this->times.size());
+
+  EnvironmentalData::FrameT frame;
+  for (std::size_t c = 0; c < this->columns.size(); ++c)
+  {
+    math::InMemoryTimeVaryingVolumetricGridFactory<double, double> factory;
+    for (std::size_t t = _first; t < last; ++t)
+    {
+      this->Decode(t, c, this->values);
+      const double *values = this->values.data();
+      for (std::size_t k = 0; k < this->z.size(); ++k)
+      {
+        for (std::size_t j = 0; j < this->y.size(); ++j)
+        {
+          for (std::size_t i = 0; i < this->x.size(); ++i)
+          {
+            factory.AddPoint(this->times[t],
+                math::Vector3d(this->x[i], this->y[j], this->z[k]),
+                *values++);
+          }
+        }
+      }
+    }
+    frame[this->columns[c]] = factory.Build();
+  }
+
+  this->data = EnvironmentalData::MakeShared(std::move(frame),
+      this->reference, this->units, last - _first < 2u);
+
+  // Release the slices that are no longer loaded
+  if (this->first)
+  {
+    const std::size_t previousLast =
+        std::min(*this->first + 2u, this->times.size());
+    if (*this->first < _first)
+      this->Release(*this->first, std::min(previousLast, _first));
+    if (last < previousLast)
+      this->Release(std::max(*this->first, last), previousLast);
+  }
+  this->first = _first;
+}
+
+//////////////////////////////////////////////////
+void MappedEnvironmentalDataPrivate::Release(std::size_t _first,
+    std::size_t _last) const
+{
+#ifndef _WIN32
+  if (_first >= _last)
+    return;
+
+  const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  const uint64_t sliceSize =
+      this->columns.size() * this->gridSize * this->valueSize;
+  // Only whole pages can be released, pages shared with loaded slices are
+  // kept
+  const uint64_t begin = (this->dataOffset + _first * sliceSize +
+      pageSize - 1u) / pageSize * pageSize;
+  const uint64_t end =
+      (this->dataOffset + _last * sliceSize) / pageSize * pageSize;
+  if (begin >= end)
+    return;
+
+  madvise(static_cast<unsigned char *>(this->address) + begin,
+      static_cast<std::size_t>(end - begin), MADV_DONTNEED);
+#else
+  (void)_first;
+  (void)_last;
+#endif
+}
+
+//////////////////////////////////////////////////
+MappedEnvironmentalData::MappedEnvironmentalData()
+  : dataPtr(new MappedEnvironmentalDataPrivate())
+{
+}
+
+//////////////////////////////////////////////////
+MappedEnvironmentalData::~MappedEnvironmentalData()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool MappedEnvironmentalData::Open(const std::string &_path,
+    EnvironmentalData::ReferenceT _reference,
+    EnvironmentalData::ReferenceUnits _units)
+{
+  this->Close();
+#ifdef _WIN32
+  (void)_path;
+  (void)_reference;
+  (void)_units;
+  gzerr << "Memory mapped environmental data is not supported on "
+        << "Windows.\n";
+  return false;
+#else
+  int fd = open(_path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    gzerr << "Unable to open environmental data [" << _path << "]: "
+          << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  struct stat st;
+  void *addr = MAP_FAILED;
+  if (fstat(fd, &st) == 0 &&
+      static_cast<uint64_t>(st.st_size) >= sizeof(EnvironmentalGridHeader))
+  {
+    addr = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ,
+        MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (addr == MAP_FAILED)
+  {
+    gzerr << "Unable to map environmental data [" << _path << "]\n";
+    return false;
+  }
+  this->dataPtr->address = addr;
+  this->dataPtr->mapSize = static_cast<uint64_t>(st.st_size);
+
+  EnvironmentalGridHeader header;
+  std::memcpy(&header, addr, sizeof(header));
+  const uint64_t mapSize = this->dataPtr->mapSize;
+  const uint64_t axesCount = uint64_t{header.xCount} + header.yCount +
+      header.zCount + header.timeCount;
+  const uint64_t valueSize = ValueSize(
+      static_cast<EnvironmentalGridValueType>(header.valueType));
+  uint64_t gridSize = 0u;
+  uint64_t sliceCount = 0u;
+  uint64_t dataSize = 0u;
+  const bool valid =
+      header.magic == EnvironmentalGridHeader::kMagic &&
+      header.version == EnvironmentalGridHeader::kVersion &&
+      header.columnCount > 0u && header.xCount > 0u &&
+      header.yCount > 0u && header.zCount > 0u && header.timeCount > 0u &&
+      header.namesOffset <= mapSize &&
+      header.namesSize <= mapSize - header.namesOffset &&
+      header.axesOffset % sizeof(double) == 0u &&
+      header.axesOffset <= mapSize &&
+      axesCount <= (mapSize - header.axesOffset) / sizeof(double) &&
+      header.scalesOffset % sizeof(double) == 0u &&
+      header.scalesOffset <= mapSize &&
+      header.columnCount <=
+        (mapSize - header.scalesOffset) / (2u * sizeof(double)) &&
+      valueSize != 0u &&
+      header.dataOffset % sizeof(double) == 0u &&
+      header.dataOffset <= mapSize &&
+      Multiply(uint64_t{header.xCount} * header.yCount, header.zCount,
+          gridSize) &&
+      Multiply(gridSize, header.columnCount, sliceCount) &&
+      Multiply(sliceCount, header.timeCount, dataSize) &&
+      dataSize <= (mapSize - header.dataOffset) / valueSize;
+  if (!valid)
+  {
+    gzerr << "File [" << _path << "] is not valid environmental data.\n";
+    this->Close();
+    return false;
+  }
+
+  // Column names
+  const char *names =
+      static_cast<const char *>(addr) + header.namesOffset;
+  const char *namesEnd = names + header.namesSize;
+  while (names < namesEnd)
+  {
+    const char *end = std::find(names, namesEnd, '\0');
+    if (end == namesEnd)
+      break;
+    this->dataPtr->columns.emplace_back(names, end);
+    names = end + 1;
+  }
+
+  // Axes
+  const double *axes = reinterpret_cast<const double *>(
+      static_cast<const unsigned char *>(addr) + header.axesOffset);
+  this->dataPtr->x.assign(axes, axes + header.xCount);
+  axes += header.xCount;
+  this->dataPtr->y.assign(axes, axes + header.yCount);
+  axes += header.yCount;
+  this->dataPtr->z.assign(axes, axes + header.zCount);
+  axes += header.zCount;
+  this->dataPtr->times.assign(axes, axes + header.timeCount);
+
+  // Scales and offsets
+  const double *scales = reinterpret_cast<const double *>(
+      static_cast<const unsigned char *>(addr) + header.scalesOffset);
+  for (uint32_t c = 0; c < header.columnCount; ++c)
+  {
+    this->dataPtr->scales.push_back(scales[2u * c]);
+    this->dataPtr->offsets.push_back(scales[2u * c + 1u]);
+  }
+
+  const auto increasing = [](const std::vector<double> &_values)
+  {
+    return std::adjacent_find(_values.begin(), _values.end(),
+        [](double _a, double _b) { return !(_a < _b); }) == _values.end();
+  };
+  if (this->dataPtr->columns.size() != header.columnCount ||
+      !increasing(this->dataPtr->x) || !increasing(this->dataPtr->y) ||
+      !increasing(this->dataPtr->z) || !increasing(this->dataPtr->times))
+  {
+    gzerr << "File [" << _path << "] is not valid environmental data.\n";
+    this->Close();
+    return false;
+  }
+
+  this->dataPtr->dataOffset = header.dataOffset;
+  this->dataPtr->gridSize = gridSize;
+  this->dataPtr->valueType =
+      static_cast<EnvironmentalGridValueType>(header.valueType);
+  this->dataPtr->valueSize = valueSize;
+  this->dataPtr->reference = _reference;
+  this->dataPtr->units = _units;
+  this->dataPtr->Load(0u);
+  return true;
+#endif
+}
+
+//////////////////////////////////////////////////
+void MappedEnvironmentalData::Close()
+{
+#ifndef _WIN32
+  if (this->dataPtr->address)
+    munmap(this->dataPtr->address, this->dataPtr->mapSize);
+#endif
+  this->dataPtr->address = nullptr;
+  this->dataPtr->mapSize = 0u;
+  this->dataPtr->dataOffset = 0u;
+  this->dataPtr->gridSize = 0u;
+  this->dataPtr->valueType = EnvironmentalGridValueType::FLOAT64;
+  this->dataPtr->valueSize = sizeof(double);
+  this->dataPtr->scales.clear();
+  this->dataPtr->offsets.clear();
+  this->dataPtr->columns.clear();
+  this->dataPtr->x.clear();
+  this->dataPtr->y.clear();
+  this->dataPtr->z.clear();
+  this->dataPtr->times.clear();
+  this->dataPtr->first.reset();
+  this->dataPtr->data.reset();
+}
+
+//////////////////////////////////////////////////
+bool MappedEnvironmentalData::IsOpen() const
+{
+  return this->dataPtr->address != nullptr;
+}
+
+//////////////////////////////////////////////////
+const std::vector<std::string> &MappedEnvironmentalData::Columns() const
+{
+  return this->dataPtr->columns;
+}
+
+//////////////////////////////////////////////////
+std::size_t MappedEnvironmentalData::TimeCount() const
+{
+  return this->dataPtr->times.size();
+}
+
+//////////////////////////////////////////////////
+EnvironmentalGridValueType MappedEnvironmentalData::ValueType() const
+{
+  return this->dataPtr->valueType;
+}
+
+//////////////////////////////////////////////////
+std::size_t MappedEnvironmentalData::FirstLoadedSlice() const
+{
+  return this->dataPtr->first.value_or(0u);
+}
+
+//////////////////////////////////////////////////
+bool MappedEnvironmentalData::StepTo(
+    const std::chrono::steady_clock::duration &_now)
+{
+  if (!this->IsOpen())
+    return false;
+
+  const std::vector<double> &times = this->dataPtr->times;
+  const double now = std::chrono::duration<double>(_now).count();
+  std::size_t first = 0u;
+  if (times.size() > 2u)
+  {
+    const auto next = std::upper_bound(times.begin(), times.end(), now);
+    const std::size_t index = next == times.begin() ? 0u :
+        static_cast<std::size_t>(next - times.begin()) - 1u;
+    first = std::min(index, times.size() - 2u);
+  }
+
+  if (this->dataPtr->first && *this->dataPtr->first == first)
+    return false;
+
+  this->dataPtr->Load(first);
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<EnvironmentalData> MappedEnvironmentalData::Data() const
+{
+  return this->dataPtr->data;
+}
+
+//////////////////////////////////////////////////
+bool MappedEnvironmentalData::Write(const std::string &_path,
+    const std::vector<std::string> &_columns,
+    const std::vector<double> &_x, const std::vector<double> &_y,
+    const std::vector<double> &_z, const std::vector<double> &_times,
+    const std::vector<double> &_values, EnvironmentalGridValueType _type)
+{
+  if (_columns.empty() || _x.empty() || _y.empty() || _z.empty() ||
+      _times.empty() ||
+      _values.size() != _columns.size() * _x.size() * _y.size() *
+          _z.size() * _times.size())
+  {
+    gzerr << "Unable to write environmental data [" << _path
+          << "]: the number of values doesn't match the grid.\n";
+    return false;
+  }
+  if (ValueSize(_type) == 0u)
+  {
+    gzerr << "Unable to write environmental data [" << _path
+          << "]: unknown value type.\n";
+    return false;
+  }
+
+  const std::size_t gridSize = _x.size() * _y.size() * _z.size();
+
+  // Scale and offset of each column, spreading the range of INT16 columns
+  // over [-32767, 32767]
+  std::vector<double> scales(2u * _columns.size(), 0.0);
+  for (std::size_t c = 0; c < _columns.size(); ++c)
+  {
+    scales[2u * c] = 1.0;
+    if (_type != EnvironmentalGridValueType::INT16)
+      continue;
+
+    double minValue = std::numeric_limits<double>::infinity();
+    double maxValue = -std::numeric_limits<double>::infinity();
+    for (std::size_t t = 0; t < _times.size(); ++t)
+    {
+      const double *values =
+          _values.data() + (t * _columns.size() + c) * gridSize;
+      for (std::size_t i = 0; i < gridSize; ++i)
+      {
+        if (std::isfinite(values[i]))
+        {
+          minValue = std::min(minValue, values[i]);
+          maxValue = std::max(maxValue, values[i]);
+        }
+      }
+    }
+    if (minValue < maxValue)
+    {
+      scales[2u * c] = (maxValue - minValue) / 65534.0;
+      scales[2u * c + 1u] = minValue + (maxValue - minValue) / 2.0;
+    }
+    else if (minValue == maxValue)
+    {
+      scales[2u * c + 1u] = minValue;
+    }
+  }
+
+  EnvironmentalGridHeader header{};
+  header.magic = EnvironmentalGridHeader::kMagic;
+  header.version = EnvironmentalGridHeader::kVersion;
+  header.columnCount = static_cast<uint32_t>(_columns.size());
+  header.xCount = static_cast<uint32_t>(_x.size());
+  header.yCount = static_cast<uint32_t>(_y.size());
+  header.zCount = static_cast<uint32_t>(_z.size());
+  header.timeCount = static_cast<uint32_t>(_times.size());
+  header.valueType = static_cast<uint32_t>(_type);
+  header.namesOffset = AlignSize(sizeof(header));
+  for (const std::string &column : _columns)
+    header.namesSize += column.size() + 1u;
+  header.axesOffset = AlignSize(header.namesOffset + header.namesSize);
+  header.scalesOffset = header.axesOffset + sizeof(double) *
+      (_x.size() + _y.size() + _z.size() + _times.size());
+  header.dataOffset =
+      header.scalesOffset + scales.size() * sizeof(double);
+
+  std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+  if (!file)
+  {
+    gzerr << "Unable to create environmental data [" << _path << "]\n";
+    return false;
+  }
+
+  const char padding[8] = {};
+  const auto writeValues = [&file](const auto &_data)
+  {
+    file.write(reinterpret_cast<const char *>(_data.data()),
+        static_cast<std::streamsize>(
+            _data.size() * sizeof(typename std::decay_t<
+                decltype(_data)>::value_type)));
+  };
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(padding, static_cast<std::streamsize>(
+      header.namesOffset - sizeof(header)));
+  for (const std::string &column : _columns)
+  {
+    file.write(column.c_str(),
+        static_cast<std::streamsize>(column.size() + 1u));
+  }
+  file.write(padding, static_cast<std::streamsize>(
+      header.axesOffset - header.namesOffset - header.namesSize));
+  writeValues(_x);
+  writeValues(_y);
+  writeValues(_z);
+  writeValues(_times);
+  writeValues(scales);
+
+  switch (_type)
+  {
+    case EnvironmentalGridValueType::FLOAT64:
+      writeValues(_values);
+      break;
+    case EnvironmentalGridValueType::FLOAT32:
+      writeValues(std::vector<float>(_values.begin(), _values.end()));
+      break;
+    case EnvironmentalGridValueType::INT16:
+    {
+      std::vector<int16_t> stored(_values.size());
+      for (std::size_t i = 0; i < _values.size(); ++i)
+      {
+        const std::size_t c = (i / gridSize) % _columns.size();
+        if (std::isnan(_values[i]))
+        {
+          stored[i] = kInt16NaN;
+          continue;
+        }
+        const double q = std::round(
+            (_values[i] - scales[2u * c + 1u]) / scales[2u * c]);
+        stored[i] = static_cast<int16_t>(
+            std::clamp(q, -32767.0, 32767.0));
+      }
+      writeValues(stored);
+      break;
+    }
+  }
+
+  if (!file)
+  {
+    gzerr << "Unable to write environmental data [" << _path << "]\n";
+    return false;
+  }
+  return true;
+}
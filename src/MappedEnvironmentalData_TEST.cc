@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Filesystem.hh>
+
+#include "gz/sensors/EnvironmentalDataSampler.hh"
+#include "gz/sensors/MappedEnvironmentalData.hh"
+
+using namespace gz;
+using namespace sensors;
+using namespace std::chrono_literals;
+
+/// \brief Test MappedEnvironmentalData
+class MappedEnvironmentalData_TEST : public ::testing::Test
+{
+  // Documentation inherited
+  protected: void SetUp() override
+  {
+    common::Console::SetVerbosity(4);
+    this->path = common::joinPaths(::testing::TempDir(),
+        "gz_sensors_environmental_grid.bin");
+    common::removeFile(this->path);
+  }
+
+  // Documentation inherited
+  protected: void TearDown() override
+  {
+    common::removeFile(this->path);
+  }
+
+  /// \brief Write a unit cube grid with 4 time slices, 10 seconds apart,
+  /// and two columns: "a" equal to x plus 100 times the slice index, and
+  /// "b" equal to -x.
+  /// \param[in] _type How to store the values.
+  /// \return True if the file was written.
+  protected: bool WriteGrid(EnvironmentalGridValueType _type =
+      EnvironmentalGridValueType::FLOAT64) const
+  {
+    const std::vector<double> axis{0.0, 1.0};
+    const std::vector<double> times{0.0, 10.0, 20.0, 30.0};
+    std::vector<double> values;
+    for (std::size_t t = 0; t < times.size(); ++t)
+    {
+      for (double sign : {100.0, -1.0})
+      {
+        for (std::size_t i = 0; i < 8u; ++i)
+        {
+          const double x = axis[i % 2u];
+          values.push_back(sign > 0.0 ? x + sign * t : sign * x);
+        }
+      }
+    }
+    return MappedEnvironmentalData::Write(
+        this->path, {"a", "b"}, axis, axis, axis, times, values, _type);
+  }
+
+  /// \brief Get the size of the grid file.
+  /// \return Size in bytes.
+  protected: std::streamoff FileSize() const
+  {
+    std::ifstream file(this->path, std::ios::binary | std::ios::ate);
+    return file.tellg();
+  }
+
+  /// \brief Path of the grid file.
+  protected: std::string path;
+};
+
+/////////////////////////////////////////////////
+TEST_F(MappedEnvironmentalData_TEST, StepTo)
+{
+#ifdef _WIN32
+  GTEST_SKIP() << "Memory mapped environmental data is POSIX only";
+#endif
+  ASSERT_TRUE(this->WriteGrid());
+
+  MappedEnvironmentalData mapped;
+  EXPECT_FALSE(mapped.IsOpen());
+  EXPECT_EQ(nullptr, mapped.Data());
+  EXPECT_FALSE(mapped.StepTo(0s));
+
+  ASSERT_TRUE(mapped.Open(this->path, math::SphericalCoordinates::GLOBAL));
+  EXPECT_TRUE(mapped.IsOpen());
+  ASSERT_EQ(2u, mapped.Columns().size());
+  EXPECT_EQ("a", mapped.Columns()[0]);
+  EXPECT_EQ("b", mapped.Columns()[1]);
+  EXPECT_EQ(4u, mapped.TimeCount());
+  EXPECT_EQ(EnvironmentalGridValueType::FLOAT64, mapped.ValueType());
+  EXPECT_EQ(0u, mapped.FirstLoadedSlice());
+  auto data = mapped.Data();
+  ASSERT_NE(nullptr, data);
+  EXPECT_EQ(math::SphericalCoordinates::GLOBAL, data->reference);
+  EXPECT_TRUE(data->frame.Has("a"));
+  EXPECT_TRUE(data->frame.Has("b"));
+
+  const math::Vector3d pos(0.25, 0.5, 0.5);
+  {
+    EnvironmentalDataSampler sampler(*data, {"a", "b"});
+    sampler.StepTo(5s);
+    auto a = sampler.LookUp(0, pos);
+    ASSERT_TRUE(a.has_value());
+    EXPECT_NEAR(50.25, *a, 1e-6);
+    auto b = sampler.LookUp(1, pos);
+    ASSERT_TRUE(b.has_value());
+    EXPECT_NEAR(-0.25, *b, 1e-6);
+  }
+
+  // Same slices
+  EXPECT_FALSE(mapped.StepTo(5s));
+  EXPECT_EQ(data, mapped.Data());
+
+  // Next slices
+  EXPECT_TRUE(mapped.StepTo(25s));
+  EXPECT_EQ(2u, mapped.FirstLoadedSlice());
+  data = mapped.Data();
+  {
+    EnvironmentalDataSampler sampler(*data, {"a"});
+    sampler.StepTo(25s);
+    auto a = sampler.LookUp(0, pos);
+    ASSERT_TRUE(a.has_value());
+    EXPECT_NEAR(250.25, *a, 1e-6);
+  }
+
+  // Past the end keeps the last slices, before the start the first ones
+  EXPECT_FALSE(mapped.StepTo(100s));
+  EXPECT_EQ(2u, mapped.FirstLoadedSlice());
+  EXPECT_TRUE(mapped.StepTo(-5s));
+  EXPECT_EQ(0u, mapped.FirstLoadedSlice());
+
+  mapped.Close();
+  EXPECT_FALSE(mapped.IsOpen());
+  EXPECT_EQ(nullptr, mapped.Data());
+  EXPECT_TRUE(mapped.Columns().empty());
+}
+
+/////////////////////////////////////////////////
+TEST_F(MappedEnvironmentalData_TEST, ValueTypes)
+{
+#ifdef _WIN32
+  GTEST_SKIP() << "Memory mapped environmental data is POSIX only";
+#endif
+  ASSERT_TRUE(this->WriteGrid());
+  const std::streamoff float64Size = this->FileSize();
+
+  const math::Vector3d pos(0.25, 0.5, 0.5);
+  for (auto [type, tolerance] : {
+      std::make_pair(EnvironmentalGridValueType::FLOAT32, 1e-5),
+      std::make_pair(EnvironmentalGridValueType::INT16, 301.0 / 65534.0)})
+  {
+    ASSERT_TRUE(this->WriteGrid(type));
+    EXPECT_LT(this->FileSize(), float64Size);
+
+    MappedEnvironmentalData mapped;
+    ASSERT_TRUE(mapped.Open(this->path, math::SphericalCoordinates::GLOBAL));
+    EXPECT_EQ(type, mapped.ValueType());
+    ASSERT_TRUE(mapped.StepTo(25s));
+
+    EnvironmentalDataSampler sampler(*mapped.Data(), {"a", "b"});
+    sampler.StepTo(25s);
+    auto a = sampler.LookUp(0, pos);
+    ASSERT_TRUE(a.has_value());
+    EXPECT_NEAR(250.25, *a, tolerance);
+    auto b = sampler.LookUp(1, pos);
+    ASSERT_TRUE(b.has_value());
+    EXPECT_NEAR(-0.25, *b, tolerance);
+  }
+
+  // Constant and missing values
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  ASSERT_TRUE(MappedEnvironmentalData::Write(this->path, {"c", "n"},
+      {0.0}, {0.0}, {0.0}, {0.0}, {3.5, nan},
+      EnvironmentalGridValueType::INT16));
+  MappedEnvironmentalData mapped;
+  ASSERT_TRUE(mapped.Open(this->path, math::SphericalCoordinates::GLOBAL));
+  EnvironmentalDataSampler sampler(*mapped.Data(), {"c", "n"});
+  auto c = sampler.LookUp(0, math::Vector3d::Zero);
+  ASSERT_TRUE(c.has_value());
+  EXPECT_DOUBLE_EQ(3.5, *c);
+  auto n = sampler.LookUp(1, math::Vector3d::Zero);
+  EXPECT_TRUE(!n.has_value() || std::isnan(*n));
+}
+
+/////////////////////////////////////////////////
+TEST_F(MappedEnvironmentalData_TEST, InvalidFile)
+{
+  MappedEnvironmentalData mapped;
+  EXPECT_FALSE(mapped.Open(this->path, math::SphericalCoordinates::GLOBAL));
+
+  // Wrong number of values
+  EXPECT_FALSE(MappedEnvironmentalData::Write(this->path, {"a"},
+      {0.0}, {0.0}, {0.0}, {0.0}, {1.0, 2.0}));
+
+  // Not a grid file
+  {
+    std::ofstream file(this->path, std::ios::binary);
+    const std::string text(256, 'x');
+    file << text;
+  }
+  EXPECT_FALSE(mapped.Open(this->path, math::SphericalCoordinates::GLOBAL));
+
+  // Truncated
+  ASSERT_TRUE(this->WriteGrid());
+  std::string bytes;
+  {
+    std::ifstream file(this->path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file(this->path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(),
+        static_cast<std::streamsize>(bytes.size() - sizeof(double)));
+  }
+  EXPECT_FALSE(mapped.Open(this->path, math::SphericalCoordinates::GLOBAL));
+
+  // Decreasing axis
+  EXPECT_TRUE(MappedEnvironmentalData::Write(this->path, {"a"},
+      {1.0, 0.0}, {0.0}, {0.0}, {0.0}, {1.0, 2.0}));
+  EXPECT_FALSE(mapped.Open(this->path, math::SphericalCoordinates::GLOBAL));
+  EXPECT_FALSE(mapped.IsOpen());
+}
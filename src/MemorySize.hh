@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_MEMORYSIZE_HH_
+#define GZ_SENSORS_MEMORYSIZE_HH_
+
+#include <cstddef>
+#include <vector>
+
+#include <google/protobuf/message.h>
+
+#include "gz/sensors/config.hh"
+#include "AlignedBuffer.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Get the memory allocated by a vector, which is kept when it's
+    /// cleared.
+    /// \param[in] _vector Vector to measure.
+    /// \return Bytes allocated for the capacity of the vector.
+    template <typename T>
+    std::size_t MemorySize(const std::vector<T> &_vector)
+    {
+      return _vector.capacity() * sizeof(T);
+    }
+
+    /// \brief Get the memory allocated by a frame buffer.
+    /// \param[in] _buffer Buffer to measure.
+    /// \return Bytes allocated for the capacity of the buffer.
+    template <typename T>
+    std::size_t MemorySize(const AlignedBuffer<T> &_buffer)
+    {
+      return _buffer.Capacity() * sizeof(T);
+    }
+
+    /// \brief Get the memory used by a message, including the memory its
+    /// fields keep when they're cleared. It walks the fields of the
+    /// message, so it's meant for reports rather than every update.
+    /// \param[in] _msg Message to measure.
+    /// \return Bytes used by the message.
+    inline std::size_t MemorySize(const google::protobuf::Message &_msg)
+    {
+      return _msg.SpaceUsedLong();
+    }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,288 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef GZ_SENSORS_MODELPOSEGRID_HH_
+#define GZ_SENSORS_MODELPOSEGRID_HH_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <gz/math/Vector3.hh>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Uniform grid of points, identified by small integers, that
+    /// are moved one at a time. Cells are hashed, so only occupied cells
+    /// take memory. Points with non finite coordinates are kept out of
+    /// every cell.
+    class ModelPoseGrid
+    {
+      /// \brief Constructor
+      /// \param[in] _cellSize Length of the side of a cell, in meters.
+      public: explicit ModelPoseGrid(double _cellSize)
+        : cellSize(_cellSize > 0.0 ? _cellSize : 1.0)
+      {
+      }
+
+      /// \brief Get the length of the side of a cell.
+      /// \return Cell size, in meters.
+      public: double CellSize() const
+      {
+        return this->cellSize;
+      }
+
+      /// \brief Get the number of points.
+      /// \return Number of points in the grid.
+      public: std::size_t Size() const
+      {
+        return this->count;
+      }
+
+      /// \brief Insert a point, or move it if it's in the grid.
+      /// \param[in] _id Point id. Ids should be small, the grid keeps a
+      /// slot for every id up to the largest one.
+      /// \param[in] _pos Position of the point.
+      public: void Set(std::size_t _id, const math::Vector3d &_pos)
+      {
+        if (_id >= this->points.size())
+          this->points.resize(_id + 1);
+
+        Point &point = this->points[_id];
+        CellKey key;
+        const bool finite = this->KeyOf(_pos, key);
+        if (point.present && point.inCell && finite && point.key == key)
+          return;
+
+        if (point.present)
+          this->Unlink(_id);
+        else
+          ++this->count;
+
+        point.present = true;
+        point.inCell = finite;
+        if (finite)
+        {
+          point.key = key;
+          std::vector<std::size_t> &cell = this->cells[key];
+          point.slot = cell.size();
+          cell.push_back(_id);
+        }
+      }
+
+      /// \brief Remove a point.
+      /// \param[in] _id Point id, ignored if it's not in the grid.
+      public: void Remove(std::size_t _id)
+      {
+        if (_id >= this->points.size() || !this->points[_id].present)
+          return;
+        this->Unlink(_id);
+        this->points[_id].present = false;
+        --this->count;
+      }
+
+      /// \brief Remove all points.
+      public: void Clear()
+      {
+        this->cells.clear();
+        this->points.clear();
+        this->count = 0;
+      }
+
+      /// \brief Call a function with the id of every point in the cells
+      /// that overlap a box. Points outside of the box but in those cells
+      /// are visited too, callers do the exact test.
+      /// \param[in] _min Minimum corner of the box.
+      /// \param[in] _max Maximum corner of the box.
+      /// \param[in] _f Function taking a point id.
+      public: template <typename F>
+      void ForEachInBox(const math::Vector3d &_min,
+                        const math::Vector3d &_max, F &&_f) const
+      {
+        CellKey lo, hi;
+        if (!this->KeyOf(_min, lo) || !this->KeyOf(_max, hi))
+        {
+          // Unbounded box, visit all cells
+          for (const auto &cell : this->cells)
+            for (std::size_t id : cell.second)
+              _f(id);
+          return;
+        }
+
+        // Probe the cells of the box or scan the occupied cells,
+        // whichever visits fewer
+        const double boxCells =
+            (static_cast<double>(hi.x - lo.x) + 1.0) *
+            (static_cast<double>(hi.y - lo.y) + 1.0) *
+            (static_cast<double>(hi.z - lo.z) + 1.0);
+        if (boxCells > static_cast<double>(this->cells.size()))
+        {
+          for (const auto &cell : this->cells)
+          {
+            const CellKey &key = cell.first;
+            if (key.x < lo.x || key.x > hi.x || key.y < lo.y ||
+                key.y > hi.y || key.z < lo.z || key.z > hi.z)
+            {
+              continue;
+            }
+            for (std::size_t id : cell.second)
+              _f(id);
+          }
+          return;
+        }
+
+        for (int64_t x = lo.x; x <= hi.x; ++x)
+        {
+          for (int64_t y = lo.y; y <= hi.y; ++y)
+          {
+            for (int64_t z = lo.z; z <= hi.z; ++z)
+            {
+              const auto cell = this->cells.find(CellKey{x, y, z});
+              if (cell == this->cells.end())
+                continue;
+              for (std::size_t id : cell->second)
+                _f(id);
+            }
+          }
+        }
+      }
+
+      /// \brief Coordinates of a cell.
+      private: struct CellKey
+      {
+        /// \brief Cell index along x.
+        int64_t x{0};
+
+        /// \brief Cell index along y.
+        int64_t y{0};
+
+        /// \brief Cell index along z.
+        int64_t z{0};
+
+        /// \brief Equality operator.
+        /// \param[in] _other Key to compare to.
+        /// \return True if both keys are the same cell.
+        bool operator==(const CellKey &_other) const
+        {
+          return this->x == _other.x && this->y == _other.y &&
+                 this->z == _other.z;
+        }
+      };
+
+      /// \brief Hash of cell coordinates.
+      private: struct CellKeyHash
+      {
+        /// \brief Hash a key.
+        /// \param[in] _key Cell coordinates.
+        /// \return Hash of the key.
+        std::size_t operator()(const CellKey &_key) const
+        {
+          // Large primes, as in Teschner et al. spatial hashing
+          const uint64_t h =
+              static_cast<uint64_t>(_key.x) * 73856093u ^
+              static_cast<uint64_t>(_key.y) * 19349663u ^
+              static_cast<uint64_t>(_key.z) * 83492791u;
+          return static_cast<std::size_t>(h);
+        }
+      };
+
+      /// \brief A point in the grid.
+      private: struct Point
+      {
+        /// \brief Cell of the point, if inCell.
+        CellKey key;
+
+        /// \brief Index of the point in its cell, if inCell.
+        std::size_t slot{0};
+
+        /// \brief True if the id is in the grid.
+        bool present{false};
+
+        /// \brief True if the point is in a cell, false if its position
+        /// isn't finite.
+        bool inCell{false};
+      };
+
+      /// \brief Get the cell of a position.
+      /// \param[in] _pos Position.
+      /// \param[out] _key Cell coordinates.
+      /// \return False if the position isn't finite.
+      private: bool KeyOf(const math::Vector3d &_pos, CellKey &_key) const
+      {
+        if (!std::isfinite(_pos.X()) || !std::isfinite(_pos.Y()) ||
+            !std::isfinite(_pos.Z()))
+        {
+          return false;
+        }
+        // Keep far away positions within the range of the keys
+        static constexpr double kMaxIndex = 4.0e18;
+        auto index = [this](double _v)
+        {
+          return static_cast<int64_t>(std::clamp(
+              std::floor(_v / this->cellSize), -kMaxIndex, kMaxIndex));
+        };
+        _key = CellKey{index(_pos.X()), index(_pos.Y()), index(_pos.Z())};
+        return true;
+      }
+
+      /// \brief Take a point out of its cell.
+      /// \param[in] _id Id of a point in the grid.
+      private: void Unlink(std::size_t _id)
+      {
+        Point &point = this->points[_id];
+        if (!point.inCell)
+          return;
+        auto cell = this->cells.find(point.key);
+        std::vector<std::size_t> &ids = cell->second;
+        // Move the last point of the cell to the slot being freed
+        const std::size_t last = ids.back();
+        ids[point.slot] = last;
+        this->points[last].slot = point.slot;
+        ids.pop_back();
+        if (ids.empty())
+          this->cells.erase(cell);
+        point.inCell = false;
+      }
+
+      /// \brief Length of the side of a cell.
+      private: double cellSize;
+
+      /// \brief Ids of the points in each occupied cell.
+      private: std::unordered_map<CellKey, std::vector<std::size_t>,
+                                  CellKeyHash> cells;
+
+      /// \brief Points, indexed by id.
+      private: std::vector<Point> points;
+
+      /// \brief Number of points in the grid.
+      private: std::size_t count{0};
+    };
+    }
+  }
+}
+
+#endif
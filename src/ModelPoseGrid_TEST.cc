@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "ModelPoseGrid.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Get the ids visited for a box, sorted.
+/// \param[in] _grid Grid to query.
+/// \param[in] _min Minimum corner of the box.
+/// \param[in] _max Maximum corner of the box.
+/// \return Visited ids.
+static std::vector<std::size_t> Visited(const ModelPoseGrid &_grid,
+    const math::Vector3d &_min, const math::Vector3d &_max)
+{
+  std::vector<std::size_t> ids;
+  _grid.ForEachInBox(_min, _max, [&](std::size_t _id)
+  {
+    ids.push_back(_id);
+  });
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+//////////////////////////////////////////////////
+TEST(ModelPoseGrid, SetAndRemove)
+{
+  ModelPoseGrid grid(1.0);
+  EXPECT_DOUBLE_EQ(1.0, grid.CellSize());
+  EXPECT_EQ(0u, grid.Size());
+
+  grid.Set(0u, math::Vector3d(0.5, 0.5, 0.5));
+  grid.Set(3u, math::Vector3d(5.5, 0.5, 0.5));
+  grid.Set(1u, math::Vector3d(-0.5, 0.5, 0.5));
+  EXPECT_EQ(3u, grid.Size());
+
+  EXPECT_EQ((std::vector<std::size_t>{0u}),
+      Visited(grid, math::Vector3d(0.1, 0.1, 0.1),
+              math::Vector3d(0.9, 0.9, 0.9)));
+  EXPECT_EQ((std::vector<std::size_t>{0u, 1u}),
+      Visited(grid, math::Vector3d(-0.9, 0.1, 0.1),
+              math::Vector3d(0.9, 0.9, 0.9)));
+  EXPECT_EQ((std::vector<std::size_t>{0u, 1u, 3u}),
+      Visited(grid, math::Vector3d(-10, -10, -10),
+              math::Vector3d(10, 10, 10)));
+
+  // Moving a point updates its cell
+  grid.Set(3u, math::Vector3d(0.2, 0.2, 0.2));
+  EXPECT_EQ(3u, grid.Size());
+  EXPECT_EQ((std::vector<std::size_t>{0u, 3u}),
+      Visited(grid, math::Vector3d(0.1, 0.1, 0.1),
+              math::Vector3d(0.9, 0.9, 0.9)));
+  EXPECT_TRUE(Visited(grid, math::Vector3d(5.1, 0.1, 0.1),
+                      math::Vector3d(5.9, 0.9, 0.9)).empty());
+
+  grid.Remove(0u);
+  grid.Remove(0u);
+  grid.Remove(42u);
+  EXPECT_EQ(2u, grid.Size());
+  EXPECT_EQ((std::vector<std::size_t>{3u}),
+      Visited(grid, math::Vector3d(0.1, 0.1, 0.1),
+              math::Vector3d(0.9, 0.9, 0.9)));
+
+  grid.Clear();
+  EXPECT_EQ(0u, grid.Size());
+  EXPECT_TRUE(Visited(grid, math::Vector3d(-10, -10, -10),
+                      math::Vector3d(10, 10, 10)).empty());
+}
+
+//////////////////////////////////////////////////
+TEST(ModelPoseGrid, NonFinite)
+{
+  ModelPoseGrid grid(2.0);
+  const double inf = std::numeric_limits<double>::infinity();
+  grid.Set(0u, math::Vector3d(std::nan(""), 0, 0));
+  grid.Set(1u, math::Vector3d(1, 1, 1));
+  EXPECT_EQ(2u, grid.Size());
+
+  // Points without a finite position are in no cell
+  EXPECT_EQ((std::vector<std::size_t>{1u}),
+      Visited(grid, math::Vector3d(-inf, -inf, -inf),
+              math::Vector3d(inf, inf, inf)));
+
+  // They can come back into the grid
+  grid.Set(0u, math::Vector3d(1.5, 1, 1));
+  EXPECT_EQ((std::vector<std::size_t>{0u, 1u}),
+      Visited(grid, math::Vector3d(0, 0, 0), math::Vector3d(1, 1, 1)));
+  grid.Remove(0u);
+  EXPECT_EQ(1u, grid.Size());
+}
+
+//////////////////////////////////////////////////
+TEST(ModelPoseGrid, LargeBox)
+{
+  // A box with more cells than the grid has occupied cells
+  ModelPoseGrid grid(0.1);
+  for (std::size_t i = 0; i < 100u; ++i)
+  {
+    grid.Set(i, math::Vector3d(i * 1.0, -1.0 * i, 0.5 * i));
+  }
+  const std::vector<std::size_t> ids =
+      Visited(grid, math::Vector3d(9.95, -50.05, 4.95),
+              math::Vector3d(50.05, -9.95, 25.05));
+  ASSERT_EQ(41u, ids.size());
+  EXPECT_EQ(10u, ids.front());
+  EXPECT_EQ(50u, ids.back());
+
+  // Far away points stay within the range of the cells
+  grid.Set(100u, math::Vector3d(1e300, -1e300, 0));
+  EXPECT_EQ(101u, grid.Size());
+  EXPECT_EQ((std::vector<std::size_t>{0u}),
+      Visited(grid, math::Vector3d(-0.05, -0.05, -0.05),
+              math::Vector3d(0.05, 0.05, 0.05)));
+}
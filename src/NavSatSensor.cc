@@ -15,7 +15,7 @@
  *
 */
 
-#include <unordered_map>
+#include <algorithm>
 
 #ifdef _WIN32
 #pragma warning(push)
@@ -29,6 +29,9 @@
 
 #include <gz/common/Profiler.hh>
 #include <gz/math/Angle.hh>
+#include <gz/math/Helpers.hh>
+#include <gz/math/Matrix3.hh>
+#include <gz/math/SphericalCoordinates.hh>
 #include <gz/math/Vector3.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
@@ -50,6 +53,9 @@ class gz::sensors::NavSatPrivate
   /// \brief To publish NavSat messages.
   public: transport::Node::Publisher pub;
 
+  /// \brief NavSat message, reused by every update.
+  public: msgs::NavSat msg;
+
   /// \brief True if Load() has been called and was successful
   public: bool loaded = false;
 
@@ -66,9 +72,71 @@ class gz::sensors::NavSatPrivate
   public: math::Vector3d velocity;
 
   /// \brief Noise added to sensor data
-  public: std::unordered_map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief Convert a world position to latitude and longitude in degrees
+  /// and altitude, linearized around the last exactly converted position
+  /// when it's close enough.
+  /// \param[in] _pos Position in the world frame.
+  /// \return Latitude, longitude and altitude.
+  public: math::Vector3d Convert(const math::Vector3d &_pos);
+
+  /// \brief Spherical coordinates of the world origin.
+  public: math::SphericalCoordinates origin;
+
+  /// \brief Distance from linearizationPoint within which positions are
+  /// linearized, zero to always convert them exactly.
+  public: double linearizationDistance = 0.0;
+
+  /// \brief True if linearizationPoint and the derivatives are valid.
+  public: bool linearized = false;
+
+  /// \brief World position the earth model is linearized around.
+  public: math::Vector3d linearizationPoint;
+
+  /// \brief Latitude and longitude in degrees and altitude at
+  /// linearizationPoint.
+  public: math::Vector3d linearizationValue;
+
+  /// \brief Derivatives of latitude, longitude and altitude with respect to
+  /// the world position, at linearizationPoint. Column i holds the
+  /// derivatives with respect to coordinate i.
+  public: math::Matrix3d linearizationJacobian;
 };
 
+//////////////////////////////////////////////////
+math::Vector3d NavSatPrivate::Convert(const math::Vector3d &_pos)
+{
+  if (this->linearizationDistance <= 0.0)
+    return this->origin.SphericalFromLocalPosition(_pos);
+
+  if (!this->linearized || _pos.Distance(this->linearizationPoint) >
+      this->linearizationDistance)
+  {
+    // Central differences over a meter, well below the distances the
+    // linearization is used over
+    const double step = 1.0;
+    this->linearizationPoint = _pos;
+    this->linearizationValue = this->origin.SphericalFromLocalPosition(_pos);
+    for (int i = 0; i < 3; ++i)
+    {
+      math::Vector3d offset;
+      offset[i] = step;
+      math::Vector3d delta =
+          this->origin.SphericalFromLocalPosition(_pos + offset) -
+          this->origin.SphericalFromLocalPosition(_pos - offset);
+      // Longitude wraps around at 180 degrees
+      delta.Y(math::Angle(GZ_DTOR(delta.Y())).Normalized().Degree());
+      this->linearizationJacobian.SetCol(i, delta / (2.0 * step));
+    }
+    this->linearized = true;
+    return this->linearizationValue;
+  }
+
+  return this->linearizationValue + this->linearizationJacobian *
+      (_pos - this->linearizationPoint);
+}
+
 //////////////////////////////////////////////////
 NavSatSensor::NavSatSensor()
   : dataPtr(std::make_unique<NavSatPrivate>())
@@ -107,10 +175,8 @@ bool NavSatSensor::Load(const sdf::Sensor &_sdf)
   if (this->Topic().empty())
     this->SetTopic("/navsat");
 
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<msgs::NavSat>(this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<msgs::NavSat>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic [" << this->Topic()
            << "]." << std::endl;
@@ -147,6 +213,8 @@ bool NavSatSensor::Load(const sdf::Sensor &_sdf)
         _sdf.NavSatSensor()->VerticalVelocityNoise());
   }
 
+  this->RegisterNoise(this->dataPtr->noises);
+
   this->dataPtr->loaded = true;
   return true;
 }
@@ -169,33 +237,29 @@ bool NavSatSensor::Update(const std::chrono::steady_clock::duration &_now)
     return false;
   }
 
-  msgs::NavSat msg;
+  auto &msg = this->dataPtr->msg;
   *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
   msg.set_frame_id(this->FrameId());
 
   // Apply noise
-  auto iter = this->dataPtr->noises.find(NAVSAT_HORIZONTAL_POSITION_NOISE);
-  if (iter != this->dataPtr->noises.end())
+  const NoiseTable &noises = this->dataPtr->noises;
+  if (const NoisePtr &noise = noises[NAVSAT_HORIZONTAL_POSITION_NOISE])
   {
-    this->SetLatitude(GZ_DTOR(iter->second->Apply(this->Latitude().Degree())));
-    this->SetLongitude(GZ_DTOR(iter->second->Apply(
-        this->Longitude().Degree())));
+    this->SetLatitude(GZ_DTOR(noise->Apply(this->Latitude().Degree())));
+    this->SetLongitude(GZ_DTOR(noise->Apply(this->Longitude().Degree())));
   }
-  iter = this->dataPtr->noises.find(NAVSAT_VERTICAL_POSITION_NOISE);
-  if (iter != this->dataPtr->noises.end())
+  if (const NoisePtr &noise = noises[NAVSAT_VERTICAL_POSITION_NOISE])
   {
-    this->SetAltitude(iter->second->Apply(this->Altitude()));
+    this->SetAltitude(noise->Apply(this->Altitude()));
   }
-  iter = this->dataPtr->noises.find(NAVSAT_HORIZONTAL_VELOCITY_NOISE);
-  if (iter != this->dataPtr->noises.end())
+  if (const NoisePtr &noise = noises[NAVSAT_HORIZONTAL_VELOCITY_NOISE])
   {
-    this->dataPtr->velocity.X(iter->second->Apply(this->dataPtr->velocity.X()));
-    this->dataPtr->velocity.Y(iter->second->Apply(this->dataPtr->velocity.Y()));
+    this->dataPtr->velocity.X(noise->Apply(this->dataPtr->velocity.X()));
+    this->dataPtr->velocity.Y(noise->Apply(this->dataPtr->velocity.Y()));
   }
-  iter = this->dataPtr->noises.find(NAVSAT_VERTICAL_VELOCITY_NOISE);
-  if (iter != this->dataPtr->noises.end())
+  if (const NoisePtr &noise = noises[NAVSAT_VERTICAL_VELOCITY_NOISE])
   {
-    this->dataPtr->velocity.Z(iter->second->Apply(this->dataPtr->velocity.Z()));
+    this->dataPtr->velocity.Z(noise->Apply(this->dataPtr->velocity.Z()));
   }
 
   // normalise so that it is within +/- 180
@@ -211,11 +275,52 @@ bool NavSatSensor::Update(const std::chrono::steady_clock::duration &_now)
 
   // publish
   this->AddSequence(msg.mutable_header());
-  this->dataPtr->pub.Publish(msg);
+  this->Publish(this->dataPtr->pub, msg);
 
   return true;
 }
 
+//////////////////////////////////////////////////
+void NavSatSensor::SetSphericalCoordinates(
+    const math::SphericalCoordinates &_origin)
+{
+  this->dataPtr->origin = _origin;
+  this->dataPtr->linearized = false;
+}
+
+//////////////////////////////////////////////////
+const math::SphericalCoordinates &NavSatSensor::SphericalCoordinates() const
+{
+  return this->dataPtr->origin;
+}
+
+//////////////////////////////////////////////////
+void NavSatSensor::SetWorldPosition(const math::Vector3d &_pos)
+{
+  const math::Vector3d spherical = this->dataPtr->Convert(_pos);
+  this->SetPosition(GZ_DTOR(spherical.X()), GZ_DTOR(spherical.Y()),
+      spherical.Z());
+}
+
+//////////////////////////////////////////////////
+void NavSatSensor::SetWorldVelocity(const math::Vector3d &_vel)
+{
+  this->SetVelocity(this->dataPtr->origin.GlobalFromLocalVelocity(_vel));
+}
+
+//////////////////////////////////////////////////
+void NavSatSensor::SetLinearizationDistance(double _distance)
+{
+  this->dataPtr->linearizationDistance = std::max(0.0, _distance);
+  this->dataPtr->linearized = false;
+}
+
+//////////////////////////////////////////////////
+double NavSatSensor::LinearizationDistance() const
+{
+  return this->dataPtr->linearizationDistance;
+}
+
 //////////////////////////////////////////////////
 void NavSatSensor::SetLatitude(const math::Angle &_latitude)
 {
@@ -21,16 +21,43 @@
   #include <Winsock2.h>
 #endif
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
+#include <string>
 
 #include <gz/common/Console.hh>
 
+#include "gz/sensors/DitheredQuantizationNoiseModel.hh"
+#include "gz/sensors/FlickerNoiseModel.hh"
+#include "gz/sensors/GaussMarkovNoiseModel.hh"
 #include "gz/sensors/GaussianNoiseModel.hh"
 #include "gz/sensors/Noise.hh"
 
+#include "TraceRecorder.hh"
+
 using namespace gz;
 using namespace sensors;
 
+namespace
+{
+  /// \brief Apply a function to a strided buffer and clamp the finite
+  /// results.
+  template <typename T, typename F>
+  void ApplyEach(T *_data, std::size_t _count, std::size_t _stride,
+      double _min, double _max, F _func)
+  {
+    for (std::size_t i = 0u; i < _count; ++i)
+    {
+      T &value = _data[i * _stride];
+      double out = _func(static_cast<double>(value));
+      if (std::isfinite(out))
+        out = std::min(std::max(out, _min), _max);
+      value = static_cast<T>(out);
+    }
+  }
+}
+
 class gz::sensors::NoisePrivate
 {
   /// \brief Which type of noise we're applying
@@ -47,6 +74,7 @@ class gz::sensors::NoisePrivate
 NoisePtr NoiseFactory::NewNoiseModel(const sdf::Noise &_sdf,
     const std::string &_sensorType)
 {
+  TraceScope trace("create_noise", kFactoryTraceTrack);
   sdf::NoiseType noiseType = _sdf.Type();
 
   NoisePtr noise;
@@ -65,11 +93,36 @@ NoisePtr NoiseFactory::NewNoiseModel(const sdf::Noise &_sdf,
              << std::endl;
       return noise;
     }
-    else
-      noise.reset(new GaussianNoiseModel());
 
-    GZ_ASSERT(noise->Type() == NoiseType::GAUSSIAN,
-        "Noise type should be 'gaussian'");
+    // Models that SDFormat doesn't describe
+    std::string gzType;
+    if (_sdf.Element() != nullptr && _sdf.Element()->HasAttribute("gz:type"))
+      gzType = _sdf.Element()->Get<std::string>("gz:type");
+
+    if (gzType.empty())
+    {
+      noise.reset(new GaussianNoiseModel());
+      GZ_ASSERT(noise->Type() == NoiseType::GAUSSIAN,
+          "Noise type should be 'gaussian'");
+    }
+    else if (gzType == "gauss_markov")
+    {
+      noise.reset(new GaussMarkovNoiseModel());
+    }
+    else if (gzType == "flicker")
+    {
+      noise.reset(new FlickerNoiseModel());
+    }
+    else if (gzType == "dithered_quantization")
+    {
+      noise.reset(new DitheredQuantizationNoiseModel());
+    }
+    else
+    {
+      gzerr << "Unrecognized noise `gz:type` [" << gzType << "]"
+            << std::endl;
+      return NoisePtr();
+    }
   }
   else if (noiseType == sdf::NoiseType::NONE)
   {
@@ -149,6 +202,84 @@ double Noise::ApplyImpl(double _in, double /*_dt*/)
   return _in;
 }
 
+//////////////////////////////////////////////////
+void Noise::ApplyBatch(double *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  this->ApplyBatchTemplate(_data, _count, _stride, _dt, _min, _max);
+}
+
+//////////////////////////////////////////////////
+void Noise::ApplyBatch(float *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  this->ApplyBatchTemplate(_data, _count, _stride, _dt, _min, _max);
+}
+
+//////////////////////////////////////////////////
+template <typename T>
+void Noise::ApplyBatchTemplate(T *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  if (_data == nullptr || _count == 0u)
+    return;
+
+  if (this->dataPtr->type == NoiseType::NONE)
+  {
+    ApplyEach(_data, _count, _stride, _min, _max,
+        [](double _in) {return _in;});
+  }
+  else if (this->dataPtr->type == NoiseType::CUSTOM)
+  {
+    if (!this->dataPtr->customNoiseCallback)
+    {
+      gzerr << "Custom noise callback function not set!"
+          << " Please call SetCustomNoiseCallback within a sensor plugin."
+          << std::endl;
+      return;
+    }
+    auto &cb = this->dataPtr->customNoiseCallback;
+    ApplyEach(_data, _count, _stride, _min, _max,
+        [&cb, _dt](double _in) {return cb(_in, _dt);});
+  }
+  else
+  {
+    this->ApplyBatchImpl(_data, _count, _stride, _dt, _min, _max);
+  }
+}
+
+//////////////////////////////////////////////////
+void Noise::ApplyBatchImpl(double *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  ApplyEach(_data, _count, _stride, _min, _max,
+      [this, _dt](double _in) {return this->ApplyImpl(_in, _dt);});
+}
+
+//////////////////////////////////////////////////
+void Noise::ApplyBatchImpl(float *_data, std::size_t _count,
+    std::size_t _stride, double _dt, double _min, double _max)
+{
+  ApplyEach(_data, _count, _stride, _min, _max,
+      [this, _dt](double _in) {return this->ApplyImpl(_in, _dt);});
+}
+
+//////////////////////////////////////////////////
+void Noise::SetSeed(uint64_t /*_seed*/)
+{
+}
+
+//////////////////////////////////////////////////
+void Noise::SaveState(SensorState &/*_state*/) const
+{
+}
+
+//////////////////////////////////////////////////
+bool Noise::RestoreState(SensorState &/*_state*/)
+{
+  return true;
+}
+
 //////////////////////////////////////////////////
 NoiseType Noise::Type() const
 {
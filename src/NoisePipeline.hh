@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_NOISEPIPELINE_HH_
+#define GZ_SENSORS_NOISEPIPELINE_HH_
+
+#include <array>
+#include <cstddef>
+#include <typeinfo>
+#include <utility>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/GaussianNoiseModel.hh"
+#include "gz/sensors/Noise.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Noise of a fixed number of channels, such as the axes of an
+    /// IMU, with the models of a sensor resolved once when it loads.
+    /// Applying it then doesn't check the type of every model for every
+    /// sample. Channels without noise are skipped up front. If every
+    /// remaining model is a plain GaussianNoiseModel, they are called
+    /// directly, without the virtual call, through a loop whose length is
+    /// a compile time constant. Other models go through Noise::Apply. The
+    /// channels are applied in order, so the random numbers drawn are the
+    /// same as applying each model in turn.
+    /// \tparam N Number of channels.
+    template <std::size_t N>
+    class NoisePipeline
+    {
+      /// \brief Resolve the models of the channels. Call it again if a
+      /// model is replaced or given a custom callback.
+      /// \param[in] _noises Model of each channel, may be null.
+      public: void Load(const std::array<NoisePtr, N> &_noises)
+      {
+        this->noises = _noises;
+        this->count = 0u;
+        bool gaussian = true;
+        for (std::size_t i = 0u; i < N; ++i)
+        {
+          Noise *noise = _noises[i].get();
+          if (!noise || noise->Type() == NoiseType::NONE)
+            continue;
+          gaussian = gaussian && noise->Type() == NoiseType::GAUSSIAN &&
+              typeid(*noise) == typeid(GaussianNoiseModel);
+          this->channels[this->count] = i;
+          this->models[this->count] = noise;
+          ++this->count;
+        }
+
+        if (this->count == 0u)
+          this->apply = &NoisePipeline::ApplyNone;
+        else if (gaussian)
+          this->apply = GaussianTable()[this->count];
+        else
+          this->apply = &NoisePipeline::ApplyDynamic;
+      }
+
+      /// \brief Apply the noise of every channel.
+      /// \param[in,out] _values Value of each channel.
+      /// \param[in] _dt Time step.
+      public: void Apply(const std::array<double *, N> &_values,
+                  double _dt = 0.0)
+      {
+        (this->*apply)(_values, _dt);
+      }
+
+      /// \brief Advance the state of the models as if noise was applied,
+      /// drawing the same random numbers.
+      /// \param[in] _dt Time step.
+      public: void Advance(double _dt)
+      {
+        std::array<double, N> values{};
+        std::array<double *, N> pointers;
+        for (std::size_t i = 0u; i < N; ++i)
+          pointers[i] = &values[i];
+        this->Apply(pointers, _dt);
+      }
+
+      /// \brief Get the number of channels with noise.
+      /// \return Number of channels.
+      public: std::size_t Count() const
+      {
+        return this->count;
+      }
+
+      /// \brief Get whether the models are called without virtual calls.
+      /// \return True if every channel with noise is Gaussian.
+      public: bool Specialized() const
+      {
+        return this->count > 0u && this->apply != &NoisePipeline::ApplyDynamic;
+      }
+
+      /// \brief Pointer to the function applying the noise.
+      private: using ApplyFunction = void (NoisePipeline::*)(
+                   const std::array<double *, N> &, double);
+
+      /// \brief Apply no noise.
+      private: void ApplyNone(const std::array<double *, N> &, double)
+      {
+      }
+
+      /// \brief Apply Gaussian models without virtual calls.
+      /// \tparam M Number of channels with noise.
+      /// \param[in,out] _values Value of each channel.
+      /// \param[in] _dt Time step.
+      private: template <std::size_t M>
+      void ApplyGaussian(const std::array<double *, N> &_values, double _dt)
+      {
+        for (std::size_t i = 0u; i < M; ++i)
+        {
+          double &value = *_values[this->channels[i]];
+          value = static_cast<GaussianNoiseModel *>(this->models[i])
+              ->GaussianNoiseModel::ApplyImpl(value, _dt);
+        }
+      }
+
+      /// \brief Apply any model through Noise::Apply.
+      /// \param[in,out] _values Value of each channel.
+      /// \param[in] _dt Time step.
+      private: void ApplyDynamic(const std::array<double *, N> &_values,
+                   double _dt)
+      {
+        for (std::size_t i = 0u; i < this->count; ++i)
+        {
+          double &value = *_values[this->channels[i]];
+          value = this->models[i]->Apply(value, _dt);
+        }
+      }
+
+      /// \brief Get the Gaussian functions by number of channels with
+      /// noise.
+      /// \return Function of each number of channels.
+      private: static const std::array<ApplyFunction, N + 1> &GaussianTable()
+      {
+        static const std::array<ApplyFunction, N + 1> table =
+            MakeGaussianTable(std::make_index_sequence<N + 1>());
+        return table;
+      }
+
+      /// \brief Build the Gaussian functions by number of channels.
+      /// \return Function of each number of channels.
+      private: template <std::size_t... Ms>
+      static std::array<ApplyFunction, N + 1> MakeGaussianTable(
+          std::index_sequence<Ms...>)
+      {
+        return {&NoisePipeline::template ApplyGaussian<Ms>...};
+      }
+
+      /// \brief Models of the channels, which keep them alive.
+      private: std::array<NoisePtr, N> noises;
+
+      /// \brief Index of each channel with noise.
+      private: std::array<std::size_t, N> channels{};
+
+      /// \brief Model of each channel with noise.
+      private: std::array<Noise *, N> models{};
+
+      /// \brief Number of channels with noise.
+      private: std::size_t count{0u};
+
+      /// \brief Function applying the noise.
+      private: ApplyFunction apply{&NoisePipeline::ApplyNone};
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+
+#include <sdf/Noise.hh>
+
+#include "gz/sensors/GaussianNoiseModel.hh"
+#include "gz/sensors/Noise.hh"
+#include "NoisePipeline.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Create a seeded Gaussian noise model.
+/// \param[in] _stdDev Standard deviation.
+/// \param[in] _precision Precision, 0 if not quantized.
+/// \param[in] _seed Seed.
+/// \return Noise model.
+NoisePtr Gaussian(double _stdDev, double _precision, uint64_t _seed)
+{
+  sdf::Noise sdf;
+  sdf.SetType(sdf::NoiseType::GAUSSIAN);
+  sdf.SetStdDev(_stdDev);
+  sdf.SetBiasMean(0.1);
+  sdf.SetDynamicBiasStdDev(0.01);
+  sdf.SetDynamicBiasCorrelationTime(2.0);
+  sdf.SetPrecision(_precision);
+  NoisePtr noise = NoiseFactory::NewNoiseModel(sdf);
+  noise->SetSeed(_seed);
+  return noise;
+}
+}
+
+//////////////////////////////////////////////////
+TEST(NoisePipeline, Empty)
+{
+  NoisePipeline<3> pipeline;
+  double x = 1.0, y = 2.0, z = 3.0;
+  pipeline.Apply({&x, &y, &z}, 0.1);
+
+  pipeline.Load({nullptr, std::make_shared<Noise>(NoiseType::NONE),
+      nullptr});
+  EXPECT_EQ(0u, pipeline.Count());
+  EXPECT_FALSE(pipeline.Specialized());
+  pipeline.Apply({&x, &y, &z}, 0.1);
+  EXPECT_DOUBLE_EQ(1.0, x);
+  EXPECT_DOUBLE_EQ(2.0, y);
+  EXPECT_DOUBLE_EQ(3.0, z);
+}
+
+//////////////////////////////////////////////////
+TEST(NoisePipeline, MatchesModels)
+{
+  // The pipeline draws the same numbers as applying each model in turn
+  const std::array<NoisePtr, 3> expected = {
+      Gaussian(0.5, 0.0, 1u), nullptr, Gaussian(0.2, 0.01, 2u)};
+  const std::array<NoisePtr, 3> noises = {
+      Gaussian(0.5, 0.0, 1u), nullptr, Gaussian(0.2, 0.01, 2u)};
+
+  NoisePipeline<3> pipeline;
+  pipeline.Load(noises);
+  EXPECT_EQ(2u, pipeline.Count());
+  EXPECT_TRUE(pipeline.Specialized());
+
+  for (int i = 0; i < 100; ++i)
+  {
+    std::array<double, 3> values = {1.0 * i, 2.0, -3.0 * i};
+    std::array<double, 3> reference = values;
+    for (std::size_t c = 0u; c < 3u; ++c)
+    {
+      if (expected[c])
+        reference[c] = expected[c]->Apply(reference[c], 0.01);
+    }
+    pipeline.Apply({&values[0], &values[1], &values[2]}, 0.01);
+    for (std::size_t c = 0u; c < 3u; ++c)
+      EXPECT_DOUBLE_EQ(reference[c], values[c]) << i << " " << c;
+  }
+
+  // Advancing draws the same numbers too
+  pipeline.Advance(0.01);
+  for (std::size_t c = 0u; c < 3u; ++c)
+  {
+    if (expected[c])
+      expected[c]->Apply(0.0, 0.01);
+  }
+  double a = 0.0, b = 0.0, d = 0.0;
+  pipeline.Apply({&a, &b, &d}, 0.01);
+  EXPECT_DOUBLE_EQ(expected[0]->Apply(0.0, 0.01), a);
+  EXPECT_DOUBLE_EQ(0.0, b);
+  EXPECT_DOUBLE_EQ(expected[2]->Apply(0.0, 0.01), d);
+}
+
+//////////////////////////////////////////////////
+TEST(NoisePipeline, CustomFallback)
+{
+  // Models that aren't Gaussian go through Noise::Apply
+  auto custom = std::make_shared<Noise>(NoiseType::NONE);
+  custom->SetCustomNoiseCallback([](double _in, double _dt)
+  {
+    return _in * 2.0 + _dt;
+  });
+
+  NoisePipeline<2> pipeline;
+  pipeline.Load({Gaussian(0.0, 0.0, 3u), custom});
+  EXPECT_EQ(2u, pipeline.Count());
+  EXPECT_FALSE(pipeline.Specialized());
+
+  double x = 0.0, y = 1.5;
+  pipeline.Apply({&x, &y}, 0.5);
+  EXPECT_DOUBLE_EQ(3.5, y);
+}
@@ -17,7 +17,11 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <limits>
 #include <numeric>
+#include <utility>
+#include <vector>
 
 #include <gz/common/Console.hh>
 #include <gz/math/Rand.hh>
@@ -26,6 +30,7 @@
 
 #include "gz/sensors/Noise.hh"
 #include "gz/sensors/GaussianNoiseModel.hh"
+#include "gz/sensors/SensorState.hh"
 
 using namespace gz;
 
@@ -57,6 +62,56 @@ sdf::ElementPtr NoiseSdf(const std::string &_type, double _mean,
   return sdf;
 }
 
+////////////////////////////////////////////////////////////////
+// Helper function that constructs sdf strings for noise models selected
+// with a gz:type attribute
+sdf::ElementPtr GzNoiseSdf(const std::string &_gzType, double _mean,
+  double _stddev, double _correlationTime, double _precision)
+{
+  std::ostringstream noiseStream;
+  noiseStream << "<sdf version='1.9'>"
+              << "  <noise type='gaussian' gz:type='" << _gzType << "'>"
+              << "    <mean>" << _mean << "</mean>"
+              << "    <stddev>" << _stddev << "</stddev>"
+              << "    <dynamic_bias_correlation_time>" << _correlationTime
+              << "    </dynamic_bias_correlation_time>"
+              << "    <precision>" << _precision << "</precision>"
+              << "  </noise>"
+              << "</sdf>";
+
+  sdf::ElementPtr sdf(new sdf::Element);
+  sdf::initFile("noise.sdf", sdf);
+  sdf::readString(noiseStream.str(), sdf);
+
+  return sdf;
+}
+
+////////////////////////////////////////////////////////////////
+// Helper function that constructs sdf strings for gaussian noise with a
+// dynamic bias
+sdf::ElementPtr DynamicBiasNoiseSdf(double _stddev, double _correlationTime,
+  double _precision)
+{
+  std::ostringstream noiseStream;
+  noiseStream << "<sdf version='1.6'>"
+              << "  <noise type='gaussian'>"
+              << "    <mean>0</mean>"
+              << "    <stddev>0</stddev>"
+              << "    <dynamic_bias_stddev>" << _stddev
+              << "    </dynamic_bias_stddev>"
+              << "    <dynamic_bias_correlation_time>" << _correlationTime
+              << "    </dynamic_bias_correlation_time>"
+              << "    <precision>" << _precision << "</precision>"
+              << "  </noise>"
+              << "</sdf>";
+
+  sdf::ElementPtr sdf(new sdf::Element);
+  sdf::initFile("noise.sdf", sdf);
+  sdf::readString(noiseStream.str(), sdf);
+
+  return sdf;
+}
+
 /// \brief Test sensor noise
 class NoiseTest : public ::testing::Test
 {
@@ -440,3 +495,339 @@ TEST(NoiseTest, NoiseFailures)
      sensors::NoiseFactory::NewNoiseModel(
      sdfNoise, "camera");
 }
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, ApplyBatch)
+{
+  // No noise, only clamping of finite values
+  sensors::NoisePtr noNoise =
+    sensors::NoiseFactory::NewNoiseModel(NoiseSdf("none", 0, 0, 0, 0, 0));
+  double data[] = {-5.0, 0.5, 5.0, std::numeric_limits<double>::infinity()};
+  noNoise->ApplyBatch(data, 4u, 1u, 0.0, 0.0, 1.0);
+  EXPECT_DOUBLE_EQ(0.0, data[0]);
+  EXPECT_DOUBLE_EQ(0.5, data[1]);
+  EXPECT_DOUBLE_EQ(1.0, data[2]);
+  EXPECT_TRUE(std::isinf(data[3]));
+
+  // Custom noise, strided float buffer
+  sensors::NoisePtr custom(new sensors::Noise(sensors::NoiseType::CUSTOM));
+  custom->SetCustomNoiseCallback(
+    std::bind(&OnApplyCustomNoise,
+      std::placeholders::_1, std::placeholders::_2));
+  float strided[] = {1.0f, 7.0f, 2.0f, 7.0f, 3.0f, 7.0f};
+  custom->ApplyBatch(strided, 3u, 2u);
+  EXPECT_FLOAT_EQ(2.0f, strided[0]);
+  EXPECT_FLOAT_EQ(7.0f, strided[1]);
+  EXPECT_FLOAT_EQ(4.0f, strided[2]);
+  EXPECT_FLOAT_EQ(7.0f, strided[3]);
+  EXPECT_FLOAT_EQ(6.0f, strided[4]);
+  EXPECT_FLOAT_EQ(7.0f, strided[5]);
+
+  // Gaussian noise with bias and precision, stays within 5 sigma
+  const double mean = 1.5;
+  const double stddev = 0.1;
+  const double bias = 2.0;
+  const double precision = 0.3;
+  sensors::NoisePtr gaussian = sensors::NoiseFactory::NewNoiseModel(
+      NoiseSdf("gaussian", mean, stddev, bias, 0, precision));
+  auto gaussianModel =
+    std::dynamic_pointer_cast<sensors::GaussianNoiseModel>(gaussian);
+  ASSERT_NE(nullptr, gaussianModel);
+  std::vector<float> values(1000u, 10.0f);
+  gaussian->ApplyBatch(values.data(), values.size());
+  for (auto value : values)
+  {
+    EXPECT_NEAR(10.0 + mean + gaussianModel->Bias(), value,
+        g_sigma * stddev + precision);
+    EXPECT_NEAR(std::round(value / precision) * precision, value, 1e-4);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, DynamicBiasTimeStep)
+{
+  // Without white noise or a constant bias, the output is the input plus
+  // the dynamic bias
+  const double stddev = 0.5;
+  const double correlationTime = 2.0;
+  sensors::NoisePtr noise = sensors::NoiseFactory::NewNoiseModel(
+      DynamicBiasNoiseSdf(stddev, correlationTime, 0));
+  ASSERT_NE(nullptr, noise);
+  noise->SetSeed(9u);
+
+  // Lag one autocorrelation and variance of the bias over a time step
+  auto biasStats = [&](double _dt, bool _batch)
+  {
+    std::vector<double> bias(4000u);
+    for (auto &b : bias)
+    {
+      if (_batch)
+      {
+        b = 0.0;
+        noise->ApplyBatch(&b, 1u, 1u, _dt);
+      }
+      else
+      {
+        b = noise->Apply(0.0, _dt);
+      }
+    }
+    const double mean =
+        std::accumulate(bias.begin(), bias.end(), 0.0) / bias.size();
+    double variance = 0.0;
+    double covariance = 0.0;
+    for (std::size_t i = 0u; i < bias.size(); ++i)
+    {
+      variance += (bias[i] - mean) * (bias[i] - mean);
+      if (i + 1u < bias.size())
+        covariance += (bias[i] - mean) * (bias[i + 1u] - mean);
+    }
+    return std::make_pair(covariance / variance, variance / bias.size());
+  };
+
+  // The discretization is cached for the first time step
+  for (int i = 0; i < 50; ++i)
+    noise->Apply(0.0, 0.01);
+
+  // A longer time step decorrelates the bias faster. A stale decay factor
+  // would keep the correlation of the short step, and a stale increment
+  // would shrink the variance below its stationary value.
+  auto stats = biasStats(1.0, false);
+  const double variance = stddev * stddev * correlationTime / 2.0;
+  EXPECT_NEAR(std::exp(-1.0 / correlationTime), stats.first, 0.06);
+  EXPECT_NEAR(variance, stats.second, 0.2 * variance);
+
+  // Changing the time step back recomputes the discretization again
+  stats = biasStats(0.01, true);
+  EXPECT_GT(stats.first, 0.97);
+}
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, DynamicBiasQuantized)
+{
+  const double precision = 0.25;
+  sensors::NoisePtr noise = sensors::NoiseFactory::NewNoiseModel(
+      DynamicBiasNoiseSdf(0.5, 2.0, precision));
+  ASSERT_NE(nullptr, noise);
+  noise->SetSeed(13u);
+
+  // Quantized output rounds whatever the time step
+  const double steps[] = {0.01, 0.01, 1.0, 0.5, 0.01};
+  for (double dt : steps)
+  {
+    const double value = noise->Apply(0.1, dt);
+    EXPECT_NEAR(std::round(value / precision) * precision, value, 1e-9);
+
+    std::vector<float> batch(8u, 0.1f);
+    noise->ApplyBatch(batch.data(), batch.size(), 1u, dt);
+    for (float v : batch)
+      EXPECT_FLOAT_EQ(std::round(v / precision) * precision, v);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, SetSeed)
+{
+  auto makeNoise = []()
+  {
+    return sensors::NoiseFactory::NewNoiseModel(
+        NoiseSdf("gaussian", 0.5, 0.2, 1.0, 0.3, 0));
+  };
+
+  // Same seed, same sequence, even if the global generator is used in
+  // between
+  sensors::NoisePtr a = makeNoise();
+  sensors::NoisePtr b = makeNoise();
+  a->SetSeed(42u);
+  b->SetSeed(42u);
+  std::vector<double> batchA(11u, 1.0);
+  std::vector<double> batchB(11u, 1.0);
+  for (int i = 0; i < 10; ++i)
+  {
+    math::Rand::DblNormal(0, 1);
+    EXPECT_DOUBLE_EQ(a->Apply(1.0, 0.01), b->Apply(1.0, 0.01));
+  }
+  a->ApplyBatch(batchA.data(), batchA.size());
+  b->ApplyBatch(batchB.data(), batchB.size());
+  EXPECT_EQ(batchA, batchB);
+
+  // Different seeds, different sequences
+  sensors::NoisePtr c = makeNoise();
+  c->SetSeed(43u);
+  a->SetSeed(42u);
+  EXPECT_NE(a->Apply(1.0), c->Apply(1.0));
+
+  // Noise without random numbers ignores the seed
+  sensors::Noise none(sensors::NoiseType::NONE);
+  none.SetSeed(42u);
+  EXPECT_DOUBLE_EQ(3.0, none.Apply(3.0));
+}
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, SaveState)
+{
+  std::vector<sensors::NoisePtr> noises = {
+      sensors::NoiseFactory::NewNoiseModel(
+          NoiseSdf("gaussian", 0.5, 0.2, 1.0, 0.3, 0)),
+      sensors::NoiseFactory::NewNoiseModel(
+          GzNoiseSdf("gauss_markov", 0, 1, 0.1, 0)),
+      sensors::NoiseFactory::NewNoiseModel(
+          GzNoiseSdf("flicker", 0, 1, 1, 0)),
+      sensors::NoiseFactory::NewNoiseModel(
+          GzNoiseSdf("dithered_quantization", 0, 0, 0, 0.1))};
+
+  for (auto &noise : noises)
+  {
+    ASSERT_NE(nullptr, noise);
+    noise->SetSeed(5u);
+    for (int i = 0; i < 10; ++i)
+      noise->Apply(1.0, 0.01);
+
+    sensors::SensorState state;
+    noise->SaveState(state);
+    std::vector<double> expected(16u, 1.0);
+    noise->ApplyBatch(expected.data(), expected.size(), 1u, 0.01);
+    double expectedSingle = noise->Apply(1.0, 0.01);
+
+    // The restored model continues the same sequence
+    EXPECT_TRUE(noise->RestoreState(state));
+    EXPECT_TRUE(state.AtEnd());
+    std::vector<double> values(16u, 1.0);
+    noise->ApplyBatch(values.data(), values.size(), 1u, 0.01);
+    EXPECT_EQ(expected, values);
+    EXPECT_DOUBLE_EQ(expectedSingle, noise->Apply(1.0, 0.01));
+
+    // Truncated state
+    sensors::SensorState empty;
+    EXPECT_FALSE(noise->RestoreState(empty));
+  }
+
+  // Noise without state
+  sensors::Noise none(sensors::NoiseType::NONE);
+  sensors::SensorState state;
+  none.SaveState(state);
+  EXPECT_EQ(0u, state.Size());
+  EXPECT_TRUE(none.RestoreState(state));
+}
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, GzTypes)
+{
+  auto noise = sensors::NoiseFactory::NewNoiseModel(
+      GzNoiseSdf("gauss_markov", 0, 1, 1, 0));
+  ASSERT_NE(nullptr, noise);
+  EXPECT_EQ(sensors::NoiseType::GAUSS_MARKOV, noise->Type());
+
+  noise = sensors::NoiseFactory::NewNoiseModel(
+      GzNoiseSdf("flicker", 0, 1, 1, 0));
+  ASSERT_NE(nullptr, noise);
+  EXPECT_EQ(sensors::NoiseType::FLICKER, noise->Type());
+
+  noise = sensors::NoiseFactory::NewNoiseModel(
+      GzNoiseSdf("dithered_quantization", 0, 1, 0, 0.1));
+  ASSERT_NE(nullptr, noise);
+  EXPECT_EQ(sensors::NoiseType::DITHERED_QUANTIZATION, noise->Type());
+
+  EXPECT_EQ(nullptr, sensors::NoiseFactory::NewNoiseModel(
+      GzNoiseSdf("unknown", 0, 1, 1, 0)));
+}
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, ApplyGaussMarkov)
+{
+  const double mean = 2.0;
+  const double stddev = 0.5;
+  const double tau = 0.1;
+  const double dt = 0.01;
+  auto noise = sensors::NoiseFactory::NewNoiseModel(
+      GzNoiseSdf("gauss_markov", mean, stddev, tau, 0));
+  ASSERT_NE(nullptr, noise);
+  noise->SetSeed(7u);
+
+  const int count = 20000;
+  std::vector<double> values(count);
+  for (auto &v : values)
+    v = noise->Apply(0.0, dt) - mean;
+
+  double sum = 0.0;
+  double sumSq = 0.0;
+  double sumLag = 0.0;
+  for (int i = 0; i < count; ++i)
+  {
+    sum += values[i];
+    sumSq += values[i] * values[i];
+    if (i > 0)
+      sumLag += values[i] * values[i - 1];
+  }
+  const double variance = sumSq / count;
+  EXPECT_NEAR(0.0, sum / count, 0.1);
+  EXPECT_NEAR(stddev, std::sqrt(variance), 0.1);
+
+  // Consecutive samples are correlated by exp(-dt / tau)
+  EXPECT_NEAR(std::exp(-dt / tau), sumLag / (count - 1) / variance, 0.05);
+
+  // Without a time step, samples are uncorrelated
+  double sumLag0 = 0.0;
+  double prev = noise->Apply(0.0) - mean;
+  for (int i = 0; i < count; ++i)
+  {
+    double v = noise->Apply(0.0) - mean;
+    sumLag0 += v * prev;
+    prev = v;
+  }
+  EXPECT_NEAR(0.0, sumLag0 / count / (stddev * stddev), 0.05);
+}
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, ApplyFlicker)
+{
+  const double stddev = 0.3;
+  auto noise = sensors::NoiseFactory::NewNoiseModel(
+      GzNoiseSdf("flicker", 0, stddev, 10.0, 0));
+  ASSERT_NE(nullptr, noise);
+  noise->SetSeed(11u);
+
+  // Each value of a batch is its own filter bank
+  std::vector<double> batch(20000u, 0.0);
+  noise->ApplyBatch(batch.data(), batch.size(), 1u, 0.01);
+  double sumSq = 0.0;
+  for (double v : batch)
+    sumSq += v * v;
+  EXPECT_NEAR(stddev, std::sqrt(sumSq / batch.size()), 0.02);
+
+  // The slowest process dominates, so consecutive small steps barely move
+  std::vector<double> next(batch.size(), 0.0);
+  noise->ApplyBatch(next.data(), next.size(), 1u, 1e-4);
+  double sumDiffSq = 0.0;
+  for (std::size_t i = 0u; i < batch.size(); ++i)
+    sumDiffSq += (next[i] - batch[i]) * (next[i] - batch[i]);
+  EXPECT_LT(std::sqrt(sumDiffSq / batch.size()), stddev * 0.5);
+}
+
+/////////////////////////////////////////////////
+TEST(NoiseTest, ApplyDitheredQuantization)
+{
+  const double precision = 1.0;
+  auto noise = sensors::NoiseFactory::NewNoiseModel(
+      GzNoiseSdf("dithered_quantization", 0, 0, 0, precision));
+  ASSERT_NE(nullptr, noise);
+  noise->SetSeed(3u);
+
+  // Plain rounding would always give 0, dither preserves the mean
+  std::vector<float> batch(20000u, 0.3f);
+  noise->ApplyBatch(batch.data(), batch.size());
+  double sum = 0.0;
+  for (float v : batch)
+  {
+    EXPECT_DOUBLE_EQ(std::round(v / precision) * precision, v);
+    sum += v;
+  }
+  EXPECT_NEAR(0.3, sum / batch.size(), 0.02);
+
+  // Same seed, same output
+  auto other = sensors::NoiseFactory::NewNoiseModel(
+      GzNoiseSdf("dithered_quantization", 0, 0, 0, precision));
+  other->SetSeed(3u);
+  std::vector<float> otherBatch(batch.size(), 0.3f);
+  other->ApplyBatch(otherBatch.data(), otherBatch.size());
+  EXPECT_EQ(batch, otherBatch);
+}
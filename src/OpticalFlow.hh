@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_OPTICALFLOW_HH_
+#define GZ_SENSORS_OPTICALFLOW_HH_
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include <gz/math/Pose3.hh>
+#include <gz/math/Vector3.hh>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Compute the optical flow of a static scene between two frames
+    /// of a moving pinhole camera, from the depths of the second frame. Each
+    /// pixel is back projected at its depth, moved into the camera frame of
+    /// the first pose and projected again, so the flow is the motion of the
+    /// pixel from the first frame to the second. Only the camera moves:
+    /// objects moving in the scene get the flow of a static object at the
+    /// same place. Cameras look along their +X axis, with +Y to the left of
+    /// the image and +Z up, as rendering cameras do.
+    /// \param[in] _depth Depths of the second frame along the X axis of the
+    /// camera, _width * _height, row major.
+    /// \param[in] _width Image width.
+    /// \param[in] _height Image height.
+    /// \param[in] _hfov Horizontal field of view in radians. Pixels are
+    /// square.
+    /// \param[in] _prevPose Pose of the camera at the first frame.
+    /// \param[in] _pose Pose of the camera at the second frame, in the same
+    /// frame as _prevPose.
+    /// \param[out] _flow 3 floats per pixel: the rightward and downward
+    /// motion of the pixel in pixels and its depth. The motion is NaN
+    /// where the depth isn't finite and positive, or where the point was
+    /// behind the camera in the first frame.
+    inline void StaticSceneFlow(const float *_depth, unsigned int _width,
+        unsigned int _height, double _hfov, const math::Pose3d &_prevPose,
+        const math::Pose3d &_pose, float *_flow)
+    {
+      const float nan = std::numeric_limits<float>::quiet_NaN();
+      const double cx = _width * 0.5;
+      const double cy = _height * 0.5;
+      const double f = cx / std::tan(_hfov * 0.5);
+
+      // Pose of the second frame in the first one, as the images of the
+      // camera axes and its origin
+      const math::Pose3d relative = _prevPose.Inverse() * _pose;
+      const math::Vector3d ex =
+          relative.Rot().RotateVector(math::Vector3d::UnitX);
+      const math::Vector3d ey =
+          relative.Rot().RotateVector(math::Vector3d::UnitY);
+      const math::Vector3d ez =
+          relative.Rot().RotateVector(math::Vector3d::UnitZ);
+      const math::Vector3d &t = relative.Pos();
+
+      for (unsigned int v = 0u; v < _height; ++v)
+      {
+        // Pixel centers, on a plane at unit depth
+        const double z = (cy - (v + 0.5)) / f;
+        for (unsigned int u = 0u; u < _width; ++u)
+        {
+          const std::size_t index =
+              static_cast<std::size_t>(v) * _width + u;
+          const double depth = _depth[index];
+          float *flow = _flow + index * 3u;
+          flow[2] = _depth[index];
+          if (!(depth > 0.0) || !std::isfinite(depth))
+          {
+            flow[0] = flow[1] = nan;
+            continue;
+          }
+
+          const double y = (cx - (u + 0.5)) / f;
+          const math::Vector3d p = (ex + ey * y + ez * z) * depth + t;
+          if (!(p.X() > 0.0))
+          {
+            flow[0] = flow[1] = nan;
+            continue;
+          }
+          const double prevU = cx - f * p.Y() / p.X();
+          const double prevV = cy - f * p.Z() / p.X();
+          flow[0] = static_cast<float>(u + 0.5 - prevU);
+          flow[1] = static_cast<float>(v + 0.5 - prevV);
+        }
+      }
+    }
+    }
+  }
+}
+
+#endif
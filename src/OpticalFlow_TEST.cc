@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gz/math/Pose3.hh>
+
+#include "OpticalFlow.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+constexpr unsigned int kWidth = 7u;
+constexpr unsigned int kHeight = 5u;
+constexpr double kHfov = 1.2;
+
+//////////////////////////////////////////////////
+/// \brief Focal length of the test camera in pixels.
+double FocalLength()
+{
+  return kWidth * 0.5 / std::tan(kHfov * 0.5);
+}
+}
+
+//////////////////////////////////////////////////
+TEST(OpticalFlow_TEST, StaticCamera)
+{
+  std::vector<float> depth(kWidth * kHeight, 2.0f);
+  depth[3] = std::numeric_limits<float>::infinity();
+  depth[4] = 0.0f;
+  std::vector<float> flow(depth.size() * 3u);
+  const math::Pose3d pose(1, 2, 3, 0.1, 0.2, 0.3);
+  StaticSceneFlow(depth.data(), kWidth, kHeight, kHfov, pose, pose,
+      flow.data());
+
+  for (std::size_t i = 0u; i < depth.size(); ++i)
+  {
+    EXPECT_FLOAT_EQ(depth[i], flow[i * 3u + 2u]);
+    if (i == 3u || i == 4u)
+    {
+      EXPECT_TRUE(std::isnan(flow[i * 3u]));
+      EXPECT_TRUE(std::isnan(flow[i * 3u + 1u]));
+      continue;
+    }
+    EXPECT_NEAR(0.0f, flow[i * 3u], 1e-5f);
+    EXPECT_NEAR(0.0f, flow[i * 3u + 1u], 1e-5f);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(OpticalFlow_TEST, Translation)
+{
+  const float d = 4.0f;
+  std::vector<float> depth(kWidth * kHeight, d);
+  std::vector<float> flow(depth.size() * 3u);
+
+  // Moving left shifts the scene right by f * b / d, moving down shifts it
+  // up
+  const double b = 0.2;
+  StaticSceneFlow(depth.data(), kWidth, kHeight, kHfov,
+      math::Pose3d(5, 0, 0, 0, 0, 0), math::Pose3d(5, b, -b, 0, 0, 0),
+      flow.data());
+  for (std::size_t i = 0u; i < depth.size(); ++i)
+  {
+    EXPECT_NEAR(FocalLength() * b / d, flow[i * 3u], 1e-4);
+    EXPECT_NEAR(-FocalLength() * b / d, flow[i * 3u + 1u], 1e-4);
+  }
+
+  // Moving forward pushes the pixels away from the center, which doesn't
+  // move
+  StaticSceneFlow(depth.data(), kWidth, kHeight, kHfov,
+      math::Pose3d::Zero, math::Pose3d(1, 0, 0, 0, 0, 0), flow.data());
+  const std::size_t center = (kHeight / 2u) * kWidth + kWidth / 2u;
+  EXPECT_NEAR(0.0f, flow[center * 3u], 1e-5f);
+  EXPECT_NEAR(0.0f, flow[center * 3u + 1u], 1e-5f);
+  EXPECT_LT(flow[0], 0.0f);
+  EXPECT_LT(flow[1], 0.0f);
+  const std::size_t last = depth.size() - 1u;
+  EXPECT_GT(flow[last * 3u], 0.0f);
+  EXPECT_GT(flow[last * 3u + 1u], 0.0f);
+
+  // Points behind the first camera have no flow
+  StaticSceneFlow(depth.data(), kWidth, kHeight, kHfov,
+      math::Pose3d::Zero, math::Pose3d(-5, 0, 0, 0, 0, 0), flow.data());
+  EXPECT_TRUE(std::isnan(flow[center * 3u]));
+}
+
+//////////////////////////////////////////////////
+TEST(OpticalFlow_TEST, Rotation)
+{
+  // Yawing left shifts the scene right, whatever its depth
+  std::vector<float> depth(kWidth * kHeight);
+  for (std::size_t i = 0u; i < depth.size(); ++i)
+    depth[i] = 1.0f + 0.5f * i;
+  std::vector<float> flow(depth.size() * 3u);
+  const double yaw = 0.05;
+  StaticSceneFlow(depth.data(), kWidth, kHeight, kHfov,
+      math::Pose3d(0, 0, 0, 0, 0, 1.0), math::Pose3d(0, 0, 0, 0, 0, 1.0 + yaw),
+      flow.data());
+  const std::size_t center = (kHeight / 2u) * kWidth + kWidth / 2u;
+  EXPECT_NEAR(FocalLength() * std::tan(yaw), flow[center * 3u], 1e-4);
+  EXPECT_NEAR(0.0f, flow[center * 3u + 1u], 1e-4);
+  for (std::size_t i = 0u; i < depth.size(); ++i)
+    EXPECT_GT(flow[i * 3u], 0.0f);
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_PHILOXRANDOM_HH_
+#define GZ_SENSORS_PHILOXRANDOM_HH_
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <gz/math/Rand.hh>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Counter-based Philox4x32-10 random number generator, as
+    /// described in "Parallel random numbers: as easy as 1, 2, 3" (Salmon et
+    /// al., 2011). Each generator is an independent stream fully determined
+    /// by its seed, so generators owned by different sensors produce the
+    /// same numbers no matter which thread or in which order they run.
+    class PhiloxRandom
+    {
+      /// \brief Constructor
+      /// \param[in] _seed Seed of the stream.
+      public: explicit PhiloxRandom(uint64_t _seed)
+      {
+        this->key[0] = static_cast<uint32_t>(_seed);
+        this->key[1] = static_cast<uint32_t>(_seed >> 32);
+      }
+
+      /// \brief Get a seed for a generator that isn't seeded explicitly.
+      /// Seeds are derived from the math::Rand seed and the number of seeds
+      /// handed out so far, so they only repeat across runs that create
+      /// generators in the same order.
+      /// \return Seed.
+      public: static uint64_t DefaultSeed()
+      {
+        static std::atomic<uint64_t> count{0u};
+        return (static_cast<uint64_t>(math::Rand::Seed()) << 32) ^
+            count.fetch_add(1u);
+      }
+
+      /// \brief Generate four 32 bit random numbers.
+      /// \return Random numbers.
+      public: std::array<uint32_t, 4> Next()
+      {
+        std::array<uint32_t, 4> ctr = this->counter;
+        uint32_t k0 = this->key[0];
+        uint32_t k1 = this->key[1];
+        for (int round = 0; round < 10; ++round)
+        {
+          const uint64_t p0 = static_cast<uint64_t>(kMul0) * ctr[0];
+          const uint64_t p1 = static_cast<uint64_t>(kMul1) * ctr[2];
+          ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ k0,
+                 static_cast<uint32_t>(p1),
+                 static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ k1,
+                 static_cast<uint32_t>(p0)};
+          k0 += kWeyl0;
+          k1 += kWeyl1;
+        }
+
+        // Advance the 128 bit counter
+        for (auto &c : this->counter)
+        {
+          if (++c != 0u)
+            break;
+        }
+        return ctr;
+      }
+
+      /// \brief Draw a uniformly distributed number in (0, 1].
+      /// \return Random number.
+      public: double Uniform()
+      {
+        if (this->uniformCount == 0u)
+        {
+          this->uniformBlock = this->Next();
+          this->uniformCount = 2u;
+        }
+        --this->uniformCount;
+        const std::size_t i = this->uniformCount * 2u;
+        return ToUnit(this->uniformBlock[i], this->uniformBlock[i + 1]);
+      }
+
+      /// \brief Draw a normally distributed number.
+      /// \param[in] _mean Mean of the distribution.
+      /// \param[in] _stdDev Standard deviation of the distribution.
+      /// \return Random number.
+      public: double Normal(double _mean, double _stdDev)
+      {
+        if (!this->hasSpare)
+        {
+          this->NormalPair(this->spare, this->current);
+          this->hasSpare = true;
+          return _mean + _stdDev * this->current;
+        }
+        this->hasSpare = false;
+        return _mean + _stdDev * this->spare;
+      }
+
+      /// \brief Fill a buffer with normally distributed numbers. Numbers are
+      /// generated in pairs with the Box-Muller transform.
+      /// \param[out] _out Buffer to fill.
+      /// \param[in] _count Number of values.
+      /// \param[in] _mean Mean of the distribution.
+      /// \param[in] _stdDev Standard deviation of the distribution.
+      public: void Normal(double *_out, std::size_t _count, double _mean,
+                  double _stdDev)
+      {
+        std::size_t i = 0u;
+        for (; i + 1u < _count; i += 2u)
+        {
+          double z0, z1;
+          this->NormalPair(z0, z1);
+          _out[i] = _mean + _stdDev * z0;
+          _out[i + 1u] = _mean + _stdDev * z1;
+        }
+        if (i < _count)
+          _out[i] = this->Normal(_mean, _stdDev);
+      }
+
+      /// \brief Generate two independent standard normal numbers.
+      /// \param[out] _z0 First number.
+      /// \param[out] _z1 Second number.
+      private: void NormalPair(double &_z0, double &_z1)
+      {
+        const auto bits = this->Next();
+        const double u0 = ToUnit(bits[0], bits[1]);
+        const double u1 = ToUnit(bits[2], bits[3]);
+        const double r = std::sqrt(-2.0 * std::log(u0));
+        const double theta = 2.0 * kPi * u1;
+        _z0 = r * std::cos(theta);
+        _z1 = r * std::sin(theta);
+      }
+
+      /// \brief Convert 64 random bits to a double in (0, 1].
+      /// \param[in] _hi High 32 bits.
+      /// \param[in] _lo Low 32 bits.
+      /// \return Number in (0, 1].
+      private: static double ToUnit(uint32_t _hi, uint32_t _lo)
+      {
+        const uint64_t bits =
+          ((static_cast<uint64_t>(_hi) << 32) | _lo) >> 11;
+        return (static_cast<double>(bits) + 1.0) * (1.0 / 9007199254740992.0);
+      }
+
+      /// \brief Philox multipliers and Weyl sequence constants.
+      private: static constexpr uint32_t kMul0 = 0xD2511F53u;
+      private: static constexpr uint32_t kMul1 = 0xCD9E8D57u;
+      private: static constexpr uint32_t kWeyl0 = 0x9E3779B9u;
+      private: static constexpr uint32_t kWeyl1 = 0xBB67AE85u;
+
+      /// \brief Pi.
+      private: static constexpr double kPi = 3.14159265358979323846;
+
+      /// \brief Key derived from the seed.
+      private: std::array<uint32_t, 2> key{};
+
+      /// \brief Counter, incremented for every block of four numbers.
+      private: std::array<uint32_t, 4> counter{};
+
+      /// \brief Unused uniform numbers of the last block.
+      private: std::array<uint32_t, 4> uniformBlock{};
+
+      /// \brief Number of unused uniform numbers in uniformBlock.
+      private: std::size_t uniformCount{0u};
+
+      /// \brief True if spare holds an unused normal number.
+      private: bool hasSpare{false};
+
+      /// \brief Second number of the last normal pair.
+      private: double spare{0.0};
+
+      /// \brief First number of the last normal pair.
+      private: double current{0.0};
+    };
+    }
+  }
+}
+
+#endif
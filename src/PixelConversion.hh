@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_PIXELCONVERSION_HH_
+#define GZ_SENSORS_PIXELCONVERSION_HH_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // The YUV conversions use the BT.601 limited range coefficients in 8 bit
+    // fixed point, the usual input of hardware video encoders.
+
+    /// \brief Compute the BT.601 limited range luma of a pixel.
+    /// \param[in] _r Red.
+    /// \param[in] _g Green.
+    /// \param[in] _b Blue.
+    /// \return Luma, in [16, 235].
+    inline uint8_t RgbToY(int _r, int _g, int _b)
+    {
+      return static_cast<uint8_t>(((66 * _r + 129 * _g + 25 * _b + 128) >> 8)
+          + 16);
+    }
+
+    /// \brief Compute the BT.601 limited range blue difference chroma.
+    /// \param[in] _r Red.
+    /// \param[in] _g Green.
+    /// \param[in] _b Blue.
+    /// \return Chroma, in [16, 240].
+    inline uint8_t RgbToU(int _r, int _g, int _b)
+    {
+      return static_cast<uint8_t>(((-38 * _r - 74 * _g + 112 * _b + 128) >> 8)
+          + 128);
+    }
+
+    /// \brief Compute the BT.601 limited range red difference chroma.
+    /// \param[in] _r Red.
+    /// \param[in] _g Green.
+    /// \param[in] _b Blue.
+    /// \return Chroma, in [16, 240].
+    inline uint8_t RgbToV(int _r, int _g, int _b)
+    {
+      return static_cast<uint8_t>(((112 * _r - 94 * _g - 18 * _b + 128) >> 8)
+          + 128);
+    }
+
+    /// \brief Convert RGB pixels to full range 8 bit grey, with the BT.601
+    /// luma weights.
+    /// \param[in] _src Packed RGB pixels.
+    /// \param[in] _width Image width.
+    /// \param[in] _height Image height.
+    /// \param[out] _dst Grey pixels, _width * _height bytes.
+    inline void RgbToMono(const unsigned char *_src, unsigned int _width,
+        unsigned int _height, unsigned char *_dst)
+    {
+      const std::size_t count = static_cast<std::size_t>(_width) * _height;
+      for (std::size_t i = 0u; i < count; ++i, _src += 3)
+      {
+        _dst[i] = static_cast<unsigned char>(
+            (77 * _src[0] + 150 * _src[1] + 29 * _src[2] + 128) >> 8);
+      }
+    }
+
+    /// \brief Convert RGB pixels to packed YUV 4:2:2, Y0 U Y1 V for each
+    /// pair of pixels. The chroma of a pair is computed from its average
+    /// color. A last odd column is dropped.
+    /// \param[in] _src Packed RGB pixels.
+    /// \param[in] _width Image width.
+    /// \param[in] _height Image height.
+    /// \param[out] _dst Output, (_width & ~1) * 2 bytes per row.
+    inline void RgbToYuyv(const unsigned char *_src, unsigned int _width,
+        unsigned int _height, unsigned char *_dst)
+    {
+      const unsigned int pairs = _width / 2u;
+      for (unsigned int v = 0u; v < _height; ++v)
+      {
+        const unsigned char *row = _src + static_cast<std::size_t>(v) *
+            _width * 3u;
+        for (unsigned int p = 0u; p < pairs; ++p, row += 6, _dst += 4)
+        {
+          const int r = (row[0] + row[3] + 1) >> 1;
+          const int g = (row[1] + row[4] + 1) >> 1;
+          const int b = (row[2] + row[5] + 1) >> 1;
+          _dst[0] = RgbToY(row[0], row[1], row[2]);
+          _dst[1] = RgbToU(r, g, b);
+          _dst[2] = RgbToY(row[3], row[4], row[5]);
+          _dst[3] = RgbToV(r, g, b);
+        }
+      }
+    }
+
+    /// \brief Convert RGB pixels to NV12: a plane of luma followed by a
+    /// plane of interleaved U and V at half resolution in each direction.
+    /// The chroma of a 2x2 block is computed from its average color. A
+    /// last odd column or row is dropped.
+    /// \param[in] _src Packed RGB pixels.
+    /// \param[in] _width Image width.
+    /// \param[in] _height Image height.
+    /// \param[out] _dst Output, w * h * 3 / 2 bytes where w and h are
+    /// _width and _height rounded down to even.
+    inline void RgbToNv12(const unsigned char *_src, unsigned int _width,
+        unsigned int _height, unsigned char *_dst)
+    {
+      const unsigned int width = _width & ~1u;
+      const unsigned int height = _height & ~1u;
+      const std::size_t srcStep = static_cast<std::size_t>(_width) * 3u;
+      unsigned char *yPlane = _dst;
+      unsigned char *uvPlane = _dst + static_cast<std::size_t>(width) * height;
+      for (unsigned int v = 0u; v < height; v += 2u)
+      {
+        const unsigned char *row0 = _src + v * srcStep;
+        const unsigned char *row1 = row0 + srcStep;
+        unsigned char *y0 = yPlane + static_cast<std::size_t>(v) * width;
+        unsigned char *y1 = y0 + width;
+        for (unsigned int u = 0u; u < width; u += 2u)
+        {
+          const unsigned char *a = row0 + u * 3u;
+          const unsigned char *b = row1 + u * 3u;
+          y0[u] = RgbToY(a[0], a[1], a[2]);
+          y0[u + 1u] = RgbToY(a[3], a[4], a[5]);
+          y1[u] = RgbToY(b[0], b[1], b[2]);
+          y1[u + 1u] = RgbToY(b[3], b[4], b[5]);
+          const int r = (a[0] + a[3] + b[0] + b[3] + 2) >> 2;
+          const int g = (a[1] + a[4] + b[1] + b[4] + 2) >> 2;
+          const int bl = (a[2] + a[5] + b[2] + b[5] + 2) >> 2;
+          *uvPlane++ = RgbToU(r, g, bl);
+          *uvPlane++ = RgbToV(r, g, bl);
+        }
+      }
+    }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "PixelConversion.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(PixelConversion, Coefficients)
+{
+  EXPECT_EQ(16, RgbToY(0, 0, 0));
+  EXPECT_EQ(235, RgbToY(255, 255, 255));
+  EXPECT_EQ(128, RgbToU(255, 255, 255));
+  EXPECT_EQ(128, RgbToV(255, 255, 255));
+  EXPECT_EQ(128, RgbToU(0, 0, 0));
+  EXPECT_EQ(128, RgbToV(0, 0, 0));
+
+  EXPECT_EQ(82, RgbToY(255, 0, 0));
+  EXPECT_EQ(90, RgbToU(255, 0, 0));
+  EXPECT_EQ(240, RgbToV(255, 0, 0));
+  EXPECT_EQ(240, RgbToU(0, 0, 255));
+}
+
+/////////////////////////////////////////////////
+TEST(PixelConversion, Mono)
+{
+  const std::vector<unsigned char> src = {
+    0, 0, 0, 255, 255, 255, 255, 0, 0, 0, 255, 0};
+  std::vector<unsigned char> dst(4u);
+  RgbToMono(src.data(), 2u, 2u, dst.data());
+  EXPECT_EQ(0, dst[0]);
+  EXPECT_EQ(255, dst[1]);
+  EXPECT_EQ(77, dst[2]);
+  EXPECT_EQ(149, dst[3]);
+}
+
+/////////////////////////////////////////////////
+TEST(PixelConversion, Yuyv)
+{
+  // 3x1 image, the last column is dropped
+  const std::vector<unsigned char> src = {
+    255, 0, 0, 255, 0, 0, 0, 0, 255};
+  std::vector<unsigned char> dst(4u);
+  RgbToYuyv(src.data(), 3u, 1u, dst.data());
+  EXPECT_EQ(82, dst[0]);
+  EXPECT_EQ(90, dst[1]);
+  EXPECT_EQ(82, dst[2]);
+  EXPECT_EQ(240, dst[3]);
+}
+
+/////////////////////////////////////////////////
+TEST(PixelConversion, Nv12)
+{
+  // 4x3 image: a red and a white block, the last row is dropped
+  std::vector<unsigned char> src(4u * 3u * 3u, 0u);
+  for (unsigned int v = 0u; v < 2u; ++v)
+  {
+    for (unsigned int u = 0u; u < 4u; ++u)
+    {
+      unsigned char *p = &src[(v * 4u + u) * 3u];
+      p[0] = 255;
+      p[1] = u < 2u ? 0 : 255;
+      p[2] = u < 2u ? 0 : 255;
+    }
+  }
+
+  std::vector<unsigned char> dst(4u * 2u * 3u / 2u, 0u);
+  RgbToNv12(src.data(), 4u, 3u, dst.data());
+  for (unsigned int v = 0u; v < 2u; ++v)
+  {
+    EXPECT_EQ(82, dst[v * 4u + 0u]);
+    EXPECT_EQ(82, dst[v * 4u + 1u]);
+    EXPECT_EQ(235, dst[v * 4u + 2u]);
+    EXPECT_EQ(235, dst[v * 4u + 3u]);
+  }
+  EXPECT_EQ(90, dst[8]);
+  EXPECT_EQ(240, dst[9]);
+  EXPECT_EQ(128, dst[10]);
+  EXPECT_EQ(128, dst[11]);
+}
@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include "PointCloudCompressor.hh"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Value of the "format" header entry of compressed clouds.
+const char kFormat[] = "delta_xyz";
+
+//////////////////////////////////////////////////
+/// \brief Get the size of a field.
+/// \param[in] _type Data type of the field.
+/// \return Size in bytes, zero for unknown types.
+uint32_t FieldSize(msgs::PointCloudPacked::Field::DataType _type)
+{
+  switch (_type)
+  {
+    case msgs::PointCloudPacked::Field::INT8:
+    case msgs::PointCloudPacked::Field::UINT8:
+      return 1u;
+    case msgs::PointCloudPacked::Field::INT16:
+    case msgs::PointCloudPacked::Field::UINT16:
+      return 2u;
+    case msgs::PointCloudPacked::Field::INT32:
+    case msgs::PointCloudPacked::Field::UINT32:
+    case msgs::PointCloudPacked::Field::FLOAT32:
+      return 4u;
+    case msgs::PointCloudPacked::Field::FLOAT64:
+      return 8u;
+    default:
+      return 0u;
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Get a numeric header entry.
+/// \param[in] _msg Cloud.
+/// \param[in] _key Key of the entry.
+/// \param[out] _value Value of the entry.
+/// \return True if the entry exists and is a number.
+bool HeaderValue(const msgs::PointCloudPacked &_msg, const std::string &_key,
+    double &_value)
+{
+  for (int i = 0; i < _msg.header().data_size(); ++i)
+  {
+    const auto &data = _msg.header().data(i);
+    if (data.key() == _key && data.value_size() > 0)
+    {
+      std::istringstream stream(data.value(0));
+      return static_cast<bool>(stream >> _value);
+    }
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+/// \brief Check the layout of a cloud.
+/// \param[in] _msg Cloud.
+/// \param[in] _size Size of the point data, ignored if zero.
+/// \return True if the cloud has x, y and z first, as FLOAT32 or INT16,
+/// and its fields fit in its points.
+bool ValidLayout(const msgs::PointCloudPacked &_msg, std::size_t _size)
+{
+  if (_msg.field_size() < 3 || _msg.point_step() == 0u)
+    return false;
+  const auto type = _msg.field(0).datatype();
+  if (type != msgs::PointCloudPacked::Field::FLOAT32 &&
+      type != msgs::PointCloudPacked::Field::INT16)
+  {
+    return false;
+  }
+  for (int k = 0; k < _msg.field_size(); ++k)
+  {
+    const uint32_t size = FieldSize(_msg.field(k).datatype());
+    if ((k < 3 && _msg.field(k).datatype() != type) || size == 0u ||
+        _msg.field(k).offset() + size > _msg.point_step())
+    {
+      return false;
+    }
+  }
+  const std::size_t points =
+      static_cast<std::size_t>(_msg.width()) * _msg.height();
+  return _size == 0u || points == 0u ||
+      _size >= static_cast<std::size_t>(_msg.row_step()) *
+      (_msg.height() - 1u) + static_cast<std::size_t>(_msg.width()) *
+      _msg.point_step();
+}
+
+//////////////////////////////////////////////////
+/// \brief Append a zig-zag LEB128 varint.
+/// \param[in] _value Value to append.
+/// \param[in,out] _out Buffer.
+void AppendVarint(int64_t _value, std::string &_out)
+{
+  uint64_t v = (static_cast<uint64_t>(_value) << 1u) ^
+      static_cast<uint64_t>(_value >> 63);
+  while (v >= 0x80u)
+  {
+    _out.push_back(static_cast<char>((v & 0x7Fu) | 0x80u));
+    v >>= 7u;
+  }
+  _out.push_back(static_cast<char>(v));
+}
+
+//////////////////////////////////////////////////
+/// \brief Read a zig-zag LEB128 varint.
+/// \param[in,out] _pos Position in the buffer, moved past the varint.
+/// \param[in] _end End of the buffer.
+/// \param[out] _value Value read.
+/// \return False if the buffer ends before the varint.
+bool ReadVarint(const unsigned char *&_pos, const unsigned char *_end,
+    int64_t &_value)
+{
+  uint64_t v = 0u;
+  for (unsigned int shift = 0u; shift < 64u; shift += 7u)
+  {
+    if (_pos == _end)
+      return false;
+    const unsigned char byte = *_pos++;
+    v |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+    if (!(byte & 0x80u))
+    {
+      _value = static_cast<int64_t>(v >> 1u) ^ -static_cast<int64_t>(v & 1u);
+      return true;
+    }
+  }
+  return false;
+}
+}
+
+//////////////////////////////////////////////////
+PointCloudCompressor::PointCloudCompressor(
+    const transport::Node::Publisher &_pub, double _resolution)
+  : pub(_pub), resolution(_resolution > 0.0 ? _resolution : 0.001)
+{
+}
+
+//////////////////////////////////////////////////
+PointCloudCompressor::~PointCloudCompressor()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->cv.notify_one();
+  if (this->thread.joinable())
+    this->thread.join();
+}
+
+//////////////////////////////////////////////////
+void PointCloudCompressor::Push(const msgs::PointCloudPacked &_msg)
+{
+  GZ_PROFILE("PointCloudCompressor::Push");
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->pending)
+      ++this->dropped;
+
+    // Copying into the same message reuses its data buffer
+    this->pendingMsg.CopyFrom(_msg);
+    this->pending = true;
+
+    if (!this->thread.joinable())
+      this->thread = std::thread(&PointCloudCompressor::Run, this);
+  }
+  this->cv.notify_one();
+}
+
+//////////////////////////////////////////////////
+uint64_t PointCloudCompressor::DroppedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->dropped;
+}
+
+//////////////////////////////////////////////////
+double PointCloudCompressor::Resolution() const
+{
+  return this->resolution;
+}
+
+//////////////////////////////////////////////////
+bool PointCloudCompressor::Encode(const msgs::PointCloudPacked &_msg,
+    double _resolution, msgs::PointCloudPacked &_out)
+{
+  if (!(_resolution > 0.0) || !ValidLayout(_msg, _msg.data().size()))
+    return false;
+
+  const bool quantized =
+      _msg.field(0).datatype() == msgs::PointCloudPacked::Field::INT16;
+  double inputResolution = 1.0;
+  if (quantized && !HeaderValue(_msg, "xyz_resolution", inputResolution))
+    return false;
+
+  _out.Clear();
+  *_out.mutable_header() = _msg.header();
+  *_out.mutable_field() = _msg.field();
+  _out.set_width(_msg.width());
+  _out.set_height(_msg.height());
+  _out.set_point_step(_msg.point_step());
+  _out.set_row_step(_msg.row_step());
+  _out.set_is_bigendian(_msg.is_bigendian());
+  _out.set_is_dense(_msg.is_dense());
+  auto *entry = _out.mutable_header()->add_data();
+  entry->set_key("format");
+  entry->add_value(kFormat);
+  entry = _out.mutable_header()->add_data();
+  entry->set_key("compressed_resolution");
+  std::ostringstream value;
+  value << _resolution;
+  entry->add_value(value.str());
+
+  const uint32_t width = _msg.width();
+  const uint32_t height = _msg.height();
+  const std::size_t points = static_cast<std::size_t>(width) * height;
+  const double scale = quantized ? inputResolution / _resolution :
+      1.0 / _resolution;
+  const uint32_t offsets[3] = {_msg.field(0).offset(),
+      _msg.field(1).offset(), _msg.field(2).offset()};
+
+  // Mask first, filled in while the coordinates are appended
+  std::string *data = _out.mutable_data();
+  data->assign((points + 7u) / 8u, '\0');
+  data->reserve(data->size() + points * 6u);
+  std::size_t valid = 0u;
+  for (uint32_t j = 0; j < height; ++j)
+  {
+    const char *row = _msg.data().data() +
+        static_cast<std::size_t>(j) * _msg.row_step();
+    int64_t previous[3] = {0, 0, 0};
+    for (uint32_t i = 0; i < width; ++i)
+    {
+      const char *point = row + static_cast<std::size_t>(i) * _msg.point_step();
+      double xyz[3];
+      bool finite = true;
+      for (int k = 0; k < 3 && finite; ++k)
+      {
+        if (quantized)
+        {
+          int16_t q;
+          std::memcpy(&q, point + offsets[k], sizeof(q));
+          finite = q != std::numeric_limits<int16_t>::min();
+          xyz[k] = q;
+        }
+        else
+        {
+          float f;
+          std::memcpy(&f, point + offsets[k], sizeof(f));
+          finite = std::isfinite(f) && std::fabs(f * scale) < 4e18;
+          xyz[k] = f;
+        }
+      }
+      if (!finite)
+        continue;
+
+      const std::size_t index = static_cast<std::size_t>(j) * width + i;
+      char &maskByte = (*data)[index / 8u];
+      maskByte = static_cast<char>(static_cast<unsigned char>(maskByte) |
+          (1u << (index % 8u)));
+      for (int k = 0; k < 3; ++k)
+      {
+        const int64_t q = std::llround(xyz[k] * scale);
+        AppendVarint(q - previous[k], *data);
+        previous[k] = q;
+      }
+      ++valid;
+    }
+  }
+
+  // Other fields, one plane per field
+  const unsigned char *mask =
+      reinterpret_cast<const unsigned char *>(data->data());
+  for (int k = 3; k < _msg.field_size(); ++k)
+  {
+    const uint32_t offset = _msg.field(k).offset();
+    const uint32_t size = FieldSize(_msg.field(k).datatype());
+    std::size_t start = data->size();
+    data->resize(start + valid * size);
+    mask = reinterpret_cast<const unsigned char *>(data->data());
+    char *dst = data->data() + start;
+    for (std::size_t index = 0u; index < points; ++index)
+    {
+      if (!(mask[index / 8u] & (1u << (index % 8u))))
+        continue;
+      const std::size_t j = index / width;
+      const std::size_t i = index % width;
+      std::memcpy(dst, _msg.data().data() + j * _msg.row_step() +
+          i * _msg.point_step() + offset, size);
+      dst += size;
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool PointCloudCompressor::Decode(const msgs::PointCloudPacked &_msg,
+    msgs::PointCloudPacked &_out)
+{
+  double resolution = 0.0;
+  std::string format;
+  for (int i = 0; i < _msg.header().data_size(); ++i)
+  {
+    const auto &data = _msg.header().data(i);
+    if (data.key() == "format" && data.value_size() > 0)
+      format = data.value(0);
+  }
+  if (format != kFormat || !ValidLayout(_msg, 0u) ||
+      !HeaderValue(_msg, "compressed_resolution", resolution) ||
+      !(resolution > 0.0))
+  {
+    return false;
+  }
+
+  const bool quantized =
+      _msg.field(0).datatype() == msgs::PointCloudPacked::Field::INT16;
+  double outputResolution = 1.0;
+  if (quantized && !HeaderValue(_msg, "xyz_resolution", outputResolution))
+    return false;
+
+  _out.Clear();
+  *_out.mutable_header() = _msg.header();
+  *_out.mutable_field() = _msg.field();
+  _out.set_width(_msg.width());
+  _out.set_height(_msg.height());
+  _out.set_point_step(_msg.point_step());
+  _out.set_row_step(_msg.row_step());
+  _out.set_is_bigendian(_msg.is_bigendian());
+  _out.set_is_dense(_msg.is_dense());
+
+  // Drop the entries of the compressed cloud
+  auto *header = _out.mutable_header();
+  for (int i = header->data_size() - 1; i >= 0; --i)
+  {
+    const std::string &key = header->data(i).key();
+    if (key == "format" || key == "compressed_resolution")
+      header->mutable_data()->DeleteSubrange(i, 1);
+  }
+
+  const uint32_t width = _msg.width();
+  const uint32_t height = _msg.height();
+  const std::size_t points = static_cast<std::size_t>(width) * height;
+  const std::size_t maskSize = (points + 7u) / 8u;
+  if (_msg.data().size() < maskSize)
+    return false;
+
+  std::string *data = _out.mutable_data();
+  data->assign(points == 0u ? 0u :
+      static_cast<std::size_t>(_msg.row_step()) * (height - 1u) +
+      static_cast<std::size_t>(width) * _msg.point_step(), '\0');
+
+  const unsigned char *mask =
+      reinterpret_cast<const unsigned char *>(_msg.data().data());
+  const unsigned char *pos = mask + maskSize;
+  const unsigned char *end = mask + _msg.data().size();
+  const double scale = quantized ? resolution / outputResolution : resolution;
+  const uint32_t offsets[3] = {_msg.field(0).offset(),
+      _msg.field(1).offset(), _msg.field(2).offset()};
+  std::size_t valid = 0u;
+  for (uint32_t j = 0; j < height; ++j)
+  {
+    char *row = data->data() + static_cast<std::size_t>(j) * _msg.row_step();
+    int64_t previous[3] = {0, 0, 0};
+    for (uint32_t i = 0; i < width; ++i)
+    {
+      char *point = row + static_cast<std::size_t>(i) * _msg.point_step();
+      const std::size_t index = static_cast<std::size_t>(j) * width + i;
+      const bool isValid = mask[index / 8u] & (1u << (index % 8u));
+      for (int k = 0; k < 3; ++k)
+      {
+        double coordinate = std::numeric_limits<double>::quiet_NaN();
+        if (isValid)
+        {
+          int64_t delta;
+          if (!ReadVarint(pos, end, delta))
+            return false;
+          previous[k] += delta;
+          coordinate = previous[k] * scale;
+        }
+        if (quantized)
+        {
+          const int16_t q = isValid ? static_cast<int16_t>(std::fmax(-32767.0,
+              std::fmin(32767.0, std::round(coordinate)))) :
+              std::numeric_limits<int16_t>::min();
+          std::memcpy(point + offsets[k], &q, sizeof(q));
+        }
+        else
+        {
+          const float f = static_cast<float>(coordinate);
+          std::memcpy(point + offsets[k], &f, sizeof(f));
+        }
+      }
+      if (isValid)
+        ++valid;
+    }
+  }
+
+  for (int k = 3; k < _msg.field_size(); ++k)
+  {
+    const uint32_t offset = _msg.field(k).offset();
+    const uint32_t size = FieldSize(_msg.field(k).datatype());
+    if (static_cast<std::size_t>(end - pos) < valid * size)
+      return false;
+    for (std::size_t index = 0u; index < points; ++index)
+    {
+      if (!(mask[index / 8u] & (1u << (index % 8u))))
+        continue;
+      const std::size_t j = index / width;
+      const std::size_t i = index % width;
+      std::memcpy(data->data() + j * _msg.row_step() + i * _msg.point_step() +
+          offset, pos, size);
+      pos += size;
+    }
+  }
+  return pos == end;
+}
+
+//////////////////////////////////////////////////
+void PointCloudCompressor::Run()
+{
+  GZ_PROFILE_THREAD_NAME("PointCloudCompressor");
+  msgs::PointCloudPacked msg;
+  msgs::PointCloudPacked compressed;
+  bool reported = false;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cv.wait(lock, [this]
+      {
+        return this->stop || this->pending;
+      });
+      if (this->stop)
+        return;
+
+      // Swapping keeps both data buffers allocated across clouds
+      msg.Swap(&this->pendingMsg);
+      this->pending = false;
+    }
+
+    {
+      GZ_PROFILE("PointCloudCompressor::Encode");
+      if (!Encode(msg, this->resolution, compressed))
+      {
+        if (!reported)
+        {
+          gzerr << "Unable to compress a point cloud, its coordinates must "
+                << "be its first three fields.\n";
+          reported = true;
+        }
+        continue;
+      }
+    }
+
+    GZ_PROFILE("PointCloudCompressor::Publish");
+    this->pub.Publish(compressed);
+  }
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_POINTCLOUDCOMPRESSOR_HH_
+#define GZ_SENSORS_POINTCLOUDCOMPRESSOR_HH_
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include <gz/msgs/pointcloud_packed.pb.h>
+#include <gz/transport/Node.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Encodes point clouds on a worker thread and publishes them.
+    /// Only the latest cloud waits for the worker: a cloud pushed while
+    /// another one is waiting replaces it. The worker thread is started by
+    /// the first push.
+    ///
+    /// Compressed clouds keep the width, height, steps, fields and header
+    /// of the cloud, with "format" set to "delta_xyz" and
+    /// "compressed_resolution" set to the quantization step in meters in
+    /// the header. Their data is, in order:
+    /// - a validity mask of (width * height + 7) / 8 bytes, bit i % 8 of
+    ///   byte i / 8 set if point i, in row major order, has finite
+    ///   coordinates;
+    /// - for each valid point, the zig-zag LEB128 varints of the
+    ///   differences of its x, y and z, rounded to multiples of the
+    ///   quantization step, with the previous valid point of its row, or
+    ///   with zero for the first valid point of a row;
+    /// - for each field after z, its bytes for each valid point.
+    class GZ_SENSORS_VISIBLE PointCloudCompressor
+    {
+      /// \brief Constructor
+      /// \param[in] _pub Publisher of the compressed clouds.
+      /// \param[in] _resolution Quantization step of the coordinates in
+      /// meters, positive.
+      public: PointCloudCompressor(const transport::Node::Publisher &_pub,
+                  double _resolution);
+
+      /// \brief Destructor. Discards the waiting cloud and stops the worker
+      /// thread once the cloud being encoded, if any, is published.
+      public: ~PointCloudCompressor();
+
+      /// \brief Queue a cloud for compression.
+      /// \param[in] _msg Cloud to compress, copied before returning. Its x,
+      /// y and z must be its first three fields, as FLOAT32 or as INT16
+      /// with an "xyz_resolution" header entry.
+      public: void Push(const msgs::PointCloudPacked &_msg);
+
+      /// \brief Get the number of clouds replaced before being encoded.
+      /// \return Number of dropped clouds.
+      public: uint64_t DroppedCount() const;
+
+      /// \brief Get the quantization step of the coordinates.
+      /// \return Step in meters.
+      public: double Resolution() const;
+
+      /// \brief Encode a cloud.
+      /// \param[in] _msg Cloud to encode.
+      /// \param[in] _resolution Quantization step in meters, positive.
+      /// \param[out] _out Compressed cloud.
+      /// \return False if the cloud can't be encoded.
+      public: static bool Encode(const msgs::PointCloudPacked &_msg,
+                  double _resolution, msgs::PointCloudPacked &_out);
+
+      /// \brief Decode a compressed cloud. Points without coordinates get
+      /// NaN FLOAT32 or -32768 INT16 coordinates and zero fields.
+      /// \param[in] _msg Compressed cloud.
+      /// \param[out] _out Decoded cloud, with the layout of the cloud that
+      /// was encoded.
+      /// \return False if _msg isn't a valid compressed cloud.
+      public: static bool Decode(const msgs::PointCloudPacked &_msg,
+                  msgs::PointCloudPacked &_out);
+
+      /// \brief Worker thread loop.
+      private: void Run();
+
+      /// \brief Publisher of the compressed clouds.
+      private: transport::Node::Publisher pub;
+
+      /// \brief Quantization step of the coordinates.
+      private: double resolution;
+
+      /// \brief Protects the members below.
+      private: mutable std::mutex mutex;
+
+      /// \brief Signals a waiting cloud or that the worker must stop.
+      private: std::condition_variable cv;
+
+      /// \brief The waiting cloud.
+      private: msgs::PointCloudPacked pendingMsg;
+
+      /// \brief True if a cloud is waiting.
+      private: bool pending{false};
+
+      /// \brief True to stop the worker thread.
+      private: bool stop{false};
+
+      /// \brief Number of clouds replaced before being encoded.
+      private: uint64_t dropped{0u};
+
+      /// \brief The worker thread.
+      private: std::thread thread;
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <gz/msgs/Utility.hh>
+
+#include "PointCloudCompressor.hh"
+#include "PointCloudUtil.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+constexpr uint32_t kWidth = 9u;
+constexpr uint32_t kHeight = 4u;
+
+//////////////////////////////////////////////////
+/// \brief Create a lidar like cloud with intensity and ring fields. The
+/// first point of each row has no coordinates.
+/// \param[in] _util Initializes the message with its resolution.
+msgs::PointCloudPacked LidarMsg(const PointCloudUtil &_util)
+{
+  msgs::PointCloudPacked msg;
+  _util.InitMsg(msg, "frame",
+      {{"intensity", msgs::PointCloudPacked::Field::FLOAT32},
+      {"ring", msgs::PointCloudPacked::Field::UINT16}});
+  msg.set_width(kWidth);
+  msg.set_height(kHeight);
+  msg.set_row_step(msg.point_step() * kWidth);
+  msg.mutable_data()->resize(msg.row_step() * kHeight);
+  const bool quantized = _util.Resolution() > 0.0;
+  for (uint32_t j = 0; j < kHeight; ++j)
+  {
+    for (uint32_t i = 0; i < kWidth; ++i)
+    {
+      char *point = msg.mutable_data()->data() +
+          (j * kWidth + i) * msg.point_step();
+      const float xyz[3] = {
+          i == 0u ? std::numeric_limits<float>::infinity() : 3.0f + 0.37f * i,
+          -1.2345f * i, 0.25f * j};
+      for (int k = 0; k < 3; ++k)
+      {
+        if (quantized)
+        {
+          const int16_t q = PointCloudUtil::QuantizeCoordinate(xyz[k],
+              static_cast<float>(1.0 / _util.Resolution()));
+          std::memcpy(point + msg.field(k).offset(), &q, sizeof(q));
+        }
+        else
+        {
+          std::memcpy(point + msg.field(k).offset(), &xyz[k], sizeof(float));
+        }
+      }
+      const float intensity = 10.0f * i + j;
+      const uint16_t ring = static_cast<uint16_t>(j);
+      std::memcpy(point + msg.field(3).offset(), &intensity,
+          sizeof(intensity));
+      std::memcpy(point + msg.field(4).offset(), &ring, sizeof(ring));
+    }
+  }
+  return msg;
+}
+
+//////////////////////////////////////////////////
+/// \brief Read a field of a point.
+template <typename T>
+T Read(const msgs::PointCloudPacked &_msg, uint32_t _index, int _field)
+{
+  T value;
+  std::memcpy(&value, _msg.data().data() + _index * _msg.point_step() +
+      _msg.field(_field).offset(), sizeof(T));
+  return value;
+}
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudCompressor_TEST, RoundTrip)
+{
+  PointCloudUtil util;
+  const msgs::PointCloudPacked msg = LidarMsg(util);
+
+  msgs::PointCloudPacked compressed;
+  ASSERT_TRUE(PointCloudCompressor::Encode(msg, 0.001, compressed));
+  EXPECT_EQ(msg.width(), compressed.width());
+  EXPECT_EQ(msg.height(), compressed.height());
+  EXPECT_LT(compressed.data().size(), msg.data().size() / 2u);
+
+  msgs::PointCloudPacked decoded;
+  ASSERT_TRUE(PointCloudCompressor::Decode(compressed, decoded));
+  ASSERT_EQ(msg.data().size(), decoded.data().size());
+  EXPECT_EQ(msg.point_step(), decoded.point_step());
+  ASSERT_EQ(msg.field_size(), decoded.field_size());
+  EXPECT_EQ(msg.header().data_size(), decoded.header().data_size());
+
+  for (uint32_t index = 0; index < kWidth * kHeight; ++index)
+  {
+    if (index % kWidth == 0u)
+    {
+      EXPECT_TRUE(std::isnan(Read<float>(decoded, index, 0)));
+      EXPECT_FLOAT_EQ(0.0f, Read<float>(decoded, index, 3));
+      continue;
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+      EXPECT_NEAR(Read<float>(msg, index, k), Read<float>(decoded, index, k),
+          0.0005);
+    }
+    EXPECT_FLOAT_EQ(Read<float>(msg, index, 3), Read<float>(decoded, index, 3));
+    EXPECT_EQ(Read<uint16_t>(msg, index, 4),
+        Read<uint16_t>(decoded, index, 4));
+  }
+
+  // Not a compressed cloud
+  EXPECT_FALSE(PointCloudCompressor::Decode(msg, decoded));
+
+  // Truncated
+  compressed.mutable_data()->pop_back();
+  EXPECT_FALSE(PointCloudCompressor::Decode(compressed, decoded));
+
+  EXPECT_FALSE(PointCloudCompressor::Encode(msg, 0.0, compressed));
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudCompressor_TEST, Quantized)
+{
+  PointCloudUtil util;
+  util.SetResolution(0.005);
+  const msgs::PointCloudPacked msg = LidarMsg(util);
+
+  // The step of the coordinates keeps them exact
+  msgs::PointCloudPacked compressed;
+  ASSERT_TRUE(PointCloudCompressor::Encode(msg, 0.005, compressed));
+  msgs::PointCloudPacked decoded;
+  ASSERT_TRUE(PointCloudCompressor::Decode(compressed, decoded));
+  ASSERT_EQ(msg.data().size(), decoded.data().size());
+  for (uint32_t index = 0; index < kWidth * kHeight; ++index)
+  {
+    for (int k = 0; index % kWidth != 0u && k < 3; ++k)
+    {
+      EXPECT_EQ(Read<int16_t>(msg, index, k),
+          Read<int16_t>(decoded, index, k));
+    }
+  }
+
+  // Quantized clouds need their resolution
+  msgs::PointCloudPacked noResolution = msg;
+  noResolution.mutable_header()->clear_data();
+  EXPECT_FALSE(PointCloudCompressor::Encode(noResolution, 0.005,
+      compressed));
+}
@@ -17,11 +17,363 @@
 
 #include "PointCloudUtil.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <vector>
+
+#include <gz/math/Helpers.hh>
+#include <gz/msgs/Utility.hh>
+
+#include "RowWorkers.hh"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 using namespace gz;
 using namespace sensors;
 
+namespace
+{
+/// \brief Byte offsets of the x, y, z and rgb fields of a point, looked up
+/// once per message instead of once per point.
+struct PointFieldOffsets
+{
+  /// \brief Constructor
+  /// \param[in] _msg Message with at least four fields.
+  /// \param[in] _resolution Resolution of INT16 coordinates.
+  PointFieldOffsets(const msgs::PointCloudPacked &_msg, double _resolution)
+    : x(_msg.field(0).offset()), y(_msg.field(1).offset()),
+      z(_msg.field(2).offset()), rgb(_msg.field(3).offset()),
+      r(_msg.is_bigendian() ? 0 : 2), b(_msg.is_bigendian() ? 2 : 0),
+      quantized(_msg.field(0).datatype() ==
+          msgs::PointCloudPacked::Field::INT16 && _resolution > 0.0),
+      inverseResolution(quantized ? static_cast<float>(1.0 / _resolution) :
+          1.0f)
+  {
+  }
+
+  /// \brief Write the coordinates of a point in the type of its fields.
+  /// \param[out] _point Start of the point.
+  /// \param[in] _x X
+  /// \param[in] _y Y
+  /// \param[in] _z Z
+  void WriteXyz(char *_point, float _x, float _y, float _z) const
+  {
+    if (!this->quantized)
+    {
+      std::memcpy(_point + this->x, &_x, sizeof(_x));
+      std::memcpy(_point + this->y, &_y, sizeof(_y));
+      std::memcpy(_point + this->z, &_z, sizeof(_z));
+      return;
+    }
+    const int16_t qx =
+        PointCloudUtil::QuantizeCoordinate(_x, this->inverseResolution);
+    const int16_t qy =
+        PointCloudUtil::QuantizeCoordinate(_y, this->inverseResolution);
+    const int16_t qz =
+        PointCloudUtil::QuantizeCoordinate(_z, this->inverseResolution);
+    std::memcpy(_point + this->x, &qx, sizeof(qx));
+    std::memcpy(_point + this->y, &qy, sizeof(qy));
+    std::memcpy(_point + this->z, &qz, sizeof(qz));
+  }
+
+  /// \brief Offset of the x field.
+  uint32_t x;
+
+  /// \brief Offset of the y field.
+  uint32_t y;
+
+  /// \brief Offset of the z field.
+  uint32_t z;
+
+  /// \brief Offset of the rgb field.
+  uint32_t rgb;
+
+  /// \brief Offset of the red byte inside the rgb field.
+  uint32_t r;
+
+  /// \brief Offset of the blue byte inside the rgb field.
+  uint32_t b;
+
+  /// \brief True if coordinates are quantized to INT16.
+  bool quantized;
+
+  /// \brief One over the resolution of quantized coordinates.
+  float inverseResolution;
+};
+
+//////////////////////////////////////////////////
+/// \brief Check if a message uses the packed little endian XYZRGB layout
+/// created by RgbdCameraSensor and DepthCameraSensor: four 32 bit fields at
+/// offsets 0, 4, 8 and 12 of a 16 byte point, without row padding. Points of
+/// this layout can be written as whole 16 byte blocks.
+/// \param[in] _msg Message to check.
+/// \return True if the fast path can be used.
+bool IsPackedXyzRgb(const msgs::PointCloudPacked &_msg)
+{
+  const uint32_t one = 1u;
+  unsigned char hostLittleEndian = 0u;
+  std::memcpy(&hostLittleEndian, &one, 1u);
+
+  return hostLittleEndian && !_msg.is_bigendian() &&
+      _msg.field_size() >= 4 &&
+      _msg.field(0).datatype() == msgs::PointCloudPacked::Field::FLOAT32 &&
+      _msg.field(0).offset() == 0u && _msg.field(1).offset() == 4u &&
+      _msg.field(2).offset() == 8u && _msg.field(3).offset() == 12u &&
+      _msg.point_step() == 16u &&
+      _msg.row_step() == _msg.width() * _msg.point_step();
+}
+
+//////////////////////////////////////////////////
+/// \brief Pack a little endian rgb field. The padding byte is written as
+/// zero, which is what the zero filled message buffer holds there.
+/// \param[in] _r Red
+/// \param[in] _g Green
+/// \param[in] _b Blue
+/// \return The 32 bit field value.
+inline uint32_t PackRgb(uint8_t _r, uint8_t _g, uint8_t _b)
+{
+  return static_cast<uint32_t>(_b) | (static_cast<uint32_t>(_g) << 8) |
+      (static_cast<uint32_t>(_r) << 16);
+}
+
+//////////////////////////////////////////////////
+/// \brief Write one packed XYZRGB point.
+/// \param[out] _dst Destination, 16 bytes.
+/// \param[in] _x X
+/// \param[in] _y Y
+/// \param[in] _z Z
+/// \param[in] _rgb Packed rgb field.
+inline void WritePackedPoint(char *_dst, float _x, float _y, float _z,
+    uint32_t _rgb)
+{
+  float xyz[3] = {_x, _y, _z};
+  std::memcpy(_dst, xyz, sizeof(xyz));
+  std::memcpy(_dst + 12, &_rgb, sizeof(_rgb));
+}
+
+//////////////////////////////////////////////////
+/// \brief Convert [X, Y, Z, RGBA] points to the packed XYZRGB layout. The
+/// rgb field is the RGBA value shifted right by 8 bits, which drops alpha
+/// and leaves b, g, r, 0 in memory. SSE2 converts a whole point per
+/// instruction.
+/// \param[out] _dst Destination, 16 bytes per point.
+/// \param[in] _src Source, 4 floats per point.
+/// \param[in] _count Number of points.
+void PackXyzRgba(char *_dst, const float *_src, std::size_t _count)
+{
+  std::size_t i = 0u;
+#if defined(__SSE2__)
+  const __m128i xyzMask = _mm_set_epi32(0, -1, -1, -1);
+  for (; i < _count; ++i)
+  {
+    const __m128i point = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(_src + i * 4u));
+    const __m128i rgb = _mm_andnot_si128(xyzMask, _mm_srli_epi32(point, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_dst + i * 16u),
+        _mm_or_si128(_mm_and_si128(point, xyzMask), rgb));
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    uint32_t rgba;
+    std::memcpy(&rgba, _src + i * 4u + 3u, sizeof(rgba));
+    WritePackedPoint(_dst + i * 16u, _src[i * 4u], _src[i * 4u + 1u],
+        _src[i * 4u + 2u], rgba >> 8);
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Set depths beyond the far clip to +inf and depths closer than
+/// the near clip to -inf. SSE2 clips four depths per instruction.
+/// \param[in,out] _depth Depths to clip.
+/// \param[in] _count Number of depths.
+/// \param[in] _near Near clip distance.
+/// \param[in] _far Far clip distance.
+/// \return True if any depth is infinite after clipping.
+bool ClipDepths(float *_depth, std::size_t _count, double _near,
+    double _far)
+{
+  // Float thresholds that compare like the double ones: a float is
+  // beyond _far if and only if it is beyond the largest float not above it
+  const float inf = math::INF_F;
+  float farF = static_cast<float>(_far);
+  if (farF > _far)
+    farF = std::nextafter(farF, -inf);
+  float nearF = static_cast<float>(_near);
+  if (nearF < _near)
+    nearF = std::nextafter(nearF, inf);
+
+  std::size_t i = 0u;
+  int hasInf = 0;
+#if defined(__SSE2__)
+  const __m128 farV = _mm_set1_ps(farF);
+  const __m128 nearV = _mm_set1_ps(nearF);
+  const __m128 infV = _mm_set1_ps(inf);
+  const __m128 negInfV = _mm_set1_ps(-inf);
+  __m128 anyInf = _mm_setzero_ps();
+  for (; i + 4u <= _count; i += 4u)
+  {
+    __m128 d = _mm_loadu_ps(_depth + i);
+    const __m128 isFar = _mm_cmpgt_ps(d, farV);
+    d = _mm_or_ps(_mm_and_ps(isFar, infV), _mm_andnot_ps(isFar, d));
+    const __m128 isNear = _mm_cmplt_ps(d, nearV);
+    d = _mm_or_ps(_mm_and_ps(isNear, negInfV), _mm_andnot_ps(isNear, d));
+    _mm_storeu_ps(_depth + i, d);
+    anyInf = _mm_or_ps(anyInf, _mm_or_ps(_mm_cmpeq_ps(d, infV),
+        _mm_cmpeq_ps(d, negInfV)));
+  }
+  hasInf = _mm_movemask_ps(anyInf);
+#endif
+  for (; i < _count; ++i)
+  {
+    float d = _depth[i];
+    d = d > farF ? inf : d;
+    d = d < nearF ? -inf : d;
+    _depth[i] = d;
+    hasInf |= (d == inf) | (d == -inf);
+  }
+  return hasInf != 0;
+}
+
+//////////////////////////////////////////////////
+/// \brief Convert depths to gray levels, (_far - depth) * _scale saturated
+/// to [0, 255] and truncated, with NaN depths black. All three
+/// channels of an RGB pixel take the gray level. SSE2 converts 16 depths
+/// per iteration.
+/// \param[out] _dst RGB pixels, 3 bytes per depth.
+/// \param[in] _src Depths.
+/// \param[in] _count Number of depths.
+/// \param[in] _far Depth that maps to black.
+/// \param[in] _scale Gray levels per meter.
+void DepthToGray(unsigned char *_dst, const float *_src, std::size_t _count,
+    float _far, float _scale)
+{
+  std::size_t i = 0u;
+#if defined(__SSE2__)
+  const __m128 farV = _mm_set1_ps(_far);
+  const __m128 scaleV = _mm_set1_ps(_scale);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 white = _mm_set1_ps(255.0f);
+  alignas(16) unsigned char gray[16];
+  for (; i + 16u <= _count; i += 16u)
+  {
+    __m128i levels[4];
+    for (int k = 0; k < 4; ++k)
+    {
+      __m128 v = _mm_mul_ps(_mm_sub_ps(farV, _mm_loadu_ps(_src + i + k * 4)),
+          scaleV);
+      // max returns its second operand for NaN
+      v = _mm_min_ps(_mm_max_ps(v, zero), white);
+      levels[k] = _mm_cvttps_epi32(v);
+    }
+    _mm_store_si128(reinterpret_cast<__m128i *>(gray), _mm_packus_epi16(
+        _mm_packs_epi32(levels[0], levels[1]),
+        _mm_packs_epi32(levels[2], levels[3])));
+    unsigned char *dst = _dst + i * 3u;
+    for (int k = 0; k < 16; ++k)
+    {
+      dst[k * 3] = gray[k];
+      dst[k * 3 + 1] = gray[k];
+      dst[k * 3 + 2] = gray[k];
+    }
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    float v = (_far - _src[i]) * _scale;
+    v = v > 0.0f ? v : 0.0f;
+    v = v < 255.0f ? v : 255.0f;
+    const unsigned char level = static_cast<unsigned char>(v);
+    _dst[i * 3u] = level;
+    _dst[i * 3u + 1u] = level;
+    _dst[i * 3u + 2u] = level;
+  }
+}
+}
+
+//////////////////////////////////////////////////
+PointCloudUtil::PointCloudUtil() = default;
+
+//////////////////////////////////////////////////
+PointCloudUtil::~PointCloudUtil() = default;
+
+//////////////////////////////////////////////////
+void PointCloudUtil::SetThreadCount(unsigned int _count)
+{
+  if (_count == 0u)
+    _count = 1u;
+  if (_count == this->ThreadCount())
+    return;
+
+  this->workers.reset();
+  if (_count > 1u)
+    this->workers = std::make_unique<RowWorkers>(_count);
+}
+
+//////////////////////////////////////////////////
+unsigned int PointCloudUtil::ThreadCount() const
+{
+  return this->workers ? this->workers->Count() : 1u;
+}
+
+//////////////////////////////////////////////////
+void PointCloudUtil::SetResolution(double _resolution)
+{
+  this->resolution = _resolution > 0.0 ? _resolution : 0.0;
+}
+
+//////////////////////////////////////////////////
+double PointCloudUtil::Resolution() const
+{
+  return this->resolution;
+}
+
+//////////////////////////////////////////////////
+void PointCloudUtil::InitMsg(msgs::PointCloudPacked &_msg,
+    const std::string &_frameId,
+    const std::vector<std::pair<std::string,
+        msgs::PointCloudPacked::Field::DataType>> &_fields) const
+{
+  const bool quantized = this->resolution > 0.0;
+  std::vector<std::pair<std::string,
+      msgs::PointCloudPacked::Field::DataType>> fields;
+  fields.reserve(_fields.size() + 1u);
+  fields.emplace_back("xyz", quantized ?
+      msgs::PointCloudPacked::Field::INT16 :
+      msgs::PointCloudPacked::Field::FLOAT32);
+  fields.insert(fields.end(), _fields.begin(), _fields.end());
+
+  _msg.Clear();
+  msgs::InitPointCloudPacked(_msg, _frameId, !quantized, fields);
+
+  if (quantized)
+  {
+    auto data = _msg.mutable_header()->add_data();
+    data->set_key("xyz_resolution");
+    std::ostringstream value;
+    value << this->resolution;
+    data->add_value(value.str());
+  }
+}
+
+//////////////////////////////////////////////////
+void PointCloudUtil::ForEachRowRange(uint32_t _rows,
+    const std::function<void(uint32_t, uint32_t)> &_fn) const
+{
+  if (!this->workers || _rows < 2u)
+  {
+    _fn(0u, _rows);
+    return;
+  }
+  this->workers->Run(_rows, _fn);
+}
+
 //////////////////////////////////////////////////
 void PointCloudUtil::FillMsg(msgs::PointCloudPacked &_msg,
     const math::Angle &_hfov, const unsigned char *_imageData,
@@ -35,58 +387,75 @@ void PointCloudUtil::FillMsg(msgs::PointCloudPacked &_msg,
 
   std::string *msgBuffer = _msg.mutable_data();
   msgBuffer->resize(_msg.row_step() * _msg.height());
-  char *msgBufferIndex = msgBuffer->data();
+  char *msgData = msgBuffer->data();
+
+  const bool packed = IsPackedXyzRgb(_msg);
+  const PointFieldOffsets offsets(_msg, this->resolution);
+  const uint32_t pointStep = _msg.point_step();
 
   // For depth calculation from image
   double fl = width / (2.0 * std::tan(_hfov.Radian() / 2.0));
 
-  // Iterate over scan and populate point cloud
-  for (uint32_t j = 0; j < height; ++j)
+  // The horizontal angle only depends on the column
+  thread_local std::vector<float> yTanBuffer;
+  yTanBuffer.resize(width);
+  for (uint32_t i = 0; i < width; ++i)
   {
-    float pAngle = 0.0;
-    if (fl > 0 && height > 1)
-      pAngle = std::atan2((height-j-1) - 0.5 * (height - 1), fl);
+    float yAngle = 0.0;
+    if (fl > 0 && width > 1)
+      yAngle = std::atan2(0.5 * (width - 1) - i, fl);
+    yTanBuffer[i] = std::tan(yAngle);
+  }
+  const float *yTan = yTanBuffer.data();
 
-    for (uint32_t i = 0; i < width; ++i)
+  // Iterate over scan and populate point cloud
+  this->ForEachRowRange(height, [&](uint32_t _begin, uint32_t _end)
+  {
+    char *msgBufferIndex = msgData +
+        static_cast<std::size_t>(_begin) * width * pointStep;
+    for (uint32_t j = _begin; j < _end; ++j)
     {
-      int fieldIndex = 0;
-
-      // Current point depth
-      float depth = _depthData[j * width + i];
-
-      float yAngle = 0.0;
-      if (fl > 0 && width > 1)
-        yAngle = std::atan2(0.5 * (width - 1) - i, fl);
-
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) = depth;
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) =
-        depth * std::tan(yAngle);
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) =
-        depth * std::tan(pAngle);
-
-      int imgIndex = i * 3 + j * width * 3;
-      int fieldOffset = _msg.field(fieldIndex).offset();
-      // Put image color data for each point, check endianess first.
-      if (_msg.is_bigendian())
+      float pAngle = 0.0;
+      if (fl > 0 && height > 1)
+        pAngle = std::atan2((height-j-1) - 0.5 * (height - 1), fl);
+      const float pTan = std::tan(pAngle);
+
+      const float *depthRow = _depthData + j * width;
+      const unsigned char *imageRow = _imageData + j * width * 3;
+
+      if (packed)
       {
-        *(msgBufferIndex + fieldOffset + 0) = _imageData[imgIndex + 0];
-        *(msgBufferIndex + fieldOffset + 1) = _imageData[imgIndex + 1];
-        *(msgBufferIndex + fieldOffset + 2) = _imageData[imgIndex + 2];
+        for (uint32_t i = 0; i < width; ++i)
+        {
+          const float depth = depthRow[i];
+          const unsigned char *pixel = imageRow + i * 3;
+          WritePackedPoint(msgBufferIndex + i * 16, depth, depth * yTan[i],
+              depth * pTan, PackRgb(pixel[0], pixel[1], pixel[2]));
+        }
+        msgBufferIndex += width * 16;
+        continue;
       }
-      else
+
+      for (uint32_t i = 0; i < width; ++i)
       {
-        *(msgBufferIndex + fieldOffset + 0) = _imageData[imgIndex + 2];
-        *(msgBufferIndex + fieldOffset + 1) = _imageData[imgIndex + 1];
-        *(msgBufferIndex + fieldOffset + 2) = _imageData[imgIndex + 0];
-      }
+        // Current point depth
+        float depth = depthRow[i];
 
-      // Add any padding
-      msgBufferIndex += _msg.point_step();
+        offsets.WriteXyz(msgBufferIndex, depth, depth * yTan[i],
+            depth * pTan);
+
+        // Put image color data for each point in the message byte order
+        const unsigned char *pixel = imageRow + i * 3;
+        char *rgb = msgBufferIndex + offsets.rgb;
+        rgb[offsets.r] = pixel[0];
+        rgb[1] = pixel[1];
+        rgb[offsets.b] = pixel[2];
+
+        // Add any padding
+        msgBufferIndex += pointStep;
+      }
     }
-  }
+  });
 }
 
 //////////////////////////////////////////////////
@@ -98,50 +467,48 @@ void PointCloudUtil::FillMsg(msgs::PointCloudPacked &_msg,
 
   std::string *msgBuffer = _msg.mutable_data();
   msgBuffer->resize(_msg.row_step() * _msg.height());
-  char *msgBufferIndex = msgBuffer->data();
+  char *msgData = msgBuffer->data();
+
+  const bool packed = IsPackedXyzRgb(_msg);
+  const PointFieldOffsets offsets(_msg, this->resolution);
+  const uint32_t pointStep = _msg.point_step();
 
   // Iterate over scan and populate point cloud
-  for (uint32_t j = 0; j < height; ++j)
+  this->ForEachRowRange(height, [&](uint32_t _begin, uint32_t _end)
   {
-    int step = j*width*3;
-    for (uint32_t i = 0; i < width; ++i)
+    const std::size_t first = static_cast<std::size_t>(_begin) * width;
+    const std::size_t last = static_cast<std::size_t>(_end) * width;
+    char *msgBufferIndex = msgData + first * pointStep;
+
+    if (packed)
     {
-      int index = step + i*3;
-      float x = _xyzData[index];
-      float y = _xyzData[index + 1];
-      float z = _xyzData[index + 2];
-
-      int fieldIndex = 0;
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) = x;
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) = y;
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) = z;
-
-      uint8_t r = static_cast<uint8_t>(_imageData[index]);
-      uint8_t g = static_cast<uint8_t>(_imageData[index + 1]);
-      uint8_t b = static_cast<uint8_t>(_imageData[index + 2]);
-
-      int fieldOffset = _msg.field(fieldIndex).offset();
-      // Put image color data for each point, check endianess first.
-      if (_msg.is_bigendian())
-      {
-        *(msgBufferIndex + fieldOffset + 0) = r;
-        *(msgBufferIndex + fieldOffset + 1) = g;
-        *(msgBufferIndex + fieldOffset + 2) = b;
-      }
-      else
+      for (std::size_t i = first; i < last; ++i)
       {
-        *(msgBufferIndex + fieldOffset + 0) = b;
-        *(msgBufferIndex + fieldOffset + 1) = g;
-        *(msgBufferIndex + fieldOffset + 2) = r;
+        const float *xyz = _xyzData + i * 3u;
+        const unsigned char *pixel = _imageData + i * 3u;
+        WritePackedPoint(msgBufferIndex, xyz[0], xyz[1], xyz[2],
+            PackRgb(pixel[0], pixel[1], pixel[2]));
+        msgBufferIndex += 16u;
       }
+      return;
+    }
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+      const float *xyz = _xyzData + i * 3u;
+      offsets.WriteXyz(msgBufferIndex, xyz[0], xyz[1], xyz[2]);
+
+      // Put image color data for each point in the message byte order
+      const unsigned char *pixel = _imageData + i * 3u;
+      char *rgb = msgBufferIndex + offsets.rgb;
+      rgb[offsets.r] = pixel[0];
+      rgb[1] = pixel[1];
+      rgb[offsets.b] = pixel[2];
 
       // Add any padding
-      msgBufferIndex += _msg.point_step();
+      msgBufferIndex += pointStep;
     }
-  }
+  });
 }
 
 //////////////////////////////////////////////////
@@ -155,55 +522,64 @@ void PointCloudUtil::FillMsg(msgs::PointCloudPacked &_msg,
 
   std::string *msgBuffer = _msg.mutable_data();
   msgBuffer->resize(_msg.row_step() * _msg.height());
-  char *msgBufferIndex = msgBuffer->data();
+  char *msgData = msgBuffer->data();
+
+  const bool packed = IsPackedXyzRgb(_msg);
+  const PointFieldOffsets offsets(_msg, this->resolution);
+  const uint32_t pointStep = _msg.point_step();
 
   // Iterate over scan and populate point cloud
-  for (uint32_t j = 0; j < height; ++j)
+  this->ForEachRowRange(height, [&](uint32_t _begin, uint32_t _end)
   {
-    int pcStep = j*width*4;
-    int imgStep = j*width*3;
-    for (uint32_t i = 0; i < width; ++i)
+    const std::size_t first = static_cast<std::size_t>(_begin) * width;
+    const std::size_t last = static_cast<std::size_t>(_end) * width;
+    char *msgBufferIndex = msgData + first * pointStep;
+
+    if (packed)
     {
-      int pcIndex = pcStep + i*4;
-      float x = _pointCloudData[pcIndex];
-      float y = _pointCloudData[pcIndex + 1];
-      float z = _pointCloudData[pcIndex + 2];
-      float rgba = _pointCloudData[pcIndex + 3];
+      PackXyzRgba(msgBufferIndex, _pointCloudData + first * 4u,
+          last - first);
 
-      int fieldIndex = 0;
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) = x;
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) = y;
-      *reinterpret_cast<float*>(msgBufferIndex +
-          _msg.field(fieldIndex++).offset()) = z;
+      // Fill buffers
+      if (_writeToBuffers && _xyzData)
+      {
+        this->XYZFromPointCloud(_xyzData + first * 3u,
+            _pointCloudData + first * 4u, width, _end - _begin);
+      }
+      if (_writeToBuffers && _imageData)
+      {
+        this->RGBFromPointCloud(_imageData + first * 3u,
+            _pointCloudData + first * 4u, width, _end - _begin);
+      }
+      return;
+    }
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+      const float *point = _pointCloudData + i * 4u;
+      float x = point[0];
+      float y = point[1];
+      float z = point[2];
+
+      offsets.WriteXyz(msgBufferIndex, x, y, z);
 
       uint8_t r = 0u;
       uint8_t g = 0u;
       uint8_t b = 0u;
       uint8_t a = 255u;
-      this->DecodeRGBAFromFloat(rgba, r, g, b, a);
+      this->DecodeRGBAFromFloat(point[3], r, g, b, a);
 
-      int fieldOffset = _msg.field(fieldIndex).offset();
-      // Put image color data for each point, check endianess first.
-      if (_msg.is_bigendian())
-      {
-        *(msgBufferIndex + fieldOffset + 0) = r;
-        *(msgBufferIndex + fieldOffset + 1) = g;
-        *(msgBufferIndex + fieldOffset + 2) = b;
-      }
-      else
-      {
-        *(msgBufferIndex + fieldOffset + 0) = b;
-        *(msgBufferIndex + fieldOffset + 1) = g;
-        *(msgBufferIndex + fieldOffset + 2) = r;
-      }
+      // Put image color data for each point in the message byte order
+      char *rgb = msgBufferIndex + offsets.rgb;
+      rgb[offsets.r] = r;
+      rgb[1] = g;
+      rgb[offsets.b] = b;
 
       // Add any padding
-      msgBufferIndex += _msg.point_step();
+      msgBufferIndex += pointStep;
 
       // Fill buffers
-      int imgIndex = imgStep + i * 3;
+      std::size_t imgIndex = i * 3u;
       if (_writeToBuffers && _xyzData)
       {
         _xyzData[imgIndex + 0] = x;
@@ -217,9 +593,100 @@ void PointCloudUtil::FillMsg(msgs::PointCloudPacked &_msg,
         _imageData[imgIndex + 2] = static_cast<unsigned char>(b);
       }
     }
-  }
+  });
 }
 
+//////////////////////////////////////////////////
+void PointCloudUtil::FillRgbdMsg(msgs::PointCloudPacked *_msg,
+    const float *_pointCloudData, float *_depthData, uint32_t _width,
+    uint32_t _height, double _nearClip, double _farClip,
+    unsigned char *_imageData) const
+{
+  if (!_pointCloudData)
+  {
+    _msg = nullptr;
+    _imageData = nullptr;
+  }
+
+  // Points of infinite depths are only patched when clipping is enabled
+  const bool clip = _depthData &&
+      (std::isfinite(_nearClip) || std::isfinite(_farClip));
+
+  char *msgData = nullptr;
+  bool packed = false;
+  uint32_t pointStep = 0u;
+  std::optional<PointFieldOffsets> offsets;
+  if (_msg)
+  {
+    std::string *msgBuffer = _msg->mutable_data();
+    msgBuffer->resize(static_cast<std::size_t>(_msg->row_step()) *
+        _msg->height());
+    msgData = msgBuffer->data();
+    packed = IsPackedXyzRgb(*_msg);
+    pointStep = _msg->point_step();
+    offsets.emplace(*_msg, this->resolution);
+  }
+
+  this->ForEachRowRange(_height, [&](uint32_t _begin, uint32_t _end)
+  {
+    for (uint32_t j = _begin; j < _end; ++j)
+    {
+      const std::size_t first = static_cast<std::size_t>(j) * _width;
+      const float *point = _pointCloudData ?
+          _pointCloudData + first * 4u : nullptr;
+
+      // The following code is a work around since gz-rendering's depth
+      // camera does not support 2 different clipping distances.
+      const bool hasInf = clip &&
+          ClipDepths(_depthData + first, _width, _nearClip, _farClip);
+
+      if (_msg)
+      {
+        char *row = msgData + first * pointStep;
+        if (packed)
+        {
+          PackXyzRgba(row, point, _width);
+        }
+        else
+        {
+          for (uint32_t i = 0; i < _width; ++i)
+          {
+            const float *p = point + i * 4u;
+            char *dst = row + static_cast<std::size_t>(i) * pointStep;
+            offsets->WriteXyz(dst, p[0], p[1], p[2]);
+
+            uint8_t r = 0u;
+            uint8_t g = 0u;
+            uint8_t b = 0u;
+            uint8_t a = 255u;
+            this->DecodeRGBAFromFloat(p[3], r, g, b, a);
+            char *rgb = dst + offsets->rgb;
+            rgb[offsets->r] = r;
+            rgb[1] = g;
+            rgb[offsets->b] = b;
+          }
+        }
+
+        // Points of clipped or missing depths take that depth
+        if (hasInf)
+        {
+          const float *depth = _depthData + first;
+          for (uint32_t i = 0; i < _width; ++i)
+          {
+            if (std::isinf(depth[i]))
+            {
+              offsets->WriteXyz(row + static_cast<std::size_t>(i) * pointStep,
+                  depth[i], depth[i], depth[i]);
+            }
+          }
+        }
+      }
+
+      if (_imageData)
+        this->RGBFromPointCloud(_imageData + first * 3u, point, _width, 1u);
+    }
+  });
+}
 
 //////////////////////////////////////////////////
 void PointCloudUtil::RGBFromPointCloud(unsigned char *_imageData,
@@ -269,6 +736,275 @@ void PointCloudUtil::XYZFromPointCloud(float *_xyzData,
   }
 }
 
+//////////////////////////////////////////////////
+void PointCloudUtil::NormalsFromPointCloud(float *_normals,
+    const float *_pointCloudData, unsigned int _width, unsigned int _height)
+    const
+{
+  const std::size_t width = _width;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+
+  auto finite = [](const float *_p)
+  {
+    return std::isfinite(_p[0]) && std::isfinite(_p[1]) &&
+        std::isfinite(_p[2]);
+  };
+
+  // Shortest finite difference between the point and the neighbours at
+  // -_stride and +_stride, false if neither neighbour is finite
+  auto difference = [&](const float *_p, bool _hasPrev, bool _hasNext,
+      std::ptrdiff_t _stride, float *_d)
+  {
+    float best = std::numeric_limits<float>::infinity();
+    bool found = false;
+    for (int side = 0; side < 2; ++side)
+    {
+      if (!(side == 0 ? _hasPrev : _hasNext))
+        continue;
+      const float *q = _p + (side == 0 ? -_stride : _stride);
+      if (!finite(q))
+        continue;
+      // Differences point towards increasing indices
+      const float sign = side == 0 ? -1.0f : 1.0f;
+      const float d[3] = {sign * (q[0] - _p[0]), sign * (q[1] - _p[1]),
+          sign * (q[2] - _p[2])};
+      const float length = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+      if (length < best)
+      {
+        best = length;
+        std::copy(d, d + 3, _d);
+        found = true;
+      }
+    }
+    return found;
+  };
+
+  this->ForEachRowRange(_height, [&](uint32_t _begin, uint32_t _end)
+  {
+    for (uint32_t j = _begin; j < _end; ++j)
+    {
+      for (std::size_t i = 0u; i < width; ++i)
+      {
+        const std::size_t index = j * width + i;
+        const float *p = _pointCloudData + index * 4u;
+        float *n = _normals + index * 3u;
+        float du[3];
+        float dv[3];
+        if (!finite(p) ||
+            !difference(p, i > 0u, i + 1u < width, 4, du) ||
+            !difference(p, j > 0u, j + 1u < _height,
+                static_cast<std::ptrdiff_t>(width * 4u), dv))
+        {
+          n[0] = n[1] = n[2] = nan;
+          continue;
+        }
+
+        float x = du[1] * dv[2] - du[2] * dv[1];
+        float y = du[2] * dv[0] - du[0] * dv[2];
+        float z = du[0] * dv[1] - du[1] * dv[0];
+        const float length = std::sqrt(x * x + y * y + z * z);
+        if (!(length > 0.0f) || !std::isfinite(length))
+        {
+          n[0] = n[1] = n[2] = nan;
+          continue;
+        }
+        // Face the origin of the cloud
+        const float scale =
+            (x * p[0] + y * p[1] + z * p[2] > 0.0f ? -1.0f : 1.0f) / length;
+        n[0] = x * scale;
+        n[1] = y * scale;
+        n[2] = z * scale;
+      }
+    }
+  });
+}
+
+//////////////////////////////////////////////////
+float PointCloudUtil::MaxFiniteDepth(const float *_depthData,
+    std::size_t _count) const
+{
+  const float inf = math::INF_F;
+  float maxDepth = 0.0f;
+  std::size_t i = 0u;
+#if defined(__SSE2__)
+  const __m128 infV = _mm_set1_ps(inf);
+  __m128 maxV = _mm_setzero_ps();
+  for (; i + 4u <= _count; i += 4u)
+  {
+    // +inf and NaN fail the comparison and count as zero
+    const __m128 d = _mm_loadu_ps(_depthData + i);
+    maxV = _mm_max_ps(maxV, _mm_and_ps(_mm_cmplt_ps(d, infV), d));
+  }
+  alignas(16) float lanes[4];
+  _mm_store_ps(lanes, maxV);
+  for (float lane : lanes)
+    maxDepth = std::max(maxDepth, lane);
+#endif
+  for (; i < _count; ++i)
+  {
+    if (_depthData[i] > maxDepth && _depthData[i] < inf)
+      maxDepth = _depthData[i];
+  }
+  return maxDepth;
+}
+
+//////////////////////////////////////////////////
+void PointCloudUtil::DepthToImage(unsigned char *_imageData,
+    const float *_depthData, unsigned int _width, unsigned int _height,
+    float _near, float _far) const
+{
+  const float scale = _far > _near ? 255.0f / (_far - _near) : 0.0f;
+  this->ForEachRowRange(_height, [&](uint32_t _begin, uint32_t _end)
+  {
+    const std::size_t first = static_cast<std::size_t>(_begin) * _width;
+    DepthToGray(_imageData + first * 3u, _depthData + first,
+        static_cast<std::size_t>(_end - _begin) * _width, _far, scale);
+  });
+}
+
+//////////////////////////////////////////////////
+void PointCloudUtil::DepthToMillimeters(uint16_t *_dst,
+    const float *_depthData, std::size_t _count) const
+{
+  // Rounded depths from 1 to 65535 mm are kept, others become 0
+  const float limit = 65536.0f;
+  std::size_t i = 0u;
+#if defined(__SSE2__)
+  const __m128 thousand = _mm_set1_ps(1000.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 limitV = _mm_set1_ps(limit);
+  const __m128i bias = _mm_set1_epi32(32768);
+  const __m128i flip = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+  for (; i + 8u <= _count; i += 8u)
+  {
+    __m128i mm[2];
+    for (int k = 0; k < 2; ++k)
+    {
+      const __m128 d = _mm_loadu_ps(_depthData + i + k * 4);
+      const __m128 v = _mm_add_ps(_mm_mul_ps(d, thousand), half);
+      const __m128 valid = _mm_and_ps(_mm_cmpgt_ps(d, zero),
+          _mm_cmplt_ps(v, limitV));
+      // SSE2 only packs signed values, so shift to the int16 range
+      mm[k] = _mm_sub_epi32(_mm_cvttps_epi32(_mm_and_ps(valid, v)), bias);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_dst + i),
+        _mm_xor_si128(_mm_packs_epi32(mm[0], mm[1]), flip));
+  }
+#endif
+  for (; i < _count; ++i)
+  {
+    const float d = _depthData[i];
+    const float v = d * 1000.0f + 0.5f;
+    _dst[i] = d > 0.0f && v < limit ? static_cast<uint16_t>(v) : 0u;
+  }
+}
+
+//////////////////////////////////////////////////
+std::size_t PointCloudUtil::VoxelFilter(const msgs::PointCloudPacked &_msg,
+    double _voxelSize, msgs::PointCloudPacked &_out)
+{
+  const uint32_t width = _msg.width();
+  const uint32_t height = _msg.height();
+  const uint32_t pointStep = _msg.point_step();
+  const std::size_t points = static_cast<std::size_t>(width) * height;
+
+  *_out.mutable_header() = _msg.header();
+  *_out.mutable_field() = _msg.field();
+  _out.set_is_bigendian(_msg.is_bigendian());
+  _out.set_point_step(pointStep);
+  _out.set_height(1u);
+  _out.set_width(0u);
+  _out.set_row_step(0u);
+  _out.set_is_dense(true);
+  std::string *outData = _out.mutable_data();
+  outData->clear();
+
+  const std::size_t needed = points == 0u ? 0u :
+      static_cast<std::size_t>(_msg.row_step()) * (height - 1u) +
+      static_cast<std::size_t>(width) * pointStep;
+  if (!(_voxelSize > 0.0) || _msg.field_size() < 3 || pointStep == 0u ||
+      points == 0u || _msg.data().size() < needed)
+  {
+    return 0u;
+  }
+
+  const bool quantized =
+      _msg.field(0).datatype() == msgs::PointCloudPacked::Field::INT16;
+  const float scale = quantized && this->resolution > 0.0 ?
+      static_cast<float>(this->resolution) : 1.0f;
+  const float inverseVoxel = static_cast<float>(1.0 / _voxelSize);
+  const uint32_t offsets[3] = {_msg.field(0).offset(),
+      _msg.field(1).offset(), _msg.field(2).offset()};
+
+  // At most half full, so probes stay short
+  constexpr uint64_t kEmpty = std::numeric_limits<uint64_t>::max();
+  std::size_t capacity = 16u;
+  while (capacity < points * 2u)
+    capacity <<= 1u;
+  this->voxelTable.assign(capacity, kEmpty);
+  const std::size_t mask = capacity - 1u;
+
+  outData->resize(points * pointStep);
+  char *dst = outData->data();
+  std::size_t kept = 0u;
+  for (uint32_t j = 0; j < height; ++j)
+  {
+    const char *row = _msg.data().data() +
+        static_cast<std::size_t>(j) * _msg.row_step();
+    for (uint32_t i = 0; i < width; ++i)
+    {
+      const char *point = row + static_cast<std::size_t>(i) * pointStep;
+      uint64_t key = 0u;
+      bool valid = true;
+      for (int k = 0; k < 3; ++k)
+      {
+        float value;
+        if (quantized)
+        {
+          int16_t q;
+          std::memcpy(&q, point + offsets[k], sizeof(q));
+          valid = q != std::numeric_limits<int16_t>::min();
+          value = q * scale;
+        }
+        else
+        {
+          std::memcpy(&value, point + offsets[k], sizeof(value));
+          valid = std::isfinite(value);
+        }
+        if (!valid)
+          break;
+
+        // Clamped so the conversion is defined, far cells wrap anyway
+        const int64_t cell = static_cast<int64_t>(std::floor(std::fmax(
+            -1e18f, std::fmin(1e18f, value * inverseVoxel))));
+        key |= (static_cast<uint64_t>(cell) & 0x1FFFFFu) << (21 * k);
+      }
+      if (!valid)
+        continue;
+
+      std::size_t slot = static_cast<std::size_t>(
+          (key * 0x9E3779B97F4A7C15ull) >> 32u) & mask;
+      while (this->voxelTable[slot] != kEmpty &&
+             this->voxelTable[slot] != key)
+      {
+        slot = (slot + 1u) & mask;
+      }
+      if (this->voxelTable[slot] == key)
+        continue;
+      this->voxelTable[slot] = key;
+
+      std::memcpy(dst + kept * pointStep, point, pointStep);
+      ++kept;
+    }
+  }
+
+  outData->resize(kept * pointStep);
+  _out.set_width(static_cast<uint32_t>(kept));
+  _out.set_row_step(static_cast<uint32_t>(kept * pointStep));
+  return kept;
+}
+
 //////////////////////////////////////////////////
 void PointCloudUtil::DecodeRGBAFromFloat(float _rgba,
   uint8_t &_r, uint8_t &_g, uint8_t &_b, uint8_t &_a) const
@@ -27,7 +27,18 @@
 #if defined(_MSC_VER)
   #pragma warning(pop)
 #endif
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <gz/math/Angle.hh>
+#include <gz/utils/SuppressWarning.hh>
 
 #include "gz/sensors/config.hh"
 #include "gz/sensors/Export.hh"
@@ -49,11 +60,84 @@ namespace gz
     // Inline bracket to help doxygen filtering.
     inline namespace GZ_SENSORS_VERSION_NAMESPACE {
     //
+    // Forward declarations
+    class RowWorkers;
+
     /// \brief Helper class that fills a msgs::PointCloudPacked message using
     /// image and depth data. The RgbdCameraSensor and DepthCameraSensor
     /// class use this.
     class PointCloudUtil_EXPORTS_API PointCloudUtil
     {
+      /// \brief Constructor
+      public: PointCloudUtil();
+
+      /// \brief Destructor. Stops the worker threads.
+      public: ~PointCloudUtil();
+
+      /// \brief Set the number of threads that fill point clouds. The rows
+      /// of a cloud are split between the calling thread and _count - 1
+      /// worker threads owned by this object. The output is identical to a
+      /// fill on a single thread.
+      /// \param[in] _count Number of threads. Zero and one fill clouds on
+      /// the calling thread, which is the default.
+      public: void SetThreadCount(unsigned int _count);
+
+      /// \brief Get the number of threads that fill point clouds.
+      /// \return Number of threads, at least one.
+      public: unsigned int ThreadCount() const;
+
+      /// \brief Set the resolution of the coordinates of the clouds. With a
+      /// positive resolution, InitMsg declares x, y and z as INT16 fields
+      /// holding the coordinate divided by the resolution, and FillMsg
+      /// quantizes the coordinates. Coordinates beyond the int16 range are
+      /// clamped to +/-32767 and non-finite coordinates are stored as
+      /// -32768. Zero, the default, keeps FLOAT32 coordinates.
+      /// \param[in] _resolution Resolution in meters.
+      public: void SetResolution(double _resolution);
+
+      /// \brief Get the resolution of the coordinates of the clouds.
+      /// \return Resolution in meters, zero for FLOAT32 coordinates.
+      public: double Resolution() const;
+
+      /// \brief Initialize a point cloud message with x, y and z fields
+      /// followed by _fields. With float coordinates the fields are aligned
+      /// to memory boundaries as needed by ROS1; quantized clouds are
+      /// tightly packed and record the resolution under the
+      /// "xyz_resolution" key of their header. Any previous content of the
+      /// message is cleared.
+      /// \param[in,out] _msg Message to initialize.
+      /// \param[in] _frameId Frame of the cloud.
+      /// \param[in] _fields Names and types of the fields after z.
+      public: void InitMsg(msgs::PointCloudPacked &_msg,
+          const std::string &_frameId,
+          const std::vector<std::pair<std::string,
+              msgs::PointCloudPacked::Field::DataType>> &_fields) const;
+
+      /// \brief Quantize a coordinate for an INT16 field.
+      /// \param[in] _value Coordinate.
+      /// \param[in] _inverseResolution One over the resolution.
+      /// \return Quantized coordinate.
+      /// \sa SetResolution
+      public: static int16_t QuantizeCoordinate(float _value,
+          float _inverseResolution)
+      {
+        if (!std::isfinite(_value))
+          return std::numeric_limits<int16_t>::min();
+        const float scaled = std::round(_value * _inverseResolution);
+        const float limit = std::numeric_limits<int16_t>::max();
+        return static_cast<int16_t>(std::fmax(-limit, std::fmin(limit,
+            scaled)));
+      }
+
+      /// \brief Call a function on consecutive ranges of rows which cover
+      /// [0, _rows), one range per thread, and wait for all of them. The
+      /// function must only write data which belongs to its rows.
+      /// \param[in] _rows Number of rows.
+      /// \param[in] _fn Function called with the first row and one past
+      /// the last row of a range.
+      public: void ForEachRowRange(uint32_t _rows,
+          const std::function<void(uint32_t, uint32_t)> &_fn) const;
+
       /// \brief Fill a msgs::PointCloudPacked.
       /// \param[in,out] _msg Point cloud message to fill. This message
       /// should be initialized. See example usage in either
@@ -90,6 +174,30 @@ namespace gz
           const float *_pointCloudData, bool _writeToBuffers = false,
           unsigned char *_imageData = 0, float *_xyzData = 0) const;
 
+      /// \brief Produce all the outputs of an RGBD camera in a single sweep
+      /// over its pixels, one row at a time so that each row is still in
+      /// cache for the next stage. For each row, depths beyond the clipping
+      /// distances are set to +/-infinity, the point cloud is packed with
+      /// the points of infinite depths set to that depth, and the RGB image
+      /// is extracted. The output is identical to the separate passes.
+      /// \param[in,out] _msg Point cloud message to fill, initialized as in
+      /// RgbdCameraSensor. Null to skip the point cloud.
+      /// \param[in] _pointCloudData Point cloud XYZ RGBA data. Null to skip
+      /// the point cloud and the image.
+      /// \param[in,out] _depthData Depth image, clipped in place. Null to
+      /// skip clipping.
+      /// \param[in] _width Image width.
+      /// \param[in] _height Image height.
+      /// \param[in] _nearClip Depths below this are set to -infinity.
+      /// -infinity disables near clipping.
+      /// \param[in] _farClip Depths above this are set to +infinity.
+      /// +infinity disables far clipping.
+      /// \param[out] _imageData RGB image to fill. Null to skip the image.
+      public: void FillRgbdMsg(msgs::PointCloudPacked *_msg,
+          const float *_pointCloudData, float *_depthData, uint32_t _width,
+          uint32_t _height, double _nearClip, double _farClip,
+          unsigned char *_imageData) const;
+
       /// \brief Extract RGB data from point cloud data
       /// \param[out] _imageData RGB Image buffer to be filled.
       /// \param[in] _pointCloudData Point cloud XYZ data.
@@ -108,6 +216,74 @@ namespace gz
           const float *_pointCloudData, unsigned int _width,
           unsigned int _height) const;
 
+      /// \brief Estimate the surface normal at each point of an organized
+      /// point cloud from the differences between neighbouring points along
+      /// rows and columns. Of the differences with the previous and the
+      /// next point, the shorter one is used so that normals don't blend
+      /// surfaces across depth discontinuities. Normals are unit vectors in
+      /// the frame of the points, facing the origin of the cloud. Points
+      /// which aren't finite, or have no finite neighbour along a row or a
+      /// column, get NaN normals. Rows are split across the threads set
+      /// with SetThreadCount.
+      /// \param[out] _normals X, y and z of the normals, 3 floats per point.
+      /// \param[in] _pointCloudData Point cloud XYZ RGBA data.
+      /// \param[in] _width Image width
+      /// \param[in] _height Image height
+      public: void NormalsFromPointCloud(float *_normals,
+          const float *_pointCloudData, unsigned int _width,
+          unsigned int _height) const;
+
+      /// \brief Get the largest finite depth of a depth image.
+      /// \param[in] _depthData Depth image data.
+      /// \param[in] _count Number of depths.
+      /// \return Largest finite depth, zero if no depth is finite and
+      /// positive.
+      public: float MaxFiniteDepth(const float *_depthData,
+          std::size_t _count) const;
+
+      /// \brief Convert a depth image to a grayscale RGB image, white at
+      /// _near and black at _far. Depths beyond the range saturate, and NaN
+      /// depths are black. Rows are split across the threads set with
+      /// SetThreadCount.
+      /// \param[out] _imageData RGB image buffer to be filled.
+      /// \param[in] _depthData Depth image data.
+      /// \param[in] _width Image width
+      /// \param[in] _height Image height
+      /// \param[in] _near Depth that maps to white.
+      /// \param[in] _far Depth that maps to black. The image is black if
+      /// it isn't beyond _near.
+      public: void DepthToImage(unsigned char *_imageData,
+          const float *_depthData, unsigned int _width,
+          unsigned int _height, float _near, float _far) const;
+
+      /// \brief Convert depths in meters to rounded uint16 millimeters, as
+      /// in the 16UC1 depth images of hardware cameras. Depths that aren't
+      /// positive and finite, or that round beyond 65535 mm, are 0, which
+      /// marks a missing measurement. SSE2 converts 8 depths per
+      /// iteration.
+      /// \param[out] _dst Millimeters, one per depth.
+      /// \param[in] _depthData Depths in meters.
+      /// \param[in] _count Number of depths.
+      public: void DepthToMillimeters(uint16_t *_dst,
+          const float *_depthData, std::size_t _count) const;
+
+      /// \brief Voxel grid filter. Copy _msg into an unorganized cloud
+      /// with one point per cubic voxel of side _voxelSize: the first point
+      /// of the voxel in row major order, with all its fields. Points
+      /// without finite coordinates are dropped, so the output is dense.
+      /// INT16 coordinates are read with Resolution(). Voxels are hashed on
+      /// 21 bits per axis, so points more than about a million voxels apart
+      /// may share a voxel.
+      /// \param[in] _msg Cloud to filter, with x, y and z as its first
+      /// three fields.
+      /// \param[in] _voxelSize Side of the voxels, positive.
+      /// \param[out] _out Filtered cloud, one row of the kept points with
+      /// the header and fields of _msg. Its buffers are reused between
+      /// calls.
+      /// \return Number of points kept.
+      public: std::size_t VoxelFilter(const msgs::PointCloudPacked &_msg,
+          double _voxelSize, msgs::PointCloudPacked &_out);
+
       /// \brief Decode/unpack RGBA values from a floating point value.
       /// Point cloud data is encoded as [X, Y, Z, RGBA], with all four fields
       /// in 32 bit float format. This function helps to unpack the last field
@@ -119,6 +295,18 @@ namespace gz
       /// \param[out] _a Alpha [0-255]
       public: void DecodeRGBAFromFloat(float _rgba, uint8_t &_r, uint8_t &_g,
           uint8_t &_b, uint8_t &_a) const;
+
+      GZ_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+      /// \brief Worker threads, null when clouds are filled on the calling
+      /// thread.
+      private: std::unique_ptr<RowWorkers> workers;
+      GZ_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+
+      /// \brief Resolution of quantized coordinates, zero for floats.
+      private: double resolution{0.0};
+
+      /// \brief Open addressing table of the voxels seen by VoxelFilter.
+      private: std::vector<uint64_t> voxelTable;
     };
     }
   }
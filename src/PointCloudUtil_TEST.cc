@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <gz/msgs/Utility.hh>
+
+#include "PointCloudUtil.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+constexpr uint32_t kWidth = 7u;
+constexpr uint32_t kHeight = 5u;
+
+//////////////////////////////////////////////////
+/// \brief Create the XYZRGB cloud used by the depth and rgbd cameras.
+msgs::PointCloudPacked PackedMsg()
+{
+  msgs::PointCloudPacked msg;
+  msgs::InitPointCloudPacked(msg, "frame", true,
+      {{"xyz", msgs::PointCloudPacked::Field::FLOAT32},
+      {"rgb", msgs::PointCloudPacked::Field::FLOAT32}});
+  msg.set_width(kWidth);
+  msg.set_height(kHeight);
+  msg.set_row_step(msg.point_step() * kWidth);
+  return msg;
+}
+
+//////////////////////////////////////////////////
+/// \brief Create a cloud with the same fields but 4 bytes of padding per
+/// point, which takes the generic path.
+msgs::PointCloudPacked PaddedMsg()
+{
+  msgs::PointCloudPacked msg = PackedMsg();
+  msg.set_point_step(20u);
+  msg.set_row_step(msg.point_step() * kWidth);
+  return msg;
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that both clouds hold the same x, y, z and rgb values.
+void ExpectSamePoints(const msgs::PointCloudPacked &_packed,
+    const msgs::PointCloudPacked &_padded)
+{
+  ASSERT_EQ(_packed.data().size(), kWidth * kHeight * 16u);
+  ASSERT_EQ(_padded.data().size(), kWidth * kHeight * 20u);
+  for (uint32_t i = 0; i < kWidth * kHeight; ++i)
+  {
+    EXPECT_EQ(0, std::memcmp(_packed.data().data() + i * 16u,
+        _padded.data().data() + i * 20u, 16u)) << "point " << i;
+  }
+}
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, FillFromDepth)
+{
+  std::vector<float> depth(kWidth * kHeight);
+  std::vector<unsigned char> image(kWidth * kHeight * 3u);
+  for (std::size_t i = 0; i < depth.size(); ++i)
+    depth[i] = 0.5f + 0.25f * i;
+  for (std::size_t i = 0; i < image.size(); ++i)
+    image[i] = static_cast<unsigned char>(i * 7u);
+
+  PointCloudUtil util;
+  msgs::PointCloudPacked packed = PackedMsg();
+  msgs::PointCloudPacked padded = PaddedMsg();
+  util.FillMsg(packed, math::Angle(1.05), image.data(), depth.data());
+  util.FillMsg(padded, math::Angle(1.05), image.data(), depth.data());
+  ExpectSamePoints(packed, padded);
+
+  // Little endian rgb is stored as b, g, r
+  const char *point = packed.data().data() + 16u;
+  EXPECT_EQ(image[5], static_cast<unsigned char>(point[12]));
+  EXPECT_EQ(image[4], static_cast<unsigned char>(point[13]));
+  EXPECT_EQ(image[3], static_cast<unsigned char>(point[14]));
+  EXPECT_EQ(0, point[15]);
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, FillFromXyz)
+{
+  std::vector<float> xyz(kWidth * kHeight * 3u);
+  std::vector<unsigned char> image(kWidth * kHeight * 3u);
+  for (std::size_t i = 0; i < xyz.size(); ++i)
+    xyz[i] = -3.0f + 0.125f * i;
+  for (std::size_t i = 0; i < image.size(); ++i)
+    image[i] = static_cast<unsigned char>(255u - i);
+
+  PointCloudUtil util;
+  msgs::PointCloudPacked packed = PackedMsg();
+  msgs::PointCloudPacked padded = PaddedMsg();
+  util.FillMsg(packed, xyz.data(), image.data());
+  util.FillMsg(padded, xyz.data(), image.data());
+  ExpectSamePoints(packed, padded);
+
+  float x = 0.0f;
+  std::memcpy(&x, packed.data().data() + 32u, sizeof(x));
+  EXPECT_FLOAT_EQ(xyz[6], x);
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, FillFromPointCloud)
+{
+  std::vector<float> cloud(kWidth * kHeight * 4u);
+  for (std::size_t i = 0; i < kWidth * kHeight; ++i)
+  {
+    cloud[i * 4u] = 0.1f * i;
+    cloud[i * 4u + 1u] = -0.2f * i;
+    cloud[i * 4u + 2u] = 1.5f;
+    const uint32_t rgba = static_cast<uint32_t>(i * 0x01020304u) | 0xFFu;
+    std::memcpy(&cloud[i * 4u + 3u], &rgba, sizeof(rgba));
+  }
+
+  PointCloudUtil util;
+  msgs::PointCloudPacked packed = PackedMsg();
+  msgs::PointCloudPacked padded = PaddedMsg();
+  std::vector<unsigned char> packedImage(kWidth * kHeight * 3u);
+  std::vector<unsigned char> paddedImage(kWidth * kHeight * 3u);
+  std::vector<float> packedXyz(kWidth * kHeight * 3u);
+  std::vector<float> paddedXyz(kWidth * kHeight * 3u);
+  util.FillMsg(packed, cloud.data(), true, packedImage.data(),
+      packedXyz.data());
+  util.FillMsg(padded, cloud.data(), true, paddedImage.data(),
+      paddedXyz.data());
+  ExpectSamePoints(packed, padded);
+  EXPECT_EQ(packedImage, paddedImage);
+  EXPECT_EQ(packedXyz, paddedXyz);
+
+  // Alpha is dropped
+  uint8_t r = 0u;
+  uint8_t g = 0u;
+  uint8_t b = 0u;
+  uint8_t a = 0u;
+  util.DecodeRGBAFromFloat(cloud[3 * 4u + 3u], r, g, b, a);
+  const char *point = packed.data().data() + 3u * 16u;
+  EXPECT_EQ(b, static_cast<unsigned char>(point[12]));
+  EXPECT_EQ(g, static_cast<unsigned char>(point[13]));
+  EXPECT_EQ(r, static_cast<unsigned char>(point[14]));
+  EXPECT_EQ(0, point[15]);
+  EXPECT_EQ(r, packedImage[9]);
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, ThreadedFill)
+{
+  PointCloudUtil serial;
+  PointCloudUtil threaded;
+  EXPECT_EQ(1u, threaded.ThreadCount());
+  threaded.SetThreadCount(3u);
+  EXPECT_EQ(3u, threaded.ThreadCount());
+
+  std::vector<float> depth(kWidth * kHeight);
+  std::vector<unsigned char> image(kWidth * kHeight * 3u);
+  for (std::size_t i = 0; i < depth.size(); ++i)
+    depth[i] = 0.5f + 0.25f * i;
+  for (std::size_t i = 0; i < image.size(); ++i)
+    image[i] = static_cast<unsigned char>(i * 7u);
+
+  // Both the packed and the generic layouts give the same bytes
+  for (auto msg : {PackedMsg(), PaddedMsg()})
+  {
+    msgs::PointCloudPacked serialMsg = msg;
+    serial.FillMsg(serialMsg, math::Angle(1.05), image.data(), depth.data());
+    threaded.FillMsg(msg, math::Angle(1.05), image.data(), depth.data());
+    EXPECT_EQ(serialMsg.data(), msg.data());
+  }
+
+  // Every row is visited once
+  std::vector<int> visits(kHeight, 0);
+  threaded.ForEachRowRange(kHeight, [&](uint32_t _begin, uint32_t _end)
+  {
+    for (uint32_t j = _begin; j < _end; ++j)
+      ++visits[j];
+  });
+  EXPECT_EQ(std::vector<int>(kHeight, 1), visits);
+
+  threaded.SetThreadCount(0u);
+  EXPECT_EQ(1u, threaded.ThreadCount());
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, QuantizedFill)
+{
+  PointCloudUtil util;
+  EXPECT_DOUBLE_EQ(0.0, util.Resolution());
+  util.SetResolution(0.01);
+  EXPECT_DOUBLE_EQ(0.01, util.Resolution());
+
+  msgs::PointCloudPacked msg;
+  util.InitMsg(msg, "frame",
+      {{"rgb", msgs::PointCloudPacked::Field::FLOAT32}});
+  ASSERT_EQ(4, msg.field_size());
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(msgs::PointCloudPacked::Field::INT16, msg.field(i).datatype());
+  EXPECT_EQ(msgs::PointCloudPacked::Field::FLOAT32, msg.field(3).datatype());
+
+  bool hasResolution = false;
+  for (const auto &data : msg.header().data())
+  {
+    if (data.key() == "xyz_resolution")
+    {
+      hasResolution = true;
+      ASSERT_EQ(1, data.value_size());
+      EXPECT_DOUBLE_EQ(0.01, std::stod(data.value(0)));
+    }
+  }
+  EXPECT_TRUE(hasResolution);
+
+  msg.set_width(4u);
+  msg.set_height(1u);
+  msg.set_row_step(msg.point_step() * msg.width());
+
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> xyz = {1.234f, -0.5f, 0.0f, 1000.0f, -1000.0f, 0.004f,
+      inf, inf, inf, 0.016f, 0.0f, -0.016f};
+  std::vector<unsigned char> image(12u, 0u);
+  util.FillMsg(msg, xyz.data(), image.data());
+
+  auto coordinate = [&](uint32_t _point, int _field)
+  {
+    int16_t value = 0;
+    std::memcpy(&value, msg.data().data() + _point * msg.point_step() +
+        msg.field(_field).offset(), sizeof(value));
+    return value;
+  };
+  EXPECT_EQ(123, coordinate(0u, 0));
+  EXPECT_EQ(-50, coordinate(0u, 1));
+  EXPECT_EQ(0, coordinate(0u, 2));
+  EXPECT_EQ(32767, coordinate(1u, 0));
+  EXPECT_EQ(-32767, coordinate(1u, 1));
+  EXPECT_EQ(0, coordinate(1u, 2));
+  EXPECT_EQ(-32768, coordinate(2u, 0));
+  EXPECT_EQ(2, coordinate(3u, 0));
+  EXPECT_EQ(-2, coordinate(3u, 2));
+
+  // Back to float coordinates
+  util.SetResolution(0.0);
+  util.InitMsg(msg, "frame",
+      {{"rgb", msgs::PointCloudPacked::Field::FLOAT32}});
+  EXPECT_EQ(msgs::PointCloudPacked::Field::FLOAT32, msg.field(0).datatype());
+  EXPECT_EQ(16u, msg.point_step());
+  for (const auto &data : msg.header().data())
+    EXPECT_NE("xyz_resolution", data.key());
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, FusedRgbdFill)
+{
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> cloud(kWidth * kHeight * 4u);
+  std::vector<float> depth(kWidth * kHeight);
+  for (std::size_t i = 0; i < kWidth * kHeight; ++i)
+  {
+    cloud[i * 4u] = 0.1f * i;
+    cloud[i * 4u + 1u] = -0.2f * i;
+    cloud[i * 4u + 2u] = 1.5f;
+    const uint32_t rgba = static_cast<uint32_t>(i * 0x01020304u) | 0xFFu;
+    std::memcpy(&cloud[i * 4u + 3u], &rgba, sizeof(rgba));
+    depth[i] = 0.2f * i;
+  }
+  depth[4] = inf;
+  const double nearClip = 0.5;
+  const double farClip = 5.0;
+
+  PointCloudUtil util;
+  util.SetThreadCount(2u);
+  for (auto msg : {PackedMsg(), PaddedMsg()})
+  {
+    // Separate passes, as done before
+    std::vector<float> expectedDepth = depth;
+    std::vector<float> patched = cloud;
+    for (std::size_t i = 0; i < expectedDepth.size(); ++i)
+    {
+      if (expectedDepth[i] > farClip)
+        expectedDepth[i] = inf;
+      if (expectedDepth[i] < nearClip)
+        expectedDepth[i] = -inf;
+      if (std::isinf(expectedDepth[i]))
+      {
+        patched[i * 4u] = expectedDepth[i];
+        patched[i * 4u + 1u] = expectedDepth[i];
+        patched[i * 4u + 2u] = expectedDepth[i];
+      }
+    }
+    msgs::PointCloudPacked expectedMsg = msg;
+    std::vector<unsigned char> expectedImage(kWidth * kHeight * 3u);
+    util.FillMsg(expectedMsg, patched.data(), true, expectedImage.data());
+
+    std::vector<float> fusedDepth = depth;
+    std::vector<unsigned char> image(kWidth * kHeight * 3u);
+    util.FillRgbdMsg(&msg, cloud.data(), fusedDepth.data(), kWidth, kHeight,
+        nearClip, farClip, image.data());
+    EXPECT_EQ(expectedMsg.data(), msg.data());
+    EXPECT_EQ(expectedImage, image);
+    EXPECT_EQ(expectedDepth, fusedDepth);
+  }
+
+  // Outputs can be skipped, and disabled clipping leaves depths untouched
+  std::vector<float> unclipped = depth;
+  std::vector<unsigned char> image(kWidth * kHeight * 3u);
+  util.FillRgbdMsg(nullptr, cloud.data(), unclipped.data(), kWidth, kHeight,
+      -inf, inf, image.data());
+  EXPECT_EQ(depth, unclipped);
+  std::vector<unsigned char> expectedImage(kWidth * kHeight * 3u);
+  util.RGBFromPointCloud(expectedImage.data(), cloud.data(), kWidth, kHeight);
+  EXPECT_EQ(expectedImage, image);
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, DepthToImage)
+{
+  const float inf = std::numeric_limits<float>::infinity();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+
+  // Wide enough for the vectorized loops and their remainders
+  const uint32_t width = 21u;
+  const uint32_t height = 3u;
+  std::vector<float> depth(width * height);
+  for (std::size_t i = 0; i < depth.size(); ++i)
+    depth[i] = 0.25f * static_cast<float>(i % 17u);
+  depth[3] = inf;
+  depth[20] = -inf;
+  depth[33] = nan;
+  depth[50] = 9.5f;
+
+  PointCloudUtil util;
+  EXPECT_FLOAT_EQ(9.5f, util.MaxFiniteDepth(depth.data(), depth.size()));
+  for (std::size_t count = 0; count < 9u; ++count)
+  {
+    float expected = 0.0f;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      if (std::isfinite(depth[i]))
+        expected = std::max(expected, depth[i]);
+    }
+    EXPECT_FLOAT_EQ(expected, util.MaxFiniteDepth(depth.data(), count));
+  }
+  const std::vector<float> missing = {inf, -inf, nan, -1.0f, inf};
+  EXPECT_FLOAT_EQ(0.0f, util.MaxFiniteDepth(missing.data(), missing.size()));
+
+  const float nearDepth = 0.5f;
+  const float farDepth = 3.0f;
+  util.SetThreadCount(2u);
+  std::vector<unsigned char> image(depth.size() * 3u);
+  util.DepthToImage(image.data(), depth.data(), width, height, nearDepth,
+      farDepth);
+  for (std::size_t i = 0; i < depth.size(); ++i)
+  {
+    unsigned int expected = 0u;
+    if (std::isnan(depth[i]) || depth[i] >= farDepth)
+      expected = 0u;
+    else if (depth[i] <= nearDepth)
+      expected = 255u;
+    else
+    {
+      expected = static_cast<unsigned int>(
+          (farDepth - depth[i]) * (255.0f / (farDepth - nearDepth)));
+    }
+    EXPECT_EQ(expected, image[i * 3u]) << i;
+    EXPECT_EQ(image[i * 3u], image[i * 3u + 1u]) << i;
+    EXPECT_EQ(image[i * 3u], image[i * 3u + 2u]) << i;
+  }
+
+  // An empty range is black
+  util.DepthToImage(image.data(), depth.data(), width, height, 1.0f, 1.0f);
+  for (unsigned char level : image)
+    EXPECT_EQ(0u, level);
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, DepthToMillimeters)
+{
+  const float inf = std::numeric_limits<float>::infinity();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const std::vector<float> depth = {
+      1.0f, 0.0014f, 0.0016f, 65.535f, 65.5354f, 65.536f, 100.0f, inf,
+      -inf, nan, -1.0f, 0.0f, 2.5f, 0.0004f, 12.3456f, 3.0f, 7.0f};
+  const std::vector<uint16_t> expected = {
+      1000u, 1u, 2u, 65535u, 65535u, 0u, 0u, 0u,
+      0u, 0u, 0u, 0u, 2500u, 0u, 12346u, 3000u, 7000u};
+
+  PointCloudUtil util;
+  std::vector<uint16_t> mm(depth.size(), 1u);
+  util.DepthToMillimeters(mm.data(), depth.data(), depth.size());
+  EXPECT_EQ(expected, mm);
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, NormalsFromPointCloud)
+{
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+
+  // Plane z = 2 + 0.5 x in front of the origin, with a far surface in the
+  // last column and a missing point
+  std::vector<float> cloud(kWidth * kHeight * 4u);
+  for (uint32_t j = 0; j < kHeight; ++j)
+  {
+    for (uint32_t i = 0; i < kWidth; ++i)
+    {
+      float *p = cloud.data() + (j * kWidth + i) * 4u;
+      p[0] = 0.1f * i;
+      p[1] = 0.1f * j;
+      p[2] = i + 1u == kWidth ? 10.0f : 2.0f + 0.5f * p[0];
+      p[3] = 0.0f;
+    }
+  }
+  cloud[(2u * kWidth + 3u) * 4u] = nan;
+
+  PointCloudUtil util;
+  std::vector<float> normals(kWidth * kHeight * 3u);
+  util.NormalsFromPointCloud(normals.data(), cloud.data(), kWidth, kHeight);
+
+  const float scale = 1.0f / std::sqrt(1.25f);
+  for (uint32_t j = 0; j < kHeight; ++j)
+  {
+    for (uint32_t i = 0; i + 1u < kWidth; ++i)
+    {
+      const float *n = normals.data() + (j * kWidth + i) * 3u;
+      if (j == 2u && i == 3u)
+      {
+        EXPECT_TRUE(std::isnan(n[0]));
+        continue;
+      }
+      EXPECT_NEAR(0.5f * scale, n[0], 1e-5f) << i << " " << j;
+      EXPECT_NEAR(0.0f, n[1], 1e-5f) << i << " " << j;
+      EXPECT_NEAR(-scale, n[2], 1e-5f) << i << " " << j;
+    }
+  }
+
+  // A single row has no vertical neighbour
+  util.NormalsFromPointCloud(normals.data(), cloud.data(), kWidth, 1u);
+  EXPECT_TRUE(std::isnan(normals[0]));
+
+  // Threads give the same normals
+  std::vector<float> threadedNormals(normals.size());
+  util.NormalsFromPointCloud(normals.data(), cloud.data(), kWidth, kHeight);
+  PointCloudUtil threaded;
+  threaded.SetThreadCount(3u);
+  threaded.NormalsFromPointCloud(threadedNormals.data(), cloud.data(),
+      kWidth, kHeight);
+  EXPECT_EQ(0, std::memcmp(normals.data(), threadedNormals.data(),
+      normals.size() * sizeof(float)));
+}
+
+//////////////////////////////////////////////////
+TEST(PointCloudUtil_TEST, VoxelFilter)
+{
+  PointCloudUtil util;
+  msgs::PointCloudPacked msg = PackedMsg();
+  const uint32_t pointStep = msg.point_step();
+  msg.mutable_data()->resize(msg.row_step() * kHeight);
+  for (uint32_t i = 0; i < kWidth * kHeight; ++i)
+  {
+    // Pairs of points share a 1 m voxel, the last row isn't finite
+    float xyz[3] = {static_cast<float>(i / 2u) + 0.25f * (i % 2u), 0.5f,
+        -0.5f};
+    if (i >= kWidth * (kHeight - 1u))
+      xyz[1] = std::numeric_limits<float>::quiet_NaN();
+    const uint32_t rgb = i;
+    char *point = msg.mutable_data()->data() + i * pointStep;
+    std::memcpy(point, xyz, sizeof(xyz));
+    std::memcpy(point + msg.field(3).offset(), &rgb, sizeof(rgb));
+  }
+
+  msgs::PointCloudPacked out;
+  const std::size_t finite = kWidth * (kHeight - 1u);
+  const std::size_t expected = (finite + 1u) / 2u;
+  EXPECT_EQ(expected, util.VoxelFilter(msg, 1.0, out));
+  EXPECT_EQ(expected, out.width());
+  EXPECT_EQ(1u, out.height());
+  EXPECT_EQ(pointStep, out.point_step());
+  EXPECT_EQ(expected * pointStep, out.row_step());
+  EXPECT_EQ(out.row_step(), out.data().size());
+  EXPECT_TRUE(out.is_dense());
+  ASSERT_EQ(msg.field_size(), out.field_size());
+  EXPECT_EQ("frame", out.header().data(0).value(0));
+
+  // The first point of each voxel is kept, with all its fields
+  for (std::size_t k = 0; k < expected; ++k)
+  {
+    float x;
+    uint32_t rgb;
+    const char *point = out.data().data() + k * pointStep;
+    std::memcpy(&x, point, sizeof(x));
+    std::memcpy(&rgb, point + out.field(3).offset(), sizeof(rgb));
+    EXPECT_FLOAT_EQ(static_cast<float>(k), x);
+    EXPECT_EQ(k * 2u, rgb);
+  }
+
+  // Small voxels keep every finite point
+  EXPECT_EQ(finite, util.VoxelFilter(msg, 0.1, out));
+
+  // Quantized coordinates are read with the resolution, and -32768 marks
+  // points without coordinates
+  msgs::PointCloudPacked quantized;
+  util.SetResolution(0.01);
+  util.InitMsg(quantized, "frame", {});
+  quantized.set_width(3u);
+  quantized.set_height(1u);
+  quantized.set_row_step(quantized.point_step() * 3u);
+  const int16_t values[9] = {100, 0, 0, 150, 0, 0,
+      std::numeric_limits<int16_t>::min(), 0, 0};
+  quantized.mutable_data()->assign(reinterpret_cast<const char *>(values),
+      sizeof(values));
+  EXPECT_EQ(1u, util.VoxelFilter(quantized, 1.0, out));
+  EXPECT_EQ(2u, util.VoxelFilter(quantized, 0.5, out));
+
+  EXPECT_EQ(0u, util.VoxelFilter(msg, 0.0, out));
+  EXPECT_EQ(0u, out.width());
+  EXPECT_TRUE(out.data().empty());
+}
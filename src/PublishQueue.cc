@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "PublishQueue.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <gz/common/Profiler.hh>
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief State of a PublishQueue shared with the publishing thread.
+class gz::sensors::PublishQueueChannel
+{
+  /// \brief Publisher for the messages of this channel.
+  public: transport::Node::Publisher pub;
+
+  /// \brief Protects the members below.
+  public: std::mutex mutex;
+
+  /// \brief Messages waiting to be published.
+  public: std::deque<std::unique_ptr<google::protobuf::Message>> messages;
+
+  /// \brief Maximum size of messages.
+  public: std::size_t depth{1u};
+
+  /// \brief Serialized size of the waiting messages and of the message
+  /// being published.
+  public: std::size_t bytes{0u};
+
+  /// \brief True while a message is being published.
+  public: bool publishing{false};
+
+  /// \brief Number of messages dropped because the channel was full, or
+  /// counted with PublishQueue::CountDropped.
+  public: uint64_t dropped{0u};
+
+  /// \brief True while the channel is in the dispatcher's ready list.
+  public: bool ready{false};
+
+  /// \brief True once the owning PublishQueue has been destroyed.
+  public: bool closed{false};
+
+  /// \brief Held while the publishing thread publishes a message of this
+  /// channel.
+  public: std::mutex publishMutex;
+};
+
+namespace
+{
+/// \brief Owns the publishing thread shared by all queues.
+class PublishDispatcher
+{
+  /// \brief Get the dispatcher, starting its thread if needed.
+  /// \return The dispatcher.
+  public: static PublishDispatcher &Instance()
+  {
+    static PublishDispatcher dispatcher;
+    return dispatcher;
+  }
+
+  /// \brief Destructor. Stops the publishing thread.
+  public: ~PublishDispatcher()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->stop = true;
+    }
+    this->cv.notify_one();
+    if (this->thread.joinable())
+      this->thread.join();
+  }
+
+  /// \brief Mark a channel as having messages to publish.
+  /// \param[in] _channel The channel.
+  public: void Notify(std::shared_ptr<PublishQueueChannel> _channel)
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->readyChannels.push_back(std::move(_channel));
+    }
+    this->cv.notify_one();
+  }
+
+  /// \brief Constructor
+  private: PublishDispatcher()
+  {
+    this->thread = std::thread(&PublishDispatcher::Run, this);
+  }
+
+  /// \brief Publishing thread loop.
+  private: void Run()
+  {
+    GZ_PROFILE_THREAD_NAME("PublishQueue");
+    while (true)
+    {
+      std::shared_ptr<PublishQueueChannel> channel;
+      {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->cv.wait(lock, [this]
+        {
+          return this->stop || !this->readyChannels.empty();
+        });
+        if (this->stop)
+          return;
+        channel = std::move(this->readyChannels.front());
+        this->readyChannels.pop_front();
+      }
+
+      std::lock_guard<std::mutex> publishLock(channel->publishMutex);
+      while (true)
+      {
+        std::unique_ptr<google::protobuf::Message> msg;
+        {
+          std::lock_guard<std::mutex> lock(channel->mutex);
+          if (channel->closed || channel->messages.empty())
+          {
+            channel->ready = false;
+            break;
+          }
+          msg = std::move(channel->messages.front());
+          channel->messages.pop_front();
+          channel->publishing = true;
+        }
+        {
+          GZ_PROFILE("PublishQueue::Publish");
+          channel->pub.Publish(*msg);
+        }
+        std::lock_guard<std::mutex> lock(channel->mutex);
+        channel->bytes -= std::min(channel->bytes,
+            static_cast<std::size_t>(msg->GetCachedSize()));
+        channel->publishing = false;
+      }
+    }
+  }
+
+  /// \brief Protects the members below.
+  private: std::mutex mutex;
+
+  /// \brief Signals that channels are ready or that the thread must stop.
+  private: std::condition_variable cv;
+
+  /// \brief Channels with messages to publish.
+  private: std::deque<std::shared_ptr<PublishQueueChannel>> readyChannels;
+
+  /// \brief True to stop the thread.
+  private: bool stop{false};
+
+  /// \brief The publishing thread.
+  private: std::thread thread;
+};
+}
+
+//////////////////////////////////////////////////
+PublishQueue::PublishQueue(const transport::Node::Publisher &_pub,
+    std::size_t _depth)
+  : channel(std::make_shared<PublishQueueChannel>())
+{
+  this->channel->pub = _pub;
+  this->channel->depth = std::max<std::size_t>(_depth, 1u);
+}
+
+//////////////////////////////////////////////////
+PublishQueue::~PublishQueue()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->channel->mutex);
+    this->channel->closed = true;
+    this->channel->messages.clear();
+    this->channel->bytes = 0u;
+  }
+  // Wait for a publish in progress
+  std::lock_guard<std::mutex> publishLock(this->channel->publishMutex);
+}
+
+//////////////////////////////////////////////////
+void PublishQueue::Push(std::unique_ptr<google::protobuf::Message> _msg)
+{
+  // Also caches the size used when the message is dequeued
+  const std::size_t size = _msg->ByteSizeLong();
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lock(this->channel->mutex);
+    while (this->channel->messages.size() >= this->channel->depth)
+    {
+      this->channel->bytes -= std::min(this->channel->bytes,
+          static_cast<std::size_t>(
+          this->channel->messages.front()->GetCachedSize()));
+      this->channel->messages.pop_front();
+      ++this->channel->dropped;
+    }
+    this->channel->bytes += size;
+    this->channel->messages.push_back(std::move(_msg));
+    if (!this->channel->ready)
+    {
+      this->channel->ready = true;
+      notify = true;
+    }
+  }
+
+  if (notify)
+    PublishDispatcher::Instance().Notify(this->channel);
+}
+
+//////////////////////////////////////////////////
+void PublishQueue::SetDepth(std::size_t _depth)
+{
+  std::lock_guard<std::mutex> lock(this->channel->mutex);
+  this->channel->depth = std::max<std::size_t>(_depth, 1u);
+}
+
+//////////////////////////////////////////////////
+std::size_t PublishQueue::PendingCount() const
+{
+  std::lock_guard<std::mutex> lock(this->channel->mutex);
+  return this->channel->messages.size() +
+      (this->channel->publishing ? 1u : 0u);
+}
+
+//////////////////////////////////////////////////
+std::size_t PublishQueue::PendingBytes() const
+{
+  std::lock_guard<std::mutex> lock(this->channel->mutex);
+  return this->channel->bytes;
+}
+
+//////////////////////////////////////////////////
+void PublishQueue::CountDropped()
+{
+  std::lock_guard<std::mutex> lock(this->channel->mutex);
+  ++this->channel->dropped;
+}
+
+//////////////////////////////////////////////////
+bool PublishQueue::HasConnections() const
+{
+  return this->channel->pub.HasConnections();
+}
+
+//////////////////////////////////////////////////
+uint64_t PublishQueue::DroppedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->channel->mutex);
+  return this->channel->dropped;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_PUBLISHQUEUE_HH_
+#define GZ_SENSORS_PUBLISHQUEUE_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <google/protobuf/message.h>
+#include <gz/transport/Node.hh>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // Forward declarations
+    class PublishQueueChannel;
+
+    /// \brief Bounded queue of messages that are published from a
+    /// background thread. All queues share a single publishing thread, which
+    /// is started the first time a message is pushed. When a queue is full,
+    /// the oldest message is dropped to make room for the new one.
+    class PublishQueue
+    {
+      /// \brief Constructor
+      /// \param[in] _pub Publisher used for all messages of this queue.
+      /// \param[in] _depth Maximum number of messages waiting to be
+      /// published. Zero is treated as one.
+      public: PublishQueue(const transport::Node::Publisher &_pub,
+                  std::size_t _depth);
+
+      /// \brief Destructor. Messages that haven't been published yet are
+      /// discarded. Blocks until the publishing thread is done with any
+      /// message of this queue it is currently publishing.
+      public: ~PublishQueue();
+
+      /// \brief Queue a message to be published.
+      /// \param[in] _msg Message to publish.
+      public: void Push(std::unique_ptr<google::protobuf::Message> _msg);
+
+      /// \brief Set the maximum number of messages waiting to be published.
+      /// \param[in] _depth Queue depth. Zero is treated as one.
+      public: void SetDepth(std::size_t _depth);
+
+      /// \brief Get the number of messages waiting to be published,
+      /// including the one being published.
+      /// \return Number of pending messages.
+      public: std::size_t PendingCount() const;
+
+      /// \brief Get the serialized size of the messages waiting to be
+      /// published, including the one being published.
+      /// \return Size in bytes.
+      public: std::size_t PendingBytes() const;
+
+      /// \brief Count a message dropped before it was pushed, such as one
+      /// refused because of backpressure.
+      public: void CountDropped();
+
+      /// \brief Check whether the publisher of the queue has subscribers.
+      /// \return True if it has subscribers.
+      public: bool HasConnections() const;
+
+      /// \brief Get the number of messages dropped because the queue was
+      /// full, or counted with CountDropped().
+      /// \return Number of dropped messages.
+      public: uint64_t DroppedCount() const;
+
+      /// \brief Shared state with the publishing thread.
+      private: std::shared_ptr<PublishQueueChannel> channel;
+    };
+    }
+  }
+}
+
+#endif
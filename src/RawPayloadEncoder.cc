@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include "RawPayloadEncoder.hh"
+
+#include <google/protobuf/field_mask.pb.h>
+#include <google/protobuf/util/field_mask_util.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gz/common/Profiler.hh>
+
+#include "gz/sensors/RawPayload.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+const google::protobuf::FieldDescriptor *sensors::RawPayloadField(
+    const google::protobuf::Descriptor *_descriptor)
+{
+  const auto *field = _descriptor->FindFieldByName("data");
+  if (!field || field->is_repeated() ||
+      field->type() != google::protobuf::FieldDescriptor::TYPE_BYTES)
+  {
+    return nullptr;
+  }
+  return field;
+}
+
+//////////////////////////////////////////////////
+bool sensors::EncodeRawPayload(const google::protobuf::Message &_msg,
+    std::string &_out)
+{
+  GZ_PROFILE("EncodeRawPayload");
+  const auto *payloadField = RawPayloadField(_msg.GetDescriptor());
+  if (!payloadField)
+    return false;
+
+  // Copy every set field but the payload
+  const auto *reflection = _msg.GetReflection();
+  std::vector<const google::protobuf::FieldDescriptor *> fields;
+  reflection->ListFields(_msg, &fields);
+  google::protobuf::FieldMask mask;
+  for (const auto *field : fields)
+  {
+    if (field != payloadField)
+      mask.add_paths(field->name());
+  }
+  std::unique_ptr<google::protobuf::Message> rest(_msg.New());
+  google::protobuf::util::FieldMaskUtil::MergeMessageTo(_msg, mask,
+      google::protobuf::util::FieldMaskUtil::MergeOptions(), rest.get());
+
+  std::string scratch;
+  const std::string &payload =
+      reflection->GetStringReference(_msg, payloadField, &scratch);
+
+  RawPayloadHeader header{};
+  header.magic = RawPayloadHeader::kMagic;
+  header.version = RawPayloadHeader::kVersion;
+  header.messageSize = static_cast<uint32_t>(rest->ByteSizeLong());
+  const std::size_t align = RawPayloadHeader::kAlignment;
+  header.payloadOffset =
+      (sizeof(header) + header.messageSize + align - 1u) / align * align;
+  header.payloadSize = payload.size();
+
+  // Reused buffers keep their size, so only the padding is cleared
+  _out.resize(header.payloadOffset + payload.size());
+  std::memcpy(&_out[0], &header, sizeof(header));
+  const std::size_t messageEnd = sizeof(header) + header.messageSize;
+  rest->SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8_t *>(&_out[sizeof(header)]));
+  std::memset(&_out[messageEnd], 0, header.payloadOffset - messageEnd);
+  if (!payload.empty())
+    std::memcpy(&_out[header.payloadOffset], payload.data(), payload.size());
+  return true;
+}
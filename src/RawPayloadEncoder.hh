@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_RAWPAYLOADENCODER_HH_
+#define GZ_SENSORS_RAWPAYLOADENCODER_HH_
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <string>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Get the payload field of a message type, its singular bytes
+    /// field named data, as in msgs::Image and msgs::PointCloudPacked.
+    /// \param[in] _descriptor Message type.
+    /// \return The field, null if the type has no payload.
+    GZ_SENSORS_VISIBLE const google::protobuf::FieldDescriptor *
+        RawPayloadField(const google::protobuf::Descriptor *_descriptor);
+
+    /// \brief Encode a message to the raw payload layout. The payload is
+    /// copied once, the rest of the message is serialized.
+    /// \param[in] _msg Message with a payload field.
+    /// \param[out] _out The encoded message. Its memory is reused.
+    /// \return False if the message has no payload field.
+    /// \sa RawPayloadHeader
+    GZ_SENSORS_VISIBLE bool EncodeRawPayload(
+        const google::protobuf::Message &_msg, std::string &_out);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <gz/msgs/double.pb.h>
+#include <gz/msgs/image.pb.h>
+
+#include <cstdint>
+#include <string>
+
+#include "gz/sensors/RawPayload.hh"
+#include "RawPayloadEncoder.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(RawPayloadEncoder, Image)
+{
+  msgs::Image image;
+  image.set_width(5u);
+  image.set_height(3u);
+  image.set_step(15u);
+  std::string pixels(45u, '\0');
+  for (std::size_t i = 0u; i < pixels.size(); ++i)
+    pixels[i] = static_cast<char>(i);
+  image.set_data(pixels);
+  EXPECT_NE(nullptr, RawPayloadField(image.GetDescriptor()));
+  EXPECT_EQ("gz.sensors.raw.gz.msgs.Image",
+      RawPayloadType(image.GetDescriptor()->full_name()));
+
+  std::string encoded;
+  ASSERT_TRUE(EncodeRawPayload(image, encoded));
+  RawPayloadView view;
+  ASSERT_TRUE(ParseRawPayload(encoded.data(), encoded.size(), view));
+
+  // The payload is aligned and left out of the protobuf message
+  EXPECT_EQ(0u, static_cast<std::size_t>(view.payload - encoded.data()) %
+      RawPayloadHeader::kAlignment);
+  EXPECT_EQ(pixels, std::string(view.payload, view.payloadSize));
+  msgs::Image rest;
+  ASSERT_TRUE(rest.ParseFromArray(view.message,
+      static_cast<int>(view.messageSize)));
+  EXPECT_EQ(5u, rest.width());
+  EXPECT_EQ(3u, rest.height());
+  EXPECT_EQ(15u, rest.step());
+  EXPECT_TRUE(rest.data().empty());
+
+  // Reusing the buffer for a smaller message
+  image.set_data("xy");
+  ASSERT_TRUE(EncodeRawPayload(image, encoded));
+  ASSERT_TRUE(ParseRawPayload(encoded.data(), encoded.size(), view));
+  EXPECT_EQ("xy", std::string(view.payload, view.payloadSize));
+  EXPECT_EQ(encoded.size(),
+      static_cast<std::size_t>(view.payload - encoded.data()) + 2u);
+}
+
+//////////////////////////////////////////////////
+TEST(RawPayloadEncoder, NoPayload)
+{
+  msgs::Double msg;
+  msg.set_data(1.0);
+  EXPECT_EQ(nullptr, RawPayloadField(msg.GetDescriptor()));
+  std::string encoded;
+  EXPECT_FALSE(EncodeRawPayload(msg, encoded));
+}
+
+//////////////////////////////////////////////////
+TEST(RawPayloadEncoder, Malformed)
+{
+  msgs::Image image;
+  image.set_data(std::string(100u, 'x'));
+  std::string encoded;
+  ASSERT_TRUE(EncodeRawPayload(image, encoded));
+
+  RawPayloadView view;
+  EXPECT_FALSE(ParseRawPayload(nullptr, 0u, view));
+  EXPECT_FALSE(ParseRawPayload(encoded.data(), 10u, view));
+  EXPECT_FALSE(ParseRawPayload(encoded.data(), encoded.size() - 1u, view));
+
+  std::string wrongMagic = encoded;
+  wrongMagic[0] = 0;
+  EXPECT_FALSE(ParseRawPayload(wrongMagic.data(), wrongMagic.size(), view));
+}
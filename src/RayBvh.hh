@@ -0,0 +1,586 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_RAYBVH_HH_
+#define GZ_SENSORS_RAYBVH_HH_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Ray in single precision, with the inverse of its direction
+    /// for the box tests.
+    struct BvhRay
+    {
+      /// \brief Constructor
+      /// \param[in] _origin Origin.
+      /// \param[in] _dir Direction, doesn't need to be normalized. Hit
+      /// distances are in multiples of it.
+      BvhRay(const std::array<float, 3> &_origin,
+          const std::array<float, 3> &_dir)
+        : origin(_origin), dir(_dir)
+      {
+        for (int i = 0; i < 3; ++i)
+          this->invDir[i] = 1.0f / this->dir[i];
+      }
+
+      /// \brief Origin.
+      std::array<float, 3> origin;
+
+      /// \brief Direction.
+      std::array<float, 3> dir;
+
+      /// \brief Component-wise inverse of the direction.
+      std::array<float, 3> invDir;
+    };
+
+    /// \brief Bounding volume hierarchy over axis aligned boxes, for casting
+    /// rays against many primitives. It's built top down with the binned
+    /// surface area heuristic, and stored as a flat array of 32 byte nodes
+    /// with the two children of a node next to each other. Traversal visits
+    /// the nearer child first and skips subtrees beyond the closest hit.
+    class RayBvh
+    {
+      /// \brief Node of the hierarchy. A leaf has a positive count of
+      /// primitives, starting at first in build order. An interior node has
+      /// a count of zero and its children at first and first + 1.
+      public: struct Node
+      {
+        /// \brief Lower corner of the box of the node.
+        std::array<float, 3> min;
+
+        /// \brief Upper corner of the box of the node.
+        std::array<float, 3> max;
+
+        /// \brief First primitive or first child.
+        uint32_t first{0u};
+
+        /// \brief Number of primitives, zero for interior nodes.
+        uint32_t count{0u};
+      };
+
+      /// \brief Build the hierarchy.
+      /// \param[in] _boxes Lower then upper corner of the box of each
+      /// primitive, 6 floats per primitive.
+      /// \param[in] _count Number of primitives.
+      public: void Build(const float *_boxes, std::size_t _count)
+      {
+        this->nodes.clear();
+        this->order.resize(_count);
+        for (std::size_t i = 0u; i < _count; ++i)
+          this->order[i] = static_cast<uint32_t>(i);
+        if (_count == 0u)
+          return;
+
+        std::vector<float> centroids(_count * 3u);
+        for (std::size_t i = 0u; i < _count; ++i)
+        {
+          for (int k = 0; k < 3; ++k)
+          {
+            centroids[i * 3u + k] =
+                0.5f * (_boxes[i * 6u + k] + _boxes[i * 6u + 3u + k]);
+          }
+        }
+
+        // A binary tree with at most _count leaves has fewer than
+        // 2 * _count nodes, so nodes are never reallocated below
+        this->nodes.reserve(2u * _count);
+        this->nodes.emplace_back();
+
+        struct Task
+        {
+          uint32_t node;
+          uint32_t begin;
+          uint32_t end;
+          uint32_t depth;
+        };
+        std::vector<Task> tasks{{0u, 0u, static_cast<uint32_t>(_count), 0u}};
+        while (!tasks.empty())
+        {
+          const Task task = tasks.back();
+          tasks.pop_back();
+
+          Node &node = this->nodes[task.node];
+          std::array<float, 3> centroidMin, centroidMax;
+          InitBounds(node.min, node.max);
+          InitBounds(centroidMin, centroidMax);
+          for (uint32_t i = task.begin; i < task.end; ++i)
+          {
+            const float *box = _boxes + this->order[i] * 6u;
+            const float *centroid = centroids.data() + this->order[i] * 3u;
+            for (int k = 0; k < 3; ++k)
+            {
+              node.min[k] = std::min(node.min[k], box[k]);
+              node.max[k] = std::max(node.max[k], box[3 + k]);
+              centroidMin[k] = std::min(centroidMin[k], centroid[k]);
+              centroidMax[k] = std::max(centroidMax[k], centroid[k]);
+            }
+          }
+
+          const uint32_t count = task.end - task.begin;
+          node.first = task.begin;
+          node.count = count;
+          if (count <= kMinLeafSize || task.depth >= kMaxDepth)
+            continue;
+
+          int axis = 0;
+          for (int k = 1; k < 3; ++k)
+          {
+            if (centroidMax[k] - centroidMin[k] >
+                centroidMax[axis] - centroidMin[axis])
+            {
+              axis = k;
+            }
+          }
+          const float extent = centroidMax[axis] - centroidMin[axis];
+
+          uint32_t mid = task.begin;
+          if (extent > 0.0f)
+          {
+            // Bin the centroids along the axis and pick the plane with the
+            // lowest surface area cost
+            std::array<uint32_t, kBinCount> binCounts{};
+            std::array<std::array<float, 3>, kBinCount> binMin, binMax;
+            for (std::size_t b = 0u; b < kBinCount; ++b)
+              InitBounds(binMin[b], binMax[b]);
+            const float scale = kBinCount / extent;
+            auto binOf = [&](uint32_t _prim)
+            {
+              const float c = centroids[_prim * 3u + axis];
+              return std::min<std::size_t>(kBinCount - 1u,
+                  static_cast<std::size_t>((c - centroidMin[axis]) * scale));
+            };
+            for (uint32_t i = task.begin; i < task.end; ++i)
+            {
+              const std::size_t b = binOf(this->order[i]);
+              const float *box = _boxes + this->order[i] * 6u;
+              ++binCounts[b];
+              for (int k = 0; k < 3; ++k)
+              {
+                binMin[b][k] = std::min(binMin[b][k], box[k]);
+                binMax[b][k] = std::max(binMax[b][k], box[3 + k]);
+              }
+            }
+
+            // Cost of the left side of each plane, then sweep from the right
+            std::array<float, kBinCount> leftCost{};
+            std::array<float, 3> accMin, accMax;
+            InitBounds(accMin, accMax);
+            uint32_t accCount = 0u;
+            for (std::size_t b = 0u; b + 1u < kBinCount; ++b)
+            {
+              Grow(accMin, accMax, binMin[b], binMax[b]);
+              accCount += binCounts[b];
+              leftCost[b] = accCount * HalfArea(accMin, accMax);
+            }
+            InitBounds(accMin, accMax);
+            accCount = 0u;
+            float bestCost = std::numeric_limits<float>::infinity();
+            std::size_t bestPlane = 0u;
+            for (std::size_t b = kBinCount - 1u; b > 0u; --b)
+            {
+              Grow(accMin, accMax, binMin[b], binMax[b]);
+              accCount += binCounts[b];
+              const float cost =
+                  leftCost[b - 1u] + accCount * HalfArea(accMin, accMax);
+              if (cost < bestCost)
+              {
+                bestCost = cost;
+                bestPlane = b;
+              }
+            }
+
+            // Keep small nodes as leaves if splitting doesn't pay off
+            const float leafCost = count * HalfArea(node.min, node.max);
+            if (count <= kMaxLeafSize && bestCost >= leafCost)
+              continue;
+
+            mid = static_cast<uint32_t>(std::partition(
+                this->order.begin() + task.begin,
+                this->order.begin() + task.end,
+                [&](uint32_t _prim) {return binOf(_prim) < bestPlane;}) -
+                this->order.begin());
+          }
+
+          // Split identical centroids in the middle
+          if (mid == task.begin || mid == task.end)
+          {
+            if (count <= kMaxLeafSize)
+              continue;
+            mid = task.begin + count / 2u;
+          }
+
+          const uint32_t left = static_cast<uint32_t>(this->nodes.size());
+          this->nodes[task.node].first = left;
+          this->nodes[task.node].count = 0u;
+          this->nodes.emplace_back();
+          this->nodes.emplace_back();
+          tasks.push_back({left, task.begin, mid, task.depth + 1u});
+          tasks.push_back({left + 1u, mid, task.end, task.depth + 1u});
+        }
+      }
+
+      /// \brief Get the primitives in build order. Leaves refer to
+      /// positions in this order.
+      /// \return Primitive index of each position.
+      public: const std::vector<uint32_t> &Order() const
+      {
+        return this->order;
+      }
+
+      /// \brief Get the nodes, the root first.
+      /// \return Nodes, empty if there are no primitives.
+      public: const std::vector<Node> &Nodes() const
+      {
+        return this->nodes;
+      }
+
+      /// \brief Visit the primitives whose box may be hit by a ray closer
+      /// than _tMax, nearest boxes first.
+      /// \param[in] _ray Ray.
+      /// \param[in,out] _tMax Distance of the closest hit, lowered by _leaf.
+      /// \param[in] _leaf Function called with the build order position of
+      /// each primitive and _tMax. It lowers _tMax when it finds a hit.
+      public: template <typename LeafFn>
+              void Traverse(const BvhRay &_ray, float &_tMax,
+                  LeafFn &&_leaf) const
+      {
+        if (this->nodes.empty())
+          return;
+
+        float tNear = 0.0f;
+        if (!HitBox(this->nodes[0], _ray, _tMax, tNear))
+          return;
+
+        std::array<uint32_t, kMaxDepth + 2u> stack;
+        std::array<float, kMaxDepth + 2u> stackNear;
+        std::size_t size = 0u;
+        uint32_t current = 0u;
+        while (true)
+        {
+          const Node &node = this->nodes[current];
+          if (node.count > 0u)
+          {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+              _leaf(i, _tMax);
+          }
+          else
+          {
+            uint32_t a = node.first;
+            uint32_t b = node.first + 1u;
+            float tA = 0.0f;
+            float tB = 0.0f;
+            const bool hitA = HitBox(this->nodes[a], _ray, _tMax, tA);
+            const bool hitB = HitBox(this->nodes[b], _ray, _tMax, tB);
+            if (hitA && hitB)
+            {
+              if (tB < tA)
+              {
+                std::swap(a, b);
+                std::swap(tA, tB);
+              }
+              stack[size] = b;
+              stackNear[size] = tB;
+              ++size;
+              current = a;
+              continue;
+            }
+            if (hitA || hitB)
+            {
+              current = hitA ? a : b;
+              continue;
+            }
+          }
+
+          // Skip the subtrees behind the closest hit
+          do
+          {
+            if (size == 0u)
+              return;
+            --size;
+          }
+          while (stackNear[size] > _tMax);
+          current = stack[size];
+        }
+      }
+
+      /// \brief Intersect a ray with the box of a node.
+      /// \param[in] _node Node.
+      /// \param[in] _ray Ray.
+      /// \param[in] _tMax Farthest distance.
+      /// \param[out] _tNear Distance at which the ray enters the box.
+      /// \return True if the ray hits the box in [0, _tMax].
+      public: static bool HitBox(const Node &_node, const BvhRay &_ray,
+                  float _tMax, float &_tNear)
+      {
+        float tMin = 0.0f;
+        float tMax = _tMax;
+        for (int k = 0; k < 3; ++k)
+        {
+          float t0 = (_node.min[k] - _ray.origin[k]) * _ray.invDir[k];
+          float t1 = (_node.max[k] - _ray.origin[k]) * _ray.invDir[k];
+          if (t0 > t1)
+            std::swap(t0, t1);
+          // NaN from a zero direction on a face keeps the bounds
+          tMin = t0 > tMin ? t0 : tMin;
+          tMax = t1 < tMax ? t1 : tMax;
+        }
+        _tNear = tMin;
+        return tMin <= tMax;
+      }
+
+      /// \brief Set bounds that any box grows.
+      /// \param[out] _min Lower corner.
+      /// \param[out] _max Upper corner.
+      private: static void InitBounds(std::array<float, 3> &_min,
+                   std::array<float, 3> &_max)
+      {
+        _min.fill(std::numeric_limits<float>::infinity());
+        _max.fill(-std::numeric_limits<float>::infinity());
+      }
+
+      /// \brief Grow bounds to contain a box.
+      /// \param[in,out] _min Lower corner of the bounds.
+      /// \param[in,out] _max Upper corner of the bounds.
+      /// \param[in] _boxMin Lower corner of the box.
+      /// \param[in] _boxMax Upper corner of the box.
+      private: static void Grow(std::array<float, 3> &_min,
+                   std::array<float, 3> &_max,
+                   const std::array<float, 3> &_boxMin,
+                   const std::array<float, 3> &_boxMax)
+      {
+        for (int k = 0; k < 3; ++k)
+        {
+          _min[k] = std::min(_min[k], _boxMin[k]);
+          _max[k] = std::max(_max[k], _boxMax[k]);
+        }
+      }
+
+      /// \brief Get half the surface area of a box.
+      /// \param[in] _min Lower corner.
+      /// \param[in] _max Upper corner, zero area if below _min.
+      /// \return Half the area.
+      private: static float HalfArea(const std::array<float, 3> &_min,
+                   const std::array<float, 3> &_max)
+      {
+        const float x = std::max(0.0f, _max[0] - _min[0]);
+        const float y = std::max(0.0f, _max[1] - _min[1]);
+        const float z = std::max(0.0f, _max[2] - _min[2]);
+        return x * y + y * z + z * x;
+      }
+
+      /// \brief Number of bins of the surface area heuristic.
+      private: static constexpr std::size_t kBinCount = 12u;
+
+      /// \brief Nodes with this many primitives or fewer are leaves.
+      private: static constexpr uint32_t kMinLeafSize = 2u;
+
+      /// \brief Nodes with more primitives than this are always split.
+      private: static constexpr uint32_t kMaxLeafSize = 8u;
+
+      /// \brief Depth beyond which nodes are leaves, which bounds the
+      /// traversal stack.
+      private: static constexpr uint32_t kMaxDepth = 62u;
+
+      /// \brief Nodes, the root first.
+      private: std::vector<Node> nodes;
+
+      /// \brief Primitive index of each build order position.
+      private: std::vector<uint32_t> order;
+    };
+
+    /// \brief Triangle mesh with a RayBvh, for finding the closest hit of
+    /// rays. Triangles are stored in build order with an edge form suited to
+    /// the Moller-Trumbore test, and are hit from both sides.
+    class TriangleBvh
+    {
+      /// \brief Build the hierarchy of a mesh.
+      /// \param[in] _vertices x, y and z of each vertex.
+      /// \param[in] _vertexCount Number of vertices.
+      /// \param[in] _indices Three vertex indices per triangle.
+      /// \param[in] _indexCount Number of indices, a multiple of 3.
+      /// \return False if an index is out of range or _indexCount isn't a
+      /// multiple of 3.
+      public: bool Build(const float *_vertices, std::size_t _vertexCount,
+                  const uint32_t *_indices, std::size_t _indexCount)
+      {
+        this->triangles.clear();
+        if (_indexCount % 3u != 0u)
+          return false;
+        for (std::size_t i = 0u; i < _indexCount; ++i)
+        {
+          if (_indices[i] >= _vertexCount)
+            return false;
+        }
+
+        const std::size_t count = _indexCount / 3u;
+        std::vector<float> boxes(count * 6u);
+        for (std::size_t t = 0u; t < count; ++t)
+        {
+          for (int k = 0; k < 3; ++k)
+          {
+            float lo = std::numeric_limits<float>::infinity();
+            float hi = -lo;
+            for (int v = 0; v < 3; ++v)
+            {
+              const float c = _vertices[_indices[t * 3u + v] * 3u + k];
+              lo = std::min(lo, c);
+              hi = std::max(hi, c);
+            }
+            boxes[t * 6u + k] = lo;
+            boxes[t * 6u + 3u + k] = hi;
+          }
+        }
+        this->bvh.Build(boxes.data(), count);
+
+        this->triangles.resize(count);
+        for (std::size_t i = 0u; i < count; ++i)
+        {
+          const uint32_t *tri = _indices + this->bvh.Order()[i] * 3u;
+          const float *v0 = _vertices + tri[0] * 3u;
+          const float *v1 = _vertices + tri[1] * 3u;
+          const float *v2 = _vertices + tri[2] * 3u;
+          Triangle &out = this->triangles[i];
+          for (int k = 0; k < 3; ++k)
+          {
+            out.v0[k] = v0[k];
+            out.e1[k] = v1[k] - v0[k];
+            out.e2[k] = v2[k] - v0[k];
+          }
+        }
+        return true;
+      }
+
+      /// \brief Find the closest hit of a ray.
+      /// \param[in] _ray Ray.
+      /// \param[in,out] _tMax Farthest distance, set to the distance of the
+      /// hit if there's one.
+      /// \return True if a triangle is hit closer than _tMax.
+      public: bool Intersect(const BvhRay &_ray, float &_tMax) const
+      {
+        bool hit = false;
+        this->bvh.Traverse(_ray, _tMax, [&](uint32_t _index, float &_t)
+            {
+              if (this->IntersectTriangle(this->triangles[_index], _ray, _t))
+                hit = true;
+            });
+        return hit;
+      }
+
+      /// \brief Get the box of the mesh.
+      /// \param[out] _min Lower corner.
+      /// \param[out] _max Upper corner.
+      /// \return False if the mesh has no triangles.
+      public: bool Bounds(std::array<float, 3> &_min,
+                  std::array<float, 3> &_max) const
+      {
+        if (this->bvh.Nodes().empty())
+          return false;
+        _min = this->bvh.Nodes()[0].min;
+        _max = this->bvh.Nodes()[0].max;
+        return true;
+      }
+
+      /// \brief Get the number of triangles.
+      /// \return Number of triangles.
+      public: std::size_t TriangleCount() const
+      {
+        return this->triangles.size();
+      }
+
+      /// \brief Triangle as a vertex and two edges.
+      private: struct Triangle
+      {
+        /// \brief First vertex.
+        std::array<float, 3> v0;
+
+        /// \brief Second vertex minus the first.
+        std::array<float, 3> e1;
+
+        /// \brief Third vertex minus the first.
+        std::array<float, 3> e2;
+      };
+
+      /// \brief Moller-Trumbore ray triangle test.
+      /// \param[in] _tri Triangle.
+      /// \param[in] _ray Ray.
+      /// \param[in,out] _tMax Farthest distance, set to the distance of the
+      /// hit if there's one.
+      /// \return True if the triangle is hit in [0, _tMax).
+      private: static bool IntersectTriangle(const Triangle &_tri,
+                   const BvhRay &_ray, float &_tMax)
+      {
+        const std::array<float, 3> &d = _ray.dir;
+        const std::array<float, 3> p = {
+            d[1] * _tri.e2[2] - d[2] * _tri.e2[1],
+            d[2] * _tri.e2[0] - d[0] * _tri.e2[2],
+            d[0] * _tri.e2[1] - d[1] * _tri.e2[0]};
+        const float det =
+            _tri.e1[0] * p[0] + _tri.e1[1] * p[1] + _tri.e1[2] * p[2];
+        if (std::fabs(det) < 1e-12f)
+          return false;
+        const float invDet = 1.0f / det;
+
+        const std::array<float, 3> s = {
+            _ray.origin[0] - _tri.v0[0],
+            _ray.origin[1] - _tri.v0[1],
+            _ray.origin[2] - _tri.v0[2]};
+        const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+        if (u < 0.0f || u > 1.0f)
+          return false;
+
+        const std::array<float, 3> q = {
+            s[1] * _tri.e1[2] - s[2] * _tri.e1[1],
+            s[2] * _tri.e1[0] - s[0] * _tri.e1[2],
+            s[0] * _tri.e1[1] - s[1] * _tri.e1[0]};
+        const float v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+          return false;
+
+        const float t =
+            (_tri.e2[0] * q[0] + _tri.e2[1] * q[1] + _tri.e2[2] * q[2]) *
+            invDet;
+        if (t < 0.0f || t >= _tMax)
+          return false;
+        _tMax = t;
+        return true;
+      }
+
+      /// \brief Hierarchy over the triangles.
+      private: RayBvh bvh;
+
+      /// \brief Triangles in build order.
+      private: std::vector<Triangle> triangles;
+    };
+    }
+  }
+}
+
+#endif
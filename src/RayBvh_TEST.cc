@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "RayBvh.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(RayBvh, Empty)
+{
+  TriangleBvh mesh;
+  EXPECT_TRUE(mesh.Build(nullptr, 0u, nullptr, 0u));
+  EXPECT_EQ(0u, mesh.TriangleCount());
+  std::array<float, 3> lo, hi;
+  EXPECT_FALSE(mesh.Bounds(lo, hi));
+
+  float t = 10.0f;
+  EXPECT_FALSE(mesh.Intersect(BvhRay({0, 0, 0}, {1, 0, 0}), t));
+  EXPECT_FLOAT_EQ(10.0f, t);
+
+  // Bad indices
+  const float vertices[] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+  const uint32_t outOfRange[] = {0, 1, 3};
+  EXPECT_FALSE(mesh.Build(vertices, 3u, outOfRange, 3u));
+  const uint32_t partial[] = {0, 1};
+  EXPECT_FALSE(mesh.Build(vertices, 3u, partial, 2u));
+}
+
+/////////////////////////////////////////////////
+TEST(RayBvh, Quad)
+{
+  // Unit quad in the plane x = 2
+  const float vertices[] = {2, -1, -1, 2, 1, -1, 2, 1, 1, 2, -1, 1};
+  const uint32_t indices[] = {0, 1, 2, 0, 2, 3};
+  TriangleBvh mesh;
+  ASSERT_TRUE(mesh.Build(vertices, 4u, indices, 6u));
+  EXPECT_EQ(2u, mesh.TriangleCount());
+
+  std::array<float, 3> lo, hi;
+  ASSERT_TRUE(mesh.Bounds(lo, hi));
+  EXPECT_FLOAT_EQ(2.0f, lo[0]);
+  EXPECT_FLOAT_EQ(-1.0f, lo[1]);
+  EXPECT_FLOAT_EQ(1.0f, hi[2]);
+
+  float t = 100.0f;
+  EXPECT_TRUE(mesh.Intersect(BvhRay({0, 0, 0}, {1, 0, 0}), t));
+  EXPECT_FLOAT_EQ(2.0f, t);
+
+  // Hit from behind, at a slant
+  t = 100.0f;
+  EXPECT_TRUE(mesh.Intersect(BvhRay({4, 0, 0}, {-1, 0.25f, 0}), t));
+  EXPECT_FLOAT_EQ(2.0f, t);
+
+  // Missed, pointing away and too short
+  t = 100.0f;
+  EXPECT_FALSE(mesh.Intersect(BvhRay({0, 0, 0}, {-1, 0, 0}), t));
+  EXPECT_FALSE(mesh.Intersect(BvhRay({0, 2, 0}, {1, 0, 0}), t));
+  t = 1.5f;
+  EXPECT_FALSE(mesh.Intersect(BvhRay({0, 0, 0}, {1, 0, 0}), t));
+}
+
+/////////////////////////////////////////////////
+TEST(RayBvh, MatchesBruteForce)
+{
+  std::mt19937 gen(7u);
+  std::uniform_real_distribution<float> pos(-10.0f, 10.0f);
+  std::uniform_real_distribution<float> offset(-0.5f, 0.5f);
+
+  // Small random triangles, so that the hierarchy has many levels
+  const std::size_t count = 2000u;
+  std::vector<float> vertices;
+  std::vector<uint32_t> indices;
+  for (std::size_t i = 0u; i < count; ++i)
+  {
+    const float c[3] = {pos(gen), pos(gen), pos(gen)};
+    for (int v = 0; v < 3; ++v)
+    {
+      for (int k = 0; k < 3; ++k)
+        vertices.push_back(c[k] + offset(gen));
+      indices.push_back(static_cast<uint32_t>(indices.size()));
+    }
+  }
+
+  TriangleBvh mesh;
+  ASSERT_TRUE(mesh.Build(vertices.data(), vertices.size() / 3u,
+      indices.data(), indices.size()));
+  EXPECT_EQ(count, mesh.TriangleCount());
+
+  // Each triangle alone, the closest of them is the expected hit
+  std::vector<TriangleBvh> single(count);
+  for (std::size_t i = 0u; i < count; ++i)
+  {
+    const uint32_t tri[3] = {0u, 1u, 2u};
+    ASSERT_TRUE(single[i].Build(vertices.data() + i * 9u, 3u, tri, 3u));
+  }
+
+  std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+  int hits = 0;
+  for (int r = 0; r < 300; ++r)
+  {
+    const BvhRay ray({0, 0, 0}, {dir(gen), dir(gen), dir(gen)});
+    float expected = 50.0f;
+    bool expectedHit = false;
+    for (const auto &tri : single)
+      expectedHit = tri.Intersect(ray, expected) || expectedHit;
+
+    float t = 50.0f;
+    EXPECT_EQ(expectedHit, mesh.Intersect(ray, t));
+    EXPECT_FLOAT_EQ(expected, t);
+    hits += expectedHit ? 1 : 0;
+  }
+  EXPECT_LT(0, hits);
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/msgs/int32.pb.h>
+#include <gz/msgs/pose_v.pb.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+#include <gz/msgs/Utility.hh>
+#include <gz/transport/Node.hh>
+
+#include "gz/sensors/Manager.hh"
+#include "gz/sensors/RemoteSensors.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Private data class for RemoteSensorCoordinator
+class gz::sensors::RemoteSensorCoordinatorPrivate
+{
+  /// \brief Callback for the steps done by the workers.
+  /// \param[in] _msg Shard and time of the step.
+  public: void OnDone(const msgs::Int32 &_msg);
+
+  /// \brief Manager with the sensors of the world.
+  public: Manager *manager{nullptr};
+
+  /// \brief Number of shards.
+  public: unsigned int shardCount{1u};
+
+  /// \brief Node for communication.
+  public: transport::Node node;
+
+  /// \brief Publisher of the steps.
+  public: transport::Node::Publisher stepPub;
+
+  /// \brief Step message, reused across steps.
+  public: msgs::Pose_V stepMsg;
+
+  /// \brief Protects stepTime and done.
+  public: std::mutex mutex;
+
+  /// \brief Notifies that a worker finished the step.
+  public: std::condition_variable doneCv;
+
+  /// \brief Time of the current step.
+  public: msgs::Time stepTime;
+
+  /// \brief True for each shard done with the current step.
+  public: std::vector<bool> done;
+};
+
+/// \brief Private data class for RemoteSensorWorker
+class gz::sensors::RemoteSensorWorkerPrivate
+{
+  /// \brief Callback for the steps of the coordinator.
+  /// \param[in] _msg Time of the step and poses of the remote sensors.
+  public: void OnStep(const msgs::Pose_V &_msg);
+
+  /// \brief Manager with the sensors of the world.
+  public: Manager *manager{nullptr};
+
+  /// \brief Shard run by the worker.
+  public: unsigned int shard{0u};
+
+  /// \brief Node for communication.
+  public: transport::Node node;
+
+  /// \brief Topic of the steps.
+  public: std::string stepTopic;
+
+  /// \brief Publisher of the steps done.
+  public: transport::Node::Publisher donePub;
+
+  /// \brief Protects the members below, held while a step runs.
+  public: mutable std::mutex mutex;
+
+  /// \brief Id of each sensor, by name.
+  public: std::unordered_map<std::string, SensorId> ids;
+
+  /// \brief Number of steps run.
+  public: uint64_t stepCount{0u};
+
+  /// \brief Time of the last step run.
+  public: std::chrono::steady_clock::duration lastStepTime{0};
+};
+
+//////////////////////////////////////////////////
+void RemoteSensorCoordinatorPrivate::OnDone(const msgs::Int32 &_msg)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    const auto &stamp = _msg.header().stamp();
+    if (_msg.data() < 0 || static_cast<std::size_t>(_msg.data()) >=
+        this->done.size() || stamp.sec() != this->stepTime.sec() ||
+        stamp.nsec() != this->stepTime.nsec())
+    {
+      return;
+    }
+    this->done[_msg.data()] = true;
+  }
+  this->doneCv.notify_all();
+}
+
+//////////////////////////////////////////////////
+RemoteSensorCoordinator::RemoteSensorCoordinator(Manager &_manager,
+    const std::string &_topic, unsigned int _shardCount)
+  : dataPtr(new RemoteSensorCoordinatorPrivate)
+{
+  this->dataPtr->manager = &_manager;
+  this->dataPtr->shardCount = std::max(_shardCount, 1u);
+  _manager.SetShard(0u, this->dataPtr->shardCount);
+
+  this->dataPtr->stepPub =
+      this->dataPtr->node.Advertise<msgs::Pose_V>(_topic + "/step");
+  if (!this->dataPtr->stepPub)
+  {
+    gzerr << "Unable to advertise on topic[" << _topic << "/step]."
+          << std::endl;
+  }
+  if (!this->dataPtr->node.Subscribe(_topic + "/done",
+      &RemoteSensorCoordinatorPrivate::OnDone, this->dataPtr.get()))
+  {
+    gzerr << "Unable to subscribe to topic[" << _topic << "/done]."
+          << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+RemoteSensorCoordinator::~RemoteSensorCoordinator() = default;
+
+//////////////////////////////////////////////////
+bool RemoteSensorCoordinator::Step(
+    const std::chrono::steady_clock::duration &_time,
+    const std::chrono::steady_clock::duration &_timeout)
+{
+  GZ_PROFILE("RemoteSensorCoordinator::Step");
+  auto &msg = this->dataPtr->stepMsg;
+  msg.Clear();
+  *msg.mutable_header()->mutable_stamp() = msgs::Convert(_time);
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->stepTime = msg.header().stamp();
+    this->dataPtr->done.assign(this->dataPtr->shardCount, false);
+    this->dataPtr->done[0] = true;
+  }
+
+  // Only the poses of the sensors run by the workers are sent
+  auto &manager = *this->dataPtr->manager;
+  for (const auto id : manager.SensorIds())
+  {
+    auto *sensor = manager.Sensor(id);
+    const std::string name = sensor->Name();
+    if (Manager::ShardOf(name, this->dataPtr->shardCount) == 0u)
+      continue;
+    auto *pose = msg.add_pose();
+    msgs::Set(pose, sensor->Pose());
+    pose->set_name(name);
+  }
+  if (this->dataPtr->shardCount > 1u)
+    this->dataPtr->stepPub.Publish(msg);
+
+  // Run the local shard while the workers run theirs
+  manager.RunOnce(_time);
+
+  std::unique_lock<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->doneCv.wait_for(lock, _timeout, [this]
+  {
+    return std::all_of(this->dataPtr->done.begin(),
+        this->dataPtr->done.end(), [](bool _done) { return _done; });
+  });
+}
+
+//////////////////////////////////////////////////
+unsigned int RemoteSensorCoordinator::ShardCount() const
+{
+  return this->dataPtr->shardCount;
+}
+
+//////////////////////////////////////////////////
+void RemoteSensorWorkerPrivate::OnStep(const msgs::Pose_V &_msg)
+{
+  GZ_PROFILE("RemoteSensorWorker::Step");
+  std::lock_guard<std::mutex> lock(this->mutex);
+  for (const auto &pose : _msg.pose())
+  {
+    auto it = this->ids.find(pose.name());
+    if (it == this->ids.end())
+    {
+      // Sensors may have been added since the last step
+      this->ids.clear();
+      for (const auto id : this->manager->SensorIds())
+        this->ids[this->manager->Sensor(id)->Name()] = id;
+      it = this->ids.find(pose.name());
+      if (it == this->ids.end())
+        continue;
+    }
+    auto *sensor = this->manager->Sensor(it->second);
+    if (sensor)
+      sensor->SetPose(msgs::Convert(pose));
+  }
+
+  const auto time = msgs::Convert(_msg.header().stamp());
+  this->manager->RunOnce(time);
+  ++this->stepCount;
+  this->lastStepTime = time;
+
+  msgs::Int32 done;
+  *done.mutable_header()->mutable_stamp() = _msg.header().stamp();
+  done.set_data(static_cast<int32_t>(this->shard));
+  this->donePub.Publish(done);
+}
+
+//////////////////////////////////////////////////
+RemoteSensorWorker::RemoteSensorWorker(Manager &_manager,
+    const std::string &_topic, unsigned int _shard,
+    unsigned int _shardCount)
+  : dataPtr(new RemoteSensorWorkerPrivate)
+{
+  this->dataPtr->manager = &_manager;
+  this->dataPtr->shard = _shard;
+  this->dataPtr->stepTopic = _topic + "/step";
+  _manager.SetShard(_shard, _shardCount);
+
+  this->dataPtr->donePub =
+      this->dataPtr->node.Advertise<msgs::Int32>(_topic + "/done");
+  if (!this->dataPtr->donePub)
+  {
+    gzerr << "Unable to advertise on topic[" << _topic << "/done]."
+          << std::endl;
+  }
+  if (!this->dataPtr->node.Subscribe(this->dataPtr->stepTopic,
+      &RemoteSensorWorkerPrivate::OnStep, this->dataPtr.get()))
+  {
+    gzerr << "Unable to subscribe to topic[" << this->dataPtr->stepTopic
+          << "]." << std::endl;
+  }
+}
+
+//////////////////////////////////////////////////
+RemoteSensorWorker::~RemoteSensorWorker()
+{
+  // Wait for a step in progress
+  this->dataPtr->node.Unsubscribe(this->dataPtr->stepTopic);
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+}
+
+//////////////////////////////////////////////////
+uint64_t RemoteSensorWorker::StepCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->stepCount;
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration RemoteSensorWorker::LastStepTime() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->lastStepTime;
+}
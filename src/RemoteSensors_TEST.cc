@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/math/Pose3.hh>
+
+#include "gz/sensors/Manager.hh"
+#include "gz/sensors/RemoteSensors.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+class CountingSensor : public Sensor
+{
+  public: virtual bool Update(
+    const std::chrono::steady_clock::duration &) override
+  {
+    this->updateCount++;
+    return true;
+  }
+
+  public: unsigned int updateCount{0};
+};
+
+//////////////////////////////////////////////////
+/// \brief Create the same sensors in a manager.
+/// \param[in] _mgr Manager to create the sensors in.
+/// \return The sensors.
+std::vector<CountingSensor *> CreateSensors(Manager &_mgr)
+{
+  std::vector<CountingSensor *> sensors;
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetUpdateRate(1.0);
+  for (int i = 0; i < 8; ++i)
+  {
+    sdfSensor.SetName("sensor" + std::to_string(i));
+    sdfSensor.SetTopic("/remote/sensor" + std::to_string(i));
+    auto *sensor = _mgr.CreateSensor<CountingSensor>(sdfSensor);
+    if (sensor)
+      sensors.push_back(sensor);
+  }
+  return sensors;
+}
+
+//////////////////////////////////////////////////
+TEST(RemoteSensors_TEST, Step)
+{
+  common::Console::SetVerbosity(4);
+
+  Manager coordinatorMgr;
+  auto coordinatorSensors = CreateSensors(coordinatorMgr);
+  ASSERT_EQ(8u, coordinatorSensors.size());
+  Manager workerMgr;
+  auto workerSensors = CreateSensors(workerMgr);
+  ASSERT_EQ(8u, workerSensors.size());
+
+  RemoteSensorCoordinator coordinator(coordinatorMgr, "/remote_test", 2u);
+  EXPECT_EQ(2u, coordinator.ShardCount());
+  EXPECT_EQ(0u, coordinatorMgr.ShardIndex());
+  RemoteSensorWorker worker(workerMgr, "/remote_test", 1u, 2u);
+  EXPECT_EQ(1u, workerMgr.ShardIndex());
+  EXPECT_EQ(0u, worker.StepCount());
+
+  for (std::size_t i = 0; i < coordinatorSensors.size(); ++i)
+  {
+    coordinatorSensors[i]->SetPose(
+        math::Pose3d(static_cast<double>(i), 0, 0, 0, 0, 0));
+  }
+
+  // Repeat the step until the worker is discovered, sensors aren't due
+  // again for the same time
+  bool done = false;
+  for (int i = 0; i < 50 && !done; ++i)
+  {
+    done = coordinator.Step(std::chrono::seconds(1),
+        std::chrono::milliseconds(100));
+  }
+  ASSERT_TRUE(done);
+  EXPECT_LE(1u, worker.StepCount());
+  EXPECT_EQ(std::chrono::seconds(1), worker.LastStepTime());
+
+  // Every sensor ran once, in one of the processes
+  for (std::size_t i = 0; i < coordinatorSensors.size(); ++i)
+  {
+    const bool remote =
+        Manager::ShardOf(coordinatorSensors[i]->Name(), 2u) == 1u;
+    EXPECT_EQ(remote ? 0u : 1u, coordinatorSensors[i]->updateCount);
+    EXPECT_EQ(remote ? 1u : 0u, workerSensors[i]->updateCount);
+    if (remote)
+    {
+      EXPECT_EQ(coordinatorSensors[i]->Pose(), workerSensors[i]->Pose());
+    }
+  }
+
+  // Following steps wait for the worker
+  EXPECT_TRUE(coordinator.Step(std::chrono::seconds(2),
+      std::chrono::seconds(5)));
+  EXPECT_EQ(std::chrono::seconds(2), worker.LastStepTime());
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include <gz/common/Profiler.hh>
+
+#include "gz/sensors/RenderTaskQueue.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Private data for RenderTaskQueue
+class gz::sensors::RenderTaskQueuePrivate
+{
+  /// \brief Protects the tasks.
+  public: mutable std::mutex mutex;
+
+  /// \brief Notifies RunNext that a task was queued.
+  public: std::condition_variable taskCv;
+
+  /// \brief Queued tasks, oldest first.
+  public: std::deque<RenderTaskQueue::Task> tasks;
+};
+
+//////////////////////////////////////////////////
+RenderTaskQueue::RenderTaskQueue()
+  : dataPtr(new RenderTaskQueuePrivate)
+{
+}
+
+//////////////////////////////////////////////////
+RenderTaskQueue::~RenderTaskQueue() = default;
+
+//////////////////////////////////////////////////
+void RenderTaskQueue::Push(Task _task)
+{
+  if (!_task)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->tasks.push_back(std::move(_task));
+  }
+  this->dataPtr->taskCv.notify_one();
+}
+
+//////////////////////////////////////////////////
+std::size_t RenderTaskQueue::RunPending()
+{
+  GZ_PROFILE("RenderTaskQueue::RunPending");
+  std::deque<Task> tasks;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    std::swap(tasks, this->dataPtr->tasks);
+  }
+
+  for (auto &task : tasks)
+    task();
+  return tasks.size();
+}
+
+//////////////////////////////////////////////////
+bool RenderTaskQueue::RunNext(
+    const std::chrono::steady_clock::duration &_timeout)
+{
+  Task task;
+  {
+    std::unique_lock<std::mutex> lock(this->dataPtr->mutex);
+    if (!this->dataPtr->taskCv.wait_for(lock, _timeout,
+        [this]{ return !this->dataPtr->tasks.empty(); }))
+    {
+      return false;
+    }
+    task = std::move(this->dataPtr->tasks.front());
+    this->dataPtr->tasks.pop_front();
+  }
+
+  GZ_PROFILE("RenderTaskQueue::RunNext");
+  task();
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t RenderTaskQueue::Size() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->tasks.size();
+}
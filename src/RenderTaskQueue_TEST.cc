@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gz/sensors/RenderTaskQueue.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(RenderTaskQueue_TEST, RunPending)
+{
+  RenderTaskQueue queue;
+  EXPECT_EQ(0u, queue.Size());
+  EXPECT_EQ(0u, queue.RunPending());
+
+  std::vector<int> order;
+  queue.Push([&]
+  {
+    order.push_back(0);
+    // Runs on the next call
+    queue.Push([&] { order.push_back(2); });
+  });
+  queue.Push([&] { order.push_back(1); });
+  EXPECT_EQ(2u, queue.Size());
+
+  EXPECT_EQ(2u, queue.RunPending());
+  EXPECT_EQ((std::vector<int>{0, 1}), order);
+  EXPECT_EQ(1u, queue.Size());
+
+  EXPECT_EQ(1u, queue.RunPending());
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), order);
+  EXPECT_EQ(0u, queue.Size());
+}
+
+//////////////////////////////////////////////////
+TEST(RenderTaskQueue_TEST, RunNext)
+{
+  RenderTaskQueue queue;
+  EXPECT_FALSE(queue.RunNext(std::chrono::milliseconds(1)));
+
+  int count = 0;
+  queue.Push([&] { ++count; });
+  queue.Push([&] { ++count; });
+  EXPECT_TRUE(queue.RunNext(std::chrono::milliseconds(1)));
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(1u, queue.Size());
+}
+
+//////////////////////////////////////////////////
+TEST(RenderTaskQueue_TEST, Threads)
+{
+  RenderTaskQueue queue;
+  std::atomic<int> count{0};
+  std::atomic<bool> done{false};
+
+  std::thread renderThread([&]
+  {
+    while (!done || queue.Size() > 0)
+      queue.RunNext(std::chrono::milliseconds(10));
+  });
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 4; ++i)
+  {
+    producers.emplace_back([&]
+    {
+      for (int j = 0; j < 100; ++j)
+        queue.Push([&] { ++count; });
+    });
+  }
+  for (auto &producer : producers)
+    producer.join();
+  done = true;
+  renderThread.join();
+
+  EXPECT_EQ(400, count);
+}
@@ -15,6 +15,10 @@
  *
 */
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include "gz/sensors/RenderingEvents.hh"
 
 using namespace gz::sensors;
@@ -22,10 +26,125 @@ using namespace gz::sensors;
 gz::common::EventT<void(const gz::rendering::ScenePtr &)>
 RenderingEvents::sceneEvent;
 
+namespace
+{
+/// \brief Protects connections to sceneEvent. Sensors may be loaded in
+/// parallel, see SensorFactory::CreateSensors
+std::mutex connectMutex;
+
+/// \brief Keeps track of the scene changes signaled by sceneEvent.
+class SceneTracker
+{
+  /// \brief Constructor, connects to sceneEvent.
+  public: SceneTracker()
+  {
+    std::lock_guard<std::mutex> lock(connectMutex);
+    this->connection = RenderingEvents::sceneEvent.Connect(
+        [this](const gz::rendering::ScenePtr &_scene)
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->scene = _scene;
+          ++this->generation;
+          ++this->contentGeneration;
+        });
+  }
+
+  /// \brief Protects scene and flushedGeneration.
+  public: std::mutex mutex;
+
+  /// \brief Protects coalescedEvent.
+  public: std::mutex eventMutex;
+
+  /// \brief Latest scene, not owned so the tracker doesn't keep it alive.
+  public: std::weak_ptr<gz::rendering::Scene> scene;
+
+  /// \brief Number of scene changes.
+  public: std::atomic<uint64_t> generation{0};
+
+  /// \brief Number of scene changes and content changes.
+  public: std::atomic<uint64_t> contentGeneration{0};
+
+  /// \brief Generation at the time of the last flush.
+  public: uint64_t flushedGeneration{0};
+
+  /// \brief Event signaled by RenderingEvents::FlushSceneChanges.
+  public: gz::common::EventT<void(const gz::rendering::ScenePtr &)>
+              coalescedEvent;
+
+  /// \brief Connection to sceneEvent.
+  public: gz::common::ConnectionPtr connection;
+};
+
+/// \brief Get the scene tracker, connected on first use.
+/// \return The tracker.
+SceneTracker &Tracker()
+{
+  static SceneTracker tracker;
+  return tracker;
+}
+}
+
 /////////////////////////////////////////////////
 gz::common::ConnectionPtr RenderingEvents::ConnectSceneChangeCallback(
     std::function<void(const gz::rendering::ScenePtr &)> _callback)
 {
+  // Start counting scene changes before anyone needs them
+  Tracker();
+  std::lock_guard<std::mutex> lock(connectMutex);
   return sceneEvent.Connect(_callback);
 }
 
+/////////////////////////////////////////////////
+gz::common::ConnectionPtr
+RenderingEvents::ConnectCoalescedSceneChangeCallback(
+    std::function<void(const gz::rendering::ScenePtr &)> _callback)
+{
+  auto &tracker = Tracker();
+  std::lock_guard<std::mutex> lock(tracker.eventMutex);
+  return tracker.coalescedEvent.Connect(_callback);
+}
+
+/////////////////////////////////////////////////
+bool RenderingEvents::FlushSceneChanges()
+{
+  auto &tracker = Tracker();
+  gz::rendering::ScenePtr scene;
+  {
+    std::lock_guard<std::mutex> lock(tracker.mutex);
+    const uint64_t generation = tracker.generation;
+    if (generation == tracker.flushedGeneration)
+      return false;
+    tracker.flushedGeneration = generation;
+    scene = tracker.scene.lock();
+  }
+
+  std::lock_guard<std::mutex> lock(tracker.eventMutex);
+  tracker.coalescedEvent(scene);
+  return true;
+}
+
+/////////////////////////////////////////////////
+uint64_t RenderingEvents::SceneGeneration()
+{
+  return Tracker().generation;
+}
+
+/////////////////////////////////////////////////
+void RenderingEvents::NotifySceneContentChanged()
+{
+  ++Tracker().contentGeneration;
+}
+
+/////////////////////////////////////////////////
+uint64_t RenderingEvents::SceneContentGeneration()
+{
+  return Tracker().contentGeneration;
+}
+
+/////////////////////////////////////////////////
+gz::rendering::ScenePtr RenderingEvents::LatestScene()
+{
+  auto &tracker = Tracker();
+  std::lock_guard<std::mutex> lock(tracker.mutex);
+  return tracker.scene.lock();
+}
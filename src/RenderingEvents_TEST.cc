@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include "gz/sensors/RenderingEvents.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(RenderingEvents_TEST, CoalescedSceneChange)
+{
+  int calls = 0;
+  int coalescedCalls = 0;
+  auto connection = RenderingEvents::ConnectSceneChangeCallback(
+      [&](const rendering::ScenePtr &) { ++calls; });
+  auto coalescedConnection =
+      RenderingEvents::ConnectCoalescedSceneChangeCallback(
+      [&](const rendering::ScenePtr &_scene)
+      {
+        EXPECT_EQ(nullptr, _scene);
+        ++coalescedCalls;
+      });
+  EXPECT_FALSE(RenderingEvents::FlushSceneChanges());
+
+  // Several scene changes within a step make a single coalesced call
+  const uint64_t generation = RenderingEvents::SceneGeneration();
+  for (int i = 0; i < 3; ++i)
+    RenderingEvents::sceneEvent(nullptr);
+  EXPECT_EQ(generation + 3, RenderingEvents::SceneGeneration());
+  EXPECT_EQ(nullptr, RenderingEvents::LatestScene());
+  EXPECT_EQ(3, calls);
+  EXPECT_EQ(0, coalescedCalls);
+
+  EXPECT_TRUE(RenderingEvents::FlushSceneChanges());
+  EXPECT_EQ(1, coalescedCalls);
+  EXPECT_FALSE(RenderingEvents::FlushSceneChanges());
+  EXPECT_EQ(1, coalescedCalls);
+
+  // Disconnected
+  coalescedConnection.reset();
+  RenderingEvents::sceneEvent(nullptr);
+  EXPECT_TRUE(RenderingEvents::FlushSceneChanges());
+  EXPECT_EQ(1, coalescedCalls);
+  EXPECT_EQ(4, calls);
+}
+
+/////////////////////////////////////////////////
+TEST(RenderingEvents, SceneContentGeneration)
+{
+  const uint64_t generation = RenderingEvents::SceneGeneration();
+  const uint64_t content = RenderingEvents::SceneContentGeneration();
+  RenderingEvents::NotifySceneContentChanged();
+  RenderingEvents::NotifySceneContentChanged();
+  EXPECT_EQ(content + 2, RenderingEvents::SceneContentGeneration());
+  EXPECT_EQ(generation, RenderingEvents::SceneGeneration());
+
+  // A new scene changes the content too
+  RenderingEvents::sceneEvent(nullptr);
+  EXPECT_EQ(content + 3, RenderingEvents::SceneContentGeneration());
+  EXPECT_EQ(generation + 1, RenderingEvents::SceneGeneration());
+}
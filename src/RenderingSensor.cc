@@ -15,21 +15,138 @@
  *
 */
 
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gz/common/Console.hh>
 #include <gz/common/Profiler.hh>
 
+#include <gz/math/Pose3.hh>
 #include <gz/rendering/Camera.hh>
 
+#include "gz/sensors/FrameRecorder.hh"
+#include "gz/sensors/RenderingEvents.hh"
 #include "gz/sensors/RenderingSensor.hh"
 
+#include "SharedMemoryImageWriter.hh"
+#include "TraceRecorder.hh"
+
+namespace
+{
+/// \brief Shared memory output of an image stream.
+struct SharedMemoryStream
+{
+  /// \brief Writer of the stream's segment.
+  std::unique_ptr<gz::sensors::SharedMemoryImageWriter> writer;
+
+  /// \brief Publisher of the descriptors.
+  gz::transport::Node::Publisher pub;
+
+  /// \brief Descriptor message, reused across frames.
+  gz::msgs::Image descriptor;
+};
+}
+
 /// \brief Private data class for RenderingSensor
 class gz::sensors::RenderingSensorPrivate
 {
   /// \brief Pointer to the scene
   public: gz::rendering::ScenePtr scene;
 
+  /// \brief Scene generation last seen by ApplySceneChanges.
+  public: uint64_t sceneGeneration{RenderingEvents::SceneGeneration()};
+
   /// \brief Manually update the rendering scene graph
   public: bool manualSceneUpdate = false;
 
+  /// \brief True to read frames back one update late.
+  public: bool asyncReadback = false;
+
+  /// \brief True to use frames in the rendering cameras' buffers.
+  public: bool zeroCopyFrames = false;
+
+  /// \brief Whether unchanged frames are reused.
+  public: bool frameReuse = false;
+
+  /// \brief True if framePose and frameGeneration describe the last
+  /// rendered frame.
+  public: bool frameValid = false;
+
+  /// \brief Pose of the sensor for the last rendered frame.
+  public: math::Pose3d framePose;
+
+  /// \brief Scene content generation of the last rendered frame.
+  public: uint64_t frameGeneration{0};
+
+  /// \brief Number of reused frames.
+  public: uint64_t reusedFrames{0};
+
+  /// \brief Check whether the last rendered frame is still valid.
+  /// \param[in] _pose Current pose of the sensor.
+  /// \return True if frame reuse is on and nothing changed.
+  public: bool FrameUnchanged(const math::Pose3d &_pose) const
+  {
+    return this->frameReuse && this->frameValid && !this->asyncReadback &&
+        this->frameGeneration == RenderingEvents::SceneContentGeneration() &&
+        this->framePose == _pose;
+  }
+
+  /// \brief True if a frame has been rendered and not read back yet.
+  public: bool pendingFrame = false;
+
+  /// \brief Time of the pending frame.
+  public: std::chrono::steady_clock::duration pendingFrameTime{0};
+
+  /// \brief True if the cameras were rendered by RenderBatch and not read
+  /// back yet.
+  public: bool batchRendered = false;
+
+  /// \brief Time RenderBatch rendered the cameras for.
+  public: std::chrono::steady_clock::duration batchFrameTime{0};
+
+  /// \brief True to write image frames into shared memory.
+  public: bool sharedMemoryOutput = false;
+
+  /// \brief Number of slots of the shared memory segments.
+  public: unsigned int sharedMemorySlots = 4u;
+
+  /// \brief Shared memory output of each image topic.
+  public: std::map<std::string, SharedMemoryStream> sharedMemoryStreams;
+
+  /// \brief Recording of the frames, null when not recording.
+  public: std::unique_ptr<FrameRecorder> recorder;
+
+  /// \brief Number of threads used to generate point clouds.
+  public: unsigned int pointCloudThreads = 1u;
+
+  /// \brief Number of threads used to apply image noise on the CPU.
+  public: unsigned int imageNoiseThreads = 1u;
+
+  /// \brief Resolution of point cloud coordinates, zero for floats.
+  public: double pointCloudResolution = 0.0;
+
+  /// \brief Side of the voxels of filtered point clouds, zero to publish
+  /// organized clouds.
+  public: double pointCloudVoxelSize = 0.0;
+
+  /// \brief Node advertising the descriptor topics.
+  public: transport::Node node;
+
+  /// \brief Get the shared memory segment name of an image topic.
+  /// \param[in] _topic Image topic.
+  /// \return Segment name.
+  public: static std::string SharedMemoryName(const std::string &_topic);
+
+  /// \brief Call a function on each rendering camera.
+  /// \param[in] _func Function to call.
+  public: void ForEachCamera(
+              const std::function<void(rendering::Camera &)> &_func);
+
   /// \brief Pointer to the internal rendering sensors used for generating
   /// sensor data
   public: std::vector<rendering::SensorPtr::weak_type> sensors;
@@ -38,10 +155,38 @@ class gz::sensors::RenderingSensorPrivate
 using namespace gz;
 using namespace sensors;
 
+//////////////////////////////////////////////////
+void RenderingSensorPrivate::ForEachCamera(
+    const std::function<void(rendering::Camera &)> &_func)
+{
+  for (auto rs : this->sensors)
+  {
+    auto s = rs.lock();
+    if (!s)
+      continue;
+    rendering::CameraPtr rc =
+        std::dynamic_pointer_cast<rendering::Camera>(s);
+    if (rc)
+      _func(*rc);
+  }
+}
+
+//////////////////////////////////////////////////
+std::string RenderingSensorPrivate::SharedMemoryName(
+    const std::string &_topic)
+{
+  // Segment names are a single path component
+  std::string name = "/gz_sensors";
+  for (char c : _topic)
+    name += (c == '/') ? '_' : c;
+  return name;
+}
+
 //////////////////////////////////////////////////
 RenderingSensor::RenderingSensor() :
   dataPtr(new RenderingSensorPrivate)
 {
+  this->SetPriority(SensorPriority::PERCEPTION);
 }
 
 //////////////////////////////////////////////////
@@ -70,12 +215,59 @@ rendering::ScenePtr RenderingSensor::Scene() const
   return this->dataPtr->scene;
 }
 
+/////////////////////////////////////////////////
+bool RenderingSensor::ApplySceneChanges()
+{
+  const uint64_t generation = RenderingEvents::SceneGeneration();
+  if (generation == this->dataPtr->sceneGeneration)
+    return false;
+  this->dataPtr->sceneGeneration = generation;
+
+  // Nothing to render into if the scene is gone
+  auto scene = RenderingEvents::LatestScene();
+  if (!scene)
+    return false;
+  this->SetScene(scene);
+  return true;
+}
+
+/////////////////////////////////////////////////
+uint64_t RenderingSensor::PixelCount() const
+{
+  uint64_t count = 0u;
+  this->dataPtr->ForEachCamera([&count](rendering::Camera &_camera)
+  {
+    count += static_cast<uint64_t>(_camera.ImageWidth()) *
+        _camera.ImageHeight();
+  });
+  return count;
+}
+
 /////////////////////////////////////////////////
 void RenderingSensor::AddSensor(rendering::SensorPtr _sensor)
 {
+  // Forget the sensors destroyed since
+  this->dataPtr->sensors.erase(std::remove_if(
+      this->dataPtr->sensors.begin(), this->dataPtr->sensors.end(),
+      [](const rendering::SensorPtr::weak_type &_s)
+      {
+        return _s.expired();
+      }), this->dataPtr->sensors.end());
   this->dataPtr->sensors.push_back(_sensor);
 }
 
+/////////////////////////////////////////////////
+void RenderingSensor::RemoveSensor(rendering::SensorPtr _sensor)
+{
+  this->dataPtr->sensors.erase(std::remove_if(
+      this->dataPtr->sensors.begin(), this->dataPtr->sensors.end(),
+      [&_sensor](const rendering::SensorPtr::weak_type &_s)
+      {
+        auto s = _s.lock();
+        return !s || s == _sensor;
+      }), this->dataPtr->sensors.end());
+}
+
 /////////////////////////////////////////////////
 void RenderingSensor::SetManualSceneUpdate(bool _manual)
 {
@@ -88,29 +280,361 @@ bool RenderingSensor::ManualSceneUpdate() const
   return this->dataPtr->manualSceneUpdate;
 }
 
+/////////////////////////////////////////////////
+void RenderingSensor::SetAsyncReadback(bool _async)
+{
+  this->dataPtr->asyncReadback = _async;
+  this->dataPtr->pendingFrame = false;
+  this->dataPtr->batchRendered = false;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::AsyncReadback() const
+{
+  return this->dataPtr->asyncReadback;
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::SetZeroCopyFrames(bool _enabled)
+{
+  this->dataPtr->zeroCopyFrames = _enabled;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::ZeroCopyFrames() const
+{
+  return this->dataPtr->zeroCopyFrames;
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::SetFrameReuse(bool _enabled)
+{
+  this->dataPtr->frameReuse = _enabled;
+  this->dataPtr->frameValid = false;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::FrameReuse() const
+{
+  return this->dataPtr->frameReuse;
+}
+
+/////////////////////////////////////////////////
+uint64_t RenderingSensor::ReusedFrameCount() const
+{
+  return this->dataPtr->reusedFrames;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::ReuseFrame()
+{
+  if (!this->dataPtr->frameReuse)
+    return false;
+
+  const math::Pose3d pose = this->Pose();
+  if (this->dataPtr->FrameUnchanged(pose))
+  {
+    ++this->dataPtr->reusedFrames;
+    return true;
+  }
+
+  // The caller renders the next frame with the current state
+  this->dataPtr->frameValid = !this->dataPtr->asyncReadback;
+  this->dataPtr->framePose = pose;
+  this->dataPtr->frameGeneration = RenderingEvents::SceneContentGeneration();
+  return false;
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::InvalidateFrame()
+{
+  this->dataPtr->frameValid = false;
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::SetSharedMemoryOutput(bool _enabled,
+    unsigned int _slotCount)
+{
+  this->dataPtr->sharedMemoryOutput = _enabled;
+  this->dataPtr->sharedMemorySlots = _slotCount > 0u ? _slotCount : 1u;
+  // Segments are recreated with the new slot count on the next frame
+  this->dataPtr->sharedMemoryStreams.clear();
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::SharedMemoryOutput() const
+{
+  return this->dataPtr->sharedMemoryOutput;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::SetRecording(const std::string &_path,
+    uint64_t _maxFrames)
+{
+  this->dataPtr->recorder.reset();
+  if (_path.empty())
+    return true;
+
+  auto recorder = std::make_unique<FrameRecorder>();
+  if (!recorder->Open(_path, _maxFrames))
+    return false;
+  this->dataPtr->recorder = std::move(recorder);
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::Recording() const
+{
+  return this->dataPtr->recorder && this->dataPtr->recorder->IsOpen();
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::SetPointCloudThreadCount(unsigned int _count)
+{
+  this->dataPtr->pointCloudThreads = std::max(_count, 1u);
+}
+
+/////////////////////////////////////////////////
+unsigned int RenderingSensor::PointCloudThreadCount() const
+{
+  return this->dataPtr->pointCloudThreads;
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::SetImageNoiseThreadCount(unsigned int _count)
+{
+  this->dataPtr->imageNoiseThreads = std::max(_count, 1u);
+}
+
+/////////////////////////////////////////////////
+unsigned int RenderingSensor::ImageNoiseThreadCount() const
+{
+  return this->dataPtr->imageNoiseThreads;
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::SetPointCloudResolution(double _resolution)
+{
+  this->dataPtr->pointCloudResolution = _resolution > 0.0 ? _resolution : 0.0;
+}
+
+/////////////////////////////////////////////////
+double RenderingSensor::PointCloudResolution() const
+{
+  return this->dataPtr->pointCloudResolution;
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::SetPointCloudVoxelSize(double _size)
+{
+  this->dataPtr->pointCloudVoxelSize = _size > 0.0 ? _size : 0.0;
+}
+
+/////////////////////////////////////////////////
+double RenderingSensor::PointCloudVoxelSize() const
+{
+  return this->dataPtr->pointCloudVoxelSize;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::RecordFrame(uint32_t _stream,
+    const msgs::Image &_image, const void *_data, std::size_t _size)
+{
+  if (!this->dataPtr->recorder)
+    return false;
+  if (this->dataPtr->recorder->Append(_stream, _image, _data, _size))
+    return true;
+
+  if (!this->dataPtr->recorder->IsOpen())
+  {
+    gzerr << "Recording of sensor [" << this->Name()
+          << "] stopped after an error.\n";
+  }
+  else
+  {
+    gzwarn << "Recording of sensor [" << this->Name() << "] reached "
+           << this->dataPtr->recorder->FrameCount()
+           << " frames and stopped.\n";
+  }
+  this->dataPtr->recorder.reset();
+  return false;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::HasSharedMemoryConnections() const
+{
+  if (!this->dataPtr->sharedMemoryOutput)
+    return false;
+  if (this->dataPtr->sharedMemoryStreams.empty())
+    return true;
+  for (const auto &stream : this->dataPtr->sharedMemoryStreams)
+  {
+    if (stream.second.pub.HasConnections())
+      return true;
+  }
+  return false;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::WriteSharedMemoryImage(const std::string &_topic,
+    const msgs::Image &_image, const void *_data, std::size_t _size)
+{
+  if (!this->dataPtr->sharedMemoryOutput)
+    return false;
+
+  GZ_PROFILE("RenderingSensor::WriteSharedMemoryImage");
+  auto it = this->dataPtr->sharedMemoryStreams.find(_topic);
+  if (it == this->dataPtr->sharedMemoryStreams.end())
+  {
+    SharedMemoryStream stream;
+    const std::string descriptorTopic = _topic + "/shm";
+    stream.pub = this->dataPtr->node.Advertise<msgs::Image>(descriptorTopic);
+    if (!stream.pub)
+    {
+      gzerr << "Unable to create publisher on topic [" << descriptorTopic
+            << "].\n";
+      return false;
+    }
+    stream.writer = std::make_unique<SharedMemoryImageWriter>(
+        RenderingSensorPrivate::SharedMemoryName(_topic),
+        this->dataPtr->sharedMemorySlots);
+    it = this->dataPtr->sharedMemoryStreams.emplace(
+        _topic, std::move(stream)).first;
+  }
+  SharedMemoryStream &stream = it->second;
+
+  uint32_t slot{0u};
+  uint64_t sequence{0u};
+  if (!stream.writer->Write(_image, _data, _size, slot, sequence))
+    return false;
+
+  if (!stream.pub.HasConnections())
+    return true;
+
+  msgs::Image &msg = stream.descriptor;
+  msg.set_width(_image.width());
+  msg.set_height(_image.height());
+  msg.set_step(_image.step());
+  msg.set_pixel_format_type(_image.pixel_format_type());
+  msg.mutable_header()->CopyFrom(_image.header());
+  auto addEntry = [&msg](const std::string &_key, const std::string &_value)
+  {
+    auto *entry = msg.mutable_header()->add_data();
+    entry->set_key(_key);
+    entry->add_value(_value);
+  };
+  addEntry("shm_name", stream.writer->Name());
+  addEntry("shm_slot", std::to_string(slot));
+  addEntry("shm_sequence", std::to_string(sequence));
+  this->Publish(stream.pub, msg);
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool RenderingSensor::IsRenderingSensor() const
+{
+  // Replayed sensors publish recorded data and don't render
+  return !this->Replay();
+}
+
+/////////////////////////////////////////////////
+void RenderingSensor::RenderBatch(const std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("RenderingSensor::RenderBatch");
+
+  // Sensors of the batch, by scene
+  std::vector<std::pair<rendering::ScenePtr, std::vector<RenderingSensor *>>>
+      scenes;
+  for (auto *s : _sensors)
+  {
+    auto *sensor = dynamic_cast<RenderingSensor *>(s);
+    if (!sensor)
+      continue;
+
+    // A frame left over from a previous batch must not be read back
+    sensor->dataPtr->batchRendered = false;
+    // Unchanged frames are republished by the update without rendering
+    if (!sensor->dataPtr->scene || sensor->dataPtr->asyncReadback ||
+        !sensor->HasConnections() ||
+        sensor->dataPtr->FrameUnchanged(sensor->Pose()))
+    {
+      continue;
+    }
+
+    auto it = std::find_if(scenes.begin(), scenes.end(),
+        [&sensor](const auto &_entry)
+        {
+          return _entry.first == sensor->dataPtr->scene;
+        });
+    if (it == scenes.end())
+    {
+      scenes.emplace_back(sensor->dataPtr->scene,
+          std::vector<RenderingSensor *>());
+      it = std::prev(scenes.end());
+    }
+    it->second.push_back(sensor);
+  }
+
+  for (auto &[scene, sensors] : scenes)
+  {
+    const bool sceneUpdate = std::any_of(sensors.begin(), sensors.end(),
+        [](const RenderingSensor *_sensor)
+        {
+          return !_sensor->dataPtr->manualSceneUpdate;
+        });
+    if (sceneUpdate)
+      scene->PreRender();
+
+    // Submit all the cameras before any of them is read back
+    for (auto *sensor : sensors)
+    {
+      sensor->dataPtr->ForEachCamera([](rendering::Camera &_camera)
+      {
+        _camera.Render();
+      });
+      sensor->dataPtr->batchRendered = true;
+      sensor->dataPtr->batchFrameTime = _now;
+      sensor->StampLatency(SensorLatencyStage::RENDER);
+    }
+
+    if (sceneUpdate && !scene->LegacyAutoGpuFlush())
+      scene->PostRender();
+  }
+}
+
 /////////////////////////////////////////////////
 void RenderingSensor::Render()
 {
   GZ_PROFILE("RenderingSensor::Render");
+  if (this->dataPtr->batchRendered)
+  {
+    // Already rendered by RenderBatch, only read back
+    TraceScope trace("readback", *this);
+    this->dataPtr->batchRendered = false;
+    this->dataPtr->ForEachCamera([](rendering::Camera &_camera)
+    {
+      _camera.PostRender();
+    });
+    this->StampLatency(SensorLatencyStage::READBACK);
+    return;
+  }
+
   // Skip scene update. The user indicated that they will do this manually.
   // Performance is improved when a global scene update occurs only once per
   // frame, which can be acheived using a manual scene update.
+  TraceScope trace("render", *this);
   if (!this->dataPtr->manualSceneUpdate)
     this->dataPtr->scene->PreRender();
 
-  for (auto rs : this->dataPtr->sensors)
+  this->dataPtr->ForEachCamera([](rendering::Camera &_camera)
   {
-    auto s = rs.lock();
-    if (!s)
-      continue;
-    rendering::CameraPtr rc =
-        std::dynamic_pointer_cast<rendering::Camera>(s);
-    if (rc)
-    {
-      rc->Render();
-      rc->PostRender();
-    }
-  }
+    _camera.Render();
+    _camera.PostRender();
+  });
+  // Each camera is read back right after it's rendered
+  this->StampLatency(SensorLatencyStage::RENDER);
+  this->StampLatency(SensorLatencyStage::READBACK);
 
   if (!this->dataPtr->manualSceneUpdate &&
       !this->dataPtr->scene->LegacyAutoGpuFlush())
@@ -120,3 +644,58 @@ void RenderingSensor::Render()
     this->dataPtr->scene->PostRender();
   }
 }
+
+/////////////////////////////////////////////////
+bool RenderingSensor::Render(const std::chrono::steady_clock::duration &_now,
+    std::chrono::steady_clock::duration &_frameTime,
+    const std::function<void()> &_readback)
+{
+  if (!this->dataPtr->asyncReadback)
+  {
+    if (this->dataPtr->batchFrameTime != _now)
+      this->dataPtr->batchRendered = false;
+    this->Render();
+    if (_readback)
+      _readback();
+    _frameTime = _now;
+    return true;
+  }
+
+  GZ_PROFILE("RenderingSensor::Render async");
+  bool ready = false;
+  if (this->dataPtr->pendingFrame)
+  {
+    // Read back the previous frame, which fires the frame callbacks
+    TraceScope trace("readback", *this);
+    this->dataPtr->ForEachCamera([](rendering::Camera &_camera)
+    {
+      _camera.PostRender();
+    });
+    if (_readback)
+      _readback();
+    this->StampLatency(SensorLatencyStage::READBACK);
+    _frameTime = this->dataPtr->pendingFrameTime;
+    ready = true;
+  }
+
+  TraceScope trace("render", *this);
+  if (!this->dataPtr->manualSceneUpdate)
+    this->dataPtr->scene->PreRender();
+
+  this->dataPtr->ForEachCamera([](rendering::Camera &_camera)
+  {
+    _camera.Render();
+  });
+
+  // Submit the new frame without waiting for it
+  if (!this->dataPtr->manualSceneUpdate &&
+      !this->dataPtr->scene->LegacyAutoGpuFlush())
+  {
+    this->dataPtr->scene->PostRender();
+  }
+  this->StampLatency(SensorLatencyStage::RENDER);
+
+  this->dataPtr->pendingFrame = true;
+  this->dataPtr->pendingFrameTime = _now;
+  return ready;
+}
@@ -15,6 +15,9 @@
  *
 */
 
+#include <algorithm>
+#include <vector>
+
 #include <gz/msgs/image.pb.h>
 #include <gz/msgs/pointcloud_packed.pb.h>
 
@@ -36,7 +39,10 @@
 #include "gz/sensors/RenderingEvents.hh"
 #include "gz/sensors/SensorFactory.hh"
 
+#include "AlignedBuffer.hh"
+#include "MemorySize.hh"
 #include "PointCloudUtil.hh"
+#include "TraceRecorder.hh"
 
 /// \brief Private data for RgbdCameraSensor
 class gz::sensors::RgbdCameraSensorPrivate
@@ -75,6 +81,9 @@ class gz::sensors::RgbdCameraSensorPrivate
   /// \brief publisher to publish point cloud
   public: transport::Node::Publisher pointPub;
 
+  /// \brief publisher to publish surface normals
+  public: transport::Node::Publisher normalPub;
+
   /// \brief true if Load() has been called and was successful
   public: bool initialized = false;
 
@@ -82,10 +91,19 @@ class gz::sensors::RgbdCameraSensorPrivate
   public: gz::rendering::DepthCameraPtr depthCamera;
 
   /// \brief Depth data buffer.
-  public: float *depthBuffer = nullptr;
+  public: AlignedBuffer<float> depthBuffer;
+
+  /// \brief Cropped and decimated depth image, unused for full frames.
+  public: std::vector<unsigned char> depthRegionBuffer;
+
+  /// \brief Cropped and decimated color image, unused for full frames.
+  public: std::vector<unsigned char> colorRegionBuffer;
 
   /// \brief Point cloud data buffer.
-  public: float *pointCloudBuffer = nullptr;
+  public: AlignedBuffer<float> pointCloudBuffer;
+
+  /// \brief Surface normals, 3 floats per point.
+  public: AlignedBuffer<float> normalBuffer;
 
   /// \brief True if a depth far clipping value has been set.
   public: bool hasDepthFarClip = false;
@@ -99,6 +117,13 @@ class gz::sensors::RgbdCameraSensorPrivate
   /// \brief Depth camera near clipping distance in meters.
   public: double depthNearClip = 0.1;
 
+  /// \brief Far clipping distance of the color image in meters.
+  public: double colorFarClip = 10.0;
+
+  /// \brief True while the far clip plane of the depth camera is the
+  /// depth far clipping distance, so the render pass clips the depths.
+  public: bool gpuFarClip = false;
+
   /// \brief The number of channels (x, y, z, rgba, ...) in the
   /// point cloud.
   public: unsigned int channels = 4;
@@ -110,7 +135,11 @@ class gz::sensors::RgbdCameraSensorPrivate
   public: gz::rendering::Image image;
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief The depth image noise if it's applied to the depth frames on
+  /// the CPU.
+  public: std::shared_ptr<ImageGaussianNoiseModel> cpuNoise;
 
   /// \brief Connection from depth camera with new depth data
   public: gz::common::ConnectionPtr depthConnection;
@@ -130,9 +159,18 @@ class gz::sensors::RgbdCameraSensorPrivate
   /// \brief The point cloud message.
   public: msgs::PointCloudPacked pointMsg;
 
+  /// \brief Voxel filtered point cloud, when a voxel size is set.
+  public: msgs::PointCloudPacked voxelMsg;
+
   /// \brief Helper class that can fill a msgs::PointCloudPacked
   /// image and depth data.
   public: PointCloudUtil pointsUtil;
+
+  /// \brief Initialize the point message with the coordinate type of a
+  /// resolution, keeping its width and height.
+  /// \param[in] _frameId Frame of the point cloud.
+  /// \param[in] _resolution Resolution of the coordinates, zero for floats.
+  public: void InitPointMsg(const std::string &_frameId, double _resolution);
 };
 
 using namespace gz;
@@ -149,10 +187,6 @@ RgbdCameraSensor::~RgbdCameraSensor()
 {
   this->dataPtr->depthConnection.reset();
   this->dataPtr->pointCloudConnection.reset();
-  if (this->dataPtr->depthBuffer)
-    delete [] this->dataPtr->depthBuffer;
-  if (this->dataPtr->pointCloudBuffer)
-    delete [] this->dataPtr->pointCloudBuffer;
 }
 
 //////////////////////////////////////////////////
@@ -196,10 +230,8 @@ bool RgbdCameraSensor::Load(const sdf::Sensor &_sdf)
   this->dataPtr->sdfSensor = _sdf;
 
   // Create the 2d image publisher
-  this->dataPtr->imagePub =
-      this->dataPtr->node.Advertise<msgs::Image>(
-          this->Topic() + "/image");
-  if (!this->dataPtr->imagePub)
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+      this->dataPtr->imagePub, this->Topic() + "/image"))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() + "/image" << "].\n";
@@ -210,10 +242,8 @@ bool RgbdCameraSensor::Load(const sdf::Sensor &_sdf)
          << this->Topic() << "/image]" << std::endl;
 
   // Create the depth image publisher
-  this->dataPtr->depthPub =
-      this->dataPtr->node.Advertise<msgs::Image>(
-          this->Topic() + "/depth_image");
-  if (!this->dataPtr->depthPub)
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+      this->dataPtr->depthPub, this->Topic() + "/depth_image"))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() + "/depth_image" << "].\n";
@@ -224,10 +254,8 @@ bool RgbdCameraSensor::Load(const sdf::Sensor &_sdf)
          << this->Topic() << "/depth_image]" << std::endl;
 
   // Create the point cloud publisher
-  this->dataPtr->pointPub =
-      this->dataPtr->node.Advertise<msgs::PointCloudPacked>(
-          this->Topic() + "/points");
-  if (!this->dataPtr->pointPub)
+  if (!this->Advertise<msgs::PointCloudPacked>(this->dataPtr->node,
+      this->dataPtr->pointPub, this->Topic() + "/points"))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() + "/points" << "].\n";
@@ -237,17 +265,20 @@ bool RgbdCameraSensor::Load(const sdf::Sensor &_sdf)
   gzdbg << "Points for [" << this->Name() << "] advertised on ["
          << this->Topic() << "/points]" << std::endl;
 
+  // Create the surface normals publisher
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+      this->dataPtr->normalPub, this->Topic() + "/normals"))
+  {
+    gzerr << "Unable to create publisher on topic["
+      << this->Topic() + "/normals" << "].\n";
+    return false;
+  }
+
   if (!this->AdvertiseInfo(this->Topic() + "/camera_info"))
     return false;
 
   // Initialize the point message.
-  // \todo(anyone) The true value in the following function call forces
-  // the xyz and rgb fields to be aligned to memory boundaries. This is need
-  // by ROS1: https://github.com/ros/common_msgs/pull/77. Ideally, memory
-  // alignment should be configured.
-  msgs::InitPointCloudPacked(this->dataPtr->pointMsg, this->FrameId(), true,
-      {{"xyz", msgs::PointCloudPacked::Field::FLOAT32},
-       {"rgb", msgs::PointCloudPacked::Field::FLOAT32}});
+  this->dataPtr->InitPointMsg(this->FrameId(), this->PointCloudResolution());
 
   if (this->Scene())
   {
@@ -285,6 +316,8 @@ bool RgbdCameraSensor::CreateCameras()
   this->dataPtr->depthCamera->SetImageHeight(height);
   this->dataPtr->depthCamera->SetNearClipPlane(cameraSdf->NearClip());
   this->dataPtr->depthCamera->SetFarClipPlane(cameraSdf->FarClip());
+  this->dataPtr->colorFarClip = cameraSdf->FarClip();
+  this->dataPtr->gpuFarClip = false;
 
   // Note: while Gazebo interprets the camera frame to be looking towards +X,
   // other tools, such as ROS, may interpret this frame as looking towards +Z.
@@ -332,9 +365,11 @@ bool RgbdCameraSensor::CreateCameras()
       this->dataPtr->noises[noiseType] =
         ImageNoiseFactory::NewNoiseModel(noiseSdf, "rgbd_camera");
 
-      std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
-           this->dataPtr->noises[noiseType])->SetCamera(
-             this->dataPtr->depthCamera);
+      auto imageNoise = std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
+          this->dataPtr->noises[noiseType]);
+      imageNoise->SetCamera(this->dataPtr->depthCamera);
+      this->dataPtr->cpuNoise =
+          imageNoise->AppliesOnCpu() ? imageNoise : nullptr;
     }
     else if (noiseSdf.Type() != sdf::NoiseType::NONE)
     {
@@ -368,12 +403,9 @@ bool RgbdCameraSensor::CreateCameras()
 
   this->Scene()->RootVisual()->AddChild(this->dataPtr->depthCamera);
 
-  this->dataPtr->depthConnection =
-      this->dataPtr->depthCamera->ConnectNewDepthFrame(
-        std::bind(&RgbdCameraSensorPrivate::OnNewDepthFrame,
-        this->dataPtr.get(),
-        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
-        std::placeholders::_4, std::placeholders::_5));
+  // The frames are connected in Update once they have consumers
+  this->dataPtr->depthConnection.reset();
+  this->dataPtr->pointCloudConnection.reset();
 
   // Set the values of the point message based on the camera information.
   this->dataPtr->pointMsg.set_width(this->ImageWidth());
@@ -400,6 +432,24 @@ void RgbdCameraSensor::SetScene(rendering::ScenePtr _scene)
   }
 }
 
+/////////////////////////////////////////////////
+void RgbdCameraSensorPrivate::InitPointMsg(const std::string &_frameId,
+    double _resolution)
+{
+  // \todo(anyone) Float coordinates force the xyz and rgb fields to be
+  // aligned to memory boundaries. This is need by ROS1:
+  // https://github.com/ros/common_msgs/pull/77. Ideally, memory alignment
+  // should be configured.
+  const uint32_t width = this->pointMsg.width();
+  const uint32_t height = this->pointMsg.height();
+  this->pointsUtil.SetResolution(_resolution);
+  this->pointsUtil.InitMsg(this->pointMsg, _frameId,
+      {{"rgb", msgs::PointCloudPacked::Field::FLOAT32}});
+  this->pointMsg.set_width(width);
+  this->pointMsg.set_height(height);
+  this->pointMsg.set_row_step(this->pointMsg.point_step() * width);
+}
+
 /////////////////////////////////////////////////
 void RgbdCameraSensorPrivate::OnNewDepthFrame(const float *_scan,
                     unsigned int _width, unsigned int _height,
@@ -411,10 +461,10 @@ void RgbdCameraSensorPrivate::OnNewDepthFrame(const float *_scan,
   unsigned int depthSamples = _width * _height;
   unsigned int depthBufferSize = depthSamples * sizeof(float);
 
-  if (!this->depthBuffer)
-    this->depthBuffer = new float[depthSamples];
-
-  memcpy(this->depthBuffer, _scan, depthBufferSize);
+  this->depthBuffer.Resize(depthSamples);
+  memcpy(this->depthBuffer.Data(), _scan, depthBufferSize);
+  if (this->cpuNoise)
+    this->cpuNoise->ApplyToImage(this->depthBuffer.Data(), depthSamples);
 }
 
 /////////////////////////////////////////////////
@@ -430,10 +480,8 @@ void RgbdCameraSensorPrivate::OnNewRgbPointCloud(const float *_scan,
       sizeof(float);
   this->channels = _channels;
 
-  if (!this->pointCloudBuffer)
-    this->pointCloudBuffer = new float[pointCloudSamples * _channels];
-
-  memcpy(this->pointCloudBuffer, _scan, pointCloudBufferSize);
+  this->pointCloudBuffer.Resize(pointCloudSamples * _channels);
+  memcpy(this->pointCloudBuffer.Data(), _scan, pointCloudBufferSize);
 }
 
 //////////////////////////////////////////////////
@@ -452,22 +500,68 @@ bool RgbdCameraSensor::Update(const std::chrono::steady_clock::duration &_now)
     return false;
   }
 
-  if (this->HasInfoConnections())
-  {
-    // publish the camera info message
-    this->PublishInfo(_now);
-  }
+  // publish the camera info message, if it has subscribers
+  this->PublishInfo(_now);
 
   // don't render if there are no subscribers
   if (!this->HasColorConnections() && !this->HasDepthConnections() &&
-    !this->HasPointConnections())
+    !this->HasPointConnections() && !this->HasNormalConnections())
   {
     return false;
   }
 
-  if ((this->HasPointConnections() || HasColorConnections()) &&
-      !this->dataPtr->pointCloudConnection)
+  // Without a color image, the far clip plane of the depth camera is the
+  // depth far clipping distance, so the render pass leaves +infinity
+  // beyond it and the depths and points arrive already clipped. The color
+  // image needs the camera far clip plane. Near clipping stays on the CPU:
+  // a near clip plane would cull close objects instead of reporting
+  // -infinity, showing the surfaces behind them.
+  const bool gpuFarClip =
+      this->dataPtr->hasDepthFarClip && !this->HasColorConnections();
+  if (gpuFarClip != this->dataPtr->gpuFarClip)
+  {
+    this->dataPtr->depthCamera->SetFarClipPlane(gpuFarClip ?
+        std::min(this->dataPtr->colorFarClip, this->dataPtr->depthFarClip) :
+        this->dataPtr->colorFarClip);
+    this->dataPtr->gpuFarClip = gpuFarClip;
+  }
+  const bool cpuFarClip = this->dataPtr->hasDepthFarClip && !gpuFarClip;
+
+  // Only read back the frames the active outputs need: the depth camera
+  // skips the depth or point cloud copy when nothing is connected to it.
+  // The point cloud only needs the depths to clip its points on the CPU,
+  // and the normals are estimated from the point cloud.
+  const bool needPointCloud = this->HasPointConnections() ||
+      this->HasColorConnections() || this->HasNormalConnections();
+  const bool needDepth = this->HasDepthConnections() ||
+      (this->HasPointConnections() &&
+      (this->dataPtr->hasDepthNearClip || cpuFarClip));
+
+  // The buffers are allocated when an output connects, before the first
+  // frame arrives
+  const std::size_t samples =
+      static_cast<std::size_t>(this->ImageWidth()) * this->ImageHeight();
+
+  if (needDepth && !this->dataPtr->depthConnection)
   {
+    this->dataPtr->depthBuffer.SetMemory(this->BufferMemory());
+    this->dataPtr->depthBuffer.Reserve(samples);
+    this->dataPtr->depthConnection =
+        this->dataPtr->depthCamera->ConnectNewDepthFrame(
+        std::bind(&RgbdCameraSensorPrivate::OnNewDepthFrame,
+        this->dataPtr.get(),
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
+        std::placeholders::_4, std::placeholders::_5));
+  }
+  else if (!needDepth && this->dataPtr->depthConnection)
+  {
+    this->dataPtr->depthConnection.reset();
+  }
+
+  if (needPointCloud && !this->dataPtr->pointCloudConnection)
+  {
+    this->dataPtr->pointCloudBuffer.SetMemory(this->BufferMemory());
+    this->dataPtr->pointCloudBuffer.Reserve(samples * this->dataPtr->channels);
     this->dataPtr->pointCloudConnection =
         this->dataPtr->depthCamera->ConnectNewRgbPointCloud(
         std::bind(&RgbdCameraSensorPrivate::OnNewRgbPointCloud,
@@ -475,27 +569,81 @@ bool RgbdCameraSensor::Update(const std::chrono::steady_clock::duration &_now)
         std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
         std::placeholders::_4, std::placeholders::_5));
   }
-  else if (!this->HasPointConnections() && !this->HasColorConnections() &&
-      this->dataPtr->pointCloudConnection)
+  else if (!needPointCloud && this->dataPtr->pointCloudConnection)
   {
     this->dataPtr->pointCloudConnection.reset();
   }
 
   unsigned int width = this->dataPtr->depthCamera->ImageWidth();
   unsigned int height = this->dataPtr->depthCamera->ImageHeight();
-  unsigned int depthSamples = height * width;
 
   // generate sensor data
+  if (this->dataPtr->cpuNoise)
+    this->dataPtr->cpuNoise->SetThreadCount(this->ImageNoiseThreadCount());
   this->Render();
 
+  const bool hasDepth = this->HasDepthConnections() &&
+      !this->dataPtr->depthBuffer.Empty();
+  const bool hasPoints = this->HasPointConnections() &&
+      !this->dataPtr->pointCloudBuffer.Empty();
+  const bool hasColor = this->HasColorConnections() &&
+      !this->dataPtr->pointCloudBuffer.Empty();
+  const bool hasNormals = this->HasNormalConnections() &&
+      !this->dataPtr->pointCloudBuffer.Empty();
+  float *depthData = needDepth && !this->dataPtr->depthBuffer.Empty() ?
+      this->dataPtr->depthBuffer.Data() : nullptr;
+
+  if (hasColor &&
+      (this->dataPtr->image.Width() != width ||
+      this->dataPtr->image.Height() != height))
+  {
+    this->dataPtr->image =
+        rendering::Image(width, height, rendering::PF_R8G8B8);
+  }
+
+  if (hasPoints)
+  {
+    if (this->dataPtr->pointsUtil.Resolution() !=
+        this->PointCloudResolution())
+    {
+      this->dataPtr->InitPointMsg(this->FrameId(),
+          this->PointCloudResolution());
+    }
+
+    // Set the time stamp
+    *this->dataPtr->pointMsg.mutable_header()->mutable_stamp() =
+      msgs::Convert(_now);
+    this->dataPtr->pointMsg.set_is_dense(true);
+  }
+
+  // Clip the depths, fill the point cloud and extract the image in a single
+  // sweep over the pixels. The clipping on the CPU is a work around since
+  // gz-rendering's depth camera does not support 2 different clipping
+  // distances. An assumption is made that the depth clipping distances are
+  // within bounds of the rgb clipping distances, if not, the rgb clipping
+  // values will take priority.
+  if (hasDepth || hasPoints || hasColor)
+  {
+    GZ_PROFILE("RgbdCameraSensor::Update Fill");
+    TraceScope trace("fill", *this);
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    this->dataPtr->pointsUtil.SetThreadCount(this->PointCloudThreadCount());
+    this->dataPtr->pointsUtil.FillRgbdMsg(
+        hasPoints ? &this->dataPtr->pointMsg : nullptr,
+        hasPoints || hasColor ? this->dataPtr->pointCloudBuffer.Data() :
+            nullptr,
+        depthData,
+        width, height,
+        this->dataPtr->hasDepthNearClip ?
+            this->dataPtr->depthNearClip : -math::INF_D,
+        cpuFarClip ? this->dataPtr->depthFarClip : math::INF_D,
+        hasColor ? this->dataPtr->image.Data<unsigned char>() : nullptr);
+  }
+
   // create and publish the depthmessage
-  if (this->HasDepthConnections())
+  if (hasDepth)
   {
     msgs::Image msg;
-    msg.set_width(width);
-    msg.set_height(height);
-    msg.set_step(width * rendering::PixelUtil::BytesPerPixel(
-               rendering::PF_FLOAT32_R));
     msg.set_pixel_format_type(msgs::PixelFormatType::R_FLOAT32);
     *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
     auto frame = msg.mutable_header()->add_data();
@@ -504,124 +652,119 @@ bool RgbdCameraSensor::Update(const std::chrono::steady_clock::duration &_now)
 
     std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
-    // The following code is a work around since gz-rendering's depth camera
-    // does not support 2 different clipping distances. An assumption is made
-    // that the depth clipping distances are within bounds of the rgb clipping
-    // distances, if not, the rgb clipping values will take priority.
-    if (this->dataPtr->hasDepthNearClip || this->dataPtr->hasDepthFarClip)
-    {
-      for (unsigned int i = 0; i < depthSamples; i++)
-      {
-        if (this->dataPtr->hasDepthFarClip &&
-            (this->dataPtr->depthBuffer[i] > this->dataPtr->depthFarClip))
-        {
-          this->dataPtr->depthBuffer[i] = math::INF_D;
-        }
-        if (this->dataPtr->hasDepthNearClip &&
-            (this->dataPtr->depthBuffer[i] < this->dataPtr->depthNearClip))
-        {
-          this->dataPtr->depthBuffer[i] = -math::INF_D;
-        }
-      }
-    }
-    msg.set_data(this->dataPtr->depthBuffer,
-        rendering::PixelUtil::MemorySize(rendering::PF_FLOAT32_R,
-        width, height));
+    // Pixels only go through protobuf if someone receives the message
+    const bool publishDepth = this->dataPtr->depthPub.HasConnections();
+    unsigned int depthWidth = width;
+    unsigned int depthHeight = height;
+    const unsigned char *depthData = this->ApplyRegionOfInterest(
+        reinterpret_cast<const unsigned char *>(
+        this->dataPtr->depthBuffer.Data()),
+        depthWidth, depthHeight, sizeof(float),
+        this->dataPtr->depthRegionBuffer);
+    msg.set_width(depthWidth);
+    msg.set_height(depthHeight);
+    msg.set_step(depthWidth * rendering::PixelUtil::BytesPerPixel(
+               rendering::PF_FLOAT32_R));
+    const std::size_t depthSize = rendering::PixelUtil::MemorySize(
+        rendering::PF_FLOAT32_R, depthWidth, depthHeight);
+    if (publishDepth)
+      msg.set_data(depthData, depthSize);
+
+    this->AddSequence(msg.mutable_header(), "depthImage");
+    this->WriteSharedMemoryImage(this->Topic() + "/depth_image", msg,
+        depthData, depthSize);
 
     // publish
+    if (publishDepth)
     {
-      this->AddSequence(msg.mutable_header(), "depthImage");
       GZ_PROFILE("RgbdCameraSensor::Update Publish depth image");
-      this->dataPtr->depthPub.Publish(msg);
+      this->Publish(this->dataPtr->depthPub, msg);
     }
   }
 
-  if (this->dataPtr->pointCloudBuffer)
+  // publish point cloud msg
+  if (hasPoints)
   {
-    bool filledImgData = false;
-    if (this->dataPtr->image.Width() != width
-        || this->dataPtr->image.Height() != height)
+    this->AddSequence(this->dataPtr->pointMsg.mutable_header(), "pointMsg");
+    GZ_PROFILE("RgbdCameraSensor::Update Publish point cloud");
+    const double voxelSize = this->PointCloudVoxelSize();
+    if (voxelSize > 0.0)
     {
-      this->dataPtr->image =
-          rendering::Image(width, height, rendering::PF_R8G8B8);
+      this->dataPtr->pointsUtil.VoxelFilter(this->dataPtr->pointMsg,
+          voxelSize, this->dataPtr->voxelMsg);
+      this->Publish(this->dataPtr->pointPub, this->dataPtr->voxelMsg);
     }
+    else
+    {
+      this->Publish(this->dataPtr->pointPub, this->dataPtr->pointMsg);
+    }
+  }
 
-    // publish point cloud msg
-    if (this->HasPointConnections())
+  // publish the surface normals
+  if (hasNormals)
+  {
+    GZ_PROFILE("RgbdCameraSensor::Update Normals");
+    const std::size_t normalSize =
+        static_cast<std::size_t>(width) * height * 3u * sizeof(float);
+    msgs::Image msg;
+    msg.set_width(width);
+    msg.set_height(height);
+    msg.set_step(width * 3u * sizeof(float));
+    msg.set_pixel_format_type(msgs::PixelFormatType::RGB_FLOAT32);
+    *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
+    auto frame = msg.mutable_header()->add_data();
+    frame->set_key("frame_id");
+    frame->add_value(this->FrameId());
     {
-      // Set the time stamp
-      *this->dataPtr->pointMsg.mutable_header()->mutable_stamp() =
-        msgs::Convert(_now);
-      this->dataPtr->pointMsg.set_is_dense(true);
-
-      if ((this->dataPtr->hasDepthNearClip || this->dataPtr->hasDepthFarClip)
-          && this->dataPtr->depthBuffer)
-      {
-        for (unsigned int i = 0; i < depthSamples; i++)
-        {
-          float depthValue = this->dataPtr->depthBuffer[i];
-          if (std::isinf(depthValue))
-          {
-            unsigned int index = i * this->dataPtr->channels;
-
-            this->dataPtr->pointCloudBuffer[index] = depthValue;
-            this->dataPtr->pointCloudBuffer[index + 1] = depthValue;
-            this->dataPtr->pointCloudBuffer[index + 2] = depthValue;
-          }
-        }
-      }
-
-      {
-        GZ_PROFILE("RgbdCameraSensor::Update Fill Point Cloud");
-        // fill point cloud msg and image data
-        this->dataPtr->pointsUtil.FillMsg(this->dataPtr->pointMsg,
-            this->dataPtr->pointCloudBuffer, true,
-            this->dataPtr->image.Data<unsigned char>());
-        filledImgData = true;
-      }
-
-      // publish
-      {
-        this->AddSequence(this->dataPtr->pointMsg.mutable_header(), "pointMsg");
-        GZ_PROFILE("RgbdCameraSensor::Update Publish point cloud");
-        this->dataPtr->pointPub.Publish(this->dataPtr->pointMsg);
-      }
+      std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+      this->dataPtr->normalBuffer.SetMemory(this->BufferMemory());
+      this->dataPtr->normalBuffer.Resize(samples * 3u);
+      this->dataPtr->pointsUtil.SetThreadCount(
+          this->PointCloudThreadCount());
+      this->dataPtr->pointsUtil.NormalsFromPointCloud(
+          this->dataPtr->normalBuffer.Data(),
+          this->dataPtr->pointCloudBuffer.Data(), width, height);
+      msg.set_data(this->dataPtr->normalBuffer.Data(), normalSize);
     }
+    this->AddSequence(msg.mutable_header(), "normals");
+    this->Publish(this->dataPtr->normalPub, msg);
+  }
 
-    // publish the 2d image message
-    if (this->HasColorConnections())
+  // publish the 2d image message
+  if (hasColor)
+  {
+    unsigned int colorWidth = width;
+    unsigned int colorHeight = height;
+    const unsigned char *data = this->ApplyRegionOfInterest(
+        this->dataPtr->image.Data<unsigned char>(), colorWidth,
+        colorHeight, rendering::PixelUtil::BytesPerPixel(
+        rendering::PF_R8G8B8), this->dataPtr->colorRegionBuffer);
+
+    msgs::Image msg;
+    msg.set_width(colorWidth);
+    msg.set_height(colorHeight);
+    msg.set_step(colorWidth * rendering::PixelUtil::BytesPerPixel(
+        rendering::PF_R8G8B8));
+    msg.set_pixel_format_type(msgs::PixelFormatType::RGB_INT8);
+    *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
+    auto frame = msg.mutable_header()->add_data();
+    frame->set_key("frame_id");
+    frame->add_value(this->dataPtr->opticalFrameId);
+    const bool publishColor = this->dataPtr->imagePub.HasConnections();
+    const std::size_t colorSize = rendering::PixelUtil::MemorySize(
+        rendering::PF_R8G8B8, colorWidth, colorHeight);
+    if (publishColor)
+      msg.set_data(data, colorSize);
+
+    this->AddSequence(msg.mutable_header(), "rgbdImage");
+    this->WriteSharedMemoryImage(this->Topic() + "/image", msg, data,
+        colorSize);
+
+    // publish the image message
+    if (publishColor)
     {
-      if (!filledImgData)
-      {
-        GZ_PROFILE("RgbdCameraSensor::Update Fill RGB Image");
-        // extract image data from point cloud data
-        this->dataPtr->pointsUtil.RGBFromPointCloud(
-            this->dataPtr->image.Data<unsigned char>(),
-            this->dataPtr->pointCloudBuffer,
-            width, height);
-      }
-
-      unsigned char *data = this->dataPtr->image.Data<unsigned char>();
-
-      msgs::Image msg;
-      msg.set_width(width);
-      msg.set_height(height);
-      msg.set_step(width * rendering::PixelUtil::BytesPerPixel(
-          rendering::PF_R8G8B8));
-      msg.set_pixel_format_type(msgs::PixelFormatType::RGB_INT8);
-      *msg.mutable_header()->mutable_stamp() = msgs::Convert(_now);
-      auto frame = msg.mutable_header()->add_data();
-      frame->set_key("frame_id");
-      frame->add_value(this->dataPtr->opticalFrameId);
-      msg.set_data(data, rendering::PixelUtil::MemorySize(rendering::PF_R8G8B8,
-        width, height));
-
-      // publish the image message
-      {
-        this->AddSequence(msg.mutable_header(), "rgbdImage");
-        GZ_PROFILE("RgbdCameraSensor::Update Publish RGB image");
-        this->dataPtr->imagePub.Publish(msg);
-      }
+      GZ_PROFILE("RgbdCameraSensor::Update Publish RGB image");
+      this->Publish(this->dataPtr->imagePub, msg);
     }
   }
 
@@ -640,23 +783,43 @@ unsigned int RgbdCameraSensor::ImageHeight() const
   return this->dataPtr->depthCamera->ImageHeight();
 }
 
+//////////////////////////////////////////////////
+SensorMemoryUsage RgbdCameraSensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage = CameraSensor::MemoryUsage();
+  usage["depth_buffer"] = MemorySize(this->dataPtr->depthBuffer);
+  usage["point_cloud_buffer"] = MemorySize(this->dataPtr->pointCloudBuffer);
+  usage["normal_buffer"] = MemorySize(this->dataPtr->normalBuffer);
+  usage["region_buffer"] += MemorySize(this->dataPtr->depthRegionBuffer) +
+      MemorySize(this->dataPtr->colorRegionBuffer);
+  usage["image"] += this->dataPtr->image.MemorySize();
+  usage["point_msg"] = MemorySize(this->dataPtr->pointMsg) +
+      MemorySize(this->dataPtr->voxelMsg);
+  return usage;
+}
+
 //////////////////////////////////////////////////
 bool RgbdCameraSensor::HasConnections() const
 {
   return this->HasColorConnections() || this->HasDepthConnections() ||
-         this->HasPointConnections() || this->HasInfoConnections();
+         this->HasPointConnections() || this->HasNormalConnections() ||
+         this->HasInfoConnections();
 }
 
 //////////////////////////////////////////////////
 bool RgbdCameraSensor::HasColorConnections() const
 {
-  return this->dataPtr->imagePub && this->dataPtr->imagePub.HasConnections();
+  return (this->dataPtr->imagePub &&
+          this->dataPtr->imagePub.HasConnections()) ||
+         this->HasSharedMemoryConnections();
 }
 
 //////////////////////////////////////////////////
 bool RgbdCameraSensor::HasDepthConnections() const
 {
-  return this->dataPtr->depthPub && this->dataPtr->depthPub.HasConnections();
+  return (this->dataPtr->depthPub &&
+          this->dataPtr->depthPub.HasConnections()) ||
+         this->HasSharedMemoryConnections();
 }
 
 //////////////////////////////////////////////////
@@ -664,3 +827,10 @@ bool RgbdCameraSensor::HasPointConnections() const
 {
   return this->dataPtr->pointPub && this->dataPtr->pointPub.HasConnections();
 }
+
+//////////////////////////////////////////////////
+bool RgbdCameraSensor::HasNormalConnections() const
+{
+  return this->dataPtr->normalPub &&
+         this->dataPtr->normalPub.HasConnections();
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_ROWWORKERS_HH_
+#define GZ_SENSORS_ROWWORKERS_HH_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Threads which process ranges of rows of an image or a point
+    /// cloud together with the calling thread.
+    class RowWorkers
+    {
+      /// \brief Constructor
+      /// \param[in] _count Number of threads including the calling thread.
+      public: explicit RowWorkers(unsigned int _count)
+      {
+        this->threads.reserve(_count - 1u);
+        for (unsigned int i = 1u; i < _count; ++i)
+          this->threads.emplace_back(&RowWorkers::Loop, this, i);
+      }
+
+      /// \brief Destructor. Stops and joins the threads.
+      public: ~RowWorkers()
+      {
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->stop = true;
+        }
+        this->workCv.notify_all();
+        for (auto &thread : this->threads)
+          thread.join();
+      }
+
+      /// \brief Get the number of threads including the calling thread.
+      /// \return Number of threads.
+      public: unsigned int Count() const
+      {
+        return static_cast<unsigned int>(this->threads.size()) + 1u;
+      }
+
+      /// \brief Run a function on all rows and wait for it to finish. The
+      /// calling thread takes the first range of rows.
+      /// \param[in] _rows Number of rows.
+      /// \param[in] _fn Function to run on each range of rows.
+      public: void Run(uint32_t _rows,
+          const std::function<void(uint32_t, uint32_t)> &_fn)
+      {
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->fn = &_fn;
+          this->rows = _rows;
+          this->pending = static_cast<unsigned int>(this->threads.size());
+          ++this->generation;
+        }
+        this->workCv.notify_all();
+
+        this->RunRange(0u);
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->doneCv.wait(lock, [this] { return this->pending == 0u; });
+        this->fn = nullptr;
+      }
+
+      /// \brief Run the current function on the range of rows of a thread.
+      /// \param[in] _index Index of the thread, 0 for the calling thread.
+      private: void RunRange(unsigned int _index)
+      {
+        const uint64_t count = this->Count();
+        const auto begin = static_cast<uint32_t>(this->rows * _index / count);
+        const auto end =
+            static_cast<uint32_t>(this->rows * (_index + 1u) / count);
+        if (begin < end)
+          (*this->fn)(begin, end);
+      }
+
+      /// \brief Main loop of a worker thread.
+      /// \param[in] _index Index of the thread.
+      private: void Loop(unsigned int _index)
+      {
+        uint64_t done = 0u;
+        while (true)
+        {
+          {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->workCv.wait(lock, [&]
+            {
+              return this->stop || this->generation != done;
+            });
+            if (this->stop)
+              return;
+            done = this->generation;
+          }
+
+          this->RunRange(_index);
+
+          std::lock_guard<std::mutex> lock(this->mutex);
+          if (--this->pending == 0u)
+            this->doneCv.notify_one();
+        }
+      }
+
+      /// \brief Worker threads.
+      private: std::vector<std::thread> threads;
+
+      /// \brief Protects the members below.
+      private: std::mutex mutex;
+
+      /// \brief Notifies the workers of new work or of a stop.
+      private: std::condition_variable workCv;
+
+      /// \brief Notifies Run that all workers are done.
+      private: std::condition_variable doneCv;
+
+      /// \brief Function being run, null when idle.
+      private: const std::function<void(uint32_t, uint32_t)> *fn{nullptr};
+
+      /// \brief Number of rows of the current run.
+      private: uint64_t rows{0u};
+
+      /// \brief Incremented on every run.
+      private: uint64_t generation{0u};
+
+      /// \brief Number of workers still running the current range.
+      private: unsigned int pending{0u};
+
+      /// \brief True to make the workers exit.
+      private: bool stop{false};
+    };
+    }
+  }
+}
+
+#endif
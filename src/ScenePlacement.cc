@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include <gz/common/Console.hh>
+
+#include "gz/sensors/RenderingSensor.hh"
+#include "gz/sensors/ScenePlacement.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Private data class for ScenePlacement
+class gz::sensors::ScenePlacementPrivate
+{
+  /// \brief Scenes sensors are assigned to.
+  public: std::vector<rendering::ScenePtr> scenes;
+
+  /// \brief Load of each scene after the last Assign call.
+  public: std::vector<double> loads;
+
+  /// \brief Scene index of each pinned sensor, by sensor name.
+  public: std::unordered_map<std::string, std::size_t> pins;
+
+  /// \brief Cost function, DefaultCost if empty.
+  public: ScenePlacement::CostFunction cost;
+};
+
+//////////////////////////////////////////////////
+ScenePlacement::ScenePlacement() :
+  dataPtr(new ScenePlacementPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+ScenePlacement::~ScenePlacement() = default;
+
+//////////////////////////////////////////////////
+std::size_t ScenePlacement::AddScene(rendering::ScenePtr _scene)
+{
+  this->dataPtr->scenes.push_back(std::move(_scene));
+  this->dataPtr->loads.push_back(0.0);
+  return this->dataPtr->scenes.size() - 1;
+}
+
+//////////////////////////////////////////////////
+std::size_t ScenePlacement::SceneCount() const
+{
+  return this->dataPtr->scenes.size();
+}
+
+//////////////////////////////////////////////////
+rendering::ScenePtr ScenePlacement::SceneByIndex(std::size_t _index) const
+{
+  if (_index >= this->dataPtr->scenes.size())
+    return nullptr;
+  return this->dataPtr->scenes[_index];
+}
+
+//////////////////////////////////////////////////
+void ScenePlacement::Pin(const std::string &_sensorName, std::size_t _index)
+{
+  this->dataPtr->pins[_sensorName] = _index;
+}
+
+//////////////////////////////////////////////////
+void ScenePlacement::Unpin(const std::string &_sensorName)
+{
+  this->dataPtr->pins.erase(_sensorName);
+}
+
+//////////////////////////////////////////////////
+void ScenePlacement::SetCostFunction(CostFunction _cost)
+{
+  this->dataPtr->cost = std::move(_cost);
+}
+
+//////////////////////////////////////////////////
+double ScenePlacement::DefaultCost(const RenderingSensor &_sensor)
+{
+  const double pixels =
+      static_cast<double>(std::max<uint64_t>(_sensor.PixelCount(), 1u));
+  const double rate = _sensor.UpdateRate() > 0.0 ? _sensor.UpdateRate() : 1.0;
+  return pixels * rate;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::size_t> ScenePlacement::Assign(
+    const std::vector<RenderingSensor *> &_sensors)
+{
+  auto &scenes = this->dataPtr->scenes;
+  auto &loads = this->dataPtr->loads;
+  if (scenes.empty())
+  {
+    gzerr << "No scene to assign rendering sensors to." << std::endl;
+    return {};
+  }
+  std::fill(loads.begin(), loads.end(), 0.0);
+
+  std::vector<double> costs(_sensors.size());
+  for (std::size_t i = 0; i < _sensors.size(); ++i)
+  {
+    costs[i] = this->dataPtr->cost ? this->dataPtr->cost(*_sensors[i]) :
+        DefaultCost(*_sensors[i]);
+  }
+
+  std::vector<std::size_t> assigned(_sensors.size(), scenes.size());
+  for (std::size_t i = 0; i < _sensors.size(); ++i)
+  {
+    auto it = this->dataPtr->pins.find(_sensors[i]->Name());
+    if (it == this->dataPtr->pins.end())
+      continue;
+    if (it->second >= scenes.size())
+    {
+      gzerr << "Sensor [" << _sensors[i]->Name() << "] is pinned to scene ["
+            << it->second << "], but there are only [" << scenes.size()
+            << "] scenes. Assigning it automatically." << std::endl;
+      continue;
+    }
+    assigned[i] = it->second;
+    loads[it->second] += costs[i];
+  }
+
+  // Place the most costly sensors first, so the small ones even out the
+  // scenes at the end
+  std::vector<std::size_t> order(_sensors.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::stable_sort(order.begin(), order.end(),
+      [&costs](std::size_t _a, std::size_t _b)
+      {
+        return costs[_a] > costs[_b];
+      });
+  for (const auto i : order)
+  {
+    if (assigned[i] < scenes.size())
+      continue;
+    const auto lightest = static_cast<std::size_t>(std::distance(
+        loads.begin(), std::min_element(loads.begin(), loads.end())));
+    assigned[i] = lightest;
+    loads[lightest] += costs[i];
+  }
+
+  for (std::size_t i = 0; i < _sensors.size(); ++i)
+  {
+    if (_sensors[i]->Scene() != scenes[assigned[i]])
+      _sensors[i]->SetScene(scenes[assigned[i]]);
+  }
+  return assigned;
+}
+
+//////////////////////////////////////////////////
+double ScenePlacement::SceneLoad(std::size_t _index) const
+{
+  if (_index >= this->dataPtr->loads.size())
+    return 0.0;
+  return this->dataPtr->loads[_index];
+}
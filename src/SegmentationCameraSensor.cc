@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <gz/msgs/image.pb.h>
 
@@ -29,10 +30,14 @@
 #include <gz/transport/Node.hh>
 #include <gz/transport/Publisher.hh>
 
-#include "gz/sensors/RenderingEvents.hh"
+#include "gz/sensors/ImageWriter.hh"
 #include "gz/sensors/SegmentationCameraSensor.hh"
 #include "gz/sensors/SensorFactory.hh"
 
+#include "AlignedBuffer.hh"
+#include "MemorySize.hh"
+#include "LabelMapEncoding.hh"
+
 using namespace gz;
 using namespace sensors;
 
@@ -80,11 +85,56 @@ class gz::sensors::SegmentationCameraSensorPrivate
   /// \brief Topic suffix to publish the segmentation labels map
   public: const std::string topicLabelsMapSuffix = "/labels_map";
 
+  /// \brief Topic suffix to publish the run-length encoded labels map
+  public: const std::string topicLabelsMapRleSuffix = "/labels_map_rle";
+
   /// \brief Buffer contains the segmentation colored map data
-  public: uint8_t *segmentationColoredBuffer {nullptr};
+  public: AlignedBuffer<uint8_t> segmentationColoredBuffer;
+
+  /// \brief Latest colored map, either segmentationColoredBuffer or, when
+  /// frames are used in place, the segmentation camera's buffer.
+  public: const uint8_t *segmentationColoredFrame{nullptr};
+
+  /// \brief Latest labels map, either segmentationLabelsBuffer or, when
+  /// the camera renders labels and frames are used in place, the
+  /// segmentation camera's buffer. Null if the labels weren't needed.
+  public: const uint8_t *segmentationLabelsFrame{nullptr};
+
+  /// \brief True if the labels map of the frames has consumers.
+  public: bool needLabelsMap{true};
+
+  /// \brief Colors of the semantic labels seen in colored frames.
+  public: LabelColorTable labelColors;
+
+  /// \brief True to color the labels maps rendered by the camera with
+  /// labelColors instead of rendering the colored map.
+  public: bool colorsFromLabels{false};
+
+  /// \brief True if the last labels map had a label without a color, so
+  /// the next frame renders the colored map to learn it.
+  public: bool labelColorsMissing{false};
 
   /// \brief Buffer contains the segmentation labels map data
-  public: uint8_t *segmentationLabelsBuffer {nullptr};
+  public: AlignedBuffer<uint8_t> segmentationLabelsBuffer;
+
+  /// \brief Cropped and decimated colored map, unused for full frames.
+  public: std::vector<unsigned char> coloredRegionBuffer;
+
+  /// \brief Cropped and decimated labels map, unused for full frames.
+  public: std::vector<unsigned char> labelsRegionBuffer;
+
+  /// \brief True to publish 16 bit labels maps.
+  public: bool labelsMap16Bit{false};
+
+  /// \brief 16 bit labels of the latest frame, filled for the 16 bit and
+  /// run-length encoded labels maps.
+  public: std::vector<uint16_t> labels16Buffer;
+
+  /// \brief Publisher of the run-length encoded labels maps
+  public: transport::Node::Publisher labelsMapRlePublisher;
+
+  /// \brief Run-length encoded labels map message
+  public: msgs::Image labelsMapRleMsg;
 
   /// \brief Buffer contains the image data to be saved
   public: unsigned char *saveImageBuffer {nullptr};
@@ -96,9 +146,6 @@ class gz::sensors::SegmentationCameraSensorPrivate
   /// \brief Connection to the new segmentation frames data
   public: common::ConnectionPtr newSegmentationConnection {nullptr};
 
-  /// \brief Connection to the Manager's scene change event.
-  public: common::ConnectionPtr sceneChangeConnection {nullptr};
-
   /// \brief Just a mutex for thread safety
   public: std::mutex mutex;
 
@@ -136,20 +183,7 @@ SegmentationCameraSensor::SegmentationCameraSensor()
 }
 
 /////////////////////////////////////////////////
-SegmentationCameraSensor::~SegmentationCameraSensor()
-{
-  if (this->dataPtr->segmentationColoredBuffer)
-  {
-    delete [] this->dataPtr->segmentationColoredBuffer;
-    this->dataPtr->segmentationColoredBuffer = nullptr;
-  }
-
-  if (this->dataPtr->segmentationLabelsBuffer)
-  {
-    delete [] this->dataPtr->segmentationLabelsBuffer;
-    this->dataPtr->segmentationLabelsBuffer = nullptr;
-  }
-}
+SegmentationCameraSensor::~SegmentationCameraSensor() = default;
 
 /////////////////////////////////////////////////
 bool SegmentationCameraSensor::Init()
@@ -193,11 +227,9 @@ bool SegmentationCameraSensor::Load(const sdf::Sensor &_sdf)
   this->dataPtr->sdfSensor = _sdf;
 
   // Create the segmentation colored map image publisher
-  this->dataPtr->coloredMapPublisher =
-      this->dataPtr->node.Advertise<gz::msgs::Image>(
-          this->Topic() + this->dataPtr->topicColoredMapSuffix);
-
-  if (!this->dataPtr->coloredMapPublisher)
+  if (!this->Advertise<gz::msgs::Image>(this->dataPtr->node,
+      this->dataPtr->coloredMapPublisher,
+      this->Topic() + this->dataPtr->topicColoredMapSuffix))
   {
     gzerr << "Unable to create publisher on topic ["
       << this->Topic() << this->dataPtr->topicColoredMapSuffix << "].\n";
@@ -208,11 +240,9 @@ bool SegmentationCameraSensor::Load(const sdf::Sensor &_sdf)
     << this->Topic() << this->dataPtr->topicColoredMapSuffix << "]\n";
 
   // Create the segmentation labels map image publisher
-  this->dataPtr->labelsMapPublisher =
-      this->dataPtr->node.Advertise<gz::msgs::Image>(
-          this->Topic() + this->dataPtr->topicLabelsMapSuffix);
-
-  if (!this->dataPtr->labelsMapPublisher)
+  if (!this->Advertise<gz::msgs::Image>(this->dataPtr->node,
+      this->dataPtr->labelsMapPublisher,
+      this->Topic() + this->dataPtr->topicLabelsMapSuffix))
   {
     gzerr << "Unable to create publisher on topic ["
       << this->Topic() << this->dataPtr->topicLabelsMapSuffix << "].\n";
@@ -223,6 +253,15 @@ bool SegmentationCameraSensor::Load(const sdf::Sensor &_sdf)
     << "] advertised on [" << this->Topic()
     << this->dataPtr->topicLabelsMapSuffix << "]\n";
 
+  // Create the run-length encoded labels map publisher
+  if (!this->Advertise<gz::msgs::Image>(this->dataPtr->node,
+      this->dataPtr->labelsMapRlePublisher, this->LabelsMapRleTopic()))
+  {
+    gzerr << "Unable to create publisher on topic ["
+      << this->LabelsMapRleTopic() << "].\n";
+    return false;
+  }
+
   // TODO(anyone) Access the info topic from the parent class
   if (!this->AdvertiseInfo(this->Topic() + "/camera_info"))
     return false;
@@ -236,11 +275,6 @@ bool SegmentationCameraSensor::Load(const sdf::Sensor &_sdf)
     }
   }
 
-  this->dataPtr->sceneChangeConnection =
-    RenderingEvents::ConnectSceneChangeCallback(
-    std::bind(&SegmentationCameraSensor::SetScene, this,
-    std::placeholders::_1));
-
   this->dataPtr->initialized = true;
 
   return true;
@@ -256,6 +290,10 @@ void SegmentationCameraSensor::SetScene(
   {
     RenderingSensor::SetScene(_scene);
 
+    // Colors are assigned by the scene's segmentation cameras
+    this->dataPtr->labelColors.Clear();
+    this->dataPtr->labelColorsMissing = false;
+
     if (this->dataPtr->initialized)
       this->CreateCamera();
   }
@@ -387,6 +425,16 @@ bool SegmentationCameraSensor::CreateCamera()
     this->dataPtr->image = this->dataPtr->rgbCamera->CreateImage();
   }
 
+  // Size the map buffers up front so the first frame doesn't allocate
+  const std::size_t mapSize = rendering::PixelUtil::MemorySize(
+      rendering::PF_R8G8B8, width, height);
+  this->dataPtr->segmentationColoredBuffer.SetMemory(this->BufferMemory());
+  this->dataPtr->segmentationLabelsBuffer.SetMemory(this->BufferMemory());
+  this->dataPtr->segmentationColoredBuffer.Reserve(mapSize);
+  this->dataPtr->segmentationLabelsBuffer.Reserve(mapSize);
+  this->dataPtr->segmentationColoredFrame = nullptr;
+  this->dataPtr->segmentationLabelsFrame = nullptr;
+
   // Connection to receive the segmentation buffer
   this->dataPtr->newSegmentationConnection =
       this->dataPtr->camera->ConnectNewSegmentationFrame(
@@ -413,17 +461,79 @@ void SegmentationCameraSensor::OnNewSegmentationFrame(const uint8_t * _data,
 
   unsigned int bufferSize = _width * _height * _channels;
 
-  if (!this->dataPtr->segmentationColoredBuffer)
-    this->dataPtr->segmentationColoredBuffer = new uint8_t[bufferSize];
+  // Without a colored map, the camera renders the labels map directly
+  if (!this->dataPtr->camera->IsColoredMap())
+  {
+    this->dataPtr->segmentationColoredFrame = nullptr;
+    if (this->ZeroCopyFrames())
+    {
+      this->dataPtr->segmentationLabelsFrame = _data;
+    }
+    else
+    {
+      this->dataPtr->segmentationLabelsBuffer.Resize(bufferSize);
+      memcpy(this->dataPtr->segmentationLabelsBuffer.Data(), _data,
+          bufferSize);
+      this->dataPtr->segmentationLabelsFrame =
+          this->dataPtr->segmentationLabelsBuffer.Data();
+    }
 
-  if (!this->dataPtr->segmentationLabelsBuffer)
-    this->dataPtr->segmentationLabelsBuffer = new uint8_t[bufferSize];
+    // Color the labels with the learned colors. A frame with a new label
+    // has no colored map, the next one renders it.
+    if (this->dataPtr->colorsFromLabels)
+    {
+      this->dataPtr->segmentationColoredBuffer.Resize(bufferSize);
+      if (this->dataPtr->labelColors.Color(
+          this->dataPtr->segmentationLabelsFrame,
+          static_cast<std::size_t>(_width) * _height,
+          this->dataPtr->segmentationColoredBuffer.Data()))
+      {
+        this->dataPtr->segmentationColoredFrame =
+            this->dataPtr->segmentationColoredBuffer.Data();
+      }
+      else
+      {
+        this->dataPtr->labelColorsMissing = true;
+      }
+    }
+    return;
+  }
 
-  memcpy(this->dataPtr->segmentationColoredBuffer, _data, bufferSize);
+  if (this->ZeroCopyFrames())
+  {
+    this->dataPtr->segmentationColoredFrame = _data;
+  }
+  else
+  {
+    this->dataPtr->segmentationColoredBuffer.Resize(bufferSize);
+    memcpy(this->dataPtr->segmentationColoredBuffer.Data(), _data,
+        bufferSize);
+    this->dataPtr->segmentationColoredFrame =
+        this->dataPtr->segmentationColoredBuffer.Data();
+  }
 
-  // Convert the colored map to labels map
-  this->dataPtr->camera->LabelMapFromColoredBuffer(
-    this->dataPtr->segmentationLabelsBuffer);
+  // Convert the colored map to labels map, if anyone needs it
+  this->dataPtr->segmentationLabelsFrame = nullptr;
+  if (this->dataPtr->needLabelsMap)
+  {
+    this->dataPtr->segmentationLabelsBuffer.Resize(bufferSize);
+    this->dataPtr->camera->LabelMapFromColoredBuffer(
+      this->dataPtr->segmentationLabelsBuffer.Data());
+    this->dataPtr->segmentationLabelsFrame =
+        this->dataPtr->segmentationLabelsBuffer.Data();
+
+    // Semantic colors don't change, so later frames can be colored from
+    // their labels
+    if (this->dataPtr->camera->Type() ==
+        rendering::SegmentationType::ST_SEMANTIC)
+    {
+      this->dataPtr->labelColors.Learn(
+          this->dataPtr->segmentationLabelsFrame,
+          this->dataPtr->segmentationColoredFrame,
+          static_cast<std::size_t>(_width) * _height);
+      this->dataPtr->labelColorsMissing = false;
+    }
+  }
 }
 
 //////////////////////////////////////////////////
@@ -431,6 +541,7 @@ bool SegmentationCameraSensor::Update(
   const std::chrono::steady_clock::duration &_now)
 {
   GZ_PROFILE("SegmentationCameraSensor::Update");
+  this->ApplySceneChanges();
   if (!this->dataPtr->initialized)
   {
     gzerr << "Not initialized, update ignored.\n";
@@ -443,16 +554,16 @@ bool SegmentationCameraSensor::Update(
     return false;
   }
 
-  if (this->HasInfoConnections())
-  {
-    // publish the camera info message
-    this->PublishInfo(_now);
-  }
+  // publish the camera info message, if it has subscribers
+  this->PublishInfo(_now);
 
   // don't render if there are no subscribers nor saving
   if (!this->dataPtr->coloredMapPublisher.HasConnections() &&
     !this->dataPtr->labelsMapPublisher.HasConnections() &&
-    !this->dataPtr->saveSamples)
+    !this->dataPtr->labelsMapRlePublisher.HasConnections() &&
+    !this->dataPtr->saveSamples &&
+    !this->HasSharedMemoryConnections() &&
+    !this->Recording())
   {
     return false;
   }
@@ -465,60 +576,205 @@ bool SegmentationCameraSensor::Update(
       this->dataPtr->camera->WorldPose());
   }
 
-  // Actual render
-  this->Render();
+  // Each map is only generated for its consumers. Shared memory and
+  // recordings take both.
+  const bool needBoth = this->dataPtr->saveSamples ||
+      this->HasSharedMemoryConnections() || this->Recording();
+  const bool needColored = needBoth ||
+      this->dataPtr->coloredMapPublisher.HasConnections() ||
+      this->dataPtr->imageEvent.ConnectionCount() > 0u;
+  this->dataPtr->needLabelsMap = needBoth ||
+      this->dataPtr->labelsMapPublisher.HasConnections() ||
+      this->dataPtr->labelsMapRlePublisher.HasConnections();
+
+  // When both maps are needed, semantic colored maps are colored from the
+  // rendered labels once the colors of the labels in view are learned,
+  // which skips converting each pixel's color back to its label
+  const bool colorsFromLabels = needColored &&
+      this->dataPtr->needLabelsMap &&
+      this->dataPtr->camera->Type() ==
+      rendering::SegmentationType::ST_SEMANTIC &&
+      !this->dataPtr->labelColors.Empty() &&
+      !this->dataPtr->labelColorsMissing;
 
-  if (this->dataPtr->saveSamples)
+  // Actual render
+  std::chrono::steady_clock::duration frameTime;
+  if (!this->Render(_now, frameTime, [this, needColored, colorsFromLabels]()
+      {
+        if (this->dataPtr->saveSamples)
+        {
+          // Copy the rgb camera image data
+          this->dataPtr->rgbCamera->Copy(this->dataPtr->image);
+          this->dataPtr->saveImageBuffer =
+              this->dataPtr->image.Data<unsigned char>();
+        }
+
+        // The frame that was read back is complete and the next one isn't
+        // rendered yet, so the next frame renders the colored map only if
+        // it has consumers. Without it, the camera renders labels, which
+        // also skips the conversion from colors to labels.
+        this->dataPtr->camera->EnableColoredMap(
+            needColored && !colorsFromLabels);
+        this->dataPtr->colorsFromLabels = colorsFromLabels;
+      }))
   {
-    // Copy the rgb camera image data
-    this->dataPtr->rgbCamera->Copy(this->dataPtr->image);
-    this->dataPtr->saveImageBuffer = this->dataPtr->image.Data<unsigned char>();
+    // The first frame in async readback mode isn't complete yet
+    return true;
   }
 
-  if (!this->dataPtr->segmentationColoredBuffer ||
-    !this->dataPtr->segmentationLabelsBuffer)
+  if (!this->dataPtr->segmentationColoredFrame &&
+    !this->dataPtr->segmentationLabelsFrame)
     return false;
 
   auto width = this->dataPtr->camera->ImageWidth();
   auto height = this->dataPtr->camera->ImageHeight();
 
   // create colored map message
-  this->dataPtr->coloredMapMsg.set_width(width);
-  this->dataPtr->coloredMapMsg.set_height(height);
   // format
-  this->dataPtr->coloredMapMsg.set_step(
-    width * rendering::PixelUtil::BytesPerPixel(rendering::PF_R8G8B8));
   this->dataPtr->coloredMapMsg.set_pixel_format_type(
     msgs::PixelFormatType::RGB_INT8);
   // time stamp
   auto stamp = this->dataPtr->coloredMapMsg.mutable_header()->mutable_stamp();
-  *stamp = msgs::Convert(_now);
+  *stamp = msgs::Convert(frameTime);
   auto frame = this->dataPtr->coloredMapMsg.mutable_header()->add_data();
   frame->set_key("frame_id");
   frame->add_value(this->FrameId());
 
-  this->dataPtr->labelsMapMsg.CopyFrom(this->dataPtr->coloredMapMsg);
+  // Only the header is shared, copying the message would copy its pixels
+  *this->dataPtr->labelsMapMsg.mutable_header() =
+      this->dataPtr->coloredMapMsg.header();
+  this->dataPtr->labelsMapMsg.set_pixel_format_type(
+      msgs::PixelFormatType::RGB_INT8);
 
   // Protect the data being modified by the segmentation buffers
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
+  // Both maps share the region of interest and decimation. Either may be
+  // missing, for a frame rendered before its consumers appeared.
+  const std::size_t bytesPerPixel =
+      rendering::PixelUtil::BytesPerPixel(rendering::PF_R8G8B8);
+  unsigned int mapWidth = width;
+  unsigned int mapHeight = height;
+  const unsigned char *coloredData = nullptr;
+  if (this->dataPtr->segmentationColoredFrame)
+  {
+    coloredData = this->ApplyRegionOfInterest(
+        this->dataPtr->segmentationColoredFrame, mapWidth, mapHeight,
+        bytesPerPixel, this->dataPtr->coloredRegionBuffer);
+  }
+  const unsigned char *labelsData = nullptr;
+  if (this->dataPtr->segmentationLabelsFrame)
+  {
+    mapWidth = width;
+    mapHeight = height;
+    labelsData = this->ApplyRegionOfInterest(
+        this->dataPtr->segmentationLabelsFrame, mapWidth, mapHeight,
+        bytesPerPixel, this->dataPtr->labelsRegionBuffer);
+  }
+  const std::size_t size = rendering::PixelUtil::MemorySize(
+      rendering::PF_R8G8B8, mapWidth, mapHeight);
+  for (auto *msg : {&this->dataPtr->coloredMapMsg,
+        &this->dataPtr->labelsMapMsg})
+  {
+    msg->set_width(mapWidth);
+    msg->set_height(mapHeight);
+    msg->set_step(mapWidth * bytesPerPixel);
+  }
+
+  // Pixels only go through protobuf if someone receives the message
+  const bool publishColored = coloredData &&
+      (this->dataPtr->coloredMapPublisher.HasConnections() ||
+      this->dataPtr->imageEvent.ConnectionCount() > 0u);
+  const bool publishLabels = labelsData &&
+      this->dataPtr->labelsMapPublisher.HasConnections();
+  const bool publishRuns = labelsData &&
+      this->dataPtr->labelsMapRlePublisher.HasConnections();
+
+  // The 16 bit labels replace the 3 channel labels map and are encoded
+  std::size_t labelsSize = size;
+  if (labelsData && (this->dataPtr->labelsMap16Bit || publishRuns))
+  {
+    const std::size_t pixels =
+        static_cast<std::size_t>(mapWidth) * mapHeight;
+    this->dataPtr->labels16Buffer.resize(pixels);
+    LabelsMapTo16Bit(labelsData, pixels,
+        this->dataPtr->camera->Type() ==
+        rendering::SegmentationType::ST_PANOPTIC,
+        this->dataPtr->labels16Buffer.data());
+
+    if (publishRuns)
+    {
+      this->dataPtr->labelsMapRleMsg.set_width(mapWidth);
+      this->dataPtr->labelsMapRleMsg.set_height(mapHeight);
+      this->dataPtr->labelsMapRleMsg.set_step(mapWidth * sizeof(uint16_t));
+      this->dataPtr->labelsMapRleMsg.set_pixel_format_type(
+          msgs::PixelFormatType::L_INT16);
+      *this->dataPtr->labelsMapRleMsg.mutable_header() =
+          this->dataPtr->coloredMapMsg.header();
+      auto *entry = this->dataPtr->labelsMapRleMsg.mutable_header()
+          ->add_data();
+      entry->set_key("format");
+      entry->add_value("rle");
+      EncodeLabelRuns(this->dataPtr->labels16Buffer.data(), pixels,
+          *this->dataPtr->labelsMapRleMsg.mutable_data());
+      this->Publish(this->dataPtr->labelsMapRlePublisher,
+          this->dataPtr->labelsMapRleMsg);
+    }
+
+    if (this->dataPtr->labelsMap16Bit)
+    {
+      labelsData = reinterpret_cast<const unsigned char *>(
+          this->dataPtr->labels16Buffer.data());
+      labelsSize = pixels * sizeof(uint16_t);
+      this->dataPtr->labelsMapMsg.set_step(mapWidth * sizeof(uint16_t));
+      this->dataPtr->labelsMapMsg.set_pixel_format_type(
+          msgs::PixelFormatType::L_INT16);
+    }
+  }
+
   // segmentation colored map data
-  this->dataPtr->coloredMapMsg.set_data(
-    this->dataPtr->segmentationColoredBuffer,
-    rendering::PixelUtil::MemorySize(rendering::PF_R8G8B8,
-    width, height));
+  if (publishColored)
+  {
+    this->dataPtr->coloredMapMsg.set_data(coloredData, size);
+  }
 
   // segmentation labels map data
-  this->dataPtr->labelsMapMsg.set_data(this->dataPtr->segmentationLabelsBuffer,
-      rendering::PixelUtil::MemorySize(rendering::PF_R8G8B8,
-      width, height));
+  if (publishLabels)
+  {
+    this->dataPtr->labelsMapMsg.set_data(labelsData, labelsSize);
+  }
+
+  // Stream 0 is the colored map, stream 1 the labels map
+  if (coloredData)
+  {
+    this->WriteSharedMemoryImage(
+        this->Topic() + this->dataPtr->topicColoredMapSuffix,
+        this->dataPtr->coloredMapMsg, coloredData, size);
+    this->RecordFrame(0u, this->dataPtr->coloredMapMsg, coloredData, size);
+  }
+  if (labelsData)
+  {
+    this->WriteSharedMemoryImage(
+        this->Topic() + this->dataPtr->topicLabelsMapSuffix,
+        this->dataPtr->labelsMapMsg, labelsData, labelsSize);
+    this->RecordFrame(1u, this->dataPtr->labelsMapMsg, labelsData,
+        labelsSize);
+  }
 
   // Publish
-  this->dataPtr->coloredMapPublisher.Publish(this->dataPtr->coloredMapMsg);
-  this->dataPtr->labelsMapPublisher.Publish(this->dataPtr->labelsMapMsg);
+  if (publishColored)
+  {
+    this->Publish(this->dataPtr->coloredMapPublisher,
+        this->dataPtr->coloredMapMsg);
+  }
+  if (publishLabels)
+  {
+    this->Publish(this->dataPtr->labelsMapPublisher,
+        this->dataPtr->labelsMapMsg);
+  }
 
   // Trigger callbacks.
-  if (this->dataPtr->imageEvent.ConnectionCount() > 0u)
+  if (coloredData && this->dataPtr->imageEvent.ConnectionCount() > 0u)
   {
     try
     {
@@ -531,7 +787,7 @@ bool SegmentationCameraSensor::Update(
   }
 
   // Save a sample (image & colored map & labels map)
-  if (this->dataPtr->saveSamples)
+  if (this->dataPtr->saveSamples && coloredData && labelsData)
     this->dataPtr->SaveSample();
 
   return true;
@@ -560,6 +816,23 @@ common::ConnectionPtr SegmentationCameraSensor::ConnectImageCallback(
   return this->dataPtr->imageEvent.Connect(_callback);
 }
 
+//////////////////////////////////////////////////
+SensorMemoryUsage SegmentationCameraSensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage = CameraSensor::MemoryUsage();
+  usage["segmentation_buffer"] =
+      MemorySize(this->dataPtr->segmentationColoredBuffer) +
+      MemorySize(this->dataPtr->segmentationLabelsBuffer) +
+      MemorySize(this->dataPtr->labels16Buffer);
+  usage["region_buffer"] += MemorySize(this->dataPtr->coloredRegionBuffer) +
+      MemorySize(this->dataPtr->labelsRegionBuffer);
+  usage["image"] += this->dataPtr->image.MemorySize();
+  usage["image_msg"] += MemorySize(this->dataPtr->coloredMapMsg) +
+      MemorySize(this->dataPtr->labelsMapMsg) +
+      MemorySize(this->dataPtr->labelsMapRleMsg);
+  return usage;
+}
+
 //////////////////////////////////////////////////
 bool SegmentationCameraSensor::HasConnections() const
 {
@@ -567,10 +840,33 @@ bool SegmentationCameraSensor::HasConnections() const
       this->dataPtr->coloredMapPublisher.HasConnections()) ||
       (this->dataPtr->labelsMapPublisher &&
       this->dataPtr->labelsMapPublisher.HasConnections()) ||
+      (this->dataPtr->labelsMapRlePublisher &&
+      this->dataPtr->labelsMapRlePublisher.HasConnections()) ||
       this->dataPtr->imageEvent.ConnectionCount() > 0u ||
+      this->HasSharedMemoryConnections() ||
+      this->Recording() ||
       this->HasInfoConnections();
 }
 
+//////////////////////////////////////////////////
+void SegmentationCameraSensor::SetLabelsMap16Bit(bool _enabled)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->labelsMap16Bit = _enabled;
+}
+
+//////////////////////////////////////////////////
+bool SegmentationCameraSensor::LabelsMap16Bit() const
+{
+  return this->dataPtr->labelsMap16Bit;
+}
+
+//////////////////////////////////////////////////
+std::string SegmentationCameraSensor::LabelsMapRleTopic() const
+{
+  return this->Topic() + this->dataPtr->topicLabelsMapRleSuffix;
+}
+
 //////////////////////////////////////////////////
 bool SegmentationCameraSensorPrivate::SaveSample()
 {
@@ -609,30 +905,28 @@ bool SegmentationCameraSensorPrivate::SaveSample()
   std::string labelsName = "labels_" + saveCounterString + ".png";
   std::string rgbImageName = "image_" + saveCounterString + ".png";
 
-  // Save rgb image
-  gz::common::Image rgbImage;
-  rgbImage.SetFromData(this->saveImageBuffer,
-    width, height, gz::common::Image::RGB_INT8);
+  // Encoding and writing the files happen on the image writer's threads
+  auto &writer = ImageWriter::Instance();
+  const std::size_t size = static_cast<std::size_t>(width) * height * 3u;
 
-  rgbImage.SavePNG(
-      gz::common::joinPaths(this->saveImageFolder, rgbImageName));
+  // Save rgb image
+  bool result = writer.Write(
+      gz::common::joinPaths(this->saveImageFolder, rgbImageName),
+      this->saveImageBuffer, size, width, height,
+      gz::common::Image::RGB_INT8);
 
   // Save colored map
-  gz::common::Image localColoredImage;
-  localColoredImage.SetFromData(this->segmentationColoredBuffer,
-    width, height, gz::common::Image::RGB_INT8);
-
-  localColoredImage.SavePNG(
-      gz::common::joinPaths(this->saveColoredMapsFolder, coloredName));
+  result = writer.Write(
+      gz::common::joinPaths(this->saveColoredMapsFolder, coloredName),
+      this->segmentationColoredFrame, size, width, height,
+      gz::common::Image::RGB_INT8) && result;
 
   // Save labels map
-  gz::common::Image localLabelsImage;
-  localLabelsImage.SetFromData(this->segmentationLabelsBuffer,
-    width, height, gz::common::Image::RGB_INT8);
-
-  localLabelsImage.SavePNG(
-      gz::common::joinPaths(this->saveLabelsMapsFolder, labelsName));
+  result = writer.Write(
+      gz::common::joinPaths(this->saveLabelsMapsFolder, labelsName),
+      this->segmentationLabelsFrame, size, width, height,
+      gz::common::Image::RGB_INT8) && result;
 
   ++this->saveCounter;
-  return true;
+  return result;
 }
@@ -22,25 +22,48 @@
 #endif
 #include <gz/msgs/double.pb.h>
 #include <gz/msgs/performance_sensor_metrics.pb.h>
+#include <gz/msgs/statistic.pb.h>
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
 
+#include "gz/sensors/Noise.hh"
 #include "gz/sensors/Sensor.hh"
 
+#include <google/protobuf/arena.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
 #include <chrono>
+#include <functional>
+#include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <gz/common/Console.hh>
 #include <gz/common/Profiler.hh>
+#include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
 #include <gz/transport/TopicUtils.hh>
 
+#include "InputInterpolation.hh"
+#include "SensorPublisher.hh"
+#include "SensorSchedule.hh"
+#include "TraceRecorder.hh"
+
 using namespace gz::sensors;
 
 class gz::sensors::SensorPrivate
 {
+  /// \brief Constructor
+  public: SensorPrivate();
+
   /// \brief Populates fields from a <sensor> DOM
   public: bool PopulateFromSDF(const sdf::Sensor &_sdf);
 
@@ -50,8 +73,53 @@ class gz::sensors::SensorPrivate
   public: bool SetTopic(const std::string &_topic);
 
   /// \brief Publishes information about the performance of the sensor.
+  /// \param[in] _sensor The sensor.
   /// \param[in] _now Current simulation time.
-  public: void PublishMetrics(const std::chrono::duration<double> &_now);
+  public: void PublishMetrics(const Sensor &_sensor,
+              const std::chrono::duration<double> &_now);
+
+  /// \brief Publishes the memory usage of the sensor.
+  /// \param[in] _sensor The sensor.
+  public: void PublishMemoryUsage(const Sensor &_sensor);
+
+  /// \brief Publishes the execution time statistics of the sensor.
+  public: void PublishExecutionTime();
+
+  /// \brief Publishes the latency statistics of the sensor.
+  public: void PublishLatency();
+
+  /// \brief Add a measured update duration to the execution time
+  /// statistics.
+  /// \param[in] _duration Wall-clock duration of the update.
+  public: void RecordExecutionTime(
+              const std::chrono::steady_clock::duration &_duration);
+
+  /// \brief Add a measured duration to statistics. The caller locks
+  /// executionTimeMutex.
+  /// \param[in,out] _stats Statistics to update.
+  /// \param[in] _duration Measured duration.
+  public: static void AddSample(SensorExecutionTime &_stats,
+              const std::chrono::steady_clock::duration &_duration);
+
+  /// \brief Add statistics to a message. Durations are in seconds and
+  /// histogram buckets are named after their upper bound in microseconds.
+  /// \param[in,out] _msg Message to add the statistics to.
+  /// \param[in] _stats Statistics to add.
+  /// \param[in] _prefix Prefix of the statistic names.
+  public: static void AddStatistics(msgs::StatisticsGroup &_msg,
+              const SensorExecutionTime &_stats, const std::string &_prefix);
+
+  /// \brief Number of latency stages.
+  public: static constexpr std::size_t kLatencyStages = 5u;
+
+  /// \brief Names of the latency stages, used in statistic names.
+  public: static constexpr std::array<const char *, kLatencyStages>
+              kLatencyStageNames{"update", "render", "readback", "fill",
+                                 "publish"};
+
+  /// \brief Check whether latencies are being measured.
+  /// \return True if metrics or latency stamps are enabled.
+  public: bool MeasureLatency() const;
 
   /// \brief Set the rate on which the sensor should publish its data. This
   /// method doesn't allow to set a higher rate than what is in the SDF.
@@ -61,11 +129,19 @@ class gz::sensors::SensorPrivate
   /// \return True if a valid topic was set.
   public: void SetRate(const gz::msgs::Double &_rate);
 
+  /// \brief Publish metrics, end the update of the bundle and advance the
+  /// next update time after the sensor generated data.
+  /// \param[in] _sensor The sensor.
+  /// \param[in] _now Current time.
+  /// \param[in] _force True if the update was forced.
+  public: void FinishUpdate(const Sensor &_sensor,
+              const std::chrono::steady_clock::duration &_now, bool _force);
+
   /// \brief id given to sensor when constructed
   public: SensorId id;
 
   /// \brief Counter used to generate unique sensor identifiers.
-  public: static SensorId idCounter;
+  public: static std::atomic<SensorId> idCounter;
 
   /// \brief name given to sensor when loaded
   public: std::string name;
@@ -82,18 +158,6 @@ class gz::sensors::SensorPrivate
   /// \brief Flag to enable publishing performance metrics.
   public: bool enableMetrics{false};
 
-  /// \brief How many times the sensor will generate data per second (value from
-  /// SDF.
-  public: double sdfUpdateRate = 0.0;
-
-  /// \brief How many times the sensor will generate data per second (currently
-  /// used value).
-  public: double updateRate = 0.0;
-
-  /// \brief What sim time should this sensor update at
-  public: std::chrono::steady_clock::duration nextUpdateTime
-    {std::chrono::steady_clock::duration::zero()};
-
   /// \brief Last steady clock time reading from last Update call.
   public: std::chrono::time_point<std::chrono::steady_clock> lastRealTime;
 
@@ -103,9 +167,47 @@ class gz::sensors::SensorPrivate
   /// \brief Transport node.
   public: gz::transport::Node node;
 
+  /// \brief Update schedule of the sensor.
+  public: SensorSchedule schedule;
+
+  /// \brief Output side of the sensor.
+  public: SensorPublisher publisher;
+
   /// \brief Publishes the PerformanceSensorMetrics message.
   public: gz::transport::Node::Publisher performanceSensorMetricsPub;
 
+  /// \brief Publishes the execution time statistics.
+  public: gz::transport::Node::Publisher executionTimePub;
+
+  /// \brief Execution time statistics.
+  public: SensorExecutionTime executionTime;
+
+  /// \brief Protects executionTime and latency, which may be updated
+  /// from a worker thread of the manager.
+  public: mutable std::mutex executionTimeMutex;
+
+  /// \brief True to add latency stamps to the message headers.
+  public: bool latencyStamps{false};
+
+  /// \brief Steady clock time each stage of the current update was
+  /// reached at, the clock's epoch if it wasn't. They're only used by the
+  /// thread updating the sensor.
+  public: std::array<std::chrono::steady_clock::time_point, kLatencyStages>
+              stageTimes{};
+
+  /// \brief System clock time the current update started at, used to
+  /// convert stageTimes to wall-clock stamps.
+  public: std::chrono::system_clock::time_point updateWallTime;
+
+  /// \brief Latency statistics of each stage.
+  public: std::array<SensorExecutionTime, kLatencyStages> latency;
+
+  /// \brief Publishes the latency statistics.
+  public: gz::transport::Node::Publisher latencyPub;
+
+  /// \brief Publishes the memory usage.
+  public: gz::transport::Node::Publisher memoryUsagePub;
+
   /// \brief SDF element with sensor information.
   public: sdf::ElementPtr sdf = nullptr;
 
@@ -120,11 +222,67 @@ class gz::sensors::SensorPrivate
   /// \brief frame id
   public: std::string frame_id;
 
-  /// \brief If sensor is active or not.
-  public: bool active = true;
+  /// \brief Get the next number of a sequence. The first number is zero.
+  /// \param[in] _seqKey Name of the sequence.
+  /// \return The sequence number.
+  public: uint64_t NextSequence(const std::string &_seqKey);
+
+  /// \brief Set the first value of a header entry to a number.
+  /// \param[in,out] _data Header entry.
+  /// \param[in] _value Value to set.
+  public: static void SetValue(gz::msgs::Header::Map *_data,
+              uint64_t _value);
+
+  /// \brief True to skip generating data without subscribers.
+  public: bool lazyUpdate{false};
+
+  /// \brief True to update the noise state on skipped lazy updates.
+  public: bool lazyNoiseUpdate{false};
+
+  /// \brief Size of the first block of the message arena.
+  public: static constexpr std::size_t kArenaBlockSize = 16384u;
+
+  /// \brief First block of the message arena, kept across resets.
+  public: std::vector<char> arenaBlock;
+
+  /// \brief Arena for temporary outgoing messages, null if disabled.
+  public: std::unique_ptr<google::protobuf::Arena> messageArena;
+
+  /// \brief Seed of the noise models, valid if hasNoiseSeed is true.
+  public: uint64_t noiseSeed{0u};
+
+  /// \brief True if SetNoiseSeed() has been called.
+  public: bool hasNoiseSeed{false};
+
+  /// \brief Noise models registered with RegisterNoise().
+  public: std::map<SensorNoiseType, std::weak_ptr<Noise>> noises;
+
+  /// \brief Kind of memory of the large buffers of the sensor.
+  public: SensorBufferMemory bufferMemory{SensorBufferMemory::DEFAULT};
+
+  /// \brief True to generate the samples due between updates from
+  /// interpolated inputs.
+  public: bool interpolateInputs{false};
+
+  /// \brief Inputs saved at the previous update, when interpolating.
+  public: SensorState prevInputs;
+
+  /// \brief Inputs saved at the current update, when interpolating.
+  public: SensorState currInputs;
+
+  /// \brief Time of the previous update, negative when no inputs were
+  /// saved.
+  public: std::chrono::steady_clock::duration inputsTime{-1};
 };
 
-SensorId SensorPrivate::idCounter = 0;
+std::atomic<SensorId> SensorPrivate::idCounter{0};
+
+//////////////////////////////////////////////////
+SensorPrivate::SensorPrivate()
+  : id(++idCounter), schedule(this->id),
+    publisher(this->node, this->name, this->topic, this->schedule)
+{
+}
 
 //////////////////////////////////////////////////
 bool SensorPrivate::PopulateFromSDF(const sdf::Sensor &_sdf)
@@ -163,6 +321,56 @@ bool SensorPrivate::PopulateFromSDF(const sdf::Sensor &_sdf)
     {
       this->frame_id = this->name;
     }
+
+    if (element->HasElement("gz_output_delay"))
+    {
+      const double delay = element->Get<double>("gz_output_delay");
+      if (delay >= 0.0)
+      {
+        this->publisher.SetDelay(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(delay)));
+      }
+      else
+      {
+        gzwarn << "Ignoring negative <gz_output_delay> [" << delay
+               << "] of sensor [" << this->name << "]." << std::endl;
+      }
+    }
+
+    if (element->HasElement("gz_buffer_memory"))
+    {
+      const auto memory = element->Get<std::string>("gz_buffer_memory");
+      if (memory == "default")
+      {
+        this->bufferMemory = SensorBufferMemory::DEFAULT;
+      }
+      else if (memory == "huge_pages")
+      {
+        this->bufferMemory = SensorBufferMemory::HUGE_PAGES;
+      }
+      else if (memory == "pinned")
+      {
+        this->bufferMemory = SensorBufferMemory::PINNED;
+      }
+      else
+      {
+        gzwarn << "Ignoring unknown <gz_buffer_memory> [" << memory
+               << "] of sensor [" << this->name << "]." << std::endl;
+      }
+    }
+
+    if (element->HasElement("gz_raw_payload"))
+    {
+      this->publisher.SetRawPayloadOutput(
+          element->Get<bool>("gz_raw_payload"));
+    }
+
+    if (element->HasElement("gz_interpolate_inputs"))
+    {
+      this->interpolateInputs =
+          element->Get<bool>("gz_interpolate_inputs");
+    }
   }
 
   // Try resolving the pose first, and only use the raw pose if that fails
@@ -173,7 +381,7 @@ bool SensorPrivate::PopulateFromSDF(const sdf::Sensor &_sdf)
     this->pose = _sdf.RawPose();
   }
 
-  this->sdfUpdateRate = this->updateRate = _sdf.UpdateRate();
+  this->schedule.SetSdfRate(_sdf.UpdateRate());
 
   this->enableMetrics = _sdf.EnableMetrics();
   return true;
@@ -183,13 +391,12 @@ bool SensorPrivate::PopulateFromSDF(const sdf::Sensor &_sdf)
 Sensor::Sensor() :
   dataPtr(new SensorPrivate)
 {
-  this->dataPtr->id = (++this->dataPtr->idCounter);
 }
 
 //////////////////////////////////////////////////
 bool Sensor::Init()
 {
-  this->dataPtr->nextUpdateTime = std::chrono::steady_clock::duration::zero();
+  this->dataPtr->schedule.Reset();
   return true;
 }
 
@@ -211,8 +418,16 @@ bool Sensor::Load(const sdf::Sensor &_sdf)
 
   const auto rateTopic = sensorTopic + "/set_rate";
 
-  if (!this->dataPtr->node.Advertise(rateTopic,
-    &SensorPrivate::SetRate, this->dataPtr.get()))
+  auto advertise = [this, rateTopic]()
+  {
+    return this->dataPtr->node.Advertise(rateTopic,
+        &SensorPrivate::SetRate, this->dataPtr.get());
+  };
+  if (this->dataPtr->publisher.AdvertiseDeferred())
+  {
+    this->DeferAdvertisement(rateTopic, std::move(advertise));
+  }
+  else if (!advertise())
   {
     gzerr << "Unable to create service server on topic["
            << rateTopic << "].\n";
@@ -237,6 +452,44 @@ bool Sensor::Load(sdf::ElementPtr _sdf)
   return this->Load(sdfSensor);
 }
 
+//////////////////////////////////////////////////
+bool Sensor::Reconfigure(const sdf::Sensor &_sdf)
+{
+  const sdf::Sensor &loaded = this->dataPtr->sdfSensor;
+  if (_sdf.Type() != loaded.Type())
+  {
+    gzerr << "Unable to reconfigure sensor [" << this->Name() << "] of type ["
+          << loaded.TypeStr() << "] with settings of type ["
+          << _sdf.TypeStr() << "].\n";
+    return false;
+  }
+
+  if (_sdf.Topic() != loaded.Topic())
+  {
+    gzerr << "The topic of sensor [" << this->Name() << "] can't be "
+          << "reconfigured, the sensor must be created again.\n";
+    return false;
+  }
+
+  if (!gz::math::equal(_sdf.UpdateRate(), loaded.UpdateRate()))
+  {
+    this->dataPtr->schedule.SetSdfRate(_sdf.UpdateRate());
+    this->SetUpdateRate(_sdf.UpdateRate());
+  }
+
+  if (_sdf.RawPose() != loaded.RawPose())
+  {
+    auto semPose = _sdf.SemanticPose();
+    sdf::Errors errors = semPose.Resolve(this->dataPtr->pose);
+    if (!errors.empty())
+      this->dataPtr->pose = _sdf.RawPose();
+  }
+
+  this->dataPtr->enableMetrics = _sdf.EnableMetrics();
+  this->dataPtr->sdfSensor = _sdf;
+  return true;
+}
+
 //////////////////////////////////////////////////
 sdf::ElementPtr Sensor::SDF() const
 {
@@ -306,15 +559,275 @@ void Sensor::SetEnableMetrics(bool _enableMetrics)
   this->dataPtr->enableMetrics = _enableMetrics;
 }
 
+//////////////////////////////////////////////////
+SensorExecutionTime Sensor::ExecutionTime() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->executionTimeMutex);
+  return this->dataPtr->executionTime;
+}
+
+//////////////////////////////////////////////////
+void Sensor::ResetExecutionTime()
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->executionTimeMutex);
+  this->dataPtr->executionTime = SensorExecutionTime();
+  this->dataPtr->latency.fill(SensorExecutionTime());
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetLatencyStamps(bool _enable)
+{
+  this->dataPtr->latencyStamps = _enable;
+}
+
+//////////////////////////////////////////////////
+bool Sensor::LatencyStamps() const
+{
+  return this->dataPtr->latencyStamps;
+}
+
+//////////////////////////////////////////////////
+SensorExecutionTime Sensor::Latency(SensorLatencyStage _stage) const
+{
+  const auto index = static_cast<std::size_t>(_stage);
+  if (index >= SensorPrivate::kLatencyStages)
+    return SensorExecutionTime();
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->executionTimeMutex);
+  return this->dataPtr->latency[index];
+}
+
+//////////////////////////////////////////////////
+SensorMemoryUsage Sensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage;
+  if (this->dataPtr->messageArena)
+  {
+    usage["message_arena"] = std::max<std::size_t>(
+        this->dataPtr->arenaBlock.capacity(),
+        this->dataPtr->messageArena->SpaceAllocated());
+  }
+
+  this->dataPtr->publisher.AddMemoryUsage(usage);
+  return usage;
+}
+
+//////////////////////////////////////////////////
+bool SensorPrivate::MeasureLatency() const
+{
+  return this->enableMetrics || this->latencyStamps;
+}
+
+//////////////////////////////////////////////////
+void Sensor::StampLatency(SensorLatencyStage _stage)
+{
+  const auto index = static_cast<std::size_t>(_stage);
+  if (!this->dataPtr->MeasureLatency() ||
+      index >= SensorPrivate::kLatencyStages)
+  {
+    return;
+  }
+
+  auto &times = this->dataPtr->stageTimes;
+  const auto now = std::chrono::steady_clock::now();
+  if (_stage == SensorLatencyStage::UPDATE)
+  {
+    times.fill(std::chrono::steady_clock::time_point());
+    times[index] = now;
+    this->dataPtr->updateWallTime = std::chrono::system_clock::now();
+    return;
+  }
+
+  // Stages reached outside of an update aren't measured
+  const auto start = times[0];
+  if (start == std::chrono::steady_clock::time_point())
+    return;
+
+  times[index] = now;
+  std::lock_guard<std::mutex> lock(this->dataPtr->executionTimeMutex);
+  SensorPrivate::AddSample(this->dataPtr->latency[index], now - start);
+}
+
+//////////////////////////////////////////////////
+void SensorPrivate::RecordExecutionTime(
+    const std::chrono::steady_clock::duration &_duration)
+{
+  std::lock_guard<std::mutex> lock(this->executionTimeMutex);
+  AddSample(this->executionTime, _duration);
+}
+
+//////////////////////////////////////////////////
+void SensorPrivate::AddSample(SensorExecutionTime &_stats,
+    const std::chrono::steady_clock::duration &_duration)
+{
+  const auto micros =
+    std::chrono::duration_cast<std::chrono::microseconds>(_duration).count();
+  std::size_t bucket = 0u;
+  while (bucket + 1u < SensorExecutionTime::kHistogramSize &&
+         (micros >> bucket) > 0)
+  {
+    ++bucket;
+  }
+
+  _stats.last = _duration;
+  if (_stats.count == 0u)
+    _stats.average = _duration;
+  else
+    _stats.average += (_duration - _stats.average) / 10;
+  _stats.max = std::max(_stats.max, _duration);
+  ++_stats.histogram[bucket];
+  ++_stats.count;
+}
+
+//////////////////////////////////////////////////
+void SensorPrivate::AddStatistics(msgs::StatisticsGroup &_msg,
+    const SensorExecutionTime &_stats, const std::string &_prefix)
+{
+  auto addStatistic = [&_msg, &_prefix](msgs::Statistic::DataType _type,
+      const std::string &_name, double _value)
+  {
+    auto statistic = _msg.add_statistics();
+    statistic->set_type(_type);
+    statistic->set_name(_prefix + _name);
+    statistic->set_value(_value);
+  };
+  auto secs = [](const std::chrono::steady_clock::duration &_d)
+  {
+    return std::chrono::duration<double>(_d).count();
+  };
+
+  addStatistic(msgs::Statistic::SAMPLE_COUNT, "count",
+      static_cast<double>(_stats.count));
+  addStatistic(msgs::Statistic::UNINITIALIZED, "last", secs(_stats.last));
+  addStatistic(msgs::Statistic::AVERAGE, "average", secs(_stats.average));
+  addStatistic(msgs::Statistic::MAXIMUM, "max", secs(_stats.max));
+  for (std::size_t i = 0u; i < _stats.histogram.size(); ++i)
+  {
+    const std::string bucketName = i + 1u < _stats.histogram.size() ?
+      "histogram_lt_" + std::to_string(1ull << i) + "us" : "histogram_inf";
+    addStatistic(msgs::Statistic::SAMPLE_COUNT, bucketName,
+        static_cast<double>(_stats.histogram[i]));
+  }
+}
+
+//////////////////////////////////////////////////
+void SensorPrivate::PublishExecutionTime()
+{
+  if (!this->executionTimePub)
+  {
+    const auto validTopic = transport::TopicUtils::AsValidTopic(
+      this->topic + "/performance_metrics/execution_time");
+    if (validTopic.empty())
+    {
+      gzerr << "Failed to set execution time topic [" << topic << "]" <<
+        std::endl;
+      return;
+    }
+    this->executionTimePub =
+      node.Advertise<msgs::StatisticsGroup>(validTopic);
+  }
+  if (!this->executionTimePub || !this->executionTimePub.HasConnections())
+    return;
+
+  SensorExecutionTime stats;
+  {
+    std::lock_guard<std::mutex> lock(this->executionTimeMutex);
+    stats = this->executionTime;
+  }
+
+  msgs::StatisticsGroup msg;
+  msg.set_name(this->name);
+  AddStatistics(msg, stats, "");
+  this->executionTimePub.Publish(msg);
+}
+
+//////////////////////////////////////////////////
+void SensorPrivate::PublishLatency()
+{
+  if (!this->latencyPub)
+  {
+    const auto validTopic = transport::TopicUtils::AsValidTopic(
+      this->topic + "/performance_metrics/latency");
+    if (validTopic.empty())
+    {
+      gzerr << "Failed to set latency topic [" << topic << "]" <<
+        std::endl;
+      return;
+    }
+    this->latencyPub = node.Advertise<msgs::StatisticsGroup>(validTopic);
+  }
+  if (!this->latencyPub || !this->latencyPub.HasConnections())
+    return;
+
+  std::array<SensorExecutionTime, kLatencyStages> stats;
+  {
+    std::lock_guard<std::mutex> lock(this->executionTimeMutex);
+    stats = this->latency;
+  }
+
+  // Statistics are named after their stage, e.g. render_average
+  msgs::StatisticsGroup msg;
+  msg.set_name(this->name);
+  for (std::size_t i = 1u; i < kLatencyStages; ++i)
+  {
+    AddStatistics(msg, stats[i],
+        std::string(kLatencyStageNames[i]) + "_");
+  }
+  this->latencyPub.Publish(msg);
+}
+
+//////////////////////////////////////////////////
+void SensorPrivate::PublishMemoryUsage(const Sensor &_sensor)
+{
+  if (!this->memoryUsagePub)
+  {
+    const auto validTopic = transport::TopicUtils::AsValidTopic(
+      this->topic + "/performance_metrics/memory");
+    if (validTopic.empty())
+    {
+      gzerr << "Failed to set memory usage topic [" << topic << "]" <<
+        std::endl;
+      return;
+    }
+    this->memoryUsagePub = node.Advertise<msgs::StatisticsGroup>(validTopic);
+  }
+  if (!this->memoryUsagePub || !this->memoryUsagePub.HasConnections())
+    return;
+
+  // One statistic per buffer, in bytes, and their total
+  msgs::StatisticsGroup msg;
+  msg.set_name(this->name);
+  std::size_t total = 0u;
+  for (const auto &[buffer, bytes] : _sensor.MemoryUsage())
+  {
+    auto statistic = msg.add_statistics();
+    statistic->set_type(msgs::Statistic::UNINITIALIZED);
+    statistic->set_name(buffer);
+    statistic->set_value(static_cast<double>(bytes));
+    total += bytes;
+  }
+  auto statistic = msg.add_statistics();
+  statistic->set_type(msgs::Statistic::UNINITIALIZED);
+  statistic->set_name("total");
+  statistic->set_value(static_cast<double>(total));
+  this->memoryUsagePub.Publish(msg);
+}
+
 //////////////////////////////////////////////////
 void Sensor::PublishMetrics(const std::chrono::duration<double> &_now)
 {
-  return this->dataPtr->PublishMetrics(_now);
+  return this->dataPtr->PublishMetrics(*this, _now);
 }
 
 //////////////////////////////////////////////////
-void SensorPrivate::PublishMetrics(const std::chrono::duration<double> &_now)
+void SensorPrivate::PublishMetrics(const Sensor &_sensor,
+    const std::chrono::duration<double> &_now)
 {
+  this->PublishExecutionTime();
+  this->PublishLatency();
+  this->PublishMemoryUsage(_sensor);
+  this->publisher.PublishBackpressure();
+
   if (!this->performanceSensorMetricsPub)
   {
     const auto validTopic = transport::TopicUtils::AsValidTopic(
@@ -360,7 +873,8 @@ void SensorPrivate::PublishMetrics(const std::chrono::duration<double> &_now)
   performanceSensorMetricsMsg.set_name(this->name);
   performanceSensorMetricsMsg.set_real_update_rate(realUpdateRate);
   performanceSensorMetricsMsg.set_sim_update_rate(simUpdateRate);
-  performanceSensorMetricsMsg.set_nominal_update_rate(this->updateRate);
+  performanceSensorMetricsMsg.set_nominal_update_rate(
+      this->schedule.Rate());
 
   // Publish data
   performanceSensorMetricsPub.Publish(performanceSensorMetricsMsg);
@@ -369,37 +883,7 @@ void SensorPrivate::PublishMetrics(const std::chrono::duration<double> &_now)
 //////////////////////////////////////////////////
 void SensorPrivate::SetRate(const gz::msgs::Double &_rate)
 {
-  auto rate = _rate.data();
-  if (rate < 0.0)
-    rate = 0.0;
-
-  // if SDF has zero, any value can be set; for non-zero SDF values, we need to
-  // check whether they are in bounds, i.e. greater than zero and lower or equal
-  // to the SDF value
-  if (!gz::math::lessOrNearEqual(this->sdfUpdateRate, 0.0))
-  {
-    if (gz::math::lessOrNearEqual(rate, 0.0))
-    {
-      gzerr << "Cannot set update rate of sensor " << this->name << " to zero "
-             << "because the <update_rate> SDF element is non-zero."
-             << std::endl;
-      return;
-    }
-    // apply the upper rate limit from SDF
-    else if (!gz::math::lessOrNearEqual(rate, this->sdfUpdateRate))
-    {
-      gzerr << "Trying to set update rate of sensor " << this->name << " to "
-             << rate << ", but the maximum rate in <update_rate> SDF element "
-             << "is " << this->sdfUpdateRate << ". Ignoring the request."
-             << std::endl;
-      return;
-    }
-  }
-
-  gzdbg << "Setting update rate of sensor " << this->name << " to " << rate
-         << " Hz" << std::endl;
-
-  this->updateRate = rate;
+  this->schedule.RequestRate(_rate.data(), this->name);
 }
 
 //////////////////////////////////////////////////
@@ -429,101 +913,336 @@ void Sensor::SetPose(const gz::math::Pose3d &_pose)
 //////////////////////////////////////////////////
 double Sensor::UpdateRate() const
 {
-  return this->dataPtr->updateRate;
+  return this->dataPtr->schedule.Rate();
 }
 
 //////////////////////////////////////////////////
 void Sensor::SetUpdateRate(const double _hz)
 {
-  if (_hz < 0)
+  this->dataPtr->schedule.SetRate(_hz);
+}
+
+//////////////////////////////////////////////////
+bool Sensor::Update(const std::chrono::steady_clock::duration &_now,
+                  const bool _force)
+{
+  auto &d = *this->dataPtr;
+  if (!d.interpolateInputs || _force || d.publisher.Replayed() ||
+      d.schedule.ScheduledRate() <= 0.0)
   {
-    this->dataPtr->updateRate = 0;
+    return this->UpdateSample(_now, _force);
   }
-  else
+
+  d.currInputs.Clear();
+  this->SaveInputs(d.currInputs);
+
+  bool result = false;
+  if (d.inputsTime >= std::chrono::steady_clock::duration::zero() &&
+      d.inputsTime < _now)
   {
-    this->dataPtr->updateRate = _hz;
+    // Generate the samples due before _now from the inputs interpolated
+    // between the previous update and this one.
+    const double span =
+        std::chrono::duration<double>(_now - d.inputsTime).count();
+    while (d.schedule.NextUpdateTime() < _now)
+    {
+      const auto due = d.schedule.NextUpdateTime();
+      const auto time = std::max(due, d.inputsTime);
+      const double alpha =
+          std::chrono::duration<double>(time - d.inputsTime).count() / span;
+      d.prevInputs.Rewind();
+      d.currInputs.Rewind();
+      if (!this->InterpolateInputs(d.prevInputs, d.currInputs, alpha))
+        break;
+      result = this->UpdateSample(time, false) || result;
+
+      // Inactive sensors keep their schedule
+      if (d.schedule.NextUpdateTime() <= due)
+        break;
+    }
+
+    d.prevInputs.Rewind();
+    d.currInputs.Rewind();
+    this->InterpolateInputs(d.prevInputs, d.currInputs, 1.0);
   }
+  result = this->UpdateSample(_now, false) || result;
+
+  std::swap(d.prevInputs, d.currInputs);
+  d.inputsTime = _now;
+  return result;
 }
 
 //////////////////////////////////////////////////
-bool Sensor::Update(const std::chrono::steady_clock::duration &_now,
+bool Sensor::UpdateSample(const std::chrono::steady_clock::duration &_now,
                   const bool _force)
 {
   GZ_PROFILE("Sensor::Update");
   bool result = false;
 
-  // Check if it's time to update
-  if (_now < this->dataPtr->nextUpdateTime && !_force &&
-      this->dataPtr->updateRate > 0)
-  {
+  auto &publisher = this->dataPtr->publisher;
+  publisher.ReleaseDelayed(_now);
+  if (!this->dataPtr->schedule.IsDue(_now, _force))
     return result;
-  }
 
-  // prevent update if not active, unless forced
-  if (!this->dataPtr->active && !_force)
+  if (!_force && this->SkipLazyUpdate(_now))
+  {
+    this->dataPtr->FinishUpdate(*this, _now, _force);
     return result;
+  }
 
   // Make the update happen
-  result = this->Update(_now);
-
-  // Publish metrics
-  if (this->EnableMetrics())
+  TraceScope trace("update", *this);
+  publisher.SetSampleTime(_now);
+  this->dataPtr->schedule.ClearTrigger();
+  this->StampLatency(SensorLatencyStage::UPDATE);
+  if (this->dataPtr->enableMetrics || this->dataPtr->schedule.MeasureCost())
   {
-    auto secs = std::chrono::duration_cast<std::chrono::duration<double>>(_now);
-    this->PublishMetrics(secs);
+    const auto start = std::chrono::steady_clock::now();
+    result = publisher.Replayed() ? publisher.PublishReplay(_now) :
+        this->Update(_now);
+    const auto duration = std::chrono::steady_clock::now() - start;
+    if (this->dataPtr->enableMetrics)
+      this->dataPtr->RecordExecutionTime(duration);
+    this->dataPtr->schedule.RecordCost(duration);
   }
-
-  if (!_force && this->dataPtr->updateRate > 0.0)
+  else
   {
-    // Update the time the plugin should be loaded
-    auto delta = std::chrono::duration_cast< std::chrono::milliseconds>
-      (std::chrono::duration< double >(1.0 / this->dataPtr->updateRate));
+    result = publisher.Replayed() ? publisher.PublishReplay(_now) :
+        this->Update(_now);
+  }
+
+  this->ResetMessageArena();
+  this->dataPtr->FinishUpdate(*this, _now, _force);
+
+  return result;
+}
 
-    this->dataPtr->nextUpdateTime += delta;
+//////////////////////////////////////////////////
+void Sensor::UpdateGroup(const std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("Sensor::UpdateGroup");
+  if (_sensors.empty())
+    return;
+
+  if (_sensors.size() == 1u)
+  {
+    _sensors.front()->Update(_now, false);
+    return;
+  }
 
-    // Catch up to "now", if necessary.
-    while (this->dataPtr->nextUpdateTime <= _now)
+  thread_local std::vector<Sensor *> due;
+  due.clear();
+  for (auto &s : _sensors)
+  {
+    // Replayed sensors and sensors that interpolate their inputs don't
+    // take part in the batch
+    if (s->dataPtr->publisher.Replayed() || s->dataPtr->interpolateInputs)
     {
-      this->dataPtr->nextUpdateTime += delta;
+      s->Update(_now, false);
+      continue;
     }
+    s->dataPtr->publisher.ReleaseDelayed(_now);
+    if (!s->dataPtr->schedule.IsDue(_now, false))
+      continue;
+    if (s->SkipLazyUpdate(_now))
+      s->dataPtr->FinishUpdate(*s, _now, false);
+    else
+      due.push_back(s);
   }
+  if (due.empty())
+    return;
 
-  return result;
+  for (auto &s : due)
+  {
+    s->dataPtr->publisher.SetSampleTime(_now);
+    s->dataPtr->schedule.ClearTrigger();
+    s->StampLatency(SensorLatencyStage::UPDATE);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  due.front()->UpdateBatch(due, _now);
+  const auto share =
+    (std::chrono::steady_clock::now() - start) / static_cast<int>(due.size());
+
+  for (auto &s : due)
+  {
+    s->ResetMessageArena();
+    if (s->dataPtr->enableMetrics)
+      s->dataPtr->RecordExecutionTime(share);
+    s->dataPtr->schedule.RecordCost(share);
+    s->dataPtr->FinishUpdate(*s, _now, false);
+  }
 }
 
 //////////////////////////////////////////////////
-std::chrono::steady_clock::duration Sensor::NextDataUpdateTime() const
+void Sensor::UpdateBatch(const std::vector<Sensor *> &_sensors,
+    const std::chrono::steady_clock::duration &_now)
 {
-  return this->dataPtr->nextUpdateTime;
+  for (auto &s : _sensors)
+    s->Update(_now);
 }
 
 //////////////////////////////////////////////////
-void Sensor::SetNextDataUpdateTime(
-    const std::chrono::steady_clock::duration &_time)
+void SensorPrivate::FinishUpdate(const Sensor &_sensor,
+    const std::chrono::steady_clock::duration &_now, bool _force)
 {
-  this->dataPtr->nextUpdateTime = _time;
-}
-
-/////////////////////////////////////////////////
-void Sensor::AddSequence(gz::msgs::Header *_msg,
-                         const std::string &_seqKey)
+  // Publish metrics
+  if (this->enableMetrics)
+  {
+    auto secs = std::chrono::duration_cast<std::chrono::duration<double>>(_now);
+    this->PublishMetrics(_sensor, secs);
+  }
+
+  this->publisher.EndUpdate(_now);
+
+  if (!_force && this->schedule.ScheduledRate() > 0.0)
+    this->schedule.Advance(_now);
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration Sensor::NextDataUpdateTime() const
+{
+  return this->dataPtr->schedule.NextUpdateTime();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetNextDataUpdateTime(
+    const std::chrono::steady_clock::duration &_time)
+{
+  this->dataPtr->schedule.SetNextUpdateTime(_time);
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetDriftFreeSchedule(bool _driftFree)
+{
+  this->dataPtr->schedule.SetDriftFree(_driftFree);
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetMinUpdateRate(double _hz)
+{
+  this->dataPtr->schedule.SetMinRate(_hz);
+}
+
+//////////////////////////////////////////////////
+double Sensor::MinUpdateRate() const
+{
+  return this->dataPtr->schedule.MinRate();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetPriority(SensorPriority _priority)
+{
+  this->dataPtr->schedule.SetPriority(_priority);
+}
+
+//////////////////////////////////////////////////
+SensorPriority Sensor::Priority() const
+{
+  return this->dataPtr->schedule.Priority();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetEffectiveUpdateRate(double _hz)
+{
+  this->dataPtr->schedule.SetEffectiveRate(_hz);
+}
+
+//////////////////////////////////////////////////
+double Sensor::EffectiveUpdateRate() const
+{
+  return this->dataPtr->schedule.ScheduledRate();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetMeasureUpdateCost(bool _measure)
+{
+  this->dataPtr->schedule.SetMeasureCost(_measure);
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration Sensor::UpdateCost() const
+{
+  return this->dataPtr->schedule.Cost();
+}
+
+//////////////////////////////////////////////////
+bool Sensor::DriftFreeSchedule() const
+{
+  return this->dataPtr->schedule.DriftFree();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetScheduleChangedCallback(
+    std::function<void(SensorId)> _callback)
+{
+  this->dataPtr->schedule.SetChangedCallback(std::move(_callback));
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetTriggerCallback(std::function<void(SensorId)> _callback)
 {
-  std::string value = "0";
+  this->dataPtr->schedule.SetTriggerCallback(std::move(_callback));
+}
 
-  if (this->dataPtr->sequences.find(_seqKey) == this->dataPtr->sequences.end())
-    this->dataPtr->sequences[_seqKey] = 0;
+//////////////////////////////////////////////////
+void Sensor::NotifyTriggered()
+{
+  this->dataPtr->schedule.NotifyTriggered();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetWaitForTrigger(bool _wait)
+{
+  this->dataPtr->schedule.SetWaitForTrigger(_wait);
+}
+
+//////////////////////////////////////////////////
+bool Sensor::WaitsForTrigger() const
+{
+  return this->dataPtr->schedule.WaitsForTrigger();
+}
+
+//////////////////////////////////////////////////
+bool Sensor::TriggerPending() const
+{
+  return this->dataPtr->schedule.TriggerPending();
+}
+
+/////////////////////////////////////////////////
+uint64_t SensorPrivate::NextSequence(const std::string &_seqKey)
+{
+  auto [it, inserted] = this->sequences.try_emplace(_seqKey, 0u);
+  if (!inserted)
+    ++it->second;
+  return it->second;
+}
+
+/////////////////////////////////////////////////
+void SensorPrivate::SetValue(gz::msgs::Header::Map *_data, uint64_t _value)
+{
+  // Format in place to reuse the memory of the existing value
+  char buffer[std::numeric_limits<uint64_t>::digits10 + 1];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), _value);
+  if (_data->value_size() == 0)
+    _data->add_value(buffer, result.ptr - buffer);
   else
-    value = std::to_string(++this->dataPtr->sequences[_seqKey]);
+    _data->mutable_value(0)->assign(buffer, result.ptr - buffer);
+}
+
+/////////////////////////////////////////////////
+void Sensor::AddSequence(gz::msgs::Header *_msg,
+                         const std::string &_seqKey)
+{
+  const uint64_t value = this->dataPtr->NextSequence(_seqKey);
 
   // Set the value if a `sequence` key already exists.
   for (int index = 0; index < _msg->data_size(); ++index)
   {
     if (_msg->data(index).key() == "seq")
     {
-      if (_msg->data(index).value_size() == 0)
-        _msg->mutable_data(index)->add_value(value);
-      else
-        _msg->mutable_data(index)->set_value(0, value);
+      SensorPrivate::SetValue(_msg->mutable_data(index), value);
       return;
     }
   }
@@ -531,19 +1250,86 @@ void Sensor::AddSequence(gz::msgs::Header *_msg,
   // Otherwise, add the sequence key-value pair.
   gz::msgs::Header::Map *map = _msg->add_data();
   map->set_key("seq");
-  map->add_value(value);
+  SensorPrivate::SetValue(map, value);
 }
 
 /////////////////////////////////////////////////
-bool Sensor::IsActive() const
+void Sensor::FillHeader(gz::msgs::Header *_msg,
+    const std::chrono::steady_clock::duration &_now)
 {
-  return this->dataPtr->active;
+  this->FillHeader(_msg, _now, this->dataPtr->frame_id, "default");
 }
 
 /////////////////////////////////////////////////
+void Sensor::FillHeader(gz::msgs::Header *_msg,
+    const std::chrono::steady_clock::duration &_now,
+    const std::string &_frameId, const std::string &_seqKey)
+{
+  *_msg->mutable_stamp() = msgs::Convert(_now);
+
+  // Stages the current update went through before the message is filled
+  static constexpr std::array<const char *, 3> stampKeys{
+    "stamp_update", "stamp_render", "stamp_readback"};
+  const auto &times = this->dataPtr->stageTimes;
+  std::array<std::size_t, stampKeys.size()> stamped{};
+  int stampCount = 0;
+  if (this->dataPtr->latencyStamps &&
+      times[0] != std::chrono::steady_clock::time_point())
+  {
+    for (std::size_t i = 0u; i < stampKeys.size(); ++i)
+    {
+      if (times[i] != std::chrono::steady_clock::time_point())
+        stamped[stampCount++] = i;
+    }
+  }
+
+  // Fast path: the header was filled by this function before
+  if (_msg->data_size() != 2 + stampCount ||
+      _msg->data(0).key() != "frame_id" || _msg->data(0).value_size() != 1 ||
+      _msg->data(1).key() != "seq" || _msg->data(1).value_size() != 1)
+  {
+    // Cleared entries are kept by protobuf and reused by add_data
+    _msg->clear_data();
+    _msg->add_data()->set_key("frame_id");
+    _msg->add_data()->set_key("seq");
+    for (int i = 0; i < stampCount; ++i)
+      _msg->add_data();
+  }
+
+  for (int i = 0; i < stampCount; ++i)
+  {
+    const std::size_t stage = stamped[i];
+    auto entry = _msg->mutable_data(2 + i);
+    if (entry->key() != stampKeys[stage])
+      entry->set_key(stampKeys[stage]);
+    const auto wall = this->dataPtr->updateWallTime +
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        times[stage] - times[0]);
+    SensorPrivate::SetValue(entry, static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        wall.time_since_epoch()).count()));
+  }
+
+  auto frame = _msg->mutable_data(0);
+  if (frame->value_size() == 0)
+    frame->add_value(_frameId);
+  else if (frame->value(0) != _frameId)
+    frame->set_value(0, _frameId);
+
+  SensorPrivate::SetValue(_msg->mutable_data(1),
+      this->dataPtr->NextSequence(_seqKey));
+}
+
+//////////////////////////////////////////////////
+bool Sensor::IsActive() const
+{
+  return this->dataPtr->schedule.Active();
+}
+
+//////////////////////////////////////////////////
 void Sensor::SetActive(bool _active)
 {
-  this->dataPtr->active = _active;
+  this->dataPtr->schedule.SetActive(_active);
 }
 
 //////////////////////////////////////////////////
@@ -551,3 +1337,534 @@ bool Sensor::HasConnections() const
 {
   return true;
 }
+
+//////////////////////////////////////////////////
+void Sensor::SetLazyUpdate(bool _lazy)
+{
+  this->dataPtr->lazyUpdate = _lazy;
+}
+
+//////////////////////////////////////////////////
+bool Sensor::LazyUpdate() const
+{
+  return this->dataPtr->lazyUpdate;
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetLazyNoiseUpdate(bool _keepNoise)
+{
+  this->dataPtr->lazyNoiseUpdate = _keepNoise;
+}
+
+//////////////////////////////////////////////////
+bool Sensor::LazyNoiseUpdate() const
+{
+  return this->dataPtr->lazyNoiseUpdate;
+}
+
+//////////////////////////////////////////////////
+void Sensor::UpdateNoiseState(const std::chrono::steady_clock::duration &_now)
+{
+  this->Update(_now);
+}
+
+//////////////////////////////////////////////////
+bool Sensor::SkipLazyUpdate(const std::chrono::steady_clock::duration &_now)
+{
+  auto &publisher = this->dataPtr->publisher;
+  if (publisher.SkipBackpressured())
+    return true;
+
+  // Recorded sensors keep producing data
+  if (!this->dataPtr->lazyUpdate || publisher.Recorded() ||
+      this->HasConnections() || publisher.HasOtherConnections())
+  {
+    return false;
+  }
+
+  GZ_PROFILE("Sensor::SkipLazyUpdate");
+  if (this->dataPtr->lazyNoiseUpdate)
+    this->UpdateNoiseState(_now);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetMessageArenaEnabled(bool _enabled)
+{
+  if (!_enabled)
+  {
+    this->dataPtr->messageArena.reset();
+    this->dataPtr->arenaBlock = std::vector<char>();
+    return;
+  }
+  if (this->dataPtr->messageArena)
+    return;
+
+  this->dataPtr->arenaBlock.resize(SensorPrivate::kArenaBlockSize);
+  google::protobuf::ArenaOptions options;
+  options.initial_block = this->dataPtr->arenaBlock.data();
+  options.initial_block_size = this->dataPtr->arenaBlock.size();
+  this->dataPtr->messageArena =
+    std::make_unique<google::protobuf::Arena>(options);
+}
+
+//////////////////////////////////////////////////
+bool Sensor::MessageArenaEnabled() const
+{
+  return this->dataPtr->messageArena != nullptr;
+}
+
+//////////////////////////////////////////////////
+google::protobuf::Arena *Sensor::MessageArena()
+{
+  return this->dataPtr->messageArena.get();
+}
+
+//////////////////////////////////////////////////
+void Sensor::ResetMessageArena()
+{
+  if (this->dataPtr->messageArena)
+    this->dataPtr->messageArena->Reset();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetNoiseSeed(uint64_t _seed)
+{
+  this->dataPtr->noiseSeed = _seed;
+  this->dataPtr->hasNoiseSeed = true;
+  for (const auto &[type, weakNoise] : this->dataPtr->noises)
+  {
+    if (auto noise = weakNoise.lock())
+      noise->SetSeed(DeriveNoiseSeed(_seed, this->Name(), type));
+  }
+}
+
+//////////////////////////////////////////////////
+bool Sensor::HasNoiseSeed() const
+{
+  return this->dataPtr->hasNoiseSeed;
+}
+
+//////////////////////////////////////////////////
+uint64_t Sensor::NoiseSeed() const
+{
+  return this->dataPtr->noiseSeed;
+}
+
+//////////////////////////////////////////////////
+uint64_t Sensor::DeriveNoiseSeed(uint64_t _seed,
+    const std::string &_sensorName, SensorNoiseType _type)
+{
+  // splitmix64 finalizer
+  auto mix = [](uint64_t _x)
+  {
+    _x += 0x9e3779b97f4a7c15ull;
+    _x = (_x ^ (_x >> 30u)) * 0xbf58476d1ce4e5b9ull;
+    _x = (_x ^ (_x >> 27u)) * 0x94d049bb133111ebull;
+    return _x ^ (_x >> 31u);
+  };
+
+  // FNV-1a hash of the name, stable across platforms and runs
+  uint64_t nameHash = 0xcbf29ce484222325ull;
+  for (unsigned char c : _sensorName)
+  {
+    nameHash ^= c;
+    nameHash *= 0x100000001b3ull;
+  }
+
+  uint64_t seed = mix(_seed);
+  seed = mix(seed ^ nameHash);
+  return mix(seed ^ static_cast<uint64_t>(_type));
+}
+
+//////////////////////////////////////////////////
+void Sensor::SaveState(SensorState &_state) const
+{
+  this->dataPtr->schedule.SaveState(_state);
+
+  _state.Write(static_cast<uint64_t>(this->dataPtr->sequences.size()));
+  for (const auto &[key, value] : this->dataPtr->sequences)
+  {
+    _state.Write(static_cast<uint64_t>(key.size()));
+    _state.WriteBytes(key.data(), key.size());
+    _state.Write(value);
+  }
+
+  _state.Write(static_cast<uint64_t>(this->dataPtr->noises.size()));
+  for (const auto &[type, weakNoise] : this->dataPtr->noises)
+  {
+    auto noise = weakNoise.lock();
+    _state.Write(type);
+    _state.Write(noise != nullptr);
+    if (noise)
+      noise->SaveState(_state);
+  }
+}
+
+//////////////////////////////////////////////////
+bool Sensor::RestoreState(SensorState &_state)
+{
+  SensorSchedule::State schedule;
+  uint64_t count{0u};
+  if (!SensorSchedule::ReadState(_state, schedule) || !_state.Read(count))
+    return false;
+
+  // Read the sequences in place when the keys match, which is the case
+  // when restoring the same sensor, so that no node is reallocated.
+  auto &sequences = this->dataPtr->sequences;
+  bool sameKeys = count == sequences.size();
+  auto it = sequences.begin();
+  std::map<std::string, uint64_t> rebuilt;
+  for (uint64_t i = 0u; i < count; ++i)
+  {
+    uint64_t size{0u};
+    if (!_state.Read(size))
+      return false;
+    const auto *key = reinterpret_cast<const char *>(
+        _state.ReadView(static_cast<std::size_t>(size)));
+    uint64_t value{0u};
+    if (!key || !_state.Read(value))
+      return false;
+
+    if (sameKeys && it->first.compare(0, std::string::npos, key,
+          static_cast<std::size_t>(size)) == 0)
+    {
+      it->second = value;
+      ++it;
+      continue;
+    }
+    if (sameKeys)
+    {
+      // Copy the matching keys read so far
+      rebuilt.insert(sequences.begin(), it);
+      sameKeys = false;
+    }
+    rebuilt.emplace(std::string(key, static_cast<std::size_t>(size)), value);
+  }
+  if (!sameKeys)
+    sequences = std::move(rebuilt);
+
+  if (!_state.Read(count))
+    return false;
+  for (uint64_t i = 0u; i < count; ++i)
+  {
+    SensorNoiseType type{};
+    bool hasNoise{false};
+    if (!_state.Read(type) || !_state.Read(hasNoise))
+      return false;
+    if (!hasNoise)
+      continue;
+
+    auto noiseIt = this->dataPtr->noises.find(type);
+    auto noise = noiseIt == this->dataPtr->noises.end() ?
+        nullptr : noiseIt->second.lock();
+    if (!noise)
+    {
+      gzerr << "Unable to restore the state of sensor [" << this->Name()
+            << "], it has no noise model of type ["
+            << static_cast<int>(type) << "]." << std::endl;
+      return false;
+    }
+    if (!noise->RestoreState(_state))
+      return false;
+  }
+
+  this->dataPtr->schedule.RestoreState(schedule);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Sensor::RegisterNoise(SensorNoiseType _type, const NoisePtr &_noise)
+{
+  if (!_noise)
+  {
+    this->dataPtr->noises.erase(_type);
+    return;
+  }
+  this->dataPtr->noises[_type] = _noise;
+  if (this->dataPtr->hasNoiseSeed)
+  {
+    _noise->SetSeed(
+        DeriveNoiseSeed(this->dataPtr->noiseSeed, this->Name(), _type));
+  }
+}
+
+//////////////////////////////////////////////////
+void Sensor::RegisterNoise(const NoiseTable &_noises)
+{
+  for (std::size_t i = 0; i < _noises.size(); ++i)
+  {
+    if (_noises[i])
+      this->RegisterNoise(static_cast<SensorNoiseType>(i), _noises[i]);
+  }
+}
+
+//////////////////////////////////////////////////
+bool Sensor::IsRenderingSensor() const
+{
+  return false;
+}
+
+//////////////////////////////////////////////////
+bool Sensor::HasBatchUpdate() const
+{
+  return false;
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetAsyncPublish(bool _async)
+{
+  this->dataPtr->publisher.SetAsync(_async);
+}
+
+//////////////////////////////////////////////////
+bool Sensor::AsyncPublish() const
+{
+  return this->dataPtr->publisher.Async();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetAsyncPublishDepth(std::size_t _depth)
+{
+  this->dataPtr->publisher.SetAsyncDepth(_depth);
+}
+
+//////////////////////////////////////////////////
+std::size_t Sensor::AsyncPublishDepth() const
+{
+  return this->dataPtr->publisher.AsyncDepth();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetBackpressureLimits(std::size_t _depth, std::size_t _bytes)
+{
+  this->dataPtr->publisher.SetBackpressureLimits(_depth, _bytes);
+}
+
+//////////////////////////////////////////////////
+std::size_t Sensor::BackpressureDepth() const
+{
+  return this->dataPtr->publisher.BackpressureDepth();
+}
+
+//////////////////////////////////////////////////
+std::size_t Sensor::BackpressureBytes() const
+{
+  return this->dataPtr->publisher.BackpressureBytes();
+}
+
+//////////////////////////////////////////////////
+uint64_t Sensor::DroppedMessageCount() const
+{
+  return this->dataPtr->publisher.DroppedCount();
+}
+
+//////////////////////////////////////////////////
+uint64_t Sensor::BackpressureSkippedCount() const
+{
+  return this->dataPtr->publisher.SkippedCount();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetAdvertiseDeferred(bool _deferred)
+{
+  this->dataPtr->publisher.SetAdvertiseDeferred(_deferred);
+}
+
+//////////////////////////////////////////////////
+bool Sensor::AdvertiseDeferred() const
+{
+  return this->dataPtr->publisher.AdvertiseDeferred();
+}
+
+//////////////////////////////////////////////////
+bool Sensor::AdvertisePending()
+{
+  bool result = true;
+  for (auto &[topic, advertise] :
+       this->dataPtr->publisher.TakePendingAdvertisements())
+  {
+    if (!advertise())
+    {
+      gzerr << "Unable to advertise [" << topic << "] for sensor ["
+            << this->Name() << "]." << std::endl;
+      result = false;
+    }
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+std::size_t Sensor::PendingAdvertisementCount() const
+{
+  return this->dataPtr->publisher.PendingAdvertisementCount();
+}
+
+//////////////////////////////////////////////////
+void Sensor::DeferAdvertisement(const std::string &_topic,
+    std::function<bool()> _advertise)
+{
+  this->dataPtr->publisher.DeferAdvertisement(_topic, std::move(_advertise));
+}
+
+//////////////////////////////////////////////////
+bool Sensor::Publish(transport::Node::Publisher &_pub,
+    const google::protobuf::Message &_msg)
+{
+  TraceScope trace("publish", *this);
+  this->StampLatency(SensorLatencyStage::FILL);
+  const auto result = this->dataPtr->publisher.Publish(_pub, _msg);
+
+  // Failed publications still leave the sensor, refused messages don't
+  if (result != SensorPublishResult::REFUSED)
+    this->StampLatency(SensorLatencyStage::PUBLISH);
+  return result == SensorPublishResult::SENT;
+}
+
+//////////////////////////////////////////////////
+bool Sensor::Publish(transport::Node::Publisher &_pub,
+    google::protobuf::Message &&_msg)
+{
+  TraceScope trace("publish", *this);
+  this->StampLatency(SensorLatencyStage::FILL);
+  const auto result = this->dataPtr->publisher.Publish(_pub, std::move(_msg));
+
+  // Failed publications still leave the sensor, refused messages don't
+  if (result != SensorPublishResult::REFUSED)
+    this->StampLatency(SensorLatencyStage::PUBLISH);
+  return result == SensorPublishResult::SENT;
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetOutputDelay(const std::chrono::steady_clock::duration &_delay)
+{
+  this->dataPtr->publisher.SetDelay(_delay);
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration Sensor::OutputDelay() const
+{
+  return this->dataPtr->publisher.Delay();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetOutputDelayDepth(std::size_t _depth)
+{
+  this->dataPtr->publisher.SetDelayDepth(_depth);
+}
+
+//////////////////////////////////////////////////
+std::size_t Sensor::OutputDelayDepth() const
+{
+  return this->dataPtr->publisher.DelayDepth();
+}
+
+//////////////////////////////////////////////////
+std::size_t Sensor::DelayedMessageCount() const
+{
+  return this->dataPtr->publisher.DelayedCount();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetPublisherTopic(transport::Node::Publisher &_pub,
+    const std::string &_topic)
+{
+  this->dataPtr->publisher.SetPublisherTopic(_pub, _topic);
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetRecorder(std::shared_ptr<SensorRecorder> _recorder)
+{
+  this->dataPtr->publisher.SetRecorder(std::move(_recorder));
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorRecorder> Sensor::Recorder() const
+{
+  return this->dataPtr->publisher.Recorder();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetBundle(std::shared_ptr<SensorBundle> _bundle)
+{
+  this->dataPtr->publisher.SetBundle(std::move(_bundle));
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorBundle> Sensor::Bundle() const
+{
+  return this->dataPtr->publisher.Bundle();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetReplay(std::shared_ptr<SensorReplay> _replay)
+{
+  this->dataPtr->publisher.SetReplay(std::move(_replay));
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorReplay> Sensor::Replay() const
+{
+  return this->dataPtr->publisher.Replay();
+}
+
+//////////////////////////////////////////////////
+std::string Sensor::TypeStr() const
+{
+  return this->dataPtr->sdfSensor.TypeStr();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetRawPayloadOutput(bool _enabled)
+{
+  this->dataPtr->publisher.SetRawPayloadOutput(_enabled);
+}
+
+//////////////////////////////////////////////////
+bool Sensor::RawPayloadOutput() const
+{
+  return this->dataPtr->publisher.RawPayloadOutput();
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetInputInterpolation(bool _enabled)
+{
+  this->dataPtr->interpolateInputs = _enabled;
+  this->dataPtr->inputsTime = std::chrono::steady_clock::duration(-1);
+}
+
+//////////////////////////////////////////////////
+bool Sensor::InputInterpolation() const
+{
+  return this->dataPtr->interpolateInputs;
+}
+
+//////////////////////////////////////////////////
+void Sensor::SaveInputs(SensorState &_state) const
+{
+  _state.Write(this->Pose());
+}
+
+//////////////////////////////////////////////////
+bool Sensor::InterpolateInputs(SensorState &_from, SensorState &_to,
+    double _alpha)
+{
+  math::Pose3d from;
+  math::Pose3d to;
+  if (!_from.Read(from) || !_to.Read(to))
+    return false;
+  this->SetPose(InterpolateInput(from, to, _alpha));
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Sensor::SetBufferMemory(SensorBufferMemory _memory)
+{
+  this->dataPtr->bufferMemory = _memory;
+}
+
+//////////////////////////////////////////////////
+SensorBufferMemory Sensor::BufferMemory() const
+{
+  return this->dataPtr->bufferMemory;
+}
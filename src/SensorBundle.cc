@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "gz/sensors/SensorBundle.hh"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+#include <gz/transport/Node.hh>
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Private data for SensorBundle
+class gz::sensors::SensorBundlePrivate
+{
+  /// \brief A message waiting for the next frame.
+  public: struct Pending
+  {
+    /// \brief Time of the update that produced the message.
+    std::chrono::steady_clock::duration time{0};
+
+    /// \brief Topic the message is published on.
+    std::string topic;
+
+    /// \brief Full name of the message type.
+    std::string type;
+
+    /// \brief Serialized message.
+    std::string data;
+  };
+
+  /// \brief Append the pending messages to frame and clear them.
+  /// \param[in] _time Time of the frame.
+  public: void BuildFrame(const std::chrono::steady_clock::duration &_time);
+
+  /// \brief Protects the members below.
+  public: mutable std::mutex mutex;
+
+  /// \brief Node the frame topic is advertised with.
+  public: transport::Node node;
+
+  /// \brief Publisher of the frames.
+  public: transport::Node::Publisher pub;
+
+  /// \brief Topic of the frames.
+  public: std::string topic;
+
+  /// \brief Name of the sensor whose updates close the frames.
+  public: std::string primary;
+
+  /// \brief Callback with every frame.
+  public: SensorBundle::FrameCallback frameCallback;
+
+  /// \brief Messages of the next frame, oldest first.
+  public: std::deque<Pending> pending;
+
+  /// \brief Entries of pending that were dropped and are reused, to keep
+  /// the memory of their strings.
+  public: std::vector<Pending> spare;
+
+  /// \brief Maximum number of pending messages.
+  public: std::size_t maxPending{1024u};
+
+  /// \brief True if the primary sensor added messages since the last
+  /// frame.
+  public: bool primaryAdded{false};
+
+  /// \brief Bytes of the frame being published.
+  public: std::string frame;
+
+  /// \brief Number of frames published.
+  public: uint64_t frameCount{0u};
+
+  /// \brief Number of messages dropped.
+  public: uint64_t droppedCount{0u};
+};
+
+namespace
+{
+/// \brief Append a value to a frame.
+/// \param[in,out] _frame Frame.
+/// \param[in] _value Value.
+template <typename T>
+void Append(std::string &_frame, const T &_value)
+{
+  _frame.append(reinterpret_cast<const char *>(&_value), sizeof(_value));
+}
+}
+
+//////////////////////////////////////////////////
+void SensorBundlePrivate::BuildFrame(
+    const std::chrono::steady_clock::duration &_time)
+{
+  std::size_t size = sizeof(SensorBundleHeader);
+  for (const auto &msg : this->pending)
+  {
+    size += (sizeof(SensorBundleEntryHeader) + msg.topic.size() +
+        msg.type.size() + msg.data.size() + 7u) & ~std::size_t(7u);
+  }
+  this->frame.clear();
+  this->frame.reserve(size);
+
+  SensorBundleHeader header;
+  header.magic = SensorBundleHeader::kMagic;
+  header.version = SensorBundleHeader::kVersion;
+  header.count = static_cast<uint32_t>(this->pending.size());
+  header.reserved = 0u;
+  header.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _time).count();
+  Append(this->frame, header);
+
+  for (auto &msg : this->pending)
+  {
+    SensorBundleEntryHeader entry;
+    entry.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        msg.time).count();
+    entry.topicSize = static_cast<uint32_t>(msg.topic.size());
+    entry.typeSize = static_cast<uint32_t>(msg.type.size());
+    entry.messageSize = msg.data.size();
+    Append(this->frame, entry);
+    this->frame += msg.topic;
+    this->frame += msg.type;
+    this->frame += msg.data;
+    this->frame.resize((this->frame.size() + 7u) & ~std::size_t(7u), '\0');
+    this->spare.push_back(std::move(msg));
+  }
+  this->pending.clear();
+}
+
+//////////////////////////////////////////////////
+SensorBundle::SensorBundle()
+  : dataPtr(new SensorBundlePrivate)
+{
+}
+
+//////////////////////////////////////////////////
+SensorBundle::~SensorBundle() = default;
+
+//////////////////////////////////////////////////
+bool SensorBundle::Advertise(const std::string &_topic)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->pub = this->dataPtr->node.Advertise(_topic,
+      SensorBundleType());
+  if (!this->dataPtr->pub)
+  {
+    gzerr << "Unable to advertise sensor bundle topic [" << _topic << "]."
+          << std::endl;
+    this->dataPtr->topic.clear();
+    return false;
+  }
+  this->dataPtr->topic = _topic;
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::string SensorBundle::Topic() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->topic;
+}
+
+//////////////////////////////////////////////////
+void SensorBundle::SetPrimary(const std::string &_sensor)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->primary = _sensor;
+  this->dataPtr->primaryAdded = false;
+}
+
+//////////////////////////////////////////////////
+std::string SensorBundle::Primary() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->primary;
+}
+
+//////////////////////////////////////////////////
+void SensorBundle::SetFrameCallback(FrameCallback _callback)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->frameCallback = std::move(_callback);
+}
+
+//////////////////////////////////////////////////
+void SensorBundle::SetMaxPending(std::size_t _count)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->maxPending = std::max<std::size_t>(1u, _count);
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorBundle::MaxPending() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->maxPending;
+}
+
+//////////////////////////////////////////////////
+bool SensorBundle::HasConnections() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->frameCallback ||
+      (this->dataPtr->pub && this->dataPtr->pub.HasConnections());
+}
+
+//////////////////////////////////////////////////
+void SensorBundle::Add(const std::string &_sensor,
+    const std::string &_topic, const google::protobuf::Message &_msg,
+    const std::chrono::steady_clock::duration &_time)
+{
+  if (!this->HasConnections())
+    return;
+
+  GZ_PROFILE("SensorBundle::Add");
+  SensorBundlePrivate::Pending msg;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    if (!this->dataPtr->spare.empty())
+    {
+      msg = std::move(this->dataPtr->spare.back());
+      this->dataPtr->spare.pop_back();
+    }
+  }
+
+  // Serialize outside of the lock, sensors may add concurrently
+  msg.time = _time;
+  msg.topic = _topic;
+  msg.type = _msg.GetTypeName();
+  if (!_msg.SerializeToString(&msg.data))
+  {
+    gzerr << "Unable to serialize message of type [" << msg.type
+          << "] for sensor bundle [" << this->Topic() << "]." << std::endl;
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto &pending = this->dataPtr->pending;
+  while (pending.size() >= this->dataPtr->maxPending)
+  {
+    this->dataPtr->spare.push_back(std::move(pending.front()));
+    pending.pop_front();
+    ++this->dataPtr->droppedCount;
+  }
+  pending.push_back(std::move(msg));
+  if (_sensor == this->dataPtr->primary)
+    this->dataPtr->primaryAdded = true;
+}
+
+//////////////////////////////////////////////////
+bool SensorBundle::EndUpdate(const std::string &_sensor,
+    const std::chrono::steady_clock::duration &_time)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  if (_sensor != this->dataPtr->primary || !this->dataPtr->primaryAdded)
+    return false;
+
+  GZ_PROFILE("SensorBundle::EndUpdate");
+  this->dataPtr->primaryAdded = false;
+  this->dataPtr->BuildFrame(_time);
+  ++this->dataPtr->frameCount;
+
+  const auto &frame = this->dataPtr->frame;
+  if (this->dataPtr->pub)
+    this->dataPtr->pub.PublishRaw(frame, SensorBundleType());
+  if (this->dataPtr->frameCallback)
+    this->dataPtr->frameCallback(frame.data(), frame.size());
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint64_t SensorBundle::FrameCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->frameCount;
+}
+
+//////////////////////////////////////////////////
+uint64_t SensorBundle::DroppedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->droppedCount;
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <google/protobuf/wrappers.pb.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/sensors/SensorBundle.hh"
+
+using namespace gz;
+using namespace sensors;
+using namespace std::chrono_literals;
+
+//////////////////////////////////////////////////
+TEST(SensorBundle_TEST, Frames)
+{
+  SensorBundle bundle;
+  bundle.SetPrimary("camera");
+  EXPECT_EQ("camera", bundle.Primary());
+
+  google::protobuf::DoubleValue msg;
+
+  // Without consumers nothing is gathered
+  EXPECT_FALSE(bundle.HasConnections());
+  msg.set_value(1.0);
+  bundle.Add("imu", "/imu", msg, 0ms);
+  bundle.Add("camera", "/camera", msg, 0ms);
+  EXPECT_FALSE(bundle.EndUpdate("camera", 0ms));
+
+  std::vector<std::string> frames;
+  bundle.SetFrameCallback([&frames](const char *_data, std::size_t _size)
+  {
+    frames.emplace_back(_data, _size);
+  });
+  EXPECT_TRUE(bundle.HasConnections());
+
+  // Imu samples wait for the next image
+  for (int i = 1; i <= 4; ++i)
+  {
+    msg.set_value(i);
+    bundle.Add("imu", "/imu", msg, 10ms * i);
+    EXPECT_FALSE(bundle.EndUpdate("imu", 10ms * i));
+  }
+  msg.set_value(100.0);
+  bundle.Add("camera", "/camera", msg, 40ms);
+  EXPECT_TRUE(bundle.EndUpdate("camera", 40ms));
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ(1u, bundle.FrameCount());
+
+  std::chrono::steady_clock::duration time{0};
+  std::vector<SensorBundleEntry> entries;
+  ASSERT_TRUE(ParseSensorBundle(frames[0].data(), frames[0].size(), time,
+      entries));
+  EXPECT_EQ(std::chrono::steady_clock::duration(40ms).count(), time.count());
+  ASSERT_EQ(5u, entries.size());
+  for (std::size_t i = 0u; i < entries.size(); ++i)
+  {
+    const bool image = i == 4u;
+    EXPECT_EQ(image ? "/camera" : "/imu", entries[i].topic);
+    EXPECT_EQ("google.protobuf.DoubleValue", entries[i].type);
+    const std::chrono::steady_clock::duration expected =
+        image ? 40ms : 10ms * static_cast<int>(i + 1);
+    EXPECT_EQ(expected.count(), entries[i].time.count());
+    google::protobuf::DoubleValue parsed;
+    ASSERT_TRUE(parsed.ParseFromArray(entries[i].message,
+        static_cast<int>(entries[i].messageSize)));
+    EXPECT_DOUBLE_EQ(image ? 100.0 : i + 1.0, parsed.value());
+  }
+
+  // An update of the first sensor without messages doesn't close a frame
+  EXPECT_FALSE(bundle.EndUpdate("camera", 80ms));
+
+  // Truncated frames are rejected
+  EXPECT_FALSE(ParseSensorBundle(frames[0].data(), frames[0].size() - 9u,
+      time, entries));
+  EXPECT_FALSE(ParseSensorBundle(frames[0].data(), 4u, time, entries));
+}
+
+//////////////////////////////////////////////////
+TEST(SensorBundle_TEST, MaxPending)
+{
+  SensorBundle bundle;
+  bundle.SetPrimary("camera");
+  bundle.SetMaxPending(3u);
+  EXPECT_EQ(3u, bundle.MaxPending());
+
+  std::vector<std::string> frames;
+  bundle.SetFrameCallback([&frames](const char *_data, std::size_t _size)
+  {
+    frames.emplace_back(_data, _size);
+  });
+
+  google::protobuf::DoubleValue msg;
+  for (int i = 0; i < 5; ++i)
+  {
+    msg.set_value(i);
+    bundle.Add("imu", "/imu", msg, 1ms * i);
+  }
+  EXPECT_EQ(2u, bundle.DroppedCount());
+
+  bundle.Add("camera", "/camera", msg, 5ms);
+  EXPECT_TRUE(bundle.EndUpdate("camera", 5ms));
+  ASSERT_EQ(1u, frames.size());
+
+  // The oldest messages were dropped
+  std::chrono::steady_clock::duration time{0};
+  std::vector<SensorBundleEntry> entries;
+  ASSERT_TRUE(ParseSensorBundle(frames[0].data(), frames[0].size(), time,
+      entries));
+  ASSERT_EQ(3u, entries.size());
+  EXPECT_EQ(std::chrono::steady_clock::duration(3ms).count(),
+      entries[0].time.count());
+  EXPECT_EQ("/camera", entries[2].topic);
+  EXPECT_EQ(3u, bundle.DroppedCount());
+}
+
+//////////////////////////////////////////////////
+TEST(SensorBundle_TEST, Concurrent)
+{
+  SensorBundle bundle;
+  bundle.SetPrimary("camera");
+  bundle.SetMaxPending(100000u);
+  std::size_t count = 0u;
+  bundle.SetFrameCallback([&count](const char *_data, std::size_t _size)
+  {
+    std::chrono::steady_clock::duration time{0};
+    std::vector<SensorBundleEntry> entries;
+    if (ParseSensorBundle(_data, _size, time, entries))
+      count += entries.size();
+  });
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&bundle, t]()
+    {
+      google::protobuf::DoubleValue msg;
+      msg.set_value(t);
+      for (int i = 0; i < 1000; ++i)
+        bundle.Add("imu" + std::to_string(t), "/imu", msg, 1ms * i);
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  google::protobuf::DoubleValue msg;
+  bundle.Add("camera", "/camera", msg, 1s);
+  EXPECT_TRUE(bundle.EndUpdate("camera", 1s));
+  EXPECT_EQ(4001u, count);
+}
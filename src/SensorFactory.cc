@@ -15,18 +15,99 @@
  *
 */
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
 #include <gz/common/Console.hh>
 
 #include "gz/sensors/SensorFactory.hh"
+#include "gz/sensors/Util.hh"
 
 /// \brief Private data class for SensorFactory
 class gz::sensors::SensorFactoryPrivate
 {
+  /// \brief Create, load and initialize a sensor of a custom type.
+  /// \param[in] _type Custom type of the sensor.
+  /// \param[in] _name Name of the sensor, for error messages.
+  /// \param[in] _load Loads the created sensor.
+  /// \return The sensor, null on error.
+  public: std::unique_ptr<Sensor> CreateCustomSensor(
+              const std::string &_type, const std::string &_name,
+              const std::function<bool(Sensor &)> &_load) const;
+
+  /// \brief Registered custom sensor types.
+  public: static std::unordered_map<std::string,
+              SensorFactory::CustomSensorConstructor> &CustomTypes();
+
+  /// \brief Protects the registered custom sensor types.
+  public: static std::mutex customTypesMutex;
+
+  /// \brief True if created sensors defer their advertisements.
+  public: bool advertiseDeferred{false};
 };
 
 using namespace gz;
 using namespace sensors;
 
+std::mutex SensorFactoryPrivate::customTypesMutex;
+
+//////////////////////////////////////////////////
+std::unordered_map<std::string, SensorFactory::CustomSensorConstructor> &
+SensorFactoryPrivate::CustomTypes()
+{
+  static std::unordered_map<std::string,
+      SensorFactory::CustomSensorConstructor> types;
+  return types;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<Sensor> SensorFactoryPrivate::CreateCustomSensor(
+    const std::string &_type, const std::string &_name,
+    const std::function<bool(Sensor &)> &_load) const
+{
+  SensorFactory::CustomSensorConstructor constructor;
+  {
+    std::lock_guard<std::mutex> lock(customTypesMutex);
+    auto it = CustomTypes().find(_type);
+    if (it != CustomTypes().end())
+      constructor = it->second;
+  }
+  if (!constructor)
+  {
+    gzerr << "Failed to create sensor [" << _name << "], custom type ["
+          << _type << "] isn't registered." << std::endl;
+    return nullptr;
+  }
+
+  auto sensor = constructor();
+  if (nullptr == sensor)
+  {
+    gzerr << "Failed to create sensor [" << _name << "] of custom type ["
+          << _type << "]" << std::endl;
+    return nullptr;
+  }
+
+  sensor->SetAdvertiseDeferred(this->advertiseDeferred);
+
+  if (!_load(*sensor))
+  {
+    gzerr << "Failed to load sensor [" << _name << "] of custom type ["
+          << _type << "]" << std::endl;
+    return nullptr;
+  }
+
+  if (!sensor->Init())
+  {
+    gzerr << "Failed to initialize sensor [" << _name << "] of custom type ["
+          << _type << "]" << std::endl;
+    return nullptr;
+  }
+
+  return sensor;
+}
+
 //////////////////////////////////////////////////
 SensorFactory::SensorFactory() : dataPtr(new SensorFactoryPrivate)
 {
@@ -36,3 +117,81 @@ SensorFactory::SensorFactory() : dataPtr(new SensorFactoryPrivate)
 SensorFactory::~SensorFactory()
 {
 }
+
+//////////////////////////////////////////////////
+void SensorFactory::SetAdvertiseDeferred(bool _deferred)
+{
+  this->dataPtr->advertiseDeferred = _deferred;
+}
+
+//////////////////////////////////////////////////
+bool SensorFactory::AdvertiseDeferred() const
+{
+  return this->dataPtr->advertiseDeferred;
+}
+
+//////////////////////////////////////////////////
+bool SensorFactory::RegisterCustomType(const std::string &_type,
+    CustomSensorConstructor _constructor)
+{
+  if (_type.empty() || !_constructor)
+  {
+    gzerr << "Custom sensor types need a name and a constructor."
+          << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(SensorFactoryPrivate::customTypesMutex);
+  if (!SensorFactoryPrivate::CustomTypes().emplace(
+      _type, std::move(_constructor)).second)
+  {
+    gzerr << "Custom sensor type [" << _type << "] is already registered."
+          << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool SensorFactory::UnregisterCustomType(const std::string &_type)
+{
+  std::lock_guard<std::mutex> lock(SensorFactoryPrivate::customTypesMutex);
+  return SensorFactoryPrivate::CustomTypes().erase(_type) > 0u;
+}
+
+//////////////////////////////////////////////////
+bool SensorFactory::HasCustomType(const std::string &_type)
+{
+  std::lock_guard<std::mutex> lock(SensorFactoryPrivate::customTypesMutex);
+  return SensorFactoryPrivate::CustomTypes().count(_type) > 0u;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<Sensor> SensorFactory::CreateCustomSensor(
+    const sdf::Sensor &_sdf)
+{
+  return this->dataPtr->CreateCustomSensor(customType(_sdf), _sdf.Name(),
+      [&_sdf](Sensor &_sensor)
+      {
+        return _sensor.Load(_sdf);
+      });
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<Sensor> SensorFactory::CreateCustomSensor(
+    sdf::ElementPtr _sdf)
+{
+  if (nullptr == _sdf)
+  {
+    gzerr << "Failed to create sensor, received null SDF "
+           << "pointer." << std::endl;
+    return nullptr;
+  }
+
+  return this->dataPtr->CreateCustomSensor(customType(_sdf),
+      _sdf->Get<std::string>("name"),
+      [&_sdf](Sensor &_sensor)
+      {
+        return _sensor.Load(_sdf);
+      });
+}
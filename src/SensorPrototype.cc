@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gz/common/Console.hh>
+
+#include "gz/sensors/SensorPrototype.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Private data for SensorPrototype
+class gz::sensors::SensorPrototypePrivate
+{
+  /// \brief Parsed sensor description.
+  public: sdf::Sensor sdf;
+
+  /// \brief True if the description is valid.
+  public: bool valid{false};
+};
+
+//////////////////////////////////////////////////
+SensorPrototype::SensorPrototype()
+  : dataPtr(new SensorPrototypePrivate)
+{
+}
+
+//////////////////////////////////////////////////
+SensorPrototype::SensorPrototype(const sdf::Sensor &_sdf)
+  : dataPtr(new SensorPrototypePrivate)
+{
+  this->dataPtr->sdf = _sdf;
+  this->dataPtr->valid = true;
+}
+
+//////////////////////////////////////////////////
+SensorPrototype::SensorPrototype(sdf::ElementPtr _sdf)
+  : dataPtr(new SensorPrototypePrivate)
+{
+  if (nullptr == _sdf)
+  {
+    gzerr << "Failed to create sensor prototype, received null SDF "
+          << "pointer." << std::endl;
+    return;
+  }
+
+  const sdf::Errors errors = this->dataPtr->sdf.Load(_sdf);
+  if (!errors.empty())
+  {
+    gzerr << "Failed to create sensor prototype:\n" << errors << std::endl;
+    return;
+  }
+  this->dataPtr->valid = true;
+}
+
+//////////////////////////////////////////////////
+SensorPrototype::~SensorPrototype() = default;
+
+//////////////////////////////////////////////////
+bool SensorPrototype::Valid() const
+{
+  return this->dataPtr->valid;
+}
+
+//////////////////////////////////////////////////
+const sdf::Sensor &SensorPrototype::Sdf() const
+{
+  return this->dataPtr->sdf;
+}
+
+//////////////////////////////////////////////////
+sdf::Sensor SensorPrototype::Instance(const SensorInstance &_instance) const
+{
+  sdf::Sensor sdf = this->dataPtr->sdf;
+  sdf.SetName(_instance.name);
+  if (!_instance.topic.empty())
+    sdf.SetTopic(_instance.topic);
+  return sdf;
+}
+
+//////////////////////////////////////////////////
+std::vector<sdf::Sensor> SensorPrototype::Instances(
+    const std::vector<SensorInstance> &_instances) const
+{
+  std::vector<sdf::Sensor> result;
+  result.reserve(_instances.size());
+  for (const auto &instance : _instances)
+    result.push_back(this->Instance(instance));
+  return result;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sdf/sdf.hh>
+
+#include "gz/sensors/SensorPrototype.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(SensorPrototype_TEST, Element)
+{
+  std::ostringstream stream;
+  stream
+    << "<?xml version='1.0'?>"
+    << "<sdf version='1.6'>"
+    << " <model name='m1'>"
+    << "  <link name='link1'>"
+    << "    <sensor name='imu' type='imu'>"
+    << "      <topic>robot/imu</topic>"
+    << "      <update_rate>100.0</update_rate>"
+    << "    </sensor>"
+    << "  </link>"
+    << " </model>"
+    << "</sdf>";
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  ASSERT_TRUE(sdf::readString(stream.str(), sdfParsed));
+
+  SensorPrototype prototype(sdfParsed->Root()->GetElement("model")
+      ->GetElement("link")->GetElement("sensor"));
+  ASSERT_TRUE(prototype.Valid());
+  EXPECT_EQ("imu", prototype.Sdf().Name());
+  EXPECT_EQ(sdf::SensorType::IMU, prototype.Sdf().Type());
+
+  auto sdf = prototype.Instance({"imu_7", "robot_7/imu", "robot_7::link"});
+  EXPECT_EQ("imu_7", sdf.Name());
+  EXPECT_EQ("robot_7/imu", sdf.Topic());
+  EXPECT_EQ(sdf::SensorType::IMU, sdf.Type());
+  EXPECT_DOUBLE_EQ(100.0, sdf.UpdateRate());
+
+  // The prototype is unchanged
+  EXPECT_EQ("imu", prototype.Sdf().Name());
+  EXPECT_EQ("robot/imu", prototype.Sdf().Topic());
+
+  // An empty topic keeps the prototype's
+  sdf = prototype.Instance({"imu_8", "", ""});
+  EXPECT_EQ("imu_8", sdf.Name());
+  EXPECT_EQ("robot/imu", sdf.Topic());
+
+  std::vector<SensorInstance> instances;
+  for (int i = 0; i < 10; ++i)
+  {
+    instances.push_back({"imu_" + std::to_string(i),
+        "robot_" + std::to_string(i) + "/imu", ""});
+  }
+  auto sdfs = prototype.Instances(instances);
+  ASSERT_EQ(instances.size(), sdfs.size());
+  for (std::size_t i = 0; i < sdfs.size(); ++i)
+  {
+    EXPECT_EQ(instances[i].name, sdfs[i].Name());
+    EXPECT_EQ(instances[i].topic, sdfs[i].Topic());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(SensorPrototype_TEST, Invalid)
+{
+  SensorPrototype empty;
+  EXPECT_FALSE(empty.Valid());
+
+  SensorPrototype null(sdf::ElementPtr{});
+  EXPECT_FALSE(null.Valid());
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  SensorPrototype dom(sdfSensor);
+  EXPECT_TRUE(dom.Valid());
+  EXPECT_EQ(sdf::SensorType::CUSTOM, dom.Sdf().Type());
+}
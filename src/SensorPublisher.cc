@@ -0,0 +1,655 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4005)
+#pragma warning(disable: 4251)
+#endif
+#include <gz/msgs/statistic.pb.h>
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+#include "SensorPublisher.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+#include <gz/transport/TopicUtils.hh>
+
+#include "gz/sensors/RawPayload.hh"
+#include "gz/sensors/SensorBundle.hh"
+#include "gz/sensors/SensorRecorder.hh"
+#include "gz/sensors/SensorReplay.hh"
+
+#include "RawPayloadEncoder.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+SensorPublisher::SensorPublisher(transport::Node &_node,
+    const std::string &_name, const std::string &_topic,
+    const SensorSchedule &_schedule)
+  : node(_node), name(_name), topic(_topic), schedule(_schedule)
+{
+}
+
+//////////////////////////////////////////////////
+SensorPublishResult SensorPublisher::Publish(
+    transport::Node::Publisher &_pub, const google::protobuf::Message &_msg)
+{
+  this->Record(_pub, _msg);
+
+  // Protobuf subscribers still get messages also published raw
+  if (this->rawPayloadOutput && this->PublishRawPayload(_pub, _msg) &&
+      !_pub.HasConnections())
+  {
+    return SensorPublishResult::SENT;
+  }
+
+  if (this->outputDelay > std::chrono::steady_clock::duration::zero())
+  {
+    if (!_pub)
+      return SensorPublishResult::REFUSED;
+
+    this->PushDelayed(_pub, [&_msg](DelayBuffer &_buffer,
+        const std::chrono::steady_clock::duration &_release)
+    {
+      _buffer.Push(_release, _msg);
+    });
+    return SensorPublishResult::SENT;
+  }
+
+  if (!this->asyncPublish)
+  {
+    return _pub.Publish(_msg) ? SensorPublishResult::SENT :
+        SensorPublishResult::FAILED;
+  }
+
+  if (!_pub || !this->AcceptsQueued(_pub))
+    return SensorPublishResult::REFUSED;
+
+  std::unique_ptr<google::protobuf::Message> copy(_msg.New());
+  copy->CopyFrom(_msg);
+  this->Queue(_pub).Push(std::move(copy));
+  return SensorPublishResult::SENT;
+}
+
+//////////////////////////////////////////////////
+SensorPublishResult SensorPublisher::Publish(
+    transport::Node::Publisher &_pub, google::protobuf::Message &&_msg)
+{
+  this->Record(_pub, _msg);
+
+  // Protobuf subscribers still get messages also published raw
+  if (this->rawPayloadOutput && this->PublishRawPayload(_pub, _msg) &&
+      !_pub.HasConnections())
+  {
+    return SensorPublishResult::SENT;
+  }
+
+  if (this->outputDelay > std::chrono::steady_clock::duration::zero())
+  {
+    if (!_pub)
+      return SensorPublishResult::REFUSED;
+
+    this->PushDelayed(_pub, [&_msg](DelayBuffer &_buffer,
+        const std::chrono::steady_clock::duration &_release)
+    {
+      _buffer.Push(_release, std::move(_msg));
+    });
+    return SensorPublishResult::SENT;
+  }
+
+  if (!this->asyncPublish)
+  {
+    return _pub.Publish(_msg) ? SensorPublishResult::SENT :
+        SensorPublishResult::FAILED;
+  }
+
+  if (!_pub || !this->AcceptsQueued(_pub))
+    return SensorPublishResult::REFUSED;
+
+  std::unique_ptr<google::protobuf::Message> queued(_msg.New());
+  queued->GetReflection()->Swap(queued.get(), &_msg);
+  this->Queue(_pub).Push(std::move(queued));
+  return SensorPublishResult::SENT;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetSampleTime(
+    const std::chrono::steady_clock::duration &_now)
+{
+  this->sampleTime = _now;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::EndUpdate(
+    const std::chrono::steady_clock::duration &_now)
+{
+  if (this->bundle)
+    this->bundle->EndUpdate(this->name, _now);
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetAsync(bool _async)
+{
+  this->asyncPublish = _async;
+  if (!_async)
+    this->publishQueues.clear();
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::Async() const
+{
+  return this->asyncPublish;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetAsyncDepth(std::size_t _depth)
+{
+  this->asyncPublishDepth = std::max<std::size_t>(_depth, 1u);
+  for (auto &queue : this->publishQueues)
+    queue.second->SetDepth(this->asyncPublishDepth);
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorPublisher::AsyncDepth() const
+{
+  return this->asyncPublishDepth;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetBackpressureLimits(std::size_t _depth,
+    std::size_t _bytes)
+{
+  this->backpressureDepth = _depth;
+  this->backpressureBytes = _bytes;
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorPublisher::BackpressureDepth() const
+{
+  return this->backpressureDepth;
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorPublisher::BackpressureBytes() const
+{
+  return this->backpressureBytes;
+}
+
+//////////////////////////////////////////////////
+uint64_t SensorPublisher::DroppedCount() const
+{
+  uint64_t count = 0u;
+  for (const auto &queue : this->publishQueues)
+    count += queue.second->DroppedCount();
+  return count;
+}
+
+//////////////////////////////////////////////////
+uint64_t SensorPublisher::SkippedCount() const
+{
+  return this->backpressureSkipped;
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::SkipBackpressured()
+{
+  // Recorded sensors keep producing data
+  if (this->recorder || !this->Backpressured())
+    return false;
+
+  ++this->backpressureSkipped;
+  return true;
+}
+
+//////////////////////////////////////////////////
+PublishQueue &SensorPublisher::Queue(const transport::Node::Publisher &_pub)
+{
+  auto &queue = this->publishQueues[&_pub];
+  if (!queue)
+    queue = std::make_unique<PublishQueue>(_pub, this->asyncPublishDepth);
+  return *queue;
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::Congested(const PublishQueue &_queue) const
+{
+  return (this->backpressureDepth > 0u &&
+          _queue.PendingCount() >= this->backpressureDepth) ||
+         (this->backpressureBytes > 0u &&
+          _queue.PendingBytes() >= this->backpressureBytes);
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::AcceptsQueued(const transport::Node::Publisher &_pub)
+{
+  auto &queue = this->Queue(_pub);
+  if (!this->Congested(queue))
+    return true;
+  queue.CountDropped();
+  return false;
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::Backpressured() const
+{
+  if (!this->asyncPublish ||
+      (this->backpressureDepth == 0u && this->backpressureBytes == 0u))
+  {
+    return false;
+  }
+
+  // Topics without subscribers don't need the data either
+  bool congested = false;
+  for (const auto &queue : this->publishQueues)
+  {
+    if (this->Congested(*queue.second))
+      congested = true;
+    else if (queue.second->HasConnections())
+      return false;
+  }
+  return congested;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::PublishBackpressure()
+{
+  if (this->backpressureDepth == 0u && this->backpressureBytes == 0u)
+    return;
+
+  if (!this->backpressurePub)
+  {
+    const auto validTopic = transport::TopicUtils::AsValidTopic(
+      this->topic + "/performance_metrics/backpressure");
+    if (validTopic.empty())
+    {
+      gzerr << "Failed to set backpressure topic [" << this->topic << "]" <<
+        std::endl;
+      return;
+    }
+    this->backpressurePub =
+        this->node.Advertise<msgs::StatisticsGroup>(validTopic);
+  }
+  if (!this->backpressurePub || !this->backpressurePub.HasConnections())
+    return;
+
+  // Skipped updates, then the dropped messages of each topic
+  msgs::StatisticsGroup msg;
+  msg.set_name(this->name);
+  auto statistic = msg.add_statistics();
+  statistic->set_type(msgs::Statistic::SAMPLE_COUNT);
+  statistic->set_name("skipped_updates");
+  statistic->set_value(static_cast<double>(this->backpressureSkipped));
+  for (const auto &queue : this->publishQueues)
+  {
+    statistic = msg.add_statistics();
+    statistic->set_type(msgs::Statistic::SAMPLE_COUNT);
+    statistic->set_name(queue.first->Topic() + "_dropped");
+    statistic->set_value(static_cast<double>(
+        queue.second->DroppedCount()));
+  }
+  this->backpressurePub.Publish(msg);
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::PublishNow(transport::Node::Publisher &_pub,
+    google::protobuf::Message &_msg)
+{
+  if (!this->asyncPublish)
+    return _pub.Publish(_msg);
+  if (!this->AcceptsQueued(_pub))
+    return false;
+
+  std::unique_ptr<google::protobuf::Message> queued(_msg.New());
+  queued->GetReflection()->Swap(queued.get(), &_msg);
+  this->Queue(_pub).Push(std::move(queued));
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::Record(transport::Node::Publisher &_pub,
+    const google::protobuf::Message &_msg)
+{
+  if (!this->recorder && !this->bundle)
+    return;
+
+  auto it = this->publisherTopics.find(&_pub);
+  const std::string &pubTopic =
+      it == this->publisherTopics.end() ? this->topic : it->second;
+  if (this->recorder)
+    this->recorder->Record(pubTopic, _msg, this->sampleTime);
+  if (this->bundle)
+    this->bundle->Add(this->name, pubTopic, _msg, this->sampleTime);
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::PublishReplay(
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("SensorPublisher::PublishReplay");
+
+  // After a rewind, resume with the messages of the current time
+  auto after = this->replayTime;
+  if (_now < after)
+    after = _now - std::chrono::steady_clock::duration(1);
+  this->replayTime = _now;
+
+  auto replayTopic = [this, &after, &_now](const std::string &_topic,
+      transport::Node::Publisher *_pub)
+  {
+    this->replay->Messages(_topic, after, _now,
+        [this, &_topic, _pub](const std::string &_type,
+            const std::string &_data)
+        {
+          // Recorded from another publisher of the sensor if the type
+          // doesn't match
+          if (!_pub || !*_pub || !_pub->PublishRaw(_data, _type))
+            this->RawPublisher(_topic, _type).PublishRaw(_data, _type);
+        });
+  };
+
+  bool topicReplayed = false;
+  for (auto &pub : this->publisherTopics)
+  {
+    replayTopic(pub.second, pub.first);
+    topicReplayed = topicReplayed || pub.second == this->topic;
+  }
+
+  // Messages of the publishers the sensor advertised itself are recorded
+  // under the sensor topic
+  if (!topicReplayed)
+    replayTopic(this->topic, nullptr);
+  return true;
+}
+
+//////////////////////////////////////////////////
+transport::Node::Publisher &SensorPublisher::RawPublisher(
+    const std::string &_topic, const std::string &_type)
+{
+  auto &pub = this->rawPublishers[std::make_pair(_topic, _type)];
+  if (!pub)
+  {
+    pub = this->node.Advertise(_topic, _type);
+    if (!pub)
+    {
+      gzerr << "Unable to advertise topic [" << _topic
+            << "] of type [" << _type << "]." << std::endl;
+    }
+  }
+  return pub;
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::PublishRawPayload(transport::Node::Publisher &_pub,
+    const google::protobuf::Message &_msg)
+{
+  // Publishers the sensor advertised itself have no known topic
+  auto pubTopic = this->publisherTopics.find(&_pub);
+  if (pubTopic == this->publisherTopics.end() ||
+      !RawPayloadField(_msg.GetDescriptor()))
+  {
+    return false;
+  }
+
+  const std::string type = RawPayloadType(_msg.GetDescriptor()->full_name());
+  auto &pub = this->RawPublisher(pubTopic->second + "/raw", type);
+  if (!pub || !pub.HasConnections())
+    return false;
+
+  GZ_PROFILE("SensorPublisher::PublishRawPayload");
+  thread_local std::string encoded;
+  return EncodeRawPayload(_msg, encoded) && pub.PublishRaw(encoded, type);
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::HasOtherConnections() const
+{
+  for (const auto &pub : this->rawPublishers)
+  {
+    if (pub.second && pub.second.HasConnections())
+      return true;
+  }
+  return this->bundle && this->bundle->HasConnections();
+}
+
+//////////////////////////////////////////////////
+DelayBuffer &SensorPublisher::Delayed(transport::Node::Publisher &_pub)
+{
+  auto &buffer = this->delayBuffers[&_pub];
+  if (!buffer)
+  {
+    std::size_t depth = this->outputDelayDepth;
+    const double rate = this->schedule.Rate();
+    if (depth == 0u && rate > 0.0)
+    {
+      // One message per update is held for the whole delay, plus the one
+      // being pushed while the oldest is due
+      const double delay =
+          std::chrono::duration<double>(this->outputDelay).count();
+      depth = static_cast<std::size_t>(std::ceil(delay * rate)) + 1u;
+    }
+    else if (depth == 0u)
+    {
+      depth = kDefaultDelayDepth;
+    }
+    buffer = std::make_unique<DelayBuffer>(depth);
+  }
+  return *buffer;
+}
+
+//////////////////////////////////////////////////
+template <typename F>
+void SensorPublisher::PushDelayed(transport::Node::Publisher &_pub,
+    F &&_push)
+{
+  std::lock_guard<std::mutex> lock(this->delayMutex);
+  DelayBuffer &buffer = this->Delayed(_pub);
+  if (buffer.Full())
+  {
+    buffer.ReleaseOldest([this, &_pub](google::protobuf::Message &_msg)
+    {
+      this->PublishNow(_pub, _msg);
+    });
+  }
+  _push(buffer, this->sampleTime + this->outputDelay);
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::ReleaseDelayed(
+    const std::chrono::steady_clock::duration &_now)
+{
+  std::lock_guard<std::mutex> lock(this->delayMutex);
+  if (this->delayBuffers.empty())
+    return;
+
+  if (_now < this->releaseTime)
+  {
+    for (auto &buffer : this->delayBuffers)
+      buffer.second->Clear();
+  }
+  this->releaseTime = _now;
+
+  for (auto &[pub, buffer] : this->delayBuffers)
+  {
+    auto *publisher = pub;
+    buffer->Release(_now, [this, publisher](google::protobuf::Message &_msg)
+    {
+      this->PublishNow(*publisher, _msg);
+    });
+  }
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetDelay(
+    const std::chrono::steady_clock::duration &_delay)
+{
+  this->outputDelay =
+      std::max(_delay, std::chrono::steady_clock::duration::zero());
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration SensorPublisher::Delay() const
+{
+  return this->outputDelay;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetDelayDepth(std::size_t _depth)
+{
+  std::lock_guard<std::mutex> lock(this->delayMutex);
+  this->outputDelayDepth = _depth;
+  this->delayBuffers.clear();
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorPublisher::DelayDepth() const
+{
+  return this->outputDelayDepth;
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorPublisher::DelayedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->delayMutex);
+  std::size_t count = 0u;
+  for (const auto &buffer : this->delayBuffers)
+    count += buffer.second->Size();
+  return count;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::AddMemoryUsage(SensorMemoryUsage &_usage) const
+{
+  std::lock_guard<std::mutex> lock(this->delayMutex);
+  if (this->delayBuffers.empty())
+    return;
+
+  std::size_t &bytes = _usage["output_delay"];
+  for (const auto &buffer : this->delayBuffers)
+    bytes += buffer.second->SpaceUsed();
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetRecorder(std::shared_ptr<SensorRecorder> _recorder)
+{
+  this->recorder = std::move(_recorder);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorRecorder> SensorPublisher::Recorder() const
+{
+  return this->recorder;
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::Recorded() const
+{
+  return this->recorder != nullptr;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetBundle(std::shared_ptr<SensorBundle> _bundle)
+{
+  this->bundle = std::move(_bundle);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorBundle> SensorPublisher::Bundle() const
+{
+  return this->bundle;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetReplay(std::shared_ptr<SensorReplay> _replay)
+{
+  this->replay = std::move(_replay);
+  this->replayTime = std::chrono::steady_clock::duration(-1);
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::Replayed() const
+{
+  return this->replay != nullptr;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<SensorReplay> SensorPublisher::Replay() const
+{
+  return this->replay;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetRawPayloadOutput(bool _enabled)
+{
+  this->rawPayloadOutput = _enabled;
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::RawPayloadOutput() const
+{
+  return this->rawPayloadOutput;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetAdvertiseDeferred(bool _deferred)
+{
+  this->advertiseDeferred = _deferred;
+}
+
+//////////////////////////////////////////////////
+bool SensorPublisher::AdvertiseDeferred() const
+{
+  return this->advertiseDeferred;
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::DeferAdvertisement(const std::string &_topic,
+    std::function<bool()> _advertise)
+{
+  this->pendingAdvertisements.emplace_back(_topic, std::move(_advertise));
+}
+
+//////////////////////////////////////////////////
+std::vector<SensorPublisher::Advertisement>
+SensorPublisher::TakePendingAdvertisements()
+{
+  this->advertiseDeferred = false;
+  auto pending = std::move(this->pendingAdvertisements);
+  this->pendingAdvertisements.clear();
+  return pending;
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorPublisher::PendingAdvertisementCount() const
+{
+  return this->pendingAdvertisements.size();
+}
+
+//////////////////////////////////////////////////
+void SensorPublisher::SetPublisherTopic(transport::Node::Publisher &_pub,
+    const std::string &_topic)
+{
+  this->publisherTopics[&_pub] = _topic;
+}
@@ -0,0 +1,460 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SENSORPUBLISHER_HH_
+#define GZ_SENSORS_SENSORPUBLISHER_HH_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <google/protobuf/message.h>
+#include <gz/transport/Node.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Sensor.hh"
+
+#include "DelayBuffer.hh"
+#include "PublishQueue.hh"
+#include "SensorSchedule.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    // Forward declarations
+    class SensorBundle;
+    class SensorRecorder;
+    class SensorReplay;
+
+    /// \brief What happened to a message handed to SensorPublisher.
+    enum class SensorPublishResult
+    {
+      /// \brief Published, queued, held back or recorded.
+      SENT,
+
+      /// \brief Handed to the publisher, which failed to publish it.
+      FAILED,
+
+      /// \brief Not handed off, because the publisher isn't valid or its
+      /// queue is over the backpressure limits.
+      REFUSED
+    };
+
+    /// \brief Output side of a sensor: the asynchronous publish queues and
+    /// their backpressure limits, the output delay, deferred
+    /// advertisements, raw payload topics, and the recorder, replay and
+    /// bundle of the sensor. The functions of Sensor that configure the
+    /// output forward to this class.
+    class SensorPublisher
+    {
+      /// \brief A deferred advertisement and its topic name.
+      public: using Advertisement =
+                  std::pair<std::string, std::function<bool()>>;
+
+      /// \brief Constructor. All arguments are owned by the sensor and must
+      /// outlive the publisher.
+      /// \param[in] _node Node the raw payload and metrics topics are
+      /// advertised on.
+      /// \param[in] _name Name of the sensor.
+      /// \param[in] _topic Topic of the sensor.
+      /// \param[in] _schedule Schedule of the sensor, used to size the delay
+      /// buffers.
+      public: SensorPublisher(transport::Node &_node, const std::string &_name,
+                  const std::string &_topic, const SensorSchedule &_schedule);
+
+      /// \brief Publish a message on a publisher of the sensor, honoring
+      /// the output delay and asynchronous publishing, and record it.
+      /// \param[in] _pub Publisher of the message.
+      /// \param[in] _msg Message to publish.
+      /// \return What happened to the message.
+      public: SensorPublishResult Publish(transport::Node::Publisher &_pub,
+                  const google::protobuf::Message &_msg);
+
+      /// \brief Publish a message on a publisher of the sensor, moving its
+      /// contents where it has to be kept.
+      /// \param[in] _pub Publisher of the message.
+      /// \param[in] _msg Message to publish. It may be left empty.
+      /// \return What happened to the message.
+      public: SensorPublishResult Publish(transport::Node::Publisher &_pub,
+                  google::protobuf::Message &&_msg);
+
+      /// \brief Set the time of the update whose messages are published.
+      /// \param[in] _now Time of the update.
+      public: void SetSampleTime(
+                  const std::chrono::steady_clock::duration &_now);
+
+      /// \brief End the update in the bundle of the sensor, if any.
+      /// \param[in] _now Time of the update.
+      public: void EndUpdate(const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Set whether messages are published from a background thread.
+      /// \param[in] _async True to publish asynchronously.
+      public: void SetAsync(bool _async);
+
+      /// \brief Get whether messages are published from a background thread.
+      /// \return True if they're published asynchronously.
+      public: bool Async() const;
+
+      /// \brief Set the depth of the publish queues.
+      /// \param[in] _depth Queue depth. Zero is treated as one.
+      public: void SetAsyncDepth(std::size_t _depth);
+
+      /// \brief Get the depth of the publish queues.
+      /// \return Queue depth.
+      public: std::size_t AsyncDepth() const;
+
+      /// \brief Set the pending messages and bytes of a publish queue from
+      /// which it refuses new ones.
+      /// \param[in] _depth Message limit, 0 for no limit.
+      /// \param[in] _bytes Byte limit, 0 for no limit.
+      public: void SetBackpressureLimits(std::size_t _depth,
+                  std::size_t _bytes);
+
+      /// \brief Get the message limit of the publish queues.
+      /// \return Message limit, 0 for no limit.
+      public: std::size_t BackpressureDepth() const;
+
+      /// \brief Get the byte limit of the publish queues.
+      /// \return Byte limit, 0 for no limit.
+      public: std::size_t BackpressureBytes() const;
+
+      /// \brief Get the number of messages dropped by the publish queues.
+      /// \return Number of dropped messages.
+      public: uint64_t DroppedCount() const;
+
+      /// \brief Get the number of updates skipped because of backpressure.
+      /// \return Number of skipped updates.
+      public: uint64_t SkippedCount() const;
+
+      /// \brief Check whether the next update should be skipped because
+      /// every publish queue with subscribers is over the backpressure
+      /// limits, counting it as skipped if so. Recorded sensors are never
+      /// skipped.
+      /// \return True if the update should be skipped.
+      public: bool SkipBackpressured();
+
+      /// \brief Publish the backpressure metrics.
+      public: void PublishBackpressure();
+
+      /// \brief Check whether a raw payload topic or the bundle of the
+      /// sensor has subscribers.
+      /// \return True if one of them has subscribers.
+      public: bool HasOtherConnections() const;
+
+      /// \brief Set the delay between an update and the publication of its
+      /// messages.
+      /// \param[in] _delay Delay. Negative delays are treated as zero.
+      public: void SetDelay(const std::chrono::steady_clock::duration &_delay);
+
+      /// \brief Get the output delay.
+      /// \return Delay.
+      public: std::chrono::steady_clock::duration Delay() const;
+
+      /// \brief Set the number of messages each publisher can hold back.
+      /// Messages that are held back are dropped.
+      /// \param[in] _depth Number of messages, zero to size the buffers from
+      /// the delay and the update rate.
+      public: void SetDelayDepth(std::size_t _depth);
+
+      /// \brief Get the number of messages each publisher can hold back.
+      /// \return Number of messages, zero if sized from the update rate.
+      public: std::size_t DelayDepth() const;
+
+      /// \brief Get the number of messages held back.
+      /// \return Number of messages.
+      public: std::size_t DelayedCount() const;
+
+      /// \brief Publish the delayed messages whose release time has been
+      /// reached. Held messages are dropped if time went backwards, such as
+      /// after a world reset.
+      /// \param[in] _now Current time.
+      public: void ReleaseDelayed(
+                  const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Add the memory held back by the output delay to a report.
+      /// \param[in,out] _usage Report to add to.
+      public: void AddMemoryUsage(SensorMemoryUsage &_usage) const;
+
+      /// \brief Set the recorder of the published messages.
+      /// \param[in] _recorder Recorder, null to stop recording.
+      public: void SetRecorder(std::shared_ptr<SensorRecorder> _recorder);
+
+      /// \brief Get the recorder of the published messages.
+      /// \return Recorder, null if not recorded.
+      public: std::shared_ptr<SensorRecorder> Recorder() const;
+
+      /// \brief Check whether the published messages are recorded.
+      /// \return True if there's a recorder.
+      public: bool Recorded() const;
+
+      /// \brief Set the bundle the published messages are added to.
+      /// \param[in] _bundle Bundle, null if the sensor isn't bundled.
+      public: void SetBundle(std::shared_ptr<SensorBundle> _bundle);
+
+      /// \brief Get the bundle the published messages are added to.
+      /// \return Bundle, null if the sensor isn't bundled.
+      public: std::shared_ptr<SensorBundle> Bundle() const;
+
+      /// \brief Set the replay whose messages are published in place of
+      /// updates.
+      /// \param[in] _replay Replay, null to stop replaying.
+      public: void SetReplay(std::shared_ptr<SensorReplay> _replay);
+
+      /// \brief Check whether the sensor is replayed.
+      /// \return True if it has a replay.
+      public: bool Replayed() const;
+
+      /// \brief Get the replay whose messages are published in place of
+      /// updates.
+      /// \return Replay, null if the sensor isn't replayed.
+      public: std::shared_ptr<SensorReplay> Replay() const;
+
+      /// \brief Publish the recorded messages of the sensor's topics up to a
+      /// time, in place of an update.
+      /// \param[in] _now The current time.
+      /// \return True.
+      public: bool PublishReplay(
+                  const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Set whether messages with a payload are also published in
+      /// the raw payload layout.
+      /// \param[in] _enabled True to publish raw payloads.
+      public: void SetRawPayloadOutput(bool _enabled);
+
+      /// \brief Get whether raw payloads are published.
+      /// \return True if they're published.
+      public: bool RawPayloadOutput() const;
+
+      /// \brief Set whether advertisements are held back until
+      /// TakePendingAdvertisements is called.
+      /// \param[in] _deferred True to defer advertisements.
+      public: void SetAdvertiseDeferred(bool _deferred);
+
+      /// \brief Get whether advertisements are deferred.
+      /// \return True if they're deferred.
+      public: bool AdvertiseDeferred() const;
+
+      /// \brief Queue an advertisement.
+      /// \param[in] _topic Topic or service name, for error messages.
+      /// \param[in] _advertise Makes the advertisement, returns true on
+      /// success.
+      public: void DeferAdvertisement(const std::string &_topic,
+                  std::function<bool()> _advertise);
+
+      /// \brief Stop deferring advertisements and take the queued ones, in
+      /// the order they were requested.
+      /// \return The queued advertisements.
+      public: std::vector<Advertisement> TakePendingAdvertisements();
+
+      /// \brief Get the number of queued advertisements.
+      /// \return Number of advertisements.
+      public: std::size_t PendingAdvertisementCount() const;
+
+      /// \brief Remember the topic of a publisher, under which its messages
+      /// are recorded.
+      /// \param[in] _pub Publisher owned by the sensor.
+      /// \param[in] _topic Topic name.
+      public: void SetPublisherTopic(transport::Node::Publisher &_pub,
+                  const std::string &_topic);
+
+      /// \brief Get the publish queue of a publisher, creating it if needed.
+      /// \param[in] _pub A publisher of the sensor.
+      /// \return The publish queue.
+      private: PublishQueue &Queue(const transport::Node::Publisher &_pub);
+
+      /// \brief Publish a message right away, or queue it when asynchronous
+      /// publishing is enabled. The contents of _msg are moved to the queue.
+      /// \param[in] _pub A publisher of the sensor.
+      /// \param[in] _msg Message to publish.
+      /// \return True if the message was published or queued.
+      private: bool PublishNow(transport::Node::Publisher &_pub,
+                   google::protobuf::Message &_msg);
+
+      /// \brief Check whether a publish queue is over the backpressure
+      /// limits.
+      /// \param[in] _queue The queue.
+      /// \return True if it's over a limit.
+      private: bool Congested(const PublishQueue &_queue) const;
+
+      /// \brief Check whether a message of a publisher can be queued,
+      /// counting it as dropped otherwise. Publishing must be asynchronous.
+      /// \param[in] _pub A publisher of the sensor.
+      /// \return False if its queue is over the backpressure limits.
+      private: bool AcceptsQueued(const transport::Node::Publisher &_pub);
+
+      /// \brief Check whether every publish queue with subscribers is over
+      /// the backpressure limits, so an update would only produce dropped
+      /// data.
+      /// \return True if the update should be skipped.
+      private: bool Backpressured() const;
+
+      /// \brief Record a message, if there's a recorder, and add it to the
+      /// bundle of the sensor.
+      /// \param[in] _pub Publisher of the message.
+      /// \param[in] _msg Message to record.
+      private: void Record(transport::Node::Publisher &_pub,
+                   const google::protobuf::Message &_msg);
+
+      /// \brief Get a publisher of serialized messages of a topic and type,
+      /// advertising it if needed.
+      /// \param[in] _topic Topic name.
+      /// \param[in] _type Message type name.
+      /// \return The publisher.
+      private: transport::Node::Publisher &RawPublisher(
+                   const std::string &_topic, const std::string &_type);
+
+      /// \brief Publish a message with a payload in the raw payload layout,
+      /// on the topic of its publisher followed by "/raw", if that topic has
+      /// subscribers.
+      /// \param[in] _pub Publisher of the message, advertised with
+      /// Sensor::Advertise.
+      /// \param[in] _msg Message to publish.
+      /// \return True if the message was published.
+      private: bool PublishRawPayload(transport::Node::Publisher &_pub,
+                   const google::protobuf::Message &_msg);
+
+      /// \brief Get the delay buffer of a publisher, creating it if needed.
+      /// delayMutex must be locked.
+      /// \param[in] _pub A publisher of the sensor.
+      /// \return The delay buffer.
+      private: DelayBuffer &Delayed(transport::Node::Publisher &_pub);
+
+      /// \brief Hold a message in the delay buffer of its publisher. When
+      /// the buffer is full, its oldest message is published early.
+      /// \param[in] _pub A publisher of the sensor.
+      /// \param[in] _push Moves or copies the message into the buffer, given
+      /// the release time.
+      /// \tparam F Callable taking the buffer and the release time.
+      private: template <typename F>
+               void PushDelayed(transport::Node::Publisher &_pub, F &&_push);
+
+      /// \brief Number of messages the delay buffers hold when their depth
+      /// isn't set and the sensor updates on every step.
+      private: static constexpr std::size_t kDefaultDelayDepth = 32u;
+
+      /// \brief Node of the sensor.
+      private: transport::Node &node;
+
+      /// \brief Name of the sensor.
+      private: const std::string &name;
+
+      /// \brief Topic of the sensor.
+      private: const std::string &topic;
+
+      /// \brief Schedule of the sensor.
+      private: const SensorSchedule &schedule;
+
+      /// \brief True to publish sensor data from a background thread.
+      private: bool asyncPublish{false};
+
+      /// \brief Depth of the publish queues.
+      private: std::size_t asyncPublishDepth{1u};
+
+      /// \brief Publish queue of each publisher of the sensor, keyed by the
+      /// address of the publisher, which lives as long as the sensor.
+      private: std::unordered_map<const transport::Node::Publisher *,
+                   std::unique_ptr<PublishQueue>> publishQueues;
+
+      /// \brief Pending messages of a publish queue from which it refuses
+      /// new ones, 0 for no limit.
+      private: std::size_t backpressureDepth{0u};
+
+      /// \brief Pending bytes of a publish queue from which it refuses new
+      /// ones, 0 for no limit.
+      private: std::size_t backpressureBytes{0u};
+
+      /// \brief Number of updates skipped because of backpressure.
+      private: std::atomic<uint64_t> backpressureSkipped{0u};
+
+      /// \brief Publisher of the backpressure metrics.
+      private: transport::Node::Publisher backpressurePub;
+
+      /// \brief True to hold back advertisements until
+      /// TakePendingAdvertisements().
+      private: bool advertiseDeferred{false};
+
+      /// \brief Deferred advertisements, in the order they were requested.
+      private: std::vector<Advertisement> pendingAdvertisements;
+
+      /// \brief Delay between an update and the publication of its messages.
+      private: std::chrono::steady_clock::duration outputDelay{0};
+
+      /// \brief Number of messages each publisher can hold back, zero to
+      /// size the buffers from the delay and the update rate.
+      private: std::size_t outputDelayDepth{0u};
+
+      /// \brief Recorder of the published messages, null if not recorded.
+      private: std::shared_ptr<SensorRecorder> recorder;
+
+      /// \brief Bundle the published messages are added to, null if the
+      /// sensor isn't bundled.
+      private: std::shared_ptr<SensorBundle> bundle;
+
+      /// \brief Topic of each publisher advertised with Sensor::Advertise.
+      private: std::unordered_map<transport::Node::Publisher *,
+                   std::string> publisherTopics;
+
+      /// \brief Replay whose messages are published in place of updates,
+      /// null if the sensor isn't replayed.
+      private: std::shared_ptr<SensorReplay> replay;
+
+      /// \brief Time up to which recorded messages were replayed, negative
+      /// before the first replayed update.
+      private: std::chrono::steady_clock::duration replayTime{-1};
+
+      /// \brief Publishers advertised with a message type name, for replayed
+      /// topics with no publisher of the sensor and for raw payloads, by
+      /// topic and message type.
+      private: std::map<std::pair<std::string, std::string>,
+                   transport::Node::Publisher> rawPublishers;
+
+      /// \brief True to also publish messages with a payload in the raw
+      /// payload layout.
+      private: bool rawPayloadOutput{false};
+
+      /// \brief Time of the update whose messages are being published.
+      private: std::chrono::steady_clock::duration sampleTime{0};
+
+      /// \brief Time of the last release of delayed messages.
+      private: std::chrono::steady_clock::duration releaseTime{0};
+
+      /// \brief Protects the delay buffers, as messages can be published
+      /// from worker threads.
+      private: mutable std::mutex delayMutex;
+
+      /// \brief Delay buffer of each publisher of the sensor, keyed by the
+      /// address of the publisher, which lives as long as the sensor.
+      private: std::unordered_map<transport::Node::Publisher *,
+                   std::unique_ptr<DelayBuffer>> delayBuffers;
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,757 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "gz/sensors/SensorRecorder.hh"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+
+#include "Lz4Frame.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Magic bytes at the start and end of an MCAP file.
+constexpr char kMagic[] = "\x89MCAP0\r\n";
+
+/// \brief Size of kMagic, without the terminating zero.
+constexpr std::size_t kMagicSize = sizeof(kMagic) - 1u;
+
+/// \brief MCAP record opcodes.
+enum Opcode : uint8_t
+{
+  kHeader = 0x01,
+  kFooter = 0x02,
+  kSchema = 0x03,
+  kChannel = 0x04,
+  kMessage = 0x05,
+  kChunk = 0x06,
+  kChunkIndex = 0x08,
+  kStatistics = 0x0B,
+  kDataEnd = 0x0F
+};
+
+/// \brief Table of the IEEE CRC-32 used by MCAP.
+/// \return The table.
+const std::array<uint32_t, 256> &CrcTable()
+{
+  static const std::array<uint32_t, 256> table = []
+  {
+    std::array<uint32_t, 256> values;
+    for (uint32_t i = 0u; i < 256u; ++i)
+    {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit)
+        crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+      values[i] = crc;
+    }
+    return values;
+  }();
+  return table;
+}
+
+/// \brief Continue a CRC-32 over more bytes.
+/// \param[in] _crc CRC of the previous bytes, zero for none.
+/// \param[in] _data Bytes.
+/// \param[in] _size Number of bytes.
+/// \return CRC of all the bytes.
+uint32_t Crc32(uint32_t _crc, const void *_data, std::size_t _size)
+{
+  const auto &table = CrcTable();
+  const auto *bytes = static_cast<const uint8_t *>(_data);
+  uint32_t crc = ~_crc;
+  for (std::size_t i = 0u; i < _size; ++i)
+    crc = table[(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+  return ~crc;
+}
+
+/// \brief Append a little endian integer.
+/// \param[in] _value The value.
+/// \param[out] _out String to append to.
+template <typename T>
+void Append(T _value, std::string &_out)
+{
+  for (std::size_t i = 0u; i < sizeof(T); ++i)
+    _out.push_back(static_cast<char>((_value >> (8u * i)) & 0xFFu));
+}
+
+/// \brief Append an MCAP string, its uint32 length followed by its bytes.
+/// \param[in] _value The string.
+/// \param[out] _out String to append to.
+void AppendString(const std::string &_value, std::string &_out)
+{
+  Append(static_cast<uint32_t>(_value.size()), _out);
+  _out.append(_value);
+}
+
+/// \brief Append the opcode and length of a record.
+/// \param[in] _opcode Opcode of the record.
+/// \param[in] _length Length of the record body.
+/// \param[out] _out String to append to.
+void AppendRecordHeader(uint8_t _opcode, uint64_t _length, std::string &_out)
+{
+  _out.push_back(static_cast<char>(_opcode));
+  Append(_length, _out);
+}
+
+/// \brief Append a record.
+/// \param[in] _opcode Opcode of the record.
+/// \param[in] _body Body of the record.
+/// \param[out] _out String to append to.
+void AppendRecord(uint8_t _opcode, const std::string &_body,
+    std::string &_out)
+{
+  AppendRecordHeader(_opcode, _body.size(), _out);
+  _out.append(_body);
+}
+
+/// \brief Add a file and its dependencies to a descriptor set,
+/// dependencies first.
+/// \param[in] _file File to add.
+/// \param[in,out] _added Names of the files already added.
+/// \param[out] _set Descriptor set.
+void AddFile(const google::protobuf::FileDescriptor *_file,
+    std::set<std::string> &_added, google::protobuf::FileDescriptorSet &_set)
+{
+  if (!_added.insert(_file->name()).second)
+    return;
+  for (int i = 0; i < _file->dependency_count(); ++i)
+    AddFile(_file->dependency(i), _added, _set);
+  _file->CopyTo(_set.add_file());
+}
+}
+
+/// \brief Private data for SensorRecorder
+class gz::sensors::SensorRecorderPrivate
+{
+  /// \brief Schema of a message type.
+  public: struct Schema
+  {
+    /// \brief Full name of the message type.
+    std::string name;
+
+    /// \brief Serialized FileDescriptorSet of the type.
+    std::string data;
+  };
+
+  /// \brief A topic and message type.
+  public: struct Channel
+  {
+    /// \brief Topic name.
+    std::string topic;
+
+    /// \brief Id of the schema, one plus its index in schemas.
+    uint16_t schema;
+  };
+
+  /// \brief A serialized message waiting to be written.
+  public: struct Pending
+  {
+    /// \brief Id of the channel, its index in channels.
+    uint16_t channel;
+
+    /// \brief Time in nanoseconds.
+    uint64_t time;
+
+    /// \brief Serialized message.
+    std::string data;
+  };
+
+  /// \brief Entry of the chunk index of the summary.
+  public: struct ChunkEntry
+  {
+    /// \brief Time of the first message.
+    uint64_t start;
+
+    /// \brief Time of the last message.
+    uint64_t end;
+
+    /// \brief Offset of the chunk record in the file.
+    uint64_t offset;
+
+    /// \brief Length of the chunk record.
+    uint64_t length;
+
+    /// \brief Size of the compressed records.
+    uint64_t compressedSize;
+
+    /// \brief Size of the uncompressed records.
+    uint64_t uncompressedSize;
+  };
+
+  /// \brief Main loop of the writer thread.
+  public: void Run();
+
+  /// \brief Append a message to the current chunk, with the schema and
+  /// channel records it needs. Only called by the writer thread.
+  /// \param[in] _msg Message to write.
+  public: void WriteMessage(const Pending &_msg);
+
+  /// \brief Write the current chunk to the file, if it has records.
+  public: void FlushChunk();
+
+  /// \brief Write the end of the data section, the summary, the footer and
+  /// the closing magic.
+  public: void WriteSummary();
+
+  /// \brief Write bytes to the file, updating the summary CRC.
+  /// \param[in] _data Bytes to write.
+  public: void Write(const std::string &_data);
+
+  /// \brief Append a schema record.
+  /// \param[in] _id Id of the schema.
+  /// \param[out] _out String to append to.
+  public: void AppendSchema(uint16_t _id, std::string &_out) const;
+
+  /// \brief Append a channel record.
+  /// \param[in] _id Id of the channel.
+  /// \param[out] _out String to append to.
+  public: void AppendChannel(uint16_t _id, std::string &_out) const;
+
+  /// \brief Chunk compression of the next files.
+  public: SensorRecorderCompression compression{
+      SensorRecorderCompression::LZ4};
+
+  /// \brief Chunk size of the next files.
+  public: std::size_t chunkSize{4u * 1024u * 1024u};
+
+  /// \brief Maximum number of queued bytes.
+  public: std::size_t queueSize{256u * 1024u * 1024u};
+
+  /// \brief Protects the members below, up to the writer thread state.
+  public: mutable std::mutex mutex;
+
+  /// \brief Notifies the writer thread of queued messages or of a stop.
+  public: std::condition_variable cv;
+
+  /// \brief Schemas of the current file.
+  public: std::vector<Schema> schemas;
+
+  /// \brief Id of the schema of each message type.
+  public: std::unordered_map<std::string, uint16_t> schemaIds;
+
+  /// \brief Channels of the current file.
+  public: std::vector<Channel> channels;
+
+  /// \brief Id of the channel of each topic and message type.
+  public: std::map<std::pair<std::string, std::string>, uint16_t> channelIds;
+
+  /// \brief Messages waiting for the writer thread.
+  public: std::deque<Pending> queue;
+
+  /// \brief Serialized bytes in queue.
+  public: std::size_t queuedBytes{0u};
+
+  /// \brief Number of messages accepted for the current file.
+  public: uint64_t recorded{0u};
+
+  /// \brief Number of messages dropped for the current file.
+  public: uint64_t dropped{0u};
+
+  /// \brief True to make the writer thread exit once the queue is empty.
+  public: bool stop{false};
+
+  /// \brief True while a file is open.
+  public: bool open{false};
+
+  /// \brief Writer thread.
+  public: std::thread thread;
+
+  /// \brief The file, only used by the writer thread while it runs.
+  public: std::FILE *file{nullptr};
+
+  /// \brief Compression of the current file.
+  public: SensorRecorderCompression fileCompression{
+      SensorRecorderCompression::LZ4};
+
+  /// \brief Chunk size of the current file.
+  public: std::size_t fileChunkSize{0u};
+
+  /// \brief Number of bytes written to the file.
+  public: uint64_t offset{0u};
+
+  /// \brief CRC of the summary written so far.
+  public: uint32_t crc{0u};
+
+  /// \brief Uncompressed records of the current chunk.
+  public: std::string chunk;
+
+  /// \brief Time of the first message of the current chunk.
+  public: uint64_t chunkStart{0u};
+
+  /// \brief Time of the last message of the current chunk.
+  public: uint64_t chunkEnd{0u};
+
+  /// \brief True if the current chunk has a message.
+  public: bool chunkHasMessage{false};
+
+  /// \brief Compressed chunk, reused across chunks.
+  public: std::string compressed;
+
+  /// \brief Record being written, reused across records.
+  public: std::string record;
+
+  /// \brief True for the schemas that have a record in the data section.
+  public: std::vector<bool> schemasWritten;
+
+  /// \brief True for the channels that have a record in the data section.
+  public: std::vector<bool> channelsWritten;
+
+  /// \brief Next sequence number of each channel.
+  public: std::vector<uint32_t> sequences;
+
+  /// \brief Chunks written to the file.
+  public: std::vector<ChunkEntry> chunkIndex;
+
+  /// \brief Number of messages written.
+  public: uint64_t messageCount{0u};
+
+  /// \brief Time of the first message written.
+  public: uint64_t messageStart{0u};
+
+  /// \brief Time of the last message written.
+  public: uint64_t messageEnd{0u};
+};
+
+//////////////////////////////////////////////////
+void SensorRecorderPrivate::Write(const std::string &_data)
+{
+  std::fwrite(_data.data(), 1u, _data.size(), this->file);
+  this->crc = Crc32(this->crc, _data.data(), _data.size());
+  this->offset += _data.size();
+}
+
+//////////////////////////////////////////////////
+void SensorRecorderPrivate::AppendSchema(uint16_t _id,
+    std::string &_out) const
+{
+  const Schema &schema = this->schemas[_id - 1u];
+  std::string body;
+  Append(_id, body);
+  AppendString(schema.name, body);
+  AppendString("protobuf", body);
+  AppendString(schema.data, body);
+  AppendRecord(kSchema, body, _out);
+}
+
+//////////////////////////////////////////////////
+void SensorRecorderPrivate::AppendChannel(uint16_t _id,
+    std::string &_out) const
+{
+  const Channel &channel = this->channels[_id];
+  std::string body;
+  Append(_id, body);
+  Append(channel.schema, body);
+  AppendString(channel.topic, body);
+  AppendString("protobuf", body);
+  Append(uint32_t{0u}, body);
+  AppendRecord(kChannel, body, _out);
+}
+
+//////////////////////////////////////////////////
+void SensorRecorderPrivate::WriteMessage(const Pending &_msg)
+{
+  if (_msg.channel >= this->channelsWritten.size() ||
+      !this->channelsWritten[_msg.channel])
+  {
+    // Schemas and channels are added by Record while this thread runs
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->channelsWritten.resize(this->channels.size(), false);
+    this->schemasWritten.resize(this->schemas.size(), false);
+    this->sequences.resize(this->channels.size(), 0u);
+    const uint16_t schema = this->channels[_msg.channel].schema;
+    if (!this->schemasWritten[schema - 1u])
+    {
+      this->AppendSchema(schema, this->chunk);
+      this->schemasWritten[schema - 1u] = true;
+    }
+    this->AppendChannel(_msg.channel, this->chunk);
+    this->channelsWritten[_msg.channel] = true;
+  }
+
+  AppendRecordHeader(kMessage, 2u + 4u + 8u + 8u + _msg.data.size(),
+      this->chunk);
+  Append(_msg.channel, this->chunk);
+  Append(this->sequences[_msg.channel]++, this->chunk);
+  Append(_msg.time, this->chunk);
+  Append(_msg.time, this->chunk);
+  this->chunk.append(_msg.data);
+
+  if (!this->chunkHasMessage || _msg.time < this->chunkStart)
+    this->chunkStart = _msg.time;
+  if (!this->chunkHasMessage || _msg.time > this->chunkEnd)
+    this->chunkEnd = _msg.time;
+  if (this->messageCount == 0u || _msg.time < this->messageStart)
+    this->messageStart = _msg.time;
+  if (this->messageCount == 0u || _msg.time > this->messageEnd)
+    this->messageEnd = _msg.time;
+  this->chunkHasMessage = true;
+  ++this->messageCount;
+
+  if (this->chunk.size() >= this->fileChunkSize)
+    this->FlushChunk();
+}
+
+//////////////////////////////////////////////////
+void SensorRecorderPrivate::FlushChunk()
+{
+  if (this->chunk.empty())
+    return;
+  GZ_PROFILE("SensorRecorder::FlushChunk");
+
+  const bool lz4 = this->fileCompression == SensorRecorderCompression::LZ4;
+  const std::string *records = &this->chunk;
+  if (lz4)
+  {
+    this->compressed.clear();
+    Lz4CompressFrame(this->chunk.data(), this->chunk.size(),
+        this->compressed);
+    records = &this->compressed;
+  }
+  const std::string compression = lz4 ? "lz4" : "";
+
+  ChunkEntry entry;
+  entry.start = this->chunkHasMessage ? this->chunkStart : 0u;
+  entry.end = this->chunkHasMessage ? this->chunkEnd : 0u;
+  entry.offset = this->offset;
+  entry.compressedSize = records->size();
+  entry.uncompressedSize = this->chunk.size();
+
+  this->record.clear();
+  const uint64_t length =
+      8u + 8u + 8u + 4u + 4u + compression.size() + 8u + records->size();
+  AppendRecordHeader(kChunk, length, this->record);
+  Append(entry.start, this->record);
+  Append(entry.end, this->record);
+  Append(entry.uncompressedSize, this->record);
+  Append(Crc32(0u, this->chunk.data(), this->chunk.size()), this->record);
+  AppendString(compression, this->record);
+  Append(static_cast<uint64_t>(records->size()), this->record);
+  this->Write(this->record);
+  this->Write(*records);
+  entry.length = 1u + 8u + length;
+  this->chunkIndex.push_back(entry);
+
+  this->chunk.clear();
+  this->chunkHasMessage = false;
+}
+
+//////////////////////////////////////////////////
+void SensorRecorderPrivate::WriteSummary()
+{
+  this->FlushChunk();
+
+  // A zero data section CRC means it isn't available, readers skip it
+  this->record.clear();
+  AppendRecordHeader(kDataEnd, 4u, this->record);
+  Append(uint32_t{0u}, this->record);
+  this->Write(this->record);
+
+  this->crc = 0u;
+  const uint64_t summaryStart = this->offset;
+  std::string summary;
+  for (std::size_t i = 0u; i < this->schemas.size(); ++i)
+    this->AppendSchema(static_cast<uint16_t>(i + 1u), summary);
+  for (std::size_t i = 0u; i < this->channels.size(); ++i)
+    this->AppendChannel(static_cast<uint16_t>(i), summary);
+
+  std::string body;
+  Append(this->messageCount, body);
+  Append(static_cast<uint16_t>(this->schemas.size()), body);
+  Append(static_cast<uint32_t>(this->channels.size()), body);
+  Append(uint32_t{0u}, body);
+  Append(uint32_t{0u}, body);
+  Append(static_cast<uint32_t>(this->chunkIndex.size()), body);
+  Append(this->messageStart, body);
+  Append(this->messageEnd, body);
+  std::string counts;
+  for (std::size_t i = 0u; i < this->sequences.size(); ++i)
+  {
+    Append(static_cast<uint16_t>(i), counts);
+    Append(static_cast<uint64_t>(this->sequences[i]), counts);
+  }
+  Append(static_cast<uint32_t>(counts.size()), body);
+  body.append(counts);
+  AppendRecord(kStatistics, body, summary);
+
+  for (const auto &entry : this->chunkIndex)
+  {
+    const std::string compression =
+        this->fileCompression == SensorRecorderCompression::LZ4 ? "lz4" : "";
+    body.clear();
+    Append(entry.start, body);
+    Append(entry.end, body);
+    Append(entry.offset, body);
+    Append(entry.length, body);
+    Append(uint32_t{0u}, body);
+    Append(uint64_t{0u}, body);
+    AppendString(compression, body);
+    Append(entry.compressedSize, body);
+    Append(entry.uncompressedSize, body);
+    AppendRecord(kChunkIndex, body, summary);
+  }
+  this->Write(summary);
+
+  // The summary CRC covers the footer up to the CRC itself
+  this->record.clear();
+  AppendRecordHeader(kFooter, 8u + 8u + 4u, this->record);
+  Append(summaryStart, this->record);
+  Append(uint64_t{0u}, this->record);
+  const uint32_t summaryCrc =
+      Crc32(this->crc, this->record.data(), this->record.size());
+  Append(summaryCrc, this->record);
+  this->record.append(kMagic, kMagicSize);
+  this->Write(this->record);
+}
+
+//////////////////////////////////////////////////
+void SensorRecorderPrivate::Run()
+{
+  std::deque<Pending> batch;
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true)
+  {
+    this->cv.wait(lock, [this]
+    {
+      return this->stop || !this->queue.empty();
+    });
+    if (this->queue.empty() && this->stop)
+      return;
+
+    std::swap(batch, this->queue);
+    this->queuedBytes = 0u;
+    lock.unlock();
+    for (const Pending &msg : batch)
+      this->WriteMessage(msg);
+    batch.clear();
+    lock.lock();
+  }
+}
+
+//////////////////////////////////////////////////
+SensorRecorder::SensorRecorder()
+  : dataPtr(new SensorRecorderPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+SensorRecorder::~SensorRecorder()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool SensorRecorder::Open(const std::string &_path)
+{
+  this->Close();
+
+  std::FILE *file = std::fopen(_path.c_str(), "wb");
+  if (!file)
+  {
+    gzerr << "Failed to create sensor recording [" << _path << "]."
+          << std::endl;
+    return false;
+  }
+
+  auto &data = *this->dataPtr;
+  std::lock_guard<std::mutex> lock(data.mutex);
+  data.file = file;
+  data.fileCompression = data.compression;
+  data.fileChunkSize = data.chunkSize;
+  data.offset = 0u;
+  data.crc = 0u;
+  data.chunk.clear();
+  data.chunkHasMessage = false;
+  data.schemas.clear();
+  data.schemaIds.clear();
+  data.channels.clear();
+  data.channelIds.clear();
+  data.schemasWritten.clear();
+  data.channelsWritten.clear();
+  data.sequences.clear();
+  data.chunkIndex.clear();
+  data.messageCount = 0u;
+  data.recorded = 0u;
+  data.dropped = 0u;
+
+  std::string header(kMagic, kMagicSize);
+  std::string body;
+  AppendString("", body);
+  AppendString("gz-sensors", body);
+  AppendRecord(kHeader, body, header);
+  data.Write(header);
+
+  data.stop = false;
+  data.open = true;
+  data.thread = std::thread(&SensorRecorderPrivate::Run, &data);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SensorRecorder::Close()
+{
+  auto &data = *this->dataPtr;
+  {
+    std::lock_guard<std::mutex> lock(data.mutex);
+    if (!data.open)
+      return;
+    data.open = false;
+    data.stop = true;
+  }
+  data.cv.notify_one();
+  data.thread.join();
+
+  data.WriteSummary();
+  std::fclose(data.file);
+  data.file = nullptr;
+}
+
+//////////////////////////////////////////////////
+bool SensorRecorder::IsOpen() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->open;
+}
+
+//////////////////////////////////////////////////
+void SensorRecorder::SetCompression(SensorRecorderCompression _compression)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->compression = _compression;
+}
+
+//////////////////////////////////////////////////
+SensorRecorderCompression SensorRecorder::Compression() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->compression;
+}
+
+//////////////////////////////////////////////////
+void SensorRecorder::SetChunkSize(std::size_t _size)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->chunkSize = _size;
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorRecorder::ChunkSize() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->chunkSize;
+}
+
+//////////////////////////////////////////////////
+void SensorRecorder::SetQueueSize(std::size_t _size)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->queueSize = _size;
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorRecorder::QueueSize() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->queueSize;
+}
+
+//////////////////////////////////////////////////
+bool SensorRecorder::Record(const std::string &_topic,
+    const google::protobuf::Message &_msg,
+    const std::chrono::steady_clock::duration &_time)
+{
+  auto &data = *this->dataPtr;
+  SensorRecorderPrivate::Pending pending;
+  pending.time = static_cast<uint64_t>(std::max<int64_t>(0,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(_time).count()));
+
+  // Serialize outside of the lock, several sensors may record at once
+  if (!_msg.SerializeToString(&pending.data))
+    return false;
+
+  const auto *descriptor = _msg.GetDescriptor();
+  std::lock_guard<std::mutex> lock(data.mutex);
+  if (!data.open)
+    return false;
+  if (pending.data.size() > data.queueSize - std::min(data.queueSize,
+      data.queuedBytes))
+  {
+    ++data.dropped;
+    return false;
+  }
+
+  auto key = std::make_pair(_topic, descriptor->full_name());
+  auto channel = data.channelIds.find(key);
+  if (channel == data.channelIds.end())
+  {
+    auto schema = data.schemaIds.find(descriptor->full_name());
+    if (schema == data.schemaIds.end())
+    {
+      google::protobuf::FileDescriptorSet files;
+      std::set<std::string> added;
+      AddFile(descriptor->file(), added, files);
+      SensorRecorderPrivate::Schema newSchema;
+      newSchema.name = descriptor->full_name();
+      files.SerializeToString(&newSchema.data);
+      data.schemas.push_back(std::move(newSchema));
+      schema = data.schemaIds.emplace(descriptor->full_name(),
+          static_cast<uint16_t>(data.schemas.size())).first;
+    }
+    data.channels.push_back({_topic, schema->second});
+    channel = data.channelIds.emplace(std::move(key),
+        static_cast<uint16_t>(data.channels.size() - 1u)).first;
+  }
+  pending.channel = channel->second;
+
+  data.queuedBytes += pending.data.size();
+  data.queue.push_back(std::move(pending));
+  ++data.recorded;
+  data.cv.notify_one();
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint64_t SensorRecorder::RecordedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->recorded;
+}
+
+//////////////////////////////////////////////////
+uint64_t SensorRecorder::DroppedCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->dropped;
+}
@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/wrappers.pb.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gz/common/Filesystem.hh>
+
+#include "gz/sensors/SensorRecorder.hh"
+#include "Lz4Frame.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Minimal MCAP reader, enough to check the recordings.
+class McapReader
+{
+  /// \brief A record.
+  public: struct Record
+  {
+    /// \brief Opcode.
+    uint8_t opcode;
+
+    /// \brief Body.
+    std::string body;
+  };
+
+  /// \brief Read a little endian integer.
+  /// \param[in] _data Bytes.
+  /// \param[in,out] _pos Position, moved past the integer.
+  /// \return The integer.
+  public: template <typename T>
+  static T Read(const std::string &_data, std::size_t &_pos)
+  {
+    T value = 0;
+    for (std::size_t i = 0u; i < sizeof(T); ++i)
+    {
+      value |= static_cast<T>(
+          static_cast<T>(static_cast<uint8_t>(_data[_pos + i])) << (8u * i));
+    }
+    _pos += sizeof(T);
+    return value;
+  }
+
+  /// \brief Read an MCAP string.
+  /// \param[in] _data Bytes.
+  /// \param[in,out] _pos Position, moved past the string.
+  /// \return The string.
+  public: static std::string ReadString(const std::string &_data,
+              std::size_t &_pos)
+  {
+    const auto size = Read<uint32_t>(_data, _pos);
+    std::string value = _data.substr(_pos, size);
+    _pos += size;
+    return value;
+  }
+
+  /// \brief Split bytes into records.
+  /// \param[in] _data Bytes.
+  /// \param[in] _begin First byte of the first record.
+  /// \param[in] _end End of the last record.
+  /// \return The records.
+  public: static std::vector<Record> Records(const std::string &_data,
+              std::size_t _begin, std::size_t _end)
+  {
+    std::vector<Record> records;
+    std::size_t pos = _begin;
+    while (pos < _end)
+    {
+      Record record;
+      record.opcode = static_cast<uint8_t>(_data[pos++]);
+      const auto length = Read<uint64_t>(_data, pos);
+      EXPECT_LE(pos + length, _end);
+      record.body = _data.substr(pos, length);
+      pos += length;
+      records.push_back(record);
+    }
+    return records;
+  }
+};
+
+/// \brief Contents of a recording.
+struct Recording
+{
+  /// \brief Records of the data section, chunks expanded.
+  std::vector<McapReader::Record> data;
+
+  /// \brief Records of the summary section.
+  std::vector<McapReader::Record> summary;
+
+  /// \brief Number of chunks.
+  std::size_t chunks{0u};
+
+  /// \brief Compression of the chunks.
+  std::string compression;
+
+  /// \brief Values of the recorded StringValue messages of each topic.
+  std::map<std::string, std::vector<std::string>> values;
+
+  /// \brief Log times of the messages of each topic.
+  std::map<std::string, std::vector<uint64_t>> times;
+};
+
+/// \brief Read a recording of StringValue messages.
+/// \param[in] _path Path of the file.
+/// \return The recording.
+static Recording ReadRecording(const std::string &_path)
+{
+  Recording recording;
+  std::ifstream file(_path, std::ios::binary);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  const std::string data = stream.str();
+
+  const std::string magic("\x89MCAP0\r\n", 8u);
+  EXPECT_GT(data.size(), 2u * magic.size());
+  EXPECT_EQ(magic, data.substr(0u, magic.size()));
+  EXPECT_EQ(magic, data.substr(data.size() - magic.size()));
+
+  // The footer gives the start of the summary
+  const std::size_t footer = data.size() - magic.size() - 1u - 8u - 20u;
+  EXPECT_EQ(0x02, data[footer]);
+  std::size_t pos = footer + 9u;
+  const auto summaryStart = McapReader::Read<uint64_t>(data, pos);
+  EXPECT_EQ(0u, McapReader::Read<uint64_t>(data, pos));
+
+  std::map<uint16_t, std::string> topics;
+  auto records = McapReader::Records(data, magic.size(), summaryStart);
+  for (const auto &record : records)
+  {
+    if (record.opcode != 0x06)
+    {
+      recording.data.push_back(record);
+      continue;
+    }
+
+    ++recording.chunks;
+    std::size_t chunkPos = 16u;
+    const auto uncompressedSize =
+        McapReader::Read<uint64_t>(record.body, chunkPos);
+    McapReader::Read<uint32_t>(record.body, chunkPos);
+    recording.compression = McapReader::ReadString(record.body, chunkPos);
+    const auto size = McapReader::Read<uint64_t>(record.body, chunkPos);
+    std::string chunk = record.body.substr(chunkPos, size);
+    if (recording.compression == "lz4")
+    {
+      std::string decompressed;
+      EXPECT_TRUE(Lz4DecompressFrame(chunk.data(), chunk.size(),
+          decompressed));
+      chunk = decompressed;
+    }
+    EXPECT_EQ(uncompressedSize, chunk.size());
+    for (const auto &inner : McapReader::Records(chunk, 0u, chunk.size()))
+      recording.data.push_back(inner);
+  }
+
+  for (const auto &record : recording.data)
+  {
+    std::size_t recordPos = 0u;
+    if (record.opcode == 0x04)
+    {
+      const auto id = McapReader::Read<uint16_t>(record.body, recordPos);
+      McapReader::Read<uint16_t>(record.body, recordPos);
+      topics[id] = McapReader::ReadString(record.body, recordPos);
+    }
+    else if (record.opcode == 0x05)
+    {
+      const auto id = McapReader::Read<uint16_t>(record.body, recordPos);
+      EXPECT_EQ(1u, topics.count(id));
+      McapReader::Read<uint32_t>(record.body, recordPos);
+      const auto time = McapReader::Read<uint64_t>(record.body, recordPos);
+      McapReader::Read<uint64_t>(record.body, recordPos);
+      google::protobuf::StringValue msg;
+      EXPECT_TRUE(msg.ParseFromString(record.body.substr(recordPos)));
+      recording.values[topics[id]].push_back(msg.value());
+      recording.times[topics[id]].push_back(time);
+    }
+  }
+
+  recording.summary = McapReader::Records(data, summaryStart, footer);
+  return recording;
+}
+
+/// \brief Count the records with an opcode.
+/// \param[in] _records Records.
+/// \param[in] _opcode Opcode.
+/// \return Number of records.
+static std::size_t Count(const std::vector<McapReader::Record> &_records,
+    uint8_t _opcode)
+{
+  std::size_t count = 0u;
+  for (const auto &record : _records)
+    count += record.opcode == _opcode ? 1u : 0u;
+  return count;
+}
+
+/// \brief Make a StringValue message.
+/// \param[in] _value Value of the message.
+/// \return The message.
+static google::protobuf::StringValue Value(const std::string &_value)
+{
+  google::protobuf::StringValue msg;
+  msg.set_value(_value);
+  return msg;
+}
+
+//////////////////////////////////////////////////
+TEST(SensorRecorder, Defaults)
+{
+  SensorRecorder recorder;
+  EXPECT_FALSE(recorder.IsOpen());
+  EXPECT_EQ(SensorRecorderCompression::LZ4, recorder.Compression());
+  EXPECT_EQ(4u * 1024u * 1024u, recorder.ChunkSize());
+  EXPECT_EQ(256u * 1024u * 1024u, recorder.QueueSize());
+
+  // Nothing is recorded without a file
+  EXPECT_FALSE(recorder.Record("/a", Value("a"), std::chrono::seconds(1)));
+  EXPECT_EQ(0u, recorder.RecordedCount());
+  EXPECT_FALSE(recorder.Open(
+      common::joinPaths("missing_directory", "recording.mcap")));
+}
+
+//////////////////////////////////////////////////
+TEST(SensorRecorder, Record)
+{
+  const std::string path = "sensor_recorder_test.mcap";
+  SensorRecorder recorder;
+  recorder.SetChunkSize(512u);
+  ASSERT_TRUE(recorder.Open(path));
+  EXPECT_TRUE(recorder.IsOpen());
+
+  // Two threads recording on their own topic
+  auto record = [&recorder](const std::string &_topic)
+  {
+    for (int i = 0; i < 200; ++i)
+    {
+      EXPECT_TRUE(recorder.Record(_topic,
+          Value(_topic + " sample " + std::to_string(i)),
+          std::chrono::milliseconds(i)));
+    }
+  };
+  std::thread first(record, "/first");
+  std::thread second(record, "/second");
+  first.join();
+  second.join();
+  EXPECT_EQ(400u, recorder.RecordedCount());
+  recorder.Close();
+  EXPECT_FALSE(recorder.IsOpen());
+  // Counters are kept until the next file
+  EXPECT_EQ(400u, recorder.RecordedCount());
+  EXPECT_EQ(0u, recorder.DroppedCount());
+
+  const Recording recording = ReadRecording(path);
+  EXPECT_EQ("lz4", recording.compression);
+  EXPECT_GT(recording.chunks, 1u);
+  EXPECT_EQ(0x01, recording.data.front().opcode);
+  EXPECT_EQ(0x0F, recording.data.back().opcode);
+  EXPECT_EQ(1u, Count(recording.data, 0x03));
+  EXPECT_EQ(2u, Count(recording.data, 0x04));
+
+  // Messages of a topic keep their order
+  ASSERT_EQ(2u, recording.values.size());
+  for (const std::string topic : {"/first", "/second"})
+  {
+    const auto &values = recording.values.at(topic);
+    ASSERT_EQ(200u, values.size());
+    for (std::size_t i = 0u; i < values.size(); ++i)
+    {
+      EXPECT_EQ(topic + " sample " + std::to_string(i), values[i]);
+      EXPECT_EQ(i * 1000000u, recording.times.at(topic)[i]);
+    }
+  }
+
+  // Summary with the schema, the channels, statistics and one index entry
+  // per chunk
+  EXPECT_EQ(1u, Count(recording.summary, 0x03));
+  EXPECT_EQ(2u, Count(recording.summary, 0x04));
+  EXPECT_EQ(recording.chunks, Count(recording.summary, 0x08));
+  ASSERT_EQ(1u, Count(recording.summary, 0x0B));
+  for (const auto &summary : recording.summary)
+  {
+    if (summary.opcode == 0x0B)
+    {
+      std::size_t pos = 0u;
+      EXPECT_EQ(400u, McapReader::Read<uint64_t>(summary.body, pos));
+    }
+    else if (summary.opcode == 0x03)
+    {
+      std::size_t pos = 2u;
+      EXPECT_EQ("google.protobuf.StringValue",
+          McapReader::ReadString(summary.body, pos));
+      EXPECT_EQ("protobuf", McapReader::ReadString(summary.body, pos));
+      google::protobuf::FileDescriptorSet files;
+      EXPECT_TRUE(files.ParseFromString(
+          McapReader::ReadString(summary.body, pos)));
+      ASSERT_EQ(1, files.file_size());
+      EXPECT_EQ("google/protobuf/wrappers.proto", files.file(0).name());
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(SensorRecorder, Uncompressed)
+{
+  const std::string path = "sensor_recorder_uncompressed.mcap";
+  SensorRecorder recorder;
+  recorder.SetCompression(SensorRecorderCompression::NONE);
+  ASSERT_TRUE(recorder.Open(path));
+  EXPECT_TRUE(recorder.Record("/a", Value("one"), std::chrono::seconds(2)));
+
+  // Opening again closes the first file
+  ASSERT_TRUE(recorder.Open(path + ".second"));
+  EXPECT_EQ(0u, recorder.RecordedCount());
+  recorder.Close();
+
+  Recording recording = ReadRecording(path);
+  EXPECT_EQ(1u, recording.chunks);
+  EXPECT_EQ("", recording.compression);
+  EXPECT_EQ(std::vector<std::string>({"one"}), recording.values["/a"]);
+  EXPECT_EQ(std::vector<uint64_t>({2000000000u}), recording.times["/a"]);
+
+  // An empty recording has a summary but no chunk
+  recording = ReadRecording(path + ".second");
+  EXPECT_EQ(0u, recording.chunks);
+  EXPECT_TRUE(recording.values.empty());
+  EXPECT_EQ(1u, Count(recording.summary, 0x0B));
+}
+
+//////////////////////////////////////////////////
+TEST(SensorRecorder, QueueFull)
+{
+  SensorRecorder recorder;
+  recorder.SetQueueSize(8u);
+  ASSERT_TRUE(recorder.Open("sensor_recorder_full.mcap"));
+
+  // Messages larger than the queue never fit
+  EXPECT_FALSE(recorder.Record("/a", Value(std::string(100u, 'x')),
+      std::chrono::seconds(0)));
+  EXPECT_TRUE(recorder.Record("/a", Value("ok"), std::chrono::seconds(0)));
+  EXPECT_EQ(1u, recorder.RecordedCount());
+  EXPECT_EQ(1u, recorder.DroppedCount());
+  recorder.Close();
+
+  const Recording recording = ReadRecording("sensor_recorder_full.mcap");
+  EXPECT_EQ(std::vector<std::string>({"ok"}), recording.values.at("/a"));
+}
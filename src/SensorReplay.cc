@@ -0,0 +1,590 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include "gz/sensors/SensorReplay.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+
+#include "Lz4Frame.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Magic bytes at the start and end of an MCAP file.
+constexpr char kMagic[] = "\x89MCAP0\r\n";
+
+/// \brief Size of kMagic, without the terminating zero.
+constexpr std::size_t kMagicSize = sizeof(kMagic) - 1u;
+
+/// \brief Size of the opcode and length of a record.
+constexpr std::size_t kRecordHeaderSize = 9u;
+
+/// \brief Number of decompressed chunks kept in memory.
+constexpr std::size_t kCachedChunks = 4u;
+
+/// \brief Chunk index of messages stored outside of a chunk.
+constexpr uint32_t kNoChunk = UINT32_MAX;
+
+/// \brief MCAP record opcodes.
+enum Opcode : uint8_t
+{
+  kFooter = 0x02,
+  kSchema = 0x03,
+  kChannel = 0x04,
+  kMessage = 0x05,
+  kChunk = 0x06,
+  kDataEnd = 0x0F
+};
+
+/// \brief Reads the fields of a record body.
+class FieldReader
+{
+  /// \brief Constructor
+  /// \param[in] _data Record body.
+  /// \param[in] _size Size of the body.
+  public: FieldReader(const char *_data, std::size_t _size)
+    : data(_data), size(_size)
+  {
+  }
+
+  /// \brief Read a little endian integer.
+  /// \param[out] _value The value.
+  /// \return False if the body is too short.
+  public: template <typename T>
+  bool Read(T &_value)
+  {
+    if (this->size - this->pos < sizeof(T))
+      return false;
+    _value = 0;
+    for (std::size_t i = 0u; i < sizeof(T); ++i)
+    {
+      _value |= static_cast<T>(static_cast<uint8_t>(
+          this->data[this->pos++])) << (8u * i);
+    }
+    return true;
+  }
+
+  /// \brief Read an MCAP string or byte array with a uint32 length.
+  /// \param[out] _value The string.
+  /// \return False if the body is too short.
+  public: bool ReadString(std::string &_value)
+  {
+    uint32_t length = 0u;
+    if (!this->Read(length) || this->size - this->pos < length)
+      return false;
+    _value.assign(this->data + this->pos, length);
+    this->pos += length;
+    return true;
+  }
+
+  /// \brief Body.
+  public: const char *data;
+
+  /// \brief Size of the body.
+  public: std::size_t size;
+
+  /// \brief Position of the next field.
+  public: std::size_t pos{0u};
+};
+}
+
+/// \brief Private data for SensorReplay
+class gz::sensors::SensorReplayPrivate
+{
+  /// \brief Where a chunk is stored in the file.
+  public: struct Chunk
+  {
+    /// \brief Offset of the records in the file.
+    uint64_t offset;
+
+    /// \brief Size of the stored records.
+    uint64_t size;
+
+    /// \brief Size of the records once decompressed.
+    uint64_t uncompressedSize;
+
+    /// \brief True if the records are an LZ4 frame.
+    bool lz4;
+  };
+
+  /// \brief Where a message is stored.
+  public: struct Entry
+  {
+    /// \brief Log time in nanoseconds.
+    uint64_t time;
+
+    /// \brief Index of its chunk, kNoChunk if it's stored in the file.
+    uint32_t chunk;
+
+    /// \brief Index of its message type in types.
+    uint32_t type;
+
+    /// \brief Offset of the message data in its chunk, or in the file.
+    uint64_t offset;
+
+    /// \brief Size of the message data.
+    uint64_t size;
+  };
+
+  /// \brief Index the records of a chunk, or of the data section.
+  /// \param[in] _data Records.
+  /// \param[in] _size Size of the records.
+  /// \param[in] _chunk Index of the chunk, kNoChunk for the data section.
+  /// \param[in] _base Offset of the records in the file.
+  /// \return False if the records are malformed.
+  public: bool Index(const char *_data, std::size_t _size, uint32_t _chunk,
+              uint64_t _base);
+
+  /// \brief Index the schema, channel and message records.
+  /// \param[in] _opcode Opcode of the record.
+  /// \param[in] _body Body of the record.
+  /// \param[in] _size Size of the body.
+  /// \param[in] _chunk Index of the chunk, kNoChunk for the data section.
+  /// \param[in] _offset Offset of the body in its chunk or in the file.
+  /// \return False if the record is malformed.
+  public: bool IndexRecord(uint8_t _opcode, const char *_body,
+              std::size_t _size, uint32_t _chunk, uint64_t _offset);
+
+  /// \brief Read bytes of the file. mutex must be locked.
+  /// \param[in] _offset Offset in the file.
+  /// \param[in] _size Number of bytes.
+  /// \param[out] _out The bytes.
+  /// \return False if the bytes can't be read.
+  public: bool ReadAt(uint64_t _offset, uint64_t _size,
+              std::string &_out) const;
+
+  /// \brief Read and decompress the records of a chunk. The result of
+  /// the last reads is cached. mutex must be locked.
+  /// \param[in] _chunk Index of the chunk.
+  /// \return The records, null if they can't be read.
+  public: const std::string *ChunkRecords(uint32_t _chunk) const;
+
+  /// \brief Decompress the stored records of a chunk.
+  /// \param[in] _chunk The chunk.
+  /// \param[in] _stored Stored records.
+  /// \param[out] _out Decompressed records.
+  /// \return False if they can't be decompressed.
+  public: static bool Decompress(const Chunk &_chunk,
+              const std::string &_stored, std::string &_out);
+
+  /// \brief Protects the file and the cache.
+  public: mutable std::mutex mutex;
+
+  /// \brief Recording, null if not open.
+  public: std::FILE *file{nullptr};
+
+  /// \brief Chunks of the recording.
+  public: std::vector<Chunk> chunks;
+
+  /// \brief Full names of the message types.
+  public: std::vector<std::string> types;
+
+  /// \brief Schema id to index in types, for protobuf schemas.
+  public: std::unordered_map<uint16_t, uint32_t> schemas;
+
+  /// \brief Channel id to its topic and index in types.
+  public: std::unordered_map<uint16_t,
+              std::pair<std::string, uint32_t>> channels;
+
+  /// \brief Messages of each topic, sorted by time.
+  public: std::map<std::string, std::vector<Entry>> topics;
+
+  /// \brief Last decompressed chunks, most recently used first.
+  public: mutable std::list<std::pair<uint32_t, std::string>> cache;
+};
+
+//////////////////////////////////////////////////
+bool SensorReplayPrivate::Index(const char *_data, std::size_t _size,
+    uint32_t _chunk, uint64_t _base)
+{
+  std::size_t pos = 0u;
+  while (pos < _size)
+  {
+    FieldReader header(_data + pos, _size - pos);
+    uint8_t opcode = 0u;
+    uint64_t length = 0u;
+    if (!header.Read(opcode) || !header.Read(length) ||
+        _size - pos - kRecordHeaderSize < length)
+    {
+      return false;
+    }
+    const std::size_t body = pos + kRecordHeaderSize;
+    if (!this->IndexRecord(opcode, _data + body, length, _chunk,
+        _base + body))
+    {
+      return false;
+    }
+    pos = body + length;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool SensorReplayPrivate::IndexRecord(uint8_t _opcode, const char *_body,
+    std::size_t _size, uint32_t _chunk, uint64_t _offset)
+{
+  FieldReader reader(_body, _size);
+  if (_opcode == kSchema)
+  {
+    uint16_t id = 0u;
+    std::string name;
+    std::string encoding;
+    if (!reader.Read(id) || !reader.ReadString(name) ||
+        !reader.ReadString(encoding))
+    {
+      return false;
+    }
+    if (encoding == "protobuf" && !this->schemas.count(id))
+    {
+      this->schemas[id] = static_cast<uint32_t>(this->types.size());
+      this->types.push_back(name);
+    }
+  }
+  else if (_opcode == kChannel)
+  {
+    uint16_t id = 0u;
+    uint16_t schema = 0u;
+    std::string topic;
+    std::string encoding;
+    if (!reader.Read(id) || !reader.Read(schema) ||
+        !reader.ReadString(topic) || !reader.ReadString(encoding))
+    {
+      return false;
+    }
+    auto type = this->schemas.find(schema);
+    if (encoding != "protobuf" || type == this->schemas.end())
+    {
+      gzwarn << "Channel [" << topic << "] of the sensor replay isn't "
+             << "protobuf, its messages are skipped." << std::endl;
+      return true;
+    }
+    this->channels.emplace(id, std::make_pair(topic, type->second));
+  }
+  else if (_opcode == kMessage)
+  {
+    uint16_t channel = 0u;
+    uint32_t sequence = 0u;
+    uint64_t logTime = 0u;
+    uint64_t publishTime = 0u;
+    if (!reader.Read(channel) || !reader.Read(sequence) ||
+        !reader.Read(logTime) || !reader.Read(publishTime))
+    {
+      return false;
+    }
+    auto it = this->channels.find(channel);
+    if (it == this->channels.end())
+      return true;
+    Entry entry;
+    entry.time = logTime;
+    entry.chunk = _chunk;
+    entry.type = it->second.second;
+    entry.offset = _offset + reader.pos;
+    entry.size = _size - reader.pos;
+    this->topics[it->second.first].push_back(entry);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool SensorReplayPrivate::ReadAt(uint64_t _offset, uint64_t _size,
+    std::string &_out) const
+{
+  _out.resize(_size);
+  if (std::fseek(this->file, static_cast<long>(_offset), SEEK_SET) != 0)
+    return false;
+  return _size == 0u ||
+      std::fread(&_out[0], 1u, _size, this->file) == _size;
+}
+
+//////////////////////////////////////////////////
+bool SensorReplayPrivate::Decompress(const Chunk &_chunk,
+    const std::string &_stored, std::string &_out)
+{
+  if (!_chunk.lz4)
+  {
+    _out = _stored;
+    return true;
+  }
+  _out.clear();
+  _out.reserve(_chunk.uncompressedSize);
+  return Lz4DecompressFrame(_stored.data(), _stored.size(), _out) &&
+      _out.size() == _chunk.uncompressedSize;
+}
+
+//////////////////////////////////////////////////
+const std::string *SensorReplayPrivate::ChunkRecords(uint32_t _chunk) const
+{
+  for (auto it = this->cache.begin(); it != this->cache.end(); ++it)
+  {
+    if (it->first == _chunk)
+    {
+      this->cache.splice(this->cache.begin(), this->cache, it);
+      return &this->cache.front().second;
+    }
+  }
+
+  GZ_PROFILE("SensorReplay::ChunkRecords");
+  const Chunk &chunk = this->chunks[_chunk];
+  std::string stored;
+  std::string records;
+  if (!this->ReadAt(chunk.offset, chunk.size, stored) ||
+      !Decompress(chunk, stored, records))
+  {
+    gzerr << "Failed to read a chunk of the sensor replay." << std::endl;
+    return nullptr;
+  }
+
+  if (this->cache.size() >= kCachedChunks)
+    this->cache.pop_back();
+  this->cache.emplace_front(_chunk, std::move(records));
+  return &this->cache.front().second;
+}
+
+//////////////////////////////////////////////////
+SensorReplay::SensorReplay()
+  : dataPtr(std::make_unique<SensorReplayPrivate>())
+{
+}
+
+//////////////////////////////////////////////////
+SensorReplay::~SensorReplay()
+{
+  this->Close();
+}
+
+//////////////////////////////////////////////////
+bool SensorReplay::Open(const std::string &_path)
+{
+  GZ_PROFILE("SensorReplay::Open");
+  this->Close();
+
+  std::FILE *file = std::fopen(_path.c_str(), "rb");
+  if (!file)
+  {
+    gzerr << "Failed to open sensor replay [" << _path << "]." << std::endl;
+    return false;
+  }
+
+  auto &data = *this->dataPtr;
+  std::lock_guard<std::mutex> lock(data.mutex);
+  data.file = file;
+
+  std::string bytes;
+  bool valid = data.ReadAt(0u, kMagicSize, bytes) &&
+      bytes == std::string(kMagic, kMagicSize);
+
+  // Index the data section, record by record, up to the summary
+  uint64_t offset = kMagicSize;
+  while (valid)
+  {
+    std::string header;
+    if (!data.ReadAt(offset, kRecordHeaderSize, header))
+      break;
+    FieldReader headerReader(header.data(), header.size());
+    uint8_t opcode = 0u;
+    uint64_t length = 0u;
+    headerReader.Read(opcode);
+    headerReader.Read(length);
+    if (opcode == kDataEnd || opcode == kFooter)
+      break;
+
+    const uint64_t body = offset + kRecordHeaderSize;
+    std::string record;
+    if (!data.ReadAt(body, length, record))
+    {
+      gzwarn << "Sensor replay [" << _path << "] is truncated, its last "
+             << "record is skipped." << std::endl;
+      break;
+    }
+
+    if (opcode != kChunk)
+    {
+      valid = data.IndexRecord(opcode, record.data(), record.size(),
+          kNoChunk, body);
+    }
+    else
+    {
+      // Chunk fields: start and end times, uncompressed size and crc,
+      // compression, then the stored records
+      FieldReader reader(record.data(), record.size());
+      uint64_t start = 0u;
+      uint64_t end = 0u;
+      uint32_t crc = 0u;
+      std::string compression;
+      uint64_t size = 0u;
+      SensorReplayPrivate::Chunk chunk;
+      valid = reader.Read(start) && reader.Read(end) &&
+          reader.Read(chunk.uncompressedSize) && reader.Read(crc) &&
+          reader.ReadString(compression) && reader.Read(size) &&
+          record.size() - reader.pos >= size;
+      if (valid && compression != "" && compression != "lz4")
+      {
+        gzwarn << "Sensor replay [" << _path << "] has a chunk compressed "
+               << "with unsupported [" << compression << "], its messages "
+               << "are skipped." << std::endl;
+      }
+      else if (valid)
+      {
+        chunk.offset = body + reader.pos;
+        chunk.size = size;
+        chunk.lz4 = compression == "lz4";
+        std::string records;
+        valid = SensorReplayPrivate::Decompress(chunk,
+            record.substr(reader.pos, size), records) &&
+            data.Index(records.data(), records.size(),
+                static_cast<uint32_t>(data.chunks.size()), 0u);
+        data.chunks.push_back(chunk);
+      }
+    }
+    offset = body + length;
+  }
+
+  if (!valid)
+  {
+    gzerr << "Sensor replay [" << _path << "] isn't a valid MCAP file."
+          << std::endl;
+    std::fclose(data.file);
+    data.file = nullptr;
+    data.chunks.clear();
+    data.types.clear();
+    data.topics.clear();
+    return false;
+  }
+
+  data.schemas.clear();
+  data.channels.clear();
+  for (auto &topic : data.topics)
+  {
+    std::stable_sort(topic.second.begin(), topic.second.end(),
+        [](const SensorReplayPrivate::Entry &_a,
+           const SensorReplayPrivate::Entry &_b)
+        {
+          return _a.time < _b.time;
+        });
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SensorReplay::Close()
+{
+  auto &data = *this->dataPtr;
+  std::lock_guard<std::mutex> lock(data.mutex);
+  if (data.file)
+    std::fclose(data.file);
+  data.file = nullptr;
+  data.chunks.clear();
+  data.types.clear();
+  data.schemas.clear();
+  data.channels.clear();
+  data.topics.clear();
+  data.cache.clear();
+}
+
+//////////////////////////////////////////////////
+bool SensorReplay::IsOpen() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->file != nullptr;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> SensorReplay::Topics() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  std::vector<std::string> topics;
+  for (const auto &topic : this->dataPtr->topics)
+    topics.push_back(topic.first);
+  return topics;
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorReplay::MessageCount(const std::string &_topic) const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto it = this->dataPtr->topics.find(_topic);
+  return it == this->dataPtr->topics.end() ? 0u : it->second.size();
+}
+
+//////////////////////////////////////////////////
+std::size_t SensorReplay::Messages(const std::string &_topic,
+    const std::chrono::steady_clock::duration &_after,
+    const std::chrono::steady_clock::duration &_until,
+    const MessageCallback &_callback) const
+{
+  GZ_PROFILE("SensorReplay::Messages");
+  auto nanos = [](const std::chrono::steady_clock::duration &_time)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        _time).count();
+  };
+  const int64_t after = nanos(_after);
+  const int64_t until = nanos(_until);
+  if (until < 0 || until <= after)
+    return 0u;
+
+  // Copy the messages out, so the callbacks run without the lock
+  std::vector<std::pair<std::string, std::string>> messages;
+  {
+    auto &data = *this->dataPtr;
+    std::lock_guard<std::mutex> lock(data.mutex);
+    auto topic = data.topics.find(_topic);
+    if (topic == data.topics.end())
+      return 0u;
+
+    const auto &entries = topic->second;
+    auto it = after < 0 ? entries.begin() : std::upper_bound(
+        entries.begin(), entries.end(), static_cast<uint64_t>(after),
+        [](uint64_t _time, const SensorReplayPrivate::Entry &_entry)
+        {
+          return _time < _entry.time;
+        });
+    for (; it != entries.end() && it->time <= static_cast<uint64_t>(until);
+         ++it)
+    {
+      std::string message;
+      if (it->chunk == kNoChunk)
+      {
+        if (!data.ReadAt(it->offset, it->size, message))
+          continue;
+      }
+      else
+      {
+        const std::string *records = data.ChunkRecords(it->chunk);
+        if (!records || records->size() < it->offset + it->size)
+          continue;
+        message = records->substr(it->offset, it->size);
+      }
+      messages.emplace_back(data.types[it->type], std::move(message));
+    }
+  }
+
+  for (const auto &message : messages)
+    _callback(message.first, message.second);
+  return messages.size();
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <google/protobuf/wrappers.pb.h>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gz/sensors/SensorRecorder.hh"
+#include "gz/sensors/SensorReplay.hh"
+
+using namespace gz;
+using namespace sensors;
+using namespace std::chrono_literals;
+
+/// \brief Messages given to a replay callback.
+struct Replayed
+{
+  /// \brief Message types.
+  std::vector<std::string> types;
+
+  /// \brief Values of the StringValue messages.
+  std::vector<std::string> values;
+
+  /// \brief Get a callback that appends to the messages.
+  /// \return The callback.
+  SensorReplay::MessageCallback Callback()
+  {
+    return [this](const std::string &_type, const std::string &_data)
+    {
+      google::protobuf::StringValue msg;
+      EXPECT_TRUE(msg.ParseFromString(_data));
+      this->types.push_back(_type);
+      this->values.push_back(msg.value());
+    };
+  }
+};
+
+/// \brief Record StringValue messages named after their topic and index,
+/// one per millisecond on each topic.
+/// \param[in] _path Path of the recording.
+/// \param[in] _compression Chunk compression.
+/// \param[in] _count Number of messages of each topic.
+static void RecordValues(const std::string &_path,
+    SensorRecorderCompression _compression, int _count)
+{
+  SensorRecorder recorder;
+  recorder.SetCompression(_compression);
+  recorder.SetChunkSize(256u);
+  ASSERT_TRUE(recorder.Open(_path));
+  for (int i = 0; i < _count; ++i)
+  {
+    for (const std::string topic : {"/first", "/second"})
+    {
+      google::protobuf::StringValue msg;
+      msg.set_value(topic + " " + std::to_string(i));
+      EXPECT_TRUE(recorder.Record(topic, msg,
+          std::chrono::milliseconds(i)));
+    }
+  }
+  recorder.Close();
+}
+
+//////////////////////////////////////////////////
+TEST(SensorReplay, Messages)
+{
+  const std::string path = "sensor_replay_messages.mcap";
+  RecordValues(path, SensorRecorderCompression::LZ4, 100);
+
+  SensorReplay replay;
+  EXPECT_FALSE(replay.IsOpen());
+  ASSERT_TRUE(replay.Open(path));
+  EXPECT_TRUE(replay.IsOpen());
+  EXPECT_EQ(std::vector<std::string>({"/first", "/second"}),
+      replay.Topics());
+  EXPECT_EQ(100u, replay.MessageCount("/first"));
+  EXPECT_EQ(0u, replay.MessageCount("/unknown"));
+
+  // The first window includes time zero
+  Replayed replayed;
+  EXPECT_EQ(3u, replay.Messages("/first", -1ns, 2ms, replayed.Callback()));
+  EXPECT_EQ(std::vector<std::string>({"/first 0", "/first 1", "/first 2"}),
+      replayed.values);
+  EXPECT_EQ("google.protobuf.StringValue", replayed.types.front());
+
+  // Later windows exclude their start
+  replayed = Replayed();
+  EXPECT_EQ(2u, replay.Messages("/second", 2ms, 4ms, replayed.Callback()));
+  EXPECT_EQ(std::vector<std::string>({"/second 3", "/second 4"}),
+      replayed.values);
+  replayed = Replayed();
+  EXPECT_EQ(0u, replay.Messages("/second", 4ms, 4ms, replayed.Callback()));
+  EXPECT_EQ(0u, replay.Messages("/unknown", -1ns, 1s, replayed.Callback()));
+
+  // Going back and forth over more chunks than are cached
+  for (int i = 99; i >= 0; i -= 7)
+  {
+    replayed = Replayed();
+    const auto time = std::chrono::milliseconds(i);
+    EXPECT_EQ(1u, replay.Messages("/first", time - 1ns, time,
+        replayed.Callback()));
+    ASSERT_EQ(1u, replayed.values.size());
+    EXPECT_EQ("/first " + std::to_string(i), replayed.values.front());
+  }
+
+  // Several threads at once
+  auto replayAll = [&replay](const std::string &_topic)
+  {
+    Replayed all;
+    EXPECT_EQ(100u, replay.Messages(_topic, -1ns, 1s, all.Callback()));
+    ASSERT_EQ(100u, all.values.size());
+    for (int i = 0; i < 100; ++i)
+      EXPECT_EQ(_topic + " " + std::to_string(i), all.values[i]);
+  };
+  std::thread first(replayAll, "/first");
+  std::thread second(replayAll, "/second");
+  first.join();
+  second.join();
+
+  replay.Close();
+  EXPECT_FALSE(replay.IsOpen());
+  EXPECT_TRUE(replay.Topics().empty());
+}
+
+//////////////////////////////////////////////////
+TEST(SensorReplay, Uncompressed)
+{
+  const std::string path = "sensor_replay_uncompressed.mcap";
+  RecordValues(path, SensorRecorderCompression::NONE, 10);
+
+  SensorReplay replay;
+  ASSERT_TRUE(replay.Open(path));
+  Replayed replayed;
+  EXPECT_EQ(10u, replay.Messages("/second", -1ns, 1s, replayed.Callback()));
+  EXPECT_EQ("/second 9", replayed.values.back());
+}
+
+//////////////////////////////////////////////////
+TEST(SensorReplay, Invalid)
+{
+  SensorReplay replay;
+  EXPECT_FALSE(replay.Open("missing_sensor_replay.mcap"));
+
+  const std::string path = "sensor_replay_invalid.mcap";
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "not a recording";
+  }
+  EXPECT_FALSE(replay.Open(path));
+  EXPECT_FALSE(replay.IsOpen());
+
+  // A truncated recording keeps its complete chunks
+  RecordValues(path, SensorRecorderCompression::LZ4, 50);
+  std::string data;
+  {
+    std::ifstream file(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size() / 2u));
+  }
+  ASSERT_TRUE(replay.Open(path));
+  EXPECT_GT(replay.MessageCount("/first"), 0u);
+  EXPECT_LT(replay.MessageCount("/first"), 50u);
+}
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "SensorSchedule.hh"
+
+#include <algorithm>
+#include <utility>
+
+#include <gz/common/Console.hh>
+#include <gz/math/Helpers.hh>
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+SensorSchedule::SensorSchedule(SensorId _id)
+  : id(_id)
+{
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::Reset()
+{
+  this->position.nextUpdateTime = std::chrono::steady_clock::duration::zero();
+  this->NotifyChanged();
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetSdfRate(double _hz)
+{
+  this->sdfRate = this->rate = _hz;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetRate(double _hz)
+{
+  this->rate = std::max(_hz, 0.0);
+  this->NotifyChanged();
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::RequestRate(double _hz, const std::string &_name)
+{
+  const double requested = std::max(_hz, 0.0);
+
+  // if SDF has zero, any value can be set; for non-zero SDF values, we need to
+  // check whether they are in bounds, i.e. greater than zero and lower or equal
+  // to the SDF value
+  if (!math::lessOrNearEqual(this->sdfRate, 0.0))
+  {
+    if (math::lessOrNearEqual(requested, 0.0))
+    {
+      gzerr << "Cannot set update rate of sensor " << _name << " to zero "
+             << "because the <update_rate> SDF element is non-zero."
+             << std::endl;
+      return;
+    }
+    // apply the upper rate limit from SDF
+    else if (!math::lessOrNearEqual(requested, this->sdfRate))
+    {
+      gzerr << "Trying to set update rate of sensor " << _name << " to "
+             << requested << ", but the maximum rate in <update_rate> SDF "
+             << "element is " << this->sdfRate << ". Ignoring the request."
+             << std::endl;
+      return;
+    }
+  }
+
+  gzdbg << "Setting update rate of sensor " << _name << " to " << requested
+         << " Hz" << std::endl;
+
+  this->rate = requested;
+  this->NotifyChanged();
+}
+
+//////////////////////////////////////////////////
+double SensorSchedule::Rate() const
+{
+  return this->rate;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetMinRate(double _hz)
+{
+  this->minRate = std::max(_hz, 0.0);
+  if (this->effectiveRate > 0.0)
+    this->NotifyChanged();
+}
+
+//////////////////////////////////////////////////
+double SensorSchedule::MinRate() const
+{
+  return this->minRate;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetEffectiveRate(double _hz)
+{
+  const double lowered = _hz >= this->rate ? 0.0 : _hz;
+  if (lowered == this->effectiveRate)
+    return;
+  this->effectiveRate = lowered;
+  this->NotifyChanged();
+}
+
+//////////////////////////////////////////////////
+double SensorSchedule::ScheduledRate() const
+{
+  if (this->rate <= 0.0 || this->effectiveRate <= 0.0)
+    return this->rate;
+  return std::min(this->rate, std::max(this->effectiveRate, this->minRate));
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetPriority(SensorPriority _priority)
+{
+  this->priority = _priority;
+}
+
+//////////////////////////////////////////////////
+SensorPriority SensorSchedule::Priority() const
+{
+  return this->priority;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetDriftFree(bool _driftFree)
+{
+  this->driftFree = _driftFree;
+  this->position.anchored = false;
+}
+
+//////////////////////////////////////////////////
+bool SensorSchedule::DriftFree() const
+{
+  return this->driftFree;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetActive(bool _active)
+{
+  this->active = _active;
+  this->NotifyChanged();
+}
+
+//////////////////////////////////////////////////
+bool SensorSchedule::Active() const
+{
+  return this->active;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetNextUpdateTime(
+    const std::chrono::steady_clock::duration &_time)
+{
+  this->position.nextUpdateTime = _time;
+  this->NotifyChanged();
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration SensorSchedule::NextUpdateTime() const
+{
+  return this->position.nextUpdateTime;
+}
+
+//////////////////////////////////////////////////
+bool SensorSchedule::IsDue(const std::chrono::steady_clock::duration &_now,
+    bool _force) const
+{
+  // Check if it's time to update
+  if (_now < this->position.nextUpdateTime && !_force &&
+      this->ScheduledRate() > 0)
+  {
+    return false;
+  }
+
+  // prevent update if not active, unless forced
+  if (!this->active && !_force)
+    return false;
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::Advance(const std::chrono::steady_clock::duration &_now)
+{
+  auto &pos = this->position;
+  const double scheduledRate = this->ScheduledRate();
+  if (this->driftFree)
+  {
+    // Update times are computed from the start of the schedule, so rounding
+    // errors don't accumulate.
+    if (!pos.anchored)
+    {
+      pos.anchor = pos.nextUpdateTime;
+      pos.ticks = 0;
+      pos.anchored = true;
+    }
+    auto timeAt = [&pos, scheduledRate](int64_t _ticks)
+    {
+      return pos.anchor +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(_ticks / scheduledRate));
+    };
+
+    ++pos.ticks;
+    pos.nextUpdateTime = timeAt(pos.ticks);
+    if (pos.nextUpdateTime <= _now)
+    {
+      // Catch up to "now", if necessary.
+      const double elapsed =
+        std::chrono::duration<double>(_now - pos.anchor).count();
+      pos.ticks = std::max(pos.ticks,
+          static_cast<int64_t>(elapsed * scheduledRate));
+      pos.nextUpdateTime = timeAt(pos.ticks);
+      while (pos.nextUpdateTime <= _now)
+        pos.nextUpdateTime = timeAt(++pos.ticks);
+    }
+    return;
+  }
+
+  // Update the time the plugin should be loaded
+  auto delta = std::chrono::duration_cast<
+    std::chrono::steady_clock::duration>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::duration<double>(1.0 / scheduledRate)));
+
+  // Rates above 1 kHz don't fit the millisecond period
+  if (delta <= std::chrono::steady_clock::duration::zero())
+  {
+    delta = std::max(std::chrono::steady_clock::duration(1),
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / scheduledRate)));
+  }
+
+  pos.nextUpdateTime += delta;
+
+  // Catch up to "now", if necessary.
+  if (pos.nextUpdateTime <= _now)
+    pos.nextUpdateTime += ((_now - pos.nextUpdateTime) / delta + 1) * delta;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetMeasureCost(bool _measure)
+{
+  this->measureCost = _measure;
+}
+
+//////////////////////////////////////////////////
+bool SensorSchedule::MeasureCost() const
+{
+  return this->measureCost;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::RecordCost(
+    const std::chrono::steady_clock::duration &_duration)
+{
+  // Exponential moving average, weighing the last update by 1/8
+  const int64_t previous = this->cost;
+  const int64_t sample = _duration.count();
+  this->cost = previous == 0 ? sample : previous + (sample - previous) / 8;
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration SensorSchedule::Cost() const
+{
+  return std::chrono::steady_clock::duration(this->cost);
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetChangedCallback(
+    std::function<void(SensorId)> _callback)
+{
+  this->changedCallback = std::move(_callback);
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetTriggerCallback(
+    std::function<void(SensorId)> _callback)
+{
+  this->triggerCallback = std::move(_callback);
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SetWaitForTrigger(bool _wait)
+{
+  if (this->waitForTrigger == _wait)
+    return;
+  this->waitForTrigger = _wait;
+  if (this->changedCallback)
+    this->changedCallback(this->id);
+}
+
+//////////////////////////////////////////////////
+bool SensorSchedule::WaitsForTrigger() const
+{
+  return this->waitForTrigger;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::NotifyTriggered()
+{
+  this->triggerPending = true;
+  if (this->triggerCallback)
+    this->triggerCallback(this->id);
+
+  // Put the sensor back on the schedule of the manager
+  if (this->waitForTrigger && this->changedCallback)
+    this->changedCallback(this->id);
+}
+
+//////////////////////////////////////////////////
+bool SensorSchedule::TriggerPending() const
+{
+  return this->triggerPending;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::ClearTrigger()
+{
+  this->triggerPending = false;
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::NotifyChanged()
+{
+  this->position.anchored = false;
+  if (this->changedCallback)
+    this->changedCallback(this->id);
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::SaveState(SensorState &_state) const
+{
+  _state.Write(this->position.nextUpdateTime);
+  _state.Write(this->position.anchored);
+  _state.Write(this->position.anchor);
+  _state.Write(this->position.ticks);
+}
+
+//////////////////////////////////////////////////
+bool SensorSchedule::ReadState(SensorState &_state, State &_schedule)
+{
+  return _state.Read(_schedule.nextUpdateTime) &&
+      _state.Read(_schedule.anchored) && _state.Read(_schedule.anchor) &&
+      _state.Read(_schedule.ticks);
+}
+
+//////////////////////////////////////////////////
+void SensorSchedule::RestoreState(const State &_schedule)
+{
+  this->position.nextUpdateTime = _schedule.nextUpdateTime;
+  this->NotifyChanged();
+  this->position = _schedule;
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SENSORSCHEDULE_HH_
+#define GZ_SENSORS_SENSORSCHEDULE_HH_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Sensor.hh"
+#include "gz/sensors/SensorState.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Update schedule of a sensor: its rates, priority, next update
+    /// time, triggers and the average cost of its updates. The functions of
+    /// Sensor that configure the schedule forward to this class.
+    class SensorSchedule
+    {
+      /// \brief Drift-free schedule position, saved with the sensor state.
+      public: struct State
+      {
+        /// \brief Time of the next update.
+        std::chrono::steady_clock::duration nextUpdateTime{0};
+
+        /// \brief True if anchor and ticks are valid.
+        bool anchored{false};
+
+        /// \brief Time of the first update of the drift-free schedule.
+        std::chrono::steady_clock::duration anchor{0};
+
+        /// \brief Number of update periods between anchor and
+        /// nextUpdateTime.
+        int64_t ticks{0};
+      };
+
+      /// \brief Constructor
+      /// \param[in] _id Id of the sensor, passed to the callbacks.
+      public: explicit SensorSchedule(SensorId _id);
+
+      /// \brief Restart the schedule from time zero.
+      public: void Reset();
+
+      /// \brief Set the rate from the <update_rate> SDF element, which caps
+      /// the rates requested with RequestRate. The current rate is set too.
+      /// \param[in] _hz Rate in Hz.
+      public: void SetSdfRate(double _hz);
+
+      /// \brief Set the update rate. Negative rates are treated as zero.
+      /// \param[in] _hz Rate in Hz, zero to update on every step.
+      public: void SetRate(double _hz);
+
+      /// \brief Set the update rate from a request of a user. The rate can't
+      /// be set higher than the SDF rate, and zero is allowed only when zero
+      /// is also in SDF.
+      /// \param[in] _hz Requested rate in Hz.
+      /// \param[in] _name Name of the sensor, for error messages.
+      public: void RequestRate(double _hz, const std::string &_name);
+
+      /// \brief Get the update rate.
+      /// \return Rate in Hz.
+      public: double Rate() const;
+
+      /// \brief Set the lowest rate SetEffectiveRate may lower the rate to.
+      /// \param[in] _hz Rate in Hz, zero if the rate can't be lowered.
+      public: void SetMinRate(double _hz);
+
+      /// \brief Get the lowest rate SetEffectiveRate may lower the rate to.
+      /// \return Rate in Hz.
+      public: double MinRate() const;
+
+      /// \brief Lower the rate the sensor is scheduled at.
+      /// \param[in] _hz Rate in Hz. Zero, or a rate not below Rate(),
+      /// restores the update rate.
+      public: void SetEffectiveRate(double _hz);
+
+      /// \brief Get the rate the sensor is scheduled at.
+      /// \return Rate(), or the effective rate if it's lower.
+      public: double ScheduledRate() const;
+
+      /// \brief Set the priority class.
+      /// \param[in] _priority Priority class.
+      public: void SetPriority(SensorPriority _priority);
+
+      /// \brief Get the priority class.
+      /// \return Priority class.
+      public: SensorPriority Priority() const;
+
+      /// \brief Set whether update times are computed from the start of the
+      /// schedule instead of adding a millisecond period to the previous
+      /// update time.
+      /// \param[in] _driftFree True for a drift-free schedule.
+      public: void SetDriftFree(bool _driftFree);
+
+      /// \brief Get whether the schedule is drift-free.
+      /// \return True if it's drift-free.
+      public: bool DriftFree() const;
+
+      /// \brief Set whether the sensor is active.
+      /// \param[in] _active False to stop the updates that aren't forced.
+      public: void SetActive(bool _active);
+
+      /// \brief Get whether the sensor is active.
+      /// \return True if it's active.
+      public: bool Active() const;
+
+      /// \brief Set the time of the next update.
+      /// \param[in] _time Time of the next update.
+      public: void SetNextUpdateTime(
+                  const std::chrono::steady_clock::duration &_time);
+
+      /// \brief Get the time of the next update.
+      /// \return Time of the next update.
+      public: std::chrono::steady_clock::duration NextUpdateTime() const;
+
+      /// \brief Check whether the sensor should generate data.
+      /// \param[in] _now Current time.
+      /// \param[in] _force True if the update is forced.
+      /// \return True if it's time to update and the sensor is active, or if
+      /// the update is forced.
+      public: bool IsDue(const std::chrono::steady_clock::duration &_now,
+                  bool _force) const;
+
+      /// \brief Advance the next update time past _now by whole update
+      /// periods, after the sensor generated data.
+      /// \param[in] _now Current time.
+      public: void Advance(const std::chrono::steady_clock::duration &_now);
+
+      /// \brief Set whether the cost of the updates is measured.
+      /// \param[in] _measure True to measure it.
+      public: void SetMeasureCost(bool _measure);
+
+      /// \brief Get whether the cost of the updates is measured.
+      /// \return True if it's measured.
+      public: bool MeasureCost() const;
+
+      /// \brief Add a measured update duration to the average update cost.
+      /// It may be called from the thread updating the sensor.
+      /// \param[in] _duration Wall-clock duration of the update.
+      public: void RecordCost(
+                  const std::chrono::steady_clock::duration &_duration);
+
+      /// \brief Get the average update cost.
+      /// \return Average wall-clock duration of an update.
+      public: std::chrono::steady_clock::duration Cost() const;
+
+      /// \brief Set the function called when the schedule changes outside
+      /// of an update.
+      /// \param[in] _callback Callback, empty to remove it.
+      public: void SetChangedCallback(std::function<void(SensorId)> _callback);
+
+      /// \brief Set the function called when the sensor is triggered.
+      /// \param[in] _callback Callback, empty to remove it.
+      public: void SetTriggerCallback(std::function<void(SensorId)> _callback);
+
+      /// \brief Set whether the sensor only generates data once triggered.
+      /// \param[in] _wait True to wait for triggers.
+      public: void SetWaitForTrigger(bool _wait);
+
+      /// \brief Get whether the sensor only generates data once triggered.
+      /// \return True if it waits for triggers.
+      public: bool WaitsForTrigger() const;
+
+      /// \brief Record a trigger and call the trigger callback. A sensor
+      /// that waits for triggers is put back on the schedule.
+      public: void NotifyTriggered();
+
+      /// \brief Get whether a trigger was received since the last update.
+      /// \return True if a trigger is pending.
+      public: bool TriggerPending() const;
+
+      /// \brief Clear the pending trigger, at the start of an update.
+      public: void ClearTrigger();
+
+      /// \brief Restart the drift-free schedule and call the changed
+      /// callback, if set.
+      public: void NotifyChanged();
+
+      /// \brief Save the position in the schedule.
+      /// \param[out] _state State to write to.
+      public: void SaveState(SensorState &_state) const;
+
+      /// \brief Read a position saved with SaveState.
+      /// \param[in,out] _state State to read from.
+      /// \param[out] _schedule Position read.
+      /// \return False if the state ended early.
+      public: static bool ReadState(SensorState &_state, State &_schedule);
+
+      /// \brief Move to a position read with ReadState.
+      /// \param[in] _schedule Position to restore.
+      public: void RestoreState(const State &_schedule);
+
+      /// \brief Id of the sensor.
+      private: SensorId id;
+
+      /// \brief Called when the schedule changes outside of an update.
+      private: std::function<void(SensorId)> changedCallback;
+
+      /// \brief Called when the sensor is triggered.
+      private: std::function<void(SensorId)> triggerCallback;
+
+      /// \brief True if the sensor only generates data once triggered.
+      private: bool waitForTrigger{false};
+
+      /// \brief True if a trigger was received since the last update.
+      private: std::atomic<bool> triggerPending{false};
+
+      /// \brief If the sensor is active or not.
+      private: bool active{true};
+
+      /// \brief Rate from the <update_rate> SDF element.
+      private: double sdfRate{0.0};
+
+      /// \brief Rate currently in use.
+      private: double rate{0.0};
+
+      /// \brief Lowest rate effectiveRate may be set to, 0 if the rate can't
+      /// be lowered.
+      private: double minRate{0.0};
+
+      /// \brief Lowered update rate, 0 if the sensor runs at rate.
+      private: double effectiveRate{0.0};
+
+      /// \brief Priority class of the sensor.
+      private: SensorPriority priority{SensorPriority::NORMAL};
+
+      /// \brief True to measure the cost of the updates.
+      private: bool measureCost{false};
+
+      /// \brief Average update duration in steady clock ticks. It's written
+      /// by whichever thread updates the sensor.
+      private: std::atomic<int64_t> cost{0};
+
+      /// \brief True to compute update times from the anchor.
+      private: bool driftFree{false};
+
+      /// \brief Position in the schedule.
+      private: State position;
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "SensorSchedule.hh"
+
+using namespace gz;
+using namespace sensors;
+using namespace std::chrono_literals;
+
+//////////////////////////////////////////////////
+TEST(SensorSchedule, Rates)
+{
+  SensorSchedule schedule(3u);
+  std::vector<SensorId> changes;
+  schedule.SetChangedCallback([&changes](SensorId _id)
+  {
+    changes.push_back(_id);
+  });
+
+  schedule.SetSdfRate(10.0);
+  EXPECT_DOUBLE_EQ(10.0, schedule.Rate());
+  EXPECT_TRUE(changes.empty());
+
+  // Requests can't go above the SDF rate, or to zero
+  schedule.RequestRate(20.0, "sensor");
+  EXPECT_DOUBLE_EQ(10.0, schedule.Rate());
+  schedule.RequestRate(0.0, "sensor");
+  EXPECT_DOUBLE_EQ(10.0, schedule.Rate());
+  EXPECT_TRUE(changes.empty());
+  schedule.RequestRate(5.0, "sensor");
+  EXPECT_DOUBLE_EQ(5.0, schedule.Rate());
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_EQ(3u, changes[0]);
+
+  // SetRate isn't capped
+  schedule.SetRate(20.0);
+  EXPECT_DOUBLE_EQ(20.0, schedule.Rate());
+  schedule.SetRate(-1.0);
+  EXPECT_DOUBLE_EQ(0.0, schedule.Rate());
+  schedule.SetRate(20.0);
+
+  // The effective rate is bounded by the minimum rate
+  schedule.SetMinRate(4.0);
+  schedule.SetEffectiveRate(2.0);
+  EXPECT_DOUBLE_EQ(4.0, schedule.ScheduledRate());
+  schedule.SetEffectiveRate(8.0);
+  EXPECT_DOUBLE_EQ(8.0, schedule.ScheduledRate());
+  schedule.SetEffectiveRate(30.0);
+  EXPECT_DOUBLE_EQ(20.0, schedule.ScheduledRate());
+}
+
+//////////////////////////////////////////////////
+TEST(SensorSchedule, Advance)
+{
+  SensorSchedule schedule(1u);
+  schedule.SetRate(10.0);
+  EXPECT_TRUE(schedule.IsDue(0s, false));
+
+  schedule.Advance(0s);
+  EXPECT_EQ(100ms, schedule.NextUpdateTime());
+  EXPECT_FALSE(schedule.IsDue(50ms, false));
+  EXPECT_TRUE(schedule.IsDue(50ms, true));
+  EXPECT_TRUE(schedule.IsDue(100ms, false));
+
+  // Missed updates are skipped
+  schedule.Advance(350ms);
+  EXPECT_EQ(400ms, schedule.NextUpdateTime());
+
+  // Inactive sensors only update when forced
+  schedule.SetActive(false);
+  EXPECT_FALSE(schedule.IsDue(400ms, false));
+  EXPECT_TRUE(schedule.IsDue(400ms, true));
+  schedule.SetActive(true);
+
+  // Drift-free schedules count periods from their first update
+  schedule.SetRate(3.0);
+  schedule.SetDriftFree(true);
+  schedule.SetNextUpdateTime(0s);
+  for (int i = 0; i < 3; ++i)
+    schedule.Advance(schedule.NextUpdateTime());
+  EXPECT_EQ(1s, schedule.NextUpdateTime());
+}
+
+//////////////////////////////////////////////////
+TEST(SensorSchedule, Triggers)
+{
+  SensorSchedule schedule(7u);
+  int triggers = 0;
+  int changes = 0;
+  schedule.SetTriggerCallback([&triggers](SensorId) {++triggers;});
+  schedule.SetChangedCallback([&changes](SensorId) {++changes;});
+
+  // Sensors that don't wait for triggers stay on the schedule
+  schedule.NotifyTriggered();
+  EXPECT_TRUE(schedule.TriggerPending());
+  EXPECT_EQ(1, triggers);
+  EXPECT_EQ(0, changes);
+  schedule.ClearTrigger();
+  EXPECT_FALSE(schedule.TriggerPending());
+
+  schedule.SetWaitForTrigger(true);
+  EXPECT_TRUE(schedule.WaitsForTrigger());
+  EXPECT_EQ(1, changes);
+  schedule.SetWaitForTrigger(true);
+  EXPECT_EQ(1, changes);
+
+  // Triggered sensors are put back on the schedule
+  schedule.NotifyTriggered();
+  EXPECT_EQ(2, triggers);
+  EXPECT_EQ(2, changes);
+}
+
+//////////////////////////////////////////////////
+TEST(SensorSchedule, State)
+{
+  SensorSchedule schedule(1u);
+  schedule.SetRate(4.0);
+  schedule.SetDriftFree(true);
+  schedule.Advance(0s);
+  schedule.Advance(250ms);
+
+  SensorState state;
+  schedule.SaveState(state);
+  schedule.Advance(500ms);
+  EXPECT_EQ(750ms, schedule.NextUpdateTime());
+
+  state.Rewind();
+  SensorSchedule::State position;
+  ASSERT_TRUE(SensorSchedule::ReadState(state, position));
+  schedule.RestoreState(position);
+  EXPECT_EQ(500ms, schedule.NextUpdateTime());
+
+  // The restored schedule continues from the same anchor
+  schedule.Advance(500ms);
+  EXPECT_EQ(750ms, schedule.NextUpdateTime());
+
+  // Truncated states aren't read
+  SensorState empty;
+  EXPECT_FALSE(SensorSchedule::ReadState(empty, position));
+}
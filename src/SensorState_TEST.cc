@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "gz/sensors/SensorState.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(SensorState, Values)
+{
+  SensorState state;
+  EXPECT_EQ(0u, state.Size());
+  EXPECT_TRUE(state.AtEnd());
+
+  state.Write(uint32_t{7u});
+  state.Write(2.5);
+  state.Write(math::Pose3d(1, 2, 3, 0.1, 0.2, 0.3));
+  state.WriteVector(std::vector<float>{1.0f, 2.0f, 3.0f});
+  EXPECT_FALSE(state.AtEnd());
+
+  uint32_t u{0u};
+  double d{0.0};
+  math::Pose3d pose;
+  std::vector<float> values;
+  ASSERT_TRUE(state.Read(u));
+  ASSERT_TRUE(state.Read(d));
+  ASSERT_TRUE(state.Read(pose));
+  ASSERT_TRUE(state.ReadVector(values));
+  EXPECT_TRUE(state.AtEnd());
+  EXPECT_EQ(7u, u);
+  EXPECT_DOUBLE_EQ(2.5, d);
+  EXPECT_EQ(math::Pose3d(1, 2, 3, 0.1, 0.2, 0.3), pose);
+  EXPECT_EQ((std::vector<float>{1.0f, 2.0f, 3.0f}), values);
+
+  // Nothing left
+  EXPECT_FALSE(state.Read(u));
+
+  // Read again
+  state.Rewind();
+  u = 0u;
+  ASSERT_TRUE(state.Read(u));
+  EXPECT_EQ(7u, u);
+}
+
+/////////////////////////////////////////////////
+TEST(SensorState, Truncated)
+{
+  SensorState state;
+  state.Write(uint64_t{1000u});
+  std::vector<double> values;
+  EXPECT_FALSE(state.ReadVector(values));
+
+  state.Rewind();
+  double d{0.0};
+  EXPECT_TRUE(state.Read(d));
+  EXPECT_EQ(nullptr, state.ReadView(1u));
+}
+
+/////////////////////////////////////////////////
+TEST(SensorState, ReuseMemory)
+{
+  SensorState state;
+  for (int i = 0; i < 4; ++i)
+    state.Write(i);
+  const std::size_t size = state.Size();
+  state.Clear();
+  EXPECT_EQ(0u, state.Size());
+  for (int i = 0; i < 4; ++i)
+    state.Write(i);
+  EXPECT_EQ(size, state.Size());
+}
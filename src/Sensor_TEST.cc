@@ -19,19 +19,36 @@
   #pragma warning(disable: 4005)
   #pragma warning(disable: 4251)
 #endif
+#include <gz/msgs/image.pb.h>
 #include <gz/msgs/performance_sensor_metrics.pb.h>
 #if defined(_MSC_VER)
   #pragma warning(pop)
 #endif
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
+#include <google/protobuf/arena.h>
 
 #include <gz/common/Console.hh>
 #include <gz/sensors/Export.hh>
+#include <gz/sensors/Noise.hh>
+#include <gz/sensors/RawPayload.hh>
 #include <gz/sensors/Sensor.hh>
+#include <gz/sensors/SensorBundle.hh>
+#include <gz/sensors/SensorRecorder.hh>
+#include <gz/sensors/SensorReplay.hh>
 #include <gz/transport/Node.hh>
 
 using namespace gz;
@@ -48,7 +65,218 @@ class TestSensor : public Sensor
   public: unsigned int updateCount{0};
 };
 
+class ArenaTestSensor : public TestSensor
+{
+  public: bool Update(const std::chrono::steady_clock::duration &) override
+  {
+    auto arena = this->MessageArena();
+    if (arena)
+    {
+      auto msg = google::protobuf::Arena::CreateMessage<msgs::Double>(arena);
+      msg->set_data(1.0);
+      spaceUsed = arena->SpaceUsed();
+    }
+    updateCount++;
+    return true;
+  }
+
+  public: google::protobuf::Arena *Arena()
+  {
+    return this->MessageArena();
+  }
+
+  public: uint64_t spaceUsed{0u};
+};
+
+class LazyTestSensor : public TestSensor
+{
+  public: bool HasConnections() const override
+  {
+    return connected;
+  }
+
+  protected: void UpdateNoiseState(
+      const std::chrono::steady_clock::duration &) override
+  {
+    noiseUpdateCount++;
+  }
+
+  public: bool connected{false};
+
+  public: unsigned int noiseUpdateCount{0};
+};
+
+class AdvertiseTestSensor : public TestSensor
+{
+  public: bool Load(const sdf::Sensor &_sdf) override
+  {
+    if (!Sensor::Load(_sdf))
+      return false;
+    return this->Advertise<msgs::Double>(this->node, this->pub,
+        this->Topic());
+  }
+
+  public: transport::Node node;
+
+  public: transport::Node::Publisher pub;
+};
+
+class RecordTestSensor : public AdvertiseTestSensor
+{
+  public: bool Update(const std::chrono::steady_clock::duration &_now)
+      override
+  {
+    msgs::Double msg;
+    msg.set_data(std::chrono::duration<double>(_now).count());
+    this->Publish(this->pub, msg);
+    updateCount++;
+    return true;
+  }
+};
+
+class LazyRecordTestSensor : public RecordTestSensor
+{
+  public: bool HasConnections() const override
+  {
+    return this->pub.HasConnections();
+  }
+};
+
+class ImageTestSensor : public TestSensor
+{
+  public: bool Load(const sdf::Sensor &_sdf) override
+  {
+    if (!Sensor::Load(_sdf))
+      return false;
+    return this->Advertise<msgs::Image>(this->node, this->pub,
+        this->Topic());
+  }
+
+  public: bool Update(const std::chrono::steady_clock::duration &) override
+  {
+    msgs::Image msg;
+    msg.set_width(2u);
+    msg.set_height(1u);
+    msg.set_data("pixels");
+    this->Publish(this->pub, msg);
+    return true;
+  }
+
+  public: transport::Node node;
+
+  public: transport::Node::Publisher pub;
+};
+
+class LatencyTestSensor : public TestSensor
+{
+  public: bool Update(const std::chrono::steady_clock::duration &_now)
+      override
+  {
+    this->StampLatency(SensorLatencyStage::RENDER);
+    this->FillHeader(this->msg.mutable_header(), _now);
+    this->Publish(this->pub, this->msg);
+    updateCount++;
+    return true;
+  }
+
+  public: msgs::Double msg;
+
+  public: transport::Node::Publisher pub;
+};
+
+class DelayTestSensor : public TestSensor
+{
+  public: bool Update(const std::chrono::steady_clock::duration &_now)
+      override
+  {
+    msgs::Double msg;
+    msg.set_data(std::chrono::duration<double>(_now).count());
+    this->Publish(this->pub, std::move(msg));
+    EXPECT_DOUBLE_EQ(0.0, msg.data());
+    updateCount++;
+    return true;
+  }
+
+  public: transport::Node::Publisher pub;
+};
+
+class NoiseTestSensor : public TestSensor
+{
+  public: explicit NoiseTestSensor(const std::string &_name)
+  {
+    sdf::Sensor sdfSensor;
+    sdfSensor.SetName(_name);
+    sdfSensor.SetTopic("/noise_test");
+    this->Load(sdfSensor);
+
+    sdf::Noise noiseDom;
+    noiseDom.SetType(sdf::NoiseType::GAUSSIAN);
+    noiseDom.SetStdDev(1.0);
+    this->noise = NoiseFactory::NewNoiseModel(noiseDom);
+    this->RegisterNoise(IMU_ANGVEL_X_NOISE_RADS_PER_S, this->noise);
+  }
+
+  public: std::vector<double> Sample()
+  {
+    std::vector<double> values;
+    for (int i = 0; i < 8; ++i)
+      values.push_back(this->noise->Apply(0.0));
+    return values;
+  }
+
+  public: NoisePtr noise;
+};
+
+/// \brief Test sensor registering a table of noise models, with some types
+/// left without a model
+class NoiseTableTestSensor : public TestSensor
+{
+  public: explicit NoiseTableTestSensor(const std::string &_name)
+  {
+    sdf::Sensor sdfSensor;
+    sdfSensor.SetName(_name);
+    sdfSensor.SetTopic("/noise_table_test");
+    this->Load(sdfSensor);
+
+    sdf::Noise noiseDom;
+    noiseDom.SetType(sdf::NoiseType::GAUSSIAN);
+    noiseDom.SetStdDev(1.0);
+    for (auto type : kTypes)
+      this->noises[type] = NoiseFactory::NewNoiseModel(noiseDom);
+    this->RegisterNoise(this->noises);
+  }
+
+  public: std::vector<double> Sample(SensorNoiseType _type)
+  {
+    std::vector<double> values;
+    for (int i = 0; i < 8; ++i)
+      values.push_back(this->noises[_type]->Apply(0.0));
+    return values;
+  }
+
+  /// \brief Types with a noise model
+  public: static constexpr std::array<SensorNoiseType, 2> kTypes{
+      IMU_ANGVEL_X_NOISE_RADS_PER_S, ACCELEROMETER_Z_NOISE_M_S_S};
+
+  public: NoiseTable noises;
+};
+
 /// \brief Test sensor class
+class PoseTestSensor : public TestSensor
+{
+  public: bool Update(const std::chrono::steady_clock::duration &_now)
+      override
+  {
+    times.push_back(_now);
+    poses.push_back(this->Pose());
+    return TestSensor::Update(_now);
+  }
+
+  public: std::vector<std::chrono::steady_clock::duration> times;
+
+  public: std::vector<math::Pose3d> poses;
+};
+
 class Sensor_TEST : public ::testing::Test
 {
   // Documentation inherited
@@ -462,3 +690,930 @@ TEST_F(SensorUpdate, NextDataUpdateTime)
     EXPECT_EQ(newNext.count(), sensor->NextDataUpdateTime().count());
   }
 }
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, AsyncPublish)
+{
+  TestSensor sensor;
+  EXPECT_FALSE(sensor.AsyncPublish());
+  EXPECT_EQ(1u, sensor.AsyncPublishDepth());
+
+  sensor.SetAsyncPublishDepth(0u);
+  EXPECT_EQ(1u, sensor.AsyncPublishDepth());
+  sensor.SetAsyncPublishDepth(4u);
+  EXPECT_EQ(4u, sensor.AsyncPublishDepth());
+
+  sensor.SetAsyncPublish(true);
+  EXPECT_TRUE(sensor.AsyncPublish());
+
+  transport::Node node;
+  std::atomic<int> received{0};
+  std::function<void(const msgs::Double &)> cb =
+      [&received](const msgs::Double &_msg)
+  {
+    EXPECT_DOUBLE_EQ(3.0, _msg.data());
+    received++;
+  };
+  EXPECT_TRUE(node.Subscribe("/test_async_publish", cb));
+
+  auto pub = node.Advertise<msgs::Double>("/test_async_publish");
+  for (int sleep = 0; sleep < 30 && !pub.HasConnections(); ++sleep)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_TRUE(pub.HasConnections());
+
+  msgs::Double msg;
+  msg.set_data(3.0);
+  EXPECT_TRUE(sensor.Publish(pub, msg));
+  EXPECT_DOUBLE_EQ(3.0, msg.data());
+  EXPECT_TRUE(sensor.Publish(pub, std::move(msg)));
+
+  for (int sleep = 0; sleep < 30 && received < 2; ++sleep)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(2, received);
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, ExecutionTime)
+{
+  TestSensor sensor;
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), false));
+  EXPECT_EQ(0u, sensor.ExecutionTime().count);
+
+  sensor.SetEnableMetrics(true);
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(2), false));
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(3), false));
+
+  SensorExecutionTime stats = sensor.ExecutionTime();
+  EXPECT_EQ(2u, stats.count);
+  EXPECT_LE(stats.last, stats.max);
+  EXPECT_LE(stats.average, stats.max);
+  uint64_t histogramCount = 0u;
+  for (auto bucket : stats.histogram)
+    histogramCount += bucket;
+  EXPECT_EQ(stats.count, histogramCount);
+
+  sensor.ResetExecutionTime();
+  stats = sensor.ExecutionTime();
+  EXPECT_EQ(0u, stats.count);
+  EXPECT_EQ(0, stats.max.count());
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, DriftFreeSchedule)
+{
+  TestSensor sensor;
+  EXPECT_FALSE(sensor.DriftFreeSchedule());
+  sensor.SetUpdateRate(333.0);
+
+  // The default schedule truncates the period to 3 ms
+  EXPECT_TRUE(sensor.Update(std::chrono::steady_clock::duration::zero(),
+      false));
+  EXPECT_EQ(std::chrono::steady_clock::duration(
+      std::chrono::milliseconds(3)).count(),
+      sensor.NextDataUpdateTime().count());
+
+  sensor.SetDriftFreeSchedule(true);
+  EXPECT_TRUE(sensor.DriftFreeSchedule());
+  sensor.SetNextDataUpdateTime(std::chrono::steady_clock::duration::zero());
+
+  // Step in 1 ms increments for one second of sim time
+  using namespace std::chrono_literals;
+  for (auto now = 0ms; now < 1000ms; now += 1ms)
+    sensor.Update(now, false);
+  // 333 updates in the first second, and the next one at 1 / 333 s past it
+  EXPECT_EQ(333u + 1u, sensor.updateCount);
+  std::chrono::steady_clock::duration expected = std::chrono::seconds(1);
+  EXPECT_EQ(expected.count(), sensor.NextDataUpdateTime().count());
+
+  // Jumping forward catches up in one step
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(100), false));
+  EXPECT_LT(std::chrono::seconds(100), sensor.NextDataUpdateTime());
+  EXPECT_GT(std::chrono::seconds(100) + 4ms, sensor.NextDataUpdateTime());
+
+  // Rates above 1 kHz work with both schedules
+  sensor.SetUpdateRate(2000.0);
+  for (bool driftFree : {true, false})
+  {
+    sensor.SetDriftFreeSchedule(driftFree);
+    sensor.SetNextDataUpdateTime(std::chrono::seconds(200));
+    EXPECT_TRUE(sensor.Update(std::chrono::seconds(200), false));
+    expected = std::chrono::seconds(200) + 500us;
+    EXPECT_EQ(expected.count(), sensor.NextDataUpdateTime().count());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, EffectiveUpdateRate)
+{
+  TestSensor sensor;
+  sensor.SetUpdateRate(100.0);
+  EXPECT_DOUBLE_EQ(0.0, sensor.MinUpdateRate());
+  EXPECT_DOUBLE_EQ(100.0, sensor.EffectiveUpdateRate());
+
+  // Kept between the minimum and the update rate
+  sensor.SetMinUpdateRate(10.0);
+  EXPECT_DOUBLE_EQ(10.0, sensor.MinUpdateRate());
+  sensor.SetEffectiveUpdateRate(1.0);
+  EXPECT_DOUBLE_EQ(10.0, sensor.EffectiveUpdateRate());
+  sensor.SetEffectiveUpdateRate(200.0);
+  EXPECT_DOUBLE_EQ(100.0, sensor.EffectiveUpdateRate());
+  EXPECT_DOUBLE_EQ(100.0, sensor.UpdateRate());
+
+  // Scheduled at the lowered rate
+  sensor.SetEffectiveUpdateRate(50.0);
+  EXPECT_DOUBLE_EQ(50.0, sensor.EffectiveUpdateRate());
+  using namespace std::chrono_literals;
+  for (auto now = 0ms; now < 1000ms; now += 1ms)
+    sensor.Update(now, false);
+  EXPECT_EQ(50u, sensor.updateCount);
+
+  // Sensors updated every cycle aren't lowered
+  sensor.SetUpdateRate(0.0);
+  EXPECT_DOUBLE_EQ(0.0, sensor.EffectiveUpdateRate());
+
+  // Costs are only measured when asked to
+  EXPECT_EQ(0, sensor.UpdateCost().count());
+  sensor.SetMeasureUpdateCost(true);
+  sensor.Update(1000ms, false);
+  EXPECT_LT(0, sensor.UpdateCost().count());
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, LazyUpdate)
+{
+  LazyTestSensor sensor;
+  sensor.SetUpdateRate(1.0);
+  EXPECT_FALSE(sensor.LazyUpdate());
+  EXPECT_FALSE(sensor.LazyNoiseUpdate());
+
+  // Not lazy, updates without connections
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(0), false));
+  EXPECT_EQ(1u, sensor.updateCount);
+
+  // Lazy, the update is skipped but the schedule still advances
+  sensor.SetLazyUpdate(true);
+  EXPECT_TRUE(sensor.LazyUpdate());
+  EXPECT_FALSE(sensor.Update(std::chrono::seconds(1), false));
+  EXPECT_EQ(1u, sensor.updateCount);
+  EXPECT_EQ(0u, sensor.noiseUpdateCount);
+  std::chrono::steady_clock::duration next = std::chrono::seconds(2);
+  EXPECT_EQ(next.count(), sensor.NextDataUpdateTime().count());
+
+  // Forced updates are never skipped
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), true));
+  EXPECT_EQ(2u, sensor.updateCount);
+
+  // Skipped updates can keep the noise state evolving
+  sensor.SetLazyNoiseUpdate(true);
+  EXPECT_TRUE(sensor.LazyNoiseUpdate());
+  EXPECT_FALSE(sensor.Update(std::chrono::seconds(2), false));
+  EXPECT_EQ(2u, sensor.updateCount);
+  EXPECT_EQ(1u, sensor.noiseUpdateCount);
+
+  // Updates resume when someone subscribes
+  sensor.connected = true;
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(3), false));
+  EXPECT_EQ(3u, sensor.updateCount);
+  EXPECT_EQ(1u, sensor.noiseUpdateCount);
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, FillHeader)
+{
+  TestSensor sensor;
+  sensor.SetFrameId("frame");
+
+  msgs::Header header;
+  auto extra = header.add_data();
+  extra->set_key("extra");
+  extra->add_value("value");
+
+  sensor.FillHeader(&header, std::chrono::milliseconds(1500));
+  EXPECT_EQ(1, header.stamp().sec());
+  EXPECT_EQ(500000000, header.stamp().nsec());
+  ASSERT_EQ(2, header.data_size());
+  EXPECT_EQ("frame_id", header.data(0).key());
+  ASSERT_EQ(1, header.data(0).value_size());
+  EXPECT_EQ("frame", header.data(0).value(0));
+  EXPECT_EQ("seq", header.data(1).key());
+  ASSERT_EQ(1, header.data(1).value_size());
+  EXPECT_EQ("0", header.data(1).value(0));
+
+  // Refilling updates the entries in place
+  const std::string *seqValue = &header.data(1).value(0);
+  sensor.FillHeader(&header, std::chrono::seconds(2));
+  EXPECT_EQ(2, header.stamp().sec());
+  EXPECT_EQ(0, header.stamp().nsec());
+  ASSERT_EQ(2, header.data_size());
+  EXPECT_EQ("1", header.data(1).value(0));
+  EXPECT_EQ(seqValue, &header.data(1).value(0));
+
+  // The default sequence is shared with AddSequence
+  msgs::Header other;
+  sensor.AddSequence(&other);
+  EXPECT_EQ("2", other.data(0).value(0));
+
+  // Explicit frame id and sequence
+  sensor.FillHeader(&header, std::chrono::seconds(3), "other_frame", "other");
+  EXPECT_EQ("other_frame", header.data(0).value(0));
+  EXPECT_EQ("0", header.data(1).value(0));
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, MessageArena)
+{
+  ArenaTestSensor sensor;
+  EXPECT_FALSE(sensor.MessageArenaEnabled());
+  EXPECT_EQ(nullptr, sensor.Arena());
+
+  sensor.SetMessageArenaEnabled(true);
+  EXPECT_TRUE(sensor.MessageArenaEnabled());
+  ASSERT_NE(nullptr, sensor.Arena());
+
+  // Messages created during the update are released after it
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), false));
+  EXPECT_LT(0u, sensor.spaceUsed);
+  EXPECT_EQ(0u, sensor.Arena()->SpaceUsed());
+
+  sensor.SetMessageArenaEnabled(false);
+  EXPECT_FALSE(sensor.MessageArenaEnabled());
+  EXPECT_EQ(nullptr, sensor.Arena());
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, MemoryUsage)
+{
+  ArenaTestSensor sensor;
+  EXPECT_TRUE(sensor.MemoryUsage().empty());
+
+  // The first block of the arena is kept across updates
+  sensor.SetMessageArenaEnabled(true);
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), false));
+  SensorMemoryUsage usage = sensor.MemoryUsage();
+  ASSERT_EQ(1u, usage.count("message_arena"));
+  EXPECT_LE(16384u, usage["message_arena"]);
+
+  sensor.SetMessageArenaEnabled(false);
+  EXPECT_TRUE(sensor.MemoryUsage().empty());
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, NoiseSeed)
+{
+  NoiseTestSensor a("imu_a");
+  EXPECT_FALSE(a.HasNoiseSeed());
+  a.SetNoiseSeed(42u);
+  EXPECT_TRUE(a.HasNoiseSeed());
+  EXPECT_EQ(42u, a.NoiseSeed());
+
+  // Same seed and name give the same noise
+  NoiseTestSensor b("imu_a");
+  b.SetNoiseSeed(42u);
+  EXPECT_EQ(a.Sample(), b.Sample());
+
+  // A different name gives different noise
+  NoiseTestSensor c("imu_c");
+  c.SetNoiseSeed(42u);
+  NoiseTestSensor d("imu_a");
+  d.SetNoiseSeed(42u);
+  EXPECT_NE(c.Sample(), d.Sample());
+
+  EXPECT_EQ(
+      Sensor::DeriveNoiseSeed(1u, "imu", IMU_ANGVEL_X_NOISE_RADS_PER_S),
+      Sensor::DeriveNoiseSeed(1u, "imu", IMU_ANGVEL_X_NOISE_RADS_PER_S));
+  EXPECT_NE(
+      Sensor::DeriveNoiseSeed(1u, "imu", IMU_ANGVEL_X_NOISE_RADS_PER_S),
+      Sensor::DeriveNoiseSeed(1u, "imu", IMU_ANGVEL_Y_NOISE_RADS_PER_S));
+  EXPECT_NE(
+      Sensor::DeriveNoiseSeed(1u, "imu", IMU_ANGVEL_X_NOISE_RADS_PER_S),
+      Sensor::DeriveNoiseSeed(2u, "imu", IMU_ANGVEL_X_NOISE_RADS_PER_S));
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, NoiseTable)
+{
+  NoiseTableTestSensor sensor("imu_table");
+  std::size_t models = 0u;
+  for (const auto &noise : sensor.noises)
+  {
+    if (noise)
+      ++models;
+  }
+  EXPECT_EQ(NoiseTableTestSensor::kTypes.size(), models);
+  EXPECT_EQ(nullptr, sensor.noises[IMU_ANGVEL_Y_NOISE_RADS_PER_S]);
+
+  // Each model in the table is seeded as if registered on its own, and
+  // types without a model are skipped
+  sensor.SetNoiseSeed(42u);
+  for (auto type : NoiseTableTestSensor::kTypes)
+  {
+    sdf::Noise noiseDom;
+    noiseDom.SetType(sdf::NoiseType::GAUSSIAN);
+    noiseDom.SetStdDev(1.0);
+    NoisePtr expected = NoiseFactory::NewNoiseModel(noiseDom);
+    expected->SetSeed(Sensor::DeriveNoiseSeed(42u, "imu_table", type));
+    std::vector<double> expectedValues;
+    for (int i = 0; i < 8; ++i)
+      expectedValues.push_back(expected->Apply(0.0));
+    EXPECT_EQ(expectedValues, sensor.Sample(type)) << type;
+  }
+  EXPECT_NE(sensor.Sample(NoiseTableTestSensor::kTypes[0]),
+            sensor.Sample(NoiseTableTestSensor::kTypes[1]));
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, SaveState)
+{
+  NoiseTestSensor sensor("imu_state");
+  sensor.SetNoiseSeed(3u);
+  sensor.SetUpdateRate(10.0);
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), false));
+  msgs::Header header;
+  sensor.FillHeader(&header, std::chrono::seconds(1));
+  sensor.FillHeader(&header, std::chrono::seconds(1), "frame", "other");
+
+  SensorState state;
+  sensor.SaveState(state);
+  EXPECT_LT(0u, state.Size());
+  const auto next = sensor.NextDataUpdateTime();
+  const auto samples = sensor.Sample();
+
+  // Go on, then go back
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(2), false));
+  sensor.FillHeader(&header, std::chrono::seconds(2));
+  EXPECT_NE(next, sensor.NextDataUpdateTime());
+
+  EXPECT_TRUE(sensor.RestoreState(state));
+  EXPECT_TRUE(state.AtEnd());
+  EXPECT_EQ(next, sensor.NextDataUpdateTime());
+  EXPECT_EQ(samples, sensor.Sample());
+  sensor.FillHeader(&header, std::chrono::seconds(2));
+  EXPECT_EQ("1", header.data(1).value(0));
+  sensor.FillHeader(&header, std::chrono::seconds(2), "frame", "other");
+  EXPECT_EQ("1", header.data(1).value(0));
+
+  // A sensor without the noise model can't restore it
+  TestSensor other;
+  state.Rewind();
+  EXPECT_FALSE(other.RestoreState(state));
+
+  // A sensor loaded the same way can
+  NoiseTestSensor copy("imu_state");
+  state.Rewind();
+  EXPECT_TRUE(copy.RestoreState(state));
+  EXPECT_EQ(next, copy.NextDataUpdateTime());
+  EXPECT_EQ(samples, copy.Sample());
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, AdvertiseDeferred)
+{
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetName("deferred");
+  sdfSensor.SetTopic("/test_advertise_deferred");
+
+  AdvertiseTestSensor sensor;
+  EXPECT_FALSE(sensor.AdvertiseDeferred());
+  sensor.SetAdvertiseDeferred(true);
+  EXPECT_TRUE(sensor.AdvertiseDeferred());
+  ASSERT_TRUE(sensor.Load(sdfSensor));
+
+  // The rate service and the data topic wait for AdvertisePending
+  EXPECT_EQ(2u, sensor.PendingAdvertisementCount());
+  EXPECT_FALSE(sensor.pub);
+
+  std::vector<std::string> services;
+  sensor.node.ServiceList(services);
+  EXPECT_EQ(services.end(), std::find(services.begin(), services.end(),
+      "/test_advertise_deferred/set_rate"));
+
+  EXPECT_TRUE(sensor.AdvertisePending());
+  EXPECT_FALSE(sensor.AdvertiseDeferred());
+  EXPECT_EQ(0u, sensor.PendingAdvertisementCount());
+  EXPECT_TRUE(sensor.pub);
+
+  std::vector<transport::ServicePublisher> publishers;
+  EXPECT_TRUE(sensor.node.ServiceInfo("/test_advertise_deferred/set_rate",
+      publishers));
+
+  // Nothing left to advertise
+  EXPECT_TRUE(sensor.AdvertisePending());
+
+  // Advertised right away when not deferred
+  sdfSensor.SetTopic("/test_advertise_now");
+  AdvertiseTestSensor other;
+  ASSERT_TRUE(other.Load(sdfSensor));
+  EXPECT_EQ(0u, other.PendingAdvertisementCount());
+  EXPECT_TRUE(other.pub);
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, LatencyStamps)
+{
+  LatencyTestSensor sensor;
+  EXPECT_FALSE(sensor.LatencyStamps());
+
+  // Nothing is measured by default
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), false));
+  EXPECT_EQ(2, sensor.msg.header().data_size());
+  EXPECT_EQ(0u, sensor.Latency(SensorLatencyStage::RENDER).count);
+
+  sensor.SetLatencyStamps(true);
+  EXPECT_TRUE(sensor.LatencyStamps());
+  auto nanos = []()
+  {
+    return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+  };
+  const uint64_t before = nanos();
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(2), false));
+  const uint64_t after = nanos();
+
+  const auto &header = sensor.msg.header();
+  ASSERT_EQ(4, header.data_size());
+  EXPECT_EQ("frame_id", header.data(0).key());
+  EXPECT_EQ("seq", header.data(1).key());
+  EXPECT_EQ("stamp_update", header.data(2).key());
+  EXPECT_EQ("stamp_render", header.data(3).key());
+  const uint64_t updateStamp = std::stoull(header.data(2).value(0));
+  const uint64_t renderStamp = std::stoull(header.data(3).value(0));
+  // The system clock may be adjusted, so allow some slack
+  EXPECT_LE(updateStamp, after + 1000000u);
+  EXPECT_GE(updateStamp + 1000000u, before);
+  EXPECT_LE(updateStamp, renderStamp);
+
+  EXPECT_EQ(0u, sensor.Latency(SensorLatencyStage::UPDATE).count);
+  EXPECT_EQ(1u, sensor.Latency(SensorLatencyStage::RENDER).count);
+  EXPECT_EQ(0u, sensor.Latency(SensorLatencyStage::READBACK).count);
+  EXPECT_EQ(1u, sensor.Latency(SensorLatencyStage::FILL).count);
+  EXPECT_EQ(1u, sensor.Latency(SensorLatencyStage::PUBLISH).count);
+  EXPECT_LE(sensor.Latency(SensorLatencyStage::RENDER).last,
+            sensor.Latency(SensorLatencyStage::FILL).last);
+  EXPECT_LE(sensor.Latency(SensorLatencyStage::FILL).last,
+            sensor.Latency(SensorLatencyStage::PUBLISH).last);
+
+  // Refilling updates the stamps in place
+  const std::string *renderValue = &header.data(3).value(0);
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(3), false));
+  ASSERT_EQ(4, header.data_size());
+  EXPECT_EQ(renderValue, &header.data(3).value(0));
+  EXPECT_EQ(2u, sensor.Latency(SensorLatencyStage::PUBLISH).count);
+
+  // Stages reached outside of an update aren't measured
+  LatencyTestSensor idle;
+  idle.SetLatencyStamps(true);
+  idle.StampLatency(SensorLatencyStage::RENDER);
+  EXPECT_EQ(0u, idle.Latency(SensorLatencyStage::RENDER).count);
+
+  sensor.ResetExecutionTime();
+  EXPECT_EQ(0u, sensor.Latency(SensorLatencyStage::PUBLISH).count);
+
+  sensor.SetLatencyStamps(false);
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(4), false));
+  EXPECT_EQ(2, header.data_size());
+  EXPECT_EQ(0u, sensor.Latency(SensorLatencyStage::PUBLISH).count);
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, OutputDelay)
+{
+  DelayTestSensor sensor;
+  EXPECT_EQ(std::chrono::steady_clock::duration::zero(),
+      sensor.OutputDelay());
+  EXPECT_EQ(0u, sensor.OutputDelayDepth());
+  EXPECT_EQ(0u, sensor.DelayedMessageCount());
+
+  sensor.SetOutputDelay(-std::chrono::milliseconds(1));
+  EXPECT_EQ(std::chrono::steady_clock::duration::zero(),
+      sensor.OutputDelay());
+  sensor.SetOutputDelay(std::chrono::milliseconds(20));
+  EXPECT_EQ(std::chrono::milliseconds(20), sensor.OutputDelay());
+  sensor.SetUpdateRate(100.0);
+
+  transport::Node node;
+  std::mutex mutex;
+  std::vector<double> received;
+  std::function<void(const msgs::Double &)> cb =
+      [&](const msgs::Double &_msg)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    received.push_back(_msg.data());
+  };
+  EXPECT_TRUE(node.Subscribe("/test_output_delay", cb));
+
+  sensor.pub = node.Advertise<msgs::Double>("/test_output_delay");
+  for (int sleep = 0; sleep < 30 && !sensor.pub.HasConnections(); ++sleep)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_TRUE(sensor.pub.HasConnections());
+
+  // Messages are held for two updates at 100 Hz
+  EXPECT_TRUE(sensor.Update(std::chrono::milliseconds(10), false));
+  EXPECT_EQ(1u, sensor.DelayedMessageCount());
+  EXPECT_FALSE(sensor.Update(std::chrono::milliseconds(15), false));
+  EXPECT_EQ(1u, sensor.DelayedMessageCount());
+  EXPECT_TRUE(sensor.Update(std::chrono::milliseconds(20), false));
+  EXPECT_EQ(2u, sensor.DelayedMessageCount());
+  EXPECT_FALSE(sensor.Update(std::chrono::milliseconds(25), false));
+  EXPECT_EQ(2u, sensor.DelayedMessageCount());
+
+  // The oldest message is released before the new one is held
+  EXPECT_TRUE(sensor.Update(std::chrono::milliseconds(30), false));
+  EXPECT_EQ(2u, sensor.DelayedMessageCount());
+  EXPECT_TRUE(sensor.Update(std::chrono::milliseconds(40), false));
+  EXPECT_EQ(2u, sensor.DelayedMessageCount());
+
+  // Setting the depth drops the held messages, and buffers of one message
+  // publish the previous one early
+  sensor.SetOutputDelayDepth(1u);
+  EXPECT_EQ(1u, sensor.OutputDelayDepth());
+  EXPECT_EQ(0u, sensor.DelayedMessageCount());
+  EXPECT_TRUE(sensor.Update(std::chrono::milliseconds(50), false));
+  EXPECT_TRUE(sensor.Update(std::chrono::milliseconds(60), false));
+  EXPECT_EQ(1u, sensor.DelayedMessageCount());
+
+  // Held messages are dropped when time goes backwards
+  EXPECT_FALSE(sensor.Update(std::chrono::milliseconds(5), false));
+  EXPECT_EQ(0u, sensor.DelayedMessageCount());
+
+  for (int sleep = 0; sleep < 30; ++sleep)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (received.size() >= 3u)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  EXPECT_EQ((std::vector<double>{0.01, 0.02, 0.05}), received);
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, BufferMemory)
+{
+  TestSensor sensor;
+  EXPECT_EQ(SensorBufferMemory::DEFAULT, sensor.BufferMemory());
+  sensor.SetBufferMemory(SensorBufferMemory::PINNED);
+  EXPECT_EQ(SensorBufferMemory::PINNED, sensor.BufferMemory());
+
+  auto load = [](TestSensor &_sensor, const std::string &_memory)
+  {
+    const std::string sensorSdf = R"(
+    <sdf version="1.9">
+      <model name="m1">
+        <link name="link1">
+          <sensor name="test" type="imu">
+            <gz_buffer_memory>)" + _memory + R"(</gz_buffer_memory>
+          </sensor>
+        </link>
+      </model>
+    </sdf>
+    )";
+    sdf::Root root;
+    sdf::Errors errors = root.LoadSdfString(sensorSdf);
+    ASSERT_TRUE(errors.empty()) << errors;
+    _sensor.Load(*root.Model()->LinkByIndex(0)->SensorByIndex(0));
+  };
+
+  load(sensor, "huge_pages");
+  EXPECT_EQ(SensorBufferMemory::HUGE_PAGES, sensor.BufferMemory());
+  load(sensor, "default");
+  EXPECT_EQ(SensorBufferMemory::DEFAULT, sensor.BufferMemory());
+
+  // Unknown kinds are ignored
+  load(sensor, "pinned");
+  load(sensor, "gpu");
+  EXPECT_EQ(SensorBufferMemory::PINNED, sensor.BufferMemory());
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, Recorder)
+{
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetName("recorded");
+  sdfSensor.SetTopic("/test_recorder");
+
+  RecordTestSensor sensor;
+  ASSERT_TRUE(sensor.Load(sdfSensor));
+  EXPECT_EQ(nullptr, sensor.Recorder());
+
+  // Not recorded without a recorder
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), false));
+
+  auto recorder = std::make_shared<SensorRecorder>();
+  ASSERT_TRUE(recorder->Open("sensor_test_recorder.mcap"));
+  sensor.SetRecorder(recorder);
+  EXPECT_EQ(recorder, sensor.Recorder());
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(2), false));
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(3), false));
+  EXPECT_EQ(2u, recorder->RecordedCount());
+
+  sensor.SetRecorder(nullptr);
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(4), false));
+  EXPECT_EQ(2u, recorder->RecordedCount());
+  recorder->Close();
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, Replay)
+{
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetName("replayed");
+  sdfSensor.SetType(sdf::SensorType::CUSTOM);
+  sdfSensor.SetTopic("/test_replay");
+  const std::string path = "sensor_test_replay.mcap";
+  {
+    RecordTestSensor recorded;
+    ASSERT_TRUE(recorded.Load(sdfSensor));
+    auto recorder = std::make_shared<SensorRecorder>();
+    ASSERT_TRUE(recorder->Open(path));
+    recorded.SetRecorder(recorder);
+    for (int i = 1; i <= 3; ++i)
+      EXPECT_TRUE(recorded.Update(std::chrono::seconds(i), false));
+    recorder->Close();
+  }
+
+  RecordTestSensor sensor;
+  ASSERT_TRUE(sensor.Load(sdfSensor));
+  EXPECT_EQ("custom", sensor.TypeStr());
+  EXPECT_EQ(nullptr, sensor.Replay());
+  auto replay = std::make_shared<SensorReplay>();
+  ASSERT_TRUE(replay->Open(path));
+  sensor.SetReplay(replay);
+  EXPECT_EQ(replay, sensor.Replay());
+
+  transport::Node node;
+  std::mutex mutex;
+  std::vector<double> received;
+  std::function<void(const msgs::Double &)> cb =
+      [&](const msgs::Double &_msg)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    received.push_back(_msg.data());
+  };
+  EXPECT_TRUE(node.Subscribe("/test_replay", cb));
+  for (int sleep = 0; sleep < 30 && !sensor.pub.HasConnections(); ++sleep)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_TRUE(sensor.pub.HasConnections());
+
+  // The recorded messages up to the update time are published in place of
+  // the update
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(2), false));
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(3), false));
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(4), false));
+  EXPECT_EQ(0u, sensor.updateCount);
+  for (int sleep = 0; sleep < 30; ++sleep)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (received.size() >= 3u)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(std::vector<double>({1.0, 2.0, 3.0}), received);
+  }
+
+  // Updates again without a replay
+  sensor.SetReplay(nullptr);
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(5), false));
+  EXPECT_EQ(1u, sensor.updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, RawPayloadOutput)
+{
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetName("raw");
+  sdfSensor.SetTopic("/test_raw_payload");
+
+  ImageTestSensor sensor;
+  ASSERT_TRUE(sensor.Load(sdfSensor));
+  EXPECT_FALSE(sensor.RawPayloadOutput());
+  sensor.SetRawPayloadOutput(true);
+  EXPECT_TRUE(sensor.RawPayloadOutput());
+
+  const std::string type = RawPayloadType("gz.msgs.Image");
+  transport::Node node;
+  std::mutex mutex;
+  std::vector<std::string> payloads;
+  std::vector<unsigned int> widths;
+  auto cb = [&](const char *_data, std::size_t _size,
+      const transport::MessageInfo &)
+  {
+    RawPayloadView view;
+    ASSERT_TRUE(ParseRawPayload(_data, _size, view));
+    msgs::Image rest;
+    ASSERT_TRUE(rest.ParseFromArray(view.message,
+        static_cast<int>(view.messageSize)));
+    std::lock_guard<std::mutex> lock(mutex);
+    payloads.emplace_back(view.payload, view.payloadSize);
+    widths.push_back(rest.width());
+  };
+  EXPECT_TRUE(node.SubscribeRaw("/test_raw_payload/raw", cb, type));
+
+  // The raw topic is advertised by the first message
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), false));
+  for (int sleep = 0; sleep < 30; ++sleep)
+  {
+    EXPECT_TRUE(sensor.Update(std::chrono::seconds(2 + sleep), false));
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!payloads.empty())
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_FALSE(payloads.empty());
+  EXPECT_EQ("pixels", payloads.front());
+  EXPECT_EQ(2u, widths.front());
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, Backpressure)
+{
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetName("backpressure");
+  sdfSensor.SetTopic("/test_backpressure");
+
+  RecordTestSensor sensor;
+  ASSERT_TRUE(sensor.Load(sdfSensor));
+  EXPECT_EQ(0u, sensor.BackpressureDepth());
+  EXPECT_EQ(0u, sensor.BackpressureBytes());
+  sensor.SetAsyncPublish(true);
+  sensor.SetBackpressureLimits(1u, 1024u * 1024u);
+  EXPECT_EQ(1u, sensor.BackpressureDepth());
+  EXPECT_EQ(1024u * 1024u, sensor.BackpressureBytes());
+
+  // A subscriber that blocks the publishing thread until released
+  transport::Node node;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool entered = false;
+  bool released = false;
+  std::function<void(const msgs::Double &)> cb =
+      [&](const msgs::Double &)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    entered = true;
+    cv.notify_all();
+    cv.wait(lock, [&released] { return released; });
+  };
+  EXPECT_TRUE(node.Subscribe("/test_backpressure", cb));
+  for (int sleep = 0; sleep < 30 && !sensor.pub.HasConnections(); ++sleep)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_TRUE(sensor.pub.HasConnections());
+
+  EXPECT_TRUE(sensor.Update(std::chrono::seconds(1), false));
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(3),
+        [&entered] { return entered; }));
+  }
+
+  // The only topic with subscribers is backed up, so updates are skipped
+  // and messages published anyway are dropped
+  EXPECT_FALSE(sensor.Update(std::chrono::seconds(2), false));
+  EXPECT_EQ(1u, sensor.updateCount);
+  EXPECT_EQ(1u, sensor.BackpressureSkippedCount());
+  msgs::Double msg;
+  EXPECT_FALSE(sensor.Publish(sensor.pub, msg));
+  EXPECT_EQ(1u, sensor.DroppedMessageCount());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    released = true;
+  }
+  cv.notify_all();
+
+  // Updates resume once the subscriber caught up
+  for (int i = 3; i < 33 && sensor.updateCount < 2u; ++i)
+  {
+    sensor.Update(std::chrono::seconds(i), false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  EXPECT_EQ(2u, sensor.updateCount);
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, InputInterpolation)
+{
+  using namespace std::chrono_literals;
+  PoseTestSensor sensor;
+  EXPECT_FALSE(sensor.InputInterpolation());
+  sensor.SetUpdateRate(100.0);
+  sensor.SetInputInterpolation(true);
+  EXPECT_TRUE(sensor.InputInterpolation());
+
+  // The inputs are set every 40 ms, moving 1 m per step and turning
+  auto poseAt = [](int _step)
+  {
+    return math::Pose3d(_step, 0, 0, 0, 0, 0.4 * _step);
+  };
+
+  // The first update has no previous inputs
+  sensor.SetPose(poseAt(0));
+  EXPECT_TRUE(sensor.Update(0ms, false));
+  ASSERT_EQ(1u, sensor.poses.size());
+
+  // Each step generates the samples due since the previous one
+  sensor.SetPose(poseAt(1));
+  EXPECT_TRUE(sensor.Update(40ms, false));
+  ASSERT_EQ(5u, sensor.poses.size());
+  for (std::size_t i = 1u; i < sensor.poses.size(); ++i)
+  {
+    const double alpha = i / 4.0;
+    const std::chrono::steady_clock::duration expected = 10ms * i;
+    EXPECT_EQ(expected.count(), sensor.times[i].count());
+    EXPECT_NEAR(alpha, sensor.poses[i].Pos().X(), 1e-9);
+    EXPECT_NEAR(0.4 * alpha, sensor.poses[i].Rot().Yaw(), 1e-9);
+  }
+
+  // The pose of the step is set exactly after the update
+  EXPECT_EQ(poseAt(1), sensor.Pose());
+
+  sensor.SetPose(poseAt(2));
+  EXPECT_TRUE(sensor.Update(80ms, false));
+  ASSERT_EQ(9u, sensor.poses.size());
+  EXPECT_NEAR(1.25, sensor.poses[5].Pos().X(), 1e-9);
+  EXPECT_EQ(poseAt(2), sensor.poses[8]);
+
+  // Forced updates generate a single sample
+  sensor.SetPose(poseAt(3));
+  EXPECT_TRUE(sensor.Update(120ms, true));
+  EXPECT_EQ(10u, sensor.poses.size());
+
+  // Without interpolation, one sample per step
+  sensor.SetInputInterpolation(false);
+  EXPECT_TRUE(sensor.Update(160ms, false));
+  EXPECT_EQ(11u, sensor.poses.size());
+}
+
+//////////////////////////////////////////////////
+TEST(Sensor_TEST, Bundle)
+{
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetName("camera");
+  sdfSensor.SetTopic("/test_bundle_camera");
+  RecordTestSensor camera;
+  ASSERT_TRUE(camera.Load(sdfSensor));
+  camera.SetUpdateRate(25.0);
+
+  sdfSensor.SetName("imu");
+  sdfSensor.SetTopic("/test_bundle_imu");
+  LazyRecordTestSensor imu;
+  ASSERT_TRUE(imu.Load(sdfSensor));
+  imu.SetUpdateRate(100.0);
+  imu.SetLazyUpdate(true);
+
+  auto bundle = std::make_shared<SensorBundle>();
+  bundle->SetPrimary("camera");
+  camera.SetBundle(bundle);
+  imu.SetBundle(bundle);
+  EXPECT_EQ(bundle, camera.Bundle());
+
+  std::vector<std::string> frames;
+  bundle->SetFrameCallback([&frames](const char *_data, std::size_t _size)
+  {
+    frames.emplace_back(_data, _size);
+  });
+
+  // The imu keeps updating without subscribers while frames are consumed
+  using namespace std::chrono_literals;
+  for (auto now = 0ms; now <= 80ms; now += 10ms)
+  {
+    imu.Update(now, false);
+    camera.Update(now, false);
+  }
+  EXPECT_EQ(9u, imu.updateCount);
+  EXPECT_EQ(3u, camera.updateCount);
+  ASSERT_EQ(3u, frames.size());
+
+  // Each image comes with the imu samples since the previous one
+  std::chrono::steady_clock::duration time{0};
+  std::vector<SensorBundleEntry> entries;
+  ASSERT_TRUE(ParseSensorBundle(frames[1].data(), frames[1].size(), time,
+      entries));
+  EXPECT_EQ(std::chrono::steady_clock::duration(40ms).count(), time.count());
+  ASSERT_EQ(5u, entries.size());
+  for (std::size_t i = 0u; i < 4u; ++i)
+  {
+    EXPECT_EQ("/test_bundle_imu", entries[i].topic);
+    EXPECT_EQ("gz.msgs.Double", entries[i].type);
+  }
+  EXPECT_EQ("/test_bundle_camera", entries[4].topic);
+  msgs::Double msg;
+  ASSERT_TRUE(msg.ParseFromArray(entries[4].message,
+      static_cast<int>(entries[4].messageSize)));
+  EXPECT_DOUBLE_EQ(0.04, msg.data());
+
+  // Without the bundle, the lazy imu skips its updates
+  imu.SetBundle(nullptr);
+  imu.Update(90ms, false);
+  EXPECT_EQ(9u, imu.updateCount);
+}
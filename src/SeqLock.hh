@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SEQLOCK_HH_
+#define GZ_SENSORS_SEQLOCK_HH_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Latest value written by one thread and read by any number of
+    /// threads without locking. The writer never waits, readers retry while
+    /// a write is in progress. The value is kept in atomic words, so a read
+    /// that overlaps a write is discarded rather than undefined.
+    /// \tparam T Trivially copyable value type.
+    template <typename T>
+    class SeqLock
+    {
+      static_assert(std::is_trivially_copyable_v<T>,
+          "SeqLock values must be trivially copyable");
+
+      /// \brief Constructor
+      /// \param[in] _value Initial value.
+      public: explicit SeqLock(const T &_value = T())
+      {
+        this->Store(_value);
+        this->sequence.store(0, std::memory_order_relaxed);
+      }
+
+      /// \brief Store a new value. Only one thread may store at a time.
+      /// \param[in] _value Value to store.
+      public: void Store(const T &_value)
+      {
+        Words words{};
+        std::memcpy(words.data(), &_value, sizeof(T));
+
+        const uint64_t seq = this->sequence.load(std::memory_order_relaxed);
+        this->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < words.size(); ++i)
+          this->data[i].store(words[i], std::memory_order_relaxed);
+        this->sequence.store(seq + 2, std::memory_order_release);
+      }
+
+      /// \brief Load the latest value.
+      /// \return Copy of the value last stored.
+      public: T Load() const
+      {
+        Words words;
+        uint64_t before;
+        uint64_t after;
+        do
+        {
+          before = this->sequence.load(std::memory_order_acquire);
+          for (std::size_t i = 0; i < words.size(); ++i)
+            words[i] = this->data[i].load(std::memory_order_relaxed);
+          std::atomic_thread_fence(std::memory_order_acquire);
+          after = this->sequence.load(std::memory_order_relaxed);
+        }
+        while ((before & 1u) || before != after);
+
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+      }
+
+      /// \brief Get the number of values stored since construction.
+      /// \return Number of stores.
+      public: uint64_t Count() const
+      {
+        return this->sequence.load(std::memory_order_acquire) / 2;
+      }
+
+      /// \brief Words holding a value.
+      private: using Words = std::array<uint64_t,
+          (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)>;
+
+      /// \brief Odd while a value is being stored, incremented twice per
+      /// store.
+      private: std::atomic<uint64_t> sequence{0};
+
+      /// \brief The value.
+      private: std::array<std::atomic<uint64_t>,
+          std::tuple_size_v<Words>> data{};
+    };
+    }
+  }
+}
+
+#endif
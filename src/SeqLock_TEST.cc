@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "SeqLock.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Value with fields that must be read together.
+struct Sample
+{
+  double a;
+  double b;
+  int64_t c;
+  bool flag;
+};
+
+/////////////////////////////////////////////////
+TEST(SeqLock, StoreLoad)
+{
+  SeqLock<Sample> lock;
+  EXPECT_EQ(0u, lock.Count());
+  EXPECT_DOUBLE_EQ(0.0, lock.Load().a);
+  EXPECT_FALSE(lock.Load().flag);
+
+  lock.Store({1.0, 2.0, 3, true});
+  EXPECT_EQ(1u, lock.Count());
+  const Sample sample = lock.Load();
+  EXPECT_DOUBLE_EQ(1.0, sample.a);
+  EXPECT_DOUBLE_EQ(2.0, sample.b);
+  EXPECT_EQ(3, sample.c);
+  EXPECT_TRUE(sample.flag);
+}
+
+/////////////////////////////////////////////////
+TEST(SeqLock, Threads)
+{
+  SeqLock<Sample> lock;
+  std::atomic<bool> done{false};
+  std::atomic<int> torn{0};
+  std::thread reader([&]
+  {
+    while (!done)
+    {
+      const Sample sample = lock.Load();
+      if (sample.b != sample.a * 2.0 ||
+          sample.c != static_cast<int64_t>(sample.a))
+      {
+        ++torn;
+      }
+    }
+  });
+
+  for (int i = 0; i < 100000; ++i)
+    lock.Store({static_cast<double>(i), i * 2.0, i, i % 2 == 0});
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(0, torn);
+  EXPECT_EQ(100000u, lock.Count());
+  EXPECT_DOUBLE_EQ(99999.0, lock.Load().a);
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "SharedMemoryImageWriter.hh"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Profiler.hh>
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Alignment of the slots and of their pixels.
+constexpr std::size_t kSlotAlignment = 64u;
+
+/// \brief Round a size up to kSlotAlignment.
+/// \param[in] _size Size in bytes.
+/// \return Aligned size.
+std::size_t AlignSize(std::size_t _size)
+{
+  return (_size + kSlotAlignment - 1u) / kSlotAlignment * kSlotAlignment;
+}
+}
+
+//////////////////////////////////////////////////
+SharedMemoryImageWriter::SharedMemoryImageWriter(const std::string &_name,
+    unsigned int _slotCount)
+  : name(_name), slotCount(_slotCount > 0u ? _slotCount : 1u)
+{
+}
+
+//////////////////////////////////////////////////
+SharedMemoryImageWriter::~SharedMemoryImageWriter()
+{
+  this->Unmap();
+}
+
+//////////////////////////////////////////////////
+const std::string &SharedMemoryImageWriter::Name() const
+{
+  return this->name;
+}
+
+//////////////////////////////////////////////////
+bool SharedMemoryImageWriter::Map(std::size_t _size)
+{
+#ifdef _WIN32
+  (void)_size;
+  if (!this->failed)
+  {
+    gzerr << "Shared memory image output is not supported on Windows.\n";
+    this->failed = true;
+  }
+  return false;
+#else
+  this->Unmap();
+
+  const std::size_t newSlotSize =
+      AlignSize(sizeof(SharedMemoryImageSlot) + _size);
+  const std::size_t newMapSize =
+      AlignSize(sizeof(SharedMemoryImageHeader)) +
+      newSlotSize * this->slotCount;
+
+  // Remove a stale segment left behind by a process that crashed
+  shm_unlink(this->name.c_str());
+  int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+  {
+    if (!this->failed)
+    {
+      gzerr << "Unable to create shared memory segment [" << this->name
+            << "]: " << std::strerror(errno) << std::endl;
+      this->failed = true;
+    }
+    return false;
+  }
+
+  void *addr = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(newMapSize)) == 0)
+  {
+    addr = mmap(nullptr, newMapSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+        fd, 0);
+  }
+  const int error = errno;
+  close(fd);
+  if (addr == MAP_FAILED)
+  {
+    if (!this->failed)
+    {
+      gzerr << "Unable to map shared memory segment [" << this->name
+            << "] of " << newMapSize << " bytes: " << std::strerror(error)
+            << std::endl;
+      this->failed = true;
+    }
+    shm_unlink(this->name.c_str());
+    return false;
+  }
+
+  this->address = addr;
+  this->mapSize = newMapSize;
+  this->slotSize = newSlotSize;
+  this->failed = false;
+
+  // The segment is zero filled by ftruncate
+  auto *bytes = static_cast<unsigned char *>(this->address);
+  for (uint32_t i = 0; i < this->slotCount; ++i)
+  {
+    new (bytes + AlignSize(sizeof(SharedMemoryImageHeader)) +
+        i * this->slotSize) SharedMemoryImageSlot{};
+  }
+  auto *header = new (bytes) SharedMemoryImageHeader{};
+  header->version = SharedMemoryImageHeader::kVersion;
+  header->slotCount = this->slotCount;
+  header->slotSize = this->slotSize;
+  header->frameCount.store(this->frameCount, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = SharedMemoryImageHeader::kMagic;
+  return true;
+#endif
+}
+
+//////////////////////////////////////////////////
+void SharedMemoryImageWriter::Unmap()
+{
+#ifndef _WIN32
+  if (!this->address)
+    return;
+
+  // Tell readers still mapping this segment to reopen it
+  static_cast<SharedMemoryImageHeader *>(this->address)->magic = 0u;
+  std::atomic_thread_fence(std::memory_order_release);
+
+  munmap(this->address, this->mapSize);
+  shm_unlink(this->name.c_str());
+  this->address = nullptr;
+  this->mapSize = 0u;
+  this->slotSize = 0u;
+#endif
+}
+
+//////////////////////////////////////////////////
+bool SharedMemoryImageWriter::Write(const msgs::Image &_image,
+    const void *_data, std::size_t _size, uint32_t &_slot,
+    uint64_t &_sequence)
+{
+  GZ_PROFILE("SharedMemoryImageWriter::Write");
+  if (!this->address ||
+      this->slotSize < sizeof(SharedMemoryImageSlot) + _size)
+  {
+    if (!this->Map(_size))
+      return false;
+  }
+
+  _slot = static_cast<uint32_t>(this->frameCount % this->slotCount);
+  auto *bytes = static_cast<unsigned char *>(this->address) +
+      AlignSize(sizeof(SharedMemoryImageHeader)) + _slot * this->slotSize;
+  auto *slot = reinterpret_cast<SharedMemoryImageSlot *>(bytes);
+
+  // Odd sequence while the slot is being written
+  const uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+  slot->sequence.store(sequence + 1u, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot->width = _image.width();
+  slot->height = _image.height();
+  slot->step = _image.step();
+  slot->pixelFormat = static_cast<uint32_t>(_image.pixel_format_type());
+  slot->sec = _image.header().stamp().sec();
+  slot->nsec = _image.header().stamp().nsec();
+  slot->size = _size;
+  std::memcpy(bytes + sizeof(SharedMemoryImageSlot), _data, _size);
+
+  _sequence = sequence + 2u;
+  slot->sequence.store(_sequence, std::memory_order_release);
+
+  ++this->frameCount;
+  static_cast<SharedMemoryImageHeader *>(this->address)->frameCount.store(
+      this->frameCount, std::memory_order_release);
+  return true;
+}
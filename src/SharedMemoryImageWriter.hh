@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SHAREDMEMORYIMAGEWRITER_HH_
+#define GZ_SENSORS_SHAREDMEMORYIMAGEWRITER_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <gz/msgs/image.pb.h>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/SharedMemoryImage.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Writes image frames into a named shared memory segment laid
+    /// out as described by SharedMemoryImageHeader. The segment is created
+    /// on the first write and removed on destruction. Only available on
+    /// POSIX platforms.
+    class SharedMemoryImageWriter
+    {
+      /// \brief Constructor
+      /// \param[in] _name Name of the segment, starting with '/'.
+      /// \param[in] _slotCount Number of slots. Zero is treated as one.
+      public: SharedMemoryImageWriter(const std::string &_name,
+                  unsigned int _slotCount);
+
+      /// \brief Destructor. Unmaps and removes the segment.
+      public: ~SharedMemoryImageWriter();
+
+      /// \brief No copy.
+      public: SharedMemoryImageWriter(const SharedMemoryImageWriter &) =
+                  delete;
+
+      /// \brief No copy.
+      public: SharedMemoryImageWriter &operator=(
+                  const SharedMemoryImageWriter &) = delete;
+
+      /// \brief Write a frame into the next slot.
+      /// \param[in] _image Width, height, step, pixel format and stamp of
+      /// the frame. Its data field is ignored.
+      /// \param[in] _data Pixels of the frame.
+      /// \param[in] _size Number of bytes in _data.
+      /// \param[out] _slot Slot the frame was written to.
+      /// \param[out] _sequence Sequence of the slot once written.
+      /// \return True if the frame was written.
+      public: bool Write(const msgs::Image &_image, const void *_data,
+                  std::size_t _size, uint32_t &_slot, uint64_t &_sequence);
+
+      /// \brief Get the name of the segment.
+      /// \return Segment name.
+      public: const std::string &Name() const;
+
+      /// \brief Map a segment with slots large enough for _size bytes of
+      /// pixels, replacing the current one.
+      /// \param[in] _size Pixel bytes per slot.
+      /// \return True on success.
+      private: bool Map(std::size_t _size);
+
+      /// \brief Unmap and remove the current segment.
+      private: void Unmap();
+
+      /// \brief Name of the segment.
+      private: std::string name;
+
+      /// \brief Number of slots.
+      private: uint32_t slotCount{1u};
+
+      /// \brief Size of a slot in bytes.
+      private: std::size_t slotSize{0u};
+
+      /// \brief Mapped address of the segment.
+      private: void *address{nullptr};
+
+      /// \brief Size of the mapping in bytes.
+      private: std::size_t mapSize{0u};
+
+      /// \brief Number of frames written.
+      private: uint64_t frameCount{0u};
+
+      /// \brief True once a failure has been reported, to avoid flooding
+      /// the console.
+      private: bool failed{false};
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SHAREDTABLECACHE_HH_
+#define GZ_SENSORS_SHAREDTABLECACHE_HH_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Parameters a table is built from, compared byte for byte.
+    class SharedTableKey
+    {
+      /// \brief Append a parameter.
+      /// \param[in] _value Value of a trivially copyable type.
+      /// \return This key.
+      public: template <typename T>
+      SharedTableKey &Add(const T &_value)
+      {
+        static_assert(std::is_trivially_copyable_v<T>,
+            "Keys are made of trivially copyable values");
+        this->bytes.append(reinterpret_cast<const char *>(&_value),
+            sizeof(T));
+        return *this;
+      }
+
+      /// \brief Append a list of parameters, and its size so that
+      /// consecutive lists can't be confused.
+      /// \param[in] _values Values of a trivially copyable type.
+      /// \return This key.
+      public: template <typename T>
+      SharedTableKey &Add(const std::vector<T> &_values)
+      {
+        static_assert(std::is_trivially_copyable_v<T>,
+            "Keys are made of trivially copyable values");
+        this->Add(_values.size());
+        this->bytes.append(reinterpret_cast<const char *>(_values.data()),
+            _values.size() * sizeof(T));
+        return *this;
+      }
+
+      /// \brief Equality operator
+      /// \param[in] _other Key to compare to.
+      /// \return True if both keys have the same parameters.
+      public: bool operator==(const SharedTableKey &_other) const
+      {
+        return this->bytes == _other.bytes;
+      }
+
+      /// \brief Get the bytes of the parameters.
+      /// \return Bytes of the parameters, in the order they were added.
+      public: const std::string &Bytes() const
+      {
+        return this->bytes;
+      }
+
+      /// \brief Bytes of the parameters.
+      private: std::string bytes;
+    };
+
+    /// \brief Immutable tables shared by sensors with the same parameters,
+    /// such as the distortion map of identical cameras. A table is built
+    /// the first time its key is requested and lives as long as a sensor
+    /// holds it, so memory scales with the number of distinct
+    /// configurations instead of the number of sensors. Thread safe.
+    /// \tparam T Type of the tables.
+    template <typename T>
+    class SharedTableCache
+    {
+      /// \brief Get the table of a key, building it if no sensor holds it.
+      /// \param[in] _key Parameters of the table.
+      /// \param[in] _build Function building the table, called with the
+      /// cache locked.
+      /// \return The shared table.
+      public: std::shared_ptr<const T> Get(const SharedTableKey &_key,
+                  const std::function<T()> &_build)
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        auto &entry = this->tables[_key.Bytes()];
+        std::shared_ptr<const T> table = entry.lock();
+        if (table)
+          return table;
+
+        // Tables are rarely built, drop the ones no sensor holds anymore
+        for (auto it = this->tables.begin(); it != this->tables.end();)
+        {
+          if (it->second.expired() && &it->second != &entry)
+            it = this->tables.erase(it);
+          else
+            ++it;
+        }
+
+        table = std::make_shared<const T>(_build());
+        entry = table;
+        return table;
+      }
+
+      /// \brief Get the number of tables held by sensors.
+      /// \return Number of tables.
+      public: std::size_t Size() const
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::size_t count = 0u;
+        for (const auto &entry : this->tables)
+        {
+          if (!entry.second.expired())
+            ++count;
+        }
+        return count;
+      }
+
+      /// \brief Protects the tables.
+      private: mutable std::mutex mutex;
+
+      /// \brief Tables by key.
+      private: std::unordered_map<std::string, std::weak_ptr<const T>>
+                   tables;
+    };
+    }
+  }
+}
+
+#endif
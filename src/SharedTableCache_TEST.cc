@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "SharedTableCache.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(SharedTableCache_TEST, Key)
+{
+  SharedTableKey a;
+  a.Add(1.0).Add(2u);
+  SharedTableKey b;
+  b.Add(1.0).Add(2u);
+  EXPECT_TRUE(a == b);
+
+  SharedTableKey c;
+  c.Add(1.0).Add(3u);
+  EXPECT_FALSE(a == c);
+
+  // Lists keep their boundaries
+  SharedTableKey d;
+  d.Add(std::vector<int>{1}).Add(std::vector<int>{2, 3});
+  SharedTableKey e;
+  e.Add(std::vector<int>{1, 2}).Add(std::vector<int>{3});
+  EXPECT_FALSE(d == e);
+}
+
+//////////////////////////////////////////////////
+TEST(SharedTableCache_TEST, Share)
+{
+  SharedTableCache<std::vector<int>> cache;
+  int builds = 0;
+  auto build = [&builds]()
+  {
+    ++builds;
+    return std::vector<int>(1000, builds);
+  };
+
+  SharedTableKey key;
+  key.Add(640u).Add(480u);
+  auto first = cache.Get(key, build);
+  auto second = cache.Get(key, build);
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(1, builds);
+  EXPECT_EQ(1u, cache.Size());
+
+  SharedTableKey other;
+  other.Add(320u).Add(240u);
+  auto third = cache.Get(other, build);
+  EXPECT_NE(first, third);
+  EXPECT_EQ(2, builds);
+  EXPECT_EQ(2, (*third)[0]);
+  EXPECT_EQ(2u, cache.Size());
+
+  // Tables no sensor holds are rebuilt
+  first.reset();
+  EXPECT_EQ(2u, cache.Size());
+  second.reset();
+  EXPECT_EQ(1u, cache.Size());
+  auto again = cache.Get(key, build);
+  EXPECT_EQ(3, builds);
+  EXPECT_EQ(3, (*again)[0]);
+}
+
+//////////////////////////////////////////////////
+TEST(SharedTableCache_TEST, Threads)
+{
+  SharedTableCache<std::vector<int>> cache;
+  SharedTableKey key;
+  key.Add(7);
+
+  std::vector<std::shared_ptr<const std::vector<int>>> tables(8);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < tables.size(); ++i)
+  {
+    threads.emplace_back([&, i]()
+    {
+      tables[i] = cache.Get(key, []() { return std::vector<int>(64, 7); });
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  for (const auto &table : tables)
+    EXPECT_EQ(tables[0], table);
+}
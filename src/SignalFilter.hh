@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_SIGNALFILTER_HH_
+#define GZ_SENSORS_SIGNALFILTER_HH_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/math/Helpers.hh>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/SensorState.hh"
+#include "gz/sensors/SensorTypes.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Filter of a fixed number of output channels, such as the
+    /// axes of an IMU, with a constant cost per sample and its state
+    /// allocated when it's configured. Samples that aren't finite pass
+    /// through without entering the state, so a single bad sample doesn't
+    /// poison the following ones.
+    /// \tparam N Number of channels.
+    template <std::size_t N>
+    class SignalFilter
+    {
+      /// \brief Configure the filter and reset its state.
+      /// \param[in] _options Filter options.
+      /// \param[in] _updateRate Update rate of the sensor in Hz, used if
+      /// the options don't set the sample rate.
+      /// \param[in] _name Name of the sensor, for error messages.
+      /// \return False if the options are invalid, in which case the
+      /// filter is left unchanged.
+      public: bool Configure(const SignalFilterOptions &_options,
+                  double _updateRate, const std::string &_name)
+      {
+        if (_options.decimation < 1u)
+        {
+          gzerr << "Unable to set the output filter of [" << _name
+                << "], the decimation must be at least 1.\n";
+          return false;
+        }
+
+        const double rate = _options.sampleRate > 0.0 ?
+            _options.sampleRate : _updateRate;
+        double b0{1.0}, b1{0.0}, b2{0.0}, a1{0.0}, a2{0.0};
+        if (_options.type == SignalFilterType::MOVING_AVERAGE &&
+            _options.window < 1u)
+        {
+          gzerr << "Unable to set the output filter of [" << _name
+                << "], the moving average window must be at least 1.\n";
+          return false;
+        }
+        else if (_options.type == SignalFilterType::BUTTERWORTH)
+        {
+          if (rate <= 0.0 || _options.cutoffFrequency <= 0.0 ||
+              _options.cutoffFrequency >= rate * 0.5)
+          {
+            gzerr << "Unable to set the output filter of [" << _name
+                  << "], the Butterworth cutoff frequency ["
+                  << _options.cutoffFrequency << "] must be positive and "
+                  << "below half the sample rate [" << rate << "].\n";
+            return false;
+          }
+
+          // Bilinear transform, with the cutoff frequency prewarped
+          const double k = std::tan(GZ_PI * _options.cutoffFrequency / rate);
+          const double k2 = k * k;
+          const double norm = 1.0 / (1.0 + GZ_SQRT2 * k + k2);
+          b0 = k2 * norm;
+          b1 = 2.0 * b0;
+          b2 = b0;
+          a1 = 2.0 * (k2 - 1.0) * norm;
+          a2 = (1.0 - GZ_SQRT2 * k + k2) * norm;
+        }
+
+        this->options = _options;
+        this->b0 = b0;
+        this->b1 = b1;
+        this->b2 = b2;
+        this->a1 = a1;
+        this->a2 = a2;
+        this->window.assign(
+            _options.type == SignalFilterType::MOVING_AVERAGE ?
+            _options.window : 0u, std::array<double, N>{});
+        this->Reset();
+        return true;
+      }
+
+      /// \brief Get the options of the filter.
+      /// \return Options.
+      public: const SignalFilterOptions &Options() const
+      {
+        return this->options;
+      }
+
+      /// \brief Forget the filtered samples.
+      public: void Reset()
+      {
+        this->sum.fill(0.0);
+        this->z1.fill(0.0);
+        this->z2.fill(0.0);
+        this->filled = 0u;
+        this->next = 0u;
+        this->primed = false;
+        // The first sample is output
+        this->skipped = this->options.decimation - 1u;
+      }
+
+      /// \brief Filter a sample of every channel in place.
+      /// \param[in,out] _values Value of each channel.
+      /// \return True if the sample is output, false if it's dropped by
+      /// decimation.
+      public: bool Apply(const std::array<double *, N> &_values)
+      {
+        switch (this->options.type)
+        {
+          case SignalFilterType::MOVING_AVERAGE:
+            this->ApplyMovingAverage(_values);
+            break;
+          case SignalFilterType::BUTTERWORTH:
+            this->ApplyButterworth(_values);
+            break;
+          case SignalFilterType::NONE:
+          default:
+            break;
+        }
+
+        if (++this->skipped < this->options.decimation)
+          return false;
+        this->skipped = 0u;
+        return true;
+      }
+
+      /// \brief Append the state of the filter to _state.
+      /// \param[in,out] _state State to append to.
+      public: void SaveState(SensorState &_state) const
+      {
+        _state.Write(this->sum);
+        _state.Write(this->z1);
+        _state.Write(this->z2);
+        _state.Write(static_cast<uint64_t>(this->filled));
+        _state.Write(static_cast<uint64_t>(this->next));
+        _state.Write(this->primed);
+        _state.Write(this->skipped);
+        for (const auto &sample : this->window)
+          _state.Write(sample);
+      }
+
+      /// \brief Restore the state saved by SaveState(), for a filter
+      /// configured with the same options.
+      /// \param[in,out] _state State to read from.
+      /// \return False if _state is too short.
+      public: bool RestoreState(SensorState &_state)
+      {
+        uint64_t filledCount{0u};
+        uint64_t nextIndex{0u};
+        if (!_state.Read(this->sum) || !_state.Read(this->z1) ||
+            !_state.Read(this->z2) || !_state.Read(filledCount) ||
+            !_state.Read(nextIndex) || !_state.Read(this->primed) ||
+            !_state.Read(this->skipped))
+        {
+          return false;
+        }
+        this->filled = static_cast<std::size_t>(filledCount);
+        this->next = static_cast<std::size_t>(nextIndex);
+        for (auto &sample : this->window)
+        {
+          if (!_state.Read(sample))
+            return false;
+        }
+        return true;
+      }
+
+      /// \brief Average the last samples.
+      /// \param[in,out] _values Value of each channel.
+      private: void ApplyMovingAverage(const std::array<double *, N> &_values)
+      {
+        auto &slot = this->window[this->next];
+        const bool full = this->filled == this->window.size();
+        for (std::size_t i = 0u; i < N; ++i)
+        {
+          const double value = *_values[i];
+          // Keep the previous sample of the channel in the window
+          const double in = std::isfinite(value) ? value :
+              (full || this->filled > 0u ? slot[i] : 0.0);
+          if (full)
+            this->sum[i] -= slot[i];
+          slot[i] = in;
+          this->sum[i] += in;
+        }
+        if (!full)
+          ++this->filled;
+
+        if (++this->next == this->window.size())
+        {
+          // Sum the window again once per turn, so rounding errors don't
+          // build up
+          this->next = 0u;
+          this->sum.fill(0.0);
+          for (const auto &sample : this->window)
+          {
+            for (std::size_t i = 0u; i < N; ++i)
+              this->sum[i] += sample[i];
+          }
+        }
+
+        const double scale = 1.0 / static_cast<double>(this->filled);
+        for (std::size_t i = 0u; i < N; ++i)
+        {
+          if (std::isfinite(*_values[i]))
+            *_values[i] = this->sum[i] * scale;
+        }
+      }
+
+      /// \brief Low-pass filter the samples, in transposed direct form II.
+      /// \param[in,out] _values Value of each channel.
+      private: void ApplyButterworth(const std::array<double *, N> &_values)
+      {
+        if (!this->primed)
+        {
+          // Start from the steady state of the first sample, so the
+          // output doesn't ramp up from zero
+          for (std::size_t i = 0u; i < N; ++i)
+          {
+            const double x = std::isfinite(*_values[i]) ? *_values[i] : 0.0;
+            this->z1[i] = x * (1.0 - this->b0);
+            this->z2[i] = x * (this->b2 - this->a2);
+          }
+          this->primed = true;
+        }
+
+        for (std::size_t i = 0u; i < N; ++i)
+        {
+          const double x = *_values[i];
+          if (!std::isfinite(x))
+            continue;
+          const double y = this->b0 * x + this->z1[i];
+          this->z1[i] = this->b1 * x - this->a1 * y + this->z2[i];
+          this->z2[i] = this->b2 * x - this->a2 * y;
+          *_values[i] = y;
+        }
+      }
+
+      /// \brief Filter options.
+      private: SignalFilterOptions options;
+
+      /// \brief Biquad coefficients.
+      private: double b0{1.0};
+
+      /// \brief Biquad coefficients.
+      private: double b1{0.0};
+
+      /// \brief Biquad coefficients.
+      private: double b2{0.0};
+
+      /// \brief Biquad coefficients.
+      private: double a1{0.0};
+
+      /// \brief Biquad coefficients.
+      private: double a2{0.0};
+
+      /// \brief Biquad state of each channel.
+      private: std::array<double, N> z1{};
+
+      /// \brief Biquad state of each channel.
+      private: std::array<double, N> z2{};
+
+      /// \brief True once the biquad state is initialized.
+      private: bool primed{false};
+
+      /// \brief Last samples of the moving average, a ring.
+      private: std::vector<std::array<double, N>> window;
+
+      /// \brief Sum of the samples in window.
+      private: std::array<double, N> sum{};
+
+      /// \brief Number of samples in window.
+      private: std::size_t filled{0u};
+
+      /// \brief Slot of window of the next sample.
+      private: std::size_t next{0u};
+
+      /// \brief Samples dropped since the last output.
+      private: unsigned int skipped{0u};
+    };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <gz/math/Helpers.hh>
+
+#include "gz/sensors/SensorState.hh"
+#include "SignalFilter.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/////////////////////////////////////////////////
+TEST(SignalFilter, None)
+{
+  SignalFilter<2> filter;
+  double a = 1.5;
+  double b = -2.0;
+  EXPECT_TRUE(filter.Apply({&a, &b}));
+  EXPECT_DOUBLE_EQ(1.5, a);
+  EXPECT_DOUBLE_EQ(-2.0, b);
+}
+
+/////////////////////////////////////////////////
+TEST(SignalFilter, Invalid)
+{
+  SignalFilter<1> filter;
+  SignalFilterOptions options;
+  options.decimation = 0u;
+  EXPECT_FALSE(filter.Configure(options, 100.0, "sensor"));
+
+  options.decimation = 1u;
+  options.type = SignalFilterType::MOVING_AVERAGE;
+  options.window = 0u;
+  EXPECT_FALSE(filter.Configure(options, 100.0, "sensor"));
+
+  options.type = SignalFilterType::BUTTERWORTH;
+  options.cutoffFrequency = 60.0;
+  EXPECT_FALSE(filter.Configure(options, 100.0, "sensor"));
+  options.cutoffFrequency = 10.0;
+  EXPECT_FALSE(filter.Configure(options, 0.0, "sensor"));
+  EXPECT_EQ(SignalFilterType::NONE, filter.Options().type);
+
+  EXPECT_TRUE(filter.Configure(options, 100.0, "sensor"));
+  EXPECT_EQ(SignalFilterType::BUTTERWORTH, filter.Options().type);
+}
+
+/////////////////////////////////////////////////
+TEST(SignalFilter, MovingAverage)
+{
+  SignalFilter<1> filter;
+  SignalFilterOptions options;
+  options.type = SignalFilterType::MOVING_AVERAGE;
+  options.window = 3u;
+  ASSERT_TRUE(filter.Configure(options, 0.0, "sensor"));
+
+  const double input[] = {3.0, 6.0, 9.0, 12.0, 0.0, 3.0, 3.0};
+  const double expected[] = {3.0, 4.5, 6.0, 9.0, 7.0, 5.0, 2.0};
+  for (int i = 0; i < 7; ++i)
+  {
+    double value = input[i];
+    EXPECT_TRUE(filter.Apply({&value}));
+    EXPECT_DOUBLE_EQ(expected[i], value) << i;
+  }
+
+  // Non finite samples pass through and don't enter the average
+  double value = std::numeric_limits<double>::quiet_NaN();
+  filter.Apply({&value});
+  EXPECT_TRUE(std::isnan(value));
+  value = 6.0;
+  filter.Apply({&value});
+  EXPECT_DOUBLE_EQ(3.0, value);
+}
+
+/////////////////////////////////////////////////
+TEST(SignalFilter, Butterworth)
+{
+  SignalFilter<2> filter;
+  SignalFilterOptions options;
+  options.type = SignalFilterType::BUTTERWORTH;
+  options.cutoffFrequency = 10.0;
+  ASSERT_TRUE(filter.Configure(options, 1000.0, "sensor"));
+
+  // A constant passes unchanged, from the first sample
+  for (int i = 0; i < 10; ++i)
+  {
+    double dc = 2.0;
+    double zero = 0.0;
+    filter.Apply({&dc, &zero});
+    EXPECT_NEAR(2.0, dc, 1e-9);
+    EXPECT_NEAR(0.0, zero, 1e-9);
+  }
+
+  // A tone well above the cutoff is attenuated, one at the cutoff is
+  // around -3 dB
+  auto amplitude = [&](double _frequency)
+  {
+    filter.Reset();
+    double peak = 0.0;
+    for (int i = 0; i < 4000; ++i)
+    {
+      double value = std::sin(2.0 * GZ_PI * _frequency * i / 1000.0);
+      double other = 0.0;
+      filter.Apply({&value, &other});
+      if (i > 2000)
+        peak = std::max(peak, std::fabs(value));
+    }
+    return peak;
+  };
+  EXPECT_LT(amplitude(200.0), 0.01);
+  EXPECT_NEAR(amplitude(10.0), std::sqrt(0.5), 0.01);
+  EXPECT_GT(amplitude(1.0), 0.99);
+}
+
+/////////////////////////////////////////////////
+TEST(SignalFilter, Decimation)
+{
+  SignalFilter<1> filter;
+  SignalFilterOptions options;
+  options.type = SignalFilterType::MOVING_AVERAGE;
+  options.window = 2u;
+  options.decimation = 3u;
+  ASSERT_TRUE(filter.Configure(options, 0.0, "sensor"));
+
+  int outputs = 0;
+  for (int i = 0; i < 9; ++i)
+  {
+    double value = i;
+    const bool output = filter.Apply({&value});
+    EXPECT_EQ(i % 3 == 0, output) << i;
+    if (output)
+    {
+      ++outputs;
+      EXPECT_DOUBLE_EQ(i == 0 ? 0.0 : i - 0.5, value);
+    }
+  }
+  EXPECT_EQ(3, outputs);
+}
+
+/////////////////////////////////////////////////
+TEST(SignalFilter, State)
+{
+  SignalFilterOptions options;
+  options.type = SignalFilterType::BUTTERWORTH;
+  options.cutoffFrequency = 5.0;
+  options.decimation = 2u;
+  SignalFilter<1> filter;
+  ASSERT_TRUE(filter.Configure(options, 100.0, "sensor"));
+  for (int i = 0; i < 5; ++i)
+  {
+    double value = i;
+    filter.Apply({&value});
+  }
+
+  SensorState state;
+  filter.SaveState(state);
+
+  SignalFilter<1> restored;
+  ASSERT_TRUE(restored.Configure(options, 100.0, "sensor"));
+  ASSERT_TRUE(restored.RestoreState(state));
+  for (int i = 5; i < 10; ++i)
+  {
+    double a = i;
+    double b = i;
+    EXPECT_EQ(filter.Apply({&a}), restored.Apply({&b}));
+    EXPECT_DOUBLE_EQ(a, b);
+  }
+}
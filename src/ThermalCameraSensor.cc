@@ -18,12 +18,23 @@
 #include <gz/msgs/image.pb.h>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <map>
 #include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <gz/common/Console.hh>
 #include <gz/common/Image.hh>
 #include <gz/common/Profiler.hh>
 #include <gz/common/SystemPaths.hh>
+#include <gz/common/Util.hh>
 
 #include <gz/math/Angle.hh>
 #include <gz/math/Helpers.hh>
@@ -33,9 +44,15 @@
 
 #include "gz/sensors/ThermalCameraSensor.hh"
 #include "gz/sensors/ImageGaussianNoiseModel.hh"
+#include "gz/sensors/ImageNoise.hh"
+#include "gz/sensors/ImageWriter.hh"
 #include "gz/sensors/RenderingEvents.hh"
 #include "gz/sensors/SensorFactory.hh"
 
+#include "AlignedBuffer.hh"
+#include "MemorySize.hh"
+#include "ThermalConversion.hh"
+
 /// \brief Private data for ThermalCameraSensor
 class gz::sensors::ThermalCameraSensorPrivate
 {
@@ -69,23 +86,30 @@ class gz::sensors::ThermalCameraSensorPrivate
   public: gz::rendering::ThermalCameraPtr thermalCamera;
 
   /// \brief Thermal data buffer.
-  public: uint16_t *thermalBuffer = nullptr;
+  public: AlignedBuffer<uint16_t> thermalBuffer;
+
+  /// \brief Latest thermal frame, either thermalBuffer or, when frames are
+  /// used in place, the thermal camera's buffer.
+  public: const uint16_t *thermalFrame{nullptr};
 
   /// \brief Thermal data buffer 8 bit.
-  public: unsigned char *thermalBuffer8Bit = nullptr;
+  public: AlignedBuffer<unsigned char> thermalBuffer8Bit;
 
-  /// \brief Thermal data buffer used when saving image.
-  public: unsigned char *imgThermalBuffer = nullptr;
+  /// \brief Cropped and decimated image, unused for full frames.
+  public: std::vector<unsigned char> regionBuffer;
 
   /// \brief Thermal data buffer used when saving image.
-  public: math::Vector2i imgThermalBufferSize =
-      math::Vector2i::Zero;
+  public: AlignedBuffer<unsigned char> imgThermalBuffer;
 
   /// \brief Pointer to an image to be published
   public: gz::rendering::Image image;
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief The image noise if it's applied to the frames on the CPU, in
+  /// which case frames are always copied to thermalBuffer.
+  public: std::shared_ptr<ImageGaussianNoiseModel> cpuNoise;
 
   /// \brief Event that is used to trigger callbacks when a new image
   /// is generated
@@ -122,6 +146,22 @@ class gz::sensors::ThermalCameraSensorPrivate
   /// \brief publisher to publish thermal image
   public: transport::Node::Publisher thermalPub;
 
+  /// \brief Colormap of the false color images.
+  public: ThermalColormap colormap{ThermalColormap::IRONBOW};
+
+  /// \brief Topic of the false color images.
+  public: std::string colormapTopic;
+
+  /// \brief Publisher of the false color images.
+  public: transport::Node::Publisher colormapPub;
+
+  /// \brief False color image message.
+  public: msgs::Image colormapMsg;
+
+  /// \brief Cropped and decimated thermal samples of the false color
+  /// images, unused for full frames.
+  public: std::vector<unsigned char> colormapRegionBuffer;
+
   /// \brief Ambient temperature of the environment
   public: float ambient = 0.0;
 
@@ -136,6 +176,46 @@ class gz::sensors::ThermalCameraSensorPrivate
 
   /// \brief Linear resolution. Defaults to 10mK
   public: float resolution = 0.01f;
+
+  /// \brief Write the entity temperatures that changed to their visuals.
+  /// \param[in] _scene Scene of the visuals.
+  /// \return True if a visual's temperature changed.
+  public: bool ApplyEntityTemperatures(const rendering::ScenePtr &_scene);
+
+  /// \brief Mark a changed entity temperature as pending.
+  /// \param[in,out] _pending Pending flag of the entity temperature.
+  public: void MarkPending(bool &_pending);
+
+  /// \brief Temperature of an entity, written to its visual's user data.
+  public: struct EntityTemperature
+  {
+    /// \brief Uniform temperature in kelvin, unless it has a heat
+    /// signature.
+    float temperature{0.0f};
+
+    /// \brief Resolved heat signature texture, empty for uniform
+    /// temperatures.
+    std::string heatSignature;
+
+    /// \brief Temperature of the black heat signature pixels.
+    float minTemp{0.0f};
+
+    /// \brief Temperature of the white heat signature pixels.
+    float maxTemp{0.0f};
+
+    /// \brief True if it isn't written to the visual yet.
+    bool pending{false};
+  };
+
+  /// \brief Entity temperatures, by visual name.
+  public: std::map<std::string, EntityTemperature> entityTemperatures;
+
+  /// \brief Number of entity temperatures pending.
+  public: std::size_t pendingEntities{0u};
+
+  /// \brief Resolved heat signature textures, by texture given to
+  /// SetEntityHeatSignature.
+  public: std::map<std::string, std::string> heatSignatures;
 };
 
 using namespace gz;
@@ -151,14 +231,6 @@ ThermalCameraSensor::ThermalCameraSensor()
 ThermalCameraSensor::~ThermalCameraSensor()
 {
   this->dataPtr->thermalConnection.reset();
-  if (this->dataPtr->thermalBuffer)
-    delete [] this->dataPtr->thermalBuffer;
-
-  if (this->dataPtr->thermalBuffer8Bit)
-    delete[] this->dataPtr->thermalBuffer8Bit;
-
-  if (this->dataPtr->imgThermalBuffer)
-    delete[] this->dataPtr->imgThermalBuffer;
 }
 
 //////////////////////////////////////////////////
@@ -202,11 +274,8 @@ bool ThermalCameraSensor::Load(const sdf::Sensor &_sdf)
   this->dataPtr->sdfSensor = _sdf;
 
   // Create the thermal image publisher
-  this->dataPtr->thermalPub =
-      this->dataPtr->node.Advertise<msgs::Image>(
-          this->Topic());
-
-  if (!this->dataPtr->thermalPub)
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+      this->dataPtr->thermalPub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() << "].\n";
@@ -216,6 +285,16 @@ bool ThermalCameraSensor::Load(const sdf::Sensor &_sdf)
   gzdbg << "Thermal images for [" << this->Name() << "] advertised on ["
          << this->Topic() << "]" << std::endl;
 
+  // Create the false color image publisher
+  this->dataPtr->colormapTopic = this->Topic() + "/colormap";
+  if (!this->Advertise<msgs::Image>(this->dataPtr->node,
+      this->dataPtr->colormapPub, this->dataPtr->colormapTopic))
+  {
+    gzerr << "Unable to create publisher on topic["
+      << this->dataPtr->colormapTopic << "].\n";
+    return false;
+  }
+
   if (!this->AdvertiseInfo())
     return false;
 
@@ -303,12 +382,22 @@ bool ThermalCameraSensor::CreateCamera()
     // Add gaussian noise to camera sensor
     if (noiseSdf.Type() == sdf::NoiseType::GAUSSIAN)
     {
+      // NoiseFactory refuses image noise types. The image noise model adds
+      // a Gaussian noise pass to the thermal camera, which only takes
+      // effect if the engine's thermal camera runs its render passes. If
+      // the engine has no such pass, the noise is applied on the CPU to the
+      // copied frames instead.
       this->dataPtr->noises[noiseType] =
-        NoiseFactory::NewNoiseModel(noiseSdf, "camera");
+        ImageNoiseFactory::NewNoiseModel(noiseSdf, "thermal_camera");
 
-      std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
-           this->dataPtr->noises[noiseType])->SetCamera(
-             this->dataPtr->thermalCamera);
+      auto imageNoise = std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
+          this->dataPtr->noises[noiseType]);
+      if (imageNoise)
+      {
+        imageNoise->SetCamera(this->dataPtr->thermalCamera);
+        this->dataPtr->cpuNoise =
+            imageNoise->AppliesOnCpu() ? imageNoise : nullptr;
+      }
     }
     else if (noiseSdf.Type() != sdf::NoiseType::NONE)
     {
@@ -343,6 +432,18 @@ bool ThermalCameraSensor::CreateCamera()
     this->dataPtr->saveImage = true;
   }
 
+  // Allocate the buffers before the first frame arrives
+  const std::size_t samples = static_cast<std::size_t>(width) * height;
+  this->dataPtr->thermalBuffer.SetMemory(this->BufferMemory());
+  this->dataPtr->thermalBuffer8Bit.SetMemory(this->BufferMemory());
+  this->dataPtr->imgThermalBuffer.SetMemory(this->BufferMemory());
+  this->dataPtr->thermalBuffer.Reserve(samples);
+  this->dataPtr->thermalFrame = nullptr;
+  if (pixelFormat == sdf::PixelFormatType::L_INT8)
+    this->dataPtr->thermalBuffer8Bit.Reserve(samples);
+  if (this->dataPtr->saveImage)
+    this->dataPtr->imgThermalBuffer.Reserve(samples * 3u);
+
   this->dataPtr->thermalConnection =
       this->dataPtr->thermalCamera->ConnectNewThermalFrame(
       std::bind(&ThermalCameraSensor::OnNewThermalFrame, this,
@@ -363,10 +464,22 @@ void ThermalCameraSensor::OnNewThermalFrame(const uint16_t *_scan,
   unsigned int samples = _width * _height;
   unsigned int thermalBufferSize = samples * sizeof(uint16_t);
 
-  if (!this->dataPtr->thermalBuffer)
-    this->dataPtr->thermalBuffer = new uint16_t[samples];
-
-  memcpy(this->dataPtr->thermalBuffer, _scan, thermalBufferSize);
+  if (this->ZeroCopyFrames() && !this->dataPtr->cpuNoise)
+  {
+    this->dataPtr->thermalFrame = _scan;
+  }
+  else
+  {
+    this->dataPtr->thermalBuffer.Resize(samples);
+    memcpy(this->dataPtr->thermalBuffer.Data(), _scan, thermalBufferSize);
+    if (this->dataPtr->cpuNoise)
+    {
+      this->dataPtr->cpuNoise->SetThreadCount(this->ImageNoiseThreadCount());
+      this->dataPtr->cpuNoise->ApplyToImage(
+          this->dataPtr->thermalBuffer.Data(), samples);
+    }
+    this->dataPtr->thermalFrame = this->dataPtr->thermalBuffer.Data();
+  }
 }
 
 /////////////////////////////////////////////////
@@ -393,6 +506,10 @@ void ThermalCameraSensor::SetScene(rendering::ScenePtr _scene)
     this->dataPtr->thermalCamera = nullptr;
     RenderingSensor::SetScene(_scene);
 
+    // The visuals of the new scene don't have the temperatures yet
+    for (auto &entry : this->dataPtr->entityTemperatures)
+      this->dataPtr->MarkPending(entry.second.pending);
+
     if (this->dataPtr->initialized)
       this->CreateCamera();
   }
@@ -415,21 +532,33 @@ bool ThermalCameraSensor::Update(
     return false;
   }
 
-  if (this->HasInfoConnections())
-  {
-    // publish the camera info message
-    this->PublishInfo(_now);
-  }
+  // publish the camera info message, if it has subscribers
+  this->PublishInfo(_now);
+
+  // A frame showing the old temperatures can't be reused
+  if (this->dataPtr->ApplyEntityTemperatures(this->Scene()))
+    this->InvalidateFrame();
 
   // don't render if there are no subscribers
   if (!this->dataPtr->thermalPub.HasConnections() &&
-      this->dataPtr->imageEvent.ConnectionCount() == 0u)
+      !this->dataPtr->colormapPub.HasConnections() &&
+      this->dataPtr->imageEvent.ConnectionCount() == 0u &&
+      !this->HasSharedMemoryConnections() &&
+      !this->Recording())
     return false;
 
-  // generate sensor data - this triggers image callback
-  this->Render();
+  // generate sensor data - this triggers image callback. The last frame
+  // is published again if nothing changed, unless noise is rendered into
+  // it.
+  std::chrono::steady_clock::duration frameTime{_now};
+  if ((this->dataPtr->noises[CAMERA_NOISE] || !this->ReuseFrame()) &&
+      !this->Render(_now, frameTime))
+  {
+    // The first frame in async readback mode isn't complete yet
+    return true;
+  }
 
-  if (!this->dataPtr->thermalBuffer)
+  if (!this->dataPtr->thermalFrame)
     return false;
 
   unsigned int width = this->dataPtr->thermalCamera->ImageWidth();
@@ -448,44 +577,88 @@ bool ThermalCameraSensor::Update(
   }
 
   // create message
-  this->dataPtr->thermalMsg.set_width(width);
-  this->dataPtr->thermalMsg.set_height(height);
-  this->dataPtr->thermalMsg.set_step(
-      width * rendering::PixelUtil::BytesPerPixel(renderingFormat));
   this->dataPtr->thermalMsg.set_pixel_format_type(msgsFormat);
   auto stamp = this->dataPtr->thermalMsg.mutable_header()->mutable_stamp();
-  *stamp = msgs::Convert(_now);
+  *stamp = msgs::Convert(frameTime);
   auto frame = this->dataPtr->thermalMsg.mutable_header()->add_data();
   frame->set_key("frame_id");
   frame->add_value(this->FrameId());
 
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
+  const void *pixels = this->dataPtr->thermalFrame;
+
   // \todo(anyone) once gz-rendering supports an image event with unsigned char
   // data type, we can remove this check that copies uint16_t data to char array
   if (this->dataPtr->thermalCamera->ImageFormat() == rendering::PF_L8)
   {
-    unsigned int len = width * height;
-    if (!this->dataPtr->thermalBuffer8Bit)
-      this->dataPtr->thermalBuffer8Bit = new unsigned char[len];
-    for (unsigned int i = 0; i < len; ++i)
-    {
-      this->dataPtr->thermalBuffer8Bit[i] =
-          static_cast<uint8_t>(this->dataPtr->thermalBuffer[i]);
-    }
-    this->dataPtr->thermalMsg.set_data(this->dataPtr->thermalBuffer8Bit,
-        rendering::PixelUtil::MemorySize(renderingFormat,
-        width, height));
-  }
-  else
-  {
-    this->dataPtr->thermalMsg.set_data(this->dataPtr->thermalBuffer,
-        rendering::PixelUtil::MemorySize(renderingFormat,
-        width, height));
+    const std::size_t len = static_cast<std::size_t>(width) * height;
+    this->dataPtr->thermalBuffer8Bit.Resize(len);
+    NarrowThermal(this->dataPtr->thermalBuffer8Bit.Data(),
+        this->dataPtr->thermalFrame, len);
+    pixels = this->dataPtr->thermalBuffer8Bit.Data();
   }
 
+  unsigned int thermalWidth = width;
+  unsigned int thermalHeight = height;
+  pixels = this->ApplyRegionOfInterest(
+      static_cast<const unsigned char *>(pixels), thermalWidth,
+      thermalHeight, rendering::PixelUtil::BytesPerPixel(renderingFormat),
+      this->dataPtr->regionBuffer);
+  const std::size_t size = rendering::PixelUtil::MemorySize(
+      renderingFormat, thermalWidth, thermalHeight);
+  this->dataPtr->thermalMsg.set_width(thermalWidth);
+  this->dataPtr->thermalMsg.set_height(thermalHeight);
+  this->dataPtr->thermalMsg.set_step(thermalWidth *
+      rendering::PixelUtil::BytesPerPixel(renderingFormat));
+
+  // Pixels only go through protobuf if someone receives the message
+  const bool publishThermal = this->dataPtr->thermalPub.HasConnections() ||
+      this->dataPtr->imageEvent.ConnectionCount() > 0u ||
+      !this->SharedMemoryOutput();
+  if (publishThermal)
+    this->dataPtr->thermalMsg.set_data(pixels, size);
+
+  this->WriteSharedMemoryImage(this->Topic(), this->dataPtr->thermalMsg,
+      pixels, size);
+  this->RecordFrame(0u, this->dataPtr->thermalMsg, pixels, size);
+
+  if (publishThermal)
+    this->Publish(this->dataPtr->thermalPub, this->dataPtr->thermalMsg);
 
-  this->dataPtr->thermalPub.Publish(this->dataPtr->thermalMsg);
+  // False color images are only generated for their subscribers
+  if (this->dataPtr->colormapPub.HasConnections())
+  {
+    GZ_PROFILE("ThermalCameraSensor::Update Colormap");
+    unsigned int colormapWidth = width;
+    unsigned int colormapHeight = height;
+    const uint16_t *samples = reinterpret_cast<const uint16_t *>(
+        this->ApplyRegionOfInterest(
+        reinterpret_cast<const unsigned char *>(this->dataPtr->thermalFrame),
+        colormapWidth, colormapHeight, sizeof(uint16_t),
+        this->dataPtr->colormapRegionBuffer));
+    const std::size_t count =
+        static_cast<std::size_t>(colormapWidth) * colormapHeight;
+    if (count > 0u)
+    {
+      this->FillHeader(this->dataPtr->colormapMsg.mutable_header(),
+          frameTime, this->FrameId(), "colormap");
+      this->dataPtr->colormapMsg.set_width(colormapWidth);
+      this->dataPtr->colormapMsg.set_height(colormapHeight);
+      this->dataPtr->colormapMsg.set_step(colormapWidth * 3u);
+      this->dataPtr->colormapMsg.set_pixel_format_type(
+          msgs::PixelFormatType::RGB_INT8);
+
+      // Each frame is scaled between its coldest and hottest pixels
+      const auto [min, max] = MinMaxThermal(samples, count);  // NOLINT
+      std::string *data = this->dataPtr->colormapMsg.mutable_data();
+      data->resize(count * 3u);
+      ThermalToRgb(reinterpret_cast<unsigned char *>(data->data()), samples,
+          count, min, std::max(1u, static_cast<unsigned int>(max - min)),
+          ColormapColors(this->dataPtr->colormap));
+      this->Publish(this->dataPtr->colormapPub, this->dataPtr->colormapMsg);
+    }
+  }
 
   // Trigger callbacks.
   try
@@ -500,8 +673,8 @@ bool ThermalCameraSensor::Update(
   // Save image
   if (this->dataPtr->saveImage)
   {
-    this->dataPtr->SaveImage(this->dataPtr->thermalBuffer, width, height,
-        commonFormat);
+    this->dataPtr->SaveImage(this->dataPtr->thermalFrame, width,
+        height, commonFormat);
   }
 
   return true;
@@ -575,35 +748,128 @@ void ThermalCameraSensor::SetLinearResolution(float _resolution)
   }
 }
 
+//////////////////////////////////////////////////
+void ThermalCameraSensor::SetEntityTemperature(const std::string &_visual,
+    float _temperature)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto [it, added] = this->dataPtr->entityTemperatures.try_emplace(_visual);
+  auto &entity = it->second;
+  if (!added && entity.heatSignature.empty() &&
+      gz::math::equal(entity.temperature, _temperature, 0.0f))
+  {
+    return;
+  }
+  entity.temperature = _temperature;
+  entity.heatSignature.clear();
+  this->dataPtr->MarkPending(entity.pending);
+}
+
+//////////////////////////////////////////////////
+void ThermalCameraSensor::SetEntityHeatSignature(const std::string &_visual,
+    const std::string &_texture, float _min, float _max)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  auto signature = this->dataPtr->heatSignatures.find(_texture);
+  if (signature == this->dataPtr->heatSignatures.end())
+  {
+    std::string path = common::findFile(_texture);
+    if (path.empty())
+    {
+      gzwarn << "Unable to find heat signature [" << _texture << "] of ["
+             << _visual << "], using it as is.\n";
+      path = _texture;
+    }
+    signature = this->dataPtr->heatSignatures.emplace(_texture, path).first;
+  }
+
+  auto [it, added] = this->dataPtr->entityTemperatures.try_emplace(_visual);
+  auto &entity = it->second;
+  if (!added && entity.heatSignature == signature->second &&
+      gz::math::equal(entity.minTemp, _min, 0.0f) &&
+      gz::math::equal(entity.maxTemp, _max, 0.0f))
+  {
+    return;
+  }
+  entity.heatSignature = signature->second;
+  entity.minTemp = _min;
+  entity.maxTemp = _max;
+  this->dataPtr->MarkPending(entity.pending);
+}
+
+//////////////////////////////////////////////////
+std::size_t ThermalCameraSensor::PendingEntityTemperatureCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->pendingEntities;
+}
+
+//////////////////////////////////////////////////
+void ThermalCameraSensorPrivate::MarkPending(bool &_pending)
+{
+  if (!_pending)
+  {
+    _pending = true;
+    ++this->pendingEntities;
+  }
+}
+
+//////////////////////////////////////////////////
+bool ThermalCameraSensorPrivate::ApplyEntityTemperatures(
+    const rendering::ScenePtr &_scene)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (this->pendingEntities == 0u || !_scene)
+    return false;
+
+  GZ_PROFILE("ThermalCameraSensor::ApplyEntityTemperatures");
+  bool changed = false;
+  for (auto &[name, entity] : this->entityTemperatures)
+  {
+    if (!entity.pending)
+      continue;
+
+    // Visuals not in the scene yet stay pending
+    rendering::VisualPtr visual = _scene->VisualByName(name);
+    if (!visual)
+      continue;
+
+    if (entity.heatSignature.empty())
+    {
+      visual->SetUserData("temperature", entity.temperature);
+    }
+    else
+    {
+      visual->SetUserData("temperature", entity.heatSignature);
+      visual->SetUserData("minTemp", entity.minTemp);
+      visual->SetUserData("maxTemp", entity.maxTemp);
+    }
+    entity.pending = false;
+    --this->pendingEntities;
+    changed = true;
+  }
+  return changed;
+}
+
 //////////////////////////////////////////////////
 bool ThermalCameraSensorPrivate::ConvertTemperatureToImage(
     const uint16_t *_data,
     unsigned char *_imageBuffer,
     unsigned int _width, unsigned int _height)
 {
+  const std::size_t count = static_cast<std::size_t>(_width) * _height;
+  if (count == 0u)
+    return false;
+
   // get min and max of temperature values
-  const auto [min, max] = // NOLINT
-      std::minmax_element(&_data[0], &_data[_height * _width]);
+  const auto [min, max] = MinMaxThermal(_data, count);  // NOLINT
 
   // convert temperature to grayscale image
-  double range = static_cast<double>(max - min);
-  if (math::equal(range, 0.0))
-    range = 1.0;
-  for (unsigned int i = 0; i < _height; ++i)
-  {
-    for (unsigned int j = 0; j < _width; ++j)
-    {
-      uint16_t temp = _data[i*_width + j];
-      double t = static_cast<double>(temp-*min) / range;
-      int r = static_cast<int>(255*t);
-      int g = r;
-      int b = r;
-      int index = i*_width*3 + j*3;
-      _imageBuffer[index] = r;
-      _imageBuffer[index+1] = g;
-      _imageBuffer[index+2] = b;
-    }
-  }
+  unsigned int range = max - min;
+  if (range == 0u)
+    range = 1u;
+  ThermalToRgb(_imageBuffer, _data, count, min, range,
+      ColormapColors(ThermalColormap::GRAYSCALE));
 
   return true;
 }
@@ -623,30 +889,35 @@ bool ThermalCameraSensorPrivate::SaveImage(const uint16_t *_data,
   if (_width == 0 || _height == 0)
     return false;
 
-  common::Image localImage;
-
-  if (static_cast<int>(_width) != this->imgThermalBufferSize.X() ||
-      static_cast<int>(_height) != this->imgThermalBufferSize.Y())
-  {
-    delete [] this->imgThermalBuffer;
-    unsigned int bufferSize = _width * _height * 3;
-    this->imgThermalBuffer = new unsigned char[bufferSize];
-    this->imgThermalBufferSize = math::Vector2i(_width, _height);
-  }
-
-  this->ConvertTemperatureToImage(_data, this->imgThermalBuffer,
+  this->imgThermalBuffer.Resize(
+      static_cast<std::size_t>(_width) * _height * 3u);
+  this->ConvertTemperatureToImage(_data, this->imgThermalBuffer.Data(),
       _width, _height);
 
   std::string filename = this->saveImagePrefix +
                          std::to_string(this->saveImageCounter) + ".png";
   ++this->saveImageCounter;
 
-  localImage.SetFromData(this->imgThermalBuffer, _width, _height,
-      common::Image::RGB_INT8);
-  localImage.SavePNG(
-      common::joinPaths(this->saveImagePath, filename));
+  // Encoding and writing the file happen on the image writer's threads
+  return ImageWriter::Instance().Write(
+      common::joinPaths(this->saveImagePath, filename),
+      this->imgThermalBuffer.Data(), this->imgThermalBuffer.Size(),
+      _width, _height, common::Image::RGB_INT8);
+}
 
-  return true;
+//////////////////////////////////////////////////
+SensorMemoryUsage ThermalCameraSensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage = CameraSensor::MemoryUsage();
+  usage["thermal_buffer"] = MemorySize(this->dataPtr->thermalBuffer) +
+      MemorySize(this->dataPtr->thermalBuffer8Bit) +
+      MemorySize(this->dataPtr->imgThermalBuffer);
+  usage["region_buffer"] += MemorySize(this->dataPtr->regionBuffer) +
+      MemorySize(this->dataPtr->colormapRegionBuffer);
+  usage["image"] += this->dataPtr->image.MemorySize();
+  usage["image_msg"] += MemorySize(this->dataPtr->thermalMsg) +
+      MemorySize(this->dataPtr->colormapMsg);
+  return usage;
 }
 
 //////////////////////////////////////////////////
@@ -654,6 +925,30 @@ bool ThermalCameraSensor::HasConnections() const
 {
   return (this->dataPtr->thermalPub &&
       this->dataPtr->thermalPub.HasConnections()) ||
+      (this->dataPtr->colormapPub &&
+      this->dataPtr->colormapPub.HasConnections()) ||
       this->dataPtr->imageEvent.ConnectionCount() > 0u ||
+      this->HasSharedMemoryConnections() ||
+      this->Recording() ||
       this->HasInfoConnections();
 }
+
+//////////////////////////////////////////////////
+void ThermalCameraSensor::SetColormap(ThermalColormap _colormap)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->colormap = _colormap;
+}
+
+//////////////////////////////////////////////////
+ThermalColormap ThermalCameraSensor::Colormap() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->colormap;
+}
+
+//////////////////////////////////////////////////
+std::string ThermalCameraSensor::ColormapTopic() const
+{
+  return this->dataPtr->colormapTopic;
+}
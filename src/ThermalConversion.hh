@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_THERMALCONVERSION_HH_
+#define GZ_SENSORS_THERMALCONVERSION_HH_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/ThermalCameraSensor.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Narrow 8 bit thermal samples, which the thermal camera delivers
+    /// in 16 bit words, to bytes. Like a static_cast, only the low byte of each
+    /// sample is kept. SSE2 handles 16 samples per iteration.
+    /// \param[out] _dst Narrowed samples, _count bytes.
+    /// \param[in] _src Thermal samples.
+    /// \param[in] _count Number of samples.
+    inline void NarrowThermal(unsigned char *_dst, const uint16_t *_src,
+        std::size_t _count)
+    {
+      std::size_t i = 0u;
+#if defined(__SSE2__)
+      const __m128i lowByte = _mm_set1_epi16(0x00FF);
+      for (; i + 16u <= _count; i += 16u)
+      {
+        const __m128i a = _mm_and_si128(lowByte, _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(_src + i)));
+        const __m128i b = _mm_and_si128(lowByte, _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(_src + i + 8u)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(_dst + i),
+            _mm_packus_epi16(a, b));
+      }
+#endif
+      for (; i < _count; ++i)
+        _dst[i] = static_cast<unsigned char>(_src[i]);
+    }
+
+    /// \brief Get the smallest and largest thermal samples. SSE2 handles 8
+    /// samples per iteration.
+    /// \param[in] _src Thermal samples.
+    /// \param[in] _count Number of samples, at least one.
+    /// \return Smallest and largest sample.
+    inline std::pair<uint16_t, uint16_t> MinMaxThermal(const uint16_t *_src,
+        std::size_t _count)
+    {
+      uint16_t min = std::numeric_limits<uint16_t>::max();
+      uint16_t max = 0u;
+      std::size_t i = 0u;
+#if defined(__SSE2__)
+      if (_count >= 8u)
+      {
+        // SSE2 only compares signed words, flipping the sign bit keeps the
+        // order
+        const __m128i bias = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+        __m128i minV = _mm_set1_epi16(0x7FFF);
+        __m128i maxV = bias;
+        for (; i + 8u <= _count; i += 8u)
+        {
+          const __m128i v = _mm_xor_si128(bias, _mm_loadu_si128(
+              reinterpret_cast<const __m128i *>(_src + i)));
+          minV = _mm_min_epi16(minV, v);
+          maxV = _mm_max_epi16(maxV, v);
+        }
+        alignas(16) uint16_t mins[8];
+        alignas(16) uint16_t maxs[8];
+        _mm_store_si128(reinterpret_cast<__m128i *>(mins),
+            _mm_xor_si128(bias, minV));
+        _mm_store_si128(reinterpret_cast<__m128i *>(maxs),
+            _mm_xor_si128(bias, maxV));
+        min = *std::min_element(mins, mins + 8);
+        max = *std::max_element(maxs, maxs + 8);
+      }
+#endif
+      for (; i < _count; ++i)
+      {
+        min = std::min(min, _src[i]);
+        max = std::max(max, _src[i]);
+      }
+      return {min, max};
+    }
+
+    /// \brief Colors of a colormap, indexed by level.
+    using ColormapLut = std::array<std::array<unsigned char, 3>, 256>;
+
+    /// \brief Build the 256 colors of a colormap by linearly interpolating
+    /// between its control colors.
+    /// \param[in] _colormap Colormap.
+    /// \return Colors from the lowest to the highest level.
+    inline ColormapLut MakeColormapLut(ThermalColormap _colormap)
+    {
+      // Position in [0, 1] and color of each control point
+      using Stop = std::array<float, 4>;
+      std::vector<Stop> stops;
+      switch (_colormap)
+      {
+        case ThermalColormap::IRONBOW:
+          stops = {{0.0f, 0.0f, 0.0f, 0.0f}, {0.2f, 64.0f, 0.0f, 140.0f},
+                   {0.4f, 180.0f, 20.0f, 120.0f}, {0.6f, 240.0f, 90.0f, 20.0f},
+                   {0.8f, 255.0f, 190.0f, 0.0f},
+                   {1.0f, 255.0f, 255.0f, 255.0f}};
+          break;
+        case ThermalColormap::RAINBOW:
+          stops = {{0.0f, 0.0f, 0.0f, 255.0f}, {0.25f, 0.0f, 255.0f, 255.0f},
+                   {0.5f, 0.0f, 255.0f, 0.0f}, {0.75f, 255.0f, 255.0f, 0.0f},
+                   {1.0f, 255.0f, 0.0f, 0.0f}};
+          break;
+        case ThermalColormap::GRAYSCALE:
+        default:
+          stops = {{0.0f, 0.0f, 0.0f, 0.0f}, {1.0f, 255.0f, 255.0f, 255.0f}};
+          break;
+      }
+
+      ColormapLut lut;
+      std::size_t stop = 1u;
+      for (std::size_t level = 0u; level < lut.size(); ++level)
+      {
+        const float t = static_cast<float>(level) / 255.0f;
+        while (stop + 1u < stops.size() && t > stops[stop][0])
+          ++stop;
+        const Stop &a = stops[stop - 1u];
+        const Stop &b = stops[stop];
+        const float s = (t - a[0]) / (b[0] - a[0]);
+        for (std::size_t c = 0u; c < 3u; ++c)
+        {
+          lut[level][c] = static_cast<unsigned char>(
+              std::lround(a[c + 1u] + s * (b[c + 1u] - a[c + 1u])));
+        }
+      }
+      return lut;
+    }
+
+    /// \brief Get the colors of a colormap, built on first use.
+    /// \param[in] _colormap Colormap.
+    /// \return Colors from the lowest to the highest level.
+    inline const ColormapLut &ColormapColors(ThermalColormap _colormap)
+    {
+      static const ColormapLut grayscale =
+          MakeColormapLut(ThermalColormap::GRAYSCALE);
+      static const ColormapLut ironbow =
+          MakeColormapLut(ThermalColormap::IRONBOW);
+      static const ColormapLut rainbow =
+          MakeColormapLut(ThermalColormap::RAINBOW);
+      switch (_colormap)
+      {
+        case ThermalColormap::IRONBOW:
+          return ironbow;
+        case ThermalColormap::RAINBOW:
+          return rainbow;
+        case ThermalColormap::GRAYSCALE:
+        default:
+          return grayscale;
+      }
+    }
+
+    /// \brief Map thermal samples to RGB pixels through a colormap, at level
+    /// 255 * (sample - _min) / _range rounded down. SSE2 computes 16 levels
+    /// per iteration. It divides in float, which is exact here:
+    /// 255 * 65535 is below 2^24, so no quotient lands within half an
+    /// ulp of an integer it isn't equal to.
+    /// \param[out] _dst RGB pixels, 3 * _count bytes.
+    /// \param[in] _src Thermal samples, none below _min or above _min + _range.
+    /// \param[in] _count Number of samples.
+    /// \param[in] _min Sample mapped to the lowest level.
+    /// \param[in] _range Sample range mapped to the highest level, at least
+    /// one.
+    /// \param[in] _lut Colors of the levels.
+    inline void ThermalToRgb(unsigned char *_dst, const uint16_t *_src,
+        std::size_t _count, uint16_t _min, unsigned int _range,
+        const ColormapLut &_lut)
+    {
+      std::size_t i = 0u;
+#if defined(__SSE2__)
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i minV = _mm_set1_epi32(_min);
+      const __m128 white = _mm_set1_ps(255.0f);
+      const __m128 rangeV = _mm_set1_ps(static_cast<float>(_range));
+      alignas(16) unsigned char levels[16];
+      for (; i + 16u <= _count; i += 16u)
+      {
+        const __m128i samples[2] = {
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(_src + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(_src + i + 8u))};
+        __m128i words[4];
+        for (int k = 0; k < 4; ++k)
+        {
+          const __m128i v = (k & 1) ?
+              _mm_unpackhi_epi16(samples[k / 2], zero) :
+              _mm_unpacklo_epi16(samples[k / 2], zero);
+          words[k] = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(
+              _mm_cvtepi32_ps(_mm_sub_epi32(v, minV)), white), rangeV));
+        }
+        _mm_store_si128(reinterpret_cast<__m128i *>(levels), _mm_packus_epi16(
+            _mm_packs_epi32(words[0], words[1]),
+            _mm_packs_epi32(words[2], words[3])));
+        unsigned char *dst = _dst + i * 3u;
+        for (int k = 0; k < 16; ++k)
+          std::memcpy(dst + k * 3, _lut[levels[k]].data(), 3u);
+      }
+#endif
+      for (; i < _count; ++i)
+      {
+        const unsigned int level =
+            255u * static_cast<unsigned int>(_src[i] - _min) / _range;
+        std::memcpy(_dst + i * 3u, _lut[level].data(), 3u);
+      }
+    }
+    }
+  }
+}
+
+#endif
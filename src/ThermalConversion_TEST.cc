@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "ThermalConversion.hh"
+
+using namespace gz;
+using namespace sensors;
+
+/// \brief Thermal samples of every count up to 40, so the tails after the
+/// groups of 8 and 16 samples are covered, and samples at the sign bit and
+/// the ends of the range.
+static std::vector<std::vector<uint16_t>> Samples()
+{
+  std::mt19937 gen(42u);
+  std::uniform_int_distribution<int> dist(0, 65535);
+  std::vector<std::vector<uint16_t>> samples;
+  for (std::size_t count = 0u; count <= 40u; ++count)
+  {
+    std::vector<uint16_t> s(count);
+    for (auto &v : s)
+      v = static_cast<uint16_t>(dist(gen));
+    samples.push_back(s);
+  }
+
+  // Values around the sign bit, which SSE2 flips to compare
+  samples.push_back({0x7FFFu, 0x8000u, 0x8001u, 0x7FFEu, 0x7FFFu, 0x8000u,
+      0x7FFFu, 0x8000u, 0x8000u});
+  samples.push_back(std::vector<uint16_t>(17u, 0xFFFFu));
+  samples.push_back(std::vector<uint16_t>(17u, 0u));
+  return samples;
+}
+
+//////////////////////////////////////////////////
+TEST(ThermalConversion, NarrowThermal)
+{
+  for (const auto &s : Samples())
+  {
+    std::vector<unsigned char> dst(s.size() + 1u, 0xAAu);
+    NarrowThermal(dst.data(), s.data(), s.size());
+    for (std::size_t i = 0u; i < s.size(); ++i)
+      EXPECT_EQ(static_cast<unsigned char>(s[i]), dst[i]) << i;
+
+    // Nothing is written past the samples
+    EXPECT_EQ(0xAAu, dst.back());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ThermalConversion, MinMaxThermal)
+{
+  for (const auto &s : Samples())
+  {
+    if (s.empty())
+      continue;
+    uint16_t min = s[0];
+    uint16_t max = s[0];
+    for (uint16_t v : s)
+    {
+      min = std::min(min, v);
+      max = std::max(max, v);
+    }
+    const auto minMax = MinMaxThermal(s.data(), s.size());
+    EXPECT_EQ(min, minMax.first) << s.size();
+    EXPECT_EQ(max, minMax.second) << s.size();
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ThermalConversion, ColormapLut)
+{
+  // Grayscale maps each level to itself
+  const ColormapLut &gray = ColormapColors(ThermalColormap::GRAYSCALE);
+  for (std::size_t level = 0u; level < gray.size(); ++level)
+  {
+    for (std::size_t c = 0u; c < 3u; ++c)
+      EXPECT_EQ(level, gray[level][c]);
+  }
+
+  // The end levels are the end control colors
+  const ColormapLut &rainbow = ColormapColors(ThermalColormap::RAINBOW);
+  EXPECT_EQ(0u, rainbow[0][0]);
+  EXPECT_EQ(0u, rainbow[0][1]);
+  EXPECT_EQ(255u, rainbow[0][2]);
+  EXPECT_EQ(255u, rainbow[255][0]);
+  EXPECT_EQ(0u, rainbow[255][1]);
+  EXPECT_EQ(0u, rainbow[255][2]);
+
+  const ColormapLut &ironbow = ColormapColors(ThermalColormap::IRONBOW);
+  EXPECT_EQ(0u, ironbow[0][0]);
+  EXPECT_EQ(255u, ironbow[255][0]);
+  EXPECT_EQ(255u, ironbow[255][1]);
+  EXPECT_EQ(255u, ironbow[255][2]);
+}
+
+//////////////////////////////////////////////////
+TEST(ThermalConversion, ThermalToRgb)
+{
+  const ColormapLut &lut = ColormapColors(ThermalColormap::IRONBOW);
+  for (const auto &s : Samples())
+  {
+    if (s.empty())
+      continue;
+    const auto minMax = MinMaxThermal(s.data(), s.size());
+    const unsigned int range =
+        std::max(1u, static_cast<unsigned int>(minMax.second - minMax.first));
+
+    std::vector<unsigned char> dst(s.size() * 3u + 1u, 0xAAu);
+    ThermalToRgb(dst.data(), s.data(), s.size(), minMax.first, range, lut);
+    for (std::size_t i = 0u; i < s.size(); ++i)
+    {
+      const unsigned int level = 255u *
+          static_cast<unsigned int>(s[i] - minMax.first) / range;
+      for (std::size_t c = 0u; c < 3u; ++c)
+        EXPECT_EQ(lut[level][c], dst[i * 3u + c]) << i;
+    }
+    EXPECT_EQ(0xAAu, dst.back());
+  }
+
+  // Every sample of the full 16 bit range lands on the exact level
+  std::vector<uint16_t> all(65536u);
+  for (std::size_t i = 0u; i < all.size(); ++i)
+    all[i] = static_cast<uint16_t>(i);
+  const ColormapLut &gray = ColormapColors(ThermalColormap::GRAYSCALE);
+  std::vector<unsigned char> dst(all.size() * 3u);
+  ThermalToRgb(dst.data(), all.data(), all.size(), 0u, 65535u, gray);
+  for (std::size_t i = 0u; i < all.size(); ++i)
+  {
+    ASSERT_EQ(255u * i / 65535u, dst[i * 3u]) << i;
+  }
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ThreadAffinity.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+bool sensors::PinCurrentThread(const std::vector<unsigned int> &_cpus)
+{
+  if (_cpus.empty())
+    return false;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const auto cpu : _cpus)
+  {
+    if (cpu >= CPU_SETSIZE)
+      return false;
+    CPU_SET(cpu, &set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+//////////////////////////////////////////////////
+std::vector<unsigned int> sensors::ParseCpuList(const std::string &_list)
+{
+  std::string list;
+  std::copy_if(_list.begin(), _list.end(), std::back_inserter(list),
+      [](char _c) { return !std::isspace(static_cast<unsigned char>(_c)); });
+
+  std::vector<unsigned int> cpus;
+  std::istringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ','))
+  {
+    const auto dash = range.find('-');
+    const std::string first = range.substr(0, dash);
+    const std::string last =
+        dash == std::string::npos ? first : range.substr(dash + 1);
+    auto isNumber = [](const std::string &_s)
+    {
+      return !_s.empty() && _s.size() <= 9 &&
+          std::all_of(_s.begin(), _s.end(),
+              [](char _c) { return _c >= '0' && _c <= '9'; });
+    };
+    if (!isNumber(first) || !isNumber(last))
+      return {};
+
+    const auto begin = static_cast<unsigned int>(std::stoul(first));
+    const auto end = static_cast<unsigned int>(std::stoul(last));
+    if (end < begin)
+      return {};
+    for (unsigned int cpu = begin; cpu <= end; ++cpu)
+      cpus.push_back(cpu);
+  }
+
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+//////////////////////////////////////////////////
+std::vector<unsigned int> sensors::NumaNodeCpus(unsigned int _node)
+{
+#ifdef __linux__
+  std::ifstream file("/sys/devices/system/node/node" +
+      std::to_string(_node) + "/cpulist");
+  std::string list;
+  if (!file || !std::getline(file, list))
+    return {};
+  return ParseCpuList(list);
+#else
+  (void)_node;
+  return {};
+#endif
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_THREADAFFINITY_HH_
+#define GZ_SENSORS_THREADAFFINITY_HH_
+
+#include <string>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Restrict the calling thread to a set of CPUs. Only supported
+    /// on Linux.
+    /// \param[in] _cpus Indices of the CPUs the thread may run on.
+    /// \return True if the affinity was set, false if _cpus is empty, the
+    /// platform isn't supported or the system rejected it.
+    bool PinCurrentThread(const std::vector<unsigned int> &_cpus);
+
+    /// \brief Parse a CPU list in the format used by the Linux sysfs, such
+    /// as "0-3,8,10-11". Whitespace is ignored.
+    /// \param[in] _list CPU list.
+    /// \return Sorted CPU indices, empty if the list is malformed.
+    std::vector<unsigned int> ParseCpuList(const std::string &_list);
+
+    /// \brief Get the CPUs of a NUMA node, read from
+    /// /sys/devices/system/node/node<N>/cpulist. Only supported on Linux.
+    /// \param[in] _node Index of the NUMA node.
+    /// \return CPU indices of the node, empty if the node doesn't exist or
+    /// the platform isn't supported.
+    std::vector<unsigned int> NumaNodeCpus(unsigned int _node);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "ThreadAffinity.hh"
+
+using namespace gz;
+using namespace sensors;
+
+//////////////////////////////////////////////////
+TEST(ThreadAffinity, ParseCpuList)
+{
+  EXPECT_EQ(std::vector<unsigned int>({0u}), ParseCpuList("0"));
+  EXPECT_EQ(std::vector<unsigned int>({0u, 1u, 2u, 3u, 8u, 10u, 11u}),
+      ParseCpuList("0-3,8,10-11\n"));
+  EXPECT_EQ(std::vector<unsigned int>({1u, 2u, 5u}),
+      ParseCpuList(" 5, 1-2 ,2"));
+
+  EXPECT_TRUE(ParseCpuList("").empty());
+  EXPECT_TRUE(ParseCpuList("3-1").empty());
+  EXPECT_TRUE(ParseCpuList("0,,1").empty());
+  EXPECT_TRUE(ParseCpuList("a-b").empty());
+  EXPECT_TRUE(ParseCpuList("-1").empty());
+}
+
+//////////////////////////////////////////////////
+TEST(ThreadAffinity, PinCurrentThread)
+{
+  EXPECT_FALSE(PinCurrentThread({}));
+
+#ifdef __linux__
+  cpu_set_t original;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(original), &original));
+  unsigned int allowed = 0;
+  while (!CPU_ISSET(allowed, &original))
+    ++allowed;
+
+  EXPECT_TRUE(PinCurrentThread({allowed}));
+  cpu_set_t pinned;
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(pinned), &pinned));
+  EXPECT_EQ(1, CPU_COUNT(&pinned));
+  EXPECT_TRUE(CPU_ISSET(allowed, &pinned));
+
+  EXPECT_EQ(0, sched_setaffinity(0, sizeof(original), &original));
+
+  // Every system has node 0, unless NUMA isn't exposed at all
+  const auto cpus = NumaNodeCpus(0);
+  if (!cpus.empty())
+  {
+    EXPECT_TRUE(std::is_sorted(cpus.begin(), cpus.end()));
+  }
+  EXPECT_TRUE(NumaNodeCpus(100000).empty());
+#endif
+}
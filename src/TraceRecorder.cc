@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#include <gz/common/Console.hh>
+
+#include "TraceRecorder.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Write a nanosecond count as microseconds.
+/// \param[in] _out Stream to write to.
+/// \param[in] _ns Nanoseconds, clamped to zero.
+void WriteMicroseconds(std::ostream &_out, int64_t _ns)
+{
+  _ns = std::max<int64_t>(_ns, 0);
+  const int64_t fraction = _ns % 1000;
+  _out << _ns / 1000 << '.' << fraction / 100 << (fraction / 10) % 10
+       << fraction % 10;
+}
+
+/// \brief Write a JSON string.
+/// \param[in] _out Stream to write to.
+/// \param[in] _value String to quote and escape.
+void WriteString(std::ostream &_out, const std::string &_value)
+{
+  static const char kHex[] = "0123456789abcdef";
+  _out << '"';
+  for (const char c : _value)
+  {
+    if (c == '"' || c == '\\')
+    {
+      _out << '\\' << c;
+    }
+    else if (static_cast<unsigned char>(c) < 0x20u)
+    {
+      _out << "\\u00" << kHex[(c >> 4) & 0xf] << kHex[c & 0xf];
+    }
+    else
+    {
+      _out << c;
+    }
+  }
+  _out << '"';
+}
+}
+
+//////////////////////////////////////////////////
+TraceRecorder &TraceRecorder::Instance()
+{
+  static TraceRecorder recorder;
+  return recorder;
+}
+
+//////////////////////////////////////////////////
+void TraceRecorder::SetCapacity(std::size_t _events)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->events.assign(_events, Event());
+  this->events.shrink_to_fit();
+  this->next = 0u;
+  this->full = false;
+  this->enabled = _events > 0u;
+}
+
+//////////////////////////////////////////////////
+std::size_t TraceRecorder::Capacity() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->events.size();
+}
+
+//////////////////////////////////////////////////
+bool TraceRecorder::Record(const char *_phase, uint64_t _track,
+    std::chrono::steady_clock::time_point _begin,
+    std::chrono::steady_clock::time_point _end)
+{
+  Event event;
+  event.phase = _phase;
+  event.track = _track;
+  event.begin = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _begin - this->epoch).count();
+  event.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      _end - _begin).count();
+  event.thread = static_cast<uint32_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (this->events.empty())
+    return false;
+  this->events[this->next] = event;
+  if (++this->next == this->events.size())
+  {
+    this->next = 0u;
+    this->full = true;
+  }
+  return this->trackNames.find(_track) == this->trackNames.end();
+}
+
+//////////////////////////////////////////////////
+void TraceRecorder::SetTrackName(uint64_t _track, const std::string &_name)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->trackNames[_track] = _name;
+}
+
+//////////////////////////////////////////////////
+std::vector<TraceRecorder::Event> TraceRecorder::Events() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  std::vector<Event> result;
+  if (this->full)
+  {
+    result.reserve(this->events.size());
+    result.insert(result.end(), this->events.begin() + this->next,
+        this->events.end());
+  }
+  result.insert(result.end(), this->events.begin(),
+      this->events.begin() + this->next);
+  return result;
+}
+
+//////////////////////////////////////////////////
+void TraceRecorder::Clear()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->next = 0u;
+  this->full = false;
+}
+
+//////////////////////////////////////////////////
+std::string TraceRecorder::Json() const
+{
+  const std::vector<Event> recorded = this->Events();
+  std::unordered_map<uint64_t, std::string> names;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    names = this->trackNames;
+  }
+
+  std::ostringstream out;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+
+  // Name the tracks of the recorded events
+  std::vector<uint64_t> tracks;
+  for (const Event &event : recorded)
+    tracks.push_back(event.track);
+  std::sort(tracks.begin(), tracks.end());
+  tracks.erase(std::unique(tracks.begin(), tracks.end()), tracks.end());
+  for (const uint64_t track : tracks)
+  {
+    auto it = names.find(track);
+    if (it == names.end())
+      continue;
+    out << (first ? "" : ",")
+        << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << track << ",\"args\":{\"name\":";
+    WriteString(out, it->second);
+    out << "}}";
+    first = false;
+  }
+
+  for (const Event &event : recorded)
+  {
+    out << (first ? "" : ",") << "\n{\"name\":";
+    WriteString(out, event.phase ? event.phase : "");
+    out << ",\"cat\":\"sensor\",\"ph\":\"X\",\"ts\":";
+    WriteMicroseconds(out, event.begin);
+    out << ",\"dur\":";
+    WriteMicroseconds(out, event.duration);
+    out << ",\"pid\":1,\"tid\":" << event.track
+        << ",\"args\":{\"thread\":" << event.thread << "}}";
+    first = false;
+  }
+  out << "\n]}\n";
+  return out.str();
+}
+
+//////////////////////////////////////////////////
+bool TraceRecorder::Dump(const std::string &_path) const
+{
+  std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+  if (!file)
+  {
+    gzerr << "Unable to open trace file [" << _path << "].\n";
+    return false;
+  }
+  file << this->Json();
+  if (!file)
+  {
+    gzerr << "Unable to write trace file [" << _path << "].\n";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef GZ_SENSORS_TRACERECORDER_HH_
+#define GZ_SENSORS_TRACERECORDER_HH_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gz/sensors/config.hh"
+#include "gz/sensors/Export.hh"
+
+namespace gz
+{
+  namespace sensors
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace GZ_SENSORS_VERSION_NAMESPACE {
+    //
+    /// \brief Records the phases of the sensor updates into a ring buffer
+    /// and writes them as Chrome trace JSON, which chrome://tracing and
+    /// Perfetto open. Each event is a complete event, "ph": "X", on the
+    /// track of its sensor, "tid" being the sensor id and the track named
+    /// after the sensor. Recording is disabled until a capacity is set, and
+    /// then costs a clock read and a short locked copy per phase.
+    class GZ_SENSORS_VISIBLE TraceRecorder
+    {
+      /// \brief A recorded phase.
+      public: struct Event
+      {
+        /// \brief Name of the phase, a string literal.
+        const char *phase{nullptr};
+
+        /// \brief Track of the event, the sensor id.
+        uint64_t track{0u};
+
+        /// \brief Start time in nanoseconds since the recorder epoch.
+        int64_t begin{0};
+
+        /// \brief Duration in nanoseconds.
+        int64_t duration{0};
+
+        /// \brief Hash of the thread that recorded the event.
+        uint32_t thread{0u};
+      };
+
+      /// \brief Get the recorder shared by all the sensors.
+      /// \return The recorder.
+      public: static TraceRecorder &Instance();
+
+      /// \brief Set the number of events kept, the oldest ones being
+      /// overwritten. Changing it clears the recorded events.
+      /// \param[in] _events Number of events, zero disables recording.
+      public: void SetCapacity(std::size_t _events);
+
+      /// \brief Get the number of events kept.
+      /// \return Number of events, zero when recording is disabled.
+      public: std::size_t Capacity() const;
+
+      /// \brief Get whether events are recorded.
+      /// \return True if the capacity is positive.
+      public: bool Enabled() const
+      {
+        return this->enabled.load(std::memory_order_relaxed);
+      }
+
+      /// \brief Record a phase.
+      /// \param[in] _phase Name of the phase, a string literal.
+      /// \param[in] _track Track of the event.
+      /// \param[in] _begin Start of the phase.
+      /// \param[in] _end End of the phase.
+      /// \return True if the track has no name yet.
+      /// \sa SetTrackName
+      public: bool Record(const char *_phase, uint64_t _track,
+                  std::chrono::steady_clock::time_point _begin,
+                  std::chrono::steady_clock::time_point _end);
+
+      /// \brief Set the name shown for a track.
+      /// \param[in] _track Track.
+      /// \param[in] _name Name of the track.
+      public: void SetTrackName(uint64_t _track, const std::string &_name);
+
+      /// \brief Get the recorded events, oldest first.
+      /// \return Recorded events.
+      public: std::vector<Event> Events() const;
+
+      /// \brief Remove the recorded events.
+      public: void Clear();
+
+      /// \brief Write the recorded events as Chrome trace JSON.
+      /// \return JSON object with a "traceEvents" array.
+      public: std::string Json() const;
+
+      /// \brief Write the recorded events as Chrome trace JSON to a file.
+      /// \param[in] _path Path of the file, overwritten.
+      /// \return True if the file was written.
+      public: bool Dump(const std::string &_path) const;
+
+      /// \brief Protects the events and track names.
+      private: mutable std::mutex mutex;
+
+      /// \brief True if the capacity is positive.
+      private: std::atomic<bool> enabled{false};
+
+      /// \brief Ring buffer of events.
+      private: std::vector<Event> events;
+
+      /// \brief Index of the next event to write in events.
+      private: std::size_t next{0u};
+
+      /// \brief True once the ring buffer wrapped around.
+      private: bool full{false};
+
+      /// \brief Name of each track.
+      private: std::unordered_map<uint64_t, std::string> trackNames;
+
+      /// \brief Time of the events' zero.
+      private: const std::chrono::steady_clock::time_point epoch{
+                   std::chrono::steady_clock::now()};
+    };
+
+    /// \brief Records the phase of a sensor from construction to
+    /// destruction when tracing is enabled.
+    class TraceScope
+    {
+      /// \brief Constructor
+      /// \param[in] _phase Name of the phase, a string literal.
+      /// \param[in] _sensor Sensor, with Id() and Name() functions, which
+      /// must outlive the scope.
+      /// \tparam SensorT Sensor type.
+      public: template <typename SensorT>
+              TraceScope(const char *_phase, const SensorT &_sensor)
+        : phase(TraceRecorder::Instance().Enabled() ? _phase : nullptr)
+      {
+        if (!this->phase)
+          return;
+        this->track = _sensor.Id();
+        this->sensor = &_sensor;
+        this->name = [](const void *_s)
+        {
+          return static_cast<const SensorT *>(_s)->Name();
+        };
+        this->begin = std::chrono::steady_clock::now();
+      }
+
+      /// \brief Destructor, records the phase.
+      public: ~TraceScope()
+      {
+        if (!this->phase)
+          return;
+        TraceRecorder &recorder = TraceRecorder::Instance();
+        if (recorder.Enabled() && recorder.Record(this->phase, this->track,
+            this->begin, std::chrono::steady_clock::now()))
+        {
+          recorder.SetTrackName(this->track, this->name(this->sensor));
+        }
+      }
+
+      /// \brief No copy constructor
+      public: TraceScope(const TraceScope &) = delete;
+
+      /// \brief No copy assignment
+      public: TraceScope &operator=(const TraceScope &) = delete;
+
+      /// \brief Name of the phase, null when tracing is disabled.
+      private: const char *phase;
+
+      /// \brief Track of the phase.
+      private: uint64_t track{0u};
+
+      /// \brief Sensor of the phase.
+      private: const void *sensor{nullptr};
+
+      /// \brief Get the name of the sensor.
+      private: std::string (*name)(const void *){nullptr};
+
+      /// \brief Start of the phase.
+      private: std::chrono::steady_clock::time_point begin;
+    };
+
+    /// \brief Track of the phases that don't belong to a sensor, such as
+    /// creating noise models while sensors are loaded.
+    struct FactoryTraceTrack
+    {
+      /// \brief Get the track.
+      /// \return Track id, which no sensor or manager has.
+      uint64_t Id() const { return std::numeric_limits<uint64_t>::max(); }
+
+      /// \brief Get the name of the track.
+      /// \return Track name.
+      std::string Name() const { return "Factories"; }
+    };
+
+    /// \brief The factory track, which outlives the trace scopes.
+    inline const FactoryTraceTrack kFactoryTraceTrack{};
+    }
+  }
+}
+
+#endif
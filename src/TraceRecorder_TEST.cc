@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include <gz/common/Filesystem.hh>
+#include <sdf/Noise.hh>
+
+#include "gz/sensors/Noise.hh"
+
+#include "TraceRecorder.hh"
+
+using namespace gz;
+using namespace sensors;
+
+namespace
+{
+/// \brief Stand-in for a sensor.
+struct FakeSensor
+{
+  uint64_t Id() const { return this->id; }
+  std::string Name() const { ++this->nameCalls; return this->name; }
+  uint64_t id{0u};
+  std::string name;
+  mutable int nameCalls{0};
+};
+}
+
+//////////////////////////////////////////////////
+TEST(TraceRecorder_TEST, Disabled)
+{
+  TraceRecorder &recorder = TraceRecorder::Instance();
+  recorder.SetCapacity(0u);
+  EXPECT_FALSE(recorder.Enabled());
+  EXPECT_EQ(0u, recorder.Capacity());
+
+  FakeSensor sensor{3u, "camera"};
+  {
+    TraceScope scope("render", sensor);
+  }
+  EXPECT_TRUE(recorder.Events().empty());
+  EXPECT_EQ(0, sensor.nameCalls);
+}
+
+//////////////////////////////////////////////////
+TEST(TraceRecorder_TEST, Ring)
+{
+  TraceRecorder &recorder = TraceRecorder::Instance();
+  recorder.SetCapacity(4u);
+  EXPECT_TRUE(recorder.Enabled());
+  EXPECT_EQ(4u, recorder.Capacity());
+
+  // The name of a track is only read the first time
+  FakeSensor sensor{5u, "lidar"};
+  for (int i = 0; i < 6; ++i)
+  {
+    TraceScope scope(i % 2 ? "publish" : "render", sensor);
+  }
+  EXPECT_EQ(1, sensor.nameCalls);
+
+  // The two oldest events were overwritten
+  const auto events = recorder.Events();
+  ASSERT_EQ(4u, events.size());
+  for (std::size_t i = 0u; i < events.size(); ++i)
+  {
+    EXPECT_EQ(5u, events[i].track);
+    EXPECT_EQ(std::string(i % 2 ? "publish" : "render"), events[i].phase);
+    EXPECT_GE(events[i].duration, 0);
+    if (i > 0u)
+    {
+      EXPECT_GE(events[i].begin, events[i - 1u].begin);
+    }
+  }
+
+  recorder.Clear();
+  EXPECT_TRUE(recorder.Events().empty());
+  EXPECT_EQ(4u, recorder.Capacity());
+  recorder.SetCapacity(0u);
+}
+
+//////////////////////////////////////////////////
+TEST(TraceRecorder_TEST, Json)
+{
+  TraceRecorder &recorder = TraceRecorder::Instance();
+  recorder.SetCapacity(16u);
+
+  const auto start = std::chrono::steady_clock::now();
+  recorder.Record("fill", 7u, start, start + std::chrono::microseconds(1500));
+  recorder.SetTrackName(7u, "depth \"camera\"");
+
+  const std::string json = recorder.Json();
+  EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, json.find(
+      "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":7,"
+      "\"args\":{\"name\":\"depth \\\"camera\\\"\"}}"));
+  EXPECT_NE(std::string::npos, json.find(
+      "{\"name\":\"fill\",\"cat\":\"sensor\",\"ph\":\"X\",\"ts\":"));
+  EXPECT_NE(std::string::npos, json.find("\"dur\":1500.000,\"pid\":1,"
+      "\"tid\":7,"));
+  EXPECT_EQ("]}\n", json.substr(json.size() - 3u));
+
+  // Dump writes the same JSON
+  const std::string path = common::joinPaths(::testing::TempDir(),
+      "trace_recorder_test.json");
+  ASSERT_TRUE(recorder.Dump(path));
+  std::ifstream file(path);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  EXPECT_EQ(json, contents.str());
+  common::removeFile(path);
+
+  EXPECT_FALSE(recorder.Dump(
+      common::joinPaths(path, "missing", "trace.json")));
+  recorder.SetCapacity(0u);
+}
+
+//////////////////////////////////////////////////
+TEST(TraceRecorder_TEST, NoiseFactory)
+{
+  TraceRecorder &recorder = TraceRecorder::Instance();
+  recorder.SetCapacity(8u);
+
+  sdf::Noise noiseDom;
+  noiseDom.SetType(sdf::NoiseType::GAUSSIAN);
+  noiseDom.SetStdDev(0.1);
+  EXPECT_NE(nullptr, NoiseFactory::NewNoiseModel(noiseDom, "imu"));
+
+  // Noise models are created on the factory track
+  const auto events = recorder.Events();
+  ASSERT_EQ(1u, events.size());
+  EXPECT_STREQ("create_noise", events[0].phase);
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), events[0].track);
+  EXPECT_NE(std::string::npos, recorder.Json().find("\"Factories\""));
+  recorder.SetCapacity(0u);
+}
@@ -17,7 +17,11 @@
 
 #include <gz/msgs/camera_info.pb.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <mutex>
+#include <vector>
 
 #include <gz/common/Console.hh>
 #include <gz/common/Event.hh>
@@ -26,20 +30,206 @@
 #include <gz/common/StringUtils.hh>
 #include <gz/math/Angle.hh>
 #include <gz/math/Helpers.hh>
+#include <gz/math/Pose3.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
 
 #include "gz/sensors/WideAngleCameraSensor.hh"
 #include "gz/sensors/ImageGaussianNoiseModel.hh"
 #include "gz/sensors/ImageNoise.hh"
+#include "gz/sensors/ImageWriter.hh"
 #include "gz/sensors/Manager.hh"
 #include "gz/sensors/RenderingEvents.hh"
 #include "gz/sensors/SensorFactory.hh"
 #include "gz/sensors/SensorTypes.hh"
 
+#include "AlignedBuffer.hh"
+#include "ImageRemap.hh"
+#include "MemorySize.hh"
+
 using namespace gz;
 using namespace sensors;
 
+namespace
+{
+/// \brief Get the size of the cubemap faces the wide angle camera renders.
+/// Each face covers 90 degrees, so the pixels of a face beyond the
+/// angular resolution of the lens image are rendered for nothing.
+/// \param[in] _cameraSdf Camera SDF.
+/// \return The env_texture_size of the lens if the SDF sets it. Otherwise
+/// the smallest power of two whose face center has the angular resolution
+/// of the center of the image, for an equidistant lens.
+int CubemapFaceSize(const sdf::Camera &_cameraSdf)
+{
+  sdf::ElementPtr elem = _cameraSdf.Element();
+  sdf::ElementPtr lensElem = elem ? elem->FindElement("lens") : nullptr;
+  if (lensElem && lensElem->HasElement("env_texture_size"))
+    return _cameraSdf.LensEnvironmentTextureSize();
+
+  // A face of size s spans s / 2 pixels per radian at its center
+  const double hfov = std::max(_cameraSdf.HorizontalFov().Radian(), 0.01);
+  const double pixelsPerRadian = _cameraSdf.ImageWidth() / hfov;
+  int size = 64;
+  while (size < 4096 && size < 2.0 * pixelsPerRadian)
+    size *= 2;
+  return size;
+}
+
+/// \brief Number of cubemap faces.
+constexpr unsigned int kFaceCount = 6u;
+
+/// \brief Orientation of the camera of each cubemap face in the sensor
+/// frame, facing +X, -X, +Y, -Y, +Z and -Z.
+const std::array<math::Quaterniond, kFaceCount> kFaceRotations = {
+  math::Quaterniond(0.0, 0.0, 0.0),
+  math::Quaterniond(0.0, 0.0, GZ_PI),
+  math::Quaterniond(0.0, 0.0, GZ_PI * 0.5),
+  math::Quaterniond(0.0, 0.0, -GZ_PI * 0.5),
+  math::Quaterniond(0.0, -GZ_PI * 0.5, 0.0),
+  math::Quaterniond(0.0, GZ_PI * 0.5, 0.0)};
+
+/// \brief Angle function of a lens.
+enum class LensFunction
+{
+  IDENTITY,
+  SIN,
+  TAN
+};
+
+/// \brief Projection of a lens, r = c1 * f * fun(theta / c2 + c3), where
+/// theta is the angle of a ray to the optical axis and r its distance to
+/// the image center, the half width being 1 when scaled to the hfov.
+struct LensProjection
+{
+  double c1{1.0};
+  double c2{1.0};
+  double c3{0.0};
+  double f{1.0};
+  LensFunction fun{LensFunction::TAN};
+};
+
+/// \brief Get the projection of the lens of a camera, with the mapping
+/// the rendering camera lens uses for each lens type.
+/// \param[in] _cameraSdf Camera SDF.
+/// \return Projection, scaled to the hfov if the SDF says so.
+LensProjection LensProjectionFromSdf(const sdf::Camera &_cameraSdf)
+{
+  LensProjection lens;
+  const std::string type = _cameraSdf.LensType();
+  if (type == "custom")
+  {
+    lens.c1 = _cameraSdf.LensC1();
+    lens.c2 = _cameraSdf.LensC2();
+    lens.c3 = _cameraSdf.LensC3();
+    lens.f = _cameraSdf.LensFocalLength();
+    const std::string fun = _cameraSdf.LensFunction();
+    lens.fun = fun == "sin" ? LensFunction::SIN :
+        fun == "tan" ? LensFunction::TAN : LensFunction::IDENTITY;
+  }
+  else if (type == "stereographic")
+  {
+    lens.c1 = 2.0;
+    lens.c2 = 2.0;
+  }
+  else if (type == "equidistant")
+  {
+    lens.fun = LensFunction::IDENTITY;
+  }
+  else if (type == "equisolid_angle")
+  {
+    lens.c1 = 2.0;
+    lens.c2 = 2.0;
+    lens.fun = LensFunction::SIN;
+  }
+  else if (type == "orthographic")
+  {
+    lens.fun = LensFunction::SIN;
+  }
+
+  if (_cameraSdf.LensScaleToHfov())
+  {
+    const double halfFov = _cameraSdf.HorizontalFov().Radian() * 0.5;
+    const double arg = halfFov / lens.c2 + lens.c3;
+    const double r = lens.fun == LensFunction::SIN ? std::sin(arg) :
+        lens.fun == LensFunction::TAN ? std::tan(arg) : arg;
+    if (std::abs(lens.c1 * r) > 1e-9)
+      lens.f = 1.0 / (lens.c1 * r);
+  }
+  return lens;
+}
+
+/// \brief Build the table stitching the image of a lens from the faces
+/// of a cubemap. The faces are stacked in a source image one face wide,
+/// in the order of kFaceRotations, and seen from the camera frame with X
+/// forward, Y left and Z up.
+/// \param[out] _remap Table to build.
+/// \param[in] _cameraSdf Camera SDF.
+/// \param[in] _faceSize Width and height of a face.
+void BuildCubemapStitch(ImageRemap &_remap, const sdf::Camera &_cameraSdf,
+    unsigned int _faceSize)
+{
+  const LensProjection lens = LensProjectionFromSdf(_cameraSdf);
+  const double cutoff = _cameraSdf.LensCutoffAngle().Radian();
+  const unsigned int width = _cameraSdf.ImageWidth();
+  const unsigned int height = _cameraSdf.ImageHeight();
+  const double aspect = static_cast<double>(height) / std::max(width, 1u);
+
+  _remap.Build(width, height, _faceSize, _faceSize * kFaceCount,
+      [&](double &_x, double &_y)
+  {
+    // Offset from the image center, the half width being 1
+    const double px = (_x - 0.5) * 2.0;
+    const double py = (_y - 0.5) * 2.0 * aspect;
+    const double r = std::sqrt(px * px + py * py);
+
+    // Invert the projection for the angle of the ray
+    const double arg = r / (lens.c1 * lens.f);
+    double angle = arg;
+    if (lens.fun == LensFunction::SIN)
+    {
+      if (std::abs(arg) > 1.0)
+        return false;
+      angle = std::asin(arg);
+    }
+    else if (lens.fun == LensFunction::TAN)
+    {
+      angle = std::atan(arg);
+    }
+    const double theta = lens.c2 * (angle - lens.c3);
+    if (!std::isfinite(theta) || theta < 0.0 || theta > cutoff)
+      return false;
+
+    math::Vector3d ray(1.0, 0.0, 0.0);
+    if (r > 1e-12)
+    {
+      const double s = std::sin(theta) / r;
+      ray.Set(std::cos(theta), -px * s, -py * s);
+    }
+
+    // The face the ray is the most forward for
+    unsigned int face = 0u;
+    math::Vector3d local;
+    double forward = -1.0;
+    for (unsigned int i = 0u; i < kFaceCount; ++i)
+    {
+      const math::Vector3d v = kFaceRotations[i].RotateVectorReverse(ray);
+      if (v.X() > forward)
+      {
+        forward = v.X();
+        local = v;
+        face = i;
+      }
+    }
+
+    // Faces have a 90 degree field of view
+    _x = (1.0 - local.Y() / local.X()) * 0.5;
+    _y = (face + std::clamp((1.0 - local.Z() / local.X()) * 0.5, 0.0,
+        1.0 - 1e-9)) / kFaceCount;
+    return true;
+  });
+}
+}
+
 /// \brief Private data for WideAngleCameraSensor
 class gz::sensors::WideAngleCameraSensorPrivate
 {
@@ -71,13 +261,21 @@ class gz::sensors::WideAngleCameraSensorPrivate
   public: gz::rendering::WideAngleCameraPtr camera;
 
   /// \brief Image data buffer.
-  public: unsigned char *imageBuffer = nullptr;
+  public: AlignedBuffer<unsigned char> imageBuffer;
+
+  /// \brief Latest image, either imageBuffer or, when frames are used in
+  /// place, the wide angle camera's buffer.
+  public: const unsigned char *imageFrame{nullptr};
 
   /// \brief Pointer to an image to be published
   // public: gz::rendering::Image image;
 
   /// \brief Noise added to sensor data
-  public: std::map<SensorNoiseType, NoisePtr> noises;
+  public: NoiseTable noises;
+
+  /// \brief The image noise if it's applied to the frames on the CPU, in
+  /// which case frames are always copied to imageBuffer.
+  public: std::shared_ptr<ImageGaussianNoiseModel> cpuNoise;
 
   /// \brief Event that is used to trigger callbacks when a new image
   /// is generated
@@ -110,6 +308,42 @@ class gz::sensors::WideAngleCameraSensorPrivate
 
   /// \brief Flag to indicate if sensor is generating data
   public: bool generatingData = false;
+
+  /// \brief True if the cubemap faces are updated progressively.
+  public: bool progressive{false};
+
+  /// \brief Number of faces rendered in turn per frame.
+  public: unsigned int facesPerFrame{1u};
+
+  /// \brief Longest time a face goes without being rendered.
+  public: std::chrono::steady_clock::duration staleness{
+      std::chrono::seconds(1)};
+
+  /// \brief Cameras of the cubemap faces, when updated progressively.
+  public: std::array<rendering::CameraPtr, kFaceCount> faceCameras;
+
+  /// \brief Image each face camera is read back to.
+  public: std::array<rendering::Image, kFaceCount> faceImages;
+
+  /// \brief Time each face was last rendered.
+  public: std::array<std::chrono::steady_clock::duration, kFaceCount>
+      faceStamps{};
+
+  /// \brief True for the faces rendered since the cameras were created.
+  public: std::array<bool, kFaceCount> faceRendered{};
+
+  /// \brief Faces rendered on the next frame. Their cameras are the ones
+  /// given to RenderingSensor, so a batch render only renders them.
+  public: std::vector<unsigned int> scheduledFaces;
+
+  /// \brief Next face in turn.
+  public: unsigned int nextFace{0u};
+
+  /// \brief Latest render of the faces, stacked one face wide.
+  public: AlignedBuffer<unsigned char> faceAtlas;
+
+  /// \brief Table stitching the image from faceAtlas.
+  public: ImageRemap stitch;
 };
 
 //////////////////////////////////////////////////
@@ -122,11 +356,6 @@ WideAngleCameraSensor::WideAngleCameraSensor()
 WideAngleCameraSensor::~WideAngleCameraSensor()
 {
   this->dataPtr->imageConnection.reset();
-  if (this->dataPtr->imageBuffer)
-  {
-    delete [] this->dataPtr->imageBuffer;
-    this->dataPtr->imageBuffer = nullptr;
-  }
 }
 
 //////////////////////////////////////////////////
@@ -171,11 +400,8 @@ bool WideAngleCameraSensor::Load(const sdf::Sensor &_sdf)
   this->dataPtr->sdfSensor = _sdf;
 
   // Create the image publisher
-  this->dataPtr->pub =
-      this->dataPtr->node.Advertise<gz::msgs::Image>(
-          this->Topic());
-
-  if (!this->dataPtr->pub)
+  if (!this->Advertise<gz::msgs::Image>(this->dataPtr->node,
+      this->dataPtr->pub, this->Topic()))
   {
     gzerr << "Unable to create publisher on topic["
       << this->Topic() << "].\n";
@@ -272,7 +498,7 @@ bool WideAngleCameraSensor::CreateCamera()
   }
 
   this->dataPtr->camera->SetLens(lens);
-
+  this->dataPtr->camera->SetEnvTextureSize(CubemapFaceSize(*cameraSdf));
 
   this->AddSensor(this->dataPtr->camera);
 
@@ -288,9 +514,11 @@ bool WideAngleCameraSensor::CreateCamera()
       this->dataPtr->noises[noiseType] =
         ImageNoiseFactory::NewNoiseModel(noiseSdf, "wide_angle_camera");
 
-      std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
-           this->dataPtr->noises[noiseType])->SetCamera(
-             this->dataPtr->camera);
+      auto imageNoise = std::dynamic_pointer_cast<ImageGaussianNoiseModel>(
+          this->dataPtr->noises[noiseType]);
+      imageNoise->SetCamera(this->dataPtr->camera);
+      this->dataPtr->cpuNoise =
+          imageNoise->AppliesOnCpu() ? imageNoise : nullptr;
     }
     else if (noiseSdf.Type() != sdf::NoiseType::NONE)
     {
@@ -330,15 +558,221 @@ bool WideAngleCameraSensor::CreateCamera()
     this->dataPtr->saveImage = true;
   }
 
+  // Size the frame buffer up front so the first frame doesn't allocate
+  this->dataPtr->imageBuffer.SetMemory(this->BufferMemory());
+  this->dataPtr->imageBuffer.Reserve(rendering::PixelUtil::MemorySize(
+      this->dataPtr->camera->ImageFormat(), width, height));
+  this->dataPtr->imageFrame = nullptr;
+
   this->dataPtr->imageConnection =
       this->dataPtr->camera->ConnectNewWideAngleFrame(
       std::bind(&WideAngleCameraSensor::OnNewWideAngleFrame, this,
         std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
         std::placeholders::_4, std::placeholders::_5));
 
+  if (this->dataPtr->progressive)
+    this->UpdateFaceCameras(true);
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool WideAngleCameraSensor::UpdateFaceCameras(bool _needed)
+{
+  auto &faces = this->dataPtr->faceCameras;
+  if (!_needed)
+  {
+    if (faces[0])
+    {
+      // Destroying them removes them from the rendered sensors
+      for (auto &face : faces)
+      {
+        this->Scene()->DestroySensor(face);
+        face = nullptr;
+      }
+      this->dataPtr->scheduledFaces.clear();
+      if (this->dataPtr->camera)
+        this->AddSensor(this->dataPtr->camera);
+    }
+    return false;
+  }
+
+  if (faces[0])
+    return true;
+
+  const sdf::Camera *cameraSdf = this->dataPtr->sdfSensor.CameraSensor();
+  if (!cameraSdf || !this->Scene() || !this->dataPtr->camera)
+    return false;
+
+  const unsigned int faceSize =
+      static_cast<unsigned int>(CubemapFaceSize(*cameraSdf));
+  for (unsigned int i = 0u; i < kFaceCount; ++i)
+  {
+    faces[i] = this->Scene()->CreateCamera(
+        this->Name() + "_face" + std::to_string(i));
+    if (!faces[i])
+    {
+      gzerr << "Unable to create the cubemap face cameras of ["
+            << this->Name() << "]\n";
+      for (unsigned int j = 0u; j < i; ++j)
+      {
+        this->Scene()->DestroySensor(faces[j]);
+        faces[j] = nullptr;
+      }
+      return false;
+    }
+    faces[i]->SetImageFormat(rendering::PF_R8G8B8);
+    faces[i]->SetImageWidth(faceSize);
+    faces[i]->SetImageHeight(faceSize);
+    faces[i]->SetVisibilityMask(cameraSdf->VisibilityMask());
+    faces[i]->SetNearClipPlane(cameraSdf->NearClip());
+    faces[i]->SetFarClipPlane(cameraSdf->FarClip());
+    faces[i]->SetAspectRatio(1.0);
+    faces[i]->SetHFOV(math::Angle(GZ_PI * 0.5));
+    faces[i]->SetAntiAliasing(2);
+    this->Scene()->RootVisual()->AddChild(faces[i]);
+    this->dataPtr->faceImages[i] = faces[i]->CreateImage();
+  }
+
+  this->dataPtr->faceAtlas.SetMemory(this->BufferMemory());
+  this->dataPtr->faceAtlas.Resize(rendering::PixelUtil::MemorySize(
+      rendering::PF_R8G8B8, faceSize, faceSize * kFaceCount));
+  BuildCubemapStitch(this->dataPtr->stitch, *cameraSdf, faceSize);
+
+  // The first frame renders every face
+  this->RemoveSensor(this->dataPtr->camera);
+  this->dataPtr->faceRendered.fill(false);
+  this->dataPtr->scheduledFaces.clear();
+  for (unsigned int i = 0u; i < kFaceCount; ++i)
+  {
+    this->dataPtr->scheduledFaces.push_back(i);
+    this->AddSensor(faces[i]);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool WideAngleCameraSensor::RenderFaces(
+    const std::chrono::steady_clock::duration &_now)
+{
+  GZ_PROFILE("WideAngleCameraSensor::RenderFaces");
+  auto &d = *this->dataPtr;
+  for (unsigned int face : d.scheduledFaces)
+  {
+    d.faceCameras[face]->SetLocalPose(
+        this->Pose() * math::Pose3d(math::Vector3d::Zero,
+        kFaceRotations[face]));
+  }
+
+  this->Render();
+
+  const std::size_t faceBytes = d.faceAtlas.Size() / kFaceCount;
+  for (unsigned int face : d.scheduledFaces)
+  {
+    d.faceCameras[face]->Copy(d.faceImages[face]);
+    memcpy(d.faceAtlas.Data() + face * faceBytes,
+        d.faceImages[face].Data<unsigned char>(), faceBytes);
+    d.faceStamps[face] = _now;
+    d.faceRendered[face] = true;
+    this->RemoveSensor(d.faceCameras[face]);
+  }
+
+  // Schedule the faces that would be too old on the next frame, then the
+  // faces in turn
+  const double rate = this->UpdateRate();
+  const auto next = _now + (rate > 0.0 ?
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / rate)) :
+      std::chrono::steady_clock::duration::zero());
+  d.scheduledFaces.clear();
+  for (unsigned int face = 0u; face < kFaceCount; ++face)
+  {
+    if (!d.faceRendered[face] || next - d.faceStamps[face] >= d.staleness)
+      d.scheduledFaces.push_back(face);
+  }
+  for (unsigned int i = 0u; i < kFaceCount &&
+       d.scheduledFaces.size() < d.facesPerFrame; ++i)
+  {
+    const unsigned int face = d.nextFace;
+    d.nextFace = (d.nextFace + 1u) % kFaceCount;
+    if (std::find(d.scheduledFaces.begin(), d.scheduledFaces.end(), face) ==
+        d.scheduledFaces.end())
+    {
+      d.scheduledFaces.push_back(face);
+    }
+  }
+  for (unsigned int face : d.scheduledFaces)
+    this->AddSensor(d.faceCameras[face]);
+
+  if (std::find(d.faceRendered.begin(), d.faceRendered.end(), false) !=
+      d.faceRendered.end())
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(d.mutex);
+  const unsigned int width = d.camera->ImageWidth();
+  const unsigned int height = d.camera->ImageHeight();
+  const std::size_t len = rendering::PixelUtil::MemorySize(
+      rendering::PF_R8G8B8, width, height);
+  d.imageBuffer.Resize(len);
+  d.stitch.Apply(d.faceAtlas.Data(), d.imageBuffer.Data(), 3u);
+  if (d.cpuNoise)
+  {
+    d.cpuNoise->SetThreadCount(this->ImageNoiseThreadCount());
+    d.cpuNoise->ApplyToImage(d.imageBuffer.Data(), len);
+  }
+  d.imageFrame = d.imageBuffer.Data();
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool WideAngleCameraSensor::SetProgressiveUpdate(bool _enabled,
+    unsigned int _facesPerFrame,
+    const std::chrono::steady_clock::duration &_staleness)
+{
+  if (!this->dataPtr->initialized)
+  {
+    gzerr << "Unable to set the progressive update of [" << this->Name()
+          << "], the sensor isn't loaded.\n";
+    return false;
+  }
+
+  if (_facesPerFrame < 1u || _facesPerFrame > kFaceCount)
+  {
+    gzerr << "Unable to set the progressive update of [" << this->Name()
+          << "] to [" << _facesPerFrame << "] faces per frame, it must be "
+          << "between 1 and " << kFaceCount << ".\n";
+    return false;
+  }
+
+  this->dataPtr->progressive = _enabled;
+  this->dataPtr->facesPerFrame = _facesPerFrame;
+  this->dataPtr->staleness = _staleness;
+  if (this->Scene())
+    this->UpdateFaceCameras(_enabled);
   return true;
 }
 
+//////////////////////////////////////////////////
+bool WideAngleCameraSensor::ProgressiveUpdate() const
+{
+  return this->dataPtr->progressive;
+}
+
+//////////////////////////////////////////////////
+unsigned int WideAngleCameraSensor::ProgressiveFacesPerFrame() const
+{
+  return this->dataPtr->facesPerFrame;
+}
+
+//////////////////////////////////////////////////
+std::chrono::steady_clock::duration
+    WideAngleCameraSensor::ProgressiveStaleness() const
+{
+  return this->dataPtr->staleness;
+}
+
 /////////////////////////////////////////////////
 void WideAngleCameraSensor::OnNewWideAngleFrame(
     const unsigned char *_data,
@@ -351,10 +785,22 @@ void WideAngleCameraSensor::OnNewWideAngleFrame(
   unsigned int len = _width * _height * _channels;
   unsigned int bufferSize = len * sizeof(unsigned char);
 
-  if (!this->dataPtr->imageBuffer)
-    this->dataPtr->imageBuffer = new unsigned char[len];
-
-  memcpy(this->dataPtr->imageBuffer, _data, bufferSize);
+  if (this->ZeroCopyFrames() && !this->dataPtr->cpuNoise)
+  {
+    this->dataPtr->imageFrame = _data;
+  }
+  else
+  {
+    this->dataPtr->imageBuffer.Resize(len);
+    memcpy(this->dataPtr->imageBuffer.Data(), _data, bufferSize);
+    if (this->dataPtr->cpuNoise)
+    {
+      this->dataPtr->cpuNoise->SetThreadCount(this->ImageNoiseThreadCount());
+      this->dataPtr->cpuNoise->ApplyToImage(
+          this->dataPtr->imageBuffer.Data(), len);
+    }
+    this->dataPtr->imageFrame = this->dataPtr->imageBuffer.Data();
+  }
 }
 
 /////////////////////////////////////////////////
@@ -379,6 +825,8 @@ void WideAngleCameraSensor::SetScene(gz::rendering::ScenePtr _scene)
   {
     // TODO(anyone) Remove camera from scene
     this->dataPtr->camera = nullptr;
+    this->dataPtr->faceCameras.fill(nullptr);
+    this->dataPtr->scheduledFaces.clear();
     RenderingSensor::SetScene(_scene);
     if (this->dataPtr->initialized)
       this->CreateCamera();
@@ -408,7 +856,9 @@ bool WideAngleCameraSensor::Update(
   // render only if necessary
   if (!this->dataPtr->pub.HasConnections() &&
       this->dataPtr->imageEvent.ConnectionCount() <= 0 &&
-      !this->dataPtr->saveImage)
+      !this->dataPtr->saveImage &&
+      !this->HasSharedMemoryConnections() &&
+      !this->HasCompressedConnections())
   {
     if (this->dataPtr->generatingData)
     {
@@ -430,9 +880,17 @@ bool WideAngleCameraSensor::Update(
   }
 
   // generate sensor data
-  this->Render();
+  if (this->dataPtr->faceCameras[0])
+  {
+    if (!this->RenderFaces(_now))
+      return false;
+  }
+  else
+  {
+    this->Render();
+  }
 
-  if (!this->dataPtr->imageBuffer)
+  if (!this->dataPtr->imageFrame)
     return false;
 
   unsigned int width = this->dataPtr->camera->ImageWidth();
@@ -459,6 +917,14 @@ bool WideAngleCameraSensor::Update(
 
   std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
 
+  const std::size_t size =
+      rendering::PixelUtil::MemorySize(renderingFormat, width, height);
+
+  // Pixels only go through protobuf if someone receives the message
+  const bool publishImage = this->dataPtr->pub.HasConnections() ||
+      this->dataPtr->imageEvent.ConnectionCount() > 0u ||
+      (!this->SharedMemoryOutput() && !this->CompressedOutput());
+
   // create message
   gz::msgs::Image msg;
   {
@@ -472,16 +938,30 @@ bool WideAngleCameraSensor::Update(
     auto frame = msg.mutable_header()->add_data();
     frame->set_key("frame_id");
     frame->add_value(this->Name());
-    msg.set_data(this->dataPtr->imageBuffer,
-        rendering::PixelUtil::MemorySize(renderingFormat,
-        width, height));
+    if (this->dataPtr->faceCameras[0])
+    {
+      auto *stamps = msg.mutable_header()->add_data();
+      stamps->set_key("face_stamps");
+      for (const auto &stamp : this->dataPtr->faceStamps)
+      {
+        stamps->add_value(std::to_string(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+            stamp).count()));
+      }
+    }
+    if (publishImage)
+      msg.set_data(this->dataPtr->imageFrame, size);
   }
 
   // publish the image message
   {
     this->AddSequence(msg.mutable_header());
+    this->WriteSharedMemoryImage(this->Topic(), msg,
+        this->dataPtr->imageFrame, size);
+    this->PublishCompressedImage(msg, this->dataPtr->imageFrame, size, format);
     GZ_PROFILE("WideAngleCameraSensor::Update Publish");
-    this->dataPtr->pub.Publish(msg);
+    if (publishImage)
+      this->Publish(this->dataPtr->pub, msg);
 
     // publish the camera info message
     this->PublishInfo(_now);
@@ -503,7 +983,7 @@ bool WideAngleCameraSensor::Update(
   // Save image
   if (this->dataPtr->saveImage)
   {
-    this->dataPtr->SaveImage(this->dataPtr->imageBuffer, width, height, format);
+    this->dataPtr->SaveImage(this->dataPtr->imageFrame, width, height, format);
   }
 
   return true;
@@ -525,12 +1005,11 @@ bool WideAngleCameraSensorPrivate::SaveImage(const unsigned char *_data,
                          std::to_string(this->saveImageCounter) + ".png";
   ++this->saveImageCounter;
 
-  gz::common::Image localImage;
-  localImage.SetFromData(_data, _width, _height, _format);
-
-  localImage.SavePNG(
-      gz::common::joinPaths(this->saveImagePath, filename));
-  return true;
+  // Encoding and writing the file happen on the image writer's threads
+  return ImageWriter::Instance().Write(
+      gz::common::joinPaths(this->saveImagePath, filename), _data,
+      rendering::PixelUtil::MemorySize(this->camera->ImageFormat(),
+      _width, _height), _width, _height, _format);
 }
 
 //////////////////////////////////////////////////
@@ -555,9 +1034,33 @@ rendering::CameraPtr WideAngleCameraSensor::RenderingCamera() const
   return this->dataPtr->camera;
 }
 
+//////////////////////////////////////////////////
+SensorMemoryUsage WideAngleCameraSensor::MemoryUsage() const
+{
+  SensorMemoryUsage usage = CameraSensor::MemoryUsage();
+  usage["image"] += MemorySize(this->dataPtr->imageBuffer);
+  if (this->dataPtr->faceCameras[0])
+  {
+    // The face images add up to the size of the atlas
+    usage["cubemap"] += MemorySize(this->dataPtr->faceAtlas) +
+        MemorySize(this->dataPtr->stitch.Sources()) +
+        this->dataPtr->faceAtlas.Size();
+  }
+  return usage;
+}
+
 //////////////////////////////////////////////////
 bool WideAngleCameraSensor::HasConnections() const
 {
   return (this->dataPtr->pub && this->dataPtr->pub.HasConnections()) ||
-      this->dataPtr->imageEvent.ConnectionCount() > 0u;
+      this->dataPtr->imageEvent.ConnectionCount() > 0u ||
+      this->HasSharedMemoryConnections() ||
+      this->HasCompressedConnections();
+}
+
+//////////////////////////////////////////////////
+bool WideAngleCameraSensor::HasRegionOfInterestSupport() const
+{
+  // The lens projection doesn't map to pinhole intrinsics
+  return false;
 }
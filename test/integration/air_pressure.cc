@@ -221,6 +221,15 @@ TEST_F(AirPressureSensorTest, SensorReadings)
   EXPECT_EQ(0, msg.header().stamp().nsec());
   EXPECT_FALSE(gz::math::equal(101288.9657925308, msgNoise.pressure()));
   EXPECT_DOUBLE_EQ(sqrt(0.2), msgNoise.variance());
+
+  // The message is reused, the variance set on load is still there
+  sensorNoise->Update(std::chrono::steady_clock::duration(
+      std::chrono::seconds(2)), false);
+  EXPECT_TRUE(msgHelperNoise.WaitForMessage()) << msgHelperNoise;
+  msgNoise = msgHelperNoise.Message();
+  EXPECT_EQ(2, msgNoise.header().stamp().sec());
+  EXPECT_DOUBLE_EQ(sqrt(0.2), msgNoise.variance());
+  EXPECT_EQ(2, msgNoise.header().data_size());
 }
 
 /////////////////////////////////////////////////
@@ -21,6 +21,7 @@
 #include <gz/msgs/annotated_axis_aligned_2d_box_v.pb.h>
 #include <gz/msgs/annotated_oriented_3d_box.pb.h>
 #include <gz/msgs/annotated_oriented_3d_box_v.pb.h>
+#include <gz/msgs/image.pb.h>
 
 #include <gz/common/Filesystem.hh>
 #include <gz/sensors/Manager.hh>
@@ -44,6 +45,12 @@ class BoundingBoxCameraSensorTest: public testing::Test,
 
   // Create a BoundingBox Camera 3D sensor from a SDF and gets a boxes message
   public: void Boxes3DWithBuiltinSDF(const std::string &_renderEngine);
+
+  // Publish boxes and the annotated image from the worker thread
+  public: void Pipelined(const std::string &_renderEngine);
+
+  // Publish the visible pixels of each box with the boxes
+  public: void VisiblePixels(const std::string &_renderEngine);
 };
 
 /// \brief mutex for thread safety
@@ -481,6 +488,213 @@ void BoundingBoxCameraSensorTest::Boxes3DWithBuiltinSDF(
 }
 
 //////////////////////////////////////////////////
+void BoundingBoxCameraSensorTest::Pipelined(
+  const std::string &_renderEngine)
+{
+  std::string path = common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "boundingbox_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // Skip unsupported engines
+  if (_renderEngine != "ogre2")
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support bounding box cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  rendering::ScenePtr scene = engine->CreateScene("scene");
+  ASSERT_NE(nullptr, scene);
+  BuildScene2d(scene);
+
+  sensors::Manager mgr;
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  auto *sensor =
+    mgr.CreateSensor<sensors::BoundingBoxCameraSensor>(sdfSensor);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  auto camera = sensor->BoundingBoxCamera();
+  ASSERT_NE(camera, nullptr);
+  camera->SetLocalPosition(0.0, 0.0, 0.0);
+  camera->SetLocalRotation(0.0, 0.0, 0.0);
+  camera->SetBoundingBoxType(rendering::BoundingBoxType::BBT_VISIBLEBOX2D);
+
+  // The rgb camera is created once the annotated image is subscribed
+  const std::string rgbCameraName = sensor->Name() + "_rgbCamera";
+  EXPECT_FALSE(scene->HasSensorName(rgbCameraName));
+
+  EXPECT_FALSE(sensor->Pipelined());
+  sensor->SetPipelined(true);
+  EXPECT_TRUE(sensor->Pipelined());
+
+  std::string topic =
+    "/test/integration/BoundingBoxCameraPlugin_boxesWithBuiltinSDF";
+  WaitForMessageTestHelper<
+    msgs::AnnotatedAxisAligned2DBox_V> helper(topic);
+  WaitForMessageTestHelper<msgs::Image> imageHelper(topic + "_image");
+
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  EXPECT_TRUE(imageHelper.WaitForMessage()) << imageHelper;
+  EXPECT_TRUE(scene->HasSensorName(rgbCameraName));
+
+  // The boxes are the ones of the synchronous update
+  auto boxesMsg = helper.Message();
+  ASSERT_EQ(2, boxesMsg.annotated_box_size());
+  EXPECT_EQ(1u, boxesMsg.annotated_box(0).label());
+  EXPECT_EQ(2u, boxesMsg.annotated_box(1).label());
+  EXPECT_NEAR(159 - 105 / 2.0,
+      boxesMsg.annotated_box(1).box().min_corner().x(), 2.0);
+
+  // The image has the boxes drawn on it
+  auto image = imageHelper.Message();
+  EXPECT_EQ(sensor->ImageWidth(), image.width());
+  EXPECT_EQ(sensor->ImageHeight(), image.height());
+  EXPECT_EQ(image.width() * image.height() * 3u, image.data().size());
+
+  // Disabling waits for the worker
+  sensor->SetPipelined(false);
+  EXPECT_FALSE(sensor->Pipelined());
+  mgr.RunOnce(std::chrono::steady_clock::duration(std::chrono::seconds(1)),
+      true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+
+  // Clean up rendering ptrs
+  camera.reset();
+
+  // Clean up
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+void BoundingBoxCameraSensorTest::VisiblePixels(
+  const std::string &_renderEngine)
+{
+  std::string path = common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "boundingbox_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // Skip unsupported engines
+  if (_renderEngine != "ogre2")
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support bounding box cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  rendering::ScenePtr scene = engine->CreateScene("scene");
+  ASSERT_NE(nullptr, scene);
+  BuildScene2d(scene);
+
+  sensors::Manager mgr;
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  auto *sensor =
+    mgr.CreateSensor<sensors::BoundingBoxCameraSensor>(sdfSensor);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  auto camera = sensor->BoundingBoxCamera();
+  ASSERT_NE(camera, nullptr);
+  camera->SetLocalPosition(0.0, 0.0, 0.0);
+  camera->SetLocalRotation(0.0, 0.0, 0.0);
+  camera->SetBoundingBoxType(rendering::BoundingBoxType::BBT_VISIBLEBOX2D);
+
+  EXPECT_FALSE(sensor->VisiblePixelCounting());
+  sensor->SetVisiblePixelCounting(true);
+  EXPECT_TRUE(sensor->VisiblePixelCounting());
+
+  std::string topic =
+    "/test/integration/BoundingBoxCameraPlugin_boxesWithBuiltinSDF";
+  WaitForMessageTestHelper<
+    msgs::AnnotatedAxisAligned2DBox_V> helper(topic);
+
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  EXPECT_TRUE(scene->HasSensorName(sensor->Name() + "_visibilityCamera"));
+
+  // One count per box in the header
+  auto boxesMsg = helper.Message();
+  const msgs::Header::Map *visiblePixels = nullptr;
+  for (const auto &data : boxesMsg.header().data())
+  {
+    if (data.key() == "visible_pixels")
+      visiblePixels = &data;
+  }
+  ASSERT_NE(nullptr, visiblePixels);
+  ASSERT_EQ(2, boxesMsg.annotated_box_size());
+  ASSERT_EQ(2, visiblePixels->value_size());
+
+  // The box in front fills its bounding box, the one partially occluded
+  // by it only part of its visible bounding box
+  std::vector<double> ratios;
+  for (int i = 0; i < boxesMsg.annotated_box_size(); ++i)
+  {
+    const auto &box = boxesMsg.annotated_box(i).box();
+    const double area =
+        (box.max_corner().x() - box.min_corner().x()) *
+        (box.max_corner().y() - box.min_corner().y());
+    ratios.push_back(std::stod(visiblePixels->value(i)) / area);
+  }
+  EXPECT_EQ(1u, boxesMsg.annotated_box(0).label());
+  EXPECT_GT(ratios[0], 0.0);
+  EXPECT_LE(ratios[0], 1.05);
+  EXPECT_EQ(2u, boxesMsg.annotated_box(1).label());
+  EXPECT_NEAR(1.0, ratios[1], 0.1);
+
+  // Disabling drops the counts and the camera
+  sensor->SetVisiblePixelCounting(false);
+  mgr.RunOnce(std::chrono::steady_clock::duration(std::chrono::seconds(1)),
+      true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  for (const auto &data : helper.Message().header().data())
+    EXPECT_NE("visible_pixels", data.key());
+  EXPECT_FALSE(scene->HasSensorName(sensor->Name() + "_visibilityCamera"));
+
+  // Clean up rendering ptrs
+  camera.reset();
+
+  // Clean up
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
 TEST_P(BoundingBoxCameraSensorTest, BoxesWithBuiltinSDF)
 {
   BoxesWithBuiltinSDF(GetParam());
@@ -492,6 +706,18 @@ TEST_P(BoundingBoxCameraSensorTest, Boxes3DWithBuiltinSDF)
   Boxes3DWithBuiltinSDF(GetParam());
 }
 
+/////////////////////////////////////////////////
+TEST_P(BoundingBoxCameraSensorTest, Pipelined)
+{
+  Pipelined(GetParam());
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoundingBoxCameraSensorTest, VisiblePixels)
+{
+  VisiblePixels(GetParam());
+}
+
 INSTANTIATE_TEST_SUITE_P(BoundingBoxCameraSensor, BoundingBoxCameraSensorTest,
     RENDER_ENGINE_VALUES, rendering::PrintToStringParam());
 
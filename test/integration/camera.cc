@@ -15,17 +15,36 @@
  *
 */
 
+#include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #include <gz/msgs/camera_info.pb.h>
 #include <gz/msgs/image.pb.h>
 #include <gz/common/Image.hh>
 
 #include <gz/common/Console.hh>
 #include <gz/common/Filesystem.hh>
+#include <gz/sensors/CameraGroup.hh>
 #include <gz/sensors/Manager.hh>
 #include <gz/sensors/CameraSensor.hh>
+#include <gz/sensors/RenderingEvents.hh>
+#include <gz/sensors/ScenePlacement.hh>
+#include <gz/sensors/SharedMemoryImage.hh>
+#include <gz/transport/Node.hh>
 #include <gz/rendering/Utils.hh>
 
 // TODO(louise) Remove these pragmas once gz-rendering is disabling the
@@ -94,6 +113,69 @@ class CameraSensorTest: public testing::Test,
 
   // Create camera sensors and verify camera projection
   public: void CameraProjection(const std::string &_renderEngine);
+
+  // Create a camera sensor with asynchronous readback and verify stamps
+  public: void AsyncReadback(const std::string &_renderEngine);
+
+  // Create a camera sensor writing frames to shared memory
+  public: void SharedMemoryOutput(const std::string &_renderEngine);
+
+  // Create a camera sensor publishing compressed images
+  public: void CompressedOutput(const std::string &_renderEngine);
+
+  // Create camera sensors rendered in a single batch
+  public: void RenderBatch(const std::string &_renderEngine);
+
+  // Create a camera sensor publishing a decimated region of interest
+  public: void RegionOfInterest(const std::string &_renderEngine);
+
+  // Create a camera sensor publishing downsampled images
+  public: void DownsampledOutputs(const std::string &_renderEngine);
+
+  // Spread camera sensors over several scenes
+  public: void ScenePlacement(const std::string &_renderEngine);
+
+  // Receive image views instead of messages
+  public: void ImageViewCallback(const std::string &_renderEngine);
+
+  // Publish images converted to other pixel formats
+  public: void ConvertedOutputs(const std::string &_renderEngine);
+
+  // Publish images as tiles
+  public: void TiledOutput(const std::string &_renderEngine);
+
+  // Test motion blur sub-frames
+  public: void MotionBlur(const std::string &_renderEngine);
+
+  // Test rendering at a lower resolution
+  public: void RenderScale(const std::string &_renderEngine);
+
+  // Test reusing frames of a static scene
+  public: void FrameReuse(const std::string &_renderEngine);
+
+  // Test frames left on the GPU
+  public: void GpuFrames(const std::string &_renderEngine);
+
+  // Test batching the images of several cameras
+  public: void Group(const std::string &_renderEngine);
+
+  // Test publishing the camera info on change
+  public: void InfoOnChange(const std::string &_renderEngine);
+
+  // Test reconfiguring the camera in place
+  public: void Reconfigure(const std::string &_renderEngine);
+
+  // Check the optical flow of a moving camera
+  public: void OpticalFlow(const std::string &_renderEngine);
+
+  // Test reusing the image message across frames of different sizes
+  public: void ImageMessageReuse(const std::string &_renderEngine);
+
+  // Test the cached layout of the image message
+  public: void ImageLayout(const std::string &_renderEngine);
+
+  // Test that image noise is applied to every frame of a static scene
+  public: void ImageNoise(const std::string &_renderEngine);
 };
 
 void CameraSensorTest::ImagesWithBuiltinSDF(const std::string &_renderEngine)
@@ -900,5 +982,1761 @@ TEST_P(CameraSensorTest, LInt8LInt16ImagesWithBuiltinSDF)
   ImageFormatLInt8LInt16(GetParam());
 }
 
+//////////////////////////////////////////////////
+void CameraSensorTest::AsyncReadback(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_FALSE(sensor->AsyncReadback());
+  sensor->SetAsyncReadback(true);
+  EXPECT_TRUE(sensor->AsyncReadback());
+
+  std::string topic = "/test/integration/CameraPlugin_imagesWithBuiltinSDF";
+  WaitForMessageTestHelper<gz::msgs::Image> helper(topic);
+  EXPECT_TRUE(sensor->HasConnections());
+
+  // The first update only renders
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_FALSE(helper.WaitForMessage(std::chrono::seconds(1))) << helper;
+
+  // The second update publishes the first frame, with its stamp
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  ASSERT_TRUE(helper.WaitForMessage(std::chrono::seconds(3))) << helper;
+  EXPECT_EQ(1, helper.Message().header().stamp().sec());
+  EXPECT_EQ(256u, helper.Message().width());
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, AsyncReadback)
+{
+  AsyncReadback(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::SharedMemoryOutput(const std::string &_renderEngine)
+{
+#ifndef _WIN32
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_FALSE(sensor->SharedMemoryOutput());
+  EXPECT_FALSE(sensor->HasConnections());
+  sensor->SetSharedMemoryOutput(true, 2u);
+  EXPECT_TRUE(sensor->SharedMemoryOutput());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  std::string topic =
+      "/test/integration/CameraPlugin_imagesWithBuiltinSDF/shm";
+  WaitForMessageTestHelper<gz::msgs::Image> helper(topic);
+
+  // The descriptor topic is advertised with the first frame, so keep
+  // updating until the subscriber is discovered
+  bool received = false;
+  for (int i = 1; i <= 10 && !received; ++i)
+  {
+    mgr.RunOnce(std::chrono::seconds(i), true);
+    received = helper.WaitForMessage(std::chrono::milliseconds(500));
+  }
+  ASSERT_TRUE(received) << helper;
+
+  const gz::msgs::Image &descriptor = helper.Message();
+  EXPECT_TRUE(descriptor.data().empty());
+  EXPECT_EQ(256u, descriptor.width());
+  EXPECT_EQ(257u, descriptor.height());
+
+  std::string name;
+  uint32_t slot = 0u;
+  uint64_t sequence = 0u;
+  for (const auto &entry : descriptor.header().data())
+  {
+    if (entry.key() == "shm_name")
+      name = entry.value(0);
+    else if (entry.key() == "shm_slot")
+      slot = static_cast<uint32_t>(std::stoul(entry.value(0)));
+    else if (entry.key() == "shm_sequence")
+      sequence = std::stoull(entry.value(0));
+  }
+  ASSERT_FALSE(name.empty());
+  EXPECT_GT(2u, slot);
+  EXPECT_EQ(0u, sequence % 2u);
+
+  // Read the frame back from the segment
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  ASSERT_GE(fd, 0);
+  gz::sensors::SharedMemoryImageHeader header;
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(header)),
+      pread(fd, &header, sizeof(header), 0));
+  EXPECT_EQ(gz::sensors::SharedMemoryImageHeader::kMagic, header.magic);
+  EXPECT_EQ(2u, header.slotCount);
+
+  gz::sensors::SharedMemoryImageSlot slotHeader;
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(slotHeader)),
+      pread(fd, &slotHeader, sizeof(slotHeader),
+      static_cast<off_t>(sizeof(header) + slot * header.slotSize)));
+  close(fd);
+  EXPECT_EQ(256u, slotHeader.width);
+  EXPECT_EQ(257u, slotHeader.height);
+  EXPECT_EQ(sequence, slotHeader.sequence.load());
+  EXPECT_EQ(descriptor.header().stamp().sec(), slotHeader.sec);
+  EXPECT_EQ(256u * 257u * 3u, slotHeader.size);
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+#endif
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, SharedMemoryOutput)
+{
+  SharedMemoryOutput(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::CompressedOutput(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_FALSE(sensor->CompressedOutput());
+  EXPECT_TRUE(sensor->SetCompressedOutput(true));
+  EXPECT_TRUE(sensor->CompressedOutput());
+  EXPECT_FALSE(sensor->HasConnections());
+
+  std::string topic =
+      "/test/integration/CameraPlugin_imagesWithBuiltinSDF/compressed";
+  WaitForMessageTestHelper<gz::msgs::Image> helper(topic);
+  EXPECT_TRUE(sensor->HasCompressedConnections());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  // Frames are encoded on a worker thread
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  ASSERT_TRUE(helper.WaitForMessage(std::chrono::seconds(3))) << helper;
+
+  const gz::msgs::Image compressed = helper.Message();
+  EXPECT_EQ(256u, compressed.width());
+  EXPECT_EQ(257u, compressed.height());
+  EXPECT_EQ(1, compressed.header().stamp().sec());
+  bool isPng = false;
+  for (const auto &entry : compressed.header().data())
+  {
+    if (entry.key() == "format")
+      isPng = entry.value(0) == "png";
+  }
+  EXPECT_TRUE(isPng);
+  ASSERT_GT(compressed.data().size(), 8u);
+  EXPECT_EQ(0, compressed.data().compare(1, 3, "PNG"));
+  EXPECT_LT(compressed.data().size(), 256u * 257u * 3u);
+
+  sensor->SetCompressedOutput(false);
+  EXPECT_FALSE(sensor->CompressedOutput());
+  EXPECT_FALSE(sensor->HasCompressedConnections());
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, CompressedOutput)
+{
+  CompressedOutput(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::RenderBatch(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  mgr.SetRenderBatchCallback(&gz::sensors::RenderingSensor::RenderBatch);
+
+  // Two sensors publishing on the same topic
+  gz::sensors::CameraSensor *sensor0 =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor0, nullptr);
+  sensor0->SetScene(scene);
+  gz::sensors::CameraSensor *sensor1 =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor1, nullptr);
+  sensor1->SetScene(scene);
+
+  std::string topic = "/test/integration/CameraPlugin_imagesWithBuiltinSDF";
+  unsigned int count = 0u;
+  std::mutex mutex;
+  gz::transport::Node node;
+  std::function<void(const gz::msgs::Image &)> onImage =
+      [&](const gz::msgs::Image &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(3, _msg.header().stamp().sec());
+        EXPECT_EQ(256u * 257u * 3u, _msg.data().size());
+        ++count;
+      };
+  ASSERT_TRUE(node.Subscribe(topic, onImage));
+  EXPECT_TRUE(sensor0->HasConnections());
+
+  mgr.RunOnce(std::chrono::seconds(3), true);
+  for (int i = 0; i < 30; ++i)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (count >= 2u)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(2u, count);
+  }
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, RenderBatch)
+{
+  RenderBatch(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::RegionOfInterest(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_EQ(1u, sensor->Decimation());
+  EXPECT_FALSE(sensor->SetDecimation(0u));
+
+  gz::msgs::Image image;
+  std::mutex mutex;
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        image = _msg;
+      });
+
+  WaitForMessageTestHelper<gz::msgs::CameraInfo> fullInfoHelper(
+      sensor->InfoTopic());
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  ASSERT_TRUE(fullInfoHelper.WaitForMessage(std::chrono::seconds(3)))
+      << fullInfoHelper;
+  const gz::msgs::CameraInfo fullInfo = fullInfoHelper.Message();
+  gz::msgs::Image full;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    full = image;
+  }
+  ASSERT_EQ(256u, full.width());
+  ASSERT_EQ(257u, full.height());
+
+  // Region extends past the bottom of the image
+  EXPECT_TRUE(sensor->SetRegionOfInterest(16u, 200u, 64u, 100u));
+  EXPECT_TRUE(sensor->SetDecimation(2u));
+  unsigned int x, y, width, height;
+  sensor->RegionOfInterest(x, y, width, height);
+  EXPECT_EQ(16u, x);
+  EXPECT_EQ(200u, y);
+  EXPECT_EQ(64u, width);
+  EXPECT_EQ(100u, height);
+
+  WaitForMessageTestHelper<gz::msgs::CameraInfo> infoHelper(
+      sensor->InfoTopic());
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  ASSERT_TRUE(infoHelper.WaitForMessage(std::chrono::seconds(3)))
+      << infoHelper;
+  gz::msgs::Image region;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    region = image;
+  }
+  EXPECT_EQ(32u, region.width());
+  EXPECT_EQ(29u, region.height());
+  EXPECT_EQ(32u * 3u, region.step());
+  ASSERT_EQ(32u * 29u * 3u, region.data().size());
+  for (unsigned int v = 0; v < region.height(); ++v)
+  {
+    for (unsigned int u = 0; u < region.width(); ++u)
+    {
+      const std::size_t fullIndex =
+          ((200u + 2u * v) * full.width() + 16u + 2u * u) * 3u;
+      const std::size_t index = (v * region.width() + u) * 3u;
+      EXPECT_EQ(0, region.data().compare(index, 3u, full.data(),
+            fullIndex, 3u));
+    }
+  }
+
+  const gz::msgs::CameraInfo info = infoHelper.Message();
+  EXPECT_EQ(32u, info.width());
+  EXPECT_EQ(29u, info.height());
+  ASSERT_EQ(9, info.intrinsics().k_size());
+  EXPECT_DOUBLE_EQ(fullInfo.intrinsics().k(0) / 2.0, info.intrinsics().k(0));
+  EXPECT_DOUBLE_EQ((fullInfo.intrinsics().k(2) - 16.0) / 2.0,
+      info.intrinsics().k(2));
+  EXPECT_DOUBLE_EQ(fullInfo.intrinsics().k(4) / 2.0, info.intrinsics().k(4));
+  EXPECT_DOUBLE_EQ((fullInfo.intrinsics().k(5) - 200.0) / 2.0,
+      info.intrinsics().k(5));
+  ASSERT_EQ(12, info.projection().p_size());
+  EXPECT_DOUBLE_EQ((fullInfo.projection().p(2) - 16.0) / 2.0,
+      info.projection().p(2));
+
+  // Back to full images
+  EXPECT_TRUE(sensor->SetRegionOfInterest(0u, 0u, 0u, 0u));
+  EXPECT_TRUE(sensor->SetDecimation(1u));
+  mgr.RunOnce(std::chrono::seconds(3), true);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(256u, image.width());
+    EXPECT_EQ(257u, image.height());
+  }
+
+  // Clean up
+  connection.reset();
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, RegionOfInterest)
+{
+  RegionOfInterest(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::DownsampledOutputs(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  EXPECT_FALSE(sensor->AddDownsampledOutput(1u));
+  EXPECT_TRUE(sensor->AddDownsampledOutput(4u));
+  EXPECT_TRUE(sensor->AddDownsampledOutput(2u));
+  EXPECT_TRUE(sensor->AddDownsampledOutput(2u));
+  EXPECT_TRUE(sensor->DownsampledTopic(3u).empty());
+  const std::string topic =
+      "/test/integration/CameraPlugin_imagesWithBuiltinSDF";
+  EXPECT_EQ(topic + "/downsampled_2", sensor->DownsampledTopic(2u));
+  EXPECT_EQ(topic + "/downsampled_4", sensor->DownsampledTopic(4u));
+
+  // Outputs are lazy
+  EXPECT_FALSE(sensor->HasDownsampledConnections());
+  EXPECT_FALSE(sensor->HasConnections());
+
+  WaitForMessageTestHelper<gz::msgs::Image> fullHelper(topic);
+  WaitForMessageTestHelper<gz::msgs::Image> halfHelper(
+      sensor->DownsampledTopic(2u));
+  WaitForMessageTestHelper<gz::msgs::Image> quarterHelper(
+      sensor->DownsampledTopic(4u));
+  EXPECT_TRUE(sensor->HasDownsampledConnections());
+
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  ASSERT_TRUE(fullHelper.WaitForMessage(std::chrono::seconds(3)))
+      << fullHelper;
+  ASSERT_TRUE(halfHelper.WaitForMessage(std::chrono::seconds(3)))
+      << halfHelper;
+  ASSERT_TRUE(quarterHelper.WaitForMessage(std::chrono::seconds(3)))
+      << quarterHelper;
+
+  const gz::msgs::Image full = fullHelper.Message();
+  const gz::msgs::Image half = halfHelper.Message();
+  const gz::msgs::Image quarter = quarterHelper.Message();
+  EXPECT_EQ(128u, half.width());
+  EXPECT_EQ(128u, half.height());
+  EXPECT_EQ(128u * 3u, half.step());
+  EXPECT_EQ(128u * 128u * 3u, half.data().size());
+  EXPECT_EQ(64u, quarter.width());
+  EXPECT_EQ(64u, quarter.height());
+  EXPECT_EQ(64u * 64u * 3u, quarter.data().size());
+  EXPECT_EQ(full.pixel_format_type(), half.pixel_format_type());
+  EXPECT_EQ(full.header().stamp().sec(), quarter.header().stamp().sec());
+
+  // The empty scene renders a uniform background
+  ASSERT_GE(full.data().size(), 3u);
+  EXPECT_EQ(0, quarter.data().compare(0, 3, full.data(), 0, 3));
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, DownsampledOutputs)
+{
+  DownsampledOutputs(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::ScenePlacement(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene0 = engine->CreateScene("scene0");
+  gz::rendering::ScenePtr scene1 = engine->CreateScene("scene1");
+
+  gz::sensors::ScenePlacement placement;
+  EXPECT_TRUE(placement.Assign({}).empty());
+  EXPECT_EQ(0u, placement.AddScene(scene0));
+  EXPECT_EQ(1u, placement.AddScene(scene1));
+  EXPECT_EQ(2u, placement.SceneCount());
+  EXPECT_EQ(scene1, placement.SceneByIndex(1));
+  EXPECT_EQ(nullptr, placement.SceneByIndex(2));
+
+  // One fast camera and three slow ones
+  gz::sensors::Manager mgr;
+  std::vector<gz::sensors::RenderingSensor *> sensors;
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  for (int i = 0; i < 4; ++i)
+  {
+    sdfSensor.SetName("camera" + std::to_string(i));
+    sdfSensor.SetTopic("/test/integration/ScenePlacement" +
+        std::to_string(i));
+    auto *sensor = mgr.CreateSensor<gz::sensors::CameraSensor>(sdfSensor);
+    ASSERT_NE(nullptr, sensor);
+    sensor->SetUpdateRate(i == 0 ? 30.0 : 10.0);
+    sensor->SetScene(scene0);
+    sensors.push_back(sensor);
+  }
+  EXPECT_EQ(256u * 257u, sensors[0]->PixelCount());
+  EXPECT_DOUBLE_EQ(256.0 * 257.0 * 30.0,
+      gz::sensors::ScenePlacement::DefaultCost(*sensors[0]));
+
+  // The fast camera is as costly as the three slow ones
+  auto assigned = placement.Assign(sensors);
+  EXPECT_EQ((std::vector<std::size_t>{0u, 1u, 1u, 1u}), assigned);
+  EXPECT_DOUBLE_EQ(placement.SceneLoad(0), placement.SceneLoad(1));
+  EXPECT_EQ(scene0, sensors[0]->Scene());
+  EXPECT_EQ(scene1, sensors[3]->Scene());
+
+  // Pinned sensors go first
+  placement.Pin("camera3", 0u);
+  assigned = placement.Assign(sensors);
+  EXPECT_EQ((std::vector<std::size_t>{1u, 0u, 0u, 0u}), assigned);
+  EXPECT_DOUBLE_EQ(placement.SceneLoad(0), placement.SceneLoad(1));
+  EXPECT_EQ(scene1, sensors[0]->Scene());
+  EXPECT_EQ(scene0, sensors[3]->Scene());
+
+  // Custom cost
+  placement.Unpin("camera3");
+  placement.SetCostFunction([](const gz::sensors::RenderingSensor &)
+  {
+    return 1.0;
+  });
+  assigned = placement.Assign(sensors);
+  EXPECT_EQ((std::vector<std::size_t>{0u, 1u, 0u, 1u}), assigned);
+  EXPECT_DOUBLE_EQ(2.0, placement.SceneLoad(0));
+  EXPECT_DOUBLE_EQ(2.0, placement.SceneLoad(1));
+
+  // Clean up
+  engine->DestroyScene(scene1);
+  engine->DestroyScene(scene0);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, ScenePlacement)
+{
+  ScenePlacement(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::ImageViewCallback(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_FALSE(sensor->HasImageConnections());
+
+  std::vector<unsigned char> pixels;
+  gz::sensors::ImageView received;
+  unsigned int count = 0;
+  auto connection = sensor->ConnectImageViewCallback(
+      [&](const gz::sensors::ImageView &_view)
+      {
+        received = _view;
+        pixels.assign(_view.data, _view.data + _view.size);
+        ++count;
+      });
+  EXPECT_TRUE(sensor->HasImageConnections());
+
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_EQ(1u, count);
+  EXPECT_EQ(std::chrono::steady_clock::duration(std::chrono::seconds(1)),
+      received.time);
+  EXPECT_EQ(256u, received.width);
+  EXPECT_EQ(257u, received.height);
+  EXPECT_EQ(gz::common::Image::RGB_INT8, received.format);
+  EXPECT_EQ(256u * 257u * 3u, pixels.size());
+
+  // The same pixels go in the message when there's one
+  gz::msgs::Image image;
+  auto imageConnection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        image = _msg;
+      });
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  EXPECT_EQ(2u, count);
+  ASSERT_EQ(pixels.size(), image.data().size());
+  EXPECT_EQ(0, std::memcmp(pixels.data(), image.data().data(),
+      pixels.size()));
+
+  connection.reset();
+  imageConnection.reset();
+  mgr.RunOnce(std::chrono::seconds(3), true);
+  EXPECT_EQ(2u, count);
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, ImageViewCallback)
+{
+  ImageViewCallback(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::ConvertedOutputs(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  using gz::sensors::ConvertedPixelFormat;
+  EXPECT_TRUE(sensor->ConvertedTopic(ConvertedPixelFormat::NV12).empty());
+  EXPECT_TRUE(sensor->AddConvertedOutput(ConvertedPixelFormat::MONO8));
+  EXPECT_TRUE(sensor->AddConvertedOutput(ConvertedPixelFormat::NV12));
+  EXPECT_TRUE(sensor->AddConvertedOutput(ConvertedPixelFormat::NV12));
+  EXPECT_EQ(sensor->Topic() + "/nv12",
+      sensor->ConvertedTopic(ConvertedPixelFormat::NV12));
+  EXPECT_FALSE(sensor->HasConvertedConnections());
+
+  WaitForMessageTestHelper<gz::msgs::Image> monoHelper(
+      sensor->ConvertedTopic(ConvertedPixelFormat::MONO8));
+  WaitForMessageTestHelper<gz::msgs::Image> nv12Helper(
+      sensor->ConvertedTopic(ConvertedPixelFormat::NV12));
+  EXPECT_TRUE(sensor->HasConvertedConnections());
+  EXPECT_TRUE(sensor->HasImageConnections());
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  ASSERT_TRUE(monoHelper.WaitForMessage(std::chrono::seconds(3)))
+      << monoHelper;
+  ASSERT_TRUE(nv12Helper.WaitForMessage(std::chrono::seconds(3)))
+      << nv12Helper;
+
+  // 256x257 image, the last row is dropped from NV12
+  const gz::msgs::Image mono = monoHelper.Message();
+  EXPECT_EQ(gz::msgs::PixelFormatType::L_INT8, mono.pixel_format_type());
+  EXPECT_EQ(256u, mono.width());
+  EXPECT_EQ(257u, mono.height());
+  EXPECT_EQ(256u * 257u, mono.data().size());
+
+  const gz::msgs::Image nv12 = nv12Helper.Message();
+  EXPECT_EQ(256u, nv12.width());
+  EXPECT_EQ(256u, nv12.height());
+  EXPECT_EQ(256u, nv12.step());
+  EXPECT_EQ(256u * 256u * 3u / 2u, nv12.data().size());
+  bool hasFormat = false;
+  for (const auto &entry : nv12.header().data())
+  {
+    if (entry.key() == "format")
+    {
+      ASSERT_EQ(1, entry.value_size());
+      EXPECT_EQ("nv12", entry.value(0));
+      hasFormat = true;
+    }
+  }
+  EXPECT_TRUE(hasFormat);
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, ConvertedOutputs)
+{
+  ConvertedOutputs(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::TiledOutput(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_EQ(0u, sensor->TiledOutputRows());
+  EXPECT_TRUE(sensor->TiledTopic().empty());
+  EXPECT_TRUE(sensor->SetTiledOutput(100u));
+  EXPECT_EQ(100u, sensor->TiledOutputRows());
+  EXPECT_EQ(sensor->Topic() + "/tiles", sensor->TiledTopic());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<gz::msgs::Image> tiles;
+  std::function<void(const gz::msgs::Image &)> callback =
+      [&](const gz::msgs::Image &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        tiles.push_back(_msg);
+        cv.notify_all();
+      };
+  gz::transport::Node node;
+  ASSERT_TRUE(node.Subscribe(sensor->TiledTopic(), callback));
+  EXPECT_TRUE(sensor->HasTiledConnections());
+
+  gz::msgs::Image image;
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        image = _msg;
+      });
+  mgr.RunOnce(std::chrono::seconds(1), true);
+
+  // 257 rows in tiles of 100
+  std::unique_lock<std::mutex> lock(mutex);
+  ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(3),
+      [&] { return tiles.size() >= 3u; }));
+  ASSERT_EQ(3u, tiles.size());
+  const unsigned int heights[] = {100u, 100u, 57u};
+  std::string pixels;
+  for (unsigned int i = 0u; i < 3u; ++i)
+  {
+    const auto &tile = tiles[i];
+    EXPECT_EQ(256u, tile.width());
+    EXPECT_EQ(heights[i], tile.height());
+    EXPECT_EQ(image.step(), tile.step());
+    EXPECT_EQ(image.pixel_format_type(), tile.pixel_format_type());
+    std::map<std::string, std::string> entries;
+    for (const auto &entry : tile.header().data())
+      entries[entry.key()] = entry.value(0);
+    EXPECT_EQ("0", entries["frame"]);
+    EXPECT_EQ(std::to_string(i), entries["tile"]);
+    EXPECT_EQ("3", entries["tile_count"]);
+    EXPECT_EQ(std::to_string(i * 100u), entries["row"]);
+    pixels += tile.data();
+  }
+  EXPECT_EQ(image.data(), pixels);
+  lock.unlock();
+
+  // Disabled
+  EXPECT_TRUE(sensor->SetTiledOutput(0u));
+  EXPECT_FALSE(sensor->HasTiledConnections());
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, TiledOutput)
+{
+  TiledOutput(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::MotionBlur(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_DOUBLE_EQ(0.0, sensor->MotionBlurExposure());
+  sensor->SetMotionBlur(0.5, 8u);
+  EXPECT_DOUBLE_EQ(0.5, sensor->MotionBlurExposure());
+  EXPECT_EQ(8u, sensor->MotionBlurMaxSubFrames());
+
+  unsigned int images{0u};
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &)
+      {
+        ++images;
+      });
+
+  // A static camera renders a single frame
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  EXPECT_EQ(2u, images);
+  EXPECT_EQ(1u, sensor->LastSubFrameCount());
+
+  // A fast rotation renders the most sub-frames
+  sensor->SetPose(gz::math::Pose3d(0, 0, 0, 0, 0, 0.5));
+  mgr.RunOnce(std::chrono::seconds(3), true);
+  EXPECT_EQ(3u, images);
+  EXPECT_EQ(8u, sensor->LastSubFrameCount());
+
+  // A slow one fewer
+  sensor->SetPose(gz::math::Pose3d(0, 0, 0, 0, 0, 0.53));
+  mgr.RunOnce(std::chrono::seconds(4), true);
+  EXPECT_LT(1u, sensor->LastSubFrameCount());
+  EXPECT_GT(8u, sensor->LastSubFrameCount());
+
+  // Static again
+  mgr.RunOnce(std::chrono::seconds(5), true);
+  EXPECT_EQ(1u, sensor->LastSubFrameCount());
+
+  // Disabled
+  sensor->SetMotionBlur(0.0, 8u);
+  sensor->SetPose(gz::math::Pose3d(0, 0, 0, 0, 0, 0.0));
+  mgr.RunOnce(std::chrono::seconds(6), true);
+  EXPECT_EQ(1u, sensor->LastSubFrameCount());
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, MotionBlur)
+{
+  MotionBlur(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::RenderScale(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_DOUBLE_EQ(1.0, sensor->RenderScale());
+  EXPECT_FALSE(sensor->SetRenderScale(0.0));
+  EXPECT_FALSE(sensor->SetRenderScale(1.5));
+  EXPECT_DOUBLE_EQ(1.0, sensor->RenderScale());
+
+  gz::msgs::Image image;
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        image = _msg;
+      });
+
+  // Rendered at half the resolution, published at full resolution
+  EXPECT_TRUE(sensor->SetRenderScale(0.5));
+  EXPECT_DOUBLE_EQ(0.5, sensor->RenderScale());
+  EXPECT_EQ(128u, sensor->RenderingCamera()->ImageWidth());
+  EXPECT_EQ(256u, sensor->ImageWidth());
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_EQ(256u, image.width());
+  EXPECT_EQ(sensor->ImageHeight(), image.height());
+  EXPECT_EQ(image.step() * image.height(), image.data().size());
+
+  // Back to full resolution
+  EXPECT_TRUE(sensor->SetRenderScale(1.0));
+  EXPECT_EQ(256u, sensor->RenderingCamera()->ImageWidth());
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  EXPECT_EQ(256u, image.width());
+  EXPECT_EQ(sensor->ImageHeight(), image.height());
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, RenderScale)
+{
+  RenderScale(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::FrameReuse(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_FALSE(sensor->FrameReuse());
+  sensor->SetFrameReuse(true);
+  EXPECT_TRUE(sensor->FrameReuse());
+
+  std::vector<gz::msgs::Image> images;
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        images.push_back(_msg);
+      });
+
+  // The second frame is the first one with a new stamp
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  ASSERT_EQ(2u, images.size());
+  EXPECT_EQ(1u, sensor->ReusedFrameCount());
+  EXPECT_EQ(images[0].data(), images[1].data());
+  EXPECT_EQ(2, images[1].header().stamp().sec());
+
+  // A change of the scene content renders again
+  gz::sensors::RenderingEvents::NotifySceneContentChanged();
+  mgr.RunOnce(std::chrono::seconds(3), true);
+  EXPECT_EQ(1u, sensor->ReusedFrameCount());
+
+  // So does a new pose
+  sensor->SetPose(gz::math::Pose3d(0, 0, 1, 0, 0, 0));
+  mgr.RunOnce(std::chrono::seconds(4), true);
+  EXPECT_EQ(1u, sensor->ReusedFrameCount());
+  mgr.RunOnce(std::chrono::seconds(5), true);
+  EXPECT_EQ(2u, sensor->ReusedFrameCount());
+  EXPECT_EQ(5u, images.size());
+
+  // Disabled
+  sensor->SetFrameReuse(false);
+  mgr.RunOnce(std::chrono::seconds(6), true);
+  mgr.RunOnce(std::chrono::seconds(7), true);
+  EXPECT_EQ(2u, sensor->ReusedFrameCount());
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, FrameReuse)
+{
+  FrameReuse(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::GpuFrames(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_FALSE(sensor->HasConnections());
+
+  std::vector<gz::sensors::GpuFrame> frames;
+  auto connection = sensor->ConnectGpuFrameCallback(
+      [&](const gz::sensors::GpuFrame &_frame)
+      {
+        frames.push_back(_frame);
+      });
+  EXPECT_TRUE(sensor->HasConnections());
+  EXPECT_FALSE(sensor->HasImageConnections());
+
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  ASSERT_EQ(2u, frames.size());
+  for (uint64_t i = 0u; i < frames.size(); ++i)
+  {
+    EXPECT_EQ(i, frames[i].sequence);
+    EXPECT_EQ(std::chrono::seconds(i + 1), frames[i].time);
+    EXPECT_EQ(256u, frames[i].width);
+    EXPECT_EQ(sensor->ImageHeight(), frames[i].height);
+    EXPECT_EQ(gz::rendering::PF_R8G8B8, frames[i].format);
+  }
+
+  // Along with images
+  unsigned int images{0u};
+  auto imageConnection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &)
+      {
+        ++images;
+      });
+  mgr.RunOnce(std::chrono::seconds(3), true);
+  EXPECT_EQ(3u, frames.size());
+  EXPECT_EQ(1u, images);
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, GpuFrames)
+{
+  GpuFrames(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::Group(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  std::vector<gz::sensors::CameraSensor *> sensors;
+  for (int i = 0; i < 3; ++i)
+  {
+    sdf::ElementPtr element = sensorPtr->Clone();
+    element->GetAttribute("name")->Set("camera_" + std::to_string(i));
+    auto *sensor = mgr.CreateSensor<gz::sensors::CameraSensor>(element);
+    ASSERT_NE(sensor, nullptr);
+    sensor->SetScene(scene);
+    sensors.push_back(sensor);
+  }
+
+  gz::sensors::CameraGroup group;
+  EXPECT_FALSE(group.AddCamera(nullptr));
+  for (auto *sensor : sensors)
+    EXPECT_TRUE(group.AddCamera(sensor));
+  EXPECT_FALSE(group.AddCamera(sensors[0]));
+  EXPECT_EQ(3u, group.CameraCount());
+  EXPECT_TRUE(group.SetTopic("/camera_group"));
+  EXPECT_EQ("/camera_group", group.Topic());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  gz::msgs::Image msg;
+  bool received{false};
+  std::function<void(const gz::msgs::Image &)> callback =
+      [&](const gz::msgs::Image &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        msg = _msg;
+        received = true;
+        cv.notify_all();
+      };
+  gz::transport::Node node;
+  ASSERT_TRUE(node.Subscribe(group.Topic(), callback));
+
+  std::vector<gz::sensors::CameraBatch> batches;
+  std::vector<unsigned char> pixels;
+  auto connection = group.ConnectBatchCallback(
+      [&](const gz::sensors::CameraBatch &_batch)
+      {
+        batches.push_back(_batch);
+        pixels.assign(_batch.data, _batch.data + _batch.size);
+      });
+
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  ASSERT_EQ(1u, batches.size());
+  EXPECT_EQ(1u, group.BatchCount());
+  const auto &batch = batches.front();
+  EXPECT_EQ(std::chrono::seconds(1), batch.time);
+  EXPECT_EQ(3u, batch.count);
+  EXPECT_EQ(256u, batch.width);
+  EXPECT_EQ(sensors[0]->ImageHeight(), batch.height);
+  EXPECT_EQ(gz::common::Image::RGB_INT8, batch.format);
+  EXPECT_EQ(3u * 3u * batch.width * batch.height, batch.size);
+  EXPECT_EQ(batch.size, pixels.size());
+
+  // One message for the whole batch
+  std::unique_lock<std::mutex> lock(mutex);
+  ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(3),
+      [&] { return received; }));
+  EXPECT_EQ(256u, msg.width());
+  EXPECT_EQ(3u * sensors[0]->ImageHeight(), msg.height());
+  EXPECT_EQ(256u * 3u, msg.step());
+  ASSERT_EQ(pixels.size(), msg.data().size());
+  EXPECT_EQ(0, std::memcmp(pixels.data(), msg.data().data(),
+      pixels.size()));
+  ASSERT_EQ(1, msg.header().data_size());
+  EXPECT_EQ("batch_size", msg.header().data(0).key());
+  EXPECT_EQ("3", msg.header().data(0).value(0));
+  lock.unlock();
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, Group)
+{
+  Group(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::InfoOnChange(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_FALSE(sensor->InfoOnChange());
+  EXPECT_EQ(std::chrono::seconds(1), sensor->InfoHeartbeat());
+  sensor->SetInfoOnChange(true);
+  EXPECT_TRUE(sensor->InfoOnChange());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  unsigned int infoCount = 0u;
+  gz::msgs::CameraInfo info;
+  std::function<void(const gz::msgs::CameraInfo &)> onInfo =
+      [&](const gz::msgs::CameraInfo &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        info = _msg;
+        ++infoCount;
+        cv.notify_all();
+      };
+  gz::transport::Node node;
+  ASSERT_TRUE(node.Subscribe(sensor->InfoTopic(), onInfo));
+  for (int sleep = 0; sleep < 30 && !sensor->HasInfoConnections(); ++sleep)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_TRUE(sensor->HasInfoConnections());
+
+  auto waitForCount = [&](unsigned int _count)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait_for(lock, std::chrono::seconds(3),
+        [&] { return infoCount >= _count; });
+    // Leave time for unexpected messages to arrive
+    lock.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    lock.lock();
+    return infoCount;
+  };
+
+  // Published for the first subscriber, then not until it changes
+  for (int i = 0; i < 6; ++i)
+    mgr.RunOnce(std::chrono::milliseconds(1000 + i * 100), true);
+  EXPECT_EQ(1u, waitForCount(1u));
+
+  EXPECT_TRUE(sensor->SetDecimation(2u));
+  mgr.RunOnce(std::chrono::milliseconds(1600), true);
+  EXPECT_EQ(2u, waitForCount(2u));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(128u, info.width());
+  }
+
+  // Republished on the heartbeat
+  mgr.RunOnce(std::chrono::milliseconds(2500), true);
+  EXPECT_EQ(2u, waitForCount(2u));
+  mgr.RunOnce(std::chrono::milliseconds(2600), true);
+  EXPECT_EQ(3u, waitForCount(3u));
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, InfoOnChange)
+{
+  InfoOnChange(GetParam());
+}
+
+//////////////////////////////////////////////////
+void CameraSensorTest::Reconfigure(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  gz::rendering::CameraPtr camera = sensor->RenderingCamera();
+  ASSERT_NE(nullptr, camera);
+
+  gz::msgs::Image image;
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        image = _msg;
+      });
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_EQ(256u, image.width());
+
+  // Half the resolution, same rendering camera
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  sdf::Camera cameraSdf = *sdfSensor.CameraSensor();
+  cameraSdf.SetImageWidth(128u);
+  cameraSdf.SetImageHeight(cameraSdf.ImageHeight() / 2u);
+  sdfSensor.SetCameraSensor(cameraSdf);
+  ASSERT_TRUE(sensor->Reconfigure(sdfSensor));
+  EXPECT_EQ(camera, sensor->RenderingCamera());
+  EXPECT_EQ(128u, sensor->ImageWidth());
+  EXPECT_EQ(cameraSdf.ImageHeight(), sensor->ImageHeight());
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  EXPECT_EQ(128u, image.width());
+  EXPECT_EQ(cameraSdf.ImageHeight(), image.height());
+  EXPECT_EQ(image.step() * image.height(), image.data().size());
+
+  // A render scale is kept
+  EXPECT_TRUE(sensor->SetRenderScale(0.5));
+  cameraSdf.SetImageWidth(256u);
+  cameraSdf.SetImageHeight(cameraSdf.ImageHeight() * 2u);
+  sdfSensor.SetCameraSensor(cameraSdf);
+  ASSERT_TRUE(sensor->Reconfigure(sdfSensor));
+  EXPECT_EQ(128u, camera->ImageWidth());
+  mgr.RunOnce(std::chrono::seconds(3), true);
+  EXPECT_EQ(256u, image.width());
+
+  // The pixel format can't be changed in place
+  cameraSdf.SetPixelFormat(sdf::PixelFormatType::L_INT8);
+  sdfSensor.SetCameraSensor(cameraSdf);
+  EXPECT_FALSE(sensor->Reconfigure(sdfSensor));
+  EXPECT_EQ(256u, sensor->ImageWidth());
+
+  // Clean up
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, Reconfigure)
+{
+  Reconfigure(GetParam());
+}
+
+/////////////////////////////////////////////////
+void CameraSensorTest::OpticalFlow(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support depth cameras" << std::endl;
+    return;
+  }
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  box->SetLocalScale(1.0, 10.0, 10.0);
+  scene->RootVisual()->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+  EXPECT_FALSE(sensor->HasOpticalFlowConnections());
+
+  WaitForMessageTestHelper<gz::msgs::Image> helper(
+      "/test/integration/CameraPlugin_imagesWithBuiltinSDF/optical_flow");
+  EXPECT_TRUE(sensor->HasOpticalFlowConnections());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  // The first frame only has a pose to start from
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_FALSE(helper.WaitForMessage(std::chrono::milliseconds(100)));
+
+  // Moving left shifts the wall right
+  const double b = 0.1;
+  sensor->SetPose(gz::math::Pose3d(0, b, 0, 0, 0, 0));
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  ASSERT_TRUE(helper.WaitForMessage(std::chrono::seconds(5))) << helper;
+  auto msg = helper.Message();
+  EXPECT_EQ(gz::msgs::PixelFormatType::RGB_FLOAT32, msg.pixel_format_type());
+  EXPECT_EQ(sensor->ImageWidth(), msg.width());
+  EXPECT_EQ(sensor->ImageHeight(), msg.height());
+  ASSERT_EQ(static_cast<std::size_t>(msg.width()) * msg.height() * 3u *
+      sizeof(float), msg.data().size());
+
+  const std::size_t center =
+      msg.height() / 2u * msg.width() + msg.width() / 2u;
+  float flow[3];
+  memcpy(flow, msg.data().data() + center * sizeof(flow), sizeof(flow));
+  EXPECT_NEAR(2.5, flow[2], 0.05);
+  const double focal = msg.width() * 0.5 /
+      std::tan(sensor->RenderingCamera()->HFOV().Radian() * 0.5);
+  EXPECT_NEAR(focal * b / flow[2], flow[0], 0.05 * focal * b / flow[2]);
+  EXPECT_NEAR(0.0, flow[1], 0.05);
+
+  // Clean up
+  box.reset();
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, OpticalFlow)
+{
+  OpticalFlow(GetParam());
+}
+
+/////////////////////////////////////////////////
+void CameraSensorTest::ImageMessageReuse(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  WaitForMessageTestHelper<gz::msgs::Image> helper(
+      "/test/integration/CameraPlugin_imagesWithBuiltinSDF");
+
+  // Each message has the size of its own frame and a single frame_id and
+  // seq entry, however many frames the message was reused for
+  int frame = 0;
+  auto checkFrame = [&](unsigned int _width, unsigned int _height)
+  {
+    mgr.RunOnce(std::chrono::seconds(++frame), true);
+    ASSERT_TRUE(helper.WaitForMessage(std::chrono::seconds(5))) << helper;
+    const auto msg = helper.Message();
+    EXPECT_EQ(_width, msg.width());
+    EXPECT_EQ(_height, msg.height());
+    EXPECT_EQ(_width * 3u, msg.step());
+    EXPECT_EQ(static_cast<std::size_t>(msg.step()) * msg.height(),
+        msg.data().size());
+    ASSERT_EQ(2, msg.header().data_size());
+    EXPECT_EQ("frame_id", msg.header().data(0).key());
+    ASSERT_EQ(1, msg.header().data(0).value_size());
+    EXPECT_EQ(sensor->OpticalFrameId(), msg.header().data(0).value(0));
+    EXPECT_EQ("seq", msg.header().data(1).key());
+    ASSERT_EQ(1, msg.header().data(1).value_size());
+    EXPECT_EQ(std::to_string(frame - 1), msg.header().data(1).value(0));
+  };
+  checkFrame(256u, 257u);
+  checkFrame(256u, 257u);
+
+  // A smaller frame shrinks the reused buffer, a larger one grows it
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  sdf::Camera cameraSdf = *sdfSensor.CameraSensor();
+  cameraSdf.SetImageWidth(128u);
+  cameraSdf.SetImageHeight(64u);
+  sdfSensor.SetCameraSensor(cameraSdf);
+  ASSERT_TRUE(sensor->Reconfigure(sdfSensor));
+  checkFrame(128u, 64u);
+
+  cameraSdf.SetImageWidth(320u);
+  cameraSdf.SetImageHeight(240u);
+  sdfSensor.SetCameraSensor(cameraSdf);
+  ASSERT_TRUE(sensor->Reconfigure(sdfSensor));
+  checkFrame(320u, 240u);
+  checkFrame(320u, 240u);
+
+  // Clean up
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, ImageMessageReuse)
+{
+  ImageMessageReuse(GetParam());
+}
+
+/////////////////////////////////////////////////
+void CameraSensorTest::ImageLayout(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  // An 8 bit grayscale camera, one byte per pixel
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  sdf::Camera cameraSdf = *sdfSensor.CameraSensor();
+  cameraSdf.SetPixelFormat(sdf::PixelFormatType::L_INT8);
+  sdfSensor.SetCameraSensor(cameraSdf);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sdfSensor);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  gz::msgs::Image image;
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        image = _msg;
+      });
+
+  int frame = 0;
+  auto checkFrame = [&](unsigned int _width, unsigned int _height)
+  {
+    image.Clear();
+    mgr.RunOnce(std::chrono::seconds(++frame), true);
+    EXPECT_EQ(gz::msgs::PixelFormatType::L_INT8, image.pixel_format_type());
+    EXPECT_EQ(_width, image.width());
+    EXPECT_EQ(_height, image.height());
+    EXPECT_EQ(_width, image.step());
+    EXPECT_EQ(static_cast<std::size_t>(_width) * _height,
+        image.data().size());
+  };
+  checkFrame(256u, 257u);
+  checkFrame(256u, 257u);
+
+  // Rendering at a lower resolution keeps the published layout
+  ASSERT_TRUE(sensor->SetRenderScale(0.5));
+  checkFrame(256u, 257u);
+  ASSERT_TRUE(sensor->SetRenderScale(1.0));
+  checkFrame(256u, 257u);
+
+  // A new image size refreshes the layout
+  cameraSdf.SetImageWidth(100u);
+  cameraSdf.SetImageHeight(50u);
+  sdfSensor.SetCameraSensor(cameraSdf);
+  ASSERT_TRUE(sensor->Reconfigure(sdfSensor));
+  checkFrame(100u, 50u);
+  checkFrame(100u, 50u);
+
+  // Clean up
+  connection.reset();
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, ImageLayout)
+{
+  ImageLayout(GetParam());
+}
+
+/////////////////////////////////////////////////
+void CameraSensorTest::ImageNoise(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  // An empty scene with a mid gray background, so noise isn't clamped
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  scene->SetBackgroundColor(0.5, 0.5, 0.5);
+
+  // Noise is applied by a render pass, or on the CPU if the engine has
+  // none
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  sdf::Camera cameraSdf = *sdfSensor.CameraSensor();
+  constexpr double stdDev = 0.05;
+  sdf::Noise noise;
+  noise.SetType(sdf::NoiseType::GAUSSIAN);
+  noise.SetMean(0.0);
+  noise.SetStdDev(stdDev);
+  cameraSdf.SetImageNoise(noise);
+  sdfSensor.SetCameraSensor(cameraSdf);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::CameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::CameraSensor>(sdfSensor);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  std::vector<gz::msgs::Image> images;
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        images.push_back(_msg);
+      });
+
+  // Nothing changes between the frames, only the noise
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  ASSERT_EQ(2u, images.size());
+  const std::string &a = images[0].data();
+  const std::string &b = images[1].data();
+  ASSERT_EQ(a.size(), b.size());
+  ASSERT_FALSE(a.empty());
+  EXPECT_NE(a, b);
+
+  // Frames have independent noise, so their difference has sqrt(2) times
+  // the noise standard deviation
+  double sumSquares = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+  {
+    const double d = static_cast<double>(static_cast<unsigned char>(a[i])) -
+        static_cast<unsigned char>(b[i]);
+    sumSquares += d * d;
+  }
+  const double rms = std::sqrt(sumSquares / a.size());
+  const double expectedRms = std::sqrt(2.0) * stdDev * 255.0;
+  EXPECT_GT(rms, 0.5 * expectedRms);
+  EXPECT_LT(rms, 1.5 * expectedRms);
+
+  // Clean up
+  connection.reset();
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(CameraSensorTest, ImageNoise)
+{
+  ImageNoise(GetParam());
+}
+
 INSTANTIATE_TEST_SUITE_P(CameraSensor, CameraSensorTest,
     RENDER_ENGINE_VALUES, gz::rendering::PrintToStringParam());
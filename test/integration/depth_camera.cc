@@ -15,7 +15,12 @@
  *
 */
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include <gz/msgs/camera_info.pb.h>
@@ -154,6 +159,24 @@ class DepthCameraSensorTest: public testing::Test,
   }
   // Create a Camera sensor from a SDF and gets a image message
   public: void ImagesWithBuiltinSDF(const std::string &_renderEngine);
+
+  // Check the 16 bit millimeter depth images
+  public: void MillimeterDepth(const std::string &_renderEngine);
+
+  // Check that frames used in place match the copied frames
+  public: void ZeroCopyFrames(const std::string &_renderEngine);
+
+  // Check the point clouds published in the GPU layout
+  public: void PointCloudGpuLayout(const std::string &_renderEngine);
+
+  // Check the surface normals estimated from the point clouds
+  public: void SurfaceNormals(const std::string &_renderEngine);
+
+  // Check the elevation maps binned from the point clouds
+  public: void ElevationMap(const std::string &_renderEngine);
+
+  // Check that image noise is added to the depths
+  public: void ImageNoise(const std::string &_renderEngine);
 };
 
 void DepthCameraSensorTest::ImagesWithBuiltinSDF(
@@ -497,6 +520,30 @@ void DepthCameraSensorTest::ImagesWithBuiltinSDF(
   g_mutex.unlock();
   g_pcMutex.unlock();
 
+  // With a fixed image range, the shade of the points depends on their
+  // distance to the clip planes instead of the largest depth of the frame
+  EXPECT_FALSE(depthSensor->FixedImageRange());
+  depthSensor->SetFixedImageRange(true);
+  EXPECT_TRUE(depthSensor->FixedImageRange());
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  for (int sleep = 0; sleep < 300 && pcCounter == 0; ++sleep)
+  {
+    g_pcMutex.lock();
+    pcCounter = g_pcCounter;
+    g_pcMutex.unlock();
+    std::this_thread::sleep_for(waitTime);
+  }
+  g_pcMutex.lock();
+  g_pcCounter = 0;
+  EXPECT_GT(pcCounter, 0);
+  const double expectedGray =
+      (far_ - expectedDepth) * 255.0 / (far_ - near_);
+  unsigned int pcMid = mid * 3;
+  EXPECT_NEAR(expectedGray, g_pointsRGBBuffer[pcMid], 1.0);
+  EXPECT_EQ(g_pointsRGBBuffer[pcMid], g_pointsRGBBuffer[pcMid + 1]);
+  EXPECT_EQ(g_pointsRGBBuffer[pcMid], g_pointsRGBBuffer[pcMid + 2]);
+  g_pcMutex.unlock();
+
   // clean up rendering ptrs
   blue.reset();
   box.reset();
@@ -507,6 +554,463 @@ void DepthCameraSensorTest::ImagesWithBuiltinSDF(
   gz::rendering::unloadEngine(engine->Name());
 }
 
+/////////////////////////////////////////////////
+void DepthCameraSensorTest::MillimeterDepth(
+    const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "depth_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+  auto imagePtr = sensorPtr->GetElement("camera")->GetElement("image");
+  imagePtr->GetElement("format")->Set<std::string>("L16");
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support depth cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  // A box in front of the camera, the sides of the image see nothing
+  double unitBoxSize = 1.0;
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  box->SetLocalScale(unitBoxSize, unitBoxSize, unitBoxSize);
+  root->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::DepthCameraSensor *depthSensor =
+      mgr.CreateSensor<gz::sensors::DepthCameraSensor>(sensorPtr);
+  ASSERT_NE(depthSensor, nullptr);
+  depthSensor->SetScene(scene);
+
+  std::string topic =
+    "/test/integration/DepthCameraPlugin_imagesWithBuiltinSDF/image";
+  WaitForMessageTestHelper<gz::msgs::Image> helper(topic);
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+
+  auto msg = helper.Message();
+  EXPECT_EQ(gz::msgs::PixelFormatType::L_INT16, msg.pixel_format_type());
+  EXPECT_EQ(msg.width() * 2u, msg.step());
+  ASSERT_EQ(msg.width() * msg.height() * sizeof(uint16_t),
+      msg.data().size());
+
+  const uint16_t *mm = reinterpret_cast<const uint16_t *>(msg.data().data());
+  unsigned int midHeight = msg.height() / 2u;
+  unsigned int mid = midHeight * msg.width() + msg.width() / 2u - 1u;
+  double expectedMm = (3.0 - unitBoxSize * 0.5) * 1000.0;
+  EXPECT_NEAR(expectedMm, mm[mid], 1.0);
+
+  // Nothing is seen on the sides, which is stored as 0
+  EXPECT_EQ(0u, mm[midHeight * msg.width()]);
+  EXPECT_EQ(0u, mm[(midHeight + 1u) * msg.width() - 1u]);
+
+  // Clean up
+  box.reset();
+  mgr.Remove(depthSensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+void DepthCameraSensorTest::ZeroCopyFrames(
+    const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "depth_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support depth cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  root->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::DepthCameraSensor *depthSensor =
+      mgr.CreateSensor<gz::sensors::DepthCameraSensor>(sensorPtr);
+  ASSERT_NE(depthSensor, nullptr);
+  depthSensor->SetScene(scene);
+  EXPECT_FALSE(depthSensor->ZeroCopyFrames());
+
+  std::string topic =
+    "/test/integration/DepthCameraPlugin_imagesWithBuiltinSDF/image";
+  WaitForMessageTestHelper<gz::msgs::Image> helper(topic);
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  auto copied = helper.Message();
+
+  depthSensor->SetZeroCopyFrames(true);
+  EXPECT_TRUE(depthSensor->ZeroCopyFrames());
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  auto inPlace = helper.Message();
+
+  // The scene didn't change, so neither did the depths
+  EXPECT_EQ(copied.width(), inPlace.width());
+  EXPECT_EQ(copied.height(), inPlace.height());
+  ASSERT_FALSE(inPlace.data().empty());
+  EXPECT_EQ(copied.data(), inPlace.data());
+
+  // Clean up
+  box.reset();
+  mgr.Remove(depthSensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+void DepthCameraSensorTest::PointCloudGpuLayout(
+    const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "depth_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support depth cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  root->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::DepthCameraSensor *depthSensor =
+      mgr.CreateSensor<gz::sensors::DepthCameraSensor>(sensorPtr);
+  ASSERT_NE(depthSensor, nullptr);
+  depthSensor->SetScene(scene);
+  EXPECT_FALSE(depthSensor->PointCloudGpuLayout());
+
+  std::string pointsTopic =
+    "/test/integration/DepthCameraPlugin_imagesWithBuiltinSDF/image/points";
+  WaitForMessageTestHelper<gz::msgs::PointCloudPacked> helper(pointsTopic);
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  auto converted = helper.Message();
+
+  depthSensor->SetPointCloudGpuLayout(true);
+  EXPECT_TRUE(depthSensor->PointCloudGpuLayout());
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  auto gpu = helper.Message();
+
+  // x, y, z and rgba, 16 bytes per point
+  ASSERT_EQ(4, gpu.field_size());
+  EXPECT_EQ("rgba", gpu.field(3).name());
+  EXPECT_EQ(gz::msgs::PointCloudPacked::Field::UINT32,
+      gpu.field(3).datatype());
+  EXPECT_EQ(16u, gpu.point_step());
+  EXPECT_EQ(converted.width(), gpu.width());
+  EXPECT_EQ(converted.height(), gpu.height());
+  ASSERT_EQ(static_cast<std::size_t>(gpu.width()) * gpu.height() * 16u,
+      gpu.data().size());
+
+  // The scene didn't change, so neither did the points of the box
+  std::size_t center = gpu.height() / 2u * gpu.width() + gpu.width() / 2u;
+  float gpuXyz[3];
+  float convertedXyz[3];
+  memcpy(gpuXyz, gpu.data().data() + center * 16u, sizeof(gpuXyz));
+  for (int i = 0; i < 3; ++i)
+  {
+    memcpy(&convertedXyz[i], converted.data().data() +
+        center * converted.point_step() + converted.field(i).offset(),
+        sizeof(float));
+    EXPECT_NEAR(convertedXyz[i], gpuXyz[i], 1e-4);
+  }
+
+  // Clean up
+  box.reset();
+  mgr.Remove(depthSensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+void DepthCameraSensorTest::SurfaceNormals(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "depth_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support depth cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  root->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::DepthCameraSensor *depthSensor =
+      mgr.CreateSensor<gz::sensors::DepthCameraSensor>(sensorPtr);
+  ASSERT_NE(depthSensor, nullptr);
+  depthSensor->SetScene(scene);
+  EXPECT_FALSE(depthSensor->HasNormalConnections());
+
+  std::string topic =
+    "/test/integration/DepthCameraPlugin_imagesWithBuiltinSDF/image";
+  WaitForMessageTestHelper<gz::msgs::PointCloudPacked> pointsHelper(
+      topic + "/points");
+  WaitForMessageTestHelper<gz::msgs::Image> normalsHelper(
+      topic + "/normals");
+  EXPECT_TRUE(depthSensor->HasNormalConnections());
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(pointsHelper.WaitForMessage()) << pointsHelper;
+  EXPECT_TRUE(normalsHelper.WaitForMessage()) << normalsHelper;
+  auto points = pointsHelper.Message();
+  auto normals = normalsHelper.Message();
+
+  EXPECT_EQ(gz::msgs::PixelFormatType::RGB_FLOAT32,
+      normals.pixel_format_type());
+  EXPECT_EQ(points.width(), normals.width());
+  EXPECT_EQ(points.height(), normals.height());
+  ASSERT_EQ(static_cast<std::size_t>(normals.width()) * normals.height() *
+      3u * sizeof(float), normals.data().size());
+
+  // The face of the box in the center of the image faces the camera
+  std::size_t center =
+      normals.height() / 2u * normals.width() + normals.width() / 2u;
+  float normal[3];
+  float xyz[3];
+  memcpy(normal, normals.data().data() + center * sizeof(normal),
+      sizeof(normal));
+  for (int i = 0; i < 3; ++i)
+  {
+    memcpy(&xyz[i], points.data().data() + center * points.point_step() +
+        points.field(i).offset(), sizeof(float));
+  }
+  const double length = std::sqrt(normal[0] * normal[0] +
+      normal[1] * normal[1] + normal[2] * normal[2]);
+  const double distance =
+      std::sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+  EXPECT_NEAR(1.0, length, 1e-4);
+  ASSERT_GT(distance, 0.0);
+  EXPECT_NEAR(-1.0, (normal[0] * xyz[0] + normal[1] * xyz[1] +
+      normal[2] * xyz[2]) / distance, 1e-3);
+
+  // Clean up
+  box.reset();
+  mgr.Remove(depthSensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+void DepthCameraSensorTest::ElevationMap(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "depth_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support depth cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  // The front face of the box is at x = 2.5, from z = -0.5 to 0.5
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  root->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::DepthCameraSensor *depthSensor =
+      mgr.CreateSensor<gz::sensors::DepthCameraSensor>(sensorPtr);
+  ASSERT_NE(depthSensor, nullptr);
+  depthSensor->SetScene(scene);
+  EXPECT_FALSE(depthSensor->ElevationMapOutput());
+  EXPECT_FALSE(depthSensor->SetElevationMapOutput(true, 0.0));
+  ASSERT_TRUE(depthSensor->SetElevationMapOutput(true, 0.25, 40u, 0.0));
+  EXPECT_TRUE(depthSensor->ElevationMapOutput());
+  EXPECT_FALSE(depthSensor->HasElevationMapConnections());
+
+  std::string topic =
+    "/test/integration/DepthCameraPlugin_imagesWithBuiltinSDF/image";
+  WaitForMessageTestHelper<gz::msgs::Image> mapHelper(
+      topic + "/elevation_map");
+  EXPECT_TRUE(depthSensor->HasElevationMapConnections());
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(mapHelper.WaitForMessage()) << mapHelper;
+  auto map = mapHelper.Message();
+
+  EXPECT_EQ(gz::msgs::PixelFormatType::R_FLOAT32, map.pixel_format_type());
+  ASSERT_EQ(40u, map.width());
+  ASSERT_EQ(40u, map.height());
+  ASSERT_EQ(40u * 40u * sizeof(float), map.data().size());
+  double resolution = 0.0;
+  double originX = 0.0;
+  double originY = 0.0;
+  for (const auto &data : map.header().data())
+  {
+    if (data.key() == "frame_id")
+      EXPECT_EQ("world", data.value(0));
+    else if (data.key() == "resolution")
+      resolution = std::stod(data.value(0));
+    else if (data.key() == "origin_x")
+      originX = std::stod(data.value(0));
+    else if (data.key() == "origin_y")
+      originY = std::stod(data.value(0));
+  }
+  EXPECT_DOUBLE_EQ(0.25, resolution);
+  EXPECT_DOUBLE_EQ(-5.0, originX);
+  EXPECT_DOUBLE_EQ(-5.0, originY);
+
+  // Only the cells of the front face of the box hold points, the top of
+  // the face being the highest point
+  std::vector<float> heights(40u * 40u);
+  memcpy(heights.data(), map.data().data(), map.data().size());
+  unsigned int occupied = 0u;
+  float highest = -std::numeric_limits<float>::infinity();
+  for (unsigned int j = 0u; j < 40u; ++j)
+  {
+    for (unsigned int i = 0u; i < 40u; ++i)
+    {
+      const float height = heights[j * 40u + i];
+      if (std::isnan(height))
+        continue;
+      ++occupied;
+      highest = std::max(highest, height);
+      const double x = originX + (i + 0.5) * resolution;
+      const double y = originY + (j + 0.5) * resolution;
+      EXPECT_NEAR(2.5, x, 0.25 + 1e-6);
+      EXPECT_NEAR(0.0, y, 0.75 + 1e-6);
+      EXPECT_GE(height, -0.5f - 0.01f);
+    }
+  }
+  EXPECT_GT(occupied, 0u);
+  EXPECT_NEAR(0.5f, highest, 0.05f);
+
+  // Disabling the output removes the topic
+  EXPECT_TRUE(depthSensor->SetElevationMapOutput(false));
+  EXPECT_FALSE(depthSensor->ElevationMapOutput());
+  EXPECT_FALSE(depthSensor->HasElevationMapConnections());
+
+  // Clean up
+  box.reset();
+  mgr.Remove(depthSensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
 //////////////////////////////////////////////////
 TEST_P(DepthCameraSensorTest, ImagesWithBuiltinSDF)
 {
@@ -514,5 +1018,130 @@ TEST_P(DepthCameraSensorTest, ImagesWithBuiltinSDF)
   gz::common::Console::SetVerbosity(4);
 }
 
+//////////////////////////////////////////////////
+TEST_P(DepthCameraSensorTest, MillimeterDepth)
+{
+  MillimeterDepth(GetParam());
+}
+
+//////////////////////////////////////////////////
+TEST_P(DepthCameraSensorTest, ZeroCopyFrames)
+{
+  ZeroCopyFrames(GetParam());
+}
+
+//////////////////////////////////////////////////
+TEST_P(DepthCameraSensorTest, PointCloudGpuLayout)
+{
+  PointCloudGpuLayout(GetParam());
+}
+
+//////////////////////////////////////////////////
+TEST_P(DepthCameraSensorTest, SurfaceNormals)
+{
+  SurfaceNormals(GetParam());
+}
+
+//////////////////////////////////////////////////
+TEST_P(DepthCameraSensorTest, ElevationMap)
+{
+  ElevationMap(GetParam());
+}
+
+/////////////////////////////////////////////////
+void DepthCameraSensorTest::ImageNoise(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "depth_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  // A box whose front face is 2.5 m away
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  scene->RootVisual()->AddChild(box);
+
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  sdf::Camera cameraSdf = *sdfSensor.CameraSensor();
+  constexpr double stdDev = 0.05;
+  sdf::Noise noise;
+  noise.SetType(sdf::NoiseType::GAUSSIAN);
+  noise.SetMean(0.0);
+  noise.SetStdDev(stdDev);
+  cameraSdf.SetImageNoise(noise);
+  sdfSensor.SetCameraSensor(cameraSdf);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::DepthCameraSensor *sensor =
+      mgr.CreateSensor<gz::sensors::DepthCameraSensor>(sdfSensor);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  std::vector<std::vector<float>> frames;
+  auto connection = sensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        std::vector<float> depths(_msg.width() * _msg.height());
+        ASSERT_EQ(depths.size() * sizeof(float), _msg.data().size());
+        std::memcpy(depths.data(), _msg.data().data(), _msg.data().size());
+        frames.push_back(depths);
+      });
+
+  // Nothing changes between the frames, only the noise, added by the
+  // render pass or on the CPU if the engine has none
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  ASSERT_EQ(2u, frames.size());
+
+  // Frames have independent noise, so their difference has zero mean and
+  // sqrt(2) times the noise standard deviation
+  double sum = 0.0;
+  double sumSquares = 0.0;
+  std::size_t count = 0u;
+  for (std::size_t i = 0; i < frames[0].size(); ++i)
+  {
+    if (!std::isfinite(frames[0][i]) || !std::isfinite(frames[1][i]))
+      continue;
+    EXPECT_NEAR(2.5, frames[0][i], 6 * stdDev);
+    const double d = static_cast<double>(frames[0][i]) - frames[1][i];
+    sum += d;
+    sumSquares += d * d;
+    ++count;
+  }
+  ASSERT_GT(count, 1000u);
+  const double rms = std::sqrt(sumSquares / count);
+  const double expectedRms = std::sqrt(2.0) * stdDev;
+  EXPECT_NEAR(0.0, sum / count, 0.1 * expectedRms);
+  EXPECT_GT(rms, 0.5 * expectedRms);
+  EXPECT_LT(rms, 1.5 * expectedRms);
+
+  // Clean up
+  connection.reset();
+  box.reset();
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(DepthCameraSensorTest, ImageNoise)
+{
+  ImageNoise(GetParam());
+}
+
 INSTANTIATE_TEST_SUITE_P(DepthCameraSensor, DepthCameraSensorTest,
     RENDER_ENGINE_VALUES, gz::rendering::PrintToStringParam());
@@ -17,13 +17,24 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include <gz/math/Matrix3.hh>
 #include <gz/math/Quaternion.hh>
 #include <gz/math/Vector3.hh>
 
+#include <gz/msgs/boolean.pb.h>
 #include <gz/msgs/dvl_velocity_tracking.pb.h>
+#include <gz/msgs/marker_v.pb.h>
 
 #include <gz/rendering/Material.hh>
 #include <gz/rendering/RenderEngine.hh>
@@ -62,6 +73,9 @@ struct DVLConfig
 
   std::string waterVelocityVariable = "underwater_current_velocity";
 
+  double resolution = 0.01;  // m at 1 m
+  bool perBeamRendering = false;
+
   bool alwaysOn = true;
 };
 
@@ -128,7 +142,9 @@ sdf::ElementPtr MakeDVLSdf(const DVLConfig &_config)
     << "       <visualize>1</visualize>"
     << "      </water_mass_mode>"
     << "     </tracking>"
-    << "     <resolution>0.01</resolution>"
+    << "     <resolution>" << _config.resolution << "</resolution>"
+    << "     <per_beam_rendering>" << _config.perBeamRendering
+    << "</per_beam_rendering>"
     << "     <maximum_range>100.</maximum_range>"
     << "     <minimum_range>0.1</minimum_range>"
     << "    </gz:dvl>"
@@ -241,6 +257,48 @@ class DopplerVelocityLogTest : public testing::Test,
     rendering::unloadEngine(engine->Name());
   }
 
+  /// \brief Add a device carrying a DVL sensor to the scene.
+  /// \param[in] _sensor DVL sensor.
+  /// \param[in] _entity Entity ID of the device.
+  /// \param[in] _pose Pose of the device in the world frame.
+  /// \param[in] _linearVelocity Velocity of the device in the world frame.
+  protected: void AddDevice(
+      DopplerVelocityLog *_sensor, uint64_t _entity,
+      const math::Pose3d &_pose, const math::Vector3d &_linearVelocity)
+  {
+    _sensor->SetEntity(_entity);
+    _sensor->SetScene(this->scene);
+    _sensor->SetManualSceneUpdate(true);
+
+    rendering::VisualPtr device = this->scene->CreateVisual();
+    device->SetLocalPose(_pose);
+    device->SetUserData("gazebo-entity", _entity);
+    for (auto renderingSensor : _sensor->RenderingSensors())
+    {
+      device->AddChild(renderingSensor);
+    }
+    this->scene->RootVisual()->AddChild(device);
+
+    sensors::EntityKinematicState & deviceState =
+        this->worldState.kinematics[_entity];
+    deviceState.pose = _pose;
+    deviceState.linearVelocity = _linearVelocity;
+  }
+
+  /// \brief Render the scene and update a DVL sensor.
+  /// \param[in] _sensor DVL sensor.
+  /// \param[in] _now Current time.
+  protected: void UpdateSensor(
+      DopplerVelocityLog *_sensor,
+      const std::chrono::steady_clock::duration &_now)
+  {
+    _sensor->SetWorldState(this->worldState);
+    this->scene->PreRender();
+    _sensor->Update(_now);
+    this->scene->PostRender();
+    _sensor->PostUpdate(_now);
+  }
+
   rendering::RenderEngine *engine{nullptr};
   rendering::ScenePtr scene;
   sensors::Manager manager;
@@ -522,5 +580,491 @@ TEST_P(DopplerVelocityLogTest, BottomTrackingWhileInMotion)
   this->manager.Remove(sensor->Id());
 }
 
+/////////////////////////////////////////////////
+TEST_P(DopplerVelocityLogTest, BottomTrackingWithThreads)
+{
+  // Add DVL sensor
+  DVLConfig config;
+  config.bottomTrackingMode = "always";
+  auto *sensor = this->manager.
+      CreateSensor<DopplerVelocityLog>(MakeDVLSdf(config));
+
+  sensor->SetThreadCount(4u);
+  EXPECT_EQ(4u, sensor->ThreadCount());
+
+  constexpr uint64_t deviceEntity = 200u;
+  sensor->SetEntity(deviceEntity);
+  sensor->SetScene(this->scene);
+  sensor->SetManualSceneUpdate(true);
+
+  rendering::VisualPtr root = this->scene->RootVisual();
+  rendering::VisualPtr device = this->scene->CreateVisual();
+  const math::Pose3d devicePose(
+      math::Vector3d::Zero,
+      math::Quaterniond::Identity);
+  device->SetLocalPose(devicePose);
+  device->SetUserData("gazebo-entity", deviceEntity);
+  for (auto renderingSensor : sensor->RenderingSensors())
+  {
+      device->AddChild(renderingSensor);
+  }
+  root->AddChild(device);
+
+  // Subscribe to DVL readings
+  WaitForMessageTestHelper<
+    msgs::DVLVelocityTracking
+  > msgHelper(sensor->Topic());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  // Update DVL readings
+  sensors::EntityKinematicState & deviceState =
+      this->worldState.kinematics[deviceEntity];
+  deviceState.pose = devicePose;
+  deviceState.linearVelocity = math::Vector3d::UnitX;
+  sensor->SetWorldState(this->worldState);
+
+  const auto now = (
+    std::chrono::seconds(100) +
+    std::chrono::nanoseconds(100));
+  this->scene->PreRender();
+  sensor->Update(now);
+  this->scene->PostRender();
+  sensor->PostUpdate(now);
+
+  EXPECT_TRUE(msgHelper.WaitForMessage(std::chrono::seconds(10)));
+
+  // Verify DVL readings
+  const msgs::DVLVelocityTracking & message = msgHelper.Message();
+  EXPECT_EQ(now, msgs::Convert(message.header().stamp()));
+  using DVLVelocityTracking = msgs::DVLVelocityTracking;
+  EXPECT_EQ(DVLVelocityTracking::DVL_TYPE_PHASED_ARRAY, message.type());
+  using DVLTrackingTarget = msgs::DVLTrackingTarget;
+  EXPECT_EQ(DVLTrackingTarget::DVL_TARGET_BOTTOM, message.target().type());
+  using DVLKinematicEstimate = msgs::DVLKinematicEstimate;
+  constexpr auto velocityReference = DVLKinematicEstimate::DVL_REFERENCE_SHIP;
+  EXPECT_EQ(velocityReference, message.velocity().reference());
+  EXPECT_TRUE(math::Vector3d::UnitX.Equal(
+    msgs::Convert(message.velocity().mean()),
+    4 * config.trackingNoise));
+  EXPECT_EQ(4, message.beams_size());
+  for (int i = 0; i < message.beams_size(); ++i)
+  {
+    EXPECT_TRUE(message.beams(i).locked());
+    const math::Quaterniond beamRotation(
+      0., GZ_DTOR(config.tiltAngle),
+      -GZ_DTOR(config.rotationAngles[i]));
+    const auto beamAxis = beamRotation * -math::Vector3d::UnitZ;
+    const auto beamVelocity =
+      beamAxis * beamAxis.Dot(deviceState.linearVelocity);
+    EXPECT_TRUE(beamVelocity.Equal(
+      msgs::Convert(message.beams(i).velocity().mean()),
+      4 * config.trackingNoise));
+    EXPECT_EQ(velocityReference, message.beams(i).velocity().reference());
+  }
+  EXPECT_EQ(0, message.status());
+
+  this->manager.Remove(sensor->Id());
+}
+
+/////////////////////////////////////////////////
+TEST_P(DopplerVelocityLogTest, BottomTrackingWhileTilted)
+{
+  // Add DVL sensor, rolled so that each beam meets the seabed at a
+  // different angle
+  DVLConfig config;
+  config.bottomTrackingMode = "always";
+  auto *sensor = this->manager.
+      CreateSensor<DopplerVelocityLog>(MakeDVLSdf(config));
+  ASSERT_NE(nullptr, sensor);
+
+  constexpr uint64_t deviceEntity = 200u;
+  const math::Pose3d devicePose(
+      math::Vector3d::Zero,
+      math::Quaterniond(GZ_DTOR(10.), 0., 0.));
+  this->AddDevice(sensor, deviceEntity, devicePose, math::Vector3d::UnitX);
+
+  // Subscribe to DVL readings
+  WaitForMessageTestHelper<
+    msgs::DVLVelocityTracking
+  > msgHelper(sensor->Topic());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  // Update DVL readings
+  const auto now = std::chrono::seconds(100);
+  this->UpdateSensor(sensor, now);
+  ASSERT_TRUE(msgHelper.WaitForMessage(std::chrono::seconds(10)));
+
+  // Verify DVL readings
+  const msgs::DVLVelocityTracking message = msgHelper.Message();
+  using DVLTrackingTarget = msgs::DVLTrackingTarget;
+  EXPECT_EQ(DVLTrackingTarget::DVL_TARGET_BOTTOM, message.target().type());
+  const math::Vector3d velocityInSensorFrame =
+      devicePose.Rot().RotateVectorReverse(math::Vector3d::UnitX);
+  EXPECT_TRUE(velocityInSensorFrame.Equal(
+    msgs::Convert(message.velocity().mean()),
+    4 * config.trackingNoise));
+  ASSERT_EQ(4, message.beams_size());
+  double targetRange = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < message.beams_size(); ++i)
+  {
+    EXPECT_TRUE(message.beams(i).locked());
+    const math::Quaterniond beamRotation(
+      0., GZ_DTOR(config.tiltAngle),
+      -GZ_DTOR(config.rotationAngles[i]));
+    const auto beamAxis = beamRotation * -math::Vector3d::UnitZ;
+
+    // The closest seabed point within the beam aperture is no closer than
+    // the aperture edge nearest to the vertical, and no farther than the
+    // beam axis
+    const double offVerticalAngle = std::acos(
+        (devicePose.Rot() * beamAxis).Dot(-math::Vector3d::UnitZ));
+    const double halfAperture = GZ_DTOR(config.apertureAngle) / 2.;
+    const double beamRange = message.beams(i).range().mean();
+    constexpr double rangeTolerance = 0.1;
+    EXPECT_GE(beamRange, seabedDepth / std::cos(
+        offVerticalAngle - halfAperture) - rangeTolerance) << i;
+    EXPECT_LE(beamRange, seabedDepth / std::cos(
+        offVerticalAngle) + rangeTolerance) << i;
+    targetRange = std::min(targetRange, beamRange);
+
+    const auto beamVelocity =
+      beamAxis * beamAxis.Dot(velocityInSensorFrame);
+    EXPECT_TRUE(beamVelocity.Equal(
+      msgs::Convert(message.beams(i).velocity().mean()),
+      4 * config.trackingNoise));
+  }
+  EXPECT_DOUBLE_EQ(targetRange, message.target().range().mean());
+  EXPECT_EQ(0, message.status());
+
+  this->manager.Remove(sensor->Id());
+}
+
+/////////////////////////////////////////////////
+TEST_P(DopplerVelocityLogTest, BottomTrackingRepeatedUpdates)
+{
+  // Add DVL sensor
+  DVLConfig config;
+  config.bottomTrackingMode = "always";
+  auto *sensor = this->manager.
+      CreateSensor<DopplerVelocityLog>(MakeDVLSdf(config));
+  ASSERT_NE(nullptr, sensor);
+
+  constexpr uint64_t deviceEntity = 200u;
+  const math::Pose3d devicePose(
+      math::Vector3d::Zero,
+      math::Quaterniond::Identity);
+  this->AddDevice(sensor, deviceEntity, devicePose, math::Vector3d::Zero);
+
+  // Subscribe to DVL readings
+  WaitForMessageTestHelper<
+    msgs::DVLVelocityTracking
+  > msgHelper(sensor->Topic());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  // Velocity covariance is the noise variance times the inverse of the
+  // beam axes' Gramian
+  math::Matrix3d beamBasisGramian = math::Matrix3d::Zero;
+  for (double rotationAngle : config.rotationAngles)
+  {
+    const math::Quaterniond beamRotation(
+      0., GZ_DTOR(config.tiltAngle), -GZ_DTOR(rotationAngle));
+    const auto a = beamRotation * -math::Vector3d::UnitZ;
+    beamBasisGramian = beamBasisGramian + math::Matrix3d(
+        a.X() * a.X(), a.X() * a.Y(), a.X() * a.Z(),
+        a.Y() * a.X(), a.Y() * a.Y(), a.Y() * a.Z(),
+        a.Z() * a.X(), a.Z() * a.Y(), a.Z() * a.Z());
+  }
+  const math::Matrix3d velocityCovariance =
+      beamBasisGramian.Inverse() * std::pow(config.trackingNoise, 2.);
+
+  // Messages are reused across updates, so nothing may carry over from
+  // one reading to the next
+  const std::array<math::Vector3d, 3> velocities{
+    math::Vector3d::UnitX,
+    math::Vector3d(0., 0.5, 0.),
+    math::Vector3d(-0.3, 0.2, 0.1)};
+  for (size_t k = 0; k < velocities.size(); ++k)
+  {
+    this->worldState.kinematics[deviceEntity].linearVelocity = velocities[k];
+    const auto now = std::chrono::seconds(100) +
+        std::chrono::milliseconds(100) * k;
+    this->UpdateSensor(sensor, now);
+    ASSERT_TRUE(msgHelper.WaitForMessage(std::chrono::seconds(10))) << k;
+
+    const msgs::DVLVelocityTracking message = msgHelper.Message();
+    EXPECT_EQ(now, msgs::Convert(message.header().stamp()));
+    using DVLTrackingTarget = msgs::DVLTrackingTarget;
+    EXPECT_EQ(DVLTrackingTarget::DVL_TARGET_BOTTOM, message.target().type());
+    EXPECT_TRUE(velocities[k].Equal(
+      msgs::Convert(message.velocity().mean()),
+      4 * config.trackingNoise)) << k;
+    ASSERT_EQ(9, message.velocity().covariance_size());
+    for (int r = 0; r < 3; ++r)
+    {
+      for (int c = 0; c < 3; ++c)
+      {
+        EXPECT_NEAR(velocityCovariance(r, c),
+                    message.velocity().covariance(3 * r + c), 1e-12)
+          << k << ": " << r << ", " << c;
+      }
+    }
+
+    ASSERT_EQ(4, message.beams_size()) << k;
+    for (int i = 0; i < message.beams_size(); ++i)
+    {
+      EXPECT_TRUE(message.beams(i).locked());
+      const math::Quaterniond beamRotation(
+        0., GZ_DTOR(config.tiltAngle),
+        -GZ_DTOR(config.rotationAngles[i]));
+      const auto beamAxis = beamRotation * -math::Vector3d::UnitZ;
+      const auto beamVelocity = beamAxis * beamAxis.Dot(velocities[k]);
+      EXPECT_TRUE(beamVelocity.Equal(
+        msgs::Convert(message.beams(i).velocity().mean()),
+        4 * config.trackingNoise)) << k << ": " << i;
+      EXPECT_EQ(9, message.beams(i).velocity().covariance_size());
+    }
+    EXPECT_EQ(0, message.status());
+  }
+
+  this->manager.Remove(sensor->Id());
+}
+
+/////////////////////////////////////////////////
+TEST_P(DopplerVelocityLogTest, WaterMassTrackingWhileInMotion)
+{
+  // Add DVL sensor
+  DVLConfig config;
+  config.waterMassTrackingMode = "always";
+  auto *sensor = this->manager.
+      CreateSensor<DopplerVelocityLog>(MakeDVLSdf(config));
+  ASSERT_NE(nullptr, sensor);
+
+  // Yaw the device, so that bin sample points and beam axes differ between
+  // the sensor and world frames
+  constexpr uint64_t deviceEntity = 200u;
+  const math::Pose3d devicePose(
+      math::Vector3d(0., 0., -10),
+      math::Quaterniond(0., 0., GZ_DTOR(90.)));
+  this->AddDevice(sensor, deviceEntity, devicePose, math::Vector3d::UnitX);
+  sensor->SetEnvironmentalData(*this->environment);
+
+  // Subscribe to DVL readings
+  WaitForMessageTestHelper<
+    msgs::DVLVelocityTracking
+  > msgHelper(sensor->Topic());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  const math::Vector3d waterVelocity(1.0, 0.5, 0.0);
+  for (int k = 0; k < 2; ++k)
+  {
+    // Update DVL readings
+    const auto now = std::chrono::seconds(100 + k);
+    this->UpdateSensor(sensor, now);
+    ASSERT_TRUE(msgHelper.WaitForMessage(std::chrono::seconds(10))) << k;
+
+    // Verify DVL readings
+    const msgs::DVLVelocityTracking message = msgHelper.Message();
+    EXPECT_EQ(now, msgs::Convert(message.header().stamp()));
+    using DVLTrackingTarget = msgs::DVLTrackingTarget;
+    EXPECT_EQ(DVLTrackingTarget::DVL_TARGET_WATER_MASS,
+              message.target().type());
+    const math::Vector3d relativeVelocity =
+        devicePose.Rot().RotateVectorReverse(
+            math::Vector3d::UnitX - waterVelocity);
+    EXPECT_TRUE(relativeVelocity.Equal(
+      msgs::Convert(message.velocity().mean()),
+      4 * config.trackingNoise)) << k;
+    ASSERT_EQ(4, message.beams_size());
+    for (int i = 0; i < message.beams_size(); ++i)
+    {
+      EXPECT_TRUE(message.beams(i).locked());
+      const math::Quaterniond beamRotation(
+        0., GZ_DTOR(config.tiltAngle),
+        -GZ_DTOR(config.rotationAngles[i]));
+      const auto beamAxis = beamRotation * -math::Vector3d::UnitZ;
+
+      const double meanBeamRange = (
+          config.waterMassNearBoundary + config.waterMassFarBoundary
+      ) / (-2. * math::Vector3d::UnitZ.Dot(beamAxis));
+      EXPECT_NEAR(meanBeamRange, message.beams(i).range().mean(), 1e-9);
+
+      const auto beamVelocity = beamAxis * beamAxis.Dot(relativeVelocity);
+      EXPECT_TRUE(beamVelocity.Equal(
+        msgs::Convert(message.beams(i).velocity().mean()),
+        4 * config.trackingNoise)) << k << ": " << i;
+    }
+    EXPECT_EQ(0, message.status());
+  }
+
+  this->manager.Remove(sensor->Id());
+}
+
+/////////////////////////////////////////////////
+TEST_P(DopplerVelocityLogTest, BeamMarkersGeometrySentOnce)
+{
+  // Add DVL sensor
+  DVLConfig config;
+  config.bottomTrackingMode = "always";
+  auto *sensor = this->manager.
+      CreateSensor<DopplerVelocityLog>(MakeDVLSdf(config));
+  ASSERT_NE(nullptr, sensor);
+
+  constexpr uint64_t deviceEntity = 200u;
+  const math::Pose3d devicePose(
+      math::Vector3d::Zero,
+      math::Quaterniond::Identity);
+  this->AddDevice(sensor, deviceEntity, devicePose, math::Vector3d::UnitX);
+
+  // Record beam marker requests
+  std::mutex mutex;
+  std::vector<msgs::Marker_V> requests;
+  std::function<bool(const msgs::Marker_V &, msgs::Boolean &)> onMarkers =
+      [&](const msgs::Marker_V &_request, msgs::Boolean &_reply)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back(_request);
+        _reply.set_data(true);
+        return true;
+      };
+  transport::Node node;
+  ASSERT_TRUE(node.Advertise("/marker_array", onMarkers));
+
+  // Subscribe to DVL readings
+  WaitForMessageTestHelper<
+    msgs::DVLVelocityTracking
+  > msgHelper(sensor->Topic());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  // Markers of 4 beams, 3 each, are shown until deleted at this update
+  // rate, so their geometry is only sent with the first update
+  constexpr size_t numUpdates = 3u;
+  for (size_t k = 0; k < numUpdates; ++k)
+  {
+    const auto now = std::chrono::seconds(100) +
+        std::chrono::milliseconds(100) * k;
+    this->UpdateSensor(sensor, now);
+    ASSERT_TRUE(msgHelper.WaitForMessage(std::chrono::seconds(10))) << k;
+  }
+  for (int sleep = 0; sleep < 100; ++sleep)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (requests.size() >= numUpdates)
+        break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(numUpdates, requests.size());
+  for (size_t k = 0; k < requests.size(); ++k)
+  {
+    ASSERT_EQ(12, requests[k].marker_size()) << k;
+    for (const auto & marker : requests[k].marker())
+    {
+      EXPECT_EQ(msgs::Marker::ADD_MODIFY, marker.action());
+      EXPECT_EQ(msgs::Marker::TRIANGLE_FAN, marker.type());
+      EXPECT_FALSE(marker.parent().empty());
+      EXPECT_TRUE(marker.has_pose());
+      EXPECT_TRUE(marker.has_scale());
+      EXPECT_TRUE(marker.has_material());
+      if (k == 0u)
+      {
+        EXPECT_LT(2, marker.point_size()) << marker.id();
+      }
+      else
+      {
+        EXPECT_EQ(0, marker.point_size()) << k << ": " << marker.id();
+      }
+    }
+  }
+
+  this->manager.Remove(sensor->Id());
+}
+
+/////////////////////////////////////////////////
+TEST_P(DopplerVelocityLogTest, PerBeamRenderingMatchesSingleSensor)
+{
+  // Add two DVL sensors on devices with the same pose and velocity, one
+  // rendering all beams at once and the other each beam on its own
+  DVLConfig config;
+  config.bottomTrackingMode = "always";
+  DVLConfig perBeamConfig = config;
+  perBeamConfig.name = "dvl_per_beam";
+  perBeamConfig.topic = "/gz/sensors/test/dvl_per_beam";
+  perBeamConfig.perBeamRendering = true;
+  auto *sensor = this->manager.
+      CreateSensor<DopplerVelocityLog>(MakeDVLSdf(config));
+  ASSERT_NE(nullptr, sensor);
+  auto *perBeamSensor = this->manager.
+      CreateSensor<DopplerVelocityLog>(MakeDVLSdf(perBeamConfig));
+  ASSERT_NE(nullptr, perBeamSensor);
+
+  // One depth sensor per beam, plus the image sensor
+  EXPECT_EQ(2u, sensor->RenderingSensors().size());
+  EXPECT_EQ(5u, perBeamSensor->RenderingSensors().size());
+
+  const math::Pose3d devicePose(
+      math::Vector3d::Zero,
+      math::Quaterniond::Identity);
+  this->AddDevice(sensor, 200u, devicePose, math::Vector3d::UnitX);
+  this->AddDevice(perBeamSensor, 201u, devicePose, math::Vector3d::UnitX);
+
+  // Subscribe to DVL readings
+  WaitForMessageTestHelper<
+    msgs::DVLVelocityTracking
+  > msgHelper(sensor->Topic());
+  EXPECT_TRUE(sensor->HasConnections());
+  WaitForMessageTestHelper<
+    msgs::DVLVelocityTracking
+  > perBeamMsgHelper(perBeamSensor->Topic());
+  EXPECT_TRUE(perBeamSensor->HasConnections());
+
+  // Update DVL readings
+  const auto now = std::chrono::seconds(100);
+  this->UpdateSensor(sensor, now);
+  ASSERT_TRUE(msgHelper.WaitForMessage(std::chrono::seconds(10)));
+  this->UpdateSensor(perBeamSensor, now);
+  ASSERT_TRUE(perBeamMsgHelper.WaitForMessage(std::chrono::seconds(10)));
+
+  // Both sensors lock on the same targets. Ranges may only differ by the
+  // range spanned by two scan steps at the beam tilt, as the scans sample
+  // the beam apertures at different angles.
+  const msgs::DVLVelocityTracking message = msgHelper.Message();
+  const msgs::DVLVelocityTracking perBeamMessage = perBeamMsgHelper.Message();
+  const double tilt = GZ_DTOR(config.tiltAngle);
+  const double rangeTolerance = 2. * config.resolution *
+      seabedDepth * std::sin(tilt) / std::pow(std::cos(tilt), 2.);
+  EXPECT_EQ(message.target().type(), perBeamMessage.target().type());
+  EXPECT_NEAR(message.target().range().mean(),
+              perBeamMessage.target().range().mean(), rangeTolerance);
+  EXPECT_TRUE(msgs::Convert(message.velocity().mean()).Equal(
+    msgs::Convert(perBeamMessage.velocity().mean()),
+    8 * config.trackingNoise));
+  ASSERT_EQ(4, message.beams_size());
+  ASSERT_EQ(message.beams_size(), perBeamMessage.beams_size());
+  for (int i = 0; i < message.beams_size(); ++i)
+  {
+    EXPECT_EQ(message.beams(i).id(), perBeamMessage.beams(i).id());
+    EXPECT_TRUE(message.beams(i).locked());
+    EXPECT_TRUE(perBeamMessage.beams(i).locked());
+    EXPECT_NEAR(message.beams(i).range().mean(),
+                perBeamMessage.beams(i).range().mean(), rangeTolerance) << i;
+    EXPECT_TRUE(msgs::Convert(message.beams(i).velocity().mean()).Equal(
+      msgs::Convert(perBeamMessage.beams(i).velocity().mean()),
+      8 * config.trackingNoise)) << i;
+
+    // Both beam ranges are consistent with the nominal beam tilt
+    const double estimatedTiltAngle = GZ_RTOD(std::acos(
+      seabedDepth / perBeamMessage.beams(i).range().mean()));
+    EXPECT_NEAR(estimatedTiltAngle, config.tiltAngle,
+                config.apertureAngle / 2 + 0.1) << i;
+  }
+  EXPECT_EQ(message.status(), perBeamMessage.status());
+
+  this->manager.Remove(perBeamSensor->Id());
+  this->manager.Remove(sensor->Id());
+}
+
 INSTANTIATE_TEST_SUITE_P(DopplerVelocityLogTests, DopplerVelocityLogTest,
     RENDER_ENGINE_VALUES, rendering::PrintToStringParam());
@@ -17,6 +17,10 @@
 
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <sdf/ForceTorque.hh>
 
 #include <gz/math/Helpers.hh>
@@ -24,6 +28,7 @@
 #include <gz/msgs/wrench.pb.h>
 
 #include <gz/sensors/ForceTorqueSensor.hh>
+#include <gz/sensors/Manager.hh>
 #include <gz/sensors/SensorFactory.hh>
 
 #include "test_config.hh"  // NOLINT(build/include)
@@ -300,6 +305,63 @@ TEST_P(ForceTorqueSensorTest, SensorReadings)
   EXPECT_EQ(torque, sensor->Torque());
 }
 
+/////////////////////////////////////////////////
+TEST_F(ForceTorqueSensorTest, GroupedUpdate)
+{
+  namespace math = gz::math;
+
+  // Create a sensor manager that updates force torque sensors as a group
+  gz::sensors::Manager mgr;
+  mgr.SetGroupedUpdate(true);
+
+  const math::Vector3d forceNoiseMean{0.1, 0.2, 0.3};
+  const math::Vector3d torqueNoiseMean{0.5, 0.6, 0.7};
+  const math::Vector3d force{1, 0, 2};
+  const math::Vector3d torque{0, -1, 3};
+
+  std::vector<gz::sensors::ForceTorqueSensor *> sensors;
+  std::vector<math::Quaterniond> rotations;
+  std::vector<std::unique_ptr<WaitForMessageTestHelper<gz::msgs::Wrench>>>
+      helpers;
+  for (int i = 0; i < 3; ++i)
+  {
+    const std::string topic =
+        "/gz/sensors/test/force_torque_group" + std::to_string(i);
+    sdf::ElementPtr forcetorqueSdf;
+    CreateForceTorqueToSdf("TestForceTorque_Group" + std::to_string(i),
+        math::Pose3d::Zero, 30, topic, true, false, "parent",
+        "child_to_parent", forceNoiseMean, {}, torqueNoiseMean, {},
+        forcetorqueSdf);
+    ASSERT_NE(nullptr, forcetorqueSdf);
+
+    auto sensor =
+        mgr.CreateSensor<gz::sensors::ForceTorqueSensor>(forcetorqueSdf);
+    ASSERT_NE(nullptr, sensor);
+
+    const math::Quaterniond rot(0.2 * i, -0.4 * i, 0.6 * i);
+    sensor->SetRotationParentInSensor(rot);
+    sensor->SetForce(force);
+    sensor->SetTorque(torque);
+    sensors.push_back(sensor);
+    rotations.push_back(rot);
+    helpers.push_back(
+        std::make_unique<WaitForMessageTestHelper<gz::msgs::Wrench>>(topic));
+  }
+
+  mgr.RunOnce(std::chrono::seconds(1));
+
+  // Each sensor measures the wrench it would if updated alone
+  for (std::size_t i = 0; i < sensors.size(); ++i)
+  {
+    EXPECT_TRUE(helpers[i]->WaitForMessage()) << *helpers[i];
+    auto msg = helpers[i]->Message();
+    EXPECT_EQ(-(rotations[i].Inverse() * force) + forceNoiseMean,
+              gz::msgs::Convert(msg.force()));
+    EXPECT_EQ(-(rotations[i].Inverse() * torque) + torqueNoiseMean,
+              gz::msgs::Convert(msg.torque()));
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
     FrameAndDirection, ForceTorqueSensorTest,
     ::testing::Combine(::testing::Values("child", "parent", "sensor"),
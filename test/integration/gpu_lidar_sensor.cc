@@ -15,9 +15,12 @@
  *
 */
 
+#include <cmath>
 #include <cstring>
+#include <mutex>
 #include <gtest/gtest.h>
 
+#include <gz/msgs/image.pb.h>
 #include <gz/msgs/laserscan.pb.h>
 #include <gz/msgs/pointcloud_packed.pb.h>
 
@@ -170,6 +173,21 @@ class GpuLidarSensorTest: public testing::Test,
 
   // Test topics
   public: void Topic(const std::string &_renderEngine);
+
+  // Test range and intensity images
+  public: void RangeImage(const std::string &_renderEngine);
+
+  // Test motion distortion of rolling scans
+  public: void RollingScan(const std::string &_renderEngine);
+
+  // Test non-uniform beam elevations
+  public: void BeamAngles(const std::string &_renderEngine);
+
+  // Test batching scans into point cloud messages
+  public: void ScanBatch(const std::string &_renderEngine);
+
+  // Test strongest and last returns
+  public: void DualReturn(const std::string &_renderEngine);
 };
 
 /////////////////////////////////////////////////
@@ -425,6 +443,16 @@ void GpuLidarSensorTest::DetectBox(const std::string &_renderEngine)
   EXPECT_FALSE(pointMsgs.back().is_dense());
   EXPECT_EQ(32u * horzSamples * vertSamples, pointMsgs.back().data().size());
 
+  // The middle ray points almost straight ahead
+  float midX = 0.0f;
+  float midZ = 1.0f;
+  std::memcpy(&midX, pointMsgs.back().data().data() + mid * 32u,
+      sizeof(midX));
+  std::memcpy(&midZ, pointMsgs.back().data().data() + mid * 32u + 8u,
+      sizeof(midZ));
+  EXPECT_NEAR(midX, expectedRangeAtMidPointBox1, 1e-3);
+  EXPECT_NEAR(midZ, 0.0, 1e-6);
+
   // Clean up rendering ptrs
   visualBox1.reset();
 
@@ -928,6 +956,578 @@ void GpuLidarSensorTest::Topic(const std::string &_renderEngine)
   }
 }
 
+/////////////////////////////////////////////////
+/// \brief Test the range and intensity images
+void GpuLidarSensorTest::RangeImage(const std::string &_renderEngine)
+{
+  // Create SDF describing a gpu lidar sensor
+  const std::string name = "TestGpuLidar";
+  const std::string topic = "/gz/sensors/test/lidar_range_image";
+  const double updateRate = 30;
+  const int horzSamples = 320;
+  const double horzResolution = 1;
+  const double horzMinAngle = -GZ_PI/2.0;
+  const double horzMaxAngle = GZ_PI/2.0;
+  const double vertResolution = 1;
+  const int vertSamples = 4;
+  const double vertMinAngle = -0.1;
+  const double vertMaxAngle = 0.1;
+  const double rangeResolution = 0.01;
+  const double rangeMin = 0.08;
+  const double rangeMax = 10.0;
+  const bool alwaysOn = 1;
+  const bool visualize = 1;
+
+  gz::math::Pose3d testPose(gz::math::Vector3d(0.0, 0.0, 0.1),
+      gz::math::Quaterniond::Identity);
+  sdf::ElementPtr lidarSdf = GpuLidarToSdf(name, testPose, updateRate, topic,
+    horzSamples, horzResolution, horzMinAngle, horzMaxAngle,
+    vertSamples, vertResolution, vertMinAngle, vertMaxAngle,
+    rangeResolution, rangeMin, rangeMax, alwaysOn, visualize);
+
+  gz::rendering::RenderEngine *engine =
+    gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  // Box in front of the sensor
+  gz::rendering::VisualPtr visualBox1 = scene->CreateVisual("TestBox1");
+  visualBox1->AddGeometry(scene->CreateBox());
+  visualBox1->SetLocalPosition(1, 0, 0.5);
+  root->AddChild(visualBox1);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::GpuLidarSensor *sensor =
+      mgr.CreateSensor<gz::sensors::GpuLidarSensor>(lidarSdf);
+  ASSERT_NE(nullptr, sensor);
+  sensor->SetScene(scene);
+  EXPECT_EQ(topic + "/range_image", sensor->RangeImageTopic());
+  EXPECT_EQ(topic + "/intensity_image", sensor->IntensityImageTopic());
+
+  WaitForMessageTestHelper<gz::msgs::Image> rangeHelper(
+      sensor->RangeImageTopic());
+  WaitForMessageTestHelper<gz::msgs::Image> intensityHelper(
+      sensor->IntensityImageTopic());
+  EXPECT_TRUE(sensor->HasConnections());
+
+  std::vector<gz::msgs::Image> rangeImages;
+  std::function<void(const gz::msgs::Image &)> rangeCb =
+      [&](const gz::msgs::Image &_msg) { rangeImages.push_back(_msg); };
+  gz::transport::Node node;
+  node.Subscribe(sensor->RangeImageTopic(), rangeCb);
+
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(rangeHelper.WaitForMessage()) << rangeHelper;
+  EXPECT_TRUE(intensityHelper.WaitForMessage()) << intensityHelper;
+
+  ASSERT_FALSE(rangeImages.empty());
+  const gz::msgs::Image &image = rangeImages.back();
+  EXPECT_EQ(static_cast<uint32_t>(horzSamples), image.width());
+  EXPECT_EQ(static_cast<uint32_t>(vertSamples), image.height());
+  EXPECT_EQ(horzSamples * sizeof(float), image.step());
+  EXPECT_EQ(gz::msgs::PixelFormatType::R_FLOAT32,
+      image.pixel_format_type());
+  ASSERT_EQ(horzSamples * vertSamples * sizeof(float), image.data().size());
+
+  // Every ray matches the laser scan
+  std::vector<double> ranges;
+  sensor->Ranges(ranges);
+  ASSERT_EQ(static_cast<std::size_t>(horzSamples * vertSamples),
+      ranges.size());
+  for (std::size_t i = 0; i < ranges.size(); ++i)
+  {
+    float range = 0.0f;
+    std::memcpy(&range, image.data().data() + i * sizeof(float),
+        sizeof(range));
+    // The scan replaces NaN with the maximum range
+    if (std::isnan(range))
+      EXPECT_DOUBLE_EQ(rangeMax, ranges[i]) << i;
+    else
+      EXPECT_EQ(static_cast<double>(range), ranges[i]) << i;
+  }
+
+  // Clean up
+  visualBox1.reset();
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+/// \brief Test the motion distortion of rolling scans
+void GpuLidarSensorTest::RollingScan(const std::string &_renderEngine)
+{
+  // Create SDF describing a gpu lidar sensor
+  const std::string name = "TestGpuLidar";
+  const std::string topic = "/gz/sensors/test/lidar_rolling_scan";
+  const double updateRate = 10;
+  const int horzSamples = 320;
+  const double horzResolution = 1;
+  const double horzMinAngle = -GZ_PI/2.0;
+  const double horzMaxAngle = GZ_PI/2.0;
+  const double vertResolution = 1;
+  const int vertSamples = 1;
+  const double vertMinAngle = 0;
+  const double vertMaxAngle = 0;
+  const double rangeResolution = 0.01;
+  const double rangeMin = 0.08;
+  const double rangeMax = 10.0;
+  const bool alwaysOn = 1;
+  const bool visualize = 1;
+
+  gz::math::Pose3d testPose(gz::math::Vector3d(0.0, 0.0, 0.1),
+      gz::math::Quaterniond::Identity);
+  sdf::ElementPtr lidarSdf = GpuLidarToSdf(name, testPose, updateRate, topic,
+    horzSamples, horzResolution, horzMinAngle, horzMaxAngle,
+    vertSamples, vertResolution, vertMinAngle, vertMaxAngle,
+    rangeResolution, rangeMin, rangeMax, alwaysOn, visualize);
+
+  gz::rendering::RenderEngine *engine =
+    gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  // Box in front of the sensor, its front face is at x = 0.5
+  gz::rendering::VisualPtr visualBox1 = scene->CreateVisual("TestBox1");
+  visualBox1->AddGeometry(scene->CreateBox());
+  visualBox1->SetLocalPosition(1, 0, 0.5);
+  root->AddChild(visualBox1);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::GpuLidarSensor *sensor =
+      mgr.CreateSensor<gz::sensors::GpuLidarSensor>(lidarSdf);
+  ASSERT_NE(nullptr, sensor);
+  sensor->SetScene(scene);
+  EXPECT_EQ(0u, sensor->RollingScanSlices());
+  sensor->SetRollingScanSlices(horzSamples);
+  EXPECT_EQ(static_cast<unsigned int>(horzSamples),
+      sensor->RollingScanSlices());
+
+  std::vector<gz::msgs::PointCloudPacked> clouds;
+  std::function<void(const gz::msgs::PointCloudPacked &)> cloudCb =
+      [&](const gz::msgs::PointCloudPacked &_msg) { clouds.push_back(_msg); };
+  gz::transport::Node node;
+  node.Subscribe(topic + "/points", cloudCb);
+
+  // First scan at rest
+  WaitForMessageTestHelper<gz::msgs::PointCloudPacked> helper(
+      topic + "/points");
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+
+  // Second scan while moving 0.1 m towards the box
+  const gz::math::Pose3d movedPose(gz::math::Vector3d(0.1, 0.0, 0.1),
+      gz::math::Quaterniond::Identity);
+  sensor->SetPose(movedPose);
+  sensor->GpuRays()->SetWorldPosition(movedPose.Pos());
+  clouds.clear();
+  mgr.RunOnce(std::chrono::milliseconds(100), true);
+  for (int i = 0; clouds.empty() && i < 300; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  ASSERT_FALSE(clouds.empty());
+  const gz::msgs::PointCloudPacked &cloud = clouds.back();
+  ASSERT_EQ(6, cloud.field_size());
+  EXPECT_EQ("t", cloud.field(5).name());
+  EXPECT_EQ(gz::msgs::PointCloudPacked::Field::FLOAT32,
+      cloud.field(5).datatype());
+  ASSERT_EQ(static_cast<std::size_t>(cloud.row_step()) * cloud.height(),
+      cloud.data().size());
+
+  const char *data = cloud.data().data();
+  const uint32_t step = cloud.point_step();
+  const uint32_t timeOffset = cloud.field(5).offset();
+
+  // Times go from minus the period to zero along the row
+  float firstTime = 0.0f;
+  float lastTime = 1.0f;
+  std::memcpy(&firstTime, data + timeOffset, sizeof(float));
+  std::memcpy(&lastTime, data + (horzSamples - 1) * step + timeOffset,
+      sizeof(float));
+  EXPECT_NEAR(-(1.0 - 1.0 / horzSamples) / updateRate, firstTime, 1e-6);
+  EXPECT_FLOAT_EQ(0.0f, lastTime);
+
+  // The middle point was captured before the end of the motion, further
+  // from the box than at the current pose
+  const int mid = horzSamples / 2;
+  const double f = static_cast<double>(mid + 1) / horzSamples;
+  float midX = 0.0f;
+  std::memcpy(&midX, data + mid * step, sizeof(midX));
+  EXPECT_NEAR(0.4 + 0.1 * (1.0 - f), midX, 1e-2);
+
+  // Clean up
+  visualBox1.reset();
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+/// \brief Test non-uniform beam elevations
+void GpuLidarSensorTest::BeamAngles(const std::string &_renderEngine)
+{
+  // Create SDF describing a gpu lidar sensor
+  const std::string name = "TestGpuLidar";
+  const std::string topic = "/gz/sensors/test/lidar_beam_angles";
+  const double updateRate = 30;
+  const int horzSamples = 320;
+  const double horzResolution = 1;
+  const double horzMinAngle = -GZ_PI/2.0;
+  const double horzMaxAngle = GZ_PI/2.0;
+  const double vertResolution = 1;
+  const int vertSamples = 3;
+  const double vertMinAngle = -0.1;
+  const double vertMaxAngle = 0.1;
+  const double rangeResolution = 0.01;
+  const double rangeMin = 0.08;
+  const double rangeMax = 10.0;
+  const bool alwaysOn = 1;
+  const bool visualize = 1;
+
+  gz::math::Pose3d testPose(gz::math::Vector3d(0.0, 0.0, 0.1),
+      gz::math::Quaterniond::Identity);
+  sdf::ElementPtr lidarSdf = GpuLidarToSdf(name, testPose, updateRate, topic,
+    horzSamples, horzResolution, horzMinAngle, horzMaxAngle,
+    vertSamples, vertResolution, vertMinAngle, vertMaxAngle,
+    rangeResolution, rangeMin, rangeMax, alwaysOn, visualize);
+
+  gz::rendering::RenderEngine *engine =
+    gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  // Box in front of the sensor, its front face is at x = 0.5
+  gz::rendering::VisualPtr visualBox1 = scene->CreateVisual("TestBox1");
+  visualBox1->AddGeometry(scene->CreateBox());
+  visualBox1->SetLocalPosition(1, 0, 0.5);
+  root->AddChild(visualBox1);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::GpuLidarSensor *sensor =
+      mgr.CreateSensor<gz::sensors::GpuLidarSensor>(lidarSdf);
+  ASSERT_NE(nullptr, sensor);
+  sensor->SetScene(scene);
+
+  // One elevation per vertical sample
+  EXPECT_FALSE(sensor->SetBeamAngles({0.0, 0.01}));
+  EXPECT_FALSE(sensor->SetBeamAngles({-0.08, 0.0, 0.03}, {0.0}));
+  EXPECT_TRUE(sensor->BeamElevations().empty());
+
+  const std::vector<double> elevations{-0.08, 0.0, 0.03};
+  EXPECT_TRUE(sensor->SetBeamAngles(elevations));
+  EXPECT_EQ(elevations, sensor->BeamElevations());
+  EXPECT_TRUE(sensor->BeamAzimuthOffsets().empty());
+
+  // Rendered at half the smallest gap over the span of the beams
+  ASSERT_NE(nullptr, sensor->GpuRays());
+  EXPECT_EQ(9u, sensor->GpuRays()->VerticalRangeCount());
+
+  WaitForMessageTestHelper<gz::msgs::PointCloudPacked> helper(
+      topic + "/points");
+  std::vector<gz::msgs::PointCloudPacked> clouds;
+  std::function<void(const gz::msgs::PointCloudPacked &)> cloudCb =
+      [&](const gz::msgs::PointCloudPacked &_msg) { clouds.push_back(_msg); };
+  gz::transport::Node node;
+  node.Subscribe(topic + "/points", cloudCb);
+
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  for (int i = 0; clouds.empty() && i < 300; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  // One row per beam, each close to its elevation
+  ASSERT_FALSE(clouds.empty());
+  const gz::msgs::PointCloudPacked &cloud = clouds.back();
+  ASSERT_EQ(static_cast<uint32_t>(vertSamples), cloud.height());
+  ASSERT_EQ(static_cast<uint32_t>(horzSamples), cloud.width());
+  ASSERT_EQ(static_cast<std::size_t>(cloud.row_step()) * cloud.height(),
+      cloud.data().size());
+  const int mid = horzSamples / 2;
+  for (uint32_t j = 0; j < cloud.height(); ++j)
+  {
+    const char *point = cloud.data().data() + j * cloud.row_step() +
+        mid * cloud.point_step();
+    float x = 0.0f;
+    float z = 0.0f;
+    uint16_t ring = 0u;
+    std::memcpy(&x, point + cloud.field(0).offset(), sizeof(x));
+    std::memcpy(&z, point + cloud.field(2).offset(), sizeof(z));
+    std::memcpy(&ring, point + cloud.field(4).offset(), sizeof(ring));
+    EXPECT_NEAR(0.5, x, 1e-2) << j;
+    EXPECT_NEAR(elevations[j], std::atan2(z, x), 1e-2) << j;
+    EXPECT_EQ(j, ring);
+  }
+
+  // Clean up
+  visualBox1.reset();
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+/// \brief Test batching scans into point cloud messages
+void GpuLidarSensorTest::ScanBatch(const std::string &_renderEngine)
+{
+  // Create SDF describing a gpu lidar sensor
+  const std::string name = "TestGpuLidar";
+  const std::string topic = "/gz/sensors/test/lidar_scan_batch";
+  const double updateRate = 30;
+  const int horzSamples = 320;
+  const double horzResolution = 1;
+  const double horzMinAngle = -GZ_PI/2.0;
+  const double horzMaxAngle = GZ_PI/2.0;
+  const double vertResolution = 1;
+  const int vertSamples = 4;
+  const double vertMinAngle = -0.1;
+  const double vertMaxAngle = 0.1;
+  const double rangeResolution = 0.01;
+  const double rangeMin = 0.08;
+  const double rangeMax = 10.0;
+  const bool alwaysOn = 1;
+  const bool visualize = 1;
+
+  gz::math::Pose3d testPose(gz::math::Vector3d(0.0, 0.0, 0.1),
+      gz::math::Quaterniond::Identity);
+  sdf::ElementPtr lidarSdf = GpuLidarToSdf(name, testPose, updateRate, topic,
+    horzSamples, horzResolution, horzMinAngle, horzMaxAngle,
+    vertSamples, vertResolution, vertMinAngle, vertMaxAngle,
+    rangeResolution, rangeMin, rangeMax, alwaysOn, visualize);
+
+  gz::rendering::RenderEngine *engine =
+    gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  gz::sensors::Manager mgr;
+  gz::sensors::GpuLidarSensor *sensor =
+      mgr.CreateSensor<gz::sensors::GpuLidarSensor>(lidarSdf);
+  ASSERT_NE(nullptr, sensor);
+  sensor->SetScene(scene);
+  EXPECT_EQ(1u, sensor->ScanBatchSize());
+  sensor->SetScanBatchSize(0u);
+  EXPECT_EQ(1u, sensor->ScanBatchSize());
+  const unsigned int batchSize = 3u;
+  sensor->SetScanBatchSize(batchSize);
+  EXPECT_EQ(batchSize, sensor->ScanBatchSize());
+
+  std::mutex mutex;
+  std::vector<gz::msgs::PointCloudPacked> clouds;
+  std::function<void(const gz::msgs::PointCloudPacked &)> cloudCb =
+      [&](const gz::msgs::PointCloudPacked &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        clouds.push_back(_msg);
+      };
+  gz::transport::Node node;
+  node.Subscribe(topic + "/points", cloudCb);
+  WaitForMessageTestHelper<gz::msgs::PointCloudPacked> helper(
+      topic + "/points");
+
+  // Nothing is published until the batch is complete
+  for (unsigned int k = 0u; k < batchSize; ++k)
+    mgr.RunOnce(std::chrono::milliseconds(10 * k), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  for (int i = 0; i < 300; ++i)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!clouds.empty())
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(1u, clouds.size());
+  const gz::msgs::PointCloudPacked &cloud = clouds.back();
+  EXPECT_EQ(batchSize * vertSamples, cloud.height());
+  EXPECT_EQ(static_cast<uint32_t>(horzSamples), cloud.width());
+  EXPECT_EQ(static_cast<std::size_t>(cloud.row_step()) * cloud.height(),
+      cloud.data().size());
+
+  bool foundStamps = false;
+  for (const auto &data : cloud.header().data())
+  {
+    if (data.key() != "scan_stamps")
+      continue;
+    foundStamps = true;
+    ASSERT_EQ(static_cast<int>(batchSize), data.value_size());
+    for (unsigned int k = 0u; k < batchSize; ++k)
+      EXPECT_EQ(std::to_string(10000000 * k), data.value(k));
+  }
+  EXPECT_TRUE(foundStamps);
+
+  // Clean up
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+/// \brief Test strongest and last returns
+void GpuLidarSensorTest::DualReturn(const std::string &_renderEngine)
+{
+  // Create SDF describing a gpu lidar sensor
+  const std::string name = "TestGpuLidar";
+  const std::string topic = "/gz/sensors/test/lidar_dual_return";
+  const double updateRate = 10;
+  const int horzSamples = 64;
+  const double horzResolution = 1;
+  const double horzMinAngle = -GZ_PI/4.0;
+  const double horzMaxAngle = GZ_PI/4.0;
+  const double vertResolution = 1;
+  const int vertSamples = 1;
+  const double vertMinAngle = 0;
+  const double vertMaxAngle = 0;
+  const double rangeResolution = 0.01;
+  const double rangeMin = 0.08;
+  const double rangeMax = 10.0;
+  const bool alwaysOn = 1;
+  const bool visualize = 1;
+
+  gz::math::Pose3d testPose(gz::math::Vector3d(0.0, 0.0, 0.1),
+      gz::math::Quaterniond::Identity);
+  sdf::ElementPtr lidarSdf = GpuLidarToSdf(name, testPose, updateRate, topic,
+    horzSamples, horzResolution, horzMinAngle, horzMaxAngle,
+    vertSamples, vertResolution, vertMinAngle, vertMaxAngle,
+    rangeResolution, rangeMin, rangeMax, alwaysOn, visualize);
+
+  gz::rendering::RenderEngine *engine =
+    gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  // Narrow box in front of the sensor, its front face is at x = 1, and a
+  // wall behind it, its front face at x = 4
+  gz::rendering::VisualPtr visualBox1 = scene->CreateVisual("TestBox1");
+  visualBox1->AddGeometry(scene->CreateBox());
+  visualBox1->SetLocalPosition(1.5, 0, 0.5);
+  visualBox1->SetLocalScale(1, 0.5, 1);
+  root->AddChild(visualBox1);
+  gz::rendering::VisualPtr visualBox2 = scene->CreateVisual("TestBox2");
+  visualBox2->AddGeometry(scene->CreateBox());
+  visualBox2->SetLocalPosition(4.5, 0, 0.5);
+  visualBox2->SetLocalScale(1, 20, 1);
+  root->AddChild(visualBox2);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::GpuLidarSensor *sensor =
+      mgr.CreateSensor<gz::sensors::GpuLidarSensor>(lidarSdf);
+  ASSERT_NE(nullptr, sensor);
+  sensor->SetScene(scene);
+  EXPECT_EQ(1u, sensor->DualReturnSamples());
+  EXPECT_FALSE(sensor->SetDualReturn(5u, 0.0));
+  EXPECT_TRUE(sensor->SetDualReturn(5u, 1.0));
+  EXPECT_EQ(5u, sensor->DualReturnSamples());
+  EXPECT_DOUBLE_EQ(1.0, sensor->DualReturnSeparation());
+  EXPECT_NEAR(horzMaxAngle - horzMinAngle, sensor->HFOV().Radian(), 1e-6);
+
+  std::mutex mutex;
+  std::vector<gz::msgs::PointCloudPacked> clouds;
+  std::function<void(const gz::msgs::PointCloudPacked &)> cloudCb =
+      [&](const gz::msgs::PointCloudPacked &_msg)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        clouds.push_back(_msg);
+      };
+  gz::transport::Node node;
+  node.Subscribe(topic + "/points", cloudCb);
+  WaitForMessageTestHelper<gz::msgs::PointCloudPacked> helper(
+      topic + "/points");
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  for (int i = 0; i < 300; ++i)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!clouds.empty())
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_FALSE(clouds.empty());
+  const gz::msgs::PointCloudPacked &cloud = clouds.back();
+  EXPECT_EQ(static_cast<uint32_t>(horzSamples), cloud.width());
+  ASSERT_EQ(7, cloud.field_size());
+  EXPECT_EQ("range2", cloud.field(5).name());
+  EXPECT_EQ(gz::msgs::PointCloudPacked::Field::FLOAT32,
+      cloud.field(5).datatype());
+  EXPECT_EQ("intensity2", cloud.field(6).name());
+  ASSERT_EQ(static_cast<std::size_t>(cloud.row_step()) * cloud.height(),
+      cloud.data().size());
+
+  const char *data = cloud.data().data();
+  const uint32_t step = cloud.point_step();
+  const uint32_t range2Offset = cloud.field(5).offset();
+
+  // Rays hitting the middle of the box have a single return
+  const int mid = horzSamples / 2;
+  float midX = 0.0f;
+  float midRange2 = 0.0f;
+  std::memcpy(&midX, data + mid * step, sizeof(midX));
+  std::memcpy(&midRange2, data + mid * step + range2Offset,
+      sizeof(midRange2));
+  EXPECT_NEAR(1.0, midX, 0.05);
+  EXPECT_TRUE(std::isinf(midRange2));
+
+  // Rays across the edges of the box also see the wall
+  int dualPoints = 0;
+  for (int i = 0; i < horzSamples; ++i)
+  {
+    float x = 0.0f;
+    float range2 = 0.0f;
+    std::memcpy(&x, data + i * step, sizeof(x));
+    std::memcpy(&range2, data + i * step + range2Offset, sizeof(range2));
+    if (std::isfinite(range2))
+    {
+      ++dualPoints;
+      EXPECT_NEAR(1.0, x, 0.05);
+      EXPECT_GT(range2, 3.9f);
+    }
+  }
+  EXPECT_GT(dualPoints, 0);
+
+  // Clean up
+  visualBox1.reset();
+  visualBox2.reset();
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
 /////////////////////////////////////////////////
 #ifdef __APPLE__
 TEST_P(GpuLidarSensorTest, DISABLED_CreateGpuLidar)
@@ -978,6 +1578,56 @@ TEST_P(GpuLidarSensorTest, ManualUpdate)
   ManualUpdate(GetParam());
 }
 
+/////////////////////////////////////////////////
+#ifdef __APPLE__
+TEST_P(GpuLidarSensorTest, DISABLED_RangeImage)
+#else
+TEST_P(GpuLidarSensorTest, RangeImage)
+#endif
+{
+  RangeImage(GetParam());
+}
+
+/////////////////////////////////////////////////
+#ifdef __APPLE__
+TEST_P(GpuLidarSensorTest, DISABLED_RollingScan)
+#else
+TEST_P(GpuLidarSensorTest, RollingScan)
+#endif
+{
+  RollingScan(GetParam());
+}
+
+/////////////////////////////////////////////////
+#ifdef __APPLE__
+TEST_P(GpuLidarSensorTest, DISABLED_BeamAngles)
+#else
+TEST_P(GpuLidarSensorTest, BeamAngles)
+#endif
+{
+  BeamAngles(GetParam());
+}
+
+/////////////////////////////////////////////////
+#ifdef __APPLE__
+TEST_P(GpuLidarSensorTest, DISABLED_ScanBatch)
+#else
+TEST_P(GpuLidarSensorTest, ScanBatch)
+#endif
+{
+  ScanBatch(GetParam());
+}
+
+/////////////////////////////////////////////////
+#ifdef __APPLE__
+TEST_P(GpuLidarSensorTest, DISABLED_DualReturn)
+#else
+TEST_P(GpuLidarSensorTest, DualReturn)
+#endif
+{
+  DualReturn(GetParam());
+}
+
 /////////////////////////////////////////////////
 TEST_P(GpuLidarSensorTest, Topic)
 {
@@ -17,6 +17,8 @@
 
 #include <gtest/gtest.h>
 
+#include <string>
+
 #include <sdf/sdf.hh>
 
 #include <gz/msgs/imu.pb.h>
@@ -230,6 +232,47 @@ TEST_F(ImuSensorTest, SensorReadings)
       gz::msgs::Convert(msg.orientation()));
 }
 
+/////////////////////////////////////////////////
+TEST_F(ImuSensorTest, ReusedMessage)
+{
+  const std::string name = "TestImuReused";
+  const std::string topic = "/gz/sensors/test/imu_reused";
+  sdf::ElementPtr imuSdf = ImuToSdf(name, gz::math::Pose3d::Zero, 30,
+      topic, true, false);
+
+  gz::sensors::SensorFactory sf;
+  auto sensor = sf.CreateSensor<gz::sensors::ImuSensor>(imuSdf);
+  ASSERT_NE(nullptr, sensor);
+  WaitForMessageTestHelper<gz::msgs::IMU> msgHelper(topic);
+
+  // The fields filled on load are in every message, and the header isn't
+  // appended to
+  for (int i = 1; i <= 3; ++i)
+  {
+    EXPECT_TRUE(sensor->Update(std::chrono::seconds(i)));
+    ASSERT_TRUE(msgHelper.WaitForMessage()) << msgHelper;
+    const auto msg = msgHelper.Message();
+    EXPECT_EQ(i, msg.header().stamp().sec());
+    EXPECT_EQ(name, msg.entity_name());
+    EXPECT_EQ(9, msg.linear_acceleration_covariance().data_size());
+    EXPECT_EQ(9, msg.angular_velocity_covariance().data_size());
+    EXPECT_EQ(9, msg.orientation_covariance().data_size());
+    ASSERT_EQ(2, msg.header().data_size());
+    EXPECT_EQ("frame_id", msg.header().data(0).key());
+    EXPECT_EQ(1, msg.header().data(0).value_size());
+    EXPECT_EQ("seq", msg.header().data(1).key());
+    ASSERT_EQ(1, msg.header().data(1).value_size());
+    EXPECT_EQ(std::to_string(i - 1), msg.header().data(1).value(0));
+    EXPECT_TRUE(msg.has_orientation());
+  }
+
+  // Disabling the orientation clears it from the reused message
+  sensor->SetOrientationEnabled(false);
+  EXPECT_TRUE(sensor->Update(std::chrono::seconds(4)));
+  ASSERT_TRUE(msgHelper.WaitForMessage()) << msgHelper;
+  EXPECT_FALSE(msgHelper.Message().has_orientation());
+}
+
 /////////////////////////////////////////////////
 TEST_F(ImuSensorTest, Topic)
 {
@@ -17,16 +17,24 @@
 
 #include <gtest/gtest.h>
 
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
 #include <gz/msgs/logical_camera_image.pb.h>
 
 #include <sdf/sdf.hh>
 
 #include <gz/common/Console.hh>
 
+#include <gz/sensors/LogicalCameraModelIndex.hh>
 #include <gz/sensors/LogicalCameraSensor.hh>
 #include <gz/sensors/SensorFactory.hh>
 #include <gz/sensors/Export.hh>
 
+#include <gz/math/AxisAlignedBox.hh>
 #include <gz/math/Helpers.hh>
 #include <gz/msgs/Utility.hh>
 #include <gz/transport/Node.hh>
@@ -180,6 +188,12 @@ TEST_F(LogicalCameraSensorTest, DetectBox)
   gz::math::Pose3d boxPoseCameraFrame = sensorPose.Inverse() * boxPose;
   EXPECT_EQ(boxPoseCameraFrame, gz::msgs::Convert(img.model(0).pose()));
 
+  // latest image snapshot
+  auto latest = sensor->LatestImage();
+  ASSERT_NE(nullptr, latest);
+  EXPECT_EQ(1, latest->model().size());
+  EXPECT_EQ(latest, sensor->LatestImage());
+
   // 2. test box outside of frustum
   std::map<std::string, gz::math::Pose3d> modelPoses2;
   gz::math::Pose3d boxPose2(gz::math::Vector3d(8, 0, 0.5),
@@ -195,6 +209,11 @@ TEST_F(LogicalCameraSensorTest, DetectBox)
   EXPECT_EQ(sensorPose, gz::msgs::Convert(img.pose()));
   EXPECT_EQ(0, img.model().size());
 
+  // the previous snapshot is kept, a new one is taken
+  EXPECT_EQ(1, latest->model().size());
+  ASSERT_NE(latest, sensor->LatestImage());
+  EXPECT_EQ(0, sensor->LatestImage()->model().size());
+
   // 3. test with different sensor pose
   // camera now on y, orientated to face box
   std::map<std::string, gz::math::Pose3d> modelPoses3;
@@ -238,6 +257,209 @@ TEST_F(LogicalCameraSensorTest, DetectBox)
   EXPECT_TRUE(helper.WaitForMessage()) << helper;
 }
 
+/////////////////////////////////////////////////
+/// \brief Test detecting boxes from a model index shared by two cameras
+TEST_F(LogicalCameraSensorTest, SharedModelIndex)
+{
+  const double updateRate = 30;
+  const double near = 0.55;
+  const double far = 5;
+  const double horzFov = 1.04719755;
+  const double aspectRatio = 1.778;
+
+  // Two cameras looking along +x and -x
+  gz::math::Pose3d sensorPose1(gz::math::Vector3d(0.25, 0.0, 0.5),
+      gz::math::Quaterniond::Identity);
+  gz::math::Pose3d sensorPose2(gz::math::Vector3d(-0.25, 0.0, 0.5),
+      gz::math::Quaterniond(0, 0, GZ_PI));
+
+  gz::sensors::SensorFactory sf;
+  auto sensor1 = sf.CreateSensor<gz::sensors::LogicalCameraSensor>(
+      LogicalCameraToSdf("camera1", sensorPose1, updateRate,
+        "/gz/sensors/test/logical_camera1", near, far, horzFov,
+        aspectRatio, true, false));
+  ASSERT_NE(nullptr, sensor1);
+  auto sensor2 = sf.CreateSensor<gz::sensors::LogicalCameraSensor>(
+      LogicalCameraToSdf("camera2", sensorPose2, updateRate,
+        "/gz/sensors/test/logical_camera2", near, far, horzFov,
+        aspectRatio, true, false));
+  ASSERT_NE(nullptr, sensor2);
+
+  auto index = std::make_shared<gz::sensors::LogicalCameraModelIndex>(1.0);
+  EXPECT_DOUBLE_EQ(1.0, index->CellSize());
+  sensor1->SetModelIndex(index);
+  sensor2->SetModelIndex(index);
+  EXPECT_EQ(index, sensor1->ModelIndex());
+
+  // Poses given to the sensors are ignored while they use the index
+  std::map<std::string, gz::math::Pose3d> ignoredPoses;
+  ignoredPoses["ignored"] = gz::math::Pose3d(2, 0, 0.5, 0, 0, 0);
+  sensor1->SetModelPoses(std::move(ignoredPoses));
+
+  std::map<std::string, gz::math::Pose3d> modelPoses;
+  modelPoses["front"] = gz::math::Pose3d(2, 0, 0.5, 0, 0, 0);
+  modelPoses["back"] = gz::math::Pose3d(-2, 0, 0.5, 0, 0, 0);
+  modelPoses["far"] = gz::math::Pose3d(100, 0, 0.5, 0, 0, 0);
+  index->SetModelPoses(modelPoses);
+  EXPECT_EQ(3u, index->ModelCount());
+
+  sensor1->Update(std::chrono::steady_clock::duration::zero());
+  sensor2->Update(std::chrono::steady_clock::duration::zero());
+  auto img = sensor1->Image();
+  ASSERT_EQ(1, img.model().size());
+  EXPECT_EQ("front", img.model(0).name());
+  EXPECT_EQ(sensorPose1.Inverse() * modelPoses["front"],
+      gz::msgs::Convert(img.model(0).pose()));
+  img = sensor2->Image();
+  ASSERT_EQ(1, img.model().size());
+  EXPECT_EQ("back", img.model(0).name());
+
+  // Moved and removed models are updated in the index
+  modelPoses.erase("back");
+  modelPoses["far"] = gz::math::Pose3d(3, 0.1, 0.5, 0, 0, 0);
+  index->SetModelPoses(modelPoses);
+  EXPECT_EQ(2u, index->ModelCount());
+
+  sensor1->Update(std::chrono::steady_clock::duration::zero());
+  sensor2->Update(std::chrono::steady_clock::duration::zero());
+  img = sensor1->Image();
+  ASSERT_EQ(2, img.model().size());
+  std::set<std::string> names{img.model(0).name(), img.model(1).name()};
+  EXPECT_EQ((std::set<std::string>{"far", "front"}), names);
+  EXPECT_EQ(0, sensor2->Image().model().size());
+
+  // Going back to the poses given to the sensor
+  sensor1->SetModelIndex(nullptr);
+  EXPECT_EQ(nullptr, sensor1->ModelIndex());
+  sensor1->Update(std::chrono::steady_clock::duration::zero());
+  img = sensor1->Image();
+  ASSERT_EQ(1, img.model().size());
+  EXPECT_EQ("ignored", img.model(0).name());
+}
+
+/////////////////////////////////////////////////
+/// \brief Test registering models once and pushing changed poses by id
+TEST_F(LogicalCameraSensorTest, IncrementalModelPoses)
+{
+  gz::math::Pose3d sensorPose(gz::math::Vector3d(0.25, 0.0, 0.5),
+      gz::math::Quaterniond::Identity);
+  gz::sensors::SensorFactory sf;
+  auto sensor = sf.CreateSensor<gz::sensors::LogicalCameraSensor>(
+      LogicalCameraToSdf("camera", sensorPose, 30,
+        "/gz/sensors/test/logical_camera", 0.55, 5, 1.04719755, 1.778,
+        true, false));
+  ASSERT_NE(nullptr, sensor);
+
+  auto index = std::make_shared<gz::sensors::LogicalCameraModelIndex>();
+  sensor->SetModelIndex(index);
+
+  const std::size_t box1 =
+      index->AddModel("box1", gz::math::Pose3d(2, 0, 0.5, 0, 0, 0));
+  const std::size_t box2 =
+      index->AddModel("box2", gz::math::Pose3d(20, 0, 0.5, 0, 0, 0));
+  EXPECT_NE(box1, box2);
+  EXPECT_EQ(2u, index->ModelCount());
+  ASSERT_TRUE(index->ModelId("box2").has_value());
+  EXPECT_EQ(box2, *index->ModelId("box2"));
+  EXPECT_FALSE(index->ModelId("box3").has_value());
+
+  // Adding a model again sets its pose
+  EXPECT_EQ(box1,
+      index->AddModel("box1", gz::math::Pose3d(2, 0.1, 0.5, 0, 0, 0)));
+  EXPECT_EQ(2u, index->ModelCount());
+
+  sensor->Update(std::chrono::steady_clock::duration::zero());
+  auto img = sensor->Image();
+  ASSERT_EQ(1, img.model().size());
+  EXPECT_EQ("box1", img.model(0).name());
+  EXPECT_EQ(sensorPose.Inverse() * gz::math::Pose3d(2, 0.1, 0.5, 0, 0, 0),
+      gz::msgs::Convert(img.model(0).pose()));
+
+  // Only push the poses that changed
+  index->SetModelPoses({{box2, gz::math::Pose3d(3, 0, 0.5, 0, 0, 0)},
+                        {42u, gz::math::Pose3d::Zero}});
+  sensor->Update(std::chrono::steady_clock::duration::zero());
+  img = sensor->Image();
+  ASSERT_EQ(2, img.model().size());
+  std::set<std::string> names{img.model(0).name(), img.model(1).name()};
+  EXPECT_EQ((std::set<std::string>{"box1", "box2"}), names);
+
+  EXPECT_TRUE(index->SetModelPose(box1,
+      gz::math::Pose3d(-2, 0, 0.5, 0, 0, 0)));
+  EXPECT_FALSE(index->SetModelPose(42u, gz::math::Pose3d::Zero));
+  sensor->Update(std::chrono::steady_clock::duration::zero());
+  img = sensor->Image();
+  ASSERT_EQ(1, img.model().size());
+  EXPECT_EQ("box2", img.model(0).name());
+
+  EXPECT_TRUE(index->RemoveModel(box2));
+  EXPECT_FALSE(index->RemoveModel(box2));
+  EXPECT_EQ(1u, index->ModelCount());
+  EXPECT_FALSE(index->ModelId("box2").has_value());
+  sensor->Update(std::chrono::steady_clock::duration::zero());
+  EXPECT_EQ(0, sensor->Image().model().size());
+}
+
+/////////////////////////////////////////////////
+/// \brief Test detecting models by their bounding volumes
+TEST_F(LogicalCameraSensorTest, BoundingVolumeDetection)
+{
+  gz::math::Pose3d sensorPose(gz::math::Vector3d(0.0, 0.0, 0.0),
+      gz::math::Quaterniond::Identity);
+  gz::sensors::SensorFactory sf;
+  auto sensor = sf.CreateSensor<gz::sensors::LogicalCameraSensor>(
+      LogicalCameraToSdf("camera", sensorPose, 30,
+        "/gz/sensors/test/logical_camera", 0.55, 5, 1.04719755, 1.778,
+        true, false));
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_FALSE(sensor->BoundingVolumeDetection());
+
+  auto index = std::make_shared<gz::sensors::LogicalCameraModelIndex>(1.0);
+  sensor->SetModelIndex(index);
+
+  // Origin beyond the far plane, bounds reaching into the frustum
+  const std::size_t wall =
+      index->AddModel("wall", gz::math::Pose3d(6, 0, 0, 0, 0, 0));
+  EXPECT_TRUE(index->SetModelBounds(wall, gz::math::AxisAlignedBox(
+      gz::math::Vector3d(-1.5, -0.5, -0.5),
+      gz::math::Vector3d(0.5, 0.5, 0.5))));
+  // Origin within the frustum, without bounds
+  index->AddModel("box", gz::math::Pose3d(2, 0, 0, 0, 0, 0));
+  // Far from the frustum, small bounds
+  const std::size_t ball =
+      index->AddModel("ball", gz::math::Pose3d(20, 20, 0, 0, 0, 0));
+  EXPECT_TRUE(index->SetModelBounds(ball, gz::math::AxisAlignedBox(
+      gz::math::Vector3d(-0.1, -0.1, -0.1),
+      gz::math::Vector3d(0.1, 0.1, 0.1))));
+  EXPECT_FALSE(index->SetModelBounds(42u, gz::math::AxisAlignedBox()));
+
+  sensor->Update(std::chrono::steady_clock::duration::zero());
+  auto img = sensor->Image();
+  ASSERT_EQ(1, img.model().size());
+  EXPECT_EQ("box", img.model(0).name());
+
+  sensor->SetBoundingVolumeDetection(true);
+  EXPECT_TRUE(sensor->BoundingVolumeDetection());
+  sensor->Update(std::chrono::steady_clock::duration::zero());
+  img = sensor->Image();
+  ASSERT_EQ(2, img.model().size());
+  std::set<std::string> names{img.model(0).name(), img.model(1).name()};
+  EXPECT_EQ((std::set<std::string>{"box", "wall"}), names);
+  for (const auto &model : img.model())
+  {
+    if (model.name() == "wall")
+    {
+      EXPECT_EQ(gz::math::Pose3d(6, 0, 0, 0, 0, 0),
+          gz::msgs::Convert(model.pose()));
+    }
+  }
+
+  // Bounds move with their model
+  index->SetModelPose(wall, gz::math::Pose3d(6, 0, 0, 0, 0, GZ_PI));
+  sensor->Update(std::chrono::steady_clock::duration::zero());
+  EXPECT_EQ(1, sensor->Image().model().size());
+}
+
 /////////////////////////////////////////////////
 TEST_F(LogicalCameraSensorTest, Topic)
 {
@@ -294,3 +516,99 @@ TEST_F(LogicalCameraSensorTest, Topic)
     ASSERT_EQ(nullptr, sensor);
   }
 }
+
+/////////////////////////////////////////////////
+/// \brief Test publishing the models that changed since the last image
+TEST_F(LogicalCameraSensorTest, DeltaPublishing)
+{
+  const std::string topic = "/gz/sensors/test/logical_camera_delta";
+  gz::math::Pose3d sensorPose(gz::math::Vector3d(0.0, 0.0, 0.0),
+      gz::math::Quaterniond::Identity);
+  gz::sensors::SensorFactory sf;
+  auto sensor = sf.CreateSensor<gz::sensors::LogicalCameraSensor>(
+      LogicalCameraToSdf("camera", sensorPose, 30, topic, 0.55, 5,
+        1.04719755, 1.778, true, false));
+  ASSERT_NE(nullptr, sensor);
+  EXPECT_DOUBLE_EQ(0.0, sensor->DeltaPositionTolerance());
+  EXPECT_EQ(100u, sensor->DeltaKeyframePeriod());
+
+  sensor->SetDeltaPublishing(0.1, GZ_DTOR(5), 3);
+  EXPECT_DOUBLE_EQ(0.1, sensor->DeltaPositionTolerance());
+  EXPECT_NEAR(GZ_DTOR(5), sensor->DeltaRotationTolerance().Radian(), 1e-9);
+  EXPECT_EQ(3u, sensor->DeltaKeyframePeriod());
+
+  auto values = [](const gz::msgs::LogicalCameraImage &_msg,
+      const std::string &_key)
+  {
+    std::vector<std::string> result;
+    for (const auto &data : _msg.header().data())
+    {
+      if (data.key() == _key)
+        result.assign(data.value().begin(), data.value().end());
+    }
+    return result;
+  };
+  auto names = [](const gz::msgs::LogicalCameraImage &_msg)
+  {
+    std::set<std::string> result;
+    for (const auto &model : _msg.model())
+      result.insert(model.name());
+    return result;
+  };
+
+  WaitForMessageTestHelper<gz::msgs::LogicalCameraImage> helper(
+      topic + "/delta");
+  EXPECT_TRUE(sensor->HasConnections());
+  auto update = [&](std::map<std::string, gz::math::Pose3d> _poses)
+  {
+    sensor->SetModelPoses(std::move(_poses));
+    sensor->Update(std::chrono::steady_clock::duration::zero());
+    return helper.WaitForMessage(std::chrono::seconds(5));
+  };
+
+  // The first delta is a keyframe
+  ASSERT_TRUE(update({{"box1", gz::math::Pose3d(2, 0, 0, 0, 0, 0)},
+                      {"box2", gz::math::Pose3d(3, 0, 0, 0, 0, 0)}}))
+      << helper;
+  auto msg = helper.Message();
+  EXPECT_EQ(std::vector<std::string>{"1"}, values(msg, "keyframe"));
+  EXPECT_EQ((std::set<std::string>{"box1", "box2"}), names(msg));
+  EXPECT_TRUE(values(msg, "left").empty());
+
+  // Changes within the tolerances aren't published, box3 enters
+  ASSERT_TRUE(update({{"box1", gz::math::Pose3d(2.05, 0, 0, 0, 0, 0)},
+                      {"box2", gz::math::Pose3d(3.5, 0, 0, 0, 0, 0)},
+                      {"box3", gz::math::Pose3d(4, 0, 0, 0, 0, 0)}}))
+      << helper;
+  msg = helper.Message();
+  EXPECT_EQ(std::vector<std::string>{"0"}, values(msg, "keyframe"));
+  EXPECT_EQ((std::set<std::string>{"box2", "box3"}), names(msg));
+  for (const auto &model : msg.model())
+  {
+    if (model.name() == "box2")
+    {
+      EXPECT_EQ(gz::math::Pose3d(3.5, 0, 0, 0, 0, 0),
+          gz::msgs::Convert(model.pose()));
+    }
+  }
+
+  // Tolerances are from the last published pose, box1 rotates and box2
+  // leaves
+  ASSERT_TRUE(update({{"box1", gz::math::Pose3d(2.05, 0, 0, 0, 0, 0.2)},
+                      {"box2", gz::math::Pose3d(8, 0, 0, 0, 0, 0)},
+                      {"box3", gz::math::Pose3d(4, 0, 0, 0, 0, 0)}}))
+      << helper;
+  msg = helper.Message();
+  EXPECT_EQ(std::vector<std::string>{"0"}, values(msg, "keyframe"));
+  EXPECT_EQ((std::set<std::string>{"box1"}), names(msg));
+  EXPECT_EQ(std::vector<std::string>{"box2"}, values(msg, "left"));
+
+  // Every third delta is a keyframe
+  ASSERT_TRUE(update({{"box1", gz::math::Pose3d(2.05, 0, 0, 0, 0, 0.2)},
+                      {"box3", gz::math::Pose3d(4, 0, 0, 0, 0, 0)}}))
+      << helper;
+  msg = helper.Message();
+  EXPECT_EQ(std::vector<std::string>{"1"}, values(msg, "keyframe"));
+  EXPECT_EQ((std::set<std::string>{"box1", "box3"}), names(msg));
+  EXPECT_TRUE(values(msg, "left").empty());
+}
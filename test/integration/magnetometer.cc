@@ -19,9 +19,15 @@
 
 #include <sdf/sdf.hh>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <gz/msgs/magnetometer.pb.h>
 
+#include <gz/sensors/MagneticDipoleModel.hh>
 #include <gz/sensors/MagnetometerSensor.hh>
+#include <gz/sensors/Manager.hh>
 #include <gz/sensors/SensorFactory.hh>
 
 #include "test_config.hh"  // NOLINT(build/include)
@@ -288,6 +294,75 @@ TEST_F(MagnetometerSensorTest, SensorReadings)
   EXPECT_EQ(localField, gz::msgs::Convert(msg.field_tesla()));
 }
 
+/////////////////////////////////////////////////
+TEST_F(MagnetometerSensorTest, FieldModel)
+{
+  namespace math = gz::math;
+
+  // Create a sensor manager that updates magnetometers as a group
+  gz::sensors::Manager mgr;
+  mgr.SetGroupedUpdate(true);
+
+  math::SphericalCoordinates origin(
+      math::SphericalCoordinates::EARTH_WGS84, GZ_DTOR(47.37),
+      GZ_DTOR(8.55), 400.0, 0.0);
+  auto model = std::make_shared<gz::sensors::MagneticDipoleModel>(
+      origin, 2024.0, 100.0);
+
+  std::vector<gz::sensors::MagnetometerSensor *> sensors;
+  std::vector<math::Pose3d> poses;
+  std::vector<std::unique_ptr<
+      WaitForMessageTestHelper<gz::msgs::Magnetometer>>> helpers;
+  for (int i = 0; i < 3; ++i)
+  {
+    const std::string topic =
+        "/gz/sensors/test/magnetometer_group" + std::to_string(i);
+    sdf::ElementPtr magnetometerSdf = MagnetometerToSdf(
+        "TestMagnetometer_Group" + std::to_string(i), math::Pose3d::Zero,
+        30, topic, true, false);
+    ASSERT_NE(nullptr, magnetometerSdf);
+
+    auto sensor =
+        mgr.CreateSensor<gz::sensors::MagnetometerSensor>(magnetometerSdf);
+    ASSERT_NE(nullptr, sensor);
+    EXPECT_EQ(nullptr, sensor->FieldModel());
+    sensor->SetFieldModel(model);
+    EXPECT_EQ(model, sensor->FieldModel());
+
+    const math::Pose3d pose(1000.0 * i, -500.0 * i, 10.0 * i,
+        0.2 * i, -0.4 * i, 0.6 * i);
+    sensor->SetWorldPose(pose);
+    sensors.push_back(sensor);
+    poses.push_back(pose);
+    helpers.push_back(std::make_unique<
+        WaitForMessageTestHelper<gz::msgs::Magnetometer>>(topic));
+  }
+
+  mgr.RunOnce(std::chrono::seconds(1));
+
+  // Each sensor measures the field of its region in the model, in its
+  // own frame. Fields are compared in microteslas, as vectors are equal
+  // within 1e-6.
+  for (std::size_t i = 0; i < sensors.size(); ++i)
+  {
+    const math::Vector3d worldField = model->Field(poses[i].Pos());
+    EXPECT_LT(20e-6, worldField.Length());
+    EXPECT_GT(70e-6, worldField.Length());
+    EXPECT_EQ(worldField * 1e6, sensors[i]->WorldMagneticField() * 1e6);
+
+    EXPECT_TRUE(helpers[i]->WaitForMessage()) << *helpers[i];
+    auto msg = helpers[i]->Message();
+    EXPECT_EQ(poses[i].Rot().Inverse().RotateVector(worldField) * 1e6,
+              gz::msgs::Convert(msg.field_tesla()) * 1e6);
+  }
+
+  // Without a model the field set directly is used again
+  sensors[0]->SetFieldModel(nullptr);
+  sensors[0]->SetWorldMagneticField(math::Vector3d(1, 2, 3));
+  EXPECT_TRUE(sensors[0]->Update(std::chrono::seconds(2)));
+  EXPECT_EQ(math::Vector3d(1, 2, 3), sensors[0]->MagneticField());
+}
+
 /////////////////////////////////////////////////
 TEST_F(MagnetometerSensorTest, Topic)
 {
@@ -20,6 +20,7 @@
 #include <sdf/sdf.hh>
 
 #include <gz/math/Helpers.hh>
+#include <gz/math/SphericalCoordinates.hh>
 
 #include <gz/msgs/navsat.pb.h>
 
@@ -289,6 +290,55 @@ TEST_F(NavSatSensorTest, SensorReadings)
   EXPECT_FALSE(math::equal(velocity.Z(), msgNoise.velocity_up()));
 }
 
+/////////////////////////////////////////////////
+TEST_F(NavSatSensorTest, WorldPosition)
+{
+  auto navsatSdf = NavSatToSdf("TestNavSat", math::Pose3d(), 30.0,
+      "/gz/sensors/test/navsat_world", true, false);
+
+  SensorFactory sf;
+  auto exact = sf.CreateSensor<NavSatSensor>(navsatSdf);
+  ASSERT_NE(nullptr, exact);
+  auto linearized = sf.CreateSensor<NavSatSensor>(navsatSdf);
+  ASSERT_NE(nullptr, linearized);
+
+  const math::SphericalCoordinates origin(
+      math::SphericalCoordinates::EARTH_WGS84, GZ_DTOR(47.3667),
+      GZ_DTOR(8.55), 500.0, GZ_DTOR(30.0));
+  exact->SetSphericalCoordinates(origin);
+  linearized->SetSphericalCoordinates(origin);
+  EXPECT_DOUBLE_EQ(0.0, linearized->LinearizationDistance());
+  linearized->SetLinearizationDistance(100.0);
+  EXPECT_DOUBLE_EQ(100.0, linearized->LinearizationDistance());
+
+  // The origin maps to the reference coordinates
+  exact->SetWorldPosition(math::Vector3d::Zero);
+  EXPECT_NEAR(47.3667, exact->Latitude().Degree(), 1e-9);
+  EXPECT_NEAR(8.55, exact->Longitude().Degree(), 1e-9);
+  EXPECT_NEAR(500.0, exact->Altitude(), 1e-6);
+
+  // Move along a path of a few kilometers, so the sensor both uses and
+  // refreshes its linearization
+  for (int i = 0; i < 200; ++i)
+  {
+    const math::Vector3d pos(17.0 * i, -9.0 * i, 0.5 * i);
+    exact->SetWorldPosition(pos);
+    linearized->SetWorldPosition(pos);
+
+    // 1e-7 degrees is about a centimeter
+    EXPECT_NEAR(exact->Latitude().Degree(), linearized->Latitude().Degree(),
+        1e-7) << i;
+    EXPECT_NEAR(exact->Longitude().Degree(),
+        linearized->Longitude().Degree(), 1e-7) << i;
+    EXPECT_NEAR(exact->Altitude(), linearized->Altitude(), 1e-2) << i;
+  }
+
+  // Velocities are rotated by the heading of the world
+  exact->SetWorldVelocity(math::Vector3d(1, 2, 3));
+  EXPECT_EQ(origin.GlobalFromLocalVelocity(math::Vector3d(1, 2, 3)),
+      exact->Velocity());
+}
+
 /////////////////////////////////////////////////
 TEST_F(NavSatSensorTest, Topic)
 {
@@ -174,6 +174,12 @@ class RgbdCameraSensorTest: public testing::Test,
 
   // Create a Camera sensor from a SDF and gets a image message
   public: void ImagesWithBuiltinSDF(const std::string &_renderEngine);
+
+  // Check that each output is produced when it is the only one subscribed
+  public: void LazyOutputs(const std::string &_renderEngine);
+
+  // Check the depths beyond the depth far clipping distance
+  public: void DepthFarClip(const std::string &_renderEngine);
 };
 
 void RgbdCameraSensorTest::ImagesWithBuiltinSDF(
@@ -753,6 +759,186 @@ void RgbdCameraSensorTest::ImagesWithBuiltinSDF(
   rendering::unloadEngine(engine->Name());
 }
 
+/////////////////////////////////////////////////
+void RgbdCameraSensorTest::LazyOutputs(const std::string &_renderEngine)
+{
+  std::string path = common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "rgbd_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support rgbd cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  rendering::ScenePtr scene = engine->CreateScene("scene");
+  scene->SetBackgroundColor(1.0, 0.0, 0.0);
+
+  sensors::Manager mgr;
+  sensors::RgbdCameraSensor *rgbdSensor =
+      mgr.CreateSensor<sensors::RgbdCameraSensor>(sensorPtr);
+  ASSERT_NE(rgbdSensor, nullptr);
+  rgbdSensor->SetScene(scene);
+
+  const std::string prefix =
+    "/test/integration/RgbdCameraPlugin_imagesWithBuiltinSDF/";
+
+  // Only the color image, the depths aren't read back
+  {
+    WaitForMessageTestHelper<msgs::Image> imageHelper(prefix + "image");
+    mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+    EXPECT_TRUE(imageHelper.WaitForMessage()) << imageHelper;
+    auto msg = imageHelper.Message();
+    EXPECT_EQ(rgbdSensor->ImageWidth(), msg.width());
+    EXPECT_EQ(rgbdSensor->ImageHeight(), msg.height());
+  }
+
+  // Only the depths, the point cloud isn't read back
+  {
+    WaitForMessageTestHelper<msgs::Image> depthHelper(
+        prefix + "depth_image");
+    mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+    EXPECT_TRUE(depthHelper.WaitForMessage()) << depthHelper;
+    auto msg = depthHelper.Message();
+    ASSERT_EQ(rgbdSensor->ImageWidth() * rgbdSensor->ImageHeight() *
+        sizeof(float), msg.data().size());
+    float depth;
+    memcpy(&depth, msg.data().data(), sizeof(depth));
+    EXPECT_FLOAT_EQ(math::INF_F, depth);
+  }
+
+  // Only the points
+  {
+    WaitForMessageTestHelper<msgs::PointCloudPacked> pointsHelper(
+        prefix + "points");
+    mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+    EXPECT_TRUE(pointsHelper.WaitForMessage()) << pointsHelper;
+    auto msg = pointsHelper.Message();
+    EXPECT_EQ(rgbdSensor->ImageWidth(), msg.width());
+    EXPECT_EQ(rgbdSensor->ImageHeight(), msg.height());
+  }
+
+  // Clean up
+  mgr.Remove(rgbdSensor->Id());
+  engine->DestroyScene(scene);
+  rendering::unloadEngine(engine->Name());
+}
+
+/////////////////////////////////////////////////
+void RgbdCameraSensorTest::DepthFarClip(const std::string &_renderEngine)
+{
+  std::string path = common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "rgbd_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // Clip the depths before the box
+  sensorPtr->GetElement("camera")->GetElement("depth_camera")
+      ->GetElement("clip")->GetElement("far")->Set(2.0);
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support rgbd cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  rendering::ScenePtr scene = engine->CreateScene("scene");
+  scene->SetBackgroundColor(1.0, 0.0, 0.0);
+  rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  scene->RootVisual()->AddChild(box);
+
+  sensors::Manager mgr;
+  sensors::RgbdCameraSensor *rgbdSensor =
+      mgr.CreateSensor<sensors::RgbdCameraSensor>(sensorPtr);
+  ASSERT_NE(rgbdSensor, nullptr);
+  rgbdSensor->SetScene(scene);
+
+  const std::string prefix =
+    "/test/integration/RgbdCameraPlugin_imagesWithBuiltinSDF/";
+  const std::size_t center =
+      rgbdSensor->ImageHeight() / 2u * rgbdSensor->ImageWidth() +
+      rgbdSensor->ImageWidth() / 2u;
+
+  // The box is beyond the depth far clipping distance, whether the render
+  // pass clips the depths, without a color image, or the CPU does
+  WaitForMessageTestHelper<msgs::Image> depthHelper(prefix + "depth_image");
+  for (bool color : {false, true})
+  {
+    std::unique_ptr<WaitForMessageTestHelper<msgs::Image>> imageHelper;
+    if (color)
+    {
+      imageHelper = std::make_unique<WaitForMessageTestHelper<msgs::Image>>(
+          prefix + "image");
+    }
+    mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+    EXPECT_TRUE(depthHelper.WaitForMessage()) << depthHelper;
+    auto msg = depthHelper.Message();
+    ASSERT_EQ(rgbdSensor->ImageWidth() * rgbdSensor->ImageHeight() *
+        sizeof(float), msg.data().size());
+    float depth;
+    memcpy(&depth, msg.data().data() + center * sizeof(depth),
+        sizeof(depth));
+    EXPECT_FLOAT_EQ(math::INF_F, depth) << color;
+
+    // The box is still within the far clip plane of the color image, so it
+    // hides the red background
+    if (imageHelper)
+    {
+      EXPECT_TRUE(imageHelper->WaitForMessage()) << *imageHelper;
+      auto image = imageHelper->Message();
+      ASSERT_EQ(rgbdSensor->ImageWidth() * rgbdSensor->ImageHeight() * 3u,
+          image.data().size());
+      const auto *rgb = reinterpret_cast<const unsigned char *>(
+          image.data().data()) + center * 3u;
+      EXPECT_FALSE(rgb[0] == 255u && rgb[1] == 0u && rgb[2] == 0u);
+    }
+  }
+
+  // Clean up
+  box.reset();
+  mgr.Remove(rgbdSensor->Id());
+  engine->DestroyScene(scene);
+  rendering::unloadEngine(engine->Name());
+}
+
 //////////////////////////////////////////////////
 TEST_P(RgbdCameraSensorTest, ImagesWithBuiltinSDF)
 {
@@ -760,5 +946,17 @@ TEST_P(RgbdCameraSensorTest, ImagesWithBuiltinSDF)
   ImagesWithBuiltinSDF(GetParam());
 }
 
+//////////////////////////////////////////////////
+TEST_P(RgbdCameraSensorTest, LazyOutputs)
+{
+  LazyOutputs(GetParam());
+}
+
+//////////////////////////////////////////////////
+TEST_P(RgbdCameraSensorTest, DepthFarClip)
+{
+  DepthFarClip(GetParam());
+}
+
 INSTANTIATE_TEST_SUITE_P(RgbdCameraSensor, RgbdCameraSensorTest,
     RENDER_ENGINE_VALUES, rendering::PrintToStringParam());
@@ -17,6 +17,9 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <vector>
+
 #include <gz/msgs/image.pb.h>
 #include <gz/msgs/camera_info.pb.h>
 
@@ -162,6 +165,9 @@ class SegmentationCameraSensorTest: public testing::Test,
 {
   // Create a Segmentation Camera sensor from a SDF and gets a image message
   public: void ImagesWithBuiltinSDF(const std::string &_renderEngine);
+
+  // Check the 16 bit and run-length encoded labels maps
+  public: void LabelsMapEncodings(const std::string &_renderEngine);
 };
 
 /////////////////////////////////////////////////
@@ -354,6 +360,135 @@ void SegmentationCameraSensorTest::ImagesWithBuiltinSDF(
   gz::rendering::unloadEngine(engine->Name());
 }
 
+/////////////////////////////////////////////////
+void SegmentationCameraSensorTest::LabelsMapEncodings(
+  const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "segmentation_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // If ogre2 is not the engine, don't run the test
+  if (_renderEngine.compare("ogre2") != 0)
+  {
+    gzdbg << "Engine '" << _renderEngine
+      << "' doesn't support segmentation cameras" << std::endl;
+    return;
+  }
+  // Setup gz-rendering with an empty scene
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  ASSERT_NE(nullptr, scene);
+  BuildScene(scene);
+
+  gz::sensors::Manager mgr;
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  gz::sensors::SegmentationCameraSensor *sensor =
+    mgr.CreateSensor<gz::sensors::SegmentationCameraSensor>(sdfSensor);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  auto camera = sensor->SegmentationCamera();
+  ASSERT_NE(camera, nullptr);
+  camera->SetSegmentationType(rendering::SegmentationType::ST_SEMANTIC);
+  camera->EnableColoredMap(true);
+  camera->SetLocalPosition(0.0, 0.0, 0.0);
+  camera->SetLocalRotation(0.0, 0.0, 0.0);
+  const uint32_t backgroundLabel = 23;
+  camera->SetBackgroundLabel(backgroundLabel);
+
+  EXPECT_FALSE(sensor->LabelsMap16Bit());
+  sensor->SetLabelsMap16Bit(true);
+  EXPECT_TRUE(sensor->LabelsMap16Bit());
+
+  const std::string topic =
+    "/test/integration/SegmentationCameraPlugin_imagesWithBuiltinSDF";
+  EXPECT_EQ(topic + "/labels_map_rle", sensor->LabelsMapRleTopic());
+
+  // The encoded maps alone keep the sensor updating
+  EXPECT_FALSE(sensor->HasConnections());
+  WaitForMessageTestHelper<gz::msgs::Image> rleHelper(
+      sensor->LabelsMapRleTopic());
+  EXPECT_TRUE(sensor->HasConnections());
+  WaitForMessageTestHelper<gz::msgs::Image> helper(topic + "/labels_map");
+
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  EXPECT_TRUE(rleHelper.WaitForMessage()) << rleHelper;
+
+  auto msg = helper.Message();
+  const unsigned int width = sensor->ImageWidth();
+  const unsigned int height = sensor->ImageHeight();
+  EXPECT_EQ(gz::msgs::PixelFormatType::L_INT16, msg.pixel_format_type());
+  EXPECT_EQ(width, msg.width());
+  EXPECT_EQ(height, msg.height());
+  EXPECT_EQ(width * 2u, msg.step());
+  ASSERT_EQ(width * height * 2u, msg.data().size());
+  std::vector<uint16_t> labels(width * height);
+  memcpy(labels.data(), msg.data().data(), msg.data().size());
+
+  // The middle box and the background
+  EXPECT_EQ(middleBoxLabel, labels[height / 2u * width + width / 2u]);
+  EXPECT_EQ(backgroundLabel, labels[0]);
+
+  // Decoding the runs gives the 16 bit labels map back
+  auto rleMsg = rleHelper.Message();
+  EXPECT_EQ(width, rleMsg.width());
+  EXPECT_EQ(height, rleMsg.height());
+  bool rleFormat = false;
+  for (const auto &data : rleMsg.header().data())
+  {
+    if (data.key() == "format" && data.value_size() > 0)
+      rleFormat = data.value(0) == "rle";
+  }
+  EXPECT_TRUE(rleFormat);
+  ASSERT_EQ(0u, rleMsg.data().size() % 4u);
+  EXPECT_LT(rleMsg.data().size(), msg.data().size());
+  std::vector<uint16_t> decoded;
+  const auto *runs =
+      reinterpret_cast<const unsigned char *>(rleMsg.data().data());
+  for (std::size_t i = 0u; i < rleMsg.data().size(); i += 4u)
+  {
+    const uint16_t label = static_cast<uint16_t>(runs[i] | runs[i + 1] << 8);
+    const std::size_t run = runs[i + 2] | runs[i + 3] << 8;
+    decoded.insert(decoded.end(), run, label);
+  }
+  EXPECT_EQ(labels, decoded);
+
+  // Without colored map consumers, the next frames render labels directly
+  EXPECT_FALSE(camera->IsColoredMap());
+  mgr.RunOnce(std::chrono::steady_clock::duration(std::chrono::seconds(1)),
+      true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+  msg = helper.Message();
+  ASSERT_EQ(width * height * 2u, msg.data().size());
+  std::vector<uint16_t> directLabels(width * height);
+  memcpy(directLabels.data(), msg.data().data(), msg.data().size());
+  EXPECT_EQ(labels, directLabels);
+
+  // Clean up rendering ptrs
+  camera.reset();
+
+  // Clean up
+  mgr.Remove(sensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
 //////////////////////////////////////////////////
 TEST_P(SegmentationCameraSensorTest, ImagesWithBuiltinSDF)
 {
@@ -361,5 +496,11 @@ TEST_P(SegmentationCameraSensorTest, ImagesWithBuiltinSDF)
   ImagesWithBuiltinSDF(GetParam());
 }
 
+//////////////////////////////////////////////////
+TEST_P(SegmentationCameraSensorTest, LabelsMapEncodings)
+{
+  LabelsMapEncodings(GetParam());
+}
+
 INSTANTIATE_TEST_SUITE_P(SegmentationCameraSensor, SegmentationCameraSensorTest,
     RENDER_ENGINE_VALUES, gz::rendering::PrintToStringParam());
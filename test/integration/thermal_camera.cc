@@ -16,11 +16,17 @@
 */
 
 #include <cstring>
+#include <string>
+#include <variant>
 #include <gtest/gtest.h>
 
 #include <gz/msgs/camera_info.pb.h>
 #include <gz/msgs/image.pb.h>
 
+#include <sdf/Camera.hh>
+#include <sdf/Noise.hh>
+#include <sdf/Sensor.hh>
+
 #include <gz/common/Filesystem.hh>
 #include <gz/common/Event.hh>
 #include <gz/sensors/Manager.hh>
@@ -108,6 +114,15 @@ class ThermalCameraSensorTest: public testing::Test,
 
   // Create a thermal camera sensor from a SDF with 8 bit image format
   public: void Images8BitWithBuiltinSDF(const std::string &_renderEngine);
+
+  // Check the false color images
+  public: void Colormap(const std::string &_renderEngine);
+
+  // Set entity temperatures through the sensor
+  public: void EntityTemperatures(const std::string &_renderEngine);
+
+  // Create a thermal camera sensor with gaussian image noise
+  public: void ImagesWithNoise(const std::string &_renderEngine);
 };
 
 void ThermalCameraSensorTest::ImagesWithBuiltinSDF(
@@ -632,5 +647,288 @@ TEST_P(ThermalCameraSensorTest, Images8BitWithBuiltinSDF)
   Images8BitWithBuiltinSDF(GetParam());
 }
 
+/////////////////////////////////////////////////
+void ThermalCameraSensorTest::Colormap(const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "thermal_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support thermal cameras" << std::endl;
+    return;
+  }
+
+  // Setup gz-rendering with an empty scene
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  // A box hotter than the ambient temperature in front of the camera
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  box->SetUserData("temperature", 310.0f);
+  root->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::ThermalCameraSensor *thermalSensor =
+      mgr.CreateSensor<gz::sensors::ThermalCameraSensor>(sensorPtr);
+  ASSERT_NE(thermalSensor, nullptr);
+  thermalSensor->SetAmbientTemperature(296.0f);
+  thermalSensor->SetLinearResolution(0.01f);
+  thermalSensor->SetScene(scene);
+
+  EXPECT_EQ(gz::sensors::ThermalColormap::IRONBOW,
+      thermalSensor->Colormap());
+  thermalSensor->SetColormap(gz::sensors::ThermalColormap::GRAYSCALE);
+  EXPECT_EQ(gz::sensors::ThermalColormap::GRAYSCALE,
+      thermalSensor->Colormap());
+
+  const std::string topic = thermalSensor->ColormapTopic();
+  EXPECT_EQ(thermalSensor->Topic() + "/colormap", topic);
+
+  // The false color images alone keep the sensor updating
+  EXPECT_FALSE(thermalSensor->HasConnections());
+  WaitForMessageTestHelper<gz::msgs::Image> helper(topic);
+  EXPECT_TRUE(thermalSensor->HasConnections());
+
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+
+  auto msg = helper.Message();
+  EXPECT_EQ(gz::msgs::PixelFormatType::RGB_INT8, msg.pixel_format_type());
+  EXPECT_EQ(thermalSensor->ImageWidth(), msg.width());
+  EXPECT_EQ(thermalSensor->ImageHeight(), msg.height());
+  EXPECT_EQ(msg.width() * 3u, msg.step());
+  ASSERT_EQ(msg.step() * msg.height(), msg.data().size());
+
+  // The box is the hottest object, so it is white, and the ambient
+  // temperature on the sides is black
+  const auto *rgb = reinterpret_cast<const unsigned char *>(
+      msg.data().data());
+  unsigned int midHeight = msg.height() / 2u;
+  unsigned int mid = (midHeight * msg.width() + msg.width() / 2u) * 3u;
+  unsigned int left = midHeight * msg.width() * 3u;
+  for (unsigned int c = 0u; c < 3u; ++c)
+  {
+    EXPECT_EQ(255u, rgb[mid + c]);
+    EXPECT_EQ(0u, rgb[left + c]);
+  }
+
+  // Clean up
+  box.reset();
+  mgr.Remove(thermalSensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(ThermalCameraSensorTest, Colormap)
+{
+  Colormap(GetParam());
+}
+
+/////////////////////////////////////////////////
+void ThermalCameraSensorTest::EntityTemperatures(
+    const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "thermal_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  ASSERT_NE(nullptr, doc->Root());
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+  ASSERT_NE(nullptr, sensorPtr);
+
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support thermal cameras" << std::endl;
+    return;
+  }
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  // A box in front of the camera, with its temperature set by the sensor
+  gz::rendering::VisualPtr box = scene->CreateVisual("hot_box");
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3.0, 0.0, 0.0);
+  root->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::ThermalCameraSensor *thermalSensor =
+      mgr.CreateSensor<gz::sensors::ThermalCameraSensor>(sensorPtr);
+  ASSERT_NE(thermalSensor, nullptr);
+  thermalSensor->SetAmbientTemperature(296.0f);
+  thermalSensor->SetLinearResolution(0.01f);
+  thermalSensor->SetScene(scene);
+
+  EXPECT_EQ(0u, thermalSensor->PendingEntityTemperatureCount());
+  thermalSensor->SetEntityTemperature("hot_box", 400.0f);
+  thermalSensor->SetEntityTemperature("not_added_yet", 350.0f);
+  EXPECT_EQ(2u, thermalSensor->PendingEntityTemperatureCount());
+
+  WaitForMessageTestHelper<gz::msgs::Image> helper(thermalSensor->Topic());
+  mgr.RunOnce(std::chrono::steady_clock::duration::zero(), true);
+  EXPECT_TRUE(helper.WaitForMessage()) << helper;
+
+  // Only the visual that isn't in the scene is still pending
+  EXPECT_EQ(1u, thermalSensor->PendingEntityTemperatureCount());
+  ASSERT_TRUE(std::holds_alternative<float>(box->UserData("temperature")));
+  EXPECT_FLOAT_EQ(400.0f, std::get<float>(box->UserData("temperature")));
+
+  auto msg = helper.Message();
+  const auto *data = reinterpret_cast<const uint16_t *>(msg.data().data());
+  unsigned int mid = msg.height() / 2u * msg.width() + msg.width() / 2u;
+  EXPECT_NEAR(400.0, data[mid] * 0.01, 1.0);
+
+  // Setting the same temperature again doesn't change anything
+  thermalSensor->SetEntityTemperature("hot_box", 400.0f);
+  EXPECT_EQ(1u, thermalSensor->PendingEntityTemperatureCount());
+
+  // A visual added later gets its temperature on the next update
+  gz::rendering::VisualPtr later = scene->CreateVisual("not_added_yet");
+  root->AddChild(later);
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  EXPECT_EQ(0u, thermalSensor->PendingEntityTemperatureCount());
+  ASSERT_TRUE(std::holds_alternative<float>(later->UserData("temperature")));
+  EXPECT_FLOAT_EQ(350.0f, std::get<float>(later->UserData("temperature")));
+
+  // Heat signatures are written with their temperature range. The visual
+  // has no geometry, so the texture isn't loaded.
+  thermalSensor->SetEntityHeatSignature("not_added_yet", "signature.png",
+      290.0f, 320.0f);
+  EXPECT_EQ(1u, thermalSensor->PendingEntityTemperatureCount());
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  EXPECT_EQ(0u, thermalSensor->PendingEntityTemperatureCount());
+  EXPECT_TRUE(std::holds_alternative<std::string>(
+      later->UserData("temperature")));
+  EXPECT_FLOAT_EQ(290.0f, std::get<float>(later->UserData("minTemp")));
+  EXPECT_FLOAT_EQ(320.0f, std::get<float>(later->UserData("maxTemp")));
+
+  // Clean up
+  box.reset();
+  later.reset();
+  mgr.Remove(thermalSensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(ThermalCameraSensorTest, EntityTemperatures)
+{
+  EntityTemperatures(GetParam());
+}
+
+//////////////////////////////////////////////////
+void ThermalCameraSensorTest::ImagesWithNoise(
+    const std::string &_renderEngine)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "thermal_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  // If ogre is not the engine, don't run the test
+  if ((_renderEngine.compare("ogre") != 0) &&
+      (_renderEngine.compare("ogre2") != 0))
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' doesn't support thermal cameras" << std::endl;
+    return;
+  }
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+
+  // Gaussian image noise used to make the camera dereference a null noise
+  // model when it was created
+  sdf::Sensor sdfSensor;
+  sdfSensor.Load(sensorPtr);
+  sdf::Camera cameraSdf = *sdfSensor.CameraSensor();
+  sdf::Noise noise;
+  noise.SetType(sdf::NoiseType::GAUSSIAN);
+  noise.SetMean(0.0);
+  noise.SetStdDev(0.01);
+  cameraSdf.SetImageNoise(noise);
+  sdfSensor.SetCameraSensor(cameraSdf);
+
+  gz::sensors::Manager mgr;
+  gz::sensors::ThermalCameraSensor *thermalSensor =
+      mgr.CreateSensor<gz::sensors::ThermalCameraSensor>(sdfSensor);
+  ASSERT_NE(thermalSensor, nullptr);
+  thermalSensor->SetScene(scene);
+
+  unsigned int count = 0u;
+  gz::msgs::Image image;
+  auto connection = thermalSensor->ConnectImageCallback(
+      [&](const gz::msgs::Image &_msg)
+      {
+        image = _msg;
+        ++count;
+      });
+
+  // The camera renders and publishes frames of the configured size
+  mgr.RunOnce(std::chrono::seconds(1), true);
+  mgr.RunOnce(std::chrono::seconds(2), true);
+  EXPECT_EQ(2u, count);
+  EXPECT_EQ(thermalSensor->ImageWidth(), image.width());
+  EXPECT_EQ(thermalSensor->ImageHeight(), image.height());
+  EXPECT_EQ(static_cast<std::size_t>(image.width()) * image.height() *
+      sizeof(uint16_t), image.data().size());
+
+  // Clean up
+  connection.reset();
+  mgr.Remove(thermalSensor->Id());
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+TEST_P(ThermalCameraSensorTest, ImagesWithNoise)
+{
+  ImagesWithNoise(GetParam());
+}
+
 INSTANTIATE_TEST_SUITE_P(ThermalCameraSensor, ThermalCameraSensorTest,
     RENDER_ENGINE_VALUES, gz::rendering::PrintToStringParam());
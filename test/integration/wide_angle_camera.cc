@@ -16,6 +16,8 @@
 */
 
 #include <cstring>
+#include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include <gz/msgs/camera_info.pb.h>
@@ -90,6 +92,9 @@ class WideAngleCameraSensorTest: public testing::Test,
 
   // Create a Camera sensor from a SDF and gets a image message
   public: void ImagesWithBuiltinSDF(const std::string &_renderEngine);
+
+  // Update the cubemap faces progressively
+  public: void ProgressiveUpdate(const std::string &_renderEngine);
 };
 
 void WideAngleCameraSensorTest::ImagesWithBuiltinSDF(
@@ -238,6 +243,130 @@ void WideAngleCameraSensorTest::ImagesWithBuiltinSDF(
   gz::rendering::unloadEngine(engine->Name());
 }
 
+//////////////////////////////////////////////////
+void WideAngleCameraSensorTest::ProgressiveUpdate(
+    const std::string &_renderEngine)
+{
+  if (_renderEngine != "ogre")
+  {
+    gzwarn << "Wide angle cameras are not supported in " << _renderEngine
+            << std::endl;
+    return;
+  }
+
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", "wide_angle_camera_sensor_builtin.sdf");
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  ASSERT_TRUE(sdf::readFile(path, doc));
+  auto sensorPtr = doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+
+  auto *engine = gz::rendering::engine(_renderEngine);
+  if (!engine)
+  {
+    gzdbg << "Engine '" << _renderEngine
+              << "' is not supported" << std::endl;
+    return;
+  }
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  scene->SetAmbientLight(1.0, 1.0, 1.0);
+  gz::rendering::VisualPtr root = scene->RootVisual();
+
+  gz::rendering::MaterialPtr blue = scene->CreateMaterial();
+  blue->SetAmbient(0.0, 0.0, 0.3);
+  blue->SetDiffuse(0.0, 0.0, 0.8);
+
+  gz::rendering::VisualPtr box = scene->CreateVisual("box");
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(gz::math::Vector3d(2.0, 0, 0));
+  box->SetMaterial(blue);
+  root->AddChild(box);
+
+  gz::sensors::Manager mgr;
+  auto *sensor =
+      mgr.CreateSensor<gz::sensors::WideAngleCameraSensor>(sensorPtr);
+  ASSERT_NE(sensor, nullptr);
+  sensor->SetScene(scene);
+
+  EXPECT_FALSE(sensor->ProgressiveUpdate());
+  EXPECT_FALSE(sensor->SetProgressiveUpdate(true, 0u));
+  EXPECT_FALSE(sensor->SetProgressiveUpdate(true, 7u));
+  EXPECT_FALSE(sensor->ProgressiveUpdate());
+  ASSERT_TRUE(sensor->SetProgressiveUpdate(true, 2u,
+      std::chrono::seconds(1)));
+  EXPECT_TRUE(sensor->ProgressiveUpdate());
+  EXPECT_EQ(2u, sensor->ProgressiveFacesPerFrame());
+  EXPECT_EQ(std::chrono::steady_clock::duration(std::chrono::seconds(1)),
+      sensor->ProgressiveStaleness());
+
+  gz::msgs::Image image;
+  auto connection = sensor->ConnectImageCallback(
+      [&image](const gz::msgs::Image &_msg)
+      {
+        image.CopyFrom(_msg);
+      });
+
+  // Stamps of the faces of the last image, in nanoseconds
+  auto faceStamps = [&image]()
+  {
+    std::vector<int64_t> stamps;
+    for (const auto &data : image.header().data())
+    {
+      if (data.key() != "face_stamps")
+        continue;
+      for (const auto &value : data.value())
+        stamps.push_back(std::stoll(value));
+    }
+    return stamps;
+  };
+
+  // The first frame renders every face, then two faces render per frame
+  using namespace std::chrono_literals;
+  ASSERT_TRUE(sensor->Update(0ms));
+  EXPECT_EQ(std::vector<int64_t>(6u, 0), faceStamps());
+
+  // The box is in front of the camera
+  const unsigned int step = image.width() * 3u;
+  const unsigned int mid = image.height() / 2u * step + step / 2u;
+  const auto *pixels =
+      reinterpret_cast<const unsigned char *>(image.data().data());
+  EXPECT_GT(pixels[mid + 2], pixels[mid + 1]);
+  EXPECT_GT(pixels[mid + 2], pixels[mid]);
+
+  ASSERT_TRUE(sensor->Update(100ms));
+  const int64_t t1 = 100000000;
+  EXPECT_EQ(std::vector<int64_t>({t1, t1, 0, 0, 0, 0}), faceStamps());
+  ASSERT_TRUE(sensor->Update(200ms));
+  const int64_t t2 = 200000000;
+  EXPECT_EQ(std::vector<int64_t>({t1, t1, t2, t2, 0, 0}), faceStamps());
+
+  // With one face per frame, faces are rendered before they get too old
+  ASSERT_TRUE(sensor->SetProgressiveUpdate(true, 1u, 250ms));
+  for (int i = 3; i < 12; ++i)
+  {
+    const auto now = std::chrono::milliseconds(i * 100);
+    ASSERT_TRUE(sensor->Update(now));
+    for (int64_t stamp : faceStamps())
+    {
+      EXPECT_GE(stamp, std::chrono::duration_cast<std::chrono::nanoseconds>(
+          now - 250ms).count()) << "frame " << i;
+    }
+  }
+
+  // Disabling it goes back to the wide angle camera
+  ASSERT_TRUE(sensor->SetProgressiveUpdate(false));
+  ASSERT_TRUE(sensor->Update(1200ms));
+  EXPECT_TRUE(faceStamps().empty());
+
+  connection.reset();
+  box.reset();
+  blue.reset();
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
 //////////////////////////////////////////////////
 TEST_P(WideAngleCameraSensorTest, ImagesWithBuiltinSDF)
 {
@@ -245,5 +374,11 @@ TEST_P(WideAngleCameraSensorTest, ImagesWithBuiltinSDF)
   ImagesWithBuiltinSDF(GetParam());
 }
 
+//////////////////////////////////////////////////
+TEST_P(WideAngleCameraSensorTest, ProgressiveUpdate)
+{
+  ProgressiveUpdate(GetParam());
+}
+
 INSTANTIATE_TEST_SUITE_P(WideAngleCameraSensor, WideAngleCameraSensorTest,
     RENDER_ENGINE_VALUES, gz::rendering::PrintToStringParam());
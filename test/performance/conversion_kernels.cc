@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sdf/sdf.hh>
+
+#include <gz/math/Angle.hh>
+#include <gz/msgs/Utility.hh>
+#include <gz/sensors/Lidar.hh>
+#include <gz/sensors/Manager.hh>
+
+#include "PointCloudUtil.hh"
+#include "ThermalConversion.hh"
+
+using namespace gz;
+using namespace std::chrono_literals;
+
+/// \brief Number of times each kernel is timed.
+constexpr int kRepeats = 20;
+
+/// \brief Number of threads of the multithreaded point cloud benchmarks.
+constexpr unsigned int kThreadCount = 4u;
+
+/// \brief Image resolutions of the camera kernels.
+const std::vector<std::pair<uint32_t, uint32_t>> kImageSizes{
+    {320u, 240u}, {640u, 480u}, {1280u, 960u}};
+
+/// \brief Horizontal and vertical samples of the lidar kernels.
+const std::vector<std::pair<uint32_t, uint32_t>> kScanSizes{
+    {360u, 16u}, {1024u, 64u}, {2048u, 128u}};
+
+//////////////////////////////////////////////////
+/// \brief Time a function and report its cost per call and per sample.
+/// Results are printed as one JSON object per line and recorded as test
+/// properties, so they end up in the XML report written with
+/// --gtest_output.
+/// \param[in] _name Benchmark name.
+/// \param[in] _width Width of the buffers.
+/// \param[in] _height Height of the buffers.
+/// \param[in] _func Function to time.
+void Measure(const std::string &_name, uint32_t _width, uint32_t _height,
+    const std::function<void()> &_func)
+{
+  // Warm up, e.g. to size the message buffers
+  _func();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kRepeats; ++i)
+    _func();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  const double us = std::chrono::duration<double, std::micro>(
+      elapsed).count() / kRepeats;
+  const double samples = static_cast<double>(_width) * _height;
+  const std::string config = _name + "_" + std::to_string(_width) + "x" +
+      std::to_string(_height);
+  ::testing::Test::RecordProperty(config + "_us_per_call",
+      std::to_string(us));
+  std::cout << "{\"benchmark\": \"" << _name << "\", \"width\": " << _width
+            << ", \"height\": " << _height << ", \"us_per_call\": " << us
+            << ", \"ns_per_sample\": " << us * 1e3 / samples << "}"
+            << std::endl;
+}
+
+//////////////////////////////////////////////////
+/// \brief Create the XYZRGB cloud used by the depth and rgbd cameras.
+/// \param[in] _width Width of the cloud.
+/// \param[in] _height Height of the cloud.
+/// \return The initialized message.
+msgs::PointCloudPacked CameraCloud(uint32_t _width, uint32_t _height)
+{
+  msgs::PointCloudPacked msg;
+  msgs::InitPointCloudPacked(msg, "frame", true,
+      {{"xyz", msgs::PointCloudPacked::Field::FLOAT32},
+      {"rgb", msgs::PointCloudPacked::Field::FLOAT32}});
+  msg.set_width(_width);
+  msg.set_height(_height);
+  msg.set_row_step(msg.point_step() * _width);
+  return msg;
+}
+
+//////////////////////////////////////////////////
+/// \brief Synthetic depths between 0.5 and 10.5 m, with a few non finite
+/// values like the ones beyond the clipping planes.
+/// \param[in] _count Number of depths.
+/// \return The depths.
+std::vector<float> Depths(std::size_t _count)
+{
+  std::vector<float> depths(_count);
+  for (std::size_t i = 0u; i < _count; ++i)
+  {
+    if (i % 97u == 0u)
+      depths[i] = std::numeric_limits<float>::infinity();
+    else
+      depths[i] = 0.5f + static_cast<float>(i % 1000u) * 0.01f;
+  }
+  return depths;
+}
+
+//////////////////////////////////////////////////
+/// \brief Create the sdf element of a lidar with Gaussian noise.
+/// \param[in] _samples Horizontal samples.
+/// \param[in] _verticalSamples Vertical samples.
+/// \return The sensor element, or null on failure.
+sdf::ElementPtr LidarToSdf(uint32_t _samples, uint32_t _verticalSamples)
+{
+  std::ostringstream stream;
+  stream
+    << "<?xml version='1.0'?>"
+    << "<sdf version='1.6'>"
+    << " <model name='m1'>"
+    << "  <link name='link1'>"
+    << "    <sensor name='lidar' type='lidar'>"
+    << "      <topic>/perf/lidar_" << _samples << "x" << _verticalSamples
+    << "</topic>"
+    << "      <update_rate>10</update_rate>"
+    << "      <ray>"
+    << "        <scan>"
+    << "          <horizontal>"
+    << "            <samples>" << _samples << "</samples>"
+    << "            <resolution>1</resolution>"
+    << "            <min_angle>-3.14159</min_angle>"
+    << "            <max_angle>3.14159</max_angle>"
+    << "          </horizontal>"
+    << "          <vertical>"
+    << "            <samples>" << _verticalSamples << "</samples>"
+    << "            <resolution>1</resolution>"
+    << "            <min_angle>-0.26</min_angle>"
+    << "            <max_angle>0.26</max_angle>"
+    << "          </vertical>"
+    << "        </scan>"
+    << "        <range>"
+    << "          <min>0.1</min>"
+    << "          <max>100</max>"
+    << "          <resolution>0.01</resolution>"
+    << "        </range>"
+    << "        <noise>"
+    << "          <type>gaussian</type>"
+    << "          <mean>0</mean>"
+    << "          <stddev>0.01</stddev>"
+    << "        </noise>"
+    << "      </ray>"
+    << "      <always_on>1</always_on>"
+    << "    </sensor>"
+    << "  </link>"
+    << " </model>"
+    << "</sdf>";
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readString(stream.str(), sdfParsed))
+    return sdf::ElementPtr();
+
+  return sdfParsed->Root()->GetElement("model")->GetElement("link")
+    ->GetElement("sensor");
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark the three PointCloudUtil::FillMsg overloads, on the
+/// calling thread and on worker threads.
+TEST(ConversionKernels, PointCloudFillMsg)
+{
+  for (const auto &[width, height] : kImageSizes)  // NOLINT
+  {
+    const std::size_t count = static_cast<std::size_t>(width) * height;
+    const std::vector<float> depths = Depths(count);
+    std::vector<unsigned char> image(count * 3u);
+    for (std::size_t i = 0u; i < image.size(); ++i)
+      image[i] = static_cast<unsigned char>(i * 7u);
+    std::vector<float> xyz(count * 3u);
+    std::vector<float> cloud(count * 4u);
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+      xyz[i * 3u] = depths[i];
+      xyz[i * 3u + 1u] = 0.001f * static_cast<float>(i % width);
+      xyz[i * 3u + 2u] = 0.001f * static_cast<float>(i / width);
+      std::memcpy(&cloud[i * 4u], &xyz[i * 3u], 3u * sizeof(float));
+      const uint32_t rgba = static_cast<uint32_t>(i * 0x01020304u) | 0xFFu;
+      std::memcpy(&cloud[i * 4u + 3u], &rgba, sizeof(rgba));
+    }
+    std::vector<unsigned char> imageOut(count * 3u);
+    std::vector<float> xyzOut(count * 3u);
+
+    for (unsigned int threads : {1u, kThreadCount})
+    {
+      sensors::PointCloudUtil util;
+      util.SetThreadCount(threads);
+      const std::string suffix = "_threads" + std::to_string(threads);
+      msgs::PointCloudPacked msg = CameraCloud(width, height);
+
+      Measure("fill_msg_depth" + suffix, width, height, [&]()
+      {
+        util.FillMsg(msg, math::Angle(1.05), image.data(), depths.data());
+      });
+      Measure("fill_msg_xyz" + suffix, width, height, [&]()
+      {
+        util.FillMsg(msg, xyz.data(), image.data());
+      });
+      Measure("fill_msg_point_cloud" + suffix, width, height, [&]()
+      {
+        util.FillMsg(msg, cloud.data(), true, imageOut.data(),
+            xyzOut.data());
+      });
+      EXPECT_EQ(static_cast<std::size_t>(msg.row_step()) * height,
+          msg.data().size());
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark the kernels of
+/// DepthCameraSensorPrivate::ConvertDepthToImage, with the range found
+/// from the frame and with a fixed range, and the millimeter conversion.
+TEST(ConversionKernels, DepthToImage)
+{
+  sensors::PointCloudUtil util;
+  for (const auto &[width, height] : kImageSizes)  // NOLINT
+  {
+    const std::size_t count = static_cast<std::size_t>(width) * height;
+    const std::vector<float> depths = Depths(count);
+    std::vector<unsigned char> image(count * 3u);
+    std::vector<uint16_t> millimeters(count);
+
+    Measure("depth_to_image", width, height, [&]()
+    {
+      const float far = util.MaxFiniteDepth(depths.data(), count);
+      util.DepthToImage(image.data(), depths.data(), width, height, 0.0f,
+          far);
+    });
+    Measure("depth_to_image_fixed_range", width, height, [&]()
+    {
+      util.DepthToImage(image.data(), depths.data(), width, height, 0.1f,
+          10.0f);
+    });
+    Measure("depth_to_millimeters", width, height, [&]()
+    {
+      util.DepthToMillimeters(millimeters.data(), depths.data(), count);
+    });
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark the kernels of
+/// ThermalCameraSensorPrivate::ConvertTemperatureToImage and of the false
+/// color and 8 bit outputs.
+TEST(ConversionKernels, TemperatureToImage)
+{
+  for (const auto &[width, height] : kImageSizes)  // NOLINT
+  {
+    const std::size_t count = static_cast<std::size_t>(width) * height;
+    std::vector<uint16_t> temperatures(count);
+    for (std::size_t i = 0u; i < count; ++i)
+      temperatures[i] = static_cast<uint16_t>(27315u + (i * 13u) % 5000u);
+    std::vector<unsigned char> image(count * 3u);
+    std::vector<unsigned char> narrowed(count);
+
+    for (auto colormap : {sensors::ThermalColormap::GRAYSCALE,
+        sensors::ThermalColormap::IRONBOW})
+    {
+      const auto &lut = sensors::ColormapColors(colormap);
+      const std::string name = colormap ==
+          sensors::ThermalColormap::GRAYSCALE ? "temperature_to_image" :
+          "temperature_to_image_ironbow";
+      Measure(name, width, height, [&]()
+      {
+        const auto [min, max] =  // NOLINT
+            sensors::MinMaxThermal(temperatures.data(), count);
+        sensors::ThermalToRgb(image.data(), temperatures.data(), count, min,
+            std::max(1u, static_cast<unsigned int>(max - min)), lut);
+      });
+    }
+    Measure("temperature_narrow_8bit", width, height, [&]()
+    {
+      sensors::NarrowThermal(narrowed.data(), temperatures.data(), count);
+    });
+  }
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark Lidar::ApplyNoise and Lidar::PublishLidarScan on
+/// synthetic scans.
+TEST(ConversionKernels, LidarScan)
+{
+  for (const auto &[samples, verticalSamples] : kScanSizes)  // NOLINT
+  {
+    sdf::ElementPtr lidarSdf = LidarToSdf(samples, verticalSamples);
+    ASSERT_NE(nullptr, lidarSdf);
+
+    sensors::Manager mgr;
+    auto *lidar = mgr.CreateSensor<sensors::Lidar>(lidarSdf);
+    ASSERT_NE(nullptr, lidar);
+    ASSERT_TRUE(lidar->HasNoise());
+
+    const std::size_t count =
+        static_cast<std::size_t>(samples) * verticalSamples;
+    std::vector<float> scan(count * 3u);
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+      scan[i * 3u] = 1.0f + static_cast<float>(i % 500u) * 0.1f;
+      scan[i * 3u + 1u] = static_cast<float>(i % 256u);
+      scan[i * 3u + 2u] = 0.0f;
+    }
+
+    // The copy is part of the timings, like the copy of rendered scans
+    auto writeScan = [&]()
+    {
+      std::memcpy(lidar->ScanWriteBuffer(scan.size()), scan.data(),
+          scan.size() * sizeof(float));
+      lidar->CommitScanBuffer();
+    };
+
+    Measure("lidar_apply_noise", samples, verticalSamples, [&]()
+    {
+      writeScan();
+      lidar->ApplyNoise();
+    });
+
+    auto now = std::chrono::steady_clock::duration::zero();
+    Measure("lidar_publish_scan", samples, verticalSamples, [&]()
+    {
+      writeScan();
+      EXPECT_TRUE(lidar->PublishLidarScan(now));
+      now += 100ms;
+    });
+  }
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sdf/Altimeter.hh>
+#include <sdf/Imu.hh>
+#include <sdf/Sensor.hh>
+
+#include <gz/sensors/AltimeterSensor.hh>
+#include <gz/sensors/ImuSensor.hh>
+#include <gz/sensors/Manager.hh>
+
+using namespace gz;
+using namespace std::chrono_literals;
+
+/// \brief Numbers of sensors of the benchmarks.
+const std::vector<std::size_t> kSensorCounts{10u, 100u, 1000u, 10000u,
+    100000u};
+
+/// \brief Largest number of built-in sensors. Each of them advertises a
+/// topic, which gz-transport doesn't scale to 100k of.
+constexpr std::size_t kMaxBuiltinSensors = 1000u;
+
+/// \brief Update rates given to the sensors in turn. Zero updates on every
+/// step.
+const std::vector<double> kRates{0.0, 10.0, 30.0, 100.0, 250.0, 1000.0};
+
+/// \brief Number of RunOnce calls measured per configuration.
+constexpr int kSteps = 200;
+
+/// \brief Simulated time between two steps, 1 kHz.
+constexpr auto kStep = 1ms;
+
+/// \brief Sensor that does nothing, like examples/custom_sensor's
+/// Odometer without its state.
+class NoOpSensor : public sensors::Sensor
+{
+  // Documentation inherited
+  public: bool Update(const std::chrono::steady_clock::duration &) override
+  {
+    ++this->updates;
+    return true;
+  }
+
+  /// \brief Number of updates.
+  public: uint64_t updates = 0u;
+};
+
+/// \brief A kind of sensor to populate the manager with.
+struct ScalabilityCase
+{
+  /// \brief Benchmark name.
+  std::string name;
+
+  /// \brief Largest number of sensors.
+  std::size_t maxCount;
+
+  /// \brief Create a sensor with a manager.
+  std::function<sensors::SensorId(sensors::Manager &, std::size_t)> create;
+};
+
+//////////////////////////////////////////////////
+/// \brief Report a measurement. Results are printed as one JSON object per
+/// line and recorded as test properties, so they end up in the XML report
+/// written with --gtest_output.
+/// \param[in] _name Benchmark name.
+/// \param[in] _count Number of sensors.
+/// \param[in] _metric Name of the measurement.
+/// \param[in] _value Measured value.
+void Report(const std::string &_name, std::size_t _count,
+    const std::string &_metric, double _value)
+{
+  ::testing::Test::RecordProperty(
+      _name + "_x" + std::to_string(_count) + "_" + _metric,
+      std::to_string(_value));
+  std::cout << "{\"benchmark\": \"" << _name << "\", \"sensors\": "
+            << _count << ", \"" << _metric << "\": " << _value << "}"
+            << std::endl;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the time elapsed since a start time.
+/// \param[in] _start Start time.
+/// \return Elapsed time in nanoseconds.
+double ElapsedNs(const std::chrono::steady_clock::time_point &_start)
+{
+  return std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - _start).count();
+}
+
+//////////////////////////////////////////////////
+/// \brief Create the sdf of a built-in sensor.
+/// \param[in] _type Sensor type.
+/// \param[in] _name Prefix of the sensor name and topic.
+/// \param[in] _index Index of the sensor.
+/// \return The sensor.
+sdf::Sensor BuiltinSdf(sdf::SensorType _type, const std::string &_name,
+    std::size_t _index)
+{
+  sdf::Sensor sdfSensor;
+  sdfSensor.SetType(_type);
+  sdfSensor.SetName(_name + std::to_string(_index));
+  sdfSensor.SetTopic("/perf/" + _name + std::to_string(_index));
+  sdfSensor.SetUpdateRate(kRates[_index % kRates.size()]);
+  return sdfSensor;
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark a manager holding _count sensors of one kind.
+/// \param[in] _case Kind of sensors.
+/// \param[in] _count Number of sensors.
+void RunScalability(const ScalabilityCase &_case, std::size_t _count)
+{
+  sensors::Manager mgr;
+  ASSERT_TRUE(mgr.Init());
+
+  std::vector<sensors::SensorId> ids;
+  ids.reserve(_count);
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0u; i < _count; ++i)
+  {
+    ids.push_back(_case.create(mgr, i));
+    ASSERT_NE(sensors::NO_SENSOR, ids.back());
+  }
+  Report(_case.name, _count, "create_ns_per_sensor",
+      ElapsedNs(start) / _count);
+
+  for (unsigned int threads : {0u, 4u})
+  {
+    mgr.SetWorkerThreadCount(threads);
+    auto now = std::chrono::steady_clock::duration::zero();
+
+    // Warm up, so every sensor has been scheduled and updated once
+    for (int i = 0; i < 5; ++i)
+    {
+      mgr.RunOnce(now);
+      now += kStep;
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kSteps; ++i)
+    {
+      mgr.RunOnce(now);
+      now += kStep;
+    }
+    Report(_case.name, _count,
+        "run_once_us_per_step_threads" + std::to_string(threads),
+        ElapsedNs(start) / 1e3 / kSteps);
+  }
+  mgr.SetWorkerThreadCount(0u);
+
+  // Look up every sensor in a random order, so the lookups don't benefit
+  // from the order of the storage
+  std::vector<sensors::SensorId> shuffled = ids;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1u));
+  std::size_t found = 0u;
+  start = std::chrono::steady_clock::now();
+  for (auto id : shuffled)
+    found += mgr.Sensor(id) != nullptr;
+  Report(_case.name, _count, "lookup_ns", ElapsedNs(start) / _count);
+  EXPECT_EQ(_count, found);
+
+  start = std::chrono::steady_clock::now();
+  for (auto id : shuffled)
+    EXPECT_TRUE(mgr.Remove(id));
+  Report(_case.name, _count, "remove_ns_per_sensor",
+      ElapsedNs(start) / _count);
+  EXPECT_TRUE(mgr.SensorIds().empty());
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark RunOnce, Manager::Sensor, sensor creation and Remove
+/// for increasing numbers of sensors at mixed rates.
+TEST(ManagerScalability, Sensors)
+{
+  const std::vector<ScalabilityCase> cases{
+    {"noop", kSensorCounts.back(),
+        [](sensors::Manager &_mgr, std::size_t _index)
+        {
+          auto sensor = std::make_unique<NoOpSensor>();
+          sensor->SetUpdateRate(kRates[_index % kRates.size()]);
+          return _mgr.AddSensor(std::move(sensor));
+        }},
+    {"imu", kMaxBuiltinSensors,
+        [](sensors::Manager &_mgr, std::size_t _index)
+        {
+          sdf::Sensor sdfSensor =
+              BuiltinSdf(sdf::SensorType::IMU, "imu", _index);
+          sdfSensor.SetImuSensor(sdf::Imu());
+          auto sensor = _mgr.CreateSensor<sensors::ImuSensor>(sdfSensor);
+          return sensor ? sensor->Id() : sensors::NO_SENSOR;
+        }},
+    {"altimeter", kMaxBuiltinSensors,
+        [](sensors::Manager &_mgr, std::size_t _index)
+        {
+          sdf::Sensor sdfSensor =
+              BuiltinSdf(sdf::SensorType::ALTIMETER, "altimeter", _index);
+          sdfSensor.SetAltimeterSensor(sdf::Altimeter());
+          auto sensor =
+              _mgr.CreateSensor<sensors::AltimeterSensor>(sdfSensor);
+          return sensor ? sensor->Id() : sensors::NO_SENSOR;
+        }},
+  };
+
+  for (const auto &scalabilityCase : cases)
+  {
+    for (std::size_t count : kSensorCounts)
+    {
+      if (count <= scalabilityCase.maxCount)
+        RunScalability(scalabilityCase, count);
+    }
+  }
+}
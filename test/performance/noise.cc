@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sdf/Noise.hh>
+
+#include "gz/sensors/FlickerNoiseModel.hh"
+#include "gz/sensors/GaussMarkovNoiseModel.hh"
+#include "gz/sensors/GaussianNoiseModel.hh"
+#include "gz/sensors/Noise.hh"
+
+using namespace gz;
+
+/// \brief Number of samples of the scalar benchmarks.
+constexpr std::size_t kScalarSamples = 1000000u;
+
+/// \brief Size of the buffers of the batch benchmarks.
+constexpr std::size_t kBatchSize = 1000000u;
+
+/// \brief Number of batches applied by the batch benchmarks.
+constexpr int kBatchRepeats = 10;
+
+/// \brief Number of threads of the multithreaded benchmarks.
+constexpr unsigned int kThreadCount = 4u;
+
+/// \brief Time step passed to the noise models, 1 kHz.
+constexpr double kDt = 0.001;
+
+//////////////////////////////////////////////////
+/// \brief Create a Gaussian noise model.
+/// \param[in] _dynamicBias True to enable the dynamic bias.
+/// \param[in] _precision Output precision, 0 to disable quantization.
+/// \return The noise model.
+sensors::NoisePtr GaussianNoise(bool _dynamicBias, double _precision)
+{
+  sdf::Noise noiseDom;
+  noiseDom.SetType(sdf::NoiseType::GAUSSIAN);
+  noiseDom.SetMean(0.1);
+  noiseDom.SetStdDev(0.2);
+  noiseDom.SetBiasMean(0.01);
+  noiseDom.SetBiasStdDev(0.001);
+  if (_dynamicBias)
+  {
+    noiseDom.SetDynamicBiasStdDev(0.05);
+    noiseDom.SetDynamicBiasCorrelationTime(100.0);
+  }
+  noiseDom.SetPrecision(_precision);
+  return sensors::NoiseFactory::NewNoiseModel(noiseDom);
+}
+
+//////////////////////////////////////////////////
+/// \brief Time a function and report its cost per sample. Results are
+/// printed as one JSON object per line and recorded as test properties, so
+/// they end up in the XML report written with --gtest_output.
+/// \param[in] _name Benchmark name.
+/// \param[in] _samples Number of samples processed by _func.
+/// \param[in] _func Function to time.
+void Measure(const std::string &_name, std::size_t _samples,
+    const std::function<void()> &_func)
+{
+  // Warm up, e.g. to allocate scratch buffers
+  _func();
+
+  auto start = std::chrono::steady_clock::now();
+  _func();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  const double ns = std::chrono::duration<double, std::nano>(elapsed).count() /
+      static_cast<double>(_samples);
+  ::testing::Test::RecordProperty(_name + "_ns_per_sample",
+      std::to_string(ns));
+  std::cout << "{\"benchmark\": \"" << _name << "\", \"samples\": "
+            << _samples << ", \"ns_per_sample\": " << ns << "}" << std::endl;
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark Noise::Apply.
+/// \param[in] _name Benchmark name.
+/// \param[in] _noise Noise model.
+void MeasureScalar(const std::string &_name, const sensors::NoisePtr &_noise)
+{
+  ASSERT_NE(nullptr, _noise);
+  double sink = 0.0;
+  Measure(_name, kScalarSamples, [&]()
+  {
+    for (std::size_t i = 0u; i < kScalarSamples; ++i)
+      sink += _noise->Apply(1.0, kDt);
+  });
+  EXPECT_TRUE(std::isfinite(sink));
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark Noise::ApplyBatch.
+/// \param[in] _name Benchmark name.
+/// \param[in] _noise Noise model.
+/// \param[in] _stride Distance between consecutive values.
+template <typename T>
+void MeasureBatch(const std::string &_name, const sensors::NoisePtr &_noise,
+    std::size_t _stride)
+{
+  ASSERT_NE(nullptr, _noise);
+  std::vector<T> buffer(kBatchSize * _stride, T(1));
+  Measure(_name, kBatchSize * kBatchRepeats, [&]()
+  {
+    for (int i = 0; i < kBatchRepeats; ++i)
+      _noise->ApplyBatch(buffer.data(), kBatchSize, _stride, kDt);
+  });
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark Noise::Apply on several threads, each with its own
+/// noise model, as when sensors are updated by Manager worker threads.
+/// \param[in] _name Benchmark name.
+/// \param[in] _seeded True to give each model its own random stream.
+void MeasureThreads(const std::string &_name, bool _seeded)
+{
+  std::vector<sensors::NoisePtr> noises;
+  for (unsigned int i = 0u; i < kThreadCount; ++i)
+  {
+    noises.push_back(GaussianNoise(false, 0.0));
+    if (_seeded)
+      noises.back()->SetSeed(i);
+  }
+
+  Measure(_name, kScalarSamples * kThreadCount, [&]()
+  {
+    std::vector<std::thread> threads;
+    for (auto &noise : noises)
+    {
+      threads.emplace_back([&noise]()
+      {
+        double sink = 0.0;
+        for (std::size_t i = 0u; i < kScalarSamples; ++i)
+          sink += noise->Apply(1.0, kDt);
+        EXPECT_TRUE(std::isfinite(sink));
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+  });
+}
+
+//////////////////////////////////////////////////
+TEST(NoisePerformance, GaussianApply)
+{
+  MeasureScalar("gaussian_apply", GaussianNoise(false, 0.0));
+  MeasureScalar("gaussian_apply_dynamic_bias", GaussianNoise(true, 0.0));
+  MeasureScalar("gaussian_apply_precision", GaussianNoise(false, 0.01));
+  MeasureScalar("gaussian_apply_dynamic_bias_precision",
+      GaussianNoise(true, 0.01));
+
+  auto seeded = GaussianNoise(true, 0.01);
+  seeded->SetSeed(1u);
+  MeasureScalar("gaussian_apply_seeded", seeded);
+}
+
+//////////////////////////////////////////////////
+TEST(NoisePerformance, GaussianApplyBatch)
+{
+  MeasureBatch<double>("gaussian_batch_double", GaussianNoise(false, 0.0),
+      1u);
+  MeasureBatch<float>("gaussian_batch_float", GaussianNoise(false, 0.0), 1u);
+  MeasureBatch<float>("gaussian_batch_float_stride3",
+      GaussianNoise(false, 0.0), 3u);
+  MeasureBatch<double>("gaussian_batch_double_precision",
+      GaussianNoise(true, 0.01), 1u);
+
+  auto seeded = GaussianNoise(false, 0.0);
+  seeded->SetSeed(1u);
+  MeasureBatch<float>("gaussian_batch_float_seeded", seeded, 1u);
+}
+
+//////////////////////////////////////////////////
+TEST(NoisePerformance, GaussianApplyThreads)
+{
+  MeasureThreads("gaussian_apply_threads_global_rand", false);
+  MeasureThreads("gaussian_apply_threads_seeded", true);
+}
+
+//////////////////////////////////////////////////
+TEST(NoisePerformance, CorrelatedNoise)
+{
+  sdf::Noise noiseDom;
+  noiseDom.SetType(sdf::NoiseType::GAUSSIAN);
+  noiseDom.SetStdDev(0.2);
+  noiseDom.SetDynamicBiasCorrelationTime(1.0);
+
+  auto gaussMarkov = std::make_shared<sensors::GaussMarkovNoiseModel>();
+  gaussMarkov->Load(noiseDom);
+  MeasureScalar("gauss_markov_apply", gaussMarkov);
+  MeasureBatch<float>("gauss_markov_batch_float", gaussMarkov, 1u);
+
+  auto flicker = std::make_shared<sensors::FlickerNoiseModel>();
+  flicker->Load(noiseDom);
+  MeasureScalar("flicker_apply", flicker);
+  MeasureBatch<float>("flicker_batch_float", flicker, 1u);
+}
@@ -0,0 +1,537 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Filesystem.hh>
+#include <gz/math/Pose3.hh>
+#include <gz/sensors/BoundingBoxCameraSensor.hh>
+#include <gz/sensors/CameraSensor.hh>
+#include <gz/sensors/DepthCameraSensor.hh>
+#include <gz/sensors/DopplerVelocityLog.hh>
+#include <gz/sensors/GpuLidarSensor.hh>
+#include <gz/sensors/Manager.hh>
+#include <gz/sensors/RgbdCameraSensor.hh>
+#include <gz/sensors/SegmentationCameraSensor.hh>
+#include <gz/sensors/ThermalCameraSensor.hh>
+#include <gz/sensors/WideAngleCameraSensor.hh>
+#include <gz/transport/Node.hh>
+
+// TODO(louise) Remove these pragmas once gz-rendering is disabling the
+// warnings
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+#include <gz/rendering/RenderEngine.hh>
+#include <gz/rendering/RenderingIface.hh>
+#include <gz/rendering/Scene.hh>
+#include <gz/rendering/Visual.hh>
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+#include "test_config.hh"  // NOLINT(build/include)
+
+using namespace std::chrono_literals;
+
+/// \brief Number of heap allocations made by the process.
+std::atomic<uint64_t> g_allocations{0u};
+
+//////////////////////////////////////////////////
+void *operator new(std::size_t _size)
+{
+  ++g_allocations;
+  if (void *ptr = std::malloc(_size == 0u ? 1u : _size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/// \brief Number of Manager::RunOnce calls measured per configuration.
+constexpr int kSteps = 50;
+
+/// \brief Factors applied to the resolution of the SDF sensors.
+const std::vector<double> kResolutionScales{0.5, 1.0, 2.0};
+
+/// \brief Number of copies of the SDF sensor.
+const std::vector<unsigned int> kSensorCounts{1u, 4u};
+
+/// \brief A sensor type to benchmark.
+struct ThroughputCase
+{
+  /// \brief Benchmark name.
+  std::string name;
+
+  /// \brief SDF file in test/sdf.
+  std::string file;
+
+  /// \brief Create the sensor with a manager.
+  std::function<gz::sensors::Sensor *(gz::sensors::Manager &,
+      sdf::ElementPtr)> create;
+};
+
+//////////////////////////////////////////////////
+/// \brief Create a sensor of a given type.
+/// \return Function that creates the sensor.
+template <typename T>
+std::function<gz::sensors::Sensor *(gz::sensors::Manager &, sdf::ElementPtr)>
+Creator()
+{
+  return [](gz::sensors::Manager &_mgr, sdf::ElementPtr _sdf)
+  {
+    return _mgr.CreateSensor<T>(_sdf);
+  };
+}
+
+//////////////////////////////////////////////////
+/// \brief Load the sensor element of a test SDF file.
+/// \param[in] _file File name in test/sdf.
+/// \return The sensor element, or null on failure.
+sdf::ElementPtr LoadSensorSdf(const std::string &_file)
+{
+  std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH, "test",
+      "sdf", _file);
+  sdf::SDFPtr doc(new sdf::SDF());
+  sdf::init(doc);
+  if (!sdf::readFile(path, doc) || !doc->Root()->HasElement("model"))
+    return sdf::ElementPtr();
+  return doc->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+}
+
+//////////////////////////////////////////////////
+/// \brief Scale an integer parameter of an element, if it is present.
+/// \param[in] _elem Element that may hold the parameter.
+/// \param[in] _names Path of the parameter below _elem.
+/// \param[in] _scale Scale factor.
+void ScaleElement(sdf::ElementPtr _elem, const std::vector<std::string> &_names,
+    double _scale)
+{
+  for (const auto &name : _names)
+  {
+    if (!_elem || !_elem->HasElement(name))
+      return;
+    _elem = _elem->GetElement(name);
+  }
+  auto value = static_cast<double>(_elem->Get<unsigned int>());
+  _elem->Set(std::max(1u, static_cast<unsigned int>(value * _scale)));
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the average latency of a pipeline stage over sensors.
+/// \param[in] _sensors Sensors.
+/// \param[in] _stage Stage.
+/// \return Average latency in milliseconds, zero if the stage wasn't
+/// reached.
+double StageMs(const std::vector<gz::sensors::Sensor *> &_sensors,
+    gz::sensors::SensorLatencyStage _stage)
+{
+  double sum = 0.0;
+  for (auto sensor : _sensors)
+  {
+    sum += std::chrono::duration<double, std::milli>(
+        sensor->Latency(_stage).average).count();
+  }
+  return _sensors.empty() ? 0.0 : sum / _sensors.size();
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark a sensor type for one resolution and sensor count.
+/// Published bytes are counted on the topic of each sensor, additional
+/// topics such as camera info or point clouds aren't subscribed to.
+/// The time of an update is split with the latency stamps of the sensors:
+/// rendering, reading back the rendered data, and the CPU work that turns
+/// it into a message. Rendering is wall-clock time on the CPU until the
+/// render call returns, which includes waiting for the GPU.
+/// Results are printed as one JSON object per line and recorded as test
+/// properties, so they end up in the XML report written with
+/// --gtest_output.
+/// \param[in] _engine Render engine.
+/// \param[in] _case Sensor type.
+/// \param[in] _scale Resolution scale factor.
+/// \param[in] _count Number of sensors.
+void RunThroughput(gz::rendering::RenderEngine *_engine,
+    const ThroughputCase &_case, double _scale, unsigned int _count)
+{
+  sdf::ElementPtr sensorSdf = LoadSensorSdf(_case.file);
+  ASSERT_NE(nullptr, sensorSdf) << _case.file;
+
+  gz::rendering::ScenePtr scene = _engine->CreateScene("scene");
+  ASSERT_NE(nullptr, scene);
+  scene->SetAmbientLight(0.3, 0.3, 0.3);
+  gz::rendering::VisualPtr box = scene->CreateVisual();
+  box->AddGeometry(scene->CreateBox());
+  box->SetLocalPosition(3, 0, 0.5);
+  scene->RootVisual()->AddChild(box);
+
+  std::atomic<uint64_t> bytes{0u};
+  std::atomic<uint64_t> messages{0u};
+  gz::transport::Node node;
+
+  std::vector<gz::sensors::Sensor *> sensors;
+  {
+    gz::sensors::Manager mgr;
+    for (unsigned int i = 0u; i < _count; ++i)
+    {
+      sdf::ElementPtr elem = sensorSdf->Clone();
+      const std::string name = _case.name + "_" + std::to_string(i);
+      elem->GetAttribute("name")->Set(name);
+      elem->GetElement("topic")->Set("/perf/" + name);
+      for (const char *tag : {"camera", "lidar"})
+      {
+        if (!elem->HasElement(tag))
+          continue;
+        auto sub = elem->GetElement(tag);
+        ScaleElement(sub, {"image", "width"}, _scale);
+        ScaleElement(sub, {"image", "height"}, _scale);
+        ScaleElement(sub, {"scan", "horizontal", "samples"}, _scale);
+        ScaleElement(sub, {"scan", "vertical", "samples"}, _scale);
+      }
+
+      gz::sensors::Sensor *sensor = _case.create(mgr, elem);
+      ASSERT_NE(nullptr, sensor) << name;
+      auto renderingSensor =
+          dynamic_cast<gz::sensors::RenderingSensor *>(sensor);
+      ASSERT_NE(nullptr, renderingSensor);
+      renderingSensor->SetScene(scene);
+      sensor->SetEnableMetrics(true);
+      sensors.push_back(sensor);
+
+      // Subscribing makes the sensor generate data
+      node.SubscribeRaw(sensor->Topic(),
+          [&bytes, &messages](const char *, const std::size_t _size,
+              const gz::transport::MessageInfo &)
+          {
+            bytes += _size;
+            ++messages;
+          });
+    }
+
+    // Warm up, e.g. to create render targets and discover subscribers
+    auto now = std::chrono::steady_clock::duration::zero();
+    for (int i = 0; i < 5; ++i)
+    {
+      mgr.RunOnce(now, true);
+      now += 100ms;
+    }
+    std::this_thread::sleep_for(200ms);
+    for (auto sensor : sensors)
+      sensor->ResetExecutionTime();
+    bytes = 0u;
+    messages = 0u;
+
+    const uint64_t allocationsStart = g_allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kSteps; ++i)
+    {
+      mgr.RunOnce(now, true);
+      now += 100ms;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const uint64_t allocations = g_allocations - allocationsStart;
+
+    // Let the messages in flight arrive
+    std::this_thread::sleep_for(200ms);
+
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const std::string config = _case.name + "_x" + std::to_string(_count) +
+        "_scale" + std::to_string(_scale);
+
+    using Stage = gz::sensors::SensorLatencyStage;
+    const double renderMs = StageMs(sensors, Stage::RENDER);
+    const double readbackMs =
+        std::max(0.0, StageMs(sensors, Stage::READBACK) - renderMs);
+    const double postMs = std::max(0.0, StageMs(sensors, Stage::FILL) -
+        StageMs(sensors, Stage::READBACK));
+
+    std::cout << "{\"benchmark\": \"" << _case.name << "\", "
+              << "\"engine\": \"" << _engine->Name() << "\", "
+              << "\"sensors\": " << _count << ", "
+              << "\"resolution_scale\": " << _scale << ", "
+              << "\"steps\": " << kSteps << ", "
+              << "\"total_ms_per_step\": " << seconds * 1e3 / kSteps << ", "
+              << "\"allocations_per_step\": "
+              << static_cast<double>(allocations) / kSteps << ", "
+              << "\"render_ms\": " << renderMs << ", "
+              << "\"readback_ms\": " << readbackMs << ", "
+              << "\"post_processing_ms\": " << postMs << ", "
+              << "\"messages\": " << messages << ", "
+              << "\"published_bytes_per_second\": " << bytes.load() / seconds
+              << ", \"sensor_ms\": [";
+    for (std::size_t i = 0u; i < sensors.size(); ++i)
+    {
+      auto time = sensors[i]->ExecutionTime();
+      std::cout << (i == 0u ? "" : ", ")
+                << std::chrono::duration<double, std::milli>(
+                       time.average).count();
+    }
+    std::cout << "]}" << std::endl;
+
+    ::testing::Test::RecordProperty(config + "_ms_per_step",
+        std::to_string(seconds * 1e3 / kSteps));
+    ::testing::Test::RecordProperty(config + "_allocations_per_step",
+        std::to_string(static_cast<double>(allocations) / kSteps));
+    ::testing::Test::RecordProperty(config + "_bytes_per_second",
+        std::to_string(bytes.load() / seconds));
+    ::testing::Test::RecordProperty(config + "_render_ms",
+        std::to_string(renderMs));
+    ::testing::Test::RecordProperty(config + "_readback_ms",
+        std::to_string(readbackMs));
+    ::testing::Test::RecordProperty(config + "_post_processing_ms",
+        std::to_string(postMs));
+  }
+
+  _engine->DestroyScene(scene);
+}
+
+//////////////////////////////////////////////////
+/// \brief Load a render engine, headless where it's supported, such as
+/// ogre2 on EGL, so the benchmarks run on machines without a display.
+/// \param[in] _name Engine name.
+/// \return The engine, or null if it isn't available.
+gz::rendering::RenderEngine *LoadEngine(const std::string &_name)
+{
+  std::map<std::string, std::string> params;
+  params["headless"] = "1";
+  return gz::rendering::engine(_name, params);
+}
+
+/// \brief Benchmark sensor throughput for a render engine.
+class SensorThroughput : public testing::Test,
+                         public testing::WithParamInterface<const char *>
+{
+};
+
+//////////////////////////////////////////////////
+TEST_P(SensorThroughput, RunOnce)
+{
+  auto *engine = LoadEngine(GetParam());
+  if (!engine)
+    GTEST_SKIP() << "Engine '" << GetParam() << "' is not supported";
+
+  const std::vector<ThroughputCase> cases{
+    {"camera", "camera_sensor_builtin.sdf",
+        Creator<gz::sensors::CameraSensor>()},
+    {"depth", "depth_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::DepthCameraSensor>()},
+    {"rgbd", "rgbd_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::RgbdCameraSensor>()},
+    {"gpu_lidar", "gpu_lidar_sensor_builtin.sdf",
+        Creator<gz::sensors::GpuLidarSensor>()},
+    {"thermal", "thermal_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::ThermalCameraSensor>()},
+    {"segmentation", "segmentation_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::SegmentationCameraSensor>()},
+    {"boundingbox", "boundingbox_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::BoundingBoxCameraSensor>()},
+    {"wide_angle", "wide_angle_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::WideAngleCameraSensor>()},
+  };
+
+  for (const auto &throughputCase : cases)
+  {
+    for (double scale : kResolutionScales)
+    {
+      for (unsigned int count : kSensorCounts)
+        RunThroughput(engine, throughputCase, scale, count);
+    }
+  }
+
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+//////////////////////////////////////////////////
+/// \brief Create the sdf element of a phased array DVL whose four beams
+/// track the bottom.
+/// \return The sensor element, or null on failure.
+sdf::ElementPtr DvlSdf()
+{
+  std::ostringstream stream;
+  stream
+    << "<?xml version='1.0'?>"
+    << "<sdf version='1.6'>"
+    << " <model name='model'>"
+    << "  <link name='link'>"
+    << "   <sensor name='dvl' type='custom' gz:type='dvl'>"
+    << "    <always_on>1</always_on>"
+    << "    <update_rate>10</update_rate>"
+    << "    <topic>/perf/dvl</topic>"
+    << "    <gz:dvl>"
+    << "     <type>phased_array</type>"
+    << "     <arrangement degrees='true'>";
+  for (int rotation : {45, 135, -135, -45})
+  {
+    stream
+      << "      <beam>"
+      << "       <aperture>2</aperture>"
+      << "       <rotation>" << rotation << "</rotation>"
+      << "       <tilt>30</tilt>"
+      << "      </beam>";
+  }
+  stream
+    << "     </arrangement>"
+    << "     <tracking>"
+    << "      <bottom_mode>"
+    << "       <when>always</when>"
+    << "       <noise type='gaussian'><stddev>0.001</stddev></noise>"
+    << "      </bottom_mode>"
+    << "     </tracking>"
+    << "     <resolution>0.01</resolution>"
+    << "     <maximum_range>100.</maximum_range>"
+    << "     <minimum_range>0.1</minimum_range>"
+    << "    </gz:dvl>"
+    << "   </sensor>"
+    << "  </link>"
+    << " </model>"
+    << "</sdf>";
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readString(stream.str(), sdfParsed))
+    return sdf::ElementPtr();
+  return sdfParsed->Root()->GetElement("model")->GetElement("link")
+      ->GetElement("sensor");
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark a DVL tracking a seabed. The DVL renders its beams in
+/// Update and turns them into velocity estimates in PostUpdate, after the
+/// scene is post-rendered, so the two are timed separately.
+TEST_P(SensorThroughput, DopplerVelocityLog)
+{
+  auto *engine = LoadEngine(GetParam());
+  if (!engine)
+    GTEST_SKIP() << "Engine '" << GetParam() << "' is not supported";
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  ASSERT_NE(nullptr, scene);
+  scene->SetAmbientLight(1.0, 1.0, 1.0);
+
+  constexpr uint64_t seabedEntity = 100u;
+  constexpr uint64_t deviceEntity = 200u;
+  const gz::math::Pose3d seabedPose(0, 0, -20, 0, 0, 0);
+  gz::rendering::VisualPtr seabed = scene->CreateVisual();
+  seabed->AddGeometry(scene->CreatePlane());
+  seabed->SetLocalPose(seabedPose);
+  seabed->SetLocalScale(gz::math::Vector3d(1e3, 1e3, 0.0));
+  seabed->SetUserData("gazebo-entity", seabedEntity);
+  scene->RootVisual()->AddChild(seabed);
+
+  uint64_t messages = 0u;
+  gz::transport::Node node;
+  {
+    gz::sensors::Manager mgr;
+    auto *sensor =
+        mgr.CreateSensor<gz::sensors::DopplerVelocityLog>(DvlSdf());
+    ASSERT_NE(nullptr, sensor);
+    sensor->SetEntity(deviceEntity);
+    sensor->SetScene(scene);
+    sensor->SetManualSceneUpdate(true);
+
+    gz::rendering::VisualPtr device = scene->CreateVisual();
+    device->SetUserData("gazebo-entity", deviceEntity);
+    for (auto renderingSensor : sensor->RenderingSensors())
+      device->AddChild(renderingSensor);
+    scene->RootVisual()->AddChild(device);
+
+    gz::sensors::WorldState worldState;
+    worldState.kinematics[seabedEntity].pose = seabedPose;
+    worldState.kinematics[deviceEntity].pose = gz::math::Pose3d::Zero;
+    sensor->SetWorldState(worldState);
+
+    node.SubscribeRaw(sensor->Topic(),
+        [&messages](const char *, const std::size_t,
+            const gz::transport::MessageInfo &)
+        {
+          ++messages;
+        });
+
+    auto now = std::chrono::steady_clock::duration::zero();
+    auto step = [&](std::chrono::steady_clock::duration &_updateTime,
+        std::chrono::steady_clock::duration &_postTime)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      scene->PreRender();
+      sensor->Update(now);
+      scene->PostRender();
+      const auto updated = std::chrono::steady_clock::now();
+      sensor->PostUpdate(now);
+      _updateTime += updated - start;
+      _postTime += std::chrono::steady_clock::now() - updated;
+      now += 100ms;
+    };
+
+    // Warm up, e.g. to create render targets and discover subscribers
+    std::chrono::steady_clock::duration updateTime{0};
+    std::chrono::steady_clock::duration postTime{0};
+    for (int i = 0; i < 5; ++i)
+      step(updateTime, postTime);
+    std::this_thread::sleep_for(200ms);
+
+    updateTime = postTime = std::chrono::steady_clock::duration::zero();
+    for (int i = 0; i < kSteps; ++i)
+      step(updateTime, postTime);
+    std::this_thread::sleep_for(200ms);
+
+    const double renderMs = std::chrono::duration<double, std::milli>(
+        updateTime).count() / kSteps;
+    const double postMs = std::chrono::duration<double, std::milli>(
+        postTime).count() / kSteps;
+    std::cout << "{\"benchmark\": \"dvl\", "
+              << "\"engine\": \"" << engine->Name() << "\", "
+              << "\"steps\": " << kSteps << ", "
+              << "\"render_ms\": " << renderMs << ", "
+              << "\"post_processing_ms\": " << postMs << ", "
+              << "\"messages\": " << messages << "}" << std::endl;
+    ::testing::Test::RecordProperty("dvl_render_ms",
+        std::to_string(renderMs));
+    ::testing::Test::RecordProperty("dvl_post_processing_ms",
+        std::to_string(postMs));
+  }
+
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+INSTANTIATE_TEST_SUITE_P(SensorThroughput, SensorThroughput,
+    RENDER_ENGINE_VALUES, gz::rendering::PrintToStringParam());
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sdf/sdf.hh>
+
+#include <gz/common/Console.hh>
+#include <gz/common/Filesystem.hh>
+#include <gz/sensors/BoundingBoxCameraSensor.hh>
+#include <gz/sensors/CameraSensor.hh>
+#include <gz/sensors/DepthCameraSensor.hh>
+#include <gz/sensors/GpuLidarSensor.hh>
+#include <gz/sensors/RgbdCameraSensor.hh>
+#include <gz/sensors/SegmentationCameraSensor.hh>
+#include <gz/sensors/SensorFactory.hh>
+#include <gz/sensors/ThermalCameraSensor.hh>
+#include <gz/sensors/WideAngleCameraSensor.hh>
+
+// TODO(louise) Remove these pragmas once gz-rendering is disabling the
+// warnings
+#ifdef _WIN32
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+#include <gz/rendering/RenderEngine.hh>
+#include <gz/rendering/RenderingIface.hh>
+#include <gz/rendering/Scene.hh>
+#ifdef _WIN32
+#pragma warning(pop)
+#endif
+
+#include "test_config.hh"  // NOLINT(build/include)
+#include "TraceRecorder.hh"
+
+/// \brief Numbers of sensors created per type.
+const std::vector<unsigned int> kSensorCounts{1u, 10u, 50u};
+
+/// \brief A sensor type to benchmark.
+struct StartupCase
+{
+  /// \brief Benchmark name.
+  std::string name;
+
+  /// \brief SDF file in test/sdf.
+  std::string file;
+
+  /// \brief Create the sensor with a factory.
+  std::function<std::unique_ptr<gz::sensors::Sensor>(
+      gz::sensors::SensorFactory &, const sdf::Sensor &)> create;
+};
+
+//////////////////////////////////////////////////
+/// \brief Create a sensor of a given type.
+/// \return Function that creates the sensor.
+template <typename T>
+std::function<std::unique_ptr<gz::sensors::Sensor>(
+    gz::sensors::SensorFactory &, const sdf::Sensor &)>
+Creator()
+{
+  return [](gz::sensors::SensorFactory &_factory, const sdf::Sensor &_sdf)
+      -> std::unique_ptr<gz::sensors::Sensor>
+  {
+    return _factory.CreateSensor<T>(_sdf);
+  };
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the time spent creating noise models since the trace was
+/// cleared.
+/// \return Duration in nanoseconds.
+int64_t NoiseCreationNs()
+{
+  int64_t total = 0;
+  for (const auto &event : gz::sensors::TraceRecorder::Instance().Events())
+  {
+    if (std::strcmp(event.phase, "create_noise") == 0)
+      total += event.duration;
+  }
+  return total;
+}
+
+//////////////////////////////////////////////////
+/// \brief Benchmark the creation of _count sensors of a type. The time is
+/// split between:
+/// - parsing the SDF file and loading the sdf::Sensor DOM;
+/// - creating the noise models, recorded by the noise factories on the
+///   trace;
+/// - the rest of SensorFactory::CreateSensor, which loads and initializes
+///   the sensor with its advertisements deferred;
+/// - the deferred advertisements, made by Sensor::AdvertisePending;
+/// - RenderingSensor::SetScene, which creates the rendering camera.
+/// Results are printed as one JSON object per line and recorded as test
+/// properties, so they end up in the XML report written with
+/// --gtest_output.
+/// \param[in] _scene Scene of the rendering sensors.
+/// \param[in] _case Sensor type.
+/// \param[in] _count Number of sensors.
+void RunStartup(gz::rendering::ScenePtr _scene, const StartupCase &_case,
+    unsigned int _count)
+{
+  using Clock = std::chrono::steady_clock;
+  const std::string path = gz::common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "sdf", _case.file);
+
+  std::map<std::string, Clock::duration> phases{
+      {"parse", Clock::duration::zero()},
+      {"load", Clock::duration::zero()},
+      {"advertise", Clock::duration::zero()},
+      {"create_camera", Clock::duration::zero()}};
+  int64_t noiseNs = 0;
+
+  gz::sensors::TraceRecorder &recorder = gz::sensors::TraceRecorder::Instance();
+  recorder.SetCapacity(4096u);
+
+  gz::sensors::SensorFactory factory;
+  factory.SetAdvertiseDeferred(true);
+  std::vector<std::unique_ptr<gz::sensors::Sensor>> sensors;
+  for (unsigned int i = 0u; i < _count; ++i)
+  {
+    const std::string name = _case.name + "_" + std::to_string(i);
+
+    auto start = Clock::now();
+    sdf::SDFPtr doc(new sdf::SDF());
+    sdf::init(doc);
+    ASSERT_TRUE(sdf::readFile(path, doc)) << path;
+    sdf::ElementPtr elem = doc->Root()->GetElement("model")
+        ->GetElement("link")->GetElement("sensor");
+    elem->GetAttribute("name")->Set(name);
+    elem->GetElement("topic")->Set("/perf/startup/" + name);
+    sdf::Sensor sdfSensor;
+    EXPECT_TRUE(sdfSensor.Load(elem).empty()) << name;
+    phases["parse"] += Clock::now() - start;
+
+    recorder.Clear();
+    start = Clock::now();
+    auto sensor = _case.create(factory, sdfSensor);
+    phases["load"] += Clock::now() - start;
+    noiseNs += NoiseCreationNs();
+    ASSERT_NE(nullptr, sensor) << name;
+
+    start = Clock::now();
+    EXPECT_TRUE(sensor->AdvertisePending()) << name;
+    phases["advertise"] += Clock::now() - start;
+
+    auto renderingSensor =
+        dynamic_cast<gz::sensors::RenderingSensor *>(sensor.get());
+    ASSERT_NE(nullptr, renderingSensor) << name;
+    start = Clock::now();
+    renderingSensor->SetScene(_scene);
+    phases["create_camera"] += Clock::now() - start;
+
+    sensors.push_back(std::move(sensor));
+  }
+  recorder.SetCapacity(0u);
+
+  // Noise models are created while loading
+  phases["load"] -= std::chrono::nanoseconds(noiseNs);
+  phases["noise"] = std::chrono::nanoseconds(noiseNs);
+
+  const std::string config = _case.name + "_x" + std::to_string(_count);
+  double totalMs = 0.0;
+  std::cout << "{\"benchmark\": \"" << _case.name << "\", "
+            << "\"sensors\": " << _count;
+  for (const auto &[phase, duration] : phases)  // NOLINT
+  {
+    const double ms = std::chrono::duration<double, std::milli>(
+        duration).count() / _count;
+    totalMs += ms;
+    std::cout << ", \"" << phase << "_ms_per_sensor\": " << ms;
+    ::testing::Test::RecordProperty(config + "_" + phase + "_ms",
+        std::to_string(ms));
+  }
+  std::cout << ", \"total_ms_per_sensor\": " << totalMs << "}" << std::endl;
+  ::testing::Test::RecordProperty(config + "_total_ms",
+      std::to_string(totalMs));
+}
+
+/// \brief Benchmark sensor creation for a render engine.
+class StartupTime : public testing::Test,
+                    public testing::WithParamInterface<const char *>
+{
+};
+
+//////////////////////////////////////////////////
+TEST_P(StartupTime, CreateSensors)
+{
+  std::map<std::string, std::string> params;
+  params["headless"] = "1";
+  auto *engine = gz::rendering::engine(GetParam(), params);
+  if (!engine)
+    GTEST_SKIP() << "Engine '" << GetParam() << "' is not supported";
+
+  gz::rendering::ScenePtr scene = engine->CreateScene("scene");
+  ASSERT_NE(nullptr, scene);
+
+  const std::vector<StartupCase> cases{
+    {"camera", "camera_sensor_builtin.sdf",
+        Creator<gz::sensors::CameraSensor>()},
+    {"depth", "depth_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::DepthCameraSensor>()},
+    {"rgbd", "rgbd_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::RgbdCameraSensor>()},
+    {"gpu_lidar", "gpu_lidar_sensor_builtin.sdf",
+        Creator<gz::sensors::GpuLidarSensor>()},
+    {"thermal", "thermal_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::ThermalCameraSensor>()},
+    {"segmentation", "segmentation_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::SegmentationCameraSensor>()},
+    {"boundingbox", "boundingbox_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::BoundingBoxCameraSensor>()},
+    {"wide_angle", "wide_angle_camera_sensor_builtin.sdf",
+        Creator<gz::sensors::WideAngleCameraSensor>()},
+  };
+
+  for (const auto &startupCase : cases)
+  {
+    for (unsigned int count : kSensorCounts)
+      RunStartup(scene, startupCase, count);
+  }
+
+  engine->DestroyScene(scene);
+  gz::rendering::unloadEngine(engine->Name());
+}
+
+INSTANTIATE_TEST_SUITE_P(StartupTime, StartupTime,
+    RENDER_ENGINE_VALUES, gz::rendering::PrintToStringParam());
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2024 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gz/msgs/air_speed.pb.h>
+#include <gz/msgs/altimeter.pb.h>
+#include <gz/msgs/fluid_pressure.pb.h>
+#include <gz/msgs/imu.pb.h>
+#include <gz/msgs/logical_camera_image.pb.h>
+#include <gz/msgs/magnetometer.pb.h>
+#include <gz/msgs/navsat.pb.h>
+#include <gz/msgs/wrench.pb.h>
+#include <gz/transport/Node.hh>
+#include <sdf/sdf.hh>
+
+#include <gz/sensors/AirPressureSensor.hh>
+#include <gz/sensors/AirSpeedSensor.hh>
+#include <gz/sensors/AltimeterSensor.hh>
+#include <gz/sensors/ForceTorqueSensor.hh>
+#include <gz/sensors/ImuSensor.hh>
+#include <gz/sensors/LogicalCameraSensor.hh>
+#include <gz/sensors/MagnetometerSensor.hh>
+#include <gz/sensors/Manager.hh>
+#include <gz/sensors/NavSatSensor.hh>
+
+#include "test_config.hh"  // NOLINT(build/include)
+
+using namespace std::chrono_literals;
+
+/// \brief True while the allocations of the calling thread are counted.
+/// Other threads, e.g. the ones of gz-transport, aren't counted.
+thread_local bool t_counting = false;
+
+/// \brief Number of heap allocations counted on the calling thread.
+thread_local uint64_t t_allocations = 0u;
+
+//////////////////////////////////////////////////
+void *operator new(std::size_t _size)
+{
+  if (t_counting)
+    ++t_allocations;
+  if (void *ptr = std::malloc(_size == 0u ? 1u : _size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+//////////////////////////////////////////////////
+void *operator new(std::size_t _size, std::align_val_t _align)
+{
+  if (t_counting)
+    ++t_allocations;
+  const auto align = static_cast<std::size_t>(_align);
+  const std::size_t size = (_size + align - 1u) / align * align;
+  if (void *ptr = std::aligned_alloc(align, size == 0u ? align : size))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, std::align_val_t) noexcept
+{
+  std::free(_ptr);
+}
+
+//////////////////////////////////////////////////
+void operator delete(void *_ptr, std::size_t, std::align_val_t) noexcept
+{
+  std::free(_ptr);
+}
+
+/// \brief Number of updates before the allocations are counted, so lazily
+/// created messages and buffers exist.
+constexpr int kWarmupUpdates = 10;
+
+/// \brief Number of updates whose allocations are counted.
+constexpr int kUpdates = 200;
+
+/// \brief A sensor type to check.
+struct AllocationCase
+{
+  /// \brief SDF sensor type.
+  std::string type;
+
+  /// \brief SDF of the sensor specific element.
+  std::string element;
+
+  /// \brief Count the allocations gz-transport makes for the updates
+  /// alone, which the sensor can't avoid.
+  std::function<uint64_t()> baseline;
+
+  /// \brief Create the sensor with a manager.
+  std::function<gz::sensors::Sensor *(gz::sensors::Manager &,
+      sdf::ElementPtr)> create;
+};
+
+//////////////////////////////////////////////////
+/// \brief Create a sensor of a given type.
+/// \return Function that creates the sensor.
+template <typename T>
+std::function<gz::sensors::Sensor *(gz::sensors::Manager &, sdf::ElementPtr)>
+Creator()
+{
+  return [](gz::sensors::Manager &_mgr, sdf::ElementPtr _sdf)
+  {
+    return _mgr.CreateSensor<T>(_sdf);
+  };
+}
+
+//////////////////////////////////////////////////
+/// \brief Count the allocations of gz-transport for kUpdates updates of a
+/// sensor publishing messages of a given type, without subscribers. The
+/// Publish call allocates on its own, e.g. for the type name of the message
+/// it checks. Sensors that only publish to subscribers just check for
+/// connections.
+/// \param[in] _publishes True if the sensor publishes without subscribers.
+/// \return Function that counts the allocations.
+template <typename T>
+std::function<uint64_t()> Baseline(bool _publishes)
+{
+  return [_publishes]()
+  {
+    gz::transport::Node node;
+    auto pub = node.Advertise<T>("/allocations/baseline");
+    T msg;
+    msg.mutable_header()->add_data()->set_key("frame_id");
+    msg.mutable_header()->add_data()->set_key("seq");
+    auto step = [&]()
+    {
+      if (_publishes)
+        pub.Publish(msg);
+      else
+        EXPECT_FALSE(pub.HasConnections());
+    };
+
+    for (int i = 0; i < kWarmupUpdates; ++i)
+      step();
+
+    t_allocations = 0u;
+    t_counting = true;
+    for (int i = 0; i < kUpdates; ++i)
+      step();
+    t_counting = false;
+    return t_allocations;
+  };
+}
+
+//////////////////////////////////////////////////
+/// \brief Create the sdf element of a sensor.
+/// \param[in] _case Sensor type.
+/// \return The sensor element, or null on failure.
+sdf::ElementPtr SensorToSdf(const AllocationCase &_case)
+{
+  std::ostringstream stream;
+  stream
+    << "<?xml version='1.0'?>"
+    << "<sdf version='1.6'>"
+    << " <model name='m1'>"
+    << "  <link name='link1'>"
+    << "    <sensor name='" << _case.type << "' type='" << _case.type << "'>"
+    << "      <topic>/allocations/" << _case.type << "</topic>"
+    << "      <update_rate>100</update_rate>"
+    << "      <always_on>1</always_on>"
+    << _case.element
+    << "    </sensor>"
+    << "  </link>"
+    << " </model>"
+    << "</sdf>";
+
+  sdf::SDFPtr sdfParsed(new sdf::SDF());
+  sdf::init(sdfParsed);
+  if (!sdf::readString(stream.str(), sdfParsed))
+    return sdf::ElementPtr();
+
+  return sdfParsed->Root()->GetElement("model")->GetElement("link")
+    ->GetElement("sensor");
+}
+
+//////////////////////////////////////////////////
+/// \brief Gaussian noise element.
+/// \return The noise SDF.
+std::string Noise()
+{
+  return "<noise type='gaussian'><mean>0</mean><stddev>0.1</stddev>"
+         "<bias_mean>0.01</bias_mean><bias_stddev>0.01</bias_stddev>"
+         "</noise>";
+}
+
+//////////////////////////////////////////////////
+/// \brief Check that the updates of the non rendering built-in sensors
+/// make no allocations of their own once warmed up: the only allocations
+/// are the ones gz-transport makes for the same number of publications.
+/// The allocations are recorded as test properties, so they end up in the
+/// XML report written with --gtest_output.
+TEST(SteadyStateAllocations, Update)
+{
+  using namespace gz;
+  const std::vector<AllocationCase> cases{
+    {"altimeter",
+        "<altimeter><vertical_position>" + Noise() +
+        "</vertical_position></altimeter>",
+        Baseline<msgs::Altimeter>(true),
+        Creator<sensors::AltimeterSensor>()},
+    {"air_pressure",
+        "<air_pressure><pressure>" + Noise() +
+        "</pressure></air_pressure>",
+        Baseline<msgs::FluidPressure>(true),
+        Creator<sensors::AirPressureSensor>()},
+    {"air_speed",
+        "<air_speed><pressure>" + Noise() + "</pressure></air_speed>",
+        Baseline<msgs::AirSpeed>(true),
+        Creator<sensors::AirSpeedSensor>()},
+    {"magnetometer",
+        "<magnetometer><x>" + Noise() + "</x></magnetometer>",
+        Baseline<msgs::Magnetometer>(true),
+        Creator<sensors::MagnetometerSensor>()},
+    {"imu",
+        "<imu><angular_velocity><x>" + Noise() +
+        "</x></angular_velocity></imu>",
+        Baseline<msgs::IMU>(false),
+        Creator<sensors::ImuSensor>()},
+    {"force_torque",
+        "<force_torque><force><x>" + Noise() + "</x></force></force_torque>",
+        Baseline<msgs::Wrench>(false),
+        Creator<sensors::ForceTorqueSensor>()},
+    {"navsat",
+        "<navsat><position_sensing><horizontal>" + Noise() +
+        "</horizontal></position_sensing></navsat>",
+        Baseline<msgs::NavSat>(true),
+        Creator<sensors::NavSatSensor>()},
+    {"logical_camera",
+        "<logical_camera><near>0.1</near><far>10</far>"
+        "<horizontal_fov>1.0</horizontal_fov><aspect_ratio>1.0</aspect_ratio>"
+        "</logical_camera>",
+        Baseline<msgs::LogicalCameraImage>(true),
+        Creator<sensors::LogicalCameraSensor>()},
+  };
+
+  for (const auto &allocationCase : cases)
+  {
+    sdf::ElementPtr sensorSdf = SensorToSdf(allocationCase);
+    ASSERT_NE(nullptr, sensorSdf) << allocationCase.type;
+
+    gz::sensors::Manager mgr;
+    gz::sensors::Sensor *sensor = allocationCase.create(mgr, sensorSdf);
+    ASSERT_NE(nullptr, sensor) << allocationCase.type;
+
+    auto now = std::chrono::steady_clock::duration::zero();
+    for (int i = 0; i < kWarmupUpdates; ++i)
+    {
+      EXPECT_TRUE(sensor->Update(now, true)) << allocationCase.type;
+      now += 10ms;
+    }
+
+    t_allocations = 0u;
+    t_counting = true;
+    for (int i = 0; i < kUpdates; ++i)
+    {
+      sensor->Update(now, true);
+      now += 10ms;
+    }
+    t_counting = false;
+    const uint64_t allocations = t_allocations;
+
+    const uint64_t transportAllocations = allocationCase.baseline();
+
+    ::testing::Test::RecordProperty(allocationCase.type + "_allocations",
+        std::to_string(allocations));
+    ::testing::Test::RecordProperty(
+        allocationCase.type + "_transport_allocations",
+        std::to_string(transportAllocations));
+    EXPECT_EQ(transportAllocations, allocations)
+        << allocationCase.type << " made " << allocations
+        << " allocations in " << kUpdates << " updates, gz-transport alone "
+        << "makes " << transportAllocations;
+  }
+}